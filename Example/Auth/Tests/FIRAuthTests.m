@@ -2265,6 +2265,58 @@ fetchCompletionHandler:(void (^)(UIBackgroundFetchResult))completionHandler {
   OCMVerifyAll(_mockBackend);
 }
 
+/** @fn testGetTokenDuringAutomaticTokenRefresh
+    @brief Tests that a token requested while an automatic token refresh is running is answered
+        with the cached token instead of waiting for the refresh to finish.
+ */
+- (void)testGetTokenDuringAutomaticTokenRefresh {
+  [[FIRAuth auth] signOut:NULL];
+  // Enable auto refresh
+  [self enableAutoTokenRefresh];
+
+  // Sign in a user.
+  [self waitForSignIn];
+
+  // Hold on to the secureToken RPC made by the token refresh task without answering it.
+  XCTestExpectation *secureTokenRequestExpectation =
+      [self expectationWithDescription:@"secureTokenRequestExpectation"];
+  __block FIRSecureTokenResponseCallback secureTokenCallback;
+  OCMExpect([_mockBackend secureToken:[OCMArg any] callback:[OCMArg any]])
+      .andCallBlock2(^(FIRSecureTokenRequest *_Nullable request,
+                       FIRSecureTokenResponseCallback callback) {
+    secureTokenCallback = callback;
+    [secureTokenRequestExpectation fulfill];
+  });
+  dispatch_async(FIRAuthGlobalWorkQueue(), ^() {
+    XCTAssertNotNil(_FIRAuthDispatcherCallback);
+    _FIRAuthDispatcherCallback();
+  });
+  [self waitForExpectationsWithTimeout:kExpectationTimeout handler:nil];
+
+  XCTestExpectation *tokenExpectation = [self expectationWithDescription:@"tokenExpectation"];
+  [[FIRAuth auth] getTokenForcingRefresh:NO withCallback:^(NSString *_Nullable token,
+                                                           NSError *_Nullable error) {
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(token, kAccessToken);
+    [tokenExpectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kExpectationTimeout handler:nil];
+
+  // Let the refresh finish.
+  XCTestExpectation *refreshExpectation = [self expectationWithDescription:@"refreshExpectation"];
+  dispatch_async(FIRAuthGlobalWorkQueue(), ^() {
+    id mockSecureTokenResponse = OCMClassMock([FIRSecureTokenResponse class]);
+    OCMStub([mockSecureTokenResponse accessToken]).andReturn(kNewAccessToken);
+    NSDate *futureDate = [[NSDate date] dateByAddingTimeInterval:kTestTokenExpirationTimeInterval];
+    OCMStub([mockSecureTokenResponse approximateExpirationDate]).andReturn(futureDate);
+    secureTokenCallback(mockSecureTokenResponse, nil);
+    [refreshExpectation fulfill];
+  });
+  [self waitForExpectationsWithTimeout:kExpectationTimeout handler:nil];
+  XCTAssertEqualObjects(kNewAccessToken, [FIRAuth auth].currentUser.rawAccessToken);
+  OCMVerifyAll(_mockBackend);
+}
+
 #if TARGET_OS_IOS
 /** @fn testAutomaticTokenRefreshInvalidTokenFailure
     @brief Tests that app foreground notification triggers the scheduling of an automatic token
@@ -135,6 +135,30 @@
   XCTAssertNotNil(container.cachedInstances[protocolName]);
 }
 
+- (void)testEagerInBackgroundInstantiation {
+  FIRComponentContainer *container =
+      [self containerWithRegistrants:@ [[FIRTestClassEagerInBackground class]]];
+
+  // Retrieving the component waits for the instance created in the background.
+  id<FIRTestProtocolEagerInBackground> instance1 =
+      FIR_COMPONENT(FIRTestProtocolEagerInBackground, container);
+  XCTAssertNotNil(instance1);
+  XCTAssertFalse(instance1.createdOnMainThread);
+  id<FIRTestProtocolEagerInBackground> instance2 =
+      FIR_COMPONENT(FIRTestProtocolEagerInBackground, container);
+  XCTAssertEqual(instance1, instance2);
+}
+
+- (void)testInstantiationDurationsRecorded {
+  FIRComponentContainer *container = [self containerWithRegistrants:@ [[FIRTestClassCached class]]];
+  NSString *protocolName = NSStringFromProtocol(@protocol(FIRTestProtocolCached));
+  XCTAssertNil(container.instantiationDurations[protocolName]);
+
+  XCTAssertNotNil(FIR_COMPONENT(FIRTestProtocolCached, container));
+  XCTAssertNotNil(container.instantiationDurations[protocolName]);
+  XCTAssertGreaterThanOrEqual(container.instantiationDurations[protocolName].doubleValue, 0);
+}
+
 #pragma mark - Input Validation Tests
 
 - (void)testProtocolAlreadyRegistered {
@@ -49,6 +49,20 @@
     : NSObject <FIRTestProtocol, FIRComponentLifecycleMaintainer, FIRLibrary>
 @end
 
+#pragma mark - Background Eager Component
+
+/// A test protocol to be used for container testing.
+@protocol FIRTestProtocolEagerInBackground
+/// Whether the instance was created on the main thread.
+@property(nonatomic, readonly) BOOL createdOnMainThread;
+@end
+
+/// A test class that is a component registrant that provides a cached component instantiated in
+/// the background when the container is created.
+@interface FIRTestClassEagerInBackground
+    : NSObject <FIRTestProtocolEagerInBackground, FIRComponentLifecycleMaintainer, FIRLibrary>
+@end
+
 #pragma mark - Cached Component
 
 /// A test protocol to be used for container testing.
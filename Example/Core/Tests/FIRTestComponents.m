@@ -97,6 +97,40 @@
 
 @end
 
+#pragma mark - Background Eager Component
+
+@implementation FIRTestClassEagerInBackground
+
+@synthesize createdOnMainThread = _createdOnMainThread;
+
+- (instancetype)init {
+  self = [super init];
+  if (self) {
+    _createdOnMainThread = [NSThread isMainThread];
+  }
+  return self;
+}
+
+/// FIRLibrary conformance.
++ (nonnull NSArray<FIRComponent *> *)componentsToRegister {
+  FIRComponent *testComponent = [FIRComponent
+      componentWithProtocol:@protocol(FIRTestProtocolEagerInBackground)
+        instantiationTiming:FIRInstantiationTimingEagerInBackground
+               dependencies:@[]
+              creationBlock:^id _Nullable(FIRComponentContainer *_Nonnull container,
+                                          BOOL *_Nonnull isCacheable) {
+                *isCacheable = YES;
+                return [[FIRTestClassEagerInBackground alloc] init];
+              }];
+  return @[ testComponent ];
+}
+
+/// FIRComponentLifecycleMaintainer conformance.
+- (void)appWillBeDeleted:(FIRApp *)app {
+}
+
+@end
+
 #pragma mark - Cached Component
 
 @implementation FIRTestClassCached
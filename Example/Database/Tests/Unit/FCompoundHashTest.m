@@ -108,6 +108,22 @@ static FCompoundHashSplitStrategy NEVER_SPLIT_STRATEGY = ^BOOL(FCompoundHashBuil
     XCTAssertEqualObjects(hash.hashes, (@[expectedHash, @""]));
 }
 
+- (void)testLongRangesHashTheirWholeText {
+    NSMutableDictionary *dict = [NSMutableDictionary dictionary];
+    NSMutableString *expected = [NSMutableString stringWithString:@"("];
+    for (int i = 0; i < 1000; i++) {
+        // Non-ASCII values so the ranges are longer in UTF-8 than in characters.
+        NSString *key = [NSString stringWithFormat:@"%d", i];
+        dict[key] = @"v\u00e4lue";
+        [expected appendFormat:@"%@\"%@\":(string:\"v\u00e4lue\")", i == 0 ? @"" : @",", key];
+    }
+    [expected appendString:@")"];
+
+    FCompoundHash *hash = [FCompoundHash fromNode:NODE(dict) splitStrategy:NEVER_SPLIT_STRATEGY];
+    XCTAssertEqualObjects(hash.posts, @[PATH(@"999")]);
+    XCTAssertEqualObjects(hash.hashes, (@[[FStringUtilities base64EncodedSha1:expected], @""]));
+}
+
 - (void)testDefaultSplitHasSensibleAmountOfHashes {
     NSMutableDictionary *dict = [NSMutableDictionary dictionary];
     for (int i = 0; i < 500; i++) {
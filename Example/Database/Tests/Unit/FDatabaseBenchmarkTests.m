@@ -0,0 +1,180 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "FCompoundHash.h"
+#import "FCompoundWrite.h"
+#import "FIRDatabaseQuery_Private.h"
+#import "FLevelDBStorageEngine.h"
+#import "FListenProvider.h"
+#import "FNode.h"
+#import "FPath.h"
+#import "FQuerySpec.h"
+#import "FRepoInfo.h"
+#import "FRepoManager.h"
+#import "FRepo_Private.h"
+#import "FSnapshotUtilities.h"
+#import "FSyncTree.h"
+#import "FTestHelpers.h"
+#import "FValueEventRegistration.h"
+
+static const int kFBenchmarkChildCount = 5000;
+
+/**
+ * Measures the parts of the client that large or fast changing data goes through, from parsing the server's JSON to
+ * raising events from FRepo. The numbers are reported by XCTest and have no baselines, since they depend too much on
+ * the machine the tests run on to fail CI, but they give other changes to these paths something to be compared to.
+ */
+@interface FDatabaseBenchmarkTests : XCTestCase
+@end
+
+@implementation FDatabaseBenchmarkTests
+
+/** A list of users like one a high rate listener might load, with a leaf, a number and a few children each. */
+- (NSDictionary *)largeJSON {
+    NSMutableDictionary *json = [NSMutableDictionary dictionaryWithCapacity:kFBenchmarkChildCount];
+    for (NSInteger i = 0; i < kFBenchmarkChildCount; i++) {
+        json[[NSString stringWithFormat:@"user-%ld", (long)i]] = @{
+            @"name": [NSString stringWithFormat:@"User %ld", (long)i],
+            @"score": @(i * 7 % 1000),
+            @"tags": @{@"active": @(i % 2 == 0), @"admin": @(i % 100 == 0)}
+        };
+    }
+    return json;
+}
+
+- (id<FNode>)largeNode {
+    return [FSnapshotUtilities nodeFrom:[self largeJSON]];
+}
+
+- (void)testNodeFromLargeJSON {
+    NSDictionary *json = [self largeJSON];
+    [self measureBlock:^{
+        id<FNode> node = [FSnapshotUtilities nodeFrom:json];
+        XCTAssertEqual([node numChildren], kFBenchmarkChildCount);
+    }];
+}
+
+- (void)testChildrenNodeUpdates {
+    id<FNode> node = [self largeNode];
+    [self measureBlock:^{
+        id<FNode> updated = node;
+        for (NSInteger i = 0; i < kFBenchmarkChildCount; i += 5) {
+            NSString *key = [NSString stringWithFormat:@"user-%ld", (long)i];
+            updated = [updated updateChild:[[FPath alloc] initWith:[key stringByAppendingString:@"/score"]]
+                              withNewChild:[FSnapshotUtilities nodeFrom:@(i)]];
+        }
+        XCTAssertEqual([updated numChildren], kFBenchmarkChildCount);
+    }];
+}
+
+- (void)testViewProcessorMerges {
+    FListenProvider *listenProvider = [[FListenProvider alloc] init];
+    listenProvider.startListening = ^(FQuerySpec *query, NSNumber *tagId, id<FSyncTreeHash> hash,
+                                      fbt_nsarray_nsstring onComplete) {
+        return @[];
+    };
+    listenProvider.stopListening = ^(FQuerySpec *query, NSNumber *tagId) {
+    };
+    FSyncTree *syncTree = [[FSyncTree alloc] initWithListenProvider:listenProvider];
+    FQuerySpec *query = [FQuerySpec defaultQueryAtPath:[FPath empty]];
+    FValueEventRegistration *registration = [[FValueEventRegistration alloc] initWithRepo:nil
+                                                                                   handle:1
+                                                                                 callback:^(FIRDataSnapshot *snap) {
+                                                                                 }
+                                                                           cancelCallback:nil];
+    [syncTree addEventRegistration:registration forQuery:query];
+    [syncTree applyServerOverwriteAtPath:[FPath empty] newData:[self largeNode]];
+
+    __block NSInteger round = 0;
+    [self measureBlock:^{
+        round++;
+        for (NSInteger i = 0; i < 100; i++) {
+            NSMutableDictionary *changes = [NSMutableDictionary dictionary];
+            for (NSInteger j = i; j < kFBenchmarkChildCount; j += 100) {
+                changes[[NSString stringWithFormat:@"user-%ld/score", (long)j]] = @(round);
+            }
+            FCompoundWrite *merge = [FCompoundWrite compoundWriteWithValueDictionary:changes];
+            NSArray *events = [syncTree applyServerMergeAtPath:[FPath empty] changedChildren:merge];
+            XCTAssertEqual(events.count, (NSUInteger)1);
+        }
+    }];
+}
+
+- (void)testCompoundHashGeneration {
+    id<FNode> node = [self largeNode];
+    [self measureBlock:^{
+        FCompoundHash *hash = [FCompoundHash fromNode:node];
+        XCTAssertTrue(hash.hashes.count > 0);
+    }];
+}
+
+- (void)testStorageEngineWritesAndReads {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"benchmark-db"];
+    FLevelDBStorageEngine *engine = [[FLevelDBStorageEngine alloc] initWithPath:path];
+    [engine purgeEverything];
+    id<FNode> node = [self largeNode];
+    [self measureBlock:^{
+        [engine updateServerCache:node atPath:[FPath pathWithString:@"users"] merge:NO];
+        for (NSInteger i = 0; i < 100; i++) {
+            NSString *key = [NSString stringWithFormat:@"users/user-%ld", (long)(i * 37 % kFBenchmarkChildCount)];
+            XCTAssertFalse([[engine serverCacheAtPath:[FPath pathWithString:key]] isEmpty]);
+        }
+        XCTAssertEqual([[engine serverCacheAtPath:[FPath pathWithString:@"users"]] numChildren],
+                       kFBenchmarkChildCount);
+    }];
+    [engine purgeEverything];
+    [engine close];
+}
+
+/**
+ * Sends the repo data updates the way its FPersistentConnection does on receiving them, while a value listener is
+ * attached. The repo's connection is interrupted so that nothing goes to the network.
+ */
+- (void)testRepoDataUpdateThroughput {
+    FRepoInfo *repoInfo = [[FRepoInfo alloc] initWithHost:@"example.com" isSecure:NO withNamespace:@"benchmark"];
+    FRepo *repo = [FRepoManager getRepo:repoInfo config:[FTestHelpers configForName:@"benchmark"]];
+    FQuerySpec *query = [FQuerySpec defaultQueryAtPath:[FPath pathWithString:@"users"]];
+    FValueEventRegistration *registration = [[FValueEventRegistration alloc] initWithRepo:repo
+                                                                                   handle:1
+                                                                                 callback:^(FIRDataSnapshot *snap) {
+                                                                                 }
+                                                                           cancelCallback:nil];
+    NSDictionary *json = [self largeJSON];
+    dispatch_sync([FIRDatabaseQuery sharedQueue], ^{
+        [repo interrupt];
+        [repo addEventRegistration:registration forQuery:query];
+        [repo onDataUpdate:repo.connection forPath:@"/users" message:json isMerge:NO tagId:nil];
+    });
+
+    __block NSInteger round = 0;
+    [self measureBlock:^{
+        round++;
+        dispatch_sync([FIRDatabaseQuery sharedQueue], ^{
+            for (NSInteger i = 0; i < 1000; i++) {
+                NSString *path = [NSString stringWithFormat:@"/users/user-%ld/score", (long)(i * 7 % kFBenchmarkChildCount)];
+                [repo onDataUpdate:repo.connection forPath:path message:@(round) isMerge:NO tagId:nil];
+            }
+        });
+    }];
+
+    dispatch_sync([FIRDatabaseQuery sharedQueue], ^{
+        [repo removeEventRegistration:registration forQuery:query];
+    });
+}
+
+@end
@@ -24,6 +24,9 @@
 #import "FWriteRecord.h"
 #import "FTestHelpers.h"
 #import "FEmptyNode.h"
+#import "APLevelDB.h"
+#import "FCompoundWrite.h"
+#import "FPruneForest.h"
 
 @interface FLevelDBStorageEngineTests : XCTestCase
 
@@ -100,6 +103,18 @@
     XCTAssertEqualObjects(engine.userWrites, @[MERGE_RECORD(@"foo/bar", merge, 1)]);
 }
 
+- (void)testUserWritesKeepEveryLeafType {
+    id<FNode> node = NODE((@{ @"string": @{ @".value": @"v\u00e4lue", @".priority": @1.5 },
+                              @"bools": @{ @"yes": @YES, @"no": @NO },
+                              @"numbers": @{ @"negative": @-42, @"long": @1542405709418655810, @"double": @2.47 },
+                              @".priority": @"prio" }));
+    FLevelDBStorageEngine *engine = [self cleanStorageEngine];
+    [engine saveUserOverwrite:node atPath:PATH(@"foo") writeId:1];
+    [engine saveUserOverwrite:[FEmptyNode emptyNode] atPath:PATH(@"foo/deleted") writeId:2];
+    XCTAssertEqualObjects(engine.userWrites, (@[OVERWRITE_RECORD(@"foo", node, 1),
+                                                OVERWRITE_RECORD(@"foo/deleted", [FEmptyNode emptyNode], 2)]));
+}
+
 - (void)testSameWriteIdOverwritesOldWrite {
     FLevelDBStorageEngine *engine = [self cleanStorageEngine];
     [engine saveUserOverwrite:NODE(@"first") atPath:PATH(@"foo/bar") writeId:1];
@@ -435,20 +450,80 @@
 
 // Well this is awkward, but NSJSONSerialization fails to deserialize JSON with tiny/huge doubles
 // It is kind of bad we raise "invalid" data, but at least we don't crash *trollface*
-- (void)testExtremeDoublesAsServerCache {
-#ifdef TARGET_OS_IOS
-    if ([[NSProcessInfo processInfo] operatingSystemVersion].majorVersion == 11) {
-        // NSJSONSerialization on iOS 11 correctly serializes small and large doubles.
-        return;
-    }
-#endif
+- (void)testPriorityOnDeepChildrenIsReturned {
+    FLevelDBStorageEngine *engine = [self cleanStorageEngine];
+    id<FNode> node = NODE((@{ @"a": @{ @"b": @{ @".value": @"leaf", @".priority": @3 },
+                                       @"c": @"other",
+                                       @".priority": @"prio" } }));
+    [engine updateServerCache:node atPath:PATH(@"foo") merge:NO];
+    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo")], node);
+    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo/a/b")], [node getChild:PATH(@"a/b")]);
+    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo/a/missing")], [FEmptyNode emptyNode]);
+}
+
+- (void)testServerCacheSizeIsTrackedAcrossUpdates {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"test-db"];
+    FLevelDBStorageEngine *engine = [self cleanStorageEngine];
+    XCTAssertEqual([engine serverCacheEstimatedSizeInBytes], (NSUInteger)0);
 
+    [engine updateServerCache:SAMPLE_NODE atPath:PATH(@"foo") merge:NO];
+    [engine updateServerCache:SAMPLE_NODE atPath:PATH(@"foo/foo") merge:NO];
+    [engine updateServerCache:NODE((@{ @"qux": @"longer value than two", @"new": @"value" })) atPath:PATH(@"foo") merge:YES];
+    [engine updateServerCacheWithMerge:[FCompoundWrite compoundWriteWithValueDictionary:@{ @"bar/baz": @"leaf" }]
+                                atPath:PATH(@"")];
+    [engine updateServerCache:NODE(@"leaf") atPath:PATH(@"bar/baz/deeper") merge:NO];
+    [engine pruneCache:[[FPruneForest empty] prunePath:PATH(@"foo/foo")] atPath:PATH(@"")];
+    NSUInteger trackedSize = [engine serverCacheEstimatedSizeInBytes];
+    XCTAssertGreaterThan(trackedSize, (NSUInteger)0);
+
+    // A fresh engine measures the cache from scratch.
+    [engine close];
+    engine = [[FLevelDBStorageEngine alloc] initWithPath:path];
+    XCTAssertEqual([engine serverCacheEstimatedSizeInBytes], trackedSize);
+
+    [engine updateServerCache:[FEmptyNode emptyNode] atPath:PATH(@"") merge:NO];
+    XCTAssertEqual([engine serverCacheEstimatedSizeInBytes], (NSUInteger)0);
+}
+
+- (void)testExtremeDoublesAsServerCache {
     FLevelDBStorageEngine *engine = [self cleanStorageEngine];
-    [engine updateServerCache:NODE((@{@"works": @"value", @"fails": @(2.225073858507201e-308)})) atPath:PATH(@"foo") merge:NO];
+    id<FNode> node = NODE((@{@"works": @"value", @"tiny": @(2.225073858507201e-308)}));
+    [engine updateServerCache:node atPath:PATH(@"foo") merge:NO];
+
+    // Doubles are stored in binary, so even the ones JSON can't round trip are kept
+    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo")], node);
+}
 
-    // Will drop the tiny double
-    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo")], NODE(@{@"works": @"value"}));
-    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo/fails")], [FEmptyNode emptyNode]);
+- (void)testJSONDatabaseIsMigrated {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"test-db"];
+    FLevelDBStorageEngine *engine = [self cleanStorageEngine];
+    [engine close];
+
+    // Write the data the way version 1 did
+    NSString *basePath = [[FLevelDBStorageEngine firebaseDir] stringByAppendingPathComponent:path];
+    APLevelDB *serverCache = [APLevelDB levelDBWithPath:[basePath stringByAppendingPathComponent:@"server_data"] error:nil];
+    [serverCache setString:@"\"value\"" forKey:@"/server_cache//foo/bar/"];
+    [serverCache setString:@"2.47" forKey:@"/server_cache//foo/baz/"];
+    [serverCache setString:@"7" forKey:@"/server_cache//foo/qux/"];
+    [serverCache close];
+    APLevelDB *writes = [APLevelDB levelDBWithPath:[basePath stringByAppendingPathComponent:@"writes"] error:nil];
+    [writes setString:@"{\"id\":1,\"path\":\"/foo/\",\"o\":{\"bar\":true}}" forKey:@"1"];
+    [writes setString:@"{\"id\":2,\"path\":\"/\",\"m\":{\"/qux\":1}}" forKey:@"2"];
+    [writes close];
+    [@"1" writeToFile:[basePath stringByAppendingPathComponent:@"version"] atomically:NO encoding:NSUTF8StringEncoding
+                error:nil];
+
+    engine = [[FLevelDBStorageEngine alloc] initWithPath:path];
+    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo")],
+                          NODE((@{@"bar": @"value", @"baz": @2.47, @"qux": @7})));
+    FCompoundWrite *merge = [FCompoundWrite compoundWriteWithValueDictionary:@{@"qux": @1}];
+    XCTAssertEqualObjects(engine.userWrites, (@[OVERWRITE_RECORD(@"foo", NODE(@{@"bar": @YES}), 1),
+                                                MERGE_RECORD(@"", merge, 2)]));
+
+    // Reopening doesn't migrate again
+    [engine close];
+    engine = [[FLevelDBStorageEngine alloc] initWithPath:path];
+    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo/baz")], NODE(@2.47));
 }
 
 - (void)testLongValuesDontLosePrecision {
@@ -563,6 +638,64 @@
     XCTAssertEqualObjects([engine trackedQueryKeysForQuery:1], ([NSSet setWithArray:@[@"c", @"d", @"e"]]));
 }
 
+- (void)testManyTrackedQueryKeysAreUpdatedInPlace {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"test-db"];
+    FLevelDBStorageEngine *engine = [self cleanStorageEngine];
+    NSMutableSet *keys = [NSMutableSet set];
+    for (int i = 0; i < 3000; i += 2) {
+        [keys addObject:[NSString stringWithFormat:@"key-%d", i]];
+    }
+    [engine setTrackedQueryKeys:keys forQueryId:1];
+
+    // Add keys before, between and after the stored ones, and remove enough of them to empty whole blocks.
+    NSMutableSet *added = [NSMutableSet setWithArray:@[@"a", @"zzz"]];
+    NSMutableSet *removed = [NSMutableSet set];
+    for (int i = 0; i < 3000; i++) {
+        NSString *key = [NSString stringWithFormat:@"key-%d", i];
+        if (i % 2 == 1) {
+            [added addObject:key];
+        } else if (i < 2000) {
+            [removed addObject:key];
+        }
+    }
+    [engine updateTrackedQueryKeysWithAddedKeys:added removedKeys:removed forQueryId:1];
+    [keys unionSet:added];
+    [keys minusSet:removed];
+    XCTAssertEqualObjects([engine trackedQueryKeysForQuery:1], keys);
+
+    [engine close];
+    engine = [[FLevelDBStorageEngine alloc] initWithPath:path];
+    [engine updateTrackedQueryKeysWithAddedKeys:[NSSet setWithObject:@"key-0"]
+                                    removedKeys:[NSSet setWithObjects:@"a", @"key-1", nil]
+                                     forQueryId:1];
+    [keys addObject:@"key-0"];
+    [keys removeObject:@"a"];
+    [keys removeObject:@"key-1"];
+    XCTAssertEqualObjects([engine trackedQueryKeysForQuery:1], keys);
+}
+
+- (void)testTrackedQueryKeyRowsAreMigrated {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"test-db"];
+    FLevelDBStorageEngine *engine = [self cleanStorageEngine];
+    [engine close];
+
+    // Write the keys the way version 2 did
+    NSString *basePath = [[FLevelDBStorageEngine firebaseDir] stringByAppendingPathComponent:path];
+    APLevelDB *serverCache = [APLevelDB levelDBWithPath:[basePath stringByAppendingPathComponent:@"server_data"] error:nil];
+    [serverCache setString:@"a" forKey:@"/tracked_query_keys/1/a"];
+    [serverCache setString:@"b" forKey:@"/tracked_query_keys/1/b"];
+    [serverCache setString:@"c" forKey:@"/tracked_query_keys/12/c"];
+    [serverCache close];
+    [@"2" writeToFile:[basePath stringByAppendingPathComponent:@"version"] atomically:NO encoding:NSUTF8StringEncoding
+                error:nil];
+
+    engine = [[FLevelDBStorageEngine alloc] initWithPath:path];
+    XCTAssertEqualObjects([engine trackedQueryKeysForQuery:1], ([NSSet setWithArray:@[@"a", @"b"]]));
+    XCTAssertEqualObjects([engine trackedQueryKeysForQuery:12], [NSSet setWithObject:@"c"]);
+    [engine updateTrackedQueryKeysWithAddedKeys:[NSSet set] removedKeys:[NSSet setWithObject:@"a"] forQueryId:1];
+    XCTAssertEqualObjects([engine trackedQueryKeysForQuery:1], [NSSet setWithObject:@"b"]);
+}
+
 - (void)testRemoveTrackedQueryRemovesTrackedQueryKeys {
     FLevelDBStorageEngine *engine = [self cleanStorageEngine];
     FTrackedQuery *query1 = [[FTrackedQuery alloc] initWithId:1 query:[FQuerySpec defaultQueryAtPath:PATH(@"a")] lastUse:100 isActive:NO isComplete:NO];
@@ -124,6 +124,35 @@
     XCTAssertEqualObjects([FSnapshotUtilities nodeFrom:data].val, data);
 }
 
+- (void)testIntegerKeysConvertToArrays {
+    NSDictionary *data = @{ @"0": @"a", @"1": @"b", @"3": @"d" };
+    NSArray *expected = @[ @"a", @"b", [NSNull null], @"d" ];
+    XCTAssertEqualObjects([FSnapshotUtilities nodeFrom:data].val, expected);
+
+    // Too sparse to be an array.
+    NSDictionary *sparse = @{ @"0": @"a", @"9": @"j" };
+    XCTAssertEqualObjects([FSnapshotUtilities nodeFrom:sparse].val, sparse);
+
+    // Names that only look like indices.
+    NSArray *names = @[ @"-1", @"-0", @"00", @"1a", @"4294967296" ];
+    for (NSString *name in names) {
+        NSDictionary *named = @{ @"0": @"a", name: @"b" };
+        XCTAssertEqualObjects([FSnapshotUtilities nodeFrom:named].val, named);
+    }
+
+    // Exporting always keeps the keys.
+    XCTAssertEqualObjects([[FSnapshotUtilities nodeFrom:data] valForExport:YES], data);
+}
+
+- (void)testEstimatedSizeIsKeptAcrossUpdates {
+    id<FNode> node = [FSnapshotUtilities nodeFrom:@{ @"a": @{ @"b": @"value" }, @"c": @1 }];
+    XCTAssertEqual([FSnapshotUtilities estimateSerializedNodeSize:node], (NSUInteger)32);
+
+    id<FNode> updated = [node updateChild:[FPath pathWithString:@"a/d"] withNewChild:[FSnapshotUtilities nodeFrom:@YES]];
+    XCTAssertEqual([FSnapshotUtilities estimateSerializedNodeSize:updated], (NSUInteger)41);
+    XCTAssertEqual([FSnapshotUtilities estimateSerializedNodeSize:node], (NSUInteger)32);
+}
+
 - (void)testEmptyNodeEqualsEmptyChildrenNode {
     XCTAssertEqualObjects([FEmptyNode emptyNode], [[FChildrenNode alloc] init]);
     XCTAssertEqualObjects([[FChildrenNode alloc] init], [FEmptyNode emptyNode]);
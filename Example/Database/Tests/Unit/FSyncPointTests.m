@@ -85,7 +85,7 @@ typedef NSDictionary* (^fbt_nsdictionary_void)(void);
     }
 }
 
-- (void) fireEvent:(id<FEvent>)event queue:(dispatch_queue_t)queue {
+- (void) fireEvent:(id<FEvent>)event {
     [NSException raise:@"NotImplementedError" format:@"Method not implemented."];
 }
 - (FCancelEvent *) createCancelEventFromError:(NSError *)error path:(FPath *)path {
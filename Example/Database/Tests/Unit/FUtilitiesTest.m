@@ -21,11 +21,32 @@
 #import "FClock.h"
 #import "FIRDatabaseConfig_Private.h"
 #import "FWebSocketConnection.h"
+#import "FNextPushId.h"
 #import "FConstants.h"
 #import "FTestHelpers.h"
 
 @interface FWebSocketConnection (Tests)
 - (NSString*)userAgent;
+- (void)handleNewFrameCount:(int)numFrames;
+- (void)appendFrame:(NSString *)message;
+@end
+
+@interface FWebSocketRecordingDelegate : NSObject <FWebSocketDelegate>
+@property (nonatomic, strong) NSMutableArray *events;
+@property (nonatomic, strong) XCTestExpectation *disconnected;
+@end
+
+@implementation FWebSocketRecordingDelegate
+
+- (void)onMessage:(FWebSocketConnection *)fwebSocket withMessage:(NSDictionary *)message {
+    [self.events addObject:message];
+}
+
+- (void)onDisconnect:(FWebSocketConnection *)fwebSocket wasEverConnected:(BOOL)everConnected {
+    [self.events addObject:@"disconnect"];
+    [self.disconnected fulfill];
+}
+
 @end
 
 @interface FUtilitiesTest : XCTestCase
@@ -87,6 +108,50 @@
 
 }
 
+- (void)testWebSocketMessagesAreDeliveredInOrder {
+    dispatch_queue_t queue = dispatch_queue_create("FUtilitiesTest", DISPATCH_QUEUE_SERIAL);
+    FRepoInfo *repoInfo = [[FRepoInfo alloc] initWithHost:@"example.com" isSecure:NO withNamespace:@"default"];
+    FWebSocketConnection *conn = [[FWebSocketConnection alloc] initWith:repoInfo andQueue:queue lastSessionID:nil];
+    FWebSocketRecordingDelegate *recorder = [[FWebSocketRecordingDelegate alloc] init];
+    recorder.events = [NSMutableArray array];
+    recorder.disconnected = [self expectationWithDescription:@"disconnected"];
+    conn.delegate = recorder;
+
+    // The first message is large enough to decode off the connection's queue, so the small messages behind it and
+    // the close have to wait for it.
+    NSString *large = [@"" stringByPaddingToLength:3 * kWebsocketMaxFrameSize withString:@"a" startingAtIndex:0];
+    NSString *largeJSON = [NSString stringWithFormat:@"{\"d\":\"%@\"}", large];
+    dispatch_async(queue, ^{
+        [conn handleNewFrameCount:2];
+        [conn appendFrame:[largeJSON substringToIndex:10]];
+        [conn appendFrame:[largeJSON substringFromIndex:10]];
+        for (int i = 0; i < 3; i++) {
+            [conn handleNewFrameCount:1];
+            [conn appendFrame:[NSString stringWithFormat:@"{\"n\":%d}", i]];
+        }
+        [conn webSocket:nil didCloseWithCode:0 reason:nil wasClean:YES];
+    });
+
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+    NSArray *expected = @[ @{@"d" : large}, @{@"n" : @0}, @{@"n" : @1}, @{@"n" : @2}, @"disconnect" ];
+    XCTAssertEqualObjects(recorder.events, expected);
+}
+
+- (void)testPushIdBatchesAreOrdered {
+    NSTimeInterval now = 1500000000.123;
+    NSArray<NSString *> *ids = [FNextPushId get:now count:1000];
+    XCTAssertEqual(ids.count, (NSUInteger)1000);
+    for (NSUInteger i = 1; i < ids.count; i++) {
+        XCTAssertEqual(ids[i].length, (NSUInteger)20);
+        XCTAssertEqual([ids[i - 1] compare:ids[i] options:NSLiteralSearch], NSOrderedAscending);
+    }
+
+    // A single ID for the same time still comes after the batch.
+    NSString *next = [FNextPushId get:now];
+    XCTAssertEqual([ids.lastObject compare:next options:NSLiteralSearch], NSOrderedAscending);
+    XCTAssertEqualObjects([FNextPushId get:now count:0], @[]);
+}
+
 - (void)testKeyComparison {
     NSArray *order = @[
       @"-2147483648", @"0", @"1", @"2", @"10", @"2147483647", // Treated as integers
@@ -161,6 +161,66 @@ static NSString *const kFIRInstanceIDAPNSTokenKey = @"APNSTuple";
   [self waitForExpectationsWithTimeout:1 handler:nil];
 }
 
+/**
+ *  Tests that once a token has been saved, it is read from memory instead of the keychain.
+ */
+- (void)testSavedTokenIsReadFromMemory {
+  XCTestExpectation *tokenExpectation = [self expectationWithDescription:@"token is saved"];
+  FIRInstanceIDFakeKeychain *fakeKeychain = [[FIRInstanceIDFakeKeychain alloc] init];
+  FIRInstanceIDTokenStore *tokenStore =
+      [[FIRInstanceIDTokenStore alloc] initWithKeychain:fakeKeychain];
+  FIRInstanceIDTokenInfo *tokenInfo =
+      [[FIRInstanceIDTokenInfo alloc] initWithAuthorizedEntity:kAuthorizedEntity
+                                                         scope:kScope
+                                                         token:kToken
+                                                    appVersion:@"1.0"
+                                                 firebaseAppID:@"firebaseAppID"];
+  [tokenStore saveTokenInfo:tokenInfo
+                    handler:^(NSError *error) {
+                      XCTAssertNil(error);
+                      fakeKeychain.cannotReadFromKeychain = YES;
+                      XCTAssertEqualObjects(
+                          [tokenStore tokenInfoWithAuthorizedEntity:kAuthorizedEntity scope:kScope]
+                              .token,
+                          kToken);
+                      [tokenExpectation fulfill];
+                    }];
+  [self waitForExpectationsWithTimeout:1 handler:nil];
+}
+
+/**
+ *  Tests that once all tokens have been read, as they are when prefetched, lookups are answered
+ *  from memory, including for tokens that don't exist, and that removing all tokens clears them.
+ */
+- (void)testLoadedTokensAreReadFromMemoryUntilRemoved {
+  FIRInstanceIDFakeKeychain *fakeKeychain = [[FIRInstanceIDFakeKeychain alloc] init];
+  FIRInstanceIDTokenInfo *tokenInfo =
+      [[FIRInstanceIDTokenInfo alloc] initWithAuthorizedEntity:kAuthorizedEntity
+                                                         scope:kScope
+                                                         token:kToken
+                                                    appVersion:@"1.0"
+                                                 firebaseAppID:@"firebaseAppID"];
+  [fakeKeychain setData:[NSKeyedArchiver archivedDataWithRootObject:tokenInfo]
+             forService:[NSString stringWithFormat:@"%@:%@", kAuthorizedEntity, kScope]
+          accessibility:NULL
+                account:FIRInstanceIDAppIdentifier()
+                handler:nil];
+  FIRInstanceIDTokenStore *tokenStore =
+      [[FIRInstanceIDTokenStore alloc] initWithKeychain:fakeKeychain];
+  XCTAssertEqual([tokenStore cachedTokenInfos].count, 1);
+
+  fakeKeychain.cannotReadFromKeychain = YES;
+  XCTAssertEqualObjects(
+      [tokenStore tokenInfoWithAuthorizedEntity:kAuthorizedEntity scope:kScope].token, kToken);
+  XCTAssertNil([tokenStore tokenInfoWithAuthorizedEntity:kAuthorizedEntity scope:@"other-scope"]);
+  XCTAssertEqual([tokenStore cachedTokenInfos].count, 1);
+
+  [tokenStore removeAllTokensWithHandler:nil];
+  fakeKeychain.cannotReadFromKeychain = NO;
+  XCTAssertNil([tokenStore tokenInfoWithAuthorizedEntity:kAuthorizedEntity scope:kScope]);
+  XCTAssertEqual([tokenStore cachedTokenInfos].count, 0);
+}
+
 /**
  *  Tests that a checkin authentication ID can be stored in the FIRInstanceIDStore.
  */
@@ -1022,6 +1022,31 @@ static NSString *const kGoogleAppID = @"1:123:ios:123abc";
   OCMVerifyAll(self.mockTokenManager);
 }
 
+/**
+ *  Tests that the key pair is loaded while the checkin is still being fetched, rather than after
+ *  it, so that generating a key pair on a fresh install doesn't add to the checkin time.
+ */
+- (void)testNewTokenFetch_keyPairLoadsDuringCheckin {
+  XCTestExpectation *keyPairExpectation = [self expectationWithDescription:@"Key pair loaded."];
+
+  // The checkin never completes.
+  [[self.mockAuthService stub] fetchCheckinInfoWithHandler:[OCMArg any]];
+
+  id mockKeypair = [self createValidMockKeypair];
+  [[[[self.mockKeyPairStore stub] andDo:^(NSInvocation *invocation) {
+    [keyPairExpectation fulfill];
+  }] andReturn:mockKeypair] loadKeyPairWithError:[OCMArg anyObjectRef]];
+
+  [self.instanceID tokenWithAuthorizedEntity:kAuthorizedEntity
+                                       scope:kScope
+                                     options:nil
+                                     handler:^(NSString *token, NSError *error) {
+                                       XCTFail(@"The token handler must wait for the checkin.");
+                                     }];
+
+  [self waitForExpectationsWithTimeout:1 handler:nil];
+}
+
 /**
  *  If a token fetch includes in its options an "apns_token" object, but not a "apns_sandbox" key,
  *  ensure that an "apns_sandbox" key is added to the token options (via automatic detection).
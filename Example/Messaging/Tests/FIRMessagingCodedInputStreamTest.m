@@ -76,6 +76,25 @@
   XCTAssertNil([stream readDataWithLength:length]);
 }
 
+- (void)testReadingBytesInPlace {
+  NSData *sampleData = [[self class] sampleData2];
+  FIRMessagingCodedInputStream *stream =
+      [[FIRMessagingCodedInputStream alloc] initWithBytes:sampleData.bytes
+                                                   length:sampleData.length];
+  int8_t tag;
+  XCTAssertTrue([stream readTag:&tag]);
+  XCTAssertEqual(5, tag);
+  int32_t length;
+  XCTAssertTrue([stream readLength:&length]);
+  XCTAssertEqual(257, length);
+
+  NSData *data = [stream readDataNoCopyWithLength:length];
+  XCTAssertTrue([[[self class] packetDataForSampleData2] isEqualToData:data]);
+  // The data points into the bytes passed in rather than holding a copy.
+  XCTAssertEqual(data.bytes, (const uint8_t *)sampleData.bytes + stream.offset - length);
+  XCTAssertNil([stream readDataNoCopyWithLength:1]);
+}
+
 + (NSData *)sampleData1 {
   // tag = 2,
   // length = 4,
@@ -145,6 +145,80 @@ typedef void (^MockDelegateSubscriptionHandler)(NSString *topic,
   XCTAssertEqual(pendingTopics.numberOfBatches, 3);
 }
 
+- (void)testOpposingPendingActionsOnSameTopicAreCoalesced {
+  FIRMessagingPendingTopicsList *pendingTopics = [[FIRMessagingPendingTopicsList alloc] init];
+  pendingTopics.delegate = self.notReadyDelegate;
+
+  [pendingTopics addOperationForTopic:@"/topics/0"
+                           withAction:FIRMessagingTopicActionSubscribe
+                           completion:nil];
+  [pendingTopics addOperationForTopic:@"/topics/0"
+                           withAction:FIRMessagingTopicActionUnsubscribe
+                           completion:nil];
+  XCTAssertEqual(pendingTopics.numberOfBatches, 1);
+
+  [pendingTopics addOperationForTopic:@"/topics/0"
+                           withAction:FIRMessagingTopicActionSubscribe
+                           completion:nil];
+  XCTAssertEqual(pendingTopics.numberOfBatches, 1);
+}
+
+- (void)testBatchesAreMergedAfterCoalescingPendingActions {
+  FIRMessagingPendingTopicsList *pendingTopics = [[FIRMessagingPendingTopicsList alloc] init];
+  pendingTopics.delegate = self.notReadyDelegate;
+
+  [pendingTopics addOperationForTopic:@"/topics/0"
+                           withAction:FIRMessagingTopicActionSubscribe
+                           completion:nil];
+  [pendingTopics addOperationForTopic:@"/topics/1"
+                           withAction:FIRMessagingTopicActionUnsubscribe
+                           completion:nil];
+  [pendingTopics addOperationForTopic:@"/topics/2"
+                           withAction:FIRMessagingTopicActionSubscribe
+                           completion:nil];
+  XCTAssertEqual(pendingTopics.numberOfBatches, 3);
+
+  // Subscribing to topic 1 instead empties the unsubscribe batch, leaving one subscribe batch.
+  [pendingTopics addOperationForTopic:@"/topics/1"
+                           withAction:FIRMessagingTopicActionSubscribe
+                           completion:nil];
+  XCTAssertEqual(pendingTopics.numberOfBatches, 1);
+}
+
+- (void)testCompletionsOfCoalescedActionsAreCalled {
+  FIRMessagingPendingTopicsList *pendingTopics = [[FIRMessagingPendingTopicsList alloc] init];
+  pendingTopics.delegate = self.notReadyDelegate;
+
+  XCTestExpectation *subscribeCompleted =
+      [self expectationWithDescription:@"Replaced subscription completed"];
+  XCTestExpectation *unsubscribeCompleted =
+      [self expectationWithDescription:@"Unsubscription completed"];
+  [pendingTopics addOperationForTopic:@"/topics/0"
+                           withAction:FIRMessagingTopicActionSubscribe
+                           completion:^(NSError *error) {
+                             [subscribeCompleted fulfill];
+                           }];
+  [pendingTopics addOperationForTopic:@"/topics/0"
+                           withAction:FIRMessagingTopicActionUnsubscribe
+                           completion:^(NSError *error) {
+                             [unsubscribeCompleted fulfill];
+                           }];
+
+  __block NSInteger requestCount = 0;
+  self.alwaysReadyDelegate.subscriptionHandler =
+      ^(NSString *topic, FIRMessagingTopicAction action,
+        FIRMessagingTopicOperationCompletion completion) {
+        requestCount++;
+        XCTAssertEqual(action, FIRMessagingTopicActionUnsubscribe);
+        completion(nil);
+      };
+  pendingTopics.delegate = self.alwaysReadyDelegate;
+  [pendingTopics resumeOperationsIfNeeded];
+
+  [self waitForExpectationsWithTimeout:1.0 handler:nil];
+  XCTAssertEqual(requestCount, 1);
+}
+
 - (void)testBatchSizeReductionAfterSuccessfulTopicUpdate {
   FIRMessagingPendingTopicsList *pendingTopics = [[FIRMessagingPendingTopicsList alloc] init];
   pendingTopics.delegate = self.alwaysReadyDelegate;
@@ -58,6 +58,7 @@ typedef void(^FIRMessagingTestSocketConnectHandler)(void);
 @property(nonatomic, readwrite, strong) NSError *protoParseError;
 @property(nonatomic, readwrite, strong) GPBMessage *protoReceived;
 @property(nonatomic, readwrite, assign) int8_t protoTagReceived;
+@property(nonatomic, readwrite, strong) NSMutableArray<NSString *> *sentRmqIds;
 
 @property(nonatomic, readwrite, copy) FIRMessagingTestSocketDisconnectHandler disconnectHandler;
 @property(nonatomic, readwrite, copy) FIRMessagingTestSocketConnectHandler connectHandler;
@@ -74,6 +75,7 @@ static BOOL isSafeToDisconnectSocket = NO;
   self.protoParseError = nil;
   self.protoReceived = nil;
   self.protoTagReceived = 0;
+  self.sentRmqIds = [NSMutableArray array];
 }
 
 - (void)tearDown {
@@ -174,6 +176,40 @@ static BOOL isSafeToDisconnectSocket = NO;
                                }];
 }
 
+- (void)testSendingQueuedProtos {
+  [self createAndConnectSocketWithBufferSize:99];
+  [self writeVersionToOutStream];
+
+  XCTestExpectation *sentExpectation =
+      [self expectationWithDescription:@"Socket sends all queued protos in order"];
+  GtalkLoginRequest *loginRequest =
+      [FIRMessagingConnection loginRequestWithToken:@"gcmtoken" authID:@"gcmauthid"];
+  FIRMessagingSetLastStreamId(loginRequest, 1);
+  GtalkHeartbeatPing *ping = [[GtalkHeartbeatPing alloc] init];
+
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(2 * NSEC_PER_SEC)),
+                 dispatch_get_main_queue(), ^{
+      // Both protos are queued before the stream has space again, so they go out together.
+      [self.socket sendData:[loginRequest data]
+                    withTag:FIRMessagingGetTagForProto(loginRequest)
+                      rmqId:@"rmq-id-1"];
+      [self.socket sendData:[ping data]
+                    withTag:FIRMessagingGetTagForProto(ping)
+                      rmqId:@"rmq-id-2"];
+  });
+
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(4 * NSEC_PER_SEC)),
+                 dispatch_get_main_queue(), ^{
+      XCTAssertEqualObjects(self.sentRmqIds, (@[ @"rmq-id-1", @"rmq-id-2" ]));
+      [sentExpectation fulfill];
+  });
+
+  [self waitForExpectationsWithTimeout:5.0
+                               handler:^(NSError *error) {
+                                   XCTAssertNil(error);
+                               }];
+}
+
 - (void)testSendingImproperData {
   [self createAndConnectSocketWithBufferSize:124];
   [self writeVersionToOutStream];
@@ -286,7 +322,9 @@ static BOOL isSafeToDisconnectSocket = NO;
 - (void)secureSocket:(FIRMessagingSecureSocket *)socket
  didSendProtoWithTag:(int8_t)tag
                rmqId:(NSString *)rmqId {
-  // do nothing
+  if (rmqId) {
+    [self.sentRmqIds addObject:rmqId];
+  }
 }
 
 - (void)secureSocketDidConnect:(FIRMessagingSecureSocket *)socket {
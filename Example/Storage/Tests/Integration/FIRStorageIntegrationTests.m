@@ -425,6 +425,29 @@ NSTimeInterval kFIRStorageIntegrationTestTimeout = 30;
   [self waitForExpectations];
 }
 
+- (void)testUnauthenticatedSimpleStream {
+  XCTestExpectation *expectation =
+      [self expectationWithDescription:@"testUnauthenticatedSimpleStream"];
+
+  FIRStorageReference *ref = [self.storage referenceWithPath:@"ios/public/1mb"];
+
+  NSMutableData *streamedData = [NSMutableData data];
+  [ref streamWithChunkHandler:^(NSData *chunk) {
+    if (chunk) {
+      [streamedData appendData:chunk];
+    } else {
+      streamedData.length = 0;
+    }
+  }
+      completion:^(NSError *error) {
+        XCTAssertNil(error, "Error should be nil");
+        XCTAssertEqual(streamedData.length, 1 * 1024 * 1024);
+        [expectation fulfill];
+      }];
+
+  [self waitForExpectations];
+}
+
 - (void)testUnauthenticatedSimpleGetDataTooSmall {
   XCTestExpectation *expectation =
       [self expectationWithDescription:@"testUnauthenticatedSimpleGetDataTooSmall"];
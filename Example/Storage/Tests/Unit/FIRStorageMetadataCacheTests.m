@@ -0,0 +1,102 @@
+// Copyright 2019 Google
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <XCTest/XCTest.h>
+
+#import "FIRStorageMetadataCache.h"
+#import "FIRStoragePath.h"
+
+@interface FIRStorageMetadataCacheTests : XCTestCase
+
+@property(nonatomic) NSURL *fileURL;
+
+@end
+
+@implementation FIRStorageMetadataCacheTests
+
+- (void)setUp {
+  [super setUp];
+  NSString *fileName = [NSString stringWithFormat:@"metadata-cache-%@.json", [NSUUID UUID]];
+  NSString *filePath = [NSTemporaryDirectory() stringByAppendingPathComponent:fileName];
+  self.fileURL = [NSURL fileURLWithPath:filePath];
+}
+
+- (void)tearDown {
+  [[NSFileManager defaultManager] removeItemAtURL:self.fileURL error:NULL];
+  [super tearDown];
+}
+
+- (FIRStoragePath *)pathForObject:(NSString *)object {
+  return [[FIRStoragePath alloc] initWithBucket:@"bucket" object:object];
+}
+
+- (void)testStoresAndRemovesMetadata {
+  FIRStorageMetadataCache *cache = [[FIRStorageMetadataCache alloc] initWithFileURL:nil
+                                                                            capacity:10];
+  NSDictionary *dictionary = @{@"name" : @"a", @"generation" : @"1"};
+  XCTAssertNil([cache metadataDictionaryForPath:[self pathForObject:@"a"]]);
+  [cache setMetadataDictionary:dictionary forPath:[self pathForObject:@"a"]];
+  XCTAssertEqualObjects([cache metadataDictionaryForPath:[self pathForObject:@"a"]], dictionary);
+  XCTAssertNil([cache metadataDictionaryForPath:[self pathForObject:@"b"]]);
+  [cache removeMetadataForPath:[self pathForObject:@"a"]];
+  XCTAssertNil([cache metadataDictionaryForPath:[self pathForObject:@"a"]]);
+}
+
+- (void)testIgnoresOlderGenerations {
+  FIRStorageMetadataCache *cache = [[FIRStorageMetadataCache alloc] initWithFileURL:nil
+                                                                            capacity:10];
+  NSDictionary *newer = @{@"generation" : @"2", @"metageneration" : @"1"};
+  [cache setMetadataDictionary:newer forPath:[self pathForObject:@"a"]];
+  [cache setMetadataDictionary:@{@"generation" : @"1", @"metageneration" : @"5"}
+                       forPath:[self pathForObject:@"a"]];
+  XCTAssertEqualObjects([cache metadataDictionaryForPath:[self pathForObject:@"a"]], newer);
+
+  NSDictionary *updated = @{@"generation" : @"2", @"metageneration" : @"2"};
+  [cache setMetadataDictionary:updated forPath:[self pathForObject:@"a"]];
+  XCTAssertEqualObjects([cache metadataDictionaryForPath:[self pathForObject:@"a"]], updated);
+}
+
+- (void)testEvictsLeastRecentlyUsed {
+  FIRStorageMetadataCache *cache = [[FIRStorageMetadataCache alloc] initWithFileURL:nil
+                                                                            capacity:2];
+  [cache setMetadataDictionary:@{@"name" : @"a"} forPath:[self pathForObject:@"a"]];
+  [cache setMetadataDictionary:@{@"name" : @"b"} forPath:[self pathForObject:@"b"]];
+  XCTAssertNotNil([cache metadataDictionaryForPath:[self pathForObject:@"a"]]);
+  [cache setMetadataDictionary:@{@"name" : @"c"} forPath:[self pathForObject:@"c"]];
+  XCTAssertNotNil([cache metadataDictionaryForPath:[self pathForObject:@"a"]]);
+  XCTAssertNil([cache metadataDictionaryForPath:[self pathForObject:@"b"]]);
+  XCTAssertNotNil([cache metadataDictionaryForPath:[self pathForObject:@"c"]]);
+}
+
+- (void)testPersistsEntries {
+  FIRStorageMetadataCache *cache = [[FIRStorageMetadataCache alloc] initWithFileURL:self.fileURL
+                                                                            capacity:10];
+  NSDictionary *dictionary = @{@"name" : @"a", @"downloadTokens" : @"token"};
+  [cache setMetadataDictionary:dictionary forPath:[self pathForObject:@"a"]];
+
+  NSPredicate *fileExists = [NSPredicate predicateWithBlock:^BOOL(NSURL *fileURL, id bindings) {
+    return [[NSFileManager defaultManager] fileExistsAtPath:fileURL.path];
+  }];
+  [self waitForExpectations:@[ [self expectationForPredicate:fileExists
+                                         evaluatedWithObject:self.fileURL
+                                                     handler:nil] ]
+                    timeout:10];
+
+  FIRStorageMetadataCache *reloadedCache =
+      [[FIRStorageMetadataCache alloc] initWithFileURL:self.fileURL capacity:10];
+  XCTAssertEqualObjects([reloadedCache metadataDictionaryForPath:[self pathForObject:@"a"]],
+                        dictionary);
+}
+
+@end
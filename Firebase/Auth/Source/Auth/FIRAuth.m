@@ -103,8 +103,11 @@ static NSTimeInterval kMaxWaitTimeForBackoff = 16 * 60;
 
 /** @var kTokenRefreshHeadStart
     @brief The amount of time before the token expires that proactive refresh should be attempted.
+    @remarks This is longer than the five minutes before expiry that @c FIRSecureTokenService stops
+        handing out the cached token, so that Firestore, Storage and Functions keep getting the
+        cached token while the refresh runs instead of waiting for one of their own.
  */
-NSTimeInterval kTokenRefreshHeadStart  = 5 * 60;
+NSTimeInterval kTokenRefreshHeadStart  = 10 * 60;
 
 /** @var kUserKey
     @brief Key of user stored in the keychain. Prefixed with a Firebase app name.
@@ -1597,8 +1600,8 @@ didReceiveRemoteNotification:(NSDictionary *)userInfo {
 
 /** @fn scheduleAutoTokenRefreshWithDelay:
     @brief Schedules a task to automatically refresh tokens on the current user. The token refresh
-        is scheduled 5 minutes before the  scheduled expiration time.
-    @remarks If the token expires in less than 5 minutes, schedule the token refresh immediately.
+        is scheduled 10 minutes before the  scheduled expiration time.
+    @remarks If the token expires in less than 10 minutes, schedule the token refresh immediately.
  */
 - (void)scheduleAutoTokenRefresh {
   NSTimeInterval tokenExpirationInterval =
@@ -17,6 +17,7 @@
 #import "FIRSecureTokenService.h"
 
 #import "FIRAuth.h"
+#import "FIRAuthGlobalWorkQueue.h"
 #import "FIRAuthKeychain.h"
 #import "FIRAuthSerialTaskQueue.h"
 #import "FIRAuthBackend.h"
@@ -72,6 +73,8 @@ static const NSTimeInterval kFiveMinutes = 5 * 60;
   NSString *_Nullable _accessToken;
 }
 
+@synthesize accessTokenExpirationDate = _accessTokenExpirationDate;
+
 - (instancetype)init {
   self = [super init];
   if (self) {
@@ -106,6 +109,20 @@ static const NSTimeInterval kFiveMinutes = 5 * 60;
 
 - (void)fetchAccessTokenForcingRefresh:(BOOL)forceRefresh
                               callback:(FIRFetchAccessTokenCallback)callback {
+  // A valid cached token doesn't need to wait for a refresh that is already running, such as the
+  // proactive one FIRAuth schedules ahead of expiry.
+  if (!forceRefresh) {
+    NSString *accessToken;
+    @synchronized(self) {
+      accessToken = [self hasValidAccessToken] ? _accessToken : nil;
+    }
+    if (accessToken) {
+      dispatch_async(FIRAuthGlobalWorkQueue(), ^{
+        callback(accessToken, nil, NO);
+      });
+      return;
+    }
+  }
   [_taskQueue enqueueTask:^(FIRAuthSerialTaskCompletionBlock complete) {
     if (!forceRefresh && [self hasValidAccessToken]) {
       complete();
@@ -122,7 +139,15 @@ static const NSTimeInterval kFiveMinutes = 5 * 60;
 }
 
 - (NSString *)rawAccessToken {
-  return _accessToken;
+  @synchronized(self) {
+    return _accessToken;
+  }
+}
+
+- (nullable NSDate *)accessTokenExpirationDate {
+  @synchronized(self) {
+    return _accessTokenExpirationDate;
+  }
 }
 
 #pragma mark - NSSecureCoding
@@ -168,9 +193,9 @@ static const NSTimeInterval kFiveMinutes = 5 * 60;
     @param callback Called when the fetch is complete. Invoked asynchronously on the main thread in
         the future.
     @remarks Because this method is guaranteed to only be called from tasks enqueued in
-        @c _taskQueue, we do not need any @synchronized guards around access to _accessToken/etc.
-        since only one of those tasks is ever running at a time, and those tasks are the only
-        access to and mutation of these instance variables.
+        @c _taskQueue, only one refresh is ever running at a time. The access token and its
+        expiration date are still updated while synchronized on self, since valid cached tokens are
+        read outside of @c _taskQueue.
  */
 - (void)requestAccessToken:(FIRFetchAccessTokenCallback)callback {
   FIRSecureTokenRequest *request;
@@ -187,8 +212,10 @@ static const NSTimeInterval kFiveMinutes = 5 * 60;
     BOOL tokenUpdated = NO;
     NSString *newAccessToken = response.accessToken;
                        if (newAccessToken.length && ![newAccessToken isEqualToString:self->_accessToken]) {
-                         self->_accessToken = [newAccessToken copy];
-                         self->_accessTokenExpirationDate = response.approximateExpirationDate;
+                         @synchronized(self) {
+                           self->_accessToken = [newAccessToken copy];
+                           self->_accessTokenExpirationDate = response.approximateExpirationDate;
+                         }
       tokenUpdated = YES;
     }
     NSString *newRefreshToken = response.refreshToken;
@@ -32,6 +32,15 @@ NS_ASSUME_NONNULL_BEGIN
 /// Cached instances of components that requested to be cached.
 @property(nonatomic, strong) NSMutableDictionary<NSString *, id> *cachedInstances;
 
+/// Groups for the components that are being instantiated in the background, keyed by the NSString
+/// of the protocol. Each group is left once its component has been instantiated.
+@property(nonatomic, strong)
+    NSMutableDictionary<NSString *, dispatch_group_t> *backgroundInstantiations;
+
+/// The time each component's creation block took the last time it ran, keyed by the NSString of
+/// the protocol.
+@property(nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *instantiationTimes;
+
 @end
 
 @implementation FIRComponentContainer
@@ -67,6 +76,8 @@ static NSMutableSet<Class> *sFIRComponentRegistrants;
     _app = app;
     _cachedInstances = [NSMutableDictionary<NSString *, id> dictionary];
     _components = [NSMutableDictionary<NSString *, FIRComponentCreationBlock> dictionary];
+    _backgroundInstantiations = [NSMutableDictionary<NSString *, dispatch_group_t> dictionary];
+    _instantiationTimes = [NSMutableDictionary<NSString *, NSNumber *> dictionary];
 
     [self populateComponentsFromRegisteredClasses:allRegistrants forApp:app];
   }
@@ -74,6 +85,7 @@ static NSMutableSet<Class> *sFIRComponentRegistrants;
 }
 
 - (void)populateComponentsFromRegisteredClasses:(NSSet<Class> *)classes forApp:(FIRApp *)app {
+  NSMutableArray<FIRComponent *> *backgroundComponents = [NSMutableArray array];
   // Loop through the verified component registrants and populate the components array.
   for (Class<FIRLibrary> klass in classes) {
     // Loop through all the components being registered and store them as appropriate.
@@ -100,9 +112,28 @@ static NSMutableSet<Class> *sFIRComponentRegistrants;
            [app isDefaultApp]);
       if (shouldInstantiateEager || shouldInstantiateDefaultEager) {
         [self instantiateInstanceForProtocol:component.protocol withBlock:component.creationBlock];
+      } else if (component.instantiationTiming == FIRInstantiationTimingEagerInBackground) {
+        // Mark every background component as pending before any of them starts, so that one
+        // retrieving another waits for it instead of creating a second instance.
+        dispatch_group_t group = dispatch_group_create();
+        dispatch_group_enter(group);
+        self.backgroundInstantiations[protocolName] = group;
+        [backgroundComponents addObject:component];
       }
     }
   }
+
+  for (FIRComponent *component in backgroundComponents) {
+    NSString *protocolName = NSStringFromProtocol(component.protocol);
+    dispatch_group_t group = self.backgroundInstantiations[protocolName];
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^{
+      [self instantiateInstanceForProtocol:component.protocol withBlock:component.creationBlock];
+      @synchronized(self) {
+        [self.backgroundInstantiations removeObjectForKey:protocolName];
+      }
+      dispatch_group_leave(group);
+    });
+  }
 }
 
 #pragma mark - Instance Creation
@@ -112,6 +143,7 @@ static NSMutableSet<Class> *sFIRComponentRegistrants;
 ///   - Call the block to create an instance if possible,
 ///   - Validate that the instance returned conforms to the protocol it claims to,
 ///   - Cache the instance if the block requests it
+///   - Record how long the block took, for launch profiling
 - (nullable id)instantiateInstanceForProtocol:(Protocol *)protocol
                                     withBlock:(FIRComponentCreationBlock)creationBlock {
   if (!creationBlock) {
@@ -120,13 +152,21 @@ static NSMutableSet<Class> *sFIRComponentRegistrants;
 
   // Create an instance using the creation block.
   BOOL shouldCache = NO;
+  CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
   id instance = creationBlock(self, &shouldCache);
+  NSTimeInterval instantiationTime = CFAbsoluteTimeGetCurrent() - startTime;
+
+  NSString *protocolName = NSStringFromProtocol(protocol);
+  @synchronized(self) {
+    self.instantiationTimes[protocolName] = @(instantiationTime);
+  }
+  FIRLogDebug(kFIRLoggerCore, @"I-COR000035", @"Instantiating %@ took %.2f ms.", protocolName,
+              instantiationTime * 1000);
   if (!instance) {
     return nil;
   }
 
   // An instance was created, validate that it conforms to the protocol it claims to.
-  NSString *protocolName = NSStringFromProtocol(protocol);
   if (![instance conformsToProtocol:protocol]) {
     FIRLogError(kFIRLoggerCore, @"I-COR000030",
                 @"An instance conforming to %@ was requested, but the instance provided does not "
@@ -136,7 +176,14 @@ static NSMutableSet<Class> *sFIRComponentRegistrants;
 
   // The instance is ready to be returned, but check if it should be cached first before returning.
   if (shouldCache) {
-    self.cachedInstances[protocolName] = instance;
+    @synchronized(self) {
+      // Another thread may have cached an instance while this one was created, keep using that one.
+      id cachedInstance = self.cachedInstances[protocolName];
+      if (cachedInstance) {
+        return cachedInstance;
+      }
+      self.cachedInstances[protocolName] = instance;
+    }
   }
 
   return instance;
@@ -147,28 +194,56 @@ static NSMutableSet<Class> *sFIRComponentRegistrants;
 - (nullable id)instanceForProtocol:(Protocol *)protocol {
   // Check if there is a cached instance, and return it if so.
   NSString *protocolName = NSStringFromProtocol(protocol);
-  id cachedInstance = self.cachedInstances[protocolName];
-  if (cachedInstance) {
-    return cachedInstance;
+  dispatch_group_t backgroundInstantiation;
+  @synchronized(self) {
+    id cachedInstance = self.cachedInstances[protocolName];
+    if (cachedInstance) {
+      return cachedInstance;
+    }
+    backgroundInstantiation = self.backgroundInstantiations[protocolName];
+  }
+
+  // Wait for a component that is still being instantiated in the background.
+  if (backgroundInstantiation) {
+    dispatch_group_wait(backgroundInstantiation, DISPATCH_TIME_FOREVER);
+    @synchronized(self) {
+      id cachedInstance = self.cachedInstances[protocolName];
+      if (cachedInstance) {
+        return cachedInstance;
+      }
+    }
   }
 
   // Use the creation block to instantiate an instance and return it.
-  FIRComponentCreationBlock creationBlock = self.components[protocolName];
+  FIRComponentCreationBlock creationBlock;
+  @synchronized(self) {
+    creationBlock = self.components[protocolName];
+  }
   return [self instantiateInstanceForProtocol:protocol withBlock:creationBlock];
 }
 
+- (NSDictionary<NSString *, NSNumber *> *)instantiationDurations {
+  @synchronized(self) {
+    return [self.instantiationTimes copy];
+  }
+}
+
 #pragma mark - Lifecycle
 
 - (void)removeAllCachedInstances {
+  NSArray *cachedInstances;
+  @synchronized(self) {
+    cachedInstances = self.cachedInstances.allValues;
+    [self.cachedInstances removeAllObjects];
+  }
+
   // Loop through the cache and notify each instance that is a maintainer to clean up after itself.
-  for (id instance in self.cachedInstances.allValues) {
+  for (id instance in cachedInstances) {
     if ([instance conformsToProtocol:@protocol(FIRComponentLifecycleMaintainer)] &&
         [instance respondsToSelector:@selector(appWillBeDeleted:)]) {
       [instance appWillBeDeleted:self.app];
     }
   }
-
-  [self.cachedInstances removeAllObjects];
 }
 
 @end
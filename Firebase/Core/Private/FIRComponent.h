@@ -39,7 +39,12 @@ typedef _Nullable id (^FIRComponentCreationBlock)(FIRComponentContainer *contain
 typedef NS_ENUM(NSInteger, FIRInstantiationTiming) {
   FIRInstantiationTimingLazy,
   FIRInstantiationTimingAlwaysEager,
-  FIRInstantiationTimingEagerInDefaultApp
+  FIRInstantiationTimingEagerInDefaultApp,
+  /// Instantiated when the app is configured like `FIRInstantiationTimingAlwaysEager`, but on a
+  /// background queue and concurrently with other such components, so that configuring the app
+  /// doesn't wait for it. Retrieving the component before it's ready waits for it. Only use this
+  /// for components that can be created off the main thread.
+  FIRInstantiationTimingEagerInBackground
 } NS_SWIFT_NAME(InstantiationTiming);
 
 /// A component that can be used from other Firebase SDKs.
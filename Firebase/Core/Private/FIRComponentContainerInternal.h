@@ -34,6 +34,10 @@ NS_ASSUME_NONNULL_BEGIN
 /// Remove all of the cached instances stored and allow them to clean up after themselves.
 - (void)removeAllCachedInstances;
 
+/// The time in seconds each component's creation block took the last time it ran, keyed by the
+/// name of the component's protocol. Used to profile the work components do during app launch.
+- (NSDictionary<NSString *, NSNumber *> *)instantiationDurations;
+
 /// Register a class to provide components for the interoperability system. The class should conform
 /// to `FIRComponentRegistrant` and provide an array of `FIRComponent` objects.
 + (void)registerAsComponentRegistrant:(Class<FIRLibrary>)klass;
@@ -14,11 +14,15 @@
  * limitations under the License.
  */
 
+#import <CommonCrypto/CommonDigest.h>
 #import "FCompoundHash.h"
 #import "FLeafNode.h"
-#import "FStringUtilities.h"
 #import "FSnapshotUtilities.h"
 #import "FChildrenNode.h"
+#import "NSData+SRB64Additions.h"
+
+// The most characters a range buffers before feeding them to its hash.
+static const NSUInteger kFCompoundHashFlushLength = 4096;
 
 @interface FCompoundHashBuilder ()
 
@@ -32,7 +36,14 @@
 @implementation FCompoundHashBuilder {
 
     // NOTE: We use the existence of this to know if we've started building a range (i.e. encountered a leaf node).
+    // It only holds the end of the range; the rest has already been fed to hashContext, so that a range never
+    // has to be held as a whole string.
     NSMutableString *optHashValueBuilder;
+    CC_SHA1_CTX hashContext;
+    // The length of the part of the range that has been hashed.
+    NSUInteger hashedLength;
+    // Ranges used to be hashed as C strings, which end at the first NUL character.
+    BOOL hashEnded;
 
     // The current path as a stack. This is used in combination with currentPathDepth to simultaneously store the
     // last leaf node path. The depth is changed when descending and ascending, at the same time the current key
@@ -65,7 +76,7 @@
 }
 
 - (NSUInteger)currentHashLength {
-    return self->optHashValueBuilder.length;
+    return self->hashedLength + self->optHashValueBuilder.length;
 }
 
 - (FPath *)currentPath {
@@ -87,9 +98,30 @@
     [FSnapshotUtilities appendHashV2RepresentationForString:key toString:string];
 }
 
+- (void)flushHashValue {
+    if (!self->hashEnded && self->optHashValueBuilder.length > 0) {
+        NSData *data = [self->optHashValueBuilder dataUsingEncoding:NSUTF8StringEncoding];
+        const void *nul = memchr(data.bytes, 0, data.length);
+        NSUInteger length = nul ? (NSUInteger)((const char *)nul - (const char *)data.bytes) : data.length;
+        CC_SHA1_Update(&self->hashContext, data.bytes, (CC_LONG)length);
+        self->hashEnded = nul != NULL;
+    }
+    self->hashedLength += self->optHashValueBuilder.length;
+    [self->optHashValueBuilder setString:@""];
+}
+
+- (void)flushHashValueIfNeeded {
+    if (self->optHashValueBuilder.length >= kFCompoundHashFlushLength) {
+        [self flushHashValue];
+    }
+}
+
 - (void)ensureRange {
     if (![self isBuildingRange]) {
         optHashValueBuilder = [NSMutableString string];
+        CC_SHA1_Init(&self->hashContext);
+        self->hashedLength = 0;
+        self->hashEnded = NO;
         [optHashValueBuilder appendString:@"("];
         [self enumerateCurrentPathToDepth:self->currentPathDepth withBlock:^(NSString *key) {
             [self appendKey:key toString:self->optHashValueBuilder];
@@ -106,6 +138,7 @@
     [FSnapshotUtilities appendHashRepresentationForLeafNode:leafNode
                                                    toString:self->optHashValueBuilder
                                                 hashVersion:FDataHashVersionV2];
+    [self flushHashValueIfNeeded];
     self->needsComma = YES;
     if (self.splitStrategy(self)) {
         [self endRange];
@@ -120,6 +153,7 @@
     }
     [self appendKey:key toString:self->optHashValueBuilder];
     [self->optHashValueBuilder appendString:@":("];
+    [self flushHashValueIfNeeded];
     if (self->currentPathDepth == currentPath.count) {
         [self->currentPath addObject:key];
     } else {
@@ -156,7 +190,11 @@
     [self->optHashValueBuilder appendString:@")"];
 
     FPath *lastLeafPath = [self currentPathWithDepth:self->lastLeafDepth];
-    NSString *hash = [FStringUtilities base64EncodedSha1:self->optHashValueBuilder];
+    [self flushHashValue];
+    uint8_t digest[CC_SHA1_DIGEST_LENGTH];
+    CC_SHA1_Final(digest, &self->hashContext);
+    NSData *digestData = [[NSData alloc] initWithBytes:digest length:CC_SHA1_DIGEST_LENGTH];
+    NSString *hash = [FSRUtilities base64EncodedStringFromData:digestData];
     [self.currentHashes addObject:hash];
     [self.currentPaths addObject:lastLeafPath];
 
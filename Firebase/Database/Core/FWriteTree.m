@@ -41,6 +41,11 @@
 * Contains FWriteRecords.
 */
 @property (nonatomic, strong) NSMutableArray *allWrites;
+/**
+* The same writes as allWrites, indexed by the path they were made at, so that finding the writes that overlap a path
+* only touches that path's ancestors and descendants. Contains NSArrays of FWriteRecords, in write ID order.
+*/
+@property (nonatomic, strong) FImmutableTree *writesByPath;
 @property (nonatomic) NSInteger lastWriteId;
 @end
 
@@ -59,6 +64,7 @@
     if (self) {
         self.visibleWrites = [FCompoundWrite emptyWrite];
         self.allWrites = [[NSMutableArray alloc] init];
+        self.writesByPath = [FImmutableTree empty];
         self.lastWriteId = -1;
     }
     return self;
@@ -79,6 +85,7 @@
     NSAssert(writeId > self.lastWriteId, @"Stacking an older write on top of a newer one");
     FWriteRecord *record = [[FWriteRecord alloc] initWithPath:path overwrite:newData writeId:writeId visible:visible];
     [self.allWrites addObject:record];
+    [self indexWrite:record];
 
     if (visible) {
         self.visibleWrites = [self.visibleWrites addWrite:newData atPath:path];
@@ -95,15 +102,14 @@
     NSAssert(writeId > self.lastWriteId, @"Stacking an older merge on top of newer one");
     FWriteRecord *record = [[FWriteRecord alloc] initWithPath:path merge:changedChildren writeId:writeId];
     [self.allWrites addObject:record];
+    [self indexWrite:record];
 
     self.visibleWrites = [self.visibleWrites addCompoundWrite:changedChildren atPath:path];
     self.lastWriteId = writeId;
 }
 
 - (FWriteRecord *)writeForId:(NSInteger)writeId {
-    NSUInteger index = [self.allWrites indexOfObjectPassingTest:^BOOL(FWriteRecord *write, NSUInteger idx, BOOL *stop) {
-        return write.writeId == writeId;
-    }];
+    NSUInteger index = [self indexOfWriteId:writeId];
     return (index == NSNotFound) ? nil : self.allWrites[index];
 }
 
@@ -115,25 +121,22 @@
 * @return YES if the write may have been visible (meaning we'll need to reevaluate / raise events as a result).
 */
 - (BOOL) removeWriteId:(NSInteger)writeId {
-    NSUInteger index = [self.allWrites indexOfObjectPassingTest:^BOOL(FWriteRecord *record, NSUInteger idx, BOOL *stop) {
-        if (record.writeId == writeId) {
-            return YES;
-        } else {
-            return NO;
-        }
-    }];
+    NSUInteger index = [self indexOfWriteId:writeId];
     NSAssert(index != NSNotFound, @"[FWriteTree removeWriteId:] called with nonexistent writeId.");
     FWriteRecord *writeToRemove = self.allWrites[index];
     [self.allWrites removeObjectAtIndex:index];
+    [self unindexWrite:writeToRemove];
 
     BOOL removedWriteWasVisible = writeToRemove.visible;
     BOOL removedWriteOverlapsWithOtherWrites = NO;
-    NSInteger i = [self.allWrites count] - 1;
+    // Only writes on the removed write's path, above it or below it, can shadow it or be shadowed by it.
+    NSArray *overlappingWrites = [self writesOverlappingPath:writeToRemove.path];
+    NSInteger i = [overlappingWrites count] - 1;
 
     while (removedWriteWasVisible && i >= 0) {
-        FWriteRecord *currentWrite = [self.allWrites objectAtIndex:i];
+        FWriteRecord *currentWrite = [overlappingWrites objectAtIndex:i];
         if (currentWrite.visible) {
-            if (i >= index && [self record:currentWrite containsPath:writeToRemove.path]) {
+            if (currentWrite.writeId > writeId && [self record:currentWrite containsPath:writeToRemove.path]) {
                 // The removed write was completely shadowed by a subsequent write.
                 removedWriteWasVisible = NO;
             } else if ([writeToRemove.path contains:currentWrite.path]) {
@@ -168,6 +171,7 @@
     NSArray *writes = self.allWrites;
     self.visibleWrites = [FCompoundWrite emptyWrite];
     self.allWrites = [NSMutableArray array];
+    self.writesByPath = [FImmutableTree empty];
     return writes;
 }
 
@@ -217,7 +221,9 @@
                             (writeIdsToExclude == nil || ![writeIdsToExclude containsObject:[NSNumber numberWithInteger:record.writeId]]) &&
                             ([record.path contains:treePath] || [treePath contains:record.path]));
                 };
-                FCompoundWrite *mergeAtPath = [FWriteTree layerTreeFromWrites:self.allWrites filter:filter treeRoot:treePath];
+                FCompoundWrite *mergeAtPath = [FWriteTree layerTreeFromWrites:[self writesOverlappingPath:treePath]
+                                                                       filter:filter
+                                                                     treeRoot:treePath];
                 id<FNode> layeredCache = completeServerCache ? completeServerCache : [FEmptyNode emptyNode];
                 return [mergeAtPath applyToNode:layeredCache];
             }
@@ -367,6 +373,65 @@
 #pragma mark -
 #pragma mark Private Methods
 
+/**
+* allWrites is kept in write ID order, so a write can be found by binary search.
+*/
+- (NSUInteger) indexOfWriteId:(NSInteger)writeId {
+    NSUInteger low = 0;
+    NSUInteger high = self.allWrites.count;
+    while (low < high) {
+        NSUInteger mid = low + (high - low) / 2;
+        NSInteger midWriteId = ((FWriteRecord *)self.allWrites[mid]).writeId;
+        if (midWriteId == writeId) {
+            return mid;
+        } else if (midWriteId < writeId) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return NSNotFound;
+}
+
+- (void) indexWrite:(FWriteRecord *)record {
+    NSArray *writesAtPath = [self.writesByPath valueAtPath:record.path];
+    writesAtPath = writesAtPath ? [writesAtPath arrayByAddingObject:record] : @[record];
+    self.writesByPath = [self.writesByPath setValue:writesAtPath atPath:record.path];
+}
+
+- (void) unindexWrite:(FWriteRecord *)record {
+    NSMutableArray *writesAtPath = [[self.writesByPath valueAtPath:record.path] mutableCopy];
+    [writesAtPath removeObjectIdenticalTo:record];
+    if (writesAtPath.count > 0) {
+        self.writesByPath = [self.writesByPath setValue:[writesAtPath copy] atPath:record.path];
+    } else {
+        self.writesByPath = [self.writesByPath removeValueAtPath:record.path];
+    }
+}
+
+/**
+* @return The pending writes made at the given path or at any of its ancestors or descendants, in write ID order.
+*/
+- (NSArray *) writesOverlappingPath:(FPath *)path {
+    NSMutableArray *writes = [NSMutableArray array];
+    FImmutableTree *subtree = [self.writesByPath forEachOnPath:path performBlock:^(FPath *ancestorPath, NSArray *value) {
+        [writes addObjectsFromArray:value];
+    }];
+    [subtree forEach:^(FPath *childPath, NSArray *value) {
+        [writes addObjectsFromArray:value];
+    }];
+    [writes sortUsingComparator:^NSComparisonResult(FWriteRecord *first, FWriteRecord *second) {
+        if (first.writeId < second.writeId) {
+            return NSOrderedAscending;
+        } else if (first.writeId > second.writeId) {
+            return NSOrderedDescending;
+        } else {
+            return NSOrderedSame;
+        }
+    }];
+    return writes;
+}
+
 - (BOOL) record:(FWriteRecord *)record containsPath:(FPath *)path {
     if ([record isOverwrite]) {
         return [record.path contains:path];
@@ -58,8 +58,8 @@
     }
 }
 
-- (void) fireEventOnQueue:(dispatch_queue_t)queue {
-    [self.eventRegistration fireEvent:self queue:queue];
+- (void) fireEvent {
+    [self.eventRegistration fireEvent:self];
 }
 
 - (BOOL) isCancelEvent {
@@ -21,7 +21,8 @@
 
 @protocol FEvent <NSObject>
 - (FPath *) path;
-- (void) fireEventOnQueue:(dispatch_queue_t)queue;
+/** Calls the user's callback for this event. Events are fired on the callback queue. */
+- (void) fireEvent;
 - (BOOL) isCancelEvent;
 - (NSString *) description;
 @end
@@ -48,9 +48,19 @@
 }
 
 - (void) raiseEvents:(NSArray *)eventDataList {
-    for (id<FEvent> event in eventDataList) {
-        [event fireEventOnQueue:self.queue];
+    if (eventDataList.count == 0) {
+        return;
     }
+    // The events from one operation, such as the child added events of a large initial load, are all fired from a
+    // single dispatch rather than one per event.
+    NSArray *events = [eventDataList copy];
+    dispatch_async(self.queue, ^{
+        for (id<FEvent> event in events) {
+            @autoreleasepool {
+                [event fireEvent];
+            }
+        }
+    });
 }
 
 - (void) raiseCallback:(fbt_void_void)callback {
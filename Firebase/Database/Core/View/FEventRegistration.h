@@ -26,7 +26,7 @@
 @protocol FEventRegistration <NSObject>
 - (BOOL) responseTo:(FIRDataEventType)eventType;
 - (FDataEvent *) createEventFrom:(FChange *)change query:(FQuerySpec *)query;
-- (void) fireEvent:(id<FEvent>)event queue:(dispatch_queue_t)queue;
+- (void) fireEvent:(id<FEvent>)event;
 - (FCancelEvent *) createCancelEventFromError:(NSError *)error path:(FPath *)path;
 /**
 * Used to figure out what event registration match the event registration that needs to be removed.
@@ -25,6 +25,10 @@
 #import "FTrackedQuery.h"
 #import "FQueryParams.h"
 #import "FEmptyNode.h"
+#import "FLeafNode.h"
+#import "FChildrenNode.h"
+#import "FNodeEncoding.h"
+#import "FConstants.h"
 #import "FPruneForest.h"
 #import "FUtilities.h"
 #import "FPendingPut.h" // For legacy migration
@@ -35,10 +39,22 @@
 @property (nonatomic, strong) APLevelDB *writesDB;
 @property (nonatomic, strong) APLevelDB *serverCacheDB;
 
+// The total size of the server cache's values, kept up to date as the cache is written once it has been read, so
+// that cache size checks don't have to scan the cache.
+@property (nonatomic) NSUInteger serverCacheSize;
+@property (nonatomic) BOOL serverCacheSizeKnown;
+
+// The sorted first keys of each tracked query's key blocks, loaded as each query's keys are first touched.
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, NSMutableArray<NSString *> *> *trackedKeyBlocks;
+
 @end
 
 // WARNING: If you change this, you need to write a migration script
-static NSString * const kFPersistenceVersion = @"1";
+static NSString * const kFPersistenceVersion = @"3";
+// Version 1 stored server cache leaves and user writes as JSON.
+static NSString * const kFPersistenceVersionJSON = @"1";
+// Version 2 stored each tracked query key in its own row.
+static NSString * const kFPersistenceVersionKeyRows = @"2";
 
 static NSString * const kFServerDBPath = @"server_data";
 static NSString * const kFWritesDBPath = @"writes";
@@ -60,7 +76,12 @@ static NSString * const kFServerCachePrefix = @"/server_cache/";
 // We wan't the entire range of thing stored in the DB
 static NSString * const kFServerCacheRangeEnd = @"/server_cache~";
 static NSString * const kFTrackedQueriesPrefix = @"/tracked_queries/";
+// Only read when migrating from version 2 or earlier.
 static NSString * const kFTrackedQueryKeysPrefix = @"/tracked_query_keys/";
+static NSString * const kFTrackedQueryKeyBlocksPrefix = @"/tracked_query_key_blocks/";
+
+// Blocks that grow past this many keys are split.
+static const NSUInteger kFTrackedQueryKeysPerBlock = 512;
 
 // Failed to load JSON because a valid JSON turns out to be NaN while deserializing
 static const NSInteger kFNanFailureCode = 3840;
@@ -77,12 +98,25 @@ static NSString* trackedQueryKey(NSUInteger trackedQueryId) {
     return [NSString stringWithFormat:@"%@%lu", kFTrackedQueriesPrefix, (unsigned long)trackedQueryId];
 }
 
-static NSString* trackedQueryKeysKeyPrefix(NSUInteger trackedQueryId) {
-    return [NSString stringWithFormat:@"%@%lu/", kFTrackedQueryKeysPrefix, (unsigned long)trackedQueryId];
+static NSString* trackedQueryKeyBlocksPrefix(NSUInteger trackedQueryId) {
+    return [NSString stringWithFormat:@"%@%lu/", kFTrackedQueryKeyBlocksPrefix, (unsigned long)trackedQueryId];
+}
+
+// Each block is stored under the first key it holds.
+static NSString* trackedQueryKeyBlockKey(NSUInteger trackedQueryId, NSString *firstKey) {
+    return [NSString stringWithFormat:@"%@%lu/%@", kFTrackedQueryKeyBlocksPrefix, (unsigned long)trackedQueryId, firstKey];
 }
 
-static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
-    return [NSString stringWithFormat:@"%@%lu/%@", kFTrackedQueryKeysPrefix, (unsigned long)trackedQueryId, key];
+// The order keys are kept in within and across blocks.
+static NSComparator trackedKeyComparator(void) {
+    static NSComparator comparator;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        comparator = ^NSComparisonResult(NSString *first, NSString *second) {
+            return [first compare:second options:NSLiteralSearch];
+        };
+    });
+    return comparator;
 }
 
 @implementation FLevelDBStorageEngine
@@ -98,19 +132,25 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
          FPangolinDB *completenessDb = [aPersistence createDbByName:@"server_complete"];
          */
         [FLevelDBStorageEngine ensureDir:self.basePath markAsDoNotBackup:YES];
-        [self runMigration];
         [self openDatabases];
+        [self runMigration];
     }
     return self;
 }
 
 - (void)runMigration {
-    // Currently we're at version 1, so all we need to do is write that to a file
     NSString *versionFile = [self.basePath stringByAppendingPathComponent:@"version"];
     NSError *error;
     NSString *oldVersion = [NSString stringWithContentsOfFile:versionFile encoding:NSUTF8StringEncoding error:&error];
-    if (!oldVersion) {
-        // This is probably fine, we don't have a version file yet
+    if (!oldVersion || [oldVersion isEqualToString:kFPersistenceVersionJSON] ||
+        [oldVersion isEqualToString:kFPersistenceVersionKeyRows]) {
+        if ([oldVersion isEqualToString:kFPersistenceVersionJSON]) {
+            [self migrateFromJSON];
+        }
+        if (oldVersion) {
+            [self migrateTrackedQueryKeysToBlocks];
+        }
+        // Without a version file this is probably fine, we just don't have one yet
         BOOL success = [kFPersistenceVersion writeToFile:versionFile atomically:NO encoding:NSUTF8StringEncoding error:&error];
         if (!success) {
             FFWarn(@"I-RDB076001", @"Failed to write version for database: %@", error);
@@ -123,6 +163,79 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     }
 }
 
+/**
+ * Re-encodes the server cache leaves and user writes that version 1 stored as JSON. Each database is rewritten in a
+ * single batch, so an interrupted migration leaves it as it was and is run again on the next launch.
+ */
+- (void)migrateFromJSON {
+    NSDate *start = [NSDate date];
+    __block NSUInteger leaves = 0;
+    id<APLevelDBWriteBatch> serverCacheBatch = [self.serverCacheDB beginWriteBatch];
+    [self.serverCacheDB enumerateKeysWithPrefix:kFServerCachePrefix asData:^(NSString *key, NSData *data, BOOL *stop) {
+        id value = [self deserializeJSONPrimitive:data];
+        if (value == [NSNull null]) {
+            [serverCacheBatch removeKey:key];
+        } else {
+            [serverCacheBatch setData:[self serializePrimitive:value] forKey:key];
+            leaves++;
+        }
+    }];
+    if (![serverCacheBatch commit]) {
+        FFWarn(@"I-RDB076038", @"Failed to migrate server cache on disk!");
+    }
+
+    __block NSUInteger writes = 0;
+    id<APLevelDBWriteBatch> writesBatch = [self.writesDB beginWriteBatch];
+    [self.writesDB enumerateKeysAndValuesAsData:^(NSString *key, NSData *data, BOOL *stop) {
+        FWriteRecord *writeRecord = [self writeRecordFromJSONData:data];
+        if (writeRecord == nil) {
+            FFWarn(@"I-RDB076013", @"Removing failed write with key %@", key);
+            [writesBatch removeKey:key];
+        } else {
+            [writesBatch setData:[FNodeEncoding encodeWriteRecord:writeRecord] forKey:key];
+            writes++;
+        }
+    }];
+    if (![writesBatch commit]) {
+        FFWarn(@"I-RDB076039", @"Failed to migrate user writes on disk!");
+    }
+    FFDebug(@"I-RDB076040", @"Migrated %lu leaf nodes and %lu writes from JSON in %fms", (unsigned long)leaves,
+            (unsigned long)writes, [start timeIntervalSinceNow]*-1000);
+}
+
+/**
+ * Moves the tracked query keys that versions 1 and 2 stored one per row into key blocks, in a single batch.
+ */
+- (void)migrateTrackedQueryKeysToBlocks {
+    NSDate *start = [NSDate date];
+    NSMutableDictionary<NSNumber *, NSMutableSet *> *keysByQuery = [NSMutableDictionary dictionary];
+    id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
+    [self.serverCacheDB enumerateKeysWithPrefix:kFTrackedQueryKeysPrefix asStrings:^(NSString *dbKey, NSString *key, BOOL *stop) {
+        NSString *queryKey = [dbKey substringFromIndex:kFTrackedQueryKeysPrefix.length];
+        NSRange separator = [queryKey rangeOfString:@"/"];
+        if (separator.location != NSNotFound) {
+            NSNumber *queryId = @((NSUInteger)[[queryKey substringToIndex:separator.location] longLongValue]);
+            NSMutableSet *keys = keysByQuery[queryId];
+            if (keys == nil) {
+                keys = [NSMutableSet set];
+                keysByQuery[queryId] = keys;
+            }
+            [keys addObject:key];
+        }
+        [batch removeKey:dbKey];
+    }];
+    __block NSUInteger keyCount = 0;
+    [keysByQuery enumerateKeysAndObjectsUsingBlock:^(NSNumber *queryId, NSMutableSet *keys, BOOL *stop) {
+        [self writeTrackedQueryKeys:keys.allObjects toNewBlocks:nil forQueryId:queryId.unsignedIntegerValue batch:batch];
+        keyCount += keys.count;
+    }];
+    if (![batch commit]) {
+        FFWarn(@"I-RDB076041", @"Failed to migrate tracked query keys on disk!");
+    }
+    FFDebug(@"I-RDB076042", @"Migrated %lu tracked keys of %lu queries in %fms", (unsigned long)keyCount,
+            (unsigned long)keysByQuery.count, [start timeIntervalSinceNow]*-1000);
+}
+
 - (void)runLegacyMigration:(FRepoInfo *)info {
     NSArray *dirPaths = NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, NSUserDomainMask, YES);
     NSString *documentsDir = [dirPaths objectAtIndex:0];
@@ -177,6 +290,8 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 
 - (void)openDatabases {
     self.serverCacheDB = [self createDB:kFServerDBPath];
+    self.serverCacheSizeKnown = NO;
+    self.trackedKeyBlocks = [NSMutableDictionary dictionary];
     self.writesDB = [self createDB:kFWritesDBPath];
 }
 
@@ -244,25 +359,13 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 }
 
 - (void)saveUserOverwrite:(id<FNode>)node atPath:(FPath *)path writeId:(NSUInteger)writeId {
-    NSDictionary *write =
-    @{ kFUserWriteId: @(writeId),
-       kFUserWritePath: [path toStringWithTrailingSlash],
-       kFUserWriteOverwrite: [node valForExport:YES] };
-    NSError *error = nil;
-    NSData *data = [NSJSONSerialization dataWithJSONObject:write options:0 error:&error];
-    NSAssert(data, @"Failed to serialize user overwrite: %@, (Error: %@)", write, error);
-    [self.writesDB setData:data forKey:writeRecordKey(writeId)];
+    FWriteRecord *write = [[FWriteRecord alloc] initWithPath:path overwrite:node writeId:writeId visible:YES];
+    [self.writesDB setData:[FNodeEncoding encodeWriteRecord:write] forKey:writeRecordKey(writeId)];
 }
 
 - (void)saveUserMerge:(FCompoundWrite *)merge atPath:(FPath *)path writeId:(NSUInteger)writeId {
-    NSDictionary *write =
-    @{ kFUserWriteId: @(writeId),
-       kFUserWritePath: [path toStringWithTrailingSlash],
-       kFUserWriteMerge: [merge valForExport:YES] };
-    NSError *error = nil;
-    NSData *data = [NSJSONSerialization dataWithJSONObject:write options:0 error:&error];
-    NSAssert(data, @"Failed to serialize user merge: %@ (Error: %@)", write, error);
-    [self.writesDB setData:data forKey:writeRecordKey(writeId)];
+    FWriteRecord *write = [[FWriteRecord alloc] initWithPath:path merge:merge writeId:writeId];
+    [self.writesDB setData:[FNodeEncoding encodeWriteRecord:write] forKey:writeRecordKey(writeId)];
 }
 
 - (void)removeUserWrite:(NSUInteger)writeId {
@@ -289,34 +392,11 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     NSDate *date = [NSDate date];
     NSMutableArray *writes = [NSMutableArray array];
     [self.writesDB enumerateKeysAndValuesAsData:^(NSString *key, NSData *data, BOOL *stop) {
-        NSError *error = nil;
-        NSDictionary *writeJSON = [NSJSONSerialization JSONObjectWithData:data options:0 error:&error];
-        if (writeJSON == nil) {
-            if (error.code == kFNanFailureCode) {
-                FFWarn(@"I-RDB076012", @"Failed to deserialize write (%@), likely because of out of range doubles (Error: %@)",
-                       [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding],
-                       error);
-                FFWarn(@"I-RDB076013", @"Removing failed write with key %@", key);
-                [self.writesDB removeKey:key];
-            } else {
-                [NSException raise:NSInternalInconsistencyException format:@"Failed to deserialize write: %@", error];
-            }
-        } else {
-            NSInteger writeId = ((NSNumber *)writeJSON[kFUserWriteId]).integerValue;
-            FPath *path = [FPath pathWithString:writeJSON[kFUserWritePath]];
-            FWriteRecord *writeRecord;
-            if (writeJSON[kFUserWriteMerge] != nil) {
-                // It's a merge
-                FCompoundWrite *merge = [FCompoundWrite compoundWriteWithValueDictionary:writeJSON[kFUserWriteMerge]];
-                writeRecord = [[FWriteRecord alloc] initWithPath:path merge:merge writeId:writeId];
-            } else {
-                // It's an overwrite
-                NSAssert(writeJSON[kFUserWriteOverwrite] != nil, @"Persisted write did not contain merge or overwrite!");
-                id<FNode> node = [FSnapshotUtilities nodeFrom:writeJSON[kFUserWriteOverwrite]];
-                writeRecord = [[FWriteRecord alloc] initWithPath:path overwrite:node writeId:writeId visible:YES];
-            }
-            [writes addObject:writeRecord];
+        FWriteRecord *writeRecord = [FNodeEncoding decodeWriteRecord:data];
+        if (writeRecord == nil) {
+            [NSException raise:NSInternalInconsistencyException format:@"Failed to deserialize write with key %@", key];
         }
+        [writes addObject:writeRecord];
     }];
     // Make sure writes are sorted
     [writes sortUsingComparator:^NSComparisonResult(FWriteRecord *one, FWriteRecord *two) {
@@ -334,8 +414,7 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 
 - (id<FNode>)serverCacheAtPath:(FPath *)path {
     NSDate *start = [NSDate date];
-    id data = [self internalNestedDataForPath:path];
-    id<FNode> node = [FSnapshotUtilities nodeFrom:data];
+    id<FNode> node = [self internalNodeForPath:path];
     FFDebug(@"I-RDB076015", @"Loaded node with %d children at %@ in %fms", [node numChildren], path, [start timeIntervalSinceNow]*-1000);
     return node;
 }
@@ -344,8 +423,8 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     NSDate *start = [NSDate date];
     __block id<FNode> node = [FEmptyNode emptyNode];
     [keys enumerateObjectsUsingBlock:^(NSString *key, BOOL *stop) {
-        id data = [self internalNestedDataForPath:[path childFromString:key]];
-        node = [node updateImmediateChild:key withNewChild:[FSnapshotUtilities nodeFrom:data]];
+        id<FNode> child = [self internalNodeForPath:[path childFromString:key]];
+        node = [node updateImmediateChild:key withNewChild:child];
     }];
     FFDebug(@"I-RDB076016", @"Loaded node with %d children for %lu keys at %@ in %fms", [node numChildren], (unsigned long)keys.count, path, [start timeIntervalSinceNow]*-1000);
     return node;
@@ -354,22 +433,24 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 - (void)updateServerCache:(id<FNode>)node atPath:(FPath *)path merge:(BOOL)merge {
     NSDate *start = [NSDate date];
     id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
+    NSMutableDictionary *removedSizes = [NSMutableDictionary dictionary];
     // Remove any leaf nodes that might be higher up
-    [self removeAllLeafNodesOnPath:path batch:batch];
+    [self removeAllLeafNodesOnPath:path batch:batch removedSizes:removedSizes];
     __block NSUInteger counter = 0;
+    __block NSUInteger bytesWritten = 0;
     if (merge) {
         // remove any children that exist
         [node enumerateChildrenUsingBlock:^(NSString *childKey, id<FNode> childNode, BOOL *stop) {
             FPath *childPath = [path childFromString:childKey];
-            [self removeAllWithPrefix:serverCacheKey(childPath) batch:batch database:self.serverCacheDB];
-            [self saveNodeInternal:childNode atPath:childPath batch:batch counter:&counter];
+            [self removeServerCacheWithPrefix:serverCacheKey(childPath) batch:batch removedSizes:removedSizes];
+            [self saveNodeInternal:childNode atPath:childPath batch:batch counter:&counter bytesWritten:&bytesWritten];
         }];
     } else {
         // remove everything
-        [self removeAllWithPrefix:serverCacheKey(path) batch:batch database:self.serverCacheDB];
-        [self saveNodeInternal:node atPath:path batch:batch counter:&counter];
+        [self removeServerCacheWithPrefix:serverCacheKey(path) batch:batch removedSizes:removedSizes];
+        [self saveNodeInternal:node atPath:path batch:batch counter:&counter bytesWritten:&bytesWritten];
     }
-    BOOL success = [batch commit];
+    BOOL success = [self commitServerCacheBatch:batch removedSizes:removedSizes bytesWritten:bytesWritten];
     if (!success) {
         FFWarn(@"I-RDB076017", @"Failed to update server cache on disk!");
     } else {
@@ -380,15 +461,17 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 - (void)updateServerCacheWithMerge:(FCompoundWrite *)merge atPath:(FPath *)path {
     NSDate *start = [NSDate date];
     __block NSUInteger counter = 0;
+    __block NSUInteger bytesWritten = 0;
     id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
+    NSMutableDictionary *removedSizes = [NSMutableDictionary dictionary];
     // Remove any leaf nodes that might be higher up
-    [self removeAllLeafNodesOnPath:path batch:batch];
+    [self removeAllLeafNodesOnPath:path batch:batch removedSizes:removedSizes];
     [merge enumerateWrites:^(FPath *relativePath, id<FNode> node, BOOL *stop) {
         FPath *childPath = [path child:relativePath];
-        [self removeAllWithPrefix:serverCacheKey(childPath) batch:batch database:self.serverCacheDB];
-        [self saveNodeInternal:node atPath:childPath batch:batch counter:&counter];
+        [self removeServerCacheWithPrefix:serverCacheKey(childPath) batch:batch removedSizes:removedSizes];
+        [self saveNodeInternal:node atPath:childPath batch:batch counter:&counter bytesWritten:&bytesWritten];
     }];
-    BOOL success = [batch commit];
+    BOOL success = [self commitServerCacheBatch:batch removedSizes:removedSizes bytesWritten:bytesWritten];
     if (!success) {
         FFWarn(@"I-RDB076019", @"Failed to update server cache on disk!");
     } else {
@@ -396,17 +479,21 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     }
 }
 
-- (void)saveNodeInternal:(id<FNode>)node atPath:(FPath *)path batch:(id<APLevelDBWriteBatch>)batch counter:(NSUInteger *)counter {
+- (void)saveNodeInternal:(id<FNode>)node atPath:(FPath *)path batch:(id<APLevelDBWriteBatch>)batch counter:(NSUInteger *)counter bytesWritten:(NSUInteger *)bytesWritten {
     id data = [node valForExport:YES];
     if(data != nil && ![data isKindOfClass:[NSNull class]]) {
-        [self internalSetNestedData:data forKey:serverCacheKey(path) withBatch:batch counter:counter];
+        [self internalSetNestedData:data forKey:serverCacheKey(path) withBatch:batch counter:counter bytesWritten:bytesWritten];
     }
 }
 
 - (NSUInteger)serverCacheEstimatedSizeInBytes {
-    // Use the exact size, because for pruning the approximate size can lead to weird situations where we prune everything
-    // because no compaction is ever run
-    return [self.serverCacheDB exactSizeFrom:kFServerCachePrefix to:kFServerCacheRangeEnd];
+    if (!self.serverCacheSizeKnown) {
+        // Use the exact size, because for pruning the approximate size can lead to weird situations where we prune
+        // everything because no compaction is ever run
+        self.serverCacheSize = [self.serverCacheDB exactSizeFrom:kFServerCachePrefix to:kFServerCacheRangeEnd];
+        self.serverCacheSizeKnown = YES;
+    }
+    return self.serverCacheSize;
 }
 
 - (void)pruneCache:(FPruneForest *)pruneForest atPath:(FPath *)path {
@@ -418,18 +505,20 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 
     NSString *prefix = serverCacheKey(path);
     id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
+    NSMutableDictionary *removedSizes = [NSMutableDictionary dictionary];
 
-    [self.serverCacheDB enumerateKeysWithPrefix:prefix usingBlock:^(NSString *dbKey, BOOL *stop) {
+    [self.serverCacheDB enumerateKeysWithPrefix:prefix asData:^(NSString *dbKey, NSData *data, BOOL *stop) {
         NSString *pathStr = [dbKey substringFromIndex:prefix.length];
         FPath *relativePath = [[FPath alloc] initWith:pathStr];
         if ([pruneForest shouldPruneUnkeptDescendantsAtPath:relativePath]) {
             pruned++;
             [batch removeKey:dbKey];
+            removedSizes[dbKey] = @(data.length);
         } else {
             kept++;
         }
     }];
-    BOOL success = [batch commit];
+    BOOL success = [self commitServerCacheBatch:batch removedSizes:removedSizes bytesWritten:0];
     if (!success) {
         FFWarn(@"I-RDB076021", @"Failed to prune cache on disk!");
     } else {
@@ -482,10 +571,11 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
     [batch removeKey:trackedQueryKey(queryId)];
     __block NSUInteger keyCount = 0;
-    [self.serverCacheDB enumerateKeysWithPrefix:trackedQueryKeysKeyPrefix(queryId) usingBlock:^(NSString *key, BOOL *stop) {
+    [self.serverCacheDB enumerateKeysWithPrefix:trackedQueryKeyBlocksPrefix(queryId) asData:^(NSString *key, NSData *data, BOOL *stop) {
         [batch removeKey:key];
-        keyCount++;
+        keyCount += [FNodeEncoding decodeKeyBlock:data].count;
     }];
+    [self.trackedKeyBlocks removeObjectForKey:@(queryId)];
 
     BOOL success = [batch commit];
     if (!success) {
@@ -518,37 +608,25 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 
 - (void)setTrackedQueryKeys:(NSSet *)keys forQueryId:(NSUInteger)queryId {
     NSDate *start = [NSDate date];
-    __block NSUInteger removed = 0;
-    __block NSUInteger added = 0;
     id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
-    NSMutableSet *seenKeys = [NSMutableSet set];
-    // First, delete any keys that might be stored and are not part of the current keys
-    [self.serverCacheDB enumerateKeysWithPrefix:trackedQueryKeysKeyPrefix(queryId) asStrings:^(NSString *dbKey, NSString *actualKey, BOOL *stop) {
-        if ([keys containsObject:actualKey]) {
-            // Already in DB
-            [seenKeys addObject:actualKey];
-        } else {
-            // Not part of set, delete key
-            [batch removeKey:dbKey];
-            removed++;
-        }
-    }];
+    NSMutableArray<NSString *> *blocks = [self trackedKeyBlocksForQuery:queryId];
+    NSUInteger removedBlocks = blocks.count;
+    for (NSString *firstKey in blocks) {
+        [batch removeKey:trackedQueryKeyBlockKey(queryId, firstKey)];
+    }
+    NSMutableArray<NSString *> *newBlocks = [NSMutableArray array];
+    [self writeTrackedQueryKeys:keys.allObjects toNewBlocks:newBlocks forQueryId:queryId batch:batch];
 
-    // Next add any keys that are missing in the database
-    [keys enumerateObjectsUsingBlock:^(NSString *childKey, BOOL *stop) {
-        if (![seenKeys containsObject:childKey]) {
-            [batch setString:childKey forKey:trackedQueryKeysKey(queryId, childKey)];
-            added++;
-        }
-    }];
     BOOL success = [batch commit];
     if (!success) {
+        [self.trackedKeyBlocks removeObjectForKey:@(queryId)];
         FFWarn(@"I-RDB076029", @"Failed to set tracked queries on disk!");
     } else {
-        FFDebug(@"I-RDB076030", @"Set %lu tracked keys (%lu added, %lu removed) for query %lu in %fms",
+        self.trackedKeyBlocks[@(queryId)] = newBlocks;
+        FFDebug(@"I-RDB076030", @"Set %lu tracked keys (%lu blocks written, %lu removed) for query %lu in %fms",
                 (unsigned long)keys.count,
-                (unsigned long)added,
-                (unsigned long)removed,
+                (unsigned long)newBlocks.count,
+                (unsigned long)removedBlocks,
                 (unsigned long)queryId,
                 [start timeIntervalSinceNow]*-1000);
     }
@@ -556,15 +634,49 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 
 - (void)updateTrackedQueryKeysWithAddedKeys:(NSSet *)added removedKeys:(NSSet *)removed forQueryId:(NSUInteger)queryId {
     NSDate *start = [NSDate date];
+    NSMutableArray<NSString *> *blocks = [self trackedKeyBlocksForQuery:queryId];
+
+    // Load the keys of only the blocks the changed keys fall into. Keys that go before every block go into the first
+    // one, and if there are no blocks yet, the empty string stands for the new block.
+    NSMutableDictionary<NSString *, NSMutableSet *> *changedBlocks = [NSMutableDictionary dictionary];
+    NSMutableSet *(^keysOfBlockForKey)(NSString *) = ^NSMutableSet *(NSString *key) {
+        NSString *firstKey = [self trackedKeyBlockForKey:key inBlocks:blocks] ?: @"";
+        NSMutableSet *blockKeys = changedBlocks[firstKey];
+        if (blockKeys == nil) {
+            NSArray *storedKeys = nil;
+            if (firstKey.length > 0) {
+                NSData *data = [self.serverCacheDB dataForKey:trackedQueryKeyBlockKey(queryId, firstKey)];
+                storedKeys = [FNodeEncoding decodeKeyBlock:data];
+            }
+            blockKeys = storedKeys ? [NSMutableSet setWithArray:storedKeys] : [NSMutableSet set];
+            changedBlocks[firstKey] = blockKeys;
+        }
+        return blockKeys;
+    };
+    for (NSString *key in removed) {
+        if (blocks.count > 0) {
+            [keysOfBlockForKey(key) removeObject:key];
+        }
+    }
+    for (NSString *key in added) {
+        [keysOfBlockForKey(key) addObject:key];
+    }
+
     id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
-    [removed enumerateObjectsUsingBlock:^(NSString *key, BOOL *stop) {
-        [batch removeKey:trackedQueryKeysKey(queryId, key)];
-    }];
-    [added enumerateObjectsUsingBlock:^(NSString *key, BOOL *stop) {
-        [batch setString:key forKey:trackedQueryKeysKey(queryId, key)];
+    NSMutableArray<NSString *> *newBlocks = [NSMutableArray array];
+    [changedBlocks enumerateKeysAndObjectsUsingBlock:^(NSString *firstKey, NSMutableSet *blockKeys, BOOL *stop) {
+        if (firstKey.length > 0) {
+            [batch removeKey:trackedQueryKeyBlockKey(queryId, firstKey)];
+            [blocks removeObject:firstKey];
+        }
+        [self writeTrackedQueryKeys:blockKeys.allObjects toNewBlocks:newBlocks forQueryId:queryId batch:batch];
     }];
+    [blocks addObjectsFromArray:newBlocks];
+    [blocks sortUsingComparator:trackedKeyComparator()];
+
     BOOL success = [batch commit];
     if (!success) {
+        [self.trackedKeyBlocks removeObjectForKey:@(queryId)];
         FFWarn(@"I-RDB076031", @"Failed to update tracked queries on disk!");
     } else {
         FFDebug(@"I-RDB076032", @"Added %lu tracked keys, removed %lu for query %lu in %fms", (unsigned long)added.count, (unsigned long)removed.count, (unsigned long)queryId, [start timeIntervalSinceNow]*-1000);
@@ -574,51 +686,150 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 - (NSSet *)trackedQueryKeysForQuery:(NSUInteger)queryId {
     NSDate *start = [NSDate date];
     NSMutableSet *set = [NSMutableSet set];
-    [self.serverCacheDB enumerateKeysWithPrefix:trackedQueryKeysKeyPrefix(queryId) asStrings:^(NSString *dbKey, NSString *actualKey, BOOL *stop) {
-        [set addObject:actualKey];
+    NSString *prefix = trackedQueryKeyBlocksPrefix(queryId);
+    NSMutableArray<NSString *> *blocks = [NSMutableArray array];
+    [self.serverCacheDB enumerateKeysWithPrefix:prefix asData:^(NSString *dbKey, NSData *data, BOOL *stop) {
+        NSArray *keys = [FNodeEncoding decodeKeyBlock:data];
+        if (keys == nil) {
+            FFWarn(@"I-RDB076043", @"Failed to decode tracked keys at key %@", dbKey);
+        } else {
+            [set addObjectsFromArray:keys];
+        }
+        [blocks addObject:[dbKey substringFromIndex:prefix.length]];
     }];
+    [blocks sortUsingComparator:trackedKeyComparator()];
+    self.trackedKeyBlocks[@(queryId)] = blocks;
     FFDebug(@"I-RDB076033", @"Loaded %lu tracked keys for query %lu in %fms", (unsigned long)set.count, (unsigned long)queryId, [start timeIntervalSinceNow]*-1000);
     return set;
 }
 
+#pragma mark - Tracked key blocks
+
+- (NSMutableArray<NSString *> *)trackedKeyBlocksForQuery:(NSUInteger)queryId {
+    NSMutableArray<NSString *> *blocks = self.trackedKeyBlocks[@(queryId)];
+    if (blocks == nil) {
+        blocks = [NSMutableArray array];
+        NSString *prefix = trackedQueryKeyBlocksPrefix(queryId);
+        [self.serverCacheDB enumerateKeysWithPrefix:prefix usingBlock:^(NSString *key, BOOL *stop) {
+            [blocks addObject:[key substringFromIndex:prefix.length]];
+        }];
+        [blocks sortUsingComparator:trackedKeyComparator()];
+        self.trackedKeyBlocks[@(queryId)] = blocks;
+    }
+    return blocks;
+}
+
+/**
+ * @return The first key of the block that the given key belongs in: the last block starting at or before it, or the
+ * first block if there are none. Returns nil if there are no blocks.
+ */
+- (NSString *)trackedKeyBlockForKey:(NSString *)key inBlocks:(NSArray<NSString *> *)blocks {
+    if (blocks.count == 0) {
+        return nil;
+    }
+    NSUInteger low = 1;
+    NSUInteger high = blocks.count;
+    while (low < high) {
+        NSUInteger mid = low + (high - low) / 2;
+        if (trackedKeyComparator()(blocks[mid], key) == NSOrderedDescending) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return blocks[low - 1];
+}
+
+/**
+ * Sorts the given keys and writes them in as few blocks as fit them, of about the same size, adding each new block's
+ * first key to newBlocks.
+ */
+- (void)writeTrackedQueryKeys:(NSArray<NSString *> *)keys
+                  toNewBlocks:(NSMutableArray<NSString *> *)newBlocks
+                   forQueryId:(NSUInteger)queryId
+                        batch:(id<APLevelDBWriteBatch>)batch {
+    if (keys.count == 0) {
+        return;
+    }
+    NSArray<NSString *> *sortedKeys = [keys sortedArrayUsingComparator:trackedKeyComparator()];
+    NSUInteger blockCount = (sortedKeys.count + kFTrackedQueryKeysPerBlock - 1) / kFTrackedQueryKeysPerBlock;
+    NSUInteger offset = 0;
+    for (NSUInteger i = 0; i < blockCount; i++) {
+        NSUInteger end = sortedKeys.count * (i + 1) / blockCount;
+        NSArray<NSString *> *blockKeys = [sortedKeys subarrayWithRange:NSMakeRange(offset, end - offset)];
+        [batch setData:[FNodeEncoding encodeKeyBlock:blockKeys] forKey:trackedQueryKeyBlockKey(queryId, blockKeys[0])];
+        [newBlocks addObject:blockKeys[0]];
+        offset = end;
+    }
+}
+
 #pragma mark - Internal methods
 
-- (void)removeAllLeafNodesOnPath:(FPath *)path batch:(id<APLevelDBWriteBatch>)batch {
+- (void)removeAllLeafNodesOnPath:(FPath *)path batch:(id<APLevelDBWriteBatch>)batch removedSizes:(NSMutableDictionary *)removedSizes {
     while (!path.isEmpty) {
-        [batch removeKey:serverCacheKey(path)];
+        [self removeServerCacheKey:serverCacheKey(path) batch:batch removedSizes:removedSizes];
         path = [path parent];
     }
     // Make sure to delete any nodes at the root
-    [batch removeKey:serverCacheKey([FPath empty])];
+    [self removeServerCacheKey:serverCacheKey([FPath empty]) batch:batch removedSizes:removedSizes];
 }
 
-- (void)removeAllWithPrefix:(NSString *)prefix batch:(id<APLevelDBWriteBatch>)batch database:(APLevelDB *)database {
-    assert(prefix != nil);
+- (void)removeServerCacheKey:(NSString *)key batch:(id<APLevelDBWriteBatch>)batch removedSizes:(NSMutableDictionary *)removedSizes {
+    NSData *data = [self.serverCacheDB dataForKey:key];
+    if (data != nil) {
+        [batch removeKey:key];
+        removedSizes[key] = @(data.length);
+    }
+}
 
-    [database enumerateKeysWithPrefix:prefix usingBlock:^(NSString *key, BOOL *stop) {
+- (void)removeServerCacheWithPrefix:(NSString *)prefix batch:(id<APLevelDBWriteBatch>)batch removedSizes:(NSMutableDictionary *)removedSizes {
+    [self.serverCacheDB enumerateKeysWithPrefix:prefix asData:^(NSString *key, NSData *data, BOOL *stop) {
         [batch removeKey:key];
+        removedSizes[key] = @(data.length);
     }];
 }
 
+/**
+ * Commits a batch of server cache changes and accounts for them in the cache size. removedSizes holds the size of
+ * each key the batch removes, keyed by the key, so that a key removed twice is only counted once. Every key the batch
+ * writes has been removed first, so bytesWritten is all that replaces them.
+ */
+- (BOOL)commitServerCacheBatch:(id<APLevelDBWriteBatch>)batch removedSizes:(NSDictionary *)removedSizes bytesWritten:(NSUInteger)bytesWritten {
+    BOOL success = [batch commit];
+    if (success && self.serverCacheSizeKnown) {
+        __block NSUInteger bytesRemoved = 0;
+        [removedSizes enumerateKeysAndObjectsUsingBlock:^(NSString *key, NSNumber *size, BOOL *stop) {
+            bytesRemoved += size.unsignedIntegerValue;
+        }];
+        NSAssert(bytesRemoved <= self.serverCacheSize + bytesWritten, @"Removed more than the server cache holds");
+        self.serverCacheSize = self.serverCacheSize + bytesWritten - bytesRemoved;
+    } else {
+        // We can't tell what made it to disk, so measure the cache again when it's next needed.
+        self.serverCacheSizeKnown = NO;
+    }
+    return success;
+}
+
 #pragma mark - Internal helper methods
 
-- (void)internalSetNestedData:(id)value forKey:(NSString *)key withBatch:(id<APLevelDBWriteBatch>)batch counter:(NSUInteger *)counter {
+- (void)internalSetNestedData:(id)value forKey:(NSString *)key withBatch:(id<APLevelDBWriteBatch>)batch counter:(NSUInteger *)counter bytesWritten:(NSUInteger *)bytesWritten {
     if([value isKindOfClass:[NSDictionary class]]) {
         NSDictionary* dictionary = value;
         [dictionary enumerateKeysAndObjectsUsingBlock:^(id childKey, id obj, BOOL *stop) {
             assert(obj != nil);
             NSString* childPath = [NSString stringWithFormat:@"%@%@/", key, childKey];
-            [self internalSetNestedData:obj forKey:childPath withBatch:batch counter:counter];
+            [self internalSetNestedData:obj forKey:childPath withBatch:batch counter:counter bytesWritten:bytesWritten];
         }];
     }
     else {
         NSData *data = [self serializePrimitive:value];
         [batch setData:data forKey:key];
         (*counter)++;
+        (*bytesWritten) += data.length;
     }
 }
 
-- (id)internalNestedDataForPath:(FPath *)path {
+- (id<FNode>)internalNodeForPath:(FPath *)path {
     NSAssert(path != nil, @"Path was nil!");
 
     NSString *baseKey = serverCacheKey(path);
@@ -630,46 +841,100 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
         [iter seekToKey:baseKey];
         if (iter.key == nil || ![iter.key hasPrefix:baseKey]) {
             // No data.
-            return nil;
+            return [FEmptyNode emptyNode];
         } else {
-            return [self internalNestedDataFromIterator:iter andKeyPrefix:baseKey];
+            return [self internalNodeFromIterator:iter andKeyPrefix:baseKey];
         }
     }
 }
 
-- (id) internalNestedDataFromIterator:(APLevelDBIterator*)iterator andKeyPrefix:(NSString*)prefix {
+/**
+ * Builds the node stored under prefix straight from the iterator, which must be positioned at its first key, the same
+ * way +[FSnapshotUtilities nodeFrom:] would build it from the exported value the keys were written from. This skips
+ * materializing the whole subtree as nested NSDictionaries first, along with validating data we wrote ourselves.
+ */
+- (id<FNode>)internalNodeFromIterator:(APLevelDBIterator*)iterator andKeyPrefix:(NSString*)prefix {
     NSString* key = iterator.key;
 
     if ([key isEqualToString:prefix]) {
         id result = [self deserializePrimitive:iterator.valueAsData];
         [iterator nextKey];
-        return result;
+        return [FSnapshotUtilities nodeFrom:result];
     } else {
-        NSMutableDictionary *dict = [[NSMutableDictionary alloc] init];
+        NSMutableDictionary *children = [[NSMutableDictionary alloc] init];
+        id<FNode> value = nil;
+        id<FNode> priority = [FEmptyNode emptyNode];
         while (key != nil && [key hasPrefix:prefix]) {
             NSString *relativePath = [key substringFromIndex:prefix.length];
-            NSArray* pathPieces = [relativePath componentsSeparatedByString:@"/"];
-            assert(pathPieces.count > 0);
-            NSString *childName = pathPieces[0];
+            NSRange separator = [relativePath rangeOfString:@"/"];
+            NSString *childName = separator.location == NSNotFound ? relativePath : [relativePath substringToIndex:separator.location];
             NSString *childPath = [NSString stringWithFormat:@"%@%@/", prefix, childName];
-            id childValue = [self internalNestedDataFromIterator:iterator andKeyPrefix:childPath];
-            [dict setValue:childValue forKey:childName];
+            id<FNode> child = [self internalNodeFromIterator:iterator andKeyPrefix:childPath];
+            if ([childName isEqualToString:kPayloadValue]) {
+                value = child;
+            } else if ([childName isEqualToString:kPayloadPriority]) {
+                priority = child;
+            } else if (![childName hasPrefix:kPayloadMetadataPrefix] && ![child isEmpty]) {
+                children[childName] = child;
+            }
 
             key = iterator.key;
         }
-        return dict;
+
+        if (value != nil) {
+            return [value updatePriority:priority];
+        } else if (children.count == 0) {
+            return [FEmptyNode emptyNode];
+        } else {
+            FImmutableSortedDictionary *childrenDict = [FImmutableSortedDictionary fromDictionary:children
+                                                                                   withComparator:[FUtilities keyComparator]];
+            return [[FChildrenNode alloc] initWithPriority:priority children:childrenDict];
+        }
     }
 }
 
 
 - (NSData*) serializePrimitive:(id)value {
-    // HACK: The built-in serialization only works on dicts and arrays.  So we create an array and then strip off
-    // the leading / trailing byte (the [ and ]).
+    return [FNodeEncoding encodeLeafValue:value];
+}
+
+- (id) deserializePrimitive:(NSData*)data {
+    id result = [FNodeEncoding decodeLeafValue:data];
+    if (result == nil) {
+        [NSException raise:NSInternalInconsistencyException format:@"Failed to deserialize primitive: %@", data];
+    }
+    return result;
+}
+
+#pragma mark - JSON migration helper methods
+
+- (FWriteRecord *)writeRecordFromJSONData:(NSData *)data {
     NSError *error = nil;
-    NSData *data = [NSJSONSerialization dataWithJSONObject:@[value] options:0 error:&error];
-    NSAssert(data, @"Failed to serialize primitive: %@", error);
+    NSDictionary *writeJSON = [NSJSONSerialization JSONObjectWithData:data options:0 error:&error];
+    if (writeJSON == nil) {
+        if (error.code == kFNanFailureCode) {
+            FFWarn(@"I-RDB076012", @"Failed to deserialize write (%@), likely because of out of range doubles (Error: %@)",
+                   [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding],
+                   error);
+            return nil;
+        } else {
+            [NSException raise:NSInternalInconsistencyException format:@"Failed to deserialize write: %@", error];
+            return nil;
+        }
+    }
 
-    return [data subdataWithRange:NSMakeRange(1, data.length - 2)];
+    NSInteger writeId = ((NSNumber *)writeJSON[kFUserWriteId]).integerValue;
+    FPath *path = [FPath pathWithString:writeJSON[kFUserWritePath]];
+    if (writeJSON[kFUserWriteMerge] != nil) {
+        // It's a merge
+        FCompoundWrite *merge = [FCompoundWrite compoundWriteWithValueDictionary:writeJSON[kFUserWriteMerge]];
+        return [[FWriteRecord alloc] initWithPath:path merge:merge writeId:writeId];
+    } else {
+        // It's an overwrite
+        NSAssert(writeJSON[kFUserWriteOverwrite] != nil, @"Persisted write did not contain merge or overwrite!");
+        id<FNode> node = [FSnapshotUtilities nodeFrom:writeJSON[kFUserWriteOverwrite]];
+        return [[FWriteRecord alloc] initWithPath:path overwrite:node writeId:writeId visible:YES];
+    }
 }
 
 - (id)fixDoubleParsing:(id)value __attribute__((no_sanitize("float-cast-overflow"))) {
@@ -694,7 +959,7 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     return value;
 }
 
-- (id) deserializePrimitive:(NSData*)data {
+- (id) deserializeJSONPrimitive:(NSData*)data {
     NSError *error = nil;
     id result = [NSJSONSerialization JSONObjectWithData:data options:NSJSONReadingAllowFragments error:&error];
     if (result != nil) {
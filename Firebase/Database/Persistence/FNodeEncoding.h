@@ -0,0 +1,53 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "FNode.h"
+
+@class FWriteRecord;
+
+/**
+ * The binary encoding FLevelDBStorageEngine persists nodes with, in place of JSON.
+ *
+ * Every value starts with a type byte: null, false, true, a zigzag varint integer, a little endian IEEE 754 double,
+ * a varint length prefixed UTF-8 string, or children, which are a varint count followed by each child's length
+ * prefixed name and value in key order. A leaf or children value whose type byte has its high bit set is
+ * followed by its priority before the rest of the value.
+ *
+ * Leaf values decode to the same NSNumbers that reading them back from JSON used to give: doubles that hold an integer
+ * come back as integers. Decoding returns nil for anything that isn't a valid encoding.
+ */
+@interface FNodeEncoding : NSObject
+
++ (NSData *)encodeLeafValue:(id)value;
++ (id)decodeLeafValue:(NSData *)data;
+
++ (NSData *)encodeNode:(id<FNode>)node;
++ (id<FNode>)decodeNode:(NSData *)data;
+
+/** Write records hold their write ID, path and either an overwrite node or the (path, node) pairs of a merge. */
++ (NSData *)encodeWriteRecord:(FWriteRecord *)writeRecord;
++ (FWriteRecord *)decodeWriteRecord:(NSData *)data;
+
+/**
+ * Key blocks hold a sorted run of a tracked query's keys: their count, and then each key as the number of leading
+ * UTF-8 bytes it shares with the key before it and the varint length prefixed bytes that follow.
+ */
++ (NSData *)encodeKeyBlock:(NSArray<NSString *> *)sortedKeys;
++ (NSArray<NSString *> *)decodeKeyBlock:(NSData *)data;
+
+@end
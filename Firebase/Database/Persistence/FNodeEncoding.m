@@ -0,0 +1,416 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "FNodeEncoding.h"
+
+#import "FChildrenNode.h"
+#import "FCompoundWrite.h"
+#import "FConstants.h"
+#import "FEmptyNode.h"
+#import "FLeafNode.h"
+#import "FPath.h"
+#import "FUtilities.h"
+#import "FWriteRecord.h"
+
+typedef NS_ENUM(uint8_t, FNodeEncodingType) {
+    FNodeEncodingTypeNull = 0,
+    FNodeEncodingTypeFalse = 1,
+    FNodeEncodingTypeTrue = 2,
+    FNodeEncodingTypeInteger = 3,
+    FNodeEncodingTypeDouble = 4,
+    FNodeEncodingTypeString = 5,
+    FNodeEncodingTypeChildren = 6,
+};
+
+// Set in the type byte of a value that's followed by its priority.
+static const uint8_t kFNodeEncodingPriorityFlag = 0x80;
+
+typedef NS_ENUM(uint8_t, FNodeEncodingWriteKind) {
+    FNodeEncodingWriteKindOverwrite = 1,
+    FNodeEncodingWriteKindMerge = 2,
+};
+
+#pragma mark - Writing
+
+static void appendByte(NSMutableData *data, uint8_t byte) {
+    [data appendBytes:&byte length:1];
+}
+
+static void appendVarint(NSMutableData *data, uint64_t value) {
+    uint8_t buffer[10];
+    NSUInteger length = 0;
+    while (value >= 0x80) {
+        buffer[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    buffer[length++] = (uint8_t)value;
+    [data appendBytes:buffer length:length];
+}
+
+static void appendString(NSMutableData *data, NSString *string) {
+    NSUInteger length = [string lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    appendVarint(data, length);
+    NSUInteger offset = data.length;
+    [data increaseLengthBy:length];
+    [string getBytes:(uint8_t *)data.mutableBytes + offset
+           maxLength:length
+          usedLength:NULL
+            encoding:NSUTF8StringEncoding
+             options:0
+               range:NSMakeRange(0, string.length)
+      remainingRange:NULL];
+}
+
+static void appendNode(NSMutableData *data, id<FNode> node);
+
+static void appendPriority(NSMutableData *data, uint8_t flags, id<FNode> priority) {
+    if (flags & kFNodeEncodingPriorityFlag) {
+        appendNode(data, priority);
+    }
+}
+
+static BOOL doubleHoldsInteger(double value) {
+    // The bounds keep the cast to int64_t defined.
+    return value >= -9223372036854775808.0 && value < 9223372036854775808.0 && (double)(int64_t)value == value;
+}
+
+static void appendLeafValue(NSMutableData *data, id value, uint8_t flags, id<FNode> priority) {
+    NSString *jsType = [FUtilities getJavascriptType:value];
+    if (jsType == kJavaScriptString) {
+        appendByte(data, FNodeEncodingTypeString | flags);
+        appendPriority(data, flags, priority);
+        appendString(data, value);
+    } else if (jsType == kJavaScriptBoolean) {
+        appendByte(data, ([value boolValue] ? FNodeEncodingTypeTrue : FNodeEncodingTypeFalse) | flags);
+        appendPriority(data, flags, priority);
+    } else if (jsType == kJavaScriptNumber) {
+        NSNumber *number = value;
+        BOOL isInteger;
+        if (CFNumberIsFloatType((CFNumberRef)number)) {
+            isInteger = doubleHoldsInteger(number.doubleValue);
+        } else {
+            // Unsigned values beyond the signed range can only be held as doubles.
+            isInteger = strcmp(number.objCType, @encode(unsigned long long)) != 0 ||
+                        number.unsignedLongLongValue <= INT64_MAX;
+        }
+        if (isInteger) {
+            int64_t integer = number.longLongValue;
+            appendByte(data, FNodeEncodingTypeInteger | flags);
+            appendPriority(data, flags, priority);
+            appendVarint(data, ((uint64_t)integer << 1) ^ (uint64_t)(integer >> 63));
+        } else {
+            uint64_t bits = CFConvertDoubleHostToSwapped(number.doubleValue).v;
+            appendByte(data, FNodeEncodingTypeDouble | flags);
+            appendPriority(data, flags, priority);
+            [data appendBytes:&bits length:sizeof(bits)];
+        }
+    } else {
+        NSCAssert(value == nil || value == [NSNull null], @"Unknown leaf value: %@", value);
+        appendByte(data, FNodeEncodingTypeNull);
+    }
+}
+
+static void appendNode(NSMutableData *data, id<FNode> node) {
+    if ([node isEmpty]) {
+        appendByte(data, FNodeEncodingTypeNull);
+        return;
+    }
+
+    id<FNode> priority = [node getPriority];
+    uint8_t flags = [priority isEmpty] ? 0 : kFNodeEncodingPriorityFlag;
+    if ([node isLeafNode]) {
+        appendLeafValue(data, ((FLeafNode *)node).value, flags, priority);
+    } else {
+        FChildrenNode *childrenNode = (FChildrenNode *)node;
+        appendByte(data, FNodeEncodingTypeChildren | flags);
+        appendPriority(data, flags, priority);
+        appendVarint(data, (uint64_t)[childrenNode.children count]);
+        [childrenNode enumerateChildrenUsingBlock:^(NSString *key, id<FNode> child, BOOL *stop) {
+            appendString(data, key);
+            appendNode(data, child);
+        }];
+    }
+}
+
+#pragma mark - Reading
+
+typedef struct {
+    const uint8_t *next;
+    const uint8_t *end;
+} FNodeEncodingReader;
+
+static BOOL readByte(FNodeEncodingReader *reader, uint8_t *byte) {
+    if (reader->next == reader->end) {
+        return NO;
+    }
+    *byte = *reader->next++;
+    return YES;
+}
+
+static BOOL readVarint(FNodeEncodingReader *reader, uint64_t *value) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t byte;
+        if (!readByte(reader, &byte)) {
+            return NO;
+        }
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            *value = result;
+            return YES;
+        }
+    }
+    return NO;
+}
+
+static NSString *readString(FNodeEncodingReader *reader) {
+    uint64_t length;
+    if (!readVarint(reader, &length) || length > (uint64_t)(reader->end - reader->next)) {
+        return nil;
+    }
+    NSString *string = [[NSString alloc] initWithBytes:reader->next length:(NSUInteger)length encoding:NSUTF8StringEncoding];
+    reader->next += length;
+    return string;
+}
+
+static BOOL readType(FNodeEncodingReader *reader, FNodeEncodingType *type, BOOL *hasPriority) {
+    uint8_t byte;
+    if (!readByte(reader, &byte)) {
+        return NO;
+    }
+    *hasPriority = (byte & kFNodeEncodingPriorityFlag) != 0;
+    *type = (FNodeEncodingType)(byte & ~kFNodeEncodingPriorityFlag);
+    return YES;
+}
+
+static id readLeafValue(FNodeEncodingReader *reader, FNodeEncodingType type) {
+    switch (type) {
+        case FNodeEncodingTypeNull:
+            return [NSNull null];
+        case FNodeEncodingTypeFalse:
+            return @NO;
+        case FNodeEncodingTypeTrue:
+            return @YES;
+        case FNodeEncodingTypeInteger: {
+            uint64_t zigzag;
+            if (!readVarint(reader, &zigzag)) {
+                return nil;
+            }
+            return [NSNumber numberWithLongLong:(int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1)];
+        }
+        case FNodeEncodingTypeDouble: {
+            CFSwappedFloat64 bits;
+            if (reader->end - reader->next < (ptrdiff_t)sizeof(bits)) {
+                return nil;
+            }
+            memcpy(&bits.v, reader->next, sizeof(bits));
+            reader->next += sizeof(bits);
+            return [NSNumber numberWithDouble:CFConvertDoubleSwappedToHost(bits)];
+        }
+        case FNodeEncodingTypeString:
+            return readString(reader);
+        default:
+            return nil;
+    }
+}
+
+static id<FNode> readNode(FNodeEncodingReader *reader) {
+    FNodeEncodingType type;
+    BOOL hasPriority;
+    if (!readType(reader, &type, &hasPriority)) {
+        return nil;
+    }
+    if (type == FNodeEncodingTypeNull) {
+        return hasPriority ? nil : [FEmptyNode emptyNode];
+    }
+
+    id<FNode> priority = hasPriority ? readNode(reader) : [FEmptyNode emptyNode];
+    if (priority == nil) {
+        return nil;
+    }
+    if (type != FNodeEncodingTypeChildren) {
+        id value = readLeafValue(reader, type);
+        return value != nil ? [[FLeafNode alloc] initWithValue:value withPriority:priority] : nil;
+    }
+
+    uint64_t count;
+    if (!readVarint(reader, &count) || count == 0 ||
+        count > (uint64_t)(reader->end - reader->next)) {
+        return nil;
+    }
+    NSMutableDictionary *children = [NSMutableDictionary dictionaryWithCapacity:(NSUInteger)count];
+    for (uint64_t i = 0; i < count; i++) {
+        NSString *key = readString(reader);
+        id<FNode> child = key != nil ? readNode(reader) : nil;
+        if (child == nil || [child isEmpty] || children[key] != nil) {
+            return nil;
+        }
+        children[key] = child;
+    }
+    FImmutableSortedDictionary *childrenDict = [FImmutableSortedDictionary fromDictionary:children
+                                                                           withComparator:[FUtilities keyComparator]];
+    return [[FChildrenNode alloc] initWithPriority:priority children:childrenDict];
+}
+
+static FNodeEncodingReader readerForData(NSData *data) {
+    const uint8_t *bytes = data.bytes;
+    FNodeEncodingReader reader = { bytes, bytes + data.length };
+    return reader;
+}
+
+@implementation FNodeEncoding
+
++ (NSData *)encodeLeafValue:(id)value {
+    NSMutableData *data = [NSMutableData data];
+    appendLeafValue(data, value, 0, nil);
+    return data;
+}
+
++ (id)decodeLeafValue:(NSData *)data {
+    FNodeEncodingReader reader = readerForData(data);
+    FNodeEncodingType type;
+    BOOL hasPriority;
+    if (!readType(&reader, &type, &hasPriority) || hasPriority) {
+        return nil;
+    }
+    id value = readLeafValue(&reader, type);
+    return reader.next == reader.end ? value : nil;
+}
+
++ (NSData *)encodeNode:(id<FNode>)node {
+    NSMutableData *data = [NSMutableData data];
+    appendNode(data, node);
+    return data;
+}
+
++ (id<FNode>)decodeNode:(NSData *)data {
+    FNodeEncodingReader reader = readerForData(data);
+    id<FNode> node = readNode(&reader);
+    return reader.next == reader.end ? node : nil;
+}
+
++ (NSData *)encodeWriteRecord:(FWriteRecord *)writeRecord {
+    NSMutableData *data = [NSMutableData data];
+    appendByte(data, writeRecord.isMerge ? FNodeEncodingWriteKindMerge : FNodeEncodingWriteKindOverwrite);
+    appendVarint(data, (uint64_t)writeRecord.writeId);
+    appendString(data, [writeRecord.path toStringWithTrailingSlash]);
+    if (writeRecord.isMerge) {
+        __block uint64_t count = 0;
+        [writeRecord.merge enumerateWrites:^(FPath *path, id<FNode> node, BOOL *stop) {
+            count++;
+        }];
+        appendVarint(data, count);
+        [writeRecord.merge enumerateWrites:^(FPath *path, id<FNode> node, BOOL *stop) {
+            appendString(data, path.wireFormat);
+            appendNode(data, node);
+        }];
+    } else {
+        appendNode(data, writeRecord.overwrite);
+    }
+    return data;
+}
+
++ (FWriteRecord *)decodeWriteRecord:(NSData *)data {
+    FNodeEncodingReader reader = readerForData(data);
+    uint8_t kind;
+    uint64_t writeId;
+    if (!readByte(&reader, &kind) || !readVarint(&reader, &writeId)) {
+        return nil;
+    }
+    NSString *pathString = readString(&reader);
+    if (pathString == nil) {
+        return nil;
+    }
+    FPath *path = [FPath pathWithString:pathString];
+
+    FWriteRecord *writeRecord;
+    if (kind == FNodeEncodingWriteKindOverwrite) {
+        id<FNode> node = readNode(&reader);
+        if (node == nil) {
+            return nil;
+        }
+        writeRecord = [[FWriteRecord alloc] initWithPath:path overwrite:node writeId:(NSInteger)writeId visible:YES];
+    } else if (kind == FNodeEncodingWriteKindMerge) {
+        uint64_t count;
+        if (!readVarint(&reader, &count) || count > (uint64_t)(reader.end - reader.next)) {
+            return nil;
+        }
+        NSMutableDictionary *nodes = [NSMutableDictionary dictionaryWithCapacity:(NSUInteger)count];
+        for (uint64_t i = 0; i < count; i++) {
+            NSString *mergePath = readString(&reader);
+            id<FNode> node = mergePath != nil ? readNode(&reader) : nil;
+            if (node == nil) {
+                return nil;
+            }
+            nodes[mergePath] = node;
+        }
+        FCompoundWrite *merge = [FCompoundWrite compoundWriteWithNodeDictionary:nodes];
+        writeRecord = [[FWriteRecord alloc] initWithPath:path merge:merge writeId:(NSInteger)writeId];
+    } else {
+        return nil;
+    }
+    return reader.next == reader.end ? writeRecord : nil;
+}
+
++ (NSData *)encodeKeyBlock:(NSArray<NSString *> *)sortedKeys {
+    NSMutableData *data = [NSMutableData data];
+    appendVarint(data, (uint64_t)sortedKeys.count);
+    NSData *previous = nil;
+    for (NSString *key in sortedKeys) {
+        NSData *utf8 = [key dataUsingEncoding:NSUTF8StringEncoding];
+        const uint8_t *bytes = utf8.bytes;
+        const uint8_t *previousBytes = previous.bytes;
+        NSUInteger shared = 0;
+        NSUInteger maxShared = MIN(utf8.length, previous.length);
+        while (shared < maxShared && bytes[shared] == previousBytes[shared]) {
+            shared++;
+        }
+        appendVarint(data, (uint64_t)shared);
+        appendVarint(data, (uint64_t)(utf8.length - shared));
+        [data appendBytes:bytes + shared length:utf8.length - shared];
+        previous = utf8;
+    }
+    return data;
+}
+
++ (NSArray<NSString *> *)decodeKeyBlock:(NSData *)data {
+    FNodeEncodingReader reader = readerForData(data);
+    uint64_t count;
+    if (!readVarint(&reader, &count) || count > (uint64_t)(reader.end - reader.next)) {
+        return nil;
+    }
+    NSMutableArray<NSString *> *keys = [NSMutableArray arrayWithCapacity:(NSUInteger)count];
+    NSMutableData *current = [NSMutableData data];
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t shared;
+        uint64_t length;
+        if (!readVarint(&reader, &shared) || !readVarint(&reader, &length) || shared > current.length ||
+            length > (uint64_t)(reader.end - reader.next)) {
+            return nil;
+        }
+        current.length = (NSUInteger)shared;
+        [current appendBytes:reader.next length:(NSUInteger)length];
+        reader.next += length;
+        NSString *key = [[NSString alloc] initWithData:current encoding:NSUTF8StringEncoding];
+        if (key == nil) {
+            return nil;
+        }
+        [keys addObject:key];
+    }
+    return reader.next == reader.end ? keys : nil;
+}
+
+@end
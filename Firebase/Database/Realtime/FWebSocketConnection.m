@@ -29,8 +29,22 @@
 #import <UIKit/UIKit.h>
 #endif
 
+// Complete messages shorter than this, with nothing queued ahead of them, are decoded on the connection's queue.
+static const NSUInteger kFWebSocketInlineDecodeLength = 4096;
+
+/** A complete message waiting for its JSON to be decoded, or for the messages ahead of it to be delivered. */
+@interface FWebSocketPendingMessage : NSObject
+@property (nonatomic, strong) NSDictionary* message;
+@property (nonatomic) BOOL decoded;
+@end
+
+@implementation FWebSocketPendingMessage
+@end
+
 @interface FWebSocketConnection () {
     NSMutableString* frame;
+    NSMutableArray<FWebSocketPendingMessage *>* pendingMessages;
+    BOOL closeAfterPendingMessages;
     BOOL everConnected;
     BOOL isClosed;
     NSTimer* keepAlive;
@@ -66,6 +80,8 @@
         self.totalFrames = 0;
         self.dispatchQueue = queue;
         frame = nil;
+        pendingMessages = [NSMutableArray array];
+        closeAfterPendingMessages = NO;
 
         NSString* connectionUrl = [repoInfo connectionURLWithLastSessionID:lastSessionID];
         NSString* ua = [self userAgent];
@@ -197,16 +213,60 @@
     self.totalFrames = self.totalFrames - 1;
 
     if (self.totalFrames == 0) {
-        // Call delegate and pass an immutable version of the frame
-        NSDictionary* json = [NSJSONSerialization JSONObjectWithData:[frame dataUsingEncoding:NSUTF8StringEncoding]
-                                                             options:kNilOptions
-                                                               error:nil];
+        NSString* completeFrame = frame;
         frame = nil;
         FFLog(@"I-RDB083007", @"(wsc:%@) handleIncomingFrame sending complete frame: %d", self.connectionId, self.totalFrames);
+        [self handleCompleteFrame:completeFrame];
+    }
+}
+
++ (NSDictionary *) decodeFrame:(NSString *)completeFrame {
+    return [NSJSONSerialization JSONObjectWithData:[completeFrame dataUsingEncoding:NSUTF8StringEncoding]
+                                           options:kNilOptions
+                                             error:nil];
+}
 
+/**
+ * Large messages are decoded on a concurrent queue so that the connection's queue can keep reading frames, and, for
+ * high-rate listeners, so that several messages decode at once. Every complete message waits in pendingMessages until
+ * it and everything ahead of it have decoded, which keeps the delegate seeing messages in the order they arrived.
+ */
+- (void) handleCompleteFrame:(NSString *)completeFrame {
+    if (pendingMessages.count == 0 && completeFrame.length < kFWebSocketInlineDecodeLength) {
+        NSDictionary* json = [FWebSocketConnection decodeFrame:completeFrame];
         @autoreleasepool {
             [self.delegate onMessage:self withMessage:json];
         }
+        return;
+    }
+
+    FWebSocketPendingMessage* pending = [[FWebSocketPendingMessage alloc] init];
+    [pendingMessages addObject:pending];
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        NSDictionary* json;
+        @autoreleasepool {
+            json = [FWebSocketConnection decodeFrame:completeFrame];
+        }
+        dispatch_async(self.dispatchQueue, ^{
+            pending.message = json;
+            pending.decoded = YES;
+            [self deliverDecodedMessages];
+        });
+    });
+}
+
+- (void) deliverDecodedMessages {
+    // Everything that finished decoding while waiting on the message ahead of it goes out in this one pass.
+    @autoreleasepool {
+        while (pendingMessages.count > 0 && pendingMessages[0].decoded) {
+            FWebSocketPendingMessage* next = pendingMessages[0];
+            [pendingMessages removeObjectAtIndex:0];
+            [self.delegate onMessage:self withMessage:next.message];
+        }
+    }
+    if (pendingMessages.count == 0 && closeAfterPendingMessages) {
+        closeAfterPendingMessages = NO;
+        [self onClosed];
     }
 }
 
@@ -286,6 +346,11 @@
 }
 
 - (void) onClosed {
+    if (pendingMessages.count > 0) {
+        // Messages that arrived before the websocket closed are still delivered before the disconnect.
+        closeAfterPendingMessages = YES;
+        return;
+    }
     if (!isClosed) {
         FFLog(@"I-RDB083013", @"Websocket is closing itself");
         [self shutdown];
@@ -34,6 +34,10 @@
 - (FNamedNode *) firstChild;
 - (FNamedNode *) lastChild;
 
+// The estimated size of this node serialized as JSON, computed once per node so that unchanged
+// subtrees aren't walked again after a write.
+- (NSUInteger) estimatedSerializedSize;
+
 @property (nonatomic, strong) FImmutableSortedDictionary* children;
 @property (nonatomic, strong) id<FNode> priorityNode;
 
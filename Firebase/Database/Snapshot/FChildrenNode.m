@@ -29,6 +29,8 @@
 
 @interface FChildrenNode ()
 @property (nonatomic, strong) NSString *lazyHash;
+// Zero until computed; the estimate is never zero once it is.
+@property (nonatomic) NSUInteger lazyEstimatedSize;
 @end
 
 @implementation FChildrenNode
@@ -162,25 +164,20 @@
     __block NSInteger maxKey = 0;
     __block BOOL allIntegerKeys = YES;
 
-    NSMutableDictionary* obj = [[NSMutableDictionary alloc] initWithCapacity:[self.children count]];
+    NSUInteger count = (NSUInteger)[self.children count];
+    NSMutableArray* keys = [[NSMutableArray alloc] initWithCapacity:count];
+    NSMutableArray* values = [[NSMutableArray alloc] initWithCapacity:count];
+    // The parsed keys, in case the children turn out to be an array.
+    NSInteger* indices = malloc(count * sizeof(NSInteger));
     [self enumerateChildrenUsingBlock:^(NSString *key, id<FNode> childNode, BOOL *stop) {
-        [obj setObject:[childNode valForExport:exp] forKey:key];
-
-        numKeys++;
+        [keys addObject:key];
+        [values addObject:[childNode valForExport:exp]];
 
         // If we already found a string key, don't bother with any of this
-        if (!allIntegerKeys) {
-            return;
-        }
-
-        // Treat leading zeroes that are not exactly "0" as strings
-        NSString* firstChar = [key substringWithRange:NSMakeRange(0, 1)];
-        if ([firstChar isEqualToString:@"0"] && [key length] > 1) {
-            allIntegerKeys = NO;
-        } else {
-            NSNumber *keyAsNum = [FUtilities intForString:key];
-            if (keyAsNum != nil) {
-                NSInteger keyAsInt = [keyAsNum integerValue];
+        if (allIntegerKeys) {
+            NSInteger keyAsInt;
+            if ([FUtilities tryParseString:key asArrayIndex:&keyAsInt]) {
+                indices[numKeys] = keyAsInt;
                 if (keyAsInt > maxKey) {
                     maxKey = keyAsInt;
                 }
@@ -188,22 +185,25 @@
                 allIntegerKeys = NO;
             }
         }
+
+        numKeys++;
     }];
 
     if (!exp && allIntegerKeys && maxKey < 2 * numKeys) {
-        // convert to an array
+        // convert to an array, filling in the missing indices with nulls
         NSMutableArray* array = [[NSMutableArray alloc] initWithCapacity:maxKey + 1];
-        for (int i = 0; i <= maxKey; ++i) {
-            NSString* keyString = [NSString stringWithFormat:@"%i", i];
-            id child = obj[keyString];
-            if (child != nil) {
-                [array addObject:child];
-            } else {
-                [array addObject:[NSNull null]];
-            }
+        NSNull* null = [NSNull null];
+        for (NSInteger i = 0; i <= maxKey; ++i) {
+            [array addObject:null];
         }
+        for (int i = 0; i < numKeys; ++i) {
+            array[indices[i]] = values[i];
+        }
+        free(indices);
         return array;
     } else {
+        free(indices);
+        NSMutableDictionary* obj = [[NSMutableDictionary alloc] initWithObjects:values forKeys:keys];
 
         if(exp && [self getPriority] != nil && !self.getPriority.isEmpty) {
             obj[kPayloadPriority] = [self.getPriority val];
@@ -258,6 +258,19 @@
     return self.lazyHash;
 }
 
+- (NSUInteger) estimatedSerializedSize {
+    if (self.lazyEstimatedSize == 0) {
+        __block NSUInteger sum = 1; // opening brackets
+        [self enumerateChildrenAndPriorityUsingBlock:^(NSString *key, id<FNode> child, BOOL *stop) {
+            sum += key.length;
+            sum += 4; // quotes around key and colon and (comma or closing bracket)
+            sum += [FSnapshotUtilities estimateSerializedNodeSize:child];
+        }];
+        self.lazyEstimatedSize = sum;
+    }
+    return self.lazyEstimatedSize;
+}
+
 - (NSComparisonResult)compare:(id <FNode>)other {
     // children nodes come last, unless this is actually an empty node, then we come first.
     if (self.isEmpty) {
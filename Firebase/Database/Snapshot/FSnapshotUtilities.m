@@ -250,8 +250,16 @@
 
 + (void)appendHashV2RepresentationForString:(NSString *)string
                                    toString:(NSMutableString *)mutableString {
-    string = [string stringByReplacingOccurrencesOfString:@"\\" withString:@"\\\\"];
-    string = [string stringByReplacingOccurrencesOfString:@"\"" withString:@"\\\""];
+    static dispatch_once_t once;
+    static NSCharacterSet *escapedCharacters;
+    dispatch_once(&once, ^{
+        escapedCharacters = [NSCharacterSet characterSetWithCharactersInString:@"\\\""];
+    });
+    // Most strings have nothing to escape, so don't copy them twice to find out.
+    if ([string rangeOfCharacterFromSet:escapedCharacters].location != NSNotFound) {
+        string = [string stringByReplacingOccurrencesOfString:@"\\" withString:@"\\\\"];
+        string = [string stringByReplacingOccurrencesOfString:@"\"" withString:@"\\\""];
+    }
     [mutableString appendString:@"\""];
     [mutableString appendString:string];
     [mutableString appendString:@"\""];
@@ -288,13 +296,7 @@
         return [FSnapshotUtilities estimateLeafNodeSize:node];
     } else {
         NSAssert([node isKindOfClass:[FChildrenNode class]], @"Unexpected node type: %@", [node class]);
-        __block NSUInteger sum = 1; // opening brackets
-        [((FChildrenNode *)node) enumerateChildrenAndPriorityUsingBlock:^(NSString *key, id<FNode>child, BOOL *stop) {
-            sum += key.length;
-            sum += 4; // quotes around key and colon and (comma or closing bracket)
-            sum += [FSnapshotUtilities estimateSerializedNodeSize:child];
-        }];
-        return sum;
+        return [(FChildrenNode *)node estimatedSerializedSize];
     }
 }
 
@@ -20,4 +20,10 @@
 
 + (NSString *) get:(NSTimeInterval)now;
 
+/**
+ * Returns count push IDs for the given time, in increasing order, as if get: had been called count times in a row
+ * without the time changing.
+ */
++ (NSArray<NSString *> *) get:(NSTimeInterval)now count:(NSUInteger)count;
+
 @end
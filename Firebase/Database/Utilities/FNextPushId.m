@@ -17,47 +17,56 @@
 #import "FNextPushId.h"
 #import "FUtilities.h"
 
-static NSString *const PUSH_CHARS = @"-0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ_abcdefghijklmnopqrstuvwxyz";
+static const char PUSH_CHARS[] = "-0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ_abcdefghijklmnopqrstuvwxyz";
 
 @implementation FNextPushId
 
 + (NSString *) get:(NSTimeInterval)currentTime {
+    return [[self get:currentTime count:1] firstObject];
+}
+
++ (NSArray<NSString *> *) get:(NSTimeInterval)currentTime count:(NSUInteger)count {
     static long long lastPushTime = 0;
     static int lastRandChars[12];
 
-    long long now = (long long)(currentTime * 1000);
+    NSMutableArray<NSString *> *ids = [NSMutableArray arrayWithCapacity:count];
+    unichar idChars[20];
 
-    BOOL duplicateTime = now == lastPushTime;
-    lastPushTime = now;
+    // The last time and random characters are shared by every thread that makes push IDs.
+    @synchronized (self) {
+        long long now = (long long)(currentTime * 1000);
 
-    unichar timeStampChars[8];
-    for(int i = 7; i >= 0; i--) {
-        timeStampChars[i] = [PUSH_CHARS characterAtIndex:(now % 64)];
-        now = (long long)floor(now / 64);
-    }
+        BOOL duplicateTime = now == lastPushTime;
+        lastPushTime = now;
 
-    NSMutableString* id = [[NSMutableString alloc] init];
-    [id appendString:[NSString stringWithCharacters:timeStampChars length:8]];
+        for(int i = 7; i >= 0; i--) {
+            idChars[i] = PUSH_CHARS[now % 64];
+            now = now / 64;
+        }
 
+        for (NSUInteger n = 0; n < count; n++) {
+            if(!duplicateTime) {
+                for(int i = 0; i < 12; i++) {
+                    lastRandChars[i] = (int)arc4random_uniform(64);
+                }
+                duplicateTime = YES;
+            }
+            else {
+                int i = 0;
+                for(i = 11; i >= 0 && lastRandChars[i] == 63; i--) {
+                    lastRandChars[i] = 0;
+                }
+                lastRandChars[i]++;
+            }
 
-    if(!duplicateTime) {
-        for(int i = 0; i < 12; i++) {
-            lastRandChars[i] = (int)floor(arc4random() % 64);
+            for(int i = 0; i < 12; i++) {
+                idChars[8 + i] = PUSH_CHARS[lastRandChars[i]];
+            }
+            [ids addObject:[[NSString alloc] initWithCharacters:idChars length:20]];
         }
     }
-    else {
-        int i = 0;
-        for(i = 11; i >= 0 && lastRandChars[i] == 63; i--) {
-            lastRandChars[i] = 0;
-        }
-        lastRandChars[i]++;
-    }
-
-    for(int i = 0; i < 12; i++) {
-        [id appendFormat:@"%C", [PUSH_CHARS characterAtIndex:lastRandChars[i]]];
-    }
 
-    return [NSString stringWithString:id];
+    return ids;
 }
 
 @end
@@ -27,6 +27,8 @@
 + (NSString *) getJavascriptType:(id)obj;
 + (NSError *) errorForStatus:(NSString *)status andReason:(NSString *)reason;
 + (NSNumber *) intForString:(NSString *)string;
+// Parses a non-negative 32-bit integer without leading zeroes, as array indices are written.
++ (BOOL) tryParseString:(NSString *)string asArrayIndex:(NSInteger *)index;
 + (NSString *) ieee754StringForNumber:(NSNumber *)val;
 + (void) setLoggingEnabled:(BOOL)enabled;
 + (BOOL) getLoggingEnabled;
@@ -287,10 +287,13 @@ static inline BOOL tryParseStringToInt(__unsafe_unretained NSString* str, NSInte
     if (length > 11 || length == 0) {
         return NO;
     }
+    // Copy the characters out in one message rather than one per character.
+    unichar chars[11];
+    [str getCharacters:chars range:NSMakeRange(0, length)];
     long long value = 0;
     BOOL negative = NO;
     NSUInteger i = 0;
-    if ([str characterAtIndex:0] == '-') {
+    if (chars[0] == '-') {
         if (length == 1) {
             return NO;
         }
@@ -298,7 +301,7 @@ static inline BOOL tryParseStringToInt(__unsafe_unretained NSString* str, NSInte
         i = 1;
     }
     for(; i < length; i++) {
-        unichar c = [str characterAtIndex:i];
+        unichar c = chars[i];
         // Must be a digit, or '-' if it's the first char.
         if (c < '0' || c > '9') {
             return NO;
@@ -336,12 +339,34 @@ static inline BOOL tryParseStringToInt(__unsafe_unretained NSString* str, NSInte
     return minName;
 }
 
++ (BOOL) tryParseString:(NSString *)string asArrayIndex:(NSInteger *)index {
+    NSUInteger length = string.length;
+    if (length == 0) {
+        return NO;
+    }
+    unichar first = [string characterAtIndex:0];
+    // Negative numbers and leading zeroes other than exactly "0" are just names.
+    if (first == '-' || (first == '0' && length > 1)) {
+        return NO;
+    }
+    return tryParseStringToInt(string, index);
+}
+
 + (NSComparisonResult) compareKey:(NSString *)a toKey:(NSString *)b {
+    // Every child comparison checks for the sentinels, so look them up once.
+    static dispatch_once_t once;
+    static NSString *minName;
+    static NSString *maxName;
+    dispatch_once(&once, ^{
+        minName = [FUtilities minName];
+        maxName = [FUtilities maxName];
+    });
+
     if (a == b) {
         return NSOrderedSame;
-    } else if (a == [FUtilities minName] || b == [FUtilities maxName]) {
+    } else if (a == minName || b == maxName) {
         return NSOrderedAscending;
-    } else if (b == [FUtilities minName] || a == [FUtilities maxName]) {
+    } else if (b == minName || a == maxName) {
         return NSOrderedDescending;
     } else {
         NSInteger aAsInt, bAsInt;
@@ -29,7 +29,13 @@
 @property(nonatomic) id<FIRIAMTimeFetcher> timeFetcher;
 @end
 
-@implementation FIRIAMFetchResponseParser
+@implementation FIRIAMFetchResponseParser {
+  // Message nodes and the definitions parsed out of them in the last response, keyed by campaign
+  // id. Fetches mostly return the same campaigns again, so a node that did not change since the
+  // last parse reuses its definition instead of going through the conversion again.
+  NSDictionary<NSString *, NSDictionary *> *_lastMessageNodes;
+  NSDictionary<NSString *, FIRIAMMessageDefinition *> *_lastDefinitions;
+}
 
 - (instancetype)initWithTimeFetcher:(id<FIRIAMTimeFetcher>)timeFetcher {
   if (self = [super init]) {
@@ -68,12 +74,37 @@
   NSArray<NSDictionary *> *messageArray = responseDict[@"messages"];
   NSInteger discarded = 0;
 
+  NSDictionary<NSString *, NSDictionary *> *lastMessageNodes;
+  NSDictionary<NSString *, FIRIAMMessageDefinition *> *lastDefinitions;
+  @synchronized(self) {
+    lastMessageNodes = _lastMessageNodes;
+    lastDefinitions = _lastDefinitions;
+  }
+
+  NSMutableDictionary<NSString *, NSDictionary *> *messageNodes = [[NSMutableDictionary alloc] init];
+  NSMutableDictionary<NSString *, FIRIAMMessageDefinition *> *parsedDefinitions =
+      [[NSMutableDictionary alloc] init];
+  NSInteger reused = 0;
+
   NSMutableArray<FIRIAMMessageDefinition *> *definitions = [[NSMutableArray alloc] init];
   for (NSDictionary *nextMsg in messageArray) {
-    FIRIAMMessageDefinition *nextDefinition =
-        [self convertToMessageDefinitionWithMessageDict:nextMsg];
+    NSString *campaignID = [self campaignIDForMessageNode:nextMsg];
+    FIRIAMMessageDefinition *nextDefinition = nil;
+    if (campaignID && [lastMessageNodes[campaignID] isEqual:nextMsg]) {
+      nextDefinition = lastDefinitions[campaignID];
+    }
+    if (nextDefinition) {
+      reused++;
+    } else {
+      nextDefinition = [self convertToMessageDefinitionWithMessageDict:nextMsg];
+    }
+
     if (nextDefinition) {
       [definitions addObject:nextDefinition];
+      if (campaignID) {
+        messageNodes[campaignID] = nextMsg;
+        parsedDefinitions[campaignID] = nextDefinition;
+      }
     } else {
       FIRLogInfo(kFIRLoggerInAppMessaging, @"I-IAM900001",
                  @"No definition generated for message node %@", nextMsg);
@@ -84,6 +115,14 @@
       kFIRLoggerInAppMessaging, @"I-IAM900002",
       @"%lu message definitions were parsed out successfully and %lu messages are discarded",
       (unsigned long)definitions.count, (unsigned long)discarded);
+  FIRLogDebug(kFIRLoggerInAppMessaging, @"I-IAM900019",
+              @"%ld message definitions were unchanged since the last fetch and reused",
+              (long)reused);
+
+  @synchronized(self) {
+    _lastMessageNodes = [messageNodes copy];
+    _lastDefinitions = [parsedDefinitions copy];
+  }
 
   if (discardCount) {
     *discardCount = discarded;
@@ -91,6 +130,19 @@
   return [definitions copy];
 }
 
+// Return nil if the message node has no campaign id to identify it across fetches.
+- (nullable NSString *)campaignIDForMessageNode:(NSDictionary *)messageNode {
+  if (![messageNode isKindOfClass:[NSDictionary class]]) {
+    return nil;
+  }
+  id vanillaPayloadNode = messageNode[@"vanillaPayload"];
+  if (![vanillaPayloadNode isKindOfClass:[NSDictionary class]]) {
+    return nil;
+  }
+  id campaignID = vanillaPayloadNode[@"campaignId"];
+  return [campaignID isKindOfClass:[NSString class]] ? campaignID : nil;
+}
+
 // Return nil if no valid triggering condition can be detected
 - (NSArray<FIRIAMDisplayTriggerDefinition *> *)parseTriggeringCondition:
     (NSArray<NSDictionary *> *)triggerConditions {
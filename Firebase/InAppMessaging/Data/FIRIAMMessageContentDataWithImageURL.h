@@ -33,9 +33,9 @@ NS_ASSUME_NONNULL_BEGIN
  * @param actionURL url string for action.
  * @param imageURL  the url to the image. It can be nil to indicate the non-image in-app
  *                  message case.
- * @param URLSession can be nil in which case the class would create NSURLSession
- *                   internally to perform the network request. Having it here so that
- *                   it's easier for doing mocking with unit testing.
+ * @param URLSession can be nil in which case the class would use an NSURLSession shared by
+ *                   all messages, whose size capped cache keeps fetched images on disk.
+ *                   Having it here so that it's easier for doing mocking with unit testing.
  */
 - (instancetype)initWithMessageTitle:(NSString *)title
                          messageBody:(NSString *)body
@@ -43,5 +43,12 @@ NS_ASSUME_NONNULL_BEGIN
                            actionURL:(nullable NSURL *)actionURL
                             imageURL:(nullable NSURL *)imageURL
                      usingURLSession:(nullable NSURLSession *)URLSession;
+
+/**
+ * Starts a low priority fetch of the image into the URL session's cache, so that a later
+ * loadImageDataWithBlock: call can be served without waiting on the network. It's a no-op
+ * for messages without an image.
+ */
+- (void)prefetchImageData;
 @end
 NS_ASSUME_NONNULL_END
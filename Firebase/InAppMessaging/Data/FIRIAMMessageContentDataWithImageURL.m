@@ -24,6 +24,11 @@
 
 static NSInteger const SuccessHTTPStatusCode = 200;
 
+// Size caps for the cache image data is fetched through when no URL session is given.
+static NSUInteger const kImageCacheMemoryCapacity = 4 * 1024 * 1024;
+static NSUInteger const kImageCacheDiskCapacity = 20 * 1024 * 1024;
+static NSString *const kImageCacheDiskPath = @"com.google.fiam.images";
+
 @interface FIRIAMMessageContentDataWithImageURL ()
 @property(nonatomic, readwrite, nonnull, copy) NSString *titleText;
 @property(nonatomic, readwrite, nonnull, copy) NSString *bodyText;
@@ -34,6 +39,20 @@ static NSInteger const SuccessHTTPStatusCode = 200;
 @end
 
 @implementation FIRIAMMessageContentDataWithImageURL
+
++ (NSURLSession *)imageDataURLSession {
+  static NSURLSession *imageDataURLSession;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    NSURLSessionConfiguration *configuration =
+        [NSURLSessionConfiguration defaultSessionConfiguration];
+    configuration.URLCache = [[NSURLCache alloc] initWithMemoryCapacity:kImageCacheMemoryCapacity
+                                                           diskCapacity:kImageCacheDiskCapacity
+                                                               diskPath:kImageCacheDiskPath];
+    imageDataURLSession = [NSURLSession sessionWithConfiguration:configuration];
+  });
+  return imageDataURLSession;
+}
 - (instancetype)initWithMessageTitle:(NSString *)title
                          messageBody:(NSString *)body
                     actionButtonText:(nullable NSString *)actionButtonText
@@ -48,7 +67,7 @@ static NSInteger const SuccessHTTPStatusCode = 200;
     _actionURL = actionURL;
 
     if (imageURL) {
-      _URLSession = URLSession ? URLSession : [NSURLSession sharedSession];
+      _URLSession = URLSession ? URLSession : [[self class] imageDataURLSession];
     }
   }
   return self;
@@ -74,6 +93,30 @@ static NSInteger const SuccessHTTPStatusCode = 200;
   return _actionButtonText;
 }
 
+// Image urls of a campaign point to fixed content, so a cached response is used whenever there
+// is one instead of going to the network again.
+- (NSURLRequest *)imageDataRequest {
+  return [NSURLRequest requestWithURL:_imageURL
+                          cachePolicy:NSURLRequestReturnCacheDataElseLoad
+                      timeoutInterval:60];
+}
+
+- (void)prefetchImageData {
+  if (!_imageURL) {
+    return;
+  }
+  NSURLSessionDataTask *task =
+      [_URLSession dataTaskWithRequest:[self imageDataRequest]
+                     completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
+                       if (error) {
+                         FIRLogDebug(kFIRLoggerInAppMessaging, @"I-IAM000005",
+                                     @"Error in prefetching image %@: %@", self.imageURL, error);
+                       }
+                     }];
+  task.priority = NSURLSessionTaskPriorityLow;
+  [task resume];
+}
+
 - (void)loadImageDataWithBlock:(void (^)(NSData *_Nullable imageData,
                                          NSError *_Nullable error))block {
   if (!block) {
@@ -85,7 +128,7 @@ static NSInteger const SuccessHTTPStatusCode = 200;
     // no image data since image url is nil
     block(nil, nil);
   } else {
-    NSURLRequest *imageDataRequest = [NSURLRequest requestWithURL:_imageURL];
+    NSURLRequest *imageDataRequest = [self imageDataRequest];
     NSURLSessionDataTask *task = [_URLSession
         dataTaskWithRequest:imageDataRequest
           completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
@@ -42,6 +42,9 @@ static NSTimeInterval kMaxFetchWaitTimeInSeconds = 3 * 24 * 60 * 60;
 @property(nonatomic) double lastFetchTime;
 @property(nonatomic) double nextFetchWaitTime;
 @property(nonatomic, nonnull) NSUserDefaults *defaults;
+// Message ids from the stored impression records, kept in memory since they are checked on every
+// display check. It's nil until they are first read and after the records change.
+@property(nonatomic, nullable) NSArray<NSString *> *impressedMessageIDs;
 @end
 
 @interface FIRIAMImpressionRecord ()
@@ -164,6 +167,7 @@ static NSTimeInterval kMaxFetchWaitTimeInSeconds = 3 * 24 * 60 * 60;
     }
 
     [self.defaults setObject:newImpressions forKey:FIRIAM_UserDefaultsKeyForImpressions];
+    self.impressedMessageIDs = nil;
     [self.defaults setDouble:timestamp forKey:FIRIAM_UserDefaultsKeyForLastImpressionTimestamp];
     self.lastDisplayTime = timestamp;
   }
@@ -193,6 +197,7 @@ static NSTimeInterval kMaxFetchWaitTimeInSeconds = 3 * 24 * 60 * 60;
                    "server fetch response",
                   (int)(existingImpressions.count - updatedImpressions.count));
       [self.defaults setObject:updatedImpressions forKey:FIRIAM_UserDefaultsKeyForImpressions];
+      self.impressedMessageIDs = nil;
     } else {
       FIRLogDebug(kFIRLoggerInAppMessaging, @"I-IAM270005",
                   @"No impression records update due to no change after applying the server "
@@ -216,15 +221,22 @@ static NSTimeInterval kMaxFetchWaitTimeInSeconds = 3 * 24 * 60 * 60;
 }
 
 - (NSArray<NSString *> *)getMessageIDsFromImpressions {
-  NSArray<NSDictionary *> *impressionsFromStorage = [self fetchImpressionArrayFromStorage];
+  @synchronized(self) {
+    if (self.impressedMessageIDs) {
+      return self.impressedMessageIDs;
+    }
 
-  NSMutableArray<NSString *> *resultArray = [[NSMutableArray alloc] init];
+    NSArray<NSDictionary *> *impressionsFromStorage = [self fetchImpressionArrayFromStorage];
 
-  for (NSDictionary *next in impressionsFromStorage) {
-    [resultArray addObject:next[FIRIAM_ImpressionDictKeyForID]];
-  }
+    NSMutableArray<NSString *> *resultArray = [[NSMutableArray alloc] init];
 
-  return resultArray;
+    for (NSDictionary *next in impressionsFromStorage) {
+      [resultArray addObject:next[FIRIAM_ImpressionDictKeyForID]];
+    }
+
+    self.impressedMessageIDs = [resultArray copy];
+    return self.impressedMessageIDs;
+  }
 }
 
 - (void)recordNewFetchWithFetchCount:(NSInteger)fetchedMsgCount
@@ -250,7 +262,10 @@ static NSTimeInterval kMaxFetchWaitTimeInSeconds = 3 * 24 * 60 * 60;
 }
 
 - (void)cleanupImpressions {
-  [self.defaults setObject:@[] forKey:FIRIAM_UserDefaultsKeyForImpressions];
+  @synchronized(self) {
+    [self.defaults setObject:@[] forKey:FIRIAM_UserDefaultsKeyForImpressions];
+    self.impressedMessageIDs = nil;
+  }
 }
 
 - (void)cleanupFetchRecords {
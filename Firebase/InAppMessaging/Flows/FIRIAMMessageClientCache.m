@@ -21,6 +21,7 @@
 #import "FIRIAMDisplayTriggerDefinition.h"
 #import "FIRIAMFetchResponseParser.h"
 #import "FIRIAMMessageClientCache.h"
+#import "FIRIAMMessageContentDataWithImageURL.h"
 #import "FIRIAMServerMsgFetchStorage.h"
 
 @interface FIRIAMMessageClientCache ()
@@ -31,6 +32,10 @@
 @property(nonatomic) NSMutableArray<FIRIAMMessageDefinition *> *testMessages;
 @property(nonatomic, weak) id<FIRIAMCacheDataObserver> observer;
 @property(nonatomic) NSMutableSet<NSString *> *firebaseAnalyticEventsToWatch;
+// regular messages with analytics event triggers, keyed by the event names, in the same order as
+// in regularMessages
+@property(nonatomic) NSDictionary<NSString *, NSArray<FIRIAMMessageDefinition *> *>
+    *regularMessagesByAnalyticsEvent;
 @property(nonatomic) id<FIRIAMBookKeeper> bookKeeper;
 @property(readonly, nonatomic) FIRIAMFetchResponseParser *responseParser;
 
@@ -54,6 +59,7 @@
 
 // reset messages data
 - (void)setMessageData:(NSArray<FIRIAMMessageDefinition *> *)messages {
+  NSArray<FIRIAMMessageDefinition *> *eligibleMessages;
   @synchronized(self) {
     NSSet<NSString *> *impressionSet =
         [NSSet setWithArray:[self.bookKeeper getMessageIDsFromImpressions]];
@@ -81,8 +87,11 @@
     self.regularMessages =
         [[regularMessages filteredArrayUsingPredicate:notImpressedPredicate] mutableCopy];
     [self setupAnalyticsEventListening];
+    eligibleMessages = [self.testMessages arrayByAddingObjectsFromArray:self.regularMessages];
   }
 
+  [self prefetchImagesForMessages:eligibleMessages];
+
   FIRLogDebug(kFIRLoggerInAppMessaging, @"I-IAM160001",
               @"There are %lu test messages and %lu regular messages and "
                "%lu Firebase Analytics events to watch after "
@@ -92,18 +101,43 @@
   [self.observer dataChanged];
 }
 
+// Warm up the image cache for messages that may get displayed, so that rendering one of them
+// doesn't have to wait for its image to download.
+- (void)prefetchImagesForMessages:(NSArray<FIRIAMMessageDefinition *> *)messages {
+  for (FIRIAMMessageDefinition *next in messages) {
+    id<FIRIAMMessageContentData> contentData = next.renderData.contentData;
+    if ([contentData isKindOfClass:[FIRIAMMessageContentDataWithImageURL class]]) {
+      [(FIRIAMMessageContentDataWithImageURL *)contentData prefetchImageData];
+    }
+  }
+}
+
 // triggered after self.messages are updated so that we can correctly enable/disable listening
 // on analytics event based on current fiam message set
 - (void)setupAnalyticsEventListening {
   self.firebaseAnalyticEventsToWatch = [[NSMutableSet alloc] init];
+  NSMutableDictionary<NSString *, NSMutableArray<FIRIAMMessageDefinition *> *> *messagesByEvent =
+      [[NSMutableDictionary alloc] init];
   for (FIRIAMMessageDefinition *nextMessage in self.regularMessages) {
-    // if it's event based triggering, add it to the watch set
+    // if it's event based triggering, add it to the watch set and the index for its event
     for (FIRIAMDisplayTriggerDefinition *nextTrigger in nextMessage.renderTriggers) {
       if (nextTrigger.triggerType == FIRIAMRenderTriggerOnFirebaseAnalyticsEvent) {
-        [self.firebaseAnalyticEventsToWatch addObject:nextTrigger.firebaseEventName];
+        NSString *eventName = nextTrigger.firebaseEventName;
+        [self.firebaseAnalyticEventsToWatch addObject:eventName];
+
+        NSMutableArray<FIRIAMMessageDefinition *> *eventMessages = messagesByEvent[eventName];
+        if (!eventMessages) {
+          eventMessages = [[NSMutableArray alloc] init];
+          messagesByEvent[eventName] = eventMessages;
+        }
+        // a message can list the same event more than once
+        if (eventMessages.lastObject != nextMessage) {
+          [eventMessages addObject:nextMessage];
+        }
       }
     }
   }
+  self.regularMessagesByAnalyticsEvent = [messagesByEvent copy];
 
   if (self.analycisEventDislayCheckFlow) {
     if ([self.firebaseAnalyticEventsToWatch count] > 0) {
@@ -159,7 +193,11 @@
 - (nullable FIRIAMMessageDefinition *)nextOnFirebaseAnalyticEventDisplayMsg:(NSString *)eventName {
   FIRLogDebug(kFIRLoggerInAppMessaging, @"I-IAM160005",
               @"Inside nextOnFirebaseAnalyticEventDisplay for checking contextual trigger match");
-  if (![self.firebaseAnalyticEventsToWatch containsObject:eventName]) {
+  NSArray<FIRIAMMessageDefinition *> *candidates;
+  @synchronized(self) {
+    candidates = self.regularMessagesByAnalyticsEvent[eventName];
+  }
+  if (candidates.count == 0) {
     return nil;
   }
 
@@ -167,15 +205,12 @@
               @"There could be a potential message match for analytics event %@", eventName);
   NSSet<NSString *> *impressionSet =
       [NSSet setWithArray:[self.bookKeeper getMessageIDsFromImpressions]];
-  @synchronized(self) {
-    for (FIRIAMMessageDefinition *next in self.regularMessages) {
-      // message being active and message not impressed yet and the contextual trigger condition
-      // match
-      if ([next messageHasStarted] && ![next messageHasExpired] &&
-          ![impressionSet containsObject:next.renderData.messageID] &&
-          [next messageRenderedOnAnalyticsEvent:eventName]) {
-        return next;
-      }
+  for (FIRIAMMessageDefinition *next in candidates) {
+    // message being active and message not impressed yet. The contextual trigger condition
+    // matches since that's how the candidates are indexed
+    if ([next messageHasStarted] && ![next messageHasExpired] &&
+        ![impressionSet containsObject:next.renderData.messageID]) {
+      return next;
     }
   }
   return nil;
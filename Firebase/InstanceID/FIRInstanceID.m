@@ -316,6 +316,18 @@ static FIRInstanceID *gInstanceID;
     tokenOptions[kFIRInstanceIDTokenOptionsFirebaseAppIDKey] = self.firebaseAppID;
   }
 
+  // On a fresh install both the checkin and the key pair generation take a while, so the key pair
+  // is loaded while the checkin info is fetched instead of after it.
+  __block FIRInstanceIDKeyPair *loadedKeyPair;
+  __block NSError *keyPairError;
+  dispatch_group_t keyPairGroup = dispatch_group_create();
+  dispatch_group_enter(keyPairGroup);
+  [self asyncLoadKeyPairWithHandler:^(FIRInstanceIDKeyPair *keyPair, NSError *error) {
+    loadedKeyPair = keyPair;
+    keyPairError = error;
+    dispatch_group_leave(keyPairGroup);
+  }];
+
   FIRInstanceID_WEAKIFY(self);
   FIRInstanceIDAuthService *authService = self.tokenManager.authService;
   [authService
@@ -345,10 +357,10 @@ static FIRInstanceID *gInstanceID;
         }
 
         FIRInstanceID_WEAKIFY(self);
-        [self asyncLoadKeyPairWithHandler:^(FIRInstanceIDKeyPair *keyPair, NSError *error) {
+        dispatch_group_notify(keyPairGroup, dispatch_get_main_queue(), ^{
           FIRInstanceID_STRONGIFY(self);
 
-          if (error) {
+          if (keyPairError || !loadedKeyPair) {
             NSError *newError =
                 [NSError errorWithFIRInstanceIDErrorCode:kFIRInstanceIDErrorCodeInvalidKeyPair];
             newHandler(nil, newError);
@@ -356,11 +368,11 @@ static FIRInstanceID *gInstanceID;
           } else {
             [self.tokenManager fetchNewTokenWithAuthorizedEntity:[authorizedEntity copy]
                                                            scope:[scope copy]
-                                                         keyPair:keyPair
+                                                         keyPair:loadedKeyPair
                                                          options:tokenOptions
                                                          handler:newHandler];
           }
-        }];
+        });
       }];
 }
 
@@ -45,7 +45,12 @@ static NSString *const kFIRInstanceIDLibraryVersion = @"GMSInstanceID-version";
 
   FIRInstanceIDTokenStore *tokenStore = [FIRInstanceIDTokenStore defaultStore];
 
-  return [self initWithCheckinStore:checkinStore tokenStore:tokenStore delegate:delegate];
+  self = [self initWithCheckinStore:checkinStore tokenStore:tokenStore delegate:delegate];
+  if (self) {
+    // The default store is created while InstanceID starts, ahead of the first token requests.
+    [tokenStore prefetchTokenInfos];
+  }
+  return self;
 }
 
 - (instancetype)initWithCheckinStore:(FIRInstanceIDCheckinStore *)checkinStore
@@ -25,6 +25,10 @@
  *  keychain. The keychain keys that are used are:
  *  Account: <Main App Bundle ID> (e.g. com.mycompany.myapp)
  *  Service: <Sender ID>:<Scope> (e.g. 1234567890:*)
+ *
+ *  Token infos are kept in memory once read or written, since keychain queries can take tens of
+ *  milliseconds. The in-memory copy is updated whenever tokens are saved or removed through the
+ *  store, including when all tokens are removed because the Instance ID identity changed.
  */
 @interface FIRInstanceIDTokenStore : NSObject
 
@@ -70,6 +74,12 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (NSArray<FIRInstanceIDTokenInfo *> *)cachedTokenInfos;
 
+/**
+ *  Asynchronously read all token infos from the Keychain into memory, so that getting a token
+ *  during app launch doesn't have to wait on a Keychain query.
+ */
+- (void)prefetchTokenInfos;
+
 #pragma mark - Save
 
 /**
@@ -30,7 +30,17 @@ static NSString *const kFIRInstanceIDTokenKeychainId = @"com.google.iid-tokens";
 
 @end
 
-@implementation FIRInstanceIDTokenStore
+@implementation FIRInstanceIDTokenStore {
+  /// Token infos read from or written to the keychain, keyed by their keychain service. NSNull
+  /// marks a service that is known not to have a token. Guarded by @synchronized(self).
+  NSMutableDictionary<NSString *, id> *_tokenInfoCache;
+  /// Whether `_tokenInfoCache` holds every token in the keychain, so that a miss means there is no
+  /// token without having to query the keychain.
+  BOOL _cacheHoldsAllTokenInfos;
+  /// Incremented whenever the tokens change, so that a prefetch which read the keychain before a
+  /// change doesn't overwrite it with stale token infos.
+  NSUInteger _cacheGeneration;
+}
 
 + (instancetype)defaultStore {
   FIRInstanceIDAuthKeychain *tokenKeychain =
@@ -42,6 +52,7 @@ static NSString *const kFIRInstanceIDTokenKeychainId = @"com.google.iid-tokens";
   self = [super init];
   if (self) {
     _keychain = keychain;
+    _tokenInfoCache = [[NSMutableDictionary alloc] init];
   }
   return self;
 }
@@ -54,18 +65,52 @@ static NSString *const kFIRInstanceIDTokenKeychainId = @"com.google.iid-tokens";
 
 - (nullable FIRInstanceIDTokenInfo *)tokenInfoWithAuthorizedEntity:(NSString *)authorizedEntity
                                                              scope:(NSString *)scope {
-  NSString *account = FIRInstanceIDAppIdentifier();
   NSString *service = [[self class] serviceKeyForAuthorizedEntity:authorizedEntity scope:scope];
-  NSData *item = [self.keychain dataForService:service account:account];
-  if (!item) {
-    return nil;
+  NSUInteger generation;
+  @synchronized(self) {
+    id cachedTokenInfo = _tokenInfoCache[service];
+    if (cachedTokenInfo) {
+      return cachedTokenInfo == [NSNull null] ? nil : cachedTokenInfo;
+    }
+    if (_cacheHoldsAllTokenInfos) {
+      return nil;
+    }
+    generation = _cacheGeneration;
   }
+  NSString *account = FIRInstanceIDAppIdentifier();
+  NSData *item = [self.keychain dataForService:service account:account];
   // Token infos created from legacy storage don't have appVersion, firebaseAppID, or APNSInfo.
-  FIRInstanceIDTokenInfo *tokenInfo = [[self class] tokenInfoFromKeychainItem:item];
+  FIRInstanceIDTokenInfo *tokenInfo = item ? [[self class] tokenInfoFromKeychainItem:item] : nil;
+  @synchronized(self) {
+    if (generation == _cacheGeneration && !_tokenInfoCache[service]) {
+      _tokenInfoCache[service] = tokenInfo ?: [NSNull null];
+    }
+  }
   return tokenInfo;
 }
 
 - (NSArray<FIRInstanceIDTokenInfo *> *)cachedTokenInfos {
+  @synchronized(self) {
+    if (_cacheHoldsAllTokenInfos) {
+      return [self tokenInfosInCache];
+    }
+  }
+  return [self loadAllTokenInfos];
+}
+
+- (void)prefetchTokenInfos {
+  dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+    [self loadAllTokenInfos];
+  });
+}
+
+/// Reads every token from the keychain, and unless the tokens changed in the meantime, replaces
+/// the cache with them.
+- (NSArray<FIRInstanceIDTokenInfo *> *)loadAllTokenInfos {
+  NSUInteger generation;
+  @synchronized(self) {
+    generation = _cacheGeneration;
+  }
   NSString *account = FIRInstanceIDAppIdentifier();
   NSArray<NSData *> *items =
       [self.keychain itemsMatchingService:kFIRInstanceIDKeychainWildcardIdentifier account:account];
@@ -77,6 +122,29 @@ static NSString *const kFIRInstanceIDTokenKeychainId = @"com.google.iid-tokens";
       [tokenInfos addObject:tokenInfo];
     }
   }
+  @synchronized(self) {
+    if (generation == _cacheGeneration) {
+      [_tokenInfoCache removeAllObjects];
+      for (FIRInstanceIDTokenInfo *tokenInfo in tokenInfos) {
+        NSString *service = [[self class] serviceKeyForAuthorizedEntity:tokenInfo.authorizedEntity
+                                                                  scope:tokenInfo.scope];
+        _tokenInfoCache[service] = tokenInfo;
+      }
+      _cacheHoldsAllTokenInfos = YES;
+    }
+  }
+  return tokenInfos;
+}
+
+/// Must be called while synchronized on self.
+- (NSArray<FIRInstanceIDTokenInfo *> *)tokenInfosInCache {
+  NSMutableArray<FIRInstanceIDTokenInfo *> *tokenInfos =
+      [NSMutableArray arrayWithCapacity:_tokenInfoCache.count];
+  for (id tokenInfo in _tokenInfoCache.allValues) {
+    if (tokenInfo != [NSNull null]) {
+      [tokenInfos addObject:tokenInfo];
+    }
+  }
   return tokenInfos;
 }
 
@@ -111,11 +179,30 @@ static NSString *const kFIRInstanceIDTokenKeychainId = @"com.google.iid-tokens";
   NSString *account = FIRInstanceIDAppIdentifier();
   NSString *service = [[self class] serviceKeyForAuthorizedEntity:tokenInfo.authorizedEntity
                                                             scope:tokenInfo.scope];
+  // Until the write finishes the cache can't tell whether the keychain holds the new token, so the
+  // entry is left out of it and read from the keychain if asked for in the meantime.
+  NSUInteger generation;
+  @synchronized(self) {
+    [_tokenInfoCache removeObjectForKey:service];
+    _cacheHoldsAllTokenInfos = NO;
+    generation = ++_cacheGeneration;
+  }
   [self.keychain setData:tokenInfoData
               forService:service
            accessibility:NULL
                  account:account
-                 handler:handler];
+                 handler:^(NSError *error) {
+                   if (!error) {
+                     @synchronized(self) {
+                       if (generation == self->_cacheGeneration) {
+                         self->_tokenInfoCache[service] = tokenInfo;
+                       }
+                     }
+                   }
+                   if (handler) {
+                     handler(error);
+                   }
+                 }];
 }
 
 #pragma mark - Delete
@@ -124,10 +211,20 @@ static NSString *const kFIRInstanceIDTokenKeychainId = @"com.google.iid-tokens";
                                   scope:(nonnull NSString *)scope {
   NSString *account = FIRInstanceIDAppIdentifier();
   NSString *service = [[self class] serviceKeyForAuthorizedEntity:authorizedEntity scope:scope];
+  @synchronized(self) {
+    _tokenInfoCache[service] = [NSNull null];
+    _cacheGeneration++;
+  }
   [self.keychain removeItemsMatchingService:service account:account handler:nil];
 }
 
 - (void)removeAllTokensWithHandler:(void (^)(NSError *error))handler {
+  // This is also how the tokens of a deleted or invalidated identity are cleared.
+  @synchronized(self) {
+    [_tokenInfoCache removeAllObjects];
+    _cacheHoldsAllTokenInfos = YES;
+    _cacheGeneration++;
+  }
   NSString *account = FIRInstanceIDAppIdentifier();
   [self.keychain removeItemsMatchingService:kFIRInstanceIDKeychainWildcardIdentifier
                                     account:account
@@ -21,8 +21,18 @@
 @property(nonatomic, readonly, assign) size_t offset;
 
 - (instancetype)initWithData:(NSData *)data;
+/**
+ * Reads from the given bytes in place, without copying or retaining them. The caller must keep the
+ * bytes alive and unchanged for as long as the stream, or any data read without copying, is used.
+ */
+- (instancetype)initWithBytes:(const void *)bytes length:(size_t)length;
 - (BOOL)readTag:(int8_t *)tag;
 - (BOOL)readLength:(int32_t *)length;
 - (NSData *)readDataWithLength:(uint32_t)length;
+/**
+ * Like readDataWithLength:, but the returned data points into the stream's bytes instead of
+ * holding a copy of them, so it is only valid while those bytes are.
+ */
+- (NSData *)readDataNoCopyWithLength:(uint32_t)length;
 
 @end
@@ -117,6 +117,15 @@ static BOOL ReadRawVarInt32(BufferState *state, int32_t *output) {
   return self;
 }
 
+- (instancetype)initWithBytes:(const void *)bytes length:(size_t)length {
+  self = [super init];
+  if (self) {
+    _state.bytes = bytes;
+    _state.bufferSize = length;
+  }
+  return self;
+}
+
 - (size_t)offset {
   return _state.bufferPos;
 }
@@ -139,4 +148,14 @@ static BOOL ReadRawVarInt32(BufferState *state, int32_t *output) {
   return result;
 }
 
+- (NSData *)readDataNoCopyWithLength:(uint32_t)length {
+  if (!CheckSize(&_state, length)) {
+    return nil;
+  }
+  void *bytesToRead = (void *)(_state.bytes + _state.bufferPos);
+  NSData *result = [NSData dataWithBytesNoCopy:bytesToRead length:length freeWhenDone:NO];
+  _state.bufferPos += length;
+  return result;
+}
+
 @end
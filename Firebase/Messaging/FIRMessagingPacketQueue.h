@@ -39,5 +39,7 @@
 - (void)push:(FIRMessagingPacket *)packet;
 - (void)pushHead:(FIRMessagingPacket *)packet;
 - (FIRMessagingPacket *)pop;
+// Returns the packet at the head of the queue without removing it, or nil if the queue is empty.
+- (FIRMessagingPacket *)peek;
 
 @end
@@ -100,4 +100,8 @@
   return nil;
 }
 
+- (FIRMessagingPacket *)peek {
+  return self.packetsContainer.firstObject;
+}
+
 @end
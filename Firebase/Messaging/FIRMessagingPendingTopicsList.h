@@ -80,6 +80,12 @@ NS_ASSUME_NONNULL_BEGIN
  *  of operations. Without batching, it would be ambiguous whether A's subscription operation or the
  *  unsubscription operation would be completed first.
  *
+ *  Operations that have not started yet are coalesced: a new operation on a topic replaces a
+ *  pending one with the opposite action, since only the last action decides whether the topic ends
+ *  up subscribed, and batches left next to each other with the same action are merged. For example
+ *  subscribing to A, unsubscribing from B and then subscribing to B leaves the single batch [A, B].
+ *  Operations already in flight are never replaced.
+ *
  *  An app can subscribe and unsubscribe from many topics, and this class helps persist the pending
  *  topics and perform the operation safely and correctly.
  *
@@ -99,16 +99,54 @@ NSString *const kPendingTopicsTimestampEncodingKey = @"ts";
 }
 
 + (void)pruneTopicBatches:(NSMutableArray <FIRMessagingTopicBatch *> *)topicBatches {
-  // For now, just remove empty batches. In the future we can use this to make the subscriptions
-  // more efficient, by actually pruning topic actions that cancel each other out, for example.
+  // Only the last action on a topic decides whether it ends up subscribed, so drop the earlier
+  // ones. Neighbouring batches with the same action are then merged into one.
+  NSMutableSet <NSString *> *laterTopics = [NSMutableSet set];
   for (NSInteger i = topicBatches.count-1; i >= 0; i--) {
     FIRMessagingTopicBatch *batch = topicBatches[i];
-    if (batch.topics.count == 0) {
+    [batch.topics minusSet:laterTopics];
+    [laterTopics unionSet:batch.topics];
+  }
+  [self removeEmptyBatches:topicBatches currentBatch:nil];
+  [self mergeNeighbouringBatches:topicBatches currentBatch:nil];
+}
+
++ (void)removeEmptyBatches:(NSMutableArray <FIRMessagingTopicBatch *> *)topicBatches
+              currentBatch:(nullable FIRMessagingTopicBatch *)currentBatch {
+  for (NSInteger i = topicBatches.count-1; i >= 0; i--) {
+    FIRMessagingTopicBatch *batch = topicBatches[i];
+    if (batch.topics.count == 0 && batch != currentBatch) {
       [topicBatches removeObjectAtIndex:i];
     }
   }
 }
 
++ (void)mergeNeighbouringBatches:(NSMutableArray <FIRMessagingTopicBatch *> *)topicBatches
+                    currentBatch:(nullable FIRMessagingTopicBatch *)currentBatch {
+  for (NSInteger i = topicBatches.count-1; i >= 1; i--) {
+    FIRMessagingTopicBatch *earlierBatch = topicBatches[i-1];
+    FIRMessagingTopicBatch *laterBatch = topicBatches[i];
+    if (earlierBatch.action != laterBatch.action) {
+      continue;
+    }
+    // The current batch survives, since its topics may be in flight.
+    FIRMessagingTopicBatch *survivor = (laterBatch == currentBatch) ? laterBatch : earlierBatch;
+    FIRMessagingTopicBatch *merged = (survivor == laterBatch) ? earlierBatch : laterBatch;
+    [survivor.topics unionSet:merged.topics];
+    [merged.topicHandlers enumerateKeysAndObjectsUsingBlock:^(
+        NSString *topic, NSMutableArray <FIRMessagingTopicOperationCompletion> *handlers,
+        BOOL *stop) {
+      NSMutableArray *survivorHandlers = survivor.topicHandlers[topic];
+      if (survivorHandlers) {
+        [survivorHandlers addObjectsFromArray:handlers];
+      } else {
+        survivor.topicHandlers[topic] = handlers;
+      }
+    }];
+    [topicBatches removeObject:merged];
+  }
+}
+
 #pragma mark NSCoding
 
 - (void)encodeWithCoder:(NSCoder *)aCoder {
@@ -144,6 +182,43 @@ NSString *const kPendingTopicsTimestampEncodingKey = @"ts";
 
   FIRMessagingTopicBatch *lastBatch = nil;
   @synchronized (self) {
+    // An operation on a topic that is still waiting to be sent replaces it, rather than queueing a
+    // request that would be undone right away. Its handlers are called when the new one finishes.
+    NSMutableArray <FIRMessagingTopicOperationCompletion> *replacedHandlers = nil;
+    BOOL replacedOperation = NO;
+    for (FIRMessagingTopicBatch *batch in self.topicBatches) {
+      if (![batch.topics member:topic] ||
+          (batch == self.currentBatch && [self.topicsInFlight member:topic])) {
+        continue;
+      }
+      if (batch.action == action) {
+        if (completion) {
+          NSMutableArray *handlers = batch.topicHandlers[topic];
+          if (!handlers) {
+            handlers = [[NSMutableArray alloc] init];
+            batch.topicHandlers[topic] = handlers;
+          }
+          [handlers addObject:completion];
+        }
+        return;
+      }
+      replacedHandlers = batch.topicHandlers[topic];
+      [batch.topics removeObject:topic];
+      [batch.topicHandlers removeObjectForKey:topic];
+      replacedOperation = YES;
+      break;
+    }
+    if (replacedOperation) {
+      [FIRMessagingPendingTopicsList removeEmptyBatches:self.topicBatches
+                                           currentBatch:self.currentBatch];
+      if (self.currentBatch.topics.count == 0) {
+        [self.topicBatches removeObject:self.currentBatch];
+        self.currentBatch = nil;
+      }
+      [FIRMessagingPendingTopicsList mergeNeighbouringBatches:self.topicBatches
+                                                 currentBatch:self.currentBatch];
+    }
+
     lastBatch = self.topicBatches.lastObject;
     if (!lastBatch || lastBatch.action != action) {
       // There either was no last batch, or our last batch's action was not the same, so we have to
@@ -157,19 +232,23 @@ NSString *const kPendingTopicsTimestampEncodingKey = @"ts";
       [self.delegate pendingTopicsListDidUpdate:self];
     }
     // Add the completion handler to the batch
-    if (completion) {
+    if (replacedHandlers.count || completion) {
       NSMutableArray *handlers = lastBatch.topicHandlers[topic];
       if (!handlers) {
         handlers = [[NSMutableArray alloc] init];
       }
-      [handlers addObject:completion];
+      [handlers addObjectsFromArray:replacedHandlers ?: @[]];
+      if (completion) {
+        [handlers addObject:completion];
+      }
       lastBatch.topicHandlers[topic] = handlers;
     }
     if (!self.currentBatch) {
       self.currentBatch = lastBatch;
     }
-    // This may have been the first topic added, or was added to an ongoing batch
-    if (self.currentBatch == lastBatch && !topicExistedBefore) {
+    // This may have been the first topic added, or was added to an ongoing batch, or merging
+    // batches may have brought more topics into the ongoing batch
+    if ((self.currentBatch == lastBatch && !topicExistedBefore) || replacedOperation) {
       // Add this topic to our ongoing operations
       FIRMessaging_WEAKIFY(self);
       dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
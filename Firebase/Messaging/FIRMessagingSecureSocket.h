@@ -29,6 +29,10 @@ typedef NS_ENUM(NSUInteger, FIRMessagingSecureSocketState){
 
 @protocol FIRMessagingSecureSocketDelegate<NSObject>
 
+/**
+ * The data is read in place from the socket's input buffer and is only valid during the call, so
+ * it must be copied to be kept.
+ */
 - (void)secureSocket:(FIRMessagingSecureSocket *)socket
       didReceiveData:(NSData *)data
              withTag:(int8_t)tag;
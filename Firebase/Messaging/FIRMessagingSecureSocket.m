@@ -28,7 +28,9 @@
 static const NSUInteger kMaxBufferLength = 1024 * 1024;  // 1M
 static const NSUInteger kBufferLengthIncrement = 16 * 1024;  // 16k
 static const uint8_t kVersion = 40;
-static const uint8_t kInvalidTag = -1;
+// Packets queued while a write is in progress are serialized together into one output buffer of up
+// to this length, so that a burst of messages goes out in as few socket writes as possible.
+static const NSUInteger kMaxCoalescedWriteLength = 16 * 1024;  // 16k
 
 typedef NS_ENUM(NSUInteger, FIRMessagingSecureSocketReadResult) {
   kFIRMessagingSecureSocketReadResultNone,
@@ -72,8 +74,10 @@ static NSUInteger SerializedSize(int32_t value) {
 @property(nonatomic, readwrite, assign) BOOL isOutStreamOpen;
 
 @property(nonatomic, readwrite, strong) NSRunLoop *runLoop;
-@property(nonatomic, readwrite, strong) NSString *currentRmqIdBeingSent;
-@property(nonatomic, readwrite, assign) int8_t currentProtoTypeBeingSent;
+// The tags, rmq ids (or NSNull) and end offsets in the output buffer of the packets in it.
+@property(nonatomic, readwrite, strong) NSMutableArray<NSNumber *> *protoTypesBeingSent;
+@property(nonatomic, readwrite, strong) NSMutableArray *rmqIdsBeingSent;
+@property(nonatomic, readwrite, strong) NSMutableArray<NSNumber *> *packetEndOffsetsBeingSent;
 
 @end
 
@@ -85,7 +89,9 @@ static NSUInteger SerializedSize(int32_t value) {
     _state = kFIRMessagingSecureSocketNotOpen;
     _inputBuffer = [NSMutableData dataWithLength:kBufferLengthIncrement];
     _packetQueue = [[FIRMessagingPacketQueue alloc] init];
-    _currentProtoTypeBeingSent = kInvalidTag;
+    _protoTypesBeingSent = [NSMutableArray array];
+    _rmqIdsBeingSent = [NSMutableArray array];
+    _packetEndOffsetsBeingSent = [NSMutableArray array];
   }
   return self;
 }
@@ -326,15 +332,16 @@ static NSUInteger SerializedSize(int32_t value) {
       _FIRMessagingDevAssert([self.inputBuffer length] > self.inputBufferLength, @"Invalid buffer size");
     }
 
-    while (self.inputBufferLength > 0 && [self.inputBuffer length] > 0) {
-      _FIRMessagingDevAssert([self.inputBuffer length] >= self.inputBufferLength,
-                             @"Buffer longer than length");
-      NSRange inputRange = NSMakeRange(0, self.inputBufferLength);
+    // Parse every complete proto in place, then move the unprocessed bytes to the front once.
+    const uint8_t *inputBytes = self.inputBuffer.bytes;
+    NSUInteger processedLength = 0;
+    while (processedLength < self.inputBufferLength) {
       size_t protoBytes = 0;
       // read the actual proto data coming in
       FIRMessagingSecureSocketReadResult readResult =
-          [self processCurrentInputBuffer:[self.inputBuffer subdataWithRange:inputRange]
-                                outOffset:&protoBytes];
+          [self processInputBytes:inputBytes + processedLength
+                           length:self.inputBufferLength - processedLength
+                        outOffset:&protoBytes];
       // Corrupt data encountered, stop processing.
       if (readResult == kFIRMessagingSecureSocketReadResultCorrupt) {
         return NO;
@@ -342,55 +349,49 @@ static NSUInteger SerializedSize(int32_t value) {
       } else if (readResult == kFIRMessagingSecureSocketReadResultIncomplete) {
         break;
       }
-      _FIRMessagingDevAssert(self.inputBufferLength >= protoBytes, @"More bytes than buffer can handle");
-      // we have read (0, protoBytes) of data in the inputBuffer
-      if (protoBytes == self.inputBufferLength) {
-        // did completely read the buffer data can be reset for further processing
-        self.inputBufferLength = 0;
-      } else {
-        // delete processed bytes while maintaining the buffer size.
-        NSUInteger prevLength __unused = [self.inputBuffer length];
-        // delete the processed bytes
-        [self.inputBuffer replaceBytesInRange:NSMakeRange(0, protoBytes) withBytes:NULL length:0];
-        // reallocate more data
-        [self.inputBuffer increaseLengthBy:protoBytes];
-        _FIRMessagingDevAssert([self.inputBuffer length] == prevLength,
-                               @"Invalid input buffer size %lu. Used bytes length %lu, "
-                               @"buffer content: %@",
-                               _FIRMessaging_UL([self.inputBuffer length]),
-                               _FIRMessaging_UL(self.inputBufferLength),
-                               self.inputBuffer);
-        self.inputBufferLength -= protoBytes;
+      processedLength += protoBytes;
+      _FIRMessagingDevAssert(self.inputBufferLength >= processedLength,
+                             @"More bytes than buffer can handle");
+    }
+    if (processedLength > 0) {
+      // delete the processed bytes while maintaining the buffer size.
+      self.inputBufferLength -= processedLength;
+      if (self.inputBufferLength > 0) {
+        memmove(self.inputBuffer.mutableBytes, inputBytes + processedLength,
+                self.inputBufferLength);
       }
     }
   }
   return YES;
 }
 
-- (FIRMessagingSecureSocketReadResult)processCurrentInputBuffer:(NSData *)readData
+- (FIRMessagingSecureSocketReadResult)processInputBytes:(const uint8_t *)bytes
+                                                length:(NSUInteger)length
                                              outOffset:(size_t *)outOffset {
   *outOffset = 0;
 
-  FIRMessagingCodedInputStream *input = [[FIRMessagingCodedInputStream alloc] initWithData:readData];
+  FIRMessagingCodedInputStream *input =
+      [[FIRMessagingCodedInputStream alloc] initWithBytes:bytes length:length];
   int8_t rawTag;
   if (![input readTag:&rawTag]) {
     return kFIRMessagingSecureSocketReadResultIncomplete;
   }
-  int32_t length;
-  if (![input readLength:&length]) {
+  int32_t protoLength;
+  if (![input readLength:&protoLength]) {
     return kFIRMessagingSecureSocketReadResultIncomplete;
   }
   // NOTE tag can be zero for |HeartbeatPing|, and length can be zero for |Close| proto
-  _FIRMessagingDevAssert(rawTag >= 0 && length >= 0, @"Invalid tag or length");
-  if (rawTag < 0 || length < 0) {
+  _FIRMessagingDevAssert(rawTag >= 0 && protoLength >= 0, @"Invalid tag or length");
+  if (rawTag < 0 || protoLength < 0) {
     FIRMessagingLoggerDebug(kFIRMessagingMessageCodeSecureSocket015, @"Buffer data corrupted.");
     return kFIRMessagingSecureSocketReadResultCorrupt;
   }
-  NSData *data = [input readDataWithLength:(uint32_t)length];
+  // The data points into the input buffer, which the delegate only reads from during the call.
+  NSData *data = [input readDataNoCopyWithLength:(uint32_t)protoLength];
   if (data == nil) {
     FIRMessagingLoggerDebug(kFIRMessagingMessageCodeSecureSocket016,
                             @"Incomplete data, buffered data length %ld, expected length %d",
-                            _FIRMessaging_UL(self.inputBufferLength), length);
+                            _FIRMessaging_UL(length), protoLength);
     return kFIRMessagingSecureSocketReadResultIncomplete;
   }
   [self.delegate secureSocket:self didReceiveData:data withTag:rawTag];
@@ -407,19 +408,11 @@ static NSUInteger SerializedSize(int32_t value) {
     [self.outStream write:&versionByte maxLength:sizeof(uint8_t)];
   }
 
-  while (!self.packetQueue.isEmpty && self.outStream.hasSpaceAvailable) {
+  while ((!self.packetQueue.isEmpty || self.outputBuffer.length > 0) &&
+         self.outStream.hasSpaceAvailable) {
     if (self.outputBuffer.length == 0) {
       // serialize new packets only when the output buffer is flushed.
-      FIRMessagingPacket *packet = [self.packetQueue pop];
-      self.currentRmqIdBeingSent = packet.rmqId;
-      self.currentProtoTypeBeingSent = packet.tag;
-      NSUInteger length = SerializedSize(packet.tag) +
-          SerializedSize((int)packet.data.length) + packet.data.length;
-      self.outputBuffer = [NSMutableData dataWithLength:length];
-      GPBCodedOutputStream *output = [GPBCodedOutputStream streamWithData:self.outputBuffer];
-      [output writeRawVarint32:packet.tag];
-      [output writeBytesNoTag:packet.data];
-      self.outputBufferLength = 0;
+      [self serializeQueuedPacketsIntoOutputBuffer];
     }
 
     // flush the output buffer.
@@ -429,16 +422,58 @@ static NSUInteger SerializedSize(int32_t value) {
       continue;
     }
     self.outputBufferLength += (NSUInteger)written;
+    [self notifyPacketsSent];
     if (self.outputBufferLength >= self.outputBuffer.length) {
       self.outputBufferLength = 0;
       self.outputBuffer = nil;
-      [self.delegate secureSocket:self
-              didSendProtoWithTag:self.currentProtoTypeBeingSent
-                            rmqId:self.currentRmqIdBeingSent];
-      self.currentRmqIdBeingSent = nil;
-      self.currentProtoTypeBeingSent = kInvalidTag;
     }
   }
 }
 
+/**
+ * Pops packets from the queue into the output buffer, until the queue is empty or adding the next
+ * packet would take the buffer over kMaxCoalescedWriteLength. The first packet is always added.
+ */
+- (void)serializeQueuedPacketsIntoOutputBuffer {
+  self.outputBuffer = [NSMutableData data];
+  self.outputBufferLength = 0;
+  while (!self.packetQueue.isEmpty) {
+    FIRMessagingPacket *packet = [self.packetQueue pop];
+    NSUInteger length = SerializedSize(packet.tag) +
+        SerializedSize((int)packet.data.length) + packet.data.length;
+    NSMutableData *packetData = [NSMutableData dataWithLength:length];
+    GPBCodedOutputStream *output = [GPBCodedOutputStream streamWithData:packetData];
+    [output writeRawVarint32:packet.tag];
+    [output writeBytesNoTag:packet.data];
+    [self.outputBuffer appendData:packetData];
+
+    [self.protoTypesBeingSent addObject:@(packet.tag)];
+    [self.rmqIdsBeingSent addObject:packet.rmqId ?: [NSNull null]];
+    [self.packetEndOffsetsBeingSent addObject:@(self.outputBuffer.length)];
+
+    FIRMessagingPacket *nextPacket = [self.packetQueue peek];
+    if (nextPacket && self.outputBuffer.length + nextPacket.data.length > kMaxCoalescedWriteLength) {
+      break;
+    }
+  }
+}
+
+/**
+ * Tells the delegate about every packet in the output buffer that has been completely written.
+ */
+- (void)notifyPacketsSent {
+  while (self.packetEndOffsetsBeingSent.count > 0 &&
+         self.packetEndOffsetsBeingSent.firstObject.unsignedIntegerValue <=
+             self.outputBufferLength) {
+    int8_t tag = (int8_t)self.protoTypesBeingSent.firstObject.intValue;
+    id rmqId = self.rmqIdsBeingSent.firstObject;
+    [self.protoTypesBeingSent removeObjectAtIndex:0];
+    [self.rmqIdsBeingSent removeObjectAtIndex:0];
+    [self.packetEndOffsetsBeingSent removeObjectAtIndex:0];
+    [self.delegate secureSocket:self
+            didSendProtoWithTag:tag
+                          rmqId:(rmqId == [NSNull null] ? nil : rmqId)];
+  }
+}
+
 @end
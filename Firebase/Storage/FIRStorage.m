@@ -16,6 +16,7 @@
 
 #import "FIRStorageComponent.h"
 #import "FIRStorageConstants_Private.h"
+#import "FIRStorageMetadataCache.h"
 #import "FIRStoragePath.h"
 #import "FIRStorageReference_Private.h"
 #import "FIRStorageTokenAuthorizer.h"
@@ -30,12 +31,16 @@
 
 #import <GTMSessionFetcher/GTMSessionFetcher.h>
 #import <GTMSessionFetcher/GTMSessionFetcherLogging.h>
+#import <GTMSessionFetcher/GTMSessionUploadFetcher.h>
 
 static NSMutableDictionary<
     NSString * /* app name */,
     NSMutableDictionary<NSString * /* bucket */, GTMSessionFetcherService *> *> *_fetcherServiceMap;
 static GTMSessionFetcherRetryBlock _retryWhenOffline;
 
+/// The number of objects whose metadata each Storage instance remembers.
+static const NSUInteger kFIRStorageMetadataCacheCapacity = 500;
+
 @interface FIRStorage () {
   /// Stored Auth reference, if it exists. This needs to be stored for `copyWithZone:`.
   id<FIRAuthInterop> _Nullable _auth;
@@ -154,6 +159,12 @@ static GTMSessionFetcherRetryBlock _retryWhenOffline;
     _maxDownloadRetryTime = 600.0;
     _maxOperationRetryTime = 120.0;
     _maxUploadRetryTime = 600.0;
+    _uploadChunkSizeBytes = kGTMSessionUploadFetcherStandardChunkSize;
+    NSURL *cacheFileURL = [FIRStorageMetadataCache defaultFileURLForAppName:app.name
+                                                                     bucket:bucket];
+    _metadataCache =
+        [[FIRStorageMetadataCache alloc] initWithFileURL:cacheFileURL
+                                                capacity:kFIRStorageMetadataCacheCapacity];
   }
   return self;
 }
@@ -14,7 +14,9 @@
 
 #import "FIRStorageDeleteTask.h"
 
+#import "FIRStorageMetadataCache.h"
 #import "FIRStorageTask_Private.h"
+#import "FIRStorage_Private.h"
 
 @implementation FIRStorageDeleteTask {
  @private
@@ -64,6 +66,9 @@
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Warc-retain-cycles"
     strongSelf->_fetcherCompletion = ^(NSData *_Nullable data, NSError *_Nullable error) {
+      if (!error) {
+        [self.reference.storage.metadataCache removeMetadataForPath:self.reference.path];
+      }
       if (!self.error) {
         self.error = [FIRStorageErrors errorWithServerError:error reference:self.reference];
       }
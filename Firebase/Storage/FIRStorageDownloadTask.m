@@ -19,7 +19,10 @@
 #import "FIRStorageObservableTask_Private.h"
 #import "FIRStorageTask_Private.h"
 
-@implementation FIRStorageDownloadTask
+@implementation FIRStorageDownloadTask {
+  /** The number of bytes passed to the chunk handler since the download last started over. */
+  int64_t _streamedBytes;
+}
 
 @synthesize progress = _progress;
 @synthesize fetcher = _fetcher;
@@ -65,7 +68,11 @@
     request.URL = components.URL;
 
     GTMSessionFetcher *fetcher;
-    if (resumeData) {
+    if (strongSelf.chunkHandler) {
+      // Streamed downloads have no resume data, since their bytes are never kept.
+      fetcher = [strongSelf.fetcherService fetcherWithRequest:request];
+      fetcher.comment = @"Starting streaming DownloadTask";
+    } else if (resumeData) {
       fetcher = [GTMSessionFetcher fetcherWithDownloadResumeData:resumeData];
       fetcher.comment = @"Resuming DownloadTask";
     } else {
@@ -95,6 +102,28 @@
         weakSelf.state = FIRStorageTaskStateRunning;
       }];
     } else {
+      void (^chunkHandler)(NSData *_Nullable chunk) = strongSelf.chunkHandler;
+      if (chunkHandler) {
+        // Handle streamed downloads
+        __block BOOL fetchHasStreamed = NO;
+        fetcher.accumulateDataBlock = ^(NSData *_Nullable buffer) {
+          FIRStorageDownloadTask *strong = weakSelf;
+          if (!strong) {
+            return;
+          }
+          // Bytes from an earlier fetch, or from before this one restarted, are sent again.
+          if ((!buffer || !fetchHasStreamed) && strong->_streamedBytes > 0) {
+            strong->_streamedBytes = 0;
+            chunkHandler(nil);
+          }
+          if (buffer.length) {
+            fetchHasStreamed = YES;
+            strong->_streamedBytes += buffer.length;
+            chunkHandler(buffer);
+          }
+        };
+      }
+
       // Handle data downloads
       [fetcher setReceivedProgressBlock:^(int64_t bytesWritten, int64_t totalBytesWritten) {
         weakSelf.state = FIRStorageTaskStateProgress;
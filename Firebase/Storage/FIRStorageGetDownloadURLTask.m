@@ -14,7 +14,9 @@
 
 #import "FIRStorageGetDownloadURLTask.h"
 
+#import "FIRStorageMetadataCache.h"
 #import "FIRStorageTask_Private.h"
+#import "FIRStorage_Private.h"
 
 @implementation FIRStorageGetDownloadURLTask {
  @private
@@ -84,6 +86,24 @@
     FIRStorageVoidURLError callback = strongSelf->_completion;
     strongSelf->_completion = nil;
 
+    FIRStorageMetadataCache *metadataCache = strongSelf.reference.storage.metadataCache;
+    NSDictionary *cachedDictionary =
+        [metadataCache metadataDictionaryForPath:strongSelf.reference.path];
+    NSURL *cachedURL =
+        cachedDictionary
+            ? [FIRStorageGetDownloadURLTask downloadURLFromMetadataDictionary:cachedDictionary]
+            : nil;
+    if (cachedURL) {
+      // Download tokens stay valid until they are revoked, so a recently seen one can be reused.
+      if (callback) {
+        dispatch_queue_t callbackQueue = strongSelf.fetcherService.callbackQueue;
+        dispatch_async(callbackQueue ? callbackQueue : dispatch_get_main_queue(), ^{
+          callback(cachedURL, nil);
+        });
+      }
+      return;
+    }
+
     GTMSessionFetcher *fetcher = [strongSelf.fetcherService fetcherWithRequest:request];
     strongSelf->_fetcher = fetcher;
     fetcher.comment = @"GetDownloadURLTask";
@@ -96,9 +116,13 @@
         if (!self.error) {
           self.error = [FIRStorageErrors errorWithServerError:error reference:self.reference];
         }
+        if (self.error.code == FIRStorageErrorCodeObjectNotFound) {
+          [metadataCache removeMetadataForPath:self.reference.path];
+        }
       } else {
         NSDictionary *responseDictionary = [NSDictionary frs_dictionaryFromJSONData:data];
         if (responseDictionary != nil) {
+          [metadataCache setMetadataDictionary:responseDictionary forPath:self.reference.path];
           downloadURL =
               [FIRStorageGetDownloadURLTask downloadURLFromMetadataDictionary:responseDictionary];
           if (!downloadURL) {
@@ -15,9 +15,11 @@
 #import "FIRStorageGetMetadataTask.h"
 
 #import "FIRStorageConstants.h"
+#import "FIRStorageMetadataCache.h"
 #import "FIRStorageMetadata_Private.h"
 #import "FIRStorageTask_Private.h"
 #import "FIRStorageUtils.h"
+#import "FIRStorage_Private.h"
 
 #import "FirebaseStorage.h"
 
@@ -69,13 +71,18 @@
 #pragma clang diagnostic ignored "-Warc-retain-cycles"
     strongSelf->_fetcherCompletion = ^(NSData *data, NSError *error) {
       FIRStorageMetadata *metadata;
+      FIRStorageMetadataCache *metadataCache = self.reference.storage.metadataCache;
       if (error) {
         if (!self.error) {
           self.error = [FIRStorageErrors errorWithServerError:error reference:self.reference];
         }
+        if (self.error.code == FIRStorageErrorCodeObjectNotFound) {
+          [metadataCache removeMetadataForPath:self.reference.path];
+        }
       } else {
         NSDictionary *responseDictionary = [NSDictionary frs_dictionaryFromJSONData:data];
         if (responseDictionary != nil) {
+          [metadataCache setMetadataDictionary:responseDictionary forPath:self.reference.path];
           metadata = [[FIRStorageMetadata alloc] initWithDictionary:responseDictionary];
           [metadata setType:FIRStorageMetadataTypeFile];
         } else {
@@ -0,0 +1,209 @@
+// Copyright 2019 Google
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "FIRStorageMetadataCache.h"
+
+#import "FIRStorageConstants_Private.h"
+#import "FIRStoragePath.h"
+#import "FIRStorageUtils.h"
+
+/** The key of the array of cached entries in the cache file, least recently used first. */
+static NSString *const kFIRStorageMetadataCacheEntriesKey = @"entries";
+
+/** The key of an entry's "bucket/object" string. */
+static NSString *const kFIRStorageMetadataCachePathKey = @"path";
+
+/** The key of an entry's server metadata dictionary. */
+static NSString *const kFIRStorageMetadataCacheMetadataKey = @"metadata";
+
+/** How long changes wait to be written, so that a burst of them is written once. */
+static const int64_t kFIRStorageMetadataCacheSaveDelay = 1 * NSEC_PER_SEC;
+
+@implementation FIRStorageMetadataCache {
+  NSURL *_fileURL;
+
+  /** Server metadata dictionaries keyed by "bucket/object". */
+  NSMutableDictionary<NSString *, NSDictionary *> *_entries;
+
+  /** The keys of _entries, least recently used first. */
+  NSMutableOrderedSet<NSString *> *_recency;
+
+  /** Whether the entries have been read from _fileURL yet. */
+  BOOL _loaded;
+
+  /** Whether a write of the entries to _fileURL is pending. */
+  BOOL _saveScheduled;
+
+  /** The queue on which the cache file is written. */
+  dispatch_queue_t _fileQueue;
+}
+
+- (instancetype)initWithFileURL:(nullable NSURL *)fileURL capacity:(NSUInteger)capacity {
+  self = [super init];
+  if (self) {
+    _fileURL = [fileURL copy];
+    _capacity = capacity;
+    _entries = [[NSMutableDictionary alloc] init];
+    _recency = [[NSMutableOrderedSet alloc] init];
+    _loaded = _fileURL == nil;
+    _fileQueue = dispatch_queue_create("com.google.firebase.storage.metadatacache",
+                                       DISPATCH_QUEUE_SERIAL);
+  }
+  return self;
+}
+
++ (NSURL *)defaultFileURLForAppName:(NSString *)appName bucket:(NSString *)bucket {
+  NSURL *cachesURL = [[[NSFileManager defaultManager] URLsForDirectory:NSCachesDirectory
+                                                             inDomains:NSUserDomainMask]
+      firstObject];
+  NSString *fileName = [NSString stringWithFormat:@"metadata-%@-%@.json", appName, bucket];
+  fileName = [fileName stringByReplacingOccurrencesOfString:@"/" withString:@"_"];
+  return [[cachesURL URLByAppendingPathComponent:@"com.google.firebase.storage"]
+      URLByAppendingPathComponent:fileName];
+}
+
++ (NSString *)keyForPath:(FIRStoragePath *)path {
+  return [NSString stringWithFormat:@"%@/%@", path.bucket, path.object ?: @""];
+}
+
+- (nullable NSDictionary *)metadataDictionaryForPath:(FIRStoragePath *)path {
+  NSString *key = [FIRStorageMetadataCache keyForPath:path];
+  @synchronized(self) {
+    [self loadIfNeeded];
+    NSDictionary *dictionary = _entries[key];
+    if (dictionary) {
+      [self markUsed:key];
+    }
+    return dictionary;
+  }
+}
+
+- (void)setMetadataDictionary:(NSDictionary *)dictionary forPath:(FIRStoragePath *)path {
+  NSString *key = [FIRStorageMetadataCache keyForPath:path];
+  @synchronized(self) {
+    [self loadIfNeeded];
+    NSDictionary *cachedDictionary = _entries[key];
+    if (cachedDictionary && [FIRStorageMetadataCache dictionary:cachedDictionary
+                                                  isNewerThan:dictionary]) {
+      return;
+    }
+    _entries[key] = [dictionary copy];
+    [self markUsed:key];
+    while (_recency.count > _capacity) {
+      [_entries removeObjectForKey:_recency.firstObject];
+      [_recency removeObjectAtIndex:0];
+    }
+    [self scheduleSave];
+  }
+}
+
+- (void)removeMetadataForPath:(FIRStoragePath *)path {
+  NSString *key = [FIRStorageMetadataCache keyForPath:path];
+  @synchronized(self) {
+    [self loadIfNeeded];
+    if (!_entries[key]) {
+      return;
+    }
+    [_entries removeObjectForKey:key];
+    [_recency removeObject:key];
+    [self scheduleSave];
+  }
+}
+
+#pragma mark - Private methods
+
+/** Returns whether @a dictionary describes a later version of an object than @a other does. */
++ (BOOL)dictionary:(NSDictionary *)dictionary isNewerThan:(NSDictionary *)other {
+  long long generation = [dictionary[kFIRStorageMetadataGeneration] longLongValue];
+  long long otherGeneration = [other[kFIRStorageMetadataGeneration] longLongValue];
+  if (generation != otherGeneration) {
+    return generation > otherGeneration;
+  }
+  long long metageneration = [dictionary[kFIRStorageMetadataMetageneration] longLongValue];
+  long long otherMetageneration = [other[kFIRStorageMetadataMetageneration] longLongValue];
+  return metageneration > otherMetageneration;
+}
+
+/** Moves @a key to the most recently used end. Must be called while synchronized on self. */
+- (void)markUsed:(NSString *)key {
+  [_recency removeObject:key];
+  [_recency addObject:key];
+}
+
+/** Reads the entries persisted by an earlier launch. Must be called while synchronized on self. */
+- (void)loadIfNeeded {
+  if (_loaded) {
+    return;
+  }
+  _loaded = YES;
+  NSData *data = [NSData dataWithContentsOfURL:_fileURL];
+  NSDictionary *contents = [NSDictionary frs_dictionaryFromJSONData:data];
+  NSArray *entries = contents[kFIRStorageMetadataCacheEntriesKey];
+  if (![entries isKindOfClass:[NSArray class]]) {
+    return;
+  }
+  for (NSDictionary *entry in entries) {
+    if (![entry isKindOfClass:[NSDictionary class]]) {
+      continue;
+    }
+    NSString *key = entry[kFIRStorageMetadataCachePathKey];
+    NSDictionary *metadata = entry[kFIRStorageMetadataCacheMetadataKey];
+    if ([key isKindOfClass:[NSString class]] && [metadata isKindOfClass:[NSDictionary class]]) {
+      _entries[key] = metadata;
+      [self markUsed:key];
+    }
+  }
+  while (_recency.count > _capacity) {
+    [_entries removeObjectForKey:_recency.firstObject];
+    [_recency removeObjectAtIndex:0];
+  }
+}
+
+/** Writes the entries to _fileURL shortly. Must be called while synchronized on self. */
+- (void)scheduleSave {
+  if (!_fileURL || _saveScheduled) {
+    return;
+  }
+  _saveScheduled = YES;
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, kFIRStorageMetadataCacheSaveDelay), _fileQueue,
+                 ^{
+                   [self save];
+                 });
+}
+
+- (void)save {
+  NSMutableArray<NSDictionary *> *entries;
+  @synchronized(self) {
+    _saveScheduled = NO;
+    entries = [[NSMutableArray alloc] initWithCapacity:_recency.count];
+    for (NSString *key in _recency) {
+      [entries addObject:@{
+        kFIRStorageMetadataCachePathKey : key,
+        kFIRStorageMetadataCacheMetadataKey : _entries[key]
+      }];
+    }
+  }
+  NSData *data =
+      [NSData frs_dataFromJSONDictionary:@{kFIRStorageMetadataCacheEntriesKey : entries}];
+  if (!data) {
+    return;
+  }
+  [[NSFileManager defaultManager] createDirectoryAtURL:[_fileURL URLByDeletingLastPathComponent]
+                           withIntermediateDirectories:YES
+                                            attributes:nil
+                                                 error:NULL];
+  [data writeToURL:_fileURL atomically:YES];
+}
+
+@end
@@ -288,6 +288,38 @@
   return task;
 }
 
+- (FIRStorageDownloadTask *)streamWithChunkHandler:(void (^)(NSData *_Nullable chunk))chunkHandler
+                                        completion:(nullable void (^)(NSError *_Nullable error))
+                                                       completion {
+  FIRStorageDownloadTask *task =
+      [[FIRStorageDownloadTask alloc] initWithReference:self
+                                         fetcherService:_storage.fetcherServiceForApp
+                                          dispatchQueue:_storage.dispatchQueue
+                                                   file:nil];
+  task.chunkHandler = chunkHandler;
+  if (completion) {
+    dispatch_queue_t callbackQueue = _storage.fetcherServiceForApp.callbackQueue;
+    if (!callbackQueue) {
+      callbackQueue = dispatch_get_main_queue();
+    }
+
+    [task observeStatus:FIRStorageTaskStatusSuccess
+                handler:^(FIRStorageTaskSnapshot *_Nonnull snapshot) {
+                  dispatch_async(callbackQueue, ^{
+                    completion(nil);
+                  });
+                }];
+    [task observeStatus:FIRStorageTaskStatusFailure
+                handler:^(FIRStorageTaskSnapshot *_Nonnull snapshot) {
+                  dispatch_async(callbackQueue, ^{
+                    completion(snapshot.error);
+                  });
+                }];
+  }
+  [task enqueue];
+  return task;
+}
+
 - (FIRStorageDownloadTask *)writeToFile:(NSURL *)fileURL {
   return [self writeToFile:fileURL completion:nil];
 }
@@ -14,8 +14,10 @@
 
 #import "FIRStorageUpdateMetadataTask.h"
 
+#import "FIRStorageMetadataCache.h"
 #import "FIRStorageMetadata_Private.h"
 #import "FIRStorageTask_Private.h"
+#import "FIRStorage_Private.h"
 
 @implementation FIRStorageUpdateMetadataTask {
  @private
@@ -82,6 +84,8 @@
       } else {
         NSDictionary *responseDictionary = [NSDictionary frs_dictionaryFromJSONData:data];
         if (responseDictionary) {
+          [self.reference.storage.metadataCache setMetadataDictionary:responseDictionary
+                                                              forPath:self.reference.path];
           metadata = [[FIRStorageMetadata alloc] initWithDictionary:responseDictionary];
           [metadata setType:FIRStorageMetadataTypeFile];
         } else {
@@ -15,13 +15,27 @@
 #import "FIRStorageUploadTask.h"
 
 #import "FIRStorageConstants_Private.h"
+#import "FIRStorageMetadataCache.h"
 #import "FIRStorageMetadata_Private.h"
 #import "FIRStorageObservableTask_Private.h"
 #import "FIRStorageTask_Private.h"
 #import "FIRStorageUploadTask_Private.h"
+#import "FIRStorage_Private.h"
 
 #import <GTMSessionFetcher/GTMSessionUploadFetcher.h>
 
+/** The user defaults key of the resumable upload sessions of file uploads that haven't finished. */
+static NSString *const kFIRStorageUploadSessionsKey = @"com.google.firebase.storage.uploadSessions";
+
+/** The key of a persisted session's upload location URL. */
+static NSString *const kFIRStorageUploadSessionLocationKey = @"location";
+
+/** The key of the date a persisted session was started. */
+static NSString *const kFIRStorageUploadSessionDateKey = @"date";
+
+/** How long a persisted session is trusted for. The server expires them after a week. */
+static const NSTimeInterval kFIRStorageUploadSessionLifetime = 6 * 24 * 60 * 60;
+
 @implementation FIRStorageUploadTask
 
 @synthesize progress = _progress;
@@ -110,11 +124,26 @@
     [components setPercentEncodedQuery:[FIRStorageUtils queryStringForDictionary:queryParams]];
     request.URL = components.URL;
 
-    GTMSessionUploadFetcher *uploadFetcher =
-        [GTMSessionUploadFetcher uploadFetcherWithRequest:request
-                                           uploadMIMEType:strongSelf->_uploadMetadata.contentType
-                                                chunkSize:kGTMSessionUploadFetcherStandardChunkSize
-                                           fetcherService:self.fetcherService];
+    // A file whose upload was interrupted by the app exiting continues from the bytes the server
+    // already has.
+    strongSelf.uploadSessionKey = [strongSelf fileUploadSessionKey];
+    NSURL *uploadLocationURL =
+        [FIRStorageUploadTask uploadLocationForSessionKey:strongSelf.uploadSessionKey];
+    int64_t chunkSize = strongSelf.reference.storage.uploadChunkSizeBytes;
+    GTMSessionUploadFetcher *uploadFetcher;
+    if (uploadLocationURL) {
+      uploadFetcher =
+          [GTMSessionUploadFetcher uploadFetcherWithLocation:uploadLocationURL
+                                              uploadMIMEType:strongSelf->_uploadMetadata.contentType
+                                                   chunkSize:chunkSize
+                                              fetcherService:self.fetcherService];
+    } else {
+      uploadFetcher =
+          [GTMSessionUploadFetcher uploadFetcherWithRequest:request
+                                             uploadMIMEType:strongSelf->_uploadMetadata.contentType
+                                                  chunkSize:chunkSize
+                                             fetcherService:self.fetcherService];
+    }
 
     if (strongSelf->_uploadData) {
       [uploadFetcher setUploadData:strongSelf->_uploadData];
@@ -126,8 +155,15 @@
 
     uploadFetcher.maxRetryInterval = self.reference.storage.maxUploadRetryTime;
 
+    __block BOOL uploadSessionPersisted = uploadLocationURL != nil;
+    __weak GTMSessionUploadFetcher *weakUploadFetcher = uploadFetcher;
     [uploadFetcher setSendProgressBlock:^(int64_t bytesSent, int64_t totalBytesSent,
                                           int64_t totalBytesExpectedToSend) {
+      if (!uploadSessionPersisted && weakUploadFetcher.uploadLocationURL) {
+        uploadSessionPersisted = YES;
+        [FIRStorageUploadTask setUploadLocation:weakUploadFetcher.uploadLocationURL
+                                  forSessionKey:weakSelf.uploadSessionKey];
+      }
       weakSelf.state = FIRStorageTaskStateProgress;
       weakSelf.progress.completedUnitCount = totalBytesSent;
       weakSelf.progress.totalUnitCount = totalBytesExpectedToSend;
@@ -144,6 +180,8 @@
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Warc-retain-cycles"
     strongSelf->_fetcherCompletion = ^(NSData *_Nullable data, NSError *_Nullable error) {
+      [FIRStorageUploadTask setUploadLocation:nil forSessionKey:self.uploadSessionKey];
+
       // Fire last progress updates
       [self fireHandlersForStatus:FIRStorageTaskStatusProgress snapshot:self.snapshot];
 
@@ -162,6 +200,8 @@
 
       NSDictionary *responseDictionary = [NSDictionary frs_dictionaryFromJSONData:data];
       if (responseDictionary) {
+        [self.reference.storage.metadataCache setMetadataDictionary:responseDictionary
+                                                            forPath:self.reference.path];
         FIRStorageMetadata *metadata =
             [[FIRStorageMetadata alloc] initWithDictionary:responseDictionary];
         [metadata setType:FIRStorageMetadataTypeFile];
@@ -212,6 +252,82 @@
   return YES;
 }
 
+#pragma mark - Upload Sessions
+
+/**
+ * Returns a key that identifies this upload's destination and the version of the file it reads,
+ * or nil for uploads of data, which can't be matched up with an earlier launch's upload.
+ */
+- (nullable NSString *)fileUploadSessionKey {
+  if (!_fileURL) {
+    return nil;
+  }
+  NSDictionary<NSURLResourceKey, id> *fileAttributes =
+      [_fileURL resourceValuesForKeys:@[ NSURLFileSizeKey, NSURLContentModificationDateKey ]
+                                error:NULL];
+  NSNumber *fileSize = fileAttributes[NSURLFileSizeKey];
+  NSDate *modificationDate = fileAttributes[NSURLContentModificationDateKey];
+  if (!fileSize || !modificationDate) {
+    return nil;
+  }
+  return [NSString stringWithFormat:@"%@/%@|%@|%@|%f", self.reference.bucket,
+                                    self.reference.fullPath, _fileURL.path, fileSize,
+                                    modificationDate.timeIntervalSince1970];
+}
+
+/** Returns the upload location of an unexpired session persisted with the given key, if any. */
++ (nullable NSURL *)uploadLocationForSessionKey:(nullable NSString *)sessionKey {
+  if (!sessionKey) {
+    return nil;
+  }
+  NSDictionary *sessions =
+      [[NSUserDefaults standardUserDefaults] dictionaryForKey:kFIRStorageUploadSessionsKey];
+  NSDictionary *session = sessions[sessionKey];
+  NSDate *startDate = session[kFIRStorageUploadSessionDateKey];
+  NSString *location = session[kFIRStorageUploadSessionLocationKey];
+  if (![startDate isKindOfClass:[NSDate class]] || ![location isKindOfClass:[NSString class]] ||
+      -[startDate timeIntervalSinceNow] > kFIRStorageUploadSessionLifetime) {
+    return nil;
+  }
+  return [NSURL URLWithString:location];
+}
+
+/** Persists the upload location of the session with the given key, or forgets it if nil. */
++ (void)setUploadLocation:(nullable NSURL *)uploadLocationURL
+            forSessionKey:(nullable NSString *)sessionKey {
+  if (!sessionKey) {
+    return;
+  }
+  @synchronized(self) {
+    NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+    NSMutableDictionary *sessions =
+        [[defaults dictionaryForKey:kFIRStorageUploadSessionsKey] mutableCopy];
+    if (!sessions) {
+      if (!uploadLocationURL) {
+        return;
+      }
+      sessions = [NSMutableDictionary dictionary];
+    }
+    // Sessions from uploads that were never finished or retried have expired on the server.
+    for (NSString *key in [sessions allKeys]) {
+      NSDate *startDate = sessions[key][kFIRStorageUploadSessionDateKey];
+      if (![startDate isKindOfClass:[NSDate class]] ||
+          -[startDate timeIntervalSinceNow] > kFIRStorageUploadSessionLifetime) {
+        [sessions removeObjectForKey:key];
+      }
+    }
+    if (uploadLocationURL) {
+      sessions[sessionKey] = @{
+        kFIRStorageUploadSessionLocationKey : uploadLocationURL.absoluteString,
+        kFIRStorageUploadSessionDateKey : [NSDate date]
+      };
+    } else {
+      [sessions removeObjectForKey:sessionKey];
+    }
+    [defaults setObject:sessions forKey:kFIRStorageUploadSessionsKey];
+  }
+}
+
 #pragma mark - Upload Management
 
 - (void)cancel {
@@ -220,6 +336,8 @@
   [self dispatchAsync:^() {
     weakSelf.state = FIRStorageTaskStateCancelled;
     [weakSelf.uploadFetcher stopFetching];
+    [FIRStorageUploadTask setUploadLocation:nil
+                              forSessionKey:weakSelf.uploadSessionKey];
     if (weakSelf.state != FIRStorageTaskStateSuccess) {
       weakSelf.metadata = weakSelf.uploadMetadata;
     }
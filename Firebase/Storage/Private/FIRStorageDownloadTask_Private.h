@@ -35,6 +35,12 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property(copy, nonatomic) NSURL *fileURL;
 
+/**
+ * Receives the downloaded bytes as they arrive instead of them being kept in downloadData, or nil
+ * when the download restarts from the beginning. Only used for downloads that aren't to a file.
+ */
+@property(copy, nonatomic, nullable) void (^chunkHandler)(NSData *_Nullable chunk);
+
 /**
  * Initializes a download task with a base FIRStorageReference and GTMSessionFetcherService.
  * @param reference The base FIRStorageReference which fetchers use for configuration.
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class FIRStoragePath;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Remembers the metadata the server last returned for each object, so that download URLs for
+ * objects that were seen recently don't need a network round trip. Entries are kept in memory up
+ * to a limit, least recently used first out, and are mirrored to a file in the caches directory so
+ * that they survive app launches. This class is thread safe.
+ */
+@interface FIRStorageMetadataCache : NSObject
+
+/**
+ * The maximum number of objects remembered.
+ */
+@property(nonatomic, readonly) NSUInteger capacity;
+
+/**
+ * Initializes a cache backed by the given file.
+ * @param fileURL The file to load entries from and persist them to, or nil to keep them in memory.
+ * @param capacity The maximum number of objects to remember.
+ * @return Returns an instance of FIRStorageMetadataCache.
+ */
+- (instancetype)initWithFileURL:(nullable NSURL *)fileURL
+                       capacity:(NSUInteger)capacity NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Returns the location of the cache file for a Storage instance.
+ * @param appName The name of the FIRApp the Storage instance belongs to.
+ * @param bucket The bucket the Storage instance is for.
+ * @return A URL in the app's caches directory.
+ */
++ (NSURL *)defaultFileURLForAppName:(NSString *)appName bucket:(NSString *)bucket;
+
+/**
+ * Returns the metadata dictionary last returned from the server for an object.
+ * @param path The path of the object.
+ * @return The server's JSON dictionary, or nil if there is none.
+ */
+- (nullable NSDictionary *)metadataDictionaryForPath:(FIRStoragePath *)path;
+
+/**
+ * Remembers the metadata dictionary the server returned for an object. A dictionary with an older
+ * generation or metageneration than the one already remembered is ignored.
+ * @param dictionary The server's JSON dictionary for the object.
+ * @param path The path of the object.
+ */
+- (void)setMetadataDictionary:(NSDictionary *)dictionary forPath:(FIRStoragePath *)path;
+
+/**
+ * Forgets the metadata of an object, for example after it is deleted.
+ * @param path The path of the object.
+ */
+- (void)removeMetadataForPath:(FIRStoragePath *)path;
+
+@end
+
+NS_ASSUME_NONNULL_END
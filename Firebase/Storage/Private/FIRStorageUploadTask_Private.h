@@ -40,6 +40,12 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property(strong, atomic) GTMSessionUploadFetcher *uploadFetcher;
 
+/**
+ * Identifies the file being uploaded across app launches, so that its resumable upload session can
+ * be continued after the app exits. Nil for uploads of data.
+ */
+@property(copy, atomic, nullable) NSString *uploadSessionKey;
+
 /**
  * Initializes an upload task with a base FIRStorageReference and GTMSessionFetcherService.
  * @param reference The base FIRStorageReference which fetchers use for configuration.
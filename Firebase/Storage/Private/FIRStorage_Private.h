@@ -15,6 +15,7 @@
  */
 
 @class FIRApp;
+@class FIRStorageMetadataCache;
 @class GTMSessionFetcherService;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -29,6 +30,12 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property(strong, nonatomic) NSString *storageBucket;
 
+/**
+ * The server metadata of recently seen objects, used to answer download URL requests without a
+ * network round trip.
+ */
+@property(strong, nonatomic, readonly) FIRStorageMetadataCache *metadataCache;
+
 /**
  * Enables/disables GTMSessionFetcher HTTP logging
  * @param isLoggingEnabled Boolean passed through to enable/disable GTMSessionFetcher logging
@@ -80,6 +80,13 @@ NS_SWIFT_NAME(Storage)
  */
 @property NSTimeInterval maxUploadRetryTime;
 
+/**
+ * The largest number of bytes an upload sends in a single request. Uploads larger than this are
+ * sent as a series of chunks, each of which can be retried on its own. Defaults to sending the
+ * whole upload in one request, which makes the fewest round trips.
+ */
+@property int64_t uploadChunkSizeBytes;
+
 /**
  * Maximum time in seconds to retry a download if a failure occurs.
  * Defaults to 10 minutes (600 seconds).
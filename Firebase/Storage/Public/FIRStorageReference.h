@@ -190,6 +190,25 @@ NS_SWIFT_NAME(putData(_:metadata:));
                      NS_SWIFT_NAME(getData(maxSize:completion:));
 // clang-format on
 
+/**
+ * Asynchronously downloads the object at the FIRStorageReference, passing its bytes to a handler as
+ * they arrive instead of holding the whole object in memory. Chunks are delivered in order, on the
+ * same queue as the completion block. If the download has to start over, for example after it is
+ * paused and resumed, the handler is called with nil and the chunks it was given before should be
+ * discarded.
+ * @param chunkHandler A block that receives each chunk of the object's data, or nil when the
+ * download restarts.
+ * @param completion A completion block that fires when the download completes, with an error on
+ * failure.
+ * @return An FIRStorageDownloadTask that can be used to monitor or manage the download.
+ */
+// clang-format off
+- (FIRStorageDownloadTask *)streamWithChunkHandler:(void (^)(NSData *_Nullable chunk))chunkHandler
+                                        completion:(nullable void (^)(NSError *_Nullable error))
+                                                       completion
+    NS_SWIFT_NAME(stream(chunkHandler:completion:));
+// clang-format on
+
 /**
  * Asynchronously retrieves a long lived download URL with a revokable token.
  * This can be used to share the file with others, but can be revoked by a developer
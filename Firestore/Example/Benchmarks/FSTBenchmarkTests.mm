@@ -0,0 +1,55 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+
+#include <cstdlib>
+#include <string>
+
+#include "benchmark/benchmark.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+// If set, names the file the results are written to instead of the default one.
+static const char *const kBenchmarkOutEnvVar = "FIRESTORE_BENCHMARK_OUT";
+
+/**
+ * Runs the benchmarks linked into the Benchmarks target, such as those in local_store_benchmark.mm
+ * and watch_change_aggregator_benchmark.mm, and writes their results as JSON so that they can be
+ * compared across releases. On other platforms the CMake firebase_firestore_benchmarks_json target
+ * does the same for the benchmarks that build there.
+ */
+@interface FSTBenchmarkTests : XCTestCase
+@end
+
+@implementation FSTBenchmarkTests
+
+- (void)testRunBenchmarks {
+  const char *out_path = std::getenv(kBenchmarkOutEnvVar);
+  std::string out_flag =
+      std::string("--benchmark_out=") + (out_path ? out_path : "/tmp/firestore_benchmarks.json");
+
+  char *argv[3] = {const_cast<char *>("Benchmarks"), const_cast<char *>(out_flag.c_str()),
+                   const_cast<char *>("--benchmark_out_format=json")};
+  int argc = 3;
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/executor_std.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+namespace chr = std::chrono;
+using firebase::firestore::util::DelayedOperation;
+using firebase::firestore::util::Executor;
+using firebase::firestore::util::ExecutorStd;
+using firebase::firestore::util::async::Schedule;
+
+namespace {
+
+using IntSchedule = Schedule<int>;
+
+/**
+ * Returns a due time far enough in the future that nothing comes due while the
+ * benchmark runs, spread out so that entries land all over the schedule.
+ */
+IntSchedule::TimePoint FarAway(IntSchedule::TimePoint start, int i) {
+  return start + chr::hours(1) + chr::milliseconds((i * 7919) % 100000);
+}
+
+}  // namespace
+
+static void BM_ScheduleChurn(benchmark::State& state) {
+  int pending = static_cast<int>(state.range(0));
+  IntSchedule schedule;
+  const auto start = chr::time_point_cast<IntSchedule::Duration>(
+      IntSchedule::Clock::now());
+
+  std::vector<IntSchedule::Handle> handles;
+  for (int i = 0; i < pending; ++i) {
+    handles.push_back(schedule.Push(i, FarAway(start, i)));
+  }
+
+  // Each iteration cancels one pending timer and schedules a replacement, the
+  // way backoff and idle timers are rearmed.
+  int i = pending;
+  for (auto _ : state) {
+    size_t slot = static_cast<size_t>(i % pending);
+    benchmark::DoNotOptimize(schedule.Remove(handles[slot]));
+    handles[slot] = schedule.Push(i, FarAway(start, i));
+    ++i;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ScheduleChurn)->Arg(16)->Arg(256)->Arg(4096);
+
+static void BM_ExecutorStdScheduleAndCancel(benchmark::State& state) {
+  int pending = static_cast<int>(state.range(0));
+  ExecutorStd executor;
+
+  std::vector<DelayedOperation> operations;
+  for (int i = 0; i < pending; ++i) {
+    operations.push_back(
+        executor.Schedule(chr::hours(1) + chr::milliseconds(i),
+                          Executor::TaggedOperation{i, [] {}}));
+  }
+
+  for (auto _ : state) {
+    DelayedOperation operation = executor.Schedule(
+        chr::hours(1), Executor::TaggedOperation{pending, [] {}});
+    operation.Cancel();
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  for (DelayedOperation& operation : operations) {
+    operation.Cancel();
+  }
+}
+BENCHMARK(BM_ExecutorStdScheduleAndCancel)->Arg(16)->Arg(256)->Arg(4096);
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "benchmark/benchmark.h"
+
+using firebase::firestore::local::LevelDbDocumentMutationKey;
+using firebase::firestore::local::LevelDbMutationKey;
+using firebase::firestore::local::LevelDbRemoteDocumentKey;
+using firebase::firestore::model::DocumentKey;
+using firebase::firestore::testutil::Key;
+
+namespace {
+
+const char kUserId[] = "user-0123456789";
+const char kDocumentPath[] = "rooms/eros/messages/ZQ3cFvY9NLAbxCk2m4Tp";
+
+}  // namespace
+
+static void BM_LevelDbRemoteDocumentKeyEncode(benchmark::State& state) {
+  DocumentKey key = Key(kDocumentPath);
+  for (auto _ : state) {
+    std::string encoded = LevelDbRemoteDocumentKey::Key(key);
+    benchmark::DoNotOptimize(encoded);
+  }
+}
+BENCHMARK(BM_LevelDbRemoteDocumentKeyEncode);
+
+static void BM_LevelDbRemoteDocumentKeyDecode(benchmark::State& state) {
+  std::string encoded = LevelDbRemoteDocumentKey::Key(Key(kDocumentPath));
+  for (auto _ : state) {
+    LevelDbRemoteDocumentKey key;
+    bool ok = key.Decode(encoded);
+    benchmark::DoNotOptimize(ok);
+  }
+}
+BENCHMARK(BM_LevelDbRemoteDocumentKeyDecode);
+
+static void BM_LevelDbMutationKeyEncode(benchmark::State& state) {
+  int batch_id = 0;
+  for (auto _ : state) {
+    std::string encoded = LevelDbMutationKey::Key(kUserId, batch_id++);
+    benchmark::DoNotOptimize(encoded);
+  }
+}
+BENCHMARK(BM_LevelDbMutationKeyEncode);
+
+static void BM_LevelDbMutationKeyDecode(benchmark::State& state) {
+  std::string encoded = LevelDbMutationKey::Key(kUserId, 12345);
+  for (auto _ : state) {
+    LevelDbMutationKey key;
+    bool ok = key.Decode(encoded);
+    benchmark::DoNotOptimize(ok);
+  }
+}
+BENCHMARK(BM_LevelDbMutationKeyDecode);
+
+static void BM_LevelDbDocumentMutationKeyEncode(benchmark::State& state) {
+  DocumentKey key = Key(kDocumentPath);
+  for (auto _ : state) {
+    std::string encoded = LevelDbDocumentMutationKey::Key(kUserId, key, 12345);
+    benchmark::DoNotOptimize(encoded);
+  }
+}
+BENCHMARK(BM_LevelDbDocumentMutationKeyEncode);
+
+static void BM_LevelDbDocumentMutationKeyDecode(benchmark::State& state) {
+  std::string encoded =
+      LevelDbDocumentMutationKey::Key(kUserId, Key(kDocumentPath), 12345);
+  for (auto _ : state) {
+    LevelDbDocumentMutationKey key;
+    bool ok = key.Decode(encoded);
+    benchmark::DoNotOptimize(ok);
+  }
+}
+BENCHMARK(BM_LevelDbDocumentMutationKeyDecode);
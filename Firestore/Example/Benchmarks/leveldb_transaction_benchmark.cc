@@ -0,0 +1,180 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/util/filesystem.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/path.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/match.h"
+#include "benchmark/benchmark.h"
+#include "leveldb/db.h"
+
+using firebase::firestore::local::LevelDbDocumentTargetKey;
+using firebase::firestore::local::LevelDbRemoteDocumentKey;
+using firebase::firestore::local::LevelDbTargetDocumentKey;
+using firebase::firestore::local::LevelDbTransaction;
+using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::TargetId;
+using firebase::firestore::testutil::Key;
+using firebase::firestore::util::Path;
+using firebase::firestore::util::RecursivelyDelete;
+using firebase::firestore::util::Status;
+using firebase::firestore::util::StringFormat;
+using firebase::firestore::util::TempDir;
+
+namespace {
+
+// Roughly the size of a small encoded document.
+const size_t kDocumentSize = 1024;
+
+std::string DocumentKeyString(int i) {
+  return LevelDbRemoteDocumentKey::Key(
+      Key(StringFormat("rooms/eros/messages/doc%s", i)));
+}
+
+/**
+ * Opens a fresh LevelDB instance in a temporary directory and commits
+ * `document_count` remote documents to it.
+ */
+std::unique_ptr<leveldb::DB> PopulatedDb(int document_count) {
+  Path dir = Path::JoinUtf8(TempDir(), "firestore_leveldb_benchmark");
+  Status status = RecursivelyDelete(dir);
+  HARD_ASSERT(status.ok(), "Failed to clean up %s: %s", dir.ToUtf8String(),
+              status.ToString());
+
+  leveldb::Options options;
+  options.create_if_missing = true;
+  leveldb::DB* db = nullptr;
+  leveldb::Status open_status =
+      leveldb::DB::Open(options, dir.ToUtf8String(), &db);
+  HARD_ASSERT(open_status.ok(), "Failed to open %s: %s", dir.ToUtf8String(),
+              open_status.ToString());
+  std::unique_ptr<leveldb::DB> result{db};
+
+  LevelDbTransaction transaction(result.get(), "Populate");
+  for (int i = 0; i < document_count; ++i) {
+    transaction.Put(DocumentKeyString(i), std::string(kDocumentSize, 'a'));
+  }
+  transaction.Commit();
+  return result;
+}
+
+/** Reads every remote document through the transaction's merged view. */
+int ScanRemoteDocuments(LevelDbTransaction* transaction) {
+  std::string prefix = LevelDbRemoteDocumentKey::KeyPrefix();
+  auto it = transaction->NewIterator();
+  int count = 0;
+  for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix);
+       it->Next()) {
+    benchmark::DoNotOptimize(it->value());
+    ++count;
+  }
+  return count;
+}
+
+}  // namespace
+
+static void BM_LevelDbTransactionIterateCommitted(benchmark::State& state) {
+  int document_count = static_cast<int>(state.range(0));
+  std::unique_ptr<leveldb::DB> db = PopulatedDb(document_count);
+  for (auto _ : state) {
+    LevelDbTransaction transaction(db.get(), "IterateCommitted");
+    int count = ScanRemoteDocuments(&transaction);
+    HARD_ASSERT(count == document_count);
+  }
+  state.SetItemsProcessed(state.iterations() * document_count);
+}
+BENCHMARK(BM_LevelDbTransactionIterateCommitted)->Arg(100)->Arg(1000);
+
+static void BM_LevelDbTransactionIterateWithPendingChanges(
+    benchmark::State& state) {
+  int document_count = static_cast<int>(state.range(0));
+  std::unique_ptr<leveldb::DB> db = PopulatedDb(document_count);
+  for (auto _ : state) {
+    state.PauseTiming();
+    // Overwrite every other document and delete every fourth one so that the
+    // iterator has to merge buffered changes with committed data.
+    LevelDbTransaction transaction(db.get(), "IterateWithPendingChanges");
+    int expected_count = document_count;
+    for (int i = 0; i < document_count; i += 2) {
+      if (i % 4 == 0) {
+        transaction.Delete(DocumentKeyString(i));
+        --expected_count;
+      } else {
+        transaction.Put(DocumentKeyString(i), std::string(kDocumentSize, 'b'));
+      }
+    }
+    state.ResumeTiming();
+
+    int count = ScanRemoteDocuments(&transaction);
+    HARD_ASSERT(count == expected_count);
+  }
+  state.SetItemsProcessed(state.iterations() * document_count);
+}
+BENCHMARK(BM_LevelDbTransactionIterateWithPendingChanges)->Arg(100)->Arg(1000);
+
+/**
+ * Measures the LevelDB writes of applying a remote event that updates
+ * `range(0)` documents of `range(2)` bytes each, all of which match every one
+ * of `range(1)` targets: each document and both of its index entries for each
+ * target are written in one transaction. Unlike the local store benchmark,
+ * this runs wherever LevelDB builds, but leaves out decoding, encoding and the
+ * local store's bookkeeping.
+ */
+static void BM_LevelDbTransactionRemoteEventWrites(benchmark::State& state) {
+  int document_count = static_cast<int>(state.range(0));
+  int target_count = static_cast<int>(state.range(1));
+  auto document_bytes = static_cast<size_t>(state.range(2));
+  std::unique_ptr<leveldb::DB> db = PopulatedDb(document_count);
+
+  std::vector<DocumentKey> keys;
+  for (int i = 0; i < document_count; ++i) {
+    keys.push_back(Key(StringFormat("rooms/eros/messages/doc%s", i)));
+  }
+  std::string document(document_bytes, 'b');
+  std::string empty;
+
+  for (auto _ : state) {
+    LevelDbTransaction transaction(db.get(), "RemoteEventWrites");
+    for (const DocumentKey& key : keys) {
+      transaction.Put(LevelDbRemoteDocumentKey::Key(key), document);
+      for (TargetId target_id = 1; target_id <= target_count; ++target_id) {
+        transaction.Put(LevelDbTargetDocumentKey::Key(target_id, key), empty);
+        transaction.Put(LevelDbDocumentTargetKey::Key(key, target_id), empty);
+      }
+    }
+    transaction.Commit();
+  }
+  state.SetItemsProcessed(state.iterations() * document_count);
+  state.SetBytesProcessed(state.iterations() * document_count *
+                          static_cast<int64_t>(document_bytes));
+}
+BENCHMARK(BM_LevelDbTransactionRemoteEventWrites)
+    ->ArgNames({"documents", "targets", "bytes"})
+    ->RangeMultiplier(10)
+    ->Ranges({{10, 1000}, {1, 10}, {1 << 10, 1 << 16}})
+    ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,229 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#import "Firestore/Source/Core/FSTQuery.h"
+#import "Firestore/Source/Local/FSTLRUGarbageCollector.h"
+#import "Firestore/Source/Local/FSTLevelDB.h"
+#import "Firestore/Source/Local/FSTLocalSerializer.h"
+#import "Firestore/Source/Local/FSTLocalStore.h"
+#import "Firestore/Source/Local/FSTMemoryPersistence.h"
+#import "Firestore/Source/Local/FSTQueryData.h"
+#import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Model/FSTFieldValue.h"
+#import "Firestore/Source/Remote/FSTSerializerBeta.h"
+
+#include "Firestore/core/include/firebase/firestore/timestamp.h"
+#include "Firestore/core/src/firebase/firestore/auth/user.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
+#include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
+#include "Firestore/core/src/firebase/firestore/util/filesystem.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/path.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+using firebase::Timestamp;
+using firebase::firestore::auth::User;
+using firebase::firestore::local::LruParams;
+using firebase::firestore::model::DatabaseId;
+using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::DocumentKeySet;
+using firebase::firestore::model::ResourcePath;
+using firebase::firestore::model::SnapshotVersion;
+using firebase::firestore::model::TargetId;
+using firebase::firestore::remote::DocumentWatchChange;
+using firebase::firestore::remote::RemoteEvent;
+using firebase::firestore::remote::TargetMetadataProvider;
+using firebase::firestore::remote::WatchChangeAggregator;
+using firebase::firestore::remote::WatchTargetChange;
+using firebase::firestore::remote::WatchTargetChangeState;
+using firebase::firestore::util::Path;
+using firebase::firestore::util::RecursivelyDelete;
+using firebase::firestore::util::Status;
+using firebase::firestore::util::StringFormat;
+using firebase::firestore::util::TempDir;
+
+namespace {
+
+enum class PersistenceKind { kMemory = 0, kLevelDb = 1 };
+
+id<FSTPersistence> CreatePersistence(PersistenceKind kind) {
+  if (kind == PersistenceKind::kMemory) {
+    return [FSTMemoryPersistence persistenceWithEagerGC];
+  }
+
+  // This owns the DatabaseId since there's no FirestoreClient to own it.
+  static DatabaseId database_id{"project", DatabaseId::kDefault};
+
+  Path dir = Path::JoinUtf8(TempDir(), "firestore_local_store_benchmark");
+  Status status = RecursivelyDelete(dir);
+  HARD_ASSERT(status.ok(), "Failed to clean up %s: %s", dir.ToUtf8String(), status.ToString());
+
+  FSTSerializerBeta *remote_serializer =
+      [[FSTSerializerBeta alloc] initWithDatabaseID:&database_id];
+  FSTLocalSerializer *serializer =
+      [[FSTLocalSerializer alloc] initWithRemoteSerializer:remote_serializer];
+  FSTLevelDB *db;
+  status = [FSTLevelDB dbWithDirectory:std::move(dir)
+                            serializer:serializer
+                             lruParams:LruParams::Disabled()
+                                   ptr:&db];
+  HARD_ASSERT(status.ok(), "Failed to open LevelDB: %s", status.ToString());
+  return db;
+}
+
+/** Looks targets up in the local store, the way the sync engine does for RemoteStore. */
+class LocalStoreTargetsProvider : public TargetMetadataProvider {
+ public:
+  explicit LocalStoreTargetsProvider(FSTLocalStore *local_store) : local_store_(local_store) {
+  }
+
+  void AddTarget(FSTQueryData *query_data) {
+    query_data_[query_data.targetID] = query_data;
+  }
+
+  DocumentKeySet GetRemoteKeysForTarget(TargetId target_id) const override {
+    return [local_store_ remoteDocumentKeysForTarget:target_id];
+  }
+
+  FSTQueryData *GetQueryDataForTarget(TargetId target_id) const override {
+    auto found = query_data_.find(target_id);
+    return found != query_data_.end() ? found->second : nil;
+  }
+
+  const DatabaseId &GetDatabaseId() const override {
+    static DatabaseId database_id{"project", DatabaseId::kDefault};
+    return database_id;
+  }
+
+ private:
+  FSTLocalStore *local_store_;
+  std::unordered_map<TargetId, FSTQueryData *> query_data_;
+};
+
+/**
+ * Creates `document_count` documents with about `document_bytes` of data each. The documents
+ * carry `version` in their data as well, so every round changes them and none of the writes is
+ * skipped as a resend.
+ */
+std::vector<FSTDocument *> CreateDocuments(int document_count,
+                                           int64_t document_bytes,
+                                           int64_t version) {
+  NSData *payload = [NSMutableData dataWithLength:static_cast<NSUInteger>(document_bytes)];
+  std::vector<FSTDocument *> docs;
+  for (int i = 0; i < document_count; ++i) {
+    FSTObjectValue *data = [[FSTObjectValue alloc] initWithDictionary:@{
+      @"payload" : [FSTBlobValue blobValue:payload],
+      @"version" : [FSTIntegerValue integerValue:version]
+    }];
+    docs.push_back([FSTDocument documentWithData:data
+                                             key:DocumentKey::FromPathString(
+                                                     StringFormat("coll/doc%s", i))
+                                         version:SnapshotVersion{Timestamp{version, 0}}
+                                           state:FSTDocumentStateSynced]);
+  }
+  return docs;
+}
+
+}  // namespace
+
+/**
+ * Measures `-[FSTLocalStore applyRemoteEvent:]` for a snapshot that updates `range(1)` documents of
+ * about `range(3)` bytes each, all of which match every one of `range(2)` targets. `range(0)` picks
+ * memory (0) or LevelDB (1) persistence. The first round adds the documents and every later round
+ * modifies them, as watch does when the documents change on the backend.
+ */
+static void BM_LocalStoreApplyRemoteEvent(benchmark::State &state) {
+  auto persistence_kind = static_cast<PersistenceKind>(state.range(0));
+  int document_count = static_cast<int>(state.range(1));
+  int target_count = static_cast<int>(state.range(2));
+  int64_t document_bytes = state.range(3);
+
+  id<FSTPersistence> persistence = CreatePersistence(persistence_kind);
+  FSTLocalStore *local_store = [[FSTLocalStore alloc] initWithPersistence:persistence
+                                                               initialUser:User::Unauthenticated()];
+  [local_store start];
+
+  LocalStoreTargetsProvider provider{local_store};
+  std::vector<TargetId> target_ids;
+  for (int i = 0; i < target_count; ++i) {
+    // Each limit makes a distinct query, so each gets a target of its own.
+    FSTQuery *query = [[FSTQuery queryWithPath:ResourcePath{"coll"}] queryBySettingLimit:i + 1];
+    FSTQueryData *query_data = [local_store allocateQuery:query];
+    provider.AddTarget(query_data);
+    target_ids.push_back(query_data.targetID);
+  }
+  NSData *resume_token = [@"resume" dataUsingEncoding:NSUTF8StringEncoding];
+
+  int64_t version = 1;
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<FSTDocument *> docs = CreateDocuments(document_count, document_bytes, version);
+    WatchChangeAggregator aggregator{&provider};
+    for (FSTDocument *doc : docs) {
+      aggregator.HandleDocumentChange(DocumentWatchChange{target_ids, {}, doc.key, doc});
+    }
+    aggregator.HandleTargetChange(
+        WatchTargetChange{WatchTargetChangeState::Current, target_ids, resume_token});
+    RemoteEvent event = aggregator.CreateRemoteEvent(SnapshotVersion{Timestamp{version, 0}});
+    ++version;
+    state.ResumeTiming();
+
+    benchmark::DoNotOptimize([local_store applyRemoteEvent:event]);
+  }
+  state.SetItemsProcessed(state.iterations() * document_count);
+  state.SetBytesProcessed(state.iterations() * document_count * document_bytes);
+
+  [persistence shutdown];
+}
+
+/**
+ * Covers both kinds of persistence with snapshots of 10 to 1000 documents, matching 1 or 10
+ * targets, of 1 KiB to 64 KiB each.
+ */
+static void LocalStoreApplyRemoteEventArgs(benchmark::internal::Benchmark *b) {
+  b->ArgNames({"leveldb", "documents", "targets", "bytes"});
+  for (int persistence = 0; persistence <= 1; ++persistence) {
+    for (int documents = 10; documents <= 1000; documents *= 10) {
+      for (int targets = 1; targets <= 10; targets *= 10) {
+        for (int bytes = 1 << 10; bytes <= 1 << 16; bytes <<= 3) {
+          b->Args({persistence, documents, targets, bytes});
+        }
+      }
+    }
+  }
+}
+BENCHMARK(BM_LocalStoreApplyRemoteEvent)
+    ->Apply(LocalStoreApplyRemoteEventArgs)
+    ->Unit(benchmark::kMicrosecond);
+
+NS_ASSUME_NONNULL_END
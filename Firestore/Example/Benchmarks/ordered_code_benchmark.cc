@@ -0,0 +1,134 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
+
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "benchmark/benchmark.h"
+
+using firebase::firestore::util::OrderedCode;
+
+namespace {
+
+// A typical document path segment, with one byte that needs escaping.
+const char kSegment[] = "messages\0chat-room-0042";
+
+}  // namespace
+
+static void BM_OrderedCodeWriteString(benchmark::State& state) {
+  absl::string_view segment{kSegment, sizeof(kSegment) - 1};
+  std::string dest;
+  for (auto _ : state) {
+    dest.clear();
+    OrderedCode::WriteString(&dest, segment);
+    benchmark::DoNotOptimize(dest);
+  }
+}
+BENCHMARK(BM_OrderedCodeWriteString);
+
+static void BM_OrderedCodeReadString(benchmark::State& state) {
+  std::string encoded;
+  OrderedCode::WriteString(&encoded, {kSegment, sizeof(kSegment) - 1});
+  std::string result;
+  for (auto _ : state) {
+    absl::string_view src = encoded;
+    result.clear();
+    bool ok = OrderedCode::ReadString(&src, &result);
+    benchmark::DoNotOptimize(ok);
+  }
+}
+BENCHMARK(BM_OrderedCodeReadString);
+
+// Long strings without special bytes, e.g. auto-generated document IDs or the
+// canonical IDs of queries with several filters.
+static void BM_OrderedCodeWriteLongString(benchmark::State& state) {
+  std::string value(static_cast<size_t>(state.range(0)), 'a');
+  std::string dest;
+  for (auto _ : state) {
+    dest.clear();
+    OrderedCode::WriteString(&dest, value);
+    benchmark::DoNotOptimize(dest);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_OrderedCodeWriteLongString)->Range(16, 1024);
+
+static void BM_OrderedCodeReadLongString(benchmark::State& state) {
+  std::string encoded;
+  OrderedCode::WriteString(
+      &encoded, std::string(static_cast<size_t>(state.range(0)), 'a'));
+  std::string result;
+  for (auto _ : state) {
+    absl::string_view src = encoded;
+    result.clear();
+    bool ok = OrderedCode::ReadString(&src, &result);
+    benchmark::DoNotOptimize(ok);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_OrderedCodeReadLongString)->Range(16, 1024);
+
+static void BM_OrderedCodeWriteNumIncreasing(benchmark::State& state) {
+  std::string dest;
+  uint64_t num = 0;
+  for (auto _ : state) {
+    dest.clear();
+    OrderedCode::WriteNumIncreasing(&dest, num);
+    benchmark::DoNotOptimize(dest);
+    num = num * 31 + 7;
+  }
+}
+BENCHMARK(BM_OrderedCodeWriteNumIncreasing);
+
+static void BM_OrderedCodeReadNumIncreasing(benchmark::State& state) {
+  std::string encoded;
+  OrderedCode::WriteNumIncreasing(&encoded, 1234567890123ULL);
+  for (auto _ : state) {
+    absl::string_view src = encoded;
+    uint64_t result = 0;
+    bool ok = OrderedCode::ReadNumIncreasing(&src, &result);
+    benchmark::DoNotOptimize(ok);
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_OrderedCodeReadNumIncreasing);
+
+static void BM_OrderedCodeWriteSignedNumIncreasing(benchmark::State& state) {
+  std::string dest;
+  int64_t num = -1234567890123LL;
+  for (auto _ : state) {
+    dest.clear();
+    OrderedCode::WriteSignedNumIncreasing(&dest, num);
+    benchmark::DoNotOptimize(dest);
+  }
+}
+BENCHMARK(BM_OrderedCodeWriteSignedNumIncreasing);
+
+static void BM_OrderedCodeReadSignedNumIncreasing(benchmark::State& state) {
+  std::string encoded;
+  OrderedCode::WriteSignedNumIncreasing(&encoded, -1234567890123LL);
+  for (auto _ : state) {
+    absl::string_view src = encoded;
+    int64_t result = 0;
+    bool ok = OrderedCode::ReadSignedNumIncreasing(&src, &result);
+    benchmark::DoNotOptimize(ok);
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_OrderedCodeReadSignedNumIncreasing);
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+
+#include <memory>
+
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "benchmark/benchmark.h"
+
+using firebase::firestore::core::Query;
+using firebase::firestore::model::Document;
+using firebase::firestore::model::FieldValue;
+using firebase::firestore::testutil::Doc;
+using firebase::firestore::testutil::Filter;
+
+namespace testutil = firebase::firestore::testutil;
+
+namespace {
+
+std::shared_ptr<Document> ChatMessage() {
+  return Doc("rooms/eros/messages/1", 0,
+             {{"author", FieldValue::FromString("alice")},
+              {"text", FieldValue::FromString("Hello, world!")},
+              {"sort", FieldValue::FromInteger(42)},
+              {"meta", FieldValue::FromMap(
+                           {{"score", FieldValue::FromDouble(0.75)},
+                            {"flagged", FieldValue::False()}})}});
+}
+
+}  // namespace
+
+static void BM_QueryMatchesPath(benchmark::State& state) {
+  std::shared_ptr<Document> doc = ChatMessage();
+  Query query = testutil::Query("rooms/eros/messages");
+  for (auto _ : state) {
+    bool matches = query.Matches(*doc);
+    benchmark::DoNotOptimize(matches);
+  }
+}
+BENCHMARK(BM_QueryMatchesPath);
+
+static void BM_QueryMatchesEqualityFilter(benchmark::State& state) {
+  std::shared_ptr<Document> doc = ChatMessage();
+  Query query = testutil::Query("rooms/eros/messages")
+                    .Filter(Filter("author", "==", "alice"));
+  for (auto _ : state) {
+    bool matches = query.Matches(*doc);
+    benchmark::DoNotOptimize(matches);
+  }
+}
+BENCHMARK(BM_QueryMatchesEqualityFilter);
+
+static void BM_QueryMatchesNestedRangeFilters(benchmark::State& state) {
+  std::shared_ptr<Document> doc = ChatMessage();
+  Query query = testutil::Query("rooms/eros/messages")
+                    .Filter(Filter("meta.score", ">=", 0.5))
+                    .Filter(Filter("meta.score", "<", 1.0));
+  for (auto _ : state) {
+    bool matches = query.Matches(*doc);
+    benchmark::DoNotOptimize(matches);
+  }
+}
+BENCHMARK(BM_QueryMatchesNestedRangeFilters);
+
+static void BM_QueryMatchesWrongCollection(benchmark::State& state) {
+  std::shared_ptr<Document> doc = ChatMessage();
+  Query query = testutil::Query("rooms/other/messages")
+                    .Filter(Filter("author", "==", "alice"));
+  for (auto _ : state) {
+    bool matches = query.Matches(*doc);
+    benchmark::DoNotOptimize(matches);
+  }
+}
+BENCHMARK(BM_QueryMatchesWrongCollection);
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/query_router.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "benchmark/benchmark.h"
+
+using firebase::firestore::core::QueryRouter;
+using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::ResourcePath;
+using firebase::firestore::model::TargetId;
+
+namespace testutil = firebase::firestore::testutil;
+
+namespace {
+
+// The changed documents are spread over this many rooms, so that each event
+// affects a handful of listeners however many there are.
+const int kChangedRooms = 10;
+
+/** Listens to the messages of `count` rooms, one listener per room. */
+std::vector<ResourcePath> ListenedCollections(int count) {
+  std::vector<ResourcePath> collections;
+  for (int i = 0; i < count; ++i) {
+    collections.push_back(
+        testutil::Resource("rooms/" + std::to_string(i) + "/messages"));
+  }
+  return collections;
+}
+
+/** Returns the keys of `count` new messages in the first few rooms. */
+std::vector<DocumentKey> ChangedMessages(int count) {
+  std::vector<DocumentKey> keys;
+  for (int i = 0; i < count; ++i) {
+    keys.push_back(testutil::Key("rooms/" + std::to_string(i % kChangedRooms) +
+                                 "/messages/" + std::to_string(i)));
+  }
+  return keys;
+}
+
+}  // namespace
+
+/**
+ * Measures finding the listeners affected by `range(1)` changed documents out
+ * of `range(0)` listeners by visiting every listener and looking up the
+ * changes to its collection, as FSTSyncEngine used to for every event.
+ */
+static void BM_RouteChangesByVisitingEveryQuery(benchmark::State& state) {
+  std::vector<ResourcePath> collections =
+      ListenedCollections(static_cast<int>(state.range(0)));
+  std::vector<DocumentKey> changes =
+      ChangedMessages(static_cast<int>(state.range(1)));
+
+  for (auto _ : state) {
+    std::map<ResourcePath, std::vector<DocumentKey>> changes_by_collection;
+    for (const DocumentKey& key : changes) {
+      changes_by_collection[key.path().PopLast()].push_back(key);
+    }
+
+    std::set<TargetId> affected;
+    for (size_t i = 0; i < collections.size(); ++i) {
+      if (changes_by_collection.count(collections[i]) > 0) {
+        affected.insert(static_cast<TargetId>(i));
+      }
+    }
+    benchmark::DoNotOptimize(affected);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_RouteChangesByVisitingEveryQuery)
+    ->Args({10, 1})
+    ->Args({300, 1})
+    ->Args({300, 100})
+    ->Args({3000, 1})
+    ->Args({3000, 100});
+
+/**
+ * Measures finding the same listeners as BM_RouteChangesByVisitingEveryQuery
+ * by looking up each changed document in a QueryRouter.
+ */
+static void BM_RouteChangesWithQueryRouter(benchmark::State& state) {
+  std::vector<ResourcePath> collections =
+      ListenedCollections(static_cast<int>(state.range(0)));
+  std::vector<DocumentKey> changes =
+      ChangedMessages(static_cast<int>(state.range(1)));
+
+  QueryRouter router;
+  for (size_t i = 0; i < collections.size(); ++i) {
+    router.AddQuery(static_cast<TargetId>(i), collections[i], "");
+  }
+
+  for (auto _ : state) {
+    std::set<TargetId> affected;
+    for (const DocumentKey& key : changes) {
+      router.AddTargetsAffectedBy(key, &affected);
+    }
+    benchmark::DoNotOptimize(affected);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_RouteChangesWithQueryRouter)
+    ->Args({10, 1})
+    ->Args({300, 1})
+    ->Args({300, 100})
+    ->Args({3000, 1})
+    ->Args({3000, 100});
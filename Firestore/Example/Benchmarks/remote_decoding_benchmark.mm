@@ -0,0 +1,190 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#include <memory>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#import "Firestore/Protos/objc/google/firestore/v1/Firestore.pbobjc.h"
+#import "Firestore/Source/Model/FSTMutation.h"
+#import "Firestore/Source/Remote/FSTSerializerBeta.h"
+
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/remote/remote_objc_bridge.h"
+#include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "grpcpp/support/byte_buffer.h"
+#include "grpcpp/support/slice.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+using firebase::firestore::model::DatabaseId;
+using firebase::firestore::model::SnapshotVersion;
+using firebase::firestore::remote::WatchChange;
+using firebase::firestore::remote::bridge::WatchStreamSerializer;
+using firebase::firestore::remote::bridge::WriteStreamSerializer;
+using firebase::firestore::util::Status;
+
+namespace {
+
+const DatabaseId &BenchmarkDatabaseId() {
+  static DatabaseId database_id{"project", DatabaseId::kDefault};
+  return database_id;
+}
+
+FSTSerializerBeta *MakeSerializer() {
+  return [[FSTSerializerBeta alloc] initWithDatabaseID:&BenchmarkDatabaseId()];
+}
+
+grpc::ByteBuffer MakeByteBuffer(NSData *data) {
+  grpc::Slice slice{data.bytes, data.length};
+  return grpc::ByteBuffer{&slice, 1};
+}
+
+/**
+ * Encodes a document change like those of an initial sync, for a document with `field_count`
+ * fields, half of them strings and half of them maps of two numbers.
+ */
+grpc::ByteBuffer EncodedDocumentChange(int field_count) {
+  GCFSListenResponse *response = [GCFSListenResponse message];
+  GCFSDocument *document = response.documentChange.document;
+  document.name = @"projects/project/databases/(default)/documents/coll/doc";
+  document.updateTime.seconds = 1234;
+  for (int i = 0; i < field_count; ++i) {
+    GCFSValue *value = [GCFSValue message];
+    if (i % 2 == 0) {
+      value.stringValue = [NSString stringWithFormat:@"value of field %d", i];
+    } else {
+      GCFSValue *integer = [GCFSValue message];
+      integer.integerValue = i;
+      GCFSValue *number = [GCFSValue message];
+      number.doubleValue = i / 2.0;
+      value.mapValue.fields[@"integer"] = integer;
+      value.mapValue.fields[@"double"] = number;
+    }
+    document.fields[[NSString stringWithFormat:@"field%d", i]] = value;
+  }
+  [response.documentChange.targetIdsArray addValue:2];
+  return MakeByteBuffer([response data]);
+}
+
+grpc::ByteBuffer EncodedWriteResponse(int result_count) {
+  GCFSWriteResponse *response = [GCFSWriteResponse message];
+  response.streamToken = [@"token" dataUsingEncoding:NSUTF8StringEncoding];
+  response.commitTime.seconds = 1234;
+  for (int i = 0; i < result_count; ++i) {
+    GCFSWriteResult *result = [GCFSWriteResult message];
+    result.updateTime.seconds = 1234;
+    [response.writeResultsArray addObject:result];
+  }
+  return MakeByteBuffer([response data]);
+}
+
+}  // namespace
+
+/**
+ * Measures decoding a document change with `range(0)` fields by parsing it into protobuf objects
+ * and converting those with FSTSerializerBeta, as the watch stream used to.
+ */
+static void BM_DecodeDocumentChangeWithProtobufObjects(benchmark::State &state) {
+  WatchStreamSerializer serializer{MakeSerializer()};
+  grpc::ByteBuffer message = EncodedDocumentChange(static_cast<int>(state.range(0)));
+
+  for (auto _ : state) {
+    @autoreleasepool {
+      Status status;
+      GCFSListenResponse *response = serializer.ParseResponse(message, &status);
+      HARD_ASSERT(status.ok());
+      std::unique_ptr<WatchChange> change = serializer.ToWatchChange(response);
+      SnapshotVersion version = serializer.ToSnapshotVersion(response);
+      benchmark::DoNotOptimize(change);
+      benchmark::DoNotOptimize(version);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * message.Length());
+}
+BENCHMARK(BM_DecodeDocumentChangeWithProtobufObjects)->Arg(4)->Arg(32)->Arg(256);
+
+/**
+ * Measures decoding the same document change as BM_DecodeDocumentChangeWithProtobufObjects
+ * straight from nanopb messages.
+ */
+static void BM_DecodeDocumentChangeWithNanopb(benchmark::State &state) {
+  WatchStreamSerializer serializer{MakeSerializer()};
+  grpc::ByteBuffer message = EncodedDocumentChange(static_cast<int>(state.range(0)));
+
+  for (auto _ : state) {
+    @autoreleasepool {
+      Status status;
+      SnapshotVersion version;
+      std::unique_ptr<WatchChange> change = serializer.DecodeResponse(message, &version, &status);
+      HARD_ASSERT(status.ok());
+      benchmark::DoNotOptimize(change);
+      benchmark::DoNotOptimize(version);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * message.Length());
+}
+BENCHMARK(BM_DecodeDocumentChangeWithNanopb)->Arg(4)->Arg(32)->Arg(256);
+
+/**
+ * Measures decoding a write response with `range(0)` results through protobuf objects, as the
+ * write stream used to.
+ */
+static void BM_DecodeWriteResponseWithProtobufObjects(benchmark::State &state) {
+  WriteStreamSerializer serializer{MakeSerializer()};
+  grpc::ByteBuffer message = EncodedWriteResponse(static_cast<int>(state.range(0)));
+
+  for (auto _ : state) {
+    @autoreleasepool {
+      Status status;
+      GCFSWriteResponse *response = serializer.ParseResponse(message, &status);
+      HARD_ASSERT(status.ok());
+      SnapshotVersion version = serializer.ToCommitVersion(response);
+      std::vector<FSTMutationResult *> results = serializer.ToMutationResults(response);
+      benchmark::DoNotOptimize(version);
+      benchmark::DoNotOptimize(results);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DecodeWriteResponseWithProtobufObjects)->Arg(1)->Arg(100);
+
+/** Measures decoding the same write response straight from nanopb messages. */
+static void BM_DecodeWriteResponseWithNanopb(benchmark::State &state) {
+  WriteStreamSerializer serializer{MakeSerializer()};
+  grpc::ByteBuffer message = EncodedWriteResponse(static_cast<int>(state.range(0)));
+
+  for (auto _ : state) {
+    @autoreleasepool {
+      SnapshotVersion version;
+      std::vector<FSTMutationResult *> results;
+      Status status = serializer.DecodeResponse(message, &version, &results);
+      HARD_ASSERT(status.ok());
+      benchmark::DoNotOptimize(version);
+      benchmark::DoNotOptimize(results);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DecodeWriteResponseWithNanopb)->Arg(1)->Arg(100);
+
+NS_ASSUME_NONNULL_END
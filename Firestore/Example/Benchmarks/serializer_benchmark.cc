@@ -0,0 +1,163 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/serializer.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "Firestore/Protos/nanopb/google/firestore/v1/document.nanopb.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/test/firebase/firestore/testutil/allocation_counter.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "benchmark/benchmark.h"
+
+using firebase::firestore::model::DatabaseId;
+using firebase::firestore::model::Document;
+using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::FieldValue;
+using firebase::firestore::model::ObjectValue;
+using firebase::firestore::nanopb::Reader;
+using firebase::firestore::nanopb::Writer;
+using firebase::firestore::remote::Serializer;
+using firebase::firestore::testutil::AllocationCounter;
+using firebase::firestore::testutil::Key;
+using firebase::firestore::testutil::Version;
+
+namespace {
+
+const DatabaseId kDatabaseId{"p", "d"};
+
+/**
+ * A document shaped like a typical chat message: a handful of top-level
+ * scalars, a nested map and a short array.
+ */
+ObjectValue ChatMessage() {
+  return ObjectValue::FromMap({
+      {"author", FieldValue::FromString("alice")},
+      {"text", FieldValue::FromString(std::string(200, 'x'))},
+      {"sort", FieldValue::FromInteger(42)},
+      {"sent", FieldValue::FromTimestamp({1234, 5678})},
+      {"meta", FieldValue::FromMap({
+                   {"score", FieldValue::FromDouble(0.75)},
+                   {"flagged", FieldValue::False()},
+                   {"client", FieldValue::FromString("ios")},
+               })},
+      {"tags", FieldValue::FromArray({
+                   FieldValue::FromString("greeting"),
+                   FieldValue::FromString("public"),
+                   FieldValue::FromString("pinned"),
+               })},
+  });
+}
+
+std::string EncodeDocument(const Serializer& serializer,
+                           const DocumentKey& key,
+                           const ObjectValue& value) {
+  std::string bytes;
+  Writer writer = Writer::Wrap(&bytes);
+  google_firestore_v1_Document proto = serializer.EncodeDocument(key, value);
+  // EncodeDocument skips the output-only update_time, but decoding requires it.
+  proto.update_time = Serializer::EncodeVersion(Version(1000));
+  writer.WriteNanopbMessage(google_firestore_v1_Document_fields, &proto);
+  Serializer::FreeNanopbMessage(google_firestore_v1_Document_fields, &proto);
+  return bytes;
+}
+
+/** Reports the allocations `allocations` counted per iteration of `state`. */
+void ReportAllocations(benchmark::State& state,
+                       const AllocationCounter& allocations) {
+  state.counters["allocations"] =
+      static_cast<double>(allocations.count()) /
+      static_cast<double>(state.iterations());
+}
+
+}  // namespace
+
+static void BM_SerializerEncodeDocument(benchmark::State& state) {
+  Serializer serializer{kDatabaseId};
+  DocumentKey key = Key("rooms/eros/messages/1");
+  ObjectValue value = ChatMessage();
+  for (auto _ : state) {
+    std::string bytes = EncodeDocument(serializer, key, value);
+    benchmark::DoNotOptimize(bytes);
+  }
+}
+BENCHMARK(BM_SerializerEncodeDocument);
+
+static void BM_SerializerEncodeDocumentBytes(benchmark::State& state) {
+  Serializer serializer{kDatabaseId};
+  DocumentKey key = Key("rooms/eros/messages/1");
+  ObjectValue value = ChatMessage();
+  std::string bytes;
+  for (auto _ : state) {
+    serializer.EncodeDocumentBytes(key, value, &bytes);
+    benchmark::DoNotOptimize(bytes);
+  }
+}
+BENCHMARK(BM_SerializerEncodeDocumentBytes);
+
+static void BM_SerializerDecodeDocument(benchmark::State& state) {
+  Serializer serializer{kDatabaseId};
+  std::string bytes =
+      EncodeDocument(serializer, Key("rooms/eros/messages/1"), ChatMessage());
+  AllocationCounter allocations;
+  for (auto _ : state) {
+    Reader reader = Reader::Wrap(bytes);
+    google_firestore_v1_Document proto =
+        google_firestore_v1_Document_init_zero;
+    reader.ReadNanopbMessage(google_firestore_v1_Document_fields, &proto);
+    std::unique_ptr<Document> doc = serializer.DecodeDocument(&reader, proto);
+    reader.FreeNanopbMessage(google_firestore_v1_Document_fields, &proto);
+    HARD_ASSERT(reader.status().ok(), "Failed to decode document");
+    benchmark::DoNotOptimize(doc);
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(bytes.size()));
+  ReportAllocations(state, allocations);
+}
+BENCHMARK(BM_SerializerDecodeDocument);
+
+static void BM_SerializerEncodeFieldValue(benchmark::State& state) {
+  FieldValue value = FieldValue::FromMap(ChatMessage().GetInternalValue());
+  for (auto _ : state) {
+    std::string bytes;
+    Writer writer = Writer::Wrap(&bytes);
+    google_firestore_v1_Value proto = Serializer::EncodeFieldValue(value);
+    writer.WriteNanopbMessage(google_firestore_v1_Value_fields, &proto);
+    Serializer::FreeNanopbMessage(google_firestore_v1_Value_fields, &proto);
+    benchmark::DoNotOptimize(bytes);
+  }
+}
+BENCHMARK(BM_SerializerEncodeFieldValue);
+
+static void BM_SerializerEncodeFieldValueBytes(benchmark::State& state) {
+  FieldValue value = FieldValue::FromMap(ChatMessage().GetInternalValue());
+  std::string bytes;
+  for (auto _ : state) {
+    Serializer::EncodeFieldValueBytes(value, &bytes);
+    benchmark::DoNotOptimize(bytes);
+  }
+}
+BENCHMARK(BM_SerializerEncodeFieldValueBytes);
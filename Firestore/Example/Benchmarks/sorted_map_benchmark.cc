@@ -0,0 +1,340 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/immutable/array_sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/immutable/btree_sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_set.h"
+#include "Firestore/core/test/firebase/firestore/testutil/allocation_counter.h"
+#include "benchmark/benchmark.h"
+
+using firebase::firestore::immutable::SortedMap;
+using firebase::firestore::immutable::SortedMapBase;
+using firebase::firestore::immutable::SortedSet;
+using firebase::firestore::immutable::impl::ArraySortedMap;
+using firebase::firestore::immutable::impl::BTreeSortedMap;
+using firebase::firestore::testutil::AllocationCounter;
+
+namespace {
+
+using IntMap = SortedMap<int, int>;
+
+/**
+ * Returns the key of the benchmarks' `i`th entry: `i` itself, or a string
+ * that sorts like a typical field name or document ID.
+ */
+template <typename K>
+K KeyAt(int i);
+
+template <>
+int KeyAt<int>(int i) {
+  return i;
+}
+
+template <>
+std::string KeyAt<std::string>(int i) {
+  std::string digits = std::to_string(i);
+  size_t padding = digits.size() < 3 ? 3 - digits.size() : 0;
+  return "field_" + std::string(padding, '0') + digits;
+}
+
+/** Creates a map containing the keys [0, size). */
+IntMap Sequential(int size) {
+  IntMap result;
+  for (int i = 0; i < size; ++i) {
+    result = result.insert(i, i);
+  }
+  return result;
+}
+
+/**
+ * Reports the allocations `allocations` counted per iteration of `state`,
+ * failing the benchmark if there were more than `budget`.
+ */
+void CheckAllocationBudget(benchmark::State& state,
+                           const AllocationCounter& allocations,
+                           double budget) {
+  double per_iteration = static_cast<double>(allocations.count()) /
+                         static_cast<double>(state.iterations());
+  state.counters["allocations"] = per_iteration;
+  if (per_iteration > budget) {
+    state.SkipWithError("Exceeded the allocation budget");
+  }
+}
+
+}  // namespace
+
+static void BM_SortedMapInsert(benchmark::State& state) {
+  int size = static_cast<int>(state.range(0));
+  for (auto _ : state) {
+    IntMap map = Sequential(size);
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_SortedMapInsert)->Arg(16)->Arg(256)->Arg(4096);
+
+static void BM_SortedMapBuild(benchmark::State& state) {
+  int size = static_cast<int>(state.range(0));
+  for (auto _ : state) {
+    IntMap::Builder builder;
+    for (int i = 0; i < size; ++i) {
+      builder.push_back(i, i);
+    }
+    IntMap map = builder.Build();
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_SortedMapBuild)->Arg(16)->Arg(256)->Arg(4096);
+
+static void BM_SortedMapInsertAll(benchmark::State& state) {
+  int size = static_cast<int>(state.range(0));
+  IntMap map = Sequential(size);
+
+  std::vector<std::pair<int, int>> batch;
+  for (int i = 0; i < size; ++i) {
+    batch.emplace_back(size + i, i);
+  }
+  for (auto _ : state) {
+    IntMap result = map.insert_all(batch);
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_SortedMapInsertAll)->Arg(16)->Arg(256)->Arg(4096);
+
+static void BM_SortedMapInsertIntoExisting(benchmark::State& state) {
+  int size = static_cast<int>(state.range(0));
+  IntMap map = Sequential(size);
+  int key = size / 2;
+  for (auto _ : state) {
+    // Replacing an existing key copies the path to it without growing the map.
+    IntMap result = map.insert(key, -1);
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_SortedMapInsertIntoExisting)->Arg(16)->Arg(256)->Arg(4096);
+
+static void BM_SortedMapErase(benchmark::State& state) {
+  int size = static_cast<int>(state.range(0));
+  IntMap map = Sequential(size);
+  for (auto _ : state) {
+    IntMap result = map;
+    for (int i = 0; i < size; ++i) {
+      result = result.erase(i);
+    }
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_SortedMapErase)->Arg(16)->Arg(256)->Arg(4096);
+
+static void BM_SortedMapIterate(benchmark::State& state) {
+  int size = static_cast<int>(state.range(0));
+  IntMap map = Sequential(size);
+  AllocationCounter allocations;
+  for (auto _ : state) {
+    int sum = 0;
+    for (const auto& entry : map) {
+      sum += entry.second;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+  // Neither representation allocates to iterate.
+  CheckAllocationBudget(state, allocations, 0);
+}
+BENCHMARK(BM_SortedMapIterate)->Arg(16)->Arg(256)->Arg(4096);
+
+static void BM_SortedMapFind(benchmark::State& state) {
+  int size = static_cast<int>(state.range(0));
+  IntMap map = Sequential(size);
+  int key = 0;
+  AllocationCounter allocations;
+  for (auto _ : state) {
+    auto found = map.find(key);
+    benchmark::DoNotOptimize(found);
+    key = (key + 1) % size;
+  }
+  CheckAllocationBudget(state, allocations, 0);
+}
+BENCHMARK(BM_SortedMapFind)->Arg(16)->Arg(256)->Arg(4096);
+
+// The array and tree crossover: SortedMap stores maps of up to kFixedSize
+// entries in an ArraySortedMap and larger ones in a BTreeSortedMap. These
+// benchmarks compare the two at sizes up to kFixedSize, for integer keys like
+// TargetIds and string keys like field names, so that kFixedSize can be
+// rechecked when either representation changes. To measure beyond it, rebuild
+// with a larger kFixedSize.
+
+namespace {
+
+template <typename Map>
+Map SequentialMap(int size) {
+  using K = typename Map::value_type::first_type;
+  Map result;
+  for (int i = 0; i < size; ++i) {
+    result = result.insert(KeyAt<K>(i), i);
+  }
+  return result;
+}
+
+void CrossoverSizes(benchmark::internal::Benchmark* b) {
+  int fixed_size = static_cast<int>(SortedMapBase::kFixedSize);
+  for (int size = 4; size < fixed_size; size += 4) {
+    b->Arg(size);
+  }
+  b->Arg(fixed_size);
+}
+
+}  // namespace
+
+template <typename Map>
+static void BM_CrossoverFind(benchmark::State& state) {
+  using K = typename Map::value_type::first_type;
+  int size = static_cast<int>(state.range(0));
+  Map map = SequentialMap<Map>(size);
+  std::vector<K> keys;
+  for (int i = 0; i < size; ++i) {
+    keys.push_back(KeyAt<K>(i));
+  }
+  size_t next = 0;
+  for (auto _ : state) {
+    auto found = map.find(keys[next]);
+    benchmark::DoNotOptimize(found);
+    next = next + 1 == keys.size() ? 0 : next + 1;
+  }
+}
+
+template <typename Map>
+static void BM_CrossoverInsert(benchmark::State& state) {
+  int size = static_cast<int>(state.range(0));
+  for (auto _ : state) {
+    Map map = SequentialMap<Map>(size);
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+
+BENCHMARK_TEMPLATE(BM_CrossoverFind, ArraySortedMap<int, int>)
+    ->Apply(CrossoverSizes);
+BENCHMARK_TEMPLATE(BM_CrossoverFind, BTreeSortedMap<int, int>)
+    ->Apply(CrossoverSizes);
+BENCHMARK_TEMPLATE(BM_CrossoverFind, ArraySortedMap<std::string, int>)
+    ->Apply(CrossoverSizes);
+BENCHMARK_TEMPLATE(BM_CrossoverFind, BTreeSortedMap<std::string, int>)
+    ->Apply(CrossoverSizes);
+BENCHMARK_TEMPLATE(BM_CrossoverInsert, ArraySortedMap<int, int>)
+    ->Apply(CrossoverSizes);
+BENCHMARK_TEMPLATE(BM_CrossoverInsert, BTreeSortedMap<int, int>)
+    ->Apply(CrossoverSizes);
+BENCHMARK_TEMPLATE(BM_CrossoverInsert, ArraySortedMap<std::string, int>)
+    ->Apply(CrossoverSizes);
+BENCHMARK_TEMPLATE(BM_CrossoverInsert, BTreeSortedMap<std::string, int>)
+    ->Apply(CrossoverSizes);
+
+// Set algebra: pairs of sets of `range(0)` keys that overlap by half, as when
+// the key set of a large target is updated with an equally large change. The
+// ByKey variants apply the same change with the insert and erase loops that
+// Union and Difference replace.
+
+namespace {
+
+using IntSet = SortedSet<int>;
+
+/** Creates a set containing the keys [start, start + size). */
+IntSet SequentialSet(int start, int size) {
+  IntSet::Builder builder;
+  builder.reserve(size);
+  for (int i = start; i < start + size; ++i) {
+    builder.push_back(i);
+  }
+  return builder.Build();
+}
+
+}  // namespace
+
+static void BM_SortedSetUnion(benchmark::State& state) {
+  int size = static_cast<int>(state.range(0));
+  IntSet lhs = SequentialSet(0, size);
+  IntSet rhs = SequentialSet(size / 2, size);
+  for (auto _ : state) {
+    IntSet result = lhs.Union(rhs);
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations() * size * 2);
+}
+BENCHMARK(BM_SortedSetUnion)->Arg(1000)->Arg(50000);
+
+static void BM_SortedSetUnionByKey(benchmark::State& state) {
+  int size = static_cast<int>(state.range(0));
+  IntSet lhs = SequentialSet(0, size);
+  IntSet rhs = SequentialSet(size / 2, size);
+  for (auto _ : state) {
+    IntSet result = lhs;
+    for (int key : rhs) {
+      result = result.insert(key);
+    }
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations() * size * 2);
+}
+BENCHMARK(BM_SortedSetUnionByKey)->Arg(1000)->Arg(50000);
+
+static void BM_SortedSetIntersect(benchmark::State& state) {
+  int size = static_cast<int>(state.range(0));
+  IntSet lhs = SequentialSet(0, size);
+  IntSet rhs = SequentialSet(size / 2, size);
+  for (auto _ : state) {
+    IntSet result = lhs.Intersect(rhs);
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations() * size * 2);
+}
+BENCHMARK(BM_SortedSetIntersect)->Arg(1000)->Arg(50000);
+
+static void BM_SortedSetDifference(benchmark::State& state) {
+  int size = static_cast<int>(state.range(0));
+  IntSet lhs = SequentialSet(0, size);
+  IntSet rhs = SequentialSet(size / 2, size);
+  for (auto _ : state) {
+    IntSet result = lhs.Difference(rhs);
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations() * size * 2);
+}
+BENCHMARK(BM_SortedSetDifference)->Arg(1000)->Arg(50000);
+
+static void BM_SortedSetDifferenceByKey(benchmark::State& state) {
+  int size = static_cast<int>(state.range(0));
+  IntSet lhs = SequentialSet(0, size);
+  IntSet rhs = SequentialSet(size / 2, size);
+  for (auto _ : state) {
+    IntSet result = lhs;
+    for (int key : rhs) {
+      result = result.erase(key);
+    }
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations() * size * 2);
+}
+BENCHMARK(BM_SortedSetDifferenceByKey)->Arg(1000)->Arg(50000);
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#include <unordered_map>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#import "Firestore/Source/Core/FSTQuery.h"
+#import "Firestore/Source/Local/FSTQueryData.h"
+#import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Model/FSTFieldValue.h"
+
+#include "Firestore/core/include/firebase/firestore/timestamp.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
+#include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+using firebase::Timestamp;
+using firebase::firestore::model::DatabaseId;
+using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::DocumentKeySet;
+using firebase::firestore::model::ResourcePath;
+using firebase::firestore::model::SnapshotVersion;
+using firebase::firestore::model::TargetId;
+using firebase::firestore::remote::DocumentWatchChange;
+using firebase::firestore::remote::RemoteEvent;
+using firebase::firestore::remote::TargetMetadataProvider;
+using firebase::firestore::remote::WatchChangeAggregator;
+using firebase::firestore::remote::WatchTargetChange;
+using firebase::firestore::remote::WatchTargetChangeState;
+using firebase::firestore::util::StringFormat;
+
+namespace {
+
+/** Treats every given target as an active listen on "coll" with no previous results. */
+class ActiveTargetsProvider : public TargetMetadataProvider {
+ public:
+  explicit ActiveTargetsProvider(const std::vector<TargetId> &target_ids) {
+    FSTQuery *query = [FSTQuery queryWithPath:ResourcePath{"coll"}];
+    for (TargetId target_id : target_ids) {
+      query_data_[target_id] = [[FSTQueryData alloc] initWithQuery:query
+                                                          targetID:target_id
+                                              listenSequenceNumber:0
+                                                           purpose:FSTQueryPurposeListen];
+    }
+  }
+
+  DocumentKeySet GetRemoteKeysForTarget(TargetId) const override {
+    return DocumentKeySet{};
+  }
+
+  FSTQueryData *GetQueryDataForTarget(TargetId target_id) const override {
+    auto found = query_data_.find(target_id);
+    return found != query_data_.end() ? found->second : nil;
+  }
+
+  const DatabaseId &GetDatabaseId() const override {
+    static DatabaseId database_id{"project", DatabaseId::kDefault};
+    return database_id;
+  }
+
+ private:
+  std::unordered_map<TargetId, FSTQueryData *> query_data_;
+};
+
+}  // namespace
+
+/**
+ * Measures aggregating a snapshot of `range(0)` documents, each of which matches all of
+ * `range(1)` targets, into a RemoteEvent.
+ */
+static void BM_WatchChangeAggregatorSnapshot(benchmark::State &state) {
+  int document_count = static_cast<int>(state.range(0));
+  int target_count = static_cast<int>(state.range(1));
+
+  std::vector<TargetId> target_ids;
+  for (int i = 0; i < target_count; ++i) {
+    target_ids.push_back(i + 1);
+  }
+  ActiveTargetsProvider provider{target_ids};
+
+  std::vector<FSTDocument *> docs;
+  for (int i = 0; i < document_count; ++i) {
+    FSTObjectValue *data =
+        [[FSTObjectValue alloc] initWithDictionary:@{@"value" : [FSTIntegerValue integerValue:i]}];
+    docs.push_back([FSTDocument
+        documentWithData:data
+                     key:DocumentKey::FromPathString(StringFormat("coll/doc%s", i))
+                 version:SnapshotVersion{Timestamp{1, 0}}
+                   state:FSTDocumentStateSynced]);
+  }
+  NSData *resume_token = [@"resume" dataUsingEncoding:NSUTF8StringEncoding];
+
+  for (auto _ : state) {
+    WatchChangeAggregator aggregator{&provider};
+    for (FSTDocument *doc : docs) {
+      aggregator.HandleDocumentChange(DocumentWatchChange{target_ids, {}, doc.key, doc});
+    }
+    aggregator.HandleTargetChange(
+        WatchTargetChange{WatchTargetChangeState::Current, target_ids, resume_token});
+    RemoteEvent event = aggregator.CreateRemoteEvent(SnapshotVersion{Timestamp{2, 0}});
+    benchmark::DoNotOptimize(event);
+  }
+  state.SetItemsProcessed(state.iterations() * document_count * target_count);
+}
+BENCHMARK(BM_WatchChangeAggregatorSnapshot)->Args({100, 1})->Args({1000, 1})->Args({100, 10});
+
+NS_ASSUME_NONNULL_END
@@ -15,6 +15,7 @@
  */
 
 #import <FirebaseFirestore/FIRDocumentSnapshot.h>
+#import <FirebaseFirestore/FIRFieldPath.h>
 
 #import <XCTest/XCTest.h>
 
@@ -54,6 +55,31 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertNotEqual([base hash], [fromCache hash]);
 }
 
+- (void)testConvertsValuesOncePerSnapshot {
+  FIRDocumentSnapshot *snapshot =
+      FSTTestDocSnapshot("rooms/foo", 1, @{@"a" : @{@"b" : @1, @"c" : @[ @2 ]}}, NO, NO);
+  XCTAssertEqualObjects(snapshot[@"a.b"], @1);
+  XCTAssertEqualObjects(snapshot[@"a.c"], @[ @2 ]);
+  XCTAssertNil(snapshot[@"a.d"]);
+  XCTAssertNil(snapshot[@"a.b.c"]);
+
+  XCTAssertEqual(snapshot[@"a"], snapshot[@"a"]);
+  FIRFieldPath *path = [[FIRFieldPath alloc] initWithFields:@[ @"a" ]];
+  XCTAssertEqual(snapshot[@"a"], [snapshot valueForField:path]);
+  XCTAssertEqual(snapshot.data, snapshot.data);
+  XCTAssertEqualObjects(snapshot.data, (@{@"a" : @{@"b" : @1, @"c" : @[ @2 ]}}));
+
+  // Each server timestamp behavior gets conversions of its own.
+  NSDictionary *estimated =
+      [snapshot dataWithServerTimestampBehavior:FIRServerTimestampBehaviorEstimate];
+  XCTAssertEqualObjects(estimated, snapshot.data);
+  XCTAssertNotEqual(estimated, snapshot.data);
+
+  FIRDocumentSnapshot *missing = FSTTestDocSnapshot("rooms/foo", 1, nil, NO, NO);
+  XCTAssertNil(missing.data);
+  XCTAssertNil(missing[@"a"]);
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
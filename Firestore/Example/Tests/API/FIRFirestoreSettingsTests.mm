@@ -0,0 +1,243 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <FirebaseFirestore/FIRFirestoreSettings.h>
+
+#import <XCTest/XCTest.h>
+
+#import "Firestore/Source/API/FIRFirestore+Internal.h"
+
+#include "Firestore/core/src/firebase/firestore/api/settings.h"
+
+using firebase::firestore::api::Settings;
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface FIRFirestoreSettingsTests : XCTestCase
+@end
+
+@implementation FIRFirestoreSettingsTests
+
+- (FIRFirestore *)newFirestore {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wnonnull"
+  return [[FIRFirestore alloc] initWithProjectID:"abc"
+                                        database:"abc"
+                                  persistenceKey:"db123"
+                             credentialsProvider:nullptr
+                                     workerQueue:nullptr
+                                     firebaseApp:nil];
+#pragma clang diagnostic pop
+}
+
+/**
+ * Applies `settings` to a new Firestore instance and returns the settings it would create its
+ * FSTFirestoreClient with.
+ */
+- (Settings)clientSettingsForSettings:(FIRFirestoreSettings *)settings {
+  FIRFirestore *firestore = [self newFirestore];
+  firestore.settings = settings;
+  return firestore.wrapped->settings();
+}
+
+- (void)testChangesToAppliedSettingsAreApplied {
+  FIRFirestore *firestore = [self newFirestore];
+  FIRFirestoreSettings *settings = [[FIRFirestoreSettings alloc] init];
+  firestore.settings = settings;
+
+  settings.groupCommitEnabled = YES;
+  firestore.settings = settings;
+  XCTAssertTrue(firestore.wrapped->settings().group_commit_enabled());
+}
+
+- (void)testGroupCommitReachesClient {
+  FIRFirestoreSettings *settings = [[FIRFirestoreSettings alloc] init];
+  XCTAssertFalse([self clientSettingsForSettings:settings].group_commit_enabled());
+  XCTAssertFalse([self clientSettingsForSettings:settings].sync_writes_enabled());
+
+  settings.groupCommitEnabled = YES;
+  settings.syncWritesEnabled = YES;
+  Settings clientSettings = [self clientSettingsForSettings:settings];
+  XCTAssertTrue(clientSettings.group_commit_enabled());
+  XCTAssertTrue(clientSettings.sync_writes_enabled());
+
+  XCTAssertEqualObjects([settings copy], settings);
+  XCTAssertNotEqualObjects([[FIRFirestoreSettings alloc] init], settings);
+}
+
+- (void)testStorageTuningReachesClient {
+  FIRFirestoreSettings *settings = [[FIRFirestoreSettings alloc] init];
+  Settings clientSettings = [self clientSettingsForSettings:settings];
+  XCTAssertEqual(clientSettings.block_cache_size_bytes(), 0);
+  XCTAssertFalse(clientSettings.bloom_filter_enabled());
+  XCTAssertEqual(clientSettings.write_buffer_size_bytes(), 0);
+  XCTAssertTrue(clientSettings.verify_checksums_enabled());
+
+  settings.blockCacheSizeBytes = 16 * 1024 * 1024;
+  settings.bloomFilterEnabled = YES;
+  settings.writeBufferSizeBytes = 1024 * 1024;
+  settings.verifyChecksumsEnabled = NO;
+  clientSettings = [self clientSettingsForSettings:settings];
+  XCTAssertEqual(clientSettings.block_cache_size_bytes(), 16 * 1024 * 1024);
+  XCTAssertTrue(clientSettings.bloom_filter_enabled());
+  XCTAssertEqual(clientSettings.write_buffer_size_bytes(), 1024 * 1024);
+  XCTAssertFalse(clientSettings.verify_checksums_enabled());
+  XCTAssertEqualObjects([settings copy], settings);
+
+  XCTAssertThrows(settings.blockCacheSizeBytes = -1);
+  XCTAssertThrows(settings.writeBufferSizeBytes = -1);
+}
+
+- (void)testCoalescedWriteSizeReachesClient {
+  FIRFirestoreSettings *settings = [[FIRFirestoreSettings alloc] init];
+  XCTAssertEqual([self clientSettingsForSettings:settings].max_coalesced_write_bytes(), 0);
+
+  settings.maxCoalescedWriteBytes = 64 * 1024;
+  XCTAssertEqual([self clientSettingsForSettings:settings].max_coalesced_write_bytes(), 64 * 1024);
+  XCTAssertThrows(settings.maxCoalescedWriteBytes = -1);
+}
+
+- (void)testMutationCompactionReachesClient {
+  FIRFirestoreSettings *settings = [[FIRFirestoreSettings alloc] init];
+  XCTAssertFalse([self clientSettingsForSettings:settings].mutation_compaction_enabled());
+
+  settings.mutationCompactionEnabled = YES;
+  XCTAssertTrue([self clientSettingsForSettings:settings].mutation_compaction_enabled());
+}
+
+- (void)testCompressionReachesClient {
+  FIRFirestoreSettings *settings = [[FIRFirestoreSettings alloc] init];
+  XCTAssertFalse([self clientSettingsForSettings:settings].compression_enabled());
+
+  settings.compressionEnabled = YES;
+  XCTAssertTrue([self clientSettingsForSettings:settings].compression_enabled());
+}
+
+- (void)testPreconnectReachesClient {
+  FIRFirestoreSettings *settings = [[FIRFirestoreSettings alloc] init];
+  XCTAssertFalse([self clientSettingsForSettings:settings].preconnect_enabled());
+
+  settings.preconnectEnabled = YES;
+  XCTAssertTrue([self clientSettingsForSettings:settings].preconnect_enabled());
+}
+
+- (void)testDeferredMigrationsReachClient {
+  FIRFirestoreSettings *settings = [[FIRFirestoreSettings alloc] init];
+  XCTAssertFalse([self clientSettingsForSettings:settings].deferred_migrations_enabled());
+
+  settings.deferredMigrationsEnabled = YES;
+  XCTAssertTrue([self clientSettingsForSettings:settings].deferred_migrations_enabled());
+}
+
+- (void)testMemoryCacheLRUReachesClient {
+  FIRFirestoreSettings *settings = [[FIRFirestoreSettings alloc] init];
+  XCTAssertFalse([self clientSettingsForSettings:settings].memory_lru_gc_enabled());
+
+  settings.persistenceEnabled = NO;
+  settings.memoryCacheLRUEnabled = YES;
+  Settings clientSettings = [self clientSettingsForSettings:settings];
+  XCTAssertFalse(clientSettings.persistence_enabled());
+  XCTAssertTrue(clientSettings.memory_lru_gc_enabled());
+}
+
+- (void)testSharedResourcesReachClient {
+  FIRFirestoreSettings *settings = [[FIRFirestoreSettings alloc] init];
+  XCTAssertFalse([self clientSettingsForSettings:settings].shared_resources_enabled());
+
+  settings.sharedResourcesEnabled = YES;
+  XCTAssertTrue([self clientSettingsForSettings:settings].shared_resources_enabled());
+}
+
+- (void)testMemorySoftLimitReachesClient {
+  FIRFirestoreSettings *settings = [[FIRFirestoreSettings alloc] init];
+  XCTAssertEqual([self clientSettingsForSettings:settings].memory_soft_limit_bytes(), 0);
+
+  settings.memorySoftLimitBytes = 32 * 1024 * 1024;
+  XCTAssertEqual([self clientSettingsForSettings:settings].memory_soft_limit_bytes(),
+                 32 * 1024 * 1024);
+  XCTAssertThrows(settings.memorySoftLimitBytes = -1);
+}
+
+- (void)testSlowOperationThresholdReachesClient {
+  FIRFirestoreSettings *settings = [[FIRFirestoreSettings alloc] init];
+  XCTAssertEqual([self clientSettingsForSettings:settings].slow_operation_threshold_ms(), 0);
+
+  settings.slowOperationThreshold = 0.25;
+  XCTAssertEqual([self clientSettingsForSettings:settings].slow_operation_threshold_ms(), 250);
+  XCTAssertThrows(settings.slowOperationThreshold = -1);
+}
+
+- (void)testSharedViewsReachClient {
+  FIRFirestoreSettings *settings = [[FIRFirestoreSettings alloc] init];
+  XCTAssertFalse([self clientSettingsForSettings:settings].shared_views_enabled());
+
+  settings.sharedViewsEnabled = YES;
+  XCTAssertTrue([self clientSettingsForSettings:settings].shared_views_enabled());
+
+  // Turning sharing back off must reach the client too, now that it also affects filtered queries.
+  settings.sharedViewsEnabled = NO;
+  XCTAssertFalse([self clientSettingsForSettings:settings].shared_views_enabled());
+}
+
+- (void)testBackgroundWritesReachClient {
+  FIRFirestoreSettings *settings = [[FIRFirestoreSettings alloc] init];
+  XCTAssertFalse([self clientSettingsForSettings:settings].background_writes_enabled());
+
+  settings.groupCommitEnabled = YES;
+  settings.backgroundWritesEnabled = YES;
+  Settings clientSettings = [self clientSettingsForSettings:settings];
+  XCTAssertTrue(clientSettings.group_commit_enabled());
+  XCTAssertTrue(clientSettings.background_writes_enabled());
+}
+
+- (void)testOptimisticWritesReachClient {
+  FIRFirestoreSettings *settings = [[FIRFirestoreSettings alloc] init];
+  XCTAssertFalse([self clientSettingsForSettings:settings].optimistic_writes_enabled());
+
+  settings.optimisticWritesEnabled = YES;
+  XCTAssertTrue([self clientSettingsForSettings:settings].optimistic_writes_enabled());
+}
+
+- (void)testFileTuningReachesClient {
+  FIRFirestoreSettings *settings = [[FIRFirestoreSettings alloc] init];
+  Settings clientSettings = [self clientSettingsForSettings:settings];
+  XCTAssertFalse(clientSettings.mobile_leveldb_env_enabled());
+  XCTAssertEqual(clientSettings.max_table_file_size_bytes(), 0);
+  XCTAssertEqual(clientSettings.max_open_files(), 0);
+
+  settings.mobileStorageTuningEnabled = YES;
+  settings.maxStorageFileSizeBytes = 8 * 1024 * 1024;
+  settings.maxOpenFiles = 200;
+  clientSettings = [self clientSettingsForSettings:settings];
+  XCTAssertTrue(clientSettings.mobile_leveldb_env_enabled());
+  XCTAssertEqual(clientSettings.max_table_file_size_bytes(), 8 * 1024 * 1024);
+  XCTAssertEqual(clientSettings.max_open_files(), 200);
+
+  XCTAssertThrows(settings.maxStorageFileSizeBytes = -1);
+  XCTAssertThrows(settings.maxOpenFiles = -1);
+}
+
+- (void)testMultiProcessPersistenceReachesClient {
+  FIRFirestoreSettings *settings = [[FIRFirestoreSettings alloc] init];
+  XCTAssertFalse([self clientSettingsForSettings:settings].shared_cache_enabled());
+
+  settings.multiProcessPersistenceEnabled = YES;
+  XCTAssertTrue([self clientSettingsForSettings:settings].shared_cache_enabled());
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/cache_warmer.h"
+
+#import <OCMock/OCMock.h>
+#import <XCTest/XCTest.h>
+
+#include <string>
+
+#import "Firestore/Source/Core/FSTEventManager.h"
+#import "Firestore/Source/Core/FSTQuery.h"
+#import "Firestore/Source/Core/FSTSyncEngine.h"
+
+#import "Firestore/Example/Tests/Util/FSTHelpers.h"
+
+#include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/executor_libdispatch.h"
+#include "absl/memory/memory.h"
+#include "absl/types/optional.h"
+
+using firebase::firestore::core::CacheFreshness;
+using firebase::firestore::core::CacheWarmer;
+using firebase::firestore::core::ViewSnapshot;
+using firebase::firestore::model::DocumentKeySet;
+using firebase::firestore::model::DocumentSet;
+using firebase::firestore::util::AsyncQueue;
+using firebase::firestore::util::ExecutorLibdispatch;
+using firebase::firestore::util::TimerId;
+
+NS_ASSUME_NONNULL_BEGIN
+
+// FSTEventManager implements this delegate privately
+@interface FSTEventManager () <FSTSyncEngineDelegate>
+@end
+
+@interface FSTCacheWarmerTests : XCTestCase
+@end
+
+@implementation FSTCacheWarmerTests {
+  std::unique_ptr<AsyncQueue> _queue;
+  FSTSyncEngine *_syncEngineMock;
+  FSTEventManager *_eventManager;
+}
+
+- (void)setUp {
+  [super setUp];
+  _queue = absl::make_unique<AsyncQueue>(absl::make_unique<ExecutorLibdispatch>(
+      dispatch_queue_create("FSTCacheWarmerTests", DISPATCH_QUEUE_SERIAL)));
+  _syncEngineMock = OCMClassMock([FSTSyncEngine class]);
+  _eventManager = [FSTEventManager eventManagerWithSyncEngine:_syncEngineMock];
+}
+
+- (ViewSnapshot)makeEmptyViewSnapshotWithQuery:(FSTQuery *)query fromCache:(bool)fromCache {
+  DocumentSet emptyDocs{query.comparator};
+  return ViewSnapshot{query,     emptyDocs, emptyDocs, {}, DocumentKeySet{},
+                      fromCache, /*sync_state_changed=*/true, false};
+}
+
+- (void)testListensInTheBackgroundAndReportsFreshness {
+  FSTQuery *query = FSTTestQuery("rooms");
+  CacheWarmer warmer{_eventManager, _queue.get()};
+
+  _queue->EnqueueBlocking([&] {
+    XCTAssertFalse(warmer.GetFreshness(query).has_value());
+    warmer.KeepSynced(query);
+  });
+  OCMVerify([_syncEngineMock listenToQuery:query]);
+
+  _queue->EnqueueBlocking([&] {
+    absl::optional<CacheFreshness> freshness = warmer.GetFreshness(query);
+    XCTAssertTrue(freshness.has_value());
+    XCTAssertTrue(freshness->is_listening);
+    XCTAssertFalse(freshness->is_synced);
+    XCTAssertFalse(freshness->last_synced_at.has_value());
+
+    [_eventManager handleViewSnapshots:{[self makeEmptyViewSnapshotWithQuery:query
+                                                                   fromCache:false]}];
+    freshness = warmer.GetFreshness(query);
+    XCTAssertTrue(freshness->is_synced);
+    XCTAssertTrue(freshness->last_synced_at.has_value());
+  });
+}
+
+- (void)testKeepingAQuerySyncedTwiceListensOnce {
+  FSTQuery *query = FSTTestQuery("rooms");
+  CacheWarmer warmer{_eventManager, _queue.get()};
+
+  _queue->EnqueueBlocking([&] {
+    warmer.KeepSynced(query);
+    warmer.KeepSynced(FSTTestQuery("rooms"));
+    XCTAssertEqual(warmer.size(), 1u);
+  });
+}
+
+- (void)testStopsListening {
+  FSTQuery *query = FSTTestQuery("rooms");
+  CacheWarmer warmer{_eventManager, _queue.get()};
+
+  _queue->EnqueueBlocking([&] { warmer.KeepSynced(query); });
+  _queue->EnqueueBlocking([&] {
+    warmer.StopKeepingSynced(query);
+    XCTAssertFalse(warmer.GetFreshness(query).has_value());
+  });
+  OCMVerify([_syncEngineMock stopListeningToQuery:query]);
+
+  // Stopping a query that isn't kept in sync is a no-op.
+  _queue->EnqueueBlocking([&] { warmer.StopKeepingSynced(query); });
+}
+
+- (void)testStartsListensAtALimitedRate {
+  CacheWarmer warmer{_eventManager, _queue.get()};
+
+  // The rate limit lets 5 listens through right away.
+  _queue->EnqueueBlocking([&] {
+    for (int i = 0; i < 6; ++i) {
+      warmer.KeepSynced(FSTTestQuery("rooms/" + std::to_string(i) + "/messages"));
+    }
+  });
+  FSTQuery *last = FSTTestQuery("rooms/5/messages");
+  XCTAssertTrue(_queue->IsScheduled(TimerId::CacheWarmingRateLimit));
+  _queue->EnqueueBlocking([&] { XCTAssertFalse(warmer.GetFreshness(last)->is_listening); });
+
+  _queue->RunScheduledOperationsUntil(TimerId::CacheWarmingRateLimit);
+  _queue->EnqueueBlocking([&] { XCTAssertTrue(warmer.GetFreshness(last)->is_listening); });
+  OCMVerify([_syncEngineMock listenToQuery:last]);
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
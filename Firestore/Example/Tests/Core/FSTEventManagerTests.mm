@@ -16,6 +16,7 @@
 
 #import "Firestore/Source/Core/FSTEventManager.h"
 
+#import <FirebaseFirestore/FIRFirestoreErrors.h>
 #import <OCMock/OCMock.h>
 #import <XCTest/XCTest.h>
 
@@ -35,6 +36,7 @@
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
 #include "Firestore/core/test/firebase/firestore/testutil/xcgmock.h"
 
+using firebase::firestore::core::DocumentViewChange;
 using firebase::firestore::core::EventListener;
 using firebase::firestore::core::ListenOptions;
 using firebase::firestore::core::QueryListener;
@@ -58,6 +60,16 @@ std::shared_ptr<QueryListener> NoopQueryListener(FSTQuery *query) {
   return QueryListener::Create(query, ListenOptions::DefaultOptions(), NoopViewSnapshotHandler());
 }
 
+/** Returns the keys of the given changes together with their types, for easy comparison. */
+NSArray<NSString *> *DescribeChanges(const std::vector<DocumentViewChange> &changes) {
+  NSMutableArray<NSString *> *result = [NSMutableArray array];
+  for (const DocumentViewChange &change : changes) {
+    [result addObject:[NSString stringWithFormat:@"%d %s", static_cast<int>(change.type()),
+                                                 change.document().key.ToString().c_str()]];
+  }
+  return result;
+}
+
 }  // namespace
 
 // FSTEventManager implements this delegate privately
@@ -140,6 +152,143 @@ std::shared_ptr<QueryListener> NoopQueryListener(FSTQuery *query) {
   XCTAssertEqualObjects(eventOrder, expected);
 }
 
+- (void)testDerivesLimitedQueryFromSharedView {
+  FSTQuery *query = FSTTestQuery("rooms");
+  FSTQuery *limited = [query queryBySettingLimit:2];
+  FSTDocument *docA = FSTTestDoc("rooms/a", 1, @{}, FSTDocumentStateSynced);
+  FSTDocument *docB = FSTTestDoc("rooms/b", 1, @{}, FSTDocumentStateSynced);
+  FSTDocument *docC = FSTTestDoc("rooms/c", 1, @{}, FSTDocumentStateSynced);
+  FSTDocument *docD = FSTTestDoc("rooms/d", 1, @{}, FSTDocumentStateSynced);
+
+  auto snapshots = std::make_shared<std::vector<ViewSnapshot>>();
+  auto listener = NoopQueryListener(query);
+  auto limitedListener = QueryListener::Create(
+      limited, [snapshots](StatusOr<ViewSnapshot> maybe_snapshot) {
+        snapshots->push_back(maybe_snapshot.ValueOrDie());
+      });
+
+  FSTSyncEngine *syncEngineMock = OCMStrictClassMock([FSTSyncEngine class]);
+  OCMExpect([syncEngineMock setSyncEngineDelegate:[OCMArg any]]);
+  FSTEventManager *eventManager = [FSTEventManager eventManagerWithSyncEngine:syncEngineMock];
+  eventManager.sharedViewsEnabled = YES;
+
+  // Only the unlimited query gets a target.
+  OCMExpect([syncEngineMock listenToQuery:query]);
+  [eventManager addListener:listener];
+  [eventManager addListener:limitedListener];
+  OCMVerifyAll((id)syncEngineMock);
+
+  DocumentSet oldDocs = FSTTestDocSet(query.comparator, @[ docB, docC, docD ]);
+  [eventManager handleViewSnapshots:{ViewSnapshot::FromInitialDocuments(query, oldDocs,
+                                                                        DocumentKeySet{}, false,
+                                                                        false)}];
+  XCTAssertEqual(snapshots->size(), 1u);
+  XCTAssertEqualObjects(DescribeChanges(snapshots->back().document_changes()),
+                        (@[ @"1 rooms/b", @"1 rooms/c" ]));
+
+  DocumentSet newDocs = FSTTestDocSet(query.comparator, @[ docA, docB, docC, docD ]);
+  DocumentViewChange addA{docA, DocumentViewChange::Type::kAdded};
+  [eventManager handleViewSnapshots:{ViewSnapshot{query, newDocs, oldDocs, {addA}, DocumentKeySet{},
+                                                  false, false, false}}];
+  XCTAssertEqual(snapshots->size(), 2u);
+  XCTAssertTrue(snapshots->back().documents() ==
+                FSTTestDocSet(limited.comparator, @[ docA, docB ]));
+  XCTAssertEqualObjects(DescribeChanges(snapshots->back().document_changes()),
+                        (@[ @"0 rooms/c", @"1 rooms/a" ]));
+
+  // The limited query gets a view of its own once the unlimited one goes away, and its first
+  // snapshot is only raised if it differs from what the listener has already seen.
+  OCMExpect([syncEngineMock stopListeningToQuery:query]);
+  OCMExpect([syncEngineMock listenToQuery:limited]);
+  [eventManager removeListener:listener];
+  OCMVerifyAll((id)syncEngineMock);
+
+  DocumentSet limitedDocs = FSTTestDocSet(limited.comparator, @[ docA, docB ]);
+  [eventManager handleViewSnapshots:{ViewSnapshot::FromInitialDocuments(limited, limitedDocs,
+                                                                        DocumentKeySet{}, false,
+                                                                        false)}];
+  XCTAssertEqual(snapshots->size(), 2u);
+
+  OCMExpect([syncEngineMock stopListeningToQuery:limited]);
+  [eventManager removeListener:limitedListener];
+  OCMVerifyAll((id)syncEngineMock);
+}
+
+- (void)testDerivesFilteredQueryFromSharedView {
+  FSTQuery *query = FSTTestQuery("rooms");
+  FSTQuery *filtered = [[query queryByAddingFilter:FSTTestFilter("open", @"==", @YES)]
+      queryByAddingSortOrder:FSTTestOrderBy("size", @"desc")];
+  FSTDocument *docA = FSTTestDoc("rooms/a", 1, @{@"open" : @YES, @"size" : @1},
+                                 FSTDocumentStateSynced);
+  FSTDocument *docB = FSTTestDoc("rooms/b", 1, @{@"open" : @NO, @"size" : @2},
+                                 FSTDocumentStateSynced);
+  FSTDocument *docC = FSTTestDoc("rooms/c", 1, @{@"open" : @YES, @"size" : @3},
+                                 FSTDocumentStateSynced);
+  FSTDocument *closedC = FSTTestDoc("rooms/c", 2, @{@"open" : @NO, @"size" : @3},
+                                    FSTDocumentStateSynced);
+
+  auto snapshots = std::make_shared<std::vector<ViewSnapshot>>();
+  auto errors = std::make_shared<int>(0);
+  auto listener = NoopQueryListener(query);
+  auto filteredListener = QueryListener::Create(
+      filtered, [snapshots, errors](StatusOr<ViewSnapshot> maybe_snapshot) {
+        if (maybe_snapshot.ok()) {
+          snapshots->push_back(maybe_snapshot.ValueOrDie());
+        } else {
+          ++*errors;
+        }
+      });
+
+  FSTSyncEngine *syncEngineMock = OCMStrictClassMock([FSTSyncEngine class]);
+  OCMExpect([syncEngineMock setSyncEngineDelegate:[OCMArg any]]);
+  FSTEventManager *eventManager = [FSTEventManager eventManagerWithSyncEngine:syncEngineMock];
+  eventManager.sharedViewsEnabled = YES;
+
+  // Only the unfiltered query gets a target.
+  OCMExpect([syncEngineMock listenToQuery:query]);
+  [eventManager addListener:listener];
+  [eventManager addListener:filteredListener];
+  OCMVerifyAll((id)syncEngineMock);
+
+  DocumentSet oldDocs = FSTTestDocSet(query.comparator, @[ docA, docB, docC ]);
+  [eventManager handleViewSnapshots:{ViewSnapshot::FromInitialDocuments(query, oldDocs,
+                                                                        DocumentKeySet{}, false,
+                                                                        false)}];
+  XCTAssertEqual(snapshots->size(), 1u);
+  XCTAssertTrue(snapshots->back().documents() ==
+                FSTTestDocSet(filtered.comparator, @[ docC, docA ]));
+  XCTAssertEqualObjects(DescribeChanges(snapshots->back().document_changes()),
+                        (@[ @"1 rooms/c", @"1 rooms/a" ]));
+
+  DocumentSet newDocs = FSTTestDocSet(query.comparator, @[ docA, docB, closedC ]);
+  DocumentViewChange modifyC{closedC, DocumentViewChange::Type::kModified};
+  [eventManager handleViewSnapshots:{ViewSnapshot{query, newDocs, oldDocs, {modifyC},
+                                                  DocumentKeySet{}, false, false, false}}];
+  XCTAssertEqual(snapshots->size(), 2u);
+  XCTAssertEqualObjects(DescribeChanges(snapshots->back().document_changes()),
+                        (@[ @"0 rooms/c" ]));
+
+  // The filtered query may be allowed where the unfiltered one isn't, so when the unfiltered one
+  // fails, the filtered one gets a target of its own instead of failing with it.
+  OCMExpect([syncEngineMock listenToQuery:filtered]);
+  [eventManager handleError:[NSError errorWithDomain:FIRFirestoreErrorDomain
+                                                code:FIRFirestoreErrorCodePermissionDenied
+                                            userInfo:nil]
+                   forQuery:query];
+  OCMVerifyAll((id)syncEngineMock);
+  XCTAssertEqual(*errors, 0);
+
+  DocumentSet filteredDocs = FSTTestDocSet(filtered.comparator, @[ docA ]);
+  [eventManager handleViewSnapshots:{ViewSnapshot::FromInitialDocuments(filtered, filteredDocs,
+                                                                        DocumentKeySet{}, false,
+                                                                        false)}];
+  XCTAssertEqual(snapshots->size(), 2u);
+
+  OCMExpect([syncEngineMock stopListeningToQuery:filtered]);
+  [eventManager removeListener:filteredListener];
+  OCMVerifyAll((id)syncEngineMock);
+}
+
 - (void)testWillForwardOnlineStateChanges {
   FSTQuery *query = FSTTestQuery("foo/bar");
 
@@ -16,6 +16,7 @@
 
 #import <XCTest/XCTest.h>
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <memory>
 #include <utility>
 #include <vector>
@@ -33,11 +34,13 @@
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/delayed_constructor.h"
 #include "Firestore/core/src/firebase/firestore/util/executor_libdispatch.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
 #include "Firestore/core/test/firebase/firestore/testutil/xcgmock.h"
+#include "absl/memory/memory.h"
 
 using firebase::firestore::FirestoreErrorCode;
 using firebase::firestore::core::AsyncEventListener;
@@ -51,10 +54,12 @@ using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::DocumentSet;
 using firebase::firestore::model::OnlineState;
 using firebase::firestore::remote::TargetChange;
+using firebase::firestore::util::AsyncQueue;
 using firebase::firestore::util::DelayedConstructor;
 using firebase::firestore::util::ExecutorLibdispatch;
 using firebase::firestore::util::Status;
 using firebase::firestore::util::StatusOr;
+using firebase::firestore::util::TimerId;
 using testing::ElementsAre;
 using testing::IsEmpty;
 
@@ -498,6 +503,90 @@ ViewSnapshot::Listener Accumulating(std::vector<ViewSnapshot> *values) {
   XC_ASSERT_THAT(events, ElementsAre(expectedSnap));
 }
 
+- (void)testCoalescesSnapshotsWithinTheCoalescingWindow {
+  std::vector<ViewSnapshot> events;
+
+  FSTQuery *query = FSTTestQuery("rooms");
+  FSTDocument *doc1 = FSTTestDoc("rooms/Eros", 1, @{@"name" : @"Eros"}, FSTDocumentStateSynced);
+  FSTDocument *doc2 = FSTTestDoc("rooms/Hades", 2, @{@"name" : @"Hades"}, FSTDocumentStateSynced);
+  FSTDocument *doc1prime = FSTTestDoc("rooms/Eros", 3, @{@"name" : @"Eros", @"owner" : @"Jonny"},
+                                      FSTDocumentStateSynced);
+  FSTDocument *doc3 = FSTTestDoc("rooms/Zeus", 4, @{@"name" : @"Zeus"}, FSTDocumentStateSynced);
+  FSTDocument *doc4 = FSTTestDoc("rooms/Ares", 5, @{@"name" : @"Ares"}, FSTDocumentStateSynced);
+
+  ListenOptions options =
+      ListenOptions::DefaultOptions().WithSnapshotCoalescingWindow(std::chrono::milliseconds(100));
+  auto listener = QueryListener::Create(query, options, Accumulating(&events));
+
+  AsyncQueue queue{absl::make_unique<ExecutorLibdispatch>(
+      dispatch_queue_create("testCoalescesSnapshots", DISPATCH_QUEUE_SERIAL))};
+  listener->set_worker_queue(&queue);
+
+  FSTView *view = [[FSTView alloc] initWithQuery:query remoteDocuments:DocumentKeySet{}];
+  ViewSnapshot snap1 = FSTTestApplyChanges(view, @[ doc1 ], absl::nullopt).value();
+  ViewSnapshot snap2 = FSTTestApplyChanges(view, @[ doc2 ], absl::nullopt).value();
+  ViewSnapshot snap3 = FSTTestApplyChanges(view, @[ doc1prime ], absl::nullopt).value();
+  ViewSnapshot snap4 = FSTTestApplyChanges(view, @[ doc3 ], absl::nullopt).value();
+  ViewSnapshot snap5 = FSTTestApplyChanges(view, @[ doc4 ], absl::nullopt).value();
+
+  // The initial event is raised right away, and opens a window in which the
+  // following snapshots are merged.
+  queue.EnqueueBlocking([&] {
+    listener->OnViewSnapshot(snap1);
+    listener->OnViewSnapshot(snap2);
+    listener->OnViewSnapshot(snap3);
+    listener->OnViewSnapshot(snap4);
+  });
+  XC_ASSERT_THAT(events, ElementsAre(ExcludingMetadataChanges(snap1)));
+
+  queue.RunScheduledOperationsUntil(TimerId::SnapshotCoalescing);
+  DocumentViewChange change1{doc2, DocumentViewChange::Type::kAdded};
+  DocumentViewChange change2{doc3, DocumentViewChange::Type::kAdded};
+  DocumentViewChange change3{doc1prime, DocumentViewChange::Type::kModified};
+  ViewSnapshot expectedSnap{query,
+                            /*documents=*/snap4.documents(),
+                            /*old_documents=*/snap2.old_documents(),
+                            /*document_changes=*/{change1, change2, change3},
+                            snap4.mutated_keys(),
+                            /*from_cache=*/true,
+                            /*sync_state_changed=*/false,
+                            /*excludes_metadata_changes=*/true};
+  XC_ASSERT_THAT(events, ElementsAre(ExcludingMetadataChanges(snap1), expectedSnap));
+
+  // Raising the merged event opened another window, which ends without any
+  // new snapshots, so the next snapshot is raised right away.
+  queue.RunScheduledOperationsUntil(TimerId::SnapshotCoalescing);
+  queue.EnqueueBlocking([&] { listener->OnViewSnapshot(snap5); });
+  XC_ASSERT_THAT(events, ElementsAre(ExcludingMetadataChanges(snap1), expectedSnap,
+                                     ExcludingMetadataChanges(snap5)));
+}
+
+- (void)testChangesOnlyListenerDropsDocumentSets {
+  std::vector<ViewSnapshot> events;
+
+  FSTQuery *query = FSTTestQuery("rooms");
+  FSTDocument *doc1 = FSTTestDoc("rooms/Eros", 1, @{@"name" : @"Eros"}, FSTDocumentStateSynced);
+  FSTDocument *doc2 = FSTTestDoc("rooms/Hades", 2, @{@"name" : @"Hades"}, FSTDocumentStateSynced);
+
+  ListenOptions options = ListenOptions::DefaultOptions().WithChangesOnly(true);
+  auto listener = QueryListener::Create(query, options, Accumulating(&events));
+
+  FSTView *view = [[FSTView alloc] initWithQuery:query remoteDocuments:DocumentKeySet{}];
+  ViewSnapshot snap1 = FSTTestApplyChanges(view, @[ doc1 ], absl::nullopt).value();
+  ViewSnapshot snap2 = FSTTestApplyChanges(view, @[ doc2 ], absl::nullopt).value();
+
+  listener->OnViewSnapshot(snap1);
+  listener->OnViewSnapshot(snap2);
+
+  XC_ASSERT_THAT(events, ElementsAre(ExcludingMetadataChanges(snap1).WithoutDocuments(),
+                                     ExcludingMetadataChanges(snap2).WithoutDocuments()));
+  XCTAssertTrue(events[1].changes_only());
+  XCTAssertTrue(events[1].documents().empty());
+  XCTAssertTrue(events[1].old_documents().empty());
+  XC_ASSERT_THAT(events[1].document_changes(),
+                 ElementsAre(DocumentViewChange{doc2, DocumentViewChange::Type::kAdded}));
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
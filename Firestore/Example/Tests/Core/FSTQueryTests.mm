@@ -24,6 +24,7 @@
 #import "Firestore/Example/Tests/Util/FSTHelpers.h"
 
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/field_mask.h"
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
@@ -33,6 +34,7 @@
 namespace testutil = firebase::firestore::testutil;
 namespace util = firebase::firestore::util;
 using firebase::firestore::model::DatabaseId;
+using firebase::firestore::model::FieldMask;
 using firebase::firestore::model::FieldPath;
 using firebase::firestore::model::ResourcePath;
 
@@ -158,6 +160,46 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertFalse([query2 matchesDocument:doc6]);
 }
 
+- (void)testMatchesMixedNumbersAndStringsForFilters {
+  FSTQuery *integerQuery =
+      [FSTTestQuery("collection") queryByAddingFilter:FSTTestFilter("sort", @">", @(2))];
+  FSTQuery *doubleQuery =
+      [FSTTestQuery("collection") queryByAddingFilter:FSTTestFilter("sort", @"<", @(2.5))];
+  FSTQuery *stringQuery =
+      [FSTTestQuery("collection") queryByAddingFilter:FSTTestFilter("sort", @">=", @"b")];
+  FSTQuery *rangeQuery = [[FSTTestQuery("collection")
+      queryByAddingFilter:FSTTestFilter("sort", @">", @(1))]
+      queryByAddingFilter:FSTTestFilter("sort", @"<=", @(3))];
+
+  FSTDocument *doc1 = FSTTestDoc("collection/1", 0, @{@"sort" : @1}, FSTDocumentStateSynced);
+  FSTDocument *doc2 = FSTTestDoc("collection/2", 0, @{@"sort" : @2.5}, FSTDocumentStateSynced);
+  FSTDocument *doc3 = FSTTestDoc("collection/3", 0, @{@"sort" : @3}, FSTDocumentStateSynced);
+  FSTDocument *doc4 = FSTTestDoc("collection/4", 0, @{@"sort" : @"a"}, FSTDocumentStateSynced);
+  FSTDocument *doc5 = FSTTestDoc("collection/5", 0, @{@"sort" : @"b"}, FSTDocumentStateSynced);
+  FSTDocument *doc6 = FSTTestDoc("collection/6", 0, @{@"sort" : @(NAN)}, FSTDocumentStateSynced);
+
+  XCTAssertFalse([integerQuery matchesDocument:doc1]);
+  XCTAssertTrue([integerQuery matchesDocument:doc2]);
+  XCTAssertTrue([integerQuery matchesDocument:doc3]);
+  XCTAssertFalse([integerQuery matchesDocument:doc5]);
+  XCTAssertFalse([integerQuery matchesDocument:doc6]);
+
+  XCTAssertTrue([doubleQuery matchesDocument:doc1]);
+  XCTAssertFalse([doubleQuery matchesDocument:doc2]);
+  XCTAssertFalse([doubleQuery matchesDocument:doc3]);
+  XCTAssertFalse([doubleQuery matchesDocument:doc4]);
+  XCTAssertTrue([doubleQuery matchesDocument:doc6]);
+
+  XCTAssertFalse([stringQuery matchesDocument:doc3]);
+  XCTAssertFalse([stringQuery matchesDocument:doc4]);
+  XCTAssertTrue([stringQuery matchesDocument:doc5]);
+
+  XCTAssertFalse([rangeQuery matchesDocument:doc1]);
+  XCTAssertTrue([rangeQuery matchesDocument:doc2]);
+  XCTAssertTrue([rangeQuery matchesDocument:doc3]);
+  XCTAssertFalse([rangeQuery matchesDocument:doc4]);
+}
+
 - (void)testArrayContainsFilter {
   FSTQuery *query = [FSTTestQuery("collection")
       queryByAddingFilter:FSTTestFilter("array", @"array_contains", @42)];
@@ -441,6 +483,25 @@ NS_ASSUME_NONNULL_BEGIN
   [self assertCorrectComparisonsWithArray:docs comparator:query.comparator];
 }
 
+- (void)testComparatorsLookFieldsUpOncePerDocument {
+  FSTQuery *ascending = [FSTTestQuery("collection") queryByAddingSortBy:"sort" ascending:YES];
+  FSTQuery *descending = [FSTTestQuery("collection") queryByAddingSortBy:"sort" ascending:NO];
+  FSTDocument *doc1 = FSTTestDoc("collection/1", 0, @{@"sort" : @2}, FSTDocumentStateSynced);
+  FSTDocument *doc2 = FSTTestDoc("collection/2", 0, @{@"sort" : @1}, FSTDocumentStateSynced);
+
+  NSComparator comparator = ascending.comparator;
+  XCTAssertEqual(comparator(doc1, doc2), NSOrderedDescending);
+  XCTAssertEqualObjects([doc1 sortValuesForOrdering:ascending.sortOrders],
+                        (@[ FSTTestFieldValue(@2), [NSNull null] ]));
+
+  // Documents compared by another query get values for its ordering instead, and comparing them
+  // again by the first query still gives the same result.
+  XCTAssertEqual(descending.comparator(doc1, doc2), NSOrderedAscending);
+  XCTAssertNil([doc1 sortValuesForOrdering:ascending.sortOrders]);
+  XCTAssertEqual(comparator(doc1, doc2), NSOrderedDescending);
+  XCTAssertEqual(comparator(doc2, doc1), NSOrderedAscending);
+}
+
 - (void)testEquality {
   FSTQuery *q11 = FSTTestQuery("foo");
   q11 = [q11 queryByAddingFilter:FSTTestFilter("i1", @"<", @(2))];
@@ -506,6 +567,91 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertNotEqualObjects(q51, q61);
 }
 
+- (void)testHashesDistinguishQueriesThatDifferInTheMiddle {
+  // Long canonical IDs that only differ in a middle filter should not collide.
+  FSTQuery *base = FSTTestQuery("rooms/eros/messages/some-long-document-id/replies");
+  FSTQuery *q1 = [base queryByAddingFilter:FSTTestFilter("author", @"==", @"alice")];
+  FSTQuery *q2 = [base queryByAddingFilter:FSTTestFilter("author", @"==", @"bobby")];
+  q1 = [q1 queryByAddingSortBy:"timestamp" ascending:YES];
+  q2 = [q2 queryByAddingSortBy:"timestamp" ascending:YES];
+
+  XCTAssertNotEqual(q1.hash, q2.hash);
+  XCTAssertNotEqualObjects(q1, q2);
+
+  FSTQuery *q1Copy = [base queryByAddingFilter:FSTTestFilter("author", @"==", @"alice")];
+  q1Copy = [q1Copy queryByAddingSortBy:"timestamp" ascending:YES];
+  XCTAssertEqual(q1.hash, q1Copy.hash);
+  XCTAssertEqualObjects(q1, q1Copy);
+}
+
+- (void)testProjectionIsPartOfQueryIdentity {
+  FSTQuery *base = FSTTestQuery("foo");
+  FSTQuery *q1 = [base queryBySelectingFields:FieldMask{testutil::Field("a")}];
+  FSTQuery *q2 = [base queryBySelectingFields:FieldMask{testutil::Field("a")}];
+  FSTQuery *q3 =
+      [base queryBySelectingFields:FieldMask{testutil::Field("a"), testutil::Field("b")}];
+
+  XCTAssertTrue(base.projection == nullptr);
+  XCTAssertTrue(*q1.projection == FieldMask{testutil::Field("a")});
+
+  XCTAssertEqualObjects(q1, q2);
+  XCTAssertEqualObjects(q1.canonicalID, q2.canonicalID);
+  XCTAssertNotEqualObjects(base, q1);
+  XCTAssertNotEqualObjects(base.canonicalID, q1.canonicalID);
+  XCTAssertNotEqualObjects(q1, q3);
+  XCTAssertNotEqualObjects(q1.canonicalID, q3.canonicalID);
+
+  // Refining a query keeps its projection.
+  FSTQuery *limited = [q1 queryBySettingLimit:10];
+  XCTAssertTrue(*limited.projection == *q1.projection);
+}
+
+- (void)testLimitedPrefixOfQuery {
+  FSTQuery *base = [FSTTestQuery("rooms") queryByAddingSortBy:"sort" ascending:YES];
+  FSTQuery *limit2 = [base queryBySettingLimit:2];
+  FSTQuery *limit5 = [base queryBySettingLimit:5];
+
+  XCTAssertTrue([limit2 isLimitedPrefixOfQuery:base]);
+  XCTAssertTrue([limit2 isLimitedPrefixOfQuery:limit5]);
+  XCTAssertTrue([limit2 isLimitedPrefixOfQuery:limit2]);
+  XCTAssertFalse([limit5 isLimitedPrefixOfQuery:limit2]);
+  XCTAssertFalse([base isLimitedPrefixOfQuery:limit5]);
+  XCTAssertFalse([base isLimitedPrefixOfQuery:base]);
+
+  // Any other difference between the queries changes which documents come first.
+  FSTQuery *descending = [[FSTTestQuery("rooms") queryByAddingSortBy:"sort" ascending:NO]
+      queryBySettingLimit:2];
+  XCTAssertFalse([descending isLimitedPrefixOfQuery:base]);
+  FSTQuery *filtered = [[base queryByAddingFilter:FSTTestFilter("a", @"==", @1)]
+      queryBySettingLimit:2];
+  XCTAssertFalse([filtered isLimitedPrefixOfQuery:base]);
+  FSTQuery *otherPath = [FSTTestQuery("other") queryByAddingSortBy:"sort" ascending:YES];
+  XCTAssertFalse([limit2 isLimitedPrefixOfQuery:otherPath]);
+}
+
+- (void)testMatchedSubsetOfQuery {
+  FSTQuery *base = FSTTestQuery("rooms");
+  FSTQuery *filtered = [base queryByAddingFilter:FSTTestFilter("a", @"==", @1)];
+  FSTQuery *sorted = [base queryByAddingSortBy:"sort" ascending:NO];
+  FSTQuery *limited = [sorted queryBySettingLimit:2];
+
+  XCTAssertTrue([filtered isMatchedSubsetOfQuery:base]);
+  XCTAssertTrue([sorted isMatchedSubsetOfQuery:base]);
+  XCTAssertTrue([limited isMatchedSubsetOfQuery:base]);
+  XCTAssertTrue([base isMatchedSubsetOfQuery:[base queryByAddingSortBy:"__name__" ascending:NO]]);
+
+  // The other query has to return every document in the collection.
+  XCTAssertFalse([filtered isMatchedSubsetOfQuery:sorted]);
+  XCTAssertFalse([limited isMatchedSubsetOfQuery:[base queryBySettingLimit:10]]);
+  XCTAssertFalse([base isMatchedSubsetOfQuery:filtered]);
+  XCTAssertFalse([filtered isMatchedSubsetOfQuery:FSTTestQuery("other")]);
+  XCTAssertFalse([filtered isMatchedSubsetOfQuery:[base queryBySelectingFields:FieldMask{
+                                                           testutil::Field("a")}]]);
+  XCTAssertFalse([[filtered queryBySelectingFields:FieldMask{testutil::Field("a")}]
+      isMatchedSubsetOfQuery:base]);
+  XCTAssertFalse([FSTTestQuery("rooms/a") isMatchedSubsetOfQuery:FSTTestQuery("rooms/a")]);
+}
+
 - (void)testUniqueIds {
   FSTQuery *q11 = FSTTestQuery("foo");
   q11 = [q11 queryByAddingFilter:FSTTestFilter("i1", @"<", @(2))];
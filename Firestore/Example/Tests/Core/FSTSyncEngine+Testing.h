@@ -17,6 +17,7 @@
 #import <Foundation/Foundation.h>
 
 #include <map>
+#include <vector>
 
 #import "Firestore/Source/Core/FSTSyncEngine.h"
 
@@ -30,6 +31,12 @@ NS_ASSUME_NONNULL_BEGIN
 - (std::map<firebase::firestore::model::DocumentKey, firebase::firestore::model::TargetId>)
     currentLimboDocuments;
 
+/**
+ * Returns the keys of the limbo documents waiting for a limbo resolution to free up, in the order
+ * they will be resolved.
+ */
+- (std::vector<firebase::firestore::model::DocumentKey>)enqueuedLimboDocuments;
+
 @end
 
 NS_ASSUME_NONNULL_END
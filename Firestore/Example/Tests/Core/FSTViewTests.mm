@@ -32,6 +32,7 @@
 #include "Firestore/core/src/firebase/firestore/core/filter.h"
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/model/field_mask.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 #include "Firestore/core/test/firebase/firestore/testutil/xcgmock.h"
@@ -44,6 +45,7 @@ using firebase::firestore::core::ViewSnapshot;
 using firebase::firestore::model::ResourcePath;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::DocumentSet;
+using firebase::firestore::model::FieldMask;
 using testing::ElementsAre;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -110,6 +112,83 @@ inline ContainsDocsMatcherP<std::vector<FSTDocument *>> ContainsDocs(
   XCTAssertTrue(snapshot.sync_state_changed());
 }
 
+- (void)testTrimsDocumentsToTheProjectionAndOrderByFields {
+  FSTQuery *query = [self queryForMessages];
+  query = [query queryByAddingSortOrder:[FSTSortOrder sortOrderWithFieldPath:testutil::Field("sort")
+                                                                   ascending:YES]];
+  query = [query queryBySelectingFields:FieldMask{testutil::Field("text")}];
+  FSTView *view = [[FSTView alloc] initWithQuery:query remoteDocuments:DocumentKeySet{}];
+
+  FSTDocument *doc1 =
+      FSTTestDoc("rooms/eros/messages/1", 0,
+                 @{@"text" : @"msg1", @"sort" : @1, @"author" : @"alice"}, FSTDocumentStateSynced);
+
+  absl::optional<ViewSnapshot> maybe_snapshot =
+      FSTTestApplyChanges(view, @[ doc1 ], FSTTestTargetChangeAckDocuments({doc1.key}));
+  XCTAssertTrue(maybe_snapshot.has_value());
+  ViewSnapshot snapshot = std::move(maybe_snapshot).value();
+
+  FSTDocument *expected =
+      FSTTestDoc("rooms/eros/messages/1", 0, @{@"text" : @"msg1", @"sort" : @1},
+                 FSTDocumentStateSynced);
+  XC_ASSERT_THAT(snapshot.documents(), ElementsAre(expected));
+}
+
+- (void)testProjectedAndUnprojectedViewsShareDocuments {
+  FSTQuery *query = [self queryForMessages];
+  FSTQuery *projected = [query queryBySelectingFields:FieldMask{testutil::Field("text")}];
+  FSTView *view = [[FSTView alloc] initWithQuery:query remoteDocuments:DocumentKeySet{}];
+  FSTView *projectedView = [[FSTView alloc] initWithQuery:projected
+                                          remoteDocuments:DocumentKeySet{}];
+
+  // The same documents, as the remote document cache hands them to every view.
+  FSTDocument *doc1 =
+      FSTTestDoc("rooms/eros/messages/1", 0, @{@"text" : @"msg1", @"author" : @"alice"},
+                 FSTDocumentStateSynced);
+  FSTDocument *doc2 =
+      FSTTestDoc("rooms/eros/messages/2", 0, @{@"text" : @"msg2", @"author" : @"bob"},
+                 FSTDocumentStateSynced);
+
+  absl::optional<ViewSnapshot> projectedSnapshot = FSTTestApplyChanges(
+      projectedView, @[ doc1, doc2 ], FSTTestTargetChangeAckDocuments({doc1.key, doc2.key}));
+  absl::optional<ViewSnapshot> snapshot = FSTTestApplyChanges(
+      view, @[ doc1, doc2 ], FSTTestTargetChangeAckDocuments({doc1.key, doc2.key}));
+  XCTAssertTrue(projectedSnapshot.has_value());
+  XCTAssertTrue(snapshot.has_value());
+
+  FSTDocument *trimmed1 =
+      FSTTestDoc("rooms/eros/messages/1", 0, @{@"text" : @"msg1"}, FSTDocumentStateSynced);
+  FSTDocument *trimmed2 =
+      FSTTestDoc("rooms/eros/messages/2", 0, @{@"text" : @"msg2"}, FSTDocumentStateSynced);
+  XC_ASSERT_THAT(projectedSnapshot->documents(), ElementsAre(trimmed1, trimmed2));
+
+  // Trimming copies the documents, so the unprojected view still sees all of their fields.
+  XC_ASSERT_THAT(snapshot->documents(), ElementsAre(doc1, doc2));
+  XCTAssertEqualObjects([doc1 fieldForPath:testutil::Field("author")], FSTTestFieldValue(@"alice"));
+}
+
+- (void)testProjectedViewsFilterOnAllFields {
+  FSTQuery *query = [[self queryForMessages]
+      queryByAddingFilter:FSTTestFilter("author", @"==", @"alice")];
+  query = [query queryBySelectingFields:FieldMask{testutil::Field("text")}];
+  FSTView *view = [[FSTView alloc] initWithQuery:query remoteDocuments:DocumentKeySet{}];
+
+  FSTDocument *doc1 =
+      FSTTestDoc("rooms/eros/messages/1", 0, @{@"text" : @"msg1", @"author" : @"alice"},
+                 FSTDocumentStateSynced);
+  FSTDocument *doc2 =
+      FSTTestDoc("rooms/eros/messages/2", 0, @{@"text" : @"msg2", @"author" : @"bob"},
+                 FSTDocumentStateSynced);
+
+  absl::optional<ViewSnapshot> snapshot =
+      FSTTestApplyChanges(view, @[ doc1, doc2 ], FSTTestTargetChangeAckDocuments({doc1.key}));
+  XCTAssertTrue(snapshot.has_value());
+
+  FSTDocument *trimmed1 =
+      FSTTestDoc("rooms/eros/messages/1", 0, @{@"text" : @"msg1"}, FSTDocumentStateSynced);
+  XC_ASSERT_THAT(snapshot->documents(), ElementsAre(trimmed1));
+}
+
 - (void)testRemovesDocuments {
   FSTQuery *query = [self queryForMessages];
   FSTView *view = [[FSTView alloc] initWithQuery:query remoteDocuments:DocumentKeySet{}];
@@ -18,10 +18,24 @@
 
 #import <XCTest/XCTest.h>
 
+#include <vector>
+
 #import "Firestore/Example/Tests/Util/FSTIntegrationTestCase.h"
+#import "Firestore/Source/API/FIRDocumentSnapshot+Internal.h"
 #import "Firestore/Source/API/FIRFirestore+Internal.h"
 #import "Firestore/Source/Core/FSTFirestoreClient.h"
 
+#include "Firestore/core/src/firebase/firestore/api/document_reference.h"
+#include "Firestore/core/src/firebase/firestore/api/document_snapshot.h"
+#include "Firestore/core/src/firebase/firestore/api/firestore.h"
+#include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+
+using firebase::firestore::api::DocumentReference;
+using firebase::firestore::api::DocumentSnapshot;
+using firebase::firestore::api::Source;
+using firebase::firestore::util::MakeString;
+using firebase::firestore::util::StatusOr;
+
 @interface FIRFirestoreSourceTests : FSTIntegrationTestCase
 @end
 
@@ -43,6 +57,63 @@
   XCTAssertEqualObjects(result.data, initialData);
 }
 
+- (NSArray<FIRDocumentSnapshot *> *)getAllDocuments:(NSArray<FIRDocumentReference *> *)docs
+                                             source:(Source)source {
+  std::vector<DocumentReference> references;
+  for (FIRDocumentReference *doc in docs) {
+    references.push_back(self.db.wrapped->GetDocument(MakeString(doc.path)));
+  }
+
+  NSMutableArray<FIRDocumentSnapshot *> *result = [NSMutableArray array];
+  XCTestExpectation *completed = [self expectationWithDescription:@"getAll completed"];
+  self.db.wrapped->GetAll(std::move(references), source,
+                          [&](StatusOr<std::vector<DocumentSnapshot>> maybe_snapshots) {
+                            XCTAssertTrue(maybe_snapshots.ok());
+                            if (maybe_snapshots.ok()) {
+                              for (DocumentSnapshot &snapshot : maybe_snapshots.ValueOrDie()) {
+                                [result addObject:[[FIRDocumentSnapshot alloc]
+                                                      initWithSnapshot:std::move(snapshot)]];
+                              }
+                            }
+                            [completed fulfill];
+                          });
+  [self awaitExpectations];
+  return result;
+}
+
+- (void)testGetAllDocumentsWhileOnlineWithDefaultSource {
+  FIRCollectionReference *col = [self collectionRef];
+  [self writeAllDocuments:@{@"doc1" : @{@"key1" : @"value1"}, @"doc2" : @{@"key2" : @"value2"}}
+             toCollection:col];
+
+  NSArray<FIRDocumentReference *> *docs = @[
+    [col documentWithPath:@"doc2"], [col documentWithPath:@"missing"],
+    [col documentWithPath:@"doc1"]
+  ];
+  NSArray<FIRDocumentSnapshot *> *result = [self getAllDocuments:docs source:Source::Default];
+
+  XCTAssertEqual(result.count, 3);
+  XCTAssertEqualObjects(result[0].documentID, @"doc2");
+  XCTAssertEqualObjects(result[0].data, @{@"key2" : @"value2"});
+  XCTAssertFalse(result[0].metadata.fromCache);
+  XCTAssertFalse(result[1].exists);
+  XCTAssertEqualObjects(result[2].documentID, @"doc1");
+  XCTAssertEqualObjects(result[2].data, @{@"key1" : @"value1"});
+}
+
+- (void)testGetAllDocumentsWhileOfflineWithDefaultSource {
+  FIRDocumentReference *doc = [self documentRef];
+  [self writeDocumentRef:doc data:@{@"key" : @"value"}];
+  [self readDocumentForRef:doc];
+  [self disableNetwork];
+
+  NSArray<FIRDocumentSnapshot *> *result = [self getAllDocuments:@[ doc ] source:Source::Default];
+
+  XCTAssertEqual(result.count, 1);
+  XCTAssertTrue(result[0].metadata.fromCache);
+  XCTAssertEqualObjects(result[0].data, @{@"key" : @"value"});
+}
+
 - (void)testGetCollectionWhileOnlineWithDefaultSource {
   FIRCollectionReference *col = [self collectionRef];
 
@@ -26,6 +26,33 @@
 
 @implementation FIRQueryTests
 
+- (void)testPaginatorDeliversPagesInOrder {
+  FIRCollectionReference *collRef = [self collectionRefWithDocuments:@{
+    @"a" : @{@"k" : @"a"},
+    @"b" : @{@"k" : @"b"},
+    @"c" : @{@"k" : @"c"},
+    @"d" : @{@"k" : @"d"},
+    @"e" : @{@"k" : @"e"}
+  }];
+  FIRQueryPaginator *paginator =
+      [[FIRQueryPaginator alloc] initWithQuery:[collRef queryOrderedByField:@"k"] pageSize:2];
+
+  NSMutableArray<NSArray<NSString *> *> *pages = [NSMutableArray array];
+  while (paginator.hasNextPage) {
+    XCTestExpectation *delivered = [self expectationWithDescription:@"page delivered"];
+    [paginator getNextPageWithCompletion:^(FIRQuerySnapshot *page, NSError *error) {
+      XCTAssertNil(error);
+      if (page) {
+        [pages addObject:FIRQuerySnapshotGetIDs(page)];
+      }
+      [delivered fulfill];
+    }];
+    [self awaitExpectations];
+  }
+
+  XCTAssertEqualObjects(pages, (@[ @[ @"a", @"b" ], @[ @"c", @"d" ], @[ @"e" ] ]));
+}
+
 - (void)testLimitQueries {
   FIRCollectionReference *collRef = [self collectionRefWithDocuments:@{
     @"a" : @{@"k" : @"a"},
@@ -378,7 +378,7 @@
   [self awaitExpectations];
 }
 
-- (void)testReadingADocTwiceWithDifferentVersions {
+- (void)testReadingADocTwiceReturnsTheFirstVersion {
   FIRFirestore *firestore = [self firestore];
   FIRDocumentReference *doc = [[firestore collectionWithPath:@"counters"] documentWithAutoID];
   [self writeDocumentRef:doc data:@{@"count" : @(15.0)}];
@@ -399,13 +399,13 @@
             }];
         // We can block on it, because transactions run on a background queue.
         dispatch_semaphore_wait(writeSemaphore, DISPATCH_TIME_FOREVER);
-        // Get the doc again in the transaction with the new version.
+        // Get the doc again in the transaction. It's served from the transaction's read cache, so
+        // it still has the version read first rather than the newer one.
         snapshot = [transaction getDocument:doc error:error];
-        // The get itself will fail, because we already read an earlier version of this document.
-        // TODO(klimt): Perhaps we shouldn't fail reads for this, but should wait and fail the
-        // whole transaction? It's an edge-case anyway, as developers shouldn't be reading the same
-        // doc multiple times. But they need to handle read errors anyway.
-        XCTAssertNotNil(*error);
+        XCTAssertNil(*error);
+        XCTAssertEqualObjects(@(15), snapshot[@"count"]);
+        // Abort the transaction so that it isn't retried with the write above.
+        *error = [NSError errorWithDomain:NSCocoaErrorDomain code:35 userInfo:@{}];
         return nil;
       }
       completion:^(id _Nullable result, NSError *_Nullable error) {
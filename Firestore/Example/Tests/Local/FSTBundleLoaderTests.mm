@@ -0,0 +1,210 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "Firestore/Source/Local/FSTBundleLoader.h"
+
+#import <XCTest/XCTest.h>
+
+#include <string>
+#include <vector>
+
+#import "Firestore/Protos/objc/firestore/local/MaybeDocument.pbobjc.h"
+#import "Firestore/Protos/objc/firestore/local/Target.pbobjc.h"
+#import "Firestore/Source/Core/FSTQuery.h"
+#import "Firestore/Source/Local/FSTLevelDB.h"
+#import "Firestore/Source/Local/FSTLocalSerializer.h"
+#import "Firestore/Source/Local/FSTLocalStore.h"
+#import "Firestore/Source/Local/FSTQueryData.h"
+#import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Remote/FSTSerializerBeta.h"
+
+#import "Firestore/Example/Tests/Local/FSTPersistenceTestHelpers.h"
+#import "Firestore/Example/Tests/Util/FSTHelpers.h"
+
+#include "Firestore/core/src/firebase/firestore/auth/user.h"
+#include "Firestore/core/src/firebase/firestore/local/bundle.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/util/filesystem.h"
+#include "Firestore/core/src/firebase/firestore/util/path.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/string_view.h"
+
+namespace testutil = firebase::firestore::testutil;
+namespace util = firebase::firestore::util;
+using firebase::firestore::auth::User;
+using firebase::firestore::local::BundleWriter;
+using firebase::firestore::model::DatabaseId;
+using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::DocumentMap;
+using firebase::firestore::model::MaybeDocumentMap;
+using firebase::firestore::util::Path;
+using firebase::firestore::util::Status;
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface FSTBundleLoaderTests : XCTestCase
+@end
+
+@implementation FSTBundleLoaderTests {
+  DatabaseId _databaseId;
+  FSTLevelDB *_persistence;
+  FSTLocalSerializer *_serializer;
+  FSTLocalStore *_localStore;
+}
+
+- (void)setUp {
+  [super setUp];
+  // Must match the database of the serializer FSTPersistenceTestHelpers opens LevelDB with.
+  _databaseId = DatabaseId("p", "d");
+  FSTSerializerBeta *remoteSerializer = [[FSTSerializerBeta alloc] initWithDatabaseID:&_databaseId];
+  _serializer = [[FSTLocalSerializer alloc] initWithRemoteSerializer:remoteSerializer];
+
+  _persistence = [FSTPersistenceTestHelpers levelDBPersistence];
+  _localStore = [[FSTLocalStore alloc] initWithPersistence:_persistence
+                                               initialUser:User::Unauthenticated()];
+  [_localStore start];
+}
+
+- (void)tearDown {
+  [_persistence shutdown];
+  [super tearDown];
+}
+
+- (FSTBundleLoader *)loader {
+  return [[FSTBundleLoader alloc] initWithLocalStore:_localStore serializer:_serializer];
+}
+
+- (void)addDocument:(FSTMaybeDocument *)document toWriter:(BundleWriter *)writer {
+  writer->AddDocument([_serializer encodedMaybeDocumentBytes:document]);
+}
+
+- (void)addQuery:(FSTQuery *)query
+           named:(const std::string &)name
+         version:(FSTTestSnapshotVersion)version
+    matchingKeys:(const std::vector<DocumentKey> &)keys
+        toWriter:(BundleWriter *)writer {
+  FSTQueryData *queryData =
+      [[FSTQueryData alloc] initWithQuery:query
+                                 targetID:1
+                     listenSequenceNumber:0
+                                  purpose:FSTQueryPurposeListen
+                          snapshotVersion:testutil::Version(version)
+                              resumeToken:FSTTestResumeTokenFromSnapshotVersion(version)];
+  NSData *target = [[_serializer encodedQueryData:queryData] data];
+  writer->AddQuery(name, absl::string_view(static_cast<const char *>(target.bytes), target.length),
+                   keys);
+}
+
+- (void)testLoadsDocumentsAndNamedQueries {
+  FSTQuery *query = FSTTestQuery("coll");
+  FSTDocument *doc1 = FSTTestDoc("coll/a", 1, @{@"n" : @1}, FSTDocumentStateSynced);
+  FSTDocument *doc2 = FSTTestDoc("coll/b", 2, @{@"n" : @2}, FSTDocumentStateSynced);
+
+  BundleWriter writer;
+  [self addDocument:doc1 toWriter:&writer];
+  [self addDocument:doc2 toWriter:&writer];
+  [self addQuery:query named:"all" version:2 matchingKeys:{doc1.key, doc2.key} toWriter:&writer];
+
+  FSTBundleLoader *loader = [self loader];
+  Status status = [loader loadBundle:writer.bundle()];
+  XCTAssertTrue(status.ok(), @"%s", status.ToString().c_str());
+
+  const MaybeDocumentMap &changed = [loader changedDocuments];
+  XCTAssertEqual(changed.size(), 2);
+  XCTAssertEqualObjects([_localStore readDocument:doc1.key], doc1);
+  XCTAssertEqualObjects([_localStore readDocument:doc2.key], doc2);
+
+  XCTAssertEqual([loader namedQueries].size(), 1);
+  FSTQuery *named = [loader namedQueries].at("all");
+  XCTAssertEqualObjects(named, query);
+
+  DocumentMap results = [_localStore executeQuery:named];
+  XCTAssertEqual(results.size(), 2);
+  XCTAssertEqualObjects(results.underlying_map().find(doc1.key)->second, doc1);
+  XCTAssertEqualObjects(results.underlying_map().find(doc2.key)->second, doc2);
+}
+
+- (void)testKeepsNewerCachedDocuments {
+  FSTDocument *newer = FSTTestDoc("coll/a", 2, @{@"n" : @2}, FSTDocumentStateSynced);
+  FSTDocument *older = FSTTestDoc("coll/a", 1, @{@"n" : @1}, FSTDocumentStateSynced);
+
+  BundleWriter first;
+  [self addDocument:newer toWriter:&first];
+  XCTAssertTrue([[self loader] loadBundle:first.bundle()].ok());
+
+  BundleWriter second;
+  [self addDocument:older toWriter:&second];
+  FSTBundleLoader *loader = [self loader];
+  XCTAssertTrue([loader loadBundle:second.bundle()].ok());
+
+  XCTAssertEqual([loader changedDocuments].size(), 0);
+  XCTAssertEqualObjects([_localStore readDocument:newer.key], newer);
+}
+
+- (void)testKeepsDocumentsReadBeforeAnError {
+  FSTDocument *doc = FSTTestDoc("coll/a", 1, @{@"n" : @1}, FSTDocumentStateSynced);
+
+  BundleWriter writer;
+  [self addDocument:doc toWriter:&writer];
+  [self addQuery:FSTTestQuery("coll")
+             named:"all"
+           version:1
+      matchingKeys:{doc.key}
+          toWriter:&writer];
+  std::string truncated = writer.bundle().substr(0, writer.bundle().size() - 1);
+
+  FSTBundleLoader *loader = [self loader];
+  XCTAssertFalse([loader loadBundle:truncated].ok());
+
+  XCTAssertEqual([loader changedDocuments].size(), 1);
+  XCTAssertEqualObjects([_localStore readDocument:doc.key], doc);
+  XCTAssertEqual([loader namedQueries].size(), 0);
+}
+
+- (void)testLoadsBundleFromFile {
+  FSTDocument *doc = FSTTestDoc("coll/a", 1, @{@"n" : @1}, FSTDocumentStateSynced);
+
+  BundleWriter writer;
+  [self addDocument:doc toWriter:&writer];
+  [self addQuery:FSTTestQuery("coll")
+             named:"all"
+           version:1
+      matchingKeys:{doc.key}
+          toWriter:&writer];
+
+  Path path = util::TempDir().AppendUtf8("FSTBundleLoaderTests.bundle");
+  NSData *bytes = [NSData dataWithBytes:writer.bundle().data() length:writer.bundle().size()];
+  XCTAssertTrue([bytes writeToFile:path.ToNSString() atomically:YES]);
+
+  FSTBundleLoader *loader = [self loader];
+  Status status = [loader loadBundleAtPath:path];
+  XCTAssertTrue(status.ok(), @"%s", status.ToString().c_str());
+  XCTAssertEqualObjects([_localStore readDocument:doc.key], doc);
+  XCTAssertEqual([loader namedQueries].count("all"), 1);
+  XCTAssertTrue(util::RecursivelyDelete(path).ok());
+}
+
+- (void)testFailsOnMissingFile {
+  Path path = util::TempDir().AppendUtf8("FSTBundleLoaderTests.missing");
+  XCTAssertFalse([[self loader] loadBundleAtPath:path].ok());
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
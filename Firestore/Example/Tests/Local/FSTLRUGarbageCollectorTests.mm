@@ -688,6 +688,28 @@ NS_ASSUME_NONNULL_BEGIN
   [_persistence shutdown];
 }
 
+- (void)testSizeShrinksWhenDocumentsAreCollected {
+  if ([self isTestBaseClass]) return;
+
+  [self newTestResources];
+
+  size_t initialSize = [_gc byteSize];
+  _persistence.run("fill cache", [&]() {
+    for (int i = 0; i < 50; i++) {
+      FSTDocument *doc = [self cacheADocumentInTransaction];
+      [self markDocumentEligibleForGCInTransaction:doc.key];
+    }
+  });
+  size_t filledSize = [_gc byteSize];
+
+  int removed = [self removeOrphanedDocumentsThroughSequenceNumber:1000];
+  XCTAssertEqual(removed, 50);
+  XCTAssertLessThan([_gc byteSize], filledSize);
+  XCTAssertEqual([_gc byteSize], initialSize);
+
+  [_persistence shutdown];
+}
+
 - (void)testDisabled {
   if ([self isTestBaseClass]) return;
 
@@ -768,6 +790,45 @@ NS_ASSUME_NONNULL_BEGIN
   [_persistence shutdown];
 }
 
+- (void)testGCRanInChunks {
+  if ([self isTestBaseClass]) return;
+
+  LruParams params = LruParams::Default();
+  params.minBytesThreshold = 100;
+  params.maximumRemovalsPerChunk = 25;
+  [self newTestResourcesWithLruParams:params];
+
+  // Add 100 targets and 10 documents to each
+  for (int i = 0; i < 100; i++) {
+    _persistence.run("Add a target and some documents", [&]() {
+      FSTQueryData *queryData = [self addNextQueryInTransaction];
+      for (int j = 0; j < 10; j++) {
+        FSTDocument *doc = [self cacheADocumentInTransaction];
+        [self addDocument:doc.key toTarget:queryData.targetID];
+      }
+    });
+  }
+
+  // Run each chunk in its own transaction, as the client does.
+  LruResults results = LruResults::DidNotRun();
+  do {
+    results = _persistence.run("GC chunk", [&]() -> LruResults {
+      return [_gc collectChunkWithLiveTargets:{} previousChunk:results];
+    });
+    XCTAssertTrue(results.didRun);
+    XCTAssertLessThanOrEqual(results.chunkTargetsRemoved + results.chunkDocumentsRemoved, 25);
+  } while (results.hasMoreWork);
+
+  // The chunks add up to the same 10 targets and 100 documents as a single collection, 25
+  // removals at a time.
+  XCTAssertEqual(10, results.targetsRemoved);
+  XCTAssertEqual(100, results.documentsRemoved);
+  XCTAssertEqual(5, results.chunksRun);
+  XCTAssertEqual(0, results.chunkTargetsRemoved);
+  XCTAssertEqual(10, results.chunkDocumentsRemoved);
+  [_persistence shutdown];
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
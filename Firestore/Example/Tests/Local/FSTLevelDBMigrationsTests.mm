@@ -28,6 +28,7 @@
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_migrations.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_query_cache.h"
+#include "Firestore/core/src/firebase/firestore/local/target_id_set.h"
 #include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 #include "absl/strings/match.h"
@@ -38,9 +39,12 @@
 NS_ASSUME_NONNULL_BEGIN
 
 using firebase::firestore::FirestoreErrorCode;
+using firebase::firestore::local::LevelDbCollectionMutationKey;
 using firebase::firestore::local::LevelDbCollectionParentKey;
 using firebase::firestore::local::LevelDbDocumentMutationKey;
+using firebase::firestore::local::LevelDbDocumentSequenceKey;
 using firebase::firestore::local::LevelDbDocumentTargetKey;
+using firebase::firestore::local::LevelDbDocumentTargetSetKey;
 using firebase::firestore::local::LevelDbMigrations;
 using firebase::firestore::local::LevelDbMutationKey;
 using firebase::firestore::local::LevelDbMutationQueueKey;
@@ -50,12 +54,15 @@ using firebase::firestore::local::LevelDbRemoteDocumentKey;
 using firebase::firestore::local::LevelDbTargetDocumentKey;
 using firebase::firestore::local::LevelDbTargetGlobalKey;
 using firebase::firestore::local::LevelDbTargetKey;
+using firebase::firestore::local::LevelDbTargetSequenceKey;
 using firebase::firestore::local::LevelDbTransaction;
+using firebase::firestore::local::TargetIdSet;
 using firebase::firestore::model::BatchId;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::ListenSequenceNumber;
 using firebase::firestore::model::TargetId;
 using firebase::firestore::testutil::Key;
+using firebase::firestore::testutil::Resource;
 using firebase::firestore::util::OrderedCode;
 using firebase::firestore::util::Path;
 using leveldb::DB;
@@ -135,6 +142,7 @@ using SchemaVersion = LevelDbMigrations::SchemaVersion;
       LevelDbTargetDocumentKey::Key(targetID, key2),
       LevelDbDocumentTargetKey::Key(key1, targetID),
       LevelDbDocumentTargetKey::Key(key2, targetID),
+      LevelDbDocumentTargetSetKey::Key(key1),
       LevelDbQueryTargetKey::Key("foo.bar.baz", targetID),
   };
 
@@ -415,6 +423,195 @@ using SchemaVersion = LevelDbMigrations::SchemaVersion;
   }
 }
 
+- (void)testCalculatesByteSize {
+  LevelDbMigrations::RunMigrations(_db.get(), 6);
+  std::string documentKey = LevelDbRemoteDocumentKey::Key(Key("docs/a"));
+  std::string targetKey = LevelDbTargetKey::Key(2);
+  std::string mutationKey = LevelDbMutationKey::Key("user", 3);
+  std::string indexKey = LevelDbDocumentMutationKey::Key("user", Key("docs/a"), 3);
+  {
+    LevelDbTransaction transaction(_db.get(), "Write rows");
+    transaction.Put(documentKey, "document");
+    transaction.Put(targetKey, "target");
+    transaction.Put(mutationKey, "mutation");
+    // Index rows don't count towards the byte size.
+    transaction.Put(indexKey, "");
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(_db.get(), 7);
+  FSTPBTargetGlobal *metadata = LevelDbQueryCache::ReadMetadata(_db.get());
+  XCTAssertNotNil(metadata);
+  int64_t expected = documentKey.size() + 8 + targetKey.size() + 6 + mutationKey.size() + 8;
+  XCTAssertEqual(metadata.byteSize, expected);
+}
+
+- (void)testCreateCollectionMutationsIndex {
+  LevelDbMigrations::RunMigrations(_db.get(), 7);
+  std::string staleKey = LevelDbCollectionMutationKey::Key("user", Resource("stale"), 1);
+  {
+    LevelDbTransaction transaction(_db.get(), "Write document mutations");
+    // Only the DbDocumentMutation index entries matter to the migration.
+    transaction.Put(LevelDbDocumentMutationKey::Key("user", Key("cg1/x"), 2), "");
+    transaction.Put(LevelDbDocumentMutationKey::Key("user", Key("cg1/y"), 2), "");
+    transaction.Put(LevelDbDocumentMutationKey::Key("user", Key("cg1/x/cg1/z"), 3), "");
+    transaction.Put(LevelDbDocumentMutationKey::Key("other", Key("cg2/x"), 4), "");
+    // Left behind by a version that didn't maintain the index.
+    transaction.Put(staleKey, "");
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(_db.get(), 8);
+  {
+    LevelDbTransaction transaction(_db.get(), "Verify");
+
+    std::vector<std::string> actual;
+    auto it = transaction.NewIterator();
+    std::string prefix = LevelDbCollectionMutationKey::KeyPrefix();
+    LevelDbCollectionMutationKey rowKey;
+    for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix); it->Next()) {
+      XCTAssertTrue(rowKey.Decode(it->key()));
+      actual.push_back(rowKey.user_id() + " " + rowKey.parent().CanonicalString() + "/" +
+                       rowKey.collection_id() + " " + std::to_string(rowKey.batch_id()));
+    }
+
+    std::vector<std::string> expected{"other /cg2 4", "user /cg1 2", "user cg1/x/cg1 3"};
+    XCTAssertEqual(actual, expected);
+  }
+}
+
+- (void)testBuildsDocumentTargetSets {
+  LevelDbMigrations::RunMigrations(_db.get(), 10);
+  std::string sentinelKey = LevelDbDocumentTargetKey::SentinelKey(Key("coll/a"));
+  {
+    LevelDbTransaction transaction(_db.get(), "Write target documents");
+    transaction.Put(LevelDbTargetDocumentKey::Key(2, Key("coll/a")), "");
+    transaction.Put(LevelDbTargetDocumentKey::Key(4, Key("coll/a")), "");
+    transaction.Put(LevelDbTargetDocumentKey::Key(4, Key("coll/a/sub/b")), "");
+    transaction.Put(LevelDbDocumentTargetKey::Key(Key("coll/a"), 2), "");
+    transaction.Put(LevelDbDocumentTargetKey::Key(Key("coll/a"), 4), "");
+    transaction.Put(LevelDbDocumentTargetKey::Key(Key("coll/a/sub/b"), 4), "");
+    transaction.Put(sentinelKey, LevelDbDocumentTargetKey::EncodeSentinelValue(1));
+    // Left behind by an earlier upgrade and not updated since.
+    TargetIdSet stale;
+    stale.insert(6);
+    transaction.Put(LevelDbDocumentTargetSetKey::Key(Key("coll/c")), stale.Encode());
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(_db.get(), 11);
+  {
+    LevelDbTransaction transaction(_db.get(), "Verify");
+
+    std::map<std::string, std::vector<TargetId>> actual;
+    auto it = transaction.NewIterator();
+    std::string prefix = LevelDbDocumentTargetSetKey::KeyPrefix();
+    LevelDbDocumentTargetSetKey rowKey;
+    for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix); it->Next()) {
+      XCTAssertTrue(rowKey.Decode(it->key()));
+      TargetIdSet targetIDs;
+      XCTAssertTrue(targetIDs.Decode(it->value()));
+      actual[rowKey.document_key().ToString()] = targetIDs.ToVector();
+    }
+
+    std::map<std::string, std::vector<TargetId>> expected{{"coll/a", {2, 4}},
+                                                          {"coll/a/sub/b", {4}}};
+    XCTAssertEqual(actual, expected);
+
+    // Only the sentinel rows are left in the document targets table.
+    ASSERT_NOT_FOUND(transaction, LevelDbDocumentTargetKey::Key(Key("coll/a"), 2));
+    ASSERT_NOT_FOUND(transaction, LevelDbDocumentTargetKey::Key(Key("coll/a/sub/b"), 4));
+    ASSERT_FOUND(transaction, sentinelKey);
+  }
+}
+
+- (void)testBuildsSequenceNumberIndexes {
+  LevelDbMigrations::RunMigrations(_db.get(), 11);
+  {
+    LevelDbTransaction transaction(_db.get(), "Write targets and sentinels");
+    FSTPBTarget *target = [FSTPBTarget message];
+    target.targetId = 2;
+    target.lastListenSequenceNumber = 7;
+    transaction.Put(LevelDbTargetKey::Key(2), target);
+    // A target written with the default sequence number has no such field.
+    target = [FSTPBTarget message];
+    target.targetId = 4;
+    transaction.Put(LevelDbTargetKey::Key(4), target);
+    transaction.Put(LevelDbDocumentTargetKey::SentinelKey(Key("coll/a")),
+                    LevelDbDocumentTargetKey::EncodeSentinelValue(5));
+    // Left behind by an earlier upgrade and not updated since.
+    transaction.Put(LevelDbTargetSequenceKey::Key(1, 6), "");
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(_db.get(), 12);
+  {
+    LevelDbTransaction transaction(_db.get(), "Verify");
+
+    std::vector<std::pair<ListenSequenceNumber, TargetId>> targets;
+    auto it = transaction.NewIterator();
+    std::string prefix = LevelDbTargetSequenceKey::KeyPrefix();
+    LevelDbTargetSequenceKey targetKey;
+    for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix); it->Next()) {
+      XCTAssertTrue(targetKey.Decode(it->key()));
+      targets.emplace_back(targetKey.sequence_number(), targetKey.target_id());
+    }
+    std::vector<std::pair<ListenSequenceNumber, TargetId>> expectedTargets{{0, 4}, {7, 2}};
+    XCTAssertEqual(targets, expectedTargets);
+
+    ASSERT_FOUND(transaction, LevelDbDocumentSequenceKey::Key(5, Key("coll/a")));
+  }
+}
+
+- (void)testDefersBackfills {
+  LevelDbMigrations::RunMigrations(_db.get(), 5);
+  {
+    LevelDbTransaction transaction(_db.get(), "Write documents and mutations");
+    // Only the keys matter to the backfills.
+    transaction.Put(LevelDbDocumentMutationKey::Key("user", Key("cg1/x"), 2), "");
+    transaction.Put(LevelDbDocumentMutationKey::Key("user", Key("cg1/x/cg2/y"), 3), "");
+    transaction.Put(LevelDbRemoteDocumentKey::Key(Key("cg3/z")), "");
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::StartMigrations(_db.get());
+  XCTAssertEqual(LevelDbMigrations::ReadSchemaVersion(_db.get()), 12);
+  std::vector<SchemaVersion> pending{LevelDbMigrations::kCollectionParentsIndex,
+                                     LevelDbMigrations::kCollectionMutationsIndex};
+  XCTAssertEqual(LevelDbMigrations::ReadPendingMigrations(_db.get()), pending);
+
+  // The backfill resumes where the previous chunk stopped, across source tables.
+  std::vector<std::string> parents;
+  XCTAssertFalse(LevelDbMigrations::RunPendingMigrationChunk(
+      _db.get(), LevelDbMigrations::kCollectionParentsIndex, 2));
+  XCTAssertTrue(LevelDbMigrations::RunPendingMigrationChunk(
+      _db.get(), LevelDbMigrations::kCollectionParentsIndex, 2));
+  {
+    LevelDbTransaction transaction(_db.get(), "Verify");
+    auto it = transaction.NewIterator();
+    std::string prefix = LevelDbCollectionParentKey::KeyPrefix();
+    LevelDbCollectionParentKey rowKey;
+    for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix); it->Next()) {
+      XCTAssertTrue(rowKey.Decode(it->key()));
+      parents.push_back(rowKey.collection_id() + " " + rowKey.parent().CanonicalString());
+    }
+  }
+  std::vector<std::string> expectedParents{"cg1 ", "cg2 cg1/x", "cg3 "};
+  XCTAssertEqual(parents, expectedParents);
+
+  pending = {LevelDbMigrations::kCollectionMutationsIndex};
+  XCTAssertEqual(LevelDbMigrations::ReadPendingMigrations(_db.get()), pending);
+
+  // Running the migrations eagerly finishes what's left.
+  LevelDbMigrations::RunMigrations(_db.get());
+  XCTAssertTrue(LevelDbMigrations::ReadPendingMigrations(_db.get()).empty());
+  {
+    LevelDbTransaction transaction(_db.get(), "Verify");
+    ASSERT_FOUND(transaction, LevelDbCollectionMutationKey::Key("user", Resource("cg1"), 2));
+    ASSERT_FOUND(transaction, LevelDbCollectionMutationKey::Key("user", Resource("cg1/x/cg2"), 3));
+  }
+}
+
 - (void)testCanDowngrade {
   // First, run all of the migrations
   LevelDbMigrations::RunMigrations(_db.get());
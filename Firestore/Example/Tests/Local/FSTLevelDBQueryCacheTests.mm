@@ -20,12 +20,14 @@
 
 #import "Firestore/Example/Tests/Local/FSTPersistenceTestHelpers.h"
 #import "Firestore/Example/Tests/Local/FSTQueryCacheTests.h"
+#import "Firestore/Example/Tests/Util/FSTHelpers.h"
 
 #include "Firestore/core/include/firebase/firestore/timestamp.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_query_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/reference_set.h"
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
@@ -36,6 +38,7 @@ using firebase::firestore::local::LevelDbQueryCache;
 using firebase::firestore::local::ReferenceSet;
 using firebase::firestore::model::DatabaseId;
 using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::ListenSequenceNumber;
 using firebase::firestore::model::ResourcePath;
 using firebase::firestore::model::SnapshotVersion;
@@ -146,6 +149,56 @@ NS_ASSUME_NONNULL_BEGIN
   });
 }
 
+- (void)testRemoveMatchingKeysKeepsOtherTargets {
+  self.persistence.run("testRemoveMatchingKeysKeepsOtherTargets", [&]() {
+    DocumentKey key = testutil::Key("foo/bar");
+    DocumentKey nestedKey = testutil::Key("foo/bar/sub/baz");
+
+    LevelDbQueryCache *cache = [self getCache:self.persistence];
+    [self addMatchingKey:key forTargetID:2];
+    [self addMatchingKey:key forTargetID:4];
+    [self addMatchingKey:nestedKey forTargetID:4];
+
+    cache->RemoveAllKeysForTarget(4);
+    XCTAssertTrue(cache->Contains(key));
+    XCTAssertFalse(cache->Contains(nestedKey));
+
+    cache->RemoveMatchingKeys(DocumentKeySet{key}, 2);
+    XCTAssertFalse(cache->Contains(key));
+  });
+}
+
+- (void)testStoresQueryResults {
+  self.persistence.run("testStoresQueryResults", [&]() {
+    FSTQueryData *rooms = [[FSTQueryData alloc] initWithQuery:FSTTestQuery("rooms")
+                                                     targetID:1
+                                         listenSequenceNumber:10
+                                                      purpose:FSTQueryPurposeListen];
+    FSTQueryData *messages = [[FSTQueryData alloc] initWithQuery:FSTTestQuery("rooms/a/messages")
+                                                        targetID:2
+                                            listenSequenceNumber:10
+                                                         purpose:FSTQueryPurposeListen];
+    self.queryCache->AddTarget(rooms);
+    self.queryCache->AddTarget(messages);
+    XCTAssertFalse(self.queryCache->GetQueryResult(rooms).has_value());
+
+    DocumentKeySet roomKeys{testutil::Key("rooms/a"), testutil::Key("rooms/b")};
+    DocumentKeySet messageKeys{testutil::Key("rooms/a/messages/1")};
+    self.queryCache->SetQueryResult(rooms, roomKeys);
+    self.queryCache->SetQueryResult(messages, messageKeys);
+    XCTAssertEqual(*self.queryCache->GetQueryResult(rooms), roomKeys);
+    XCTAssertEqual(*self.queryCache->GetQueryResult(messages), messageKeys);
+
+    // Changes to a collection don't affect the results of nested collections.
+    self.queryCache->InvalidateQueryResults(ResourcePath{"rooms"});
+    XCTAssertFalse(self.queryCache->GetQueryResult(rooms).has_value());
+    XCTAssertEqual(*self.queryCache->GetQueryResult(messages), messageKeys);
+
+    self.queryCache->RemoveTarget(messages);
+    XCTAssertFalse(self.queryCache->GetQueryResult(messages).has_value());
+  });
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -31,6 +31,7 @@ NS_ASSUME_NONNULL_BEGIN
 
 using leveldb::WriteOptions;
 using firebase::firestore::local::LevelDbRemoteDocumentCache;
+using firebase::firestore::local::LevelDbSettings;
 using firebase::firestore::local::RemoteDocumentCache;
 using firebase::firestore::util::OrderedCode;
 
@@ -55,7 +56,7 @@ static const char *kDummy = "1";
   _db = [FSTPersistenceTestHelpers levelDBPersistence];
   self.persistence = _db;
   HARD_ASSERT(!_cache, "Previous cache not torn down");
-  _cache = absl::make_unique<LevelDbRemoteDocumentCache>(_db, _db.serializer);
+  _cache = absl::make_unique<LevelDbRemoteDocumentCache>(_db, _db.serializer, [self settings]);
 
   // Write a couple dummy rows that should appear before/after the remote_documents table to make
   // sure the tests are unaffected.
@@ -63,6 +64,11 @@ static const char *kDummy = "1";
   [self writeDummyRowWithSegments:@[ @"remote_documentsa", @"foo", @"bar" ]];
 }
 
+/** The settings that choose the format the cache under test writes documents in. */
+- (LevelDbSettings)settings {
+  return LevelDbSettings{};
+}
+
 - (RemoteDocumentCache *_Nullable)remoteDocumentCache {
   return _cache.get();
 }
@@ -86,4 +92,33 @@ static const char *kDummy = "1";
 
 @end
 
+/** Runs the same tests against a cache that stores field names in dictionaries. */
+@interface FSTLevelDBCompactRemoteDocumentCacheTests : FSTLevelDBRemoteDocumentCacheTests
+@end
+
+@implementation FSTLevelDBCompactRemoteDocumentCacheTests
+
+- (LevelDbSettings)settings {
+  LevelDbSettings settings;
+  settings.compact_remote_documents = true;
+  return settings;
+}
+
+@end
+
+/** Runs the same tests against a cache that compresses (almost) every document. */
+@interface FSTLevelDBCompressedRemoteDocumentCacheTests : FSTLevelDBRemoteDocumentCacheTests
+@end
+
+@implementation FSTLevelDBCompressedRemoteDocumentCacheTests
+
+- (LevelDbSettings)settings {
+  LevelDbSettings settings;
+  settings.compact_remote_documents = true;
+  settings.compress_remote_documents_bytes = 1;
+  return settings;
+}
+
+@end
+
 NS_ASSUME_NONNULL_END
@@ -0,0 +1,276 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "Firestore/Source/Local/FSTLevelDB.h"
+
+#import <XCTest/XCTest.h>
+
+#include <memory>
+#include <string>
+
+#import "Firestore/Example/Tests/Local/FSTPersistenceTestHelpers.h"
+#import "Firestore/Example/Tests/Util/FSTHelpers.h"
+#import "Firestore/Protos/objc/firestore/local/Target.pbobjc.h"
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_query_cache.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_snapshot.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_statistics.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
+#include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/executor_libdispatch.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/match.h"
+#include "leveldb/db.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+using firebase::firestore::local::LevelDbMutationKey;
+using firebase::firestore::local::LevelDbQueryCache;
+using firebase::firestore::local::LevelDbRemoteDocumentKey;
+using firebase::firestore::local::LevelDbSnapshot;
+using firebase::firestore::local::LevelDbStatistics;
+using firebase::firestore::local::LevelDbTargetKey;
+using firebase::firestore::local::LevelDbTransaction;
+using firebase::firestore::testutil::Key;
+using firebase::firestore::util::AsyncQueue;
+using firebase::firestore::util::ExecutorLibdispatch;
+
+@interface FSTLevelDBTests : XCTestCase
+@end
+
+@implementation FSTLevelDBTests {
+  std::unique_ptr<AsyncQueue> _queue;
+  FSTLevelDB *_db;
+}
+
+- (void)setUp {
+  [super setUp];
+  dispatch_queue_t queue = dispatch_queue_create("FSTLevelDBTests", DISPATCH_QUEUE_SERIAL);
+  _queue = absl::make_unique<AsyncQueue>(absl::make_unique<ExecutorLibdispatch>(queue));
+  _db = [FSTPersistenceTestHelpers levelDBPersistence];
+}
+
+- (void)tearDown {
+  // Let any scheduled flush run before the queue goes away.
+  _queue->EnqueueBlocking([] {});
+  [_db shutdown];
+  _db = nil;
+  _queue.reset();
+  [super tearDown];
+}
+
+/** Reads `key` directly from LevelDB, bypassing any buffered changes. */
+- (BOOL)isWritten:(const std::string &)key {
+  std::string value;
+  return _db.ptr->Get(LevelDbTransaction::DefaultReadOptions(), key, &value).ok();
+}
+
+/** Sums the sizes of the rows under `prefix` that are written to LevelDB. */
+- (int64_t)writtenSizeOfRowsWithPrefix:(const std::string &)prefix {
+  int64_t size = 0;
+  std::unique_ptr<leveldb::Iterator> it{
+      _db.ptr->NewIterator(LevelDbTransaction::DefaultReadOptions())};
+  for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key().ToString(), prefix);
+       it->Next()) {
+    size += static_cast<int64_t>(it->key().size() + it->value().size());
+  }
+  return size;
+}
+
+- (void)testCommitsImmediatelyByDefault {
+  _queue->EnqueueBlocking([&] {
+    _db.run("Put", [&] { _db.currentTransaction->Put("key", "value"); });
+    XCTAssertTrue([self isWritten:"key"]);
+  });
+}
+
+- (void)testGroupCommitWritesTransactionsTogether {
+  [_db enableGroupCommitOnQueue:_queue.get()];
+
+  _queue->EnqueueBlocking([&] {
+    _db.run("Put first", [&] { _db.currentTransaction->Put("first", "1"); });
+    _db.run("Put second", [&] {
+      std::string value;
+      XCTAssertTrue(_db.currentTransaction->Get("first", &value).ok());
+      XCTAssertEqual(value, std::string("1"));
+      _db.currentTransaction->Put("second", "2");
+    });
+
+    XCTAssertFalse([self isWritten:"first"]);
+    XCTAssertFalse([self isWritten:"second"]);
+  });
+
+  // The flush was enqueued ahead of this operation.
+  _queue->EnqueueBlocking([&] {
+    XCTAssertTrue([self isWritten:"first"]);
+    XCTAssertTrue([self isWritten:"second"]);
+  });
+}
+
+- (void)testFlushPendingWrites {
+  [_db enableGroupCommitOnQueue:_queue.get()];
+
+  _queue->EnqueueBlocking([&] {
+    _db.run("Put", [&] { _db.currentTransaction->Put("key", "value"); });
+    XCTAssertFalse([self isWritten:"key"]);
+    [_db flushPendingWrites];
+    XCTAssertTrue([self isWritten:"key"]);
+  });
+}
+
+- (void)testDeferredCommitWaitsForCommitDeferredTransactions {
+  _queue->EnqueueBlocking([&] {
+    _db.run("Put deferred", [&] {
+      [_db deferCommit];
+      _db.currentTransaction->Put("first", "1");
+    });
+    _db.run("Put second", [&] { _db.currentTransaction->Put("second", "2"); });
+
+    // Both stay buffered, though group commit isn't enabled.
+    XCTAssertFalse([self isWritten:"first"]);
+    XCTAssertFalse([self isWritten:"second"]);
+
+    [_db commitDeferredTransactions];
+    XCTAssertTrue([self isWritten:"first"]);
+    XCTAssertTrue([self isWritten:"second"]);
+
+    _db.run("Put third", [&] { _db.currentTransaction->Put("third", "3"); });
+    XCTAssertTrue([self isWritten:"third"]);
+  });
+}
+
+- (void)testDurableCommitIsWrittenBeforeCommitting {
+  [_db enableGroupCommitOnQueue:_queue.get()];
+
+  _queue->EnqueueBlocking([&] {
+    _db.run("Put first", [&] { _db.currentTransaction->Put("first", "1"); });
+    _db.run("Put durable", [&] {
+      [_db requireDurableCommit];
+      _db.currentTransaction->Put("durable", "2");
+    });
+    // Changes buffered ahead of it are written with it.
+    XCTAssertTrue([self isWritten:"first"]);
+    XCTAssertTrue([self isWritten:"durable"]);
+
+    _db.run("Put deferred durable", [&] {
+      [_db deferCommit];
+      [_db requireDurableCommit];
+      _db.currentTransaction->Put("deferred", "3");
+    });
+    XCTAssertFalse([self isWritten:"deferred"]);
+    [_db commitDeferredTransactions];
+    XCTAssertTrue([self isWritten:"deferred"]);
+
+    _db.run("Put last", [&] { _db.currentTransaction->Put("last", "4"); });
+    XCTAssertFalse([self isWritten:"last"]);
+  });
+}
+
+- (void)testSnapshotIsolatesReadsFromLaterWrites {
+  [_db enableGroupCommitOnQueue:_queue.get()];
+
+  std::unique_ptr<LevelDbSnapshot> snapshot;
+  _queue->EnqueueBlocking([&] {
+    for (int i = 0; i < 10; ++i) {
+      _db.run("Put", [&] { _db.currentTransaction->Put("key_" + std::to_string(i), "old"); });
+    }
+    // Buffered writes are flushed, so the snapshot sees them.
+    snapshot = [_db snapshotWithLabel:"testSnapshotIsolatesReadsFromLaterWrites"];
+
+    _db.run("Update", [&] {
+      _db.currentTransaction->Delete("key_0");
+      _db.currentTransaction->Put("key_1", "new");
+      _db.currentTransaction->Put("key_10", "new");
+    });
+    [_db flushPendingWrites];
+  });
+
+  // Reads happen off the queue, and see none of the changes made after the snapshot.
+  LevelDbSnapshot *reading = snapshot.get();
+  dispatch_queue_t reader = dispatch_queue_create("reader", DISPATCH_QUEUE_SERIAL);
+  dispatch_sync(reader, ^{
+    std::string value;
+    XCTAssertTrue(reading->Get("key_0", &value).ok());
+    XCTAssertEqual(value, std::string("old"));
+
+    int rows = 0;
+    auto it = reading->NewIterator();
+    for (it->Seek("key_"); it->Valid(); it->Next()) {
+      XCTAssertEqual(it->value(), "old");
+      ++rows;
+    }
+    XCTAssertEqual(rows, 10);
+  });
+  snapshot.reset();
+}
+
+- (void)testPartialCommitsKeepTheByteSizeConsistent {
+  _queue->EnqueueBlocking([&] {
+    _db.run("Apply large event", [&] {
+      [_db allowPartialCommits];
+      NSString *data = [@"" stringByPaddingToLength:1024 * 1024 withString:@"x" startingAtIndex:0];
+      for (int i = 0; i < 20; ++i) {
+        std::string path = "docs/" + std::to_string(i);
+        [_db remoteDocumentCache]->Add(
+            FSTTestDoc(path, 1, @{@"data" : data}, FSTDocumentStateSynced));
+        [_db checkpointPartialCommit];
+
+        // What a crash would leave behind at this point: the saved byte size has to match the rows
+        // that are actually written.
+        int64_t written = [self writtenSizeOfRowsWithPrefix:LevelDbRemoteDocumentKey::KeyPrefix()] +
+                          [self writtenSizeOfRowsWithPrefix:LevelDbTargetKey::KeyPrefix()] +
+                          [self writtenSizeOfRowsWithPrefix:LevelDbMutationKey::KeyPrefix()];
+        XCTAssertEqual(LevelDbQueryCache::ReadMetadata(_db.ptr).byteSize, written);
+      }
+
+      // The event was flushed in several batches before it committed.
+      XCTAssertTrue([self isWritten:LevelDbRemoteDocumentKey::Key(Key("docs/0"))]);
+      XCTAssertFalse([self isWritten:LevelDbRemoteDocumentKey::Key(Key("docs/19"))]);
+    });
+  });
+}
+
+- (void)testStatisticsAttributeSizesToKeyFamilies {
+  _queue->EnqueueBlocking([&] {
+    _db.run("Put documents", [&] {
+      for (int i = 0; i < 100; ++i) {
+        std::string key = LevelDbRemoteDocumentKey::Key(Key("docs/" + std::to_string(i)));
+        _db.currentTransaction->Put(key, std::string(1024, 'x'));
+      }
+    });
+
+    XCTAssertEqual([_db statistics].compactions, 0);
+
+    // Compacting writes the rows from the memtable to tables, whose sizes LevelDB can estimate.
+    [_db compact];
+
+    LevelDbStatistics statistics = [_db statistics];
+    XCTAssertGreaterThan(statistics.remote_documents_bytes, 0);
+    XCTAssertEqual(statistics.mutations_bytes, 0);
+    XCTAssertEqual(statistics.collection_parents_bytes, 0);
+    XCTAssertFalse(statistics.files_per_level.empty());
+    XCTAssertGreaterThan(statistics.approximate_memory_usage, 0);
+    XCTAssertFalse(statistics.stats.empty());
+    XCTAssertEqual(statistics.compactions, 1);
+  });
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -18,6 +18,9 @@
 
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
 
 // This is out of order to satisfy the linter, which doesn't realize this is
 // the header corresponding to this test.
@@ -194,6 +197,25 @@ using leveldb::WriteOptions;
   XCTAssertTrue(status.IsNotFound());
 }
 
+- (void)testRowSize {
+  WriteOptions writeOptions;
+  Status status = _db->Put(writeOptions, "committed", "12345");
+  XCTAssertTrue(status.ok());
+
+  LevelDbTransaction transaction(_db.get(), "testRowSize");
+  XCTAssertEqual(transaction.RowSize("committed"), 9 + 5);
+  XCTAssertEqual(transaction.RowSize("missing"), 0);
+
+  transaction.Put("committed", "12");
+  XCTAssertEqual(transaction.RowSize("committed"), 9 + 2);
+
+  transaction.Put("pending", "123");
+  XCTAssertEqual(transaction.RowSize("pending"), 7 + 3);
+
+  transaction.Delete("committed");
+  XCTAssertEqual(transaction.RowSize("committed"), 0);
+}
+
 - (void)testProtobufSupport {
   LevelDbTransaction transaction(_db.get(), "testProtobufSupport");
 
@@ -282,6 +304,291 @@ using leveldb::WriteOptions;
   XCTAssertFalse(it->Valid());
 }
 
+- (void)testSeekForward {
+  for (int i = 0; i < 6; ++i) {
+    Status status = _db->Put(LevelDbTransaction::DefaultWriteOptions(), "key_" + std::to_string(i),
+                             "value_" + std::to_string(i));
+    XCTAssertTrue(status.ok());
+  }
+
+  LevelDbTransaction transaction(_db.get(), "testSeekForward");
+  transaction.Delete("key_2");
+  transaction.Put("key_3a", "value_3a");
+
+  auto it = transaction.NewIterator();
+  it->SeekForward("key_0");
+  XCTAssertTrue(it->Valid());
+  XCTAssertEqual("key_0", it->key());
+
+  // The current entry, the next one, and one further on.
+  it->SeekForward("key_0");
+  XCTAssertEqual("key_0", it->key());
+  it->SeekForward("key_1");
+  XCTAssertEqual("key_1", it->key());
+  it->SeekForward("key_2");
+  XCTAssertEqual("key_3", it->key());
+  it->SeekForward("key_3a");
+  XCTAssertEqual("key_3a", it->key());
+  it->SeekForward("key_5");
+  XCTAssertEqual("key_5", it->key());
+
+  // Changes to the transaction after positioning the iterator are visible.
+  transaction.Put("key_5a", "value_5a");
+  it->SeekForward("key_5a");
+  XCTAssertTrue(it->Valid());
+  XCTAssertEqual("key_5a", it->key());
+
+  it->SeekForward("key_6");
+  XCTAssertFalse(it->Valid());
+}
+
+- (void)testUpperBound {
+  for (int i = 0; i < 4; ++i) {
+    Status status = _db->Put(LevelDbTransaction::DefaultWriteOptions(), "key_" + std::to_string(i),
+                             "value_" + std::to_string(i));
+    XCTAssertTrue(status.ok());
+  }
+
+  LevelDbTransaction transaction(_db.get(), "testUpperBound");
+  transaction.Put("key_1a", "value_1a");
+  transaction.Put("key_2a", "value_2a");
+
+  LevelDbTransaction::IteratorOptions options;
+  options.upper_bound = "key_2a";
+  auto it = transaction.NewIterator(options);
+
+  std::vector<std::string> keys;
+  for (it->Seek("key_1"); it->Valid(); it->Next()) {
+    keys.emplace_back(it->key());
+  }
+  XCTAssertTrue(keys == (std::vector<std::string>{"key_1", "key_1a", "key_2"}));
+
+  it->Seek("key_3");
+  XCTAssertFalse(it->Valid());
+  it->SeekToLast();
+  XCTAssertTrue(it->Valid());
+  XCTAssertEqual("key_2", it->key());
+}
+
+- (void)testIterateBackwards {
+  for (int i = 0; i < 4; ++i) {
+    Status status = _db->Put(LevelDbTransaction::DefaultWriteOptions(), "key_" + std::to_string(i),
+                             "value_" + std::to_string(i));
+    XCTAssertTrue(status.ok());
+  }
+
+  LevelDbTransaction transaction(_db.get(), "testIterateBackwards");
+  transaction.Delete("key_1");
+  transaction.Put("key_2", "new_value_2");
+  transaction.Put("key_4", "value_4");
+
+  auto it = transaction.NewIterator();
+  std::vector<std::pair<std::string, std::string>> rows;
+  for (it->SeekToLast(); it->Valid(); it->Prev()) {
+    rows.emplace_back(std::string{it->key()}, std::string{it->value()});
+  }
+  std::vector<std::pair<std::string, std::string>> expected{{"key_4", "value_4"},
+                                                            {"key_3", "value_3"},
+                                                            {"key_2", "new_value_2"},
+                                                            {"key_0", "value_0"}};
+  XCTAssertTrue(rows == expected);
+
+  it->SeekBefore("key_2");
+  XCTAssertTrue(it->Valid());
+  XCTAssertEqual("key_0", it->key());
+
+  // Turning around continues from the current entry.
+  it->Next();
+  XCTAssertEqual("key_2", it->key());
+  it->Next();
+  XCTAssertEqual("key_3", it->key());
+  it->Prev();
+  XCTAssertEqual("key_2", it->key());
+
+  // Changes to the transaction after positioning the iterator are visible.
+  transaction.Put("key_1a", "value_1a");
+  it->Prev();
+  XCTAssertEqual("key_1a", it->key());
+  it->Prev();
+  XCTAssertEqual("key_0", it->key());
+  it->Prev();
+  XCTAssertFalse(it->Valid());
+}
+
+- (void)testNextN {
+  for (int i = 0; i < 5; ++i) {
+    Status status = _db->Put(LevelDbTransaction::DefaultWriteOptions(), "key_" + std::to_string(i),
+                             "value_" + std::to_string(i));
+    XCTAssertTrue(status.ok());
+  }
+
+  LevelDbTransaction transaction(_db.get(), "testNextN");
+  transaction.Delete("key_1");
+  transaction.Put("key_2a", "value_2a");
+
+  auto it = transaction.NewIterator();
+  it->Seek("key_0");
+  LevelDbTransaction::Rows rows;
+  XCTAssertEqual(it->NextN(3, &rows), 3u);
+  LevelDbTransaction::Rows expected{
+      {"key_0", "value_0"}, {"key_2", "value_2"}, {"key_2a", "value_2a"}};
+  XCTAssertTrue(rows == expected);
+  XCTAssertTrue(it->Valid());
+  XCTAssertEqual("key_3", it->key());
+
+  rows.clear();
+  XCTAssertEqual(it->NextN(3, &rows), 2u);
+  expected = {{"key_3", "value_3"}, {"key_4", "value_4"}};
+  XCTAssertTrue(rows == expected);
+  XCTAssertFalse(it->Valid());
+}
+
+- (void)testGetAll {
+  for (int i = 0; i < 4; ++i) {
+    Status status = _db->Put(LevelDbTransaction::DefaultWriteOptions(), "key_" + std::to_string(i),
+                             "value_" + std::to_string(i));
+    XCTAssertTrue(status.ok());
+  }
+
+  LevelDbTransaction transaction(_db.get(), "testGetAll");
+  transaction.Delete("key_1");
+  transaction.Put("key_2", "new_value_2");
+  transaction.Put("key_4", "value_4");
+
+  std::vector<std::string> keys{"key_0", "key_1", "key_2", "key_2a", "key_3", "key_4", "key_5"};
+  std::vector<std::pair<size_t, std::string>> results;
+  transaction.GetAll(keys, [&](size_t index, absl::string_view value) {
+    results.emplace_back(index, std::string{value});
+  });
+
+  std::vector<std::pair<size_t, std::string>> expected{
+      {0, "value_0"}, {2, "new_value_2"}, {4, "value_3"}, {5, "value_4"}};
+  XCTAssertTrue(results == expected);
+}
+
+- (void)testDeleteRange {
+  for (int i = 0; i < 6; ++i) {
+    Status status = _db->Put(LevelDbTransaction::DefaultWriteOptions(), "key_" + std::to_string(i),
+                             "value_" + std::to_string(i));
+    XCTAssertTrue(status.ok());
+  }
+
+  LevelDbTransaction transaction(_db.get(), "testDeleteRange");
+  transaction.Put("key_1a", "pending");
+  transaction.DeleteRange("key_1", "key_3");
+  transaction.DeleteRange("key_3", "key_4");
+  // Puts after the range is deleted are kept.
+  transaction.Put("key_2", "new_value");
+
+  std::string value;
+  XCTAssertTrue(transaction.Get("key_1", &value).IsNotFound());
+  XCTAssertTrue(transaction.Get("key_1a", &value).IsNotFound());
+  XCTAssertTrue(transaction.Get("key_3", &value).IsNotFound());
+  XCTAssertTrue(transaction.Get("key_2", &value).ok());
+  XCTAssertEqual(value, "new_value");
+
+  std::vector<std::string> keys;
+  LevelDbTransaction::Iterator iter(&transaction);
+  for (iter.Seek(""); iter.Valid(); iter.Next()) {
+    keys.emplace_back(iter.key());
+  }
+  std::vector<std::string> expected{"key_0", "key_2", "key_4", "key_5"};
+  XCTAssertTrue(keys == expected);
+
+  keys.clear();
+  for (iter.SeekToLast(); iter.Valid(); iter.Prev()) {
+    keys.emplace_back(iter.key());
+  }
+  XCTAssertTrue(keys == std::vector<std::string>(expected.rbegin(), expected.rend()));
+
+  transaction.Commit();
+
+  keys.clear();
+  std::unique_ptr<leveldb::Iterator> it(_db->NewIterator(LevelDbTransaction::DefaultReadOptions()));
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    keys.push_back(it->key().ToString());
+  }
+  XCTAssertTrue(keys == expected);
+}
+
+- (void)testPutReplacesPendingValue {
+  LevelDbTransaction transaction(_db.get(), "testPutReplacesPendingValue");
+  transaction.Put("key", "value_1");
+  transaction.Put("key", "value_2");
+
+  std::string value;
+  XCTAssertTrue(transaction.Get("key", &value).ok());
+  XCTAssertEqual(value, "value_2");
+
+  transaction.Commit();
+  XCTAssertTrue(_db->Get(LevelDbTransaction::DefaultReadOptions(), "key", &value).ok());
+  XCTAssertEqual(value, "value_2");
+}
+
+- (void)testAllowFlushes {
+  LevelDbTransaction transaction(_db.get(), "testAllowFlushes");
+  transaction.AllowFlushes(100);
+  auto iter = transaction.NewIterator();
+  for (int i = 0; i < 20; ++i) {
+    transaction.Put("key_" + std::to_string(i + 10), "value");
+    // Changes are only flushed at checkpoints.
+    if (i == 0) XCTAssertEqual(transaction.changed_keys(), 1u);
+    transaction.Checkpoint();
+  }
+
+  // Most of the changes are already in leveldb, but reads see all of them.
+  XCTAssertLessThan(transaction.changed_keys(), 10u);
+  std::string value;
+  const ReadOptions &readOptions = LevelDbTransaction::DefaultReadOptions();
+  XCTAssertTrue(_db->Get(readOptions, "key_10", &value).ok());
+  int count = 0;
+  for (iter->Seek(""); iter->Valid(); iter->Next()) {
+    count++;
+  }
+  XCTAssertEqual(count, 20);
+
+  transaction.Commit();
+  XCTAssertTrue(_db->Get(readOptions, "key_29", &value).ok());
+}
+
+- (void)testBackgroundWrites {
+  for (int i = 0; i < 4; ++i) {
+    Status status = _db->Put(LevelDbTransaction::DefaultWriteOptions(), "key_" + std::to_string(i),
+                             "value_" + std::to_string(i));
+    XCTAssertTrue(status.ok());
+  }
+
+  LevelDbTransaction transaction(_db.get(), "testBackgroundWrites");
+  transaction.Put("key_0", "new_value");
+  transaction.Delete("key_1");
+  transaction.DeleteRange("key_2", "key_4");
+  auto write = transaction.StartBackgroundWrite();
+  XCTAssertTrue(write);
+  transaction.Put("key_3", "new_value");
+
+  // Until the write runs, and is reaped, reads see its changes through the transaction.
+  std::string value;
+  const ReadOptions &readOptions = LevelDbTransaction::DefaultReadOptions();
+  XCTAssertTrue(_db->Get(readOptions, "key_1", &value).ok());
+  transaction.ReapBackgroundWrites();
+  XCTAssertEqual(transaction.changed_keys(), 4u);
+  XCTAssertTrue(transaction.Get("key_1", &value).IsNotFound());
+
+  std::thread runner([write] { write->Run(); });
+  runner.join();
+  XCTAssertTrue(_db->Get(readOptions, "key_1", &value).IsNotFound());
+  XCTAssertTrue(_db->Get(readOptions, "key_3", &value).IsNotFound());
+  transaction.ReapBackgroundWrites();
+  XCTAssertEqual(transaction.changed_keys(), 1u);
+  XCTAssertTrue(transaction.Get("key_0", &value).ok());
+  XCTAssertEqual(value, "new_value");
+  XCTAssertTrue(transaction.Get("key_3", &value).ok());
+
+  transaction.Commit();
+  XCTAssertTrue(_db->Get(readOptions, "key_3", &value).ok());
+  XCTAssertEqual(value, "new_value");
+}
+
 - (void)testToString {
   std::string key = LevelDbMutationKey::Key("user1", 42);
   FSTPBWriteBatch *message = [FSTPBWriteBatch message];
@@ -220,6 +220,37 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertEqualObjects(decoded, queryData);
 }
 
+- (void)testEncodesQueryDataWithProjection {
+  FSTQuery *query = [FSTTestQuery("room")
+      queryBySelectingFields:FieldMask{testutil::Field("a"), testutil::Field("b.c")}];
+  FSTQueryData *queryData = [[FSTQueryData alloc] initWithQuery:query
+                                                       targetID:42
+                                           listenSequenceNumber:10
+                                                        purpose:FSTQueryPurposeListen];
+
+  // The projection isn't part of the RPC target, so it's stored in the select clause.
+  GCFSTarget_QueryTarget *queryTarget = [self.remoteSerializer encodedQueryTarget:query];
+  XCTAssertFalse(queryTarget.structuredQuery.hasSelect);
+
+  FSTPBTarget *expected = [FSTPBTarget message];
+  expected.targetId = 42;
+  expected.lastListenSequenceNumber = 10;
+  expected.snapshotVersion = [self.remoteSerializer encodedVersion:SnapshotVersion::None()];
+  expected.resumeToken = [NSData data];
+  expected.query.parent = queryTarget.parent;
+  expected.query.structuredQuery = queryTarget.structuredQuery;
+  for (NSString *path in @[ @"a", @"b.c" ]) {
+    GCFSStructuredQuery_FieldReference *field = [GCFSStructuredQuery_FieldReference message];
+    field.fieldPath = path;
+    [expected.query.structuredQuery.select.fieldsArray addObject:field];
+  }
+
+  XCTAssertEqualObjects([self.serializer encodedQueryData:queryData], expected);
+  FSTQueryData *decoded = [self.serializer decodedQueryData:expected];
+  XCTAssertEqualObjects(decoded, queryData);
+  XCTAssertEqualObjects(decoded.query, query);
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
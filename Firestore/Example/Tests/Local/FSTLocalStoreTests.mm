@@ -19,6 +19,7 @@
 #import <FirebaseFirestore/FIRTimestamp.h>
 #import <XCTest/XCTest.h>
 
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -28,6 +29,7 @@
 #import "Firestore/Source/Local/FSTPersistence.h"
 #import "Firestore/Source/Local/FSTQueryData.h"
 #import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Model/FSTFieldValue.h"
 #import "Firestore/Source/Model/FSTMutation.h"
 #import "Firestore/Source/Model/FSTMutationBatch.h"
 #import "Firestore/Source/Util/FSTClasses.h"
@@ -47,10 +49,15 @@
 
 namespace testutil = firebase::firestore::testutil;
 using firebase::firestore::auth::User;
+using firebase::firestore::local::AggregateField;
+using firebase::firestore::local::FieldIndex;
+using firebase::firestore::local::LocalQueryCursor;
+using firebase::firestore::local::LocalQueryPage;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::ListenSequenceNumber;
 using firebase::firestore::model::DocumentMap;
+using firebase::firestore::model::kBatchIdUnknown;
 using firebase::firestore::model::MaybeDocumentMap;
 using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::model::TargetId;
@@ -180,6 +187,21 @@ NS_ASSUME_NONNULL_BEGIN
   return queryData.targetID;
 }
 
+/** Reads every page of the local results of `query`, returning the paths of the documents. */
+- (std::vector<std::string>)readPagesOfQuery:(FSTQuery *)query pageSize:(size_t)pageSize {
+  std::vector<std::string> paths;
+  absl::optional<LocalQueryCursor> cursor;
+  do {
+    LocalQueryPage page = [self.localStore readQuery:query pageSize:pageSize after:cursor];
+    XCTAssertLessThanOrEqual(page.documents.size(), pageSize);
+    for (FSTDocument *doc : page.documents) {
+      paths.push_back(doc.key.ToString());
+    }
+    cursor = std::move(page.next);
+  } while (cursor);
+  return paths;
+}
+
 /** Asserts that the last target ID is the given number. */
 #define FSTAssertTargetID(targetID)              \
   do {                                           \
@@ -909,6 +931,110 @@ NS_ASSUME_NONNULL_BEGIN
                         ]));
 }
 
+- (void)testCanAggregateCollectionQueries {
+  if ([self isTestBaseClass]) return;
+
+  FSTQuery *query = FSTTestQuery("foo");
+  [self allocateQuery:query];
+  FSTAssertTargetID(2);
+
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(
+                             FSTTestDoc("foo/bar", 10, @{@"n" : @20}, FSTDocumentStateSynced), {2},
+                             {})];
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(
+                             FSTTestDoc("foo/baz", 20, @{@"n" : @10}, FSTDocumentStateSynced), {2},
+                             {})];
+
+  // Local mutations replace the remote values they overlay.
+  [self.localStore locallyWriteMutations:{
+    FSTTestSetMutation(@"foo/baz", @{@"n" : @"ten"}),
+        FSTTestSetMutation(@"foo/bonk", @{@"n" : @1.5})
+  }];
+
+  std::vector<AggregateField> fields{AggregateField::Count(),
+                                     AggregateField::Sum(testutil::Field("n")),
+                                     AggregateField::Average(testutil::Field("n"))};
+  std::vector<FSTFieldValue *> results = [self.localStore aggregateQuery:query fields:fields];
+  XCTAssertEqual(results.size(), 3);
+  XCTAssertEqualObjects(results[0], [FSTIntegerValue integerValue:3]);
+  XCTAssertEqualObjects(results[1], [FSTDoubleValue doubleValue:21.5]);
+  XCTAssertEqualObjects(results[2], [FSTDoubleValue doubleValue:10.75]);
+
+  // With a limit, only the first documents in query order are aggregated.
+  results = [self.localStore aggregateQuery:[query queryBySettingLimit:2] fields:fields];
+  XCTAssertEqual(results.size(), 3);
+  XCTAssertEqualObjects(results[0], [FSTIntegerValue integerValue:2]);
+  XCTAssertEqualObjects(results[1], [FSTIntegerValue integerValue:20]);
+  XCTAssertEqualObjects(results[2], [FSTDoubleValue doubleValue:20]);
+}
+
+- (void)testReadsQueryResultsInPages {
+  if ([self isTestBaseClass]) return;
+
+  FSTQuery *query = FSTTestQuery("foo");
+  [self allocateQuery:query];
+  FSTAssertTargetID(2);
+
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(
+                             FSTTestDoc("foo/a", 10, @{@"n" : @3}, FSTDocumentStateSynced), {2},
+                             {})];
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(
+                             FSTTestDoc("foo/c", 10, @{@"n" : @1}, FSTDocumentStateSynced), {2},
+                             {})];
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(
+                             FSTTestDoc("foo/d", 10, @{@"n" : @2}, FSTDocumentStateSynced), {2},
+                             {})];
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(
+                             FSTTestDoc("foo/e", 10, @{@"m" : @0}, FSTDocumentStateSynced), {2},
+                             {})];
+
+  // Local views are merged into the remote documents at their positions.
+  [self.localStore locallyWriteMutations:{
+    FSTTestSetMutation(@"foo/b", @{@"n" : @4}), FSTTestDeleteMutation(@"foo/c")
+  }];
+
+  std::vector<std::string> expected{"foo/a", "foo/b", "foo/d", "foo/e"};
+  XCTAssertEqual([self readPagesOfQuery:query pageSize:2], expected);
+  XCTAssertEqual([self readPagesOfQuery:query pageSize:10], expected);
+
+  // Without an index, an orderBy still filters the results but they're read in key order.
+  FSTQuery *ordered = [query queryByAddingSortOrder:FSTTestOrderBy("n", @"asc")];
+  expected = {"foo/a", "foo/b", "foo/d"};
+  XCTAssertEqual([self readPagesOfQuery:ordered pageSize:1], expected);
+
+  // With a value index on the field, pages follow the orderBy.
+  [self.localStore addFieldIndex:FieldIndex{"foo", testutil::Field("n")}];
+  expected = {"foo/d", "foo/a", "foo/b"};
+  XCTAssertEqual([self readPagesOfQuery:ordered pageSize:1], expected);
+  XCTAssertEqual([self readPagesOfQuery:ordered pageSize:2], expected);
+
+  // The limit applies across pages.
+  expected = {"foo/d", "foo/a"};
+  XCTAssertEqual([self readPagesOfQuery:[ordered queryBySettingLimit:2] pageSize:1], expected);
+}
+
+- (void)testRecomputesCachedLocalViewsOfQueryResults {
+  if ([self isTestBaseClass]) return;
+
+  FSTQuery *query = FSTTestQuery("foo");
+  TargetId targetID = [self allocateQuery:query];
+  [self writeMutation:FSTTestPatchMutation("foo/bar", @{@"foo" : @"bar"}, {})];
+  XCTAssertEqualObjects(docMapToArray([self.localStore executeQuery:query]), @[]);
+
+  [self applyRemoteEvent:FSTTestAddedRemoteEvent(
+                             FSTTestDoc("foo/bar", 1, @{@"it" : @"base"}, FSTDocumentStateSynced),
+                             {targetID})];
+  XCTAssertEqualObjects(docMapToArray([self.localStore executeQuery:query]), (@[
+                          FSTTestDoc("foo/bar", 1, @{@"foo" : @"bar", @"it" : @"base"},
+                                     FSTDocumentStateLocalMutations)
+                        ]));
+
+  [self rejectMutation];
+  XCTAssertEqualObjects(
+      docMapToArray([self.localStore executeQuery:query]),
+      (@[ FSTTestDoc("foo/bar", 1, @{@"it" : @"base"}, FSTDocumentStateSynced) ]));
+}
+
 - (void)testPersistsResumeTokens {
   if ([self isTestBaseClass]) return;
   // This test only works in the absence of the FSTEagerGarbageCollector.
@@ -940,6 +1066,46 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertGreaterThan(newSequenceNumber, initialSequenceNumber);
 }
 
+- (void)testPersistsResumeTokensOfIdleTargets {
+  if ([self isTestBaseClass]) return;
+  if ([self gcIsEager]) return;
+
+  FSTQuery *query = FSTTestQuery("foo/bar");
+  FSTQueryData *queryData = [self.localStore allocateQuery:query];
+  TargetId targetID = queryData.targetID;
+  auto metadataProvider = TestTargetMetadataProvider::CreateSingleResultProvider(
+      testutil::Key("foo/bar"), std::vector<TargetId>{targetID});
+
+  // Watch refreshes the resume token of the idle target every minute.
+  const int64_t minute = 60 * 1000 * 1000;
+  for (int64_t version = minute; version <= 6 * minute; version += minute) {
+    NSData *resumeToken = FSTTestResumeTokenFromSnapshotVersion(version);
+    WatchTargetChange watchChange{WatchTargetChangeState::Current, {targetID}, resumeToken};
+    WatchChangeAggregator aggregator{&metadataProvider};
+    aggregator.HandleTargetChange(watchChange);
+    [self applyRemoteEvent:aggregator.CreateRemoteEvent(testutil::Version(version))];
+
+    // The first token is persisted, and then one that's five minutes newer.
+    NSData *persisted = self.localStorePersistence.queryCache->GetTarget(query).resumeToken;
+    int64_t persistedVersion = version < 6 * minute ? minute : version;
+    XCTAssertEqualObjects(persisted, FSTTestResumeTokenFromSnapshotVersion(persistedVersion));
+  }
+}
+
+- (void)testWritesStreamTokensWhenFlushed {
+  if ([self isTestBaseClass]) return;
+
+  NSData *streamToken = [@"token" dataUsingEncoding:NSUTF8StringEncoding];
+  [self.localStore setLastStreamToken:streamToken];
+  XCTAssertEqualObjects([self.localStore lastStreamToken], streamToken);
+  [self.localStore flushLastStreamToken];
+
+  FSTLocalStore *restarted = [[FSTLocalStore alloc] initWithPersistence:self.localStorePersistence
+                                                            initialUser:User::Unauthenticated()];
+  [restarted start];
+  XCTAssertEqualObjects([restarted lastStreamToken], streamToken);
+}
+
 - (void)testRemoteDocumentKeysForTarget {
   if ([self isTestBaseClass]) return;
 
@@ -1160,6 +1326,73 @@ NS_ASSUME_NONNULL_BEGIN
   FSTAssertChanged(@[ FSTTestDoc("foo/bar", 1, @{@"sum" : @1}, FSTDocumentStateLocalMutations) ]);
 }
 
+- (void)testCompactsRepeatedWritesToTheSameDocument {
+  if ([self isTestBaseClass]) return;
+
+  self.localStore.mutationCompactionEnabled = YES;
+  FSTLocalWriteResult *first = [self.localStore
+      locallyWriteMutations:{FSTTestSetMutation(@"foo/bar", @{@"foo" : @"old", @"a" : @1})}];
+  FSTLocalWriteResult *second = [self.localStore
+      locallyWriteMutations:{FSTTestPatchMutation("foo/bar", @{@"foo" : @"bar"}, {})}];
+  XCTAssertEqual(first.batchID, second.batchID);
+  FSTAssertContains(FSTTestDoc("foo/bar", 0, @{@"foo" : @"bar", @"a" : @1},
+                               FSTDocumentStateLocalMutations));
+
+  FSTMutationBatch *batch = [self.localStore nextMutationBatchAfterBatchID:kBatchIdUnknown];
+  XCTAssertEqual(batch.mutations.size(), 1);
+  XCTAssertEqualObjects(batch.mutations[0],
+                        FSTTestSetMutation(@"foo/bar", @{@"foo" : @"bar", @"a" : @1}));
+  XCTAssertNil([self.localStore nextMutationBatchAfterBatchID:batch.batchID]);
+}
+
+- (void)testDoesNotCompactWritesByDefault {
+  if ([self isTestBaseClass]) return;
+
+  FSTLocalWriteResult *first =
+      [self.localStore locallyWriteMutations:{FSTTestSetMutation(@"foo/bar", @{@"foo" : @"old"})}];
+  FSTLocalWriteResult *second =
+      [self.localStore locallyWriteMutations:{FSTTestSetMutation(@"foo/bar", @{@"foo" : @"bar"})}];
+  XCTAssertNotEqual(first.batchID, second.batchID);
+}
+
+- (void)testDoesNotCompactWritesIntoBatchesHandedOutForSending {
+  if ([self isTestBaseClass]) return;
+
+  self.localStore.mutationCompactionEnabled = YES;
+  FSTLocalWriteResult *first =
+      [self.localStore locallyWriteMutations:{FSTTestSetMutation(@"foo/bar", @{@"foo" : @"old"})}];
+  XCTAssertNotNil([self.localStore nextMutationBatchAfterBatchID:kBatchIdUnknown]);
+
+  FSTLocalWriteResult *second =
+      [self.localStore locallyWriteMutations:{FSTTestSetMutation(@"foo/bar", @{@"foo" : @"bar"})}];
+  XCTAssertNotEqual(first.batchID, second.batchID);
+  FSTAssertContains(FSTTestDoc("foo/bar", 0, @{@"foo" : @"bar"}, FSTDocumentStateLocalMutations));
+}
+
+- (void)testDoesNotCompactWritesAcrossOtherDocuments {
+  if ([self isTestBaseClass]) return;
+
+  self.localStore.mutationCompactionEnabled = YES;
+  FSTLocalWriteResult *first =
+      [self.localStore locallyWriteMutations:{FSTTestSetMutation(@"foo/bar", @{@"foo" : @"old"})}];
+  [self.localStore locallyWriteMutations:{FSTTestSetMutation(@"foo/baz", @{@"foo" : @"baz"})}];
+  FSTLocalWriteResult *third =
+      [self.localStore locallyWriteMutations:{FSTTestSetMutation(@"foo/bar", @{@"foo" : @"bar"})}];
+  XCTAssertNotEqual(first.batchID, third.batchID);
+}
+
+- (void)testDoesNotCompactIntoWritesWithPreconditions {
+  if ([self isTestBaseClass]) return;
+
+  self.localStore.mutationCompactionEnabled = YES;
+  // The update fails if the document doesn't exist, which the set alone wouldn't.
+  FSTLocalWriteResult *first = [self.localStore
+      locallyWriteMutations:{FSTTestPatchMutation("foo/bar", @{@"foo" : @"old"}, {})}];
+  FSTLocalWriteResult *second =
+      [self.localStore locallyWriteMutations:{FSTTestSetMutation(@"foo/bar", @{@"foo" : @"bar"})}];
+  XCTAssertNotEqual(first.batchID, second.batchID);
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
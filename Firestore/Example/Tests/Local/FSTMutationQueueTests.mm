@@ -186,6 +186,30 @@ NS_ASSUME_NONNULL_BEGIN
   });
 }
 
+- (void)testReplaceMutationBatch {
+  if ([self isTestBaseClass]) return;
+
+  self.persistence.run("testReplaceMutationBatch", [&]() {
+    std::vector<FSTMutationBatch *> batches = [self createBatches:3];
+    FSTMutationBatch *original = batches[1];
+
+    FSTMutationBatch *replacement =
+        [[FSTMutationBatch alloc] initWithBatchID:original.batchID
+                                   localWriteTime:original.localWriteTime
+                                    baseMutations:{}
+                                        mutations:{FSTTestSetMutation(@"foo/bar", @{@"a" : @2})}];
+    self.mutationQueue->ReplaceMutationBatch(replacement);
+
+    XCTAssertEqualObjects(self.mutationQueue->LookupMutationBatch(original.batchID), replacement);
+    XCTAssertEqual([self batchCount], 3);
+
+    std::vector<FSTMutationBatch *> expected{batches[0], replacement, batches[2]};
+    std::vector<FSTMutationBatch *> matches =
+        self.mutationQueue->AllMutationBatchesAffectingDocumentKey(testutil::Key("foo/bar"));
+    FSTAssertEqualVectors(matches, expected);
+  });
+}
+
 - (void)testAllMutationBatchesAffectingDocumentKey {
   if ([self isTestBaseClass]) return;
 
@@ -17,6 +17,8 @@
 #import "Firestore/Example/Tests/Local/FSTRemoteDocumentCacheTests.h"
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Local/FSTPersistence.h"
@@ -24,6 +26,9 @@
 
 #import "Firestore/Example/Tests/Util/FSTHelpers.h"
 
+#include "Firestore/core/src/firebase/firestore/local/field_index.h"
+#include "Firestore/core/src/firebase/firestore/local/field_index_encoding.h"
+#include "Firestore/core/src/firebase/firestore/local/index_manager.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_remote_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
@@ -35,6 +40,8 @@
 
 namespace testutil = firebase::firestore::testutil;
 namespace util = firebase::firestore::util;
+using firebase::firestore::local::FieldIndex;
+using firebase::firestore::local::FieldIndexRangeForFilter;
 using firebase::firestore::local::RemoteDocumentCache;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentKeySet;
@@ -187,6 +194,110 @@ static const int kVersion = 42;
   });
 }
 
+- (void)testDocumentsMatchingIndexRange {
+  if (!self.remoteDocumentCache) return;
+
+  self.persistence.run("testDocumentsMatchingIndexRange", [&]() {
+    self.remoteDocumentCache->Add(FSTTestDoc("a/1", kVersion, @{@"n" : @2}, FSTDocumentStateSynced));
+    self.remoteDocumentCache->Add(FSTTestDoc("b/1", kVersion, @{@"n" : @1}, FSTDocumentStateSynced));
+    self.remoteDocumentCache->Add(FSTTestDoc("b/2", kVersion, @{@"n" : @2}, FSTDocumentStateSynced));
+    self.remoteDocumentCache->Add(FSTTestDoc("b/3", kVersion, @{@"n" : @3}, FSTDocumentStateSynced));
+    self.remoteDocumentCache->Add(
+        FSTTestDoc("b/1/z/1", kVersion, @{@"n" : @2}, FSTDocumentStateSynced));
+
+    // Backfill existing documents, then check that later writes keep the index up to date.
+    FieldIndex index{"b", testutil::Field("n")};
+    if ([self.persistence indexManager]->AddFieldIndex(index)) {
+      self.remoteDocumentCache->BackfillFieldIndex(index);
+    }
+    self.remoteDocumentCache->Add(FSTTestDoc("b/4", kVersion, @{@"n" : @5}, FSTDocumentStateSynced));
+    self.remoteDocumentCache->Add(FSTTestDoc("b/5", kVersion, @{@"n" : @"5"}, FSTDocumentStateSynced));
+    self.remoteDocumentCache->Add(FSTTestDoc("b/2", kVersion, @{@"n" : @0}, FSTDocumentStateSynced));
+    self.remoteDocumentCache->Remove(testutil::Key("b/3"));
+
+    FSTFilter *filter = FSTTestFilter("n", @">=", @2);
+    FSTQuery *query = [FSTTestQuery("b") queryByAddingFilter:filter];
+    auto range = FieldIndexRangeForFilter(index, filter);
+    XCTAssertTrue(range.has_value());
+
+    DocumentMap results = self.remoteDocumentCache->GetMatchingUsingIndex(query, *range);
+    [self expectMap:results.underlying_map()
+        hasDocsInArray:@[ FSTTestDoc("b/4", kVersion, @{@"n" : @5}, FSTDocumentStateSynced) ]
+               exactly:YES];
+  });
+}
+
+- (void)testDocumentsMatchingArrayIndexRange {
+  if (!self.remoteDocumentCache) return;
+
+  self.persistence.run("testDocumentsMatchingArrayIndexRange", [&]() {
+    self.remoteDocumentCache->Add(
+        FSTTestDoc("b/1", kVersion, @{@"tags" : @[ @"x", @"y" ]}, FSTDocumentStateSynced));
+    self.remoteDocumentCache->Add(
+        FSTTestDoc("b/2", kVersion, @{@"tags" : @[ @"y" ]}, FSTDocumentStateSynced));
+    self.remoteDocumentCache->Add(
+        FSTTestDoc("b/3", kVersion, @{@"tags" : @"x"}, FSTDocumentStateSynced));
+
+    FieldIndex index{"b", testutil::Field("tags"), FieldIndex::Kind::ArrayContains};
+    if ([self.persistence indexManager]->AddFieldIndex(index)) {
+      self.remoteDocumentCache->BackfillFieldIndex(index);
+    }
+    self.remoteDocumentCache->Add(
+        FSTTestDoc("b/4", kVersion, @{@"tags" : @[ @"x", @"x" ]}, FSTDocumentStateSynced));
+    self.remoteDocumentCache->Add(
+        FSTTestDoc("b/1", kVersion, @{@"tags" : @[ @"y" ]}, FSTDocumentStateSynced));
+
+    FSTFilter *filter = FSTTestFilter("tags", @"array_contains", @"x");
+    FSTQuery *query = [FSTTestQuery("b") queryByAddingFilter:filter];
+    auto range = FieldIndexRangeForFilter(index, filter);
+    XCTAssertTrue(range.has_value());
+    XCTAssertFalse(FieldIndexRangeForFilter(index, FSTTestFilter("tags", @"==", @"x")).has_value());
+    XCTAssertFalse(
+        FieldIndexRangeForFilter(FieldIndex{"b", testutil::Field("tags")}, filter).has_value());
+
+    DocumentMap results = self.remoteDocumentCache->GetMatchingUsingIndex(query, *range);
+    [self expectMap:results.underlying_map()
+        hasDocsInArray:@[ FSTTestDoc("b/4", kVersion, @{@"tags" : @[ @"x", @"x" ]},
+                                     FSTDocumentStateSynced) ]
+               exactly:YES];
+  });
+}
+
+- (void)testDocumentsMatchingSeveralQueries {
+  if (!self.remoteDocumentCache) return;
+
+  // Enough collections for the scans to run concurrently where supported.
+  const int kRooms = 10;
+  self.persistence.run("testDocumentsMatchingSeveralQueries setup", [&]() {
+    for (int i = 0; i < kRooms; ++i) {
+      std::string room = "rooms/" + std::to_string(i) + "/messages";
+      [self setTestDocumentAtPath:room + "/1"];
+      [self setTestDocumentAtPath:room + "/2"];
+      [self setTestDocumentAtPath:room + "/1/z/1"];
+    }
+  });
+
+  self.persistence.run("testDocumentsMatchingSeveralQueries", [&]() {
+    std::vector<FSTQuery *> queries;
+    for (int i = 0; i <= kRooms; ++i) {
+      queries.push_back(FSTTestQuery("rooms/" + std::to_string(i) + "/messages"));
+    }
+
+    std::vector<DocumentMap> results = self.remoteDocumentCache->GetMatchingForQueries(queries);
+    XCTAssertEqual(results.size(), queries.size());
+    for (int i = 0; i < kRooms; ++i) {
+      std::string room = "rooms/" + std::to_string(i) + "/messages";
+      [self expectMap:results[i].underlying_map()
+          hasDocsInArray:@[
+            FSTTestDoc(room + "/1", kVersion, _kDocData, FSTDocumentStateSynced),
+            FSTTestDoc(room + "/2", kVersion, _kDocData, FSTDocumentStateSynced)
+          ]
+                 exactly:YES];
+    }
+    XCTAssertTrue(results[kRooms].empty());
+  });
+}
+
 #pragma mark - Helpers
 - (FSTDocument *)setTestDocumentAtPath:(const absl::string_view)path {
   FSTDocument *doc = FSTTestDoc(path, kVersion, _kDocData, FSTDocumentStateSynced);
@@ -100,6 +100,31 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertEqual(setWithoutDoc3.size(), 1);
 }
 
+- (void)testNthDocument {
+  DocumentSet set = FSTTestDocSet(_comp, @[ _doc1, _doc2, _doc3 ]);
+
+  XCTAssertEqualObjects(*set.nth(0), _doc3);
+  XCTAssertEqualObjects(*set.nth(1), _doc1);
+  XCTAssertEqualObjects(*set.nth(2), _doc2);
+  XCTAssertTrue(set.nth(3) == set.end());
+  XCTAssertEqual(set.IndexOf((*set.nth(1)).key), 1);
+}
+
+- (void)testTruncate {
+  DocumentSet set = FSTTestDocSet(_comp, @[ _doc1, _doc2, _doc3 ]);
+
+  DocumentSet truncated = set.Truncate(2);
+  XC_ASSERT_THAT(truncated, ElementsAre(_doc3, _doc1));
+  XCTAssertEqual(truncated.size(), 2);
+  XCTAssertFalse(truncated.ContainsKey(_doc2.key));
+
+  // Original remains unchanged
+  XC_ASSERT_THAT(set, ElementsAre(_doc3, _doc1, _doc2));
+
+  XCTAssertEqual(set.Truncate(0).size(), 0);
+  XCTAssertTrue(set.Truncate(5) == set);
+}
+
 - (void)testUpdates {
   DocumentSet set = FSTTestDocSet(_comp, @[ _doc1, _doc2, _doc3 ]);
 
@@ -137,6 +162,45 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertNotEqual(set1, sortedSet1);
 }
 
+- (void)testEqualSetsHaveEqualHashes {
+  DocumentSet set1 = FSTTestDocSet(_comp, @[ _doc1, _doc2, _doc3 ]);
+  DocumentSet set2 = FSTTestDocSet(_comp, @[ _doc3, _doc2, _doc1 ]);
+  XCTAssertEqual(set1, set2);
+  XCTAssertEqual(set1.Hash(), set2.Hash());
+
+  DocumentSet copy = set1;
+  XCTAssertEqual(copy, set1);
+  XCTAssertEqual(copy.Hash(), set1.Hash());
+
+  // Building the same contents another way gives the same hash.
+  DocumentSet roundTrip = set1.erase(_doc2.key).insert(_doc2);
+  XCTAssertEqual(roundTrip, set1);
+  XCTAssertEqual(roundTrip.Hash(), set1.Hash());
+
+  DocumentSet truncated = set1.Truncate(2);
+  DocumentSet expected = FSTTestDocSet(_comp, @[ _doc3, _doc1 ]);
+  XCTAssertEqual(truncated, expected);
+  XCTAssertEqual(truncated.Hash(), expected.Hash());
+
+  DocumentSet empty{_comp};
+  XCTAssertEqual(set1.Truncate(0).Hash(), empty.Hash());
+}
+
+- (void)testChangedDocumentsChangeTheHash {
+  DocumentSet set = FSTTestDocSet(_comp, @[ _doc1, _doc2, _doc3 ]);
+
+  FSTDocument *doc2Prime = FSTTestDoc("docs/2", 0, @{@"sort" : @9}, FSTDocumentStateSynced);
+  DocumentSet updated = set.insert(doc2Prime);
+  XCTAssertNotEqual(updated, set);
+  XCTAssertNotEqual(updated.Hash(), set.Hash());
+
+  FSTDocument *doc2Local =
+      FSTTestDoc("docs/2", 0, @{@"sort" : @3}, FSTDocumentStateLocalMutations);
+  DocumentSet pending = set.insert(doc2Local);
+  XCTAssertNotEqual(pending, set);
+  XCTAssertNotEqual(pending.Hash(), set.Hash());
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -88,6 +88,18 @@ NS_ASSUME_NONNULL_BEGIN
       FSTTestDoc("messages/first", 1, @{@"a" : @1}, FSTDocumentStateLocalMutations));
 }
 
+- (void)testHasSameDataIgnoresVersionAndState {
+  FSTDocument *doc = FSTTestDoc("messages/first", 1, @{@"a" : @1}, FSTDocumentStateSynced);
+  FSTDocument *newer =
+      FSTTestDoc("messages/first", 2, @{@"a" : @1}, FSTDocumentStateLocalMutations);
+  FSTDocument *changed = FSTTestDoc("messages/first", 2, @{@"a" : @2}, FSTDocumentStateSynced);
+
+  XCTAssertTrue([doc hasSameDataAs:newer]);
+  XCTAssertEqual(doc.contentHash, newer.contentHash);
+  XCTAssertFalse([doc hasSameDataAs:changed]);
+  XCTAssertFalse([changed hasSameDataAs:doc]);
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
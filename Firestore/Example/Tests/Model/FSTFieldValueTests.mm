@@ -27,6 +27,7 @@
 #import "Firestore/Example/Tests/Util/FSTHelpers.h"
 
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/field_mask.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
@@ -34,6 +35,7 @@
 namespace testutil = firebase::firestore::testutil;
 namespace util = firebase::firestore::util;
 using firebase::firestore::model::DatabaseId;
+using firebase::firestore::model::FieldMask;
 using firebase::firestore::model::FieldValue;
 
 /** Helper to wrap the values in a set of equality groups using FSTTestFieldValue(). */
@@ -307,6 +309,29 @@ union DoubleBits {
   XCTAssertEqual(actual.type, FieldValue::Type::Object);
 }
 
+- (void)testWrapsCppValuesInTheMatchingClasses {
+  FIRTimestamp *timestamp = [[FIRTimestamp alloc] initWithSeconds:100 nanoseconds:5000];
+  XCTAssertEqualObjects(FieldValue::FromTimestamp({100, 5000}).Wrap(),
+                        [FSTTimestampValue timestampValue:timestamp]);
+
+  FIRGeoPoint *geoPoint = [[FIRGeoPoint alloc] initWithLatitude:1.5 longitude:-2];
+  XCTAssertEqualObjects(FieldValue::FromGeoPoint({1.5, -2}).Wrap(),
+                        [FSTGeoPointValue geoPointValue:geoPoint]);
+
+  const uint8_t bytes[] = {1, 2, 3};
+  XCTAssertEqualObjects(FieldValue::FromBlob(bytes, sizeof(bytes)).Wrap(),
+                        [FSTBlobValue blobValue:[NSData dataWithBytes:bytes length:3]]);
+
+  NSArray<FSTFieldValue *> *elements =
+      @[ [FSTNullValue nullValue], [FSTIntegerValue integerValue:1] ];
+  XCTAssertEqualObjects(
+      FieldValue::FromArray({FieldValue::Null(), FieldValue::FromInteger(1)}).Wrap(),
+      [[FSTArrayValue alloc] initWithValueNoCopy:elements]);
+
+  FieldValue::Map map = FieldValue::Map{}.insert("a", FieldValue::FromDouble(0.5));
+  XCTAssertEqualObjects(FieldValue::FromMap(map).Wrap(), FSTTestObjectValue(@{@"a" : @0.5}));
+}
+
 - (void)testExtractsFields {
   FSTObjectValue *obj = FSTTestObjectValue(@{@"foo" : @{@"a" : @YES, @"b" : @"string"}});
   FSTAssertIsKindOfClass(obj, FSTObjectValue);
@@ -422,6 +447,16 @@ union DoubleBits {
   XCTAssertEqualObjects(mod, FSTTestFieldValue(@{}));
 }
 
+- (void)testAppliesFieldMasks {
+  FSTObjectValue *old = FSTTestObjectValue(@{@"a" : @{@"b" : @1, @"c" : @2}, @"d" : @3});
+  FSTObjectValue *mod =
+      [old objectByApplyingFieldMask:FieldMask{testutil::Field("a.b"), testutil::Field("e")}];
+  XCTAssertEqualObjects(mod, FSTTestFieldValue(@{@"a" : @{@"b" : @1}}));
+
+  mod = [old objectByApplyingFieldMask:FieldMask{testutil::Field("d")}];
+  XCTAssertEqualObjects(mod, FSTTestFieldValue(@{@"d" : @3}));
+}
+
 - (void)testArrays {
   FSTArrayValue *expected = [[FSTArrayValue alloc]
       initWithValueNoCopy:@[ FieldValue::FromString("value").Wrap(), FieldValue::True().Wrap() ]];
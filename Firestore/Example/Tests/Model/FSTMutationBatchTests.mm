@@ -0,0 +1,107 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "Firestore/Source/Model/FSTMutationBatch.h"
+
+#import <FirebaseFirestore/FIRTimestamp.h>
+#import <XCTest/XCTest.h>
+
+#include <vector>
+
+#import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Model/FSTMutation.h"
+
+#import "Firestore/Example/Tests/Util/FSTHelpers.h"
+
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+
+namespace testutil = firebase::firestore::testutil;
+using firebase::firestore::model::MaybeDocumentMap;
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface FSTMutationBatchTests : XCTestCase
+@end
+
+@implementation FSTMutationBatchTests
+
+- (FSTMutationBatch *)batchWithMutations:(std::vector<FSTMutation *> &&)mutations {
+  return [[FSTMutationBatch alloc] initWithBatchID:1
+                                    localWriteTime:[FIRTimestamp timestamp]
+                                     baseMutations:{}
+                                         mutations:std::move(mutations)];
+}
+
+- (void)testAppliesToDocumentsInMap {
+  FSTDocument *doc1 = FSTTestDoc("coll/doc1", 1, @{@"a" : @1}, FSTDocumentStateSynced);
+  FSTDocument *doc2 = FSTTestDoc("coll/doc2", 1, @{@"a" : @2}, FSTDocumentStateSynced);
+  MaybeDocumentMap documents = FSTTestDocUpdates(@[ doc1, doc2 ]);
+
+  FSTMutationBatch *batch = [self batchWithMutations:{
+    FSTTestPatchMutation("coll/doc1", @{@"b" : @1}, {}),
+    FSTTestPatchMutation("coll/doc1", @{@"c" : @1}, {}),
+    FSTTestSetMutation(@"coll/doc3", @{@"a" : @3}),
+  }];
+
+  MaybeDocumentMap result = [batch applyToLocalDocuments:documents];
+
+  XCTAssertEqual(result.size(), 2);
+  XCTAssertEqualObjects(result.find(testutil::Key("coll/doc1"))->second,
+                        FSTTestDoc("coll/doc1", 1, (@{@"a" : @1, @"b" : @1, @"c" : @1}),
+                                   FSTDocumentStateLocalMutations));
+  XCTAssertEqualObjects([batch applyToLocalDocument:doc1 documentKey:testutil::Key("coll/doc1")],
+                        result.find(testutil::Key("coll/doc1"))->second);
+
+  // Documents the batch doesn't affect are left as they were.
+  XCTAssertEqual(result.find(testutil::Key("coll/doc2"))->second, doc2);
+}
+
+- (void)testAppliesToMissingDocumentsInMap {
+  MaybeDocumentMap documents;
+  documents = documents.insert(testutil::Key("coll/doc1"), nil);
+
+  FSTMutationBatch *batch = [self batchWithMutations:{
+    FSTTestSetMutation(@"coll/doc1", @{@"a" : @1}),
+  }];
+
+  MaybeDocumentMap result = [batch applyToLocalDocuments:documents];
+  XCTAssertEqual(result.size(), 1);
+  XCTAssertEqualObjects(result.find(testutil::Key("coll/doc1"))->second,
+                        FSTTestDoc("coll/doc1", 0, @{@"a" : @1}, FSTDocumentStateLocalMutations));
+}
+
+- (void)testAppliesToDocumentSetIncludingMissingDocuments {
+  FSTDocument *doc1 = FSTTestDoc("coll/doc1", 1, @{@"a" : @1}, FSTDocumentStateSynced);
+  MaybeDocumentMap documents = FSTTestDocUpdates(@[ doc1 ]);
+
+  FSTMutationBatch *batch = [self batchWithMutations:{
+    FSTTestDeleteMutation(@"coll/doc1"),
+    FSTTestSetMutation(@"coll/doc2", @{@"a" : @2}),
+  }];
+
+  MaybeDocumentMap result = [batch applyToLocalDocumentSet:documents];
+
+  XCTAssertEqual(result.size(), 2);
+  XCTAssertEqualObjects(result.find(testutil::Key("coll/doc1"))->second,
+                        FSTTestDeletedDoc("coll/doc1", 0, NO));
+  XCTAssertEqualObjects(result.find(testutil::Key("coll/doc2"))->second,
+                        FSTTestDoc("coll/doc2", 0, @{@"a" : @2}, FSTDocumentStateLocalMutations));
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -375,6 +375,14 @@ using firebase::firestore::model::TransformOperation;
   [self transformBaseDoc:baseDoc applyTransform:transform expecting:expected];
 }
 
+- (void)testAppliesLocalArrayRemoveTransformWithDuplicateExistingElements {
+  // Removing an element removes every occurrence of it.
+  auto baseDoc = @{@"array" : @[ @1, @2, @1, @3, @2 ]};
+  auto transform = @{@"array" : [FIRFieldValue fieldValueForArrayRemove:@[ @1, @2 ]]};
+  auto expected = @{@"array" : @[ @3 ]};
+  [self transformBaseDoc:baseDoc applyTransform:transform expecting:expected];
+}
+
 - (void)testAppliesLocalArrayRemoveTransformWithNonPrimitiveElements {
   // Remove nested object values (one existing, one not).
   auto baseDoc = @{@"array" : @[ @1, @{@"a" : @"b"} ]};
@@ -17,6 +17,7 @@
 #import <XCTest/XCTest.h>
 
 #include <memory>
+#include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -27,6 +28,7 @@
 
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/remote/bloom_filter.h"
 #include "Firestore/core/src/firebase/firestore/remote/existence_filter.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
@@ -41,11 +43,13 @@ using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::model::TargetId;
+using firebase::firestore::remote::BloomFilter;
 using firebase::firestore::remote::DocumentWatchChange;
 using firebase::firestore::remote::ExistenceFilter;
 using firebase::firestore::remote::ExistenceFilterWatchChange;
 using firebase::firestore::remote::RemoteEvent;
 using firebase::firestore::remote::TargetChange;
+using firebase::firestore::remote::TargetStatistics;
 using firebase::firestore::remote::TestTargetMetadataProvider;
 using firebase::firestore::remote::WatchChange;
 using firebase::firestore::remote::WatchChangeAggregator;
@@ -425,6 +429,41 @@ std::unique_ptr<WatchTargetChange> MakeTargetChange(WatchTargetChangeState state
   XCTAssertTrue(event.target_changes().at(2) == targetChange2);
 }
 
+- (void)testWillHandleDocumentInManyTargets {
+  std::unordered_map<TargetId, FSTQueryData *> targetMap;
+  std::vector<TargetId> targetIDs;
+  std::vector<TargetId> leftTargetIDs;
+  for (TargetId targetID = 1; targetID <= 100; ++targetID) {
+    targetMap[targetID] = [self queryDataForTargets:{targetID}].at(targetID);
+    targetIDs.push_back(targetID);
+    if (targetID > 50) leftTargetIDs.push_back(targetID);
+  }
+
+  // The document enters every target and then leaves half of them again.
+  FSTDocument *doc1a = FSTTestDoc("docs/1", 1, @{@"value" : @1}, FSTDocumentStateSynced);
+  auto change1 = MakeDocChange(targetIDs, {}, doc1a.key, doc1a);
+  FSTDocument *doc1b = FSTTestDoc("docs/1", 2, @{@"value" : @2}, FSTDocumentStateSynced);
+  auto change2 = MakeDocChange({}, leftTargetIDs, doc1b.key, doc1b);
+
+  RemoteEvent event =
+      [self remoteEventAtSnapshotVersion:3
+                               targetMap:targetMap
+                    outstandingResponses:_noOutstandingResponses
+                            existingKeys:DocumentKeySet{}
+                                 changes:Changes(std::move(change1), std::move(change2))];
+  XCTAssertEqual(event.document_updates().size(), 1);
+  XCTAssertEqualObjects(event.document_updates().at(doc1b.key), doc1b);
+
+  XCTAssertEqual(event.target_changes().size(), 100);
+  TargetChange added{_resumeToken1, false, DocumentKeySet{doc1a.key}, DocumentKeySet{},
+                     DocumentKeySet{}};
+  TargetChange unchanged{_resumeToken1, false, DocumentKeySet{}, DocumentKeySet{},
+                         DocumentKeySet{}};
+  for (TargetId targetID : targetIDs) {
+    XCTAssertTrue(event.target_changes().at(targetID) == (targetID > 50 ? unchanged : added));
+  }
+}
+
 - (void)testTargetCurrentChangeWillMarkTheTargetCurrent {
   std::unordered_map<TargetId, FSTQueryData *> targetMap{[self queryDataForTargets:{1}]};
 
@@ -559,6 +598,67 @@ std::unique_ptr<WatchTargetChange> MakeTargetChange(WatchTargetChangeState state
   XCTAssertEqual(event.document_updates().size(), 0);
 }
 
+- (void)testExistenceFilterMismatchWithBloomFilterRemovesMissingDocuments {
+  std::unordered_map<TargetId, FSTQueryData *> targetMap{[self queryDataForTargets:{1}]};
+
+  FSTDocument *doc1 = FSTTestDoc("docs/1", 1, @{@"value" : @1}, FSTDocumentStateSynced);
+  FSTDocument *doc2 = FSTTestDoc("docs/2", 2, @{@"value" : @2}, FSTDocumentStateSynced);
+  auto change1 = MakeTargetChange(WatchTargetChangeState::Current, {1}, _resumeToken1);
+
+  WatchChangeAggregator aggregator =
+      [self aggregatorWithTargetMap:targetMap
+               outstandingResponses:_noOutstandingResponses
+                       existingKeys:DocumentKeySet{doc1.key, doc2.key}
+                            changes:Changes(std::move(change1))];
+  aggregator.CreateRemoteEvent(testutil::Version(3));
+
+  // A bloom filter that only contains
+  // "projects/project/databases/(default)/documents/docs/1".
+  BloomFilter bloomFilter =
+      BloomFilter::Create(std::string("\x00\x00\x10\x00\x02\x40\x00\x00", 8), 0, 3)
+          .ValueOrDie();
+  ExistenceFilterWatchChange change2{ExistenceFilter{1, bloomFilter}, 1};
+  aggregator.HandleExistenceFilter(change2);
+
+  RemoteEvent event = aggregator.CreateRemoteEvent(testutil::Version(4));
+
+  // Only the document that is missing from the bloom filter is removed, and the target is not
+  // reset.
+  XCTAssertEqual(event.target_changes().size(), 1);
+  TargetChange targetChange{_resumeToken1, true, DocumentKeySet{}, DocumentKeySet{},
+                            DocumentKeySet{doc2.key}};
+  XCTAssertTrue(event.target_changes().at(1) == targetChange);
+  XCTAssertEqual(event.target_mismatches().size(), 0);
+  XCTAssertEqual(event.document_updates().size(), 0);
+}
+
+- (void)testExistenceFilterMismatchWithInconclusiveBloomFilterClearsTarget {
+  std::unordered_map<TargetId, FSTQueryData *> targetMap{[self queryDataForTargets:{1}]};
+
+  FSTDocument *doc1 = FSTTestDoc("docs/1", 1, @{@"value" : @1}, FSTDocumentStateSynced);
+  FSTDocument *doc2 = FSTTestDoc("docs/2", 2, @{@"value" : @2}, FSTDocumentStateSynced);
+  auto change1 = MakeTargetChange(WatchTargetChangeState::Current, {1}, _resumeToken1);
+
+  WatchChangeAggregator aggregator =
+      [self aggregatorWithTargetMap:targetMap
+               outstandingResponses:_noOutstandingResponses
+                       existingKeys:DocumentKeySet{doc1.key, doc2.key}
+                            changes:Changes(std::move(change1))];
+  aggregator.CreateRemoteEvent(testutil::Version(3));
+
+  // A bloom filter with every bit set, which might contain any document.
+  BloomFilter bloomFilter = BloomFilter::Create("\xff", 0, 1).ValueOrDie();
+  ExistenceFilterWatchChange change2{ExistenceFilter{1, bloomFilter}, 1};
+  aggregator.HandleExistenceFilter(change2);
+
+  RemoteEvent event = aggregator.CreateRemoteEvent(testutil::Version(4));
+
+  TargetChange targetChange{[NSData data], false, DocumentKeySet{}, DocumentKeySet{},
+                            DocumentKeySet{doc1.key, doc2.key}};
+  XCTAssertTrue(event.target_changes().at(1) == targetChange);
+  XCTAssertEqual(event.target_mismatches().size(), 1);
+}
+
 - (void)testExistenceFilterMismatchRemovesCurrentChanges {
   std::unordered_map<TargetId, FSTQueryData *> targetMap{[self queryDataForTargets:{1}]};
 
@@ -649,6 +749,50 @@ std::unique_ptr<WatchTargetChange> MakeTargetChange(WatchTargetChangeState state
   XCTAssertTrue(event.target_changes().at(1) == targetChange1);
 }
 
+- (void)testRecordsTargetStatistics {
+  std::unordered_map<TargetId, FSTQueryData *> targetMap{[self queryDataForTargets:{1}]};
+
+  FSTDocument *doc1 = FSTTestDoc("docs/1", 1, @{@"value" : @1}, FSTDocumentStateSynced);
+  auto change1 = MakeDocChange({1}, {}, doc1.key, doc1);
+  change1->set_encoded_size(100);
+  FSTDocument *doc2 = FSTTestDoc("docs/2", 2, @{@"value" : @2}, FSTDocumentStateSynced);
+  auto change2 = MakeDocChange({1}, {}, doc2.key, doc2);
+  change2->set_encoded_size(50);
+
+  WatchChangeAggregator aggregator =
+      [self aggregatorWithTargetMap:targetMap
+               outstandingResponses:_noOutstandingResponses
+                       existingKeys:DocumentKeySet {}
+                            changes:Changes(std::move(change1), std::move(change2))];
+
+  TargetStatistics *statistics = _targetMetadataProvider.GetStatisticsForTarget(1);
+  XCTAssertEqual(statistics->documents_added, 2);
+  XCTAssertEqual(statistics->documents_modified, 0);
+  XCTAssertEqual(statistics->bytes_received, 150);
+
+  FSTDocument *updatedDoc1 = FSTTestDoc("docs/1", 3, @{@"value" : @3}, FSTDocumentStateSynced);
+  DocumentWatchChange change3{{1}, {}, updatedDoc1.key, updatedDoc1};
+  change3.set_encoded_size(20);
+  aggregator.HandleDocumentChange(change3);
+
+  DocumentWatchChange change4{{}, {1}, doc2.key, nil};
+  change4.set_encoded_size(10);
+  aggregator.HandleDocumentChange(change4);
+
+  XCTAssertEqual(statistics->documents_added, 2);
+  XCTAssertEqual(statistics->documents_modified, 1);
+  XCTAssertEqual(statistics->documents_removed, 1);
+  XCTAssertEqual(statistics->bytes_received, 180);
+
+  ExistenceFilterWatchChange change5{ExistenceFilter{3}, 1};
+  change5.set_encoded_size(5);
+  aggregator.HandleExistenceFilter(change5);
+
+  XCTAssertEqual(statistics->existence_filter_mismatches, 1);
+  XCTAssertEqual(statistics->resets, 1);
+  XCTAssertEqual(statistics->bytes_received, 185);
+}
+
 - (void)testResumeTokensHandledPerTarget {
   std::unordered_map<TargetId, FSTQueryData *> targetMap{[self queryDataForTargets:{1, 2}]};
 
@@ -24,6 +24,7 @@
 #import <XCTest/XCTest.h>
 
 #include <memory>
+#include <string>
 #include <vector>
 
 #import "Firestore/Protos/objc/firestore/local/MaybeDocument.pbobjc.h"
@@ -37,6 +38,7 @@
 #import "Firestore/Protos/objc/google/type/Latlng.pbobjc.h"
 #import "Firestore/Source/API/FIRFieldValue+Internal.h"
 #import "Firestore/Source/Core/FSTQuery.h"
+#import "Firestore/Source/Local/FSTLocalSerializer.h"
 #import "Firestore/Source/Local/FSTQueryData.h"
 #import "Firestore/Source/Model/FSTDocument.h"
 #import "Firestore/Source/Model/FSTDocumentKey.h"
@@ -52,6 +54,7 @@
 #include "Firestore/core/src/firebase/firestore/model/field_mask.h"
 #include "Firestore/core/src/firebase/firestore/model/field_transform.h"
 #include "Firestore/core/src/firebase/firestore/model/precondition.h"
+#include "Firestore/core/src/firebase/firestore/remote/remote_objc_bridge.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
@@ -73,10 +76,17 @@ using firebase::firestore::remote::ExistenceFilterWatchChange;
 using firebase::firestore::remote::WatchChange;
 using firebase::firestore::remote::WatchTargetChange;
 using firebase::firestore::remote::WatchTargetChangeState;
+using firebase::firestore::remote::bridge::WatchStreamSerializer;
+using firebase::firestore::remote::bridge::WriteStreamSerializer;
 using firebase::firestore::util::Status;
 
 namespace {
 
+grpc::ByteBuffer MakeByteBuffer(NSData *data) {
+  grpc::Slice slice{data.bytes, data.length};
+  return grpc::ByteBuffer{&slice, 1};
+}
+
 template <typename T>
 bool Equals(const WatchChange &lhs, const WatchChange &rhs) {
   return static_cast<const T &>(lhs) == static_cast<const T &>(rhs);
@@ -756,6 +766,25 @@ NS_ASSUME_NONNULL_BEGIN
   [self assertRoundTripForQueryData:model proto:expected];
 }
 
+- (void)testDoesNotSendProjections {
+  // Watch must send full documents, since they're stored in the shared remote document cache.
+  FSTQuery *q = [FSTTestQuery("docs")
+      queryBySelectingFields:FieldMask{testutil::Field("a"), testutil::Field("b.c")}];
+  FSTQueryData *model = [self queryDataForQuery:q];
+
+  GCFSTarget *expected = [GCFSTarget message];
+  expected.query.parent = @"projects/p/databases/d/documents";
+  GCFSStructuredQuery_CollectionSelector *from = [GCFSStructuredQuery_CollectionSelector message];
+  from.collectionId = @"docs";
+  [expected.query.structuredQuery.fromArray addObject:from];
+  [expected.query.structuredQuery.orderByArray
+      addObject:[GCFSStructuredQuery_Order messageWithProperty:kDocumentKeyPath ascending:YES]];
+  expected.targetId = 1;
+
+  XCTAssertEqualObjects([self.serializer encodedTarget:model], expected);
+  XCTAssertFalse([self.serializer encodedTarget:model].query.structuredQuery.hasSelect);
+}
+
 - (void)testEncodesResumeTokens {
   FSTQuery *q = FSTTestQuery("docs");
   FSTQueryData *model = [[FSTQueryData alloc] initWithQuery:q
@@ -803,6 +832,25 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertEqualObjects(actualModel, queryData.query);
 }
 
+/**
+ * Asserts that `response` decodes to `expected`, both from protobuf objects and through the watch
+ * stream bridge straight from its encoding.
+ */
+- (void)assertListenResponse:(GCFSListenResponse *)response
+                   decodesTo:(const WatchChange &)expected {
+  std::unique_ptr<WatchChange> actual = [self.serializer decodedWatchChange:response];
+  XCTAssertTrue(IsWatchChangeEqual(*actual, expected));
+
+  WatchStreamSerializer bridge{self.serializer};
+  SnapshotVersion version;
+  Status status;
+  std::unique_ptr<WatchChange> decoded =
+      bridge.DecodeResponse(MakeByteBuffer([response data]), &version, &status);
+  XCTAssertTrue(status.ok(), @"%s", status.ToString().c_str());
+  XCTAssertTrue(IsWatchChangeEqual(*decoded, expected));
+  XCTAssertEqual(version, [self.serializer versionFromListenResponse:response]);
+}
+
 - (void)testConvertsTargetChangeWithAdded {
   WatchTargetChange expected{WatchTargetChangeState::Added, {1, 4}};
   GCFSListenResponse *listenResponse = [GCFSListenResponse message];
@@ -810,8 +858,7 @@ NS_ASSUME_NONNULL_BEGIN
   [listenResponse.targetChange.targetIdsArray addValue:1];
   [listenResponse.targetChange.targetIdsArray addValue:4];
 
-  std::unique_ptr<WatchChange> actual = [self.serializer decodedWatchChange:listenResponse];
-  XCTAssertTrue(IsWatchChangeEqual(*actual, expected));
+  [self assertListenResponse:listenResponse decodesTo:expected];
 }
 
 - (void)testConvertsTargetChangeWithRemoved {
@@ -828,8 +875,7 @@ NS_ASSUME_NONNULL_BEGIN
   [listenResponse.targetChange.targetIdsArray addValue:1];
   [listenResponse.targetChange.targetIdsArray addValue:4];
 
-  std::unique_ptr<WatchChange> actual = [self.serializer decodedWatchChange:listenResponse];
-  XCTAssertTrue(IsWatchChangeEqual(*actual, expected));
+  [self assertListenResponse:listenResponse decodesTo:expected];
 }
 
 - (void)testConvertsTargetChangeWithNoChange {
@@ -839,8 +885,7 @@ NS_ASSUME_NONNULL_BEGIN
   [listenResponse.targetChange.targetIdsArray addValue:1];
   [listenResponse.targetChange.targetIdsArray addValue:4];
 
-  std::unique_ptr<WatchChange> actual = [self.serializer decodedWatchChange:listenResponse];
-  XCTAssertTrue(IsWatchChangeEqual(*actual, expected));
+  [self assertListenResponse:listenResponse decodesTo:expected];
 }
 
 - (void)testConvertsDocumentChangeWithTargetIds {
@@ -857,8 +902,7 @@ NS_ASSUME_NONNULL_BEGIN
   [listenResponse.documentChange.targetIdsArray addValue:1];
   [listenResponse.documentChange.targetIdsArray addValue:2];
 
-  std::unique_ptr<WatchChange> actual = [self.serializer decodedWatchChange:listenResponse];
-  XCTAssertTrue(IsWatchChangeEqual(*actual, expected));
+  [self assertListenResponse:listenResponse decodesTo:expected];
 }
 
 - (void)testConvertsDocumentChangeWithRemovedTargetIds {
@@ -876,8 +920,7 @@ NS_ASSUME_NONNULL_BEGIN
   [listenResponse.documentChange.removedTargetIdsArray addValue:1];
   [listenResponse.documentChange.targetIdsArray addValue:2];
 
-  std::unique_ptr<WatchChange> actual = [self.serializer decodedWatchChange:listenResponse];
-  XCTAssertTrue(IsWatchChangeEqual(*actual, expected));
+  [self assertListenResponse:listenResponse decodesTo:expected];
 }
 
 - (void)testConvertsDocumentChangeWithDeletions {
@@ -890,8 +933,7 @@ NS_ASSUME_NONNULL_BEGIN
   [listenResponse.documentDelete.removedTargetIdsArray addValue:1];
   [listenResponse.documentDelete.removedTargetIdsArray addValue:2];
 
-  std::unique_ptr<WatchChange> actual = [self.serializer decodedWatchChange:listenResponse];
-  XCTAssertTrue(IsWatchChangeEqual(*actual, expected));
+  [self assertListenResponse:listenResponse decodesTo:expected];
 }
 
 - (void)testConvertsDocumentChangeWithRemoves {
@@ -902,8 +944,82 @@ NS_ASSUME_NONNULL_BEGIN
   [listenResponse.documentRemove.removedTargetIdsArray addValue:1];
   [listenResponse.documentRemove.removedTargetIdsArray addValue:2];
 
-  std::unique_ptr<WatchChange> actual = [self.serializer decodedWatchChange:listenResponse];
-  XCTAssertTrue(IsWatchChangeEqual(*actual, expected));
+  [self assertListenResponse:listenResponse decodesTo:expected];
+}
+
+- (void)testDecodesNestedValuesFromEncodedDocumentChange {
+  NSDictionary<NSString *, id> *data = @{
+    @"array" : @[ @1, @"two", @{@"three" : @3.5} ],
+    @"map" : @{@"bool" : @YES, @"null" : [NSNull null]},
+    @"ref" : FSTTestRef("p", "d", @"coll/2")
+  };
+  FSTDocument *doc = FSTTestDoc("coll/1", 5, data, FSTDocumentStateSynced);
+  DocumentWatchChange expected{{1}, {}, FSTTestDocKey(@"coll/1"), doc};
+
+  GCFSListenResponse *listenResponse = [GCFSListenResponse message];
+  listenResponse.documentChange.document.name = [self.serializer encodedDocumentKey:doc.key];
+  listenResponse.documentChange.document.updateTime = [self.serializer encodedVersion:doc.version];
+  listenResponse.documentChange.document.fields = [self.serializer encodedFields:doc.data];
+  [listenResponse.documentChange.targetIdsArray addValue:1];
+
+  [self assertListenResponse:listenResponse decodesTo:expected];
+}
+
+- (void)testDecodedDocumentChangeKeepsItsEncoding {
+  GCFSListenResponse *listenResponse = [GCFSListenResponse message];
+  listenResponse.documentChange.document.name = @"projects/p/databases/d/documents/coll/1";
+  listenResponse.documentChange.document.updateTime.nanos = 5000;
+  GCFSValue *fooValue = [GCFSValue message];
+  fooValue.stringValue = @"bar";
+  [listenResponse.documentChange.document.fields setObject:fooValue forKey:@"foo"];
+  [listenResponse.documentChange.targetIdsArray addValue:1];
+
+  WatchStreamSerializer bridge{self.serializer};
+  SnapshotVersion version;
+  Status status;
+  std::unique_ptr<WatchChange> decoded =
+      bridge.DecodeResponse(MakeByteBuffer([listenResponse data]), &version, &status);
+  XCTAssertTrue(status.ok());
+  FSTDocument *document =
+      (FSTDocument *)static_cast<DocumentWatchChange &>(*decoded).new_document();
+  XCTAssertEqualObjects(document.encodedProto, [listenResponse.documentChange.document data]);
+
+  // Local persistence writes the kept encoding as it is.
+  FSTLocalSerializer *localSerializer =
+      [[FSTLocalSerializer alloc] initWithRemoteSerializer:self.serializer];
+  FSTPBMaybeDocument *expected = [FSTPBMaybeDocument message];
+  expected.document = listenResponse.documentChange.document;
+  std::string encoded = [localSerializer encodedMaybeDocumentBytes:document];
+  XCTAssertEqualObjects([NSData dataWithBytes:encoded.data() length:encoded.size()],
+                        [expected data]);
+}
+
+- (void)testDecodesWriteResponseFromItsEncoding {
+  SnapshotVersion commitVersion = testutil::Version(3000);
+  SnapshotVersion updateVersion = testutil::Version(4000);
+  GCFSWriteResponse *response = [GCFSWriteResponse message];
+  response.streamToken = FSTTestData(1, 2, 3, -1);
+  response.commitTime = [self.serializer encodedTimestamp:commitVersion.timestamp()];
+  GCFSWriteResult *update = [GCFSWriteResult message];
+  update.updateTime = [self.serializer encodedTimestamp:updateVersion.timestamp()];
+  [update.transformResultsArray addObject:[self.serializer encodedString:@"result"]];
+  [response.writeResultsArray addObject:update];
+  [response.writeResultsArray addObject:[GCFSWriteResult message]];
+
+  WriteStreamSerializer bridge{self.serializer};
+  SnapshotVersion version;
+  std::vector<FSTMutationResult *> results;
+  Status status = bridge.DecodeResponse(MakeByteBuffer([response data]), &version, &results);
+  XCTAssertTrue(status.ok(), @"%s", status.ToString().c_str());
+
+  XCTAssertEqual(version, commitVersion);
+  XCTAssertEqualObjects(bridge.GetLastStreamToken(), FSTTestData(1, 2, 3, -1));
+  XCTAssertEqual(results.size(), 2);
+  XCTAssertEqual(results[0].version, updateVersion);
+  XCTAssertEqualObjects(results[0].transformResults, @[ FieldValue::FromString("result").Wrap() ]);
+  // Deletes don't have an update time.
+  XCTAssertEqual(results[1].version, commitVersion);
+  XCTAssertNil(results[1].transformResults);
 }
 
 @end
@@ -20,10 +20,12 @@
 #include <memory>
 #include <queue>
 #include <utility>
+#include <vector>
 
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Local/FSTQueryData.h"
 #import "Firestore/Source/Model/FSTMutation.h"
+#import "Firestore/Source/Model/FSTMutationBatch.h"
 #import "Firestore/Source/Remote/FSTSerializerBeta.h"
 
 #include "Firestore/core/src/firebase/firestore/auth/credentials_provider.h"
@@ -110,6 +112,12 @@ class MockWatchStream : public WatchStream {
     active_targets_[query.targetID] = sentQueryData;
   }
 
+  void WatchQueries(const std::vector<FSTQueryData*>& queries) override {
+    for (FSTQueryData* query : queries) {
+      WatchQuery(query);
+    }
+  }
+
   void UnwatchTargetId(model::TargetId target_id) override {
     LOG_DEBUG("UnwatchTargetId: %s", target_id);
     active_targets_.erase(target_id);
@@ -201,6 +209,20 @@ class MockWriteStream : public WriteStream {
     sent_mutations_.push(mutations);
   }
 
+  /** Packs all of the given batches into one write, regardless of their size. */
+  size_t WriteCoalescedMutations(std::vector<FSTMutationBatch*>::const_iterator begin,
+                                 std::vector<FSTMutationBatch*>::const_iterator end,
+                                 size_t) override {
+    datastore_->IncrementWriteStreamRequests();
+    std::vector<FSTMutation*> mutations;
+    for (auto iter = begin; iter != end; ++iter) {
+      const std::vector<FSTMutation*>& batch_mutations = [*iter mutations];
+      mutations.insert(mutations.end(), batch_mutations.begin(), batch_mutations.end());
+    }
+    sent_mutations_.push(std::move(mutations));
+    return static_cast<size_t>(end - begin);
+  }
+
   /** Injects a write ack as though it had come from the backend in response to a write. */
   void AckWrite(const SnapshotVersion& commitVersion, std::vector<FSTMutationResult*> results) {
     callback_->OnWriteStreamMutationResult(commitVersion, std::move(results));
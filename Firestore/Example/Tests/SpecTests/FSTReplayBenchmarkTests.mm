@@ -0,0 +1,305 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+#import <Protobuf/GPBProtocolBuffers.h>
+#import <XCTest/XCTest.h>
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#import "Firestore/Protos/objc/google/firestore/v1/Firestore.pbobjc.h"
+#import "Firestore/Protos/objc/google/firestore/v1/Write.pbobjc.h"
+#import "Firestore/Source/Core/FSTQuery.h"
+#import "Firestore/Source/Local/FSTPersistence.h"
+#import "Firestore/Source/Local/FSTQueryData.h"
+#import "Firestore/Source/Model/FSTMutation.h"
+#import "Firestore/Source/Remote/FSTSerializerBeta.h"
+
+#import "Firestore/Example/Tests/Local/FSTPersistenceTestHelpers.h"
+#import "Firestore/Example/Tests/SpecTests/FSTSyncEngineTestDriver.h"
+#import "Firestore/Example/Tests/Util/FSTHelpers.h"
+
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
+#include "Firestore/core/src/firebase/firestore/util/latency_histogram.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+
+namespace testutil = firebase::firestore::testutil;
+using firebase::firestore::model::DatabaseId;
+using firebase::firestore::model::SnapshotVersion;
+using firebase::firestore::model::TargetId;
+using firebase::firestore::remote::WatchChange;
+using firebase::firestore::util::LatencyHistogram;
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Replays are slow and their numbers are only meaningful on a quiet machine, so they are disabled
+// by default. Set this to YES to run them.
+static const BOOL kRunReplayBenchmarks = NO;
+
+// If set, names a recording to replay instead of the synthetic one.
+static const char *const kRecordingEnvVar = "FIRESTORE_REPLAY_RECORDING";
+
+/**
+ * The field numbers of the entries in a recording. A recording is the wire encoding of a message
+ * with one repeated field per entry type, with the entries kept in the order they were captured:
+ * listens and user writes are what the client sent, and listen and write responses are what the
+ * backend answered.
+ */
+typedef NS_ENUM(int32_t, FSTReplayEntry) {
+  FSTReplayEntryListen = 1,         // GCFSTarget
+  FSTReplayEntryWrite = 2,          // GCFSWrite
+  FSTReplayEntryListenResponse = 3, // GCFSListenResponse
+  FSTReplayEntryWriteResponse = 4,  // GCFSWriteResponse
+};
+
+static const int kSyntheticDocumentCount = 2000;
+static const int kSyntheticWriteCount = 200;
+
+/**
+ * Replays a recording of watch and write stream traffic through the whole client below the public
+ * API: the mock datastore stands in for the network, and everything from the serializer through
+ * RemoteStore, FSTSyncEngine, FSTLocalStore and the views runs as it would against the backend.
+ * Reports the overall throughput and the latency of individual entries for both memory and
+ * LevelDB persistence.
+ */
+@interface FSTReplayBenchmarkTests : XCTestCase
+@end
+
+@implementation FSTReplayBenchmarkTests {
+  DatabaseId _databaseID;
+  FSTSerializerBeta *_serializer;
+}
+
+- (void)setUp {
+  [super setUp];
+  // Must match the database used by FSTSyncEngineTestDriver.
+  _databaseID = DatabaseId{"project", "database"};
+  _serializer = [[FSTSerializerBeta alloc] initWithDatabaseID:&_databaseID];
+}
+
+- (void)testReplayWithMemoryPersistence {
+  if (!kRunReplayBenchmarks) return;
+  [self replayWithPersistence:[FSTPersistenceTestHelpers eagerGCMemoryPersistence]
+                        label:@"memory"];
+}
+
+- (void)testReplayWithLevelDBPersistence {
+  if (!kRunReplayBenchmarks) return;
+  [self replayWithPersistence:[FSTPersistenceTestHelpers levelDBPersistence] label:@"leveldb"];
+}
+
+- (NSData *)recording {
+  const char *path = std::getenv(kRecordingEnvVar);
+  if (path) {
+    NSData *data = [NSData dataWithContentsOfFile:@(path)];
+    XCTAssertNotNil(data, @"Unable to read recording %s", path);
+    return data;
+  }
+  return [self syntheticRecording];
+}
+
+- (void)replayWithPersistence:(id<FSTPersistence>)persistence label:(NSString *)label {
+  NSData *recording = [self recording];
+
+  FSTSyncEngineTestDriver *driver =
+      [[FSTSyncEngineTestDriver alloc] initWithPersistence:persistence];
+  [driver start];
+
+  LatencyHistogram latencies;
+  int entries = 0;
+  auto start = LatencyHistogram::Clock::now();
+
+  GPBCodedInputStream *input = [GPBCodedInputStream streamWithData:recording];
+  for (int32_t tag = [input readTag]; tag != 0; tag = [input readTag]) {
+    // The low three bits of a tag hold the wire type, the rest the field number.
+    int32_t field = tag >> 3;
+    NSData *bytes = [input readBytes];
+    NSError *error = nil;
+
+    auto entry_start = LatencyHistogram::Clock::now();
+    switch (field) {
+      case FSTReplayEntryListen: {
+        GCFSTarget *target = [GCFSTarget parseFromData:bytes error:&error];
+        XCTAssertNil(error);
+        FSTQuery *query = target.targetTypeOneOfCase == GCFSTarget_TargetType_OneOfCase_Query
+                              ? [_serializer decodedQueryFromQueryTarget:target.query]
+                              : [_serializer decodedQueryFromDocumentsTarget:target.documents];
+        TargetId targetID = [driver addUserListenerWithQuery:query];
+        // The recorded responses address targets by the IDs the recording client assigned, so
+        // the replaying client has to assign the same ones.
+        XCTAssertEqual(targetID, target.targetId);
+        break;
+      }
+
+      case FSTReplayEntryWrite: {
+        GCFSWrite *write = [GCFSWrite parseFromData:bytes error:&error];
+        XCTAssertNil(error);
+        [driver writeUserMutation:[_serializer decodedMutation:write]];
+        break;
+      }
+
+      case FSTReplayEntryListenResponse: {
+        GCFSListenResponse *response = [GCFSListenResponse parseFromData:bytes error:&error];
+        XCTAssertNil(error);
+        std::unique_ptr<WatchChange> change = [_serializer decodedWatchChange:response];
+        [driver receiveWatchChange:*change
+                   snapshotVersion:[_serializer versionFromListenResponse:response]];
+        break;
+      }
+
+      case FSTReplayEntryWriteResponse: {
+        GCFSWriteResponse *response = [GCFSWriteResponse parseFromData:bytes error:&error];
+        XCTAssertNil(error);
+        SnapshotVersion commitVersion = [_serializer decodedVersion:response.commitTime];
+        std::vector<FSTMutationResult *> results;
+        for (GCFSWriteResult *result in response.writeResultsArray) {
+          results.push_back([_serializer decodedMutationResult:result
+                                                 commitVersion:commitVersion]);
+        }
+        [driver receiveWriteAckWithVersion:commitVersion mutationResults:std::move(results)];
+        break;
+      }
+
+      default:
+        XCTFail(@"Unknown recording entry %d", field);
+        break;
+    }
+
+    // Raised snapshots and acknowledgements are otherwise kept for the lifetime of the driver.
+    [driver capturedEventsSinceLastCall];
+    [driver capturedAcknowledgedWritesSinceLastCall];
+    [driver capturedRejectedWritesSinceLastCall];
+
+    latencies.RecordElapsedSince(entry_start);
+    ++entries;
+  }
+
+  double seconds =
+      std::chrono::duration<double>(LatencyHistogram::Clock::now() - start).count();
+  [driver shutdown];
+
+  NSLog(@"Replay (%@): %d entries in %.3fs (%.0f entries/s); latency p50 %lldms, p99 %lldms, "
+        @"max %lldms",
+        label, entries, seconds, entries / seconds,
+        static_cast<long long>(latencies.Percentile(50).count()),
+        static_cast<long long>(latencies.Percentile(99).count()),
+        static_cast<long long>(latencies.max().count()));
+}
+
+#pragma mark - Synthetic recording
+
+/**
+ * Builds a recording of a client that listens to a collection, receives its initial result set,
+ * and then writes to it, with each write acknowledged and echoed back by watch.
+ */
+- (NSData *)syntheticRecording {
+  NSMutableData *data = [NSMutableData data];
+  GPBCodedOutputStream *output = [GPBCodedOutputStream streamWithData:data];
+
+  const TargetId targetID = 2;
+  FSTQuery *query = FSTTestQuery("coll");
+  FSTQueryData *queryData = [[FSTQueryData alloc] initWithQuery:query
+                                                       targetID:targetID
+                                           listenSequenceNumber:0
+                                                        purpose:FSTQueryPurposeListen];
+  [output writeMessage:FSTReplayEntryListen value:[_serializer encodedTarget:queryData]];
+
+  GCFSListenResponse *added = [GCFSListenResponse message];
+  added.targetChange.targetChangeType = GCFSTargetChange_TargetChangeType_Add;
+  [added.targetChange.targetIdsArray addValue:targetID];
+  [output writeMessage:FSTReplayEntryListenResponse value:added];
+
+  int64_t version = 1;
+  for (int i = 0; i < kSyntheticDocumentCount; ++i) {
+    [output writeMessage:FSTReplayEntryListenResponse
+                   value:[self documentResponseForIndex:i version:version target:targetID]];
+  }
+  [self writeSnapshotAtVersion:version++ target:targetID markCurrent:YES toStream:output];
+
+  for (int i = 0; i < kSyntheticWriteCount; ++i) {
+    int index = i % kSyntheticDocumentCount;
+    FSTMutation *mutation = FSTTestSetMutation([NSString stringWithFormat:@"coll/doc%d", index],
+                                               @{@"index" : @(index), @"write" : @(i)});
+    [output writeMessage:FSTReplayEntryWrite value:[_serializer encodedMutation:mutation]];
+
+    int64_t commitVersion = version++;
+    GCFSWriteResponse *ack = [GCFSWriteResponse message];
+    ack.commitTime = [_serializer encodedVersion:testutil::Version(commitVersion)];
+    GCFSWriteResult *result = [GCFSWriteResult message];
+    result.updateTime = ack.commitTime;
+    [ack.writeResultsArray addObject:result];
+    [output writeMessage:FSTReplayEntryWriteResponse value:ack];
+
+    [output writeMessage:FSTReplayEntryListenResponse
+                   value:[self documentResponseForIndex:index
+                                                version:commitVersion
+                                                 target:targetID]];
+    [self writeSnapshotAtVersion:commitVersion target:targetID markCurrent:NO toStream:output];
+  }
+
+  [output flush];
+  return data;
+}
+
+- (GCFSListenResponse *)documentResponseForIndex:(int)index
+                                         version:(int64_t)version
+                                          target:(TargetId)targetID {
+  NSString *path = [NSString stringWithFormat:@"coll/doc%d", index];
+  GCFSListenResponse *response = [GCFSListenResponse message];
+  response.documentChange.document =
+      [_serializer encodedDocumentWithFields:FSTTestObjectValue(@{@"index" : @(index)})
+                                         key:FSTTestDocKey(path)];
+  response.documentChange.document.updateTime =
+      [_serializer encodedVersion:testutil::Version(version)];
+  [response.documentChange.targetIdsArray addValue:targetID];
+  return response;
+}
+
+/**
+ * Writes the responses that make watch raise a snapshot at the given version: optionally marking
+ * the target current, followed by a global no-change carrying the read time.
+ */
+- (void)writeSnapshotAtVersion:(int64_t)version
+                        target:(TargetId)targetID
+                   markCurrent:(BOOL)markCurrent
+                      toStream:(GPBCodedOutputStream *)output {
+  NSData *resumeToken = [[NSString stringWithFormat:@"resume-%lld", static_cast<long long>(version)]
+      dataUsingEncoding:NSUTF8StringEncoding];
+
+  if (markCurrent) {
+    GCFSListenResponse *current = [GCFSListenResponse message];
+    current.targetChange.targetChangeType = GCFSTargetChange_TargetChangeType_Current;
+    [current.targetChange.targetIdsArray addValue:targetID];
+    current.targetChange.resumeToken = resumeToken;
+    [output writeMessage:FSTReplayEntryListenResponse value:current];
+  }
+
+  GCFSListenResponse *snapshot = [GCFSListenResponse message];
+  snapshot.targetChange.targetChangeType = GCFSTargetChange_TargetChangeType_NoChange;
+  snapshot.targetChange.resumeToken = resumeToken;
+  snapshot.targetChange.readTime = [_serializer encodedVersion:testutil::Version(version)];
+  [output writeMessage:FSTReplayEntryListenResponse value:snapshot];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
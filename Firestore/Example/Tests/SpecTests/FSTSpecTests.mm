@@ -18,6 +18,7 @@
 
 #import <FirebaseFirestore/FIRFirestoreErrors.h>
 
+#include <limits>
 #include <map>
 #include <unordered_map>
 #include <utility>
@@ -121,6 +122,7 @@ std::vector<TargetId> ConvertTargetsArray(NSArray<NSNumber *> *from) {
 
 @implementation FSTSpecTests {
   BOOL _gcEnabled;
+  size_t _maxConcurrentLimboResolutions;
   BOOL _networkEnabled;
 }
 
@@ -147,8 +149,16 @@ std::vector<TargetId> ConvertTargetsArray(NSArray<NSNumber *> *from) {
   if (numClients) {
     XCTAssertEqualObjects(numClients, @1, @"The iOS client does not support multi-client tests");
   }
+  NSNumber *maxConcurrentLimboResolutions = config[@"maxConcurrentLimboResolutions"];
+  _maxConcurrentLimboResolutions = maxConcurrentLimboResolutions
+                                       ? [maxConcurrentLimboResolutions unsignedLongValue]
+                                       : std::numeric_limits<size_t>::max();
   id<FSTPersistence> persistence = [self persistenceWithGCEnabled:_gcEnabled];
-  self.driver = [[FSTSyncEngineTestDriver alloc] initWithPersistence:persistence];
+  self.driver =
+      [[FSTSyncEngineTestDriver alloc] initWithPersistence:persistence
+                                               initialUser:User::Unauthenticated()
+                                         outstandingWrites:{}
+                             maxConcurrentLimboResolutions:_maxConcurrentLimboResolutions];
   [self.driver start];
 }
 
@@ -432,9 +442,11 @@ std::vector<TargetId> ConvertTargetsArray(NSArray<NSNumber *> *from) {
   [self.driver shutdown];
 
   id<FSTPersistence> persistence = [self persistenceWithGCEnabled:_gcEnabled];
-  self.driver = [[FSTSyncEngineTestDriver alloc] initWithPersistence:persistence
-                                                         initialUser:currentUser
-                                                   outstandingWrites:outstandingWrites];
+  self.driver =
+      [[FSTSyncEngineTestDriver alloc] initWithPersistence:persistence
+                                               initialUser:currentUser
+                                         outstandingWrites:outstandingWrites
+                             maxConcurrentLimboResolutions:_maxConcurrentLimboResolutions];
   [self.driver start];
 }
 
@@ -597,6 +609,14 @@ std::vector<TargetId> ConvertTargetsArray(NSArray<NSNumber *> *from) {
       // Update the expected limbo documents
       [self.driver setExpectedLimboDocuments:std::move(expectedLimboDocuments)];
     }
+    if (expected[@"enqueuedLimboDocs"]) {
+      std::vector<DocumentKey> expectedEnqueuedLimboDocuments;
+      for (NSString *name in expected[@"enqueuedLimboDocs"]) {
+        expectedEnqueuedLimboDocuments.push_back(FSTTestDocKey(name));
+      }
+      XCTAssertTrue([self.driver enqueuedLimboDocuments] == expectedEnqueuedLimboDocuments,
+                    @"Unexpected enqueued limbo documents");
+    }
     if (expected[@"activeTargets"]) {
       __block std::unordered_map<TargetId, FSTQueryData *> expectedActiveTargets;
       [expected[@"activeTargets"] enumerateKeysAndObjectsUsingBlock:^(NSString *targetIDString,
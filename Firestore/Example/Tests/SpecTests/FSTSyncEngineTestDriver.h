@@ -101,9 +101,19 @@ typedef std::unordered_map<firebase::firestore::auth::User,
  * a set of existing outstandingWrites (useful when your FSTPersistence object has
  * persisted mutation queues).
  */
+- (instancetype)initWithPersistence:(id<FSTPersistence>)persistence
+                        initialUser:(const firebase::firestore::auth::User &)initialUser
+                  outstandingWrites:(const FSTOutstandingWriteQueues &)outstandingWrites;
+
+/**
+ * Like the initializer above, but limits the underlying FSTSyncEngine to resolving
+ * `maxConcurrentLimboResolutions` limbo documents at a time (the other initializers don't limit
+ * it).
+ */
 - (instancetype)initWithPersistence:(id<FSTPersistence>)persistence
                         initialUser:(const firebase::firestore::auth::User &)initialUser
                   outstandingWrites:(const FSTOutstandingWriteQueues &)outstandingWrites
+      maxConcurrentLimboResolutions:(size_t)maxConcurrentLimboResolutions
     NS_DESIGNATED_INITIALIZER;
 
 - (instancetype)init NS_UNAVAILABLE;
@@ -268,6 +278,9 @@ typedef std::unordered_map<firebase::firestore::auth::User,
 - (std::map<firebase::firestore::model::DocumentKey, firebase::firestore::model::TargetId>)
     currentLimboDocuments;
 
+/** The limbo documents waiting for a limbo resolution, in the order they will be resolved. */
+- (std::vector<firebase::firestore::model::DocumentKey>)enqueuedLimboDocuments;
+
 /** The expected set of documents in limbo. */
 - (const firebase::firestore::model::DocumentKeySet &)expectedLimboDocuments;
 
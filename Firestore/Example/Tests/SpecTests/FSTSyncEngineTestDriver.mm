@@ -18,6 +18,7 @@
 
 #import <FirebaseFirestore/FIRFirestoreErrors.h>
 
+#include <limits>
 #include <map>
 #include <memory>
 #include <string>
@@ -164,6 +165,16 @@ NS_ASSUME_NONNULL_BEGIN
 - (instancetype)initWithPersistence:(id<FSTPersistence>)persistence
                         initialUser:(const User &)initialUser
                   outstandingWrites:(const FSTOutstandingWriteQueues &)outstandingWrites {
+  return [self initWithPersistence:persistence
+                       initialUser:initialUser
+                 outstandingWrites:outstandingWrites
+     maxConcurrentLimboResolutions:std::numeric_limits<size_t>::max()];
+}
+
+- (instancetype)initWithPersistence:(id<FSTPersistence>)persistence
+                        initialUser:(const User &)initialUser
+                  outstandingWrites:(const FSTOutstandingWriteQueues &)outstandingWrites
+      maxConcurrentLimboResolutions:(size_t)maxConcurrentLimboResolutions {
   if (self = [super init]) {
     // Do a deep copy.
     for (const auto &pair : outstandingWrites) {
@@ -191,8 +202,9 @@ NS_ASSUME_NONNULL_BEGIN
     ;
 
     _syncEngine = [[FSTSyncEngine alloc] initWithLocalStore:_localStore
-                                                remoteStore:_remoteStore.get()
-                                                initialUser:initialUser];
+                                                  remoteStore:_remoteStore.get()
+                                                  initialUser:initialUser
+                                maxConcurrentLimboResolutions:maxConcurrentLimboResolutions];
     _remoteStore->set_sync_engine(_syncEngine);
     _eventManager = [FSTEventManager eventManagerWithSyncEngine:_syncEngine];
 
@@ -425,6 +437,10 @@ NS_ASSUME_NONNULL_BEGIN
   return [self.syncEngine currentLimboDocuments];
 }
 
+- (std::vector<DocumentKey>)enqueuedLimboDocuments {
+  return [self.syncEngine enqueuedLimboDocuments];
+}
+
 - (const std::unordered_map<TargetId, FSTQueryData *> &)activeTargets {
   return _datastore->ActiveTargets();
 }
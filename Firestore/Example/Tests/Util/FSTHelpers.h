@@ -193,9 +193,12 @@ class TestTargetMetadataProvider : public TargetMetadataProvider {
 
   model::DocumentKeySet GetRemoteKeysForTarget(model::TargetId target_id) const override;
   FSTQueryData *GetQueryDataForTarget(model::TargetId target_id) const override;
+  const model::DatabaseId &GetDatabaseId() const override;
+  TargetStatistics *GetStatisticsForTarget(model::TargetId target_id) override;
 
  private:
   std::unordered_map<model::TargetId, model::DocumentKeySet> synced_keys_;
+  std::unordered_map<model::TargetId, TargetStatistics> statistics_;
   std::unordered_map<model::TargetId, FSTQueryData *> query_data_;
 };
 
@@ -283,7 +283,7 @@ FSTTransformMutation *FSTTestTransformMutation(NSString *path, NSDictionary<NSSt
   DocumentKey key{testutil::Resource(util::MakeString(path))};
   FSTUserDataConverter *converter = FSTTestUserDataConverter();
   ParsedUpdateData result = [converter parsedUpdateData:data];
-  HARD_ASSERT(result.data().value.count == 0,
+  HARD_ASSERT(result.data().GetInternalValue().empty(),
               "FSTTestTransformMutation() only expects transforms; no other data");
   return [[FSTTransformMutation alloc] initWithKey:key fieldTransforms:result.field_transforms()];
 }
@@ -377,6 +377,15 @@ FSTQueryData *TestTargetMetadataProvider::GetQueryDataForTarget(TargetId target_
   return it->second;
 }
 
+const DatabaseId &TestTargetMetadataProvider::GetDatabaseId() const {
+  static DatabaseId database_id{"project", DatabaseId::kDefault};
+  return database_id;
+}
+
+TargetStatistics *TestTargetMetadataProvider::GetStatisticsForTarget(TargetId target_id) {
+  return &statistics_[target_id];
+}
+
 }  // namespace remote
 }  // namespace firestore
 }  // namespace firebase
@@ -122,6 +122,7 @@ const ::google::protobuf::uint32 TableStruct::offsets[] GOOGLE_PROTOBUF_ATTRIBUT
   GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::firestore::client::TargetGlobal, highest_listen_sequence_number_),
   GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::firestore::client::TargetGlobal, last_remote_snapshot_version_),
   GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::firestore::client::TargetGlobal, target_count_),
+  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::firestore::client::TargetGlobal, byte_size_),
 };
 static const ::google::protobuf::internal::MigrationSchema schemas[] GOOGLE_PROTOBUF_ATTRIBUTE_SECTION_VARIABLE(protodesc_cold) = {
   { 0, -1, sizeof(::firestore::client::Target)},
@@ -165,15 +166,16 @@ void AddDescriptorsImpl() {
       "oogle.firestore.v1.Target.QueryTargetH\000\022"
       "@\n\tdocuments\030\006 \001(\0132+.google.firestore.v1"
       ".Target.DocumentsTargetH\000B\r\n\013target_type"
-      "\"\251\001\n\014TargetGlobal\022\031\n\021highest_target_id\030\001"
+      "\"\274\001\n\014TargetGlobal\022\031\n\021highest_target_id\030\001"
       " \001(\005\022&\n\036highest_listen_sequence_number\030\002"
       " \001(\003\022@\n\034last_remote_snapshot_version\030\003 \001"
       "(\0132\032.google.protobuf.Timestamp\022\024\n\014target"
-      "_count\030\004 \001(\005B/\n#com.google.firebase.fire"
-      "store.protoP\001\242\002\005FSTPBb\006proto3"
+      "_count\030\004 \001(\005\022\021\n\tbyte_size\030\005 \001(\003B/\n#com.g"
+      "oogle.firebase.firestore.protoP\001\242\002\005FSTPB"
+      "b\006proto3"
   };
   ::google::protobuf::DescriptorPool::InternalAddGeneratedFile(
-      descriptor, 629);
+      descriptor, 648);
   ::google::protobuf::MessageFactory::InternalRegisterGeneratedFile(
     "firestore/local/target.proto", &protobuf_RegisterTypes);
   ::protobuf_google_2ffirestore_2fv1_2ffirestore_2eproto::AddDescriptors();
@@ -759,6 +761,7 @@ const int TargetGlobal::kHighestTargetIdFieldNumber;
 const int TargetGlobal::kHighestListenSequenceNumberFieldNumber;
 const int TargetGlobal::kLastRemoteSnapshotVersionFieldNumber;
 const int TargetGlobal::kTargetCountFieldNumber;
+const int TargetGlobal::kByteSizeFieldNumber;
 #endif  // !defined(_MSC_VER) || _MSC_VER >= 1900
 
 TargetGlobal::TargetGlobal()
@@ -904,6 +907,20 @@ bool TargetGlobal::MergePartialFromCodedStream(
         break;
       }
 
+      // int64 byte_size = 5;
+      case 5: {
+        if (static_cast< ::google::protobuf::uint8>(tag) ==
+            static_cast< ::google::protobuf::uint8>(40u /* 40 & 0xFF */)) {
+
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::int64, ::google::protobuf::internal::WireFormatLite::TYPE_INT64>(
+                 input, &byte_size_)));
+        } else {
+          goto handle_unusual;
+        }
+        break;
+      }
+
       default: {
       handle_unusual:
         if (tag == 0) {
@@ -951,6 +968,11 @@ void TargetGlobal::SerializeWithCachedSizes(
     ::google::protobuf::internal::WireFormatLite::WriteInt32(4, this->target_count(), output);
   }
 
+  // int64 byte_size = 5;
+  if (this->byte_size() != 0) {
+    ::google::protobuf::internal::WireFormatLite::WriteInt64(5, this->byte_size(), output);
+  }
+
   if ((_internal_metadata_.have_unknown_fields() &&  ::google::protobuf::internal::GetProto3PreserveUnknownsDefault())) {
     ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
         (::google::protobuf::internal::GetProto3PreserveUnknownsDefault()   ? _internal_metadata_.unknown_fields()   : _internal_metadata_.default_instance()), output);
@@ -987,6 +1009,11 @@ void TargetGlobal::SerializeWithCachedSizes(
     target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(4, this->target_count(), target);
   }
 
+  // int64 byte_size = 5;
+  if (this->byte_size() != 0) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteInt64ToArray(5, this->byte_size(), target);
+  }
+
   if ((_internal_metadata_.have_unknown_fields() &&  ::google::protobuf::internal::GetProto3PreserveUnknownsDefault())) {
     target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
         (::google::protobuf::internal::GetProto3PreserveUnknownsDefault()   ? _internal_metadata_.unknown_fields()   : _internal_metadata_.default_instance()), target);
@@ -1018,6 +1045,13 @@ size_t TargetGlobal::ByteSizeLong() const {
         this->highest_listen_sequence_number());
   }
 
+  // int64 byte_size = 5;
+  if (this->byte_size() != 0) {
+    total_size += 1 +
+      ::google::protobuf::internal::WireFormatLite::Int64Size(
+        this->byte_size());
+  }
+
   // int32 highest_target_id = 1;
   if (this->highest_target_id() != 0) {
     total_size += 1 +
@@ -1067,6 +1101,9 @@ void TargetGlobal::MergeFrom(const TargetGlobal& from) {
   if (from.highest_listen_sequence_number() != 0) {
     set_highest_listen_sequence_number(from.highest_listen_sequence_number());
   }
+  if (from.byte_size() != 0) {
+    set_byte_size(from.byte_size());
+  }
   if (from.highest_target_id() != 0) {
     set_highest_target_id(from.highest_target_id());
   }
@@ -1101,6 +1138,7 @@ void TargetGlobal::InternalSwap(TargetGlobal* other) {
   using std::swap;
   swap(last_remote_snapshot_version_, other->last_remote_snapshot_version_);
   swap(highest_listen_sequence_number_, other->highest_listen_sequence_number_);
+  swap(byte_size_, other->byte_size_);
   swap(highest_target_id_, other->highest_target_id_);
   swap(target_count_, other->target_count_);
   _internal_metadata_.Swap(&other->_internal_metadata_);
@@ -350,6 +350,12 @@ class TargetGlobal : public ::google::protobuf::Message /* @@protoc_insertion_po
   ::google::protobuf::int64 highest_listen_sequence_number() const;
   void set_highest_listen_sequence_number(::google::protobuf::int64 value);
 
+  // int64 byte_size = 5;
+  void clear_byte_size();
+  static const int kByteSizeFieldNumber = 5;
+  ::google::protobuf::int64 byte_size() const;
+  void set_byte_size(::google::protobuf::int64 value);
+
   // int32 highest_target_id = 1;
   void clear_highest_target_id();
   static const int kHighestTargetIdFieldNumber = 1;
@@ -368,6 +374,7 @@ class TargetGlobal : public ::google::protobuf::Message /* @@protoc_insertion_po
   ::google::protobuf::internal::InternalMetadataWithArena _internal_metadata_;
   ::google::protobuf::Timestamp* last_remote_snapshot_version_;
   ::google::protobuf::int64 highest_listen_sequence_number_;
+  ::google::protobuf::int64 byte_size_;
   ::google::protobuf::int32 highest_target_id_;
   ::google::protobuf::int32 target_count_;
   mutable int _cached_size_;
@@ -679,6 +686,20 @@ inline void TargetGlobal::set_target_count(::google::protobuf::int32 value) {
   // @@protoc_insertion_point(field_set:firestore.client.TargetGlobal.target_count)
 }
 
+// int64 byte_size = 5;
+inline void TargetGlobal::clear_byte_size() {
+  byte_size_ = GOOGLE_LONGLONG(0);
+}
+inline ::google::protobuf::int64 TargetGlobal::byte_size() const {
+  // @@protoc_insertion_point(field_get:firestore.client.TargetGlobal.byte_size)
+  return byte_size_;
+}
+inline void TargetGlobal::set_byte_size(::google::protobuf::int64 value) {
+  
+  byte_size_ = value;
+  // @@protoc_insertion_point(field_set:firestore.client.TargetGlobal.byte_size)
+}
+
 #ifdef __GNUC__
   #pragma GCC diagnostic pop
 #endif  // __GNUC__
@@ -53,6 +53,7 @@ typedef struct _firestore_client_TargetGlobal {
     int64_t highest_listen_sequence_number;
     google_protobuf_Timestamp last_remote_snapshot_version;
     int32_t target_count;
+    int64_t byte_size;
 /* @@protoc_insertion_point(struct:firestore_client_TargetGlobal) */
 } firestore_client_TargetGlobal;
 
@@ -60,9 +61,9 @@ typedef struct _firestore_client_TargetGlobal {
 
 /* Initializer values for message structs */
 #define firestore_client_Target_init_default     {0, google_protobuf_Timestamp_init_default, NULL, 0, 0, {google_firestore_v1_Target_QueryTarget_init_default}}
-#define firestore_client_TargetGlobal_init_default {0, 0, google_protobuf_Timestamp_init_default, 0}
+#define firestore_client_TargetGlobal_init_default {0, 0, google_protobuf_Timestamp_init_default, 0, 0}
 #define firestore_client_Target_init_zero        {0, google_protobuf_Timestamp_init_zero, NULL, 0, 0, {google_firestore_v1_Target_QueryTarget_init_zero}}
-#define firestore_client_TargetGlobal_init_zero  {0, 0, google_protobuf_Timestamp_init_zero, 0}
+#define firestore_client_TargetGlobal_init_zero  {0, 0, google_protobuf_Timestamp_init_zero, 0, 0}
 
 /* Field tags (for use in manual encoding/decoding) */
 #define firestore_client_Target_query_tag        5
@@ -75,14 +76,15 @@ typedef struct _firestore_client_TargetGlobal {
 #define firestore_client_TargetGlobal_highest_listen_sequence_number_tag 2
 #define firestore_client_TargetGlobal_last_remote_snapshot_version_tag 3
 #define firestore_client_TargetGlobal_target_count_tag 4
+#define firestore_client_TargetGlobal_byte_size_tag 5
 
 /* Struct field encoding specification for nanopb */
 extern const pb_field_t firestore_client_Target_fields[7];
-extern const pb_field_t firestore_client_TargetGlobal_fields[5];
+extern const pb_field_t firestore_client_TargetGlobal_fields[6];
 
 /* Maximum encoded size of messages (where known) */
 /* firestore_client_Target_size depends on runtime parameters */
-#define firestore_client_TargetGlobal_size       57
+#define firestore_client_TargetGlobal_size       68
 
 /* Message IDs (where set with "msgid" option) */
 #ifdef PB_MSGID
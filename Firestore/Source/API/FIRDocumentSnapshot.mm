@@ -44,6 +44,7 @@ using firebase::firestore::api::SnapshotMetadata;
 using firebase::firestore::api::ThrowInvalidArgument;
 using firebase::firestore::model::DatabaseId;
 using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::FieldPath;
 using firebase::firestore::model::FieldValue;
 using firebase::firestore::util::WrapNSString;
 
@@ -147,9 +148,7 @@ ServerTimestampBehavior InternalServerTimestampBehavior(FIRServerTimestampBehavi
 
 - (nullable NSDictionary<NSString *, id> *)dataWithServerTimestampBehavior:
     (FIRServerTimestampBehavior)serverTimestampBehavior {
-  FSTFieldValueOptions *options = [self optionsForServerTimestampBehavior:serverTimestampBehavior];
-  FSTObjectValue *data = _snapshot.GetData();
-  return data == nil ? nil : [self convertedObject:data options:options];
+  return [self convertedValueAtPath:FieldPath{} serverTimestampBehavior:serverTimestampBehavior];
 }
 
 - (nullable id)valueForField:(id)field {
@@ -167,15 +166,27 @@ ServerTimestampBehavior InternalServerTimestampBehavior(FIRServerTimestampBehavi
     ThrowInvalidArgument("Subscript key must be an NSString or FIRFieldPath.");
   }
 
-  FSTFieldValue *fieldValue = _snapshot.GetValue(fieldPath.internalValue);
-  FSTFieldValueOptions *options = [self optionsForServerTimestampBehavior:serverTimestampBehavior];
-  return fieldValue == nil ? nil : [self convertedValue:fieldValue options:options];
+  return [self convertedValueAtPath:fieldPath.internalValue
+             serverTimestampBehavior:serverTimestampBehavior];
 }
 
 - (nullable id)objectForKeyedSubscript:(id)key {
   return [self valueForField:key];
 }
 
+/**
+ * Converts the value at `fieldPath` (all of the data for an empty path) to what users see, once
+ * per snapshot and server timestamp behavior.
+ */
+- (nullable id)convertedValueAtPath:(const FieldPath &)fieldPath
+            serverTimestampBehavior:(FIRServerTimestampBehavior)serverTimestampBehavior {
+  FSTFieldValueOptions *options = [self optionsForServerTimestampBehavior:serverTimestampBehavior];
+  return _snapshot.GetConvertedValue(fieldPath, options.serverTimestampBehavior,
+                                     ^id(FSTFieldValue *value) {
+                                       return [self convertedValue:value options:options];
+                                     });
+}
+
 - (FSTFieldValueOptions *)optionsForServerTimestampBehavior:
     (FIRServerTimestampBehavior)serverTimestampBehavior {
   SUPPRESS_DEPRECATED_DECLARATIONS_BEGIN()
@@ -19,7 +19,6 @@
 #include <functional>
 #include <string>
 #include <utility>
-#include <vector>
 
 #import "Firestore/Source/API/FIRFieldPath+Internal.h"
 
@@ -48,7 +47,7 @@ NS_ASSUME_NONNULL_BEGIN
     ThrowInvalidArgument("Invalid field path. Provided names must not be empty.");
   }
 
-  std::vector<std::string> field_names;
+  FieldPath::SegmentsT field_names;
   field_names.reserve(fieldNames.count);
   for (int i = 0; i < fieldNames.count; ++i) {
     field_names.emplace_back(util::MakeString(fieldNames[i]));
@@ -22,6 +22,7 @@
 #import <FirebaseCore/FIRLogger.h>
 #import <FirebaseCore/FIROptions.h>
 
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -30,6 +31,7 @@
 
 #import "Firestore/Source/API/FIRDocumentReference+Internal.h"
 #import "Firestore/Source/API/FIRFirestore+Internal.h"
+#import "Firestore/Source/API/FIRQuery+Internal.h"
 #import "Firestore/Source/API/FIRTransaction+Internal.h"
 #import "Firestore/Source/API/FSTFirestoreComponent.h"
 #import "Firestore/Source/API/FSTUserDataConverter.h"
@@ -44,6 +46,7 @@
 #include "Firestore/core/src/firebase/firestore/util/error_apple.h"
 #include "Firestore/core/src/firebase/firestore/util/executor_libdispatch.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/path.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
 
@@ -178,7 +181,9 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (void)setSettings:(FIRFirestoreSettings *)settings {
   if (![settings isEqual:_settings]) {
-    _settings = settings;
+    // Copy the settings so that later changes to the caller's instance aren't mistaken for the
+    // settings already in use.
+    _settings = [settings copy];
     _firestore->set_settings([settings internalSettings]);
 
     std::unique_ptr<util::Executor> user_executor =
@@ -302,6 +307,32 @@ NS_ASSUME_NONNULL_BEGIN
   _firestore->DisableNetwork(util::MakeCallback(completion));
 }
 
+- (void)loadBundleAtURL:(NSURL *)fileURL
+             completion:(nullable void (^)(NSDictionary<NSString *, FIRQuery *> *_Nullable,
+                                           NSError *_Nullable))completion {
+  if (!fileURL.isFileURL) {
+    ThrowInvalidArgument("Bundle URL must be a file URL but was %s", fileURL.absoluteString);
+  }
+
+  auto objcTranslator =
+      [self, completion](util::StatusOr<std::map<std::string, FSTQuery *>> maybeQueries) {
+        if (!completion) return;
+        if (!maybeQueries.ok()) {
+          completion(nil, util::MakeNSError(maybeQueries.status()));
+          return;
+        }
+
+        NSMutableDictionary<NSString *, FIRQuery *> *queries = [NSMutableDictionary dictionary];
+        for (const auto &entry : maybeQueries.ValueOrDie()) {
+          queries[util::WrapNSString(entry.first)] = [FIRQuery referenceWithQuery:entry.second
+                                                                        firestore:self];
+        }
+        completion(queries, nil);
+      };
+
+  _firestore->LoadBundle(util::Path::FromNSString(fileURL.path), std::move(objcTranslator));
+}
+
 @end
 
 @implementation FIRFirestore (Internal)
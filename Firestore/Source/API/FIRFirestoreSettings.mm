@@ -34,6 +34,28 @@ static const BOOL kDefaultPersistenceEnabled = YES;
 static const int64_t kDefaultCacheSizeBytes = 100 * 1024 * 1024;
 static const int64_t kMinimumCacheSizeBytes = 1 * 1024 * 1024;
 static const BOOL kDefaultTimestampsInSnapshotsEnabled = YES;
+static const BOOL kDefaultGroupCommitEnabled = NO;
+static const BOOL kDefaultSyncWritesEnabled = NO;
+static const int64_t kDefaultBlockCacheSizeBytes = 0;
+static const BOOL kDefaultBloomFilterEnabled = NO;
+static const int64_t kDefaultWriteBufferSizeBytes = 0;
+static const BOOL kDefaultVerifyChecksumsEnabled = YES;
+static const int64_t kDefaultMaxCoalescedWriteBytes = 0;
+static const BOOL kDefaultMutationCompactionEnabled = NO;
+static const BOOL kDefaultCompressionEnabled = NO;
+static const BOOL kDefaultPreconnectEnabled = NO;
+static const BOOL kDefaultDeferredMigrationsEnabled = NO;
+static const BOOL kDefaultMemoryCacheLRUEnabled = NO;
+static const BOOL kDefaultSharedResourcesEnabled = NO;
+static const int64_t kDefaultMemorySoftLimitBytes = 0;
+static const NSTimeInterval kDefaultSlowOperationThreshold = 0;
+static const BOOL kDefaultSharedViewsEnabled = NO;
+static const BOOL kDefaultBackgroundWritesEnabled = NO;
+static const BOOL kDefaultOptimisticWritesEnabled = NO;
+static const BOOL kDefaultMobileStorageTuningEnabled = NO;
+static const int64_t kDefaultMaxStorageFileSizeBytes = 0;
+static const int64_t kDefaultMaxOpenFiles = 0;
+static const BOOL kDefaultMultiProcessPersistenceEnabled = NO;
 
 @implementation FIRFirestoreSettings
 
@@ -45,6 +67,28 @@ static const BOOL kDefaultTimestampsInSnapshotsEnabled = YES;
     _persistenceEnabled = kDefaultPersistenceEnabled;
     _timestampsInSnapshotsEnabled = kDefaultTimestampsInSnapshotsEnabled;
     _cacheSizeBytes = kDefaultCacheSizeBytes;
+    _groupCommitEnabled = kDefaultGroupCommitEnabled;
+    _syncWritesEnabled = kDefaultSyncWritesEnabled;
+    _blockCacheSizeBytes = kDefaultBlockCacheSizeBytes;
+    _bloomFilterEnabled = kDefaultBloomFilterEnabled;
+    _writeBufferSizeBytes = kDefaultWriteBufferSizeBytes;
+    _verifyChecksumsEnabled = kDefaultVerifyChecksumsEnabled;
+    _maxCoalescedWriteBytes = kDefaultMaxCoalescedWriteBytes;
+    _mutationCompactionEnabled = kDefaultMutationCompactionEnabled;
+    _compressionEnabled = kDefaultCompressionEnabled;
+    _preconnectEnabled = kDefaultPreconnectEnabled;
+    _deferredMigrationsEnabled = kDefaultDeferredMigrationsEnabled;
+    _memoryCacheLRUEnabled = kDefaultMemoryCacheLRUEnabled;
+    _sharedResourcesEnabled = kDefaultSharedResourcesEnabled;
+    _memorySoftLimitBytes = kDefaultMemorySoftLimitBytes;
+    _slowOperationThreshold = kDefaultSlowOperationThreshold;
+    _sharedViewsEnabled = kDefaultSharedViewsEnabled;
+    _backgroundWritesEnabled = kDefaultBackgroundWritesEnabled;
+    _optimisticWritesEnabled = kDefaultOptimisticWritesEnabled;
+    _mobileStorageTuningEnabled = kDefaultMobileStorageTuningEnabled;
+    _maxStorageFileSizeBytes = kDefaultMaxStorageFileSizeBytes;
+    _maxOpenFiles = kDefaultMaxOpenFiles;
+    _multiProcessPersistenceEnabled = kDefaultMultiProcessPersistenceEnabled;
   }
   return self;
 }
@@ -56,27 +100,16 @@ static const BOOL kDefaultTimestampsInSnapshotsEnabled = YES;
     return NO;
   }
 
+  // Every setting other than the dispatch queue is carried by the internal settings, so comparing
+  // those keeps equality in step with the settings the client actually sees.
   FIRFirestoreSettings *otherSettings = (FIRFirestoreSettings *)other;
-  SUPPRESS_DEPRECATED_DECLARATIONS_BEGIN()
-  return [self.host isEqual:otherSettings.host] &&
-         self.isSSLEnabled == otherSettings.isSSLEnabled &&
-         self.dispatchQueue == otherSettings.dispatchQueue &&
-         self.isPersistenceEnabled == otherSettings.isPersistenceEnabled &&
-         self.timestampsInSnapshotsEnabled == otherSettings.timestampsInSnapshotsEnabled &&
-         self.cacheSizeBytes == otherSettings.cacheSizeBytes;
-  SUPPRESS_END()
+  return self.dispatchQueue == otherSettings.dispatchQueue &&
+         [self internalSettings] == [otherSettings internalSettings];
 }
 
 - (NSUInteger)hash {
-  NSUInteger result = [self.host hash];
-  result = 31 * result + (self.isSSLEnabled ? 1231 : 1237);
   // Ignore the dispatchQueue to avoid having to deal with sizeof(dispatch_queue_t).
-  result = 31 * result + (self.isPersistenceEnabled ? 1231 : 1237);
-  SUPPRESS_DEPRECATED_DECLARATIONS_BEGIN()
-  result = 31 * result + (self.timestampsInSnapshotsEnabled ? 1231 : 1237);
-  SUPPRESS_END()
-  result = 31 * result + (NSUInteger)self.cacheSizeBytes;
-  return result;
+  return [self internalSettings].Hash();
 }
 
 - (id)copyWithZone:(nullable NSZone *)zone {
@@ -89,6 +122,28 @@ static const BOOL kDefaultTimestampsInSnapshotsEnabled = YES;
   copy.timestampsInSnapshotsEnabled = _timestampsInSnapshotsEnabled;
   SUPPRESS_END()
   copy.cacheSizeBytes = _cacheSizeBytes;
+  copy.groupCommitEnabled = _groupCommitEnabled;
+  copy.syncWritesEnabled = _syncWritesEnabled;
+  copy.blockCacheSizeBytes = _blockCacheSizeBytes;
+  copy.bloomFilterEnabled = _bloomFilterEnabled;
+  copy.writeBufferSizeBytes = _writeBufferSizeBytes;
+  copy.verifyChecksumsEnabled = _verifyChecksumsEnabled;
+  copy.maxCoalescedWriteBytes = _maxCoalescedWriteBytes;
+  copy.mutationCompactionEnabled = _mutationCompactionEnabled;
+  copy.compressionEnabled = _compressionEnabled;
+  copy.preconnectEnabled = _preconnectEnabled;
+  copy.deferredMigrationsEnabled = _deferredMigrationsEnabled;
+  copy.memoryCacheLRUEnabled = _memoryCacheLRUEnabled;
+  copy.sharedResourcesEnabled = _sharedResourcesEnabled;
+  copy.memorySoftLimitBytes = _memorySoftLimitBytes;
+  copy.slowOperationThreshold = _slowOperationThreshold;
+  copy.sharedViewsEnabled = _sharedViewsEnabled;
+  copy.backgroundWritesEnabled = _backgroundWritesEnabled;
+  copy.optimisticWritesEnabled = _optimisticWritesEnabled;
+  copy.mobileStorageTuningEnabled = _mobileStorageTuningEnabled;
+  copy.maxStorageFileSizeBytes = _maxStorageFileSizeBytes;
+  copy.maxOpenFiles = _maxOpenFiles;
+  copy.multiProcessPersistenceEnabled = _multiProcessPersistenceEnabled;
   return copy;
 }
 
@@ -119,6 +174,55 @@ static const BOOL kDefaultTimestampsInSnapshotsEnabled = YES;
   _cacheSizeBytes = cacheSizeBytes;
 }
 
+- (void)setBlockCacheSizeBytes:(int64_t)blockCacheSizeBytes {
+  if (blockCacheSizeBytes < 0) {
+    ThrowInvalidArgument("Block cache size must not be negative");
+  }
+  _blockCacheSizeBytes = blockCacheSizeBytes;
+}
+
+- (void)setWriteBufferSizeBytes:(int64_t)writeBufferSizeBytes {
+  if (writeBufferSizeBytes < 0) {
+    ThrowInvalidArgument("Write buffer size must not be negative");
+  }
+  _writeBufferSizeBytes = writeBufferSizeBytes;
+}
+
+- (void)setMaxCoalescedWriteBytes:(int64_t)maxCoalescedWriteBytes {
+  if (maxCoalescedWriteBytes < 0) {
+    ThrowInvalidArgument("Coalesced write size must not be negative");
+  }
+  _maxCoalescedWriteBytes = maxCoalescedWriteBytes;
+}
+
+- (void)setMemorySoftLimitBytes:(int64_t)memorySoftLimitBytes {
+  if (memorySoftLimitBytes < 0) {
+    ThrowInvalidArgument("Memory soft limit must not be negative");
+  }
+  _memorySoftLimitBytes = memorySoftLimitBytes;
+}
+
+- (void)setSlowOperationThreshold:(NSTimeInterval)slowOperationThreshold {
+  if (slowOperationThreshold < 0) {
+    ThrowInvalidArgument("Slow operation threshold must not be negative");
+  }
+  _slowOperationThreshold = slowOperationThreshold;
+}
+
+- (void)setMaxStorageFileSizeBytes:(int64_t)maxStorageFileSizeBytes {
+  if (maxStorageFileSizeBytes < 0) {
+    ThrowInvalidArgument("Storage file size must not be negative");
+  }
+  _maxStorageFileSizeBytes = maxStorageFileSizeBytes;
+}
+
+- (void)setMaxOpenFiles:(int64_t)maxOpenFiles {
+  if (maxOpenFiles < 0) {
+    ThrowInvalidArgument("Open file limit must not be negative");
+  }
+  _maxOpenFiles = maxOpenFiles;
+}
+
 - (Settings)internalSettings {
   Settings settings;
   settings.set_host(MakeString(_host));
@@ -126,6 +230,28 @@ static const BOOL kDefaultTimestampsInSnapshotsEnabled = YES;
   settings.set_persistence_enabled(_persistenceEnabled);
   settings.set_timestamps_in_snapshots_enabled(_timestampsInSnapshotsEnabled);
   settings.set_cache_size_bytes(_cacheSizeBytes);
+  settings.set_group_commit_enabled(_groupCommitEnabled);
+  settings.set_sync_writes_enabled(_syncWritesEnabled);
+  settings.set_block_cache_size_bytes(_blockCacheSizeBytes);
+  settings.set_bloom_filter_enabled(_bloomFilterEnabled);
+  settings.set_write_buffer_size_bytes(_writeBufferSizeBytes);
+  settings.set_verify_checksums_enabled(_verifyChecksumsEnabled);
+  settings.set_max_coalesced_write_bytes(_maxCoalescedWriteBytes);
+  settings.set_mutation_compaction_enabled(_mutationCompactionEnabled);
+  settings.set_compression_enabled(_compressionEnabled);
+  settings.set_preconnect_enabled(_preconnectEnabled);
+  settings.set_deferred_migrations_enabled(_deferredMigrationsEnabled);
+  settings.set_memory_lru_gc_enabled(_memoryCacheLRUEnabled);
+  settings.set_shared_resources_enabled(_sharedResourcesEnabled);
+  settings.set_memory_soft_limit_bytes(_memorySoftLimitBytes);
+  settings.set_slow_operation_threshold_ms(static_cast<int64_t>(_slowOperationThreshold * 1000));
+  settings.set_shared_views_enabled(_sharedViewsEnabled);
+  settings.set_background_writes_enabled(_backgroundWritesEnabled);
+  settings.set_optimistic_writes_enabled(_optimisticWritesEnabled);
+  settings.set_mobile_leveldb_env_enabled(_mobileStorageTuningEnabled);
+  settings.set_max_table_file_size_bytes(_maxStorageFileSizeBytes);
+  settings.set_max_open_files(_maxOpenFiles);
+  settings.set_shared_cache_enabled(_multiProcessPersistenceEnabled);
   return settings;
 }
 
@@ -17,6 +17,7 @@
 #import "FIRQuery.h"
 
 #include <memory>
+#include <set>
 #include <utility>
 
 #import "FIRDocumentReference.h"
@@ -42,6 +43,7 @@
 #include "Firestore/core/src/firebase/firestore/api/input_validation.h"
 #include "Firestore/core/src/firebase/firestore/core/filter.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/field_mask.h"
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
@@ -63,6 +65,7 @@ using firebase::firestore::core::ListenOptions;
 using firebase::firestore::core::QueryListener;
 using firebase::firestore::core::ViewSnapshot;
 using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::FieldMask;
 using firebase::firestore::model::FieldPath;
 using firebase::firestore::model::FieldValue;
 using firebase::firestore::model::ResourcePath;
@@ -399,6 +402,24 @@ NS_ASSUME_NONNULL_BEGIN
   return [FIRQuery referenceWithQuery:[self.query queryBySettingLimit:limit] firestore:_firestore];
 }
 
+- (FIRQuery *)queryBySelectingFields:(NSArray<id> *)fields {
+  if (fields.count == 0) {
+    ThrowInvalidArgument("Invalid Query. A projection must select at least one field.");
+  }
+  std::set<FieldPath> paths;
+  for (id field in fields) {
+    if ([field isKindOfClass:[NSString class]]) {
+      paths.insert([FIRFieldPath pathWithDotSeparatedString:field].internalValue);
+    } else if ([field isKindOfClass:[FIRFieldPath class]]) {
+      paths.insert(((FIRFieldPath *)field).internalValue);
+    } else {
+      ThrowInvalidArgument("Invalid Query. Fields to select must be NSStrings or FIRFieldPaths.");
+    }
+  }
+  FSTQuery *query = [self.query queryBySelectingFields:FieldMask{std::move(paths)}];
+  return [FIRQuery referenceWithQuery:query firestore:self.firestore];
+}
+
 - (FIRQuery *)queryStartingAtDocument:(FIRDocumentSnapshot *)snapshot {
   FSTBound *bound = [self boundFromSnapshot:snapshot isBefore:YES];
   return [FIRQuery referenceWithQuery:[self.query queryByAddingStartAt:bound]
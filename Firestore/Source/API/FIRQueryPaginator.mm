@@ -0,0 +1,112 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "FIRQueryPaginator.h"
+
+#import "FIRListenerRegistration.h"
+#import "FIRQuery.h"
+#import "FIRQuerySnapshot.h"
+
+#include "Firestore/core/src/firebase/firestore/api/input_validation.h"
+
+using firebase::firestore::api::ThrowIllegalState;
+using firebase::firestore::api::ThrowInvalidArgument;
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation FIRQueryPaginator {
+  FIRQuery *_query;
+  NSInteger _pageSize;
+
+  /** The query for the next page, or nil once the last page has been delivered. */
+  FIRQuery *_Nullable _nextPageQuery;
+
+  /** The listener keeping the next page's target open, if any. */
+  id<FIRListenerRegistration> _Nullable _prefetchRegistration;
+
+  BOOL _pageRequested;
+}
+
+- (instancetype)initWithQuery:(FIRQuery *)query pageSize:(NSInteger)pageSize {
+  if (pageSize <= 0) {
+    ThrowInvalidArgument("Invalid page size (%s). Page size must be positive.", pageSize);
+  }
+  if (self = [super init]) {
+    _query = query;
+    _pageSize = pageSize;
+    _nextPageQuery = [query queryLimitedTo:pageSize];
+  }
+  return self;
+}
+
+- (void)dealloc {
+  [self stop];
+}
+
+- (BOOL)hasNextPage {
+  return _nextPageQuery != nil;
+}
+
+- (void)getNextPageWithCompletion:(void (^)(FIRQuerySnapshot *_Nullable page,
+                                            NSError *_Nullable error))completion {
+  if (_pageRequested) {
+    ThrowIllegalState("The next page was requested before the previous one was delivered.");
+  }
+  if (!_nextPageQuery) {
+    completion(nil, nil);
+    return;
+  }
+
+  _pageRequested = YES;
+  [_nextPageQuery getDocumentsWithCompletion:^(FIRQuerySnapshot *_Nullable page,
+                                               NSError *_Nullable error) {
+    self->_pageRequested = NO;
+    if (error) {
+      // Keep the next page query (and its prefetch listener) so that the page can be requested
+      // again.
+      completion(nil, error);
+      return;
+    }
+
+    [self stop];
+    if (page.count < self->_pageSize) {
+      self->_nextPageQuery = nil;
+    } else {
+      self->_nextPageQuery =
+          [[self->_query queryStartingAfterDocument:page.documents.lastObject]
+              queryLimitedTo:self->_pageSize];
+      [self prefetchNextPage];
+    }
+    completion(page, nil);
+  }];
+}
+
+- (void)prefetchNextPage {
+  // The listener itself does nothing: it only keeps the target active so that the documents of
+  // the page are synced into the cache before the page is requested.
+  _prefetchRegistration =
+      [_nextPageQuery addSnapshotListener:^(FIRQuerySnapshot *_Nullable, NSError *_Nullable){
+      }];
+}
+
+- (void)stop {
+  [_prefetchRegistration remove];
+  _prefetchRegistration = nil;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
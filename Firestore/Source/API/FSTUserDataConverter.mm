@@ -32,6 +32,8 @@
 #import "Firestore/Source/Model/FSTFieldValue.h"
 #import "Firestore/Source/Model/FSTMutation.h"
 
+#include "Firestore/core/include/firebase/firestore/geo_point.h"
+#include "Firestore/core/include/firebase/firestore/timestamp.h"
 #include "Firestore/core/src/firebase/firestore/api/input_validation.h"
 #include "Firestore/core/src/firebase/firestore/core/user_data.h"
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
@@ -45,8 +47,11 @@
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/match.h"
+#include "absl/types/optional.h"
 
 namespace util = firebase::firestore::util;
+using firebase::Timestamp;
+using firebase::firestore::GeoPoint;
 using firebase::firestore::api::ThrowInvalidArgument;
 using firebase::firestore::core::ParsedSetData;
 using firebase::firestore::core::ParsedUpdateData;
@@ -61,6 +66,7 @@ using firebase::firestore::model::FieldPath;
 using firebase::firestore::model::FieldTransform;
 using firebase::firestore::model::FieldValue;
 using firebase::firestore::model::NumericIncrementTransform;
+using firebase::firestore::model::ObjectValue;
 using firebase::firestore::model::Precondition;
 using firebase::firestore::model::ServerTimestampTransform;
 using firebase::firestore::model::TransformOperation;
@@ -116,9 +122,9 @@ NS_ASSUME_NONNULL_BEGIN
   }
 
   ParseAccumulator accumulator{UserDataSource::Set};
-  FSTFieldValue *updateData = [self parseData:input context:accumulator.RootContext()];
+  absl::optional<FieldValue> updateData = [self parseData:input context:accumulator.RootContext()];
 
-  return std::move(accumulator).SetData((FSTObjectValue *)updateData);
+  return std::move(accumulator).SetData(ObjectValue{std::move(*updateData)});
 }
 
 - (ParsedSetData)parsedMergeData:(id)input fieldMask:(nullable NSArray<id> *)fieldMask {
@@ -130,8 +136,7 @@ NS_ASSUME_NONNULL_BEGIN
 
   ParseAccumulator accumulator{UserDataSource::MergeSet};
 
-  FSTObjectValue *updateData = (FSTObjectValue *)[self parseData:input
-                                                         context:accumulator.RootContext()];
+  ObjectValue updateData{*[self parseData:input context:accumulator.RootContext()]};
 
   if (fieldMask) {
     std::set<FieldPath> validatedFieldPaths;
@@ -156,10 +161,11 @@ NS_ASSUME_NONNULL_BEGIN
       validatedFieldPaths.insert(path);
     }
 
-    return std::move(accumulator).MergeData(updateData, FieldMask{std::move(validatedFieldPaths)});
+    return std::move(accumulator)
+        .MergeData(std::move(updateData), FieldMask{std::move(validatedFieldPaths)});
 
   } else {
-    return std::move(accumulator).MergeData(updateData);
+    return std::move(accumulator).MergeData(std::move(updateData));
   }
 }
 
@@ -174,7 +180,8 @@ NS_ASSUME_NONNULL_BEGIN
 
   ParseAccumulator accumulator{UserDataSource::Update};
   __block ParseContext context = accumulator.RootContext();
-  __block FSTObjectValue *updateData = [FSTObjectValue objectValue];
+  // Updates usually name many distinct paths, so apply them all at once.
+  __block ObjectValue::Builder updateData;
 
   [dict enumerateKeysAndObjectsUsingBlock:^(id key, id value, BOOL *stop) {
     FieldPath path;
@@ -192,26 +199,26 @@ NS_ASSUME_NONNULL_BEGIN
       // Add it to the field mask, but don't add anything to updateData.
       context.AddToFieldMask(std::move(path));
     } else {
-      FSTFieldValue *_Nullable parsedValue = [self parseData:value
-                                                     context:context.ChildContext(path)];
+      absl::optional<FieldValue> parsedValue = [self parseData:value
+                                                       context:context.ChildContext(path)];
       if (parsedValue) {
         context.AddToFieldMask(path);
-        updateData = [updateData objectBySettingValue:parsedValue forPath:path];
+        updateData.Set(path, std::move(*parsedValue));
       }
     }
   }];
 
-  return std::move(accumulator).UpdateData(updateData);
+  return std::move(accumulator).UpdateData(updateData.Build());
 }
 
 - (FSTFieldValue *)parsedQueryValue:(id)input {
   ParseAccumulator accumulator{UserDataSource::Argument};
 
-  FSTFieldValue *_Nullable parsed = [self parseData:input context:accumulator.RootContext()];
+  absl::optional<FieldValue> parsed = [self parseData:input context:accumulator.RootContext()];
   HARD_ASSERT(parsed, "Parsed data should not be nil.");
   HARD_ASSERT(accumulator.field_transforms().empty(),
               "Field transforms should have been disallowed.");
-  return parsed;
+  return std::move(*parsed).Wrap();
 }
 
 /**
@@ -221,10 +228,10 @@ NS_ASSUME_NONNULL_BEGIN
  * @param context A context object representing the current path being parsed, the source of the
  *   data being parsed, etc.
  *
- * @return The parsed value, or nil if the value was a FieldValue sentinel that should not be
- *   included in the resulting parsed data.
+ * @return The parsed value, or absl::nullopt if the value was a FieldValue sentinel that should not
+ *   be included in the resulting parsed data.
  */
-- (nullable FSTFieldValue *)parseData:(id)input context:(ParseContext &&)context {
+- (absl::optional<FieldValue>)parseData:(id)input context:(ParseContext &&)context {
   input = self.preConverter(input);
   if ([input isKindOfClass:[NSDictionary class]]) {
     return [self parseDictionary:(NSDictionary *)input context:std::move(context)];
@@ -233,9 +240,9 @@ NS_ASSUME_NONNULL_BEGIN
     // FieldValues usually parse into transforms (except FieldValue.delete()) in which case we
     // do not want to include this field in our parsed data (as doing so will overwrite the field
     // directly prior to the transform trying to transform it). So we don't call appendToFieldMask
-    // and we return nil as our parsing result.
+    // and we return absl::nullopt as our parsing result.
     [self parseSentinelFieldValue:(FIRFieldValue *)input context:std::move(context)];
-    return nil;
+    return absl::nullopt;
 
   } else {
     // If context path is unset we are already inside an array and we don't support field mask paths
@@ -256,39 +263,38 @@ NS_ASSUME_NONNULL_BEGIN
   }
 }
 
-- (FSTFieldValue *)parseDictionary:(NSDictionary *)dict context:(ParseContext &&)context {
-  NSMutableDictionary<NSString *, FSTFieldValue *> *result =
-      [NSMutableDictionary dictionaryWithCapacity:dict.count];
-
+- (FieldValue)parseDictionary:(NSDictionary *)dict context:(ParseContext &&)context {
   if ([dict count] == 0) {
     const FieldPath *path = context.path();
     if (path && !path->empty()) {
       context.AddToFieldMask(*path);
     }
-    return [FSTObjectValue objectValue];
-  } else {
-    [dict enumerateKeysAndObjectsUsingBlock:^(NSString *key, id value, BOOL *stop) {
-      FSTFieldValue *_Nullable parsedValue =
-          [self parseData:value context:context.ChildContext(util::MakeString(key))];
-      if (parsedValue) {
-        result[key] = parsedValue;
-      }
-    }];
+    return FieldValue::EmptyObject();
   }
-  return [[FSTObjectValue alloc] initWithDictionary:result];
+
+  __block std::vector<std::pair<std::string, FieldValue>> result;
+  result.reserve(dict.count);
+  [dict enumerateKeysAndObjectsUsingBlock:^(NSString *key, id value, BOOL *stop) {
+    std::string field = util::MakeString(key);
+    absl::optional<FieldValue> parsedValue = [self parseData:value
+                                                     context:context.ChildContext(field)];
+    if (parsedValue) {
+      result.emplace_back(std::move(field), std::move(*parsedValue));
+    }
+  }];
+  return FieldValue::FromMap(FieldValue::Map{}.insert_all(result));
 }
 
-- (FSTFieldValue *)parseArray:(NSArray *)array context:(ParseContext &&)context {
-  NSMutableArray<FSTFieldValue *> *result = [NSMutableArray arrayWithCapacity:array.count];
+- (FieldValue)parseArray:(NSArray *)array context:(ParseContext &&)context {
+  __block std::vector<FieldValue> result;
+  result.reserve(array.count);
   [array enumerateObjectsUsingBlock:^(id entry, NSUInteger idx, BOOL *stop) {
-    FSTFieldValue *_Nullable parsedEntry = [self parseData:entry context:context.ChildContext(idx)];
-    if (!parsedEntry) {
-      // Just include nulls in the array for fields being replaced with a sentinel.
-      parsedEntry = [FSTNullValue nullValue];
-    }
-    [result addObject:parsedEntry];
+    absl::optional<FieldValue> parsedEntry = [self parseData:entry
+                                                     context:context.ChildContext(idx)];
+    // Just include nulls in the array for fields being replaced with a sentinel.
+    result.push_back(parsedEntry ? std::move(*parsedEntry) : FieldValue::Null());
   }];
-  return [[FSTArrayValue alloc] initWithValueNoCopy:result];
+  return FieldValue::FromArray(std::move(result));
 }
 
 /**
@@ -366,9 +372,9 @@ NS_ASSUME_NONNULL_BEGIN
  *
  * @return The parsed value.
  */
-- (nullable FSTFieldValue *)parseScalarValue:(nullable id)input context:(ParseContext &&)context {
+- (FieldValue)parseScalarValue:(nullable id)input context:(ParseContext &&)context {
   if (!input || [input isMemberOfClass:[NSNull class]]) {
-    return [FSTNullValue nullValue];
+    return FieldValue::Null();
 
   } else if ([input isKindOfClass:[NSNumber class]]) {
     // Recover the underlying type of the number, using the method described here:
@@ -380,7 +386,7 @@ NS_ASSUME_NONNULL_BEGIN
     // Articles/ocrtTypeEncodings.html
     switch (cType[0]) {
       case 'q':
-        return [FSTIntegerValue integerValue:[input longLongValue]];
+        return FieldValue::FromInteger([input longLongValue]);
 
       case 'i':  // Falls through.
       case 's':  // Falls through.
@@ -389,7 +395,7 @@ NS_ASSUME_NONNULL_BEGIN
       case 'S':
         // Coerce integer values that aren't long long. Allow unsigned integer types that are
         // guaranteed small enough to skip a length check.
-        return [FSTIntegerValue integerValue:[input longLongValue]];
+        return FieldValue::FromInteger([input longLongValue]);
 
       case 'L':  // Falls through.
       case 'Q':
@@ -403,19 +409,17 @@ NS_ASSUME_NONNULL_BEGIN
                                  context.FieldDescription());
 
           } else {
-            return [FSTIntegerValue integerValue:(int64_t)extended];
+            return FieldValue::FromInteger((int64_t)extended);
           }
         }
 
       case 'f':
-        return [FSTDoubleValue doubleValue:[input doubleValue]];
+        return FieldValue::FromDouble([input doubleValue]);
 
       case 'd':
-        // Double values are already the right type, so just reuse the existing boxed double.
-        //
         // Note that NSNumber already performs NaN normalization to a single shared instance
         // so there's no need to treat NaN specially here.
-        return [FSTDoubleValue doubleValue:[input doubleValue]];
+        return FieldValue::FromDouble([input doubleValue]);
 
       case 'B':  // Falls through.
       case 'c':  // Falls through.
@@ -427,7 +431,7 @@ NS_ASSUME_NONNULL_BEGIN
         // legitimate usage of signed chars is impossible, but this should be rare.
         //
         // Additionally, for consistency, map unsigned chars to bools in the same way.
-        return FieldValue::FromBoolean([input boolValue]).Wrap();
+        return FieldValue::FromBoolean([input boolValue]);
 
       default:
         // All documented codes should be handled above, so this shouldn't happen.
@@ -435,23 +439,24 @@ NS_ASSUME_NONNULL_BEGIN
     }
 
   } else if ([input isKindOfClass:[NSString class]]) {
-    return FieldValue::FromString(util::MakeString(input)).Wrap();
+    return FieldValue::FromString(util::MakeString(input));
 
   } else if ([input isKindOfClass:[NSDate class]]) {
-    return [FSTTimestampValue timestampValue:[FIRTimestamp timestampWithDate:input]];
+    FIRTimestamp *timestamp = [FIRTimestamp timestampWithDate:input];
+    return FieldValue::FromTimestamp(Timestamp{timestamp.seconds, timestamp.nanoseconds});
 
   } else if ([input isKindOfClass:[FIRTimestamp class]]) {
     FIRTimestamp *originalTimestamp = (FIRTimestamp *)input;
-    FIRTimestamp *truncatedTimestamp =
-        [FIRTimestamp timestampWithSeconds:originalTimestamp.seconds
-                               nanoseconds:originalTimestamp.nanoseconds / 1000 * 1000];
-    return [FSTTimestampValue timestampValue:truncatedTimestamp];
+    return FieldValue::FromTimestamp(
+        Timestamp{originalTimestamp.seconds, originalTimestamp.nanoseconds / 1000 * 1000});
 
   } else if ([input isKindOfClass:[FIRGeoPoint class]]) {
-    return [FSTGeoPointValue geoPointValue:input];
+    FIRGeoPoint *geoPoint = (FIRGeoPoint *)input;
+    return FieldValue::FromGeoPoint(GeoPoint{geoPoint.latitude, geoPoint.longitude});
 
   } else if ([input isKindOfClass:[NSData class]]) {
-    return [FSTBlobValue blobValue:input];
+    NSData *blob = (NSData *)input;
+    return FieldValue::FromBlob(static_cast<const uint8_t *>(blob.bytes), blob.length);
 
   } else if ([input isKindOfClass:[FSTDocumentKeyReference class]]) {
     FSTDocumentKeyReference *reference = input;
@@ -462,8 +467,7 @@ NS_ASSUME_NONNULL_BEGIN
           other->project_id(), other->database_id(), self.databaseID->project_id(),
           self.databaseID->database_id(), context.FieldDescription());
     }
-    return [FSTReferenceValue referenceValue:[FSTDocumentKey keyWithDocumentKey:reference.key]
-                                  databaseID:self.databaseID];
+    return FieldValue::FromReference(reference.key, self.databaseID);
 
   } else {
     ThrowInvalidArgument("Unsupported type: %s%s", NSStringFromClass([input class]),
@@ -481,10 +485,11 @@ NS_ASSUME_NONNULL_BEGIN
     // are not considered writes since they cannot contain any FieldValue sentinels, etc.
     ParseContext context = accumulator.RootContext();
 
-    FSTFieldValue *parsedElement = [self parseData:element context:context.ChildContext(i)];
+    absl::optional<FieldValue> parsedElement = [self parseData:element
+                                                       context:context.ChildContext(i)];
     HARD_ASSERT(parsedElement && accumulator.field_transforms().size() == 0,
                 "Failed to properly parse array transform element: %s", element);
-    values.push_back(parsedElement);
+    values.push_back(std::move(*parsedElement).Wrap());
   }
   return values;
 }
@@ -39,6 +39,14 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @interface FSTEventManager : NSObject
 
+/**
+ * Whether a query whose results can be computed from those of another listened query takes them
+ * from that query's view, with no target or view of its own. The other query is either the same
+ * query with a larger limit or none, or an unfiltered query on the same collection, whose results
+ * are matched against the query's filters, sorted and limited locally.
+ */
+@property(nonatomic, assign) BOOL sharedViewsEnabled;
+
 + (instancetype)eventManagerWithSyncEngine:(FSTSyncEngine *)syncEngine;
 
 - (instancetype)init NS_UNAVAILABLE;
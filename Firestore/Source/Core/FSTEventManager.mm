@@ -16,13 +16,16 @@
 
 #import "Firestore/Source/Core/FSTEventManager.h"
 
+#include <algorithm>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Core/FSTSyncEngine.h"
+#import "Firestore/Source/Model/FSTDocument.h"
 
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
 #include "Firestore/core/src/firebase/firestore/util/error_apple.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
@@ -37,6 +40,8 @@ namespace objc = firebase::firestore::util::objc;
 using firebase::firestore::core::DocumentViewChange;
 using firebase::firestore::core::QueryListener;
 using firebase::firestore::core::ViewSnapshot;
+using firebase::firestore::model::DocumentKeySet;
+using firebase::firestore::model::DocumentSet;
 using firebase::firestore::model::OnlineState;
 using firebase::firestore::model::TargetId;
 using firebase::firestore::util::MakeStatus;
@@ -54,6 +59,21 @@ struct QueryListenersInfo {
   TargetId target_id;
   std::vector<std::shared_ptr<QueryListener>> listeners;
 
+  /**
+   * The query whose view this query takes its results from, or nil if the query has a target and
+   * view of its own.
+   */
+  FSTQuery *_Nullable source = nil;
+
+  /** The queries that take their results from the view of this one. */
+  std::vector<FSTQuery *> derived_queries;
+
+  /**
+   * Whether the query took its results from another query's view before it got a view of its
+   * own, so the first snapshot of its own view has to be raised as changes to the last one.
+   */
+  bool continues_derived = false;
+
   void Erase(const std::shared_ptr<QueryListener> &listener) {
     auto found = absl::c_find(listeners, listener);
     if (found != listeners.end()) {
@@ -61,6 +81,15 @@ struct QueryListenersInfo {
     }
   }
 
+  void EraseDerived(FSTQuery *query) {
+    auto found = absl::c_find_if(derived_queries, [query](FSTQuery *derived) {
+      return [derived isEqual:query];
+    });
+    if (found != derived_queries.end()) {
+      derived_queries.erase(found);
+    }
+  }
+
   const absl::optional<ViewSnapshot> &view_snapshot() const {
     return snapshot_;
   }
@@ -75,6 +104,97 @@ struct QueryListenersInfo {
   absl::optional<ViewSnapshot> snapshot_;
 };
 
+/**
+ * Returns the documents of `query` taken from `source`, a snapshot of a query that `query` is a
+ * limited prefix or a matched subset of.
+ */
+DocumentSet DeriveDocuments(FSTQuery *query, const ViewSnapshot &source) {
+  if ([query isLimitedPrefixOfQuery:source.query()]) {
+    return source.documents().Truncate(static_cast<size_t>(query.limit));
+  }
+
+  DocumentSet documents{query.comparator};
+  for (FSTDocument *doc : source.documents()) {
+    if ([query matchesDocument:doc]) {
+      documents = documents.insert(doc);
+    }
+  }
+  if (query.limit != NSNotFound) {
+    documents = documents.Truncate(static_cast<size_t>(query.limit));
+  }
+  return documents;
+}
+
+/**
+ * Returns the snapshot of `query` taken from `source`, a snapshot of a query that `query` is a
+ * limited prefix or a matched subset of, with its changes computed against `previous`. Returns
+ * nullopt if neither the documents nor the sync state changed since `previous`.
+ */
+absl::optional<ViewSnapshot> DeriveSnapshot(FSTQuery *query,
+                                            const ViewSnapshot &source,
+                                            const absl::optional<ViewSnapshot> &previous) {
+  DocumentSet documents = DeriveDocuments(query, source);
+  DocumentSet old_documents = previous ? previous->documents() : DocumentSet{query.comparator};
+  DocumentKeySet old_mutated_keys = previous ? previous->mutated_keys() : DocumentKeySet{};
+
+  DocumentKeySet mutated_keys;
+  for (FSTDocument *doc : documents) {
+    if (source.mutated_keys().contains(doc.key)) {
+      mutated_keys = mutated_keys.insert(doc.key);
+    }
+  }
+
+  std::vector<DocumentViewChange> changes;
+  for (FSTDocument *old_doc : old_documents) {
+    if (!documents.ContainsKey(old_doc.key)) {
+      changes.emplace_back(old_doc, DocumentViewChange::Type::kRemoved);
+    }
+  }
+  for (FSTDocument *doc : documents) {
+    FSTDocument *old_doc = old_documents.GetDocument(doc.key);
+    if (!old_doc) {
+      changes.emplace_back(doc, DocumentViewChange::Type::kAdded);
+    } else if (![old_doc hasSameDataAs:doc]) {
+      changes.emplace_back(doc, DocumentViewChange::Type::kModified);
+    } else if (old_mutated_keys.contains(doc.key) != mutated_keys.contains(doc.key)) {
+      changes.emplace_back(doc, DocumentViewChange::Type::kMetadata);
+    }
+  }
+
+  bool sync_state_changed = !previous || previous->from_cache() != source.from_cache();
+  if (changes.empty() && !sync_state_changed) {
+    return absl::nullopt;
+  }
+
+  core::SortDocumentViewChanges(query, &changes);
+  return ViewSnapshot{query,
+                      std::move(documents),
+                      std::move(old_documents),
+                      std::move(changes),
+                      std::move(mutated_keys),
+                      source.from_cache(),
+                      sync_state_changed,
+                      source.excludes_metadata_changes()};
+}
+
+/**
+ * Raises the snapshot of `query` taken from `source` to the query's listeners, unless nothing
+ * changed since the last one.
+ */
+void RaiseDerivedSnapshot(FSTQuery *query,
+                          QueryListenersInfo *query_info,
+                          const ViewSnapshot &source) {
+  absl::optional<ViewSnapshot> snapshot =
+      DeriveSnapshot(query, source, query_info->view_snapshot());
+  if (!snapshot) {
+    return;
+  }
+  for (const auto &listener : query_info->listeners) {
+    listener->OnViewSnapshot(*snapshot);
+  }
+  query_info->set_view_snapshot(snapshot);
+}
+
 }  // namespace
 
 #pragma mark - FSTEventManager
@@ -120,7 +240,12 @@ struct QueryListenersInfo {
   }
 
   if (first_listen) {
-    query_info.target_id = [self.syncEngine listenToQuery:query];
+    FSTQuery *source = self.sharedViewsEnabled ? [self sourceQueryForQuery:query] : nil;
+    if (source) {
+      [self deriveQuery:query fromQuery:source];
+    } else {
+      query_info.target_id = [self.syncEngine listenToQuery:query];
+    }
   }
   return query_info.target_id;
 }
@@ -137,8 +262,66 @@ struct QueryListenersInfo {
   }
 
   if (last_listen) {
+    FSTQuery *source = found_iter->second.source;
+    std::vector<FSTQuery *> derived_queries = std::move(found_iter->second.derived_queries);
     _queries.erase(found_iter);
-    [self.syncEngine stopListeningToQuery:query];
+
+    if (source) {
+      _queries.at(source).EraseDerived(query);
+    } else {
+      [self.syncEngine stopListeningToQuery:query];
+      [self reattachDerivedQueries:std::move(derived_queries)];
+    }
+  }
+}
+
+/**
+ * Returns a listened query with a view of its own that @a query can take its results from, or nil
+ * if there's none.
+ */
+- (nullable FSTQuery *)sourceQueryForQuery:(FSTQuery *)query {
+  for (const auto &kv : _queries) {
+    if (!kv.second.source && ![kv.first isEqual:query] &&
+        ([query isLimitedPrefixOfQuery:kv.first] || [query isMatchedSubsetOfQuery:kv.first])) {
+      return kv.first;
+    }
+  }
+  return nil;
+}
+
+/** Makes @a query take its results from the view of @a source from now on. */
+- (void)deriveQuery:(FSTQuery *)query fromQuery:(FSTQuery *)source {
+  QueryListenersInfo &source_info = _queries.at(source);
+  QueryListenersInfo &query_info = _queries.at(query);
+  query_info.source = source;
+  query_info.target_id = source_info.target_id;
+  source_info.derived_queries.push_back(query);
+
+  if (source_info.view_snapshot()) {
+    RaiseDerivedSnapshot(query, &query_info, *source_info.view_snapshot());
+  }
+}
+
+/**
+ * Finds new sources for queries that took their results from a query that's no longer listened
+ * to, or gives them views of their own if there's no other query to take them from.
+ */
+- (void)reattachDerivedQueries:(std::vector<FSTQuery *>)queries {
+  // The queries with larger limits go first, so that the others can take their results from them.
+  std::stable_sort(queries.begin(), queries.end(),
+                   [](FSTQuery *lhs, FSTQuery *rhs) { return lhs.limit > rhs.limit; });
+
+  for (FSTQuery *query : queries) {
+    QueryListenersInfo &query_info = _queries.at(query);
+    query_info.source = nil;
+
+    FSTQuery *source = [self sourceQueryForQuery:query];
+    if (source) {
+      [self deriveQuery:query fromQuery:source];
+    } else {
+      query_info.continues_derived = true;
+      query_info.target_id = [self.syncEngine listenToQuery:query];
+    }
   }
 }
 
@@ -148,10 +331,20 @@ struct QueryListenersInfo {
     auto found_iter = _queries.find(query);
     if (found_iter != _queries.end()) {
       QueryListenersInfo &query_info = found_iter->second;
-      for (const auto &listener : query_info.listeners) {
-        listener->OnViewSnapshot(viewSnapshot);
+      if (query_info.continues_derived) {
+        // The listeners have already seen the results taken from the old source.
+        query_info.continues_derived = false;
+        RaiseDerivedSnapshot(found_iter->first, &query_info, viewSnapshot);
+      } else {
+        for (const auto &listener : query_info.listeners) {
+          listener->OnViewSnapshot(viewSnapshot);
+        }
+        query_info.set_view_snapshot(std::move(viewSnapshot));
+      }
+
+      for (FSTQuery *derived : query_info.derived_queries) {
+        RaiseDerivedSnapshot(derived, &_queries.at(derived), *query_info.view_snapshot());
       }
-      query_info.set_view_snapshot(std::move(viewSnapshot));
     }
   }
 }
@@ -164,9 +357,25 @@ struct QueryListenersInfo {
       listener->OnError(Status::FromNSError(error));
     }
 
+    // The queries that only limit this one's results fail with it. The ones that filter them may
+    // still be allowed on their own, so they get a source or target of their own instead.
+    std::vector<FSTQuery *> reattached;
+    for (FSTQuery *derived : query_info.derived_queries) {
+      if (![derived isLimitedPrefixOfQuery:query]) {
+        reattached.push_back(derived);
+        continue;
+      }
+      auto derived_iter = _queries.find(derived);
+      for (const auto &listener : derived_iter->second.listeners) {
+        listener->OnError(Status::FromNSError(error));
+      }
+      _queries.erase(derived_iter);
+    }
+
     // Remove all listeners. NOTE: We don't need to call [FSTSyncEngine stopListening] after an
     // error.
     _queries.erase(found_iter);
+    [self reattachDerivedQueries:std::move(reattached)];
   }
 }
 
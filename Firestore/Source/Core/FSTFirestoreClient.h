@@ -16,7 +16,10 @@
 
 #import <Foundation/Foundation.h>
 
+#include <functional>
+#include <map>
 #include <memory>
+#include <string>
 #include <vector>
 
 #import "Firestore/Source/Core/FSTTypes.h"
@@ -24,16 +27,39 @@
 #include "Firestore/core/src/firebase/firestore/api/document_reference.h"
 #include "Firestore/core/src/firebase/firestore/api/document_snapshot.h"
 #include "Firestore/core/src/firebase/firestore/api/settings.h"
+#include "Firestore/core/src/firebase/firestore/api/source.h"
 #include "Firestore/core/src/firebase/firestore/auth/credentials_provider.h"
+#include "Firestore/core/src/firebase/firestore/core/cache_warmer.h"
 #include "Firestore/core/src/firebase/firestore/core/database_info.h"
 #include "Firestore/core/src/firebase/firestore/core/listen_options.h"
 #include "Firestore/core/src/firebase/firestore/core/query_listener.h"
 #include "Firestore/core/src/firebase/firestore/core/transaction.h"
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
+#include "Firestore/core/src/firebase/firestore/local/query_profile.h"
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "Firestore/core/src/firebase/firestore/util/path.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor_callback.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+struct LevelDbStatistics;
+struct MemoryUsage;
+
+}  // namespace local
+
+namespace remote {
+
+struct NetworkMetrics;
+struct TargetStatistics;
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
 
 @class FIRDocumentReference;
 @class FIRDocumentSnapshot;
@@ -49,7 +75,9 @@
 namespace api = firebase::firestore::api;
 namespace auth = firebase::firestore::auth;
 namespace core = firebase::firestore::core;
+namespace local = firebase::firestore::local;
 namespace model = firebase::firestore::model;
+namespace remote = firebase::firestore::remote;
 namespace util = firebase::firestore::util;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -84,6 +112,46 @@ NS_ASSUME_NONNULL_BEGIN
 /** Enables the network connection and requeues all pending operations. */
 - (void)enableNetworkWithCallback:(util::StatusCallback)callback;
 
+/**
+ * Invokes the callback with a snapshot of the network counters and latencies collected since the
+ * client was created.
+ */
+- (void)getNetworkMetricsWithCallback:(std::function<void(const remote::NetworkMetrics &)>)callback;
+
+/**
+ * Invokes the callback with the documents added, modified and removed, the bytes received and the
+ * resets watch has sent for the query since it was last listened to, or with nothing if it isn't
+ * being listened to.
+ */
+- (void)getTargetStatisticsForQuery:(FSTQuery *)query
+                           callback:(std::function<void(const absl::optional<
+                                         remote::TargetStatistics> &)>)callback;
+
+/**
+ * Invokes the callback with the sizes, files and memory usage LevelDB reports for the local
+ * storage, or with nothing if persistence isn't backed by LevelDB.
+ */
+- (void)getLevelDBStatisticsWithCallback:
+    (std::function<void(const absl::optional<local::LevelDbStatistics> &)>)callback;
+
+/**
+ * Compacts the LevelDB database backing persistence, reclaiming the space held by deleted
+ * documents. Does nothing if persistence isn't backed by LevelDB.
+ */
+- (void)compactLocalStorageWithCallback:(util::StatusCallback)callback;
+
+/**
+ * Loads the bundle file at `path` (see local/bundle.h) into the local cache and raises snapshots
+ * for the documents it changed. Invokes the callback with the bundle's queries, by the names it
+ * gives them, or with the error that stopped the bundle from loading. The documents and queries
+ * applied before an error are kept.
+ */
+- (void)loadBundleAtPath:(const util::Path &)path
+                callback:(util::StatusOrCallback<std::map<std::string, FSTQuery *>>)callback;
+
+/** Invokes the callback with the estimated memory held by the client's caches and views. */
+- (void)getMemoryUsageWithCallback:(std::function<void(const local::MemoryUsage &)>)callback;
+
 /** Starts listening to a query. */
 - (std::shared_ptr<core::QueryListener>)listenToQuery:(FSTQuery *)query
                                               options:(core::ListenOptions)options
@@ -93,6 +161,23 @@ NS_ASSUME_NONNULL_BEGIN
 /** Stops listening to a query previously listened to. */
 - (void)removeListener:(const std::shared_ptr<core::QueryListener> &)listener;
 
+/**
+ * Starts or stops keeping the cached results of the query fresh with a background listen that has
+ * no snapshot listener attached, so that listening to the query later raises its first snapshot
+ * from an up to date cache. Background listens start at a limited rate and yield to interactive
+ * work (see `core::CacheWarmer`).
+ */
+- (void)keepQuerySynced:(FSTQuery *)query enabled:(BOOL)enabled;
+
+/**
+ * Invokes the callback with how fresh the cached results of the query are, or with nothing if the
+ * query isn't kept in sync.
+ */
+- (void)getCacheFreshnessForQuery:(FSTQuery *)query
+                         callback:
+                             (std::function<void(const absl::optional<core::CacheFreshness> &)>)
+                                 callback;
+
 /**
  * Retrieves a document from the cache via the indicated callback. If the doc
  * doesn't exist, an error will be sent to the callback.
@@ -100,6 +185,16 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)getDocumentFromLocalCache:(const api::DocumentReference &)doc
                          callback:(api::DocumentSnapshot::Listener &&)callback;
 
+/**
+ * Retrieves the given documents with a single read of the local cache and, unless `source` is
+ * `Source::Cache`, a single lookup on the backend. The callback receives one snapshot per
+ * reference, in the order of `docs`. With `Source::Default`, the cached documents are returned if
+ * the backend can't be reached.
+ */
+- (void)getDocuments:(std::vector<api::DocumentReference>)docs
+              source:(api::Source)source
+            callback:(util::StatusOrCallback<std::vector<api::DocumentSnapshot>>)callback;
+
 /**
  * Retrieves a (possibly empty) set of documents from the cache via the
  * indicated completion.
@@ -108,6 +203,16 @@ NS_ASSUME_NONNULL_BEGIN
                         completion:(void (^)(FIRQuerySnapshot *_Nullable query,
                                              NSError *_Nullable error))completion;
 
+/**
+ * Executes the query against the local cache like `getDocumentsFromLocalCache:completion:`, but
+ * reports how much work the execution took instead of its results: the keys scanned and documents
+ * decoded by the remote document cache, the mutation batches overlaid on them and the time spent
+ * in each phase. The counters stay zero in builds without thread_local (see
+ * `QueryProfile::IsSupported()`).
+ */
+- (void)explainQuery:(FSTQuery *)query
+            callback:(std::function<void(const local::QueryProfile &)>)callback;
+
 /** Write mutations. callback will be notified when it's written to the backend. */
 - (void)writeMutations:(std::vector<FSTMutation *> &&)mutations
               callback:(util::StatusCallback)callback;
@@ -18,8 +18,11 @@
 
 #include <chrono>  // NOLINT(build/c++11)
 #include <future>  // NOLINT(build/c++11)
+#include <map>
 #include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 
 #import "FIRFirestoreErrors.h"
 #import "Firestore/Source/API/FIRDocumentReference+Internal.h"
@@ -32,6 +35,7 @@
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Core/FSTSyncEngine.h"
 #import "Firestore/Source/Core/FSTView.h"
+#import "Firestore/Source/Local/FSTBundleLoader.h"
 #import "Firestore/Source/Local/FSTLRUGarbageCollector.h"
 #import "Firestore/Source/Local/FSTLevelDB.h"
 #import "Firestore/Source/Local/FSTLocalSerializer.h"
@@ -43,14 +47,19 @@
 
 #include "Firestore/core/src/firebase/firestore/api/settings.h"
 #include "Firestore/core/src/firebase/firestore/auth/credentials_provider.h"
+#include "Firestore/core/src/firebase/firestore/core/cache_warmer.h"
 #include "Firestore/core/src/firebase/firestore/core/database_info.h"
+#include "Firestore/core/src/firebase/firestore/core/shared_client_resources.h"
+#include "Firestore/core/src/firebase/firestore/local/query_profile.h"
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
 #include "Firestore/core/src/firebase/firestore/remote/datastore.h"
+#include "Firestore/core/src/firebase/firestore/remote/memory_pressure_monitor.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_store.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/metrics_registry.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
@@ -61,25 +70,39 @@ using firebase::firestore::FirestoreErrorCode;
 using firebase::firestore::api::DocumentReference;
 using firebase::firestore::api::DocumentSnapshot;
 using firebase::firestore::api::Settings;
+using firebase::firestore::api::Source;
 using firebase::firestore::api::SnapshotMetadata;
 using firebase::firestore::auth::CredentialsProvider;
 using firebase::firestore::auth::User;
+using firebase::firestore::core::CacheFreshness;
+using firebase::firestore::core::CacheWarmer;
 using firebase::firestore::core::DatabaseInfo;
 using firebase::firestore::core::ListenOptions;
 using firebase::firestore::core::QueryListener;
+using firebase::firestore::core::SharedClientResources;
 using firebase::firestore::core::ViewSnapshot;
+using firebase::firestore::local::LevelDbSettings;
+using firebase::firestore::local::LevelDbStatistics;
 using firebase::firestore::local::LruParams;
+using firebase::firestore::local::LruResults;
+using firebase::firestore::local::MemoryUsage;
+using firebase::firestore::local::QueryProfile;
 using firebase::firestore::model::DatabaseId;
+using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::DocumentMap;
 using firebase::firestore::model::MaybeDocumentMap;
 using firebase::firestore::model::OnlineState;
 using firebase::firestore::remote::Datastore;
+using firebase::firestore::remote::MemoryPressureMonitor;
+using firebase::firestore::remote::NetworkMetrics;
 using firebase::firestore::remote::RemoteStore;
+using firebase::firestore::remote::TargetStatistics;
 using firebase::firestore::util::Path;
 using firebase::firestore::util::AsyncQueue;
 using firebase::firestore::util::DelayedOperation;
 using firebase::firestore::util::Executor;
+using firebase::firestore::util::MetricsRegistry;
 using firebase::firestore::util::Status;
 using firebase::firestore::util::StatusOr;
 using firebase::firestore::util::StatusOrCallback;
@@ -91,6 +114,49 @@ NS_ASSUME_NONNULL_BEGIN
 static const std::chrono::milliseconds FSTLruGcInitialDelay = std::chrono::minutes(1);
 /** Minimum amount of time between GC checks, after the first one. */
 static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minutes(5);
+/** How long GC runs chunks of a collection before yielding the worker queue to other work. */
+static const std::chrono::milliseconds FSTLruGcTimeBudget = std::chrono::milliseconds(10);
+/**
+ * The number of targets and documents a collection must remove before the LevelDB database is
+ * compacted after it.
+ */
+static const int FSTLruGcCompactionThreshold = 1000;
+/** How often estimated memory use is compared against the soft limit, if there is one. */
+static const std::chrono::milliseconds FSTMemoryLimitCheckDelay = std::chrono::minutes(1);
+/** How long deferred migrations run chunks before yielding the worker queue to other work. */
+static const std::chrono::milliseconds FSTMigrationTimeBudget = std::chrono::milliseconds(10);
+
+namespace {
+
+/**
+ * The phases of starting a client, which every `FSTFirestoreClient` in the process records into.
+ * Together they show which part of startup a slow start spent its time in.
+ */
+struct StartupMetrics {
+  /** From creating the client until the credentials provider reported the first user. */
+  MetricsRegistry::Histogram *credentials =
+      MetricsRegistry::Default().GetHistogram("startup.credentials_latency");
+  /** Opening persistence, including any migrations that aren't deferred. */
+  MetricsRegistry::Histogram *persistenceOpen =
+      MetricsRegistry::Default().GetHistogram("startup.persistence_open_latency");
+  MetricsRegistry::Histogram *localStoreStart =
+      MetricsRegistry::Default().GetHistogram("startup.local_store_start_latency");
+  MetricsRegistry::Histogram *remoteStoreStart =
+      MetricsRegistry::Default().GetHistogram("startup.remote_store_start_latency");
+  /** From creating the client until it finished initializing. */
+  MetricsRegistry::Histogram *total =
+      MetricsRegistry::Default().GetHistogram("startup.total_latency");
+  /** How long the first listen waited for initialization before it was registered. */
+  MetricsRegistry::Histogram *firstListenInitializationWait =
+      MetricsRegistry::Default().GetHistogram("startup.first_listen_initialization_wait");
+};
+
+StartupMetrics &Metrics() {
+  static StartupMetrics metrics;
+  return metrics;
+}
+
+}  // namespace
 
 @interface FSTFirestoreClient () {
   DatabaseInfo _databaseInfo;
@@ -125,12 +191,26 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
 
   std::unique_ptr<RemoteStore> _remoteStore;
 
+  /** The resources shared with the app's other clients, if the settings enable sharing. */
+  std::shared_ptr<SharedClientResources> _sharedResources;
+
   std::unique_ptr<Executor> _userExecutor;
+  /** Decodes what bundles hold; created along with the local store. */
+  FSTLocalSerializer *_localSerializer;
   std::chrono::milliseconds _initialGcDelay;
   std::chrono::milliseconds _regularGcDelay;
   BOOL _gcHasRun;
   _Nullable id<FSTLRUDelegate> _lruDelegate;
   DelayedOperation _lruCallback;
+  FSTLevelDB *_Nullable _deferredMigrationsDB;
+  DelayedOperation _migrationCallback;
+  size_t _memorySoftLimitBytes;
+  DelayedOperation _memoryLimitCallback;
+  std::unique_ptr<MemoryPressureMonitor> _memoryPressureMonitor;
+  std::unique_ptr<CacheWarmer> _cacheWarmer;
+  std::chrono::steady_clock::time_point _creationTime;
+  /** Whether a listen has been registered yet; only accessed on the worker queue. */
+  BOOL _hasListened;
 }
 
 - (Executor *)userExecutor {
@@ -161,11 +241,22 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
                         userExecutor:(std::unique_ptr<Executor>)userExecutor
                          workerQueue:(std::unique_ptr<AsyncQueue>)workerQueue {
   if (self = [super init]) {
+    _creationTime = std::chrono::steady_clock::now();
     _databaseInfo = databaseInfo;
     _credentialsProvider = credentialsProvider;
     _userExecutor = std::move(userExecutor);
     _workerQueue = std::move(workerQueue);
+    if (settings.shared_resources_enabled()) {
+      _sharedResources = SharedClientResources::Acquire(
+          databaseInfo.persistence_key(), static_cast<size_t>(settings.block_cache_size_bytes()));
+      _sharedResources->ShareWorkerQueue(_workerQueue.get());
+    }
+    if (settings.slow_operation_threshold_ms() > 0) {
+      [self watchForSlowOperationsWithThreshold:std::chrono::milliseconds(
+                                                    settings.slow_operation_threshold_ms())];
+    }
     _gcHasRun = NO;
+    _hasListened = NO;
     _initialGcDelay = FSTLruGcInitialDelay;
     _regularGcDelay = FSTLruGcRegularDelay;
 
@@ -182,7 +273,8 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
         userPromise->set_value(user);
       } else {
         strongSelf->_workerQueue->Enqueue(
-            [strongSelf, user] { [strongSelf credentialDidChangeWithUser:user]; });
+            [strongSelf, user] { [strongSelf credentialDidChangeWithUser:user]; },
+            AsyncQueue::Priority::Interactive, "credentialDidChange");
       }
     };
 
@@ -193,8 +285,9 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
     // before any subsequently queued work runs.
     _workerQueue->Enqueue([self, userPromise, settings] {
       User user = userPromise->get_future().get();
+      Metrics().credentials->RecordElapsedSince(self->_creationTime);
       [self initializeWithUser:user settings:settings];
-    });
+    }, AsyncQueue::Priority::Interactive, "initialize");
   }
   return self;
 }
@@ -203,23 +296,43 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
   // Do all of our initialization on our own dispatch queue.
   _workerQueue->VerifyIsCurrentQueue();
   LOG_DEBUG("Initializing. Current user: %s", user.uid());
+  auto startTime = std::chrono::steady_clock::now();
 
   // Note: The initialization work must all be synchronous (we can't dispatch more work) since
   // external write/listen operations could get queued to run before that subsequent work
   // completes.
+  FSTSerializerBeta *remoteSerializer =
+      [[FSTSerializerBeta alloc] initWithDatabaseID:&self.databaseInfo->database_id()];
+  FSTLocalSerializer *serializer =
+      [[FSTLocalSerializer alloc] initWithRemoteSerializer:remoteSerializer];
+  _localSerializer = serializer;
+  auto persistenceStartTime = std::chrono::steady_clock::now();
   if (settings.persistence_enabled()) {
     Path dir = [FSTLevelDB storageDirectoryForDatabaseInfo:*self.databaseInfo
                                         documentsDirectory:[FSTLevelDB documentsDirectory]];
 
-    FSTSerializerBeta *remoteSerializer =
-        [[FSTSerializerBeta alloc] initWithDatabaseID:&self.databaseInfo->database_id()];
-    FSTLocalSerializer *serializer =
-        [[FSTLocalSerializer alloc] initWithRemoteSerializer:remoteSerializer];
+    LevelDbSettings levelDbSettings;
+    levelDbSettings.block_cache_size_bytes =
+        static_cast<size_t>(settings.block_cache_size_bytes());
+    levelDbSettings.bloom_filter_enabled = settings.bloom_filter_enabled();
+    levelDbSettings.write_buffer_size_bytes =
+        static_cast<size_t>(settings.write_buffer_size_bytes());
+    levelDbSettings.verify_checksums = settings.verify_checksums_enabled();
+    levelDbSettings.mobile_env = settings.mobile_leveldb_env_enabled();
+    levelDbSettings.max_file_size_bytes =
+        static_cast<size_t>(settings.max_table_file_size_bytes());
+    levelDbSettings.max_open_files = static_cast<int>(settings.max_open_files());
+    levelDbSettings.defer_migrations = settings.deferred_migrations_enabled();
+    levelDbSettings.shared_cache = settings.shared_cache_enabled();
+    if (_sharedResources) {
+      levelDbSettings.shared_block_cache = _sharedResources->block_cache();
+    }
     FSTLevelDB *ldb;
     Status levelDbStatus =
         [FSTLevelDB dbWithDirectory:std::move(dir)
                          serializer:serializer
                           lruParams:LruParams::WithCacheSize(settings.cache_size_bytes())
+                           settings:levelDbSettings
                                 ptr:&ldb];
     if (!levelDbStatus.ok()) {
       // If leveldb fails to start then just throw up our hands: the error is unrecoverable.
@@ -229,17 +342,43 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
       [NSException raise:NSInternalInconsistencyException
                   format:@"Failed to open DB: %s", levelDbStatus.ToString().c_str()];
     }
+    ldb.syncWrites = settings.sync_writes_enabled();
+    if (settings.group_commit_enabled()) {
+      [ldb enableGroupCommitOnQueue:_workerQueue.get()];
+      if (settings.background_writes_enabled()) {
+        [ldb enableBackgroundWrites];
+      }
+    }
     _lruDelegate = ldb.referenceDelegate;
     _persistence = ldb;
     [self scheduleLruGarbageCollection];
+    if (ldb.hasPendingMigrations) {
+      _deferredMigrationsDB = ldb;
+      [self schedulePendingMigrations];
+    }
+  } else if (settings.memory_lru_gc_enabled()) {
+    FSTMemoryPersistence *memory = [FSTMemoryPersistence
+        persistenceWithLruParams:LruParams::WithCacheSize(settings.cache_size_bytes())
+                      serializer:serializer];
+    _lruDelegate = (FSTMemoryLRUReferenceDelegate *)memory.referenceDelegate;
+    _persistence = memory;
+    [self scheduleLruGarbageCollection];
   } else {
     _persistence = [FSTMemoryPersistence persistenceWithEagerGC];
   }
+  Metrics().persistenceOpen->RecordElapsedSince(persistenceStartTime);
 
   _localStore = [[FSTLocalStore alloc] initWithPersistence:_persistence initialUser:user];
+  _localStore.mutationCompactionEnabled = settings.mutation_compaction_enabled();
+  _localStore.optimisticWritesEnabled = settings.optimistic_writes_enabled();
+  _memorySoftLimitBytes = static_cast<size_t>(settings.memory_soft_limit_bytes());
 
   auto datastore =
       std::make_shared<Datastore>(*self.databaseInfo, _workerQueue.get(), _credentialsProvider);
+  datastore->set_compression_enabled(settings.compression_enabled());
+  if (settings.preconnect_enabled()) {
+    datastore->Preconnect();
+  }
 
   _remoteStore = absl::make_unique<RemoteStore>(
       _localStore, std::move(datastore), _workerQueue.get(),
@@ -250,14 +389,153 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
                                               initialUser:user];
 
   _eventManager = [FSTEventManager eventManagerWithSyncEngine:_syncEngine];
+  _eventManager.sharedViewsEnabled = settings.shared_views_enabled();
+  _cacheWarmer = absl::make_unique<CacheWarmer>(_eventManager, _workerQueue.get());
 
   // Setup wiring for remote store.
   _remoteStore->set_sync_engine(_syncEngine);
+  _remoteStore->set_max_coalesced_write_bytes(
+      static_cast<size_t>(settings.max_coalesced_write_bytes()));
 
   // NOTE: RemoteStore depends on LocalStore (for persisting stream tokens, refilling mutation
   // queue, etc.) so must be started after LocalStore.
+  auto localStoreStartTime = std::chrono::steady_clock::now();
   [_localStore start];
+  auto remoteStoreStartTime = std::chrono::steady_clock::now();
   _remoteStore->Start();
+  auto endTime = std::chrono::steady_clock::now();
+
+  if (_memorySoftLimitBytes > 0) {
+    [self scheduleMemoryLimitCheck];
+  }
+
+  _memoryPressureMonitor = MemoryPressureMonitor::Create(_workerQueue.get());
+  __weak __typeof__(self) weakSelf = self;
+  _memoryPressureMonitor->AddCallback([weakSelf](MemoryPressureMonitor::Level level) {
+    [weakSelf releaseMemoryUnderPressure:level];
+  });
+
+  Metrics().localStoreStart->Record(std::chrono::duration_cast<std::chrono::milliseconds>(
+      remoteStoreStartTime - localStoreStartTime));
+  Metrics().remoteStoreStart->Record(
+      std::chrono::duration_cast<std::chrono::milliseconds>(endTime - remoteStoreStartTime));
+  Metrics().total->RecordElapsedSince(_creationTime);
+  LOG_DEBUG("Initialized in %sms, of which starting the local store took %sms",
+            std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count(),
+            std::chrono::duration_cast<std::chrono::milliseconds>(endTime - localStoreStartTime)
+                .count());
+}
+
+/**
+ * Makes the worker queue time its operations and log a warning describing the client's state
+ * after each one that runs longer than `threshold`. The state is read on the worker queue as part
+ * of the slow operation, so this costs nothing beyond the timing unless an operation is slow.
+ */
+- (void)watchForSlowOperationsWithThreshold:(std::chrono::milliseconds)threshold {
+  __weak __typeof__(self) weakSelf = self;
+  _workerQueue->SetSlowOperationHandler([weakSelf](const AsyncQueue::SlowOperation &operation) {
+    __typeof__(self) strongSelf = weakSelf;
+    if (strongSelf) {
+      [strongSelf logSlowOperation:operation];
+    }
+  });
+  _workerQueue->EnableInstrumentation(threshold);
+}
+
+- (void)logSlowOperation:(const AsyncQueue::SlowOperation &)operation {
+  // A slow operation may run before initialization made the stores.
+  size_t activeTargets = _remoteStore ? _remoteStore->active_target_count() : 0;
+  size_t pendingWrites = _remoteStore ? _remoteStore->pending_write_count() : 0;
+
+  int levelDBFiles = 0;
+  int64_t levelDBMemory = 0;
+  FSTLevelDB *levelDB = [self levelDB];
+  if (levelDB) {
+    LevelDbStatistics statistics = [levelDB statistics];
+    for (int files : statistics.files_per_level) {
+      levelDBFiles += files;
+    }
+    levelDBMemory = statistics.approximate_memory_usage;
+  }
+
+  LOG_WARN("Slow operation: label=%s run_time_ms=%s backlog=%s active_targets=%s "
+           "pending_writes=%s leveldb_files=%s leveldb_memory_bytes=%s",
+           operation.label, operation.run_time.count(), operation.backlog, activeTargets,
+           pendingWrites, levelDBFiles, levelDBMemory);
+}
+
+/**
+ * Schedules the migrations that FSTLevelDB deferred at startup to run in chunks, each in its own
+ * transaction, for at most FSTMigrationTimeBudget at a time (or less, if other work is waiting) so
+ * that other work on the worker queue can run in between. Reads that need a pending migration
+ * finish it themselves.
+ */
+- (void)schedulePendingMigrations {
+  _migrationCallback = _workerQueue->EnqueueAfterDelay(
+      std::chrono::milliseconds(0), TimerId::PendingMigrationChunk, [self]() {
+        auto start = std::chrono::steady_clock::now();
+        BOOL hasMoreWork = YES;
+        while (hasMoreWork && std::chrono::steady_clock::now() - start < FSTMigrationTimeBudget &&
+               !_workerQueue->ShouldYield()) {
+          hasMoreWork = [_deferredMigrationsDB runPendingMigrationChunk];
+        }
+
+        if (hasMoreWork) {
+          [self schedulePendingMigrations];
+        } else {
+          _deferredMigrationsDB = nil;
+        }
+      });
+}
+
+/**
+ * Schedules a check of the estimated memory use against the soft limit. Over the limit, the local
+ * store drops the documents it can recompute from persistence. Reschedules itself.
+ */
+- (void)scheduleMemoryLimitCheck {
+  _memoryLimitCallback = _workerQueue->EnqueueAfterDelay(
+      FSTMemoryLimitCheckDelay, TimerId::MemoryLimitCheck, [self]() {
+        MemoryUsage usage = [self memoryUsage];
+        if (usage.total() > _memorySoftLimitBytes) {
+          LOG_DEBUG("Estimated memory use of %s bytes exceeds the soft limit of %s bytes",
+                    usage.total(), _memorySoftLimitBytes);
+          [_localStore releaseCachedDocuments];
+        }
+        [self scheduleMemoryLimitCheck];
+      });
+}
+
+/**
+ * Releases the memory held by state that is reconstructed when it's needed again: the local views
+ * of documents with pending writes, the decoded copies of persisted mutation batches and LevelDB's
+ * block cache. The sync engine's views are kept, since they hold the state of active listeners.
+ */
+- (void)releaseMemoryUnderPressure:(MemoryPressureMonitor::Level)level {
+  static MetricsRegistry::Counter *events =
+      MetricsRegistry::Default().GetCounter("memory_pressure.events");
+  static MetricsRegistry::Counter *reclaimedBytes =
+      MetricsRegistry::Default().GetCounter("memory_pressure.reclaimed_bytes");
+
+  size_t usageBefore = [_localStore memoryUsage].total();
+  [_localStore releaseCachedDocuments];
+  size_t usageAfter = [_localStore memoryUsage].total();
+  size_t localStoreBytes = usageBefore > usageAfter ? usageBefore - usageAfter : 0;
+  size_t blockCacheBytes = [[self levelDB] releaseBlockCache];
+
+  events->Increment();
+  reclaimedBytes->Increment(static_cast<int64_t>(localStoreBytes + blockCacheBytes));
+  LOG_DEBUG("Released %s bytes from the local store and %s bytes from the block cache under %s "
+            "memory pressure",
+            localStoreBytes, blockCacheBytes,
+            level == MemoryPressureMonitor::Level::Critical ? "critical" : "warning");
+}
+
+/** Estimates the memory held by the local store and the sync engine's views. */
+- (MemoryUsage)memoryUsage {
+  MemoryUsage usage = [_localStore memoryUsage];
+  usage.view_documents_bytes = [_syncEngine approximateViewBytes];
+  usage.reference_set_bytes += [_syncEngine approximateLimboReferenceBytes];
+  return usage;
 }
 
 /**
@@ -267,12 +545,40 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
 - (void)scheduleLruGarbageCollection {
   std::chrono::milliseconds delay = _gcHasRun ? _regularGcDelay : _initialGcDelay;
   _lruCallback = _workerQueue->EnqueueAfterDelay(delay, TimerId::GarbageCollectionDelay, [self]() {
-    [self->_localStore collectGarbage:self->_lruDelegate.gc];
-    self->_gcHasRun = YES;
-    [self scheduleLruGarbageCollection];
+    [self continueLruGarbageCollection:LruResults::DidNotRun()];
   });
 }
 
+/**
+ * Runs chunks of LRU garbage collection, each in its own transaction, until the collection
+ * finishes, uses up FSTLruGcTimeBudget or other work is waiting on the worker queue. In the latter
+ * cases the rest of the collection is re-enqueued so that the other work can run in between.
+ */
+- (void)continueLruGarbageCollection:(const LruResults &)previousChunk {
+  auto start = std::chrono::steady_clock::now();
+  LruResults results = previousChunk;
+  do {
+    results = [_localStore collectGarbageChunk:_lruDelegate.gc previousChunk:results];
+  } while (results.hasMoreWork && std::chrono::steady_clock::now() - start < FSTLruGcTimeBudget &&
+           !_workerQueue->ShouldYield());
+
+  if (results.hasMoreWork) {
+    _lruCallback = _workerQueue->EnqueueAfterDelay(
+        std::chrono::milliseconds(0), TimerId::GarbageCollectionDelay,
+        [self, results]() { [self continueLruGarbageCollection:results]; });
+    return;
+  }
+
+  if (results.targetsRemoved + results.documentsRemoved >= FSTLruGcCompactionThreshold) {
+    // LevelDB only reclaims the space of deleted rows as it compacts the tables holding them, which
+    // it may not get to for a long time after a large collection.
+    [[self levelDB] compact];
+  }
+
+  _gcHasRun = YES;
+  [self scheduleLruGarbageCollection];
+}
+
 - (void)credentialDidChangeWithUser:(const User &)user {
   _workerQueue->VerifyIsCurrentQueue();
 
@@ -286,7 +592,7 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
     if (callback) {
       self->_userExecutor->Execute([=] { callback(Status::OK()); });
     }
-  });
+  }, AsyncQueue::Priority::Interactive, "disableNetwork");
 }
 
 - (void)enableNetworkWithCallback:(util::StatusCallback)callback {
@@ -295,7 +601,75 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
     if (callback) {
       self->_userExecutor->Execute([=] { callback(Status::OK()); });
     }
-  });
+  }, AsyncQueue::Priority::Interactive, "enableNetwork");
+}
+
+- (void)getNetworkMetricsWithCallback:(std::function<void(const NetworkMetrics &)>)callback {
+  _workerQueue->Enqueue([self, callback] {
+    NetworkMetrics metrics = _remoteStore->GetNetworkMetrics();
+    self->_userExecutor->Execute([=] { callback(metrics); });
+  }, AsyncQueue::Priority::Interactive, "getNetworkMetrics");
+}
+
+- (void)getTargetStatisticsForQuery:(FSTQuery *)query
+                           callback:(std::function<void(const absl::optional<TargetStatistics> &)>)
+                                        callback {
+  _workerQueue->Enqueue([self, query, callback] {
+    absl::optional<TargetStatistics> statistics = _remoteStore->GetTargetStatistics(query);
+    self->_userExecutor->Execute([=] { callback(statistics); });
+  }, AsyncQueue::Priority::Interactive, "getTargetStatistics");
+}
+
+/** The persistence layer if it's backed by LevelDB, or nil. */
+- (nullable FSTLevelDB *)levelDB {
+  return [_persistence isKindOfClass:[FSTLevelDB class]] ? (FSTLevelDB *)_persistence : nil;
+}
+
+- (void)getLevelDBStatisticsWithCallback:
+    (std::function<void(const absl::optional<LevelDbStatistics> &)>)callback {
+  _workerQueue->Enqueue([self, callback] {
+    absl::optional<LevelDbStatistics> statistics;
+    FSTLevelDB *levelDB = [self levelDB];
+    if (levelDB) {
+      statistics = [levelDB statistics];
+    }
+    self->_userExecutor->Execute([=] { callback(statistics); });
+  }, AsyncQueue::Priority::Interactive, "getLevelDBStatistics");
+}
+
+- (void)compactLocalStorageWithCallback:(util::StatusCallback)callback {
+  _workerQueue->Enqueue([self, callback] {
+    [[self levelDB] compact];
+    if (callback) {
+      self->_userExecutor->Execute([=] { callback(Status::OK()); });
+    }
+  }, AsyncQueue::Priority::Background, "compactLocalStorage");
+}
+
+- (void)loadBundleAtPath:(const Path &)path
+                callback:(StatusOrCallback<std::map<std::string, FSTQuery *>>)callback {
+  _workerQueue->Enqueue([self, path, callback] {
+    FSTBundleLoader *loader = [[FSTBundleLoader alloc] initWithLocalStore:self.localStore
+                                                               serializer:self->_localSerializer];
+    Status status = [loader loadBundleAtPath:path];
+    // Documents applied before an error are kept, so listeners see them either way.
+    [self.syncEngine applyBundledChanges:[loader changedDocuments]];
+    if (!callback) return;
+
+    if (status.ok()) {
+      std::map<std::string, FSTQuery *> namedQueries = [loader namedQueries];
+      self->_userExecutor->Execute([=] { callback(namedQueries); });
+    } else {
+      self->_userExecutor->Execute([=] { callback(status); });
+    }
+  }, AsyncQueue::Priority::Interactive, "loadBundle");
+}
+
+- (void)getMemoryUsageWithCallback:(std::function<void(const MemoryUsage &)>)callback {
+  _workerQueue->Enqueue([self, callback] {
+    MemoryUsage usage = [self memoryUsage];
+    self->_userExecutor->Execute([=] { callback(usage); });
+  }, AsyncQueue::Priority::Interactive, "getMemoryUsage");
 }
 
 - (void)shutdownWithCallback:(util::StatusCallback)callback {
@@ -306,26 +680,65 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
     if (self->_lruCallback) {
       self->_lruCallback.Cancel();
     }
+    if (self->_migrationCallback) {
+      self->_migrationCallback.Cancel();
+    }
+    if (self->_memoryLimitCallback) {
+      self->_memoryLimitCallback.Cancel();
+    }
+    self->_memoryPressureMonitor.reset();
+    self->_cacheWarmer.reset();
     _remoteStore->Shutdown();
+    [self.localStore flushLastStreamToken];
     [self.persistence shutdown];
     if (callback) {
       self->_userExecutor->Execute([=] { callback(Status::OK()); });
     }
-  });
+  }, AsyncQueue::Priority::Interactive, "shutdown");
 }
 
 - (std::shared_ptr<QueryListener>)listenToQuery:(FSTQuery *)query
                                         options:(core::ListenOptions)options
                                        listener:(ViewSnapshot::SharedListener &&)listener {
   auto query_listener = QueryListener::Create(query, std::move(options), std::move(listener));
-
-  _workerQueue->Enqueue([self, query_listener] { [self.eventManager addListener:query_listener]; });
+  query_listener->set_worker_queue(_workerQueue.get());
+
+  auto listenTime = std::chrono::steady_clock::now();
+  _workerQueue->Enqueue(
+      [self, query_listener, listenTime] {
+        if (!self->_hasListened) {
+          self->_hasListened = YES;
+          Metrics().firstListenInitializationWait->RecordElapsedSince(listenTime);
+        }
+        [self.eventManager addListener:query_listener];
+      },
+      AsyncQueue::Priority::Interactive, "listen");
 
   return query_listener;
 }
 
 - (void)removeListener:(const std::shared_ptr<QueryListener> &)listener {
-  _workerQueue->Enqueue([self, listener] { [self.eventManager removeListener:listener]; });
+  _workerQueue->Enqueue([self, listener] { [self.eventManager removeListener:listener]; },
+                        AsyncQueue::Priority::Interactive, "removeListener");
+}
+
+- (void)keepQuerySynced:(FSTQuery *)query enabled:(BOOL)enabled {
+  _workerQueue->Enqueue([self, query, enabled] {
+    if (enabled) {
+      self->_cacheWarmer->KeepSynced(query);
+    } else {
+      self->_cacheWarmer->StopKeepingSynced(query);
+    }
+  }, AsyncQueue::Priority::Background, "keepQuerySynced");
+}
+
+- (void)getCacheFreshnessForQuery:(FSTQuery *)query
+                         callback:(std::function<void(const absl::optional<CacheFreshness> &)>)
+                                      callback {
+  _workerQueue->Enqueue([self, query, callback] {
+    absl::optional<CacheFreshness> freshness = self->_cacheWarmer->GetFreshness(query);
+    self->_userExecutor->Execute([=] { callback(freshness); });
+  }, AsyncQueue::Priority::Interactive, "getCacheFreshness");
 }
 
 - (void)getDocumentFromLocalCache:(const DocumentReference &)doc
@@ -354,7 +767,67 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
     if (shared_callback) {
       self->_userExecutor->Execute([=] { shared_callback->OnEvent(std::move(maybe_snapshot)); });
     }
-  });
+  }, AsyncQueue::Priority::Interactive, "getDocumentFromLocalCache");
+}
+
+- (void)getDocuments:(std::vector<DocumentReference>)docs
+              source:(Source)source
+            callback:(StatusOrCallback<std::vector<DocumentSnapshot>>)callback {
+  _workerQueue->Enqueue([self, docs, source, callback] {
+    DocumentKeySet keySet;
+    for (const DocumentReference &doc : docs) {
+      keySet = keySet.insert(doc.key());
+    }
+    MaybeDocumentMap localDocs = [self.localStore readDocuments:keySet];
+
+    // Converts the documents read into snapshots, in the order they were asked for. Documents
+    // with pending writes are raised in their local state, as if they had come from a listener.
+    auto raise = [=](const MaybeDocumentMap &serverDocs, bool fromCache) {
+      std::vector<DocumentSnapshot> result;
+      result.reserve(docs.size());
+      for (const DocumentReference &doc : docs) {
+        FSTMaybeDocument *maybeDoc = localDocs.find(doc.key())->second;
+        bool hasPendingWrites = [maybeDoc isKindOfClass:[FSTDocument class]] &&
+                                ((FSTDocument *)maybeDoc).hasLocalMutations;
+        if (!fromCache && !hasPendingWrites) {
+          auto found = serverDocs.find(doc.key());
+          maybeDoc = found != serverDocs.end() ? found->second : nil;
+        }
+
+        FSTDocument *document =
+            [maybeDoc isKindOfClass:[FSTDocument class]] ? (FSTDocument *)maybeDoc : nil;
+        result.emplace_back(doc.firestore(), doc.key(), document, fromCache, hasPendingWrites);
+      }
+
+      if (callback) {
+        self->_userExecutor->Execute([=] { callback(std::move(result)); });
+      }
+    };
+
+    if (source == Source::Cache) {
+      raise(MaybeDocumentMap{}, /*fromCache=*/true);
+      return;
+    }
+
+    std::vector<DocumentKey> keys{keySet.begin(), keySet.end()};
+    self->_remoteStore->LookupDocuments(
+        keys, [=](const std::vector<FSTMaybeDocument *> &serverDocs, const Status &status) {
+          if (!status.ok()) {
+            if (source == Source::Default && status.code() == FirestoreErrorCode::Unavailable) {
+              raise(MaybeDocumentMap{}, /*fromCache=*/true);
+            } else if (callback) {
+              self->_userExecutor->Execute([=] { callback(status); });
+            }
+            return;
+          }
+
+          MaybeDocumentMap serverDocMap;
+          for (FSTMaybeDocument *doc : serverDocs) {
+            serverDocMap = serverDocMap.insert(doc.key, doc);
+          }
+          raise(serverDocMap, /*fromCache=*/false);
+        });
+  }, AsyncQueue::Priority::Interactive, "getDocuments");
 }
 
 - (void)getDocumentsFromLocalCache:(FIRQuery *)query
@@ -382,7 +855,28 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
     if (completion) {
       self->_userExecutor->Execute([=] { completion(result, nil); });
     }
-  });
+  }, AsyncQueue::Priority::Interactive, "getDocumentsFromLocalCache");
+}
+
+- (void)explainQuery:(FSTQuery *)query
+            callback:(std::function<void(const QueryProfile &)>)callback {
+  _workerQueue->Enqueue([self, query, callback] {
+    QueryProfile profile;
+    {
+      QueryProfile::Scope scope(&profile);
+      DocumentMap docs = [self.localStore executeQuery:query];
+
+      QueryProfile::PhaseTimer timer(QueryProfile::Phase::ViewDiff);
+      FSTView *view = [[FSTView alloc] initWithQuery:query remoteDocuments:DocumentKeySet{}];
+      FSTViewDocumentChanges *viewDocChanges =
+          [view computeChangesWithDocuments:docs.underlying_map()];
+      [view applyChangesToDocuments:viewDocChanges];
+    }
+
+    if (callback) {
+      self->_userExecutor->Execute([=] { callback(profile); });
+    }
+  }, AsyncQueue::Priority::Interactive, "explainQuery");
 }
 
 - (void)writeMutations:(std::vector<FSTMutation *> &&)mutations
@@ -403,7 +897,7 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
                 }
               }];
     }
-  });
+  }, AsyncQueue::Priority::Interactive, "writeMutations");
 };
 
 - (void)transactionWithRetries:(int)retries
@@ -421,7 +915,7 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
                                 workerQueue:_workerQueue.get()
                              updateCallback:std::move(update_callback)
                              resultCallback:std::move(async_callback)];
-  });
+  }, AsyncQueue::Priority::Interactive, "transaction");
 }
 
 - (const DatabaseInfo *)databaseInfo {
@@ -17,6 +17,7 @@
 #import <Foundation/Foundation.h>
 
 #include "Firestore/core/src/firebase/firestore/core/filter.h"
+#include "Firestore/core/src/firebase/firestore/model/field_mask.h"
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 
@@ -167,7 +168,21 @@ NS_ASSUME_NONNULL_BEGIN
                      orderBy:(NSArray<FSTSortOrder *> *)sortOrders
                        limit:(NSInteger)limit
                      startAt:(nullable FSTBound *)startAtBound
-                       endAt:(nullable FSTBound *)endAtBound NS_DESIGNATED_INITIALIZER;
+                       endAt:(nullable FSTBound *)endAtBound;
+
+/**
+ * Initializes a query with all of its components directly, including the projection that limits
+ * which fields its results contain (nullptr for whole documents).
+ */
+- (instancetype)initWithPath:(model::ResourcePath)path
+             collectionGroup:(nullable NSString *)collectionGroup
+                    filterBy:(NSArray<FSTFilter *> *)filters
+                     orderBy:(NSArray<FSTSortOrder *> *)sortOrders
+                       limit:(NSInteger)limit
+                     startAt:(nullable FSTBound *)startAtBound
+                       endAt:(nullable FSTBound *)endAtBound
+                  projection:(nullable const model::FieldMask *)projection
+    NS_DESIGNATED_INITIALIZER;
 
 /**
  * Creates and returns a new FSTQuery.
@@ -245,6 +260,16 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (instancetype)queryByAddingEndAt:(FSTBound *)bound;
 
+/**
+ * Creates a new FSTQuery whose results only contain the given fields, replacing any previous
+ * projection. Documents are still matched and ordered on their full contents, so fields used by
+ * order-by constraints are kept as well.
+ *
+ * @param fields The fields to keep. Must not be empty.
+ * @return the new FSTQuery.
+ */
+- (instancetype)queryBySelectingFields:(model::FieldMask)fields;
+
 /**
  * Helper to convert a collection group query into a collection query at a specific path. This is
  * used when executing collection group queries, since we have to split the query into a set of
@@ -261,6 +286,21 @@ NS_ASSUME_NONNULL_BEGIN
 /** Returns YES if the @a document matches the constraints of the receiver. */
 - (BOOL)matchesDocument:(FSTDocument *)document;
 
+/**
+ * Returns YES if the receiver's results are always the first results of @a other: both queries
+ * are the same apart from their limits, the receiver has a limit, and @a other has none or one at
+ * least as large.
+ */
+- (BOOL)isLimitedPrefixOfQuery:(FSTQuery *)other;
+
+/**
+ * Returns YES if the receiver's results can be computed by matching and sorting the results of
+ * @a other: @a other returns every document in the receiver's collection, with no filters, limit,
+ * bounds or projection, and orders them by key alone. The receiver must be a collection query on
+ * the same path without a projection, and may have any filters, order, limit and bounds.
+ */
+- (BOOL)isMatchedSubsetOfQuery:(FSTQuery *)other;
+
 /** Returns a comparator that will sort documents according to the receiver's sort order. */
 - (NSComparator)comparator;
 
@@ -277,6 +317,9 @@ NS_ASSUME_NONNULL_BEGIN
 /** The base path of the query. */
 - (const model::ResourcePath &)path;
 
+/** The fields that results are limited to, or nullptr if results contain whole documents. */
+- (nullable const model::FieldMask *)projection;
+
 /** The collection group of the query. */
 @property(nonatomic, nullable, strong, readonly) NSString *collectionGroup;
 
@@ -16,6 +16,7 @@
 
 #import "Firestore/Source/Core/FSTQuery.h"
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
@@ -27,6 +28,7 @@
 
 #include "Firestore/core/src/firebase/firestore/api/input_validation.h"
 #include "Firestore/core/src/firebase/firestore/core/filter.h"
+#include "Firestore/core/src/firebase/firestore/core/query_matcher.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
@@ -34,11 +36,15 @@
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/hashing.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+#include "absl/memory/memory.h"
+#include "absl/types/optional.h"
 
 namespace util = firebase::firestore::util;
 using firebase::firestore::api::ThrowInvalidArgument;
 using firebase::firestore::core::Filter;
+using firebase::firestore::core::QueryMatcher;
 using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::FieldMask;
 using firebase::firestore::model::FieldPath;
 using firebase::firestore::model::FieldValue;
 using firebase::firestore::model::ResourcePath;
@@ -533,8 +539,14 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
 @interface FSTQuery () {
   // Cached value of the canonicalID property.
   NSString *_canonicalID;
+  // Hash of the full canonicalID, computed along with it.
+  NSUInteger _hash;
   /** The base path of the query. */
   ResourcePath _path;
+  /** The compiled constraints of the query, created on first use. */
+  std::unique_ptr<QueryMatcher> _matcher;
+  /** The fields that results are limited to, if any. */
+  absl::optional<FieldMask> _projection;
 }
 
 /** A list of fields given to sort by. This does not include the implicit key sort at the end. */
@@ -545,6 +557,25 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
 
 @end
 
+/**
+ * Returns the values `sortOrders` orders `document` by, with NSNull for the key ordering and for
+ * missing fields. They're looked up on the first comparison and memoized on the document.
+ */
+static NSArray *SortValues(FSTDocument *document, NSArray<FSTSortOrder *> *sortOrders) {
+  NSArray *values = [document sortValuesForOrdering:sortOrders];
+  if (!values) {
+    NSMutableArray *extracted = [NSMutableArray arrayWithCapacity:sortOrders.count];
+    for (FSTSortOrder *orderBy in sortOrders) {
+      FSTFieldValue *value =
+          orderBy.field == FieldPath::KeyFieldPath() ? nil : [document fieldForPath:orderBy.field];
+      [extracted addObject:value ? value : [NSNull null]];
+    }
+    values = extracted;
+    [document setSortValues:values forOrdering:sortOrders];
+  }
+  return values;
+}
+
 @implementation FSTQuery
 
 #pragma mark - Constructors
@@ -571,6 +602,24 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
                        limit:(NSInteger)limit
                      startAt:(nullable FSTBound *)startAtBound
                        endAt:(nullable FSTBound *)endAtBound {
+  return [self initWithPath:std::move(path)
+            collectionGroup:collectionGroup
+                   filterBy:filters
+                    orderBy:sortOrders
+                      limit:limit
+                    startAt:startAtBound
+                      endAt:endAtBound
+                 projection:nullptr];
+}
+
+- (instancetype)initWithPath:(ResourcePath)path
+             collectionGroup:(nullable NSString *)collectionGroup
+                    filterBy:(NSArray<FSTFilter *> *)filters
+                     orderBy:(NSArray<FSTSortOrder *> *)sortOrders
+                       limit:(NSInteger)limit
+                     startAt:(nullable FSTBound *)startAtBound
+                       endAt:(nullable FSTBound *)endAtBound
+                  projection:(nullable const FieldMask *)projection {
   if (self = [super init]) {
     _path = std::move(path);
     _collectionGroup = collectionGroup;
@@ -579,6 +628,9 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
     _limit = limit;
     _startAt = startAtBound;
     _endAt = endAtBound;
+    if (projection) {
+      _projection = *projection;
+    }
   }
   return self;
 }
@@ -600,7 +652,9 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
 }
 
 - (NSUInteger)hash {
-  return [self.canonicalID hash];
+  // Make sure the hash has been computed along with the canonicalID.
+  (void)self.canonicalID;
+  return _hash;
 }
 
 - (instancetype)copyWithZone:(nullable NSZone *)zone {
@@ -675,7 +729,8 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
                                 orderBy:self.explicitSortOrders
                                   limit:self.limit
                                 startAt:self.startAt
-                                  endAt:self.endAt];
+                                  endAt:self.endAt
+                             projection:self.projection];
 }
 
 - (instancetype)queryByAddingSortOrder:(FSTSortOrder *)sortOrder {
@@ -688,7 +743,8 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
                                 orderBy:[self.explicitSortOrders arrayByAddingObject:sortOrder]
                                   limit:self.limit
                                 startAt:self.startAt
-                                  endAt:self.endAt];
+                                  endAt:self.endAt
+                             projection:self.projection];
 }
 
 - (instancetype)queryBySettingLimit:(NSInteger)limit {
@@ -698,7 +754,8 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
                                 orderBy:self.explicitSortOrders
                                   limit:limit
                                 startAt:self.startAt
-                                  endAt:self.endAt];
+                                  endAt:self.endAt
+                             projection:self.projection];
 }
 
 - (instancetype)queryByAddingStartAt:(FSTBound *)bound {
@@ -708,7 +765,8 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
                                 orderBy:self.explicitSortOrders
                                   limit:self.limit
                                 startAt:bound
-                                  endAt:self.endAt];
+                                  endAt:self.endAt
+                             projection:self.projection];
 }
 
 - (instancetype)queryByAddingEndAt:(FSTBound *)bound {
@@ -718,7 +776,20 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
                                 orderBy:self.explicitSortOrders
                                   limit:self.limit
                                 startAt:self.startAt
-                                  endAt:bound];
+                                  endAt:bound
+                             projection:self.projection];
+}
+
+- (instancetype)queryBySelectingFields:(FieldMask)fields {
+  HARD_ASSERT(fields.size() > 0, "A projection must select at least one field.");
+  return [[FSTQuery alloc] initWithPath:self.path
+                        collectionGroup:self.collectionGroup
+                               filterBy:self.filters
+                                orderBy:self.explicitSortOrders
+                                  limit:self.limit
+                                startAt:self.startAt
+                                  endAt:self.endAt
+                             projection:&fields];
 }
 
 - (instancetype)collectionQueryAtPath:(firebase::firestore::model::ResourcePath)path {
@@ -728,7 +799,8 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
                                 orderBy:self.explicitSortOrders
                                   limit:self.limit
                                 startAt:self.startAt
-                                  endAt:self.endAt];
+                                  endAt:self.endAt
+                             projection:self.projection];
 }
 
 - (BOOL)isDocumentQuery {
@@ -740,20 +812,79 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
 }
 
 - (BOOL)matchesDocument:(FSTDocument *)document {
-  return [self pathAndCollectionGroupMatchDocument:document] &&
-         [self orderByMatchesDocument:document] && [self filtersMatchDocument:document] &&
-         [self boundsMatchDocument:document];
+  // Queries are usually matched against many documents, so compiling them is worth it.
+  if (!_matcher) {
+    _matcher = absl::make_unique<QueryMatcher>(self);
+  }
+  return _matcher->Matches(document);
+}
+
+- (BOOL)isLimitedPrefixOfQuery:(FSTQuery *)other {
+  if (self.limit == NSNotFound || (other.limit != NSNotFound && other.limit < self.limit)) {
+    return NO;
+  }
+  return self.path == other.path &&
+         (self.collectionGroup == other.collectionGroup ||
+          [self.collectionGroup isEqual:other.collectionGroup]) &&
+         [self.filters isEqual:other.filters] && [self.sortOrders isEqual:other.sortOrders] &&
+         (self.startAt == other.startAt || [self.startAt isEqual:other.startAt]) &&
+         (self.endAt == other.endAt || [self.endAt isEqual:other.endAt]) &&
+         _projection == other->_projection;
+}
+
+- (BOOL)isMatchedSubsetOfQuery:(FSTQuery *)other {
+  if ([self isDocumentQuery] || self.collectionGroup || _projection) {
+    return NO;
+  }
+  // The key ordering is always the last one, so a single sort order means there's no other.
+  return self.path == other.path && ![other isDocumentQuery] && !other.collectionGroup &&
+         other.filters.count == 0 && other.sortOrders.count == 1 && other.limit == NSNotFound &&
+         !other.startAt && !other.endAt && !other->_projection;
 }
 
 - (NSComparator)comparator {
+  // Look the sort orders up once rather than on every comparison, since the comparator runs for
+  // every step of every DocumentSet insert, erase and lookup.
+  NSArray<FSTSortOrder *> *sortOrders = self.sortOrders;
+  if (sortOrders.count == 1) {
+    // Only the key ordering, which doesn't look any fields up.
+    return ^NSComparisonResult(id document1, id document2) {
+      if (document1 == document2) {
+        return NSOrderedSame;
+      }
+      HARD_ASSERT(sortOrders[0].field == FieldPath::KeyFieldPath(),
+                  "sortOrder of query did not include key ordering");
+      return [sortOrders[0] compareDocument:document1 toDocument:document2];
+    };
+  }
+
   return ^NSComparisonResult(id document1, id document2) {
+    if (document1 == document2) {
+      return NSOrderedSame;
+    }
+    NSArray *values1 = SortValues(document1, sortOrders);
+    NSArray *values2 = SortValues(document2, sortOrders);
     BOOL didCompareOnKeyField = NO;
-    for (FSTSortOrder *orderBy in self.sortOrders) {
-      NSComparisonResult comp = [orderBy compareDocument:document1 toDocument:document2];
+    NSUInteger i = 0;
+    for (FSTSortOrder *orderBy in sortOrders) {
+      NSComparisonResult comp;
+      if (orderBy.field == FieldPath::KeyFieldPath()) {
+        comp = CompareKeys(((FSTDocument *)document1).key, ((FSTDocument *)document2).key);
+        didCompareOnKeyField = YES;
+      } else {
+        id value1 = values1[i];
+        id value2 = values2[i];
+        HARD_ASSERT(value1 != [NSNull null] && value2 != [NSNull null],
+                    "Trying to compare documents on fields that don't exist.");
+        comp = [(FSTFieldValue *)value1 compare:value2];
+      }
+      if (!orderBy.isAscending) {
+        comp = ReverseOrder(comp);
+      }
       if (comp != NSOrderedSame) {
         return comp;
       }
-      didCompareOnKeyField = didCompareOnKeyField || orderBy.field == FieldPath::KeyFieldPath();
+      ++i;
     }
     HARD_ASSERT(didCompareOnKeyField, "sortOrder of query did not include key ordering");
     return NSOrderedSame;
@@ -792,6 +923,10 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
   return _path;
 }
 
+- (nullable const FieldMask *)projection {
+  return _projection ? &*_projection : nullptr;
+}
+
 #pragma mark - Private properties
 
 - (NSString *)canonicalID {
@@ -831,71 +966,37 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
     [canonicalID appendFormat:@"|ub:%@", self.endAt.canonicalString];
   }
 
-  _canonicalID = canonicalID;
-  return canonicalID;
+  if (_projection) {
+    [canonicalID appendString:@"|p:"];
+    for (const FieldPath &field : *_projection) {
+      [canonicalID appendFormat:@"%s,", field.CanonicalString().c_str()];
+    }
+  }
+
+  // -[NSString hash] only looks at a few characters at the start, middle and end of long strings,
+  // which makes queries that differ only in a filter or bound collide. Hash the whole ID once so
+  // that lookups in query-keyed maps don't have to fall back to comparing queries.
+  _hash = std::hash<std::string>{}(util::MakeString(canonicalID));
+  _canonicalID = [canonicalID copy];
+  return _canonicalID;
 }
 
 #pragma mark - Private methods
 
 - (BOOL)isEqualToQuery:(FSTQuery *)other {
+  // Equal queries have equal canonicalIDs, so a hash mismatch rules out equality without
+  // comparing filters and bounds.
+  if (self.hash != other.hash) {
+    return NO;
+  }
   return self.path == other.path &&
          (self.collectionGroup == other.collectionGroup ||
           [self.collectionGroup isEqual:other.collectionGroup]) &&
          self.limit == other.limit && [self.filters isEqual:other.filters] &&
          [self.sortOrders isEqual:other.sortOrders] &&
          (self.startAt == other.startAt || [self.startAt isEqual:other.startAt]) &&
-         (self.endAt == other.endAt || [self.endAt isEqual:other.endAt]);
-}
-
-/* Returns YES if the document matches the path and collection group for the receiver. */
-- (BOOL)pathAndCollectionGroupMatchDocument:(FSTDocument *)document {
-  const ResourcePath &documentPath = document.key.path();
-  if (self.collectionGroup) {
-    // NOTE: self.path is currently always empty since we don't expose Collection Group queries
-    // rooted at a document path yet.
-    return document.key.HasCollectionId(util::MakeString(self.collectionGroup)) &&
-           self.path.IsPrefixOf(documentPath);
-  } else if (DocumentKey::IsDocumentKey(_path)) {
-    // Exact match for document queries.
-    return self.path == documentPath;
-  } else {
-    // Shallow ancestor queries by default.
-    return self.path.IsPrefixOf(documentPath) && _path.size() == documentPath.size() - 1;
-  }
-}
-
-/**
- * A document must have a value for every ordering clause in order to show up in the results.
- */
-- (BOOL)orderByMatchesDocument:(FSTDocument *)document {
-  for (FSTSortOrder *orderBy in self.explicitSortOrders) {
-    const FieldPath &fieldPath = orderBy.field;
-    // order by key always matches
-    if (fieldPath != FieldPath::KeyFieldPath() && [document fieldForPath:fieldPath] == nil) {
-      return NO;
-    }
-  }
-  return YES;
-}
-
-/** Returns YES if the document matches all of the filters in the receiver. */
-- (BOOL)filtersMatchDocument:(FSTDocument *)document {
-  for (FSTFilter *filter in self.filters) {
-    if (![filter matchesDocument:document]) {
-      return NO;
-    }
-  }
-  return YES;
-}
-
-- (BOOL)boundsMatchDocument:(FSTDocument *)document {
-  if (self.startAt && ![self.startAt sortsBeforeDocument:document usingSortOrder:self.sortOrders]) {
-    return NO;
-  }
-  if (self.endAt && [self.endAt sortsBeforeDocument:document usingSortOrder:self.sortOrders]) {
-    return NO;
-  }
-  return YES;
+         (self.endAt == other.endAt || [self.endAt isEqual:other.endAt]) &&
+         _projection == other->_projection;
 }
 
 @end
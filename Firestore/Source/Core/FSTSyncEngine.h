@@ -22,6 +22,7 @@
 
 #include "Firestore/core/src/firebase/firestore/auth/user.h"
 #include "Firestore/core/src/firebase/firestore/core/transaction.h"
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_store.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
@@ -70,7 +71,18 @@ NS_ASSUME_NONNULL_BEGIN
 - (instancetype)init NS_UNAVAILABLE;
 - (instancetype)initWithLocalStore:(FSTLocalStore *)localStore
                        remoteStore:(remote::RemoteStore *)remoteStore
-                       initialUser:(const auth::User &)user NS_DESIGNATED_INITIALIZER;
+                       initialUser:(const auth::User &)user;
+
+/**
+ * Creates a sync engine that listens to at most `maxConcurrentLimboResolutions` limbo documents at
+ * a time. Documents that go into limbo while all the slots are taken wait in a queue, in the order
+ * they went into limbo.
+ */
+- (instancetype)initWithLocalStore:(FSTLocalStore *)localStore
+                       remoteStore:(remote::RemoteStore *)remoteStore
+                       initialUser:(const auth::User &)user
+     maxConcurrentLimboResolutions:(size_t)maxConcurrentLimboResolutions
+    NS_DESIGNATED_INITIALIZER;
 
 /**
  * A delegate to be notified when queries being listened to produce new view snapshots or errors.
@@ -113,9 +125,24 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (void)credentialDidChangeWithUser:(const auth::User &)user;
 
+/**
+ * Raises events for the documents that loading a bundle changed in the local store, as returned by
+ * `-[FSTLocalStore applyBundledDocuments:]`.
+ */
+- (void)applyBundledChanges:(const model::MaybeDocumentMap &)changes;
+
 /** Applies an OnlineState change to the sync engine and notifies any views of the change. */
 - (void)applyChangedOnlineState:(model::OnlineState)onlineState;
 
+/**
+ * Approximately how many bytes the documents held by active views occupy. Views need their
+ * documents to compute changes, so this memory is only reported, never released.
+ */
+- (size_t)approximateViewBytes;
+
+/** Approximately how many bytes the limbo document references occupy. */
+- (size_t)approximateLimboReferenceBytes;
+
 @end
 
 NS_ASSUME_NONNULL_END
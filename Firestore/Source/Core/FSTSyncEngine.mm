@@ -16,9 +16,11 @@
 
 #import "Firestore/Source/Core/FSTSyncEngine.h"
 
+#include <deque>
 #include <map>
 #include <memory>
 #include <set>
+#include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -35,6 +37,7 @@
 
 #include "Firestore/core/include/firebase/firestore/firestore_errors.h"
 #include "Firestore/core/src/firebase/firestore/auth/user.h"
+#include "Firestore/core/src/firebase/firestore/core/query_router.h"
 #include "Firestore/core/src/firebase/firestore/core/target_id_generator.h"
 #include "Firestore/core/src/firebase/firestore/core/transaction.h"
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
@@ -42,17 +45,23 @@
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/remote/exponential_backoff.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
 #include "Firestore/core/src/firebase/firestore/util/error_apple.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/metrics_registry.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+#include "Firestore/core/src/firebase/firestore/util/tracing.h"
 #include "absl/types/optional.h"
 
 using firebase::firestore::FirestoreErrorCode;
 using firebase::firestore::auth::HashUser;
 using firebase::firestore::auth::User;
+using firebase::firestore::core::QueryRouter;
 using firebase::firestore::core::TargetIdGenerator;
 using firebase::firestore::core::Transaction;
 using firebase::firestore::core::ViewSnapshot;
@@ -64,14 +73,18 @@ using firebase::firestore::model::DocumentMap;
 using firebase::firestore::model::MaybeDocumentMap;
 using firebase::firestore::model::ListenSequenceNumber;
 using firebase::firestore::model::OnlineState;
+using firebase::firestore::model::ResourcePath;
 using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::model::TargetId;
+using firebase::firestore::remote::ExponentialBackoff;
 using firebase::firestore::remote::RemoteEvent;
 using firebase::firestore::remote::RemoteStore;
 using firebase::firestore::remote::TargetChange;
 using firebase::firestore::util::AsyncQueue;
 using firebase::firestore::util::MakeNSError;
+using firebase::firestore::util::MetricsRegistry;
 using firebase::firestore::util::Status;
+using firebase::firestore::util::TimerId;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -79,6 +92,97 @@ NS_ASSUME_NONNULL_BEGIN
 // real sequence numbers.
 static const ListenSequenceNumber kIrrelevantSequenceNumber = -1;
 
+// Bounds the number of watch targets opened for limbo documents, e.g. when a large query comes
+// back online and finds many of its documents gone.
+static const size_t kDefaultMaxConcurrentLimboResolutions = 100;
+
+// Transactions that fail to commit are retried with backoff, so that clients contending for the
+// same documents spread their attempts out instead of aborting each other again right away.
+static const double kTransactionBackoffFactor = 1.5;
+static const AsyncQueue::Milliseconds kTransactionBackoffInitialDelay{100};
+static const AsyncQueue::Milliseconds kTransactionBackoffMaxDelay{5000};
+
+namespace {
+
+/** The metrics that every `FSTSyncEngine` in the process records into. */
+struct SyncEngineMetrics {
+  MetricsRegistry::Counter *listens = MetricsRegistry::Default().GetCounter("sync_engine.listens");
+  MetricsRegistry::Counter *writes = MetricsRegistry::Default().GetCounter("sync_engine.writes");
+  /** Limit queries re-run against the local store because documents left their results. */
+  MetricsRegistry::Counter *refills = MetricsRegistry::Default().GetCounter("sync_engine.refills");
+  /** Views left alone because none of the changes could affect them. */
+  MetricsRegistry::Counter *viewsVisited =
+      MetricsRegistry::Default().GetCounter("sync_engine.views_visited");
+  MetricsRegistry::Counter *viewsSkipped =
+      MetricsRegistry::Default().GetCounter("sync_engine.views_skipped");
+  MetricsRegistry::Counter *limboResolutions =
+      MetricsRegistry::Default().GetCounter("sync_engine.limbo_resolutions");
+  MetricsRegistry::Counter *transactionAttempts =
+      MetricsRegistry::Default().GetCounter("sync_engine.transaction_attempts");
+  MetricsRegistry::Counter *transactionsFailed =
+      MetricsRegistry::Default().GetCounter("sync_engine.transactions_failed");
+};
+
+SyncEngineMetrics &Metrics() {
+  static SyncEngineMetrics metrics;
+  return metrics;
+}
+
+/** Returns the collection group of `query`, or an empty string if it isn't a group query. */
+std::string CollectionGroupOfQuery(FSTQuery *query) {
+  return query.collectionGroup ? firebase::firestore::util::MakeString(query.collectionGroup)
+                               : std::string{};
+}
+
+/**
+ * Splits the document changes to apply to the views by the collection the documents are in, so
+ * that each view only looks at the changes to documents its query could match. Every document a
+ * view holds is in a collection its query matches, so a view never misses the change that removes
+ * one of its documents.
+ */
+class DocumentChangeRouter {
+ public:
+  explicit DocumentChangeRouter(const MaybeDocumentMap &changes) : changes_(changes) {
+    std::map<ResourcePath, MaybeDocumentMap::Builder> builders;
+    for (const auto &kv : changes) {
+      builders[kv.first.path().PopLast()].push_back(kv.first, kv.second);
+    }
+    for (auto &kv : builders) {
+      changes_by_collection_.emplace(kv.first, kv.second.Build());
+    }
+  }
+
+  /** Returns the changes to documents at the paths that `query` could match. */
+  MaybeDocumentMap ChangesForQuery(FSTQuery *query) const {
+    const ResourcePath &path = query.path;
+    if (query.collectionGroup) {
+      std::string collectionGroup = firebase::firestore::util::MakeString(query.collectionGroup);
+      MaybeDocumentMap::Builder result;
+      for (const auto &kv : changes_) {
+        if (kv.first.HasCollectionId(collectionGroup) && path.IsPrefixOf(kv.first.path())) {
+          result.push_back(kv.first, kv.second);
+        }
+      }
+      return result.Build();
+    }
+
+    if (DocumentKey::IsDocumentKey(path)) {
+      DocumentKey key{path};
+      auto found = changes_.find(key);
+      return found != changes_.end() ? MaybeDocumentMap{{key, found->second}} : MaybeDocumentMap{};
+    }
+
+    auto found = changes_by_collection_.find(path);
+    return found != changes_by_collection_.end() ? found->second : MaybeDocumentMap{};
+  }
+
+ private:
+  const MaybeDocumentMap &changes_;
+  std::map<ResourcePath, MaybeDocumentMap> changes_by_collection_;
+};
+
+}  // namespace
+
 #pragma mark - FSTQueryView
 
 /**
@@ -181,6 +285,9 @@ class LimboResolution {
   /** FSTQueryViews for all active queries, indexed by target ID. */
   std::unordered_map<TargetId, FSTQueryView *> _queryViewsByTarget;
 
+  /** The targets of all active queries, indexed by the documents their queries could match. */
+  QueryRouter _queryRouter;
+
   /**
    * When a document is in limbo, we create a special listen to resolve it. This maps the
    * DocumentKey of each limbo document to the TargetId of the listen resolving it.
@@ -193,6 +300,17 @@ class LimboResolution {
    */
   std::map<TargetId, LimboResolution> _limboResolutionsByTarget;
 
+  /**
+   * The keys of the limbo documents that are waiting for a limbo resolution to free up, in the
+   * order they went into limbo. A key may be in the queue more than once (or after it left limbo);
+   * only the keys in `_enqueuedLimboKeys` are still waiting.
+   */
+  std::deque<DocumentKey> _enqueuedLimboResolutions;
+  std::set<DocumentKey> _enqueuedLimboKeys;
+
+  /** The maximum number of limbo documents being resolved at a time. */
+  size_t _maxConcurrentLimboResolutions;
+
   User _currentUser;
 
   /** Used to track any documents that are currently in limbo. */
@@ -202,9 +320,22 @@ class LimboResolution {
 - (instancetype)initWithLocalStore:(FSTLocalStore *)localStore
                        remoteStore:(RemoteStore *)remoteStore
                        initialUser:(const User &)initialUser {
+  return [self initWithLocalStore:localStore
+                        remoteStore:remoteStore
+                        initialUser:initialUser
+      maxConcurrentLimboResolutions:kDefaultMaxConcurrentLimboResolutions];
+}
+
+- (instancetype)initWithLocalStore:(FSTLocalStore *)localStore
+                       remoteStore:(RemoteStore *)remoteStore
+                       initialUser:(const User &)initialUser
+     maxConcurrentLimboResolutions:(size_t)maxConcurrentLimboResolutions {
+  HARD_ASSERT(maxConcurrentLimboResolutions > 0,
+              "At least one limbo document must be resolved at a time");
   if (self = [super init]) {
     _localStore = localStore;
     _remoteStore = remoteStore;
+    _maxConcurrentLimboResolutions = maxConcurrentLimboResolutions;
 
     _queryViewsByQuery = [NSMutableDictionary dictionary];
 
@@ -217,6 +348,7 @@ class LimboResolution {
 - (TargetId)listenToQuery:(FSTQuery *)query {
   [self assertDelegateExistsForSelector:_cmd];
   HARD_ASSERT(self.queryViewsByQuery[query] == nil, "We already listen to query: %s", query);
+  Metrics().listens->Increment();
 
   FSTQueryData *queryData = [self.localStore allocateQuery:query];
   ViewSnapshot viewSnapshot = [self initializeViewAndComputeSnapshotForQueryData:queryData];
@@ -227,7 +359,8 @@ class LimboResolution {
 }
 
 - (ViewSnapshot)initializeViewAndComputeSnapshotForQueryData:(FSTQueryData *)queryData {
-  DocumentMap docs = [self.localStore executeQuery:queryData.query];
+  TRACE_SPAN("sync", "-[FSTSyncEngine initializeViewAndComputeSnapshotForQueryData:]");
+  DocumentMap docs = [self.localStore executeQueryForTarget:queryData];
   DocumentKeySet remoteKeys = [self.localStore remoteDocumentKeysForTarget:queryData.targetID];
 
   FSTView *view = [[FSTView alloc] initWithQuery:queryData.query
@@ -243,6 +376,8 @@ class LimboResolution {
                                                            view:view];
   self.queryViewsByQuery[queryData.query] = queryView;
   _queryViewsByTarget[queryData.targetID] = queryView;
+  _queryRouter.AddQuery(queryData.targetID, queryData.query.path,
+                        CollectionGroupOfQuery(queryData.query));
 
   HARD_ASSERT(viewChange.snapshot.has_value(),
               "applyChangesToDocuments for new view should always return a snapshot");
@@ -263,11 +398,19 @@ class LimboResolution {
 - (void)writeMutations:(std::vector<FSTMutation *> &&)mutations
             completion:(FSTVoidErrorBlock)completion {
   [self assertDelegateExistsForSelector:_cmd];
+  Metrics().writes->Increment();
 
   FSTLocalWriteResult *result = [self.localStore locallyWriteMutations:std::move(mutations)];
-  [self addMutationCompletionBlock:completion batchID:result.batchID];
-
-  [self emitNewSnapshotsAndNotifyLocalStoreWithChanges:result.changes remoteEvent:absl::nullopt];
+  // With optimistic writes, the write reaches durable storage only once its snapshots have been
+  // raised. `commitLocalWrites` writes it synchronously, even with group commit, so it's durable
+  // before it enters the write pipeline. It's committed even if raising the snapshots throws, so
+  // that it isn't left to be written with whichever transaction happens to commit next.
+  @try {
+    [self addMutationCompletionBlock:completion batchID:result.batchID];
+    [self emitNewSnapshotsAndNotifyLocalStoreWithChanges:result.changes remoteEvent:absl::nullopt];
+  } @finally {
+    [self.localStore commitLocalWrites];
+  }
   _remoteStore->FillWritePipeline();
 }
 
@@ -278,6 +421,17 @@ class LimboResolution {
     completionBlocks = [NSMutableDictionary dictionary];
     _mutationCompletionBlocks[_currentUser] = completionBlocks;
   }
+
+  // With mutation compaction, several writes can end up in the same batch. Each of them is
+  // completed when the batch is.
+  FSTVoidErrorBlock existing = completionBlocks[@(batchID)];
+  if (existing) {
+    FSTVoidErrorBlock added = completion;
+    completion = ^(NSError *_Nullable error) {
+      existing(error);
+      added(error);
+    };
+  }
   [completionBlocks setObject:completion forKey:@(batchID)];
 }
 
@@ -300,37 +454,64 @@ class LimboResolution {
   workerQueue->VerifyIsCurrentQueue();
   HARD_ASSERT(retries >= 0, "Got negative number of retries for transaction");
 
+  auto backoff = std::make_shared<ExponentialBackoff>(
+      workerQueue, TimerId::TransactionRetry, kTransactionBackoffFactor,
+      kTransactionBackoffInitialDelay, kTransactionBackoffMaxDelay);
+  [self transactionWithRetries:retries
+                       backoff:std::move(backoff)
+                   workerQueue:workerQueue
+                updateCallback:std::move(updateCallback)
+                resultCallback:std::move(resultCallback)];
+}
+
+- (void)transactionWithRetries:(int)retries
+                       backoff:(std::shared_ptr<ExponentialBackoff>)backoff
+                   workerQueue:(AsyncQueue *)workerQueue
+                updateCallback:(core::TransactionUpdateCallback)updateCallback
+                resultCallback:(core::TransactionResultCallback)resultCallback {
+  Metrics().transactionAttempts->Increment();
   std::shared_ptr<Transaction> transaction = _remoteStore->CreateTransaction();
   updateCallback(transaction, [=](util::StatusOr<absl::any> maybe_result) {
-    workerQueue->Enqueue(
-        [self, retries, workerQueue, updateCallback, resultCallback, transaction, maybe_result] {
-          if (!maybe_result.ok()) {
-            resultCallback(std::move(maybe_result));
-            return;
-          }
-
-          transaction->Commit([self, retries, workerQueue, updateCallback, resultCallback,
-                               maybe_result](Status status) {
-            if (status.ok()) {
-              resultCallback(std::move(maybe_result));
-              return;
-            }
-
-            // TODO(b/35201829): Only retry on real transaction failures.
-            if (retries == 0) {
-              Status wrappedError =
-                  Status(FirestoreErrorCode::FailedPrecondition, "Transaction failed all retries.")
-                      .CausedBy(std::move(status));
-              resultCallback(std::move(wrappedError));
-              return;
-            }
-            workerQueue->VerifyIsCurrentQueue();
-            return [self transactionWithRetries:(retries - 1)
-                                    workerQueue:workerQueue
-                                 updateCallback:updateCallback
-                                 resultCallback:resultCallback];
-          });
+    workerQueue->Enqueue([self, retries, backoff, workerQueue, updateCallback, resultCallback,
+                          transaction, maybe_result] {
+      if (!maybe_result.ok()) {
+        resultCallback(std::move(maybe_result));
+        return;
+      }
+
+      transaction->Commit([self, retries, backoff, workerQueue, updateCallback, resultCallback,
+                           maybe_result](Status status) {
+        if (status.ok()) {
+          resultCallback(std::move(maybe_result));
+          return;
+        }
+
+        // TODO(b/35201829): Only retry on real transaction failures.
+        if (retries == 0) {
+          Metrics().transactionsFailed->Increment();
+          Status wrappedError =
+              Status(FirestoreErrorCode::FailedPrecondition, "Transaction failed all retries.")
+                  .CausedBy(std::move(status));
+          resultCallback(std::move(wrappedError));
+          return;
+        }
+        workerQueue->VerifyIsCurrentQueue();
+
+        // The first retry happens right away; each one after that waits longer, with jitter, so
+        // that contending clients don't keep aborting each other.
+        if (status.code() == FirestoreErrorCode::ResourceExhausted) {
+          backoff->ResetToMax();
+        }
+        backoff->BackoffAndRun([self, retries, backoff, workerQueue, updateCallback,
+                                resultCallback] {
+          [self transactionWithRetries:(retries - 1)
+                               backoff:backoff
+                           workerQueue:workerQueue
+                        updateCallback:updateCallback
+                        resultCallback:resultCallback];
         });
+      });
+    });
   });
 }
 
@@ -409,6 +590,8 @@ class LimboResolution {
     RemoteEvent event{SnapshotVersion::None(), /*target_changes=*/{}, /*target_mismatches=*/{},
                       /*document_updates=*/{{limboKey, doc}}, std::move(limboDocuments)};
     [self applyRemoteEvent:event];
+
+    [self pumpEnqueuedLimboResolutions];
   } else {
     auto found = _queryViewsByTarget.find(targetID);
     HARD_ASSERT(found != _queryViewsByTarget.end(), "Unknown targetId: %s", targetID);
@@ -453,6 +636,11 @@ class LimboResolution {
   [self emitNewSnapshotsAndNotifyLocalStoreWithChanges:changes remoteEvent:absl::nullopt];
 }
 
+- (void)applyBundledChanges:(const MaybeDocumentMap &)changes {
+  [self assertDelegateExistsForSelector:_cmd];
+  [self emitNewSnapshotsAndNotifyLocalStoreWithChanges:changes remoteEvent:absl::nullopt];
+}
+
 - (void)processUserCallbacksForBatchID:(BatchId)batchID error:(NSError *_Nullable)error {
   NSMutableDictionary<NSNumber *, FSTVoidErrorBlock> *completionBlocks =
       _mutationCompletionBlocks[_currentUser];
@@ -477,6 +665,8 @@ class LimboResolution {
 - (void)removeAndCleanupQuery:(FSTQueryView *)queryView {
   [self.queryViewsByQuery removeObjectForKey:queryView.query];
   _queryViewsByTarget.erase(queryView.targetID);
+  _queryRouter.RemoveQuery(queryView.targetID, queryView.query.path,
+                           CollectionGroupOfQuery(queryView.query));
 
   DocumentKeySet limboKeys = _limboDocumentRefs.ReferencedKeys(queryView.targetID);
   _limboDocumentRefs.RemoveReferences(queryView.targetID);
@@ -494,44 +684,76 @@ class LimboResolution {
 - (void)emitNewSnapshotsAndNotifyLocalStoreWithChanges:(const MaybeDocumentMap &)changes
                                            remoteEvent:(const absl::optional<RemoteEvent> &)
                                                            maybeRemoteEvent {
-  __block std::vector<ViewSnapshot> newSnapshots;
+  TRACE_SPAN("sync",
+             "-[FSTSyncEngine emitNewSnapshotsAndNotifyLocalStoreWithChanges:remoteEvent:]");
+  std::vector<ViewSnapshot> newSnapshots;
   NSMutableArray<FSTLocalViewChanges *> *documentChangesInAllViews = [NSMutableArray array];
+  DocumentChangeRouter router{changes};
+
+  // Only the views that the event could affect are visited: those whose queries could match one of
+  // the changed documents, and those whose targets changed. The rest would come out exactly as
+  // they are, and with many active listeners they are most of them.
+  std::set<TargetId> affectedTargets;
+  for (const auto &kv : changes) {
+    _queryRouter.AddTargetsAffectedBy(kv.first, &affectedTargets);
+  }
+  if (maybeRemoteEvent.has_value()) {
+    for (const auto &kv : maybeRemoteEvent->target_changes()) {
+      // Limbo resolutions have targets but no views.
+      if (_queryViewsByTarget.find(kv.first) != _queryViewsByTarget.end()) {
+        affectedTargets.insert(kv.first);
+      }
+    }
+  }
+  Metrics().viewsVisited->Increment(static_cast<int64_t>(affectedTargets.size()));
+  Metrics().viewsSkipped->Increment(
+      static_cast<int64_t>(_queryViewsByTarget.size() - affectedTargets.size()));
+
+  for (TargetId targetID : affectedTargets) {
+    FSTQueryView *queryView = _queryViewsByTarget.at(targetID);
+    absl::optional<TargetChange> targetChange;
+    if (maybeRemoteEvent.has_value()) {
+      const RemoteEvent &remoteEvent = maybeRemoteEvent.value();
+      auto it = remoteEvent.target_changes().find(queryView.targetID);
+      if (it != remoteEvent.target_changes().end()) {
+        targetChange = it->second;
+      }
+    }
 
-  [self.queryViewsByQuery
-      enumerateKeysAndObjectsUsingBlock:^(FSTQuery *query, FSTQueryView *queryView, BOOL *stop) {
-        FSTView *view = queryView.view;
-        FSTViewDocumentChanges *viewDocChanges = [view computeChangesWithDocuments:changes];
-        if (viewDocChanges.needsRefill) {
-          // The query has a limit and some docs were removed/updated, so we need to re-run the
-          // query against the local store to make sure we didn't lose any good docs that had been
-          // past the limit.
-          DocumentMap docs = [self.localStore executeQuery:queryView.query];
-          viewDocChanges = [view computeChangesWithDocuments:docs.underlying_map()
-                                             previousChanges:viewDocChanges];
-        }
+    // A view that none of the documents could belong to and whose target didn't change would
+    // come out exactly as it is.
+    MaybeDocumentMap viewChanges = router.ChangesForQuery(queryView.query);
+    if (viewChanges.empty() && !targetChange) {
+      Metrics().viewsSkipped->Increment();
+      continue;
+    }
 
-        absl::optional<TargetChange> targetChange;
-        if (maybeRemoteEvent.has_value()) {
-          const RemoteEvent &remoteEvent = maybeRemoteEvent.value();
-          auto it = remoteEvent.target_changes().find(queryView.targetID);
-          if (it != remoteEvent.target_changes().end()) {
-            targetChange = it->second;
-          }
-        }
-        FSTViewChange *viewChange = [queryView.view applyChangesToDocuments:viewDocChanges
-                                                               targetChange:targetChange];
+    FSTView *view = queryView.view;
+    FSTViewDocumentChanges *viewDocChanges = [view computeChangesWithDocuments:viewChanges];
+    if (viewDocChanges.needsRefill) {
+      // The query has a limit and some docs were removed/updated, so we need to re-run the
+      // query against the local store to make sure we didn't lose any good docs that had been
+      // past the limit.
+      Metrics().refills->Increment();
+      DocumentMap docs = [self.localStore executeQuery:queryView.query];
+      viewDocChanges = [view computeChangesWithDocuments:docs.underlying_map()
+                                         previousChanges:viewDocChanges];
+    }
 
-        [self updateTrackedLimboDocumentsWithChanges:viewChange.limboChanges
-                                            targetID:queryView.targetID];
+    FSTViewChange *viewChange = [queryView.view applyChangesToDocuments:viewDocChanges
+                                                           targetChange:targetChange];
 
-        if (viewChange.snapshot.has_value()) {
-          newSnapshots.push_back(viewChange.snapshot.value());
-          FSTLocalViewChanges *docChanges =
-              [FSTLocalViewChanges changesForViewSnapshot:viewChange.snapshot.value()
-                                             withTargetID:queryView.targetID];
-          [documentChangesInAllViews addObject:docChanges];
-        }
-      }];
+    [self updateTrackedLimboDocumentsWithChanges:viewChange.limboChanges
+                                        targetID:queryView.targetID];
+
+    if (viewChange.snapshot.has_value()) {
+      newSnapshots.push_back(viewChange.snapshot.value());
+      FSTLocalViewChanges *docChanges =
+          [FSTLocalViewChanges changesForViewSnapshot:viewChange.snapshot.value()
+                                         withTargetID:queryView.targetID];
+      [documentChangesInAllViews addObject:docChanges];
+    }
+  }
 
   [self.syncEngineDelegate handleViewSnapshots:std::move(newSnapshots)];
   [self.localStore notifyLocalViewChanges:documentChangesInAllViews];
@@ -565,8 +787,29 @@ class LimboResolution {
 - (void)trackLimboChange:(FSTLimboDocumentChange *)limboChange {
   DocumentKey key{limboChange.key};
 
-  if (_limboTargetsByKey.find(key) == _limboTargetsByKey.end()) {
+  if (_limboTargetsByKey.find(key) == _limboTargetsByKey.end() &&
+      _enqueuedLimboKeys.find(key) == _enqueuedLimboKeys.end()) {
     LOG_DEBUG("New document in limbo: %s", key.ToString());
+    _enqueuedLimboResolutions.push_back(key);
+    _enqueuedLimboKeys.insert(key);
+    [self pumpEnqueuedLimboResolutions];
+  }
+}
+
+/**
+ * Starts listens for enqueued limbo documents until the maximum number of concurrent limbo
+ * resolutions is reached.
+ */
+- (void)pumpEnqueuedLimboResolutions {
+  while (!_enqueuedLimboResolutions.empty() &&
+         _limboTargetsByKey.size() < _maxConcurrentLimboResolutions) {
+    DocumentKey key = _enqueuedLimboResolutions.front();
+    _enqueuedLimboResolutions.pop_front();
+    if (_enqueuedLimboKeys.erase(key) == 0) {
+      // The document left limbo while it was waiting (or is already being resolved).
+      continue;
+    }
+
     TargetId limboTargetID = _targetIdGenerator.NextId();
     FSTQuery *query = [FSTQuery queryWithPath:key.path()];
     FSTQueryData *queryData = [[FSTQueryData alloc] initWithQuery:query
@@ -574,12 +817,16 @@ class LimboResolution {
                                              listenSequenceNumber:kIrrelevantSequenceNumber
                                                           purpose:FSTQueryPurposeLimboResolution];
     _limboResolutionsByTarget.emplace(limboTargetID, LimboResolution{key});
+    Metrics().limboResolutions->Increment();
     _remoteStore->Listen(queryData);
     _limboTargetsByKey[key] = limboTargetID;
   }
 }
 
 - (void)removeLimboTargetForKey:(const DocumentKey &)key {
+  // If the document is still waiting for a resolution, it no longer needs one.
+  _enqueuedLimboKeys.erase(key);
+
   const auto iter = _limboTargetsByKey.find(key);
   if (iter == _limboTargetsByKey.end()) {
     // This target already got removed, because the query failed.
@@ -589,6 +836,20 @@ class LimboResolution {
   _remoteStore->StopListening(limboTargetID);
   _limboTargetsByKey.erase(key);
   _limboResolutionsByTarget.erase(limboTargetID);
+
+  [self pumpEnqueuedLimboResolutions];
+}
+
+- (size_t)approximateViewBytes {
+  size_t size = 0;
+  for (FSTQueryView *queryView in [_queryViewsByQuery objectEnumerator]) {
+    size += [queryView.view approximateDocumentBytes];
+  }
+  return size;
+}
+
+- (size_t)approximateLimboReferenceBytes {
+  return _limboDocumentRefs.EstimatedByteSize();
 }
 
 // Used for testing
@@ -597,6 +858,18 @@ class LimboResolution {
   return _limboTargetsByKey;
 }
 
+// Used for testing
+- (std::vector<DocumentKey>)enqueuedLimboDocuments {
+  std::vector<DocumentKey> result;
+  std::set<DocumentKey> seen;
+  for (const DocumentKey &key : _enqueuedLimboResolutions) {
+    if (_enqueuedLimboKeys.find(key) != _enqueuedLimboKeys.end() && seen.insert(key).second) {
+      result.push_back(key);
+    }
+  }
+  return result;
+}
+
 - (void)credentialDidChangeWithUser:(const firebase::firestore::auth::User &)user {
   BOOL userChanged = (_currentUser != user);
   _currentUser = user;
@@ -164,6 +164,9 @@ typedef NS_ENUM(NSInteger, FSTLimboDocumentChangeType) {
  */
 - (const model::DocumentKeySet &)syncedDocuments;
 
+/** Approximately how many bytes the documents currently in this view occupy. */
+- (size_t)approximateDocumentBytes;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -16,7 +16,7 @@
 
 #import "Firestore/Source/Core/FSTView.h"
 
-#include <algorithm>
+#include <set>
 #include <utility>
 #include <vector>
 
@@ -28,17 +28,23 @@
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/model/field_mask.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
 #include "Firestore/core/src/firebase/firestore/util/delayed_constructor.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "absl/types/optional.h"
 
 using firebase::firestore::core::DocumentViewChange;
 using firebase::firestore::core::DocumentViewChangeSet;
+using firebase::firestore::core::SortDocumentViewChanges;
 using firebase::firestore::core::SyncState;
 using firebase::firestore::core::ViewSnapshot;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::DocumentSet;
+using firebase::firestore::model::FieldMask;
+using firebase::firestore::model::FieldPath;
 using firebase::firestore::model::MaybeDocumentMap;
 using firebase::firestore::model::OnlineState;
 using firebase::firestore::remote::TargetChange;
@@ -46,27 +52,6 @@ using firebase::firestore::util::DelayedConstructor;
 
 NS_ASSUME_NONNULL_BEGIN
 
-namespace {
-
-int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
-  switch (changeType) {
-    case DocumentViewChange::Type::kRemoved:
-      return 0;
-    case DocumentViewChange::Type::kAdded:
-      return 1;
-    case DocumentViewChange::Type::kModified:
-      return 2;
-    case DocumentViewChange::Type::kMetadata:
-      // A metadata change is converted to a modified change at the public API layer. Since we sort
-      // by document key and then change type, metadata and modified changes must be sorted
-      // equivalently.
-      return 2;
-  }
-  HARD_FAIL("Unknown DocumentViewChange::Type %s", changeType);
-}
-
-}  // namespace
-
 #pragma mark - FSTViewDocumentChanges
 
 /** The result of applying a set of doc changes to a view. */
@@ -230,6 +215,12 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
 
   /** Document Keys that have local changes. */
   DocumentKeySet _mutatedKeys;
+
+  /**
+   * The fields that documents in the view are trimmed to: the query's projection along with the
+   * fields it orders by. Unset if the query has no projection.
+   */
+  absl::optional<FieldMask> _projection;
 }
 
 - (instancetype)initWithQuery:(FSTQuery *)query remoteDocuments:(DocumentKeySet)remoteDocuments {
@@ -238,6 +229,15 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
     _query = query;
     _documentSet.Init(query.comparator);
     _syncedDocuments = std::move(remoteDocuments);
+    if (const FieldMask *projection = query.projection) {
+      std::set<FieldPath> fields{projection->begin(), projection->end()};
+      for (FSTSortOrder *sortOrder in query.sortOrders) {
+        if (!sortOrder.field.IsKeyFieldPath()) {
+          fields.insert(sortOrder.field);
+        }
+      }
+      _projection = FieldMask{std::move(fields)};
+    }
   }
   return self;
 }
@@ -246,6 +246,14 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
   return _syncedDocuments;
 }
 
+- (size_t)approximateDocumentBytes {
+  size_t size = 0;
+  for (FSTDocument *document : *_documentSet) {
+    size += [document approximateByteSize];
+  }
+  return size;
+}
+
 - (FSTViewDocumentChanges *)computeChangesWithDocuments:(const MaybeDocumentMap &)docChanges {
   return [self computeChangesWithDocuments:docChanges previousChanges:nil];
 }
@@ -291,6 +299,9 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
                   key.ToString(), newDoc.key.ToString());
       if (![self.query matchesDocument:newDoc]) {
         newDoc = nil;
+      } else if (_projection) {
+        // Only trim after matching, since filters may be on fields that aren't projected.
+        newDoc = [self projectedDocument:newDoc];
       }
     }
 
@@ -305,7 +316,7 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
     BOOL changeApplied = NO;
     // Calculate change
     if (oldDoc && newDoc) {
-      BOOL docsEqual = [oldDoc.data isEqual:newDoc.data];
+      BOOL docsEqual = [oldDoc hasSameDataAs:newDoc];
       if (!docsEqual) {
         if (![self shouldWaitForSyncedDocument:newDoc oldDocument:oldDoc]) {
           changeSet.AddChange(DocumentViewChange{newDoc, DocumentViewChange::Type::kModified});
@@ -352,12 +363,18 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
   }
 
   if (self.query.limit != NSNotFound && newDocumentSet.size() > self.query.limit) {
-    for (size_t i = newDocumentSet.size() - self.query.limit; i > 0; --i) {
-      FSTDocument *oldDoc = newDocumentSet.GetLastDocument();
-      newDocumentSet = newDocumentSet.erase(oldDoc.key);
-      newMutatedKeys = newMutatedKeys.erase(oldDoc.key);
+    // A refill adds every matching document in the local cache, so there can be far more documents
+    // past the limit than in it. Find them by index and drop them in bulk rather than popping them
+    // off the end one at a time.
+    size_t limit = static_cast<size_t>(self.query.limit);
+    std::vector<DocumentKey> overflowKeys;
+    for (auto iter = newDocumentSet.nth(limit); iter != newDocumentSet.end(); ++iter) {
+      FSTDocument *oldDoc = *iter;
+      overflowKeys.push_back(oldDoc.key);
       changeSet.AddChange(DocumentViewChange{oldDoc, DocumentViewChange::Type::kRemoved});
     }
+    newDocumentSet = newDocumentSet.Truncate(limit);
+    newMutatedKeys = newMutatedKeys.erase_all(overflowKeys);
   }
 
   HARD_ASSERT(!needsRefill || !previousChanges,
@@ -393,15 +410,7 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
 
   // Sort changes based on type and query comparator.
   std::vector<DocumentViewChange> changes = docChanges.changeSet.GetChanges();
-  std::sort(changes.begin(), changes.end(),
-            [self](const DocumentViewChange &lhs, const DocumentViewChange &rhs) {
-              int pos1 = GetDocumentViewChangeTypePosition(lhs.type());
-              int pos2 = GetDocumentViewChangeTypePosition(rhs.type());
-              if (pos1 != pos2) {
-                return pos1 < pos2;
-              }
-              return self.query.comparator(lhs.document(), rhs.document()) == NSOrderedAscending;
-            });
+  SortDocumentViewChanges(self.query, &changes);
 
   [self applyTargetChange:targetChange];
   NSArray<FSTLimboDocumentChange *> *limboChanges = [self updateLimboDocuments];
@@ -446,6 +455,20 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
 
 #pragma mark - Private methods
 
+/** Returns a copy of the given document that only holds the fields in the view's projection. */
+- (FSTDocument *)projectedDocument:(FSTDocument *)document {
+  FSTDocumentState state = FSTDocumentStateSynced;
+  if (document.hasLocalMutations) {
+    state = FSTDocumentStateLocalMutations;
+  } else if (document.hasCommittedMutations) {
+    state = FSTDocumentStateCommittedMutations;
+  }
+  return [FSTDocument documentWithData:[document.data objectByApplyingFieldMask:*_projection]
+                                   key:document.key
+                               version:document.version
+                                 state:state];
+}
+
 /** Returns whether the doc for the given key should be in limbo. */
 - (BOOL)shouldBeLimboDocumentKey:(const DocumentKey &)key {
   // If the remote end says it's part of this query, it's not in limbo.
@@ -474,16 +497,12 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
   if (maybeTargetChange.has_value()) {
     const TargetChange &target_change = maybeTargetChange.value();
 
-    for (const DocumentKey &key : target_change.added_documents()) {
-      _syncedDocuments = _syncedDocuments.insert(key);
-    }
+    _syncedDocuments = _syncedDocuments.Union(target_change.added_documents());
     for (const DocumentKey &key : target_change.modified_documents()) {
       HARD_ASSERT(_syncedDocuments.find(key) != _syncedDocuments.end(),
                   "Modified document %s not found in view.", key.ToString());
     }
-    for (const DocumentKey &key : target_change.removed_documents()) {
-      _syncedDocuments = _syncedDocuments.erase(key);
-    }
+    _syncedDocuments = _syncedDocuments.Difference(target_change.removed_documents());
 
     self.current = target_change.current();
   }
@@ -508,17 +527,13 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
   // Diff the new limbo docs with the old limbo docs.
   NSMutableArray<FSTLimboDocumentChange *> *changes =
       [NSMutableArray arrayWithCapacity:(oldLimboDocuments.size() + _limboDocuments.size())];
-  for (const DocumentKey &key : oldLimboDocuments) {
-    if (!_limboDocuments.contains(key)) {
-      [changes addObject:[FSTLimboDocumentChange changeWithType:FSTLimboDocumentChangeTypeRemoved
-                                                            key:key]];
-    }
+  for (const DocumentKey &key : oldLimboDocuments.Difference(_limboDocuments)) {
+    [changes addObject:[FSTLimboDocumentChange changeWithType:FSTLimboDocumentChangeTypeRemoved
+                                                          key:key]];
   }
-  for (const DocumentKey &key : _limboDocuments) {
-    if (!oldLimboDocuments.contains(key)) {
-      [changes addObject:[FSTLimboDocumentChange changeWithType:FSTLimboDocumentChangeTypeAdded
-                                                            key:key]];
-    }
+  for (const DocumentKey &key : _limboDocuments.Difference(oldLimboDocuments)) {
+    [changes addObject:[FSTLimboDocumentChange changeWithType:FSTLimboDocumentChangeTypeAdded
+                                                          key:key]];
   }
   return changes;
 }
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#include <map>
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/util/path.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "absl/strings/string_view.h"
+
+@class FSTLocalSerializer;
+@class FSTLocalStore;
+@class FSTQuery;
+
+namespace model = firebase::firestore::model;
+namespace util = firebase::firestore::util;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Primes the local store with the documents and query results of a bundle (see local/bundle.h).
+ *
+ * Documents are applied in batches, each in its own transaction, so a large bundle neither holds
+ * all of its documents in memory nor commits them in a single huge write batch. If loading fails
+ * part way through, the documents and queries applied until then are kept: each of them is valid
+ * on its own, and loading the bundle again skips over them.
+ */
+@interface FSTBundleLoader : NSObject
+
+- (instancetype)initWithLocalStore:(FSTLocalStore *)localStore
+                        serializer:(FSTLocalSerializer *)serializer NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/** Maps the bundle file at `path` into memory and loads it. */
+- (util::Status)loadBundleAtPath:(const util::Path &)path;
+
+/** Loads a bundle that's already in memory. */
+- (util::Status)loadBundle:(absl::string_view)bundle;
+
+/** The local view of every document that changed in the local store as a result of loading. */
+- (const model::MaybeDocumentMap &)changedDocuments;
+
+/**
+ * The queries read from the bundle, by the names the bundle gives them. The names are not
+ * persisted, so they're only available from the loader that read the bundle.
+ */
+- (const std::map<std::string, FSTQuery *> &)namedQueries;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,191 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "Firestore/Source/Local/FSTBundleLoader.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#import "Firestore/Protos/objc/firestore/local/MaybeDocument.pbobjc.h"
+#import "Firestore/Protos/objc/firestore/local/Target.pbobjc.h"
+#import "Firestore/Source/Local/FSTLocalSerializer.h"
+#import "Firestore/Source/Local/FSTLocalStore.h"
+#import "Firestore/Source/Local/FSTQueryData.h"
+#import "Firestore/Source/Model/FSTDocument.h"
+
+#include "Firestore/core/src/firebase/firestore/local/bundle.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/util/filesystem.h"
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
+#include "Firestore/core/src/firebase/firestore/util/tracing.h"
+
+using firebase::firestore::FirestoreErrorCode;
+using firebase::firestore::local::BundledQuery;
+using firebase::firestore::local::BundleReader;
+using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::DocumentKeySet;
+using firebase::firestore::model::MaybeDocumentMap;
+using firebase::firestore::util::MappedFile;
+using firebase::firestore::util::Path;
+using firebase::firestore::util::Status;
+using firebase::firestore::util::StatusOr;
+using firebase::firestore::util::StringFormat;
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace {
+
+/**
+ * The number of documents applied per transaction. Large enough that the per-transaction overhead
+ * is amortized, small enough to bound the size of the write batch.
+ */
+const size_t kDocumentsPerBatch = 1000;
+
+NSData *MakeNSDataNoCopy(absl::string_view bytes) {
+  return [[NSData alloc] initWithBytesNoCopy:(void *)bytes.data()
+                                      length:bytes.size()
+                                freeWhenDone:NO];
+}
+
+}  // namespace
+
+@implementation FSTBundleLoader {
+  FSTLocalStore *_localStore;
+  FSTLocalSerializer *_serializer;
+
+  /** Documents read from the bundle but not yet applied. */
+  MaybeDocumentMap _pendingDocuments;
+  size_t _pendingCount;
+
+  MaybeDocumentMap _changedDocuments;
+  std::map<std::string, FSTQuery *> _namedQueries;
+}
+
+- (instancetype)initWithLocalStore:(FSTLocalStore *)localStore
+                        serializer:(FSTLocalSerializer *)serializer {
+  if (self = [super init]) {
+    _localStore = localStore;
+    _serializer = serializer;
+    _pendingCount = 0;
+  }
+  return self;
+}
+
+- (Status)loadBundleAtPath:(const Path &)path {
+  StatusOr<std::unique_ptr<MappedFile>> maybeFile = MappedFile::Open(path);
+  if (!maybeFile.ok()) {
+    return maybeFile.status();
+  }
+
+  // The file must stay mapped while it's read, since everything read from it points into it.
+  std::unique_ptr<MappedFile> file = std::move(maybeFile).ValueOrDie();
+  return [self loadBundle:file->contents()];
+}
+
+- (Status)loadBundle:(absl::string_view)bundle {
+  TRACE_SPAN("local", "-[FSTBundleLoader loadBundle:]");
+  BundleReader reader(bundle);
+  while (reader.Next()) {
+    Status status;
+    switch (reader.type()) {
+      case BundleReader::ElementType::Document:
+        status = [self readDocument:reader.document()];
+        break;
+      case BundleReader::ElementType::Query:
+        status = [self readQuery:reader.query()];
+        break;
+    }
+    if (!status.ok()) {
+      [self flushDocuments];
+      return status;
+    }
+  }
+
+  [self flushDocuments];
+  return reader.status();
+}
+
+- (const MaybeDocumentMap &)changedDocuments {
+  return _changedDocuments;
+}
+
+- (const std::map<std::string, FSTQuery *> &)namedQueries {
+  return _namedQueries;
+}
+
+#pragma mark - Private methods
+
+- (Status)readDocument:(absl::string_view)encoded {
+  NSError *error;
+  FSTPBMaybeDocument *proto = [FSTPBMaybeDocument parseFromData:MakeNSDataNoCopy(encoded)
+                                                          error:&error];
+  if (!proto) {
+    return Status(FirestoreErrorCode::DataLoss,
+                  StringFormat("Bundle contains an invalid document: %s", error));
+  }
+
+  FSTMaybeDocument *document = [_serializer decodedMaybeDocument:proto];
+  _pendingDocuments = _pendingDocuments.insert(document.key, document);
+  _pendingCount++;
+  if (_pendingCount >= kDocumentsPerBatch) {
+    [self flushDocuments];
+  }
+  return Status::OK();
+}
+
+- (Status)readQuery:(const BundledQuery &)bundledQuery {
+  NSError *error;
+  FSTPBTarget *proto = [FSTPBTarget parseFromData:MakeNSDataNoCopy(bundledQuery.target)
+                                            error:&error];
+  if (!proto) {
+    return Status(FirestoreErrorCode::DataLoss,
+                  StringFormat("Bundle contains an invalid query %s: %s", bundledQuery.name,
+                               error));
+  }
+
+  // The query's documents must be in the remote document cache before its target is, or a
+  // listener could observe the target without them.
+  [self flushDocuments];
+
+  FSTQueryData *queryData = [_serializer decodedQueryData:proto];
+  DocumentKeySet keys;
+  for (const DocumentKey &key : bundledQuery.matching_keys) {
+    keys = keys.insert(key);
+  }
+  [_localStore applyBundledQuery:queryData matchingKeys:keys];
+
+  _namedQueries[std::string(bundledQuery.name)] = queryData.query;
+  return Status::OK();
+}
+
+- (void)flushDocuments {
+  if (_pendingCount == 0) return;
+
+  MaybeDocumentMap changed = [_localStore applyBundledDocuments:_pendingDocuments];
+  for (const auto &kv : changed) {
+    _changedDocuments = _changedDocuments.insert(kv.first, kv.second);
+  }
+
+  _pendingDocuments = MaybeDocumentMap{};
+  _pendingCount = 0;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -40,11 +40,11 @@ struct LruParams {
   static const int64_t CacheSizeUnlimited = -1;
 
   static LruParams Default() {
-    return LruParams{100 * 1024 * 1024, 10, 1000};
+    return LruParams{100 * 1024 * 1024, 10, 1000, 500};
   }
 
   static LruParams Disabled() {
-    return LruParams{kFIRFirestoreCacheSizeUnlimited, 0, 0};
+    return LruParams{kFIRFirestoreCacheSizeUnlimited, 0, 0, 0};
   }
 
   static LruParams WithCacheSize(int64_t cacheSize) {
@@ -56,6 +56,12 @@ struct LruParams {
   int64_t minBytesThreshold;
   int percentileToCollect;
   int maximumSequenceNumbersToCollect;
+
+  /**
+   * The maximum number of targets and documents removed by one chunk of an incremental collection
+   * (see `collectChunkWithLiveTargets:previousChunk:`).
+   */
+  int maximumRemovalsPerChunk;
 };
 
 struct LruResults {
@@ -65,8 +71,26 @@ struct LruResults {
 
   bool didRun;
   int sequenceNumbersCollected;
+
+  /** The totals across all the chunks of the collection so far. */
   int targetsRemoved;
   int documentsRemoved;
+
+  /** The number of chunks run so far; a non-incremental collection runs as a single chunk. */
+  int chunksRun;
+
+  /** What the most recent chunk removed. */
+  int chunkTargetsRemoved;
+  int chunkDocumentsRemoved;
+
+  /**
+   * Whether the most recent chunk stopped at its removal limit, meaning another chunk is needed to
+   * finish the collection.
+   */
+  bool hasMoreWork;
+
+  /** The sequence number through which the collection removes targets and documents. */
+  model::ListenSequenceNumber upperBound;
 };
 
 }  // namespace local
@@ -79,7 +103,7 @@ namespace local = firebase::firestore::local;
  * Persistence layers intending to use LRU Garbage collection should implement this protocol. This
  * protocol defines the operations that the LRU garbage collector needs from the persistence layer.
  */
-@protocol FSTLRUDelegate
+@protocol FSTLRUDelegate <NSObject>
 
 /**
  * Enumerates all the targets that the delegate is aware of. This is typically all of the targets in
@@ -93,19 +117,21 @@ namespace local = firebase::firestore::local;
 - (void)enumerateMutationsUsingCallback:(const local::OrphanedDocumentCallback &)callback;
 
 /**
- * Removes all unreferenced documents from the cache that have a sequence number less than or equal
- * to the given sequence number. Returns the number of documents removed.
+ * Removes at most `limit` unreferenced documents from the cache that have a sequence number less
+ * than or equal to the given sequence number. Returns the number of documents removed.
  */
-- (int)removeOrphanedDocumentsThroughSequenceNumber:(model::ListenSequenceNumber)sequenceNumber;
+- (int)removeOrphanedDocumentsThroughSequenceNumber:(model::ListenSequenceNumber)sequenceNumber
+                                              limit:(int)limit;
 
 /**
- * Removes all targets that are not currently being listened to and have a sequence number less than
- * or equal to the given sequence number. Returns the number of targets removed.
+ * Removes at most `limit` targets that are not currently being listened to and have a sequence
+ * number less than or equal to the given sequence number. Returns the number of targets removed.
  */
 - (int)removeTargetsThroughSequenceNumber:(model::ListenSequenceNumber)sequenceNumber
                               liveQueries:
                                   (const std::unordered_map<model::TargetId, FSTQueryData *> &)
-                                      liveQueries;
+                                      liveQueries
+                                    limit:(int)limit;
 
 - (size_t)byteSize;
 
@@ -115,6 +141,15 @@ namespace local = firebase::firestore::local;
 /** Access to the underlying LRU Garbage collector instance. */
 @property(strong, nonatomic, readonly) FSTLRUGarbageCollector *gc;
 
+@optional
+
+/**
+ * Returns the `count`th lowest sequence number of the targets and orphaned documents. Delegates
+ * that keep their sequence numbers in order implement this so that the collector doesn't have to
+ * enumerate all of them.
+ */
+- (model::ListenSequenceNumber)nthSequenceNumber:(NSUInteger)count;
+
 @end
 
 /**
@@ -157,7 +192,21 @@ namespace local = firebase::firestore::local;
 
 - (size_t)byteSize;
 
+/** Runs a complete collection, which must happen within a single transaction. */
 - (local::LruResults)collectWithLiveTargets:
     (const std::unordered_map<model::TargetId, FSTQueryData *> &)liveTargets;
 
+/**
+ * Runs one chunk of an incremental collection, removing at most `maximumRemovalsPerChunk` targets
+ * and documents. Each chunk can run in its own transaction, so a large collection doesn't block
+ * other work for its whole duration.
+ *
+ * Pass `LruResults::DidNotRun()` as `previousChunk` to start a collection, and the results of the
+ * previous chunk to continue one for as long as they report `hasMoreWork`. The returned results
+ * accumulate the totals of all the chunks so far.
+ */
+- (local::LruResults)collectChunkWithLiveTargets:
+                         (const std::unordered_map<model::TargetId, FSTQueryData *> &)liveTargets
+                                   previousChunk:(const local::LruResults &)previousChunk;
+
 @end
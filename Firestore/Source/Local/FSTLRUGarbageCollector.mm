@@ -17,13 +17,17 @@
 #import "Firestore/Source/Local/FSTLRUGarbageCollector.h"
 
 #include <chrono>  //NOLINT(build/c++11)
+#include <limits>
 #include <queue>
 #include <utility>
 
 #import "Firestore/Source/Local/FSTPersistence.h"
 #include "Firestore/core/include/firebase/firestore/timestamp.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/metrics_registry.h"
+#include "Firestore/core/src/firebase/firestore/util/tracing.h"
 
 using Millis = std::chrono::milliseconds;
 using firebase::Timestamp;
@@ -32,6 +36,7 @@ using firebase::firestore::local::LruResults;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::ListenSequenceNumber;
 using firebase::firestore::model::TargetId;
+using firebase::firestore::util::MetricsRegistry;
 
 const int64_t kFIRFirestoreCacheSizeUnlimited = LruParams::CacheSizeUnlimited;
 const ListenSequenceNumber kFSTListenSequenceNumberInvalid = -1;
@@ -40,6 +45,25 @@ static Millis::rep millisecondsBetween(const Timestamp &start, const Timestamp &
   return std::chrono::duration_cast<Millis>(end.ToTimePoint() - start.ToTimePoint()).count();
 }
 
+/**
+ * Records a garbage collection run (or a chunk of an incremental one) in the metrics of every
+ * collector in the process.
+ */
+static void RecordCollection(int targetsRemoved, int documentsRemoved, Millis::rep duration) {
+  static MetricsRegistry::Counter *runs = MetricsRegistry::Default().GetCounter("lru_gc.runs");
+  static MetricsRegistry::Counter *targets =
+      MetricsRegistry::Default().GetCounter("lru_gc.targets_removed");
+  static MetricsRegistry::Counter *documents =
+      MetricsRegistry::Default().GetCounter("lru_gc.documents_removed");
+  static MetricsRegistry::Histogram *latency =
+      MetricsRegistry::Default().GetHistogram("lru_gc.latency");
+
+  runs->Increment();
+  targets->Increment(targetsRemoved);
+  documents->Increment(documentsRemoved);
+  latency->Record(Millis{duration});
+}
+
 /**
  * RollingSequenceNumberBuffer tracks the nth sequence number in a series. Sequence numbers may be
  * added out of order.
@@ -95,9 +119,57 @@ class RollingSequenceNumberBuffer {
 
 - (LruResults)collectWithLiveTargets:
     (const std::unordered_map<TargetId, FSTQueryData *> &)liveTargets {
+  if (![self shouldCollect]) {
+    return LruResults::DidNotRun();
+  }
+  return [self runGCWithLiveTargets:liveTargets];
+}
+
+- (LruResults)collectChunkWithLiveTargets:
+                  (const std::unordered_map<TargetId, FSTQueryData *> &)liveTargets
+                            previousChunk:(const LruResults &)previousChunk {
+  TRACE_SPAN("gc", "-[FSTLRUGarbageCollector collectChunkWithLiveTargets:previousChunk:]");
+  LruResults results = previousChunk;
+  if (!results.didRun) {
+    if (![self shouldCollect]) {
+      return LruResults::DidNotRun();
+    }
+    int sequenceNumbers = [self sequenceNumbersToCollect];
+    results = LruResults{/* didRun= */ true, sequenceNumbers, 0, 0};
+    results.upperBound = [self sequenceNumberForQueryCount:sequenceNumbers];
+  }
+
+  Timestamp start = Timestamp::Now();
+  int limit = _params.maximumRemovalsPerChunk;
+  HARD_ASSERT(limit > 0, "Incremental collection requires a positive maximumRemovalsPerChunk");
+  // Targets go first, since removing them is what orphans their documents.
+  int numTargetsRemoved = [_delegate removeTargetsThroughSequenceNumber:results.upperBound
+                                                            liveQueries:liveTargets
+                                                                  limit:limit];
+  int numDocumentsRemoved =
+      [_delegate removeOrphanedDocumentsThroughSequenceNumber:results.upperBound
+                                                        limit:limit - numTargetsRemoved];
+
+  results.targetsRemoved += numTargetsRemoved;
+  results.documentsRemoved += numDocumentsRemoved;
+  results.chunksRun++;
+  results.chunkTargetsRemoved = numTargetsRemoved;
+  results.chunkDocumentsRemoved = numDocumentsRemoved;
+  results.hasMoreWork = numTargetsRemoved + numDocumentsRemoved >= limit;
+
+  Millis::rep duration = millisecondsBetween(start, Timestamp::Now());
+  RecordCollection(numTargetsRemoved, numDocumentsRemoved, duration);
+
+  LOG_DEBUG("LRU Garbage Collection: chunk %s removed %s targets and %s documents in %sms",
+            results.chunksRun, numTargetsRemoved, numDocumentsRemoved, duration);
+  return results;
+}
+
+/** Returns whether the cache is large enough, and collection enabled, for a collection to run. */
+- (BOOL)shouldCollect {
   if (_params.minBytesThreshold == kFIRFirestoreCacheSizeUnlimited) {
     LOG_DEBUG("Garbage collection skipped; disabled");
-    return LruResults::DidNotRun();
+    return NO;
   }
 
   size_t currentSize = [self byteSize];
@@ -105,21 +177,27 @@ class RollingSequenceNumberBuffer {
     // Not enough on disk to warrant collection. Wait another timeout cycle.
     LOG_DEBUG("Garbage collection skipped; Cache size %s is lower than threshold %s", currentSize,
               _params.minBytesThreshold);
-    return LruResults::DidNotRun();
-  } else {
-    LOG_DEBUG("Running garbage collection on cache of size: %s", currentSize);
-    return [self runGCWithLiveTargets:liveTargets];
+    return NO;
   }
+
+  LOG_DEBUG("Running garbage collection on cache of size: %s", currentSize);
+  return YES;
 }
 
-- (LruResults)runGCWithLiveTargets:
-    (const std::unordered_map<TargetId, FSTQueryData *> &)liveTargets {
-  Timestamp start = Timestamp::Now();
+- (int)sequenceNumbersToCollect {
   int sequenceNumbers = [self queryCountForPercentile:_params.percentileToCollect];
   // Cap at the configured max
   if (sequenceNumbers > _params.maximumSequenceNumbersToCollect) {
     sequenceNumbers = _params.maximumSequenceNumbersToCollect;
   }
+  return sequenceNumbers;
+}
+
+- (LruResults)runGCWithLiveTargets:
+    (const std::unordered_map<TargetId, FSTQueryData *> &)liveTargets {
+  TRACE_SPAN("gc", "-[FSTLRUGarbageCollector runGCWithLiveTargets:]");
+  Timestamp start = Timestamp::Now();
+  int sequenceNumbers = [self sequenceNumbersToCollect];
   Timestamp countedTargets = Timestamp::Now();
 
   ListenSequenceNumber upperBound = [self sequenceNumberForQueryCount:sequenceNumbers];
@@ -144,8 +222,15 @@ class RollingSequenceNumberBuffer {
                   millisecondsBetween(removedTargets, removedDocuments), "ms\n");
   absl::StrAppend(&desc, "Total duration: ", millisecondsBetween(start, removedDocuments), "ms");
   LOG_DEBUG(desc.c_str());
+  RecordCollection(numTargetsRemoved, numDocumentsRemoved,
+                   millisecondsBetween(start, removedDocuments));
 
-  return LruResults{/* didRun= */ true, sequenceNumbers, numTargetsRemoved, numDocumentsRemoved};
+  LruResults results{/* didRun= */ true, sequenceNumbers, numTargetsRemoved, numDocumentsRemoved};
+  results.chunksRun = 1;
+  results.chunkTargetsRemoved = numTargetsRemoved;
+  results.chunkDocumentsRemoved = numDocumentsRemoved;
+  results.upperBound = upperBound;
+  return results;
 }
 
 - (int)queryCountForPercentile:(NSUInteger)percentile {
@@ -158,6 +243,9 @@ class RollingSequenceNumberBuffer {
   if (queryCount == 0) {
     return kFSTListenSequenceNumberInvalid;
   }
+  if ([_delegate respondsToSelector:@selector(nthSequenceNumber:)]) {
+    return [_delegate nthSequenceNumber:queryCount];
+  }
   RollingSequenceNumberBuffer buffer(queryCount);
 
   [_delegate enumerateTargetsUsingCallback:[&buffer](FSTQueryData *queryData) {
@@ -173,11 +261,14 @@ class RollingSequenceNumberBuffer {
 - (int)removeQueriesUpThroughSequenceNumber:(ListenSequenceNumber)sequenceNumber
                                 liveQueries:(const std::unordered_map<TargetId, FSTQueryData *> &)
                                                 liveQueries {
-  return [_delegate removeTargetsThroughSequenceNumber:sequenceNumber liveQueries:liveQueries];
+  return [_delegate removeTargetsThroughSequenceNumber:sequenceNumber
+                                           liveQueries:liveQueries
+                                                 limit:std::numeric_limits<int>::max()];
 }
 
 - (int)removeOrphanedDocumentsThroughSequenceNumber:(ListenSequenceNumber)sequenceNumber {
-  return [_delegate removeOrphanedDocumentsThroughSequenceNumber:sequenceNumber];
+  return [_delegate removeOrphanedDocumentsThroughSequenceNumber:sequenceNumber
+                                                           limit:std::numeric_limits<int>::max()];
 }
 
 - (size_t)byteSize {
@@ -23,10 +23,16 @@
 #import "Firestore/Source/Local/FSTLRUGarbageCollector.h"
 #import "Firestore/Source/Local/FSTPersistence.h"
 #include "Firestore/core/src/firebase/firestore/core/database_info.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_migrations.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_options.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_snapshot.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_statistics.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/path.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "absl/strings/string_view.h"
 #include "leveldb/db.h"
 
 @class FSTLocalSerializer;
@@ -55,6 +61,13 @@ NS_ASSUME_NONNULL_BEGIN
                       lruParams:(local::LruParams)lruParams
                             ptr:(FSTLevelDB *_Nullable *_Nonnull)ptr;
 
+/** Like the above, but tunes the LevelDB database with the given settings. */
++ (util::Status)dbWithDirectory:(util::Path)directory
+                     serializer:(FSTLocalSerializer *)serializer
+                      lruParams:(local::LruParams)lruParams
+                       settings:(const local::LevelDbSettings &)settings
+                            ptr:(FSTLevelDB *_Nullable *_Nonnull)ptr;
+
 - (instancetype)init NS_UNAVAILABLE;
 
 /** Finds a suitable directory to serve as the root of all Firestore local storage. */
@@ -76,11 +89,118 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (const leveldb::ReadOptions)standardReadOptions;
 
+/**
+ * Enables group commit: instead of being written to LevelDB as they commit, the changes of
+ * transactions that commit while an operation runs on `queue` accumulate in a single batch. That
+ * batch is written by an operation enqueued behind them, or sooner if it grows large.
+ *
+ * Reads always see the accumulated changes. A crash may lose the transactions of the batch that
+ * hasn't been written yet, but never part of a transaction, unless it allowed partial commits.
+ * Transactions that call `requireDurableCommit` are written before they finish committing.
+ *
+ * @param queue The queue all transactions run on, which must outlive this instance.
+ */
+- (void)enableGroupCommitOnQueue:(util::AsyncQueue *)queue;
+
+/**
+ * Makes group commit hand the batches it writes behind the transactions on its queue to a serial
+ * queue of their own, so that writing them to LevelDB (and syncing them, with `syncWrites`) no
+ * longer holds up that queue. Reads keep seeing the changes until they've been written. Batches
+ * written for any other reason still wait for those handed off before them.
+ */
+- (void)enableBackgroundWrites;
+
+/**
+ * Whether every write to LevelDB is synced to disk before it completes (off by default), which
+ * protects recent writes from operating system crashes at a significant cost in latency. Applies
+ * to transactions started from now on.
+ */
+@property(nonatomic, assign) BOOL syncWrites;
+
+/** Writes the changes buffered by group commit, if any. Must not be called in a transaction. */
+- (void)flushPendingWrites;
+
+/**
+ * Returns a read-only view of the database as it is now, which can be read on any thread while
+ * transactions go on writing. Reads that need a consistent state of a lot of rows can run on it
+ * without holding up the queue. Writes the changes buffered by group commit first, so the view
+ * includes every transaction committed so far. Must not be called in a transaction, and the view
+ * must be destroyed before `shutdown`.
+ */
+- (std::unique_ptr<local::LevelDbSnapshot>)snapshotWithLabel:(absl::string_view)label;
+
+/**
+ * Whether migrations deferred by `LevelDbSettings::defer_migrations` are still pending. Until they
+ * finish, the indexes they populate are incomplete.
+ */
+@property(nonatomic, readonly) BOOL hasPendingMigrations;
+
+/**
+ * Runs the next chunk of the pending migrations, in a transaction of its own.
+ *
+ * @return Whether migrations remain pending afterwards.
+ */
+- (BOOL)runPendingMigrationChunk;
+
+/**
+ * Runs the given migration to completion if it's pending, for reads that rely on the index it
+ * populates. May be called from within a transaction.
+ */
+- (void)finishMigration:(local::LevelDbMigrations::SchemaVersion)version;
+
+/**
+ * What LevelDB reports about the database: the approximate size of each family of rows, the files
+ * at each level, its memory usage and the compactions requested through `compact`.
+ */
+- (local::LevelDbStatistics)statistics;
+
+/**
+ * Drops the blocks LevelDB has cached in memory that no read is using, returning the number of
+ * bytes released. Blocks are read back from disk as they're needed again.
+ */
+- (size_t)releaseBlockCache;
+
+/**
+ * Writes any changes buffered by group commit and compacts the whole database, which reclaims the
+ * space of the rows that garbage collection deleted. Blocks until the compaction finishes. Must not
+ * be called in a transaction.
+ */
+- (void)compact;
+
+/**
+ * Whether the database is a private copy of one shared with the process that has it open, as
+ * opened with `LevelDbSettings::shared_cache` when that process holds the lease on it. Writes to
+ * the copy aren't seen by other processes and are lost when it's next copied, so readers should
+ * only read.
+ */
+@property(nonatomic, readonly) BOOL isSharedCacheReader;
+
+/**
+ * Whether the process that has the shared database open has written to it since this reader
+ * copied it, in which case reopening it yields a fresher copy. Always NO for the writer.
+ */
+- (BOOL)sharedCacheChanged;
+
 /** The native db pointer, allocated during start. */
 @property(nonatomic, assign, readonly) leveldb::DB *ptr;
 
 @property(nonatomic, readonly) local::LevelDbTransaction *currentTransaction;
 
+/**
+ * Adds `delta` to the running total of bytes used by remote documents, targets and mutation
+ * batches, which the garbage collector compares against its threshold. Must be called from within
+ * a transaction.
+ */
+- (void)adjustByteSize:(int64_t)delta;
+
+/**
+ * Makes the current transaction write its changes, along with any buffered by group commit, to
+ * LevelDB before `commitTransaction` returns, or before `commitDeferredTransactions` returns if it
+ * deferred its commit. Transactions that add mutation batches call this, since the batches are sent
+ * to the backend as soon as they're committed. Must be called from within a transaction.
+ */
+- (void)requireDurableCommit;
+
 @property(nonatomic, readonly) const std::set<std::string> &users;
 
 @property(nonatomic, readonly, strong) FSTLevelDBLRUDelegate *referenceDelegate;
@@ -16,9 +16,12 @@
 
 #import "Firestore/Source/Local/FSTLevelDB.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
 #include <memory>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #import "FIRFirestoreErrors.h"
 #import "Firestore/Source/Local/FSTLRUGarbageCollector.h"
@@ -34,6 +37,8 @@
 #include "Firestore/core/src/firebase/firestore/local/leveldb_mutation_queue.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_query_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_remote_document_cache.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_shared_cache.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_statistics.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_util.h"
 #include "Firestore/core/src/firebase/firestore/local/listen_sequence.h"
@@ -43,8 +48,10 @@
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/util/executor_libdispatch.h"
 #include "Firestore/core/src/firebase/firestore/util/filesystem.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
@@ -60,16 +67,22 @@ namespace util = firebase::firestore::util;
 using firebase::firestore::FirestoreErrorCode;
 using firebase::firestore::auth::User;
 using firebase::firestore::core::DatabaseInfo;
+using firebase::firestore::local::CompactLevelDb;
 using firebase::firestore::local::ConvertStatus;
+using firebase::firestore::local::GetLevelDbStatistics;
 using firebase::firestore::local::IndexManager;
 using firebase::firestore::local::LevelDbDocumentMutationKey;
-using firebase::firestore::local::LevelDbDocumentTargetKey;
 using firebase::firestore::local::LevelDbIndexManager;
 using firebase::firestore::local::LevelDbMigrations;
 using firebase::firestore::local::LevelDbMutationKey;
 using firebase::firestore::local::LevelDbMutationQueue;
+using firebase::firestore::local::LevelDbOptions;
 using firebase::firestore::local::LevelDbQueryCache;
 using firebase::firestore::local::LevelDbRemoteDocumentCache;
+using firebase::firestore::local::LevelDbSettings;
+using firebase::firestore::local::LevelDbSharedCache;
+using firebase::firestore::local::LevelDbSnapshot;
+using firebase::firestore::local::LevelDbStatistics;
 using firebase::firestore::local::LevelDbTransaction;
 using firebase::firestore::local::ListenSequence;
 using firebase::firestore::local::LruParams;
@@ -82,6 +95,9 @@ using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::ListenSequenceNumber;
 using firebase::firestore::model::ResourcePath;
 using firebase::firestore::model::TargetId;
+using firebase::firestore::util::AsyncQueue;
+using firebase::firestore::util::Executor;
+using firebase::firestore::util::ExecutorLibdispatch;
 using firebase::firestore::util::OrderedCode;
 using firebase::firestore::util::Path;
 using firebase::firestore::util::Status;
@@ -94,6 +110,30 @@ using leveldb::WriteOptions;
 
 static const char *kReservedPathComponent = "firestore";
 
+/** The number of rows a chunk of a deferred migration backfills. */
+static const size_t kMigrationChunkRows = 500;
+
+/** How many times a reader of a shared cache tries to copy it before giving up. */
+static const int kMaxSharedCacheCopyAttempts = 3;
+
+using Millis = std::chrono::milliseconds;
+
+static Millis::rep millisecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<Millis>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * The number of changed keys past which the batch accumulated by group commit is written as soon
+ * as its last transaction commits, which bounds the memory it holds.
+ */
+static const size_t kMaxGroupCommitChanges = 10000;
+
+/**
+ * The size of the pending changes past which a transaction that allows partial commits writes
+ * them, which bounds the memory it holds.
+ */
+static const size_t kMaxPartialCommitBytes = 8 * 1024 * 1024;
+
 @interface FSTLevelDB ()
 
 - (size_t)byteSize;
@@ -220,29 +260,34 @@ static const char *kReservedPathComponent = "firestore";
   _db.queryCache->EnumerateOrphanedDocuments(callback);
 }
 
-- (int)removeOrphanedDocumentsThroughSequenceNumber:(ListenSequenceNumber)upperBound {
+- (int)removeOrphanedDocumentsThroughSequenceNumber:(ListenSequenceNumber)upperBound
+                                              limit:(int)limit {
   int count = 0;
-  _db.queryCache->EnumerateOrphanedDocuments(
-      [&count, self, upperBound](const DocumentKey &docKey, ListenSequenceNumber sequenceNumber) {
-        if (sequenceNumber <= upperBound) {
-          if (![self isPinned:docKey]) {
-            count++;
-            self->_db.remoteDocumentCache->Remove(docKey);
-            [self removeSentinel:docKey];
-          }
+  if (limit <= 0) {
+    return count;
+  }
+  _db.queryCache->EnumerateOrphanedDocumentsThrough(
+      upperBound, [&count, self, limit](const DocumentKey &docKey,
+                                        ListenSequenceNumber sequenceNumber) {
+        if (![self isPinned:docKey]) {
+          count++;
+          self->_db.remoteDocumentCache->Remove(docKey);
+          self->_db.queryCache->RemoveSentinel(docKey, sequenceNumber);
         }
+        return count < limit;
       });
   return count;
 }
 
-- (void)removeSentinel:(const DocumentKey &)key {
-  _db.currentTransaction->Delete(LevelDbDocumentTargetKey::SentinelKey(key));
-}
-
 - (int)removeTargetsThroughSequenceNumber:(ListenSequenceNumber)sequenceNumber
                               liveQueries:(const std::unordered_map<TargetId, FSTQueryData *> &)
-                                              liveQueries {
-  return _db.queryCache->RemoveTargets(sequenceNumber, liveQueries);
+                                              liveQueries
+                                    limit:(int)limit {
+  return _db.queryCache->RemoveTargets(sequenceNumber, liveQueries, limit);
+}
+
+- (ListenSequenceNumber)nthSequenceNumber:(NSUInteger)count {
+  return _db.queryCache->NthSequenceNumber(count);
 }
 
 - (size_t)sequenceNumberCount {
@@ -259,10 +304,7 @@ static const char *kReservedPathComponent = "firestore";
 }
 
 - (void)writeSentinelForKey:(const DocumentKey &)key {
-  std::string sentinelKey = LevelDbDocumentTargetKey::SentinelKey(key);
-  std::string encodedSequenceNumber =
-      LevelDbDocumentTargetKey::EncodeSentinelValue([self currentSequenceNumber]);
-  _db.currentTransaction->Put(sentinelKey, encodedSequenceNumber);
+  _db.queryCache->WriteSentinel(key, [self currentSequenceNumber]);
 }
 
 - (void)removeMutationReference:(const DocumentKey &)key {
@@ -282,6 +324,22 @@ static const char *kReservedPathComponent = "firestore";
 @implementation FSTLevelDB {
   Path _directory;
   std::unique_ptr<LevelDbTransaction> _transaction;
+  /**
+   * Whether `_transaction` is in use by a running transaction. If not, but it isn't null, it holds
+   * the changes of committed transactions waiting to be written by group commit.
+   */
+  BOOL _transactionOpen;
+  /** The queue that flushes for group commit, if enabled. */
+  AsyncQueue *_groupCommitQueue;
+  BOOL _flushScheduled;
+  /** Whether a transaction called `deferCommit`, until `commitDeferredTransactions`. */
+  BOOL _commitDeferred;
+  /** Whether a transaction called `requireDurableCommit`, until its changes are written. */
+  BOOL _durableCommitRequired;
+  /** The queue group commit writes its batches from, if background writes are enabled. */
+  std::unique_ptr<Executor> _writeExecutor;
+  /** Owns objects used by `_ptr`, so it's declared first (and destroyed after it). */
+  std::unique_ptr<LevelDbOptions> _options;
   std::unique_ptr<leveldb::DB> _ptr;
   std::unique_ptr<LevelDbRemoteDocumentCache> _documentCache;
   std::unique_ptr<LevelDbIndexManager> _indexManager;
@@ -290,6 +348,17 @@ static const char *kReservedPathComponent = "firestore";
   std::unique_ptr<LevelDbQueryCache> _queryCache;
   std::set<std::string> _users;
   std::unique_ptr<LevelDbMutationQueue> _currentMutationQueue;
+  /** The migrations left pending by a deferred start, in the order they must finish. */
+  std::vector<LevelDbMigrations::SchemaVersion> _pendingMigrations;
+  /** The number of times `compact` has run since the database was opened. */
+  int _compactions;
+  /** Coordinates with the other processes using the database, if it's shared. */
+  std::unique_ptr<LevelDbSharedCache> _sharedCache;
+  /**
+   * For the writer of a shared cache, the sequence number it last wrote with. For a reader, the
+   * one the writer had written with when the reader copied the database.
+   */
+  uint64_t _sharedSequenceNumber;
 }
 
 /**
@@ -323,40 +392,105 @@ static const char *kReservedPathComponent = "firestore";
                                            lruParams:
                                                (firebase::firestore::local::LruParams)lruParams
                                                  ptr:(FSTLevelDB **)ptr {
+  return [self dbWithDirectory:std::move(directory)
+                    serializer:serializer
+                     lruParams:lruParams
+                      settings:LevelDbSettings{}
+                           ptr:ptr];
+}
+
++ (firebase::firestore::util::Status)dbWithDirectory:(firebase::firestore::util::Path)directory
+                                          serializer:(FSTLocalSerializer *)serializer
+                                           lruParams:
+                                               (firebase::firestore::local::LruParams)lruParams
+                                            settings:(const LevelDbSettings &)settings
+                                                 ptr:(FSTLevelDB **)ptr {
+  auto startTime = std::chrono::steady_clock::now();
   Status status = [self ensureDirectory:directory];
   if (!status.ok()) return status;
 
-  StatusOr<std::unique_ptr<DB>> database = [self createDBWithDirectory:directory];
+  auto options = absl::make_unique<LevelDbOptions>(settings);
+  StatusOr<std::unique_ptr<DB>> database = [self createDBWithDirectory:directory
+                                                               options:options->options()];
+  std::unique_ptr<LevelDbSharedCache> sharedCache;
+  BOOL sharedCacheReader = NO;
+  uint64_t sharedSequenceNumber = 0;
+  if (settings.shared_cache) {
+    sharedCache = absl::make_unique<LevelDbSharedCache>(directory);
+    sharedSequenceNumber = sharedCache->ReadSequenceNumber();
+    if (!database.status().ok()) {
+      // Another process holds the lease on the database: start from a copy of it instead.
+      Path readerDirectory = [self sharedCacheReaderDirectoryForDirectory:directory];
+      StatusOr<std::unique_ptr<DB>> copy =
+          [self createDBWithSharedCache:*sharedCache
+                              directory:readerDirectory
+                                options:options->options()
+                         sequenceNumber:&sharedSequenceNumber];
+      if (copy.ok()) {
+        database = std::move(copy);
+        sharedCacheReader = YES;
+        LOG_DEBUG("LevelDB at %s is open in another process, reading a copy at sequence number %s",
+                  directory.ToUtf8String(), sharedSequenceNumber);
+      }
+    }
+  }
   if (!database.status().ok()) {
     return database.status();
   }
+  Millis::rep openMillis = millisecondsSince(startTime);
 
+  auto migrationsStartTime = std::chrono::steady_clock::now();
   std::unique_ptr<DB> ldb = std::move(database.ValueOrDie());
-  LevelDbMigrations::RunMigrations(ldb.get());
+  if (settings.defer_migrations) {
+    LevelDbMigrations::StartMigrations(ldb.get());
+  } else {
+    LevelDbMigrations::RunMigrations(ldb.get());
+  }
+  std::vector<LevelDbMigrations::SchemaVersion> pendingMigrations =
+      LevelDbMigrations::ReadPendingMigrations(ldb.get());
+  Millis::rep migrationsMillis = millisecondsSince(migrationsStartTime);
+
+  auto cachesStartTime = std::chrono::steady_clock::now();
   LevelDbTransaction transaction(ldb.get(), "Start LevelDB");
   std::set<std::string> users = [self collectUserSet:&transaction];
   transaction.Commit();
   FSTLevelDB *db = [[self alloc] initWithLevelDB:std::move(ldb)
+                                         options:std::move(options)
                                            users:users
                                        directory:directory
                                       serializer:serializer
-                                       lruParams:lruParams];
+                                       lruParams:lruParams
+                                        settings:settings];
+  db->_pendingMigrations = std::move(pendingMigrations);
+  if (sharedCache) {
+    db->_isSharedCacheReader = sharedCacheReader;
+    db->_sharedSequenceNumber = sharedSequenceNumber;
+    db->_sharedCache = std::move(sharedCache);
+  }
   *ptr = db;
+
+  LOG_DEBUG("Started LevelDB in %sms: opening took %sms, migrations %sms (%s left pending) and "
+            "loading caches %sms",
+            millisecondsSince(startTime), openMillis, migrationsMillis,
+            db->_pendingMigrations.size(), millisecondsSince(cachesStartTime));
   return Status::OK();
 }
 
 - (instancetype)initWithLevelDB:(std::unique_ptr<leveldb::DB>)db
+                        options:(std::unique_ptr<LevelDbOptions>)options
                           users:(std::set<std::string>)users
                       directory:(firebase::firestore::util::Path)directory
                      serializer:(FSTLocalSerializer *)serializer
-                      lruParams:(firebase::firestore::local::LruParams)lruParams {
+                      lruParams:(firebase::firestore::local::LruParams)lruParams
+                       settings:(const LevelDbSettings &)settings {
   if (self = [super init]) {
     self.started = YES;
+    _options = std::move(options);
     _ptr = std::move(db);
     _directory = std::move(directory);
     _serializer = serializer;
     _queryCache = absl::make_unique<LevelDbQueryCache>(self, _serializer);
-    _documentCache = absl::make_unique<LevelDbRemoteDocumentCache>(self, _serializer);
+    _documentCache = absl::make_unique<LevelDbRemoteDocumentCache>(self, _serializer, settings);
     _indexManager = absl::make_unique<LevelDbIndexManager>(self);
     _referenceDelegate = [[FSTLevelDBLRUDelegate alloc] initWithPersistence:self
                                                                   lruParams:lruParams];
@@ -370,18 +504,15 @@ static const char *kReservedPathComponent = "firestore";
 }
 
 - (size_t)byteSize {
-  int64_t count = 0;
-  auto iter = util::DirectoryIterator::Create(_directory);
-  for (; iter->Valid(); iter->Next()) {
-    int64_t fileSize = util::FileSize(iter->file()).ValueOrDie();
-    count += fileSize;
-  }
-  HARD_ASSERT(iter->status().ok(), "Failed to iterate leveldb directory: %s",
-              iter->status().error_message().c_str());
-  HARD_ASSERT(count >= 0 && count <= SIZE_MAX, "Overflowed counting bytes cached");
+  int64_t count = _queryCache->byte_size();
+  HARD_ASSERT(count >= 0 && count <= SIZE_MAX, "Invalid count of bytes cached: %s", count);
   return static_cast<size_t>(count);
 }
 
+- (void)adjustByteSize:(int64_t)delta {
+  _queryCache->AdjustByteSize(delta);
+}
+
 - (const std::set<std::string> &)users {
   return _users;
 }
@@ -455,10 +586,8 @@ static const char *kReservedPathComponent = "firestore";
 }
 
 /** Opens the database within the given directory. */
-+ (StatusOr<std::unique_ptr<DB>>)createDBWithDirectory:(const Path &)directory {
-  Options options;
-  options.create_if_missing = true;
-
++ (StatusOr<std::unique_ptr<DB>>)createDBWithDirectory:(const Path &)directory
+                                               options:(const Options &)options {
   DB *database = nullptr;
   leveldb::Status status = DB::Open(options, directory.ToUtf8String(), &database);
   if (!status.ok()) {
@@ -470,14 +599,173 @@ static const char *kReservedPathComponent = "firestore";
   return std::unique_ptr<DB>(database);
 }
 
+/**
+ * The directory a process that isn't the writer of the shared cache in `directory` keeps its copy
+ * in. Each app or extension, identified by its bundle, gets a copy of its own.
+ */
++ (Path)sharedCacheReaderDirectoryForDirectory:(const Path &)directory {
+  NSString *bundleID = [[NSBundle mainBundle] bundleIdentifier] ?: @"reader";
+  return Path::FromUtf8(
+      absl::StrCat(directory.ToUtf8String(), ".", util::MakeString(bundleID), ".reader"));
+}
+
+/**
+ * Copies the shared cache into `directory` and opens the copy, setting `sequenceNumber` to the
+ * one the writer had written with when the copy was taken.
+ */
++ (StatusOr<std::unique_ptr<DB>>)createDBWithSharedCache:(const LevelDbSharedCache &)sharedCache
+                                               directory:(const Path &)directory
+                                                 options:(const Options &)options
+                                          sequenceNumber:(uint64_t *)sequenceNumber {
+  Status status;
+  for (int attempt = 0; attempt < kMaxSharedCacheCopyAttempts; ++attempt) {
+    *sequenceNumber = sharedCache.ReadSequenceNumber();
+    status = sharedCache.CopyTo(directory);
+    if (!status.ok()) continue;
+
+    StatusOr<std::unique_ptr<DB>> database = [self createDBWithDirectory:directory options:options];
+    if (database.ok()) return database;
+    status = database.status();
+  }
+  return Status{FirestoreErrorCode::Internal, "Failed to copy shared LevelDB database"}.CausedBy(
+      status);
+}
+
+- (BOOL)sharedCacheChanged {
+  return _isSharedCacheReader && _sharedCache->ReadSequenceNumber() != _sharedSequenceNumber;
+}
+
+/** Tells the readers of the shared cache, if any, that the writer wrote to it. */
+- (void)didWriteToSharedCache {
+  if (!_sharedCache || _isSharedCacheReader) return;
+
+  Status status = _sharedCache->WriteSequenceNumber(++_sharedSequenceNumber);
+  if (!status.ok()) {
+    LOG_WARN("Failed to notify readers of the shared LevelDB database: %s", status.ToString());
+  }
+}
+
 - (LevelDbTransaction *)currentTransaction {
-  HARD_ASSERT(_transaction != nullptr, "Attempting to access transaction before one has started");
+  HARD_ASSERT(_transactionOpen, "Attempting to access transaction before one has started");
   return _transaction.get();
 }
 
+- (void)enableGroupCommitOnQueue:(AsyncQueue *)queue {
+  _groupCommitQueue = queue;
+}
+
+- (void)dealloc {
+  // Background writes use `_ptr`, which is destroyed before `_transaction` waits for them.
+  if (_transaction) _transaction->WaitForBackgroundWrites();
+}
+
+- (void)enableBackgroundWrites {
+  _writeExecutor = absl::make_unique<ExecutorLibdispatch>(
+      dispatch_queue_create("com.google.firebase.firestore.leveldb", DISPATCH_QUEUE_SERIAL));
+}
+
+/** Hands the changes of the committed transactions to `_writeExecutor` to write. */
+- (void)startBackgroundWrite {
+  HARD_ASSERT(!_transactionOpen, "Writing in the background in the middle of a transaction");
+  if (!_transaction) return;
+
+  _transaction->ReapBackgroundWrites();
+  std::shared_ptr<LevelDbTransaction::BackgroundWrite> write = _transaction->StartBackgroundWrite();
+  if (!write) return;
+
+  __weak FSTLevelDB *weakSelf = self;
+  AsyncQueue *queue = _groupCommitQueue;
+  _writeExecutor->Execute([write, weakSelf, queue] {
+    write->Run();
+    // The transaction can drop the written changes, which reads now find in LevelDB.
+    queue->EnqueueRelaxed([weakSelf] {
+      FSTLevelDB *strongSelf = weakSelf;
+      if (strongSelf && strongSelf->_transaction) {
+        strongSelf->_transaction->ReapBackgroundWrites();
+      }
+      [strongSelf didWriteToSharedCache];
+    });
+  });
+}
+
+- (void)flushPendingWrites {
+  HARD_ASSERT(!_transactionOpen, "Flushing writes in the middle of a transaction");
+  _commitDeferred = NO;
+  _durableCommitRequired = NO;
+  if (_transaction) {
+    _transaction->Commit();
+    _transaction.reset();
+    [self didWriteToSharedCache];
+  }
+}
+
+- (std::unique_ptr<LevelDbSnapshot>)snapshotWithLabel:(absl::string_view)label {
+  // The snapshot only sees what's been written to LevelDB.
+  [self flushPendingWrites];
+  return absl::make_unique<LevelDbSnapshot>(_ptr.get(), label, _options->read_options());
+}
+
+#pragma mark - Statistics
+
+- (LevelDbStatistics)statistics {
+  LevelDbStatistics statistics = GetLevelDbStatistics(_ptr.get());
+  statistics.compactions = _compactions;
+  return statistics;
+}
+
+- (size_t)releaseBlockCache {
+  return _options->ReleaseBlockCache();
+}
+
+- (void)compact {
+  [self flushPendingWrites];
+  auto start = std::chrono::steady_clock::now();
+  CompactLevelDb(_ptr.get());
+  ++_compactions;
+  LOG_DEBUG("Compacted LevelDB in %sms", millisecondsSince(start));
+}
+
+#pragma mark - Deferred migrations
+
+- (BOOL)hasPendingMigrations {
+  return !_pendingMigrations.empty();
+}
+
+- (BOOL)runPendingMigrationChunk {
+  if (_pendingMigrations.empty()) return NO;
+
+  // Chunks write to LevelDB directly, outside of any buffered group commit. That's safe since the
+  // buffered changes keep the indexes up to date for the rows they touch, and they're written
+  // after the chunk. Changes already handed off to be written could land in the middle of the chunk
+  // instead, so the chunk waits for them.
+  if (_transaction) _transaction->WaitForBackgroundWrites();
+  auto start = std::chrono::steady_clock::now();
+  LevelDbMigrations::SchemaVersion version = _pendingMigrations.front();
+  if (LevelDbMigrations::RunPendingMigrationChunk(_ptr.get(), version, kMigrationChunkRows)) {
+    _pendingMigrations.erase(_pendingMigrations.begin());
+    LOG_DEBUG("Finished deferred migration %s", version);
+  }
+  LOG_DEBUG("Ran a chunk of deferred migration %s in %sms", version, millisecondsSince(start));
+  return !_pendingMigrations.empty();
+}
+
+- (void)finishMigration:(LevelDbMigrations::SchemaVersion)version {
+  auto it = std::find(_pendingMigrations.begin(), _pendingMigrations.end(), version);
+  if (it == _pendingMigrations.end()) return;
+
+  if (_transaction) _transaction->WaitForBackgroundWrites();
+  auto start = std::chrono::steady_clock::now();
+  while (!LevelDbMigrations::RunPendingMigrationChunk(_ptr.get(), version, kMigrationChunkRows)) {
+  }
+  _pendingMigrations.erase(it);
+  LOG_DEBUG("Waited %sms for deferred migration %s to finish", millisecondsSince(start), version);
+}
+
 #pragma mark - Persistence Factory methods
 
 - (LevelDbMutationQueue *)mutationQueueForUser:(const User &)user {
+  // Starting a mutation queue reads batch IDs directly from LevelDB.
+  [self flushPendingWrites];
   _users.insert(user.uid());
   _currentMutationQueue.reset(new LevelDbMutationQueue(user, self, self.serializer));
   return _currentMutationQueue.get();
@@ -496,20 +784,92 @@ static const char *kReservedPathComponent = "firestore";
 }
 
 - (void)startTransaction:(absl::string_view)label {
-  HARD_ASSERT(_transaction == nullptr, "Starting a transaction while one is already outstanding");
-  _transaction = absl::make_unique<LevelDbTransaction>(_ptr.get(), label);
+  HARD_ASSERT(!_transactionOpen, "Starting a transaction while one is already outstanding");
+  _transactionOpen = YES;
+  if (!_transaction) {
+    WriteOptions writeOptions;
+    writeOptions.sync = self.syncWrites;
+    _transaction = absl::make_unique<LevelDbTransaction>(
+        _ptr.get(), label, _options->read_options(), writeOptions);
+  }
   [_referenceDelegate transactionWillStart];
 }
 
+- (void)allowPartialCommits {
+  HARD_ASSERT(_transactionOpen, "Allowing partial commits outside of a transaction");
+  // Sentinel rows written by the transaction carry its sequence number, so it's recorded ahead of
+  // them. Otherwise it could be handed out again after a crash left some of them behind.
+  _queryCache->RaiseHighestListenSequenceNumber([_referenceDelegate currentSequenceNumber]);
+  _transaction->AllowFlushes(kMaxPartialCommitBytes);
+}
+
+- (void)checkpointPartialCommit {
+  HARD_ASSERT(_transactionOpen, "Checkpointing a partial commit outside of a transaction");
+  _transaction->Checkpoint();
+}
+
 - (void)commitTransaction {
-  HARD_ASSERT(_transaction != nullptr, "Committing a transaction before one is started");
+  HARD_ASSERT(_transactionOpen, "Committing a transaction before one is started");
   [_referenceDelegate transactionWillCommit];
-  _transaction->Commit();
-  _transaction.reset();
+  _transactionOpen = NO;
+  // Transactions grouped with this one may not allow partial commits.
+  _transaction->AllowFlushes(0);
+
+  // After a deferred commit, the changes stay buffered until `commitDeferredTransactions`, which
+  // writes them in order with those of the transactions that committed after it.
+  if (_transaction->changed_keys() >= kMaxGroupCommitChanges ||
+      (!_commitDeferred && (!_groupCommitQueue || _durableCommitRequired))) {
+    [self flushPendingWrites];
+  } else if (!_commitDeferred) {
+    [self scheduleFlush];
+  }
+}
+
+- (void)requireDurableCommit {
+  HARD_ASSERT(_transactionOpen, "Requiring a durable commit outside of a transaction");
+  _durableCommitRequired = YES;
+}
+
+- (void)deferCommit {
+  HARD_ASSERT(_transactionOpen, "Deferring a commit outside of a transaction");
+  _commitDeferred = YES;
+}
+
+- (void)commitDeferredTransactions {
+  HARD_ASSERT(!_transactionOpen, "Committing deferred transactions in the middle of a transaction");
+  if (!_commitDeferred) return;
+
+  _commitDeferred = NO;
+  if (_groupCommitQueue && !_durableCommitRequired) {
+    [self scheduleFlush];
+  } else {
+    [self flushPendingWrites];
+  }
+}
+
+/** Enqueues the group commit flush on `_groupCommitQueue`, unless one is already scheduled. */
+- (void)scheduleFlush {
+  if (!_flushScheduled) {
+    _flushScheduled = YES;
+    __weak FSTLevelDB *weakSelf = self;
+    _groupCommitQueue->EnqueueRelaxed([weakSelf] {
+      FSTLevelDB *strongSelf = weakSelf;
+      if (!strongSelf) return;
+
+      strongSelf->_flushScheduled = NO;
+      if (!strongSelf.isStarted) return;
+      if (strongSelf->_writeExecutor) {
+        [strongSelf startBackgroundWrite];
+      } else {
+        [strongSelf flushPendingWrites];
+      }
+    });
+  }
 }
 
 - (void)shutdown {
   HARD_ASSERT(self.isStarted, "FSTLevelDB shutdown without start!");
+  [self flushPendingWrites];
   self.started = NO;
   _ptr.reset();
 }
@@ -16,6 +16,8 @@
 
 #import <Foundation/Foundation.h>
 
+#include <string>
+
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 
 @class FSTMaybeDocument;
@@ -49,6 +51,12 @@ NS_ASSUME_NONNULL_BEGIN
 /** Encodes an FSTMaybeDocument model to the equivalent protocol buffer for local storage. */
 - (FSTPBMaybeDocument *)encodedMaybeDocument:(FSTMaybeDocument *)document;
 
+/**
+ * Returns the serialized form of encodedMaybeDocument:. Documents that memoize the bytes they were
+ * received in are written around those bytes, without creating any protobuf objects.
+ */
+- (std::string)encodedMaybeDocumentBytes:(FSTMaybeDocument *)document;
+
 /** Decodes an FSTPBMaybeDocument proto to the equivalent model. */
 - (FSTMaybeDocument *)decodedMaybeDocument:(FSTPBMaybeDocument *)proto;
 
@@ -17,6 +17,7 @@
 #import "Firestore/Source/Local/FSTLocalSerializer.h"
 
 #include <cinttypes>
+#include <set>
 #include <utility>
 #include <vector>
 
@@ -25,6 +26,7 @@
 #import "Firestore/Protos/objc/firestore/local/Mutation.pbobjc.h"
 #import "Firestore/Protos/objc/firestore/local/Target.pbobjc.h"
 #import "Firestore/Protos/objc/google/firestore/v1/Document.pbobjc.h"
+#import "Firestore/Protos/objc/google/firestore/v1/Query.pbobjc.h"
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Local/FSTQueryData.h"
 #import "Firestore/Source/Model/FSTDocument.h"
@@ -34,14 +36,24 @@
 
 #include "Firestore/core/include/firebase/firestore/timestamp.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/field_mask.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/wire_writer.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+#include "absl/strings/string_view.h"
 
 using firebase::Timestamp;
 using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::FieldMask;
+using firebase::firestore::model::FieldPath;
 using firebase::firestore::model::ListenSequenceNumber;
 using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::model::TargetId;
+using firebase::firestore::nanopb::WireWriter;
+
+namespace util = firebase::firestore::util;
 
 @interface FSTLocalSerializer ()
 
@@ -86,6 +98,30 @@ using firebase::firestore::model::TargetId;
   return proto;
 }
 
+- (std::string)encodedMaybeDocumentBytes:(FSTMaybeDocument *)document {
+  NSData *encodedProto = nil;
+  if ([document isKindOfClass:[FSTDocument class]]) {
+    encodedProto = ((FSTDocument *)document).encodedProto;
+  }
+
+  if (!encodedProto) {
+    NSData *data = [[self encodedMaybeDocument:document] data];
+    return std::string{static_cast<const char *>(data.bytes), data.length};
+  }
+
+  // Write the fields in the order the protobuf runtime does, so the result is the same either way.
+  std::string result;
+  WireWriter writer{&result};
+  writer.WriteTag(FSTPBMaybeDocument_FieldNumber_Document, PB_WT_STRING);
+  writer.WriteLengthDelimited(
+      absl::string_view{static_cast<const char *>(encodedProto.bytes), encodedProto.length});
+  if (((FSTDocument *)document).hasCommittedMutations) {
+    writer.WriteTag(FSTPBMaybeDocument_FieldNumber_HasCommittedMutations, PB_WT_VARINT);
+    writer.WriteVarint(1);
+  }
+  return result;
+}
+
 - (FSTMaybeDocument *)decodedMaybeDocument:(FSTPBMaybeDocument *)proto {
   switch (proto.documentTypeOneOfCase) {
     case FSTPBMaybeDocument_DocumentType_OneOfCase_Document:
@@ -236,6 +272,18 @@ using firebase::firestore::model::TargetId;
     proto.documents = [remoteSerializer encodedDocumentsTarget:query];
   } else {
     proto.query = [remoteSerializer encodedQueryTarget:query];
+
+    // The projection isn't sent to the backend, but it's part of the query's identity, so it's
+    // stored in the select clause of the persisted target.
+    if (const FieldMask *projection = query.projection) {
+      NSMutableArray<GCFSStructuredQuery_FieldReference *> *fields =
+          proto.query.structuredQuery.select.fieldsArray;
+      for (const FieldPath &field : *projection) {
+        GCFSStructuredQuery_FieldReference *ref = [GCFSStructuredQuery_FieldReference message];
+        ref.fieldPath = util::WrapNSString(field.CanonicalString());
+        [fields addObject:ref];
+      }
+    }
   }
 
   return proto;
@@ -257,6 +305,14 @@ using firebase::firestore::model::TargetId;
 
     case FSTPBTarget_TargetType_OneOfCase_Query:
       query = [remoteSerializer decodedQueryFromQueryTarget:target.query];
+      if (target.query.structuredQuery.select.fieldsArray_Count > 0) {
+        std::set<FieldPath> fields;
+        for (GCFSStructuredQuery_FieldReference *ref in
+             target.query.structuredQuery.select.fieldsArray) {
+          fields.insert(FieldPath::FromServerFormat(util::MakeString(ref.fieldPath)));
+        }
+        query = [query queryBySelectingFields:FieldMask{std::move(fields)}];
+      }
       break;
 
     default:
@@ -21,11 +21,16 @@
 #import "Firestore/Source/Local/FSTLRUGarbageCollector.h"
 
 #include "Firestore/core/src/firebase/firestore/auth/user.h"
+#include "Firestore/core/src/firebase/firestore/local/aggregation.h"
+#include "Firestore/core/src/firebase/firestore/local/field_index.h"
+#include "Firestore/core/src/firebase/firestore/local/local_documents_view.h"
+#include "Firestore/core/src/firebase/firestore/local/memory_usage.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -37,6 +42,7 @@ class RemoteEvent;
 }  // namespace firestore
 }  // namespace firebase
 
+@class FSTFieldValue;
 @class FSTLocalViewChanges;
 @class FSTLocalWriteResult;
 @class FSTMutation;
@@ -110,9 +116,44 @@ NS_ASSUME_NONNULL_BEGIN
 /** Accepts locally generated Mutations and commits them to storage. */
 - (FSTLocalWriteResult *)locallyWriteMutations:(std::vector<FSTMutation *> &&)mutations;
 
+/**
+ * Whether a write of a single set or patch mutation is merged into the batch of the previous write
+ * when both are to the same document, instead of being stored as a batch of its own. This keeps the
+ * mutation queue short while the same document is written repeatedly offline.
+ *
+ * A write is only ever merged into the newest batch in the queue, and only if that batch hasn't
+ * been handed to the remote store yet. The merged write's result then carries the ID of the batch
+ * that it was merged into. Defaults to NO.
+ */
+@property(nonatomic, assign, getter=isMutationCompactionEnabled) BOOL mutationCompactionEnabled;
+
+/**
+ * Whether `locallyWriteMutations:` leaves its transaction uncommitted to durable storage until
+ * `commitLocalWrites`, so that the latency compensated snapshots can be raised first. Defaults to
+ * NO.
+ *
+ * Those snapshots may then describe a write that is never persisted: if the process dies before
+ * `commitLocalWrites`, the write is lost without its completion ever being called. Callers must
+ * call `commitLocalWrites` on every path out of the write, including exceptional ones.
+ */
+@property(nonatomic, assign, getter=isOptimisticWritesEnabled) BOOL optimisticWritesEnabled;
+
+/**
+ * Writes the changes of the `locallyWriteMutations:` calls that `optimisticWritesEnabled` left
+ * uncommitted to durable storage, along with everything committed after them. The new mutation
+ * batches are durable once this returns, even with group commit, so they can then be sent.
+ */
+- (void)commitLocalWrites;
+
 /** Returns the current value of a document with a given key, or nil if not found. */
 - (nullable FSTMaybeDocument *)readDocument:(const model::DocumentKey &)key;
 
+/**
+ * Returns the current values of the documents with the given keys, reading them all in a single
+ * pass over the cache. Keys without a document map to an `FSTDeletedDocument`.
+ */
+- (model::MaybeDocumentMap)readDocuments:(const model::DocumentKeySet &)keys;
+
 /**
  * Acknowledges the given batch.
  *
@@ -143,9 +184,15 @@ NS_ASSUME_NONNULL_BEGIN
  * Sets the stream token for the current user without acknowledging any mutation batch. This is
  * usually only useful after a stream handshake or in response to an error that requires clearing
  * the stream token.
+ *
+ * The token is only written to persistence with the next transaction that removes a mutation
+ * batch, on a user change, or by `flushLastStreamToken`; `lastStreamToken` returns it right away.
  */
 - (void)setLastStreamToken:(nullable NSData *)streamToken;
 
+/** Writes the token from the last `setLastStreamToken:` to persistence if it hasn't been yet. */
+- (void)flushLastStreamToken;
+
 /**
  * Returns the last consistent snapshot processed (used by the RemoteStore to determine whether to
  * buffer incoming snapshots from the backend).
@@ -161,6 +208,23 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (model::MaybeDocumentMap)applyRemoteEvent:(const remote::RemoteEvent &)remoteEvent;
 
+/**
+ * Updates remote documents with the ones read from a bundle, except where the cache already has
+ * the same or a later version: unlike watch, a bundle may be older than what the client has seen.
+ *
+ * @return The local view of the documents that changed.
+ */
+- (model::MaybeDocumentMap)applyBundledDocuments:(const model::MaybeDocumentMap &)documents;
+
+/**
+ * Saves a query read from a bundle as an inactive target whose remote documents are `keys`, so that
+ * listening to the query later resumes from the bundle's resume token and snapshot version. The
+ * target ID of `bundledQueryData` is ignored. Does nothing if the query is being listened to or its
+ * cached target is at least as recent.
+ */
+- (void)applyBundledQuery:(FSTQueryData *)bundledQueryData
+             matchingKeys:(const model::DocumentKeySet &)keys;
+
 /**
  * Returns the keys of the documents that are associated with the given targetID in the remote
  * table.
@@ -179,6 +243,40 @@ NS_ASSUME_NONNULL_BEGIN
 /** Runs @a query against all the documents in the local store and returns the results. */
 - (model::DocumentMap)executeQuery:(FSTQuery *)query;
 
+/**
+ * Runs the query of an allocated target like `executeQuery:`, but starts from the result last
+ * stored for the target (as reported through `notifyLocalViewChanges:`) when there is one, which
+ * turns a scan of the collection into lookups of the documents in the result.
+ */
+- (model::DocumentMap)executeQueryForTarget:(FSTQueryData *)queryData;
+
+/**
+ * Computes the given aggregates over the local view of the documents matching the query, in the
+ * order of `fields`. Unless the query has a limit, matching documents are read one at a time
+ * rather than collected, and a declared field index is used to find them as `executeQuery:` would.
+ */
+- (std::vector<FSTFieldValue *>)aggregateQuery:(FSTQuery *)query
+                                        fields:(const std::vector<local::AggregateField> &)fields;
+
+/**
+ * Reads the next page of at most `pageSize` documents matching the query in the local view,
+ * starting after `cursor` or at the beginning of the results. Unlike `executeQuery:`, only the
+ * documents of the page are decoded and held, so consumers that visit each result once (such as
+ * exports) can walk results of any size. See `LocalDocumentsView::ReadDocumentsMatchingQuery` for
+ * the order of the pages.
+ */
+- (local::LocalQueryPage)readQuery:(FSTQuery *)query
+                          pageSize:(size_t)pageSize
+                             after:(const absl::optional<local::LocalQueryCursor> &)cursor;
+
+/**
+ * Declares a field index, which lets queries with filters or orderBys on the indexed field be
+ * executed as index range scans rather than by scanning every cached document in the collection.
+ * Documents that are already cached are indexed as part of this call. Declaring an index that
+ * already exists is a no-op.
+ */
+- (void)addFieldIndex:(const local::FieldIndex &)index;
+
 /** Notify the local store of the changed views to locally pin / unpin documents. */
 - (void)notifyLocalViewChanges:(NSArray<FSTLocalViewChanges *> *)viewChanges;
 
@@ -192,6 +290,25 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (local::LruResults)collectGarbage:(FSTLRUGarbageCollector *)garbageCollector;
 
+/**
+ * Runs one chunk of an incremental garbage collection in its own transaction. Pass
+ * `LruResults::DidNotRun()` to start a collection and the previous chunk's results to continue it.
+ */
+- (local::LruResults)collectGarbageChunk:(FSTLRUGarbageCollector *)garbageCollector
+                           previousChunk:(const local::LruResults &)previousChunk;
+
+/**
+ * Estimates the memory held by the local store's caches. The view documents are owned by the sync
+ * engine, so `view_documents_bytes` is left at zero.
+ */
+- (local::MemoryUsage)memoryUsage;
+
+/**
+ * Drops the documents and batches that the local store can recompute from persistence: the local
+ * views of documents with pending writes and the decoded copies of persisted mutation batches.
+ */
+- (void)releaseCachedDocuments;
+
 @end
 
 NS_ASSUME_NONNULL_END
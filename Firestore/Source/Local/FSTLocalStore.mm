@@ -16,6 +16,7 @@
 
 #import "Firestore/Source/Local/FSTLocalStore.h"
 
+#include <algorithm>
 #include <memory>
 #include <set>
 #include <unordered_map>
@@ -36,23 +37,37 @@
 #include "Firestore/core/src/firebase/firestore/auth/user.h"
 #include "Firestore/core/src/firebase/firestore/core/target_id_generator.h"
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_set.h"
+#include "Firestore/core/src/firebase/firestore/local/aggregation.h"
 #include "Firestore/core/src/firebase/firestore/local/local_documents_view.h"
+#include "Firestore/core/src/firebase/firestore/local/mutation_compaction.h"
 #include "Firestore/core/src/firebase/firestore/local/mutation_queue.h"
 #include "Firestore/core/src/firebase/firestore/local/query_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/reference_set.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/metrics_registry.h"
+#include "Firestore/core/src/firebase/firestore/util/tracing.h"
 #include "absl/memory/memory.h"
+#include "absl/types/optional.h"
 
 using firebase::firestore::auth::User;
 using firebase::firestore::core::TargetIdGenerator;
+using firebase::firestore::local::AggregateField;
+using firebase::firestore::local::Aggregator;
+using firebase::firestore::local::CompactMutations;
+using firebase::firestore::local::FieldIndex;
 using firebase::firestore::local::LocalDocumentsView;
+using firebase::firestore::local::LocalQueryCursor;
+using firebase::firestore::local::LocalQueryPage;
 using firebase::firestore::local::LruResults;
+using firebase::firestore::local::MemoryUsage;
 using firebase::firestore::local::MutationQueue;
 using firebase::firestore::local::QueryCache;
 using firebase::firestore::local::ReferenceSet;
@@ -61,16 +76,21 @@ using firebase::firestore::model::BatchId;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::DocumentMap;
+using firebase::firestore::model::DocumentSet;
 using firebase::firestore::model::DocumentVersionMap;
 using firebase::firestore::model::FieldMask;
 using firebase::firestore::model::FieldPath;
+using firebase::firestore::model::kBatchIdUnknown;
 using firebase::firestore::model::MaybeDocumentMap;
 using firebase::firestore::model::ListenSequenceNumber;
 using firebase::firestore::model::Precondition;
+using firebase::firestore::model::ResourcePath;
 using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::model::TargetId;
 using firebase::firestore::remote::RemoteEvent;
 using firebase::firestore::remote::TargetChange;
+using firebase::firestore::util::LatencyHistogram;
+using firebase::firestore::util::MetricsRegistry;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -82,6 +102,34 @@ NS_ASSUME_NONNULL_BEGIN
  */
 static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
 
+namespace {
+
+/** The metrics that every `FSTLocalStore` in the process records into. */
+struct LocalStoreMetrics {
+  MetricsRegistry::Counter *batchesWritten =
+      MetricsRegistry::Default().GetCounter("local_store.batches_written");
+  MetricsRegistry::Counter *remoteEventsApplied =
+      MetricsRegistry::Default().GetCounter("local_store.remote_events_applied");
+  MetricsRegistry::Histogram *remoteEventLatency =
+      MetricsRegistry::Default().GetHistogram("local_store.remote_event_latency");
+  MetricsRegistry::Counter *queriesExecuted =
+      MetricsRegistry::Default().GetCounter("local_store.queries_executed");
+  /** Target queries answered from their stored results rather than a collection scan. */
+  MetricsRegistry::Counter *storedResultsUsed =
+      MetricsRegistry::Default().GetCounter("local_store.stored_results_used");
+  MetricsRegistry::Histogram *queryLatency =
+      MetricsRegistry::Default().GetHistogram("local_store.query_latency");
+  MetricsRegistry::Gauge *allocatedTargets =
+      MetricsRegistry::Default().GetGauge("local_store.allocated_targets");
+};
+
+LocalStoreMetrics &Metrics() {
+  static LocalStoreMetrics metrics;
+  return metrics;
+}
+
+}  // namespace
+
 @interface FSTLocalStore ()
 
 /** Manages our in-memory or durable persistence. */
@@ -109,6 +157,32 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
 
   /** Maps a targetID to data about its query. */
   std::unordered_map<TargetId, FSTQueryData *> _targetIDs;
+
+  /**
+   * The snapshot version each active target was last persisted with, which the age of its
+   * in-memory resume token is measured against.
+   */
+  std::unordered_map<TargetId, SnapshotVersion> _persistedSnapshotVersions;
+
+  /**
+   * The stored query results of active targets that were dropped because of remote document
+   * changes since the last `notifyLocalViewChanges:`. They're stored again there for the targets
+   * whose views didn't change.
+   */
+  std::unordered_map<TargetId, DocumentKeySet> _invalidatedQueryResults;
+
+  /** The ID of the batch written by the last call to `locallyWriteMutations:`. */
+  BatchId _lastWrittenBatchID;
+
+  /** The highest batch ID returned by `nextMutationBatchAfterBatchID:`. */
+  BatchId _highestBatchIDHandedOut;
+
+  /**
+   * The stream token from the last `setLastStreamToken:` that hasn't been written to the mutation
+   * queue yet, if `_hasPendingStreamToken` is set. See `setLastStreamToken:`.
+   */
+  NSData *_Nullable _pendingStreamToken;
+  BOOL _hasPendingStreamToken;
 }
 
 - (instancetype)initWithPersistence:(id<FSTPersistence>)persistence
@@ -123,6 +197,8 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
     [_persistence.referenceDelegate addInMemoryPins:&_localViewReferences];
 
     _targetIDGenerator = TargetIdGenerator::QueryCacheTargetIdGenerator(0);
+    _lastWrittenBatchID = kBatchIdUnknown;
+    _highestBatchIDHandedOut = kBatchIdUnknown;
   }
   return self;
 }
@@ -138,14 +214,18 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
 }
 
 - (MaybeDocumentMap)userDidChange:(const User &)user {
+  TRACE_SPAN("local", "-[FSTLocalStore userDidChange:]");
   // Swap out the mutation queue, grabbing the pending mutation batches before and after.
   std::vector<FSTMutationBatch *> oldBatches = self.persistence.run(
-      "OldBatches",
-      [&]() -> std::vector<FSTMutationBatch *> { return _mutationQueue->AllMutationBatches(); });
+      "OldBatches", [&]() -> std::vector<FSTMutationBatch *> {
+        [self writePendingStreamToken];
+        return _mutationQueue->AllMutationBatches();
+      });
 
   // The old one has a reference to the mutation queue, so nil it out first.
   _localDocuments.reset();
   _mutationQueue = [self.persistence mutationQueueForUser:user];
+  _lastWrittenBatchID = kBatchIdUnknown;
 
   [self startMutationQueue];
 
@@ -172,6 +252,7 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
 }
 
 - (FSTLocalWriteResult *)locallyWriteMutations:(std::vector<FSTMutation *> &&)mutations {
+  TRACE_SPAN("local", "-[FSTLocalStore locallyWriteMutations:]");
   FIRTimestamp *localWriteTime = [FIRTimestamp timestamp];
   DocumentKeySet keys;
   for (FSTMutation *mutation : mutations) {
@@ -179,6 +260,11 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
   }
 
   return self.persistence.run("Locally write mutations", [&]() -> FSTLocalWriteResult * {
+    if (self.optimisticWritesEnabled &&
+        [self.persistence respondsToSelector:@selector(deferCommit)]) {
+      [self.persistence deferCommit];
+    }
+
     // Load and apply all existing mutations. This lets us compute the current base state for
     // all non-idempotent transforms before applying any additional user-provided writes.
     MaybeDocumentMap existingDocuments = _localDocuments->GetDocuments(keys);
@@ -217,16 +303,70 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
       }
     }
 
-    FSTMutationBatch *batch = _mutationQueue->AddMutationBatch(
-        localWriteTime, std::move(baseMutations), std::move(mutations));
+    FSTMutationBatch *batch = nil;
+    if (self.isMutationCompactionEnabled && baseMutations.empty() && mutations.size() == 1) {
+      batch = [self compactIntoLastWrittenBatch:mutations[0]];
+    }
+    if (!batch) {
+      batch = _mutationQueue->AddMutationBatch(localWriteTime, std::move(baseMutations),
+                                               std::move(mutations));
+    }
+    _lastWrittenBatchID = batch.batchID;
+    _localDocuments->InvalidateOverlays(batch.keys);
+    Metrics().batchesWritten->Increment();
+
+    // Set and patch mutations are idempotent, so a compacted batch can be applied on top of
+    // documents that already reflect the batch it replaced.
     MaybeDocumentMap changedDocuments = [batch applyToLocalDocumentSet:existingDocuments];
     return [FSTLocalWriteResult resultForBatchID:batch.batchID changes:std::move(changedDocuments)];
   });
 }
 
+/**
+ * Merges the given mutation into the batch written last, if that is still the newest batch in the
+ * queue, hasn't been handed out for sending, and consists of a single mutation that compacts with
+ * the given one. Returns the updated batch, or nil if the mutation needs a batch of its own.
+ */
+- (nullable FSTMutationBatch *)compactIntoLastWrittenBatch:(FSTMutation *)mutation {
+  if (_lastWrittenBatchID == kBatchIdUnknown || _lastWrittenBatchID <= _highestBatchIDHandedOut) {
+    return nil;
+  }
+
+  FSTMutationBatch *lastBatch = _mutationQueue->LookupMutationBatch(_lastWrittenBatchID);
+  if (!lastBatch || _mutationQueue->NextMutationBatchAfterBatchId(_lastWrittenBatchID)) {
+    return nil;
+  }
+  if (!lastBatch.baseMutations.empty() || lastBatch.mutations.size() != 1 ||
+      lastBatch.mutations[0].key != mutation.key) {
+    return nil;
+  }
+
+  FSTMutation *compacted = CompactMutations(lastBatch.mutations[0], mutation);
+  if (!compacted) {
+    return nil;
+  }
+
+  FSTMutationBatch *batch = [[FSTMutationBatch alloc] initWithBatchID:lastBatch.batchID
+                                                       localWriteTime:lastBatch.localWriteTime
+                                                        baseMutations:{}
+                                                            mutations:{compacted}];
+  _mutationQueue->ReplaceMutationBatch(batch);
+  return batch;
+}
+
+- (void)commitLocalWrites {
+  if ([self.persistence respondsToSelector:@selector(commitDeferredTransactions)]) {
+    [self.persistence commitDeferredTransactions];
+  }
+}
+
 - (MaybeDocumentMap)acknowledgeBatchWithResult:(FSTMutationBatchResult *)batchResult {
+  TRACE_SPAN("local", "-[FSTLocalStore acknowledgeBatchWithResult:]");
   return self.persistence.run("Acknowledge batch", [&]() -> MaybeDocumentMap {
     FSTMutationBatch *batch = batchResult.batch;
+    // The acknowledgement's token supersedes any pending one.
+    _hasPendingStreamToken = NO;
+    _pendingStreamToken = nil;
     _mutationQueue->AcknowledgeBatch(batch, batchResult.streamToken);
     [self applyBatchResult:batchResult];
     _mutationQueue->PerformConsistencyCheck();
@@ -236,11 +376,14 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
 }
 
 - (MaybeDocumentMap)rejectBatchID:(BatchId)batchID {
+  TRACE_SPAN("local", "-[FSTLocalStore rejectBatchID:]");
   return self.persistence.run("Reject batch", [&]() -> MaybeDocumentMap {
     FSTMutationBatch *toReject = _mutationQueue->LookupMutationBatch(batchID);
     HARD_ASSERT(toReject, "Attempt to reject nonexistent batch!");
 
+    [self writePendingStreamToken];
     _mutationQueue->RemoveMutationBatch(toReject);
+    _localDocuments->InvalidateOverlays(toReject.keys);
     _mutationQueue->PerformConsistencyCheck();
 
     return _localDocuments->GetDocuments(toReject.keys);
@@ -248,12 +391,39 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
 }
 
 - (nullable NSData *)lastStreamToken {
+  if (_hasPendingStreamToken) {
+    return _pendingStreamToken;
+  }
   return _mutationQueue->GetLastStreamToken();
 }
 
 - (void)setLastStreamToken:(nullable NSData *)streamToken {
-  self.persistence.run("Set stream token",
-                       [&]() { _mutationQueue->SetLastStreamToken(streamToken); });
+  // The write stream's handshake doesn't send a token, so losing one that was set here to a crash
+  // costs nothing. Rather than committing a transaction of its own, the token is kept in memory
+  // and written along with the next batch removal, user change or `flushLastStreamToken`.
+  NSData *current = [self lastStreamToken];
+  if (current == streamToken || [current isEqualToData:streamToken]) {
+    return;
+  }
+  _pendingStreamToken = streamToken;
+  _hasPendingStreamToken = YES;
+}
+
+- (void)flushLastStreamToken {
+  if (!_hasPendingStreamToken) {
+    return;
+  }
+  self.persistence.run("Flush stream token", [&]() { [self writePendingStreamToken]; });
+}
+
+/** Writes the pending stream token, if any, in the current transaction. */
+- (void)writePendingStreamToken {
+  if (!_hasPendingStreamToken) {
+    return;
+  }
+  _mutationQueue->SetLastStreamToken(_pendingStreamToken);
+  _hasPendingStreamToken = NO;
+  _pendingStreamToken = nil;
 }
 
 - (const SnapshotVersion &)lastRemoteSnapshotVersion {
@@ -261,58 +431,41 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
 }
 
 - (MaybeDocumentMap)applyRemoteEvent:(const RemoteEvent &)remoteEvent {
-  return self.persistence.run("Apply remote event", [&]() -> MaybeDocumentMap {
+  TRACE_SPAN("local", "-[FSTLocalStore applyRemoteEvent:]");
+  Metrics().remoteEventsApplied->Increment();
+  auto startedAt = LatencyHistogram::Clock::now();
+  MaybeDocumentMap result = self.persistence.run("Apply remote event", [&]() -> MaybeDocumentMap {
     // TODO(gsoltis): move the sequence number into the reference delegate.
     ListenSequenceNumber sequenceNumber = self.persistence.currentSequenceNumber;
 
+    // A large event may be written in several batches, split at the checkpoints below, any prefix
+    // of which a crash can leave behind. The writes are ordered to keep the cache consistent
+    // through that. Stored query results are invalidated before documents they would miss are
+    // written, and targets only take their new documents and resume tokens once all the documents
+    // are written.
+    [self allowPartialCommits];
+
+    // When a global snapshot contains updates (either add or modify) we can completely trust these
+    // updates as authoritative and blindly apply them to our cache (as a defensive measure to
+    // promote self-healing in the unfortunate case that our cache is ever somehow corrupted /
+    // out-of-sync).
+    //
+    // If the document is only updated while removing it from a target then watch isn't obligated
+    // to send the absolute latest version: it can send the first version that caused the document
+    // not to match.
     DocumentKeySet authoritativeUpdates;
     for (const auto &entry : remoteEvent.target_changes()) {
-      TargetId targetID = entry.first;
-      const TargetChange &change = entry.second;
-
       // Do not ref/unref unassigned targetIDs - it may lead to leaks.
-      auto found = _targetIDs.find(targetID);
-      if (found == _targetIDs.end()) {
+      if (_targetIDs.find(entry.first) == _targetIDs.end()) {
         continue;
       }
-      FSTQueryData *queryData = found->second;
-
-      // When a global snapshot contains updates (either add or modify) we can completely trust
-      // these updates as authoritative and blindly apply them to our cache (as a defensive measure
-      // to promote self-healing in the unfortunate case that our cache is ever somehow corrupted /
-      // out-of-sync).
-      //
-      // If the document is only updated while removing it from a target then watch isn't obligated
-      // to send the absolute latest version: it can send the first version that caused the document
-      // not to match.
-      for (const DocumentKey &key : change.added_documents()) {
-        authoritativeUpdates = authoritativeUpdates.insert(key);
-      }
-      for (const DocumentKey &key : change.modified_documents()) {
-        authoritativeUpdates = authoritativeUpdates.insert(key);
-      }
-
-      _queryCache->RemoveMatchingKeys(change.removed_documents(), targetID);
-      _queryCache->AddMatchingKeys(change.added_documents(), targetID);
-
-      // Update the resume token if the change includes one. Don't clear any preexisting value.
-      // Bump the sequence number as well, so that documents being removed now are ordered later
-      // than documents that were previously removed from this target.
-      NSData *resumeToken = change.resume_token();
-      if (resumeToken.length > 0) {
-        FSTQueryData *oldQueryData = queryData;
-        queryData = [queryData queryDataByReplacingSnapshotVersion:remoteEvent.snapshot_version()
-                                                       resumeToken:resumeToken
-                                                    sequenceNumber:sequenceNumber];
-        _targetIDs[targetID] = queryData;
-
-        if ([self shouldPersistQueryData:queryData oldQueryData:oldQueryData change:change]) {
-          _queryCache->UpdateTarget(queryData);
-        }
-      }
+      const TargetChange &change = entry.second;
+      authoritativeUpdates = authoritativeUpdates.Union(change.added_documents())
+                                 .Union(change.modified_documents());
     }
 
     MaybeDocumentMap changedDocs;
+    DocumentKeySet changedKeys;
     const DocumentKeySet &limboDocuments = remoteEvent.limbo_document_changes();
     DocumentKeySet updatedKeys;
     for (const auto &kv : remoteEvent.document_updates()) {
@@ -337,19 +490,70 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
       if (!existingDoc || doc.version == SnapshotVersion::None() ||
           (authoritativeUpdates.contains(doc.key) && !existingDoc.hasPendingWrites) ||
           doc.version >= existingDoc.version) {
-        _remoteDocumentCache->Add(doc);
         changedDocs = changedDocs.insert(key, doc);
+        changedKeys = changedKeys.insert(key);
       } else {
         LOG_DEBUG("FSTLocalStore Ignoring outdated watch update for %s. "
                   "Current version: %s  Watch version: %s",
                   key.ToString(), existingDoc.version.timestamp().ToString(),
                   doc.version.timestamp().ToString());
       }
+    }
+
+    [self invalidateQueryResultsForChangedDocuments:changedKeys];
+
+    for (const auto &kv : changedDocs) {
+      const DocumentKey &key = kv.first;
+      FSTMaybeDocument *doc = kv.second;
+      // Watch often resends documents that are already cached, so skip rewriting the cache when
+      // nothing at all has changed. A new version with the same data is still written so that the
+      // cached version advances.
+      auto foundExisting = existingDocs.find(key);
+      if (foundExisting == existingDocs.end() || ![doc isEqual:foundExisting->second]) {
+        _remoteDocumentCache->Add(doc);
+      }
+      _localDocuments->InvalidateOverlays(DocumentKeySet{key});
+      [self checkpointPartialCommit];
+    }
 
-      // If this was a limbo resolution, make sure we mark when it was accessed.
+    // If this was a limbo resolution, make sure we mark when it was accessed.
+    for (const DocumentKey &key : updatedKeys) {
       if (limboDocuments.contains(key)) {
         [self.persistence.referenceDelegate limboDocumentUpdated:key];
+        [self checkpointPartialCommit];
+      }
+    }
+
+    for (const auto &entry : remoteEvent.target_changes()) {
+      TargetId targetID = entry.first;
+      const TargetChange &change = entry.second;
+
+      auto found = _targetIDs.find(targetID);
+      if (found == _targetIDs.end()) {
+        continue;
+      }
+      FSTQueryData *queryData = found->second;
+
+      _queryCache->RemoveMatchingKeys(change.removed_documents(), targetID);
+      _queryCache->AddMatchingKeys(change.added_documents(), targetID);
+
+      // Update the resume token if the change includes one. Don't clear any preexisting value.
+      // Bump the sequence number as well, so that documents being removed now are ordered later
+      // than documents that were previously removed from this target.
+      NSData *resumeToken = change.resume_token();
+      if (resumeToken.length > 0) {
+        FSTQueryData *oldQueryData = queryData;
+        queryData = [queryData queryDataByReplacingSnapshotVersion:remoteEvent.snapshot_version()
+                                                       resumeToken:resumeToken
+                                                    sequenceNumber:sequenceNumber];
+        _targetIDs[targetID] = queryData;
+
+        if ([self shouldPersistQueryData:queryData oldQueryData:oldQueryData change:change]) {
+          _queryCache->UpdateTarget(queryData);
+          _persistedSnapshotVersions[targetID] = queryData.snapshotVersion;
+        }
       }
+      [self checkpointPartialCommit];
     }
 
     // HACK: The only reason we allow omitting snapshot version is so we can synthesize remote
@@ -366,6 +570,107 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
 
     return _localDocuments->GetLocalViewOfDocuments(changedDocs);
   });
+  Metrics().remoteEventLatency->RecordElapsedSince(startedAt);
+  return result;
+}
+
+- (MaybeDocumentMap)applyBundledDocuments:(const MaybeDocumentMap &)documents {
+  TRACE_SPAN("local", "-[FSTLocalStore applyBundledDocuments:]");
+  return self.persistence.run("Apply bundled documents", [&]() -> MaybeDocumentMap {
+    // Like remote events, bundles may be written in several batches, split after any document.
+    // Documents that a crash leaves written are skipped when the bundle is loaded again, since
+    // they're no longer older.
+    [self allowPartialCommits];
+
+    DocumentKeySet keys;
+    for (const auto &kv : documents) {
+      keys = keys.insert(kv.first);
+    }
+    MaybeDocumentMap existingDocs = _remoteDocumentCache->GetAll(keys);
+
+    MaybeDocumentMap changedDocs;
+    DocumentKeySet changedKeys;
+    for (const auto &kv : documents) {
+      const DocumentKey &key = kv.first;
+      FSTMaybeDocument *doc = kv.second;
+      FSTMaybeDocument *existingDoc = nil;
+      auto foundExisting = existingDocs.find(key);
+      if (foundExisting != existingDocs.end()) {
+        existingDoc = foundExisting->second;
+      }
+      if (existingDoc && existingDoc.version >= doc.version) {
+        continue;
+      }
+
+      changedDocs = changedDocs.insert(key, doc);
+      changedKeys = changedKeys.insert(key);
+    }
+
+    // Stored query results are invalidated before the documents they would miss are written.
+    [self invalidateQueryResultsForChangedDocuments:changedKeys];
+    for (const auto &kv : changedDocs) {
+      _remoteDocumentCache->Add(kv.second);
+      _localDocuments->InvalidateOverlays(DocumentKeySet{kv.first});
+      [self checkpointPartialCommit];
+    }
+    return _localDocuments->GetLocalViewOfDocuments(changedDocs);
+  });
+}
+
+- (void)applyBundledQuery:(FSTQueryData *)bundledQueryData
+             matchingKeys:(const DocumentKeySet &)keys {
+  TRACE_SPAN("local", "-[FSTLocalStore applyBundledQuery:]");
+  self.persistence.run("Apply bundled query", [&]() {
+    ListenSequenceNumber sequenceNumber = self.persistence.currentSequenceNumber;
+    FSTQueryData *queryData = _queryCache->GetTarget(bundledQueryData.query);
+
+    if (queryData) {
+      // Active targets are kept up to date by watch, so the bundle can't be any newer.
+      if (_targetIDs.find(queryData.targetID) != _targetIDs.end() ||
+          queryData.snapshotVersion >= bundledQueryData.snapshotVersion) {
+        return;
+      }
+
+      TargetId targetID = queryData.targetID;
+      _queryCache->RemoveMatchingKeys(_queryCache->GetMatchingKeys(targetID), targetID);
+      _queryCache->RemoveQueryResult(queryData);
+      queryData = [queryData queryDataByReplacingSnapshotVersion:bundledQueryData.snapshotVersion
+                                                     resumeToken:bundledQueryData.resumeToken
+                                                  sequenceNumber:sequenceNumber];
+      _queryCache->UpdateTarget(queryData);
+    } else {
+      queryData = [[FSTQueryData alloc] initWithQuery:bundledQueryData.query
+                                             targetID:_targetIDGenerator.NextId()
+                                 listenSequenceNumber:sequenceNumber
+                                              purpose:FSTQueryPurposeListen
+                                      snapshotVersion:bundledQueryData.snapshotVersion
+                                          resumeToken:bundledQueryData.resumeToken];
+      _queryCache->AddTarget(queryData);
+    }
+
+    _queryCache->AddMatchingKeys(keys, queryData.targetID);
+  });
+}
+
+/**
+ * Lets the current transaction write its changes before it commits once they grow large, if the
+ * persistence layer supports that. Callers must order their writes so that the writes up to any
+ * `checkpointPartialCommit` leave the cache consistent.
+ */
+- (void)allowPartialCommits {
+  if ([self.persistence respondsToSelector:@selector(allowPartialCommits)]) {
+    [self.persistence allowPartialCommits];
+  }
+}
+
+/**
+ * Marks a point at which the writes of the current transaction leave the cache consistent, where
+ * a transaction that allows partial commits may write its changes.
+ */
+- (void)checkpointPartialCommit {
+  if ([self.persistence respondsToSelector:@selector(checkpointPartialCommit)]) {
+    [self.persistence checkpointPartialCommit];
+  }
 }
 
 /**
@@ -391,8 +696,17 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
   // up-to-date after a crash and avoids needing to loop over all active queries on shutdown.
   // Especially in the browser we may not get time to do anything interesting while the current
   // tab is closing.
+  //
+  // The age is measured from when the target was last persisted rather than from its last
+  // in-memory update: watch refreshes the tokens of idle targets more often than this, so those
+  // would otherwise never be persisted.
+  SnapshotVersion persistedVersion = oldQueryData.snapshotVersion;
+  auto persisted = _persistedSnapshotVersions.find(newQueryData.targetID);
+  if (persisted != _persistedSnapshotVersions.end()) {
+    persistedVersion = persisted->second;
+  }
   int64_t newSeconds = newQueryData.snapshotVersion.timestamp().seconds();
-  int64_t oldSeconds = oldQueryData.snapshotVersion.timestamp().seconds();
+  int64_t oldSeconds = persistedVersion.timestamp().seconds();
   int64_t timeDelta = newSeconds - oldSeconds;
   if (timeDelta >= kResumeTokenMaxAgeSeconds) return YES;
 
@@ -406,6 +720,7 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
 }
 
 - (void)notifyLocalViewChanges:(NSArray<FSTLocalViewChanges *> *)viewChanges {
+  TRACE_SPAN("local", "-[FSTLocalStore notifyLocalViewChanges:]");
   self.persistence.run("NotifyLocalViewChanges", [&]() {
     for (FSTLocalViewChanges *viewChange in viewChanges) {
       for (const DocumentKey &key : viewChange.removedKeys) {
@@ -413,7 +728,18 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
       }
       _localViewReferences.AddReferences(viewChange.addedKeys, viewChange.targetID);
       _localViewReferences.AddReferences(viewChange.removedKeys, viewChange.targetID);
+
+      if (viewChange.resultKeys) {
+        [self updateQueryResult:*viewChange.resultKeys forTargetID:viewChange.targetID];
+        _invalidatedQueryResults.erase(viewChange.targetID);
+      }
     }
+
+    // The remaining views didn't change, so their previous results still stand.
+    for (const auto &kv : _invalidatedQueryResults) {
+      [self updateQueryResult:kv.second forTargetID:kv.first];
+    }
+    _invalidatedQueryResults.clear();
   });
 }
 
@@ -422,6 +748,10 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
       self.persistence.run("NextMutationBatchAfterBatchID", [&]() -> FSTMutationBatch * {
         return _mutationQueue->NextMutationBatchAfterBatchId(batchID);
       });
+  if (result) {
+    // The batch may be sent from now on, so it can no longer absorb later writes.
+    _highestBatchIDHandedOut = std::max(_highestBatchIDHandedOut, result.batchID);
+  }
   return result;
 }
 
@@ -431,7 +761,14 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
   });
 }
 
+- (MaybeDocumentMap)readDocuments:(const DocumentKeySet &)keys {
+  return self.persistence.run("ReadDocuments", [&]() -> MaybeDocumentMap {
+    return _localDocuments->GetDocuments(keys);
+  });
+}
+
 - (FSTQueryData *)allocateQuery:(FSTQuery *)query {
+  TRACE_SPAN("local", "-[FSTLocalStore allocateQuery:]");
   FSTQueryData *queryData = self.persistence.run("Allocate query", [&]() -> FSTQueryData * {
     FSTQueryData *cached = _queryCache->GetTarget(query);
     // TODO(mcg): freshen last accessed date if cached exists?
@@ -449,10 +786,13 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
   HARD_ASSERT(_targetIDs.find(targetID) == _targetIDs.end(),
               "Tried to allocate an already allocated query: %s", query);
   _targetIDs[targetID] = queryData;
+  _persistedSnapshotVersions[targetID] = queryData.snapshotVersion;
+  Metrics().allocatedTargets->Add(1);
   return queryData;
 }
 
 - (void)releaseQuery:(FSTQuery *)query {
+  TRACE_SPAN("local", "-[FSTLocalStore releaseQuery:]");
   self.persistence.run("Release query", [&]() {
     FSTQueryData *queryData = _queryCache->GetTarget(query);
     HARD_ASSERT(queryData, "Tried to release nonexistent query: %s", query);
@@ -477,15 +817,89 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
     for (const DocumentKey &key : removed) {
       [self.persistence.referenceDelegate removeReference:key];
     }
-    _targetIDs.erase(targetID);
+    if (_targetIDs.erase(targetID) > 0) {
+      Metrics().allocatedTargets->Add(-1);
+    }
+    _persistedSnapshotVersions.erase(targetID);
     [self.persistence.referenceDelegate removeTarget:queryData];
   });
 }
 
 - (DocumentMap)executeQuery:(FSTQuery *)query {
-  return self.persistence.run("ExecuteQuery", [&]() -> DocumentMap {
+  Metrics().queriesExecuted->Increment();
+  auto startedAt = LatencyHistogram::Clock::now();
+  DocumentMap result = self.persistence.run("ExecuteQuery", [&]() -> DocumentMap {
     return _localDocuments->GetDocumentsMatchingQuery(query);
   });
+  Metrics().queryLatency->RecordElapsedSince(startedAt);
+  return result;
+}
+
+- (DocumentMap)executeQueryForTarget:(FSTQueryData *)queryData {
+  TRACE_SPAN("local", "-[FSTLocalStore executeQueryForTarget:]");
+  Metrics().queriesExecuted->Increment();
+  auto startedAt = LatencyHistogram::Clock::now();
+  DocumentMap result = self.persistence.run("ExecuteQueryForTarget", [&]() -> DocumentMap {
+    FSTQuery *query = queryData.query;
+    if (![query isDocumentQuery] && ![query isCollectionGroupQuery]) {
+      absl::optional<DocumentKeySet> remoteKeys = _queryCache->GetQueryResult(queryData);
+      if (remoteKeys) {
+        absl::optional<DocumentMap> docs =
+            _localDocuments->GetDocumentsMatchingQuery(query, *remoteKeys);
+        if (docs) {
+          Metrics().storedResultsUsed->Increment();
+          return *std::move(docs);
+        }
+      }
+    }
+    return _localDocuments->GetDocumentsMatchingQuery(query);
+  });
+  Metrics().queryLatency->RecordElapsedSince(startedAt);
+  return result;
+}
+
+- (std::vector<FSTFieldValue *>)aggregateQuery:(FSTQuery *)query
+                                        fields:(const std::vector<AggregateField> &)fields {
+  TRACE_SPAN("local", "-[FSTLocalStore aggregateQuery:fields:]");
+  return self.persistence.run("AggregateQuery", [&]() -> std::vector<FSTFieldValue *> {
+    Aggregator aggregator{fields};
+    if (query.limit == NSNotFound) {
+      _localDocuments->ForEachDocumentMatchingQuery(
+          query, [&aggregator](FSTDocument *doc) { aggregator.Add(doc); });
+      return aggregator.Results();
+    }
+
+    // Which documents fall within the limit depends on the order of all of the
+    // matching documents, so these have to be collected and sorted first.
+    DocumentMap matches = _localDocuments->GetDocumentsMatchingQuery(query);
+    DocumentSet docs{query.comparator};
+    for (const auto &kv : matches.underlying_map()) {
+      docs = docs.insert(static_cast<FSTDocument *>(kv.second));
+    }
+    NSInteger count = 0;
+    for (FSTDocument *doc : docs) {
+      if (count++ == query.limit) break;
+      aggregator.Add(doc);
+    }
+    return aggregator.Results();
+  });
+}
+
+- (LocalQueryPage)readQuery:(FSTQuery *)query
+                   pageSize:(size_t)pageSize
+                      after:(const absl::optional<LocalQueryCursor> &)cursor {
+  TRACE_SPAN("local", "-[FSTLocalStore readQuery:pageSize:after:]");
+  return self.persistence.run("ReadQuery", [&]() -> LocalQueryPage {
+    return _localDocuments->ReadDocumentsMatchingQuery(query, pageSize, cursor);
+  });
+}
+
+- (void)addFieldIndex:(const FieldIndex &)index {
+  self.persistence.run("Add field index", [&]() {
+    if ([self.persistence indexManager]->AddFieldIndex(index)) {
+      _remoteDocumentCache->BackfillFieldIndex(index);
+    }
+  });
 }
 
 - (DocumentKeySet)remoteDocumentKeysForTarget:(TargetId)targetID {
@@ -518,6 +932,59 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
   }
 
   _mutationQueue->RemoveMutationBatch(batch);
+  _localDocuments->InvalidateOverlays(docKeys);
+  [self invalidateQueryResultsForChangedDocuments:docKeys];
+}
+
+/**
+ * Drops the stored query results of the collections containing the given remote documents, which
+ * have changed. The results of active targets are set aside, to be stored again if their views
+ * don't change.
+ */
+- (void)invalidateQueryResultsForChangedDocuments:(const DocumentKeySet &)keys {
+  std::set<ResourcePath> collectionPaths;
+  for (const DocumentKey &key : keys) {
+    collectionPaths.insert(key.path().PopLast());
+  }
+
+  for (const ResourcePath &collectionPath : collectionPaths) {
+    for (const auto &kv : _targetIDs) {
+      FSTQueryData *queryData = kv.second;
+      if (queryData.query.path != collectionPath ||
+          _invalidatedQueryResults.find(kv.first) != _invalidatedQueryResults.end()) {
+        continue;
+      }
+      absl::optional<DocumentKeySet> result = _queryCache->GetQueryResult(queryData);
+      if (result) {
+        _invalidatedQueryResults[kv.first] = *std::move(result);
+      }
+    }
+    _queryCache->InvalidateQueryResults(collectionPath);
+  }
+}
+
+/**
+ * Stores the keys of the documents in an active target's view as its query result, provided that
+ * the view reflects the remote documents alone.
+ */
+- (void)updateQueryResult:(const DocumentKeySet &)keys forTargetID:(TargetId)targetID {
+  auto found = _targetIDs.find(targetID);
+  if (found == _targetIDs.end()) {
+    return;
+  }
+  FSTQueryData *queryData = found->second;
+  FSTQuery *query = queryData.query;
+  if ([query isDocumentQuery] || [query isCollectionGroupQuery]) {
+    return;
+  }
+
+  // With pending writes the view isn't the result of the query against the remote documents, and
+  // any result stored before the writes may be outdated by now.
+  if (!_mutationQueue->AllMutationBatchesAffectingQuery(query).empty()) {
+    _queryCache->RemoveQueryResult(queryData);
+  } else {
+    _queryCache->SetQueryResult(queryData, keys);
+  }
 }
 
 - (LruResults)collectGarbage:(FSTLRUGarbageCollector *)garbageCollector {
@@ -526,6 +993,27 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
   });
 }
 
+- (LruResults)collectGarbageChunk:(FSTLRUGarbageCollector *)garbageCollector
+                    previousChunk:(const LruResults &)previousChunk {
+  return self.persistence.run("Collect garbage chunk", [&]() -> LruResults {
+    return [garbageCollector collectChunkWithLiveTargets:_targetIDs previousChunk:previousChunk];
+  });
+}
+
+- (MemoryUsage)memoryUsage {
+  MemoryUsage usage;
+  usage.remote_documents_bytes = _remoteDocumentCache->EstimatedMemoryUsage();
+  usage.local_documents_bytes = _localDocuments->EstimatedOverlayByteSize();
+  usage.reference_set_bytes = _localViewReferences.EstimatedByteSize();
+  usage.mutation_batches_bytes = _mutationQueue->EstimatedMemoryUsage();
+  return usage;
+}
+
+- (void)releaseCachedDocuments {
+  _localDocuments->ReleaseOverlays();
+  _mutationQueue->ReleaseCachedBatches();
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -19,6 +19,7 @@
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "absl/types/optional.h"
 
 @class FSTMutation;
 @class FSTQuery;
@@ -49,6 +50,12 @@ NS_ASSUME_NONNULL_BEGIN
 - (const model::DocumentKeySet &)addedKeys;
 - (const model::DocumentKeySet &)removedKeys;
 
+/**
+ * The keys of all documents in the view after the changes, if they're known (i.e. if the changes
+ * were created from a view snapshot).
+ */
+- (const absl::optional<model::DocumentKeySet> &)resultKeys;
+
 @end
 
 NS_ASSUME_NONNULL_END
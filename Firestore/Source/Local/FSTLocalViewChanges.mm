@@ -32,12 +32,14 @@ NS_ASSUME_NONNULL_BEGIN
 @interface FSTLocalViewChanges ()
 - (instancetype)initWithTarget:(TargetId)targetID
                      addedKeys:(DocumentKeySet)addedKeys
-                   removedKeys:(DocumentKeySet)removedKeys NS_DESIGNATED_INITIALIZER;
+                   removedKeys:(DocumentKeySet)removedKeys
+                    resultKeys:(absl::optional<DocumentKeySet>)resultKeys NS_DESIGNATED_INITIALIZER;
 @end
 
 @implementation FSTLocalViewChanges {
   DocumentKeySet _addedKeys;
   DocumentKeySet _removedKeys;
+  absl::optional<DocumentKeySet> _resultKeys;
 }
 
 + (instancetype)changesForViewSnapshot:(const ViewSnapshot &)viewSnapshot
@@ -61,9 +63,15 @@ NS_ASSUME_NONNULL_BEGIN
     }
   }
 
-  return [self changesForTarget:targetID
-                      addedKeys:std::move(addedKeys)
-                    removedKeys:std::move(removedKeys)];
+  DocumentKeySet resultKeys;
+  for (FSTDocument *doc : viewSnapshot.documents()) {
+    resultKeys = resultKeys.insert(doc.key);
+  }
+
+  return [[FSTLocalViewChanges alloc] initWithTarget:targetID
+                                           addedKeys:std::move(addedKeys)
+                                         removedKeys:std::move(removedKeys)
+                                          resultKeys:std::move(resultKeys)];
 }
 
 + (instancetype)changesForTarget:(TargetId)targetID
@@ -71,17 +79,20 @@ NS_ASSUME_NONNULL_BEGIN
                      removedKeys:(DocumentKeySet)removedKeys {
   return [[FSTLocalViewChanges alloc] initWithTarget:targetID
                                            addedKeys:std::move(addedKeys)
-                                         removedKeys:std::move(removedKeys)];
+                                         removedKeys:std::move(removedKeys)
+                                          resultKeys:absl::nullopt];
 }
 
 - (instancetype)initWithTarget:(TargetId)targetID
                      addedKeys:(DocumentKeySet)addedKeys
-                   removedKeys:(DocumentKeySet)removedKeys {
+                   removedKeys:(DocumentKeySet)removedKeys
+                    resultKeys:(absl::optional<DocumentKeySet>)resultKeys {
   self = [super init];
   if (self) {
     _targetID = targetID;
     _addedKeys = std::move(addedKeys);
     _removedKeys = std::move(removedKeys);
+    _resultKeys = std::move(resultKeys);
   }
   return self;
 }
@@ -94,6 +105,10 @@ NS_ASSUME_NONNULL_BEGIN
   return _removedKeys;
 }
 
+- (const absl::optional<DocumentKeySet> &)resultKeys {
+  return _resultKeys;
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -36,9 +36,22 @@ NS_ASSUME_NONNULL_BEGIN
 
 + (instancetype)persistenceWithEagerGC;
 
+/**
+ * Creates a persistence that keeps documents after they're no longer referenced, until LRU garbage
+ * collection finds the cache over the size threshold in `lruParams`. The serializer measures the
+ * size of the cache.
+ */
 + (instancetype)persistenceWithLruParams:(local::LruParams)lruParams
                               serializer:(FSTLocalSerializer *)serializer;
 
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * An estimate of the memory used by cached documents, targets and pending writes, as the size of
+ * their serialized forms. Always 0 for persistence with eager GC, which doesn't measure it.
+ */
+@property(nonatomic, readonly) size_t byteSize;
+
 @end
 
 /**
@@ -57,7 +70,6 @@ NS_ASSUME_NONNULL_BEGIN
     : NSObject <FSTReferenceDelegate, FSTLRUDelegate, FSTTransactional>
 
 - (instancetype)initWithPersistence:(FSTMemoryPersistence *)persistence
-                         serializer:(FSTLocalSerializer *)serializer
                           lruParams:(local::LruParams)lruParams;
 
 - (BOOL)isPinnedAtSequenceNumber:(model::ListenSequenceNumber)upperBound
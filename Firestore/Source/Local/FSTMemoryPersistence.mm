@@ -55,6 +55,9 @@ NS_ASSUME_NONNULL_BEGIN
 
 @interface FSTMemoryPersistence ()
 
+- (instancetype)initWithSerializer:(nullable FSTLocalSerializer *)serializer
+    NS_DESIGNATED_INITIALIZER;
+
 - (MemoryQueryCache *)queryCache;
 
 - (MemoryRemoteDocumentCache *)remoteDocumentCache;
@@ -91,10 +94,13 @@ NS_ASSUME_NONNULL_BEGIN
   FSTTransactionRunner _transactionRunner;
 
   id<FSTReferenceDelegate> _referenceDelegate;
+
+  /** Measures the size of the cache, if set. */
+  FSTLocalSerializer *_Nullable _serializer;
 }
 
 + (instancetype)persistenceWithEagerGC {
-  FSTMemoryPersistence *persistence = [[FSTMemoryPersistence alloc] init];
+  FSTMemoryPersistence *persistence = [[FSTMemoryPersistence alloc] initWithSerializer:nil];
   persistence.referenceDelegate =
       [[FSTMemoryEagerReferenceDelegate alloc] initWithPersistence:persistence];
   return persistence;
@@ -102,23 +108,36 @@ NS_ASSUME_NONNULL_BEGIN
 
 + (instancetype)persistenceWithLruParams:(firebase::firestore::local::LruParams)lruParams
                               serializer:(FSTLocalSerializer *)serializer {
-  FSTMemoryPersistence *persistence = [[FSTMemoryPersistence alloc] init];
+  FSTMemoryPersistence *persistence = [[FSTMemoryPersistence alloc] initWithSerializer:serializer];
   persistence.referenceDelegate =
       [[FSTMemoryLRUReferenceDelegate alloc] initWithPersistence:persistence
-                                                      serializer:serializer
                                                        lruParams:lruParams];
   return persistence;
 }
 
-- (instancetype)init {
+- (instancetype)initWithSerializer:(nullable FSTLocalSerializer *)serializer {
   if (self = [super init]) {
+    _serializer = serializer;
     _queryCache = absl::make_unique<MemoryQueryCache>(self);
-    _remoteDocumentCache = absl::make_unique<MemoryRemoteDocumentCache>(self);
+    _remoteDocumentCache = absl::make_unique<MemoryRemoteDocumentCache>(self, serializer);
     self.started = YES;
   }
   return self;
 }
 
+- (size_t)byteSize {
+  if (!_serializer) return 0;
+
+  // Documents make up the bulk of the cache, so theirs is the only size that's tracked as they're
+  // added. Targets and pending writes are few enough to measure on demand.
+  size_t count = _remoteDocumentCache->byte_size();
+  count += _queryCache->CalculateByteSize(_serializer);
+  for (const auto &entry : _mutationQueues) {
+    count += entry.second->CalculateByteSize(_serializer);
+  }
+  return count;
+}
+
 - (void)setReferenceDelegate:(id<FSTReferenceDelegate>)referenceDelegate {
   _referenceDelegate = referenceDelegate;
   id delegate = _referenceDelegate;
@@ -181,11 +200,9 @@ NS_ASSUME_NONNULL_BEGIN
   // PORTING NOTE: when this class is ported to C++, this does not need to be a pointer
   std::unique_ptr<ListenSequence> _listenSequence;
   ListenSequenceNumber _currentSequenceNumber;
-  FSTLocalSerializer *_serializer;
 }
 
 - (instancetype)initWithPersistence:(FSTMemoryPersistence *)persistence
-                         serializer:(FSTLocalSerializer *)serializer
                           lruParams:(firebase::firestore::local::LruParams)lruParams {
   if (self = [super init]) {
     _persistence = persistence;
@@ -195,7 +212,6 @@ NS_ASSUME_NONNULL_BEGIN
     ListenSequenceNumber highestSequenceNumber =
         _persistence.queryCache->highest_listen_sequence_number();
     _listenSequence = absl::make_unique<ListenSequence>(highestSequenceNumber);
-    _serializer = serializer;
   }
   return self;
 }
@@ -254,8 +270,9 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (int)removeTargetsThroughSequenceNumber:(ListenSequenceNumber)sequenceNumber
                               liveQueries:(const std::unordered_map<TargetId, FSTQueryData *> &)
-                                              liveQueries {
-  return _persistence.queryCache->RemoveTargets(sequenceNumber, liveQueries);
+                                              liveQueries
+                                    limit:(int)limit {
+  return _persistence.queryCache->RemoveTargets(sequenceNumber, liveQueries, limit);
 }
 
 - (size_t)sequenceNumberCount {
@@ -267,9 +284,10 @@ NS_ASSUME_NONNULL_BEGIN
   return totalCount;
 }
 
-- (int)removeOrphanedDocumentsThroughSequenceNumber:(ListenSequenceNumber)upperBound {
+- (int)removeOrphanedDocumentsThroughSequenceNumber:(ListenSequenceNumber)upperBound
+                                              limit:(int)limit {
   std::vector<DocumentKey> removed =
-      _persistence.remoteDocumentCache->RemoveOrphanedDocuments(self, upperBound);
+      _persistence.remoteDocumentCache->RemoveOrphanedDocuments(self, upperBound, limit);
   for (const auto &key : removed) {
     _sequenceNumbers.erase(key);
   }
@@ -317,17 +335,7 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (size_t)byteSize {
-  // Note that this method is only used for testing because this delegate is only
-  // used for testing. The algorithm here (loop through everything, serialize it
-  // and count bytes) is inefficient and inexact, but won't run in production.
-  size_t count = 0;
-  count += _persistence.queryCache->CalculateByteSize(_serializer);
-  count += _persistence.remoteDocumentCache->CalculateByteSize(_serializer);
-  const MutationQueues &queues = [_persistence mutationQueues];
-  for (const auto &entry : queues) {
-    count += entry.second->CalculateByteSize(_serializer);
-  }
-  return count;
+  return [_persistence byteSize];
 }
 
 @end
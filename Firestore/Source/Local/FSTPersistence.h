@@ -102,6 +102,35 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property(nonatomic, readonly) model::ListenSequenceNumber currentSequenceNumber;
 
+@optional
+
+/**
+ * Lets the current transaction write its changes to durable storage before it commits, at calls to
+ * `checkpointPartialCommit` once they grow large, so that it doesn't have to hold them all in
+ * memory. A crash can then leave the writes up to any checkpoint behind, so this is only for
+ * transactions that order their writes to stay consistent through that, like the application of
+ * remote events and bundles.
+ */
+- (void)allowPartialCommits;
+
+/**
+ * Marks a point in a transaction that allows partial commits at which its writes so far leave the
+ * cache consistent. The transaction's changes are only written early at such points, so the rows
+ * that describe others, like the cache's byte size, sentinel rows and indexes, are always written
+ * along with the rows they describe.
+ */
+- (void)checkpointPartialCommit;
+
+/**
+ * Keeps the changes of the current transaction from being written to durable storage when it
+ * commits, along with those of the transactions that commit after it, until
+ * `commitDeferredTransactions`. Reads see the changes in the meantime.
+ */
+- (void)deferCommit;
+
+/** Writes the changes held back by `deferCommit`, in the order they were committed, if any. */
+- (void)commitDeferredTransactions;
+
 @end
 
 @protocol FSTTransactional
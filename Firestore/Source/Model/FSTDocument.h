@@ -52,6 +52,12 @@ typedef NS_ENUM(NSInteger, FSTDocumentState) {
  */
 - (bool)hasPendingWrites;
 
+/**
+ * Returns an estimate of the number of bytes of memory used by the document, including its key and
+ * data. The key's path is shared by the copies of the key, but is counted in full.
+ */
+- (size_t)approximateByteSize;
+
 @end
 
 @interface FSTDocument : FSTMaybeDocument
@@ -66,18 +72,55 @@ typedef NS_ENUM(NSInteger, FSTDocumentState) {
                            state:(FSTDocumentState)state
                            proto:(GCFSDocument *)proto;
 
+/**
+ * Creates a document received from Watch, keeping the serialized google.firestore.v1.Document it
+ * was decoded from in `encodedProto`.
+ */
++ (instancetype)documentWithData:(FSTObjectValue *)data
+                             key:(model::DocumentKey)key
+                         version:(model::SnapshotVersion)version
+                           state:(FSTDocumentState)state
+                    encodedProto:(nullable NSData *)encodedProto;
+
 - (nullable FSTFieldValue *)fieldForPath:(const model::FieldPath &)path;
 - (bool)hasLocalMutations;
 - (bool)hasCommittedMutations;
 
 @property(nonatomic, strong, readonly) FSTObjectValue *data;
 
+/**
+ * A hash of `data`, computed on first use and memoized. Documents with equal data have equal
+ * content hashes, so differing content hashes prove that the data differs.
+ */
+@property(nonatomic, assign, readonly) NSUInteger contentHash;
+
+/**
+ * Returns whether the given document has the same data as this one, ignoring key, version and
+ * state. Checks the content hashes before comparing the data field by field.
+ */
+- (BOOL)hasSameDataAs:(FSTDocument *)other;
+
+/**
+ * Returns the values a comparator memoized for `ordering` with setSortValues:forOrdering:, or nil
+ * if the last values set were for another ordering. `ordering` is compared by identity. Documents
+ * are immutable and usually sit in a single view, so a comparator only has to look up the fields
+ * it orders by once per document rather than on every comparison.
+ */
+- (nullable NSArray *)sortValuesForOrdering:(id)ordering;
+- (void)setSortValues:(NSArray *)values forOrdering:(id)ordering;
+
 /**
  * Memoized serialized form of the document for optimization purposes (avoids repeated
  * serialization). Might be nil.
  */
 @property(nonatomic, strong, readonly) GCFSDocument *proto;
 
+/**
+ * Memoized serialized google.firestore.v1.Document, kept instead of `proto` for documents decoded
+ * without creating protobuf objects. Local persistence writes these bytes as they are. Might be nil.
+ */
+@property(nonatomic, strong, readonly, nullable) NSData *encodedProto;
+
 @end
 
 @interface FSTDeletedDocument : FSTMaybeDocument
@@ -16,8 +16,11 @@
 
 #import "Firestore/Source/Model/FSTDocument.h"
 
+#import <objc/runtime.h>
+
 #include <utility>
 
+#import "Firestore/Protos/objc/google/firestore/v1/Document.pbobjc.h"
 #import "Firestore/Source/Model/FSTFieldValue.h"
 #import "Firestore/Source/Util/FSTClasses.h"
 
@@ -72,10 +75,34 @@ NS_ASSUME_NONNULL_BEGIN
   return _version;
 }
 
+- (size_t)approximateByteSize {
+  return class_getInstanceSize([self class]) + _key.EstimatedPathByteSize();
+}
+
+@end
+
+/** The sort values memoized on a document, together with the ordering they were extracted for. */
+@interface FSTDocumentSortValues : NSObject {
+ @public
+  id _ordering;
+  NSArray *_values;
+}
+@end
+
+@implementation FSTDocumentSortValues
+@end
+
+@interface FSTDocument ()
+
+// Snapshots compare documents on the user's queue too, so the memo is swapped atomically.
+@property(atomic, strong, nullable) FSTDocumentSortValues *memoizedSortValues;
+
 @end
 
 @implementation FSTDocument {
   FSTDocumentState _documentState;
+  // The memoized hash of _data, or 0 if it hasn't been computed yet.
+  NSUInteger _contentHash;
 }
 
 + (instancetype)documentWithData:(FSTObjectValue *)data
@@ -100,6 +127,19 @@ NS_ASSUME_NONNULL_BEGIN
                                      proto:proto];
 }
 
++ (instancetype)documentWithData:(FSTObjectValue *)data
+                             key:(DocumentKey)key
+                         version:(SnapshotVersion)version
+                           state:(FSTDocumentState)state
+                    encodedProto:(nullable NSData *)encodedProto {
+  FSTDocument *document = [[FSTDocument alloc] initWithData:data
+                                                        key:std::move(key)
+                                                    version:std::move(version)
+                                                      state:state];
+  document->_encodedProto = encodedProto;
+  return document;
+}
+
 - (instancetype)initWithData:(FSTObjectValue *)data
                          key:(DocumentKey)key
                      version:(SnapshotVersion)version
@@ -149,13 +189,13 @@ NS_ASSUME_NONNULL_BEGIN
 
   FSTDocument *otherDoc = other;
   return self.key == otherDoc.key && self.version == otherDoc.version &&
-         _documentState == otherDoc->_documentState && [self.data isEqual:otherDoc.data];
+         _documentState == otherDoc->_documentState && [self hasSameDataAs:otherDoc];
 }
 
 - (NSUInteger)hash {
   NSUInteger result = self.key.Hash();
   result = result * 31 + self.version.Hash();
-  result = result * 31 + [self.data hash];
+  result = result * 31 + self.contentHash;
   result = result * 31 + _documentState;
   return result;
 }
@@ -171,6 +211,43 @@ NS_ASSUME_NONNULL_BEGIN
   return [_data valueForPath:path];
 }
 
+- (NSUInteger)contentHash {
+  // A hash that happens to be 0 is just recomputed on every call.
+  if (_contentHash == 0) {
+    _contentHash = [_data hash];
+  }
+  return _contentHash;
+}
+
+- (BOOL)hasSameDataAs:(FSTDocument *)other {
+  if (_data == other->_data) {
+    return YES;
+  }
+  return self.contentHash == other.contentHash && [_data isEqual:other->_data];
+}
+
+- (nullable NSArray *)sortValuesForOrdering:(id)ordering {
+  FSTDocumentSortValues *memoized = self.memoizedSortValues;
+  return memoized && memoized->_ordering == ordering ? memoized->_values : nil;
+}
+
+- (void)setSortValues:(NSArray *)values forOrdering:(id)ordering {
+  FSTDocumentSortValues *memoized = [[FSTDocumentSortValues alloc] init];
+  memoized->_ordering = ordering;
+  memoized->_values = values;
+  self.memoizedSortValues = memoized;
+}
+
+- (size_t)approximateByteSize {
+  size_t size = [super approximateByteSize] + [_data approximateByteSize];
+  // The encoded document is kept alongside the data it decodes to.
+  if (_proto) {
+    size += static_cast<size_t>([_proto serializedSize]);
+  }
+  size += _encodedProto.length;
+  return size;
+}
+
 @end
 
 @implementation FSTDeletedDocument {
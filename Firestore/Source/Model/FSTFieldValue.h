@@ -116,6 +116,12 @@ enum class ServerTimestampBehavior { None, Estimate, Previous };
 /** Compares against another FSTFieldValue. */
 - (NSComparisonResult)compare:(FSTFieldValue *)other;
 
+/**
+ * Returns an estimate of the number of bytes of memory used by the value, including the objects it
+ * owns. Values shared with other values are counted in full.
+ */
+- (size_t)approximateByteSize;
+
 @end
 
 /**
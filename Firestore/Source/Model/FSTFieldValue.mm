@@ -16,6 +16,8 @@
 
 #import "Firestore/Source/Model/FSTFieldValue.h"
 
+#import <objc/runtime.h>
+
 #include <functional>
 #include <utility>
 
@@ -118,6 +120,10 @@ NS_ASSUME_NONNULL_BEGIN
   }
 }
 
+- (size_t)approximateByteSize {
+  return class_getInstanceSize([self class]);
+}
+
 @end
 
 #pragma mark - FSTNullValue
@@ -366,6 +372,10 @@ NS_ASSUME_NONNULL_BEGIN
   }
 }
 
+- (size_t)approximateByteSize {
+  return [super approximateByteSize] + class_getInstanceSize([FIRTimestamp class]);
+}
+
 @end
 #pragma mark - FSTServerTimestampValue
 
@@ -437,6 +447,11 @@ NS_ASSUME_NONNULL_BEGIN
   }
 }
 
+- (size_t)approximateByteSize {
+  return [super approximateByteSize] + class_getInstanceSize([FIRTimestamp class]) +
+         [self.previousValue approximateByteSize];
+}
+
 @end
 
 #pragma mark - FSTGeoPointValue
@@ -489,6 +504,10 @@ NS_ASSUME_NONNULL_BEGIN
   }
 }
 
+- (size_t)approximateByteSize {
+  return [super approximateByteSize] + class_getInstanceSize([FIRGeoPoint class]);
+}
+
 @end
 #pragma mark - FSTBlobValue
 
@@ -557,6 +576,10 @@ static NSComparisonResult CompareBytes(NSData *left, NSData *right) {
   }
 }
 
+- (size_t)approximateByteSize {
+  return [super approximateByteSize] + self.internalValue.length;
+}
+
 @end
 
 #pragma mark - FSTReferenceValue
@@ -626,6 +649,11 @@ static NSComparisonResult CompareBytes(NSData *left, NSData *right) {
   }
 }
 
+- (size_t)approximateByteSize {
+  return [super approximateByteSize] + class_getInstanceSize([FSTDocumentKey class]) +
+         self.key.key.EstimatedPathByteSize();
+}
+
 @end
 
 #pragma mark - FSTObjectValue
@@ -814,7 +842,7 @@ static const NSComparator StringComparator = ^NSComparisonResult(NSString *left,
 }
 
 - (FSTObjectValue *)objectByApplyingFieldMask:(const FieldMask &)fieldMask {
-  FSTObjectValue *filteredObject = self;
+  FSTObjectValue *filteredObject = [FSTObjectValue objectValue];
   for (const FieldPath &path : fieldMask) {
     if (path.empty()) {
       return self;
@@ -828,6 +856,15 @@ static const NSComparator StringComparator = ^NSComparisonResult(NSString *left,
   return filteredObject;
 }
 
+- (size_t)approximateByteSize {
+  __block size_t size = [super approximateByteSize];
+  [self.internalValue
+      enumerateKeysAndObjectsUsingBlock:^(NSString *key, FSTFieldValue *obj, BOOL *stop) {
+        size += [key lengthOfBytesUsingEncoding:NSUTF8StringEncoding] + [obj approximateByteSize];
+      }];
+  return size;
+}
+
 @end
 
 @interface FSTArrayValue ()
@@ -905,6 +942,14 @@ static const NSComparator StringComparator = ^NSComparisonResult(NSString *left,
   }
 }
 
+- (size_t)approximateByteSize {
+  size_t size = [super approximateByteSize];
+  for (FSTFieldValue *element in self.internalValue) {
+    size += [element approximateByteSize];
+  }
+  return size;
+}
+
 @end
 
 @implementation FSTDelegateValue {
@@ -1021,6 +1066,11 @@ static const NSComparator StringComparator = ^NSComparisonResult(NSString *left,
   return self.internalValue.Hash();
 }
 
+- (size_t)approximateByteSize {
+  // The instance already includes the FieldValue itself.
+  return [super approximateByteSize] - sizeof(FieldValue) + self.internalValue.EstimatedByteSize();
+}
+
 @end
 
 template <>
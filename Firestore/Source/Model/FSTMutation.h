@@ -167,6 +167,9 @@ NS_ASSUME_NONNULL_BEGIN
 /** Returns whether all operations in the mutation are idempotent. */
 @property(nonatomic, readonly) BOOL idempotent;
 
+/** Returns an estimate of the number of bytes of memory used by the mutation and its values. */
+- (size_t)approximateByteSize;
+
 @end
 
 #pragma mark - FSTSetMutation
@@ -238,6 +241,9 @@ NS_ASSUME_NONNULL_BEGIN
 /** The fields and associated values to use when patching the document. */
 @property(nonatomic, strong, readonly) FSTObjectValue *value;
 
+/** Returns the result of applying this patch to the given object, ignoring the precondition. */
+- (FSTObjectValue *)patchObjectValue:(FSTObjectValue *)objectValue;
+
 @end
 
 #pragma mark - FSTTransformMutation
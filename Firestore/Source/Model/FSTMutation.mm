@@ -16,6 +16,8 @@
 
 #import "Firestore/Source/Model/FSTMutation.h"
 
+#import <objc/runtime.h>
+
 #include <memory>
 #include <set>
 #include <string>
@@ -126,6 +128,10 @@ NS_ASSUME_NONNULL_BEGIN
 - (const SnapshotVersion &)postMutationVersionForDocument:(FSTMaybeDocument *)maybeDoc {
   return [maybeDoc isKindOfClass:[FSTDocument class]] ? maybeDoc.version : SnapshotVersion::None();
 }
+- (size_t)approximateByteSize {
+  return class_getInstanceSize([self class]) + _key.EstimatedPathByteSize();
+}
+
 @end
 
 #pragma mark - FSTSetMutation
@@ -203,6 +209,10 @@ NS_ASSUME_NONNULL_BEGIN
   return YES;
 }
 
+- (size_t)approximateByteSize {
+  return [super approximateByteSize] + [self.value approximateByteSize];
+}
+
 @end
 
 #pragma mark - FSTPatchMutation
@@ -323,6 +333,10 @@ NS_ASSUME_NONNULL_BEGIN
   return YES;
 }
 
+- (size_t)approximateByteSize {
+  return [super approximateByteSize] + [self.value approximateByteSize];
+}
+
 @end
 
 @implementation FSTTransformMutation {
@@ -86,9 +86,21 @@ NS_ASSUME_NONNULL_BEGIN
 - (FSTMaybeDocument *_Nullable)applyToLocalDocument:(FSTMaybeDocument *_Nullable)maybeDoc
                                         documentKey:(const model::DocumentKey &)documentKey;
 
-/** Computes the local view for all provided documents given the mutations in this batch. */
+/**
+ * Computes the local view for all provided documents given the mutations in this batch. Documents
+ * the batch mutates that aren't in `documentSet` are mutated from a missing document and added.
+ */
 - (model::MaybeDocumentMap)applyToLocalDocumentSet:(const model::MaybeDocumentMap &)documentSet;
 
+/**
+ * Applies the mutations in this batch to the documents in `documents` that they affect, in a
+ * single pass over the batch's mutations grouped by key. Unlike `applyToLocalDocumentSet:`, the
+ * documents the batch mutates that aren't in `documents` are left out. Documents the batch
+ * doesn't affect are shared with `documents` rather than visited, so the cost is proportional to
+ * the size of the batch rather than to the number of documents.
+ */
+- (model::MaybeDocumentMap)applyToLocalDocuments:(const model::MaybeDocumentMap &)documents;
+
 /** Returns the set of unique keys referenced by all mutations in the batch. */
 - (model::DocumentKeySet)keys;
 
@@ -111,6 +123,9 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (const std::vector<FSTMutation *> &)mutations;
 
+/** Returns an estimate of the number of bytes of memory used by the batch and its mutations. */
+- (size_t)approximateByteSize;
+
 @end
 
 #pragma mark - FSTMutationBatchResult
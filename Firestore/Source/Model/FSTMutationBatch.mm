@@ -16,7 +16,10 @@
 
 #import "Firestore/Source/Model/FSTMutationBatch.h"
 
+#import <objc/runtime.h>
+
 #include <algorithm>
+#include <map>
 #include <utility>
 
 #import "FIRTimestamp.h"
@@ -41,6 +44,16 @@ using firebase::firestore::util::Hash;
 
 NS_ASSUME_NONNULL_BEGIN
 
+namespace {
+
+/** The mutations of a batch that affect a single document, in batch order. */
+struct DocumentMutations {
+  std::vector<FSTMutation *> baseMutations;
+  std::vector<FSTMutation *> mutations;
+};
+
+}  // namespace
+
 @implementation FSTMutationBatch {
   std::vector<FSTMutation *> _baseMutations;
   std::vector<FSTMutation *> _mutations;
@@ -153,23 +166,71 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (MaybeDocumentMap)applyToLocalDocumentSet:(const MaybeDocumentMap &)documentSet {
-  // TODO(mrschmidt): This implementation is O(n^2). If we iterate through the mutations first (as
-  // done in `applyToLocalDocument:documentKey:`), we can reduce the complexity to O(n).
+  return [self applyToLocalDocuments:documentSet includingMissing:YES];
+}
 
-  MaybeDocumentMap mutatedDocuments = documentSet;
-  for (FSTMutation *mutation : _mutations) {
-    const DocumentKey &key = mutation.key;
-    auto maybeDocument = mutatedDocuments.find(key);
-    FSTMaybeDocument *mutatedDocument = [self
-        applyToLocalDocument:(maybeDocument != mutatedDocuments.end() ? maybeDocument->second : nil)
-                 documentKey:key];
-    if (mutatedDocument) {
-      mutatedDocuments = mutatedDocuments.insert(key, mutatedDocument);
+- (MaybeDocumentMap)applyToLocalDocuments:(const MaybeDocumentMap &)documents {
+  return [self applyToLocalDocuments:documents includingMissing:NO];
+}
+
+- (MaybeDocumentMap)applyToLocalDocuments:(const MaybeDocumentMap &)documents
+                         includingMissing:(BOOL)includingMissing {
+  MaybeDocumentMap mutatedDocuments = documents;
+  for (const auto &entry : [self mutationsByKey]) {
+    const DocumentKey &key = entry.first;
+    auto found = documents.find(key);
+    if (found == documents.end() && !includingMissing) {
+      continue;
+    }
+
+    FSTMaybeDocument *_Nullable maybeDoc = found != documents.end() ? found->second : nil;
+    maybeDoc = [self applyMutations:entry.second toLocalDocument:maybeDoc];
+    if (maybeDoc || found != documents.end()) {
+      mutatedDocuments = mutatedDocuments.insert(key, maybeDoc);
     }
   }
   return mutatedDocuments;
 }
 
+/**
+ * Groups the mutations of this batch by the key they affect. Only the keys of user-provided
+ * mutations are included, since those are the documents the batch applies to.
+ */
+- (std::map<DocumentKey, DocumentMutations>)mutationsByKey {
+  std::map<DocumentKey, DocumentMutations> result;
+  for (FSTMutation *mutation : _mutations) {
+    result[mutation.key].mutations.push_back(mutation);
+  }
+  for (FSTMutation *mutation : _baseMutations) {
+    auto found = result.find(mutation.key);
+    if (found != result.end()) {
+      found->second.baseMutations.push_back(mutation);
+    }
+  }
+  return result;
+}
+
+/**
+ * Applies the mutations of this batch that affect one document to it, like
+ * `applyToLocalDocument:documentKey:` but without scanning the whole batch.
+ */
+- (FSTMaybeDocument *_Nullable)applyMutations:(const DocumentMutations &)documentMutations
+                              toLocalDocument:(FSTMaybeDocument *_Nullable)maybeDoc {
+  for (FSTMutation *mutation : documentMutations.baseMutations) {
+    maybeDoc = [mutation applyToLocalDocument:maybeDoc
+                                 baseDocument:maybeDoc
+                               localWriteTime:self.localWriteTime];
+  }
+
+  FSTMaybeDocument *baseDoc = maybeDoc;
+  for (FSTMutation *mutation : documentMutations.mutations) {
+    maybeDoc = [mutation applyToLocalDocument:maybeDoc
+                                 baseDocument:baseDoc
+                               localWriteTime:self.localWriteTime];
+  }
+  return maybeDoc;
+}
+
 - (DocumentKeySet)keys {
   DocumentKeySet set;
   for (FSTMutation *mutation : _mutations) {
@@ -178,6 +239,17 @@ NS_ASSUME_NONNULL_BEGIN
   return set;
 }
 
+- (size_t)approximateByteSize {
+  size_t size = class_getInstanceSize([self class]);
+  for (FSTMutation *mutation : _baseMutations) {
+    size += sizeof(FSTMutation *) + [mutation approximateByteSize];
+  }
+  for (FSTMutation *mutation : _mutations) {
+    size += sizeof(FSTMutation *) + [mutation approximateByteSize];
+  }
+  return size;
+}
+
 @end
 
 #pragma mark - FSTMutationBatchResult
@@ -168,6 +168,21 @@ NS_SWIFT_NAME(Firestore)
  */
 - (void)disableNetworkWithCompletion:(nullable void (^)(NSError *_Nullable error))completion;
 
+/**
+ * Loads the Firestore bundle at `fileURL` into the local cache. Documents in the bundle are only
+ * applied where they are newer than the cached ones, and active listeners raise events for them.
+ * The completion block, if provided, is called with the bundle's named queries, which can then be
+ * read from cache with `FIRFirestoreSourceCache`, or with the error that stopped the load.
+ * Documents applied before an error are kept.
+ *
+ * @param fileURL The file URL of the bundle.
+ * @param completion A block called once the bundle has been loaded.
+ */
+- (void)loadBundleAtURL:(NSURL *)fileURL
+             completion:(nullable void (^)(NSDictionary<NSString *, FIRQuery *> *_Nullable queries,
+                                           NSError *_Nullable error))completion
+    NS_SWIFT_NAME(loadBundle(at:completion:));
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -76,6 +76,156 @@ NS_SWIFT_NAME(FirestoreSettings)
  */
 @property(nonatomic, assign) int64_t cacheSizeBytes;
 
+/**
+ * Whether local persistence collects the changes made close together into one batch and writes
+ * them to disk at once. A crash may lose the changes of the batch that hasn't been written yet,
+ * though never part of a single change. Writes are always on disk before they're sent to the
+ * backend. Has no effect unless persistence is enabled. Defaults to false.
+ */
+@property(nonatomic, getter=isGroupCommitEnabled) BOOL groupCommitEnabled;
+
+/**
+ * Whether every write to local persistence is synced to disk before it completes, which protects
+ * recent writes from operating system crashes at a significant cost in latency. Has no effect
+ * unless persistence is enabled. Defaults to false.
+ */
+@property(nonatomic, getter=areSyncWritesEnabled) BOOL syncWritesEnabled;
+
+/**
+ * The capacity of the cache local persistence keeps of recently read disk blocks, or 0 for
+ * the storage engine's default (8MB). Has no effect unless persistence is enabled. Cannot be
+ * negative.
+ */
+@property(nonatomic, assign) int64_t blockCacheSizeBytes;
+
+/**
+ * Whether local persistence keeps bloom filters with its data on disk, which speed up looking up
+ * documents that aren't cached. Has no effect unless persistence is enabled. Defaults to false.
+ */
+@property(nonatomic, getter=isBloomFilterEnabled) BOOL bloomFilterEnabled;
+
+/**
+ * How much data local persistence collects in memory before sorting it into a file on disk, or
+ * 0 for the storage engine's default (4MB). Has no effect unless persistence is enabled. Cannot
+ * be negative.
+ */
+@property(nonatomic, assign) int64_t writeBufferSizeBytes;
+
+/**
+ * Whether reads from local persistence verify the checksums of the data they read from disk, so
+ * that corrupt data is reported rather than returned. Has no effect unless persistence is
+ * enabled. Defaults to true.
+ */
+@property(nonatomic, getter=isVerifyChecksumsEnabled) BOOL verifyChecksumsEnabled;
+
+/**
+ * The largest encoded size of the pending writes that are sent to the backend together in a
+ * single request, or 0 to send every write batch in a request of its own. Cannot be negative.
+ */
+@property(nonatomic, assign) int64_t maxCoalescedWriteBytes;
+
+/**
+ * Whether repeated writes to the same document are merged into one while they wait to be sent to
+ * the backend, so that a document changed many times while offline is only sent once. Defaults to
+ * false.
+ */
+@property(nonatomic, getter=isMutationCompactionEnabled) BOOL mutationCompactionEnabled;
+
+/**
+ * Whether the messages sent to the backend are compressed with gzip. Responses are compressed
+ * whenever the backend chooses to, regardless of this setting. Defaults to false.
+ */
+@property(nonatomic, getter=isCompressionEnabled) BOOL compressionEnabled;
+
+/**
+ * Whether the connection to the backend is set up as soon as the Firestore instance starts,
+ * instead of when the first listen or write needs it, which takes the connection setup off the
+ * latency of that first request. Defaults to false.
+ */
+@property(nonatomic, getter=isPreconnectEnabled) BOOL preconnectEnabled;
+
+/**
+ * Whether local persistence finishes the schema migrations that only build indexes in the
+ * background after Firestore starts, instead of before it can be used, which shortens the first
+ * start after an upgrade. Has no effect unless persistence is enabled. Defaults to false.
+ */
+@property(nonatomic, getter=areDeferredMigrationsEnabled) BOOL deferredMigrationsEnabled;
+
+/**
+ * Whether the memory cache used when persistence is disabled keeps documents after they're no
+ * longer listened to, evicting the least recently used ones once it outgrows `cacheSizeBytes`,
+ * instead of dropping them right away. Defaults to false.
+ */
+@property(nonatomic, getter=isMemoryCacheLRUEnabled) BOOL memoryCacheLRUEnabled;
+
+/**
+ * Whether this instance shares its worker queue and its cache of recently read disk blocks with
+ * the app's other Firestore instances that share them too, instead of each having its own. The
+ * block cache is sized by the first instance to open it. Defaults to false.
+ */
+@property(nonatomic, getter=areSharedResourcesEnabled) BOOL sharedResourcesEnabled;
+
+/**
+ * The estimated memory use of the caches and views of this instance above which it drops the
+ * cached data it can recompute from persistence, or 0 for no limit. Cannot be negative.
+ */
+@property(nonatomic, assign) int64_t memorySoftLimitBytes;
+
+/**
+ * How long, in seconds, an operation on Firestore's internal queue may run before Firestore logs
+ * a warning with diagnostics about its state, or 0 to never warn. Cannot be negative.
+ */
+@property(nonatomic, assign) NSTimeInterval slowOperationThreshold;
+
+/**
+ * Whether a listened query takes its results from another listened query, instead of being
+ * listened to on its own, when the other query only differs by a larger limit or returns every
+ * document in the same collection. Defaults to false.
+ */
+@property(nonatomic, getter=areSharedViewsEnabled) BOOL sharedViewsEnabled;
+
+/**
+ * Whether group commit writes its batches to disk from a queue of its own, so that writing them
+ * doesn't hold up Firestore's other work. Has no effect unless `groupCommitEnabled` is set and
+ * persistence is enabled. Defaults to false.
+ */
+@property(nonatomic, getter=areBackgroundWritesEnabled) BOOL backgroundWritesEnabled;
+
+/**
+ * Whether listeners see a local write before its changes are written to local persistence,
+ * rather than after. A write is still persisted before it's sent to the backend. If the app
+ * crashes or local persistence fails in between, listeners may have been shown a write that is
+ * never persisted or sent. Has no effect unless persistence is enabled. Defaults to false.
+ */
+@property(nonatomic, getter=areOptimisticWritesEnabled) BOOL optimisticWritesEnabled;
+
+/**
+ * Whether local persistence reads its files through memory maps and compacts them at a low
+ * priority, which suits mobile devices better than the storage engine's defaults. Has no effect
+ * unless persistence is enabled. Defaults to false.
+ */
+@property(nonatomic, getter=isMobileStorageTuningEnabled) BOOL mobileStorageTuningEnabled;
+
+/**
+ * The size at which local persistence starts a new data file, or 0 for the storage engine's
+ * default (2MB). Larger files mean fewer files to keep open in large caches, at the cost of
+ * longer compactions. Has no effect unless persistence is enabled. Cannot be negative.
+ */
+@property(nonatomic, assign) int64_t maxStorageFileSizeBytes;
+
+/**
+ * The most files local persistence keeps open, or 0 for the storage engine's default (1000).
+ * Has no effect unless persistence is enabled. Cannot be negative.
+ */
+@property(nonatomic, assign) int64_t maxOpenFiles;
+
+/**
+ * Whether local persistence may be shared with other processes, like an app's extensions.
+ * A process that finds it open in another starts from a copy of it rather than failing to
+ * start. Has no effect unless persistence is enabled. Defaults to false.
+ */
+@property(nonatomic, getter=isMultiProcessPersistenceEnabled) BOOL multiProcessPersistenceEnabled;
+
 @end
 
 NS_ASSUME_NONNULL_END
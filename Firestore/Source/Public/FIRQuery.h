@@ -341,6 +341,18 @@ addSnapshotListenerWithIncludeMetadataChanges:(BOOL)includeMetadataChanges
  */
 - (FIRQuery *)queryLimitedTo:(NSInteger)limit NS_SWIFT_NAME(limit(to:));
 
+#pragma mark - Selecting Fields
+/**
+ * Creates and returns a new `FIRQuery` whose result documents only contain the given fields, along
+ * with any fields the query is ordered by. Documents are still filtered on all of their fields.
+ *
+ * @param fields An array of `NSString` field names or `FIRFieldPath`s to include in the results.
+ *     Must not be empty.
+ *
+ * @return The created `FIRQuery`.
+ */
+- (FIRQuery *)queryBySelectingFields:(NSArray<id> *)fields NS_SWIFT_NAME(select(_:));
+
 #pragma mark - Choosing Endpoints
 /**
  * Creates and returns a new `FIRQuery` that starts at the provided document (inclusive). The
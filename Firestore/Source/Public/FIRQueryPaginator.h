@@ -0,0 +1,68 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class FIRQuery;
+@class FIRQuerySnapshot;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Pages through the results of a query, `pageSize` documents at a time, the way an infinite-scroll
+ * UI would with `startAfter(lastDocument).limit(pageSize)` queries.
+ *
+ * Once a page has been delivered, the paginator starts listening to the query for the following
+ * page in the background. Listens to the same query share a target, so by the time that page is
+ * requested its target is usually open and synced, and the page is delivered without waiting for
+ * a round trip. Only the next page is prefetched, and its listener is removed once it has been
+ * delivered.
+ */
+NS_SWIFT_NAME(QueryPaginator)
+@interface FIRQueryPaginator : NSObject
+
+/**
+ * Creates a paginator over the results of `query`.
+ *
+ * @param query The query to page through. It must be ordered, so that each page starts after the
+ *     last document of the one before it.
+ * @param pageSize The maximum number of documents in each page. Must be positive.
+ */
+- (instancetype)initWithQuery:(FIRQuery *)query
+                     pageSize:(NSInteger)pageSize NS_DESIGNATED_INITIALIZER;
+
+/** :nodoc: */
+- (instancetype)init NS_UNAVAILABLE;
+
+/** Whether a page after the ones delivered so far may have documents. */
+@property(nonatomic, assign, readonly) BOOL hasNextPage;
+
+/**
+ * Gets the next page of documents. The completion receives a nil page (and no error) once there
+ * are no pages left. Pages must be requested one at a time.
+ *
+ * @param completion A block to execute once the page has been fetched.
+ */
+- (void)getNextPageWithCompletion:(void (^)(FIRQuerySnapshot *_Nullable page,
+                                            NSError *_Nullable error))completion
+    NS_SWIFT_NAME(getNextPage(completion:));
+
+/** Stops prefetching the next page. */
+- (void)stop;
+
+@end
+
+NS_ASSUME_NONNULL_END
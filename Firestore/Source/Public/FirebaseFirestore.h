@@ -26,6 +26,7 @@
 #import "FIRGeoPoint.h"
 #import "FIRListenerRegistration.h"
 #import "FIRQuery.h"
+#import "FIRQueryPaginator.h"
 #import "FIRQuerySnapshot.h"
 #import "FIRSnapshotMetadata.h"
 #import "FIRTimestamp.h"
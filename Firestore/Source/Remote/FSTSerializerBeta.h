@@ -65,6 +65,9 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (instancetype)initWithDatabaseID:(const model::DatabaseId *)databaseID NS_DESIGNATED_INITIALIZER;
 
+/** The database the serializer encodes for. Not owned by the serializer. */
+@property(nonatomic, assign, readonly) const model::DatabaseId *databaseID;
+
 - (GPBTimestamp *)encodedTimestamp:(const firebase::Timestamp &)timestamp;
 - (firebase::Timestamp)decodedTimestamp:(GPBTimestamp *)timestamp;
 
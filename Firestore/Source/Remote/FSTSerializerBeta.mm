@@ -85,11 +85,6 @@ using firebase::firestore::remote::WatchTargetChangeState;
 
 NS_ASSUME_NONNULL_BEGIN
 
-@interface FSTSerializerBeta ()
-// Does not own this DatabaseId.
-@property(nonatomic, assign, readonly) const DatabaseId *databaseID;
-@end
-
 @implementation FSTSerializerBeta
 
 - (instancetype)initWithDatabaseID:(const DatabaseId *)databaseID {
@@ -816,6 +811,10 @@ NS_ASSUME_NONNULL_BEGIN
     queryTarget.structuredQuery.endAt = [self encodedBound:query.endAt];
   }
 
+  // The projection is deliberately not sent as StructuredQuery.select: the documents Watch sends
+  // land in the remote document cache that every query shares, and queries filter on all of a
+  // document's fields. Views trim documents to the projection instead, see FSTView.
+
   return queryTarget;
 }
 
@@ -872,7 +871,8 @@ NS_ASSUME_NONNULL_BEGIN
                                 orderBy:orderBy
                                   limit:limit
                                 startAt:startAt
-                                  endAt:endAt];
+                                  endAt:endAt
+                             projection:nullptr];
 }
 
 #pragma mark Filters
@@ -1216,6 +1216,8 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (std::unique_ptr<WatchChange>)decodedExistenceFilterWatchChange:(GCFSExistenceFilter *)filter {
+  // The generated protos don't include the `unchanged_names` bloom filter yet, so filters decoded
+  // here only carry a count and mismatches are resolved by resetting the target.
   ExistenceFilter existenceFilter{filter.count};
   TargetId targetID = filter.targetId;
   return absl::make_unique<ExistenceFilterWatchChange>(existenceFilter, targetID);
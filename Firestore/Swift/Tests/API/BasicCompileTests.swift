@@ -45,6 +45,7 @@ func main() {
 
   readDocuments(matching: query)
   readDocumentsWithSource(matching: query)
+  readPages(of: query)
 
   listenToDocument(at: documentRef)
 
@@ -273,6 +274,18 @@ func readDocumentsWithSource(matching query: Query) {
   }
 }
 
+func readPages(of query: Query) {
+  let paginator = QueryPaginator(query: query, pageSize: 50)
+  if paginator.hasNextPage {
+    paginator.getNextPage { page, error in
+      for document in page?.documents ?? [] {
+        print(document.data())
+      }
+    }
+  }
+  paginator.stop()
+}
+
 func listenToDocument(at docRef: DocumentReference) {
   let listener = docRef.addSnapshotListener { document, error in
     if let error = error {
@@ -23,7 +23,9 @@
 
 #import <Foundation/Foundation.h>
 
+#include <map>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
 #include <utility>
 
@@ -58,7 +60,8 @@ class DocumentSnapshot {
       : firestore_{firestore},
         internal_key_{std::move(document_key)},
         internal_document_{document},
-        metadata_{std::move(metadata)} {
+        metadata_{std::move(metadata)},
+        converted_values_{std::make_shared<ConvertedValues>()} {
   }
 
   DocumentSnapshot(std::shared_ptr<Firestore> firestore,
@@ -69,7 +72,8 @@ class DocumentSnapshot {
       : firestore_{firestore},
         internal_key_{std::move(document_key)},
         internal_document_{document},
-        metadata_{has_pending_writes, from_cache} {
+        metadata_{has_pending_writes, from_cache},
+        converted_values_{std::make_shared<ConvertedValues>()} {
   }
 
   size_t Hash() const;
@@ -89,8 +93,27 @@ class DocumentSnapshot {
   DocumentReference CreateReference() const;
 
   FSTObjectValue* _Nullable GetData() const;
+
+  /**
+   * Returns the value at `field_path`, found by walking the document's data
+   * one segment at a time, or nil if there's none. An empty path returns all
+   * of the data.
+   */
   id _Nullable GetValue(const model::FieldPath& field_path) const;
 
+  /**
+   * Returns the value at `field_path` (all of the data for an empty path) as
+   * converted by `convert`, or nil if there's none. `convert` only sees that
+   * value, so reading one field never converts the rest of the document.
+   *
+   * Conversions are memoized per snapshot and `behavior`, and shared by copies
+   * of the snapshot, so reading the same field again returns the same object.
+   * This is safe to call from any thread.
+   */
+  id _Nullable GetConvertedValue(const model::FieldPath& field_path,
+                                 ServerTimestampBehavior behavior,
+                                 id (^convert)(FSTFieldValue* value)) const;
+
   const std::shared_ptr<Firestore>& firestore() const {
     return firestore_;
   }
@@ -103,6 +126,12 @@ class DocumentSnapshot {
   model::DocumentKey internal_key_;
   FSTDocument* internal_document_ = nil;
   SnapshotMetadata metadata_;
+
+  struct ConvertedValues {
+    std::mutex mutex;
+    std::map<std::pair<ServerTimestampBehavior, model::FieldPath>, id> values;
+  };
+  std::shared_ptr<ConvertedValues> converted_values_;
 };
 
 }  // namespace api
@@ -16,6 +16,8 @@
 
 #include "Firestore/core/src/firebase/firestore/api/document_snapshot.h"
 
+#include <utility>
+
 #import "Firestore/Source/API/FIRDocumentReference+Internal.h"
 #import "Firestore/Source/Model/FSTDocument.h"
 
@@ -53,6 +55,35 @@ id _Nullable DocumentSnapshot::GetValue(const FieldPath& field_path) const {
   return [[internal_document_ data] valueForPath:field_path];
 }
 
+id _Nullable DocumentSnapshot::GetConvertedValue(
+    const FieldPath& field_path,
+    ServerTimestampBehavior behavior,
+    id (^convert)(FSTFieldValue* value)) const {
+  FSTFieldValue* value = GetValue(field_path);
+  if (value == nil) {
+    return nil;
+  }
+  if (!converted_values_) {
+    return convert(value);
+  }
+
+  auto key = std::make_pair(behavior, field_path);
+  {
+    std::lock_guard<std::mutex> lock{converted_values_->mutex};
+    auto found = converted_values_->values.find(key);
+    if (found != converted_values_->values.end()) {
+      return found->second;
+    }
+  }
+
+  // Convert without holding the lock, and keep the first conversion if another
+  // thread finished one in the meantime.
+  id converted = convert(value);
+  std::lock_guard<std::mutex> lock{converted_values_->mutex};
+  return converted_values_->values.emplace(std::move(key), converted)
+      .first->second;
+}
+
 bool operator==(const DocumentSnapshot& lhs, const DocumentSnapshot& rhs) {
   return lhs.firestore_ == rhs.firestore_ &&
          lhs.internal_key_ == rhs.internal_key_ &&
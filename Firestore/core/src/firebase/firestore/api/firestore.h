@@ -23,18 +23,24 @@
 
 #import <Foundation/Foundation.h>
 
+#include <functional>
+#include <map>
 #include <memory>
 #include <mutex>  // NOLINT(build/c++11)
 #include <string>
 #include <utility>
+#include <vector>
 #include "dispatch/dispatch.h"
 
 #include "Firestore/core/src/firebase/firestore/api/settings.h"
+#include "Firestore/core/src/firebase/firestore/api/source.h"
 #include "Firestore/core/src/firebase/firestore/auth/credentials_provider.h"
 #include "Firestore/core/src/firebase/firestore/core/transaction.h"
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/metrics_registry.h"
+#include "Firestore/core/src/firebase/firestore/util/path.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor_callback.h"
 #include "absl/types/any.h"
@@ -48,12 +54,21 @@ NS_ASSUME_NONNULL_BEGIN
 @class FIRTransaction;
 @class FIRWriteBatch;
 @class FSTFirestoreClient;
+@class FSTQuery;
 
 namespace firebase {
 namespace firestore {
+
+namespace remote {
+
+struct NetworkMetrics;
+
+}  // namespace remote
+
 namespace api {
 
 class DocumentReference;
+class DocumentSnapshot;
 
 class Firestore : public std::enable_shared_from_this<Firestore> {
  public:
@@ -97,6 +112,17 @@ class Firestore : public std::enable_shared_from_this<Firestore> {
   FIRWriteBatch* GetBatch();
   FIRQuery* GetCollectionGroup(NSString* collection_id);
 
+  /**
+   * Reads all of the given documents at once: the local cache is read once
+   * and, unless `source` is `Source::Cache`, the backend is asked for all of
+   * them in a single lookup. The snapshots are passed to `callback` on the
+   * user executor, in the order of `documents`.
+   */
+  void GetAll(
+      std::vector<DocumentReference> documents,
+      Source source,
+      util::StatusOrCallback<std::vector<DocumentSnapshot>> callback);
+
   void RunTransaction(core::TransactionUpdateCallback update_callback,
                       core::TransactionResultCallback result_callback);
 
@@ -105,6 +131,31 @@ class Firestore : public std::enable_shared_from_this<Firestore> {
   void EnableNetwork(util::StatusCallback callback);
   void DisableNetwork(util::StatusCallback callback);
 
+  /**
+   * Loads the bundle file at `path` into the local cache and invokes
+   * `callback` with the queries it names, or with the error that stopped it.
+   */
+  void LoadBundle(
+      const util::Path& path,
+      util::StatusOrCallback<std::map<std::string, FSTQuery*>> callback);
+
+  /**
+   * Invokes `callback` on the user executor with the network counters and
+   * latencies (bytes and messages per stream, token fetch, time to first
+   * response, backoff and write acknowledgement latencies) collected so far.
+   */
+  void GetNetworkMetrics(
+      std::function<void(const remote::NetworkMetrics&)> callback);
+
+  /**
+   * Returns the current value of the counters, gauges and latency histograms
+   * the core records into as it runs: listens and writes handled by the sync
+   * engine, watch changes, local store queries and remote events, LevelDB
+   * commits and garbage collections. These are shared by every Firestore
+   * instance in the process and can be polled from any thread.
+   */
+  util::MetricsSnapshot GetMetrics() const;
+
  private:
   void EnsureClientConfigured();
 
@@ -26,6 +26,8 @@
 #import "Firestore/Source/Core/FSTQuery.h"
 
 #include "Firestore/core/src/firebase/firestore/api/document_reference.h"
+#include "Firestore/core/src/firebase/firestore/api/document_snapshot.h"
+#include "Firestore/core/src/firebase/firestore/api/input_validation.h"
 #include "Firestore/core/src/firebase/firestore/api/settings.h"
 #include "Firestore/core/src/firebase/firestore/auth/firebase_credentials_provider_apple.h"
 #include "Firestore/core/src/firebase/firestore/core/transaction.h"
@@ -127,6 +129,23 @@ FIRQuery* Firestore::GetCollectionGroup(NSString* collection_id) {
                          firestore:wrapper];
 }
 
+void Firestore::GetAll(
+    std::vector<DocumentReference> documents,
+    Source source,
+    util::StatusOrCallback<std::vector<DocumentSnapshot>> callback) {
+  EnsureClientConfigured();
+  for (const DocumentReference& document : documents) {
+    if (document.firestore().get() != this) {
+      ThrowInvalidArgument("Provided document reference is from a different "
+                           "Firestore instance.");
+    }
+  }
+
+  [client_ getDocuments:std::move(documents)
+                 source:source
+               callback:std::move(callback)];
+}
+
 void Firestore::RunTransaction(
     core::TransactionUpdateCallback update_callback,
     core::TransactionResultCallback result_callback) {
@@ -159,6 +178,23 @@ void Firestore::DisableNetwork(util::StatusCallback callback) {
   [client_ disableNetworkWithCallback:std::move(callback)];
 }
 
+void Firestore::LoadBundle(
+    const util::Path& path,
+    util::StatusOrCallback<std::map<std::string, FSTQuery*>> callback) {
+  EnsureClientConfigured();
+  [client_ loadBundleAtPath:path callback:std::move(callback)];
+}
+
+void Firestore::GetNetworkMetrics(
+    std::function<void(const remote::NetworkMetrics&)> callback) {
+  EnsureClientConfigured();
+  [client_ getNetworkMetricsWithCallback:std::move(callback)];
+}
+
+util::MetricsSnapshot Firestore::GetMetrics() const {
+  return util::MetricsRegistry::Default().Snapshot();
+}
+
 void Firestore::EnsureClientConfigured() {
   std::lock_guard<std::mutex> lock{mutex_};
 
@@ -26,6 +26,7 @@
 #include <functional>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/api/document_change.h"
 #include "Firestore/core/src/firebase/firestore/api/document_snapshot.h"
@@ -93,6 +94,9 @@ class QuerySnapshot {
   /**
    * Iterates over the `DocumentChanges` representing the changes between
    * the prior snapshot and this one.
+   *
+   * Snapshots raised by a changes-only listener carry no documents, so their
+   * changes report `DocumentChange::npos` for both the old and new index.
    */
   void ForEachChange(bool include_metadata_changes,
                      const std::function<void(DocumentChange)>& callback) const;
@@ -100,10 +104,26 @@ class QuerySnapshot {
   friend bool operator==(const QuerySnapshot& lhs, const QuerySnapshot& rhs);
 
  private:
+  struct ChangeIndexes {
+    size_t old_index;
+    size_t new_index;
+  };
+
+  /**
+   * Returns the old and new index of each of the snapshot's document changes,
+   * computing them on first use. Computing the indexes replays the changes
+   * against the old documents, so this is only done once per snapshot no
+   * matter how often (or with which `include_metadata_changes`) the changes
+   * are read.
+   */
+  const std::vector<ChangeIndexes>& GetChangeIndexes() const;
+
   std::shared_ptr<Firestore> firestore_;
   FSTQuery* internal_query_ = nil;
   core::ViewSnapshot snapshot_;
   SnapshotMetadata metadata_;
+
+  mutable std::shared_ptr<const std::vector<ChangeIndexes>> change_indexes_;
 };
 
 }  // namespace api
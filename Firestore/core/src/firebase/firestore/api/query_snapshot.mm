@@ -17,6 +17,7 @@
 #include "Firestore/core/src/firebase/firestore/api/query_snapshot.h"
 
 #include <utility>
+#include <vector>
 
 #import "Firestore/Source/API/FIRDocumentChange+Internal.h"
 #import "Firestore/Source/API/FIRDocumentSnapshot+Internal.h"
@@ -45,9 +46,9 @@ using core::ViewSnapshot;
 using model::DocumentSet;
 
 bool operator==(const QuerySnapshot& lhs, const QuerySnapshot& rhs) {
-  return lhs.firestore_ == rhs.firestore_ &&
+  return lhs.firestore_ == rhs.firestore_ && lhs.metadata_ == rhs.metadata_ &&
          objc::Equals(lhs.internal_query_, rhs.internal_query_) &&
-         lhs.snapshot_ == rhs.snapshot_ && lhs.metadata_ == rhs.metadata_;
+         lhs.snapshot_ == rhs.snapshot_;
 }
 
 size_t QuerySnapshot::Hash() const {
@@ -82,28 +83,30 @@ static DocumentChange::Type DocumentChangeTypeForChange(
   HARD_FAIL("Unknown DocumentViewChange::Type: %s", change.type());
 }
 
-void QuerySnapshot::ForEachChange(
-    bool include_metadata_changes,
-    const std::function<void(DocumentChange)>& callback) const {
-  if (include_metadata_changes && snapshot_.excludes_metadata_changes()) {
-    ThrowInvalidArgument("To include metadata changes with your document "
-                         "changes, you must call "
-                         "addSnapshotListener(includeMetadataChanges:true).");
+const std::vector<QuerySnapshot::ChangeIndexes>&
+QuerySnapshot::GetChangeIndexes() const {
+  if (change_indexes_) {
+    return *change_indexes_;
   }
 
-  if (snapshot_.old_documents().empty()) {
+  const std::vector<DocumentViewChange>& changes =
+      snapshot_.document_changes();
+  std::vector<ChangeIndexes> result;
+  result.reserve(changes.size());
+
+  if (snapshot_.changes_only()) {
+    // Changes-only snapshots carry no document sets, so there is nothing to
+    // compute indexes against.
+    result.assign(changes.size(),
+                  ChangeIndexes{DocumentChange::npos, DocumentChange::npos});
+
+  } else if (snapshot_.old_documents().empty()) {
     // Special case the first snapshot because index calculation is easy and
     // fast. Also all changes on the first snapshot are adds so there are also
     // no metadata-only changes to filter out.
     FSTDocument* last_document = nil;
     size_t index = 0;
-    for (const DocumentViewChange& change : snapshot_.document_changes()) {
-      FSTDocument* doc = change.document();
-      SnapshotMetadata metadata(
-          /*pending_writes=*/snapshot_.mutated_keys().contains(doc.key),
-          /*from_cache=*/snapshot_.from_cache());
-      DocumentSnapshot document(firestore_, doc.key, doc, metadata);
-
+    for (const DocumentViewChange& change : changes) {
       HARD_ASSERT(change.type() == DocumentViewChange::Type::kAdded,
                   "Invalid event type for first snapshot");
       HARD_ASSERT(!last_document || snapshot_.query().comparator(
@@ -111,26 +114,16 @@ void QuerySnapshot::ForEachChange(
                                         NSOrderedAscending,
                   "Got added events in wrong order");
 
-      callback(DocumentChange(DocumentChange::Type::Added, std::move(document),
-                              DocumentChange::npos, index++));
+      result.push_back(ChangeIndexes{DocumentChange::npos, index++});
     }
 
   } else {
     // A DocumentSet that is updated incrementally as changes are applied to use
-    // to lookup the index of a document.
+    // to lookup the index of a document. Metadata-only changes never move a
+    // document, so the indexes computed here hold whether or not the caller
+    // filters those changes out.
     DocumentSet index_tracker = snapshot_.old_documents();
-    for (const DocumentViewChange& change : snapshot_.document_changes()) {
-      if (!include_metadata_changes &&
-          change.type() == DocumentViewChange::Type::kMetadata) {
-        continue;
-      }
-
-      FSTDocument* doc = change.document();
-      SnapshotMetadata metadata(
-          /*pending_writes=*/snapshot_.mutated_keys().contains(doc.key),
-          /*from_cache=*/snapshot_.from_cache());
-      DocumentSnapshot document(firestore_, doc.key, doc, metadata);
-
+    for (const DocumentViewChange& change : changes) {
       size_t old_index = DocumentChange::npos;
       size_t new_index = DocumentChange::npos;
       if (change.type() != DocumentViewChange::Type::kAdded) {
@@ -144,10 +137,44 @@ void QuerySnapshot::ForEachChange(
         new_index = index_tracker.IndexOf(change.document().key);
       }
 
-      DocumentChange::Type type = DocumentChangeTypeForChange(change);
-      callback(DocumentChange(type, std::move(document), old_index, new_index));
+      result.push_back(ChangeIndexes{old_index, new_index});
     }
   }
+
+  change_indexes_ = std::make_shared<const std::vector<ChangeIndexes>>(
+      std::move(result));
+  return *change_indexes_;
+}
+
+void QuerySnapshot::ForEachChange(
+    bool include_metadata_changes,
+    const std::function<void(DocumentChange)>& callback) const {
+  if (include_metadata_changes && snapshot_.excludes_metadata_changes()) {
+    ThrowInvalidArgument("To include metadata changes with your document "
+                         "changes, you must call "
+                         "addSnapshotListener(includeMetadataChanges:true).");
+  }
+
+  const std::vector<DocumentViewChange>& changes =
+      snapshot_.document_changes();
+  const std::vector<ChangeIndexes>& indexes = GetChangeIndexes();
+  for (size_t i = 0; i < changes.size(); ++i) {
+    const DocumentViewChange& change = changes[i];
+    if (!include_metadata_changes &&
+        change.type() == DocumentViewChange::Type::kMetadata) {
+      continue;
+    }
+
+    FSTDocument* doc = change.document();
+    SnapshotMetadata metadata(
+        /*pending_writes=*/snapshot_.mutated_keys().contains(doc.key),
+        /*from_cache=*/snapshot_.from_cache());
+    DocumentSnapshot document(firestore_, doc.key, doc, metadata);
+
+    DocumentChange::Type type = DocumentChangeTypeForChange(change);
+    callback(DocumentChange(type, std::move(document), indexes[i].old_index,
+                            indexes[i].new_index));
+  }
 }
 
 }  // namespace api
@@ -24,7 +24,18 @@ namespace api {
 
 size_t Settings::Hash() const {
   return util::Hash(host_, ssl_enabled_, persistence_enabled_,
-                    timestamps_in_snapshots_enabled_, cache_size_bytes_);
+                    timestamps_in_snapshots_enabled_, cache_size_bytes_,
+                    group_commit_enabled_, sync_writes_enabled_,
+                    block_cache_size_bytes_, bloom_filter_enabled_,
+                    write_buffer_size_bytes_, verify_checksums_enabled_,
+                    max_coalesced_write_bytes_, mutation_compaction_enabled_,
+                    compression_enabled_, preconnect_enabled_,
+                    deferred_migrations_enabled_, memory_lru_gc_enabled_,
+                    shared_resources_enabled_, memory_soft_limit_bytes_,
+                    slow_operation_threshold_ms_, shared_views_enabled_,
+                    background_writes_enabled_, optimistic_writes_enabled_,
+                    mobile_leveldb_env_enabled_, max_table_file_size_bytes_,
+                    max_open_files_, shared_cache_enabled_);
 }
 
 bool operator==(const Settings& lhs, const Settings& rhs) {
@@ -32,7 +43,29 @@ bool operator==(const Settings& lhs, const Settings& rhs) {
          lhs.persistence_enabled_ == rhs.persistence_enabled_ &&
          lhs.timestamps_in_snapshots_enabled_ ==
              rhs.timestamps_in_snapshots_enabled_ &&
-         lhs.cache_size_bytes_ == rhs.cache_size_bytes_;
+         lhs.cache_size_bytes_ == rhs.cache_size_bytes_ &&
+         lhs.group_commit_enabled_ == rhs.group_commit_enabled_ &&
+         lhs.sync_writes_enabled_ == rhs.sync_writes_enabled_ &&
+         lhs.block_cache_size_bytes_ == rhs.block_cache_size_bytes_ &&
+         lhs.bloom_filter_enabled_ == rhs.bloom_filter_enabled_ &&
+         lhs.write_buffer_size_bytes_ == rhs.write_buffer_size_bytes_ &&
+         lhs.verify_checksums_enabled_ == rhs.verify_checksums_enabled_ &&
+         lhs.max_coalesced_write_bytes_ == rhs.max_coalesced_write_bytes_ &&
+         lhs.mutation_compaction_enabled_ == rhs.mutation_compaction_enabled_ &&
+         lhs.compression_enabled_ == rhs.compression_enabled_ &&
+         lhs.preconnect_enabled_ == rhs.preconnect_enabled_ &&
+         lhs.deferred_migrations_enabled_ == rhs.deferred_migrations_enabled_ &&
+         lhs.memory_lru_gc_enabled_ == rhs.memory_lru_gc_enabled_ &&
+         lhs.shared_resources_enabled_ == rhs.shared_resources_enabled_ &&
+         lhs.memory_soft_limit_bytes_ == rhs.memory_soft_limit_bytes_ &&
+         lhs.slow_operation_threshold_ms_ == rhs.slow_operation_threshold_ms_ &&
+         lhs.shared_views_enabled_ == rhs.shared_views_enabled_ &&
+         lhs.background_writes_enabled_ == rhs.background_writes_enabled_ &&
+         lhs.optimistic_writes_enabled_ == rhs.optimistic_writes_enabled_ &&
+         lhs.mobile_leveldb_env_enabled_ == rhs.mobile_leveldb_env_enabled_ &&
+         lhs.max_table_file_size_bytes_ == rhs.max_table_file_size_bytes_ &&
+         lhs.max_open_files_ == rhs.max_open_files_ &&
+         lhs.shared_cache_enabled_ == rhs.shared_cache_enabled_;
 }
 
 }  // namespace api
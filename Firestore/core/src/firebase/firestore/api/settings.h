@@ -69,6 +69,249 @@ class Settings {
     return cache_size_bytes_;
   }
 
+  /**
+   * Whether LevelDB persistence merges the transactions that commit during a
+   * single drain of the worker queue into one write.
+   */
+  void set_group_commit_enabled(bool value) {
+    group_commit_enabled_ = value;
+  }
+  bool group_commit_enabled() const {
+    return group_commit_enabled_;
+  }
+
+  /**
+   * Whether group commit writes its batches to LevelDB from a queue of their
+   * own instead of the worker queue.
+   */
+  void set_background_writes_enabled(bool value) {
+    background_writes_enabled_ = value;
+  }
+  bool background_writes_enabled() const {
+    return background_writes_enabled_;
+  }
+
+  /** Whether LevelDB persistence syncs every write to disk. */
+  void set_sync_writes_enabled(bool value) {
+    sync_writes_enabled_ = value;
+  }
+  bool sync_writes_enabled() const {
+    return sync_writes_enabled_;
+  }
+
+  /**
+   * The capacity of the LevelDB block cache, or 0 to use LevelDB's default.
+   */
+  void set_block_cache_size_bytes(int64_t value) {
+    block_cache_size_bytes_ = value;
+  }
+  int64_t block_cache_size_bytes() const {
+    return block_cache_size_bytes_;
+  }
+
+  /**
+   * Whether LevelDB keeps bloom filters, which speed up lookups of absent
+   * keys.
+   */
+  void set_bloom_filter_enabled(bool value) {
+    bloom_filter_enabled_ = value;
+  }
+  bool bloom_filter_enabled() const {
+    return bloom_filter_enabled_;
+  }
+
+  /**
+   * The size of the LevelDB write buffer, or 0 to use LevelDB's default.
+   */
+  void set_write_buffer_size_bytes(int64_t value) {
+    write_buffer_size_bytes_ = value;
+  }
+  int64_t write_buffer_size_bytes() const {
+    return write_buffer_size_bytes_;
+  }
+
+  /** Whether reads from LevelDB verify checksums. */
+  void set_verify_checksums_enabled(bool value) {
+    verify_checksums_enabled_ = value;
+  }
+  bool verify_checksums_enabled() const {
+    return verify_checksums_enabled_;
+  }
+
+  /**
+   * The largest encoded size of the pending writes packed into a single
+   * request to the backend, or 0 to send every write batch on its own.
+   */
+  void set_max_coalesced_write_bytes(int64_t value) {
+    max_coalesced_write_bytes_ = value;
+  }
+  int64_t max_coalesced_write_bytes() const {
+    return max_coalesced_write_bytes_;
+  }
+
+  /**
+   * Whether repeated writes to the same document are merged in the mutation
+   * queue while they wait to be sent.
+   */
+  void set_mutation_compaction_enabled(bool value) {
+    mutation_compaction_enabled_ = value;
+  }
+  bool mutation_compaction_enabled() const {
+    return mutation_compaction_enabled_;
+  }
+
+  /**
+   * Whether the messages sent to the backend are gzip-compressed. Responses
+   * are compressed whenever the backend chooses to, regardless of this option.
+   */
+  void set_compression_enabled(bool value) {
+    compression_enabled_ = value;
+  }
+  bool compression_enabled() const {
+    return compression_enabled_;
+  }
+
+  /**
+   * Whether the connection to the backend is set up as soon as the client
+   * starts, instead of when it's first needed.
+   */
+  void set_preconnect_enabled(bool value) {
+    preconnect_enabled_ = value;
+  }
+  bool preconnect_enabled() const {
+    return preconnect_enabled_;
+  }
+
+  /**
+   * Whether LevelDB persistence finishes the migrations that only backfill
+   * indexes in the background after the client starts, instead of before.
+   */
+  void set_deferred_migrations_enabled(bool value) {
+    deferred_migrations_enabled_ = value;
+  }
+  bool deferred_migrations_enabled() const {
+    return deferred_migrations_enabled_;
+  }
+
+  /**
+   * Whether memory persistence keeps documents after they're no longer
+   * referenced, evicting the least recently used ones once the cache outgrows
+   * `cache_size_bytes`, instead of dropping them right away.
+   */
+  void set_memory_lru_gc_enabled(bool value) {
+    memory_lru_gc_enabled_ = value;
+  }
+  bool memory_lru_gc_enabled() const {
+    return memory_lru_gc_enabled_;
+  }
+
+  /**
+   * Whether the client shares its worker dispatch queue and LevelDB block
+   * cache with the clients of the app's other Firestore instances that share
+   * them too. The block cache is sized by the first client to open it.
+   */
+  void set_shared_resources_enabled(bool value) {
+    shared_resources_enabled_ = value;
+  }
+  bool shared_resources_enabled() const {
+    return shared_resources_enabled_;
+  }
+
+  /**
+   * The estimated memory use above which the client drops the documents it
+   * can recompute from persistence, or 0 for no limit.
+   */
+  void set_memory_soft_limit_bytes(int64_t value) {
+    memory_soft_limit_bytes_ = value;
+  }
+  int64_t memory_soft_limit_bytes() const {
+    return memory_soft_limit_bytes_;
+  }
+
+  /**
+   * How long an operation on the worker queue may run before the client logs
+   * a warning with diagnostics about its state, or 0 to never warn.
+   */
+  void set_slow_operation_threshold_ms(int64_t value) {
+    slow_operation_threshold_ms_ = value;
+  }
+  int64_t slow_operation_threshold_ms() const {
+    return slow_operation_threshold_ms_;
+  }
+
+  /**
+   * Whether a listened query takes its results from another listened query's
+   * view, instead of getting a target and view of its own, when the other query
+   * only differs by a larger limit or is an unfiltered query on the same
+   * collection.
+   */
+  void set_shared_views_enabled(bool value) {
+    shared_views_enabled_ = value;
+  }
+  bool shared_views_enabled() const {
+    return shared_views_enabled_;
+  }
+
+  /**
+   * Whether a local write raises its latency compensated snapshots before its
+   * changes are written to LevelDB, rather than after.
+   *
+   * Those snapshots may describe a write that is never persisted: if the
+   * process dies before the changes are written, the write is lost, and its
+   * completion is never called.
+   */
+  void set_optimistic_writes_enabled(bool value) {
+    optimistic_writes_enabled_ = value;
+  }
+  bool optimistic_writes_enabled() const {
+    return optimistic_writes_enabled_;
+  }
+
+  /**
+   * Whether LevelDB persistence reads its tables through memory maps and
+   * compacts at a low priority, using a leveldb::Env tuned for mobile devices.
+   */
+  void set_mobile_leveldb_env_enabled(bool value) {
+    mobile_leveldb_env_enabled_ = value;
+  }
+  bool mobile_leveldb_env_enabled() const {
+    return mobile_leveldb_env_enabled_;
+  }
+
+  /**
+   * The size LevelDB persistence starts a new table file at, or 0 for
+   * LevelDB's default (2MB).
+   */
+  void set_max_table_file_size_bytes(int64_t value) {
+    max_table_file_size_bytes_ = value;
+  }
+  int64_t max_table_file_size_bytes() const {
+    return max_table_file_size_bytes_;
+  }
+
+  /**
+   * The most files LevelDB persistence keeps open, or 0 for LevelDB's default
+   * (1000).
+   */
+  void set_max_open_files(int64_t value) {
+    max_open_files_ = value;
+  }
+  int64_t max_open_files() const {
+    return max_open_files_;
+  }
+
+  /**
+   * Whether LevelDB persistence may be shared with other processes, like an
+   * app's extensions. Those that find it open elsewhere start from a copy of
+   * it rather than failing to start.
+   */
+  void set_shared_cache_enabled(bool value) {
+    shared_cache_enabled_ = value;
+  }
+  bool shared_cache_enabled() const {
+    return shared_cache_enabled_;
+  }
+
   friend bool operator==(const Settings& lhs, const Settings& rhs);
 
   size_t Hash() const;
@@ -79,6 +322,28 @@ class Settings {
   bool persistence_enabled_ = false;
   bool timestamps_in_snapshots_enabled_ = false;
   int64_t cache_size_bytes_ = 0;
+  bool group_commit_enabled_ = false;
+  bool background_writes_enabled_ = false;
+  bool sync_writes_enabled_ = false;
+  int64_t block_cache_size_bytes_ = 0;
+  bool bloom_filter_enabled_ = false;
+  int64_t write_buffer_size_bytes_ = 0;
+  bool verify_checksums_enabled_ = true;
+  int64_t max_coalesced_write_bytes_ = 0;
+  bool mutation_compaction_enabled_ = false;
+  bool compression_enabled_ = false;
+  bool preconnect_enabled_ = false;
+  bool deferred_migrations_enabled_ = false;
+  bool memory_lru_gc_enabled_ = false;
+  bool shared_resources_enabled_ = false;
+  int64_t memory_soft_limit_bytes_ = 0;
+  int64_t slow_operation_threshold_ms_ = 0;
+  bool shared_views_enabled_ = false;
+  bool optimistic_writes_enabled_ = false;
+  bool mobile_leveldb_env_enabled_ = false;
+  int64_t max_table_file_size_bytes_ = 0;
+  int64_t max_open_files_ = 0;
+  bool shared_cache_enabled_ = false;
 };
 
 }  // namespace api
@@ -0,0 +1,160 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_BULK_WRITER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_BULK_WRITER_H_
+
+#if !defined(__OBJC__)
+#error "This header only supports Objective-C++"
+#endif  // !defined(__OBJC__)
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/rate_limiter.h"
+#include "Firestore/core/src/firebase/firestore/core/user_data.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/remote/datastore.h"
+#include "Firestore/core/src/firebase/firestore/remote/exponential_backoff.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class FSTMutation;
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+/**
+ * Sends an unbounded number of independent writes straight to the backend,
+ * for tasks like data migrations that write much more than a WriteBatch
+ * can hold.
+ *
+ * Writes are grouped into batches that are committed independently: several
+ * commits are kept in flight at once, subject to a rate limit that ramps up
+ * over time, and batches that fail with a transient error are retried with
+ * backoff. Unlike writes through the sync engine, bulk writes skip the local
+ * mutation queue: they aren't persisted, don't show up in the local view of
+ * documents until the backend sends them back, and are lost if the client
+ * shuts down before they are committed.
+ *
+ * Since each commit is atomic, a write that fails permanently would take the
+ * other writes in its batch down with it; such batches are split up and their
+ * writes retried one at a time, so that only the failing writes are dropped.
+ *
+ * All methods must be called on the worker queue.
+ */
+class BulkWriter : public std::enable_shared_from_this<BulkWriter> {
+ public:
+  /** The maximum number of writes committed together. */
+  static constexpr size_t kMaxBatchSize = 20;
+
+  /** The maximum number of commits in flight at any time. */
+  static constexpr size_t kMaxPendingBatches = 10;
+
+  /** The maximum number of times a batch is sent before giving up. */
+  static constexpr int kMaxAttempts = 10;
+
+  static std::shared_ptr<BulkWriter> Create(remote::Datastore* datastore,
+                                            util::AsyncQueue* worker_queue);
+
+  ~BulkWriter();
+
+  /** Overwrites the document with the given key with `data`. */
+  void Set(const model::DocumentKey& key, ParsedSetData&& data);
+
+  /** Updates the existing document with the given key with `data`. */
+  void Update(const model::DocumentKey& key, ParsedUpdateData&& data);
+
+  /** Deletes the document with the given key. */
+  void Delete(const model::DocumentKey& key);
+
+  /**
+   * Sends all writes made so far, without waiting for a batch to fill up, and
+   * invokes `callback` once none are left. The status passed to the callback
+   * is the first permanent error writes have failed with since the previous
+   * flush, or OK if they all succeeded.
+   */
+  void Flush(util::StatusCallback&& callback);
+
+ private:
+  struct Batch {
+    std::vector<FSTMutation*> mutations;
+
+    /**
+     * The number of mutations for each write in the batch: a set with field
+     * transforms takes two mutations, which have to be committed together.
+     */
+    std::vector<size_t> write_sizes;
+
+    int attempts = 0;
+  };
+
+  BulkWriter(remote::Datastore* datastore, util::AsyncQueue* worker_queue);
+
+  /** Adds the mutations of a single write to the batch being filled. */
+  void AddWrite(std::vector<FSTMutation*>&& mutations);
+
+  /** Moves the batch being filled to the queue of batches ready to send. */
+  void SealBatch();
+
+  /** Commits ready batches for as long as the limits allow. */
+  void SendBatches();
+
+  /** Schedules SendBatches to run after the given delay. */
+  void ScheduleSendBatches(RateLimiter::Milliseconds delay);
+
+  void HandleCommitResult(Batch batch, const util::Status& status);
+
+  /** Splits a failed batch into one batch per write, to be sent first. */
+  void SplitBatch(Batch batch);
+
+  void RecordError(const util::Status& status);
+
+  /** Invokes the flush callbacks if no writes are left. */
+  void MaybeFinishFlush();
+
+  remote::Datastore* datastore_ = nullptr;
+  util::AsyncQueue* worker_queue_ = nullptr;
+
+  RateLimiter rate_limiter_;
+  remote::ExponentialBackoff backoff_;
+
+  Batch current_batch_;
+  std::deque<Batch> ready_batches_;
+  size_t pending_batches_ = 0;
+
+  /** Whether SendBatches is scheduled to run once the rate limit allows. */
+  bool send_scheduled_ = false;
+  util::DelayedOperation scheduled_send_;
+
+  /** Whether sending is paused until the backoff after a failure is over. */
+  bool backing_off_ = false;
+
+  util::Status first_error_;
+  std::vector<util::StatusCallback> flush_callbacks_;
+};
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_BULK_WRITER_H_
@@ -0,0 +1,246 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/bulk_writer.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <utility>
+
+#import "Firestore/Source/Model/FSTMutation.h"
+
+#include "Firestore/core/include/firebase/firestore/firestore_errors.h"
+#include "Firestore/core/src/firebase/firestore/model/precondition.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/log.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+namespace chr = std::chrono;
+
+using model::DocumentKey;
+using model::Precondition;
+using remote::Datastore;
+using util::AsyncQueue;
+using util::Status;
+using util::TimerId;
+
+namespace {
+
+/**
+ * The rate limit starts at 500 writes per second and grows by 50% every 5
+ * minutes, following the guidance for ramping up traffic.
+ */
+const double kInitialOpsPerSecond = 500;
+const double kMaxOpsPerSecond = 10000;
+const auto kRateLimitRampInterval = chr::minutes(5);
+
+const double kBackoffFactor = 1.5;
+const AsyncQueue::Milliseconds kBackoffInitialDelay{1000};
+const AsyncQueue::Milliseconds kBackoffMaxDelay{60 * 1000};
+
+}  // namespace
+
+constexpr size_t BulkWriter::kMaxBatchSize;
+constexpr size_t BulkWriter::kMaxPendingBatches;
+constexpr int BulkWriter::kMaxAttempts;
+
+std::shared_ptr<BulkWriter> BulkWriter::Create(Datastore* datastore,
+                                               AsyncQueue* worker_queue) {
+  return std::shared_ptr<BulkWriter>(new BulkWriter(datastore, worker_queue));
+}
+
+BulkWriter::BulkWriter(Datastore* datastore, AsyncQueue* worker_queue)
+    : datastore_{NOT_NULL(datastore)},
+      worker_queue_{NOT_NULL(worker_queue)},
+      rate_limiter_{kInitialOpsPerSecond, kMaxOpsPerSecond,
+                    kRateLimitRampInterval},
+      backoff_{worker_queue, TimerId::BulkWriterRetry, kBackoffFactor,
+               kBackoffInitialDelay, kBackoffMaxDelay} {
+}
+
+BulkWriter::~BulkWriter() {
+  backoff_.Cancel();
+  scheduled_send_.Cancel();
+}
+
+void BulkWriter::Set(const DocumentKey& key, ParsedSetData&& data) {
+  AddWrite(std::move(data).ToMutations(key, Precondition::None()));
+}
+
+void BulkWriter::Update(const DocumentKey& key, ParsedUpdateData&& data) {
+  AddWrite(std::move(data).ToMutations(key, Precondition::Exists(true)));
+}
+
+void BulkWriter::Delete(const DocumentKey& key) {
+  AddWrite({[[FSTDeleteMutation alloc] initWithKey:key
+                                      precondition:Precondition::None()]});
+}
+
+void BulkWriter::Flush(util::StatusCallback&& callback) {
+  worker_queue_->VerifyIsCurrentQueue();
+
+  flush_callbacks_.push_back(std::move(callback));
+  SealBatch();
+  SendBatches();
+  MaybeFinishFlush();
+}
+
+void BulkWriter::AddWrite(std::vector<FSTMutation*>&& mutations) {
+  worker_queue_->VerifyIsCurrentQueue();
+
+  current_batch_.write_sizes.push_back(mutations.size());
+  std::move(mutations.begin(), mutations.end(),
+            std::back_inserter(current_batch_.mutations));
+
+  if (current_batch_.write_sizes.size() >= kMaxBatchSize) {
+    SealBatch();
+    SendBatches();
+  }
+}
+
+void BulkWriter::SealBatch() {
+  if (current_batch_.write_sizes.empty()) {
+    return;
+  }
+  ready_batches_.push_back(std::move(current_batch_));
+  current_batch_ = Batch{};
+}
+
+void BulkWriter::SendBatches() {
+  if (send_scheduled_ || backing_off_) {
+    return;
+  }
+
+  while (!ready_batches_.empty() && pending_batches_ < kMaxPendingBatches) {
+    Batch& next = ready_batches_.front();
+    int ops = static_cast<int>(next.write_sizes.size());
+    if (!rate_limiter_.TryMakeRequest(ops)) {
+      ScheduleSendBatches(rate_limiter_.GetNextRequestDelay(ops));
+      return;
+    }
+
+    Batch batch = std::move(next);
+    ready_batches_.pop_front();
+    ++batch.attempts;
+    ++pending_batches_;
+
+    std::weak_ptr<BulkWriter> weak_this = shared_from_this();
+    std::vector<FSTMutation*> mutations = batch.mutations;
+    datastore_->CommitMutations(
+        mutations, [weak_this, batch](const Status& status) {
+          if (auto strong_this = weak_this.lock()) {
+            strong_this->HandleCommitResult(batch, status);
+          }
+        });
+  }
+}
+
+void BulkWriter::ScheduleSendBatches(RateLimiter::Milliseconds delay) {
+  send_scheduled_ = true;
+
+  std::weak_ptr<BulkWriter> weak_this = shared_from_this();
+  scheduled_send_ = worker_queue_->EnqueueAfterDelay(
+      delay, TimerId::BulkWriterRateLimit, [weak_this] {
+        if (auto strong_this = weak_this.lock()) {
+          strong_this->send_scheduled_ = false;
+          strong_this->SendBatches();
+        }
+      });
+}
+
+void BulkWriter::HandleCommitResult(Batch batch, const Status& status) {
+  --pending_batches_;
+
+  if (status.ok()) {
+    backoff_.Reset();
+
+  } else if (!Datastore::IsPermanentWriteError(status) &&
+             batch.attempts < kMaxAttempts) {
+    LOG_DEBUG("BulkWriter retrying a batch of %s writes after error: %s",
+              batch.write_sizes.size(), status.ToString());
+    if (status.code() == FirestoreErrorCode::ResourceExhausted) {
+      backoff_.ResetToMax();
+    }
+    ready_batches_.push_front(std::move(batch));
+
+    if (!backing_off_) {
+      backing_off_ = true;
+      std::weak_ptr<BulkWriter> weak_this = shared_from_this();
+      backoff_.BackoffAndRun([weak_this] {
+        if (auto strong_this = weak_this.lock()) {
+          strong_this->backing_off_ = false;
+          strong_this->SendBatches();
+        }
+      });
+    }
+    return;
+
+  } else if (batch.write_sizes.size() > 1 &&
+             Datastore::IsPermanentWriteError(status)) {
+    // One of the writes may have failed the whole batch, so find out which.
+    SplitBatch(std::move(batch));
+
+  } else {
+    RecordError(status);
+  }
+
+  SendBatches();
+  MaybeFinishFlush();
+}
+
+void BulkWriter::SplitBatch(Batch batch) {
+  std::deque<Batch> writes;
+  auto mutation = batch.mutations.begin();
+  for (size_t write_size : batch.write_sizes) {
+    Batch write;
+    write.write_sizes.push_back(write_size);
+    write.mutations.assign(mutation, mutation + write_size);
+    mutation += write_size;
+    writes.push_back(std::move(write));
+  }
+
+  ready_batches_.insert(ready_batches_.begin(),
+                        std::make_move_iterator(writes.begin()),
+                        std::make_move_iterator(writes.end()));
+}
+
+void BulkWriter::RecordError(const Status& status) {
+  LOG_WARN("BulkWriter failed to commit writes: %s", status.ToString());
+  if (first_error_.ok()) {
+    first_error_ = status;
+  }
+}
+
+void BulkWriter::MaybeFinishFlush() {
+  if (flush_callbacks_.empty() || !ready_batches_.empty() ||
+      pending_batches_ > 0) {
+    return;
+  }
+
+  std::vector<util::StatusCallback> callbacks = std::move(flush_callbacks_);
+  flush_callbacks_.clear();
+  Status status = first_error_;
+  first_error_ = Status::OK();
+  for (const util::StatusCallback& callback : callbacks) {
+    callback(status);
+  }
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
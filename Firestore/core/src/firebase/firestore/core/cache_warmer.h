@@ -0,0 +1,132 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_CACHE_WARMER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_CACHE_WARMER_H_
+
+#if !defined(__OBJC__)
+#error "This header only supports Objective-C++"
+#endif  // !defined(__OBJC__)
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <deque>
+#include <memory>
+
+#include "Firestore/core/src/firebase/firestore/core/query_listener.h"
+#include "Firestore/core/src/firebase/firestore/core/rate_limiter.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/objc_compatibility.h"
+#include "absl/types/optional.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class FSTEventManager;
+@class FSTQuery;
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+/** How up to date the cached results of a query kept in sync are. */
+struct CacheFreshness {
+  /** Whether the background listen for the query has been started yet. */
+  bool is_listening = false;
+
+  /** Whether the cached results are in sync with the backend right now. */
+  bool is_synced = false;
+
+  /**
+   * When the cached results were last in sync with the backend since the
+   * query started being kept in sync, or nothing if they haven't been yet.
+   */
+  absl::optional<std::chrono::system_clock::time_point> last_synced_at;
+};
+
+/**
+ * Keeps the cached results of queries fresh by listening to them in the
+ * background, with no snapshot listener attached, so that a screen that
+ * listens to one of them later gets its first snapshot from an up to date
+ * cache.
+ *
+ * A warmed query is listened to like any other: it shares its target with
+ * identical user queries, the watch stream resumes it from its resume token,
+ * and LRU garbage collection leaves its target and documents alone. Since
+ * nothing waits on them, the listens are started at a limited rate that ramps
+ * up over time, from operations that yield to interactive work.
+ *
+ * All methods must be called on the worker queue.
+ */
+class CacheWarmer {
+ public:
+  CacheWarmer(FSTEventManager* event_manager, util::AsyncQueue* worker_queue);
+
+  ~CacheWarmer();
+
+  /** Starts keeping `query` in sync, unless it already is. */
+  void KeepSynced(FSTQuery* query);
+
+  /** Stops keeping `query` in sync. Does nothing if it isn't. */
+  void StopKeepingSynced(FSTQuery* query);
+
+  /**
+   * Returns how fresh the cached results of `query` are, or nothing if it
+   * isn't kept in sync.
+   */
+  absl::optional<CacheFreshness> GetFreshness(FSTQuery* query) const;
+
+  /** The number of queries kept in sync. */
+  size_t size() const {
+    return warmed_queries_.size();
+  }
+
+ private:
+  struct WarmedQuery {
+    /** The background listener, or null until the listen is started. */
+    std::shared_ptr<QueryListener> listener;
+
+    /** Updated by `listener` as snapshots arrive. */
+    std::shared_ptr<CacheFreshness> freshness;
+  };
+
+  /** Starts the pending listens for as long as the rate limit allows. */
+  void StartPendingListens();
+
+  /** Schedules StartPendingListens to run after the given delay. */
+  void ScheduleStartPendingListens(RateLimiter::Milliseconds delay);
+
+  std::shared_ptr<QueryListener> CreateListener(
+      FSTQuery* query, std::shared_ptr<CacheFreshness> freshness);
+
+  FSTEventManager* event_manager_ = nil;
+  util::AsyncQueue* worker_queue_ = nullptr;
+
+  util::objc::unordered_map<FSTQuery*, WarmedQuery> warmed_queries_;
+
+  /** The queries whose listens are waiting for the rate limit, in order. */
+  std::deque<FSTQuery*> pending_queries_;
+
+  RateLimiter rate_limiter_;
+  util::DelayedOperation scheduled_start_;
+  bool start_scheduled_ = false;
+};
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_CACHE_WARMER_H_
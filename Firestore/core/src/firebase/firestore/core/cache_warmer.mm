@@ -0,0 +1,188 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/cache_warmer.h"
+
+#include <utility>
+
+#import "Firestore/Source/Core/FSTEventManager.h"
+#import "Firestore/Source/Core/FSTQuery.h"
+
+#include "Firestore/core/src/firebase/firestore/core/listen_options.h"
+#include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
+#include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/metrics_registry.h"
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "absl/algorithm/container.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+namespace chr = std::chrono;
+
+using util::AsyncQueue;
+using util::MetricsRegistry;
+using util::StatusOr;
+using util::TimerId;
+
+namespace {
+
+/**
+ * Background listens start at 5 per second, growing by 50% every minute up to
+ * 50 per second, so that warming many queries at once doesn't flood the watch
+ * stream ahead of the listens of the screen the user is looking at.
+ */
+const double kInitialListensPerSecond = 5;
+const double kMaxListensPerSecond = 50;
+const auto kRateLimitRampInterval = chr::minutes(1);
+
+struct CacheWarmerMetrics {
+  MetricsRegistry::Gauge* warmed_queries =
+      MetricsRegistry::Default().GetGauge("cache_warming.warmed_queries");
+  MetricsRegistry::Counter* listens_started =
+      MetricsRegistry::Default().GetCounter("cache_warming.listens_started");
+};
+
+CacheWarmerMetrics& Metrics() {
+  static CacheWarmerMetrics metrics;
+  return metrics;
+}
+
+}  // namespace
+
+CacheWarmer::CacheWarmer(FSTEventManager* event_manager,
+                         AsyncQueue* worker_queue)
+    : event_manager_{event_manager},
+      worker_queue_{worker_queue},
+      rate_limiter_{kInitialListensPerSecond, kMaxListensPerSecond,
+                    kRateLimitRampInterval} {
+}
+
+CacheWarmer::~CacheWarmer() {
+  scheduled_start_.Cancel();
+}
+
+void CacheWarmer::KeepSynced(FSTQuery* query) {
+  auto inserted = warmed_queries_.emplace(
+      query, WarmedQuery{nullptr, std::make_shared<CacheFreshness>()});
+  if (!inserted.second) {
+    return;
+  }
+
+  Metrics().warmed_queries->Add(1);
+  pending_queries_.push_back(query);
+  StartPendingListens();
+}
+
+void CacheWarmer::StopKeepingSynced(FSTQuery* query) {
+  auto found = warmed_queries_.find(query);
+  if (found == warmed_queries_.end()) {
+    return;
+  }
+
+  if (found->second.listener) {
+    [event_manager_ removeListener:found->second.listener];
+  } else {
+    auto pending = absl::c_find_if(pending_queries_, [query](FSTQuery* other) {
+      return [query isEqual:other];
+    });
+    if (pending != pending_queries_.end()) {
+      pending_queries_.erase(pending);
+    }
+  }
+
+  warmed_queries_.erase(found);
+  Metrics().warmed_queries->Add(-1);
+}
+
+absl::optional<CacheFreshness> CacheWarmer::GetFreshness(
+    FSTQuery* query) const {
+  auto found = warmed_queries_.find(query);
+  if (found == warmed_queries_.end()) {
+    return absl::nullopt;
+  }
+  return *found->second.freshness;
+}
+
+void CacheWarmer::StartPendingListens() {
+  if (start_scheduled_) {
+    return;
+  }
+
+  while (!pending_queries_.empty()) {
+    if (worker_queue_->ShouldYield()) {
+      ScheduleStartPendingListens(RateLimiter::Milliseconds::zero());
+      return;
+    }
+    if (!rate_limiter_.TryMakeRequest(1)) {
+      ScheduleStartPendingListens(rate_limiter_.GetNextRequestDelay(1));
+      return;
+    }
+
+    FSTQuery* query = pending_queries_.front();
+    pending_queries_.pop_front();
+
+    WarmedQuery& warmed = warmed_queries_.at(query);
+    warmed.freshness->is_listening = true;
+    warmed.listener = CreateListener(query, warmed.freshness);
+    [event_manager_ addListener:warmed.listener];
+    Metrics().listens_started->Increment();
+  }
+}
+
+void CacheWarmer::ScheduleStartPendingListens(
+    RateLimiter::Milliseconds delay) {
+  start_scheduled_ = true;
+  scheduled_start_ = worker_queue_->EnqueueAfterDelay(
+      delay, TimerId::CacheWarmingRateLimit, [this] {
+        start_scheduled_ = false;
+        StartPendingListens();
+      });
+}
+
+std::shared_ptr<QueryListener> CacheWarmer::CreateListener(
+    FSTQuery* query, std::shared_ptr<CacheFreshness> freshness) {
+  // Metadata changes are needed to see the results go in and out of sync.
+  // Nothing reads the documents, so the snapshots don't have to carry them.
+  ListenOptions options =
+      ListenOptions(/*include_query_metadata_changes=*/true,
+                    /*include_document_metadata_changes=*/false,
+                    /*wait_for_sync_when_online=*/false)
+          .WithChangesOnly(true);
+
+  return QueryListener::Create(
+      query, std::move(options),
+      [freshness, query](const StatusOr<ViewSnapshot>& maybe_snapshot) {
+        if (!maybe_snapshot.ok()) {
+          // The backend rejected the target, which ends the listen.
+          LOG_WARN("Stopped keeping query %s in sync: %s", query.canonicalID,
+                   maybe_snapshot.status().ToString());
+          freshness->is_listening = false;
+          freshness->is_synced = false;
+          return;
+        }
+
+        freshness->is_synced = !maybe_snapshot.ValueOrDie().from_cache();
+        if (freshness->is_synced) {
+          freshness->last_synced_at = chr::system_clock::now();
+        }
+      });
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
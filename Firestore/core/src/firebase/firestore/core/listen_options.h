@@ -17,6 +17,8 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_LISTEN_OPTIONS_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_LISTEN_OPTIONS_H_
 
+#include <chrono>  // NOLINT(build/c++11)
+
 namespace firebase {
 namespace firestore {
 namespace core {
@@ -78,10 +80,45 @@ class ListenOptions {
     return wait_for_sync_when_online_;
   }
 
+  /**
+   * Returns a copy of these options that limits the rate of events: after an
+   * event is raised, the snapshots that arrive within `window` are merged into
+   * a single event raised at the end of the window.
+   *
+   * A zero window (the default) raises an event for every snapshot.
+   */
+  ListenOptions WithSnapshotCoalescingWindow(
+      std::chrono::milliseconds window) const {
+    ListenOptions result = *this;
+    result.snapshot_coalescing_window_ = window;
+    return result;
+  }
+
+  std::chrono::milliseconds snapshot_coalescing_window() const {
+    return snapshot_coalescing_window_;
+  }
+
+  /**
+   * Returns a copy of these options that raises changes-only snapshots (see
+   * ViewSnapshot::WithoutDocuments()), for listeners that only consume the
+   * document changes and keep their own copy of the results.
+   */
+  ListenOptions WithChangesOnly(bool changes_only) const {
+    ListenOptions result = *this;
+    result.changes_only_ = changes_only;
+    return result;
+  }
+
+  bool changes_only() const {
+    return changes_only_;
+  }
+
  private:
   bool include_query_metadata_changes_ = false;
   bool include_document_metadata_changes_ = false;
   bool wait_for_sync_when_online_ = false;
+  std::chrono::milliseconds snapshot_coalescing_window_{0};
+  bool changes_only_ = false;
 };
 
 }  // namespace core
@@ -29,6 +29,7 @@
 #include "Firestore/core/src/firebase/firestore/core/listen_options.h"
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor_callback.h"
 #include "absl/types/optional.h"
@@ -45,7 +46,7 @@ namespace core {
  * QueryListener takes a series of internal view snapshots and determines when
  * to raise user-facing events.
  */
-class QueryListener {
+class QueryListener : public std::enable_shared_from_this<QueryListener> {
  public:
   static std::shared_ptr<QueryListener> Create(
       FSTQuery* query,
@@ -93,6 +94,15 @@ class QueryListener {
     return snapshot_;
   }
 
+  /**
+   * Sets the queue this listener receives snapshots on, which is required to
+   * coalesce snapshots (see ListenOptions::WithSnapshotCoalescingWindow()).
+   * Without a queue every snapshot raises an event as soon as it arrives.
+   */
+  void set_worker_queue(util::AsyncQueue* worker_queue) {
+    worker_queue_ = worker_queue;
+  }
+
   virtual void OnViewSnapshot(ViewSnapshot snapshot);
   virtual void OnError(util::Status error);
   virtual void OnOnlineStateChanged(model::OnlineState online_state);
@@ -100,8 +110,15 @@ class QueryListener {
  private:
   bool ShouldRaiseInitialEvent(const ViewSnapshot& snapshot,
                                model::OnlineState online_state) const;
-  bool ShouldRaiseEvent(const ViewSnapshot& snapshot) const;
+  bool ShouldRaiseEvent(const ViewSnapshot& snapshot,
+                        bool has_pending_writes_changed) const;
   void RaiseInitialEvent(const ViewSnapshot& snapshot);
+  void RaiseEvent(ViewSnapshot snapshot);
+
+  bool IsCoalescing() const;
+  void CoalesceSnapshot(ViewSnapshot snapshot);
+  void StartCoalescingWindow();
+  void OnCoalescingWindowEnd();
 
   FSTQuery* query_ = nil;
   ListenOptions options_;
@@ -123,6 +140,25 @@ class QueryListener {
   model::OnlineState online_state_ = model::OnlineState::Unknown;
 
   absl::optional<ViewSnapshot> snapshot_;
+
+  util::AsyncQueue* worker_queue_ = nullptr;
+
+  /**
+   * Whether an event was raised within the current coalescing window, in which
+   * case later snapshots are merged into `coalesced_snapshot_` until the window
+   * ends.
+   */
+  bool in_coalescing_window_ = false;
+  util::DelayedOperation coalescing_window_end_;
+
+  /** The merged snapshots received since the last event, if any. */
+  absl::optional<ViewSnapshot> coalesced_snapshot_;
+
+  /**
+   * Whether the snapshot before the first of the coalesced ones had pending
+   * writes, to tell whether the merged snapshot changes that.
+   */
+  bool coalesced_has_pending_writes_ = false;
 };
 
 }  // namespace core
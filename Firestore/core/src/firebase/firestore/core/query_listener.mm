@@ -35,6 +35,38 @@ using model::OnlineState;
 using model::TargetId;
 using util::MakeStatus;
 using util::Status;
+using util::TimerId;
+
+namespace {
+
+/**
+ * Merges two consecutive snapshots into one that goes straight from the
+ * documents before `earlier` to the documents of `later`.
+ */
+ViewSnapshot MergeSnapshots(const ViewSnapshot& earlier,
+                            const ViewSnapshot& later) {
+  DocumentViewChangeSet change_set;
+  for (const DocumentViewChange& change : earlier.document_changes()) {
+    change_set.AddChange(DocumentViewChange{change});
+  }
+  for (const DocumentViewChange& change : later.document_changes()) {
+    change_set.AddChange(DocumentViewChange{change});
+  }
+  std::vector<DocumentViewChange> changes = change_set.GetChanges();
+  SortDocumentViewChanges(later.query(), &changes);
+
+  return ViewSnapshot{later.query(),
+                      later.documents(),
+                      earlier.old_documents(),
+                      std::move(changes),
+                      later.mutated_keys(),
+                      later.from_cache(),
+                      earlier.sync_state_changed() ||
+                          later.sync_state_changed(),
+                      later.excludes_metadata_changes()};
+}
+
+}  // namespace
 
 void QueryListener::OnViewSnapshot(ViewSnapshot snapshot) {
   HARD_ASSERT(
@@ -64,14 +96,25 @@ void QueryListener::OnViewSnapshot(ViewSnapshot snapshot) {
     if (ShouldRaiseInitialEvent(snapshot, online_state_)) {
       RaiseInitialEvent(snapshot);
     }
-  } else if (ShouldRaiseEvent(snapshot)) {
-    listener_->OnEvent(snapshot);
+  } else if (IsCoalescing()) {
+    CoalesceSnapshot(snapshot);
+  } else {
+    bool has_pending_writes_changed =
+        snapshot_.has_value() &&
+        snapshot_->has_pending_writes() != snapshot.has_pending_writes();
+    if (ShouldRaiseEvent(snapshot, has_pending_writes_changed)) {
+      RaiseEvent(snapshot);
+    }
   }
 
   snapshot_ = std::move(snapshot);
 }
 
 void QueryListener::OnError(Status error) {
+  coalescing_window_end_.Cancel();
+  in_coalescing_window_ = false;
+  coalesced_snapshot_.reset();
+
   listener_->OnEvent(std::move(error));
 }
 
@@ -109,7 +152,8 @@ bool QueryListener::ShouldRaiseInitialEvent(const ViewSnapshot& snapshot,
   return !snapshot.documents().empty() || online_state == OnlineState::Offline;
 }
 
-bool QueryListener::ShouldRaiseEvent(const ViewSnapshot& snapshot) const {
+bool QueryListener::ShouldRaiseEvent(const ViewSnapshot& snapshot,
+                                     bool has_pending_writes_changed) const {
   // We don't need to handle include_document_metadata_changes() here because
   // the Metadata only changes have already been stripped out if needed. At this
   // point the only changes we will see are the ones we should propagate.
@@ -117,9 +161,6 @@ bool QueryListener::ShouldRaiseEvent(const ViewSnapshot& snapshot) const {
     return true;
   }
 
-  bool has_pending_writes_changed =
-      snapshot_.has_value() &&
-      snapshot_.value().has_pending_writes() != snapshot.has_pending_writes();
   if (snapshot.sync_state_changed() || has_pending_writes_changed) {
     return options_.include_query_metadata_changes();
   }
@@ -137,7 +178,78 @@ void QueryListener::RaiseInitialEvent(const ViewSnapshot& snapshot) {
       snapshot.query(), snapshot.documents(), snapshot.mutated_keys(),
       snapshot.from_cache(), snapshot.excludes_metadata_changes());
   raised_initial_event_ = true;
-  listener_->OnEvent(std::move(modified_snapshot));
+  RaiseEvent(std::move(modified_snapshot));
+
+  if (IsCoalescing()) {
+    StartCoalescingWindow();
+  }
+}
+
+void QueryListener::RaiseEvent(ViewSnapshot snapshot) {
+  if (options_.changes_only()) {
+    listener_->OnEvent(snapshot.WithoutDocuments());
+  } else {
+    listener_->OnEvent(std::move(snapshot));
+  }
+}
+
+bool QueryListener::IsCoalescing() const {
+  return worker_queue_ != nullptr &&
+         options_.snapshot_coalescing_window().count() > 0;
+}
+
+void QueryListener::CoalesceSnapshot(ViewSnapshot snapshot) {
+  if (!in_coalescing_window_) {
+    // Nothing was raised recently, so there's no reason to wait.
+    bool has_pending_writes_changed =
+        snapshot_.has_value() &&
+        snapshot_->has_pending_writes() != snapshot.has_pending_writes();
+    if (ShouldRaiseEvent(snapshot, has_pending_writes_changed)) {
+      RaiseEvent(std::move(snapshot));
+      StartCoalescingWindow();
+    }
+    return;
+  }
+
+  if (coalesced_snapshot_) {
+    coalesced_snapshot_ = MergeSnapshots(*coalesced_snapshot_, snapshot);
+  } else {
+    coalesced_has_pending_writes_ =
+        snapshot_.has_value() && snapshot_->has_pending_writes();
+    coalesced_snapshot_ = std::move(snapshot);
+  }
+}
+
+void QueryListener::StartCoalescingWindow() {
+  in_coalescing_window_ = true;
+
+  std::weak_ptr<QueryListener> weak_this = shared_from_this();
+  coalescing_window_end_ = worker_queue_->EnqueueAfterDelay(
+      options_.snapshot_coalescing_window(), TimerId::SnapshotCoalescing,
+      [weak_this] {
+        if (auto strong_this = weak_this.lock()) {
+          strong_this->OnCoalescingWindowEnd();
+        }
+      });
+}
+
+void QueryListener::OnCoalescingWindowEnd() {
+  in_coalescing_window_ = false;
+  if (!coalesced_snapshot_) {
+    return;
+  }
+
+  ViewSnapshot snapshot = std::move(*coalesced_snapshot_);
+  coalesced_snapshot_.reset();
+
+  // The merged changes may cancel out (e.g. a document added and then
+  // removed), in which case there's nothing to raise.
+  bool has_pending_writes_changed =
+      coalesced_has_pending_writes_ != snapshot.has_pending_writes();
+  if (ShouldRaiseEvent(snapshot, has_pending_writes_changed)) {
+    RaiseEvent(std::move(snapshot));
+    StartCoalescingWindow();
+  }
 }
 
 }  // namespace core
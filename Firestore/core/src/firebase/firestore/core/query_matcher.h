@@ -0,0 +1,148 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_QUERY_MATCHER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_QUERY_MATCHER_H_
+
+#if !defined(__OBJC__)
+#error "This header only supports Objective-C++"
+#endif  // !defined(__OBJC__)
+
+#import <Foundation/Foundation.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#import "Firestore/Source/Model/FSTFieldValue.h"
+
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+
+@class FSTBound;
+@class FSTDocument;
+@class FSTFilter;
+@class FSTQuery;
+@class FSTSortOrder;
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+/**
+ * The constraints of an FSTQuery compiled into a flat program, for matching
+ * many documents against the same query. Matches(document) is equivalent to
+ * -[FSTQuery matchesDocument:].
+ *
+ * Each distinct field path the query constrains is looked up once per
+ * document, using field names wrapped ahead of time, and all the filters and
+ * orderBys on that field are then checked against the one value. Comparisons
+ * are specialized for the type of the filter value, falling back to the
+ * generic -[FSTFieldValue compare:] only for documents whose value has a
+ * different representation.
+ */
+class QueryMatcher {
+ public:
+  explicit QueryMatcher(FSTQuery* query);
+
+  /** Returns true if the document matches the constraints of the query. */
+  bool Matches(FSTDocument* document) const;
+
+ private:
+  enum class PathMatch {
+    /** The document's path equals the query's path. */
+    Document,
+    /** The document is an immediate child of the query's path. */
+    Collection,
+    /** The document is in a collection with the right ID below the path. */
+    CollectionGroup,
+  };
+
+  enum class Opcode {
+    /** Matches any value; the field only has to exist (an orderBy). */
+    Exists,
+    IsNull,
+    IsNaN,
+    ArrayContains,
+    CompareInteger,
+    CompareDouble,
+    CompareString,
+    /** Compares values of the operand's type order by -compare:. */
+    Compare,
+  };
+
+  struct Instruction {
+    Opcode opcode = Opcode::Exists;
+
+    /**
+     * The comparison results that satisfy the filter, as a bitmask with a bit
+     * for each NSComparisonResult (see AcceptsComparison).
+     */
+    int accepted = 0;
+
+    FSTFieldValue* _Nullable operand = nil;
+    FSTTypeOrder operand_type_order = FSTTypeOrderNull;
+    int64_t integer_operand = 0;
+    double double_operand = 0;
+    std::string string_operand;
+  };
+
+  /** The instructions constraining a single field path. */
+  struct FieldProgram {
+    std::vector<NSString*> segments;
+    std::vector<Instruction> instructions;
+  };
+
+  /** The instructions for filters on the document key. */
+  struct KeyInstruction {
+    int accepted;
+    model::DocumentKey key;
+  };
+
+  /** Adds an instruction for the field at `path`, grouping it by path. */
+  void AddInstruction(const model::FieldPath& path, Instruction instruction);
+
+  void AddFilter(FSTFilter* filter);
+
+  bool MatchesPath(FSTDocument* document) const;
+  bool MatchesFields(FSTDocument* document) const;
+  bool MatchesBounds(FSTDocument* document) const;
+
+  static bool Execute(const Instruction& instruction, FSTFieldValue* value);
+
+  PathMatch path_match_;
+  model::ResourcePath path_;
+  std::string collection_group_;
+
+  std::vector<model::FieldPath> field_paths_;
+  std::vector<FieldProgram> fields_;
+  std::vector<KeyInstruction> key_instructions_;
+
+  NSArray<FSTSortOrder*>* sort_orders_;
+  FSTBound* _Nullable start_at_;
+  FSTBound* _Nullable end_at_;
+};
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_QUERY_MATCHER_H_
@@ -0,0 +1,363 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/query_matcher.h"
+
+#import <objc/runtime.h>
+
+#include <cmath>
+#include <string>
+#include <utility>
+
+#import "Firestore/Source/Core/FSTQuery.h"
+#import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Model/FSTDocumentKey.h"
+
+#include "Firestore/core/src/firebase/firestore/core/filter.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/util/comparison.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+namespace {
+
+using model::DocumentKey;
+using model::FieldPath;
+using model::FieldValue;
+using util::CompareMixedNumber;
+using util::ReverseOrder;
+using util::WrapCompare;
+
+/** Returns the bit that represents `comparison` in an accepted bitmask. */
+constexpr int ComparisonBit(NSComparisonResult comparison) {
+  return 1 << (comparison + 1);
+}
+
+/** Returns the bitmask of comparison results that satisfy `op`. */
+int AcceptedComparisons(Filter::Operator op) {
+  switch (op) {
+    case Filter::Operator::LessThan:
+      return ComparisonBit(NSOrderedAscending);
+    case Filter::Operator::LessThanOrEqual:
+      return ComparisonBit(NSOrderedAscending) | ComparisonBit(NSOrderedSame);
+    case Filter::Operator::Equal:
+      return ComparisonBit(NSOrderedSame);
+    case Filter::Operator::GreaterThanOrEqual:
+      return ComparisonBit(NSOrderedSame) | ComparisonBit(NSOrderedDescending);
+    case Filter::Operator::GreaterThan:
+      return ComparisonBit(NSOrderedDescending);
+    case Filter::Operator::ArrayContains:
+      break;
+  }
+  HARD_FAIL("Unknown operator: %s", op);
+}
+
+bool AcceptsComparison(int accepted, NSComparisonResult comparison) {
+  return (accepted & ComparisonBit(comparison)) != 0;
+}
+
+NSComparisonResult WrapComparisonResult(util::ComparisonResult result) {
+  return static_cast<NSComparisonResult>(result);
+}
+
+// The classes of the values that have specialized instructions. Checking for
+// these with object_getClass avoids messaging the value; none of them have
+// subclasses.
+
+Class ObjectValueClass() {
+  static Class cls = [FSTObjectValue class];
+  return cls;
+}
+
+Class ArrayValueClass() {
+  static Class cls = [FSTArrayValue class];
+  return cls;
+}
+
+Class IntegerValueClass() {
+  static Class cls = [FSTIntegerValue class];
+  return cls;
+}
+
+Class DoubleValueClass() {
+  static Class cls = [FSTDoubleValue class];
+  return cls;
+}
+
+Class DelegateValueClass() {
+  static Class cls = [FSTDelegateValue class];
+  return cls;
+}
+
+}  // namespace
+
+QueryMatcher::QueryMatcher(FSTQuery* query)
+    : path_(query.path),
+      sort_orders_(query.sortOrders),
+      start_at_(query.startAt),
+      end_at_(query.endAt) {
+  if (query.collectionGroup) {
+    path_match_ = PathMatch::CollectionGroup;
+    collection_group_ = util::MakeString(query.collectionGroup);
+  } else if (model::DocumentKey::IsDocumentKey(path_)) {
+    path_match_ = PathMatch::Document;
+  } else {
+    path_match_ = PathMatch::Collection;
+  }
+
+  // A document must have a value for every ordering clause in order to show
+  // up in the results. Ordering by key always matches.
+  for (FSTSortOrder* order_by in query.explicitSortOrders) {
+    if (!order_by.field.IsKeyFieldPath()) {
+      AddInstruction(order_by.field, Instruction{});
+    }
+  }
+
+  for (FSTFilter* filter in query.filters) {
+    AddFilter(filter);
+  }
+}
+
+void QueryMatcher::AddInstruction(const FieldPath& path,
+                                  Instruction instruction) {
+  for (size_t i = 0; i < field_paths_.size(); ++i) {
+    if (field_paths_[i] == path) {
+      fields_[i].instructions.push_back(std::move(instruction));
+      return;
+    }
+  }
+
+  FieldProgram program;
+  for (const std::string& segment : path) {
+    program.segments.push_back(util::WrapNSString(segment));
+  }
+  program.instructions.push_back(std::move(instruction));
+  field_paths_.push_back(path);
+  fields_.push_back(std::move(program));
+}
+
+void QueryMatcher::AddFilter(FSTFilter* filter) {
+  Instruction instruction;
+  if ([filter isKindOfClass:[FSTNullFilter class]]) {
+    instruction.opcode = Opcode::IsNull;
+    instruction.operand = [FSTNullValue nullValue];
+    AddInstruction(filter.field, std::move(instruction));
+    return;
+  }
+  if ([filter isKindOfClass:[FSTNanFilter class]]) {
+    instruction.opcode = Opcode::IsNaN;
+    AddInstruction(filter.field, std::move(instruction));
+    return;
+  }
+
+  HARD_ASSERT([filter isKindOfClass:[FSTRelationFilter class]],
+              "Unknown filter: %s", filter);
+  auto* relation_filter = (FSTRelationFilter*)filter;
+  Filter::Operator op = relation_filter.filterOperator;
+  FSTFieldValue* value = relation_filter.value;
+
+  if (relation_filter.field.IsKeyFieldPath()) {
+    HARD_ASSERT(value.type == FieldValue::Type::Reference,
+                "Comparing on key, but filter value not a FSTReferenceValue.");
+    HARD_ASSERT(op != Filter::Operator::ArrayContains,
+                "arrayContains queries don't make sense on document keys.");
+    FSTReferenceValue* reference = (FSTReferenceValue*)value;
+    key_instructions_.push_back(
+        KeyInstruction{AcceptedComparisons(op), reference.value.key});
+    return;
+  }
+
+  instruction.operand = value;
+  instruction.operand_type_order = value.typeOrder;
+  if (op == Filter::Operator::ArrayContains) {
+    instruction.opcode = Opcode::ArrayContains;
+  } else {
+    instruction.accepted = AcceptedComparisons(op);
+    Class value_class = object_getClass(value);
+    if (value_class == IntegerValueClass()) {
+      instruction.opcode = Opcode::CompareInteger;
+      instruction.integer_operand = ((FSTIntegerValue*)value).internalValue;
+    } else if (value_class == DoubleValueClass()) {
+      instruction.opcode = Opcode::CompareDouble;
+      instruction.double_operand = ((FSTDoubleValue*)value).internalValue;
+    } else if (value_class == DelegateValueClass() &&
+               value.type == FieldValue::Type::String) {
+      instruction.opcode = Opcode::CompareString;
+      instruction.string_operand =
+          ((FSTDelegateValue*)value).internalValue.string_value();
+    } else {
+      instruction.opcode = Opcode::Compare;
+    }
+  }
+  AddInstruction(relation_filter.field, std::move(instruction));
+}
+
+bool QueryMatcher::Matches(FSTDocument* document) const {
+  return MatchesPath(document) && MatchesFields(document) &&
+         MatchesBounds(document);
+}
+
+bool QueryMatcher::MatchesPath(FSTDocument* document) const {
+  const DocumentKey& key = document.key;
+  const model::ResourcePath& document_path = key.path();
+  switch (path_match_) {
+    case PathMatch::Document:
+      // Exact match for document queries.
+      return path_ == document_path;
+    case PathMatch::Collection:
+      // Shallow ancestor queries by default.
+      return document_path.size() == path_.size() + 1 &&
+             path_.IsPrefixOf(document_path);
+    case PathMatch::CollectionGroup:
+      return key.HasCollectionId(collection_group_) &&
+             path_.IsPrefixOf(document_path);
+  }
+  UNREACHABLE();
+}
+
+bool QueryMatcher::MatchesFields(FSTDocument* document) const {
+  if (!key_instructions_.empty()) {
+    const DocumentKey& key = document.key;
+    for (const KeyInstruction& instruction : key_instructions_) {
+      if (!AcceptsComparison(instruction.accepted,
+                             model::CompareKeys(key, instruction.key))) {
+        return false;
+      }
+    }
+  }
+  if (fields_.empty()) {
+    return true;
+  }
+
+  FSTObjectValue* data = document.data;
+  for (const FieldProgram& field : fields_) {
+    FSTFieldValue* _Nullable value = data;
+    for (NSString* segment : field.segments) {
+      if (object_getClass(value) != ObjectValueClass()) {
+        value = nil;
+        break;
+      }
+      value = ((FSTObjectValue*)value).internalValue[segment];
+    }
+
+    // No filter or orderBy matches a document without the field.
+    if (!value) {
+      return false;
+    }
+    for (const Instruction& instruction : field.instructions) {
+      if (!Execute(instruction, value)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool QueryMatcher::MatchesBounds(FSTDocument* document) const {
+  if (start_at_ &&
+      ![start_at_ sortsBeforeDocument:document usingSortOrder:sort_orders_]) {
+    return false;
+  }
+  if (end_at_ &&
+      [end_at_ sortsBeforeDocument:document usingSortOrder:sort_orders_]) {
+    return false;
+  }
+  return true;
+}
+
+bool QueryMatcher::Execute(const Instruction& instruction,
+                           FSTFieldValue* value) {
+  Class value_class = object_getClass(value);
+  NSComparisonResult comparison = NSOrderedSame;
+
+  switch (instruction.opcode) {
+    case Opcode::Exists:
+      return true;
+
+    case Opcode::IsNull:
+      return [value isEqual:instruction.operand];
+
+    case Opcode::IsNaN:
+      return value_class == DoubleValueClass() &&
+             std::isnan(((FSTDoubleValue*)value).internalValue);
+
+    case Opcode::ArrayContains:
+      return value_class == ArrayValueClass() &&
+             [((FSTArrayValue*)value).internalValue
+                 containsObject:instruction.operand];
+
+    case Opcode::CompareInteger:
+      if (value_class == IntegerValueClass()) {
+        int64_t integer_value = ((FSTIntegerValue*)value).internalValue;
+        comparison =
+            WrapCompare<int64_t>(integer_value, instruction.integer_operand);
+        return AcceptsComparison(instruction.accepted, comparison);
+      } else if (value_class == DoubleValueClass()) {
+        comparison = WrapComparisonResult(
+            CompareMixedNumber(((FSTDoubleValue*)value).internalValue,
+                               instruction.integer_operand));
+        return AcceptsComparison(instruction.accepted, comparison);
+      }
+      break;
+
+    case Opcode::CompareDouble:
+      if (value_class == DoubleValueClass()) {
+        double double_value = ((FSTDoubleValue*)value).internalValue;
+        comparison =
+            WrapCompare<double>(double_value, instruction.double_operand);
+        return AcceptsComparison(instruction.accepted, comparison);
+      } else if (value_class == IntegerValueClass()) {
+        comparison = WrapComparisonResult(ReverseOrder(
+            CompareMixedNumber(instruction.double_operand,
+                               ((FSTIntegerValue*)value).internalValue)));
+        return AcceptsComparison(instruction.accepted, comparison);
+      }
+      break;
+
+    case Opcode::CompareString:
+      if (value_class == DelegateValueClass()) {
+        const FieldValue& field_value =
+            ((FSTDelegateValue*)value).internalValue;
+        if (field_value.type() == FieldValue::Type::String) {
+          comparison = WrapCompare<std::string>(field_value.string_value(),
+                                                instruction.string_operand);
+          return AcceptsComparison(instruction.accepted, comparison);
+        }
+      }
+      break;
+
+    case Opcode::Compare:
+      break;
+  }
+
+  // Only perform comparison queries on types with matching backend order (such
+  // as double and int).
+  return value.typeOrder == instruction.operand_type_order &&
+         AcceptsComparison(instruction.accepted,
+                           [value compare:instruction.operand]);
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/query_router.h"
+
+#include "absl/algorithm/container.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+using model::DocumentKey;
+using model::ResourcePath;
+using model::TargetId;
+
+void QueryRouter::AddQuery(TargetId target_id,
+                           const ResourcePath& path,
+                           const std::string& collection_group) {
+  if (collection_group.empty()) {
+    targets_by_path_[path].push_back(target_id);
+  } else {
+    collection_group_targets_[collection_group].emplace_back(path, target_id);
+  }
+}
+
+void QueryRouter::RemoveQuery(TargetId target_id,
+                              const ResourcePath& path,
+                              const std::string& collection_group) {
+  if (collection_group.empty()) {
+    auto found = targets_by_path_.find(path);
+    if (found == targets_by_path_.end()) return;
+
+    std::vector<TargetId>& targets = found->second;
+    auto target = absl::c_find(targets, target_id);
+    if (target != targets.end()) {
+      targets.erase(target);
+    }
+    if (targets.empty()) {
+      targets_by_path_.erase(found);
+    }
+  } else {
+    auto found = collection_group_targets_.find(collection_group);
+    if (found == collection_group_targets_.end()) return;
+
+    auto& targets = found->second;
+    auto target = absl::c_find(targets, std::make_pair(path, target_id));
+    if (target != targets.end()) {
+      targets.erase(target);
+    }
+    if (targets.empty()) {
+      collection_group_targets_.erase(found);
+    }
+  }
+}
+
+void QueryRouter::AddTargetsAffectedBy(const DocumentKey& key,
+                                       std::set<TargetId>* targets) const {
+  const ResourcePath& path = key.path();
+
+  auto document_targets = targets_by_path_.find(path);
+  if (document_targets != targets_by_path_.end()) {
+    targets->insert(document_targets->second.begin(),
+                    document_targets->second.end());
+  }
+
+  auto collection_targets = targets_by_path_.find(path.PopLast());
+  if (collection_targets != targets_by_path_.end()) {
+    targets->insert(collection_targets->second.begin(),
+                    collection_targets->second.end());
+  }
+
+  if (collection_group_targets_.empty() || path.size() < 2) return;
+  auto group_targets = collection_group_targets_.find(path[path.size() - 2]);
+  if (group_targets != collection_group_targets_.end()) {
+    for (const auto& entry : group_targets->second) {
+      if (entry.first.IsPrefixOf(path)) {
+        targets->insert(entry.second);
+      }
+    }
+  }
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
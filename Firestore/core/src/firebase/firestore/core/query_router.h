@@ -0,0 +1,89 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_QUERY_ROUTER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_QUERY_ROUTER_H_
+
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/model/types.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+/**
+ * Indexes the targets of active queries by the documents their queries could
+ * match, so that the targets affected by a batch of document changes are
+ * found in time proportional to the number of changes and affected targets
+ * rather than to the number of active queries.
+ *
+ * Queries are described by their path and collection group: a document query
+ * could match the document at its path, a collection query the documents
+ * immediately under its path, and a collection group query the documents of
+ * any collection with the group's ID under its path.
+ *
+ * Not thread-safe.
+ */
+class QueryRouter {
+ public:
+  /**
+   * Routes changes to the documents the query could match to `target_id`.
+   * `collection_group` is empty unless the query is a collection group query.
+   */
+  void AddQuery(model::TargetId target_id,
+                const model::ResourcePath& path,
+                const std::string& collection_group);
+
+  /**
+   * Stops routing changes to `target_id`, which must have been added with the
+   * same query.
+   */
+  void RemoveQuery(model::TargetId target_id,
+                   const model::ResourcePath& path,
+                   const std::string& collection_group);
+
+  /** Adds the targets whose queries could match `key` to `targets`. */
+  void AddTargetsAffectedBy(const model::DocumentKey& key,
+                            std::set<model::TargetId>* targets) const;
+
+ private:
+  /**
+   * The targets of document and collection queries by query path. Document
+   * paths have an even number of segments and collection paths an odd one, so
+   * both kinds of queries share the map.
+   */
+  std::map<model::ResourcePath, std::vector<model::TargetId>> targets_by_path_;
+
+  /** The paths and targets of collection group queries, by collection ID. */
+  std::unordered_map<
+      std::string,
+      std::vector<std::pair<model::ResourcePath, model::TargetId>>>
+      collection_group_targets_;
+};
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_QUERY_ROUTER_H_
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/rate_limiter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+namespace chr = std::chrono;
+
+namespace {
+
+/** The factor the rate grows by every ramp interval. */
+const double kRampUpFactor = 1.5;
+
+}  // namespace
+
+RateLimiter::RateLimiter(double initial_ops_per_second,
+                         double max_ops_per_second,
+                         Milliseconds ramp_interval,
+                         Clock::time_point start_time)
+    : initial_ops_per_second_{initial_ops_per_second},
+      max_ops_per_second_{max_ops_per_second},
+      ramp_interval_{ramp_interval},
+      start_time_{start_time},
+      last_refill_time_{start_time},
+      available_ops_{initial_ops_per_second} {
+  HARD_ASSERT(initial_ops_per_second > 0, "Rates must be positive");
+  HARD_ASSERT(initial_ops_per_second <= max_ops_per_second,
+              "Initial rate can't be greater than max rate");
+  HARD_ASSERT(ramp_interval.count() > 0, "Ramp interval must be positive");
+}
+
+bool RateLimiter::TryMakeRequest(int ops, Clock::time_point now) {
+  HARD_ASSERT(ops <= initial_ops_per_second_,
+              "Requests can't be larger than the initial rate");
+  Refill(now);
+  if (available_ops_ < ops) {
+    return false;
+  }
+  available_ops_ -= ops;
+  return true;
+}
+
+RateLimiter::Milliseconds RateLimiter::GetNextRequestDelay(
+    int ops, Clock::time_point now) {
+  Refill(now);
+  double missing_ops = ops - available_ops_;
+  if (missing_ops <= 0) {
+    return Milliseconds::zero();
+  }
+
+  double millis = missing_ops * 1000 / GetOpsPerSecond(now);
+  return Milliseconds{static_cast<Milliseconds::rep>(std::ceil(millis))};
+}
+
+double RateLimiter::GetOpsPerSecond(Clock::time_point now) const {
+  if (now <= start_time_) {
+    return initial_ops_per_second_;
+  }
+
+  auto intervals = (now - start_time_) / ramp_interval_;
+  double rate = initial_ops_per_second_ *
+                std::pow(kRampUpFactor, static_cast<double>(intervals));
+  return std::min(rate, max_ops_per_second_);
+}
+
+void RateLimiter::Refill(Clock::time_point now) {
+  if (now <= last_refill_time_) {
+    return;
+  }
+
+  double rate = GetOpsPerSecond(now);
+  double elapsed_seconds =
+      chr::duration<double>(now - last_refill_time_).count();
+  available_ops_ = std::min(available_ops_ + elapsed_seconds * rate, rate);
+  last_refill_time_ = now;
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_RATE_LIMITER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_RATE_LIMITER_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+/**
+ * A token bucket that limits the rate at which operations are sent to the
+ * backend, and raises that rate over time.
+ *
+ * The bucket starts out allowing `initial_ops_per_second` and grows the rate
+ * by 50% every `ramp_interval`, up to `max_ops_per_second`, which is how
+ * traffic to a new range of keys should be ramped up. The bucket holds at most
+ * a second's worth of operations.
+ *
+ * Not thread-safe.
+ */
+class RateLimiter {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using Milliseconds = std::chrono::milliseconds;
+
+  RateLimiter(double initial_ops_per_second,
+              double max_ops_per_second,
+              Milliseconds ramp_interval,
+              Clock::time_point start_time = Clock::now());
+
+  /**
+   * Takes `ops` operations out of the bucket and returns true if that many are
+   * available at `now`; otherwise leaves the bucket alone and returns false.
+   * `ops` must not be greater than the initial rate.
+   */
+  bool TryMakeRequest(int ops, Clock::time_point now = Clock::now());
+
+  /**
+   * Returns how long to wait from `now` until `ops` operations are available,
+   * which is zero if they already are.
+   */
+  Milliseconds GetNextRequestDelay(int ops,
+                                   Clock::time_point now = Clock::now());
+
+  /** Returns the rate of operations allowed at `now`. */
+  double GetOpsPerSecond(Clock::time_point now) const;
+
+ private:
+  void Refill(Clock::time_point now);
+
+  double initial_ops_per_second_ = 0;
+  double max_ops_per_second_ = 0;
+  Milliseconds ramp_interval_;
+  Clock::time_point start_time_;
+  Clock::time_point last_refill_time_;
+  double available_ops_ = 0;
+};
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_RATE_LIMITER_H_
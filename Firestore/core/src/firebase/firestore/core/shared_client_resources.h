@@ -0,0 +1,88 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_SHARED_CLIENT_RESOURCES_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_SHARED_CLIENT_RESOURCES_H_
+
+#if !defined(__OBJC__)
+#error "This header only supports Objective-C++"
+#endif  // !defined(__OBJC__)
+
+#include <dispatch/dispatch.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "leveldb/cache.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+/**
+ * The resources that the clients of all Firestore instances of an app share
+ * when they opt into sharing: a serial dispatch queue that their worker queues
+ * run on, and a LevelDB block cache that bounds the memory their databases use
+ * for caching, together.
+ *
+ * The clients stay isolated: each keeps its own worker queue (which merely
+ * targets the shared dispatch queue), its own database and its own streams.
+ * Their gRPC completion queue and channel are shared by `GrpcSharedResources`
+ * regardless.
+ *
+ * All methods are thread-safe.
+ */
+class SharedClientResources {
+ public:
+  /**
+   * Returns the resources for the app with the given persistence key, creating
+   * them if no client holds them at the moment. The resources are released
+   * once the last client lets go of them.
+   *
+   * @param block_cache_size_bytes The capacity of the block cache, or 0 for
+   *     LevelDB's default; only used if new resources are created.
+   */
+  static std::shared_ptr<SharedClientResources> Acquire(
+      const std::string& persistence_key, size_t block_cache_size_bytes);
+
+  SharedClientResources(const SharedClientResources&) = delete;
+  SharedClientResources& operator=(const SharedClientResources&) = delete;
+
+  /**
+   * Makes `worker_queue` run its operations on the shared dispatch queue. Must
+   * be called before any operation is enqueued on `worker_queue`.
+   */
+  void ShareWorkerQueue(util::AsyncQueue* worker_queue);
+
+  const std::shared_ptr<leveldb::Cache>& block_cache() const {
+    return block_cache_;
+  }
+
+ private:
+  SharedClientResources(const std::string& persistence_key,
+                        size_t block_cache_size_bytes);
+
+  dispatch_queue_t worker_dispatch_queue_;
+  std::shared_ptr<leveldb::Cache> block_cache_;
+};
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_SHARED_CLIENT_RESOURCES_H_
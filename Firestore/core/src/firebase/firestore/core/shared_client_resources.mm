@@ -0,0 +1,89 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/shared_client_resources.h"
+
+#include <mutex>  // NOLINT(build/c++11)
+#include <unordered_map>
+
+#include "Firestore/core/src/firebase/firestore/util/executor_libdispatch.h"
+#include "absl/strings/str_cat.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+namespace {
+
+using util::AsyncQueue;
+using util::ExecutorLibdispatch;
+
+using ResourcesByKey =
+    std::unordered_map<std::string, std::weak_ptr<SharedClientResources>>;
+
+/** LevelDB's default block cache capacity. */
+const size_t kDefaultBlockCacheSizeBytes = 8 * 1024 * 1024;
+
+std::mutex& PoolMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+ResourcesByKey& Pool() {
+  static ResourcesByKey pool;
+  return pool;
+}
+
+}  // namespace
+
+std::shared_ptr<SharedClientResources> SharedClientResources::Acquire(
+    const std::string& persistence_key, size_t block_cache_size_bytes) {
+  std::lock_guard<std::mutex> lock{PoolMutex()};
+
+  std::weak_ptr<SharedClientResources>& entry = Pool()[persistence_key];
+  std::shared_ptr<SharedClientResources> resources = entry.lock();
+  if (!resources) {
+    // The constructor is private, so `std::make_shared` can't be used.
+    resources = std::shared_ptr<SharedClientResources>(
+        new SharedClientResources(persistence_key, block_cache_size_bytes));
+    entry = resources;
+  }
+  return resources;
+}
+
+SharedClientResources::SharedClientResources(const std::string& persistence_key,
+                                             size_t block_cache_size_bytes) {
+  std::string label =
+      absl::StrCat("com.google.firebase.firestore.shared.", persistence_key);
+  worker_dispatch_queue_ =
+      dispatch_queue_create(label.c_str(), DISPATCH_QUEUE_SERIAL);
+
+  if (block_cache_size_bytes == 0) {
+    block_cache_size_bytes = kDefaultBlockCacheSizeBytes;
+  }
+  block_cache_.reset(leveldb::NewLRUCache(block_cache_size_bytes));
+}
+
+void SharedClientResources::ShareWorkerQueue(AsyncQueue* worker_queue) {
+  // On Apple platforms, the executor implementation must be the
+  // libdispatch-based one.
+  auto executor = static_cast<ExecutorLibdispatch*>(worker_queue->executor());
+  dispatch_set_target_queue(executor->dispatch_queue(), worker_dispatch_queue_);
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
@@ -23,6 +23,7 @@
 
 #include <functional>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <unordered_map>
 #include <vector>
 
@@ -31,6 +32,7 @@
 #include "Firestore/core/src/firebase/firestore/model/precondition.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/remote/datastore.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor_callback.h"
@@ -54,11 +56,15 @@ class Transaction {
       const std::vector<FSTMaybeDocument*>&, const util::Status&)>;
 
   Transaction() = default;
-  explicit Transaction(remote::Datastore* transaction);
+  Transaction(remote::Datastore* datastore, util::AsyncQueue* worker_queue);
 
   /**
    * Takes a set of keys and asynchronously attempts to fetch all the documents
    * from the backend, ignoring any local changes.
+   *
+   * Documents already read by this transaction are served from its read cache
+   * rather than fetched again, and lookups issued before the worker queue gets
+   * to them are sent to the backend together.
    */
   void Lookup(const std::vector<model::DocumentKey>& keys,
               LookupCallback&& callback);
@@ -89,6 +95,25 @@ class Transaction {
   void Commit(util::StatusCallback&& callback);
 
  private:
+  struct PendingLookup {
+    std::vector<model::DocumentKey> keys;
+    LookupCallback callback;
+  };
+
+  /**
+   * Fetches the documents for all pending lookups that aren't in the read
+   * cache yet, then invokes the callbacks of the lookups. Runs on the worker
+   * queue.
+   */
+  void SendPendingLookups();
+
+  /**
+   * Invokes the callbacks of the given lookups with documents from the read
+   * cache, or with `status` if it's an error.
+   */
+  void FinishLookups(const std::vector<PendingLookup>& lookups,
+                     const util::Status& status);
+
   /**
    * Every time a document is read, this should be called to record its version.
    * If we read two different versions of the same document, this will return an
@@ -119,6 +144,7 @@ class Transaction {
       const model::DocumentKey& key) const;
 
   remote::Datastore* datastore_ = nullptr;
+  util::AsyncQueue* worker_queue_ = nullptr;
 
   std::vector<FSTMutation*> mutations_;
   bool committed_ = false;
@@ -133,6 +159,22 @@ class Transaction {
                      model::SnapshotVersion,
                      model::DocumentKeyHash>
       read_versions_;
+
+  /**
+   * The documents read by this transaction. Only accessed on the worker queue.
+   */
+  std::unordered_map<model::DocumentKey,
+                     FSTMaybeDocument*,
+                     model::DocumentKeyHash>
+      read_cache_;
+
+  /**
+   * Lookups waiting for `SendPendingLookups` to run. Guarded by
+   * `lookup_mutex_`, since lookups are issued from the user's queue.
+   */
+  std::vector<PendingLookup> pending_lookups_;
+  bool lookups_scheduled_ = false;
+  std::mutex lookup_mutex_;
 };
 
 using TransactionResultCallback = util::StatusOrCallback<absl::any>;
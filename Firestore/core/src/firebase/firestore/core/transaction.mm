@@ -17,6 +17,9 @@
 #include "Firestore/core/src/firebase/firestore/core/transaction.h"
 
 #include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <unordered_set>
 #include <utility>
 
@@ -34,6 +37,7 @@ using firebase::firestore::model::DocumentKeyHash;
 using firebase::firestore::model::Precondition;
 using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::remote::Datastore;
+using firebase::firestore::util::AsyncQueue;
 using firebase::firestore::util::Status;
 using firebase::firestore::util::StatusOr;
 
@@ -41,8 +45,8 @@ namespace firebase {
 namespace firestore {
 namespace core {
 
-Transaction::Transaction(Datastore* datastore)
-    : datastore_{NOT_NULL(datastore)} {
+Transaction::Transaction(Datastore* datastore, AsyncQueue* worker_queue)
+    : datastore_{NOT_NULL(datastore)}, worker_queue_{NOT_NULL(worker_queue)} {
 }
 
 Status Transaction::RecordVersion(FSTMaybeDocument* doc) {
@@ -80,24 +84,82 @@ void Transaction::Lookup(const std::vector<DocumentKey>& keys,
   HARD_ASSERT(mutations_.empty(),
               "Transactions lookups are invalid after writes.");
 
-  datastore_->LookupDocuments(
-      keys, [this, callback](const std::vector<FSTMaybeDocument*>& documents,
-                             const Status& status) {
-        if (!status.ok()) {
-          callback({}, status);
+  std::lock_guard<std::mutex> lock{lookup_mutex_};
+  pending_lookups_.push_back(PendingLookup{keys, std::move(callback)});
+  if (lookups_scheduled_) {
+    return;
+  }
+
+  lookups_scheduled_ = true;
+  worker_queue_->EnqueueRelaxed([this] { SendPendingLookups(); });
+}
+
+void Transaction::SendPendingLookups() {
+  std::vector<PendingLookup> lookups;
+  {
+    std::lock_guard<std::mutex> lock{lookup_mutex_};
+    lookups = std::move(pending_lookups_);
+    pending_lookups_.clear();
+    lookups_scheduled_ = false;
+  }
+
+  std::vector<DocumentKey> missing;
+  for (const PendingLookup& lookup : lookups) {
+    for (const DocumentKey& key : lookup.keys) {
+      if (read_cache_.find(key) == read_cache_.end()) {
+        missing.push_back(key);
+      }
+    }
+  }
+  std::sort(missing.begin(), missing.end());
+  missing.erase(std::unique(missing.begin(), missing.end()), missing.end());
+
+  if (missing.empty()) {
+    FinishLookups(lookups, Status::OK());
+    return;
+  }
+
+  // Versions are recorded as the documents arrive rather than once the whole
+  // lookup has finished.
+  auto record_error = std::make_shared<Status>();
+  datastore_->LookupDocumentsStreaming(
+      missing,
+      [this, record_error](FSTMaybeDocument* doc) {
+        if (!record_error->ok()) {
           return;
         }
+        *record_error = RecordVersion(doc);
+        read_cache_[doc.key] = doc;
+      },
+      [this, lookups, record_error](const Status& status) {
+        FinishLookups(lookups, status.ok() ? *record_error : status);
+      });
+}
 
-        for (FSTMaybeDocument* doc : documents) {
-          Status record_error = RecordVersion(doc);
-          if (!record_error.ok()) {
-            callback({}, record_error);
-            return;
-          }
-        }
+void Transaction::FinishLookups(const std::vector<PendingLookup>& lookups,
+                                const Status& status) {
+  for (const PendingLookup& lookup : lookups) {
+    if (!status.ok()) {
+      lookup.callback({}, status);
+      continue;
+    }
 
-        callback(documents, Status::OK());
-      });
+    // Sort by key, like `Datastore::LookupDocuments` does.
+    std::map<DocumentKey, FSTMaybeDocument*> documents;
+    for (const DocumentKey& key : lookup.keys) {
+      auto found = read_cache_.find(key);
+      if (found != read_cache_.end()) {
+        documents[key] = found->second;
+      }
+    }
+
+    std::vector<FSTMaybeDocument*> result;
+    result.reserve(documents.size());
+    for (const auto& kv : documents) {
+      result.push_back(kv.second);
+    }
+    lookup.callback(result, Status::OK());
+  }
 }
 
 void Transaction::WriteMutations(std::vector<FSTMutation*>&& mutations) {
@@ -18,6 +18,7 @@
 
 #include <utility>
 
+#import "Firestore/Source/Model/FSTFieldValue.h"
 #import "Firestore/Source/Model/FSTMutation.h"
 
 #include "Firestore/core/src/firebase/firestore/api/input_validation.h"
@@ -32,6 +33,8 @@ using model::DocumentKey;
 using model::FieldMask;
 using model::FieldPath;
 using model::FieldTransform;
+using model::FieldValue;
+using model::ObjectValue;
 using model::Precondition;
 using model::TransformOperation;
 
@@ -69,12 +72,12 @@ void ParseAccumulator::AddToFieldTransforms(
                                  std::move(transform_operation));
 }
 
-ParsedSetData ParseAccumulator::MergeData(FSTObjectValue* data) && {
-  return ParsedSetData{data, FieldMask{std::move(field_mask_)},
+ParsedSetData ParseAccumulator::MergeData(ObjectValue data) && {
+  return ParsedSetData{std::move(data), FieldMask{std::move(field_mask_)},
                        std::move(field_transforms_)};
 }
 
-ParsedSetData ParseAccumulator::MergeData(FSTObjectValue* data,
+ParsedSetData ParseAccumulator::MergeData(ObjectValue data,
                                           model::FieldMask user_field_mask) && {
   std::vector<FieldTransform> covered_field_transforms;
 
@@ -84,16 +87,16 @@ ParsedSetData ParseAccumulator::MergeData(FSTObjectValue* data,
     }
   }
 
-  return ParsedSetData{data, std::move(user_field_mask),
+  return ParsedSetData{std::move(data), std::move(user_field_mask),
                        std::move(covered_field_transforms)};
 }
 
-ParsedSetData ParseAccumulator::SetData(FSTObjectValue* data) && {
-  return ParsedSetData{data, std::move(field_transforms_)};
+ParsedSetData ParseAccumulator::SetData(ObjectValue data) && {
+  return ParsedSetData{std::move(data), std::move(field_transforms_)};
 }
 
-ParsedUpdateData ParseAccumulator::UpdateData(FSTObjectValue* data) && {
-  return ParsedUpdateData{data, FieldMask{std::move(field_mask_)},
+ParsedUpdateData ParseAccumulator::UpdateData(ObjectValue data) && {
+  return ParsedUpdateData{std::move(data), FieldMask{std::move(field_mask_)},
                           std::move(field_transforms_)};
 }
 
@@ -194,17 +197,27 @@ void ParseContext::AddToFieldTransforms(
 
 #pragma mark - ParsedSetData
 
-ParsedSetData::ParsedSetData(FSTObjectValue* data,
+namespace {
+
+/** Converts parsed data into the form that FSTMutations hold. */
+FSTObjectValue* WrapObject(const ObjectValue& data) {
+  return static_cast<FSTObjectValue*>(
+      FieldValue::FromMap(data.GetInternalValue()).Wrap());
+}
+
+}  // namespace
+
+ParsedSetData::ParsedSetData(ObjectValue data,
                              std::vector<FieldTransform> field_transforms)
-    : data_{data},
+    : data_{std::move(data)},
       field_transforms_{std::move(field_transforms)},
       patch_{false} {
 }
 
-ParsedSetData::ParsedSetData(FSTObjectValue* data,
+ParsedSetData::ParsedSetData(ObjectValue data,
                              FieldMask field_mask,
                              std::vector<FieldTransform> field_transforms)
-    : data_{data},
+    : data_{std::move(data)},
       field_mask_{std::move(field_mask)},
       field_transforms_{std::move(field_transforms)},
       patch_{true} {
@@ -212,17 +225,18 @@ ParsedSetData::ParsedSetData(FSTObjectValue* data,
 
 std::vector<FSTMutation*> ParsedSetData::ToMutations(
     const DocumentKey& key, const Precondition& precondition) && {
+  FSTObjectValue* data = WrapObject(data_);
   std::vector<FSTMutation*> mutations;
   if (patch_) {
     FSTMutation* mutation =
         [[FSTPatchMutation alloc] initWithKey:key
                                     fieldMask:std::move(field_mask_)
-                                        value:data_
+                                        value:data
                                  precondition:precondition];
     mutations.push_back(mutation);
   } else {
     FSTMutation* mutation = [[FSTSetMutation alloc] initWithKey:key
-                                                          value:data_
+                                                          value:data
                                                    precondition:precondition];
     mutations.push_back(mutation);
   }
@@ -240,22 +254,23 @@ std::vector<FSTMutation*> ParsedSetData::ToMutations(
 #pragma mark - ParsedUpdateData
 
 ParsedUpdateData::ParsedUpdateData(
-    FSTObjectValue* data,
+    ObjectValue data,
     model::FieldMask field_mask,
     std::vector<model::FieldTransform> field_transforms)
-    : data_{data},
+    : data_{std::move(data)},
       field_mask_{std::move(field_mask)},
       field_transforms_{std::move(field_transforms)} {
 }
 
 std::vector<FSTMutation*> ParsedUpdateData::ToMutations(
     const DocumentKey& key, const Precondition& precondition) && {
+  FSTObjectValue* data = WrapObject(data_);
   std::vector<FSTMutation*> mutations;
 
   FSTMutation* mutation =
       [[FSTPatchMutation alloc] initWithKey:key
                                   fieldMask:std::move(field_mask_)
-                                      value:data_
+                                      value:data
                                precondition:precondition];
   mutations.push_back(mutation);
 
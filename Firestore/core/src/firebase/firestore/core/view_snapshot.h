@@ -102,6 +102,14 @@ class DocumentViewChangeSet {
   immutable::SortedMap<model::DocumentKey, DocumentViewChange> change_map_;
 };
 
+/**
+ * Sorts changes in the order they're reported in a ViewSnapshot: removals
+ * first, then additions, then modifications (including metadata-only ones),
+ * each in query order.
+ */
+void SortDocumentViewChanges(FSTQuery* query,
+                             std::vector<DocumentViewChange>* changes);
+
 /**
  * A view snapshot is an immutable capture of the results of a query and the
  * changes to them.
@@ -175,6 +183,20 @@ class ViewSnapshot {
     return mutated_keys_;
   }
 
+  /**
+   * Returns a copy of this snapshot without its `documents()` and
+   * `old_documents()`, which are both empty in the copy. Holding on to the
+   * copy doesn't keep the document sets of the view alive, and reading its
+   * changes doesn't need to track document positions (so the changes report
+   * no indexes).
+   */
+  ViewSnapshot WithoutDocuments() const;
+
+  /** Whether this snapshot was stripped of its documents. */
+  bool changes_only() const {
+    return changes_only_;
+  }
+
   std::string ToString() const;
   friend std::ostream& operator<<(std::ostream& out, const ViewSnapshot& value);
   size_t Hash() const;
@@ -190,6 +212,7 @@ class ViewSnapshot {
   bool from_cache_ = false;
   bool sync_state_changed_ = false;
   bool excludes_metadata_changes_ = false;
+  bool changes_only_ = false;
 };
 
 bool operator==(const ViewSnapshot& lhs, const ViewSnapshot& rhs);
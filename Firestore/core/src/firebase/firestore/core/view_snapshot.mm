@@ -16,12 +16,14 @@
 
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
 
+#include <algorithm>
 #include <ostream>
 
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Model/FSTDocument.h"
 
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/hashing.h"
 #include "Firestore/core/src/firebase/firestore/util/objc_compatibility.h"
 #include "Firestore/core/src/firebase/firestore/util/string_format.h"
@@ -56,6 +58,42 @@ bool operator==(const DocumentViewChange& lhs, const DocumentViewChange& rhs) {
 
 // DocumentViewChangeSet
 
+namespace {
+
+int GetDocumentViewChangeTypePosition(DocumentViewChange::Type type) {
+  switch (type) {
+    case DocumentViewChange::Type::kRemoved:
+      return 0;
+    case DocumentViewChange::Type::kAdded:
+      return 1;
+    case DocumentViewChange::Type::kModified:
+      return 2;
+    case DocumentViewChange::Type::kMetadata:
+      // A metadata change is converted to a modified change at the public API
+      // layer. Since we sort by document key and then change type, metadata
+      // and modified changes must be sorted equivalently.
+      return 2;
+  }
+  UNREACHABLE();
+}
+
+}  // namespace
+
+void SortDocumentViewChanges(FSTQuery* query,
+                             std::vector<DocumentViewChange>* changes) {
+  std::sort(changes->begin(), changes->end(),
+            [query](const DocumentViewChange& lhs,
+                    const DocumentViewChange& rhs) {
+              int pos1 = GetDocumentViewChangeTypePosition(lhs.type());
+              int pos2 = GetDocumentViewChangeTypePosition(rhs.type());
+              if (pos1 != pos2) {
+                return pos1 < pos2;
+              }
+              return query.comparator(lhs.document(), rhs.document()) ==
+                     NSOrderedAscending;
+            });
+}
+
 void DocumentViewChangeSet::AddChange(DocumentViewChange&& change) {
   const DocumentKey& key = change.document().key;
   auto old_change_iter = change_map_.find(key);
@@ -170,14 +208,23 @@ ViewSnapshot ViewSnapshot::FromInitialDocuments(
                       /*sync_state_changed=*/true, excludes_metadata_changes};
 }
 
+ViewSnapshot ViewSnapshot::WithoutDocuments() const {
+  ViewSnapshot result = *this;
+  result.documents_ = DocumentSet{query_.comparator};
+  result.old_documents_ = DocumentSet{query_.comparator};
+  result.changes_only_ = true;
+  return result;
+}
+
 std::string ViewSnapshot::ToString() const {
   return StringFormat(
       "<ViewSnapshot query: %s documents: %s old_documents: %s changes: %s "
       "from_cache: %s mutated_keys: %s sync_state_changed: %s "
-      "excludes_metadata_changes: %s>",
+      "excludes_metadata_changes: %s changes_only: %s>",
       query(), documents_.ToString(), old_documents_.ToString(),
       objc::Description(document_changes()), from_cache(),
-      mutated_keys().size(), sync_state_changed(), excludes_metadata_changes());
+      mutated_keys().size(), sync_state_changed(), excludes_metadata_changes(),
+      changes_only());
 }
 
 std::ostream& operator<<(std::ostream& out, const ViewSnapshot& value) {
@@ -188,21 +235,29 @@ size_t ViewSnapshot::Hash() const {
   // Note: We are omitting `mutated_keys_` from the hash, since we don't have a
   // straightforward way to compute its hash value. Since `ViewSnapshot` is
   // currently not stored in any dictionaries, this has no side effects.
-
+  //
+  // The document sets hash in constant time, so only the number of changes is
+  // hashed rather than each of them, which keeps hashing a snapshot from
+  // visiting every document.
   return util::Hash([query() hash], documents(), old_documents(),
-                    document_changes(), from_cache(), sync_state_changed(),
-                    excludes_metadata_changes());
+                    document_changes().size(), from_cache(),
+                    sync_state_changed(), excludes_metadata_changes(),
+                    changes_only());
 }
 
 bool operator==(const ViewSnapshot& lhs, const ViewSnapshot& rhs) {
-  return objc::Equals(lhs.query(), rhs.query()) &&
+  // Compare the cheap members first so that most unequal snapshots are told
+  // apart without looking at their documents.
+  return lhs.from_cache() == rhs.from_cache() &&
+         lhs.sync_state_changed() == rhs.sync_state_changed() &&
+         lhs.excludes_metadata_changes() == rhs.excludes_metadata_changes() &&
+         lhs.changes_only() == rhs.changes_only() &&
+         lhs.document_changes().size() == rhs.document_changes().size() &&
+         objc::Equals(lhs.query(), rhs.query()) &&
          lhs.documents() == rhs.documents() &&
          lhs.old_documents() == rhs.old_documents() &&
-         lhs.document_changes() == rhs.document_changes() &&
-         lhs.from_cache() == rhs.from_cache() &&
          lhs.mutated_keys() == rhs.mutated_keys() &&
-         lhs.sync_state_changed() == rhs.sync_state_changed() &&
-         lhs.excludes_metadata_changes() == rhs.excludes_metadata_changes();
+         lhs.document_changes() == rhs.document_changes();
 }
 
 }  // namespace core
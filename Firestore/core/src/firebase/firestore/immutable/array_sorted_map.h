@@ -21,7 +21,9 @@
 #include <array>
 #include <cassert>
 #include <functional>
+#include <iterator>
 #include <memory>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -155,6 +157,21 @@ class ArraySortedMap : public SortedMapBase {
       : array_{SortedArray(entries, comparator)}, key_comparator_{comparator} {
   }
 
+  /**
+   * Creates an ArraySortedMap from entries that are already sorted by key with
+   * no duplicates. There must be at most kFixedSize of them.
+   */
+  static ArraySortedMap FromSorted(std::vector<value_type>&& entries,
+                                   const C& comparator) {
+    if (entries.empty()) {
+      return ArraySortedMap{comparator};
+    }
+    auto array = std::make_shared<const array_type>(
+        std::make_move_iterator(entries.begin()),
+        std::make_move_iterator(entries.end()));
+    return ArraySortedMap{array, key_comparator_type{comparator}};
+  }
+
   /** Returns true if the map contains no elements. */
   bool empty() const {
     return size() == 0;
@@ -261,6 +278,14 @@ class ArraySortedMap : public SortedMapBase {
     return found == end() ? npos : static_cast<size_type>(found - begin());
   }
 
+  /**
+   * Returns an iterator pointing to the entry at the given index, or end() if
+   * the index is out of range. This is the inverse of find_index.
+   */
+  const_iterator nth(size_type index) const {
+    return index < size() ? begin() + index : end();
+  }
+
   /**
    * Finds the first entry in the map containing a key greater than or equal
    * to the given key.
@@ -271,7 +296,7 @@ class ArraySortedMap : public SortedMapBase {
    *     requested key.
    */
   const_iterator lower_bound(const K& key) const {
-    return std::lower_bound(begin(), end(), key, key_comparator_);
+    return LowerBound(key, std::is_arithmetic<K>{});
   }
 
   const_iterator min() const {
@@ -301,6 +326,14 @@ class ArraySortedMap : public SortedMapBase {
     return array_->end();
   }
 
+  /** Calls `action` with each entry in the map, in order. */
+  template <typename Action>
+  void ForEach(const Action& action) const {
+    for (const value_type& entry : *this) {
+      action(entry);
+    }
+  }
+
   /**
    * Returns a view of this SortedMap containing just the keys that have been
    * inserted.
@@ -344,6 +377,36 @@ class ArraySortedMap : public SortedMapBase {
     return std::make_shared<const array_type>(sorted.begin(), sorted.end());
   }
 
+  /**
+   * A branchless binary search, for keys such as TargetIds that compare in a
+   * single instruction. Each step keeps one half of the range by choosing
+   * between two positions, which compilers turn into a conditional move
+   * instead of a branch that mispredicts about half the time. It makes the
+   * same number of comparisons as std::lower_bound.
+   */
+  const_iterator LowerBound(const K& key, std::true_type) const {
+    const_iterator base = begin();
+    size_type n = size();
+    if (n == 0) {
+      return base;
+    }
+    while (n > 1) {
+      size_type half = n / 2;
+      base = key_comparator_(base[half], key) ? base + half : base;
+      n -= half;
+    }
+    return key_comparator_(*base, key) ? base + 1 : base;
+  }
+
+  /**
+   * An ordinary binary search, for keys such as strings whose comparisons are
+   * calls: waiting for each one before loading the next entry costs more than
+   * the mispredicted branches the branchless search avoids.
+   */
+  const_iterator LowerBound(const K& key, std::false_type) const {
+    return std::lower_bound(begin(), end(), key, key_comparator_);
+  }
+
   ArraySortedMap(const array_pointer& array,
                  const key_comparator_type& key_comparator) noexcept
       : array_{array}, key_comparator_{key_comparator} {
@@ -0,0 +1,518 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_BTREE_NODE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_BTREE_NODE_H_
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/immutable/btree_node_iterator.h"
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_container.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+/**
+ * BTreeNode is a node in a BTreeSortedMap: a persistent B+tree whose leaves
+ * hold up to kMaxWidth entries each, stored contiguously, and whose inner
+ * nodes hold up to kMaxWidth children.
+ *
+ * Nodes are immutable and shared between versions of the tree. Mutations copy
+ * only the nodes on the path from the root to the affected leaf, so every
+ * operation allocates O(log(n)) nodes of O(kMaxWidth) size each.
+ *
+ * Every leaf is at the same depth, and every node other than the root holds at
+ * least kMinWidth entries or children.
+ */
+template <typename K, typename V>
+class BTreeNode : public SortedMapBase {
+ public:
+  using first_type = K;
+  using second_type = V;
+
+  /**
+   * The type of the entries stored in the map.
+   */
+  using value_type = std::pair<K, V>;
+  using const_iterator = BTreeNodeIterator<BTreeNode<K, V>>;
+
+  /**
+   * The maximum number of entries in a leaf, and of children in an inner node.
+   * Nodes that grow beyond this are split in two.
+   */
+  static constexpr size_type kMaxWidth = 32;
+
+  /**
+   * The minimum number of entries or children in any node but the root. Nodes
+   * that shrink below this borrow from or are merged with a sibling.
+   */
+  static constexpr size_type kMinWidth = kMaxWidth / 2;
+
+  /**
+   * Constructs an empty node.
+   */
+  BTreeNode() : rep_{EmptyRep()} {
+  }
+
+  /** Returns true if this node and its descendants contain no entries. */
+  bool empty() const {
+    return size() == 0;
+  }
+
+  /** Returns the number of entries at or beneath this node in the tree. */
+  size_type size() const {
+    return rep_->size_;
+  }
+
+  /** Returns true if this node holds entries rather than child nodes. */
+  bool is_leaf() const {
+    return rep_->children_.empty();
+  }
+
+  /**
+   * Returns the number of entries (for a leaf) or children (for an inner node)
+   * directly in this node.
+   */
+  size_type width() const {
+    return static_cast<size_type>(is_leaf() ? rep_->entries_.size()
+                                            : rep_->children_.size());
+  }
+
+  /** Returns the entry at the given index of a leaf. */
+  const value_type& entry(size_type index) const {
+    return rep_->entries_[index];
+  }
+
+  /** Returns the child at the given index of an inner node. */
+  const BTreeNode& child(size_type index) const {
+    return rep_->children_[index];
+  }
+
+  /** Calls `action` with each entry at or beneath this node, in order. */
+  template <typename Action>
+  void ForEach(const Action& action) const {
+    if (is_leaf()) {
+      for (const value_type& entry : rep_->entries_) {
+        action(entry);
+      }
+    } else {
+      for (const BTreeNode& child : rep_->children_) {
+        child.ForEach(action);
+      }
+    }
+  }
+
+  /**
+   * Returns the index of the first entry in this leaf whose key is not less
+   * than the given key, or width() if there is no such entry.
+   */
+  template <typename Comparator>
+  size_type LowerBoundIndex(const K& key, const Comparator& comparator) const {
+    const std::vector<value_type>& entries = rep_->entries_;
+    auto found = std::lower_bound(
+        entries.begin(), entries.end(), key,
+        [&](const value_type& entry, const K& k) {
+          return comparator(entry.first, k);
+        });
+    return static_cast<size_type>(found - entries.begin());
+  }
+
+  /**
+   * Returns the index of the child of this inner node whose subtree would
+   * contain the given key.
+   */
+  template <typename Comparator>
+  size_type ChildIndex(const K& key, const Comparator& comparator) const {
+    const std::vector<K>& separators = rep_->separators_;
+    auto found = std::upper_bound(separators.begin(), separators.end(), key,
+                                  comparator);
+    return static_cast<size_type>(found - separators.begin());
+  }
+
+  /**
+   * Builds a tree containing the given entries, which must be sorted by key
+   * with no duplicates, in O(n) time. Every node is filled as evenly as
+   * possible, so the tree has the minimum depth for its size.
+   */
+  static BTreeNode FromSorted(std::vector<value_type>&& entries);
+
+  /** Returns a tree with the given key-value pair set/updated. */
+  template <typename Comparator>
+  BTreeNode insert(const K& key,
+                   const V& value,
+                   const Comparator& comparator) const;
+
+  /**
+   * Returns a tree without the given key. If the key is not present, returns a
+   * node that shares its representation with this one.
+   */
+  template <typename Comparator>
+  BTreeNode erase(const K& key, const Comparator& comparator) const;
+
+ private:
+  struct Rep {
+    size_type size_ = 0;
+
+    // The entries of a leaf, in key order. Empty for inner nodes.
+    std::vector<value_type> entries_;
+
+    // The children of an inner node, in key order. Empty for leaves.
+    std::vector<BTreeNode> children_;
+
+    // The smallest key (at the time it was split off) in each child but the
+    // first: every key in children_[i] is less than separators_[i], and every
+    // key in children_[i + 1] is greater than or equal to it.
+    std::vector<K> separators_;
+  };
+
+  explicit BTreeNode(Rep&& rep) : rep_{std::make_shared<Rep>(std::move(rep))} {
+  }
+
+  /**
+   * Returns a shared empty node, to cut down on allocations in the base case.
+   */
+  static const std::shared_ptr<Rep>& EmptyRep() {
+    static const std::shared_ptr<Rep> empty_rep = std::make_shared<Rep>();
+    return empty_rep;
+  }
+
+  static BTreeNode Leaf(std::vector<value_type>&& entries) {
+    if (entries.empty()) {
+      return BTreeNode{};
+    }
+    Rep rep;
+    rep.size_ = static_cast<size_type>(entries.size());
+    rep.entries_ = std::move(entries);
+    return BTreeNode{std::move(rep)};
+  }
+
+  static BTreeNode Inner(std::vector<BTreeNode>&& children,
+                         std::vector<K>&& separators) {
+    HARD_ASSERT(children.size() == separators.size() + 1);
+    Rep rep;
+    for (const BTreeNode& child : children) {
+      rep.size_ += child.size();
+    }
+    rep.children_ = std::move(children);
+    rep.separators_ = std::move(separators);
+    return BTreeNode{std::move(rep)};
+  }
+
+  /**
+   * Inserts into the subtree rooted at this node. If the resulting node
+   * overflows, it is split: the returned node is the lower half, and the
+   * upper half and the smallest key in it are stored in `split` and
+   * `split_key`. Otherwise `split` is left empty.
+   */
+  template <typename Comparator>
+  BTreeNode InnerInsert(const K& key,
+                        const V& value,
+                        const Comparator& comparator,
+                        BTreeNode* split,
+                        K* split_key) const;
+
+  template <typename Comparator>
+  BTreeNode InnerErase(const K& key, const Comparator& comparator) const;
+
+  /**
+   * Restores the minimum width of the child at `index` in the inner node
+   * represented by `rep`, by merging it with a neighbor or, if the two don't
+   * fit in a single node, by redistributing their contents evenly.
+   */
+  static void Rebalance(Rep* rep, size_type index);
+
+  template <typename T>
+  static std::vector<T> Concat(const std::vector<T>& lhs,
+                               const std::vector<T>& rhs) {
+    std::vector<T> result;
+    result.reserve(lhs.size() + rhs.size());
+    result.insert(result.end(), lhs.begin(), lhs.end());
+    result.insert(result.end(), rhs.begin(), rhs.end());
+    return result;
+  }
+
+  /** Moves the elements of `source` from `index` onwards into a new vector. */
+  template <typename T>
+  static std::vector<T> SplitOff(std::vector<T>* source, size_t index) {
+    std::vector<T> result{std::make_move_iterator(source->begin() + index),
+                          std::make_move_iterator(source->end())};
+    source->erase(source->begin() + index, source->end());
+    return result;
+  }
+
+  /**
+   * Returns the sizes of the nodes that `count` entries or children should be
+   * divided into, so that each node holds between kMinWidth and kMaxWidth of
+   * them (unless there are fewer than kMinWidth in total).
+   */
+  static std::vector<size_t> ChunkSizes(size_t count) {
+    size_t chunks = (count + kMaxWidth - 1) / kMaxWidth;
+    std::vector<size_t> sizes(chunks, count / chunks);
+    for (size_t i = 0; i < count % chunks; ++i) {
+      sizes[i] += 1;
+    }
+    return sizes;
+  }
+
+  std::shared_ptr<Rep> rep_;
+};
+
+template <typename K, typename V>
+constexpr typename BTreeNode<K, V>::size_type BTreeNode<K, V>::kMaxWidth;
+
+template <typename K, typename V>
+constexpr typename BTreeNode<K, V>::size_type BTreeNode<K, V>::kMinWidth;
+
+template <typename K, typename V>
+BTreeNode<K, V> BTreeNode<K, V>::FromSorted(std::vector<value_type>&& entries) {
+  if (entries.size() <= kMaxWidth) {
+    return Leaf(std::move(entries));
+  }
+
+  // Build the leaves, then repeatedly group the nodes of the last level built
+  // under the nodes of a new level until there's a single root. Alongside
+  // each node, track the smallest key beneath it to use as its separator.
+  std::vector<BTreeNode> level;
+  std::vector<K> min_keys;
+  auto entry = std::make_move_iterator(entries.begin());
+  for (size_t chunk_size : ChunkSizes(entries.size())) {
+    min_keys.push_back(entry->first);
+    level.push_back(Leaf(std::vector<value_type>{entry, entry + chunk_size}));
+    entry += chunk_size;
+  }
+
+  while (level.size() > 1) {
+    std::vector<BTreeNode> parents;
+    std::vector<K> parent_min_keys;
+    size_t start = 0;
+    for (size_t chunk_size : ChunkSizes(level.size())) {
+      auto first_child = std::make_move_iterator(level.begin() + start);
+      auto first_key = std::make_move_iterator(min_keys.begin() + start);
+      parent_min_keys.push_back(min_keys[start]);
+      std::vector<BTreeNode> children{first_child, first_child + chunk_size};
+      std::vector<K> separators{first_key + 1, first_key + chunk_size};
+      parents.push_back(Inner(std::move(children), std::move(separators)));
+      start += chunk_size;
+    }
+    level = std::move(parents);
+    min_keys = std::move(parent_min_keys);
+  }
+  return std::move(level.front());
+}
+
+template <typename K, typename V>
+template <typename Comparator>
+BTreeNode<K, V> BTreeNode<K, V>::insert(const K& key,
+                                        const V& value,
+                                        const Comparator& comparator) const {
+  BTreeNode split;
+  K split_key{};
+  BTreeNode root = InnerInsert(key, value, comparator, &split, &split_key);
+  if (split.empty()) {
+    return root;
+  }
+
+  // The root overflowed, so the tree grows by one level.
+  std::vector<BTreeNode> children;
+  children.reserve(2);
+  children.push_back(std::move(root));
+  children.push_back(std::move(split));
+  std::vector<K> separators;
+  separators.push_back(std::move(split_key));
+  return Inner(std::move(children), std::move(separators));
+}
+
+template <typename K, typename V>
+template <typename Comparator>
+BTreeNode<K, V> BTreeNode<K, V>::InnerInsert(const K& key,
+                                             const V& value,
+                                             const Comparator& comparator,
+                                             BTreeNode* split,
+                                             K* split_key) const {
+  if (is_leaf()) {
+    const std::vector<value_type>& old_entries = rep_->entries_;
+    size_type index = LowerBoundIndex(key, comparator);
+    bool found = index < old_entries.size() &&
+                 !comparator(key, old_entries[index].first);
+
+    std::vector<value_type> entries;
+    entries.reserve(old_entries.size() + 1);
+    entries.insert(entries.end(), old_entries.begin(),
+                   old_entries.begin() + index);
+    entries.emplace_back(key, value);
+    entries.insert(entries.end(), old_entries.begin() + index + (found ? 1 : 0),
+                   old_entries.end());
+
+    if (entries.size() > kMaxWidth) {
+      std::vector<value_type> upper = SplitOff(&entries, entries.size() / 2);
+      *split_key = upper.front().first;
+      *split = Leaf(std::move(upper));
+    }
+    return Leaf(std::move(entries));
+  }
+
+  size_type index = ChildIndex(key, comparator);
+  BTreeNode child_split;
+  K child_split_key{};
+  BTreeNode new_child = child(index).InnerInsert(
+      key, value, comparator, &child_split, &child_split_key);
+
+  Rep rep = *rep_;
+  rep.size_ += new_child.size() + child_split.size() - child(index).size();
+  rep.children_[index] = std::move(new_child);
+  if (!child_split.empty()) {
+    rep.children_.insert(rep.children_.begin() + index + 1,
+                         std::move(child_split));
+    rep.separators_.insert(rep.separators_.begin() + index,
+                           std::move(child_split_key));
+  }
+
+  if (rep.children_.size() > kMaxWidth) {
+    size_t half = rep.children_.size() / 2;
+    std::vector<BTreeNode> upper_children = SplitOff(&rep.children_, half);
+    std::vector<K> upper_separators = SplitOff(&rep.separators_, half);
+
+    // The separator between the halves moves up into the parent.
+    *split_key = std::move(rep.separators_.back());
+    rep.separators_.pop_back();
+    *split = Inner(std::move(upper_children), std::move(upper_separators));
+    rep.size_ -= split->size();
+  }
+  return BTreeNode{std::move(rep)};
+}
+
+template <typename K, typename V>
+template <typename Comparator>
+BTreeNode<K, V> BTreeNode<K, V>::erase(const K& key,
+                                       const Comparator& comparator) const {
+  BTreeNode root = InnerErase(key, comparator);
+
+  // An inner root left with a single child is redundant, so the tree shrinks
+  // by one level.
+  if (!root.is_leaf() && root.width() == 1) {
+    return root.child(0);
+  }
+  return root;
+}
+
+template <typename K, typename V>
+template <typename Comparator>
+BTreeNode<K, V> BTreeNode<K, V>::InnerErase(
+    const K& key, const Comparator& comparator) const {
+  if (is_leaf()) {
+    const std::vector<value_type>& old_entries = rep_->entries_;
+    size_type index = LowerBoundIndex(key, comparator);
+    if (index == old_entries.size() ||
+        comparator(key, old_entries[index].first)) {
+      // Not found.
+      return *this;
+    }
+
+    std::vector<value_type> entries;
+    entries.reserve(old_entries.size() - 1);
+    entries.insert(entries.end(), old_entries.begin(),
+                   old_entries.begin() + index);
+    entries.insert(entries.end(), old_entries.begin() + index + 1,
+                   old_entries.end());
+    return Leaf(std::move(entries));
+  }
+
+  size_type index = ChildIndex(key, comparator);
+  BTreeNode new_child = child(index).InnerErase(key, comparator);
+  if (new_child.rep_ == child(index).rep_) {
+    // Not found, so there's nothing to copy.
+    return *this;
+  }
+
+  Rep rep = *rep_;
+  rep.size_ -= 1;
+  bool underfull = new_child.width() < kMinWidth;
+  rep.children_[index] = std::move(new_child);
+  if (underfull) {
+    Rebalance(&rep, index);
+  }
+  return BTreeNode{std::move(rep)};
+}
+
+template <typename K, typename V>
+void BTreeNode<K, V>::Rebalance(Rep* rep, size_type index) {
+  // Inner nodes always have at least two children, so there's always a
+  // neighbor to pair with.
+  size_t left = index > 0 ? index - 1 : index;
+  size_t right = left + 1;
+  const BTreeNode& lhs = rep->children_[left];
+  const BTreeNode& rhs = rep->children_[right];
+
+  BTreeNode merged;
+  BTreeNode split;
+  K split_key{};
+  if (lhs.is_leaf()) {
+    std::vector<value_type> entries =
+        Concat(lhs.rep_->entries_, rhs.rep_->entries_);
+    if (entries.size() > kMaxWidth) {
+      std::vector<value_type> upper = SplitOff(&entries, entries.size() / 2);
+      split_key = upper.front().first;
+      split = Leaf(std::move(upper));
+    }
+    merged = Leaf(std::move(entries));
+
+  } else {
+    std::vector<BTreeNode> children =
+        Concat(lhs.rep_->children_, rhs.rep_->children_);
+
+    // The separator between the two nodes moves down between their children.
+    std::vector<K> separators;
+    separators.reserve(children.size() - 1);
+    separators.insert(separators.end(), lhs.rep_->separators_.begin(),
+                      lhs.rep_->separators_.end());
+    separators.push_back(rep->separators_[left]);
+    separators.insert(separators.end(), rhs.rep_->separators_.begin(),
+                      rhs.rep_->separators_.end());
+
+    if (children.size() > kMaxWidth) {
+      size_t half = children.size() / 2;
+      std::vector<BTreeNode> upper_children = SplitOff(&children, half);
+      std::vector<K> upper_separators = SplitOff(&separators, half);
+      split_key = std::move(separators.back());
+      separators.pop_back();
+      split = Inner(std::move(upper_children), std::move(upper_separators));
+    }
+    merged = Inner(std::move(children), std::move(separators));
+  }
+
+  rep->children_[left] = std::move(merged);
+  if (split.empty()) {
+    rep->children_.erase(rep->children_.begin() + right);
+    rep->separators_.erase(rep->separators_.begin() + left);
+  } else {
+    rep->children_[right] = std::move(split);
+    rep->separators_[left] = std::move(split_key);
+  }
+}
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_BTREE_NODE_H_
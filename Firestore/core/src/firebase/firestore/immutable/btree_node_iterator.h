@@ -0,0 +1,280 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_BTREE_NODE_ITERATOR_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_BTREE_NODE_ITERATOR_H_
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_container.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+/**
+ * A forward iterator for traversing BTreeNodes, which is an in-order traversal
+ * of the map they represent.
+ *
+ * ## Complexity
+ *
+ * Like LlrbNodeIterator, this keeps an explicit stack of the nodes leading to
+ * the current entry since the tree cannot contain parent pointers. Unlike
+ * LlrbNodeIterator the stack is never more than a handful of levels deep, so
+ * it's stored inline and copying an iterator never allocates.
+ *
+ * For an underlying tree of size `n`, incrementing an iterator is amortized
+ * `O(1)`: most increments just move to the next entry in the same leaf.
+ *
+ * ## Invalidation and Comparison
+ *
+ * BTreeNodeIterators compare based on the identity of the nodes and the
+ * position within them, so only iterators over the same version of a tree are
+ * comparable. As with LlrbNodeIterator, mutations create new trees so no
+ * iterator is ever invalidated, but BTreeNodeIterator does not extend the
+ * lifetime of its underlying tree.
+ */
+template <typename N>
+class BTreeNodeIterator {
+ public:
+  using node_type = N;
+  using key_type = typename node_type::first_type;
+  using size_type = SortedContainer::size_type;
+
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = typename node_type::value_type;
+
+  using pointer = typename node_type::value_type const*;
+  using reference = typename node_type::value_type const&;
+  using difference_type = std::ptrdiff_t;
+
+  /**
+   * The maximum depth of a tree. Every node but the root has at least
+   * kMinWidth entries or children, so any deeper tree would have more entries
+   * than size_type can count.
+   */
+  static constexpr int kMaxDepth = 8;
+
+  // Default constructor to conform to the requirements of ForwardIterator
+  BTreeNodeIterator() {
+  }
+
+  /**
+   * Constructs an iterator starting at the first entry in the tree represented
+   * by the given root node.
+   */
+  static BTreeNodeIterator Begin(const node_type* root) {
+    BTreeNodeIterator result;
+    if (!root->empty()) {
+      result.DescendFirst(root);
+    }
+    return result;
+  }
+
+  /**
+   * Constructs an iterator pointing at the end of the iteration sequence of a
+   * tree (i.e. one past the last entry).
+   */
+  static BTreeNodeIterator End() {
+    return BTreeNodeIterator{};
+  }
+
+  /**
+   * Constructs an iterator pointing at the last entry in the tree represented
+   * by the given root node, or End() if the tree is empty.
+   */
+  static BTreeNodeIterator Last(const node_type* root) {
+    BTreeNodeIterator result;
+    if (root->empty()) {
+      return result;
+    }
+    const node_type* node = root;
+    for (; !node->is_leaf(); node = &node->child(node->width() - 1)) {
+      result.Push(node, node->width() - 1);
+    }
+    result.Push(node, node->width() - 1);
+    return result;
+  }
+
+  /**
+   * Constructs an iterator pointing to the first entry whose key is not less
+   * than the given key. If all entries in the tree are less than the given key,
+   * returns an equivalent to `End()`.
+   */
+  template <typename C>
+  static BTreeNodeIterator LowerBound(const node_type* root,
+                                      const key_type& key,
+                                      const C& comparator) {
+    BTreeNodeIterator result;
+    if (root->empty()) {
+      return result;
+    }
+
+    const node_type* node = root;
+    while (!node->is_leaf()) {
+      size_type index = node->ChildIndex(key, comparator);
+      result.Push(node, index);
+      node = &node->child(index);
+    }
+    result.Push(node, node->LowerBoundIndex(key, comparator));
+
+    // All the keys in the leaf are less than the key, so the lower bound is
+    // the first entry of the next leaf.
+    if (result.top().index == node->width()) {
+      result.Advance();
+    }
+    return result;
+  }
+
+  /**
+   * Constructs an iterator pointing to the entry at the given index in the
+   * tree represented by the given root node. If the index is not less than the
+   * size of the tree, returns an equivalent to `End()`.
+   */
+  static BTreeNodeIterator Nth(const node_type* root, size_type index) {
+    BTreeNodeIterator result;
+    if (index >= root->size()) {
+      return result;
+    }
+
+    const node_type* node = root;
+    while (!node->is_leaf()) {
+      size_type child = 0;
+      while (index >= node->child(child).size()) {
+        index -= node->child(child).size();
+        ++child;
+      }
+      result.Push(node, child);
+      node = &node->child(child);
+    }
+    result.Push(node, index);
+    return result;
+  }
+
+  /**
+   * Returns true if this iterator points at the end of the iteration sequence.
+   */
+  bool is_end() const {
+    return depth_ == 0;
+  }
+
+  /**
+   * Returns the address of the entry that this iterator points to. This can
+   * only be called if `is_end()` is false.
+   */
+  pointer get() const {
+    HARD_ASSERT(!is_end());
+    const Frame& leaf = top();
+    return &leaf.node->entry(leaf.index);
+  }
+
+  reference operator*() const {
+    return *get();
+  }
+
+  pointer operator->() const {
+    return get();
+  }
+
+  BTreeNodeIterator& operator++() {
+    HARD_ASSERT(!is_end());
+
+    Frame& leaf = top();
+    ++leaf.index;
+    if (leaf.index == leaf.node->width()) {
+      Advance();
+    }
+    return *this;
+  }
+
+  BTreeNodeIterator operator++(int /*unused*/) {
+    BTreeNodeIterator result = *this;
+    ++*this;
+    return result;
+  }
+
+  friend bool operator==(const BTreeNodeIterator& a,
+                         const BTreeNodeIterator& b) {
+    if (a.is_end() || b.is_end()) {
+      return a.is_end() == b.is_end();
+    }
+    return a.top().node == b.top().node && a.top().index == b.top().index;
+  }
+
+  bool operator!=(const BTreeNodeIterator& b) const {
+    return !(*this == b);
+  }
+
+ private:
+  struct Frame {
+    const node_type* node;
+    size_type index;
+  };
+
+  Frame& top() {
+    return stack_[depth_ - 1];
+  }
+  const Frame& top() const {
+    return stack_[depth_ - 1];
+  }
+
+  void Push(const node_type* node, size_type index) {
+    HARD_ASSERT(depth_ < kMaxDepth, "BTreeNode is too deep");
+    stack_[depth_++] = Frame{node, index};
+  }
+
+  /** Pushes the path from the given node to the first entry beneath it. */
+  void DescendFirst(const node_type* node) {
+    for (; !node->is_leaf(); node = &node->child(0)) {
+      Push(node, 0);
+    }
+    Push(node, 0);
+  }
+
+  /**
+   * Moves from a leaf that has been exhausted to the first entry of the next
+   * leaf, or to the end if there is none.
+   */
+  void Advance() {
+    --depth_;
+    while (depth_ > 0) {
+      Frame& parent = top();
+      ++parent.index;
+      if (parent.index < parent.node->width()) {
+        DescendFirst(&parent.node->child(parent.index));
+        return;
+      }
+      --depth_;
+    }
+  }
+
+  std::array<Frame, kMaxDepth> stack_{};
+  int depth_ = 0;
+};
+
+template <typename N>
+constexpr int BTreeNodeIterator<N>::kMaxDepth;
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_BTREE_NODE_ITERATOR_H_
@@ -0,0 +1,273 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_BTREE_SORTED_MAP_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_BTREE_SORTED_MAP_H_
+
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/immutable/btree_node.h"
+#include "Firestore/core/src/firebase/firestore/immutable/keys_view.h"
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_container.h"
+#include "Firestore/core/src/firebase/firestore/util/comparator_holder.h"
+#include "Firestore/core/src/firebase/firestore/util/comparison.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+/**
+ * BTreeSortedMap is a value type containing a map. It is immutable, but has
+ * methods to efficiently create new maps that are mutations of it.
+ *
+ * Compared with TreeSortedMap, which allocates a node per entry, the entries
+ * of a BTreeSortedMap are stored contiguously in wide leaves, so lookups touch
+ * far fewer cache lines and iteration mostly walks arrays.
+ */
+template <typename K, typename V, typename C = util::Comparator<K>>
+class BTreeSortedMap : public SortedMapBase, public util::ComparatorHolder<C> {
+ public:
+  /**
+   * The type of the entries stored in the map.
+   */
+  using value_type = std::pair<K, V>;
+
+  /**
+   * The type of the node containing entries of value_type.
+   */
+  using node_type = BTreeNode<K, V>;
+  using const_iterator = typename node_type::const_iterator;
+  using const_key_iterator = util::iterator_first<const_iterator>;
+
+  /**
+   * Creates an empty BTreeSortedMap.
+   */
+  explicit BTreeSortedMap(const C& comparator = {})
+      : util::ComparatorHolder<C>{comparator} {
+  }
+
+  /**
+   * Creates a BTreeSortedMap from a range of pairs to insert.
+   */
+  template <typename Range>
+  static BTreeSortedMap Create(const Range& range, const C& comparator) {
+    node_type node;
+    for (auto&& element : range) {
+      node = node.insert(element.first, element.second, comparator);
+    }
+    return BTreeSortedMap{std::move(node), comparator};
+  }
+
+  /**
+   * Creates a BTreeSortedMap from entries that are already sorted by key with
+   * no duplicates. Unlike Create, this takes O(n) time.
+   */
+  static BTreeSortedMap FromSorted(std::vector<value_type>&& entries,
+                                   const C& comparator) {
+    return BTreeSortedMap{node_type::FromSorted(std::move(entries)),
+                          comparator};
+  }
+
+  /** Returns true if the map contains no elements. */
+  bool empty() const {
+    return root_.empty();
+  }
+
+  /** Returns the number of items in this map. */
+  size_type size() const {
+    return root_.size();
+  }
+
+  const node_type& root() const {
+    return root_;
+  }
+
+  /**
+   * Creates a new map identical to this one, but with a key-value pair added or
+   * updated.
+   *
+   * @param key The key to insert/update.
+   * @param value The value to associate with the key.
+   * @return A new dictionary with the added/updated value.
+   */
+  BTreeSortedMap insert(const K& key, const V& value) const {
+    const C& comparator = this->comparator();
+    return BTreeSortedMap{root_.insert(key, value, comparator), comparator};
+  }
+
+  /**
+   * Creates a new map identical to this one, but with a key removed from it.
+   *
+   * @param key The key to remove.
+   * @return A new map without that value.
+   */
+  BTreeSortedMap erase(const K& key) const {
+    const C& comparator = this->comparator();
+    return BTreeSortedMap{root_.erase(key, comparator), comparator};
+  }
+
+  bool contains(const K& key) const {
+    // Inline the tree traversal here to avoid building up the stack required
+    // to construct a full iterator.
+    const C& comparator = this->comparator();
+    const node_type* node = &root_;
+    while (!node->is_leaf()) {
+      node = &node->child(node->ChildIndex(key, comparator));
+    }
+    size_type index = node->LowerBoundIndex(key, comparator);
+    return index < node->width() && !comparator(key, node->entry(index).first);
+  }
+
+  /**
+   * Finds a value in the map.
+   *
+   * @param key The key to look up.
+   * @return An iterator pointing to the entry containing the key, or end() if
+   *     not found.
+   */
+  const_iterator find(const K& key) const {
+    const_iterator found = lower_bound(key);
+    if (!found.is_end() && !this->comparator()(key, found->first)) {
+      return found;
+    } else {
+      return end();
+    }
+  }
+
+  /**
+   * Finds the index of the given key in the map.
+   *
+   * @param key The key to look up.
+   * @return The index of the entry containing the key, or npos if not found.
+   */
+  size_type find_index(const K& key) const {
+    const C& comparator = this->comparator();
+
+    size_type pruned_entries = 0;
+    const node_type* node = &root_;
+    while (!node->is_leaf()) {
+      size_type index = node->ChildIndex(key, comparator);
+      for (size_type i = 0; i < index; ++i) {
+        pruned_entries += node->child(i).size();
+      }
+      node = &node->child(index);
+    }
+
+    size_type index = node->LowerBoundIndex(key, comparator);
+    if (index < node->width() && !comparator(key, node->entry(index).first)) {
+      return pruned_entries + index;
+    }
+    return npos;
+  }
+
+  /**
+   * Returns an iterator pointing to the entry at the given index, or end() if
+   * the index is out of range. This is the inverse of find_index, and takes
+   * O(log(n)) time because every node knows the size of its subtree.
+   */
+  const_iterator nth(size_type index) const {
+    return const_iterator::Nth(&root_, index);
+  }
+
+  /**
+   * Finds the first entry in the map containing a key greater than or equal
+   * to the given key.
+   *
+   * @param key The key to look up.
+   * @return An iterator pointing to the entry containing the key or the next
+   *     largest key. Can return end() if all keys in the map are less than the
+   *     requested key.
+   */
+  const_iterator lower_bound(const K& key) const {
+    return const_iterator::LowerBound(&root_, key, this->comparator());
+  }
+
+  const_iterator min() const {
+    return begin();
+  }
+
+  const_iterator max() const {
+    return const_iterator::Last(&root_);
+  }
+
+  /**
+   * Returns a forward iterator pointing to the first entry in the map. If there
+   * are no entries in the map, begin() == end().
+   *
+   * See BTreeNodeIterator for details
+   */
+  const_iterator begin() const {
+    return const_iterator::Begin(&root_);
+  }
+
+  /**
+   * Returns an iterator pointing past the last entry in the map.
+   */
+  const_iterator end() const {
+    return const_iterator::End();
+  }
+
+  /**
+   * Calls `action` with each entry in the map, in order. Unlike iterating,
+   * this never has to keep the path to the current entry.
+   */
+  template <typename Action>
+  void ForEach(const Action& action) const {
+    root_.ForEach(action);
+  }
+
+  /**
+   * Returns a view of this SortedMap containing just the keys that have been
+   * inserted.
+   */
+  const util::range<const_key_iterator> keys() const {
+    return KeysView(*this);
+  }
+
+  /**
+   * Returns a view of this SortedMap containing just the keys that have been
+   * inserted that are greater than or equal to the given key.
+   */
+  const util::range<const_key_iterator> keys_from(const K& key) const {
+    return KeysViewFrom(*this, key);
+  }
+
+  /**
+   * Returns a view of this SortedMap containing just the keys that have been
+   * inserted that are greater than or equal to the given start_key and less
+   * than the given end_key.
+   */
+  const util::range<const_key_iterator> keys_in(const K& start_key,
+                                                const K& end_key) const {
+    return impl::KeysViewIn(*this, start_key, end_key, this->comparator());
+  }
+
+ private:
+  BTreeSortedMap(node_type&& root, const C& comparator) noexcept
+      : util::ComparatorHolder<C>{comparator}, root_{std::move(root)} {
+  }
+
+  node_type root_;
+};
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_BTREE_SORTED_MAP_H_
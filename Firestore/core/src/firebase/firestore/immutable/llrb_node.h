@@ -100,6 +100,17 @@ class LlrbNode : public SortedMapBase {
   template <typename Comparator>
   LlrbNode erase(const K& key, const Comparator& comparator) const;
 
+  /** Calls `action` with each entry at or beneath this node, in order. */
+  template <typename Action>
+  void ForEach(const Action& action) const {
+    // Recursing on the left keeps the depth at the height of the tree, which
+    // is logarithmic; looping on the right saves the rest of the calls.
+    for (const LlrbNode* node = this; !node->empty(); node = &node->right()) {
+      node->left().ForEach(action);
+      action(node->entry());
+    }
+  }
+
   const LlrbNode& min() const {
     const LlrbNode* node = this;
     while (!node->left().empty()) {
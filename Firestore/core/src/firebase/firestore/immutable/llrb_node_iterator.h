@@ -17,8 +17,9 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_LLRB_NODE_ITERATOR_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_LLRB_NODE_ITERATOR_H_
 
+#include <algorithm>
+#include <array>
 #include <iterator>
-#include <stack>
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/immutable/llrb_node.h"
@@ -30,6 +31,58 @@ namespace firestore {
 namespace immutable {
 namespace impl {
 
+/**
+ * The path of an LlrbNodeIterator, stored inline. The height of a
+ * left-leaning red-black tree is at most 2 lg(n + 1), and a tree can't hold
+ * more entries than its 31-bit sizes count, so the path never has more than
+ * kMaxDepth nodes.
+ */
+template <typename N>
+class LlrbNodeStack {
+ public:
+  static constexpr int kMaxDepth = 64;
+
+  LlrbNodeStack() {
+  }
+
+  // Only the part of the array in use is copied.
+  LlrbNodeStack(const LlrbNodeStack& other) : depth_{other.depth_} {
+    std::copy(other.nodes_.begin(), other.nodes_.begin() + depth_,
+              nodes_.begin());
+  }
+
+  LlrbNodeStack& operator=(const LlrbNodeStack& other) {
+    depth_ = other.depth_;
+    std::copy(other.nodes_.begin(), other.nodes_.begin() + depth_,
+              nodes_.begin());
+    return *this;
+  }
+
+  bool empty() const {
+    return depth_ == 0;
+  }
+
+  const N* top() const {
+    return nodes_[depth_ - 1];
+  }
+
+  void push(const N* node) {
+    HARD_ASSERT(depth_ < kMaxDepth, "LlrbNode is too deep");
+    nodes_[depth_++] = node;
+  }
+
+  void pop() {
+    --depth_;
+  }
+
+ private:
+  std::array<const N*, kMaxDepth> nodes_;
+  int depth_ = 0;
+};
+
+template <typename N>
+constexpr int LlrbNodeStack<N>::kMaxDepth;
+
 /**
  * A forward iterator for traversing LlrbNodes. LlrbNodes represent the nodes
  * in a tree implementing a sorted map so iterating with LlrbNodeIterator is
@@ -44,9 +97,12 @@ namespace impl {
  *
  * For an underlying tree of size `n`:
  *
- *   * LlrbNodeIterator uses `O(lg(n))` memory for its stack, and
+ *   * LlrbNodeIterator uses `O(lg(n))` memory for its stack, which is stored
+ *     inline so that creating or copying an iterator never allocates, and
  *   * incrementing an iterator is an `O(lg(n))` operation.
  *
+ * Visiting every entry is cheaper still through LlrbNode::ForEach.
+ *
  * ## Invalidation and Comparison
  *
  * LlrbNodeIterators compare based on the identity of the nodes themselves,
@@ -66,8 +122,9 @@ class LlrbNodeIterator {
  public:
   using node_type = N;
   using key_type = typename node_type::first_type;
+  using size_type = typename node_type::size_type;
 
-  using stack_type = std::stack<const node_type*>;
+  using stack_type = LlrbNodeStack<node_type>;
 
   using iterator_category = std::forward_iterator_tag;
   using value_type = typename node_type::value_type;
@@ -137,6 +194,36 @@ class LlrbNodeIterator {
     return LlrbNodeIterator{std::move(stack)};
   }
 
+  /**
+   * Constructs an iterator pointing to the node at the given index in the tree
+   * represented by the given root node. If the index is not less than the size
+   * of the tree, returns an equivalent to `End()`.
+   */
+  static LlrbNodeIterator Nth(const node_type* root, size_type index) {
+    stack_type stack;
+    if (index >= root->size()) {
+      return LlrbNodeIterator{std::move(stack)};
+    }
+
+    const node_type* node = root;
+    while (true) {
+      size_type left_size = node->left().size();
+      if (index == left_size) {
+        stack.push(node);
+        return LlrbNodeIterator{std::move(stack)};
+
+      } else if (index < left_size) {
+        // As in LowerBound, nodes to the right of the path are revisited by
+        // the iteration, so they go on the stack.
+        stack.push(node);
+        node = &node->left();
+      } else {
+        index -= left_size + 1;
+        node = &node->right();
+      }
+    }
+  }
+
   /**
    * Returns true if this iterator points at the end of the iteration sequence.
    */
@@ -63,11 +63,12 @@ class SortedMapBase : public SortedContainer {
    * The maximum size of an ArraySortedMap.
    *
    * This is the size threshold where we use a tree backed sorted map instead of
-   * an array backed sorted map. This is a more or less arbitrary chosen value,
-   * that was chosen to be large enough to fit most of object kind of Firebase
-   * data, but small enough to not notice degradation in performance for
-   * inserting and lookups. Feel free to empirically determine this constant,
-   * but don't expect much gain in real world performance.
+   * an array backed sorted map. The BM_Crossover benchmarks in
+   * sorted_map_benchmark.cc compare the two: with integer keys the array stays
+   * ahead well past this size, but with string keys, building a map by
+   * inserting falls behind the tree at around this size, and a larger value
+   * would also make every array backed map bigger, since the array is
+   * allocated at full size.
    */
   static constexpr size_type kFixedSize = 25;
 };
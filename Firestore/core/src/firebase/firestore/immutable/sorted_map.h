@@ -17,14 +17,19 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_MAP_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_MAP_H_
 
+#include <algorithm>
+#include <iterator>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/immutable/array_sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/immutable/btree_sorted_map.h"
 #include "Firestore/core/src/firebase/firestore/immutable/keys_view.h"
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_container.h"
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_map_iterator.h"
-#include "Firestore/core/src/firebase/firestore/immutable/tree_sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/util/comparator_holder.h"
 #include "Firestore/core/src/firebase/firestore/util/comparison.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "absl/base/attributes.h"
 
 namespace firebase {
@@ -34,6 +39,9 @@ namespace immutable {
 /**
  * SortedMap is a value type containing a map. It is immutable, but
  * has methods to efficiently create new maps that are mutations of it.
+ *
+ * Maps of up to kFixedSize entries are stored in a single array. Larger maps
+ * are stored in a persistent B-tree (see BTreeSortedMap).
  */
 template <typename K, typename V, typename C = util::Comparator<K>>
 class SortedMap : public SortedMapBase {
@@ -43,15 +51,17 @@ class SortedMap : public SortedMapBase {
   /** The type of the entries stored in the map. */
   using value_type = std::pair<K, V>;
   using array_type = impl::ArraySortedMap<K, V, C>;
-  using tree_type = impl::TreeSortedMap<K, V, C>;
+  using tree_type = impl::BTreeSortedMap<K, V, C>;
 
   using const_iterator = impl::SortedMapIterator<
       value_type,
       typename impl::FixedArray<value_type>::const_iterator,
-      typename impl::LlrbNode<K, V>::const_iterator>;
+      typename impl::BTreeNode<K, V>::const_iterator>;
 
   using const_key_iterator = util::iterator_first<const_iterator>;
 
+  class Builder;
+
   /**
    * Creates an empty SortedMap.
    */
@@ -100,7 +110,7 @@ class SortedMap : public SortedMapBase {
         array_.~ArraySortedMap();
         break;
       case Tag::Tree:
-        tree_.~TreeSortedMap();
+        tree_.~BTreeSortedMap();
         break;
     }
   }
@@ -179,7 +189,9 @@ class SortedMap : public SortedMapBase {
           // exactly where this cut-off happens and just unconditionally
           // converting if the next insertion could overflow keeps things
           // simpler.
-          tree_type tree = tree_type::Create(array_, comparator());
+          tree_type tree = tree_type::FromSorted(
+              std::vector<value_type>{array_.begin(), array_.end()},
+              comparator());
           return SortedMap{tree.insert(key, value)};
         } else {
           return SortedMap{array_.insert(key, value)};
@@ -211,6 +223,104 @@ class SortedMap : public SortedMapBase {
     UNREACHABLE();
   }
 
+  /**
+   * Creates a new map identical to this one, but with all the given key-value
+   * pairs added or updated. If the entries contain the same key more than
+   * once, the last value for that key wins, just as with repeated calls to
+   * insert.
+   *
+   * Batches that are small relative to the map are inserted one at a time;
+   * larger ones are merged with the contents of the map, and the result is
+   * built in a single pass. Entries that are already sorted by key, such as
+   * those of another SortedMap, are not sorted again.
+   *
+   * @param entries A range of key-value pairs.
+   * @return A new map with all the added/updated values.
+   */
+  template <typename Range>
+  ABSL_MUST_USE_RESULT SortedMap insert_all(const Range& entries) const {
+    const C& comparator = this->comparator();
+    std::vector<value_type> additions = SortedEntries(entries, comparator);
+    if (additions.empty()) {
+      return *this;
+    }
+    if (!IsBulkUpdate(additions.size())) {
+      SortedMap result = *this;
+      for (const value_type& addition : additions) {
+        result = result.insert(addition.first, addition.second);
+      }
+      return result;
+    }
+
+    std::vector<value_type> merged;
+    merged.reserve(size() + additions.size());
+    const_iterator existing = begin();
+    const_iterator existing_end = end();
+    for (value_type& addition : additions) {
+      while (existing != existing_end &&
+             comparator(existing->first, addition.first)) {
+        merged.push_back(*existing);
+        ++existing;
+      }
+      if (existing != existing_end &&
+          !comparator(addition.first, existing->first)) {
+        // The addition replaces the existing entry.
+        ++existing;
+      }
+      merged.push_back(std::move(addition));
+    }
+    for (; existing != existing_end; ++existing) {
+      merged.push_back(*existing);
+    }
+    return FromSorted(std::move(merged), comparator);
+  }
+
+  /**
+   * Creates a new map identical to this one, but with all the given keys
+   * removed from it. Keys that aren't in the map are ignored.
+   *
+   * As with insert_all, large batches are applied in a single pass over the
+   * map rather than one key at a time.
+   *
+   * @param keys A range of keys to remove.
+   * @return A new map without those keys.
+   */
+  template <typename Range>
+  ABSL_MUST_USE_RESULT SortedMap erase_all(const Range& keys) const {
+    const C& comparator = this->comparator();
+    std::vector<K> removals{std::begin(keys), std::end(keys)};
+    if (removals.empty()) {
+      return *this;
+    }
+    if (!IsBulkUpdate(removals.size())) {
+      SortedMap result = *this;
+      for (const K& removal : removals) {
+        result = result.erase(removal);
+      }
+      return result;
+    }
+
+    if (!std::is_sorted(removals.begin(), removals.end(), comparator)) {
+      std::sort(removals.begin(), removals.end(), comparator);
+    }
+
+    std::vector<value_type> kept;
+    kept.reserve(size());
+    auto removal = removals.begin();
+    for (const value_type& entry : *this) {
+      while (removal != removals.end() && comparator(*removal, entry.first)) {
+        ++removal;
+      }
+      if (removal == removals.end() || comparator(entry.first, *removal)) {
+        kept.push_back(entry);
+      }
+    }
+    if (kept.size() == size()) {
+      return *this;
+    }
+    return FromSorted(std::move(kept), comparator);
+  }
+
   bool contains(const K& key) const {
     switch (tag_) {
       case Tag::Array:
@@ -254,6 +364,20 @@ class SortedMap : public SortedMapBase {
     UNREACHABLE();
   }
 
+  /**
+   * Returns an iterator pointing to the entry at the given index, or end() if
+   * the index is out of range. This is the inverse of find_index.
+   */
+  const_iterator nth(size_type index) const {
+    switch (tag_) {
+      case Tag::Array:
+        return const_iterator(array_.nth(index));
+      case Tag::Tree:
+        return const_iterator{tree_.nth(index)};
+    }
+    UNREACHABLE();
+  }
+
   /**
    * Finds the first entry in the map containing a key greater than or equal
    * to the given key.
@@ -320,6 +444,23 @@ class SortedMap : public SortedMapBase {
     UNREACHABLE();
   }
 
+  /**
+   * Calls `action` with each entry in the map, in order. This is cheaper than
+   * iterating over a large map, since no iterator has to be advanced.
+   */
+  template <typename Action>
+  void ForEach(const Action& action) const {
+    switch (tag_) {
+      case Tag::Array:
+        array_.ForEach(action);
+        return;
+      case Tag::Tree:
+        tree_.ForEach(action);
+        return;
+    }
+    UNREACHABLE();
+  }
+
   /**
    * Returns a view of this SortedMap containing just the keys that have been
    * inserted.
@@ -346,15 +487,18 @@ class SortedMap : public SortedMapBase {
     return impl::KeysViewIn(*this, start_key, end_key, comparator());
   }
 
- private:
-  explicit SortedMap(array_type&& array)
-      : tag_{Tag::Array}, array_{std::move(array)} {
-  }
-
-  explicit SortedMap(tree_type&& tree)
-      : tag_{Tag::Tree}, tree_{std::move(tree)} {
+  /**
+   * Returns true if a batch of `count` changes should be applied by rebuilding
+   * the map rather than by a sequence of individual changes. Each individual
+   * change copies the full path from the root to a leaf, kMaxWidth entries or
+   * children at every level, so rebuilding wins once the batch is a sizable
+   * fraction of the map.
+   */
+  bool IsBulkUpdate(size_t count) const {
+    return count * tree_type::node_type::kMaxWidth >= size();
   }
 
+  /** Returns the comparator that orders the keys of this map. */
   const C& comparator() const {
     switch (tag_) {
       case Tag::Array:
@@ -365,6 +509,60 @@ class SortedMap : public SortedMapBase {
     UNREACHABLE();
   }
 
+ private:
+  explicit SortedMap(array_type&& array)
+      : tag_{Tag::Array}, array_{std::move(array)} {
+  }
+
+  explicit SortedMap(tree_type&& tree)
+      : tag_{Tag::Tree}, tree_{std::move(tree)} {
+  }
+
+  /**
+   * Creates a SortedMap from entries that are already sorted by key with no
+   * duplicates, using whichever representation suits their number.
+   */
+  static SortedMap FromSorted(std::vector<value_type>&& entries,
+                              const C& comparator) {
+    if (entries.size() <= kFixedSize) {
+      return SortedMap{array_type::FromSorted(std::move(entries), comparator)};
+    }
+    return SortedMap{tree_type::FromSorted(std::move(entries), comparator)};
+  }
+
+  /**
+   * Copies the given range of entries into a vector sorted by key, keeping
+   * only the last entry for each key.
+   */
+  template <typename Range>
+  static std::vector<value_type> SortedEntries(const Range& range,
+                                               const C& comparator) {
+    auto entry_less = [&comparator](const value_type& lhs,
+                                    const value_type& rhs) {
+      return comparator(lhs.first, rhs.first);
+    };
+
+    std::vector<value_type> entries{std::begin(range), std::end(range)};
+    if (!std::is_sorted(entries.begin(), entries.end(), entry_less)) {
+      std::stable_sort(entries.begin(), entries.end(), entry_less);
+    }
+
+    auto out = entries.begin();
+    for (auto in = entries.begin(); in != entries.end(); ++in) {
+      auto next = std::next(in);
+      if (next != entries.end() && !entry_less(*in, *next)) {
+        // Superseded by a later entry with the same key.
+        continue;
+      }
+      if (out != in) {
+        *out = std::move(*in);
+      }
+      ++out;
+    }
+    entries.erase(out, entries.end());
+    return entries;
+  }
+
   enum class Tag {
     Array,
     Tree,
@@ -377,6 +575,64 @@ class SortedMap : public SortedMapBase {
   };
 };
 
+/**
+ * Builds a SortedMap from entries supplied in increasing key order, such as
+ * the rows of an ordered LevelDB scan, in O(n) time. Building with insert
+ * instead would create, and then discard, a new version of the map for every
+ * entry.
+ */
+template <typename K, typename V, typename C>
+class SortedMap<K, V, C>::Builder : public util::ComparatorHolder<C> {
+ public:
+  explicit Builder(const C& comparator = {})
+      : util::ComparatorHolder<C>{comparator} {
+  }
+
+  /**
+   * Appends an entry to the map being built. The key must be greater than the
+   * key of every entry appended previously.
+   */
+  void push_back(const K& key, const V& value) {
+    HARD_ASSERT(
+        entries_.empty() || this->comparator()(entries_.back().first, key),
+        "SortedMap::Builder entries must be appended in increasing key order");
+    entries_.emplace_back(key, value);
+  }
+
+  void push_back(K&& key, V&& value) {
+    HARD_ASSERT(
+        entries_.empty() || this->comparator()(entries_.back().first, key),
+        "SortedMap::Builder entries must be appended in increasing key order");
+    entries_.emplace_back(std::move(key), std::move(value));
+  }
+
+  /**
+   * Reserves room for `count` entries, for callers that know (or can bound)
+   * the size of the map ahead of time.
+   */
+  void reserve(size_type count) {
+    entries_.reserve(count);
+  }
+
+  /** Returns the number of entries appended so far. */
+  size_type size() const {
+    return static_cast<size_type>(entries_.size());
+  }
+
+  /**
+   * Returns a map containing every entry appended so far, and leaves this
+   * builder empty.
+   */
+  SortedMap Build() {
+    std::vector<value_type> entries;
+    entries.swap(entries_);
+    return SortedMap::FromSorted(std::move(entries), this->comparator());
+  }
+
+ private:
+  std::vector<value_type> entries_;
+};
+
 }  // namespace immutable
 }  // namespace firestore
 }  // namespace firebase
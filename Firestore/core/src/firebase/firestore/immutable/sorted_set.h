@@ -19,6 +19,7 @@
 
 #include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_container.h"
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
@@ -53,6 +54,8 @@ class SortedSet : public SortedContainer {
 
   using const_iterator = typename M::const_key_iterator;
 
+  class Builder;
+
   explicit SortedSet(const C& comparator = C()) : map_{comparator} {
   }
 
@@ -85,6 +88,102 @@ class SortedSet : public SortedContainer {
     return SortedSet{map_.erase(key)};
   }
 
+  /**
+   * Returns a set with all the given keys added. See SortedMap::insert_all.
+   */
+  template <typename Range>
+  ABSL_MUST_USE_RESULT SortedSet insert_all(const Range& keys) const {
+    std::vector<std::pair<K, V>> entries;
+    for (const K& key : keys) {
+      entries.emplace_back(key, V{});
+    }
+    return SortedSet{map_.insert_all(entries)};
+  }
+
+  /**
+   * Returns a set with all the given keys removed. See SortedMap::erase_all.
+   */
+  template <typename Range>
+  ABSL_MUST_USE_RESULT SortedSet erase_all(const Range& keys) const {
+    return SortedSet{map_.erase_all(keys)};
+  }
+
+  /**
+   * Returns a set with the keys that are in this set, `other`, or both.
+   *
+   * If one of the sets is much smaller than the other, its keys are added to
+   * the larger one individually, so the result shares most of the larger
+   * set's structure. Otherwise both sets are merged in a single linear pass.
+   */
+  ABSL_MUST_USE_RESULT SortedSet Union(const SortedSet& other) const {
+    if (size() < other.size()) {
+      return other.Union(*this);
+    }
+    if (!map_.IsBulkUpdate(other.size())) {
+      SortedSet result = *this;
+      for (const K& key : other) {
+        if (!result.contains(key)) {
+          result = result.insert(key);
+        }
+      }
+      return result;
+    }
+    return Merge(other, MergeKeep::kUnion);
+  }
+
+  /**
+   * Returns a set with the keys that are in both this set and `other`.
+   *
+   * If one of the sets is much smaller than the other, only its keys are
+   * looked up in the larger one. Otherwise both sets are merged in a single
+   * linear pass.
+   */
+  ABSL_MUST_USE_RESULT SortedSet Intersect(const SortedSet& other) const {
+    if (size() < other.size()) {
+      return other.Intersect(*this);
+    }
+    if (!map_.IsBulkUpdate(other.size())) {
+      Builder result{map_.comparator()};
+      for (const K& key : other) {
+        if (contains(key)) {
+          result.push_back(key);
+        }
+      }
+      return result.size() == other.size() ? other : result.Build();
+    }
+    return Merge(other, MergeKeep::kIntersection);
+  }
+
+  /**
+   * Returns a set with the keys of this set that aren't in `other`.
+   *
+   * If `other` is much smaller than this set, its keys are removed
+   * individually, so the result shares most of this set's structure. If this
+   * set is much smaller, only its keys are looked up in `other`. Otherwise
+   * both sets are merged in a single linear pass.
+   */
+  ABSL_MUST_USE_RESULT SortedSet Difference(const SortedSet& other) const {
+    if (!map_.IsBulkUpdate(other.size())) {
+      SortedSet result = *this;
+      for (const K& key : other) {
+        if (result.contains(key)) {
+          result = result.erase(key);
+        }
+      }
+      return result;
+    }
+    if (!other.map_.IsBulkUpdate(size())) {
+      Builder result{map_.comparator()};
+      for (const K& key : *this) {
+        if (!other.contains(key)) {
+          result.push_back(key);
+        }
+      }
+      return result.size() == size() ? *this : result.Build();
+    }
+    return Merge(other, MergeKeep::kDifference);
+  }
+
   bool contains(const K& key) const {
     return map_.contains(key);
   }
@@ -97,6 +196,11 @@ class SortedSet : public SortedContainer {
     return map_.find_index(key);
   }
 
+  /** Returns an iterator pointing to the key at the given index. */
+  const_iterator nth(size_type index) const {
+    return const_iterator{map_.nth(index)};
+  }
+
   const_iterator min() const {
     return const_iterator{map_.min()};
   }
@@ -113,6 +217,14 @@ class SortedSet : public SortedContainer {
     return const_iterator{map_.end()};
   }
 
+  /** Calls `action` with each value in the set, in order. */
+  template <typename Action>
+  void ForEach(const Action& action) const {
+    map_.ForEach([&action](const typename M::value_type& entry) {
+      action(entry.first);
+    });
+  }
+
   /**
    * Returns a view of this SortedSet containing just the keys that have been
    * inserted that are greater than or equal to the given key.
@@ -143,9 +255,109 @@ class SortedSet : public SortedContainer {
   }
 
  private:
+  /** Which keys of a merge of two sets end up in the result. */
+  enum class MergeKeep {
+    kUnion,
+    kIntersection,
+    kDifference,
+  };
+
+  /**
+   * Merges the keys of this set with those of `other` in a single pass,
+   * building a new set from the keys `keep` selects. Returns one of the sets
+   * itself if the result would contain exactly its keys.
+   */
+  SortedSet Merge(const SortedSet& other, MergeKeep keep) const {
+    const C& comparator = map_.comparator();
+    bool keep_this_only = keep != MergeKeep::kIntersection;
+    bool keep_both = keep != MergeKeep::kDifference;
+    bool keep_other_only = keep == MergeKeep::kUnion;
+
+    Builder result{comparator};
+    result.reserve(keep == MergeKeep::kUnion ? size() + other.size() : size());
+    const_iterator lhs = begin();
+    const_iterator lhs_end = end();
+    const_iterator rhs = other.begin();
+    const_iterator rhs_end = other.end();
+    while (lhs != lhs_end && rhs != rhs_end) {
+      if (comparator(*lhs, *rhs)) {
+        if (keep_this_only) result.push_back(*lhs);
+        ++lhs;
+      } else if (comparator(*rhs, *lhs)) {
+        if (keep_other_only) result.push_back(*rhs);
+        ++rhs;
+      } else {
+        if (keep_both) result.push_back(*lhs);
+        ++lhs;
+        ++rhs;
+      }
+    }
+    if (keep_this_only) {
+      for (; lhs != lhs_end; ++lhs) result.push_back(*lhs);
+    }
+    if (keep_other_only) {
+      for (; rhs != rhs_end; ++rhs) result.push_back(*rhs);
+    }
+
+    // Each kind of merge only ever adds keys to this set or only ever drops
+    // them, so an unchanged size means unchanged contents. The same holds for
+    // `other` in unions and intersections.
+    if (result.size() == size()) {
+      return *this;
+    }
+    if (keep != MergeKeep::kDifference && result.size() == other.size()) {
+      return other;
+    }
+    return result.Build();
+  }
+
   M map_;
 };
 
+/**
+ * Builds a SortedSet from keys supplied in increasing order in O(n) time. See
+ * SortedMap::Builder.
+ */
+template <typename K, typename C, typename V, typename M>
+class SortedSet<K, C, V, M>::Builder {
+ public:
+  explicit Builder(const C& comparator = {}) : map_builder_{comparator} {
+  }
+
+  /**
+   * Appends a key to the set being built. The key must be greater than every
+   * key appended previously.
+   */
+  void push_back(const K& key) {
+    map_builder_.push_back(key, {});
+  }
+
+  void push_back(K&& key) {
+    map_builder_.push_back(std::move(key), V{});
+  }
+
+  /** Reserves room for `count` keys. See SortedMap::Builder::reserve. */
+  void reserve(size_type count) {
+    map_builder_.reserve(count);
+  }
+
+  /** Returns the number of keys appended so far. */
+  size_type size() const {
+    return map_builder_.size();
+  }
+
+  /**
+   * Returns a set containing every key appended so far, and leaves this
+   * builder empty.
+   */
+  SortedSet Build() {
+    return SortedSet{map_builder_.Build()};
+  }
+
+ private:
+  typename M::Builder map_builder_;
+};
+
 template <typename K, typename C, typename V>
 SortedSet<K, C, V> MakeSortedSet(const SortedMap<K, V, C>& map) {
   return SortedSet<K, C, V>{map};
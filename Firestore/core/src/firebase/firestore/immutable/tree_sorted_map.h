@@ -172,6 +172,14 @@ class TreeSortedMap : public SortedMapBase, public util::ComparatorHolder<C> {
     return npos;
   }
 
+  /**
+   * Returns an iterator pointing to the entry at the given index, or end() if
+   * the index is out of range. This is the inverse of find_index.
+   */
+  const_iterator nth(size_type index) const {
+    return const_iterator::Nth(&root_, index);
+  }
+
   /**
    * Finds the first entry in the map containing a key greater than or equal
    * to the given key.
@@ -217,6 +225,15 @@ class TreeSortedMap : public SortedMapBase, public util::ComparatorHolder<C> {
     return const_iterator::End();
   }
 
+  /**
+   * Calls `action` with each entry in the map, in order. Unlike iterating,
+   * this never has to keep the path to the current entry.
+   */
+  template <typename Action>
+  void ForEach(const Action& action) const {
+    root_.ForEach(action);
+  }
+
   /**
    * Returns a view of this SortedMap containing just the keys that have been
    * inserted.
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_AGGREGATION_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_AGGREGATION_H_
+
+#if !defined(__OBJC__)
+#error "For now, this file must only be included by ObjC source files."
+#endif  // !defined(__OBJC__)
+
+#import <Foundation/Foundation.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+
+@class FSTDocument;
+@class FSTFieldValue;
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * An aggregate computed over all documents matching a query: the number of
+ * documents, or the sum or average of a numeric field.
+ */
+class AggregateField {
+ public:
+  enum class Kind {
+    Count,
+    Sum,
+    Average,
+  };
+
+  static AggregateField Count() {
+    return AggregateField{Kind::Count, model::FieldPath{}};
+  }
+
+  static AggregateField Sum(model::FieldPath field_path) {
+    return AggregateField{Kind::Sum, std::move(field_path)};
+  }
+
+  static AggregateField Average(model::FieldPath field_path) {
+    return AggregateField{Kind::Average, std::move(field_path)};
+  }
+
+  Kind kind() const {
+    return kind_;
+  }
+
+  /** The field summed or averaged. Empty for a count. */
+  const model::FieldPath& field_path() const {
+    return field_path_;
+  }
+
+ private:
+  AggregateField(Kind kind, model::FieldPath field_path)
+      : kind_{kind}, field_path_{std::move(field_path)} {
+  }
+
+  Kind kind_;
+  model::FieldPath field_path_;
+};
+
+/**
+ * Computes a set of aggregates over documents that are added one at a time, so
+ * that the documents don't have to be kept around.
+ *
+ * Sums and averages only look at fields holding integers or doubles; other
+ * values (and missing fields) are skipped, as the backend does.
+ */
+class Aggregator {
+ public:
+  explicit Aggregator(std::vector<AggregateField> fields);
+
+  void Add(FSTDocument* document);
+
+  /**
+   * Returns the value of each aggregate, in the order of the fields given at
+   * construction:
+   *
+   *   * a count is an integer;
+   *   * a sum is an integer if every summed value was an integer and the sum
+   *     fits in 64 bits, and a double otherwise;
+   *   * an average is a double, or null if no numeric values were seen.
+   */
+  std::vector<FSTFieldValue*> Results() const;
+
+ private:
+  struct Accumulator {
+    int64_t count = 0;
+    int64_t integer_sum = 0;
+    double double_sum = 0;
+    bool is_double = false;
+  };
+
+  void Accumulate(Accumulator* accumulator, FSTFieldValue* _Nullable value);
+
+  std::vector<AggregateField> fields_;
+  std::vector<Accumulator> accumulators_;
+  int64_t document_count_ = 0;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_AGGREGATION_H_
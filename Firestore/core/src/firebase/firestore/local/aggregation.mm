@@ -0,0 +1,124 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/aggregation.h"
+
+#include <limits>
+#include <utility>
+
+#import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Model/FSTFieldValue.h"
+
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+using model::FieldValue;
+
+bool AddWouldOverflow(int64_t x, int64_t y) {
+  return (y > 0 && x > std::numeric_limits<int64_t>::max() - y) ||
+         (y < 0 && x < std::numeric_limits<int64_t>::min() - y);
+}
+
+}  // namespace
+
+Aggregator::Aggregator(std::vector<AggregateField> fields)
+    : fields_{std::move(fields)}, accumulators_(fields_.size()) {
+}
+
+void Aggregator::Add(FSTDocument* document) {
+  ++document_count_;
+  for (size_t i = 0; i < fields_.size(); ++i) {
+    const AggregateField& field = fields_[i];
+    if (field.kind() != AggregateField::Kind::Count) {
+      Accumulate(&accumulators_[i], [document fieldForPath:field.field_path()]);
+    }
+  }
+}
+
+void Aggregator::Accumulate(Accumulator* accumulator,
+                            FSTFieldValue* _Nullable value) {
+  if (!value) {
+    return;
+  }
+
+  if (value.type == FieldValue::Type::Integer) {
+    int64_t integer = static_cast<FSTIntegerValue*>(value).internalValue;
+    accumulator->double_sum += static_cast<double>(integer);
+    if (accumulator->is_double ||
+        AddWouldOverflow(accumulator->integer_sum, integer)) {
+      accumulator->is_double = true;
+    } else {
+      accumulator->integer_sum += integer;
+    }
+  } else if (value.type == FieldValue::Type::Double) {
+    double number = static_cast<FSTDoubleValue*>(value).internalValue;
+    accumulator->double_sum += number;
+    accumulator->is_double = true;
+  } else {
+    return;
+  }
+
+  ++accumulator->count;
+}
+
+std::vector<FSTFieldValue*> Aggregator::Results() const {
+  std::vector<FSTFieldValue*> results;
+  results.reserve(fields_.size());
+
+  for (size_t i = 0; i < fields_.size(); ++i) {
+    const Accumulator& accumulator = accumulators_[i];
+    switch (fields_[i].kind()) {
+      case AggregateField::Kind::Count:
+        results.push_back([FSTIntegerValue integerValue:document_count_]);
+        break;
+
+      case AggregateField::Kind::Sum:
+        if (accumulator.is_double) {
+          results.push_back(
+              [FSTDoubleValue doubleValue:accumulator.double_sum]);
+        } else {
+          results.push_back(
+              [FSTIntegerValue integerValue:accumulator.integer_sum]);
+        }
+        break;
+
+      case AggregateField::Kind::Average:
+        if (accumulator.count == 0) {
+          results.push_back([FSTNullValue nullValue]);
+        } else {
+          results.push_back([FSTDoubleValue
+              doubleValue:accumulator.double_sum /
+                          static_cast<double>(accumulator.count)]);
+        }
+        break;
+    }
+  }
+
+  return results;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,169 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/bundle.h"
+
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/wire_reader.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/wire_writer.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+using model::DocumentKey;
+using model::ResourcePath;
+using nanopb::WireReader;
+using nanopb::WireWriter;
+
+/** The magic and format version at the start of every bundle. */
+const char kBundleHeader[] = "FSTBndl\x01";
+const size_t kBundleHeaderSize = sizeof(kBundleHeader) - 1;
+
+// Field numbers, see the messages in the header.
+const uint32_t kBundleDocument = 1;
+const uint32_t kBundleQuery = 2;
+const uint32_t kQueryName = 1;
+const uint32_t kQueryTarget = 2;
+const uint32_t kQueryDocumentKey = 3;
+
+}  // namespace
+
+BundleReader::BundleReader(absl::string_view bundle) {
+  if (!absl::StartsWith(bundle, {kBundleHeader, kBundleHeaderSize})) {
+    Fail("Not a bundle, or a bundle format version that isn't supported");
+    return;
+  }
+  rest_ = bundle.substr(kBundleHeaderSize);
+}
+
+bool BundleReader::Next() {
+  WireReader reader{rest_};
+  uint32_t field_number = 0;
+  pb_wire_type_t wire_type = PB_WT_VARINT;
+  while (status_.ok() && reader.ReadTag(&field_number, &wire_type)) {
+    bool known = (field_number == kBundleDocument ||
+                  field_number == kBundleQuery) &&
+                 wire_type == PB_WT_STRING;
+    if (!known) {
+      // Skip elements added by later versions of the format.
+      reader.SkipField(wire_type);
+      continue;
+    }
+
+    absl::string_view element = reader.ReadLengthDelimited();
+    if (!reader.ok()) break;
+    rest_ = reader.remaining();
+
+    if (field_number == kBundleDocument) {
+      type_ = ElementType::Document;
+      document_ = element;
+      return true;
+    }
+
+    type_ = ElementType::Query;
+    return ReadQuery(element);
+  }
+
+  if (!reader.ok()) {
+    return Fail("Bundle is truncated or corrupt");
+  }
+  rest_ = {};
+  return false;
+}
+
+bool BundleReader::ReadQuery(absl::string_view message) {
+  query_ = BundledQuery{};
+
+  WireReader reader{message};
+  uint32_t field_number = 0;
+  pb_wire_type_t wire_type = PB_WT_VARINT;
+  while (reader.ReadTag(&field_number, &wire_type)) {
+    if (wire_type != PB_WT_STRING) {
+      reader.SkipField(wire_type);
+      continue;
+    }
+
+    absl::string_view value = reader.ReadLengthDelimited();
+    if (field_number == kQueryName) {
+      query_.name = value;
+    } else if (field_number == kQueryTarget) {
+      query_.target = value;
+    } else if (field_number == kQueryDocumentKey) {
+      // Check everything ResourcePath and DocumentKey would assert on.
+      ResourcePath path = value.find("//") == absl::string_view::npos
+                              ? ResourcePath::FromString(value)
+                              : ResourcePath{};
+      if (path.empty() || !DocumentKey::IsDocumentKey(path)) {
+        return Fail(
+            absl::StrCat("Bundled query has an invalid document key: ", value));
+      }
+      query_.matching_keys.push_back(DocumentKey{std::move(path)});
+    }
+  }
+
+  if (!reader.ok()) {
+    return Fail("Bundled query is corrupt");
+  }
+  if (query_.target.empty()) {
+    return Fail(absl::StrCat("Bundled query ", query_.name, " has no target"));
+  }
+  return true;
+}
+
+bool BundleReader::Fail(absl::string_view description) {
+  status_ = util::Status{FirestoreErrorCode::DataLoss, description};
+  rest_ = {};
+  return false;
+}
+
+BundleWriter::BundleWriter() : bundle_(kBundleHeader, kBundleHeaderSize) {
+}
+
+void BundleWriter::AddDocument(absl::string_view document) {
+  WireWriter writer{&bundle_};
+  writer.WriteTag(kBundleDocument, PB_WT_STRING);
+  writer.WriteLengthDelimited(document);
+}
+
+void BundleWriter::AddQuery(absl::string_view name,
+                            absl::string_view target,
+                            const std::vector<DocumentKey>& matching_keys) {
+  std::string query;
+  WireWriter query_writer{&query};
+  query_writer.WriteTag(kQueryName, PB_WT_STRING);
+  query_writer.WriteLengthDelimited(name);
+  query_writer.WriteTag(kQueryTarget, PB_WT_STRING);
+  query_writer.WriteLengthDelimited(target);
+  for (const DocumentKey& key : matching_keys) {
+    query_writer.WriteTag(kQueryDocumentKey, PB_WT_STRING);
+    query_writer.WriteLengthDelimited(key.path().CanonicalString());
+  }
+
+  WireWriter writer{&bundle_};
+  writer.WriteTag(kBundleQuery, PB_WT_STRING);
+  writer.WriteLengthDelimited(query);
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
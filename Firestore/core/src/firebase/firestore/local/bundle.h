@@ -0,0 +1,148 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_BUNDLE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_BUNDLE_H_
+
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+// A bundle is a pre-built file of documents and query results, shipped with an
+// app or downloaded separately, that primes the local cache so that listeners
+// only need to fetch what changed since the bundle was built.
+//
+// A bundle starts with an 8 byte header (the magic "FSTBndl" and a format
+// version byte), followed by the fields of a message in protocol buffer wire
+// format, one per element of the bundle:
+//
+//   message Bundle {
+//     // A document, as stored in the remote document cache.
+//     repeated firestore.client.MaybeDocument document = 1;
+//     repeated NamedQuery query = 2;
+//   }
+//
+//   message NamedQuery {
+//     string name = 1;
+//     // The query, along with the resume token and snapshot version it had
+//     // when the bundle was built. The target ID is ignored.
+//     firestore.client.Target target = 2;
+//     // The paths of the documents matching the query, e.g. "rooms/eros".
+//     repeated string document_key = 3;
+//   }
+//
+// Elements are read one at a time, so a bundle can be read straight from a
+// MappedFile without ever being copied in full.
+
+/** A query result read from a bundle. */
+struct BundledQuery {
+  /** The name the bundle gives the query, by which the app can look it up. */
+  absl::string_view name;
+
+  /** The serialized firestore.client.Target holding the query. */
+  absl::string_view target;
+
+  std::vector<model::DocumentKey> matching_keys;
+};
+
+/**
+ * Reads the elements of a bundle in order. The reader doesn't own the bundle,
+ * and the string_views it returns point into it.
+ */
+class BundleReader {
+ public:
+  enum class ElementType {
+    Document,
+    Query,
+  };
+
+  explicit BundleReader(absl::string_view bundle);
+
+  /**
+   * Advances to the next element, returning false once there are none left or
+   * if the bundle is malformed (in which case `status()` is an error).
+   */
+  bool Next();
+
+  ElementType type() const {
+    return type_;
+  }
+
+  /**
+   * The current element, a serialized firestore.client.MaybeDocument, if
+   * `type()` is Document.
+   */
+  absl::string_view document() const {
+    return document_;
+  }
+
+  /** The current element, if `type()` is Query. */
+  const BundledQuery& query() const {
+    return query_;
+  }
+
+  const util::Status& status() const {
+    return status_;
+  }
+
+ private:
+  bool Fail(absl::string_view description);
+  bool ReadQuery(absl::string_view message);
+
+  absl::string_view rest_;
+  util::Status status_;
+
+  ElementType type_ = ElementType::Document;
+  absl::string_view document_;
+  BundledQuery query_;
+};
+
+/** Builds a bundle in memory, see BundleReader. */
+class BundleWriter {
+ public:
+  BundleWriter();
+
+  /** Adds a serialized firestore.client.MaybeDocument. */
+  void AddDocument(absl::string_view document);
+
+  /**
+   * Adds a query, given as a serialized firestore.client.Target, under the
+   * given name.
+   */
+  void AddQuery(absl::string_view name,
+                absl::string_view target,
+                const std::vector<model::DocumentKey>& matching_keys);
+
+  const std::string& bundle() const {
+    return bundle_;
+  }
+
+ private:
+  std::string bundle_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_BUNDLE_H_
@@ -0,0 +1,39 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/field_index.h"
+
+#include "absl/strings/str_cat.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+std::string FieldIndex::ToString() const {
+  return absl::StrCat(
+      "FieldIndex(collection_id=", collection_id_,
+      ", field_path=", field_path_.CanonicalString(),
+      kind_ == Kind::ArrayContains ? ", kind=array_contains" : "", ")");
+}
+
+bool operator==(const FieldIndex& lhs, const FieldIndex& rhs) {
+  return lhs.collection_id_ == rhs.collection_id_ &&
+         lhs.field_path_ == rhs.field_path_ && lhs.kind_ == rhs.kind_;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_FIELD_INDEX_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_FIELD_INDEX_H_
+
+#include <string>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Declares a client-side secondary index over a single field of all documents
+ * in collections with the given collection ID (e.g. all documents in any
+ * 'messages' collection, indexed by 'timestamp').
+ *
+ * Index entries are kept per collection path, so a FieldIndex serves both
+ * collection queries and the per-parent collection queries that make up a
+ * collection group query.
+ */
+class FieldIndex {
+ public:
+  /** What the entries of an index map to the documents that have them. */
+  enum class Kind {
+    /**
+     * The value of the field, which serves filters comparing the field and
+     * orderBys on it.
+     */
+    Value,
+
+    /**
+     * Each distinct element of the field if it's an array, which serves
+     * array-contains filters on the field.
+     */
+    ArrayContains,
+  };
+
+  FieldIndex(std::string collection_id,
+             model::FieldPath field_path,
+             Kind kind = Kind::Value)
+      : collection_id_{std::move(collection_id)},
+        field_path_{std::move(field_path)},
+        kind_{kind} {
+  }
+
+  const std::string& collection_id() const {
+    return collection_id_;
+  }
+
+  const model::FieldPath& field_path() const {
+    return field_path_;
+  }
+
+  Kind kind() const {
+    return kind_;
+  }
+
+  std::string ToString() const;
+
+  friend bool operator==(const FieldIndex& lhs, const FieldIndex& rhs);
+
+ private:
+  std::string collection_id_;
+  model::FieldPath field_path_;
+  Kind kind_;
+};
+
+inline bool operator!=(const FieldIndex& lhs, const FieldIndex& rhs) {
+  return !(lhs == rhs);
+}
+
+/**
+ * A contiguous range of entries in a FieldIndex, expressed in terms of encoded
+ * index values (whose byte order matches the Firestore ordering of the values
+ * they encode). For an array-contains index, the values are array elements.
+ *
+ * The lower bound is inclusive, the upper bound is exclusive. An absent upper
+ * bound scans to the end of the index.
+ *
+ * Ranges are allowed to be wider than the filter they were derived from:
+ * results of an index scan are always re-filtered against the query.
+ */
+class FieldIndexRange {
+ public:
+  FieldIndexRange(FieldIndex index,
+                  std::string lower_bound,
+                  absl::optional<std::string> upper_bound)
+      : index_{std::move(index)},
+        lower_bound_{std::move(lower_bound)},
+        upper_bound_{std::move(upper_bound)} {
+  }
+
+  /** Creates a range that spans every entry in the given index. */
+  static FieldIndexRange All(FieldIndex index) {
+    return FieldIndexRange{std::move(index), "", absl::nullopt};
+  }
+
+  const FieldIndex& index() const {
+    return index_;
+  }
+
+  const std::string& lower_bound() const {
+    return lower_bound_;
+  }
+
+  const absl::optional<std::string>& upper_bound() const {
+    return upper_bound_;
+  }
+
+  /** Returns true if the given encoded index value falls within the range. */
+  bool Contains(absl::string_view encoded_value) const {
+    return encoded_value >= lower_bound_ &&
+           (!upper_bound_ || encoded_value < *upper_bound_);
+  }
+
+  /**
+   * Returns true if the given encoded index value sorts at or after the end of
+   * the range, which means a forward scan can stop.
+   */
+  bool IsPastEnd(absl::string_view encoded_value) const {
+    return upper_bound_ && encoded_value >= *upper_bound_;
+  }
+
+ private:
+  FieldIndex index_;
+  std::string lower_bound_;
+  absl::optional<std::string> upper_bound_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_FIELD_INDEX_H_
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_FIELD_INDEX_ENCODING_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_FIELD_INDEX_ENCODING_H_
+
+#if !defined(__OBJC__)
+#error "For now, this file must only be included by ObjC source files."
+#endif  // !defined(__OBJC__)
+
+#import <Foundation/Foundation.h>
+
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/local/field_index.h"
+#include "absl/types/optional.h"
+
+@class FSTFieldValue;
+@class FSTFilter;
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Encodes the given value into a string whose byte order is consistent with
+ * the Firestore ordering of values: if `a` sorts before `b` then
+ * `EncodeFieldIndexValue(a) <= EncodeFieldIndexValue(b)`.
+ *
+ * The encoding is not injective: integers beyond 2^53 share encodings with
+ * their nearest doubles, and all arrays (and all objects) share a single
+ * encoding. Index scans are therefore only used to narrow down candidates,
+ * which are always re-filtered against the query.
+ *
+ * Returns absl::nullopt for values that are never indexed (server timestamps,
+ * which only exist in the local view of a document).
+ */
+absl::optional<std::string> EncodeFieldIndexValue(FSTFieldValue* value);
+
+/**
+ * Returns the range of entries in `index` that contains every document
+ * matching `filter`, or absl::nullopt if the filter cannot be answered by the
+ * index (e.g. because it's on another field, or it's an array-contains and the
+ * index isn't an array-contains index).
+ */
+absl::optional<FieldIndexRange> FieldIndexRangeForFilter(
+    const FieldIndex& index, FSTFilter* filter);
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_FIELD_INDEX_ENCODING_H_
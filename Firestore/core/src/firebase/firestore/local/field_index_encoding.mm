@@ -0,0 +1,215 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/field_index_encoding.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#import "FIRGeoPoint.h"
+#import "FIRTimestamp.h"
+#import "Firestore/Source/Core/FSTQuery.h"
+#import "Firestore/Source/Model/FSTDocumentKey.h"
+#import "Firestore/Source/Model/FSTFieldValue.h"
+
+#include "Firestore/core/src/firebase/firestore/core/filter.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+using core::Filter;
+using model::FieldValue;
+using util::OrderedCode;
+
+/**
+ * Writes a double such that the unsigned byte order of the output matches the
+ * numeric order of the input. NaN sorts before all other numbers, and -0.0 is
+ * written as 0.0 since Firestore treats the two as equal.
+ */
+void WriteDouble(std::string* dest, double value) {
+  uint64_t bits = 0;
+  if (!std::isnan(value)) {
+    if (value == 0) {
+      value = 0;
+    }
+    std::memcpy(&bits, &value, sizeof(bits));
+    // Flipping the sign bit of positive numbers moves them above all negative
+    // numbers; flipping all bits of negative numbers reverses their order.
+    const uint64_t sign_bit = 0x8000000000000000ULL;
+    bits = (bits & sign_bit) ? ~bits : bits ^ sign_bit;
+  }
+  OrderedCode::WriteNumIncreasing(dest, bits);
+}
+
+/** The first byte of every encoded value in the given type order. */
+std::string TypePrefix(FSTTypeOrder type_order) {
+  return std::string(1, static_cast<char>(type_order));
+}
+
+/**
+ * Returns the smallest string that sorts after the given encoded value, which
+ * is the exclusive upper bound for entries equal to it.
+ */
+std::string Successor(std::string encoded_value) {
+  encoded_value.push_back('\0');
+  return encoded_value;
+}
+
+}  // namespace
+
+absl::optional<std::string> EncodeFieldIndexValue(FSTFieldValue* value) {
+  std::string result = TypePrefix(value.typeOrder);
+
+  switch (value.type) {
+    case FieldValue::Type::Null:
+    case FieldValue::Type::Array:
+    case FieldValue::Type::Object:
+      // Nothing beyond the type prefix, see the comment in the header.
+      break;
+
+    case FieldValue::Type::Boolean:
+      result.push_back(
+          ((FSTDelegateValue*)value).internalValue.boolean_value() ? 1 : 0);
+      break;
+
+    case FieldValue::Type::Integer:
+      WriteDouble(&result,
+                  static_cast<double>(((FSTIntegerValue*)value).internalValue));
+      break;
+
+    case FieldValue::Type::Double:
+      WriteDouble(&result, ((FSTDoubleValue*)value).internalValue);
+      break;
+
+    case FieldValue::Type::Timestamp: {
+      FIRTimestamp* timestamp = ((FSTTimestampValue*)value).value;
+      OrderedCode::WriteSignedNumIncreasing(&result, timestamp.seconds);
+      OrderedCode::WriteSignedNumIncreasing(&result, timestamp.nanoseconds);
+      break;
+    }
+
+    case FieldValue::Type::ServerTimestamp:
+      return absl::nullopt;
+
+    case FieldValue::Type::String:
+      result.append(((FSTDelegateValue*)value).internalValue.string_value());
+      break;
+
+    case FieldValue::Type::Blob: {
+      NSData* blob = ((FSTBlobValue*)value).value;
+      result.append(static_cast<const char*>(blob.bytes), blob.length);
+      break;
+    }
+
+    case FieldValue::Type::Reference: {
+      auto* reference = (FSTReferenceValue*)value;
+      OrderedCode::WriteString(&result, reference.databaseID->project_id());
+      OrderedCode::WriteString(&result, reference.databaseID->database_id());
+      for (const std::string& segment : reference.value.key.path()) {
+        OrderedCode::WriteString(&result, segment);
+      }
+      break;
+    }
+
+    case FieldValue::Type::GeoPoint: {
+      FIRGeoPoint* geo_point = ((FSTGeoPointValue*)value).value;
+      WriteDouble(&result, geo_point.latitude);
+      WriteDouble(&result, geo_point.longitude);
+      break;
+    }
+  }
+
+  return result;
+}
+
+absl::optional<FieldIndexRange> FieldIndexRangeForFilter(
+    const FieldIndex& index, FSTFilter* filter) {
+  if (filter.field != index.field_path()) {
+    return absl::nullopt;
+  }
+
+  FSTFieldValue* value = nil;
+  Filter::Operator op = Filter::Operator::Equal;
+  if ([filter isKindOfClass:[FSTRelationFilter class]]) {
+    auto* relation_filter = (FSTRelationFilter*)filter;
+    value = relation_filter.value;
+    op = relation_filter.filterOperator;
+  } else if ([filter isKindOfClass:[FSTNullFilter class]]) {
+    value = [FSTNullValue nullValue];
+  } else if ([filter isKindOfClass:[FSTNanFilter class]]) {
+    value = [FSTDoubleValue nanValue];
+  } else {
+    return absl::nullopt;
+  }
+
+  absl::optional<std::string> encoded = EncodeFieldIndexValue(value);
+  if (!encoded) {
+    return absl::nullopt;
+  }
+
+  // An array-contains index has an entry for each element of the array, so it
+  // answers array-contains filters with the entries for the filter value, and
+  // nothing else.
+  if (index.kind() == FieldIndex::Kind::ArrayContains) {
+    if (op != Filter::Operator::ArrayContains) {
+      return absl::nullopt;
+    }
+    return FieldIndexRange{index, *encoded, Successor(*encoded)};
+  }
+
+  // Firestore filters only match values of the same type order as the filter
+  // value, so inequalities are bounded by the type on their open end.
+  std::string type_start = TypePrefix(value.typeOrder);
+  std::string type_end =
+      TypePrefix(static_cast<FSTTypeOrder>(value.typeOrder + 1));
+
+  switch (op) {
+    case Filter::Operator::Equal:
+      return FieldIndexRange{index, *encoded, Successor(*encoded)};
+
+    case Filter::Operator::LessThan:
+    case Filter::Operator::LessThanOrEqual:
+      return FieldIndexRange{index, std::move(type_start),
+                             Successor(*encoded)};
+
+    case Filter::Operator::GreaterThan:
+    case Filter::Operator::GreaterThanOrEqual:
+      return FieldIndexRange{index, std::move(*encoded), std::move(type_end)};
+
+    case Filter::Operator::ArrayContains:
+      // Needs an array-contains index, see above.
+      return absl::nullopt;
+  }
+
+  UNREACHABLE();
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,250 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/field_name_dictionary.h"
+
+#include <algorithm>
+
+#include "Firestore/core/src/firebase/firestore/nanopb/wire_reader.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/wire_writer.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/hashing.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+using nanopb::WireReader;
+using nanopb::WireWriter;
+
+/**
+ * The first byte of the compact format. No serialized proto can start with it
+ * because it would be the tag of field number 0, which is invalid.
+ */
+const char kCompactMarker = '\0';
+
+/** The version of the compact format, which follows the marker. */
+const char kCompactVersion = 1;
+
+/**
+ * The messages the transcoder has to look into to reach every field name. All
+ * other messages (and all fields not listed in ChildOf) are copied verbatim.
+ */
+enum class Message {
+  None,
+  MaybeDocument,  // firestore.client.MaybeDocument
+  Document,       // google.firestore.v1.Document
+  FieldsEntry,    // The map<string, Value> entries of Document and MapValue
+  Value,          // google.firestore.v1.Value
+  MapValue,       // google.firestore.v1.MapValue
+  ArrayValue,     // google.firestore.v1.ArrayValue
+};
+
+/** The field number of the key in a map entry. */
+const uint32_t kFieldsEntryKey = 1;
+
+/**
+ * Returns the type of the submessage in the given field of `parent`, or
+ * Message::None if the field isn't on the way to any field names.
+ */
+Message ChildOf(Message parent, uint32_t field_number) {
+  switch (parent) {
+    case Message::MaybeDocument:
+      return field_number == 2 ? Message::Document : Message::None;
+    case Message::Document:
+      return field_number == 2 ? Message::FieldsEntry : Message::None;
+    case Message::FieldsEntry:
+      return field_number == 2 ? Message::Value : Message::None;
+    case Message::Value:
+      if (field_number == 6) return Message::MapValue;
+      if (field_number == 9) return Message::ArrayValue;
+      return Message::None;
+    case Message::MapValue:
+      return field_number == 1 ? Message::FieldsEntry : Message::None;
+    case Message::ArrayValue:
+      return field_number == 1 ? Message::Value : Message::None;
+    case Message::None:
+      break;
+  }
+  return Message::None;
+}
+
+/**
+ * Rewrites the keys of map entries in either direction: to IDs if constructed
+ * with a dictionary to intern into, and back to names otherwise.
+ */
+class Transcoder {
+ public:
+  explicit Transcoder(FieldNameDictionary* interning)
+      : interning_(interning), names_(interning) {
+  }
+
+  explicit Transcoder(const FieldNameDictionary* names) : names_(names) {
+  }
+
+  /**
+   * Appends the rewritten form of `message`, a message of the given type, to
+   * `out`. Returns false if the message is malformed.
+   */
+  bool Rewrite(absl::string_view message, Message type, std::string* out) {
+    WireReader reader{message};
+    WireWriter writer{out};
+
+    absl::string_view field_start = reader.remaining();
+    uint32_t field_number = 0;
+    pb_wire_type_t wire_type = PB_WT_VARINT;
+    while (reader.ReadTag(&field_number, &wire_type)) {
+      Message child = ChildOf(type, field_number);
+
+      if (type == Message::FieldsEntry && field_number == kFieldsEntryKey) {
+        if (!RewriteKey(&reader, wire_type, &writer)) return false;
+
+      } else if (child != Message::None && wire_type == PB_WT_STRING) {
+        absl::string_view submessage = reader.ReadLengthDelimited();
+        std::string rewritten;
+        if (!reader.ok() || !Rewrite(submessage, child, &rewritten)) {
+          return false;
+        }
+        writer.WriteTag(field_number, PB_WT_STRING);
+        writer.WriteLengthDelimited(rewritten);
+
+      } else {
+        reader.SkipField(wire_type);
+        size_t size = field_start.size() - reader.remaining().size();
+        out->append(field_start.data(), size);
+      }
+
+      field_start = reader.remaining();
+    }
+    return reader.ok();
+  }
+
+ private:
+  bool RewriteKey(WireReader* reader,
+                  pb_wire_type_t wire_type,
+                  WireWriter* writer) {
+    if (interning_) {
+      if (wire_type != PB_WT_STRING) return false;
+
+      absl::string_view name = reader->ReadLengthDelimited();
+      if (!reader->ok()) return false;
+
+      writer->WriteTag(kFieldsEntryKey, PB_WT_VARINT);
+      writer->WriteVarint(interning_->Intern(name));
+      return true;
+    }
+
+    if (wire_type != PB_WT_VARINT) return false;
+
+    uint64_t id = reader->ReadVarint();
+    if (!reader->ok() || id > UINT32_MAX) return false;
+
+    const std::string* name = names_->Find(static_cast<uint32_t>(id));
+    if (!name) return false;
+
+    writer->WriteTag(kFieldsEntryKey, PB_WT_STRING);
+    writer->WriteLengthDelimited(*name);
+    return true;
+  }
+
+  FieldNameDictionary* interning_ = nullptr;
+  const FieldNameDictionary* names_ = nullptr;
+};
+
+}  // namespace
+
+size_t FieldNameDictionary::Hash::operator()(absl::string_view name) const {
+  return static_cast<size_t>(util::HashBytes(name.data(), name.size()));
+}
+
+void FieldNameDictionary::Load(uint32_t id, std::string name) {
+  auto inserted = names_.emplace(id, std::move(name));
+  HARD_ASSERT(inserted.second, "Field name ID %s loaded twice", id);
+
+  ids_.emplace(inserted.first->second, id);
+  next_id_ = std::max(next_id_, id + 1);
+}
+
+uint32_t FieldNameDictionary::Intern(absl::string_view name) {
+  auto found = ids_.find(name);
+  if (found != ids_.end()) {
+    return found->second;
+  }
+
+  uint32_t id = next_id_++;
+  auto inserted = names_.emplace(id, std::string{name});
+  ids_.emplace(inserted.first->second, id);
+  new_ids_.push_back(id);
+  return id;
+}
+
+const std::string* FieldNameDictionary::Find(uint32_t id) const {
+  auto found = names_.find(id);
+  return found != names_.end() ? &found->second : nullptr;
+}
+
+std::vector<std::pair<uint32_t, std::string>>
+FieldNameDictionary::TakeNewNames() {
+  std::vector<std::pair<uint32_t, std::string>> result;
+  result.reserve(new_ids_.size());
+  for (uint32_t id : new_ids_) {
+    result.emplace_back(id, names_[id]);
+  }
+  new_ids_.clear();
+  return result;
+}
+
+bool IsCompactMaybeDocument(absl::string_view encoded) {
+  return !encoded.empty() && encoded.front() == kCompactMarker;
+}
+
+absl::optional<std::string> CompactMaybeDocument(
+    absl::string_view encoded, FieldNameDictionary* dictionary) {
+  std::string result;
+  result.reserve(encoded.size());
+  result.push_back(kCompactMarker);
+  result.push_back(kCompactVersion);
+
+  Transcoder transcoder{dictionary};
+  if (!transcoder.Rewrite(encoded, Message::MaybeDocument, &result)) {
+    return absl::nullopt;
+  }
+  return result;
+}
+
+absl::optional<std::string> ExpandMaybeDocument(
+    absl::string_view compact, const FieldNameDictionary& dictionary) {
+  if (compact.size() < 2 || compact[0] != kCompactMarker ||
+      compact[1] != kCompactVersion) {
+    return absl::nullopt;
+  }
+  compact.remove_prefix(2);
+
+  std::string result;
+  result.reserve(compact.size() * 2);
+
+  Transcoder transcoder{&dictionary};
+  if (!transcoder.Rewrite(compact, Message::MaybeDocument, &result)) {
+    return absl::nullopt;
+  }
+  return result;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
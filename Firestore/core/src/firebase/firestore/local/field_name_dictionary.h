@@ -0,0 +1,116 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_FIELD_NAME_DICTIONARY_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_FIELD_NAME_DICTIONARY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Assigns small integer IDs to the field names (map keys) of the documents in
+ * one collection, so that documents stored in the compact format can refer to
+ * each name by ID instead of repeating it.
+ *
+ * IDs are never reassigned: once a name has been given an ID and persisted,
+ * documents may refer to it until the end of time. A dictionary is not
+ * thread-safe.
+ */
+class FieldNameDictionary {
+ public:
+  /**
+   * Adds a name read back from storage under the ID it was persisted with.
+   * Names added this way are not returned by `TakeNewNames()`.
+   */
+  void Load(uint32_t id, std::string name);
+
+  /**
+   * Returns the ID of the given name, assigning it the next unused ID if it
+   * doesn't have one yet.
+   */
+  uint32_t Intern(absl::string_view name);
+
+  /** Returns the name with the given ID, or nullptr if there is none. */
+  const std::string* Find(uint32_t id) const;
+
+  /**
+   * Returns the names that `Intern()` has assigned IDs to since the last call,
+   * which the caller must persist along with the documents that use them.
+   */
+  std::vector<std::pair<uint32_t, std::string>> TakeNewNames();
+
+  /** Returns the number of names in the dictionary. */
+  size_t size() const {
+    return names_.size();
+  }
+
+ private:
+  struct Hash {
+    size_t operator()(absl::string_view name) const;
+  };
+
+  std::unordered_map<uint32_t, std::string> names_;
+
+  // Keys point into the values of names_, whose nodes never move.
+  std::unordered_map<absl::string_view, uint32_t, Hash> ids_;
+
+  std::vector<uint32_t> new_ids_;
+  uint32_t next_id_ = 0;
+};
+
+/**
+ * Whether the given encoded MaybeDocument is in the compact format produced by
+ * `CompactMaybeDocument()`, rather than a plain serialized proto.
+ */
+bool IsCompactMaybeDocument(absl::string_view encoded);
+
+/**
+ * Rewrites a serialized `firestore.client.MaybeDocument` into the compact
+ * format, in which the keys of the document's fields (at every level of
+ * nesting) are replaced with IDs from `dictionary`. Names that are new to the
+ * dictionary are assigned IDs along the way.
+ *
+ * Returns absl::nullopt if `encoded` is not a well-formed proto.
+ */
+absl::optional<std::string> CompactMaybeDocument(
+    absl::string_view encoded, FieldNameDictionary* dictionary);
+
+/**
+ * Reverses `CompactMaybeDocument()`, giving back the serialized proto, which
+ * decodes to exactly the same document.
+ *
+ * Returns absl::nullopt if `compact` is malformed or refers to IDs missing from
+ * `dictionary`.
+ */
+absl::optional<std::string> ExpandMaybeDocument(
+    absl::string_view compact, const FieldNameDictionary& dictionary);
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_FIELD_NAME_DICTIONARY_H_
@@ -20,6 +20,7 @@
 #include <string>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/local/field_index.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 
 namespace firebase {
@@ -29,8 +30,9 @@ namespace local {
 /**
  * Represents a set of indexes that are used to execute queries efficiently.
  *
- * Currently the only index is a [collection id] => [parent path] index, used
- * to execute Collection Group queries.
+ * There is a [collection id] => [parent path] index, used to execute
+ * Collection Group queries, and a registry of the declared FieldIndexes, used
+ * to plan local queries as index range scans.
  */
 class IndexManager {
  public:
@@ -56,6 +58,24 @@ class IndexManager {
    */
   virtual std::vector<model::ResourcePath> GetCollectionParents(
       const std::string& collection_id) = 0;
+
+  /**
+   * Declares a field index. Once declared, the remote document cache maintains
+   * index entries for the indexed field of every document in a collection with
+   * the index's collection_id.
+   *
+   * @return true if the index was newly declared, in which case the caller is
+   *     responsible for backfilling entries for documents that are already
+   *     cached; false if the index already existed.
+   */
+  virtual bool AddFieldIndex(const FieldIndex& index) = 0;
+
+  /**
+   * Returns the field indexes declared for collections with the given
+   * collection_id.
+   */
+  virtual std::vector<FieldIndex> GetFieldIndexes(
+      const std::string& collection_id) = 0;
 };
 
 }  // namespace local
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_env.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__APPLE__)
+#include <pthread.h>
+#include <sys/qos.h>
+#endif  // defined(__APPLE__)
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "leveldb/slice.h"
+#include "leveldb/status.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+using leveldb::Env;
+using leveldb::RandomAccessFile;
+using leveldb::Slice;
+using leveldb::Status;
+
+/** A file read through a read-only memory map of all of it. */
+class MmapRandomAccessFile : public RandomAccessFile {
+ public:
+  MmapRandomAccessFile(std::string filename, void* base, size_t length)
+      : filename_{std::move(filename)}, base_{base}, length_{length} {
+  }
+
+  ~MmapRandomAccessFile() override {
+    munmap(base_, length_);
+  }
+
+  Status Read(uint64_t offset,
+              size_t n,
+              Slice* result,
+              char* scratch) const override {
+    (void)scratch;
+    if (offset > length_ || n > length_ - offset) {
+      *result = Slice{};
+      return Status::IOError(filename_, "Read past the end of the file");
+    }
+    *result = Slice{static_cast<const char*>(base_) + offset, n};
+    return Status::OK();
+  }
+
+ private:
+  std::string filename_;
+  void* base_;
+  size_t length_;
+};
+
+/** Lowers the priority of the calling thread to that of background work. */
+void LowerThreadPriority() {
+#if defined(__APPLE__)
+  pthread_set_qos_class_self_np(QOS_CLASS_UTILITY, 0);
+#endif  // defined(__APPLE__)
+}
+
+class MobileEnv : public leveldb::EnvWrapper {
+ public:
+  explicit MobileEnv(Env* target) : EnvWrapper{target} {
+  }
+
+  Status NewRandomAccessFile(const std::string& filename,
+                             RandomAccessFile** result) override {
+    int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      // Lets the default Env report the error the way LevelDB expects.
+      return target()->NewRandomAccessFile(filename, result);
+    }
+
+    void* base = MAP_FAILED;
+    size_t length = 0;
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+      length = static_cast<size_t>(file_stat.st_size);
+      base = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    // The mapping stays valid without the descriptor.
+    close(fd);
+
+    if (base == MAP_FAILED) {
+      // Empty files can't be mapped, and the address space may run out.
+      return target()->NewRandomAccessFile(filename, result);
+    }
+    *result = new MmapRandomAccessFile{filename, base, length};
+    return Status::OK();
+  }
+
+  void Schedule(void (*function)(void* arg), void* arg) override {
+    target()->Schedule(&RunInBackground, new BackgroundWork{function, arg});
+  }
+
+ private:
+  struct BackgroundWork {
+    void (*function)(void* arg);
+    void* arg;
+  };
+
+  static void RunInBackground(void* arg) {
+    std::unique_ptr<BackgroundWork> work{static_cast<BackgroundWork*>(arg)};
+    LowerThreadPriority();
+    work->function(work->arg);
+  }
+};
+
+}  // namespace
+
+leveldb::Env* MobileLevelDbEnv() {
+  static Env* env = new MobileEnv{Env::Default()};
+  return env;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
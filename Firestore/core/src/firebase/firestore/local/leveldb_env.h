@@ -0,0 +1,46 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_ENV_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_ENV_H_
+
+#include "leveldb/env.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Returns the leveldb::Env that `LevelDbSettings::mobile_env` selects, which
+ * wraps LevelDB's default Env in two ways:
+ *
+ *   * Tables are read through a memory map of the whole file, however many of
+ *     them are open, so the table cache doesn't hold a file descriptor for
+ *     each of them and reads don't need a system call.
+ *   * Background compactions run at a low priority (the utility QoS class on
+ *     Apple platforms), so that they don't compete with the app's foreground
+ *     work. LevelDB runs them on a single thread that every database opened
+ *     with the default Env shares, which is left at that priority.
+ *
+ * The Env is never destroyed.
+ */
+leveldb::Env* MobileLevelDbEnv();
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_ENV_H_
@@ -22,8 +22,10 @@
 #endif  // !defined(__OBJC__)
 
 #include <string>
+#include <unordered_set>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/local/field_index.h"
 #include "Firestore/core/src/firebase/firestore/local/index_manager.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_index_manager.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
@@ -47,18 +49,44 @@ class LevelDbIndexManager : public IndexManager {
   std::vector<model::ResourcePath> GetCollectionParents(
       const std::string& collection_id) override;
 
+  bool AddFieldIndex(const FieldIndex& index) override;
+
+  std::vector<FieldIndex> GetFieldIndexes(
+      const std::string& collection_id) override;
+
  private:
+  /**
+   * Reads the collection parents of the given collection_id into
+   * collection_parents_cache_, unless they have already been read.
+   */
+  void EnsureCollectionParentsLoaded(const std::string& collection_id);
+
+  /**
+   * Reads the declared field indexes for the given collection_id into
+   * field_indexes_cache_, unless they have already been read.
+   */
+  void EnsureFieldIndexesLoaded(const std::string& collection_id);
+
   // This instance is owned by FSTLevelDB; avoid a retain cycle.
   __weak FSTLevelDB* db_;
 
   /**
-   * An in-memory copy of the index entries we've already written since the SDK
-   * launched. Used to avoid re-writing the same entry repeatedly.
-   *
-   * This is *NOT* a complete cache of what's in persistence and so can never
-   * be used to satisfy reads.
+   * A write-through, in-memory copy of the collection-parent index. It holds
+   * every entry written since the SDK launched, which avoids re-writing the
+   * same entry repeatedly, and is complete (and so can satisfy reads) for every
+   * collection_id in loaded_collection_parent_ids_.
    */
   MemoryCollectionParentIndex collection_parents_cache_;
+  std::unordered_set<std::string> loaded_collection_parent_ids_;
+
+  /**
+   * An in-memory copy of the declared field indexes. Like the collection
+   * parents cache, this is complete for every collection_id in
+   * loaded_field_index_collections_, since field indexes are only ever
+   * declared through this instance.
+   */
+  MemoryFieldIndexRegistry field_indexes_cache_;
+  std::unordered_set<std::string> loaded_field_index_collections_;
 };
 
 }  // namespace local
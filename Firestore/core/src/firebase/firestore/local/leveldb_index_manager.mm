@@ -20,6 +20,7 @@
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_migrations.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_index_manager.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
@@ -55,7 +56,40 @@ void LevelDbIndexManager::AddToCollectionParentIndex(
 
 std::vector<ResourcePath> LevelDbIndexManager::GetCollectionParents(
     const std::string& collection_id) {
-  std::vector<ResourcePath> results;
+  EnsureCollectionParentsLoaded(collection_id);
+  return collection_parents_cache_.GetEntries(collection_id);
+}
+
+bool LevelDbIndexManager::AddFieldIndex(const FieldIndex& index) {
+  EnsureFieldIndexesLoaded(index.collection_id());
+  if (!field_indexes_cache_.Add(index)) {
+    return false;
+  }
+
+  std::string key =
+      index.kind() == FieldIndex::Kind::ArrayContains
+          ? LevelDbArrayIndexKey::Key(index.collection_id(), index.field_path())
+          : LevelDbFieldIndexKey::Key(index.collection_id(),
+                                      index.field_path());
+  std::string empty_buffer;
+  db_.currentTransaction->Put(key, empty_buffer);
+  return true;
+}
+
+std::vector<FieldIndex> LevelDbIndexManager::GetFieldIndexes(
+    const std::string& collection_id) {
+  EnsureFieldIndexesLoaded(collection_id);
+  return field_indexes_cache_.GetEntries(collection_id);
+}
+
+void LevelDbIndexManager::EnsureCollectionParentsLoaded(
+    const std::string& collection_id) {
+  // Entries written by the backfill aren't in the cache, so it can only be
+  // loaded once the backfill is complete.
+  [db_ finishMigration:LevelDbMigrations::kCollectionParentsIndex];
+  if (!loaded_collection_parent_ids_.insert(collection_id).second) {
+    return;
+  }
 
   auto index_iterator = db_.currentTransaction->NewIterator();
   std::string index_prefix =
@@ -69,9 +103,46 @@ std::vector<ResourcePath> LevelDbIndexManager::GetCollectionParents(
       break;
     }
 
-    results.push_back(row_key.parent());
+    collection_parents_cache_.Add(row_key.parent().Append(collection_id));
+  }
+}
+
+void LevelDbIndexManager::EnsureFieldIndexesLoaded(
+    const std::string& collection_id) {
+  if (!loaded_field_index_collections_.insert(collection_id).second) {
+    return;
+  }
+
+  auto index_iterator = db_.currentTransaction->NewIterator();
+  std::string index_prefix = LevelDbFieldIndexKey::KeyPrefix(collection_id);
+  LevelDbFieldIndexKey row_key;
+  for (index_iterator->Seek(index_prefix); index_iterator->Valid();
+       index_iterator->Next()) {
+    if (!absl::StartsWith(index_iterator->key(), index_prefix) ||
+        !row_key.Decode(index_iterator->key()) ||
+        row_key.collection_id() != collection_id) {
+      break;
+    }
+
+    field_indexes_cache_.Add(
+        FieldIndex{row_key.collection_id(), row_key.field_path()});
+  }
+
+  std::string array_index_prefix =
+      LevelDbArrayIndexKey::KeyPrefix(collection_id);
+  LevelDbArrayIndexKey array_row_key;
+  for (index_iterator->Seek(array_index_prefix); index_iterator->Valid();
+       index_iterator->Next()) {
+    if (!absl::StartsWith(index_iterator->key(), array_index_prefix) ||
+        !array_row_key.Decode(index_iterator->key()) ||
+        array_row_key.collection_id() != collection_id) {
+      break;
+    }
+
+    field_indexes_cache_.Add(FieldIndex{array_row_key.collection_id(),
+                                        array_row_key.field_path(),
+                                        FieldIndex::Kind::ArrayContains});
   }
-  return results;
 }
 
 }  // namespace local
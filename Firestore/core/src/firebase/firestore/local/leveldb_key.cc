@@ -19,13 +19,16 @@
 #include <utility>
 #include <vector>
 
+#include "Firestore/Protos/nanopb/firestore/local/target.nanopb.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_util.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/wire_reader.h"
 #include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
 #include "absl/base/attributes.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/str_cat.h"
 
 using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::FieldPath;
 using firebase::firestore::model::ResourcePath;
 using firebase::firestore::util::OrderedCode;
 
@@ -36,16 +39,27 @@ namespace local {
 namespace {
 
 const char* kVersionGlobalTable = "version";
+const char* kMigrationProgressTable = "migration_progress";
 const char* kMutationsTable = "mutation";
 const char* kDocumentMutationsTable = "document_mutation";
+const char* kCollectionMutationsTable = "collection_mutation";
 const char* kMutationQueuesTable = "mutation_queue";
 const char* kTargetGlobalTable = "target_global";
 const char* kTargetsTable = "target";
 const char* kQueryTargetsTable = "query_target";
 const char* kTargetDocumentsTable = "target_document";
 const char* kDocumentTargetsTable = "document_target";
+const char* kDocumentTargetSetsTable = "document_target_set";
+const char* kTargetSequencesTable = "target_sequence";
+const char* kDocumentSequencesTable = "document_sequence";
+const char* kQueryResultsTable = "query_result";
 const char* kRemoteDocumentsTable = "remote_document";
 const char* kCollectionParentsTable = "collection_parent";
+const char* kFieldIndexesTable = "field_index";
+const char* kFieldIndexEntriesTable = "field_index_entry";
+const char* kFieldNamesTable = "field_name";
+const char* kArrayIndexesTable = "array_index";
+const char* kArrayIndexEntriesTable = "array_index_entry";
 
 /**
  * Labels for the components of keys. These serve to make keys self-describing.
@@ -96,6 +110,24 @@ enum ComponentLabel {
    */
   CollectionId = 14,
 
+  /** A component containing the canonical string of an indexed field. */
+  IndexedField = 15,
+
+  /**
+   * A component containing the order-preserving encoding of an indexed field
+   * value.
+   */
+  IndexValue = 16,
+
+  /** A component containing the schema version of a migration. */
+  SchemaVersion = 17,
+
+  /** A component containing the ID of a field name in a dictionary. */
+  FieldNameId = 18,
+
+  /** A component containing a listen sequence number. */
+  SequenceNumber = 19,
+
   /**
    * A path segment describes just a single segment in a resource path. Path
    * segments that occur sequentially in a key represent successive segments in
@@ -116,6 +148,75 @@ enum ComponentLabel {
   Unknown = 63,
 };
 
+/**
+ * Reads past a string written by OrderedCode::WriteString without unescaping
+ * it, storing the bytes of the string as written (without its terminator) in
+ * `encoded`. Sets `escaped` if the string contains escaped bytes.
+ *
+ * OrderedCode writes '\0' as "\0\xff" and '\xff' as "\xff\0", and ends
+ * strings with "\0\1".
+ *
+ * Returns false if `src` doesn't start with a complete string.
+ */
+bool SkipString(absl::string_view* src,
+                absl::string_view* encoded,
+                bool* escaped) {
+  size_t i = 0;
+  while (i < src->size()) {
+    char c = (*src)[i];
+    if (c != '\0' && c != '\xff') {
+      ++i;
+      continue;
+    }
+    if (i + 1 == src->size()) {
+      return false;
+    }
+
+    char next = (*src)[i + 1];
+    if (c == '\0' && next == '\1') {
+      *encoded = src->substr(0, i);
+      src->remove_prefix(i + 2);
+      return true;
+    }
+    if ((c == '\0' && next != '\xff') || (c == '\xff' && next != '\0')) {
+      return false;
+    }
+    *escaped = true;
+    i += 2;
+  }
+  return false;
+}
+
+/** Returns the string whose bytes as written are `encoded`, see SkipString. */
+std::string UnescapeString(absl::string_view encoded) {
+  std::string result;
+  result.reserve(encoded.size());
+  for (size_t i = 0; i < encoded.size(); ++i) {
+    char c = encoded[i];
+    result.push_back(c);
+    if (c == '\0' || c == '\xff') {
+      // Skip the second byte of the escape.
+      ++i;
+    }
+  }
+  return result;
+}
+
+/**
+ * Returns true if the string whose bytes as written are `encoded` is `value`,
+ * see SkipString.
+ */
+bool EncodedStringEquals(absl::string_view encoded, absl::string_view value) {
+  size_t i = 0;
+  for (char c : value) {
+    if (i == encoded.size() || encoded[i] != c) {
+      return false;
+    }
+    i += (c == '\0' || c == '\xff') ? 2 : 1;
+  }
+  return i == encoded.size();
+}
+
 /**
  * A helper for reading through the string form of a LevelDB key, as written
  * by Writer.
@@ -162,6 +263,21 @@ class Reader {
     return ReadLabeledInt32(ComponentLabel::TargetId);
   }
 
+  int32_t ReadSchemaVersion() {
+    return ReadLabeledInt32(ComponentLabel::SchemaVersion);
+  }
+
+  int32_t ReadFieldNameId() {
+    return ReadLabeledInt32(ComponentLabel::FieldNameId);
+  }
+
+  model::ListenSequenceNumber ReadSequenceNumber() {
+    if (!ReadComponentLabelMatching(ComponentLabel::SequenceNumber)) {
+      Fail();
+    }
+    return ReadSignedNumIncreasing();
+  }
+
   std::string ReadUserId() {
     return ReadLabeledString(ComponentLabel::UserId);
   }
@@ -170,6 +286,19 @@ class Reader {
     return ReadLabeledString(ComponentLabel::CollectionId);
   }
 
+  FieldPath ReadIndexedField() {
+    std::string canonical_field =
+        ReadLabeledString(ComponentLabel::IndexedField);
+    if (!ok_) {
+      return FieldPath{};
+    }
+    return FieldPath::FromServerFormat(canonical_field);
+  }
+
+  std::string ReadIndexValue() {
+    return ReadLabeledString(ComponentLabel::IndexValue);
+  }
+
   /**
    * Reads component labels and strings from the key until it finds a component
    * label other than ComponentLabel::PathSegment (or the key is exhausted).
@@ -191,6 +320,18 @@ class Reader {
    */
   DocumentKey ReadDocumentKey();
 
+  /**
+   * Reads path segments like ReadResourcePath, but stores views of the
+   * segments as written in the key rather than copies of them, see
+   * LevelDbPathView.
+   *
+   * If the read is unsuccessful or the path is not a valid document key, fails
+   * the Reader.
+   */
+  void ReadDocumentPathView(std::vector<absl::string_view>* segments,
+                            absl::string_view* encoded,
+                            bool* escaped);
+
   /**
    * Reads a terminator component from the key.
    *
@@ -237,6 +378,25 @@ class Reader {
     return "";
   }
 
+  /**
+   * Reads a string from the key without unescaping it, see SkipString.
+   *
+   * If the read is unsuccessful, returns an empty view and fails the Reader.
+   */
+  absl::string_view ReadEncodedString(bool* escaped) {
+    if (ok_) {
+      absl::string_view result;
+      absl::string_view tmp = MakeStringView(src_);
+      if (SkipString(&tmp, &result, escaped)) {
+        src_ = MakeSlice(tmp);
+        return result;
+      }
+    }
+
+    Fail();
+    return {};
+  }
+
   /**
    * Reads a component label from the key.
    *
@@ -353,10 +513,14 @@ class Reader {
   ABSL_MUST_USE_RESULT
   bool ReadLabeledStringMatching(ComponentLabel expected_label,
                                  const char* expected_value) {
-    std::string value = ReadLabeledString(expected_label);
+    if (!ReadComponentLabelMatching(expected_label)) {
+      Fail();
+    }
+    bool escaped = false;
+    absl::string_view value = ReadEncodedString(&escaped);
     if (ok_) {
       // Value mismatch does not constitute a failure:
-      return value == expected_value;
+      return EncodedStringEquals(value, expected_value);
     }
 
     Fail();
@@ -377,7 +541,7 @@ class Reader {
 };
 
 ResourcePath Reader::ReadResourcePath() {
-  std::vector<std::string> path_segments;
+  ResourcePath::SegmentsT path_segments;
   while (!empty()) {
     // Advance a temporary slice to avoid advancing contents into the next key
     // component which may not be a path segment.
@@ -408,6 +572,33 @@ DocumentKey Reader::ReadDocumentKey() {
   return DocumentKey{};
 }
 
+void Reader::ReadDocumentPathView(std::vector<absl::string_view>* segments,
+                                  absl::string_view* encoded,
+                                  bool* escaped) {
+  segments->clear();
+  *escaped = false;
+  const char* start = src_.data();
+  while (!empty()) {
+    // Advance a temporary slice to avoid advancing contents into the next key
+    // component which may not be a path segment.
+    leveldb::Slice saved_position = src_;
+    if (!ReadComponentLabelMatching(ComponentLabel::PathSegment)) {
+      src_ = saved_position;
+      break;
+    }
+
+    absl::string_view segment = ReadEncodedString(escaped);
+    if (!ok_) break;
+
+    segments->push_back(segment);
+  }
+  *encoded = absl::string_view{start, static_cast<size_t>(src_.data() - start)};
+
+  if (segments->empty() || segments->size() % 2 != 0) {
+    Fail();
+  }
+}
+
 /**
  * Returns a base64-encoded string for an invalid key, used for debug-friendly
  * description text.
@@ -485,6 +676,38 @@ std::string Reader::Describe() {
         absl::StrAppend(&description, " collection_id=", collection_id);
       }
 
+    } else if (label == ComponentLabel::IndexedField) {
+      FieldPath field_path = ReadIndexedField();
+      if (ok_) {
+        absl::StrAppend(&description,
+                        " indexed_field=", field_path.CanonicalString());
+      }
+
+    } else if (label == ComponentLabel::IndexValue) {
+      std::string index_value = ReadIndexValue();
+      if (ok_) {
+        absl::StrAppend(&description,
+                        " index_value=", absl::CHexEscape(index_value));
+      }
+
+    } else if (label == ComponentLabel::SchemaVersion) {
+      int32_t schema_version = ReadSchemaVersion();
+      if (ok_) {
+        absl::StrAppend(&description, " schema_version=", schema_version);
+      }
+
+    } else if (label == ComponentLabel::FieldNameId) {
+      int32_t field_name_id = ReadFieldNameId();
+      if (ok_) {
+        absl::StrAppend(&description, " field_name_id=", field_name_id);
+      }
+
+    } else if (label == ComponentLabel::SequenceNumber) {
+      model::ListenSequenceNumber sequence_number = ReadSequenceNumber();
+      if (ok_) {
+        absl::StrAppend(&description, " sequence_number=", sequence_number);
+      }
+
     } else {
       absl::StrAppend(&description, " unknown label=", static_cast<int>(label));
       Fail();
@@ -528,6 +751,19 @@ class Writer {
     WriteLabeledInt32(ComponentLabel::TargetId, target_id);
   }
 
+  void WriteSchemaVersion(int32_t schema_version) {
+    WriteLabeledInt32(ComponentLabel::SchemaVersion, schema_version);
+  }
+
+  void WriteFieldNameId(int32_t field_name_id) {
+    WriteLabeledInt32(ComponentLabel::FieldNameId, field_name_id);
+  }
+
+  void WriteSequenceNumber(model::ListenSequenceNumber sequence_number) {
+    WriteComponentLabel(ComponentLabel::SequenceNumber);
+    OrderedCode::WriteSignedNumIncreasing(&dest_, sequence_number);
+  }
+
   void WriteUserId(absl::string_view user_id) {
     WriteLabeledString(ComponentLabel::UserId, user_id);
   }
@@ -536,6 +772,15 @@ class Writer {
     WriteLabeledString(ComponentLabel::CollectionId, collection_id);
   }
 
+  void WriteIndexedField(const FieldPath& field_path) {
+    WriteLabeledString(ComponentLabel::IndexedField,
+                       field_path.CanonicalString());
+  }
+
+  void WriteIndexValue(absl::string_view index_value) {
+    WriteLabeledString(ComponentLabel::IndexValue, index_value);
+  }
+
   /**
    * For each segment in the given resource path writes a
    * ComponentLabel::PathSegment component label and a string containing the
@@ -600,6 +845,28 @@ std::string LevelDbVersionKey::Key() {
   return writer.result();
 }
 
+std::string LevelDbMigrationProgressKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kMigrationProgressTable);
+  return writer.result();
+}
+
+std::string LevelDbMigrationProgressKey::Key(int32_t schema_version) {
+  Writer writer;
+  writer.WriteTableName(kMigrationProgressTable);
+  writer.WriteSchemaVersion(schema_version);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbMigrationProgressKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kMigrationProgressTable);
+  schema_version_ = reader.ReadSchemaVersion();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
 std::string LevelDbMutationKey::KeyPrefix() {
   Writer writer;
   writer.WriteTableName(kMutationsTable);
@@ -676,6 +943,64 @@ bool LevelDbDocumentMutationKey::Decode(absl::string_view key) {
   return reader.ok();
 }
 
+std::string LevelDbCollectionMutationKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kCollectionMutationsTable);
+  return writer.result();
+}
+
+std::string LevelDbCollectionMutationKey::KeyPrefix(
+    absl::string_view user_id) {
+  Writer writer;
+  writer.WriteTableName(kCollectionMutationsTable);
+  writer.WriteUserId(user_id);
+  return writer.result();
+}
+
+std::string LevelDbCollectionMutationKey::KeyPrefix(
+    absl::string_view user_id, absl::string_view collection_id) {
+  Writer writer;
+  writer.WriteTableName(kCollectionMutationsTable);
+  writer.WriteUserId(user_id);
+  writer.WriteCollectionId(collection_id);
+  return writer.result();
+}
+
+std::string LevelDbCollectionMutationKey::KeyPrefix(
+    absl::string_view user_id, const ResourcePath& collection_path) {
+  Writer writer;
+  writer.WriteTableName(kCollectionMutationsTable);
+  writer.WriteUserId(user_id);
+  writer.WriteCollectionId(collection_path.last_segment());
+  writer.WriteResourcePath(collection_path.PopLast());
+  return writer.result();
+}
+
+std::string LevelDbCollectionMutationKey::Key(
+    absl::string_view user_id,
+    const ResourcePath& collection_path,
+    model::BatchId batch_id) {
+  Writer writer;
+  writer.WriteTableName(kCollectionMutationsTable);
+  writer.WriteUserId(user_id);
+  writer.WriteCollectionId(collection_path.last_segment());
+  writer.WriteResourcePath(collection_path.PopLast());
+  writer.WriteBatchId(batch_id);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbCollectionMutationKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kCollectionMutationsTable);
+  user_id_ = reader.ReadUserId();
+  collection_id_ = reader.ReadCollectionId();
+  parent_ = reader.ReadResourcePath();
+  batch_id_ = reader.ReadBatchId();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
 std::string LevelDbMutationQueueKey::KeyPrefix() {
   Writer writer;
   writer.WriteTableName(kMutationQueuesTable);
@@ -734,6 +1059,30 @@ bool LevelDbTargetKey::Decode(leveldb::Slice key) {
   return reader.ok();
 }
 
+model::ListenSequenceNumber LevelDbTargetKey::DecodeSequenceNumber(
+    absl::string_view target_value) {
+  // Proto3 leaves out fields with default values, so a target without the
+  // field has sequence number 0.
+  model::ListenSequenceNumber sequence_number = 0;
+  nanopb::WireReader reader{target_value};
+  uint32_t field_number;
+  pb_wire_type_t wire_type;
+  while (reader.ReadTag(&field_number, &wire_type)) {
+    if (field_number ==
+            firestore_client_Target_last_listen_sequence_number_tag &&
+        wire_type == PB_WT_VARINT) {
+      sequence_number =
+          static_cast<model::ListenSequenceNumber>(reader.ReadVarint());
+    } else {
+      reader.SkipField(wire_type);
+    }
+  }
+  if (!reader.ok()) {
+    HARD_FAIL("Failed to read sequence number from a target row");
+  }
+  return sequence_number;
+}
+
 std::string LevelDbQueryTargetKey::KeyPrefix() {
   Writer writer;
   writer.WriteTableName(kQueryTargetsTable);
@@ -852,6 +1201,112 @@ bool LevelDbDocumentTargetKey::Decode(absl::string_view key) {
   return reader.ok();
 }
 
+std::string LevelDbDocumentTargetSetKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kDocumentTargetSetsTable);
+  return writer.result();
+}
+
+std::string LevelDbDocumentTargetSetKey::Key(const DocumentKey& document_key) {
+  Writer writer;
+  writer.WriteTableName(kDocumentTargetSetsTable);
+  writer.WriteResourcePath(document_key.path());
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbDocumentTargetSetKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kDocumentTargetSetsTable);
+  document_key_ = reader.ReadDocumentKey();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbTargetSequenceKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kTargetSequencesTable);
+  return writer.result();
+}
+
+std::string LevelDbTargetSequenceKey::Key(
+    model::ListenSequenceNumber sequence_number, model::TargetId target_id) {
+  Writer writer;
+  writer.WriteTableName(kTargetSequencesTable);
+  writer.WriteSequenceNumber(sequence_number);
+  writer.WriteTargetId(target_id);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbTargetSequenceKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kTargetSequencesTable);
+  sequence_number_ = reader.ReadSequenceNumber();
+  target_id_ = reader.ReadTargetId();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbDocumentSequenceKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kDocumentSequencesTable);
+  return writer.result();
+}
+
+std::string LevelDbDocumentSequenceKey::Key(
+    model::ListenSequenceNumber sequence_number,
+    const DocumentKey& document_key) {
+  Writer writer;
+  writer.WriteTableName(kDocumentSequencesTable);
+  writer.WriteSequenceNumber(sequence_number);
+  writer.WriteResourcePath(document_key.path());
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbDocumentSequenceKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kDocumentSequencesTable);
+  sequence_number_ = reader.ReadSequenceNumber();
+  document_key_ = reader.ReadDocumentKey();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbQueryResultKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kQueryResultsTable);
+  return writer.result();
+}
+
+std::string LevelDbQueryResultKey::KeyPrefix(
+    const ResourcePath& collection_path) {
+  Writer writer;
+  writer.WriteTableName(kQueryResultsTable);
+  writer.WriteResourcePath(collection_path);
+  return writer.result();
+}
+
+std::string LevelDbQueryResultKey::Key(const ResourcePath& collection_path,
+                                       model::TargetId target_id) {
+  Writer writer;
+  writer.WriteTableName(kQueryResultsTable);
+  writer.WriteResourcePath(collection_path);
+  writer.WriteTargetId(target_id);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbQueryResultKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kQueryResultsTable);
+  collection_path_ = reader.ReadResourcePath();
+  target_id_ = reader.ReadTargetId();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
 std::string LevelDbRemoteDocumentKey::KeyPrefix() {
   Writer writer;
   writer.WriteTableName(kRemoteDocumentsTable);
@@ -915,6 +1370,273 @@ bool LevelDbCollectionParentKey::Decode(absl::string_view key) {
   return reader.ok();
 }
 
+std::string LevelDbFieldIndexKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kFieldIndexesTable);
+  return writer.result();
+}
+
+std::string LevelDbFieldIndexKey::KeyPrefix(absl::string_view collection_id) {
+  Writer writer;
+  writer.WriteTableName(kFieldIndexesTable);
+  writer.WriteCollectionId(collection_id);
+  return writer.result();
+}
+
+std::string LevelDbFieldIndexKey::Key(absl::string_view collection_id,
+                                      const FieldPath& field_path) {
+  Writer writer;
+  writer.WriteTableName(kFieldIndexesTable);
+  writer.WriteCollectionId(collection_id);
+  writer.WriteIndexedField(field_path);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbFieldIndexKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kFieldIndexesTable);
+  collection_id_ = reader.ReadCollectionId();
+  field_path_ = reader.ReadIndexedField();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbFieldIndexEntryKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kFieldIndexEntriesTable);
+  return writer.result();
+}
+
+std::string LevelDbFieldIndexEntryKey::KeyPrefix(
+    const ResourcePath& collection_path, const FieldPath& field_path) {
+  Writer writer;
+  writer.WriteTableName(kFieldIndexEntriesTable);
+  writer.WriteResourcePath(collection_path);
+  writer.WriteIndexedField(field_path);
+  return writer.result();
+}
+
+std::string LevelDbFieldIndexEntryKey::KeyPrefix(
+    const ResourcePath& collection_path,
+    const FieldPath& field_path,
+    absl::string_view index_value) {
+  Writer writer;
+  writer.WriteTableName(kFieldIndexEntriesTable);
+  writer.WriteResourcePath(collection_path);
+  writer.WriteIndexedField(field_path);
+  writer.WriteIndexValue(index_value);
+  return writer.result();
+}
+
+std::string LevelDbFieldIndexEntryKey::Key(const FieldPath& field_path,
+                                           absl::string_view index_value,
+                                           const DocumentKey& document_key) {
+  Writer writer;
+  writer.WriteTableName(kFieldIndexEntriesTable);
+  writer.WriteResourcePath(document_key.path().PopLast());
+  writer.WriteIndexedField(field_path);
+  writer.WriteIndexValue(index_value);
+  writer.WriteResourcePath(document_key.path());
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbFieldIndexEntryKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kFieldIndexEntriesTable);
+  collection_path_ = reader.ReadResourcePath();
+  field_path_ = reader.ReadIndexedField();
+  index_value_ = reader.ReadIndexValue();
+  document_key_ = reader.ReadDocumentKey();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbFieldNameKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kFieldNamesTable);
+  return writer.result();
+}
+
+std::string LevelDbFieldNameKey::KeyPrefix(
+    const ResourcePath& collection_path) {
+  Writer writer;
+  writer.WriteTableName(kFieldNamesTable);
+  writer.WriteResourcePath(collection_path);
+  return writer.result();
+}
+
+std::string LevelDbFieldNameKey::Key(const ResourcePath& collection_path,
+                                     int32_t field_name_id) {
+  Writer writer;
+  writer.WriteTableName(kFieldNamesTable);
+  writer.WriteResourcePath(collection_path);
+  writer.WriteFieldNameId(field_name_id);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbFieldNameKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kFieldNamesTable);
+  collection_path_ = reader.ReadResourcePath();
+  field_name_id_ = reader.ReadFieldNameId();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbArrayIndexKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kArrayIndexesTable);
+  return writer.result();
+}
+
+std::string LevelDbArrayIndexKey::KeyPrefix(absl::string_view collection_id) {
+  Writer writer;
+  writer.WriteTableName(kArrayIndexesTable);
+  writer.WriteCollectionId(collection_id);
+  return writer.result();
+}
+
+std::string LevelDbArrayIndexKey::Key(absl::string_view collection_id,
+                                      const FieldPath& field_path) {
+  Writer writer;
+  writer.WriteTableName(kArrayIndexesTable);
+  writer.WriteCollectionId(collection_id);
+  writer.WriteIndexedField(field_path);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbArrayIndexKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kArrayIndexesTable);
+  collection_id_ = reader.ReadCollectionId();
+  field_path_ = reader.ReadIndexedField();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbArrayIndexEntryKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kArrayIndexEntriesTable);
+  return writer.result();
+}
+
+std::string LevelDbArrayIndexEntryKey::KeyPrefix(
+    const ResourcePath& collection_path, const FieldPath& field_path) {
+  Writer writer;
+  writer.WriteTableName(kArrayIndexEntriesTable);
+  writer.WriteResourcePath(collection_path);
+  writer.WriteIndexedField(field_path);
+  return writer.result();
+}
+
+std::string LevelDbArrayIndexEntryKey::KeyPrefix(
+    const ResourcePath& collection_path,
+    const FieldPath& field_path,
+    absl::string_view index_value) {
+  Writer writer;
+  writer.WriteTableName(kArrayIndexEntriesTable);
+  writer.WriteResourcePath(collection_path);
+  writer.WriteIndexedField(field_path);
+  writer.WriteIndexValue(index_value);
+  return writer.result();
+}
+
+std::string LevelDbArrayIndexEntryKey::Key(const FieldPath& field_path,
+                                           absl::string_view index_value,
+                                           const DocumentKey& document_key) {
+  Writer writer;
+  writer.WriteTableName(kArrayIndexEntriesTable);
+  writer.WriteResourcePath(document_key.path().PopLast());
+  writer.WriteIndexedField(field_path);
+  writer.WriteIndexValue(index_value);
+  writer.WriteResourcePath(document_key.path());
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbArrayIndexEntryKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kArrayIndexEntriesTable);
+  collection_path_ = reader.ReadResourcePath();
+  field_path_ = reader.ReadIndexedField();
+  index_value_ = reader.ReadIndexValue();
+  document_key_ = reader.ReadDocumentKey();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+bool LevelDbPathView::SegmentEquals(size_t i, absl::string_view value) const {
+  return EncodedStringEquals(segments_[i], value);
+}
+
+bool LevelDbPathView::StartsWith(const ResourcePath& prefix) const {
+  if (prefix.size() > size()) {
+    return false;
+  }
+  for (size_t i = 0; i < prefix.size(); ++i) {
+    if (!SegmentEquals(i, prefix[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+ResourcePath LevelDbPathView::ToResourcePath() const {
+  ResourcePath::SegmentsT segments;
+  segments.reserve(segments_.size());
+  for (absl::string_view segment : segments_) {
+    segments.push_back(escaped_ ? UnescapeString(segment)
+                                : std::string{segment});
+  }
+  return ResourcePath{std::move(segments)};
+}
+
+DocumentKey LevelDbPathView::ToDocumentKey() const {
+  return DocumentKey{ToResourcePath()};
+}
+
+bool LevelDbTargetDocumentKeyView::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kTargetDocumentsTable);
+  target_id_ = reader.ReadTargetId();
+  reader.ReadDocumentPathView(&path_.segments_, &path_.encoded_,
+                              &path_.escaped_);
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+bool LevelDbDocumentTargetKeyView::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kDocumentTargetsTable);
+  reader.ReadDocumentPathView(&path_.segments_, &path_.encoded_,
+                              &path_.escaped_);
+  target_id_ = reader.ReadTargetId();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+bool LevelDbDocumentTargetSetKeyView::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kDocumentTargetSetsTable);
+  reader.ReadDocumentPathView(&path_.segments_, &path_.encoded_,
+                              &path_.escaped_);
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+bool LevelDbRemoteDocumentKeyView::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kRemoteDocumentsTable);
+  reader.ReadDocumentPathView(&path_.segments_, &path_.encoded_,
+                              &path_.escaped_);
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -17,9 +17,13 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_KEY_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_KEY_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "absl/strings/string_view.h"
@@ -74,6 +78,20 @@ namespace local {
 //   - path: ResourcePath
 //   - target_id: model::TargetId
 //
+// document_target_sets:
+//   - table_name: string = "document_target_set"
+//   - path: ResourcePath
+//
+// target_sequences:
+//   - table_name: string = "target_sequence"
+//   - sequence_number: model::ListenSequenceNumber
+//   - target_id: model::TargetId
+//
+// document_sequences:
+//   - table_name: string = "document_sequence"
+//   - sequence_number: model::ListenSequenceNumber
+//   - path: ResourcePath
+//
 // remote_documents:
 //   - table_name: string = "remote_document"
 //   - path: ResourcePath
@@ -82,6 +100,39 @@ namespace local {
 //   - table_name: string = "collection_parent"
 //   - collectionId: string
 //   - parent: ResourcePath
+//
+// field_indexes:
+//   - table_name: string = "field_index"
+//   - collection_id: string
+//   - indexed_field: string (a canonical FieldPath)
+//
+// migration_progress:
+//   - table_name: string = "migration_progress"
+//   - schema_version: int32_t
+//
+// field_index_entries:
+//   - table_name: string = "field_index_entry"
+//   - collection_path: ResourcePath
+//   - indexed_field: string (a canonical FieldPath)
+//   - index_value: string (an order-preserving encoding of a FieldValue)
+//   - path: ResourcePath
+//
+// field_names:
+//   - table_name: string = "field_name"
+//   - collection_path: ResourcePath
+//   - field_name_id: int32_t
+//
+// array_indexes:
+//   - table_name: string = "array_index"
+//   - collection_id: string
+//   - indexed_field: string (a canonical FieldPath)
+//
+// array_index_entries:
+//   - table_name: string = "array_index_entry"
+//   - collection_path: ResourcePath
+//   - indexed_field: string (a canonical FieldPath)
+//   - index_value: string (the encoding of an element of the indexed array)
+//   - path: ResourcePath
 
 /**
  * Parses the given key and returns a human readable description of its
@@ -101,6 +152,42 @@ class LevelDbVersionKey {
   static std::string Key();
 };
 
+/**
+ * A key in the migration_progress table, which holds a row for each migration
+ * that has been started but hasn't yet finished backfilling its index from the
+ * existing rows. The value of a row is the last key the backfill processed.
+ */
+class LevelDbMigrationProgressKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /** Creates a complete key that points to the given migration's progress. */
+  static std::string Key(int32_t schema_version);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The schema version of the migration, as encoded in the key. */
+  int32_t schema_version() const {
+    return schema_version_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  int32_t schema_version_;
+};
+
 /** A key in the mutations table. */
 class LevelDbMutationKey {
  public:
@@ -215,6 +302,89 @@ class LevelDbDocumentMutationKey {
   model::BatchId batch_id_;
 };
 
+/**
+ * A key in the collection_mutations index, which records the mutation batches
+ * affecting documents in each collection, keyed by the collection's ID and
+ * parent path. Unlike the document_mutations index, scanning the rows for a
+ * collection doesn't visit the mutations to documents in its subcollections.
+ */
+class LevelDbCollectionMutationKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * user_id.
+   */
+  static std::string KeyPrefix(absl::string_view user_id);
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * user_id and collection_id, across all parents.
+   */
+  static std::string KeyPrefix(absl::string_view user_id,
+                               absl::string_view collection_id);
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * user_id and collection.
+   *
+   * Note that a scan over this prefix also matches the rows of collections
+   * with the same ID nested below the collection, which have to be skipped.
+   */
+  static std::string KeyPrefix(absl::string_view user_id,
+                               const model::ResourcePath& collection_path);
+
+  /**
+   * Creates a complete key that points to a specific user_id, collection and
+   * batch_id.
+   */
+  static std::string Key(absl::string_view user_id,
+                         const model::ResourcePath& collection_path,
+                         model::BatchId batch_id);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The user that owns the mutation batches. */
+  const std::string& user_id() const {
+    return user_id_;
+  }
+
+  /** The collection_id, as encoded in the key. */
+  const std::string& collection_id() const {
+    return collection_id_;
+  }
+
+  /** The parent path of the collection, as encoded in the key. */
+  const model::ResourcePath& parent() const {
+    return parent_;
+  }
+
+  /** The batch_id that has mutations to documents in the collection. */
+  model::BatchId batch_id() const {
+    return batch_id_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  std::string user_id_;
+  std::string collection_id_;
+  model::ResourcePath parent_;
+  model::BatchId batch_id_;
+};
+
 /**
  * A key in the mutation_queues table.
  *
@@ -282,6 +452,13 @@ class LevelDbTargetKey {
   /** Creates a complete key that points to a specific target, by target_id. */
   static std::string Key(model::TargetId target_id);
 
+  /**
+   * Given the value of a target row, an encoded Target proto, returns its
+   * last_listen_sequence_number without decoding the rest of the target.
+   */
+  static model::ListenSequenceNumber DecodeSequenceNumber(
+      absl::string_view target_value);
+
   /**
    * Decodes the contents of a target key, storing the decoded values in this
    * instance.
@@ -403,6 +580,10 @@ class LevelDbTargetDocumentKey {
 /**
  * A key in the document targets table, an index from documents to the targets
  * that contain them.
+ *
+ * Since schema version 11 the targets of each document are stored as a single
+ * row in the document target sets table instead, and this table only holds
+ * the sentinel rows.
  */
 class LevelDbDocumentTargetKey {
  public:
@@ -469,6 +650,8 @@ class LevelDbDocumentTargetKey {
   }
 
  private:
+  friend class LevelDbDocumentTargetKeyView;
+
   // Used for sentinel row for a document in the document target index. No
   // target has the ID 0, and it will sort first in the list of targets for a
   // document.
@@ -479,6 +662,185 @@ class LevelDbDocumentTargetKey {
   model::DocumentKey document_key_;
 };
 
+/**
+ * A key in the document target sets table, which holds a row for each document
+ * that's in at least one target. The value is the TargetIdSet of the targets
+ * that contain the document, encoded with `TargetIdSet::Encode()`.
+ *
+ * The rows sort in the same order as the sentinel rows of their documents in
+ * the document targets table.
+ */
+class LevelDbDocumentTargetSetKey {
+ public:
+  /**
+   * Creates a key that contains just the document target sets table prefix
+   * and points just before the first key.
+   */
+  static std::string KeyPrefix();
+
+  /** Creates a complete key that points to the row of the given document. */
+  static std::string Key(const model::DocumentKey& document_key);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The path to the document, as encoded in the key. */
+  const model::DocumentKey& document_key() const {
+    return document_key_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  model::DocumentKey document_key_;
+};
+
+/**
+ * A key in the target sequences table, an index of the targets by their
+ * sequence numbers. Each target has exactly one row, whose key holds the
+ * sequence number in its target row, so the oldest targets come first.
+ */
+class LevelDbTargetSequenceKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /** Creates a complete key that points to the row of the given target. */
+  static std::string Key(model::ListenSequenceNumber sequence_number,
+                         model::TargetId target_id);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  model::ListenSequenceNumber sequence_number() const {
+    return sequence_number_;
+  }
+
+  model::TargetId target_id() const {
+    return target_id_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  model::ListenSequenceNumber sequence_number_;
+  model::TargetId target_id_;
+};
+
+/**
+ * A key in the document sequences table, an index of the sentinel rows in the
+ * document targets table by the sequence numbers they hold. Each sentinel row
+ * has exactly one row here, so the least recently used documents come first.
+ */
+class LevelDbDocumentSequenceKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /** Creates a complete key that points to the row of the given document. */
+  static std::string Key(model::ListenSequenceNumber sequence_number,
+                         const model::DocumentKey& document_key);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  model::ListenSequenceNumber sequence_number() const {
+    return sequence_number_;
+  }
+
+  /** The path to the document, as encoded in the key. */
+  const model::DocumentKey& document_key() const {
+    return document_key_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  model::ListenSequenceNumber sequence_number_;
+  model::DocumentKey document_key_;
+};
+
+/**
+ * A key in the query_results table, which holds the keys of the documents last
+ * in the result of a target's collection query, keyed by the queried
+ * collection so that changes to the collection can find the stored results
+ * they invalidate.
+ */
+class LevelDbQueryResultKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * collection.
+   *
+   * Note that a scan over this prefix also matches the rows of collections
+   * nested below the collection, which sort after the collection's own rows.
+   */
+  static std::string KeyPrefix(const model::ResourcePath& collection_path);
+
+  /**
+   * Creates a complete key that points to the stored result of the given
+   * target.
+   */
+  static std::string Key(const model::ResourcePath& collection_path,
+                         model::TargetId target_id);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The path to the queried collection, as encoded in the key. */
+  const model::ResourcePath& collection_path() const {
+    return collection_path_;
+  }
+
+  /** The target_id of the query, as encoded in the key. */
+  model::TargetId target_id() const {
+    return target_id_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  model::ResourcePath collection_path_;
+  model::TargetId target_id_;
+};
+
 /** A key in the remote documents table. */
 class LevelDbRemoteDocumentKey {
  public:
@@ -578,6 +940,509 @@ class LevelDbCollectionParentKey {
   model::ResourcePath parent_;
 };
 
+/**
+ * A key in the field indexes table, which records the declared field indexes
+ * (see FieldIndex). Each row associates a collection ID with a field path that
+ * should be indexed for all collections with that ID.
+ */
+class LevelDbFieldIndexKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * collection_id.
+   */
+  static std::string KeyPrefix(absl::string_view collection_id);
+
+  /**
+   * Creates a complete key that points to a specific collection_id and field
+   * path.
+   */
+  static std::string Key(absl::string_view collection_id,
+                         const model::FieldPath& field_path);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The collection_id, as encoded in the key. */
+  const std::string& collection_id() const {
+    return collection_id_;
+  }
+
+  /** The indexed field, as encoded in the key. */
+  const model::FieldPath& field_path() const {
+    return field_path_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  std::string collection_id_;
+  model::FieldPath field_path_;
+};
+
+/**
+ * A key in the field index entries table, which stores one row for each
+ * indexed field of each cached remote document.
+ *
+ * Entries are grouped by the collection containing the document and the
+ * indexed field, and then ordered by the encoded field value, so that a
+ * RelationFilter or orderBy on an indexed field can be executed as a range
+ * scan over the rows for one collection.
+ */
+class LevelDbFieldIndexEntryKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first entry for the given
+   * field in the given collection.
+   */
+  static std::string KeyPrefix(const model::ResourcePath& collection_path,
+                               const model::FieldPath& field_path);
+
+  /**
+   * Creates a key prefix that points just before the first entry with the
+   * given encoded value for the given field in the given collection.
+   */
+  static std::string KeyPrefix(const model::ResourcePath& collection_path,
+                               const model::FieldPath& field_path,
+                               absl::string_view index_value);
+
+  /**
+   * Creates a complete key that points to the entry for a specific document.
+   * The collection_path is implied by the document_key.
+   */
+  static std::string Key(const model::FieldPath& field_path,
+                         absl::string_view index_value,
+                         const model::DocumentKey& document_key);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The path of the collection containing the document. */
+  const model::ResourcePath& collection_path() const {
+    return collection_path_;
+  }
+
+  /** The indexed field, as encoded in the key. */
+  const model::FieldPath& field_path() const {
+    return field_path_;
+  }
+
+  /** The encoded value of the indexed field in the document. */
+  const std::string& index_value() const {
+    return index_value_;
+  }
+
+  /** The path to the document, as encoded in the key. */
+  const model::DocumentKey& document_key() const {
+    return document_key_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  model::ResourcePath collection_path_;
+  model::FieldPath field_path_;
+  std::string index_value_;
+  model::DocumentKey document_key_;
+};
+
+/**
+ * A key in the field names table, which stores the field name dictionaries of
+ * remote documents kept in the compact format (see FieldNameDictionary). Each
+ * row maps an ID to the field name it stands for in one collection.
+ */
+class LevelDbFieldNameKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first name of the given
+   * collection. Note that the prefix also matches the names of its
+   * subcollections, which sort after the collection's own names.
+   */
+  static std::string KeyPrefix(const model::ResourcePath& collection_path);
+
+  /**
+   * Creates a complete key that points to the name with the given ID in the
+   * given collection.
+   */
+  static std::string Key(const model::ResourcePath& collection_path,
+                         int32_t field_name_id);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The path of the collection the name belongs to. */
+  const model::ResourcePath& collection_path() const {
+    return collection_path_;
+  }
+
+  /** The ID of the name within its collection's dictionary. */
+  int32_t field_name_id() const {
+    return field_name_id_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  model::ResourcePath collection_path_;
+  int32_t field_name_id_;
+};
+
+/**
+ * A key in the array indexes table, which records the declared array-contains
+ * indexes (see FieldIndex::Kind::ArrayContains). Each row associates a
+ * collection ID with a field path whose array elements should be indexed for
+ * all collections with that ID.
+ */
+class LevelDbArrayIndexKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * collection_id.
+   */
+  static std::string KeyPrefix(absl::string_view collection_id);
+
+  /**
+   * Creates a complete key that points to a specific collection_id and field
+   * path.
+   */
+  static std::string Key(absl::string_view collection_id,
+                         const model::FieldPath& field_path);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The collection_id, as encoded in the key. */
+  const std::string& collection_id() const {
+    return collection_id_;
+  }
+
+  /** The indexed field, as encoded in the key. */
+  const model::FieldPath& field_path() const {
+    return field_path_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  std::string collection_id_;
+  model::FieldPath field_path_;
+};
+
+/**
+ * A key in the array index entries table, an inverted index which stores one
+ * row for each distinct element of each indexed array field of each cached
+ * remote document.
+ *
+ * The layout matches LevelDbFieldIndexEntryKey, with the encoded element in
+ * place of the encoded field value, so that an array-contains filter on an
+ * indexed field can be executed as a scan over the rows for a single value.
+ */
+class LevelDbArrayIndexEntryKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first entry for the given
+   * field in the given collection.
+   */
+  static std::string KeyPrefix(const model::ResourcePath& collection_path,
+                               const model::FieldPath& field_path);
+
+  /**
+   * Creates a key prefix that points just before the first entry with the
+   * given encoded element for the given field in the given collection.
+   */
+  static std::string KeyPrefix(const model::ResourcePath& collection_path,
+                               const model::FieldPath& field_path,
+                               absl::string_view index_value);
+
+  /**
+   * Creates a complete key that points to the entry for a specific document.
+   * The collection_path is implied by the document_key.
+   */
+  static std::string Key(const model::FieldPath& field_path,
+                         absl::string_view index_value,
+                         const model::DocumentKey& document_key);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The path of the collection containing the document. */
+  const model::ResourcePath& collection_path() const {
+    return collection_path_;
+  }
+
+  /** The indexed field, as encoded in the key. */
+  const model::FieldPath& field_path() const {
+    return field_path_;
+  }
+
+  /** The encoded array element, as encoded in the key. */
+  const std::string& index_value() const {
+    return index_value_;
+  }
+
+  /** The path to the document, as encoded in the key. */
+  const model::DocumentKey& document_key() const {
+    return document_key_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  model::ResourcePath collection_path_;
+  model::FieldPath field_path_;
+  std::string index_value_;
+  model::DocumentKey document_key_;
+};
+
+/**
+ * The path in a key, as views into the key rather than copies of its segments.
+ *
+ * Keys write path segments escaped, so a segment's view is the segment itself
+ * unless it contains a '\0' or '\xff' byte, in which case `escaped()` is true.
+ * The comparison helpers account for escaping either way.
+ *
+ * A view is only valid as long as the key it was decoded from. Decoding into
+ * the same view again reuses its storage, so a view that's reused across the
+ * rows of a scan doesn't allocate once it has seen the deepest path.
+ */
+class LevelDbPathView {
+ public:
+  size_t size() const {
+    return segments_.size();
+  }
+
+  bool empty() const {
+    return segments_.empty();
+  }
+
+  /** The segment at index `i`, as written in the key. */
+  absl::string_view segment(size_t i) const {
+    return segments_[i];
+  }
+
+  /** Whether any segment contains escaped bytes. */
+  bool escaped() const {
+    return escaped_;
+  }
+
+  /**
+   * The bytes of all the segments of the path, as written in the key. Two
+   * paths are equal if and only if their encodings are.
+   */
+  absl::string_view encoded() const {
+    return encoded_;
+  }
+
+  /** Whether the segment at index `i` is `value`. */
+  bool SegmentEquals(size_t i, absl::string_view value) const;
+
+  /** Whether `prefix` is a prefix of (or equal to) this path. */
+  bool StartsWith(const model::ResourcePath& prefix) const;
+
+  /** Decodes the path, allocating its segments. */
+  model::ResourcePath ToResourcePath() const;
+
+  /**
+   * Decodes the path as a document key. The view decoders only accept keys
+   * whose paths are valid document keys.
+   */
+  model::DocumentKey ToDocumentKey() const;
+
+  friend bool operator==(const LevelDbPathView& lhs,
+                         const LevelDbPathView& rhs) {
+    return lhs.encoded_ == rhs.encoded_;
+  }
+
+  friend bool operator!=(const LevelDbPathView& lhs,
+                         const LevelDbPathView& rhs) {
+    return !(lhs == rhs);
+  }
+
+ private:
+  friend class LevelDbDocumentTargetKeyView;
+  friend class LevelDbDocumentTargetSetKeyView;
+  friend class LevelDbRemoteDocumentKeyView;
+  friend class LevelDbTargetDocumentKeyView;
+
+  std::vector<absl::string_view> segments_;
+  absl::string_view encoded_;
+  bool escaped_ = false;
+};
+
+/**
+ * Decodes keys in the target documents table like LevelDbTargetDocumentKey,
+ * but without allocating: the decoded path points into the key.
+ */
+class LevelDbTargetDocumentKeyView {
+ public:
+  /**
+   * Decodes the given complete key into this view.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  model::TargetId target_id() const {
+    return target_id_;
+  }
+
+  const LevelDbPathView& path() const {
+    return path_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  model::TargetId target_id_;
+  LevelDbPathView path_;
+};
+
+/**
+ * Decodes keys in the document targets table like LevelDbDocumentTargetKey,
+ * but without allocating: the decoded path points into the key.
+ */
+class LevelDbDocumentTargetKeyView {
+ public:
+  /**
+   * Decodes the given complete key into this view.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  model::TargetId target_id() const {
+    return target_id_;
+  }
+
+  /** Returns true if this is the sentinel row of its document. */
+  bool IsSentinel() const {
+    return target_id_ == LevelDbDocumentTargetKey::kInvalidTargetId;
+  }
+
+  const LevelDbPathView& path() const {
+    return path_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  model::TargetId target_id_;
+  LevelDbPathView path_;
+};
+
+/**
+ * Decodes keys in the document target sets table like
+ * LevelDbDocumentTargetSetKey, but without allocating: the decoded path points
+ * into the key.
+ */
+class LevelDbDocumentTargetSetKeyView {
+ public:
+  /**
+   * Decodes the given complete key into this view.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  const LevelDbPathView& path() const {
+    return path_;
+  }
+
+ private:
+  LevelDbPathView path_;
+};
+
+/**
+ * Decodes keys in the remote documents table like LevelDbRemoteDocumentKey,
+ * but without allocating: the decoded path points into the key.
+ */
+class LevelDbRemoteDocumentKeyView {
+ public:
+  /**
+   * Decodes the given complete key into this view.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  const LevelDbPathView& path() const {
+    return path_;
+  }
+
+ private:
+  LevelDbPathView path_;
+};
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -16,17 +16,25 @@
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_migrations.h"
 
+#include <algorithm>
+#include <map>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/Protos/nanopb/firestore/local/mutation.nanopb.h"
 #include "Firestore/Protos/nanopb/firestore/local/target.nanopb.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_util.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_index_manager.h"
+#include "Firestore/core/src/firebase/firestore/local/target_id_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/decode_context.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/string_util.h"
 #include "absl/strings/match.h"
 
 namespace firebase {
@@ -39,6 +47,7 @@ using leveldb::Status;
 using leveldb::WriteOptions;
 using model::DocumentKey;
 using model::ResourcePath;
+using nanopb::DecodeContext;
 using nanopb::Reader;
 using nanopb::Writer;
 
@@ -63,9 +72,25 @@ namespace {
  *   * Migration 4 ensures that every document in the remote document cache
  *     has a sentinel row with a sequence number.
  *   * Migration 5 drops held write acks.
- *   * Migration 6 populates the collection_parents index.
+ *   * Migration 6 populates the collection_parents index (in backfill chunks).
+ *   * Migration 7 computes the running byte size kept in the target_global
+ *     row.
+ *   * Migration 8 populates the collection_mutations index (in backfill
+ *     chunks).
+ *   * Migration 9 introduces the field_name table, after which remote
+ *     documents may be stored in the compact format. No rows change, but
+ *     the version records that older clients may be unable to read the cache.
+ *   * Migration 10 allows remote documents to be stored compressed. Like
+ *     migration 9, it only records the version.
+ *   * Migration 11 replaces the document_target rows of each document (other
+ *     than its sentinel row) with a single document_target_set row.
+ *   * Migration 12 builds the target_sequence and document_sequence indexes,
+ *     which order targets and sentinel rows by sequence number.
  */
-const LevelDbMigrations::SchemaVersion kSchemaVersion = 6;
+const LevelDbMigrations::SchemaVersion kSchemaVersion = 12;
+
+/** The number of rows backfilled per transaction when migrations run eagerly. */
+const size_t kBackfillChunkRows = 1000;
 
 /**
  * Save the given version number as the current version of the schema of the
@@ -81,19 +106,23 @@ void SaveVersion(LevelDbMigrations::SchemaVersion version,
 }
 
 void DeleteEverythingWithPrefix(const std::string& prefix, leveldb::DB* db) {
+  static constexpr size_t kMaxDeletes = 1000;
+
+  // The rows are read once and deleted, so there's no point caching them.
+  LevelDbTransaction::IteratorOptions options;
+  options.upper_bound = util::PrefixSuccessor(prefix);
+  options.fill_cache = false;
+
   bool more_deletes = true;
   while (more_deletes) {
     LevelDbTransaction transaction(db, "Delete everything with prefix");
-    auto it = transaction.NewIterator();
-
-    more_deletes = false;
-    for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix);
-         it->Next()) {
-      if (transaction.changed_keys() >= 1000) {
-        more_deletes = true;
-        break;
-      }
-      transaction.Delete(it->key());
+    auto it = transaction.NewIterator(options);
+
+    LevelDbTransaction::Rows rows;
+    it->Seek(prefix);
+    more_deletes = it->NextN(kMaxDeletes, &rows) == kMaxDeletes && it->Valid();
+    for (const auto& row : rows) {
+      transaction.Delete(row.first);
     }
 
     transaction.Commit();
@@ -104,6 +133,7 @@ void DeleteEverythingWithPrefix(const std::string& prefix, leveldb::DB* db) {
 void ClearQueryCache(leveldb::DB* db) {
   DeleteEverythingWithPrefix(LevelDbTargetKey::KeyPrefix(), db);
   DeleteEverythingWithPrefix(LevelDbDocumentTargetKey::KeyPrefix(), db);
+  DeleteEverythingWithPrefix(LevelDbDocumentTargetSetKey::KeyPrefix(), db);
   DeleteEverythingWithPrefix(LevelDbTargetDocumentKey::KeyPrefix(), db);
   DeleteEverythingWithPrefix(LevelDbQueryTargetKey::KeyPrefix(), db);
 
@@ -167,6 +197,7 @@ void RemoveAcknowledgedMutations(leveldb::DB* db) {
   std::string mutation_queue_start = LevelDbMutationQueueKey::KeyPrefix();
 
   LevelDbMutationQueueKey key;
+  DecodeContext context;
 
   auto it = transaction.NewIterator();
   it->Seek(mutation_queue_start);
@@ -175,13 +206,14 @@ void RemoveAcknowledgedMutations(leveldb::DB* db) {
     HARD_ASSERT(key.Decode(it->key()), "Failed to decode mutation queue key");
     firestore_client_MutationQueue mutation_queue{};
     Reader reader = Reader::Wrap(it->value());
-    reader.ReadNanopbMessage(firestore_client_MutationQueue_fields,
-                             &mutation_queue);
+    context.ReadNanopbMessage(&reader, firestore_client_MutationQueue_fields,
+                              &mutation_queue);
     HARD_ASSERT(reader.status().ok(), "Failed to deserialize MutationQueue");
     RemoveMutationBatches(&transaction, key.user_id(),
                           mutation_queue.last_acknowledged_batch_id);
     RemoveMutationDocuments(&transaction, key.user_id(),
                             mutation_queue.last_acknowledged_batch_id);
+    context.Reset();
   }
 
   SaveVersion(5, &transaction);
@@ -264,48 +296,258 @@ void EnsureCollectionParentRow(LevelDbTransaction* transaction,
   }
 }
 
+/** Returns the total size of the keys and values of the rows under `prefix`. */
+int64_t SizeOfRowsWithPrefix(LevelDbTransaction* transaction,
+                             const std::string& prefix) {
+  int64_t size = 0;
+  auto it = transaction->NewIterator();
+  for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix);
+       it->Next()) {
+    size += static_cast<int64_t>(it->key().size() + it->value().size());
+  }
+  return size;
+}
+
 /**
- * Migration 6.
+ * Migration 7.
  *
- * Creates appropriate LevelDbCollectionParentKey rows for all collections
- * of documents in the remote document cache and mutation queue.
+ * Initializes the running byte size in the target_global row from the rows
+ * that count towards it: remote documents, targets and mutation batches.
+ * Rerunning it (after a downgrade) discards any drift left by versions that
+ * didn't maintain the count.
  */
-void EnsureCollectionParentsIndex(leveldb::DB* db) {
-  LevelDbTransaction transaction(db, "Ensure Collection Parents Index");
+void CalculateByteSize(leveldb::DB* db) {
+  LevelDbTransaction transaction(db, "Calculate byte size");
 
-  MemoryCollectionParentIndex cache;
+  std::string bytes;
+  transaction.Get(LevelDbTargetGlobalKey::Key(), &bytes);
+  firestore_client_TargetGlobal target_global{};
+  Reader reader = Reader::Wrap(bytes);
+  reader.ReadNanopbMessage(firestore_client_TargetGlobal_fields,
+                           &target_global);
+  HARD_ASSERT(reader.status().ok(), "Failed to deserialize TargetGlobal");
 
-  // Index existing remote documents.
-  std::string documents_prefix = LevelDbRemoteDocumentKey::KeyPrefix();
-  auto it = transaction.NewIterator();
-  it->Seek(documents_prefix);
+  target_global.byte_size =
+      SizeOfRowsWithPrefix(&transaction,
+                           LevelDbRemoteDocumentKey::KeyPrefix()) +
+      SizeOfRowsWithPrefix(&transaction, LevelDbTargetKey::KeyPrefix()) +
+      SizeOfRowsWithPrefix(&transaction, LevelDbMutationKey::KeyPrefix());
+
+  bytes.clear();
+  Writer writer = Writer::Wrap(&bytes);
+  writer.WriteNanopbMessage(firestore_client_TargetGlobal_fields,
+                            &target_global);
+  transaction.Put(LevelDbTargetGlobalKey::Key(), std::move(bytes));
+
+  SaveVersion(7, &transaction);
+  transaction.Commit();
+}
+
+/**
+ * Migrations 6 and 8 only populate an index from existing rows, so rather than
+ * running in one transaction they're started and then backfilled in chunks.
+ * Starting a migration records it in the migration_progress table; each
+ * chunk saves the last key it processed there, and the row is deleted once the
+ * backfill reaches the end. Writes maintain the indexes for the rows they
+ * touch, so a pending backfill never loses their entries, and reads that need
+ * an index must finish its migration first.
+ *
+ * Migration 6 creates LevelDbCollectionParentKey rows for all collections of
+ * documents in the remote document cache and mutation queue.
+ *
+ * Migration 8 rebuilds the collection_mutations index from the
+ * document_mutations index. Any existing rows are dropped first since versions
+ * that didn't maintain the index may have removed batches since it was last
+ * built.
+ */
+void StartBackfill(LevelDbMigrations::SchemaVersion version,
+                   leveldb::DB* db) {
+  if (version == LevelDbMigrations::kCollectionMutationsIndex) {
+    DeleteEverythingWithPrefix(LevelDbCollectionMutationKey::KeyPrefix(), db);
+  }
+
+  LevelDbTransaction transaction(db, "Start migration");
+  transaction.Put(LevelDbMigrationProgressKey::Key(version), std::string{});
+  SaveVersion(version, &transaction);
+  transaction.Commit();
+}
+
+/**
+ * Returns the prefixes of the rows the given migration backfills its index
+ * from, in key order.
+ */
+std::vector<std::string> BackfillSources(
+    LevelDbMigrations::SchemaVersion version) {
+  switch (version) {
+    case LevelDbMigrations::kCollectionParentsIndex:
+      return {LevelDbDocumentMutationKey::KeyPrefix(),
+              LevelDbRemoteDocumentKey::KeyPrefix()};
+    case LevelDbMigrations::kCollectionMutationsIndex:
+      return {LevelDbDocumentMutationKey::KeyPrefix()};
+    default:
+      HARD_FAIL("Migration %s doesn't have a backfill", version);
+  }
+}
+
+/** Writes the index entry of the given migration for the row at `key`. */
+void BackfillRow(LevelDbMigrations::SchemaVersion version,
+                 LevelDbTransaction* transaction,
+                 MemoryCollectionParentIndex* cache,
+                 absl::string_view key) {
   LevelDbRemoteDocumentKey document_key;
-  for (; it->Valid() && absl::StartsWith(it->key(), documents_prefix);
-       it->Next()) {
-    HARD_ASSERT(document_key.Decode(it->key()),
-                "Failed to decode document key");
+  if (absl::StartsWith(key, LevelDbRemoteDocumentKey::KeyPrefix())) {
+    HARD_ASSERT(document_key.Decode(key), "Failed to decode document key");
+    EnsureCollectionParentRow(transaction, cache, document_key.document_key());
+    return;
+  }
 
-    EnsureCollectionParentRow(&transaction, &cache,
-                              document_key.document_key());
+  LevelDbDocumentMutationKey mutation_key;
+  HARD_ASSERT(mutation_key.Decode(key),
+              "Failed to decode document-mutation key");
+  if (version == LevelDbMigrations::kCollectionParentsIndex) {
+    EnsureCollectionParentRow(transaction, cache, mutation_key.document_key());
+  } else {
+    std::string empty_buffer;
+    transaction->Put(LevelDbCollectionMutationKey::Key(
+                         mutation_key.user_id(),
+                         mutation_key.document_key().path().PopLast(),
+                         mutation_key.batch_id()),
+                     empty_buffer);
   }
+}
 
-  // Index existing mutations.
-  std::string mutations_prefix = LevelDbDocumentMutationKey::KeyPrefix();
-  it = transaction.NewIterator();
-  it->Seek(mutations_prefix);
-  LevelDbDocumentMutationKey key;
-  for (; it->Valid() && absl::StartsWith(it->key(), mutations_prefix);
-       it->Next()) {
-    HARD_ASSERT(key.Decode(it->key()),
-                "Failed to decode document-mutation key");
+/**
+ * Marks the cache as possibly containing compact remote documents. There's no
+ * data to migrate: the field_name table is filled as documents are written.
+ */
+void AllowCompactRemoteDocuments(leveldb::DB* db) {
+  LevelDbTransaction transaction(db, "Allow compact remote documents");
+  SaveVersion(9, &transaction);
+  transaction.Commit();
+}
+
+/**
+ * Marks the cache as possibly containing compressed remote documents, which
+ * are written as they become large enough to be worth it.
+ */
+void AllowCompressedRemoteDocuments(leveldb::DB* db) {
+  LevelDbTransaction transaction(db, "Allow compressed remote documents");
+  SaveVersion(10, &transaction);
+  transaction.Commit();
+}
 
-    EnsureCollectionParentRow(&transaction, &cache, key.document_key());
+/**
+ * Migration 11.
+ *
+ * Builds the document_target_set row of each document from the
+ * target_document rows, which every version has maintained, and drops the
+ * document_target rows other than the sentinels. Rerunning it (after a
+ * downgrade) discards target sets that versions writing document_target rows
+ * didn't keep up to date.
+ */
+void BuildDocumentTargetSets(leveldb::DB* db) {
+  DeleteEverythingWithPrefix(LevelDbDocumentTargetSetKey::KeyPrefix(), db);
+
+  LevelDbTransaction transaction(db, "Build document target sets");
+
+  // Every row is read once, so none of them are worth caching.
+  LevelDbTransaction::IteratorOptions options;
+  options.fill_cache = false;
+
+  std::string document_target_prefix = LevelDbDocumentTargetKey::KeyPrefix();
+  options.upper_bound = util::PrefixSuccessor(document_target_prefix);
+  auto it = transaction.NewIterator(options);
+  LevelDbDocumentTargetKeyView document_target_key;
+  for (it->Seek(document_target_prefix); it->Valid(); it->Next()) {
+    HARD_ASSERT(document_target_key.Decode(it->key()),
+                "Failed to decode document-target key");
+    if (!document_target_key.IsSentinel()) {
+      transaction.Delete(it->key());
+    }
+  }
+
+  std::map<DocumentKey, TargetIdSet> target_sets;
+  std::string target_document_prefix = LevelDbTargetDocumentKey::KeyPrefix();
+  options.upper_bound = util::PrefixSuccessor(target_document_prefix);
+  it = transaction.NewIterator(options);
+  LevelDbTargetDocumentKey target_document_key;
+  for (it->Seek(target_document_prefix); it->Valid(); it->Next()) {
+    HARD_ASSERT(target_document_key.Decode(it->key()),
+                "Failed to decode target-document key");
+    target_sets[target_document_key.document_key()].insert(
+        target_document_key.target_id());
+  }
+
+  for (const auto& entry : target_sets) {
+    transaction.Put(LevelDbDocumentTargetSetKey::Key(entry.first),
+                    entry.second.Encode());
+  }
+
+  SaveVersion(11, &transaction);
+  transaction.Commit();
+}
+
+/**
+ * Migration 12.
+ *
+ * Builds the target_sequence and document_sequence indexes from the targets
+ * and the sentinel rows. Like migration 11 it drops any existing rows first, so
+ * rerunning it (after a downgrade) discards entries that versions without the
+ * indexes left behind.
+ */
+void BuildSequenceNumberIndexes(leveldb::DB* db) {
+  DeleteEverythingWithPrefix(LevelDbTargetSequenceKey::KeyPrefix(), db);
+  DeleteEverythingWithPrefix(LevelDbDocumentSequenceKey::KeyPrefix(), db);
+
+  LevelDbTransaction transaction(db, "Build sequence number indexes");
+
+  // Every row is read once, so none of them are worth caching.
+  LevelDbTransaction::IteratorOptions options;
+  options.fill_cache = false;
+  std::string empty_buffer;
+
+  std::string target_prefix = LevelDbTargetKey::KeyPrefix();
+  options.upper_bound = util::PrefixSuccessor(target_prefix);
+  auto it = transaction.NewIterator(options);
+  LevelDbTargetKey target_key;
+  for (it->Seek(target_prefix); it->Valid(); it->Next()) {
+    HARD_ASSERT(target_key.Decode(MakeSlice(it->key())),
+                "Failed to decode target key");
+    transaction.Put(
+        LevelDbTargetSequenceKey::Key(
+            LevelDbTargetKey::DecodeSequenceNumber(it->value()),
+            target_key.target_id()),
+        empty_buffer);
+  }
+
+  std::string document_target_prefix = LevelDbDocumentTargetKey::KeyPrefix();
+  options.upper_bound = util::PrefixSuccessor(document_target_prefix);
+  it = transaction.NewIterator(options);
+  LevelDbDocumentTargetKey document_target_key;
+  for (it->Seek(document_target_prefix); it->Valid(); it->Next()) {
+    HARD_ASSERT(document_target_key.Decode(it->key()),
+                "Failed to decode document-target key");
+    if (document_target_key.IsSentinel()) {
+      transaction.Put(
+          LevelDbDocumentSequenceKey::Key(
+              LevelDbDocumentTargetKey::DecodeSentinelValue(it->value()),
+              document_target_key.document_key()),
+          empty_buffer);
+    }
   }
 
-  SaveVersion(6, &transaction);
+  SaveVersion(12, &transaction);
   transaction.Commit();
 }
 
+/** Starts the given migration and backfills it to completion. */
+void RunBackfill(LevelDbMigrations::SchemaVersion version, leveldb::DB* db) {
+  StartBackfill(version, db);
+  while (!LevelDbMigrations::RunPendingMigrationChunk(db, version,
+                                                      kBackfillChunkRows)) {
+  }
+}
+
 }  // namespace
 
 LevelDbMigrations::SchemaVersion LevelDbMigrations::ReadSchemaVersion(
@@ -321,12 +563,33 @@ LevelDbMigrations::SchemaVersion LevelDbMigrations::ReadSchemaVersion(
   }
 }
 
+constexpr LevelDbMigrations::SchemaVersion
+    LevelDbMigrations::kCollectionParentsIndex;
+constexpr LevelDbMigrations::SchemaVersion
+    LevelDbMigrations::kCollectionMutationsIndex;
+
 void LevelDbMigrations::RunMigrations(leveldb::DB* db) {
   RunMigrations(db, kSchemaVersion);
 }
 
 void LevelDbMigrations::RunMigrations(leveldb::DB* db,
                                       SchemaVersion to_version) {
+  RunMigrations(db, to_version, /*defer_backfills=*/false);
+
+  // Also finish any migrations a previous deferred start left pending.
+  for (SchemaVersion version : ReadPendingMigrations(db)) {
+    while (!RunPendingMigrationChunk(db, version, kBackfillChunkRows)) {
+    }
+  }
+}
+
+void LevelDbMigrations::StartMigrations(leveldb::DB* db) {
+  RunMigrations(db, kSchemaVersion, /*defer_backfills=*/true);
+}
+
+void LevelDbMigrations::RunMigrations(leveldb::DB* db,
+                                      SchemaVersion to_version,
+                                      bool defer_backfills) {
   SchemaVersion from_version = ReadSchemaVersion(db);
   // If this is a downgrade, just save the downgrade version so we can
   // detect it when we go to upgrade again, allowing us to rerun the
@@ -354,8 +617,100 @@ void LevelDbMigrations::RunMigrations(leveldb::DB* db,
   }
 
   if (from_version < 6 && to_version >= 6) {
-    EnsureCollectionParentsIndex(db);
+    if (defer_backfills) {
+      StartBackfill(kCollectionParentsIndex, db);
+    } else {
+      RunBackfill(kCollectionParentsIndex, db);
+    }
+  }
+
+  if (from_version < 7 && to_version >= 7) {
+    CalculateByteSize(db);
+  }
+
+  if (from_version < 8 && to_version >= 8) {
+    if (defer_backfills) {
+      StartBackfill(kCollectionMutationsIndex, db);
+    } else {
+      RunBackfill(kCollectionMutationsIndex, db);
+    }
+  }
+
+  if (from_version < 9 && to_version >= 9) {
+    AllowCompactRemoteDocuments(db);
+  }
+
+  if (from_version < 10 && to_version >= 10) {
+    AllowCompressedRemoteDocuments(db);
+  }
+
+  if (from_version < 11 && to_version >= 11) {
+    BuildDocumentTargetSets(db);
+  }
+
+  if (from_version < 12 && to_version >= 12) {
+    BuildSequenceNumberIndexes(db);
+  }
+}
+
+std::vector<LevelDbMigrations::SchemaVersion>
+LevelDbMigrations::ReadPendingMigrations(leveldb::DB* db) {
+  std::vector<SchemaVersion> result;
+
+  LevelDbTransaction transaction(db, "Read pending migrations");
+  std::string prefix = LevelDbMigrationProgressKey::KeyPrefix();
+  auto it = transaction.NewIterator();
+  LevelDbMigrationProgressKey key;
+  for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix);
+       it->Next()) {
+    HARD_ASSERT(key.Decode(it->key()),
+                "Failed to decode migration progress key");
+    result.push_back(key.schema_version());
+  }
+  return result;
+}
+
+bool LevelDbMigrations::RunPendingMigrationChunk(leveldb::DB* db,
+                                                 SchemaVersion version,
+                                                 size_t max_rows) {
+  LevelDbTransaction transaction(db, "Run pending migration chunk");
+  std::string progress_key = LevelDbMigrationProgressKey::Key(version);
+  std::string last_key;
+  if (transaction.Get(progress_key, &last_key).IsNotFound()) {
+    return true;
+  }
+
+  MemoryCollectionParentIndex cache;
+  size_t rows = 0;
+  // Backfills read every row of their sources once, which would only push
+  // blocks that are read often out of the cache.
+  LevelDbTransaction::IteratorOptions options;
+  options.fill_cache = false;
+  auto it = transaction.NewIterator(options);
+  for (const std::string& prefix : BackfillSources(version)) {
+    // The last key is empty when nothing has been processed yet, or it's past
+    // the rows of the prefixes that were processed already.
+    it->Seek(std::max(prefix, last_key));
+    if (it->Valid() && it->key() == last_key) {
+      it->Next();
+    }
+
+    for (; it->Valid() && absl::StartsWith(it->key(), prefix); it->Next()) {
+      if (rows == max_rows) {
+        transaction.Put(progress_key, std::move(last_key));
+        transaction.Commit();
+        return false;
+      }
+
+      last_key = std::string{it->key()};
+      BackfillRow(version, &transaction, &cache, last_key);
+      rows++;
+    }
   }
+
+  transaction.Delete(progress_key);
+  transaction.Commit();
+  return true;
 }
 
 }  // namespace local
@@ -17,7 +17,9 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_MIGRATIONS_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_MIGRATIONS_H_
 
+#include <cstddef>
 #include <cstdint>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
 #include "Firestore/core/src/firebase/firestore/local/local_serializer.h"
@@ -44,9 +46,45 @@ class LevelDbMigrations {
 
   /**
    * Runs any migrations needed to bring the given database up to the given
-   * schema version
+   * schema version, and finishes any that were left pending by
+   * StartMigrations.
    */
   static void RunMigrations(leveldb::DB* db, SchemaVersion version);
+
+  /** The migration that backfills the collection_parents index. */
+  static constexpr SchemaVersion kCollectionParentsIndex = 6;
+
+  /** The migration that backfills the collection_mutations index. */
+  static constexpr SchemaVersion kCollectionMutationsIndex = 8;
+
+  /**
+   * Like RunMigrations, but the migrations that only backfill an index from
+   * existing rows are merely started, so that opening a large database doesn't
+   * wait for them. Until a migration's backfill is finished with
+   * RunPendingMigrationChunk, the index it populates is incomplete.
+   */
+  static void StartMigrations(leveldb::DB* db);
+
+  /**
+   * Returns the migrations that have been started but haven't finished their
+   * backfill, in order.
+   */
+  static std::vector<SchemaVersion> ReadPendingMigrations(leveldb::DB* db);
+
+  /**
+   * Backfills up to `max_rows` more rows of the given pending migration, in a
+   * transaction of its own.
+   *
+   * @return true if the migration has finished.
+   */
+  static bool RunPendingMigrationChunk(leveldb::DB* db,
+                                       SchemaVersion version,
+                                       size_t max_rows);
+
+ private:
+  static void RunMigrations(leveldb::DB* db,
+                            SchemaVersion version,
+                            bool defer_backfills);
 };
 
 }  // namespace local
@@ -25,6 +25,7 @@
 
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #import "Firestore/Source/Public/FIRTimestamp.h"
@@ -77,6 +78,8 @@ class LevelDbMutationQueue : public MutationQueue {
 
   void RemoveMutationBatch(FSTMutationBatch* batch) override;
 
+  void ReplaceMutationBatch(FSTMutationBatch* batch) override;
+
   std::vector<FSTMutationBatch*> AllMutationBatches() override;
 
   std::vector<FSTMutationBatch*> AllMutationBatchesAffectingDocumentKeys(
@@ -100,6 +103,13 @@ class LevelDbMutationQueue : public MutationQueue {
 
   void SetLastStreamToken(NSData* _Nullable stream_token) override;
 
+  /** Estimates the batches decoded into `batch_cache_`. */
+  size_t EstimatedMemoryUsage() override;
+
+  void ReleaseCachedBatches() override {
+    batch_cache_.clear();
+  }
+
  private:
   /**
    * Constructs a vector of matching batches, sorted by batchID to ensure that
@@ -119,6 +129,10 @@ class LevelDbMutationQueue : public MutationQueue {
   /** Parses the MutationQueue metadata from the given LevelDB row contents. */
   FSTPBMutationQueue* _Nullable MetadataForKey(const std::string& key);
 
+  /**
+   * Decodes a serialized FSTPBWriteBatch. The bytes are parsed where they
+   * are, without being copied, so `encoded` can point into a LevelDB row.
+   */
   FSTMutationBatch* ParseMutationBatch(absl::string_view encoded);
 
   // This instance is owned by FSTLevelDB; avoid a retain cycle.
@@ -145,6 +159,13 @@ class LevelDbMutationQueue : public MutationQueue {
    * A write-through cache copy of the metadata describing the current queue.
    */
   FSTPBMutationQueue* _Nullable metadata_;
+
+  /**
+   * The decoded mutation batches of this queue, keyed by batch ID, so that
+   * repeated lookups of pending batches don't parse them again. Entries are
+   * added as batches are written or read and dropped when they're removed.
+   */
+  std::unordered_map<model::BatchId, FSTMutationBatch*> batch_cache_;
 };
 
 }  // namespace local
@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_mutation_queue.h"
 
+#include <algorithm>
 #include <memory>
 #include <utility>
 
@@ -26,7 +27,7 @@
 #import "Firestore/Source/Model/FSTMutation.h"
 #import "Firestore/Source/Model/FSTMutationBatch.h"
 
-#include "Firestore/core/src/firebase/firestore/local/leveldb_util.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_migrations.h"
 #include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/util/string_util.h"
@@ -41,7 +42,6 @@ namespace local {
 
 using auth::User;
 using leveldb::DB;
-using leveldb::Iterator;
 using leveldb::Status;
 using model::BatchId;
 using model::DocumentKey;
@@ -50,69 +50,22 @@ using model::kBatchIdUnknown;
 using model::ResourcePath;
 
 BatchId LoadNextBatchIdFromDb(DB* db) {
-  // TODO(gsoltis): implement Prev() and SeekToLast() on
-  // LevelDbTransaction::Iterator, then port this to a transaction.
-  std::unique_ptr<Iterator> it(
-      db->NewIterator(LevelDbTransaction::DefaultReadOptions()));
-
+  LevelDbTransaction transaction(db, "Load next batch id");
   std::string table_key = LevelDbMutationKey::KeyPrefix();
+  LevelDbTransaction::IteratorOptions options;
+  options.upper_bound = util::PrefixSuccessor(table_key);
+  auto it = transaction.NewIterator(options);
 
+  // Batch ids increase within the rows of each user, so the last row of every
+  // user holds that user's highest batch id. Visit those rows from the end of
+  // the table back, seeking past the rest of each user's rows.
   LevelDbMutationKey row_key;
   BatchId max_batch_id = kBatchIdUnknown;
-
-  bool more_user_ids = false;
-  std::string next_user_id;
-
-  it->Seek(table_key);
-  if (it->Valid() && row_key.Decode(MakeStringView(it->key()))) {
-    more_user_ids = true;
-    next_user_id = row_key.user_id();
-  }
-
-  // This loop assumes that nextUserId contains the next username at the start
-  // of the iteration.
-  while (more_user_ids) {
-    // Compute the first key after the last mutation for next_user_id.
-    std::string user_end = LevelDbMutationKey::KeyPrefix(next_user_id);
-    user_end = util::PrefixSuccessor(user_end);
-
-    // Seek to that key with the intent of finding the boundary between
-    // next_user_id's mutations and the one after that (if any).
-    it->Seek(user_end);
-
-    // At this point there are three possible cases to handle differently. Each
-    // case must prepare the next iteration (by assigning to next_user_id or
-    // setting more_user_ids = NO) and seek the iterator to the last row in the
-    // current user's mutation sequence.
-    if (!it->Valid()) {
-      // The iterator is past the last row altogether (there are no additional
-      // userIDs and now rows in any table after mutations). The last row will
-      // have the highest batchID.
-      more_user_ids = false;
-      it->SeekToLast();
-
-    } else if (row_key.Decode(MakeStringView(it->key()))) {
-      // The iterator is valid and the key decoded successfully so the next user
-      // was just decoded.
-      next_user_id = row_key.user_id();
-      it->Prev();
-
-    } else {
-      // The iterator is past the end of the mutations table but there are other
-      // rows.
-      more_user_ids = false;
-      it->Prev();
-    }
-
-    // In all the cases above there was at least one row for the current user
-    // and each case has set things up such that iterator points to it.
-    if (!row_key.Decode(MakeStringView(it->key()))) {
-      HARD_FAIL("There should have been a key previous to %s", user_end);
-    }
-
-    if (row_key.batch_id() > max_batch_id) {
-      max_batch_id = row_key.batch_id();
-    }
+  for (it->SeekToLast(); it->Valid() && absl::StartsWith(it->key(), table_key);
+       it->SeekBefore(LevelDbMutationKey::KeyPrefix(row_key.user_id()))) {
+    HARD_ASSERT(row_key.Decode(it->key()), "Failed to decode mutation key %s",
+                DescribeKey(it));
+    max_batch_id = std::max(max_batch_id, row_key.batch_id());
   }
 
   return max_batch_id + 1;
@@ -169,6 +122,9 @@ FSTMutationBatch* LevelDbMutationQueue::AddMutationBatch(
                                       mutations:std::move(mutations)];
   std::string key = mutation_batch_key(batch_id);
   db_.currentTransaction->Put(key, [serializer_ encodedMutationBatch:batch]);
+  [db_ adjustByteSize:db_.currentTransaction->RowSize(key)];
+  // The batch is sent to the backend once committed, so it must not be lost.
+  [db_ requireDurableCommit];
 
   // Store an empty value in the index which is equivalent to serializing a
   // GPBEmpty message. In the future if we wanted to store some other kind of
@@ -180,9 +136,14 @@ FSTMutationBatch* LevelDbMutationQueue::AddMutationBatch(
     key = LevelDbDocumentMutationKey::Key(user_id_, mutation.key, batch_id);
     db_.currentTransaction->Put(key, empty_buffer);
 
+    key = LevelDbCollectionMutationKey::Key(
+        user_id_, mutation.key.path().PopLast(), batch_id);
+    db_.currentTransaction->Put(key, empty_buffer);
+
     db_.indexManager->AddToCollectionParentIndex(mutation.key.path().PopLast());
   }
 
+  batch_cache_[batch_id] = batch;
   return batch;
 }
 
@@ -202,13 +163,37 @@ void LevelDbMutationQueue::RemoveMutationBatch(FSTMutationBatch* batch) {
               "Mutation batch %s not found; found %s", DescribeKey(key),
               DescribeKey(check_iterator->key()));
 
+  [db_ adjustByteSize:-db_.currentTransaction->RowSize(key)];
   db_.currentTransaction->Delete(key);
 
   for (FSTMutation* mutation : [batch mutations]) {
     key = LevelDbDocumentMutationKey::Key(user_id_, mutation.key, batch_id);
     db_.currentTransaction->Delete(key);
+
+    key = LevelDbCollectionMutationKey::Key(
+        user_id_, mutation.key.path().PopLast(), batch_id);
+    db_.currentTransaction->Delete(key);
+
     [db_.referenceDelegate removeMutationReference:mutation.key];
   }
+
+  batch_cache_.erase(batch_id);
+}
+
+void LevelDbMutationQueue::ReplaceMutationBatch(FSTMutationBatch* batch) {
+  std::string key = mutation_batch_key(batch.batchID);
+  std::string value;
+  Status status = db_.currentTransaction->Get(key, &value);
+  HARD_ASSERT(status.ok(), "Mutation batch %s did not exist",
+              DescribeKey(key));
+
+  // The mutation indexes are keyed by document or collection and batch ID,
+  // all of which stay the same, so only the batch itself needs rewriting.
+  db_.currentTransaction->Put(key, [serializer_ encodedMutationBatch:batch]);
+  [db_ adjustByteSize:db_.currentTransaction->RowSize(key) -
+                      static_cast<int64_t>(key.size() + value.size())];
+
+  batch_cache_[batch.batchID] = batch;
 }
 
 std::vector<FSTMutationBatch*> LevelDbMutationQueue::AllMutationBatches() {
@@ -277,56 +262,41 @@ LevelDbMutationQueue::AllMutationBatchesAffectingQuery(FSTQuery* query) {
       "CollectionGroup queries should be handled in LocalDocumentsView");
 
   const ResourcePath& query_path = query.path;
-  size_t immediate_children_path_length = query_path.size() + 1;
+  const ResourcePath parent = query_path.PopLast();
 
-  // TODO(mcg): Actually implement a single-collection query
-  //
-  // This is actually executing an ancestor query, traversing the whole subtree
-  // below the collection which can be horrifically inefficient for some
-  // structures. The right way to solve this is to implement the full value
-  // index, but that's not in the cards in the near future so this is the best
-  // we can do for the moment.
-  //
   // Since we don't yet index the actual properties in the mutations, our
   // current approach is to just return all mutation batches that affect
   // documents in the collection being queried.
   //
-  // Unlike allMutationBatchesAffectingDocumentKey, this iteration will scan the
-  // document-mutation index for more than a single document so the associated
-  // batchIDs will be neither necessarily unique nor in order. This means an
-  // efficient simultaneous scan isn't possible.
+  // The collection-mutation index holds a row per collection and batch, so
+  // unlike a scan of the document-mutation index this doesn't visit the
+  // mutations to individual documents or to documents in subcollections. Index
+  // rows have this form (with markers in brackets):
+  //
+  // <User>user <CollectionId>rooms <BatchId>2 <Terminator>
+  // <User>user <CollectionId>rooms <BatchId>3 <Terminator>
+  // <User>user <CollectionId>rooms <Path>a <Path>b <BatchId>3 <Terminator>
+  //
+  // Path markers sort after BatchId markers so all the rows for the queried
+  // collection are contiguous, allowing a break after any mismatch.
+  [db_ finishMigration:LevelDbMigrations::kCollectionMutationsIndex];
   std::string index_prefix =
-      LevelDbDocumentMutationKey::KeyPrefix(user_id_, query_path);
+      LevelDbCollectionMutationKey::KeyPrefix(user_id_, query_path);
   auto index_iterator = db_.currentTransaction->NewIterator();
   index_iterator->Seek(index_prefix);
 
-  LevelDbDocumentMutationKey row_key;
+  LevelDbCollectionMutationKey row_key;
 
   // Collect up unique batchIDs encountered during a scan of the index. Use a
   // set<BatchId> to accumulate batch IDs so they can be traversed in order in a
   // scan of the main table.
-  //
-  // This method is faster than performing lookups of the keys with _db->Get and
-  // keeping a hash of batchIDs that have already been looked up. The
-  // performance difference is minor for small numbers of keys but > 30% faster
-  // for larger numbers of keys.
   std::set<BatchId> unique_batch_ids;
   for (; index_iterator->Valid(); index_iterator->Next()) {
     if (!absl::StartsWith(index_iterator->key(), index_prefix) ||
-        !row_key.Decode(index_iterator->key())) {
+        !row_key.Decode(index_iterator->key()) || row_key.parent() != parent) {
       break;
     }
 
-    // Rows with document keys more than one segment longer than the query path
-    // can't be matches. For example, a query on 'rooms' can't match the
-    // document /rooms/abc/messages/xyx.
-    // TODO(mcg): we'll need a different scanner when we implement ancestor
-    // queries.
-    if (row_key.document_key().path().size() !=
-        immediate_children_path_length) {
-      continue;
-    }
-
     unique_batch_ids.insert(row_key.batch_id());
   }
 
@@ -335,19 +305,23 @@ LevelDbMutationQueue::AllMutationBatchesAffectingQuery(FSTQuery* query) {
 
 FSTMutationBatch* _Nullable LevelDbMutationQueue::LookupMutationBatch(
     model::BatchId batch_id) {
-  std::string key = mutation_batch_key(batch_id);
+  auto cached = batch_cache_.find(batch_id);
+  if (cached != batch_cache_.end()) {
+    return cached->second;
+  }
 
-  std::string value;
-  Status status = db_.currentTransaction->Get(key, &value);
-  if (!status.ok()) {
-    if (status.IsNotFound()) {
-      return nil;
-    }
-    HARD_FAIL("Lookup mutation batch (%s, %s) failed with status: %s", user_id_,
-              batch_id, status.ToString());
+  // Read the row through an iterator so that it's parsed where it is instead
+  // of being copied out first.
+  std::string key = mutation_batch_key(batch_id);
+  auto it = db_.currentTransaction->NewIterator();
+  it->Seek(key);
+  if (!it->Valid() || it->key() != key) {
+    return nil;
   }
 
-  return ParseMutationBatch(value);
+  FSTMutationBatch* batch = ParseMutationBatch(it->value());
+  batch_cache_[batch_id] = batch;
+  return batch;
 }
 
 FSTMutationBatch* _Nullable LevelDbMutationQueue::NextMutationBatchAfterBatchId(
@@ -413,14 +387,28 @@ void LevelDbMutationQueue::SetLastStreamToken(NSData* _Nullable stream_token) {
   db_.currentTransaction->Put(mutation_queue_key(), metadata_);
 }
 
+size_t LevelDbMutationQueue::EstimatedMemoryUsage() {
+  size_t size = 0;
+  for (const auto& entry : batch_cache_) {
+    size += sizeof(entry) + [entry.second approximateByteSize];
+  }
+  return size;
+}
+
 std::vector<FSTMutationBatch*> LevelDbMutationQueue::AllMutationBatchesWithIds(
     const std::set<BatchId>& batch_ids) {
   std::vector<FSTMutationBatch*> result;
 
   // Given an ordered set of unique batchIDs perform a skipping scan over the
-  // main table to find the mutation batches.
+  // main table to find the mutation batches that haven't been decoded yet.
   auto mutation_iterator = db_.currentTransaction->NewIterator();
   for (BatchId batch_id : batch_ids) {
+    auto cached = batch_cache_.find(batch_id);
+    if (cached != batch_cache_.end()) {
+      result.push_back(cached->second);
+      continue;
+    }
+
     std::string mutation_key = mutation_batch_key(batch_id);
     mutation_iterator->Seek(mutation_key);
     if (!mutation_iterator->Valid() ||
@@ -430,7 +418,9 @@ std::vector<FSTMutationBatch*> LevelDbMutationQueue::AllMutationBatchesWithIds(
                 DescribeKey(mutation_key), DescribeKey(mutation_iterator));
     }
 
-    result.push_back(ParseMutationBatch(mutation_iterator->value()));
+    FSTMutationBatch* batch = ParseMutationBatch(mutation_iterator->value());
+    batch_cache_[batch_id] = batch;
+    result.push_back(batch);
   }
   return result;
 }
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_options.h"
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_env.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+/** The number of bits per key recommended by LevelDB for bloom filters. */
+const int kBloomFilterBitsPerKey = 10;
+
+/** The capacity of the block cache LevelDB creates if none is given. */
+const size_t kDefaultBlockCacheSizeBytes = 8 * 1024 * 1024;
+
+}  // namespace
+
+LevelDbOptions::LevelDbOptions(const LevelDbSettings& settings) {
+  options_.create_if_missing = true;
+
+  if (settings.shared_block_cache) {
+    block_cache_ = settings.shared_block_cache;
+    options_.block_cache = block_cache_.get();
+  } else {
+    // Rather than leave LevelDB to create its default cache, create an
+    // equivalent one here so that it can be released under memory pressure.
+    size_t capacity = settings.block_cache_size_bytes > 0
+                          ? settings.block_cache_size_bytes
+                          : kDefaultBlockCacheSizeBytes;
+    block_cache_.reset(leveldb::NewLRUCache(capacity));
+    options_.block_cache = block_cache_.get();
+  }
+
+  if (settings.bloom_filter_enabled) {
+    filter_policy_.reset(leveldb::NewBloomFilterPolicy(kBloomFilterBitsPerKey));
+    options_.filter_policy = filter_policy_.get();
+  }
+
+  if (settings.write_buffer_size_bytes > 0) {
+    options_.write_buffer_size = settings.write_buffer_size_bytes;
+  }
+
+  if (settings.mobile_env) {
+    options_.env = MobileLevelDbEnv();
+  }
+  if (settings.max_file_size_bytes > 0) {
+    options_.max_file_size = settings.max_file_size_bytes;
+  }
+  if (settings.max_open_files > 0) {
+    options_.max_open_files = settings.max_open_files;
+  }
+
+  read_options_.verify_checksums = settings.verify_checksums;
+}
+
+size_t LevelDbOptions::ReleaseBlockCache() {
+  size_t before = block_cache_->TotalCharge();
+  block_cache_->Prune();
+  size_t after = block_cache_->TotalCharge();
+  return before > after ? before - after : 0;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_OPTIONS_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_OPTIONS_H_
+
+#include <cstddef>
+#include <memory>
+
+#include "leveldb/cache.h"
+#include "leveldb/filter_policy.h"
+#include "leveldb/options.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/** Tuning parameters for the LevelDB database backing persistence. */
+struct LevelDbSettings {
+  /**
+   * The capacity of the block cache, or 0 for the same capacity as LevelDB's
+   * default (8MB).
+   */
+  size_t block_cache_size_bytes = 0;
+
+  /**
+   * A block cache shared with other databases, used instead of a cache of
+   * `block_cache_size_bytes` if set.
+   */
+  std::shared_ptr<leveldb::Cache> shared_block_cache;
+
+  /**
+   * Whether tables carry a bloom filter, which lets point lookups of absent
+   * keys skip reading from disk at the cost of about 10 bits per key.
+   */
+  bool bloom_filter_enabled = false;
+
+  /**
+   * The amount of data to build up in memory before converting it to a sorted
+   * on-disk file, or 0 for LevelDB's default (4MB).
+   */
+  size_t write_buffer_size_bytes = 0;
+
+  /**
+   * Whether the database uses `MobileLevelDbEnv()`, which reads tables through
+   * memory maps and compacts at a low priority, instead of LevelDB's default
+   * Env.
+   */
+  bool mobile_env = false;
+
+  /**
+   * The size that LevelDB starts a new table file at, or 0 for its default
+   * (2MB). Larger tables make for fewer files to keep open and fewer misses of
+   * the table cache in large databases, at the cost of longer compactions.
+   */
+  size_t max_file_size_bytes = 0;
+
+  /**
+   * The most files LevelDB keeps open, nearly all of them tables in its table
+   * cache, or 0 for its default (1000).
+   */
+  int max_open_files = 0;
+
+  /** Whether reads verify the checksums of all the data they read. */
+  bool verify_checksums = true;
+
+  /**
+   * Whether the migrations that only backfill an index are left to run in
+   * chunks after the database opens, rather than before it's used.
+   */
+  bool defer_migrations = false;
+
+  /**
+   * Whether remote documents are written in the compact format, which keeps
+   * each collection's field names once in the field_name table instead of in
+   * every document. Documents in either format can always be read, but clients
+   * before schema version 9 can't read compact ones.
+   */
+  bool compact_remote_documents = false;
+
+  /**
+   * Remote documents whose encoding is at least this many bytes are stored
+   * compressed with deflate, or 0 to never compress them. Documents are read
+   * whether or not they're compressed, but clients before schema version 10
+   * can't read compressed ones.
+   */
+  size_t compress_remote_documents_bytes = 0;
+
+  /**
+   * Whether other processes may share the database directory, as described by
+   * `LevelDbSharedCache`. A process that finds the database open elsewhere
+   * then reads from a private copy of it instead of failing to open it.
+   */
+  bool shared_cache = false;
+};
+
+/**
+ * The leveldb::Options and leveldb::ReadOptions for the given settings, which
+ * also owns the block cache and filter policy they point to. An instance must
+ * outlive any database that was opened with its options.
+ */
+class LevelDbOptions {
+ public:
+  explicit LevelDbOptions(const LevelDbSettings& settings);
+
+  LevelDbOptions(const LevelDbOptions&) = delete;
+  LevelDbOptions& operator=(const LevelDbOptions&) = delete;
+
+  const leveldb::Options& options() const {
+    return options_;
+  }
+
+  const leveldb::ReadOptions& read_options() const {
+    return read_options_;
+  }
+
+  /**
+   * Drops the blocks in the block cache that no read is using, returning the
+   * number of bytes released. A shared block cache is released for all of the
+   * databases sharing it.
+   */
+  size_t ReleaseBlockCache();
+
+ private:
+  std::shared_ptr<leveldb::Cache> block_cache_;
+  std::unique_ptr<const leveldb::FilterPolicy> filter_policy_;
+  leveldb::Options options_;
+  leveldb::ReadOptions read_options_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_OPTIONS_H_
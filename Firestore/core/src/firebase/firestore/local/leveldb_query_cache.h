@@ -23,14 +23,18 @@
 
 #import <Foundation/Foundation.h>
 
+#include <functional>
 #include <unordered_map>
 
 #import "Firestore/Protos/objc/firestore/local/Target.pbobjc.h"
 #include "Firestore/core/src/firebase/firestore/local/query_cache.h"
+#include "Firestore/core/src/firebase/firestore/local/target_id_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 #include "leveldb/db.h"
 
 @class FSTLevelDB;
@@ -74,7 +78,8 @@ class LevelDbQueryCache : public QueryCache {
 
   int RemoveTargets(model::ListenSequenceNumber upper_bound,
                     const std::unordered_map<model::TargetId, FSTQueryData*>&
-                        live_targets) override;
+                        live_targets,
+                    int limit) override;
 
   // Key-related methods
 
@@ -95,9 +100,23 @@ class LevelDbQueryCache : public QueryCache {
 
   /**
    * Checks to see if there are any references to a document with the given key.
+   * This is a single read of the document's row in the document target sets
+   * table.
    */
   bool Contains(const model::DocumentKey& key) override;
 
+  // Query result methods
+  void SetQueryResult(FSTQueryData* query_data,
+                      const model::DocumentKeySet& keys) override;
+
+  absl::optional<model::DocumentKeySet> GetQueryResult(
+      FSTQueryData* query_data) override;
+
+  void RemoveQueryResult(FSTQueryData* query_data) override;
+
+  void InvalidateQueryResults(
+      const model::ResourcePath& collection_path) override;
+
   // Other methods and accessors
   size_t size() const override {
     return metadata_.targetCount;
@@ -118,10 +137,91 @@ class LevelDbQueryCache : public QueryCache {
   // Non-interface methods
   void Start();
 
+  /**
+   * Calls `callback` with the key and sequence number of each document that
+   * has a sentinel row but isn't in any target, in key order. The sentinel rows
+   * are merged with the document target sets table, which holds a single row
+   * for each document in some target.
+   */
   void EnumerateOrphanedDocuments(const OrphanedDocumentCallback& callback);
 
+  /**
+   * Calls `callback` with the key and sequence number of each document that
+   * isn't in any target and has a sequence number of at most `upper_bound`,
+   * least recently used first, until `callback` returns false. Only the rows of
+   * the document sequences table up to `upper_bound` are read.
+   */
+  void EnumerateOrphanedDocumentsThrough(
+      model::ListenSequenceNumber upper_bound,
+      const std::function<bool(const model::DocumentKey&,
+                               model::ListenSequenceNumber)>& callback);
+
+  /**
+   * Returns the `count`th lowest sequence number of the targets and orphaned
+   * documents together, or the highest of them if there are fewer (and
+   * kFSTListenSequenceNumberInvalid if there are none). The
+   * sequence indexes are read in order, so only the first `count` entries (and
+   * the documents in some target between them) are visited.
+   */
+  model::ListenSequenceNumber NthSequenceNumber(size_t count);
+
+  /**
+   * Writes the sentinel row of the given document with the given sequence
+   * number, keeping the document sequences table up to date.
+   */
+  void WriteSentinel(const model::DocumentKey& key,
+                     model::ListenSequenceNumber sequence_number);
+
+  /**
+   * Deletes the sentinel row of the given document, which holds the given
+   * sequence number, and its row in the document sequences table.
+   */
+  void RemoveSentinel(const model::DocumentKey& key,
+                      model::ListenSequenceNumber sequence_number);
+
+  /**
+   * Returns the running total of bytes used by the remote documents, targets
+   * and mutation batches in the database, as maintained by AdjustByteSize().
+   */
+  int64_t byte_size() const {
+    return metadata_.byteSize;
+  }
+
+  /**
+   * Adds `delta` (which may be negative) to the running total of bytes and
+   * saves it along with the rest of the metadata in the current transaction.
+   */
+  void AdjustByteSize(int64_t delta);
+
+  /**
+   * Raises the highest listen sequence number to `sequence_number`, if it's
+   * lower, saving it in the current transaction.
+   */
+  void RaiseHighestListenSequenceNumber(
+      model::ListenSequenceNumber sequence_number);
+
  private:
   void Save(FSTQueryData* query_data);
+
+  /** Deletes the rows of the given target other than its matching keys. */
+  void RemoveTargetRows(FSTQueryData* query_data);
+
+  /**
+   * Removes all the keys in the query results of the given targets, updating
+   * each affected document's target set once.
+   */
+  void RemoveAllKeysForTargets(const TargetIdSet& target_ids);
+
+  /** Returns the targets that contain the given document. */
+  TargetIdSet ReadDocumentTargets(const model::DocumentKey& key);
+
+  /**
+   * Saves the targets that contain the given document, deleting the
+   * document's row if there are none.
+   */
+  void WriteDocumentTargets(const model::DocumentKey& key,
+                            const TargetIdSet& target_ids);
+
   bool UpdateMetadata(FSTQueryData* query_data);
   void SaveMetadata();
   /**
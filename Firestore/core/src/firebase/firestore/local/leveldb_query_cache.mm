@@ -21,13 +21,19 @@
 
 #import "Firestore/Protos/objc/firestore/local/Target.pbobjc.h"
 #import "Firestore/Source/Core/FSTQuery.h"
+#import "Firestore/Source/Local/FSTLRUGarbageCollector.h"
 #import "Firestore/Source/Local/FSTLevelDB.h"
 #import "Firestore/Source/Local/FSTLocalSerializer.h"
 #import "Firestore/Source/Local/FSTQueryData.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/local/target_id_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+#include "Firestore/core/src/firebase/firestore/util/string_util.h"
 #include "absl/strings/match.h"
 
 namespace firebase {
@@ -37,9 +43,11 @@ namespace local {
 using model::DocumentKey;
 using model::DocumentKeySet;
 using model::ListenSequenceNumber;
+using model::ResourcePath;
 using model::SnapshotVersion;
 using model::TargetId;
 using util::MakeString;
+using util::OrderedCode;
 using leveldb::Status;
 
 FSTPBTargetGlobal* LevelDbQueryCache::ReadMetadata(leveldb::DB* db) {
@@ -107,18 +115,33 @@ void LevelDbQueryCache::UpdateTarget(FSTQueryData* query_data) {
 }
 
 void LevelDbQueryCache::RemoveTarget(FSTQueryData* query_data) {
-  TargetId target_id = query_data.targetID;
+  RemoveAllKeysForTarget(query_data.targetID);
+  RemoveTargetRows(query_data);
+}
 
-  RemoveAllKeysForTarget(target_id);
+void LevelDbQueryCache::RemoveTargetRows(FSTQueryData* query_data) {
+  TargetId target_id = query_data.targetID;
 
+  // The stored row has the sequence number the target is indexed under, which
+  // the given query data may have moved on from.
   std::string key = LevelDbTargetKey::Key(target_id);
+  std::string value;
+  int64_t target_size = 0;
+  if (db_.currentTransaction->Get(key, &value).ok()) {
+    target_size = static_cast<int64_t>(key.size() + value.size());
+    db_.currentTransaction->Delete(LevelDbTargetSequenceKey::Key(
+        LevelDbTargetKey::DecodeSequenceNumber(value), target_id));
+  }
   db_.currentTransaction->Delete(key);
 
   std::string index_key = LevelDbQueryTargetKey::Key(
       MakeString(query_data.query.canonicalID), target_id);
   db_.currentTransaction->Delete(index_key);
 
+  RemoveQueryResult(query_data);
+
   metadata_.targetCount--;
+  metadata_.byteSize -= target_size;
   SaveMetadata();
 }
 
@@ -184,20 +207,42 @@ void LevelDbQueryCache::EnumerateTargets(const TargetCallback& callback) {
 
 int LevelDbQueryCache::RemoveTargets(
     ListenSequenceNumber upper_bound,
-    const std::unordered_map<model::TargetId, FSTQueryData*>& live_targets) {
+    const std::unordered_map<model::TargetId, FSTQueryData*>& live_targets,
+    int limit) {
   int count = 0;
-  std::string target_prefix = LevelDbTargetKey::KeyPrefix();
+  TargetIdSet removed;
+  // The target sequences table is ordered by sequence number, so only the
+  // targets up to `upper_bound` are read.
+  std::string prefix = LevelDbTargetSequenceKey::KeyPrefix();
   auto it = db_.currentTransaction->NewIterator();
-  it->Seek(target_prefix);
-  for (; it->Valid() && absl::StartsWith(it->key(), target_prefix);
+  LevelDbTargetSequenceKey row_key;
+  std::string value;
+  for (it->Seek(prefix);
+       count < limit && it->Valid() && absl::StartsWith(it->key(), prefix);
        it->Next()) {
-    FSTQueryData* query_data = DecodeTarget(it->value());
-    if (query_data.sequenceNumber <= upper_bound &&
-        live_targets.find(query_data.targetID) == live_targets.end()) {
-      RemoveTarget(query_data);
-      count++;
+    HARD_ASSERT(row_key.Decode(it->key()),
+                "Failed to decode target sequence key");
+    if (row_key.sequence_number() > upper_bound) {
+      break;
+    }
+    if (live_targets.find(row_key.target_id()) != live_targets.end()) {
+      continue;
+    }
+
+    std::string target_key = LevelDbTargetKey::Key(row_key.target_id());
+    if (!db_.currentTransaction->Get(target_key, &value).ok()) {
+      HARD_FAIL("Dangling target sequence reference found: %s points to %s",
+                DescribeKey(it), DescribeKey(target_key));
     }
+    FSTQueryData* query_data = DecodeTarget(value);
+    RemoveTargetRows(query_data);
+    removed.insert(query_data.targetID);
+    count++;
   }
+
+  // Documents are often in several of the removed targets, so their target
+  // sets are updated once for all of them.
+  RemoveAllKeysForTargets(removed);
   return count;
 }
 
@@ -212,8 +257,10 @@ void LevelDbQueryCache::AddMatchingKeys(const DocumentKeySet& keys,
   for (const DocumentKey& key : keys) {
     db_.currentTransaction->Put(LevelDbTargetDocumentKey::Key(target_id, key),
                                 empty_buffer);
-    db_.currentTransaction->Put(LevelDbDocumentTargetKey::Key(key, target_id),
-                                empty_buffer);
+    TargetIdSet target_ids = ReadDocumentTargets(key);
+    if (target_ids.insert(target_id)) {
+      WriteDocumentTargets(key, target_ids);
+    }
     [db_.referenceDelegate addReference:key];
   };
 }
@@ -223,31 +270,45 @@ void LevelDbQueryCache::RemoveMatchingKeys(const DocumentKeySet& keys,
   for (const DocumentKey& key : keys) {
     db_.currentTransaction->Delete(
         LevelDbTargetDocumentKey::Key(target_id, key));
-    db_.currentTransaction->Delete(
-        LevelDbDocumentTargetKey::Key(key, target_id));
+    TargetIdSet target_ids = ReadDocumentTargets(key);
+    if (target_ids.erase(target_id)) {
+      WriteDocumentTargets(key, target_ids);
+    }
     [db_.referenceDelegate removeReference:key];
   }
 }
 
 void LevelDbQueryCache::RemoveAllKeysForTarget(TargetId target_id) {
-  std::string index_prefix = LevelDbTargetDocumentKey::KeyPrefix(target_id);
-  auto index_iterator = db_.currentTransaction->NewIterator();
-  index_iterator->Seek(index_prefix);
-
-  LevelDbTargetDocumentKey row_key;
-  for (; index_iterator->Valid(); index_iterator->Next()) {
-    absl::string_view index_key = index_iterator->key();
+  TargetIdSet target_ids;
+  target_ids.insert(target_id);
+  RemoveAllKeysForTargets(target_ids);
+}
 
-    // Only consider rows matching this specific targetID.
-    if (!row_key.Decode(index_key) || row_key.target_id() != target_id) {
-      break;
+void LevelDbQueryCache::RemoveAllKeysForTargets(
+    const TargetIdSet& target_ids) {
+  // The rows of each target are read for their document keys, but deleted as
+  // a range so that the transaction doesn't have to buffer every one of them.
+  DocumentKeySet document_keys;
+  LevelDbTargetDocumentKeyView row_key;
+  for (TargetId target_id : target_ids.ToVector()) {
+    std::string index_prefix = LevelDbTargetDocumentKey::KeyPrefix(target_id);
+    LevelDbTransaction::IteratorOptions options;
+    options.upper_bound = util::PrefixSuccessor(index_prefix);
+    options.fill_cache = false;
+    auto index_iterator = db_.currentTransaction->NewIterator(options);
+    for (index_iterator->Seek(index_prefix); index_iterator->Valid();
+         index_iterator->Next()) {
+      HARD_ASSERT(row_key.Decode(index_iterator->key()),
+                  "Failed to decode target document key");
+      document_keys = document_keys.insert(row_key.path().ToDocumentKey());
     }
-    const DocumentKey& document_key = row_key.document_key();
+    db_.currentTransaction->DeleteRange(index_prefix, options.upper_bound);
+  }
 
-    // Delete both index rows
-    db_.currentTransaction->Delete(index_key);
-    db_.currentTransaction->Delete(
-        LevelDbDocumentTargetKey::Key(document_key, target_id));
+  for (const DocumentKey& document_key : document_keys) {
+    WriteDocumentTargets(
+        document_key, TargetIdSet::Difference(ReadDocumentTargets(document_key),
+                                              target_ids));
   }
 }
 
@@ -256,41 +317,96 @@ DocumentKeySet LevelDbQueryCache::GetMatchingKeys(TargetId target_id) {
   auto index_iterator = db_.currentTransaction->NewIterator();
   index_iterator->Seek(index_prefix);
 
-  DocumentKeySet result;
-  LevelDbTargetDocumentKey row_key;
-  for (; index_iterator->Valid(); index_iterator->Next()) {
-    // TODO(gsoltis): could we use a StartsWith instead?
-    // Only consider rows matching this specific target_id.
-    if (!row_key.Decode(index_iterator->key()) ||
-        row_key.target_id() != target_id) {
-      break;
-    }
-
-    result = result.insert(row_key.document_key());
+  // Rows are ordered by document key within each target, so the set can be
+  // built in a single pass. The prefix check ends the scan at the next target
+  // without decoding its first row.
+  DocumentKeySet::Builder result;
+  LevelDbTargetDocumentKeyView row_key;
+  for (; index_iterator->Valid() &&
+         absl::StartsWith(index_iterator->key(), index_prefix);
+       index_iterator->Next()) {
+    HARD_ASSERT(row_key.Decode(index_iterator->key()),
+                "Failed to decode target document key");
+    result.push_back(row_key.path().ToDocumentKey());
   }
 
-  return result;
+  return result.Build();
 }
 
 bool LevelDbQueryCache::Contains(const DocumentKey& key) {
-  // ignore sentinel rows when determining if a key belongs to a target.
-  // Sentinel row just says the document exists, not that it's a member of any
-  // particular target.
-  std::string index_prefix = LevelDbDocumentTargetKey::KeyPrefix(key.path());
-  auto index_iterator = db_.currentTransaction->NewIterator();
-  index_iterator->Seek(index_prefix);
+  // Documents only have a row in the document target sets table while they're
+  // in some target. The sentinel row in the document targets table just says
+  // the document exists, not that it's a member of any particular target.
+  std::string value;
+  Status status = db_.currentTransaction->Get(
+      LevelDbDocumentTargetSetKey::Key(key), &value);
+  if (!status.ok() && !status.IsNotFound()) {
+    HARD_FAIL("Contains: failed loading the targets of %s with status: %s",
+              key.ToString(), status.ToString());
+  }
+  return status.ok();
+}
 
-  for (; index_iterator->Valid() &&
-         absl::StartsWith(index_iterator->key(), index_prefix);
-       index_iterator->Next()) {
-    LevelDbDocumentTargetKey row_key;
-    if (row_key.Decode(index_iterator->key()) && !row_key.IsSentinel() &&
-        row_key.document_key() == key) {
-      return true;
-    }
+void LevelDbQueryCache::SetQueryResult(FSTQueryData* query_data,
+                                       const DocumentKeySet& keys) {
+  // All the documents are in the queried collection, so only their IDs need
+  // to be written.
+  std::string value;
+  for (const DocumentKey& key : keys) {
+    OrderedCode::WriteString(&value, key.path().last_segment());
   }
 
-  return false;
+  db_.currentTransaction->Put(
+      LevelDbQueryResultKey::Key(query_data.query.path, query_data.targetID),
+      std::move(value));
+}
+
+absl::optional<DocumentKeySet> LevelDbQueryCache::GetQueryResult(
+    FSTQueryData* query_data) {
+  const ResourcePath& collection_path = query_data.query.path;
+  std::string value;
+  Status status = db_.currentTransaction->Get(
+      LevelDbQueryResultKey::Key(collection_path, query_data.targetID), &value);
+  if (status.IsNotFound()) {
+    return absl::nullopt;
+  } else if (!status.ok()) {
+    HARD_FAIL("GetQueryResult: failed loading target %s with status: %s",
+              query_data.targetID, status.ToString());
+  }
+
+  DocumentKeySet keys;
+  absl::string_view src = value;
+  std::string document_id;
+  while (!src.empty()) {
+    HARD_ASSERT(OrderedCode::ReadString(&src, &document_id),
+                "Failed to decode the stored result of target %s",
+                query_data.targetID);
+    keys = keys.insert(DocumentKey{collection_path.Append(document_id)});
+  }
+  return keys;
+}
+
+void LevelDbQueryCache::RemoveQueryResult(FSTQueryData* query_data) {
+  db_.currentTransaction->Delete(
+      LevelDbQueryResultKey::Key(query_data.query.path, query_data.targetID));
+}
+
+void LevelDbQueryCache::InvalidateQueryResults(
+    const ResourcePath& collection_path) {
+  std::string prefix = LevelDbQueryResultKey::KeyPrefix(collection_path);
+  auto it = db_.currentTransaction->NewIterator();
+  it->Seek(prefix);
+
+  // The rows of the collection itself sort before those of any nested
+  // collections, so the scan can stop at the first row for another path.
+  LevelDbQueryResultKey row_key;
+  for (; it->Valid() && absl::StartsWith(it->key(), prefix); it->Next()) {
+    if (!row_key.Decode(it->key()) ||
+        row_key.collection_path() != collection_path) {
+      break;
+    }
+    db_.currentTransaction->Delete(it->key());
+  }
 }
 
 const SnapshotVersion& LevelDbQueryCache::GetLastRemoteSnapshotVersion() const {
@@ -307,43 +423,235 @@ void LevelDbQueryCache::SetLastRemoteSnapshotVersion(SnapshotVersion version) {
 void LevelDbQueryCache::EnumerateOrphanedDocuments(
     const OrphanedDocumentCallback& callback) {
   std::string document_target_prefix = LevelDbDocumentTargetKey::KeyPrefix();
-  auto it = db_.currentTransaction->NewIterator();
+  std::string target_set_prefix = LevelDbDocumentTargetSetKey::KeyPrefix();
+  // Garbage collection reads the whole tables once, so it doesn't fill the
+  // cache with blocks nothing else is about to read.
+  LevelDbTransaction::IteratorOptions options;
+  options.upper_bound = util::PrefixSuccessor(document_target_prefix);
+  options.fill_cache = false;
+  auto it = db_.currentTransaction->NewIterator(options);
   it->Seek(document_target_prefix);
+
+  options.upper_bound = util::PrefixSuccessor(target_set_prefix);
+  auto target_sets = db_.currentTransaction->NewIterator(options);
+  target_sets->Seek(target_set_prefix);
+
+  // Both tables are ordered by the encoded document path, so a single pass
+  // over the target sets finds the row of each sentinel's document, if any.
+  LevelDbDocumentTargetSetKeyView target_set_key;
+  auto in_some_target = [&](const LevelDbPathView& path) -> bool {
+    for (; target_sets->Valid(); target_sets->Next()) {
+      HARD_ASSERT(target_set_key.Decode(target_sets->key()),
+                  "Failed to decode DocumentTargetSet key");
+      if (target_set_key.path().encoded() >= path.encoded()) {
+        return target_set_key.path() == path;
+      }
+    }
+    return false;
+  };
+
   ListenSequenceNumber next_to_report = 0;
-  DocumentKey key_to_report;
-  LevelDbDocumentTargetKey key;
 
-  for (; it->Valid() && absl::StartsWith(it->key(), document_target_prefix);
-       it->Next()) {
+  // Most documents belong to some target, so only the key of the sentinel row
+  // is kept while scanning and the document key is decoded when reporting.
+  std::string row_to_report;
+  LevelDbDocumentTargetKeyView key_to_report;
+  auto report = [&] {
+    HARD_ASSERT(key_to_report.Decode(row_to_report),
+                "Failed to decode DocumentTarget key");
+    callback(key_to_report.path().ToDocumentKey(), next_to_report);
+  };
+
+  LevelDbDocumentTargetKeyView key;
+
+  for (; it->Valid(); it->Next()) {
     HARD_ASSERT(key.Decode(it->key()), "Failed to decode DocumentTarget key");
     if (key.IsSentinel()) {
       // if next_to_report is non-zero, report it, this is a new key so the last
       // one must be not be a member of any targets.
       if (next_to_report != 0) {
-        callback(key_to_report, next_to_report);
+        report();
+      }
+      if (in_some_target(key.path())) {
+        next_to_report = 0;
+        continue;
       }
       // set next_to_report to be this sequence number. It's the next one we
       // might report, if we don't find any targets for this document.
       next_to_report =
           LevelDbDocumentTargetKey::DecodeSentinelValue(it->value());
-      key_to_report = key.document_key();
+      row_to_report.assign(it->key().data(), it->key().size());
     } else {
-      // set next_to_report to be 0, we know we don't need to report this one
-      // since we found a target for it.
+      // A row for a single target, as written before the target sets table.
       next_to_report = 0;
     }
   }
   // if next_to_report is non-zero, report it. We didn't find any targets for
   // that document, and we weren't asked to stop.
   if (next_to_report != 0) {
-    callback(key_to_report, next_to_report);
+    report();
   }
 }
 
 void LevelDbQueryCache::Save(FSTQueryData* query_data) {
   TargetId target_id = query_data.targetID;
+  ListenSequenceNumber sequence_number = query_data.sequenceNumber;
   std::string key = LevelDbTargetKey::Key(target_id);
+
+  // Move the target's row in the target sequences table if its sequence
+  // number changed.
+  std::string old_value;
+  int64_t old_size = 0;
+  bool indexed = false;
+  if (db_.currentTransaction->Get(key, &old_value).ok()) {
+    old_size = static_cast<int64_t>(key.size() + old_value.size());
+    ListenSequenceNumber old_sequence_number =
+        LevelDbTargetKey::DecodeSequenceNumber(old_value);
+    if (old_sequence_number == sequence_number) {
+      indexed = true;
+    } else {
+      db_.currentTransaction->Delete(
+          LevelDbTargetSequenceKey::Key(old_sequence_number, target_id));
+    }
+  }
+  if (!indexed) {
+    std::string empty_buffer;
+    db_.currentTransaction->Put(
+        LevelDbTargetSequenceKey::Key(sequence_number, target_id),
+        empty_buffer);
+  }
+
   db_.currentTransaction->Put(key, [serializer_ encodedQueryData:query_data]);
+  AdjustByteSize(db_.currentTransaction->RowSize(key) - old_size);
+}
+
+void LevelDbQueryCache::WriteSentinel(const DocumentKey& key,
+                                      ListenSequenceNumber sequence_number) {
+  std::string sentinel_key = LevelDbDocumentTargetKey::SentinelKey(key);
+  std::string old_value;
+  if (db_.currentTransaction->Get(sentinel_key, &old_value).ok()) {
+    ListenSequenceNumber old_sequence_number =
+        LevelDbDocumentTargetKey::DecodeSentinelValue(old_value);
+    if (old_sequence_number == sequence_number) {
+      // Documents are often touched several times in a transaction.
+      return;
+    }
+    db_.currentTransaction->Delete(
+        LevelDbDocumentSequenceKey::Key(old_sequence_number, key));
+  }
+
+  std::string empty_buffer;
+  db_.currentTransaction->Put(
+      LevelDbDocumentSequenceKey::Key(sequence_number, key), empty_buffer);
+  db_.currentTransaction->Put(
+      sentinel_key,
+      LevelDbDocumentTargetKey::EncodeSentinelValue(sequence_number));
+}
+
+void LevelDbQueryCache::RemoveSentinel(const DocumentKey& key,
+                                       ListenSequenceNumber sequence_number) {
+  db_.currentTransaction->Delete(
+      LevelDbDocumentSequenceKey::Key(sequence_number, key));
+  db_.currentTransaction->Delete(LevelDbDocumentTargetKey::SentinelKey(key));
+}
+
+void LevelDbQueryCache::EnumerateOrphanedDocumentsThrough(
+    ListenSequenceNumber upper_bound,
+    const std::function<bool(const DocumentKey&, ListenSequenceNumber)>&
+        callback) {
+  std::string prefix = LevelDbDocumentSequenceKey::KeyPrefix();
+  auto it = db_.currentTransaction->NewIterator();
+  LevelDbDocumentSequenceKey row_key;
+  for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix);
+       it->Next()) {
+    HARD_ASSERT(row_key.Decode(it->key()),
+                "Failed to decode document sequence key");
+    if (row_key.sequence_number() > upper_bound) {
+      break;
+    }
+    if (!Contains(row_key.document_key()) &&
+        !callback(row_key.document_key(), row_key.sequence_number())) {
+      break;
+    }
+  }
+}
+
+ListenSequenceNumber LevelDbQueryCache::NthSequenceNumber(size_t count) {
+  // Merge the two sequence indexes, skipping the documents that are in some
+  // target, until `count` entries have been seen.
+  std::string target_prefix = LevelDbTargetSequenceKey::KeyPrefix();
+  auto targets = db_.currentTransaction->NewIterator();
+  targets->Seek(target_prefix);
+  LevelDbTargetSequenceKey target_key;
+  auto next_target = [&]() -> absl::optional<ListenSequenceNumber> {
+    if (!targets->Valid() || !absl::StartsWith(targets->key(), target_prefix)) {
+      return absl::nullopt;
+    }
+    HARD_ASSERT(target_key.Decode(targets->key()),
+                "Failed to decode target sequence key");
+    return target_key.sequence_number();
+  };
+
+  std::string document_prefix = LevelDbDocumentSequenceKey::KeyPrefix();
+  auto documents = db_.currentTransaction->NewIterator();
+  documents->Seek(document_prefix);
+  LevelDbDocumentSequenceKey document_key;
+  auto next_document = [&]() -> absl::optional<ListenSequenceNumber> {
+    for (; documents->Valid() &&
+           absl::StartsWith(documents->key(), document_prefix);
+         documents->Next()) {
+      HARD_ASSERT(document_key.Decode(documents->key()),
+                  "Failed to decode document sequence key");
+      if (!Contains(document_key.document_key())) {
+        return document_key.sequence_number();
+      }
+    }
+    return absl::nullopt;
+  };
+
+  ListenSequenceNumber result = kFSTListenSequenceNumberInvalid;
+  absl::optional<ListenSequenceNumber> target = next_target();
+  absl::optional<ListenSequenceNumber> document = next_document();
+  for (size_t seen = 0; seen < count && (target || document); seen++) {
+    if (target && (!document || *target <= *document)) {
+      result = *target;
+      targets->Next();
+      target = next_target();
+    } else {
+      result = *document;
+      documents->Next();
+      document = next_document();
+    }
+  }
+  return result;
+}
+
+TargetIdSet LevelDbQueryCache::ReadDocumentTargets(const DocumentKey& key) {
+  TargetIdSet result;
+  std::string value;
+  Status status = db_.currentTransaction->Get(
+      LevelDbDocumentTargetSetKey::Key(key), &value);
+  if (status.IsNotFound()) {
+    return result;
+  } else if (!status.ok()) {
+    HARD_FAIL("ReadDocumentTargets: failed loading the targets of %s with "
+              "status: %s",
+              key.ToString(), status.ToString());
+  }
+
+  HARD_ASSERT(result.Decode(value), "Failed to decode the targets of %s",
+              key.ToString());
+  return result;
+}
+
+void LevelDbQueryCache::WriteDocumentTargets(const DocumentKey& key,
+                                             const TargetIdSet& target_ids) {
+  std::string row_key = LevelDbDocumentTargetSetKey::Key(key);
+  if (target_ids.empty()) {
+    db_.currentTransaction->Delete(row_key);
+  } else {
+    db_.currentTransaction->Put(std::move(row_key), target_ids.Encode());
+  }
 }
 
 bool LevelDbQueryCache::UpdateMetadata(FSTQueryData* query_data) {
@@ -361,6 +669,22 @@ bool LevelDbQueryCache::UpdateMetadata(FSTQueryData* query_data) {
   return updated;
 }
 
+void LevelDbQueryCache::AdjustByteSize(int64_t delta) {
+  if (delta == 0) {
+    return;
+  }
+  metadata_.byteSize += delta;
+  SaveMetadata();
+}
+
+void LevelDbQueryCache::RaiseHighestListenSequenceNumber(
+    ListenSequenceNumber sequence_number) {
+  if (sequence_number > metadata_.highestListenSequenceNumber) {
+    metadata_.highestListenSequenceNumber = sequence_number;
+    SaveMetadata();
+  }
+}
+
 void LevelDbQueryCache::SaveMetadata() {
   db_.currentTransaction->Put(LevelDbTargetGlobalKey::Key(), metadata_);
 }
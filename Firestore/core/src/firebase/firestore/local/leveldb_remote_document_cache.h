@@ -21,15 +21,26 @@
 #error "For now, this file must only be included by ObjC source files."
 #endif  // !defined(__OBJC__)
 
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/local/field_index.h"
+#include "Firestore/core/src/firebase/firestore/local/field_name_dictionary.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_options.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/util/worker_pool.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 
+@class FSTDocument;
 @class FSTLevelDB;
 @class FSTLocalSerializer;
 @class FSTMaybeDocument;
@@ -44,7 +55,14 @@ namespace local {
 /** Cached Remote Documents backed by leveldb. */
 class LevelDbRemoteDocumentCache : public RemoteDocumentCache {
  public:
-  LevelDbRemoteDocumentCache(FSTLevelDB* db, FSTLocalSerializer* serializer);
+  /**
+   * Creates a cache over the remote_documents table of `db`, which writes
+   * documents compact and/or compressed as `settings` ask. Documents stored in
+   * any of the formats are always read.
+   */
+  LevelDbRemoteDocumentCache(FSTLevelDB* db,
+                             FSTLocalSerializer* serializer,
+                             const LevelDbSettings& settings);
 
   void Add(FSTMaybeDocument* document) override;
   void Remove(const model::DocumentKey& key) override;
@@ -52,14 +70,126 @@ class LevelDbRemoteDocumentCache : public RemoteDocumentCache {
   FSTMaybeDocument* _Nullable Get(const model::DocumentKey& key) override;
   model::MaybeDocumentMap GetAll(const model::DocumentKeySet& keys) override;
   model::DocumentMap GetMatching(FSTQuery* query) override;
+  std::vector<model::DocumentMap> GetMatchingForQueries(
+      const std::vector<FSTQuery*>& queries) override;
+  model::DocumentMap GetMatchingUsingIndex(
+      FSTQuery* query, const FieldIndexRange& range) override;
+  void ForEachMatching(
+      FSTQuery* query,
+      const std::function<void(FSTDocument*)>& callback) override;
+  void ForEachMatchingUsingIndex(
+      FSTQuery* query,
+      const FieldIndexRange& range,
+      const std::function<void(FSTDocument*)>& callback) override;
+  void ForEachInKeyOrder(
+      FSTQuery* query,
+      const absl::optional<model::DocumentKey>& start_after,
+      const std::function<bool(FSTDocument*)>& callback) override;
+  void ForEachInIndexOrder(
+      FSTQuery* query,
+      const FieldIndexRange& range,
+      const absl::optional<FieldIndexPosition>& start_after,
+      const std::function<bool(absl::string_view, FSTDocument*)>& callback)
+      override;
+
+  void BackfillFieldIndex(const FieldIndex& index) override;
+
+  /** Returns 0, since the documents are read from LevelDB as needed. */
+  size_t EstimatedMemoryUsage() override {
+    return 0;
+  }
 
  private:
+  /**
+   * Reads the documents in the collection at `collection_path` using the given
+   * iterator, which may either read through the current transaction or
+   * directly from a LevelDB snapshot.
+   */
+  template <typename Iterator>
+  model::DocumentMap ScanCollection(Iterator* it,
+                                    const model::ResourcePath& collection_path);
+
+  /**
+   * Calls `callback` with each document in the collection at
+   * `collection_path` in key order, starting after `start_after` if given,
+   * until `callback` returns false. Reads them with the given iterator as
+   * ScanCollection does.
+   */
+  template <typename Iterator>
+  void ForEachInCollection(
+      Iterator* it,
+      const model::ResourcePath& collection_path,
+      const absl::optional<model::DocumentKey>& start_after,
+      const std::function<bool(FSTDocument*)>& callback);
+
+  /**
+   * Reads the rows of the given documents, whose keys must be strictly
+   * increasing, calling `found` with the index in `ordered_keys` and the
+   * decoded contents of each one that has a row.
+   */
+  void ReadAll(const std::vector<model::DocumentKey>& ordered_keys,
+               const std::function<void(size_t, FSTMaybeDocument*)>& found);
+
+  /** Encodes `document` for its row in the remote_documents table. */
+  std::string EncodeMaybeDocument(FSTMaybeDocument* document);
+
+  /**
+   * Encodes `document` in the compact format, adding any new field names to
+   * the dictionary of its collection in the current transaction.
+   */
+  std::string EncodeCompactMaybeDocument(FSTMaybeDocument* document);
+
+  /**
+   * Decodes a row of the remote_documents table, reading the field name
+   * dictionary through the current transaction if the row is compact.
+   */
   FSTMaybeDocument* DecodeMaybeDocument(absl::string_view encoded,
                                         const model::DocumentKey& key);
 
+  /**
+   * Decodes a row of the remote_documents table using the already loaded
+   * dictionary of the document's collection.
+   */
+  FSTMaybeDocument* DecodeMaybeDocument(absl::string_view encoded,
+                                        const model::DocumentKey& key,
+                                        const FieldNameDictionary& names);
+
+  /**
+   * Decodes a serialized FSTPBMaybeDocument (not in the compact format).
+   *
+   * The bytes are parsed where they are, without being copied, but through a
+   * GPB message: the rest of the local store takes FSTMaybeDocuments, so
+   * decoding into model::Document with nanopb would only add a conversion.
+   * Scans avoid the cost by decoding no row outside the collection they read.
+   */
+  FSTMaybeDocument* ParseMaybeDocument(absl::string_view encoded,
+                                       const model::DocumentKey& key);
+
+  /**
+   * Brings the field index entries for the document at `key` up to date with
+   * `new_document`, which is about to replace the currently cached entry (or
+   * nil if the entry is about to be removed).
+   */
+  void UpdateFieldIndexEntries(const model::DocumentKey& key,
+                               FSTMaybeDocument* _Nullable new_document);
+
+  /**
+   * Returns the keys of all rows in the field_index_entries and
+   * array_index_entries tables that should exist for the given document and
+   * indexes.
+   */
+  std::set<std::string> FieldIndexEntries(
+      FSTMaybeDocument* _Nullable document,
+      const std::vector<FieldIndex>& indexes);
+
   // This instance is owned by FSTLevelDB; avoid a retain cycle.
   __weak FSTLevelDB* db_;
   FSTLocalSerializer* serializer_;
+  bool compact_documents_ = false;
+  size_t compress_documents_bytes_ = 0;
+
+  // Runs the scans of GetMatchingForQueries; created by the first of them.
+  std::unique_ptr<util::WorkerPool> scan_pool_;
 };
 
 }  // namespace local
@@ -18,41 +18,179 @@
 
 #import <Foundation/Foundation.h>
 
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #import "Firestore/Protos/objc/firestore/local/MaybeDocument.pbobjc.h"
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Local/FSTLevelDB.h"
 #import "Firestore/Source/Local/FSTLocalSerializer.h"
+#import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Model/FSTFieldValue.h"
+#include "Firestore/core/src/firebase/firestore/local/field_index_encoding.h"
+#include "Firestore/core/src/firebase/firestore/local/field_name_dictionary.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_util.h"
+#include "Firestore/core/src/firebase/firestore/local/query_profile.h"
+#include "Firestore/core/src/firebase/firestore/local/value_compression.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/src/firebase/firestore/util/string_util.h"
+#include "Firestore/core/src/firebase/firestore/util/worker_pool.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/match.h"
+#include "absl/types/optional.h"
 #include "leveldb/db.h"
 
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::DocumentMap;
+using firebase::firestore::model::FieldPath;
 using firebase::firestore::model::MaybeDocumentMap;
+using firebase::firestore::model::ResourcePath;
+using firebase::firestore::util::WorkerPool;
 using leveldb::Status;
 
 namespace firebase {
 namespace firestore {
 namespace local {
 
+namespace {
+
+/**
+ * The smallest number of collections that GetMatchingForQueries scans
+ * concurrently. Below this, dispatching the scans costs more than it saves.
+ */
+const size_t kMinParallelScans = 8;
+
+absl::string_view KeyOf(LevelDbTransaction::Iterator* it) {
+  return it->key();
+}
+
+absl::string_view KeyOf(leveldb::Iterator* it) {
+  return MakeStringView(it->key());
+}
+
+absl::string_view ValueOf(LevelDbTransaction::Iterator* it) {
+  return it->value();
+}
+
+absl::string_view ValueOf(leveldb::Iterator* it) {
+  return MakeStringView(it->value());
+}
+
+/**
+ * Whether decoding the given row may need the field name dictionary of its
+ * collection. A compressed row may hide a compact document, and reading the
+ * dictionary for one that doesn't only costs a short scan.
+ */
+bool NeedsFieldNames(absl::string_view row) {
+  return IsCompactMaybeDocument(row) || IsCompressedValue(row);
+}
+
+/**
+ * Returns the given row with any compression undone, using `buffer` to hold
+ * the result if necessary.
+ */
+absl::string_view UncompressedRow(absl::string_view row,
+                                  const DocumentKey& key,
+                                  std::string* buffer) {
+  if (!IsCompressedValue(row)) {
+    return row;
+  }
+
+  absl::optional<std::string> uncompressed = UncompressValue(row);
+  if (!uncompressed) {
+    HARD_FAIL("Failed to uncompress document (%s)", key.ToString());
+  }
+  *buffer = std::move(uncompressed).value();
+  return *buffer;
+}
+
+/**
+ * Reads the field name dictionary of the collection at `collection_path` using
+ * the given iterator, which is left at an unspecified position.
+ */
+template <typename Iterator>
+FieldNameDictionary ReadFieldNames(Iterator* it,
+                                   const ResourcePath& collection_path) {
+  FieldNameDictionary names;
+
+  // The names of subcollections share the prefix but sort after the names of
+  // the collection itself.
+  std::string prefix = LevelDbFieldNameKey::KeyPrefix(collection_path);
+  LevelDbFieldNameKey current_key;
+  for (it->Seek(prefix); it->Valid() && absl::StartsWith(KeyOf(it), prefix) &&
+                         current_key.Decode(KeyOf(it)) &&
+                         current_key.collection_path() == collection_path;
+       it->Next()) {
+    names.Load(static_cast<uint32_t>(current_key.field_name_id()),
+               std::string{ValueOf(it)});
+  }
+  return names;
+}
+
+/**
+ * Appends the documents of the entries in `range` for the collection at
+ * `collection_path` to `candidate_keys`, in index value order. `EntryKey` is
+ * the key of the index's entries table.
+ */
+template <typename EntryKey>
+void ScanIndexEntries(LevelDbTransaction::Iterator* it,
+                      const ResourcePath& collection_path,
+                      const FieldIndexRange& range,
+                      std::vector<DocumentKey>* candidate_keys) {
+  const FieldPath& field_path = range.index().field_path();
+  std::string index_prefix = EntryKey::KeyPrefix(collection_path, field_path);
+  it->Seek(
+      EntryKey::KeyPrefix(collection_path, field_path, range.lower_bound()));
+
+  EntryKey current_key;
+  for (; it->Valid(); it->Next()) {
+    QueryProfile::RecordKeysScanned();
+    if (!absl::StartsWith(it->key(), index_prefix) ||
+        !current_key.Decode(it->key()) ||
+        range.IsPastEnd(current_key.index_value())) {
+      break;
+    }
+    candidate_keys->push_back(current_key.document_key());
+  }
+}
+
+}  // namespace
+
 LevelDbRemoteDocumentCache::LevelDbRemoteDocumentCache(
-    FSTLevelDB* db, FSTLocalSerializer* serializer)
-    : db_(db), serializer_(serializer) {
+    FSTLevelDB* db,
+    FSTLocalSerializer* serializer,
+    const LevelDbSettings& settings)
+    : db_(db),
+      serializer_(serializer),
+      compact_documents_(settings.compact_remote_documents),
+      compress_documents_bytes_(settings.compress_remote_documents_bytes) {
 }
 
 void LevelDbRemoteDocumentCache::Add(FSTMaybeDocument* document) {
+  UpdateFieldIndexEntries(document.key, document);
+
   std::string ldb_key = LevelDbRemoteDocumentKey::Key(document.key);
-  db_.currentTransaction->Put(ldb_key,
-                              [serializer_ encodedMaybeDocument:document]);
+  int64_t old_size = db_.currentTransaction->RowSize(ldb_key);
+  db_.currentTransaction->Put(ldb_key, EncodeMaybeDocument(document));
+  [db_ adjustByteSize:db_.currentTransaction->RowSize(ldb_key) - old_size];
 
   db_.indexManager->AddToCollectionParentIndex(document.key.path().PopLast());
 }
 
 void LevelDbRemoteDocumentCache::Remove(const DocumentKey& key) {
+  UpdateFieldIndexEntries(key, nil);
+
   std::string ldb_key = LevelDbRemoteDocumentKey::Key(key);
+  [db_ adjustByteSize:-db_.currentTransaction->RowSize(ldb_key)];
   db_.currentTransaction->Delete(ldb_key);
 }
 
@@ -60,6 +198,7 @@ FSTMaybeDocument* _Nullable LevelDbRemoteDocumentCache::Get(
     const DocumentKey& key) {
   std::string ldb_key = LevelDbRemoteDocumentKey::Key(key);
   std::string value;
+  QueryProfile::RecordKeysScanned();
   Status status = db_.currentTransaction->Get(ldb_key, &value);
   if (status.IsNotFound()) {
     return nil;
@@ -73,22 +212,59 @@ FSTMaybeDocument* _Nullable LevelDbRemoteDocumentCache::Get(
 
 MaybeDocumentMap LevelDbRemoteDocumentCache::GetAll(
     const DocumentKeySet& keys) {
-  MaybeDocumentMap results;
-
-  LevelDbRemoteDocumentKey currentKey;
-  auto it = db_.currentTransaction->NewIterator();
+  // The keys are visited in order, so the results can be built in a single
+  // pass.
+  std::vector<DocumentKey> ordered_keys{keys.begin(), keys.end()};
+  MaybeDocumentMap::Builder results;
+  size_t next = 0;
 
-  for (const DocumentKey& key : keys) {
-    it->Seek(LevelDbRemoteDocumentKey::Key(key));
-    if (!it->Valid() || !currentKey.Decode(it->key()) ||
-        currentKey.document_key() != key) {
-      results = results.insert(key, nil);
-    } else {
-      results = results.insert(key, DecodeMaybeDocument(it->value(), key));
+  ReadAll(ordered_keys, [&](size_t index, FSTMaybeDocument* maybe_doc) {
+    for (; next < index; ++next) {
+      results.push_back(ordered_keys[next], nil);
     }
+    results.push_back(ordered_keys[next++], maybe_doc);
+  });
+
+  for (; next < ordered_keys.size(); ++next) {
+    results.push_back(ordered_keys[next], nil);
   }
 
-  return results;
+  return results.Build();
+}
+
+void LevelDbRemoteDocumentCache::ReadAll(
+    const std::vector<DocumentKey>& ordered_keys,
+    const std::function<void(size_t, FSTMaybeDocument*)>& found) {
+  // The rows can be read with a single ordered multi-get.
+  std::vector<std::string> row_keys;
+  row_keys.reserve(ordered_keys.size());
+  for (const DocumentKey& key : ordered_keys) {
+    row_keys.push_back(LevelDbRemoteDocumentKey::Key(key));
+  }
+  QueryProfile::RecordKeysScanned(static_cast<int64_t>(row_keys.size()));
+
+  // Keys in the same collection are mostly adjacent, so the dictionary of the
+  // last collection seen is kept around.
+  absl::optional<FieldNameDictionary> names;
+  ResourcePath names_path;
+
+  db_.currentTransaction->GetAll(
+      row_keys, [&](size_t index, absl::string_view value) {
+        const DocumentKey& key = ordered_keys[index];
+
+        if (!NeedsFieldNames(value)) {
+          found(index, DecodeMaybeDocument(value, key));
+          return;
+        }
+
+        ResourcePath collection_path = key.path().PopLast();
+        if (!names || names_path != collection_path) {
+          auto names_it = db_.currentTransaction->NewIterator();
+          names = ReadFieldNames(names_it.get(), collection_path);
+          names_path = std::move(collection_path);
+        }
+        found(index, DecodeMaybeDocument(value, key, *names));
+      });
 }
 
 DocumentMap LevelDbRemoteDocumentCache::GetMatching(FSTQuery* query) {
@@ -96,45 +272,446 @@ DocumentMap LevelDbRemoteDocumentCache::GetMatching(FSTQuery* query) {
       ![query isCollectionGroupQuery],
       "CollectionGroup queries should be handled in LocalDocumentsView");
 
-  DocumentMap results;
+  auto it = db_.currentTransaction->NewIterator();
+  return ScanCollection(it.get(), query.path);
+}
+
+void LevelDbRemoteDocumentCache::ForEachMatching(
+    FSTQuery* query, const std::function<void(FSTDocument*)>& callback) {
+  HARD_ASSERT(
+      ![query isCollectionGroupQuery],
+      "CollectionGroup queries should be handled in LocalDocumentsView");
+
+  auto it = db_.currentTransaction->NewIterator();
+  ForEachInCollection(it.get(), query.path, absl::nullopt,
+                      [&callback](FSTDocument* doc) {
+                        callback(doc);
+                        return true;
+                      });
+}
+
+std::vector<DocumentMap> LevelDbRemoteDocumentCache::GetMatchingForQueries(
+    const std::vector<FSTQuery*>& queries) {
+  std::vector<DocumentMap> results(queries.size());
+
+  // A LevelDB snapshot doesn't include the changes buffered in the current
+  // transaction, so the scans can only bypass it while it has none. A query
+  // profile only counts the work done on its own thread, so profiled queries
+  // scan sequentially too.
+  if (queries.size() < kMinParallelScans ||
+      db_.currentTransaction->changed_keys() > 0 || QueryProfile::Current()) {
+    for (size_t i = 0; i < queries.size(); ++i) {
+      results[i] = GetMatching(queries[i]);
+    }
+    return results;
+  }
+
+  for (FSTQuery* query : queries) {
+    HARD_ASSERT(
+        ![query isCollectionGroupQuery],
+        "CollectionGroup queries should be handled in LocalDocumentsView");
+  }
+
+  // Every scan gets its own iterator over a single snapshot, so they all see
+  // the same state of the database.
+  leveldb::DB* ldb = db_.ptr;
+  leveldb::ReadOptions read_options = LevelDbTransaction::DefaultReadOptions();
+  read_options.snapshot = ldb->GetSnapshot();
+
+  if (!scan_pool_) {
+    scan_pool_ = absl::make_unique<WorkerPool>();
+  }
+  scan_pool_->ParallelFor(queries.size(), 1, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i != end; ++i) {
+      @autoreleasepool {
+        std::unique_ptr<leveldb::Iterator> it{ldb->NewIterator(read_options)};
+        results[i] = ScanCollection(it.get(), queries[i].path);
+      }
+    }
+  });
+
+  ldb->ReleaseSnapshot(read_options.snapshot);
+  return results;
+}
+
+template <typename Iterator>
+DocumentMap LevelDbRemoteDocumentCache::ScanCollection(
+    Iterator* it, const ResourcePath& collection_path) {
+  DocumentMap::Builder results;
+  ForEachInCollection(it, collection_path, absl::nullopt,
+                      [&results](FSTDocument* doc) {
+                        results.push_back(doc.key, doc);
+                        return true;
+                      });
+  return results.Build();
+}
 
+template <typename Iterator>
+void LevelDbRemoteDocumentCache::ForEachInCollection(
+    Iterator* it,
+    const ResourcePath& collection_path,
+    const absl::optional<DocumentKey>& start_after,
+    const std::function<bool(FSTDocument*)>& callback) {
   // Use the query path as a prefix for testing if a document matches the query.
-  const model::ResourcePath& query_path = query.path;
-  size_t immediate_children_path_length = query_path.size() + 1;
+  size_t immediate_children_path_length = collection_path.size() + 1;
 
   // Documents are ordered by key, so we can use a prefix scan to narrow down
   // the documents we need to match the query against.
-  std::string start_key = LevelDbRemoteDocumentKey::KeyPrefix(query_path);
-  auto it = db_.currentTransaction->NewIterator();
-  it->Seek(start_key);
+  std::string start_key = LevelDbRemoteDocumentKey::KeyPrefix(collection_path);
+  it->Seek(start_after ? LevelDbRemoteDocumentKey::Key(*start_after)
+                       : start_key);
 
-  LevelDbRemoteDocumentKey current_key;
-  for (; it->Valid() && current_key.Decode(it->key()); it->Next()) {
+  // Only loaded once the scan comes across a document in the compact format.
+  absl::optional<FieldNameDictionary> names;
+
+  // Stop as soon as the key leaves the query path: checking the key before
+  // decoding the value means rows outside the collection are never parsed, and
+  // rows in subcollections of later siblings never keep the scan going.
+  // Decode keys as views so that rows in subcollections are skipped without
+  // allocating.
+  LevelDbRemoteDocumentKeyView current_key;
+  for (; it->Valid() && absl::StartsWith(KeyOf(it), start_key) &&
+         current_key.Decode(KeyOf(it));
+       it->Next()) {
+    QueryProfile::RecordKeysScanned();
     // The query is actually returning any path that starts with the query path
     // prefix which may include documents in subcollections. For example, a
     // query on 'rooms' will return rooms/abc/messages/xyx but we shouldn't
     // match it. Fix this by discarding rows with document keys more than one
     // segment longer than the query path.
-    const DocumentKey& document_key = current_key.document_key();
-    if (document_key.path().size() != immediate_children_path_length) {
+    if (current_key.path().size() != immediate_children_path_length) {
       continue;
     }
+    DocumentKey document_key = current_key.path().ToDocumentKey();
+    if (start_after && document_key == *start_after) {
+      continue;
+    }
+
+    if (!names && NeedsFieldNames(ValueOf(it))) {
+      // Reading the names moves the iterator, so come back to this document.
+      std::string resume_key{KeyOf(it)};
+      names = ReadFieldNames(it, collection_path);
+      it->Seek(resume_key);
+    }
 
     FSTMaybeDocument* maybe_doc =
-        DecodeMaybeDocument(it->value(), document_key);
-    if (!query_path.IsPrefixOf(maybe_doc.key.path())) {
-      break;
-    } else if ([maybe_doc isKindOfClass:[FSTDocument class]]) {
-      results =
-          results.insert(maybe_doc.key, static_cast<FSTDocument*>(maybe_doc));
+        names ? DecodeMaybeDocument(ValueOf(it), document_key, *names)
+              : DecodeMaybeDocument(ValueOf(it), document_key);
+    if ([maybe_doc isKindOfClass:[FSTDocument class]] &&
+        !callback(static_cast<FSTDocument*>(maybe_doc))) {
+      return;
     }
   }
+}
 
-  return results;
+DocumentMap LevelDbRemoteDocumentCache::GetMatchingUsingIndex(
+    FSTQuery* query, const FieldIndexRange& range) {
+  DocumentMap::Builder results;
+  ForEachMatchingUsingIndex(query, range, [&results](FSTDocument* doc) {
+    results.push_back(doc.key, doc);
+  });
+  return results.Build();
+}
+
+void LevelDbRemoteDocumentCache::ForEachMatchingUsingIndex(
+    FSTQuery* query,
+    const FieldIndexRange& range,
+    const std::function<void(FSTDocument*)>& callback) {
+  HARD_ASSERT(
+      ![query isCollectionGroupQuery],
+      "CollectionGroup queries should be handled in LocalDocumentsView");
+  HARD_ASSERT(query.path.last_segment() == range.index().collection_id(),
+              "Index %s does not apply to query %s", range.index().ToString(),
+              query);
+
+  // Index entries are ordered by value within each collection and field, so a
+  // single seek and forward scan finds every candidate.
+  //
+  // Candidates come out in index value order rather than key order, so collect
+  // them and sort them all at once. Only the keys are collected: the documents
+  // are decoded one at a time as they're handed to the callback.
+  auto it = db_.currentTransaction->NewIterator();
+  std::vector<DocumentKey> candidate_keys;
+  if (range.index().kind() == FieldIndex::Kind::ArrayContains) {
+    ScanIndexEntries<LevelDbArrayIndexEntryKey>(it.get(), query.path, range,
+                                                &candidate_keys);
+  } else {
+    ScanIndexEntries<LevelDbFieldIndexEntryKey>(it.get(), query.path, range,
+                                                &candidate_keys);
+  }
+  std::sort(candidate_keys.begin(), candidate_keys.end());
+  candidate_keys.erase(
+      std::unique(candidate_keys.begin(), candidate_keys.end()),
+      candidate_keys.end());
+
+  ReadAll(candidate_keys, [&callback](size_t, FSTMaybeDocument* maybe_doc) {
+    if ([maybe_doc isKindOfClass:[FSTDocument class]]) {
+      callback(static_cast<FSTDocument*>(maybe_doc));
+    }
+  });
+}
+
+void LevelDbRemoteDocumentCache::ForEachInKeyOrder(
+    FSTQuery* query,
+    const absl::optional<DocumentKey>& start_after,
+    const std::function<bool(FSTDocument*)>& callback) {
+  HARD_ASSERT(
+      ![query isCollectionGroupQuery],
+      "CollectionGroup queries should be handled in LocalDocumentsView");
+
+  auto it = db_.currentTransaction->NewIterator();
+  ForEachInCollection(it.get(), query.path, start_after, callback);
+}
+
+void LevelDbRemoteDocumentCache::ForEachInIndexOrder(
+    FSTQuery* query,
+    const FieldIndexRange& range,
+    const absl::optional<FieldIndexPosition>& start_after,
+    const std::function<bool(absl::string_view, FSTDocument*)>& callback) {
+  HARD_ASSERT(
+      ![query isCollectionGroupQuery],
+      "CollectionGroup queries should be handled in LocalDocumentsView");
+  HARD_ASSERT(range.index().kind() == FieldIndex::Kind::Value &&
+                  query.path.last_segment() == range.index().collection_id(),
+              "Index %s does not order query %s", range.index().ToString(),
+              query);
+
+  const FieldPath& field_path = range.index().field_path();
+  std::string index_prefix =
+      LevelDbFieldIndexEntryKey::KeyPrefix(query.path, field_path);
+
+  // Entries are ordered by value and then by document key, so resuming after
+  // a position is a single seek. The entry at the position itself is skipped
+  // if it still exists.
+  std::string start_key;
+  if (start_after && start_after->index_value >= range.lower_bound()) {
+    start_key = LevelDbFieldIndexEntryKey::Key(
+        field_path, start_after->index_value, start_after->document_key);
+  } else {
+    start_key = LevelDbFieldIndexEntryKey::KeyPrefix(query.path, field_path,
+                                                     range.lower_bound());
+  }
+  auto it = db_.currentTransaction->NewIterator();
+  it->Seek(start_key);
+  if (start_after && it->Valid() && it->key() == start_key) {
+    it->Next();
+  }
+
+  LevelDbFieldIndexEntryKey current_key;
+  std::string row;
+  for (; it->Valid(); it->Next()) {
+    QueryProfile::RecordKeysScanned();
+    if (!absl::StartsWith(it->key(), index_prefix) ||
+        !current_key.Decode(it->key()) ||
+        range.IsPastEnd(current_key.index_value())) {
+      return;
+    }
+
+    // Documents are read one at a time as their entries come up, so a scan
+    // that stops early reads no more of them than it hands out.
+    const DocumentKey& document_key = current_key.document_key();
+    Status status = db_.currentTransaction->Get(
+        LevelDbRemoteDocumentKey::Key(document_key), &row);
+    if (status.IsNotFound()) {
+      continue;
+    }
+    HARD_ASSERT(status.ok(),
+                "Fetch document for key (%s) failed with status: %s",
+                document_key.ToString(), status.ToString());
+    FSTMaybeDocument* maybe_doc = DecodeMaybeDocument(row, document_key);
+    if ([maybe_doc isKindOfClass:[FSTDocument class]] &&
+        !callback(current_key.index_value(),
+                  static_cast<FSTDocument*>(maybe_doc))) {
+      return;
+    }
+  }
+}
+
+void LevelDbRemoteDocumentCache::BackfillFieldIndex(const FieldIndex& index) {
+  std::vector<FieldIndex> indexes{index};
+  const std::string& collection_id = index.collection_id();
+
+  for (const ResourcePath& parent :
+       db_.indexManager->GetCollectionParents(collection_id)) {
+    ResourcePath collection_path = parent.Append(collection_id);
+    size_t immediate_children_path_length = collection_path.size() + 1;
+
+    std::string start_key =
+        LevelDbRemoteDocumentKey::KeyPrefix(collection_path);
+    // Every document of the collection is read once, so none of them are
+    // worth keeping in the cache.
+    LevelDbTransaction::IteratorOptions options;
+    options.upper_bound = util::PrefixSuccessor(start_key);
+    options.fill_cache = false;
+    auto it = db_.currentTransaction->NewIterator(options);
+    it->Seek(start_key);
+
+    LevelDbRemoteDocumentKeyView current_key;
+    for (; it->Valid() && current_key.Decode(it->key()); it->Next()) {
+      // Skip documents in subcollections, see GetMatching.
+      if (current_key.path().size() != immediate_children_path_length) {
+        continue;
+      }
+      DocumentKey document_key = current_key.path().ToDocumentKey();
+
+      FSTMaybeDocument* maybe_doc =
+          DecodeMaybeDocument(it->value(), document_key);
+      std::string empty_buffer;
+      for (const std::string& entry : FieldIndexEntries(maybe_doc, indexes)) {
+        db_.currentTransaction->Put(entry, empty_buffer);
+      }
+    }
+  }
+}
+
+void LevelDbRemoteDocumentCache::UpdateFieldIndexEntries(
+    const DocumentKey& key, FSTMaybeDocument* _Nullable new_document) {
+  const ResourcePath& path = key.path();
+  std::vector<FieldIndex> indexes =
+      db_.indexManager->GetFieldIndexes(path[path.size() - 2]);
+  if (indexes.empty()) {
+    return;
+  }
+
+  // Find the previous entries by reading back the document being replaced.
+  // This is only done for collections that are actually indexed.
+  FSTMaybeDocument* old_document = Get(key);
+  if ([old_document isKindOfClass:[FSTDocument class]] &&
+      [new_document isKindOfClass:[FSTDocument class]] &&
+      [static_cast<FSTDocument*>(old_document)
+          hasSameDataAs:static_cast<FSTDocument*>(new_document)]) {
+    // Only the version or state changed, which index entries don't depend on.
+    return;
+  }
+
+  std::set<std::string> old_entries = FieldIndexEntries(old_document, indexes);
+  std::set<std::string> new_entries = FieldIndexEntries(new_document, indexes);
+
+  for (const std::string& entry : old_entries) {
+    if (new_entries.find(entry) == new_entries.end()) {
+      db_.currentTransaction->Delete(entry);
+    }
+  }
+  std::string empty_buffer;
+  for (const std::string& entry : new_entries) {
+    if (old_entries.find(entry) == old_entries.end()) {
+      db_.currentTransaction->Put(entry, empty_buffer);
+    }
+  }
+}
+
+std::set<std::string> LevelDbRemoteDocumentCache::FieldIndexEntries(
+    FSTMaybeDocument* _Nullable document,
+    const std::vector<FieldIndex>& indexes) {
+  std::set<std::string> entries;
+  if (![document isKindOfClass:[FSTDocument class]]) {
+    return entries;
+  }
+
+  auto* doc = static_cast<FSTDocument*>(document);
+  for (const FieldIndex& index : indexes) {
+    FSTFieldValue* value = [doc fieldForPath:index.field_path()];
+    if (!value) continue;
+
+    if (index.kind() == FieldIndex::Kind::ArrayContains) {
+      if (![value isKindOfClass:[FSTArrayValue class]]) continue;
+
+      // Elements that encode the same share an entry, since the set dedupes
+      // them.
+      for (FSTFieldValue* element in ((FSTArrayValue*)value).internalValue) {
+        absl::optional<std::string> encoded = EncodeFieldIndexValue(element);
+        if (!encoded) continue;
+
+        entries.insert(LevelDbArrayIndexEntryKey::Key(index.field_path(),
+                                                      *encoded, doc.key));
+      }
+      continue;
+    }
+
+    absl::optional<std::string> encoded = EncodeFieldIndexValue(value);
+    if (!encoded) continue;
+
+    entries.insert(LevelDbFieldIndexEntryKey::Key(index.field_path(), *encoded,
+                                                  doc.key));
+  }
+  return entries;
+}
+
+std::string LevelDbRemoteDocumentCache::EncodeMaybeDocument(
+    FSTMaybeDocument* document) {
+  std::string encoded;
+  if (compact_documents_) {
+    encoded = EncodeCompactMaybeDocument(document);
+  } else {
+    encoded = [serializer_ encodedMaybeDocumentBytes:document];
+  }
+
+  if (compress_documents_bytes_ > 0 &&
+      encoded.size() >= compress_documents_bytes_) {
+    absl::optional<std::string> compressed = CompressValue(encoded);
+    if (compressed) {
+      return std::move(compressed).value();
+    }
+  }
+  return encoded;
+}
+
+std::string LevelDbRemoteDocumentCache::EncodeCompactMaybeDocument(
+    FSTMaybeDocument* document) {
+  std::string encoded = [serializer_ encodedMaybeDocumentBytes:document];
+
+  ResourcePath collection_path = document.key.path().PopLast();
+  auto it = db_.currentTransaction->NewIterator();
+  FieldNameDictionary names = ReadFieldNames(it.get(), collection_path);
+
+  absl::optional<std::string> compact = CompactMaybeDocument(encoded, &names);
+  HARD_ASSERT(compact.has_value(), "Failed to compact document (%s)",
+              document.key.ToString());
+
+  // The names are written in the same transaction as the document, so they're
+  // never visible without each other.
+  for (auto& name : names.TakeNewNames()) {
+    db_.currentTransaction->Put(
+        LevelDbFieldNameKey::Key(collection_path,
+                                 static_cast<int32_t>(name.first)),
+        std::move(name.second));
+  }
+  return std::move(compact).value();
+}
+
+FSTMaybeDocument* LevelDbRemoteDocumentCache::DecodeMaybeDocument(
+    absl::string_view encoded, const DocumentKey& key) {
+  std::string buffer;
+  encoded = UncompressedRow(encoded, key, &buffer);
+  if (!IsCompactMaybeDocument(encoded)) {
+    return ParseMaybeDocument(encoded, key);
+  }
+
+  auto it = db_.currentTransaction->NewIterator();
+  FieldNameDictionary names = ReadFieldNames(it.get(), key.path().PopLast());
+  return DecodeMaybeDocument(encoded, key, names);
 }
 
 FSTMaybeDocument* LevelDbRemoteDocumentCache::DecodeMaybeDocument(
+    absl::string_view encoded,
+    const DocumentKey& key,
+    const FieldNameDictionary& names) {
+  std::string buffer;
+  encoded = UncompressedRow(encoded, key, &buffer);
+  if (!IsCompactMaybeDocument(encoded)) {
+    return ParseMaybeDocument(encoded, key);
+  }
+
+  absl::optional<std::string> expanded = ExpandMaybeDocument(encoded, names);
+  if (!expanded) {
+    HARD_FAIL("Failed to expand compact document (%s)", key.ToString());
+  }
+  return ParseMaybeDocument(*expanded, key);
+}
+
+FSTMaybeDocument* LevelDbRemoteDocumentCache::ParseMaybeDocument(
     absl::string_view encoded, const DocumentKey& key) {
+  QueryProfile::RecordDocumentDecoded();
   NSData* data = [[NSData alloc] initWithBytesNoCopy:(void*)encoded.data()
                                               length:encoded.size()
                                         freeWhenDone:NO];
@@ -0,0 +1,166 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_shared_cache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/filesystem.h"
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
+#include "absl/strings/match.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+using util::DirectoryIterator;
+using util::Path;
+using util::Status;
+using util::StatusOr;
+using util::StringFormat;
+
+/** The file in the database directory that holds the sequence number. */
+const char* kSequenceNumberFile = "FIRESTORE_SEQUENCE";
+
+/** Whether the database file with the given name is never modified. */
+bool IsTableFile(const std::string& name) {
+  return absl::EndsWith(name, ".ldb") || absl::EndsWith(name, ".sst");
+}
+
+/**
+ * Whether the file with the given name is left out of copies: the lock and the
+ * info logs belong to the process that has the database open.
+ */
+bool IsPrivateFile(const std::string& name) {
+  return name == "LOCK" || name == "LOG" || name == "LOG.old" ||
+         name == kSequenceNumberFile;
+}
+
+Status WriteFile(const Path& path, const std::string& contents) {
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return Status::FromErrno(
+        errno, StringFormat("Could not create %s", path.ToUtf8String()));
+  }
+  size_t written = 0;
+  while (written < contents.size()) {
+    ssize_t result =
+        write(fd, contents.data() + written, contents.size() - written);
+    if (result < 0) {
+      if (errno == EINTR) continue;
+      int error = errno;
+      close(fd);
+      return Status::FromErrno(
+          error, StringFormat("Could not write %s", path.ToUtf8String()));
+    }
+    written += static_cast<size_t>(result);
+  }
+  close(fd);
+  return Status::OK();
+}
+
+Status CopyFile(const Path& from, const Path& to) {
+  StatusOr<std::string> contents = util::ReadFile(from);
+  if (!contents.ok()) return contents.status();
+  return WriteFile(to, contents.ValueOrDie());
+}
+
+}  // namespace
+
+LevelDbSharedCache::LevelDbSharedCache(Path directory)
+    : directory_{std::move(directory)},
+      sequence_number_file_{directory_.AppendUtf8(kSequenceNumberFile)} {
+}
+
+uint64_t LevelDbSharedCache::ReadSequenceNumber() const {
+  int fd = open(sequence_number_file_.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return 0;
+
+  uint64_t sequence_number = 0;
+  ssize_t result = pread(fd, &sequence_number, sizeof(sequence_number), 0);
+  close(fd);
+  return result == sizeof(sequence_number) ? sequence_number : 0;
+}
+
+Status LevelDbSharedCache::WriteSequenceNumber(uint64_t sequence_number) const {
+  int fd =
+      open(sequence_number_file_.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return Status::FromErrno(
+        errno, StringFormat("Could not open %s",
+                            sequence_number_file_.ToUtf8String()));
+  }
+
+  // A single aligned write of the whole number, which readers never see torn.
+  ssize_t result = pwrite(fd, &sequence_number, sizeof(sequence_number), 0);
+  int error = errno;
+  close(fd);
+  if (result != sizeof(sequence_number)) {
+    return Status::FromErrno(
+        error, StringFormat("Could not write %s",
+                            sequence_number_file_.ToUtf8String()));
+  }
+  return Status::OK();
+}
+
+Status LevelDbSharedCache::CopyTo(const Path& destination) const {
+  Status status = util::RecursivelyDelete(destination);
+  if (!status.ok()) return status;
+  status = util::RecursivelyCreateDir(destination);
+  if (!status.ok()) return status;
+
+  // CURRENT names the manifest, which names the tables, so the tables the
+  // copied manifest needs are linked after it.
+  std::unique_ptr<DirectoryIterator> files =
+      DirectoryIterator::Create(directory_);
+  std::vector<Path> tables;
+  for (; files->Valid(); files->Next()) {
+    Path file = files->file();
+    std::string name = file.Basename().ToUtf8String();
+    if (IsPrivateFile(name)) continue;
+
+    if (IsTableFile(name)) {
+      tables.push_back(std::move(file));
+      continue;
+    }
+    status = CopyFile(file, destination.AppendUtf8(name));
+    if (!status.ok()) return status;
+  }
+  if (!files->status().ok()) return files->status();
+
+  for (const Path& table : tables) {
+    Path copy = destination.AppendUtf8(table.Basename().ToUtf8String());
+    if (link(table.c_str(), copy.c_str()) == 0) continue;
+
+    status = CopyFile(table, copy);
+    if (!status.ok()) return status;
+  }
+  return Status::OK();
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
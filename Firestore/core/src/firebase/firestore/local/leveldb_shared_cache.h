@@ -0,0 +1,76 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_SHARED_CACHE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_SHARED_CACHE_H_
+
+#include <cstdint>
+
+#include "Firestore/core/src/firebase/firestore/util/path.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Coordinates the processes that share a LevelDB persistence directory, like
+ * an app and its extensions in an app group container.
+ *
+ * LevelDB lets one process at a time open a database. The process that does is
+ * the writer: it holds the lease for as long as it keeps the database open,
+ * since LevelDB's lock on the directory goes away when the process exits,
+ * however it exits. Every time the writer writes to the database it bumps a
+ * sequence number kept in a small file in the directory. Other processes read
+ * from a private copy of the database taken with `CopyTo()` instead, and can
+ * compare the sequence number to the one they copied at to tell if the writer
+ * wrote since.
+ */
+class LevelDbSharedCache {
+ public:
+  /** @param directory The directory of the shared database. */
+  explicit LevelDbSharedCache(util::Path directory);
+
+  /**
+   * Returns the sequence number the writer last wrote with, or 0 if none ever
+   * did.
+   */
+  uint64_t ReadSequenceNumber() const;
+
+  /** Records that the writer wrote to the database with the given number. */
+  util::Status WriteSequenceNumber(uint64_t sequence_number) const;
+
+  /**
+   * Copies the database into `destination`, replacing whatever was there, so
+   * that it can be opened while the writer keeps the original open.
+   *
+   * Table files never change once LevelDB writes them, so they are linked
+   * rather than copied where the filesystem allows. The writer may delete one
+   * that's been compacted away while the copy is taken, leaving a copy that
+   * fails to open; trying again then finds the files that replaced it.
+   */
+  util::Status CopyTo(const util::Path& destination) const;
+
+ private:
+  util::Path directory_;
+  util::Path sequence_number_file_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_SHARED_CACHE_H_
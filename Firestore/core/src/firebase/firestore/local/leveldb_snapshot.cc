@@ -0,0 +1,49 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_snapshot.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+leveldb::ReadOptions SnapshotReadOptions(
+    const leveldb::ReadOptions& read_options,
+    const leveldb::Snapshot* snapshot) {
+  leveldb::ReadOptions result = read_options;
+  result.snapshot = snapshot;
+  return result;
+}
+
+}  // namespace
+
+LevelDbSnapshot::LevelDbSnapshot(leveldb::DB* db,
+                                 absl::string_view label,
+                                 const leveldb::ReadOptions& read_options)
+    : db_(db),
+      snapshot_(db->GetSnapshot()),
+      transaction_(db, label, SnapshotReadOptions(read_options, snapshot_)) {
+}
+
+LevelDbSnapshot::~LevelDbSnapshot() {
+  db_->ReleaseSnapshot(snapshot_);
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
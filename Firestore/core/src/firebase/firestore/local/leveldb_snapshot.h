@@ -0,0 +1,93 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_SNAPSHOT_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_SNAPSHOT_H_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
+#include "absl/strings/string_view.h"
+#include "leveldb/db.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * A read-only transaction over the state of a leveldb database at the moment
+ * it was created, pinned to a `leveldb::Snapshot`.
+ *
+ * LevelDbTransactions are only used on the queue that runs them, where they
+ * see each other's changes. A LevelDbSnapshot sees none of the writes made
+ * after it was created, so it can be read on any thread while transactions
+ * go on writing, and every read agrees with every other. A snapshot must only
+ * be used by one thread at a time, and must be destroyed, along with its
+ * iterators, before the database is closed.
+ */
+class LevelDbSnapshot {
+ public:
+  explicit LevelDbSnapshot(
+      leveldb::DB* db,
+      absl::string_view label,
+      const leveldb::ReadOptions& read_options =
+          LevelDbTransaction::DefaultReadOptions());
+
+  ~LevelDbSnapshot();
+
+  LevelDbSnapshot(const LevelDbSnapshot& other) = delete;
+
+  LevelDbSnapshot& operator=(const LevelDbSnapshot& other) = delete;
+
+  /** Like LevelDbTransaction::Get(), as of the snapshot. */
+  leveldb::Status Get(absl::string_view key, std::string* value) {
+    return transaction_.Get(key, value);
+  }
+
+  /** Like LevelDbTransaction::GetAll(), as of the snapshot. */
+  void GetAll(const std::vector<std::string>& keys,
+              const std::function<void(size_t, absl::string_view)>& found) {
+    transaction_.GetAll(keys, found);
+  }
+
+  /** Returns a new Iterator over the rows as of the snapshot. */
+  std::unique_ptr<LevelDbTransaction::Iterator> NewIterator() {
+    return transaction_.NewIterator();
+  }
+
+  std::unique_ptr<LevelDbTransaction::Iterator> NewIterator(
+      const LevelDbTransaction::IteratorOptions& options) {
+    return transaction_.NewIterator(options);
+  }
+
+ private:
+  leveldb::DB* db_;
+  const leveldb::Snapshot* snapshot_;
+
+  // Reads all go through a transaction that's never written to, so the
+  // iterators merge nothing into the rows of the snapshot.
+  LevelDbTransaction transaction_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_SNAPSHOT_H_
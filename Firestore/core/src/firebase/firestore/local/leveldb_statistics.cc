@@ -0,0 +1,117 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_statistics.h"
+
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/util/string_util.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+/**
+ * Sums LevelDB's estimates of the on-disk size of the rows starting with each
+ * of the given prefixes.
+ */
+int64_t ApproximateSize(leveldb::DB* db,
+                        const std::vector<std::string>& prefixes) {
+  std::vector<std::string> limits;
+  std::vector<leveldb::Range> ranges;
+  limits.reserve(prefixes.size());
+  ranges.reserve(prefixes.size());
+  for (const std::string& prefix : prefixes) {
+    limits.push_back(util::PrefixSuccessor(prefix));
+    ranges.emplace_back(prefix, limits.back());
+  }
+
+  std::vector<uint64_t> sizes(ranges.size());
+  db->GetApproximateSizes(ranges.data(), static_cast<int>(ranges.size()),
+                          sizes.data());
+
+  int64_t total = 0;
+  for (uint64_t size : sizes) {
+    total += static_cast<int64_t>(size);
+  }
+  return total;
+}
+
+int64_t GetIntProperty(leveldb::DB* db, const std::string& name) {
+  std::string value;
+  int64_t result = 0;
+  if (db->GetProperty(name, &value) && absl::SimpleAtoi(value, &result)) {
+    return result;
+  }
+  return 0;
+}
+
+}  // namespace
+
+LevelDbStatistics GetLevelDbStatistics(leveldb::DB* db) {
+  LevelDbStatistics result;
+
+  result.remote_documents_bytes =
+      ApproximateSize(db, {LevelDbRemoteDocumentKey::KeyPrefix()});
+  result.targets_bytes =
+      ApproximateSize(db, {LevelDbTargetKey::KeyPrefix(),
+                           LevelDbQueryTargetKey::KeyPrefix(),
+                           LevelDbTargetGlobalKey::Key()});
+  result.target_documents_bytes =
+      ApproximateSize(db, {LevelDbTargetDocumentKey::KeyPrefix(),
+                           LevelDbDocumentTargetKey::KeyPrefix(),
+                           LevelDbDocumentTargetSetKey::KeyPrefix()});
+  result.mutations_bytes =
+      ApproximateSize(db, {LevelDbMutationKey::KeyPrefix(),
+                           LevelDbDocumentMutationKey::KeyPrefix(),
+                           LevelDbCollectionMutationKey::KeyPrefix(),
+                           LevelDbMutationQueueKey::KeyPrefix()});
+  result.collection_parents_bytes =
+      ApproximateSize(db, {LevelDbCollectionParentKey::KeyPrefix()});
+
+  // LevelDB rejects the property for levels past its last one.
+  std::string files;
+  for (int level = 0;
+       db->GetProperty(absl::StrCat("leveldb.num-files-at-level", level),
+                       &files);
+       ++level) {
+    int count = 0;
+    if (!absl::SimpleAtoi(files, &count)) {
+      count = 0;
+    }
+    result.files_per_level.push_back(count);
+  }
+
+  result.approximate_memory_usage =
+      GetIntProperty(db, "leveldb.approximate-memory-usage");
+  db->GetProperty("leveldb.stats", &result.stats);
+
+  return result;
+}
+
+void CompactLevelDb(leveldb::DB* db) {
+  db->CompactRange(nullptr, nullptr);
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
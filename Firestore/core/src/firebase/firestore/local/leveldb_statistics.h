@@ -0,0 +1,92 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_STATISTICS_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_STATISTICS_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "leveldb/db.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * What LevelDB reports about the database backing persistence.
+ *
+ * The sizes of the key families are LevelDB's estimates of the space their
+ * rows take up on disk, so writes that are still in the memtable (and haven't
+ * been compacted into a table yet) aren't counted.
+ */
+struct LevelDbStatistics {
+  /** The remote_documents table. */
+  int64_t remote_documents_bytes = 0;
+
+  /** The target, query_target and target_global tables. */
+  int64_t targets_bytes = 0;
+
+  /**
+   * The target_document, document_target and document_target_set tables.
+   */
+  int64_t target_documents_bytes = 0;
+
+  /**
+   * The mutation, document_mutation, collection_mutation and mutation_queue
+   * tables.
+   */
+  int64_t mutations_bytes = 0;
+
+  /** The collection_parent table. */
+  int64_t collection_parents_bytes = 0;
+
+  /** The number of table files at each level, starting with level 0. */
+  std::vector<int> files_per_level;
+
+  /** The memory LevelDB uses for its memtables and caches, in bytes. */
+  int64_t approximate_memory_usage = 0;
+
+  /**
+   * The number of full compactions requested through `CompactLevelDb` since the
+   * database was opened. LevelDB doesn't count the compactions it schedules
+   * itself; the time and I/O they took per level are part of `stats`.
+   */
+  int compactions = 0;
+
+  /** LevelDB's own description of its levels and compactions. */
+  std::string stats;
+};
+
+/**
+ * Reads the statistics of `db`. `compactions` is left for the caller to fill
+ * in.
+ */
+LevelDbStatistics GetLevelDbStatistics(leveldb::DB* db);
+
+/**
+ * Compacts the whole of `db`, which discards the space held by deleted and
+ * overwritten rows. Blocks until the compaction finishes, which may take a
+ * while for large databases.
+ */
+void CompactLevelDb(leveldb::DB* db);
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_STATISTICS_H_
@@ -16,9 +16,14 @@
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
 
+#include <algorithm>
+#include <iterator>
+
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/metrics_registry.h"
+#include "Firestore/core/src/firebase/firestore/util/tracing.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "leveldb/write_batch.h"
@@ -34,8 +39,33 @@ namespace firebase {
 namespace firestore {
 namespace local {
 
+using util::LatencyHistogram;
+using util::MetricsRegistry;
+
+namespace {
+
+// The most rows of a deleted range written to leveldb in one batch.
+constexpr size_t kDeletedRangeBatchSize = 1000;
+
+ReadOptions IteratorReadOptions(
+    const ReadOptions& read_options,
+    const LevelDbTransaction::IteratorOptions& options) {
+  ReadOptions result = read_options;
+  result.fill_cache = options.fill_cache;
+  return result;
+}
+
+}  // namespace
+
 LevelDbTransaction::Iterator::Iterator(LevelDbTransaction* txn)
-    : db_iter_(txn->db_->NewIterator(txn->read_options_)),
+    : Iterator(txn, IteratorOptions{}) {
+}
+
+LevelDbTransaction::Iterator::Iterator(LevelDbTransaction* txn,
+                                       const IteratorOptions& options)
+    : read_options_(IteratorReadOptions(txn->read_options_, options)),
+      upper_bound_(options.upper_bound),
+      flushes_(txn->flushes_),
       last_version_(txn->version_),
       txn_(txn),
       mutations_iter_(txn->mutations_.begin()),
@@ -43,7 +73,9 @@ LevelDbTransaction::Iterator::Iterator(LevelDbTransaction* txn)
       is_mutation_(false),
       // Iterator doesn't really point to anything yet, so is
       // invalid
-      is_valid_(false) {
+      is_valid_(false),
+      forward_(true) {
+  db_iter_.reset(txn->db_->NewIterator(read_options_));
 }
 
 void LevelDbTransaction::Iterator::UpdateCurrent() {
@@ -56,12 +88,19 @@ void LevelDbTransaction::Iterator::UpdateCurrent() {
     } else if (!db_iter_->Valid()) {
       is_mutation_ = true;
     } else {
-      // Both iterators are valid. If the leveldb key is equal to or greater
-      // than the current mutation key, we are looking at a mutation next. It's
-      // either sooner in the iteration or directly shadowing the underlying
-      // committed value in leveldb.
-      is_mutation_ = db_iter_->key().compare(mutations_iter_->first) >= 0;
+      // Both iterators are valid. A mutation is next if its key comes sooner
+      // in the iteration than the leveldb key, or if it's equal and directly
+      // shadows the underlying committed value in leveldb.
+      int cmp = db_iter_->key().compare(mutations_iter_->first);
+      is_mutation_ = forward_ ? cmp >= 0 : cmp <= 0;
+    }
+
+    Slice key = is_mutation_ ? Slice{mutations_iter_->first} : db_iter_->key();
+    if (forward_ && !upper_bound_.empty() && key.compare(upper_bound_) >= 0) {
+      is_valid_ = false;
+      return;
     }
+
     if (is_mutation_) {
       current_ = *mutations_iter_;
     } else {
@@ -70,19 +109,100 @@ void LevelDbTransaction::Iterator::UpdateCurrent() {
   }
 }
 
-void LevelDbTransaction::Iterator::Seek(const std::string& key) {
-  db_iter_->Seek(key);
+void LevelDbTransaction::Iterator::CheckStatus() {
   HARD_ASSERT(db_iter_->status().ok(), "leveldb iterator reported an error: %s",
               db_iter_->status().ToString());
-  for (; db_iter_->Valid() && IsDeleted(db_iter_->key()); db_iter_->Next()) {
+}
+
+void LevelDbTransaction::Iterator::SyncToFlushes() {
+  if (flushes_ != txn_->flushes_) {
+    db_iter_.reset(txn_->db_->NewIterator(read_options_));
+    flushes_ = txn_->flushes_;
   }
-  HARD_ASSERT(db_iter_->status().ok(), "leveldb iterator reported an error: %s",
-              db_iter_->status().ToString());
+}
+
+void LevelDbTransaction::Iterator::Seek(const std::string& key) {
+  SyncToFlushes();
+  forward_ = true;
+  db_iter_->Seek(key);
+  CheckStatus();
+  SkipDeletedForward();
   mutations_iter_ = txn_->mutations_.lower_bound(key);
   UpdateCurrent();
   last_version_ = txn_->version_;
 }
 
+void LevelDbTransaction::Iterator::SeekForward(const std::string& key) {
+  // Only the entry right after the current one is worth trying: stepping
+  // further copies rows that aren't needed, and a seek costs about the same.
+  if (is_valid_ && forward_ && last_version_ == txn_->version_) {
+    if (current_.first < key) {
+      Next();
+    }
+    // Running off the end means there's nothing at or after `key` either.
+    if (!is_valid_ || current_.first >= key) {
+      return;
+    }
+  }
+  Seek(key);
+}
+
+void LevelDbTransaction::Iterator::SeekToLast() {
+  if (!upper_bound_.empty()) {
+    SeekBackward(upper_bound_, /*inclusive=*/false);
+    return;
+  }
+
+  SyncToFlushes();
+  forward_ = false;
+  db_iter_->SeekToLast();
+  CheckStatus();
+  SkipDeletedBackward();
+  Mutations& mutations = txn_->mutations_;
+  mutations_iter_ =
+      mutations.empty() ? mutations.end() : std::prev(mutations.end());
+  UpdateCurrent();
+  last_version_ = txn_->version_;
+}
+
+void LevelDbTransaction::Iterator::SeekBefore(const std::string& key) {
+  SeekBackward(key, /*inclusive=*/false);
+}
+
+void LevelDbTransaction::Iterator::SeekBackward(const std::string& key,
+                                                bool inclusive) {
+  // Nothing at or past the bound is visible.
+  if (!upper_bound_.empty() &&
+      (key > upper_bound_ || (inclusive && key == upper_bound_))) {
+    SeekBackward(upper_bound_, /*inclusive=*/false);
+    return;
+  }
+
+  SyncToFlushes();
+  forward_ = false;
+  db_iter_->Seek(key);
+  CheckStatus();
+  if (!db_iter_->Valid()) {
+    db_iter_->SeekToLast();
+    CheckStatus();
+  } else {
+    int cmp = db_iter_->key().compare(key);
+    if (cmp > 0 || (cmp == 0 && !inclusive)) {
+      db_iter_->Prev();
+      CheckStatus();
+    }
+  }
+  SkipDeletedBackward();
+
+  Mutations& mutations = txn_->mutations_;
+  auto after = inclusive ? mutations.upper_bound(key)
+                         : mutations.lower_bound(key);
+  mutations_iter_ =
+      after == mutations.begin() ? mutations.end() : std::prev(after);
+  UpdateCurrent();
+  last_version_ = txn_->version_;
+}
+
 absl::string_view LevelDbTransaction::Iterator::key() {
   HARD_ASSERT(Valid(), "key() called on invalid iterator");
   return current_.first;
@@ -97,6 +217,36 @@ bool LevelDbTransaction::Iterator::IsDeleted(leveldb::Slice slice) {
   return txn_->deletions_.find(slice.ToString()) != txn_->deletions_.end();
 }
 
+void LevelDbTransaction::Iterator::SkipDeletedForward() {
+  while (db_iter_->Valid()) {
+    auto range = txn_->FindDeletedRange(db_iter_->key());
+    if (range != txn_->deleted_ranges_.end()) {
+      db_iter_->Seek(range->second);
+    } else if (IsDeleted(db_iter_->key())) {
+      db_iter_->Next();
+    } else {
+      break;
+    }
+  }
+  CheckStatus();
+}
+
+void LevelDbTransaction::Iterator::SkipDeletedBackward() {
+  while (db_iter_->Valid()) {
+    auto range = txn_->FindDeletedRange(db_iter_->key());
+    if (range != txn_->deleted_ranges_.end()) {
+      // The range holds the current key, so seeking to its start stays valid.
+      db_iter_->Seek(range->first);
+      db_iter_->Prev();
+    } else if (IsDeleted(db_iter_->key())) {
+      db_iter_->Prev();
+    } else {
+      break;
+    }
+  }
+  CheckStatus();
+}
+
 bool LevelDbTransaction::Iterator::SyncToTransaction() {
   if (last_version_ < txn_->version_) {
     // Intentionally copying here since Seek() may update current_. We need the
@@ -111,28 +261,81 @@ bool LevelDbTransaction::Iterator::SyncToTransaction() {
 }
 
 void LevelDbTransaction::Iterator::AdvanceLDB() {
-  do {
-    db_iter_->Next();
-  } while (db_iter_->Valid() && IsDeleted(db_iter_->key()));
-  HARD_ASSERT(db_iter_->status().ok(), "leveldb iterator reported an error: %s",
-              db_iter_->status().ToString());
+  db_iter_->Next();
+  SkipDeletedForward();
+}
+
+void LevelDbTransaction::Iterator::RetreatLDB() {
+  db_iter_->Prev();
+  SkipDeletedBackward();
+}
+
+void LevelDbTransaction::Iterator::Step() {
+  // A mutation might be shadowing leveldb. If so, move both.
+  bool shadows = is_mutation_ && db_iter_->Valid() &&
+                 db_iter_->key() == mutations_iter_->first;
+  if (forward_) {
+    if (!is_mutation_ || shadows) {
+      AdvanceLDB();
+    }
+    if (is_mutation_) {
+      ++mutations_iter_;
+    }
+  } else {
+    if (!is_mutation_ || shadows) {
+      RetreatLDB();
+    }
+    if (is_mutation_) {
+      mutations_iter_ = mutations_iter_ == txn_->mutations_.begin()
+                            ? txn_->mutations_.end()
+                            : std::prev(mutations_iter_);
+    }
+  }
+  UpdateCurrent();
 }
 
 void LevelDbTransaction::Iterator::Next() {
   HARD_ASSERT(Valid(), "Next() called on invalid iterator");
+  if (!forward_) {
+    // Turning around: find the first entry after the current one.
+    const std::string current_key = current_.first;
+    Seek(current_key);
+    if (is_valid_ && current_.first == current_key) {
+      Step();
+    }
+    return;
+  }
+
   bool advanced = SyncToTransaction();
   if (!advanced && is_valid_) {
-    if (is_mutation_) {
-      // A mutation might be shadowing leveldb. If so, advance both.
-      if (db_iter_->Valid() && db_iter_->key() == mutations_iter_->first) {
-        AdvanceLDB();
-      }
-      ++mutations_iter_;
+    Step();
+  }
+}
+
+void LevelDbTransaction::Iterator::Prev() {
+  HARD_ASSERT(Valid(), "Prev() called on invalid iterator");
+  if (forward_ || last_version_ < txn_->version_) {
+    // Turning around, or resyncing with the transaction, both take a seek.
+    const std::string current_key = current_.first;
+    SeekBackward(current_key, /*inclusive=*/false);
+    return;
+  }
+  Step();
+}
+
+size_t LevelDbTransaction::Iterator::NextN(size_t count, Rows* rows) {
+  size_t appended = 0;
+  for (; appended < count && is_valid_; ++appended) {
+    if (!forward_ || last_version_ < txn_->version_) {
+      // Next() needs the current key to find its way back to this entry.
+      rows->push_back(current_);
+      Next();
     } else {
-      AdvanceLDB();
+      rows->push_back(std::move(current_));
+      Step();
     }
-    UpdateCurrent();
   }
+  return appended;
 }
 
 LevelDbTransaction::LevelDbTransaction(DB* db,
@@ -148,6 +351,12 @@ LevelDbTransaction::LevelDbTransaction(DB* db,
       label_(std::string{label}) {
 }
 
+LevelDbTransaction::~LevelDbTransaction() {
+  for (const auto& write : background_writes_) {
+    write->Wait();
+  }
+}
+
 const ReadOptions& LevelDbTransaction::DefaultReadOptions() {
   static ReadOptions options = ([]() {
     ReadOptions read_options;
@@ -163,8 +372,18 @@ const WriteOptions& LevelDbTransaction::DefaultWriteOptions() {
 }
 
 void LevelDbTransaction::Put(std::string key, std::string value) {
-  deletions_.erase(key);
-  mutations_.emplace(std::make_pair(std::move(key), std::move(value)));
+  if (deletions_.erase(key) > 0) {
+    pending_bytes_ -= key.size();
+  }
+  auto found = mutations_.find(key);
+  if (found != mutations_.end()) {
+    pending_bytes_ -= found->second.size();
+    found->second = std::move(value);
+    pending_bytes_ += found->second.size();
+  } else {
+    pending_bytes_ += key.size() + value.size();
+    mutations_.emplace(std::move(key), std::move(value));
+  }
   version_++;
 }
 
@@ -173,6 +392,11 @@ LevelDbTransaction::NewIterator() {
   return absl::make_unique<LevelDbTransaction::Iterator>(this);
 }
 
+std::unique_ptr<LevelDbTransaction::Iterator> LevelDbTransaction::NewIterator(
+    const IteratorOptions& options) {
+  return absl::make_unique<LevelDbTransaction::Iterator>(this, options);
+}
+
 Status LevelDbTransaction::Get(absl::string_view key, std::string* value) {
   std::string key_string(key);
   if (deletions_.find(key_string) != deletions_.end()) {
@@ -182,45 +406,403 @@ Status LevelDbTransaction::Get(absl::string_view key, std::string* value) {
     if (iter != mutations_.end()) {
       *value = iter->second;
       return Status::OK();
+    } else if (FindDeletedRange(key_string) != deleted_ranges_.end()) {
+      return Status::NotFound(key_string +
+                              " is in a range deleted by the transaction");
     } else {
       return db_->Get(read_options_, key_string, value);
     }
   }
 }
 
+void LevelDbTransaction::GetAll(
+    const std::vector<std::string>& keys,
+    const std::function<void(size_t, absl::string_view)>& found) {
+  Iterator it{this};
+  for (size_t i = 0; i < keys.size(); ++i) {
+    HARD_ASSERT(i == 0 || keys[i - 1] < keys[i],
+                "GetAll() keys must be in strictly increasing order");
+    it.SeekForward(keys[i]);
+    if (it.Valid() && it.key() == keys[i]) {
+      found(i, it.value());
+    }
+  }
+}
+
+int64_t LevelDbTransaction::RowSize(absl::string_view key) {
+  std::string value;
+  if (!Get(key, &value).ok()) {
+    return 0;
+  }
+  return static_cast<int64_t>(key.size() + value.size());
+}
+
 void LevelDbTransaction::Delete(absl::string_view key) {
   std::string to_delete(key);
-  deletions_.insert(to_delete);
-  mutations_.erase(to_delete);
+  auto found = mutations_.find(to_delete);
+  if (found != mutations_.end()) {
+    pending_bytes_ -= found->first.size() + found->second.size();
+    mutations_.erase(found);
+  }
+  if (deletions_.insert(std::move(to_delete)).second) {
+    pending_bytes_ += key.size();
+  }
   version_++;
 }
 
+void LevelDbTransaction::DeleteRange(absl::string_view begin,
+                                     absl::string_view end) {
+  std::string range_begin{begin};
+  std::string range_end{end};
+  HARD_ASSERT(range_begin < range_end,
+              "DeleteRange() must be given a non-empty range");
+
+  // Puts in the range are superseded. Deletes are kept so that they're still
+  // written in the same batch as the rest of the transaction.
+  auto first = mutations_.lower_bound(range_begin);
+  auto last = mutations_.lower_bound(range_end);
+  for (auto it = first; it != last; ++it) {
+    pending_bytes_ -= it->first.size() + it->second.size();
+  }
+  mutations_.erase(first, last);
+
+  // Merge with the ranges this one overlaps or touches.
+  auto it = deleted_ranges_.upper_bound(range_begin);
+  if (it != deleted_ranges_.begin() && std::prev(it)->second >= range_begin) {
+    --it;
+    range_begin = it->first;
+  }
+  while (it != deleted_ranges_.end() && it->first <= range_end) {
+    range_end = std::max(range_end, it->second);
+    pending_bytes_ -= it->first.size() + it->second.size();
+    it = deleted_ranges_.erase(it);
+  }
+  pending_bytes_ += range_begin.size() + range_end.size();
+  deleted_ranges_.emplace(std::move(range_begin), std::move(range_end));
+  range_deletes_++;
+  version_++;
+}
+
+LevelDbTransaction::DeletedRanges::const_iterator
+LevelDbTransaction::FindDeletedRange(Slice key) const {
+  if (deleted_ranges_.empty()) {
+    return deleted_ranges_.end();
+  }
+  auto after = deleted_ranges_.upper_bound(key.ToString());
+  if (after == deleted_ranges_.begin()) {
+    return deleted_ranges_.end();
+  }
+  auto range = std::prev(after);
+  return key.compare(range->second) < 0 ? range : deleted_ranges_.end();
+}
+
 void LevelDbTransaction::Commit() {
+  TRACE_SPAN("leveldb", "LevelDbTransaction::Commit");
+  static MetricsRegistry::Counter* read_only_commits =
+      MetricsRegistry::Default().GetCounter("leveldb.read_only_commits");
+  static MetricsRegistry::Counter* commits =
+      MetricsRegistry::Default().GetCounter("leveldb.commits");
+
+  if (!WritePending()) {
+    // Read-only transactions, like those of cache reads, have nothing to
+    // write; an empty batch would still append to (and maybe sync) the log.
+    read_only_commits->Increment();
+    return;
+  }
+  commits->Increment();
+}
+
+void LevelDbTransaction::Checkpoint() {
+  static MetricsRegistry::Counter* flushes =
+      MetricsRegistry::Default().GetCounter("leveldb.flushes");
+
+  if (max_pending_bytes_ == 0 || pending_bytes_ <= max_pending_bytes_) {
+    return;
+  }
+
+  TRACE_SPAN("leveldb", "LevelDbTransaction::Flush");
+  WritePending();
+  // Iterators have to find their place again, now in leveldb.
+  flushes_++;
+  version_++;
+  flushes->Increment();
+}
+
+bool LevelDbTransaction::WritePending() {
+  static MetricsRegistry::Counter* rows_written =
+      MetricsRegistry::Default().GetCounter("leveldb.rows_written");
+  static MetricsRegistry::Counter* rows_deleted =
+      MetricsRegistry::Default().GetCounter("leveldb.rows_deleted");
+  static MetricsRegistry::Histogram* commit_latency =
+      MetricsRegistry::Default().GetHistogram("leveldb.commit_latency");
+
+  // The changes have to reach leveldb in the order they were made.
+  WaitForBackgroundWrites();
+  if (deletions_.empty() && mutations_.empty() && deleted_ranges_.empty()) {
+    return false;
+  }
+
+  LOG_DEBUG("Committing transaction: %s", ToString());
+
+  auto started_at = LatencyHistogram::Clock::now();
+  if (!deletions_.empty() || !mutations_.empty()) {
+    WriteBatch batch;
+    for (const auto& deletion : deletions_) {
+      batch.Delete(deletion);
+    }
+
+    for (const auto& entry : mutations_) {
+      batch.Put(entry.first, entry.second);
+    }
+
+    Status status = db_->Write(write_options_, &batch);
+    HARD_ASSERT(status.ok(), "Failed to commit transaction:\n%s\n Failed: %s",
+                ToString(), status.ToString());
+  }
+  rows_written->Increment(static_cast<int64_t>(mutations_.size()));
+  rows_deleted->Increment(static_cast<int64_t>(deletions_.size()));
+
+  // Rows put in a range after it was deleted are already written and have to
+  // be kept.
+  WriteDeletedRanges(
+      db_, read_options_, write_options_, deleted_ranges_,
+      [this](const std::string& key) { return mutations_.count(key) > 0; },
+      label_);
+  commit_latency->RecordElapsedSince(started_at);
+
+  mutations_.clear();
+  deletions_.clear();
+  deleted_ranges_.clear();
+  pending_bytes_ = 0;
+  return true;
+}
+
+void LevelDbTransaction::WriteDeletedRanges(
+    DB* db,
+    const ReadOptions& read_options,
+    const WriteOptions& write_options,
+    const DeletedRanges& ranges,
+    const std::function<bool(const std::string&)>& is_kept,
+    const std::string& label) {
+  static MetricsRegistry::Counter* rows_deleted =
+      MetricsRegistry::Default().GetCounter("leveldb.rows_deleted");
+  if (ranges.empty()) {
+    return;
+  }
+
+  // The iterator reads from the implicit snapshot it was created with, so the
+  // batches written along the way don't disturb it.
+  ReadOptions scan_options = read_options;
+  scan_options.fill_cache = false;
+  std::unique_ptr<leveldb::Iterator> it{db->NewIterator(scan_options)};
+
   WriteBatch batch;
-  for (const auto& deletion : deletions_) {
-    batch.Delete(deletion);
+  size_t batch_rows = 0;
+  auto write_batch = [&] {
+    Status status = db->Write(write_options, &batch);
+    HARD_ASSERT(status.ok(), "Failed to delete a range of %s: %s", label,
+                status.ToString());
+    rows_deleted->Increment(static_cast<int64_t>(batch_rows));
+    batch.Clear();
+    batch_rows = 0;
+  };
+
+  for (const auto& range : ranges) {
+    for (it->Seek(range.first);
+         it->Valid() && it->key().compare(range.second) < 0; it->Next()) {
+      if (is_kept(it->key().ToString())) {
+        continue;
+      }
+      batch.Delete(it->key());
+      if (++batch_rows == kDeletedRangeBatchSize) {
+        write_batch();
+      }
+    }
+    HARD_ASSERT(it->status().ok(), "leveldb iterator reported an error: %s",
+                it->status().ToString());
+  }
+  if (batch_rows > 0) {
+    write_batch();
   }
+}
+
+std::shared_ptr<LevelDbTransaction::BackgroundWrite>
+LevelDbTransaction::StartBackgroundWrite() {
+  static MetricsRegistry::Counter* background_writes =
+      MetricsRegistry::Default().GetCounter("leveldb.background_writes");
 
+  if (deletions_.empty() && mutations_.empty() && deleted_ranges_.empty()) {
+    return nullptr;
+  }
+
+  LOG_DEBUG("Handing off transaction: %s", ToString());
+  std::shared_ptr<BackgroundWrite> write{
+      new BackgroundWrite{db_, read_options_, write_options_, label_}};
+  for (const auto& deletion : deletions_) {
+    write->batch_.Delete(deletion);
+  }
   for (const auto& entry : mutations_) {
-    batch.Put(entry.first, entry.second);
+    write->batch_.Put(entry.first, entry.second);
+  }
+  write->puts_ = mutations_.size();
+  write->deletes_ = deletions_.size();
+  write->deleted_ranges_ = deleted_ranges_;
+  write->range_deletes_ = range_deletes_;
+  for (const auto& range : deleted_ranges_) {
+    auto first = mutations_.lower_bound(range.first);
+    auto last = mutations_.lower_bound(range.second);
+    for (auto it = first; it != last; ++it) {
+      write->kept_in_ranges_.insert(it->first);
+    }
   }
 
-  LOG_DEBUG("Committing transaction: %s", ToString());
+  background_writes_.push_back(write);
+  background_writes->Increment();
+  return write;
+}
+
+void LevelDbTransaction::BackgroundWrite::Run() {
+  TRACE_SPAN("leveldb", "LevelDbTransaction::BackgroundWrite::Run");
+  static MetricsRegistry::Counter* rows_written =
+      MetricsRegistry::Default().GetCounter("leveldb.rows_written");
+  static MetricsRegistry::Counter* rows_deleted =
+      MetricsRegistry::Default().GetCounter("leveldb.rows_deleted");
+  static MetricsRegistry::Histogram* commit_latency =
+      MetricsRegistry::Default().GetHistogram("leveldb.commit_latency");
 
-  Status status = db_->Write(write_options_, &batch);
-  HARD_ASSERT(status.ok(), "Failed to commit transaction:\n%s\n Failed: %s",
-              ToString(), status.ToString());
+  auto started_at = LatencyHistogram::Clock::now();
+  if (puts_ > 0 || deletes_ > 0) {
+    Status status = db_->Write(write_options_, &batch_);
+    HARD_ASSERT(status.ok(), "Failed to write %s in the background: %s",
+                label_, status.ToString());
+  }
+  rows_written->Increment(static_cast<int64_t>(puts_));
+  rows_deleted->Increment(static_cast<int64_t>(deletes_));
+  WriteDeletedRanges(
+      db_, read_options_, write_options_, deleted_ranges_,
+      [this](const std::string& key) { return kept_in_ranges_.count(key) > 0; },
+      label_);
+  commit_latency->RecordElapsedSince(started_at);
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  done_ = true;
+  finished_.notify_all();
+}
+
+void LevelDbTransaction::BackgroundWrite::Wait() {
+  std::unique_lock<std::mutex> lock{mutex_};
+  finished_.wait(lock, [this] { return done_; });
+}
+
+bool LevelDbTransaction::BackgroundWrite::done() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return done_;
+}
+
+void LevelDbTransaction::ReapBackgroundWrites() {
+  while (!background_writes_.empty() && background_writes_.front()->done()) {
+    DropWritten(*background_writes_.front());
+    background_writes_.pop_front();
+  }
+}
+
+void LevelDbTransaction::WaitForBackgroundWrites() {
+  while (!background_writes_.empty()) {
+    background_writes_.front()->Wait();
+    DropWritten(*background_writes_.front());
+    background_writes_.pop_front();
+  }
+}
+
+void LevelDbTransaction::DropWritten(const BackgroundWrite& write) {
+  // The ranges go first, since a put in a range that's still deleted has to
+  // stay pending: the range will delete the row from leveldb again. A range
+  // deleted again since the write started might be the same range, but it
+  // covers rows the write put back, so then all of the ranges stay.
+  if (write.range_deletes_ == range_deletes_) {
+    for (const auto& range : write.deleted_ranges_) {
+      auto found = deleted_ranges_.find(range.first);
+      if (found != deleted_ranges_.end() && found->second == range.second) {
+        pending_bytes_ -= found->first.size() + found->second.size();
+        deleted_ranges_.erase(found);
+      }
+    }
+  }
+
+  // Changes that were made again with the same result since are dropped too:
+  // leveldb has that result already, unless a write still in flight changes
+  // the row in between.
+  class KeyCollector : public WriteBatch::Handler {
+   public:
+    void Put(const Slice& key, const Slice&) override {
+      keys.insert(key.ToString());
+    }
+    void Delete(const Slice& key) override {
+      keys.insert(key.ToString());
+    }
+
+    std::set<std::string> keys;
+  };
+
+  class Dropper : public WriteBatch::Handler {
+   public:
+    Dropper(LevelDbTransaction* txn, const std::set<std::string>& in_flight)
+        : txn_(txn), in_flight_(in_flight) {
+    }
+
+    void Put(const Slice& key, const Slice& value) override {
+      auto found = txn_->mutations_.find(key.ToString());
+      if (found != txn_->mutations_.end() && Slice{found->second} == value &&
+          txn_->FindDeletedRange(key) == txn_->deleted_ranges_.end() &&
+          in_flight_.count(found->first) == 0) {
+        txn_->pending_bytes_ -= found->first.size() + found->second.size();
+        txn_->mutations_.erase(found);
+      }
+    }
+
+    void Delete(const Slice& key) override {
+      std::string deleted = key.ToString();
+      if (in_flight_.count(deleted) == 0 && txn_->deletions_.erase(deleted)) {
+        txn_->pending_bytes_ -= key.size();
+      }
+    }
+
+   private:
+    LevelDbTransaction* txn_;
+    const std::set<std::string>& in_flight_;
+  };
+
+  KeyCollector in_flight;
+  for (const auto& later : background_writes_) {
+    if (later.get() != &write) {
+      Status status = later->batch_.Iterate(&in_flight);
+      HARD_ASSERT(status.ok(), "Failed to read back a batch: %s",
+                  status.ToString());
+    }
+  }
+
+  Dropper dropper{this, in_flight.keys};
+  Status status = write.batch_.Iterate(&dropper);
+  HARD_ASSERT(status.ok(), "Failed to read back a written batch: %s",
+              status.ToString());
+  // Iterators have to find the dropped changes in leveldb now.
+  flushes_++;
+  version_++;
 }
 
 std::string LevelDbTransaction::ToString() {
   std::string dest = absl::StrCat("<LevelDbTransaction ", label_, ": ");
-  size_t changes = deletions_.size() + mutations_.size();
+  size_t changes = changed_keys();
   size_t bytes = 0;  // accumulator for size of individual mutations.
   dest += std::to_string(changes) + " changes ";
   std::string items;  // accumulator for individual changes.
   for (const auto& deletion : deletions_) {
     absl::StrAppend(&items, "\n  - Delete ", DescribeKey(deletion));
   }
+  for (const auto& range : deleted_ranges_) {
+    absl::StrAppend(&items, "\n  - Delete from ", DescribeKey(range.first),
+                    " to ", DescribeKey(range.second));
+  }
   for (const auto& entry : mutations_) {
     size_t change_bytes = entry.second.size();
     bytes += change_bytes;
@@ -17,15 +17,22 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_TRANSACTION_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_TRANSACTION_H_
 
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstddef>
 #include <cstdint>
+#include <deque>
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/strings/string_view.h"
 #include "leveldb/db.h"
+#include "leveldb/write_batch.h"
 
 #if __OBJC__
 #import <Protobuf/GPBProtocolBuffers.h>
@@ -43,8 +50,34 @@ namespace local {
 class LevelDbTransaction {
   using Deletions = std::set<std::string>;
   using Mutations = std::map<std::string, std::string>;
+  // Deleted ranges, as a map from the first key of each to the key it ends
+  // before. The ranges are disjoint and never adjacent.
+  using DeletedRanges = std::map<std::string, std::string>;
 
  public:
+  /** Options that control how an Iterator reads from leveldb. */
+  struct IteratorOptions {
+    /**
+     * If not empty, the iterator only visits keys less than this one: it's
+     * invalid rather than positioned at or past the bound, and SeekToLast()
+     * finds the last key before it. Callers scanning a range don't need to
+     * check every key to find where the range ends.
+     */
+    std::string upper_bound;
+
+    /**
+     * Whether blocks read by the iterator are added to leveldb's block cache.
+     * Large scans that only run once, like garbage collection and migrations,
+     * should turn this off so they don't evict blocks that are read often.
+     */
+    bool fill_cache = true;
+  };
+
+  /**
+   * The rows NextN() copies out of an Iterator, as key-value pairs.
+   */
+  using Rows = std::vector<std::pair<std::string, std::string>>;
+
   /**
    * Iterator iterates over a merged view of pending changes from the
    * transaction and any unchanged values in the underlying leveldb instance.
@@ -53,6 +86,8 @@ class LevelDbTransaction {
    public:
     explicit Iterator(LevelDbTransaction* txn);
 
+    Iterator(LevelDbTransaction* txn, const IteratorOptions& options);
+
     /**
      * Returns true if this iterator points to an entry
      */
@@ -66,11 +101,48 @@ class LevelDbTransaction {
      */
     void Seek(const std::string& key);
 
+    /**
+     * Like Seek(), but for a key that isn't less than the key of the last
+     * Seek(). When the key is at or right after the current entry, it's
+     * reached with Next(), which is much cheaper than a full seek.
+     */
+    void SeekForward(const std::string& key);
+
+    /**
+     * Seeks this iterator to the last entry, or the last entry before the
+     * upper bound if there is one.
+     */
+    void SeekToLast();
+
+    /**
+     * Seeks this iterator to the last entry with a key less than the given
+     * key.
+     */
+    void SeekBefore(const std::string& key);
+
     /**
      * Advances the iterator to the next entry
      */
     void Next();
 
+    /**
+     * Moves the iterator back to the previous entry. Stepping back repeatedly
+     * is as cheap as calling Next(); switching between the two directions
+     * costs a seek.
+     */
+    void Prev();
+
+    /**
+     * Appends up to `count` entries to `rows`, starting with the current one,
+     * and advances the iterator past them. Returns the number of entries
+     * appended, which is less than `count` only if the iterator ran out of
+     * entries.
+     *
+     * Scans that visit every row of a range can read it in batches with this
+     * instead of calling key(), value() and Next() for each row.
+     */
+    size_t NextN(size_t count, Rows* rows);
+
     /**
      * Returns the key of the current entry
      */
@@ -82,17 +154,46 @@ class LevelDbTransaction {
     absl::string_view value();
 
    private:
+    /**
+     * Seeks to the last entry with a key less than `key`, or also equal to it
+     * if `inclusive`.
+     */
+    void SeekBackward(const std::string& key, bool inclusive);
+
     /**
      * Advances to the next non-deleted key in leveldb.
      */
     void AdvanceLDB();
 
+    /**
+     * Moves back to the previous non-deleted key in leveldb.
+     */
+    void RetreatLDB();
+
+    /**
+     * Moves from the current entry to the one after (or before, if iterating
+     * backwards) without checking for changes to the transaction.
+     */
+    void Step();
+
     /**
      * Returns true if the given slice matches a key present in the deletions_
      * set.
      */
     bool IsDeleted(leveldb::Slice slice);
 
+    /**
+     * Moves the leveldb iterator forward to the first key, starting with the
+     * current one, that isn't deleted. Deleted ranges are skipped with a seek.
+     */
+    void SkipDeletedForward();
+
+    /**
+     * Moves the leveldb iterator back to the last key, starting with the
+     * current one, that isn't deleted.
+     */
+    void SkipDeletedBackward();
+
     /**
      * Syncs with the underlying transaction. If the transaction has been
      * updated, the mutation iterator may need to be reset. Returns true if this
@@ -107,12 +208,28 @@ class LevelDbTransaction {
      */
     void UpdateCurrent();
 
+    void CheckStatus();
+
+    /**
+     * Replaces the leveldb iterator if the transaction has flushed since it
+     * was created: it reads from a snapshot that doesn't have the flushed
+     * changes.
+     */
+    void SyncToFlushes();
+
     std::unique_ptr<leveldb::Iterator> db_iter_;
+    leveldb::ReadOptions read_options_;
+    std::string upper_bound_;
+    // The number of flushes of the transaction db_iter_ has seen.
+    int32_t flushes_;
 
     // The last observed version of the underlying transaction
     int32_t last_version_;
     // The underlying transaction.
     LevelDbTransaction* txn_;
+    // The first pending mutation at or after the iterator's position or, when
+    // iterating backwards, the last one at or before it. It's
+    // mutations_.end() if there's no such mutation.
     Mutations::iterator mutations_iter_;
     // We save the current key and value so that once an iterator is Valid(), it
     // remains so at least until the next call to Seek() or Next(), even if the
@@ -124,6 +241,58 @@ class LevelDbTransaction {
     // True if the iterator pointed to a valid entry the last time Next() or
     // Seek() was called.
     bool is_valid_;
+    // False if the iterator was last positioned by moving backwards, through
+    // Prev() or one of the backwards seeks.
+    bool forward_;
+  };
+
+  /**
+   * The changes a transaction handed off with StartBackgroundWrite(), to be
+   * written to leveldb on another thread.
+   */
+  class BackgroundWrite {
+   public:
+    /**
+     * Writes the changes to leveldb. Must be called exactly once, on any
+     * thread, and after the Run() of every write the transaction started
+     * before this one.
+     */
+    void Run();
+
+   private:
+    friend class LevelDbTransaction;
+
+    BackgroundWrite(leveldb::DB* db,
+                    const leveldb::ReadOptions& read_options,
+                    const leveldb::WriteOptions& write_options,
+                    std::string label)
+        : db_(db),
+          read_options_(read_options),
+          write_options_(write_options),
+          label_(std::move(label)) {
+    }
+
+    /** Blocks until Run() has returned. */
+    void Wait();
+    bool done();
+
+    leveldb::DB* db_;
+    leveldb::ReadOptions read_options_;
+    leveldb::WriteOptions write_options_;
+    std::string label_;
+
+    leveldb::WriteBatch batch_;
+    size_t puts_ = 0;
+    size_t deletes_ = 0;
+    DeletedRanges deleted_ranges_;
+    // The keys put in the deleted ranges after they were deleted.
+    std::set<std::string> kept_in_ranges_;
+    // The transaction's range_deletes_ when the write started.
+    int32_t range_deletes_ = 0;
+
+    std::mutex mutex_;
+    std::condition_variable finished_;
+    bool done_ = false;
   };
 
   explicit LevelDbTransaction(
@@ -136,6 +305,9 @@ class LevelDbTransaction {
 
   LevelDbTransaction& operator=(const LevelDbTransaction& other) = delete;
 
+  /** Waits for the background writes that are still running. */
+  ~LevelDbTransaction();
+
   /**
    * Returns a default set of ReadOptions
    */
@@ -146,8 +318,12 @@ class LevelDbTransaction {
    */
   static const leveldb::WriteOptions& DefaultWriteOptions();
 
+  /**
+   * Returns the number of pending changes. A deleted range counts as a single
+   * change however many rows it holds.
+   */
   size_t changed_keys() const {
-    return mutations_.size() + deletions_.size();
+    return mutations_.size() + deletions_.size() + deleted_ranges_.size();
   }
 
   /**
@@ -156,6 +332,19 @@ class LevelDbTransaction {
    */
   void Delete(absl::string_view key);
 
+  /**
+   * Removes every entry with a key in [begin, end), including any pending puts
+   * in the range. Rows put in the range afterwards are kept.
+   *
+   * Unlike Delete(), this doesn't buffer the keys it removes: they're read
+   * from leveldb when the transaction commits and deleted in batches of
+   * bounded size, after the rest of the transaction's changes are written.
+   * A crash partway through can leave some rows of the range behind, so it's
+   * only for rows that nothing reads once the rest of the transaction is
+   * committed, like the index rows of a removed target.
+   */
+  void DeleteRange(absl::string_view begin, absl::string_view end);
+
 #if __OBJC__
   /**
    * Schedules the row identified by `key` to be set to the given protocol
@@ -163,9 +352,7 @@ class LevelDbTransaction {
    */
   void Put(absl::string_view key, GPBMessage* message) {
     NSData* data = [message data];
-    std::string key_string(key);
-    mutations_[key_string] = std::string((const char*)data.bytes, data.length);
-    version_++;
+    Put(std::string{key}, std::string((const char*)data.bytes, data.length));
   }
 #endif
 
@@ -183,28 +370,141 @@ class LevelDbTransaction {
    */
   leveldb::Status Get(absl::string_view key, std::string* value);
 
+  /**
+   * Looks up all the given keys, which must be in strictly increasing order,
+   * with a single iterator. Calls `found` with the index in `keys` and the
+   * latest known value of every key that exists, in order; the value is only
+   * valid for the duration of the call.
+   *
+   * Keys that are adjacent in the database are visited without seeking, so
+   * this is much faster than calling Get() for each key.
+   */
+  void GetAll(
+      const std::vector<std::string>& keys,
+      const std::function<void(size_t, absl::string_view)>& found);
+
+  /**
+   * Returns the number of bytes the row identified by `key` occupies (the size
+   * of its key plus the size of its latest known value), or 0 if the row
+   * doesn't exist or is scheduled for deletion in this transaction.
+   */
+  int64_t RowSize(absl::string_view key);
+
   /**
    * Returns a new Iterator over the pending changes in this transaction, merged
    * with the existing values already in leveldb.
    */
   std::unique_ptr<Iterator> NewIterator();
 
+  /**
+   * Returns a new Iterator like NewIterator(), that reads leveldb as described
+   * by the given options.
+   */
+  std::unique_ptr<Iterator> NewIterator(const IteratorOptions& options);
+
+  /**
+   * Lets the transaction write its pending changes to leveldb before it
+   * commits, at calls to Checkpoint() once they take more than
+   * `max_pending_bytes`, so that large write sets don't have to be held in
+   * memory. Passing 0 turns this off, which is the default.
+   *
+   * Flushed changes are durable even if the transaction never commits, and
+   * each flush is only atomic by itself. Callers that allow flushes have to
+   * order their writes so that the changes made up to any checkpoint leave a
+   * consistent database.
+   */
+  void AllowFlushes(size_t max_pending_bytes) {
+    max_pending_bytes_ = max_pending_bytes;
+  }
+
+  /**
+   * Marks a point at which the changes made so far leave the database
+   * consistent, and writes them if flushes are allowed and they've grown past
+   * the limit. Changes are never flushed anywhere else, so rows that describe
+   * others, like counters and index entries, are written in the same batch as
+   * the rows they describe, as long as both are written between checkpoints.
+   */
+  void Checkpoint();
+
   /**
    * Commits the transaction. All pending changes are written. The transaction
    * should not be used after calling this method.
    */
   void Commit();
 
+  /**
+   * Hands the pending changes off to be written to leveldb by the returned
+   * write's Run(), which can be called on another thread, or returns nullptr
+   * if there are none. The transaction can go on being used meanwhile.
+   *
+   * The changes stay pending, and reads keep seeing them, until
+   * ReapBackgroundWrites() drops them after the write finishes. Changes made
+   * after the hand-off are written by a later one, or by Commit(), which first
+   * waits for every background write to finish.
+   */
+  std::shared_ptr<BackgroundWrite> StartBackgroundWrite();
+
+  /**
+   * Drops the changes that finished background writes have written from the
+   * pending ones, unless they changed again since. Doesn't wait for writes
+   * that are still running.
+   */
+  void ReapBackgroundWrites();
+
+  /**
+   * Waits for all the background writes started so far to finish, and reaps
+   * them, so that leveldb has their changes.
+   */
+  void WaitForBackgroundWrites();
+
   std::string ToString();
 
  private:
+  /**
+   * Returns the deleted range that holds `key`, or deleted_ranges_.end() if
+   * there's none.
+   */
+  DeletedRanges::const_iterator FindDeletedRange(leveldb::Slice key) const;
+
+  /**
+   * Deletes the committed rows of `ranges` batch by batch, except the ones
+   * `is_kept` accepts.
+   */
+  static void WriteDeletedRanges(
+      leveldb::DB* db,
+      const leveldb::ReadOptions& read_options,
+      const leveldb::WriteOptions& write_options,
+      const DeletedRanges& ranges,
+      const std::function<bool(const std::string&)>& is_kept,
+      const std::string& label);
+
+  /** Drops the changes of a finished background write. */
+  void DropWritten(const BackgroundWrite& write);
+
+  /**
+   * Writes all the pending changes to leveldb, returning false if there were
+   * none.
+   */
+  bool WritePending();
+
   leveldb::DB* db_;
   Mutations mutations_;
   Deletions deletions_;
+  DeletedRanges deleted_ranges_;
   leveldb::ReadOptions read_options_;
   leveldb::WriteOptions write_options_;
   int32_t version_;
+  // The approximate size of the pending changes: that of the keys and values
+  // of mutations_ and the keys of everything deleted.
+  size_t pending_bytes_ = 0;
+  size_t max_pending_bytes_ = 0;
+  int32_t flushes_ = 0;
+  // The number of DeleteRange() calls, which background writes compare to
+  // tell whether their ranges were deleted again since.
+  int32_t range_deletes_ = 0;
   std::string label_;
+  // The background writes that haven't been reaped, in the order they started.
+  std::deque<std::shared_ptr<BackgroundWrite>> background_writes_;
 };
 
 /**
@@ -19,17 +19,23 @@
 
 #import <Foundation/Foundation.h>
 
+#include <functional>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/local/field_index.h"
 #include "Firestore/core/src/firebase/firestore/local/index_manager.h"
 #include "Firestore/core/src/firebase/firestore/local/mutation_queue.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "absl/types/optional.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
+@class FSTDocument;
 @class FSTMaybeDocument;
 @class FSTMutationBatch;
 @class FSTQuery;
@@ -38,6 +44,35 @@ namespace firebase {
 namespace firestore {
 namespace local {
 
+/**
+ * Where a paged read of local query results continues: just after the last
+ * document of the previous page.
+ */
+struct LocalQueryCursor {
+  /** The key of the last document read. */
+  model::DocumentKey last_key;
+
+  /**
+   * The encoded index value of the ordering field of the last document read,
+   * if the pages are read in index order.
+   */
+  absl::optional<std::string> last_index_value;
+
+  /** The number of documents read so far, which counts against the limit. */
+  size_t documents_read = 0;
+};
+
+/** A page of local query results, see ReadDocumentsMatchingQuery. */
+struct LocalQueryPage {
+  std::vector<FSTDocument*> documents;
+
+  /**
+   * Where the next page starts, or absl::nullopt if there are no more
+   * results.
+   */
+  absl::optional<LocalQueryCursor> next;
+};
+
 /**
  * A readonly view of the local state of all documents we're tracking (i.e. we
  * have a cached version in remoteDocumentCache or local mutations for the
@@ -80,12 +115,82 @@ class LocalDocumentsView {
   /** Performs a query against the local view of all documents. */
   model::DocumentMap GetDocumentsMatchingQuery(FSTQuery* query);
 
+  /**
+   * Performs a collection query whose results against the remote documents are
+   * known to be the documents identified by `remote_keys`, looking those up
+   * instead of scanning the collection.
+   *
+   * Returns absl::nullopt if the query has a limit and local mutations affect
+   * it, since the mutations may push documents out of the results that would
+   * have to be replaced by documents past the limit.
+   */
+  absl::optional<model::DocumentMap> GetDocumentsMatchingQuery(
+      FSTQuery* query, const model::DocumentKeySet& remote_keys);
+
+  /**
+   * Calls `callback` with each document matching the query in the local view,
+   * like GetDocumentsMatchingQuery but without collecting the results: remote
+   * documents are handed over as they're read, and only the documents with
+   * local mutations are looked up individually.
+   *
+   * Documents are visited in no particular order and the query's limit is
+   * ignored.
+   */
+  void ForEachDocumentMatchingQuery(
+      FSTQuery* query, const std::function<void(FSTDocument*)>& callback);
+
+  /**
+   * Reads up to `page_size` documents matching the query in the local view,
+   * starting after `cursor` or at the beginning of the results, without
+   * reading any of the results past the page.
+   *
+   * Pages are read in the order of the query's first orderBy if it's
+   * ascending and a value index is declared on its field, and in key order
+   * otherwise. Documents whose ordering field holds a pending server timestamp
+   * come last. The results of a collection group query are read one
+   * collection at a time, and the query's limit applies across all pages.
+   *
+   * Each page reads the current state of the cache, so documents changed
+   * between pages may be missed, or read twice if their position moved past
+   * the cursor.
+   */
+  LocalQueryPage ReadDocumentsMatchingQuery(
+      FSTQuery* query,
+      size_t page_size,
+      const absl::optional<LocalQueryCursor>& cursor);
+
+  /**
+   * Discards the cached local views of the documents identified by `keys`.
+   *
+   * Must be called whenever a mutation batch affecting the documents is added,
+   * replaced or removed and whenever their remote versions change.
+   */
+  void InvalidateOverlays(const model::DocumentKeySet& keys);
+
+  /** Discards all cached local views, which are recomputed when next read. */
+  void ReleaseOverlays() {
+    overlays_.clear();
+  }
+
+  /**
+   * Returns an estimate of the number of bytes of memory used by the cached
+   * local views of documents.
+   */
+  size_t EstimatedOverlayByteSize() const;
+
  private:
   /** Internal version of GetDocument that allows re-using batches. */
   FSTMaybeDocument* _Nullable GetDocument(
       const model::DocumentKey& key,
       const std::vector<FSTMutationBatch*>& batches);
 
+  /**
+   * Remembers the local views in `docs` of all documents affected by at least
+   * one of the given `batches`, which must be all the batches affecting them.
+   */
+  void SaveOverlays(const model::MaybeDocumentMap& docs,
+                    const std::vector<FSTMutationBatch*>& batches);
+
   /**
    * Returns the view of the given `docs` as they would appear after applying
    * all mutations in the given `batches`.
@@ -100,12 +205,67 @@ class LocalDocumentsView {
 
   model::DocumentMap GetDocumentsMatchingCollectionGroupQuery(FSTQuery* query);
 
+  void ForEachDocumentMatchingCollectionQuery(
+      FSTQuery* query, const std::function<void(FSTDocument*)>& callback);
+
+  /**
+   * Appends the documents of the collection query that follow `start_after`
+   * (if given) to `page`, in key order or in the order of `order_index`,
+   * until the page holds `page_size` documents. Sets `last_index_value` to
+   * the index value of the last document appended.
+   */
+  void ReadCollectionQueryPage(FSTQuery* query,
+                               const absl::optional<FieldIndex>& order_index,
+                               const LocalQueryCursor* _Nullable start_after,
+                               size_t page_size,
+                               std::vector<FSTDocument*>* page,
+                               std::string* last_index_value);
+
+  /**
+   * Returns the declared value index on the field of the query's first
+   * orderBy if the orderBy is ascending, which lets query results be read in
+   * their order.
+   */
+  absl::optional<FieldIndex> FindOrderingIndex(FSTQuery* query);
+
   /** Queries the remote documents and overlays mutations. */
   model::DocumentMap GetDocumentsMatchingCollectionQuery(FSTQuery* query);
 
+  /**
+   * Overlays the given `batches`, which must be all the batches affecting the
+   * collection query, onto the `results` of the query against the remote
+   * documents, and filters out the documents that don't match.
+   */
+  model::DocumentMap ApplyLocalMutationsToQueryResults(
+      FSTQuery* query,
+      model::DocumentMap results,
+      const std::vector<FSTMutationBatch*>& batches);
+
+  /**
+   * Chooses a range of a declared field index that contains every document
+   * matching the given collection query, or returns absl::nullopt if the query
+   * has to be executed by scanning the whole collection.
+   *
+   * Equality and array-contains filters (the latter served by an
+   * array-contains index) are preferred over inequalities since they're
+   * usually more selective. An orderBy on an indexed field can be served by
+   * the whole index, since documents without the field never match the query.
+   */
+  absl::optional<FieldIndexRange> PlanFieldIndexScan(FSTQuery* query);
+
   RemoteDocumentCache* remote_document_cache_;
   MutationQueue* mutation_queue_;
   IndexManager* index_manager_;
+
+  /**
+   * The local views of documents with pending mutations, as last computed by
+   * applying the mutations to the remote documents. A nil overlay is valid and
+   * means that the document doesn't exist locally.
+   */
+  std::unordered_map<model::DocumentKey,
+                     FSTMaybeDocument* _Nullable,
+                     model::DocumentKeyHash>
+      overlays_;
 };
 
 }  // namespace local
@@ -16,20 +16,29 @@
 
 #import "Firestore/core/src/firebase/firestore/local/local_documents_view.h"
 
+#include <algorithm>
+#include <functional>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Model/FSTFieldValue.h"
 #import "Firestore/Source/Model/FSTMutation.h"
 #import "Firestore/Source/Model/FSTMutationBatch.h"
 
+#include "Firestore/core/src/firebase/firestore/local/field_index_encoding.h"
 #include "Firestore/core/src/firebase/firestore/local/mutation_queue.h"
+#include "Firestore/core/src/firebase/firestore/local/query_profile.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "absl/strings/string_view.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -40,16 +49,64 @@ namespace local {
 using model::DocumentKey;
 using model::DocumentKeySet;
 using model::DocumentMap;
+using model::FieldPath;
 using model::MaybeDocumentMap;
 using model::ResourcePath;
 using model::SnapshotVersion;
 using util::MakeString;
 
+namespace {
+
+/**
+ * Returns the given document, or a FSTDeletedDocument if there's no state for
+ * `key`.
+ */
+FSTMaybeDocument* DocumentOrDeleted(FSTMaybeDocument* _Nullable maybe_doc,
+                                    const DocumentKey& key) {
+  // TODO(http://b/32275378): Don't conflate missing / deleted.
+  if (!maybe_doc) {
+    return [FSTDeletedDocument documentWithKey:key
+                                       version:SnapshotVersion::None()
+                         hasCommittedMutations:NO];
+  }
+  return maybe_doc;
+}
+
+/**
+ * The index value given to documents whose ordering field holds a pending
+ * server timestamp, which sorts after every encoded value since those start
+ * with their type order.
+ */
+const char kPendingIndexValue[] = "\xff";
+
+/**
+ * Returns true if the index position (`lhs_value`, `lhs_key`) sorts before
+ * (`rhs_value`, `rhs_key`). In key order, all the values are empty.
+ */
+bool IsBefore(absl::string_view lhs_value,
+              const DocumentKey& lhs_key,
+              absl::string_view rhs_value,
+              const DocumentKey& rhs_key) {
+  int comparison = lhs_value.compare(rhs_value);
+  return comparison < 0 || (comparison == 0 && lhs_key < rhs_key);
+}
+
+}  // namespace
+
 FSTMaybeDocument* _Nullable LocalDocumentsView::GetDocument(
     const DocumentKey& key) {
+  auto overlay = overlays_.find(key);
+  if (overlay != overlays_.end()) {
+    return overlay->second;
+  }
+
   std::vector<FSTMutationBatch*> batches =
       mutation_queue_->AllMutationBatchesAffectingDocumentKey(key);
-  return GetDocument(key, batches);
+  FSTMaybeDocument* _Nullable document = GetDocument(key, batches);
+  if (!batches.empty()) {
+    overlays_[key] = document;
+  }
+  return document;
 }
 
 FSTMaybeDocument* _Nullable LocalDocumentsView::GetDocument(
@@ -65,22 +122,70 @@ FSTMaybeDocument* _Nullable LocalDocumentsView::GetDocument(
 MaybeDocumentMap LocalDocumentsView::ApplyLocalMutationsToDocuments(
     const MaybeDocumentMap& docs,
     const std::vector<FSTMutationBatch*>& batches) {
-  MaybeDocumentMap results;
+  // Apply each batch only to the documents it affects rather than visiting
+  // every document for every batch.
+  MaybeDocumentMap results = docs;
+  for (FSTMutationBatch* batch : batches) {
+    results = [batch applyToLocalDocuments:results];
+  }
+  return results;
+}
 
-  for (const auto& kv : docs) {
-    const DocumentKey& key = kv.first;
-    FSTMaybeDocument* local_view = kv.second;
-    for (FSTMutationBatch* batch : batches) {
-      local_view = [batch applyToLocalDocument:local_view documentKey:key];
+void LocalDocumentsView::SaveOverlays(
+    const MaybeDocumentMap& docs,
+    const std::vector<FSTMutationBatch*>& batches) {
+  for (FSTMutationBatch* batch : batches) {
+    for (const DocumentKey& key : batch.keys) {
+      auto found = docs.find(key);
+      if (found != docs.end()) {
+        overlays_[key] = found->second;
+      }
     }
-    results = results.insert(key, local_view);
   }
-  return results;
+}
+
+void LocalDocumentsView::InvalidateOverlays(const DocumentKeySet& keys) {
+  for (const DocumentKey& key : keys) {
+    overlays_.erase(key);
+  }
+}
+
+size_t LocalDocumentsView::EstimatedOverlayByteSize() const {
+  size_t size = 0;
+  for (const auto& entry : overlays_) {
+    size += sizeof(entry) + [entry.second approximateByteSize];
+  }
+  return size;
 }
 
 MaybeDocumentMap LocalDocumentsView::GetDocuments(const DocumentKeySet& keys) {
-  MaybeDocumentMap docs = remote_document_cache_->GetAll(keys);
-  return GetLocalViewOfDocuments(docs);
+  MaybeDocumentMap results;
+
+  // Documents with a cached overlay don't need their remote state or their
+  // mutation batches looked up.
+  DocumentKeySet uncached_keys;
+  for (const DocumentKey& key : keys) {
+    auto overlay = overlays_.find(key);
+    if (overlay != overlays_.end()) {
+      results = results.insert(key, DocumentOrDeleted(overlay->second, key));
+    } else {
+      uncached_keys = uncached_keys.insert(key);
+    }
+  }
+  if (uncached_keys.empty()) {
+    return results;
+  }
+
+  MaybeDocumentMap base_docs = remote_document_cache_->GetAll(uncached_keys);
+  std::vector<FSTMutationBatch*> batches =
+      mutation_queue_->AllMutationBatchesAffectingDocumentKeys(uncached_keys);
+  MaybeDocumentMap docs = ApplyLocalMutationsToDocuments(base_docs, batches);
+  SaveOverlays(docs, batches);
+
+  for (const auto& kv : docs) {
+    results = results.insert(kv.first, DocumentOrDeleted(kv.second, kv.first));
+  }
+  return results;
 }
 
 /**
@@ -101,29 +206,23 @@ MaybeDocumentMap LocalDocumentsView::GetLocalViewOfDocuments(
   MaybeDocumentMap docs = ApplyLocalMutationsToDocuments(base_docs, batches);
 
   for (const auto& kv : docs) {
-    const DocumentKey& key = kv.first;
-    FSTMaybeDocument* maybe_doc = kv.second;
-
-    // TODO(http://b/32275378): Don't conflate missing / deleted.
-    if (!maybe_doc) {
-      maybe_doc = [FSTDeletedDocument documentWithKey:key
-                                              version:SnapshotVersion::None()
-                                hasCommittedMutations:NO];
-    }
-    results = results.insert(key, maybe_doc);
+    results = results.insert(kv.first, DocumentOrDeleted(kv.second, kv.first));
   }
 
   return results;
 }
 
 DocumentMap LocalDocumentsView::GetDocumentsMatchingQuery(FSTQuery* query) {
+  DocumentMap results;
   if ([query isDocumentQuery]) {
-    return GetDocumentsMatchingDocumentQuery(query.path);
+    results = GetDocumentsMatchingDocumentQuery(query.path);
   } else if ([query isCollectionGroupQuery]) {
-    return GetDocumentsMatchingCollectionGroupQuery(query);
+    results = GetDocumentsMatchingCollectionGroupQuery(query);
   } else {
-    return GetDocumentsMatchingCollectionQuery(query);
+    results = GetDocumentsMatchingCollectionQuery(query);
   }
+  QueryProfile::RecordDocumentsMatched(static_cast<int64_t>(results.size()));
+  return results;
 }
 
 DocumentMap LocalDocumentsView::GetDocumentsMatchingDocumentQuery(
@@ -144,58 +243,405 @@ model::DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionGroupQuery(
       "Currently we only support collection group queries at the root.");
 
   std::string collection_id = MakeString(query.collectionGroup);
-  std::vector<ResourcePath> parents =
-      index_manager_->GetCollectionParents(collection_id);
-  DocumentMap results;
+  std::vector<FSTQuery*> collection_queries;
+  for (const ResourcePath& parent :
+       index_manager_->GetCollectionParents(collection_id)) {
+    collection_queries.push_back(
+        [query collectionQueryAtPath:parent.Append(collection_id)]);
+  }
+  QueryProfile::RecordCollectionParentsVisited(
+      static_cast<int64_t>(collection_queries.size()));
+  if (collection_queries.empty()) {
+    return DocumentMap{};
+  }
 
-  // Perform a collection query against each parent that contains the
-  // collection_id and aggregate the results.
-  for (const ResourcePath& parent : parents) {
-    FSTQuery* collection_query =
-        [query collectionQueryAtPath:parent.Append(collection_id)];
-    DocumentMap collection_results =
-        GetDocumentsMatchingCollectionQuery(collection_query);
+  DocumentMap results;
+  auto add_results = [&results](const DocumentMap& collection_results) {
     for (const auto& kv : collection_results.underlying_map()) {
       const DocumentKey& key = kv.first;
       FSTDocument* doc = static_cast<FSTDocument*>(kv.second);
       results = results.insert(key, doc);
     }
+  };
+
+  // Perform a collection query against each parent that contains the
+  // collection_id and aggregate the results. Field indexes are declared per
+  // collection_id, so either all of the collection queries can use one or none
+  // of them can.
+  if (PlanFieldIndexScan(collection_queries.front())) {
+    for (FSTQuery* collection_query : collection_queries) {
+      add_results(GetDocumentsMatchingCollectionQuery(collection_query));
+    }
+    return results;
+  }
+
+  // The scans of the remote documents are independent of each other, so let
+  // the cache run them together, possibly concurrently.
+  std::vector<DocumentMap> remote_results;
+  {
+    QueryProfile::PhaseTimer timer(QueryProfile::Phase::GetMatching);
+    remote_results =
+        remote_document_cache_->GetMatchingForQueries(collection_queries);
+  }
+
+  QueryProfile::PhaseTimer timer(QueryProfile::Phase::Overlay);
+  for (size_t i = 0; i < collection_queries.size(); ++i) {
+    FSTQuery* collection_query = collection_queries[i];
+    std::vector<FSTMutationBatch*> matching_batches =
+        mutation_queue_->AllMutationBatchesAffectingQuery(collection_query);
+    QueryProfile::RecordMutationBatchesOverlaid(
+        static_cast<int64_t>(matching_batches.size()));
+    add_results(ApplyLocalMutationsToQueryResults(
+        collection_query, std::move(remote_results[i]), matching_batches));
   }
   return results;
 }
 
 DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionQuery(
     FSTQuery* query) {
-  DocumentMap results = remote_document_cache_->GetMatching(query);
+  absl::optional<FieldIndexRange> index_range = PlanFieldIndexScan(query);
+  DocumentMap results;
+  {
+    QueryProfile::PhaseTimer timer(QueryProfile::Phase::GetMatching);
+    results =
+        index_range
+            ? remote_document_cache_->GetMatchingUsingIndex(query, *index_range)
+            : remote_document_cache_->GetMatching(query);
+  }
+
+  QueryProfile::PhaseTimer timer(QueryProfile::Phase::Overlay);
   // Get locally persisted mutation batches.
-  std::vector<FSTMutationBatch*> matchingBatches =
+  std::vector<FSTMutationBatch*> matching_batches =
       mutation_queue_->AllMutationBatchesAffectingQuery(query);
+  QueryProfile::RecordMutationBatchesOverlaid(
+      static_cast<int64_t>(matching_batches.size()));
+  return ApplyLocalMutationsToQueryResults(query, std::move(results),
+                                           matching_batches);
+}
 
-  for (FSTMutationBatch* batch : matchingBatches) {
-    for (FSTMutation* mutation : [batch mutations]) {
-      // Only process documents belonging to the collection.
-      if (!query.path.IsImmediateParentOf(mutation.key.path())) {
+absl::optional<DocumentMap> LocalDocumentsView::GetDocumentsMatchingQuery(
+    FSTQuery* query, const DocumentKeySet& remote_keys) {
+  HARD_ASSERT(![query isDocumentQuery] && ![query isCollectionGroupQuery],
+              "Stored results are only used for collection queries");
+
+  std::vector<FSTMutationBatch*> matching_batches =
+      mutation_queue_->AllMutationBatchesAffectingQuery(query);
+  if (query.limit != NSNotFound && !matching_batches.empty()) {
+    return absl::nullopt;
+  }
+
+  DocumentMap results;
+  for (const auto& kv : remote_document_cache_->GetAll(remote_keys)) {
+    // Documents may have been garbage collected since the result was stored,
+    // in which case they're no longer part of it.
+    if ([kv.second isKindOfClass:[FSTDocument class]]) {
+      results = results.insert(kv.first, static_cast<FSTDocument*>(kv.second));
+    }
+  }
+  return ApplyLocalMutationsToQueryResults(query, std::move(results),
+                                           matching_batches);
+}
+
+void LocalDocumentsView::ForEachDocumentMatchingQuery(
+    FSTQuery* query, const std::function<void(FSTDocument*)>& callback) {
+  if ([query isDocumentQuery]) {
+    DocumentMap docs = GetDocumentsMatchingDocumentQuery(query.path);
+    for (const auto& kv : docs.underlying_map()) {
+      callback(static_cast<FSTDocument*>(kv.second));
+    }
+  } else if ([query isCollectionGroupQuery]) {
+    HARD_ASSERT(
+        query.path.empty(),
+        "Currently we only support collection group queries at the root.");
+
+    std::string collection_id = MakeString(query.collectionGroup);
+    for (const ResourcePath& parent :
+         index_manager_->GetCollectionParents(collection_id)) {
+      ForEachDocumentMatchingCollectionQuery(
+          [query collectionQueryAtPath:parent.Append(collection_id)], callback);
+    }
+  } else {
+    ForEachDocumentMatchingCollectionQuery(query, callback);
+  }
+}
+
+void LocalDocumentsView::ForEachDocumentMatchingCollectionQuery(
+    FSTQuery* query, const std::function<void(FSTDocument*)>& callback) {
+  // Documents with local mutations are skipped while reading the remote
+  // documents and visited afterwards in their local view instead.
+  DocumentKeySet mutated_keys;
+  for (FSTMutationBatch* batch :
+       mutation_queue_->AllMutationBatchesAffectingQuery(query)) {
+    for (const DocumentKey& key : batch.keys) {
+      if (query.path.IsImmediateParentOf(key.path())) {
+        mutated_keys = mutated_keys.insert(key);
+      }
+    }
+  }
+
+  auto visit_remote = [&](FSTDocument* doc) {
+    if (!mutated_keys.contains(doc.key) && [query matchesDocument:doc]) {
+      callback(doc);
+    }
+  };
+  absl::optional<FieldIndexRange> index_range = PlanFieldIndexScan(query);
+  if (index_range) {
+    remote_document_cache_->ForEachMatchingUsingIndex(query, *index_range,
+                                                      visit_remote);
+  } else {
+    remote_document_cache_->ForEachMatching(query, visit_remote);
+  }
+
+  if (mutated_keys.empty()) {
+    return;
+  }
+  for (const auto& kv : GetDocuments(mutated_keys)) {
+    FSTMaybeDocument* local_view = kv.second;
+    if ([local_view isKindOfClass:[FSTDocument class]]) {
+      auto* doc = static_cast<FSTDocument*>(local_view);
+      if ([query matchesDocument:doc]) {
+        callback(doc);
+      }
+    }
+  }
+}
+
+LocalQueryPage LocalDocumentsView::ReadDocumentsMatchingQuery(
+    FSTQuery* query,
+    size_t page_size,
+    const absl::optional<LocalQueryCursor>& cursor) {
+  HARD_ASSERT(page_size > 0, "Pages must hold at least one document");
+
+  LocalQueryPage page;
+  size_t documents_read = cursor ? cursor->documents_read : 0;
+  bool limited = query.limit != NSNotFound;
+  if (limited) {
+    auto limit = static_cast<size_t>(query.limit);
+    if (documents_read >= limit) {
+      return page;
+    }
+    page_size = std::min(page_size, limit - documents_read);
+  }
+
+  if ([query isDocumentQuery]) {
+    if (!cursor) {
+      DocumentMap docs = GetDocumentsMatchingDocumentQuery(query.path);
+      for (const auto& kv : docs.underlying_map()) {
+        page.documents.push_back(static_cast<FSTDocument*>(kv.second));
+      }
+    }
+    return page;
+  }
+
+  std::vector<ResourcePath> collection_paths;
+  if ([query isCollectionGroupQuery]) {
+    HARD_ASSERT(
+        query.path.empty(),
+        "Currently we only support collection group queries at the root.");
+
+    std::string collection_id = MakeString(query.collectionGroup);
+    for (const ResourcePath& parent :
+         index_manager_->GetCollectionParents(collection_id)) {
+      collection_paths.push_back(parent.Append(collection_id));
+    }
+    std::sort(collection_paths.begin(), collection_paths.end());
+  } else {
+    collection_paths.push_back(query.path);
+  }
+
+  absl::optional<FieldIndex> order_index = FindOrderingIndex(query);
+  absl::optional<ResourcePath> cursor_collection;
+  if (cursor) {
+    cursor_collection = cursor->last_key.path().PopLast();
+  }
+  std::string last_index_value;
+  for (const ResourcePath& collection_path : collection_paths) {
+    // Collections before the cursor's were read by earlier pages.
+    if (cursor_collection && collection_path < *cursor_collection) {
+      continue;
+    }
+    FSTQuery* collection_query =
+        [query isCollectionGroupQuery]
+            ? [query collectionQueryAtPath:collection_path]
+            : query;
+    const LocalQueryCursor* start_after =
+        cursor_collection && collection_path == *cursor_collection ? &*cursor
+                                                                   : nullptr;
+    ReadCollectionQueryPage(collection_query, order_index, start_after,
+                            page_size, &page.documents, &last_index_value);
+    if (page.documents.size() == page_size) {
+      break;
+    }
+  }
+  QueryProfile::RecordDocumentsMatched(
+      static_cast<int64_t>(page.documents.size()));
+
+  // A page that isn't full is the last one, and so is a page that reaches the
+  // limit.
+  documents_read += page.documents.size();
+  bool limit_reached =
+      limited && documents_read >= static_cast<size_t>(query.limit);
+  if (page.documents.size() == page_size && !limit_reached) {
+    LocalQueryCursor next;
+    next.last_key = page.documents.back().key;
+    if (order_index) {
+      next.last_index_value = std::move(last_index_value);
+    }
+    next.documents_read = documents_read;
+    page.next = std::move(next);
+  }
+  return page;
+}
+
+void LocalDocumentsView::ReadCollectionQueryPage(
+    FSTQuery* query,
+    const absl::optional<FieldIndex>& order_index,
+    const LocalQueryCursor* _Nullable start_after,
+    size_t page_size,
+    std::vector<FSTDocument*>* page,
+    std::string* last_index_value) {
+  std::string start_value;
+  if (start_after && order_index && start_after->last_index_value) {
+    start_value = *start_after->last_index_value;
+  }
+
+  // Documents with local mutations are skipped while reading the remote
+  // documents, and their local views are merged in at their positions.
+  DocumentKeySet mutated_keys;
+  for (FSTMutationBatch* batch :
+       mutation_queue_->AllMutationBatchesAffectingQuery(query)) {
+    for (const DocumentKey& key : batch.keys) {
+      if (query.path.IsImmediateParentOf(key.path())) {
+        mutated_keys = mutated_keys.insert(key);
+      }
+    }
+  }
+
+  using Entry = std::pair<std::string, FSTDocument*>;
+  std::vector<Entry> local_docs;
+  if (!mutated_keys.empty()) {
+    for (const auto& kv : GetDocuments(mutated_keys)) {
+      FSTMaybeDocument* local_view = kv.second;
+      if (![local_view isKindOfClass:[FSTDocument class]]) {
+        continue;
+      }
+      auto* doc = static_cast<FSTDocument*>(local_view);
+      if (![query matchesDocument:doc]) {
         continue;
       }
 
-      const DocumentKey& key = mutation.key;
-      // base_doc may be nil for the documents that weren't yet written to the
-      // backend.
-      FSTMaybeDocument* base_doc = nil;
-      auto found = results.underlying_map().find(key);
-      if (found != results.underlying_map().end()) {
-        base_doc = found->second;
+      std::string value;
+      if (order_index) {
+        absl::optional<std::string> encoded = EncodeFieldIndexValue(
+            [doc fieldForPath:order_index->field_path()]);
+        value = encoded ? std::move(*encoded) : kPendingIndexValue;
       }
-      FSTMaybeDocument* mutated_doc =
-          [mutation applyToLocalDocument:base_doc
-                            baseDocument:base_doc
-                          localWriteTime:batch.localWriteTime];
-
-      if ([mutated_doc isKindOfClass:[FSTDocument class]]) {
-        results = results.insert(key, static_cast<FSTDocument*>(mutated_doc));
-      } else {
-        results = results.erase(key);
+      if (start_after &&
+          !IsBefore(start_value, start_after->last_key, value, doc.key)) {
+        continue;
       }
+      local_docs.emplace_back(std::move(value), doc);
+    }
+    // The local views come in key order, so a stable sort orders views with
+    // equal values by key.
+    std::stable_sort(local_docs.begin(), local_docs.end(),
+                     [](const Entry& lhs, const Entry& rhs) {
+                       return lhs.first < rhs.first;
+                     });
+  }
+
+  // Appends a document to the page, returning false once the page is full.
+  auto append = [&](absl::string_view value, FSTDocument* doc) -> bool {
+    page->push_back(doc);
+    *last_index_value = std::string{value};
+    return page->size() < page_size;
+  };
+  size_t next_local = 0;
+  auto visit_remote = [&](absl::string_view value, FSTDocument* doc) -> bool {
+    if (mutated_keys.contains(doc.key) || ![query matchesDocument:doc]) {
+      return true;
+    }
+    while (next_local < local_docs.size() &&
+           IsBefore(local_docs[next_local].first,
+                    local_docs[next_local].second.key, value, doc.key)) {
+      const Entry& entry = local_docs[next_local++];
+      if (!append(entry.first, entry.second)) {
+        return false;
+      }
+    }
+    return append(value, doc);
+  };
+
+  if (order_index) {
+    // Narrow the scan if a filter on the ordering field can use the index.
+    absl::optional<FieldIndexRange> range = PlanFieldIndexScan(query);
+    if (!range || range->index() != *order_index) {
+      range = FieldIndexRange::All(*order_index);
+    }
+    absl::optional<FieldIndexPosition> position;
+    if (start_after) {
+      position = FieldIndexPosition{start_value, start_after->last_key};
+    }
+    remote_document_cache_->ForEachInIndexOrder(query, *range, position,
+                                                visit_remote);
+  } else {
+    absl::optional<DocumentKey> start_key;
+    if (start_after) {
+      start_key = start_after->last_key;
+    }
+    remote_document_cache_->ForEachInKeyOrder(
+        query, start_key,
+        [&visit_remote](FSTDocument* doc) { return visit_remote("", doc); });
+  }
+
+  // Whatever local views are left sort after all the remote documents.
+  while (page->size() < page_size && next_local < local_docs.size()) {
+    const Entry& entry = local_docs[next_local++];
+    append(entry.first, entry.second);
+  }
+}
+
+DocumentMap LocalDocumentsView::ApplyLocalMutationsToQueryResults(
+    FSTQuery* query,
+    DocumentMap results,
+    const std::vector<FSTMutationBatch*>& batches) {
+  // Group the batches by the documents in the collection they affect.
+  std::unordered_map<DocumentKey, std::vector<FSTMutationBatch*>,
+                     model::DocumentKeyHash>
+      batches_by_key;
+  for (FSTMutationBatch* batch : batches) {
+    for (const DocumentKey& key : batch.keys) {
+      // Only process documents belonging to the collection.
+      if (query.path.IsImmediateParentOf(key.path())) {
+        batches_by_key[key].push_back(batch);
+      }
+    }
+  }
+
+  for (const auto& kv : batches_by_key) {
+    const DocumentKey& key = kv.first;
+    FSTMaybeDocument* _Nullable local_view = nil;
+    auto overlay = overlays_.find(key);
+    if (overlay != overlays_.end()) {
+      local_view = overlay->second;
+    } else {
+      // An index scan only returns documents that matched before applying
+      // local mutations, and a collection scan skips deleted documents, so the
+      // base document may not be in the results.
+      auto found = results.underlying_map().find(key);
+      local_view = found != results.underlying_map().end()
+                       ? found->second
+                       : remote_document_cache_->Get(key);
+      for (FSTMutationBatch* batch : kv.second) {
+        local_view = [batch applyToLocalDocument:local_view documentKey:key];
+      }
+      overlays_[key] = local_view;
+    }
+
+    if ([local_view isKindOfClass:[FSTDocument class]]) {
+      results = results.insert(key, static_cast<FSTDocument*>(local_view));
+    } else {
+      results = results.erase(key);
     }
   }
 
@@ -215,6 +661,67 @@ DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionQuery(
   return results;
 }
 
+absl::optional<FieldIndex> LocalDocumentsView::FindOrderingIndex(
+    FSTQuery* query) {
+  FSTSortOrder* first_order = query.sortOrders.firstObject;
+  if (!first_order.ascending || first_order.field.IsKeyFieldPath()) {
+    return absl::nullopt;
+  }
+
+  std::string collection_id = [query isCollectionGroupQuery]
+                                  ? MakeString(query.collectionGroup)
+                                  : query.path.last_segment();
+  for (const FieldIndex& index :
+       index_manager_->GetFieldIndexes(collection_id)) {
+    if (index.kind() == FieldIndex::Kind::Value &&
+        index.field_path() == first_order.field) {
+      return index;
+    }
+  }
+  return absl::nullopt;
+}
+
+absl::optional<FieldIndexRange> LocalDocumentsView::PlanFieldIndexScan(
+    FSTQuery* query) {
+  std::vector<FieldIndex> indexes =
+      index_manager_->GetFieldIndexes(query.path.last_segment());
+  if (indexes.empty()) {
+    return absl::nullopt;
+  }
+
+  absl::optional<FieldIndexRange> inequality_range;
+  for (FSTFilter* filter in query.filters) {
+    for (const FieldIndex& index : indexes) {
+      absl::optional<FieldIndexRange> range =
+          FieldIndexRangeForFilter(index, filter);
+      if (!range) continue;
+
+      if (![filter isKindOfClass:[FSTRelationFilter class]] ||
+          !((FSTRelationFilter*)filter).isInequality) {
+        return range;
+      }
+      if (!inequality_range) {
+        inequality_range = std::move(range);
+      }
+    }
+  }
+  if (inequality_range) {
+    return inequality_range;
+  }
+
+  for (FSTSortOrder* sort_order in query.explicitSortOrders) {
+    const FieldPath& field = sort_order.field;
+    for (const FieldIndex& index : indexes) {
+      if (index.kind() == FieldIndex::Kind::Value &&
+          index.field_path() == field) {
+        return FieldIndexRange::All(index);
+      }
+    }
+  }
+
+  return absl::nullopt;
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -52,6 +52,25 @@ std::vector<ResourcePath> MemoryCollectionParentIndex::GetEntries(
   return result;
 }
 
+bool MemoryFieldIndexRegistry::Add(const FieldIndex& index) {
+  std::vector<FieldIndex>& existing_indexes = index_[index.collection_id()];
+  if (std::find(existing_indexes.begin(), existing_indexes.end(), index) !=
+      existing_indexes.end()) {
+    return false;
+  }
+  existing_indexes.push_back(index);
+  return true;
+}
+
+std::vector<FieldIndex> MemoryFieldIndexRegistry::GetEntries(
+    const std::string& collection_id) const {
+  auto found = index_.find(collection_id);
+  if (found != index_.end()) {
+    return found->second;
+  }
+  return {};
+}
+
 void MemoryIndexManager::AddToCollectionParentIndex(
     const ResourcePath& collection_path) {
   collection_parents_index_.Add(collection_path);
@@ -62,6 +81,15 @@ std::vector<ResourcePath> MemoryIndexManager::GetCollectionParents(
   return collection_parents_index_.GetEntries(collection_id);
 }
 
+bool MemoryIndexManager::AddFieldIndex(const FieldIndex& index) {
+  return field_indexes_.Add(index);
+}
+
+std::vector<FieldIndex> MemoryIndexManager::GetFieldIndexes(
+    const std::string& collection_id) {
+  return field_indexes_.GetEntries(collection_id);
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
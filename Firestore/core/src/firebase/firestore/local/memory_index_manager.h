@@ -22,6 +22,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/local/field_index.h"
 #include "Firestore/core/src/firebase/firestore/local/index_manager.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 
@@ -46,6 +47,21 @@ class MemoryCollectionParentIndex {
   std::unordered_map<std::string, std::set<model::ResourcePath>> index_;
 };
 
+/**
+ * Internal registry of declared field indexes, keyed by collection_id. Also
+ * used for in-memory caching by LevelDbIndexManager.
+ */
+class MemoryFieldIndexRegistry {
+ public:
+  // Returns false if the index was already registered.
+  bool Add(const FieldIndex& index);
+
+  std::vector<FieldIndex> GetEntries(const std::string& collection_id) const;
+
+ private:
+  std::unordered_map<std::string, std::vector<FieldIndex>> index_;
+};
+
 /** An in-memory implementation of IndexManager. */
 class MemoryIndexManager : public IndexManager {
  public:
@@ -55,8 +71,14 @@ class MemoryIndexManager : public IndexManager {
   std::vector<model::ResourcePath> GetCollectionParents(
       const std::string& collection_id) override;
 
+  bool AddFieldIndex(const FieldIndex& index) override;
+
+  std::vector<FieldIndex> GetFieldIndexes(
+      const std::string& collection_id) override;
+
  private:
   MemoryCollectionParentIndex collection_parents_index_;
+  MemoryFieldIndexRegistry field_indexes_;
 };
 
 }  // namespace local
@@ -65,6 +65,8 @@ class MemoryMutationQueue : public MutationQueue {
 
   void RemoveMutationBatch(FSTMutationBatch* batch) override;
 
+  void ReplaceMutationBatch(FSTMutationBatch* batch) override;
+
   std::vector<FSTMutationBatch*> AllMutationBatches() override {
     return queue_;
   }
@@ -93,6 +95,12 @@ class MemoryMutationQueue : public MutationQueue {
   NSData* _Nullable GetLastStreamToken() override;
   void SetLastStreamToken(NSData* _Nullable token) override;
 
+  size_t EstimatedMemoryUsage() override;
+
+  /** Does nothing, since the queue's batches only exist in memory. */
+  void ReleaseCachedBatches() override {
+  }
+
  private:
   using DocumentKeyReferenceSet =
       immutable::SortedSet<DocumentKeyReference, DocumentKeyReference::ByKey>;
@@ -126,6 +126,18 @@ void MemoryMutationQueue::RemoveMutationBatch(FSTMutationBatch* batch) {
   }
 }
 
+void MemoryMutationQueue::ReplaceMutationBatch(FSTMutationBatch* batch) {
+  int index = IndexOfBatchId(batch.batchID);
+  HARD_ASSERT(index >= 0 && index < queue_.size(),
+              "Trying to replace a batch that is not in the queue");
+  HARD_ASSERT(batch.keys == queue_[index].keys,
+              "Replacement batch must affect the same documents");
+
+  // The index is keyed by document key and batch ID, both of which stay the
+  // same.
+  queue_[index] = batch;
+}
+
 std::vector<FSTMutationBatch*>
 MemoryMutationQueue::AllMutationBatchesAffectingDocumentKeys(
     const DocumentKeySet& document_keys) {
@@ -264,6 +276,14 @@ void MemoryMutationQueue::SetLastStreamToken(NSData* _Nullable token) {
   last_stream_token_ = token;
 }
 
+size_t MemoryMutationQueue::EstimatedMemoryUsage() {
+  size_t size = 0;
+  for (FSTMutationBatch* batch : queue_) {
+    size += sizeof(batch) + [batch approximateByteSize];
+  }
+  return size;
+}
+
 std::vector<FSTMutationBatch*> MemoryMutationQueue::AllMutationBatchesWithIds(
     const std::set<BatchId>& batch_ids) {
   std::vector<FSTMutationBatch*> result;
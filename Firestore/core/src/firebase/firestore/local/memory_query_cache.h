@@ -30,9 +30,11 @@
 #include "Firestore/core/src/firebase/firestore/local/query_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/reference_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "Firestore/core/src/firebase/firestore/util/objc_compatibility.h"
+#include "absl/types/optional.h"
 
 @class FSTLocalSerializer;
 @class FSTMemoryPersistence;
@@ -62,7 +64,8 @@ class MemoryQueryCache : public QueryCache {
 
   int RemoveTargets(model::ListenSequenceNumber upper_bound,
                     const std::unordered_map<model::TargetId, FSTQueryData*>&
-                        live_targets) override;
+                        live_targets,
+                    int limit) override;
 
   // Key-related methods
   void AddMatchingKeys(const model::DocumentKeySet& keys,
@@ -75,6 +78,26 @@ class MemoryQueryCache : public QueryCache {
 
   bool Contains(const model::DocumentKey& key) override;
 
+  // Query result methods
+
+  // The memory cache doesn't survive restarts, so there are no cold-start
+  // listens for stored query results to speed up.
+  void SetQueryResult(FSTQueryData* query_data,
+                      const model::DocumentKeySet& keys) override {
+  }
+
+  absl::optional<model::DocumentKeySet> GetQueryResult(
+      FSTQueryData* query_data) override {
+    return absl::nullopt;
+  }
+
+  void RemoveQueryResult(FSTQueryData* query_data) override {
+  }
+
+  void InvalidateQueryResults(
+      const model::ResourcePath& collection_path) override {
+  }
+
   // Other methods and accessors
   size_t CalculateByteSize(FSTLocalSerializer* serializer);
 
@@ -80,9 +80,13 @@ void MemoryQueryCache::EnumerateTargets(const TargetCallback& callback) {
 
 int MemoryQueryCache::RemoveTargets(
     model::ListenSequenceNumber upper_bound,
-    const std::unordered_map<TargetId, FSTQueryData*>& live_targets) {
+    const std::unordered_map<TargetId, FSTQueryData*>& live_targets,
+    int limit) {
   std::vector<FSTQuery*> to_remove;
   for (const auto& kv : queries_) {
+    if (static_cast<int>(to_remove.size()) >= limit) {
+      break;
+    }
     FSTQuery* query = kv.first;
     FSTQueryData* query_data = kv.second;
 
@@ -21,6 +21,8 @@
 #error "For now, this file must only be included by ObjC source files."
 #endif  // !defined(__OBJC__)
 
+#include <functional>
+#include <unordered_map>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
@@ -28,7 +30,10 @@
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 
+@class FSTDocument;
 @class FSTLocalSerializer;
 @class FSTMaybeDocument;
 @class FSTMemoryLRUReferenceDelegate;
@@ -43,7 +48,12 @@ namespace local {
 
 class MemoryRemoteDocumentCache : public RemoteDocumentCache {
  public:
-  explicit MemoryRemoteDocumentCache(FSTMemoryPersistence *persistence);
+  /**
+   * Creates a cache owned by `persistence`. If a serializer is given, the cache
+   * keeps track of the approximate size of its documents, see `byte_size()`.
+   */
+  MemoryRemoteDocumentCache(FSTMemoryPersistence *persistence,
+                            FSTLocalSerializer *_Nullable serializer);
 
   void Add(FSTMaybeDocument *document) override;
   void Remove(const model::DocumentKey &key) override;
@@ -51,17 +61,64 @@ class MemoryRemoteDocumentCache : public RemoteDocumentCache {
   FSTMaybeDocument *_Nullable Get(const model::DocumentKey &key) override;
   model::MaybeDocumentMap GetAll(const model::DocumentKeySet &keys) override;
   model::DocumentMap GetMatching(FSTQuery *query) override;
+  std::vector<model::DocumentMap> GetMatchingForQueries(
+      const std::vector<FSTQuery *> &queries) override;
+  model::DocumentMap GetMatchingUsingIndex(
+      FSTQuery *query, const FieldIndexRange &range) override;
+  void ForEachMatching(
+      FSTQuery *query,
+      const std::function<void(FSTDocument *)> &callback) override;
+  void ForEachMatchingUsingIndex(
+      FSTQuery *query,
+      const FieldIndexRange &range,
+      const std::function<void(FSTDocument *)> &callback) override;
+  void ForEachInKeyOrder(
+      FSTQuery *query,
+      const absl::optional<model::DocumentKey> &start_after,
+      const std::function<bool(FSTDocument *)> &callback) override;
+
+  /**
+   * Sorts the documents of the collection by their encoded values, since the
+   * in-memory cache doesn't maintain field indexes.
+   */
+  void ForEachInIndexOrder(
+      FSTQuery *query,
+      const FieldIndexRange &range,
+      const absl::optional<FieldIndexPosition> &start_after,
+      const std::function<bool(absl::string_view, FSTDocument *)> &callback)
+      override;
+  void BackfillFieldIndex(const FieldIndex &index) override;
+  size_t EstimatedMemoryUsage() override;
 
   std::vector<model::DocumentKey> RemoveOrphanedDocuments(
       FSTMemoryLRUReferenceDelegate *reference_delegate,
-      model::ListenSequenceNumber upper_bound);
-
-  size_t CalculateByteSize(FSTLocalSerializer *serializer);
+      model::ListenSequenceNumber upper_bound,
+      int limit);
+
+  /**
+   * Returns the approximate number of bytes used by the cached documents, as
+   * the sum of the sizes of their keys and serialized forms, or 0 if the cache
+   * wasn't given a serializer to measure them with. Maintained as documents are
+   * added and removed, so it's cheap to call.
+   */
+  size_t byte_size() const {
+    return byte_size_;
+  }
 
  private:
+  /** Stops counting the size of the document at `key`, if it was counted. */
+  void ForgetByteSize(const model::DocumentKey &key);
+
   /** Underlying cache of documents. */
   model::MaybeDocumentMap docs_;
 
+  FSTLocalSerializer *_Nullable serializer_;
+
+  /** The size counted for each document, if sizes are tracked. */
+  std::unordered_map<model::DocumentKey, size_t, model::DocumentKeyHash>
+      byte_sizes_;
+  size_t byte_size_ = 0;
+
   // This instance is owned by FSTMemoryPersistence; avoid a retain cycle.
   __weak FSTMemoryPersistence *persistence_;
 };
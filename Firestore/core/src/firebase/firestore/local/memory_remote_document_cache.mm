@@ -16,15 +16,26 @@
 
 #include "Firestore/core/src/firebase/firestore/local/memory_remote_document_cache.h"
 
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
 #import "Firestore/Protos/objc/firestore/local/MaybeDocument.pbobjc.h"
 #import "Firestore/Source/Core/FSTQuery.h"
+#import "Firestore/Source/Local/FSTLocalSerializer.h"
 #import "Firestore/Source/Local/FSTMemoryPersistence.h"
+#import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Model/FSTFieldValue.h"
 
+#include "Firestore/core/src/firebase/firestore/local/field_index_encoding.h"
+#include "Firestore/core/src/firebase/firestore/local/query_profile.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::DocumentMap;
+using firebase::firestore::model::FieldPath;
 using firebase::firestore::model::ListenSequenceNumber;
 using firebase::firestore::model::MaybeDocumentMap;
 
@@ -48,19 +59,38 @@ size_t DocumentKeyByteSize(const DocumentKey& key) {
 }  // namespace
 
 MemoryRemoteDocumentCache::MemoryRemoteDocumentCache(
-    FSTMemoryPersistence* persistence) {
+    FSTMemoryPersistence* persistence, FSTLocalSerializer* _Nullable serializer)
+    : serializer_(serializer) {
   persistence_ = persistence;
 }
 
 void MemoryRemoteDocumentCache::Add(FSTMaybeDocument* document) {
   docs_ = docs_.insert(document.key, document);
 
+  if (serializer_) {
+    size_t size =
+        DocumentKeyByteSize(document.key) +
+        [serializer_ encodedMaybeDocumentBytes:document].size();
+    size_t& counted = byte_sizes_[document.key];
+    byte_size_ = byte_size_ - counted + size;
+    counted = size;
+  }
+
   persistence_.indexManager->AddToCollectionParentIndex(
       document.key.path().PopLast());
 }
 
 void MemoryRemoteDocumentCache::Remove(const DocumentKey& key) {
   docs_ = docs_.erase(key);
+  ForgetByteSize(key);
+}
+
+void MemoryRemoteDocumentCache::ForgetByteSize(const DocumentKey& key) {
+  auto found = byte_sizes_.find(key);
+  if (found != byte_sizes_.end()) {
+    byte_size_ -= found->second;
+    byte_sizes_.erase(found);
+  }
 }
 
 FSTMaybeDocument* _Nullable MemoryRemoteDocumentCache::Get(
@@ -81,12 +111,19 @@ MaybeDocumentMap MemoryRemoteDocumentCache::GetAll(const DocumentKeySet& keys) {
 }
 
 DocumentMap MemoryRemoteDocumentCache::GetMatching(FSTQuery* query) {
+  DocumentMap results;
+  ForEachMatching(query, [&results](FSTDocument* doc) {
+    results = results.insert(doc.key, doc);
+  });
+  return results;
+}
+
+void MemoryRemoteDocumentCache::ForEachMatching(
+    FSTQuery* query, const std::function<void(FSTDocument*)>& callback) {
   HARD_ASSERT(
       ![query isCollectionGroupQuery],
       "CollectionGroup queries should be handled in LocalDocumentsView");
 
-  DocumentMap results;
-
   // Documents are ordered by key, so we can use a prefix scan to narrow down
   // the documents we need to match the query against.
   DocumentKey prefix{query.path.Append("")};
@@ -95,24 +132,128 @@ DocumentMap MemoryRemoteDocumentCache::GetMatching(FSTQuery* query) {
     if (!query.path.IsPrefixOf(key.path())) {
       break;
     }
+    QueryProfile::RecordKeysScanned();
     FSTMaybeDocument* maybeDoc = it->second;
     if (![maybeDoc isKindOfClass:[FSTDocument class]]) {
       continue;
     }
     FSTDocument* doc = static_cast<FSTDocument*>(maybeDoc);
     if ([query matchesDocument:doc]) {
-      results = results.insert(key, doc);
+      callback(doc);
     }
   }
+}
+
+std::vector<DocumentMap> MemoryRemoteDocumentCache::GetMatchingForQueries(
+    const std::vector<FSTQuery*>& queries) {
+  std::vector<DocumentMap> results;
+  results.reserve(queries.size());
+  for (FSTQuery* query : queries) {
+    results.push_back(GetMatching(query));
+  }
   return results;
 }
 
+DocumentMap MemoryRemoteDocumentCache::GetMatchingUsingIndex(
+    FSTQuery* query, const FieldIndexRange&) {
+  // The in-memory cache doesn't maintain field indexes; a prefix scan over the
+  // sorted map is already proportional to the size of the collection.
+  return GetMatching(query);
+}
+
+void MemoryRemoteDocumentCache::ForEachMatchingUsingIndex(
+    FSTQuery* query,
+    const FieldIndexRange&,
+    const std::function<void(FSTDocument*)>& callback) {
+  ForEachMatching(query, callback);
+}
+
+void MemoryRemoteDocumentCache::ForEachInKeyOrder(
+    FSTQuery* query,
+    const absl::optional<DocumentKey>& start_after,
+    const std::function<bool(FSTDocument*)>& callback) {
+  HARD_ASSERT(
+      ![query isCollectionGroupQuery],
+      "CollectionGroup queries should be handled in LocalDocumentsView");
+
+  DocumentKey start =
+      start_after ? *start_after : DocumentKey{query.path.Append("")};
+  for (auto it = docs_.lower_bound(start); it != docs_.end(); ++it) {
+    const DocumentKey& key = it->first;
+    if (!query.path.IsPrefixOf(key.path())) {
+      break;
+    }
+    QueryProfile::RecordKeysScanned();
+    if (!query.path.IsImmediateParentOf(key.path()) ||
+        (start_after && key == *start_after) ||
+        ![it->second isKindOfClass:[FSTDocument class]]) {
+      continue;
+    }
+    if (!callback(static_cast<FSTDocument*>(it->second))) {
+      return;
+    }
+  }
+}
+
+void MemoryRemoteDocumentCache::ForEachInIndexOrder(
+    FSTQuery* query,
+    const FieldIndexRange& range,
+    const absl::optional<FieldIndexPosition>& start_after,
+    const std::function<bool(absl::string_view, FSTDocument*)>& callback) {
+  // Collect the entries a LevelDB field index would have for the collection.
+  using Entry = std::pair<std::string, FSTDocument*>;
+  const FieldPath& field_path = range.index().field_path();
+  std::vector<Entry> entries;
+  ForEachInKeyOrder(query, absl::nullopt, [&](FSTDocument* doc) {
+    FSTFieldValue* value = [doc fieldForPath:field_path];
+    if (value) {
+      absl::optional<std::string> encoded = EncodeFieldIndexValue(value);
+      if (encoded && range.Contains(*encoded)) {
+        entries.emplace_back(std::move(*encoded), doc);
+      }
+    }
+    return true;
+  });
+
+  // The documents were visited in key order, so a stable sort orders entries
+  // with equal values by key.
+  std::stable_sort(entries.begin(), entries.end(),
+                   [](const Entry& lhs, const Entry& rhs) {
+                     return lhs.first < rhs.first;
+                   });
+  auto is_after_start = [&start_after](const Entry& entry) {
+    return !start_after || entry.first > start_after->index_value ||
+           (entry.first == start_after->index_value &&
+            start_after->document_key < entry.second.key);
+  };
+  for (const Entry& entry : entries) {
+    if (is_after_start(entry) && !callback(entry.first, entry.second)) {
+      return;
+    }
+  }
+}
+
+void MemoryRemoteDocumentCache::BackfillFieldIndex(const FieldIndex&) {
+}
+
+size_t MemoryRemoteDocumentCache::EstimatedMemoryUsage() {
+  size_t size = 0;
+  for (const auto& kv : docs_) {
+    size += [kv.second approximateByteSize];
+  }
+  return size;
+}
+
 std::vector<DocumentKey> MemoryRemoteDocumentCache::RemoveOrphanedDocuments(
     FSTMemoryLRUReferenceDelegate* reference_delegate,
-    ListenSequenceNumber upper_bound) {
+    ListenSequenceNumber upper_bound,
+    int limit) {
   std::vector<DocumentKey> removed;
   MaybeDocumentMap updated_docs = docs_;
   for (const auto& kv : docs_) {
+    if (static_cast<int>(removed.size()) >= limit) {
+      break;
+    }
     const DocumentKey& key = kv.first;
     if (![reference_delegate isPinnedAtSequenceNumber:upper_bound
                                              document:key]) {
@@ -121,17 +262,10 @@ std::vector<DocumentKey> MemoryRemoteDocumentCache::RemoveOrphanedDocuments(
     }
   }
   docs_ = updated_docs;
-  return removed;
-}
-
-size_t MemoryRemoteDocumentCache::CalculateByteSize(
-    FSTLocalSerializer* serializer) {
-  size_t count = 0;
-  for (const auto& kv : docs_) {
-    count += DocumentKeyByteSize(kv.first);
-    count += [[serializer encodedMaybeDocument:kv.second] serializedSize];
+  for (const DocumentKey& key : removed) {
+    ForgetByteSize(key);
   }
-  return count;
+  return removed;
 }
 
 }  // namespace local
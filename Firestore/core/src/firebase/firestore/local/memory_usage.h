@@ -0,0 +1,64 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_MEMORY_USAGE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_MEMORY_USAGE_H_
+
+#include <cstddef>
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Estimates of the number of bytes of memory held by each of the client's
+ * in-memory structures. Documents and values shared between structures, such
+ * as a document that's both cached and part of a view, are counted in each.
+ */
+struct MemoryUsage {
+  /** The documents of the remote document cache, if it's held in memory. */
+  size_t remote_documents_bytes = 0;
+
+  /** The documents that views hold to compute their changes. */
+  size_t view_documents_bytes = 0;
+
+  /**
+   * The local views of documents with pending writes, as computed by applying
+   * the writes to the remote documents. These are recomputed when needed, so
+   * they're dropped under memory pressure.
+   */
+  size_t local_documents_bytes = 0;
+
+  /** The references that keep documents pinned in the local store. */
+  size_t reference_set_bytes = 0;
+
+  /**
+   * The mutation batches held in memory: all of them for memory persistence,
+   * or the decoded copies of persisted batches otherwise.
+   */
+  size_t mutation_batches_bytes = 0;
+
+  size_t total() const {
+    return remote_documents_bytes + view_documents_bytes +
+           local_documents_bytes + reference_set_bytes + mutation_batches_bytes;
+  }
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_MEMORY_USAGE_H_
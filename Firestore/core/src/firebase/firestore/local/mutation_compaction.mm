@@ -0,0 +1,111 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/mutation_compaction.h"
+
+#include <set>
+#include <utility>
+
+#import "Firestore/Source/Model/FSTFieldValue.h"
+#import "Firestore/Source/Model/FSTMutation.h"
+
+#include "Firestore/core/src/firebase/firestore/model/field_mask.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/precondition.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+using model::FieldMask;
+using model::FieldPath;
+using model::Precondition;
+
+bool IsSetOrPatch(FSTMutation* mutation) {
+  return [mutation isKindOfClass:[FSTSetMutation class]] ||
+         [mutation isKindOfClass:[FSTPatchMutation class]];
+}
+
+/**
+ * Returns the union of the given masks, leaving out fields nested in other
+ * fields of the union: the backend rejects masks with overlapping fields, and
+ * the value of the outer field covers the nested one anyway.
+ */
+FieldMask MergeFieldMasks(const FieldMask& lhs, const FieldMask& rhs) {
+  std::set<FieldPath> all_fields{lhs.begin(), lhs.end()};
+  all_fields.insert(rhs.begin(), rhs.end());
+
+  // Nested fields sort right after the field that contains them.
+  std::set<FieldPath> fields;
+  for (const FieldPath& field : all_fields) {
+    if (fields.empty() || !fields.rbegin()->IsPrefixOf(field)) {
+      fields.insert(fields.end(), field);
+    }
+  }
+  return FieldMask{std::move(fields)};
+}
+
+}  // namespace
+
+FSTMutation* _Nullable CompactMutations(FSTMutation* earlier,
+                                        FSTMutation* later) {
+  HARD_ASSERT(earlier.key == later.key,
+              "Compacting mutations of different documents");
+
+  if (!IsSetOrPatch(earlier) || !IsSetOrPatch(later)) {
+    return nil;
+  }
+  if (!earlier.precondition.IsNone()) {
+    return nil;
+  }
+  if (!later.precondition.IsNone() &&
+      !(later.precondition == Precondition::Exists(true))) {
+    return nil;
+  }
+
+  if ([later isKindOfClass:[FSTSetMutation class]]) {
+    return [[FSTSetMutation alloc] initWithKey:later.key
+                                         value:((FSTSetMutation*)later).value
+                                  precondition:Precondition::None()];
+  }
+
+  auto* patch = (FSTPatchMutation*)later;
+  if ([earlier isKindOfClass:[FSTSetMutation class]]) {
+    FSTObjectValue* value =
+        [patch patchObjectValue:((FSTSetMutation*)earlier).value];
+    return [[FSTSetMutation alloc] initWithKey:later.key
+                                         value:value
+                                  precondition:Precondition::None()];
+  }
+
+  auto* earlier_patch = (FSTPatchMutation*)earlier;
+  return [[FSTPatchMutation alloc]
+       initWithKey:later.key
+         fieldMask:MergeFieldMasks(*earlier_patch.fieldMask, *patch.fieldMask)
+             value:[patch patchObjectValue:earlier_patch.value]
+      precondition:Precondition::None()];
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
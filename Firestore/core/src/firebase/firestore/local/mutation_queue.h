@@ -82,6 +82,13 @@ class MutationQueue {
    */
   virtual void RemoveMutationBatch(FSTMutationBatch* batch) = 0;
 
+  /**
+   * Replaces the batch in the queue that has the same batch ID as the given
+   * batch. The new batch must affect exactly the same documents as the one it
+   * replaces.
+   */
+  virtual void ReplaceMutationBatch(FSTMutationBatch* batch) = 0;
+
   /** Gets all mutation batches in the mutation queue. */
   // TODO(mikelehen): PERF: Current consumer only needs mutated keys; if we can
   // provide that cheaply, we should replace this.
@@ -161,6 +168,18 @@ class MutationQueue {
 
   /** Sets the stream token for this mutation queue. */
   virtual void SetLastStreamToken(NSData* _Nullable stream_token) = 0;
+
+  /**
+   * Returns an estimate of the number of bytes of memory used by the mutation
+   * batches that the queue holds in memory.
+   */
+  virtual size_t EstimatedMemoryUsage() = 0;
+
+  /**
+   * Drops the batches that the queue holds in memory but can read back from
+   * persistence. Batches that only exist in memory are kept.
+   */
+  virtual void ReleaseCachedBatches() = 0;
 };
 
 }  // namespace local
@@ -28,8 +28,10 @@
 
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "absl/types/optional.h"
 
 @class FSTQuery;
 @class FSTQueryData;
@@ -95,10 +97,15 @@ class QueryCache {
 
   virtual void EnumerateTargets(const TargetCallback& callback) = 0;
 
+  /**
+   * Removes at most `limit` targets that are not in `live_targets` and have a
+   * sequence number less than or equal to `upper_bound`. Returns the number of
+   * targets removed.
+   */
   virtual int RemoveTargets(
       model::ListenSequenceNumber upper_bound,
-      const std::unordered_map<model::TargetId, FSTQueryData*>&
-          live_targets) = 0;
+      const std::unordered_map<model::TargetId, FSTQueryData*>& live_targets,
+      int limit) = 0;
 
   // Key-related methods
   virtual void AddMatchingKeys(const model::DocumentKeySet& keys,
@@ -111,6 +118,38 @@ class QueryCache {
 
   virtual bool Contains(const model::DocumentKey& key) = 0;
 
+  // Query result methods
+
+  /**
+   * Stores `keys` as the result of the target's collection query against the
+   * remote documents, so that a later listen to the target can look up those
+   * documents instead of scanning the collection. For a limit query, `keys`
+   * are the documents within the limit.
+   *
+   * The caller must store a new result whenever the target's result changes
+   * while it's active. Otherwise results are dropped by
+   * InvalidateQueryResults().
+   */
+  virtual void SetQueryResult(FSTQueryData* query_data,
+                              const model::DocumentKeySet& keys) = 0;
+
+  /**
+   * Returns the result last stored for the target by SetQueryResult(), or
+   * absl::nullopt if there's none or it has been invalidated since.
+   */
+  virtual absl::optional<model::DocumentKeySet> GetQueryResult(
+      FSTQueryData* query_data) = 0;
+
+  /** Drops the stored result of the target, if any. */
+  virtual void RemoveQueryResult(FSTQueryData* query_data) = 0;
+
+  /**
+   * Drops the stored results of all queries on the given collection. Must be
+   * called whenever a remote document in the collection changes.
+   */
+  virtual void InvalidateQueryResults(
+      const model::ResourcePath& collection_path) = 0;
+
   // Accessors
 
   /** Returns the number of targets cached. */
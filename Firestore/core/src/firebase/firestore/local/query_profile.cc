@@ -0,0 +1,127 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/query_profile.h"
+
+#include "absl/base/config.h"
+#include "absl/strings/str_cat.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+thread_local QueryProfile* current_profile = nullptr;
+#endif
+
+}  // namespace
+
+QueryProfile::Scope::Scope(QueryProfile* profile) {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  previous_ = current_profile;
+  current_profile = profile;
+#else
+  (void)profile;
+#endif
+}
+
+QueryProfile::Scope::~Scope() {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  current_profile = previous_;
+#endif
+}
+
+QueryProfile::PhaseTimer::PhaseTimer(Phase phase)
+    : profile_(QueryProfile::Current()), phase_(phase) {
+  if (profile_) {
+    start_ = Clock::now();
+  }
+}
+
+QueryProfile::PhaseTimer::~PhaseTimer() {
+  if (profile_) {
+    profile_->AddDuration(phase_, std::chrono::duration_cast<Microseconds>(
+                                      Clock::now() - start_));
+  }
+}
+
+bool QueryProfile::IsSupported() {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  return true;
+#else
+  return false;
+#endif
+}
+
+QueryProfile* QueryProfile::Current() {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  return current_profile;
+#else
+  return nullptr;
+#endif
+}
+
+void QueryProfile::RecordKeysScanned(int64_t count) {
+  if (QueryProfile* profile = Current()) {
+    profile->keys_scanned_ += count;
+  }
+}
+
+void QueryProfile::RecordDocumentDecoded() {
+  if (QueryProfile* profile = Current()) {
+    ++profile->documents_decoded_;
+  }
+}
+
+void QueryProfile::RecordDocumentsMatched(int64_t count) {
+  if (QueryProfile* profile = Current()) {
+    profile->documents_matched_ += count;
+  }
+}
+
+void QueryProfile::RecordMutationBatchesOverlaid(int64_t count) {
+  if (QueryProfile* profile = Current()) {
+    profile->mutation_batches_overlaid_ += count;
+  }
+}
+
+void QueryProfile::RecordCollectionParentsVisited(int64_t count) {
+  if (QueryProfile* profile = Current()) {
+    profile->collection_parents_visited_ += count;
+  }
+}
+
+void QueryProfile::AddDuration(Phase phase, Microseconds elapsed) {
+  durations_[static_cast<size_t>(phase)] += elapsed;
+}
+
+std::string QueryProfile::ToString() const {
+  return absl::StrCat(
+      "QueryProfile(keys_scanned=", keys_scanned_,
+      ", documents_decoded=", documents_decoded_,
+      ", documents_matched=", documents_matched_,
+      ", mutation_batches_overlaid=", mutation_batches_overlaid_,
+      ", collection_parents_visited=", collection_parents_visited_,
+      ", get_matching_us=", duration(Phase::GetMatching).count(),
+      ", overlay_us=", duration(Phase::Overlay).count(),
+      ", view_diff_us=", duration(Phase::ViewDiff).count(), ")");
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_QUERY_PROFILE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_QUERY_PROFILE_H_
+
+#include <array>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Counts the work done by a single execution of a query against the local
+ * store: how many rows were read from the remote document cache, how many of
+ * them were decoded, how many local mutation batches were applied on top, and
+ * how long each phase took.
+ *
+ * The storage layers record into the profile of the current thread's innermost
+ * `Scope`, if any, so that executing a query without one costs nothing more
+ * than a thread-local read at each recording site.
+ */
+class QueryProfile {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using Microseconds = std::chrono::microseconds;
+
+  /** The phases of a query execution that are timed separately. */
+  enum class Phase {
+    /** Scanning the remote document cache for candidate documents. */
+    GetMatching,
+    /** Applying local mutations to the candidates in LocalDocumentsView. */
+    Overlay,
+    /** Computing the view changes from the resulting documents. */
+    ViewDiff,
+  };
+
+  /**
+   * Makes the given profile the target of the recording functions on the
+   * current thread for the lifetime of the Scope.
+   */
+  class Scope {
+   public:
+    explicit Scope(QueryProfile* profile);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    QueryProfile* previous_ = nullptr;
+  };
+
+  /**
+   * Adds the time between its construction and destruction to the given phase
+   * of the current profile. Does nothing if there's no current profile.
+   */
+  class PhaseTimer {
+   public:
+    explicit PhaseTimer(Phase phase);
+    ~PhaseTimer();
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+   private:
+    QueryProfile* profile_ = nullptr;
+    Phase phase_;
+    Clock::time_point start_;
+  };
+
+  QueryProfile() = default;
+
+  /**
+   * Whether profiles can be recorded in this build, which requires
+   * thread_local.
+   */
+  static bool IsSupported();
+
+  /** The profile of the innermost Scope on the current thread, if any. */
+  static QueryProfile* Current();
+
+  /** Records a row key the current query read from LevelDB. */
+  static void RecordKeysScanned(int64_t count = 1);
+
+  /** Records a document the current query parsed from its stored form. */
+  static void RecordDocumentDecoded();
+
+  /** Records the documents in the result of the current query. */
+  static void RecordDocumentsMatched(int64_t count);
+
+  /** Records mutation batches applied to the results of the current query. */
+  static void RecordMutationBatchesOverlaid(int64_t count);
+
+  /**
+   * Records the parents a collection group query ran a collection query
+   * against.
+   */
+  static void RecordCollectionParentsVisited(int64_t count);
+
+  int64_t keys_scanned() const {
+    return keys_scanned_;
+  }
+  int64_t documents_decoded() const {
+    return documents_decoded_;
+  }
+  int64_t documents_matched() const {
+    return documents_matched_;
+  }
+  int64_t mutation_batches_overlaid() const {
+    return mutation_batches_overlaid_;
+  }
+  int64_t collection_parents_visited() const {
+    return collection_parents_visited_;
+  }
+
+  /** The total time spent in the given phase. */
+  Microseconds duration(Phase phase) const {
+    return durations_[static_cast<size_t>(phase)];
+  }
+
+  /** Adds `elapsed` to the time spent in the given phase. */
+  void AddDuration(Phase phase, Microseconds elapsed);
+
+  /** A single-line, human-readable summary of the profile. */
+  std::string ToString() const;
+
+ private:
+  int64_t keys_scanned_ = 0;
+  int64_t documents_decoded_ = 0;
+  int64_t documents_matched_ = 0;
+  int64_t mutation_batches_overlaid_ = 0;
+  int64_t collection_parents_visited_ = 0;
+
+  std::array<Microseconds, 3> durations_{};
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_QUERY_PROFILE_H_
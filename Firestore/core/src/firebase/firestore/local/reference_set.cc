@@ -16,8 +16,9 @@
 
 #include "Firestore/core/src/firebase/firestore/local/reference_set.h"
 
-#include "Firestore/core/src/firebase/firestore/immutable/sorted_set.h"
-#include "Firestore/core/src/firebase/firestore/local/document_key_reference.h"
+#include <algorithm>
+#include <utility>
+
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 
 namespace firebase {
@@ -28,73 +29,127 @@ using model::DocumentKey;
 using model::DocumentKeySet;
 
 void ReferenceSet::AddReference(const DocumentKey& key, int id) {
-  DocumentKeyReference reference{key, id};
-  by_key_ = by_key_.insert(reference);
-  by_id_ = by_id_.insert(reference);
+  if (AddId(key, id)) {
+    by_id_[id].insert(key);
+  }
 }
 
 void ReferenceSet::AddReferences(const DocumentKeySet& keys, int id) {
+  if (keys.empty()) return;
+
+  // Look up the Id's keys once for the whole batch.
+  KeySet& id_keys = by_id_[id];
+  id_keys.reserve(id_keys.size() + keys.size());
   for (const DocumentKey& key : keys) {
-    AddReference(key, id);
+    if (AddId(key, id)) {
+      id_keys.insert(key);
+    }
   }
 }
 
 void ReferenceSet::RemoveReference(const DocumentKey& key, int id) {
-  RemoveReference(DocumentKeyReference{key, id});
+  if (!RemoveId(key, id)) return;
+
+  auto found = by_id_.find(id);
+  found->second.erase(key);
+  if (found->second.empty()) {
+    by_id_.erase(found);
+  }
 }
 
-void ReferenceSet::RemoveReferences(
-    const firebase::firestore::model::DocumentKeySet& keys, int id) {
+void ReferenceSet::RemoveReferences(const DocumentKeySet& keys, int id) {
+  auto found = by_id_.find(id);
+  if (found == by_id_.end()) return;
+
   for (const DocumentKey& key : keys) {
-    RemoveReference(key, id);
+    if (RemoveId(key, id)) {
+      found->second.erase(key);
+    }
+  }
+  if (found->second.empty()) {
+    by_id_.erase(found);
   }
 }
 
 DocumentKeySet ReferenceSet::RemoveReferences(int id) {
-  DocumentKeyReference start{DocumentKey::Empty(), id};
-  DocumentKeyReference end{DocumentKey::Empty(), id + 1};
-
-  DocumentKeySet removed{};
+  auto found = by_id_.find(id);
+  if (found == by_id_.end()) return DocumentKeySet{};
 
-  auto initial = by_id_;
-  for (const auto& reference : initial.values_in(start, end)) {
-    RemoveReference(reference);
-    removed = removed.insert(reference.key());
+  KeySet keys = std::move(found->second);
+  by_id_.erase(found);
+  for (const DocumentKey& key : keys) {
+    RemoveId(key, id);
   }
-  return removed;
+  return ToDocumentKeySet(keys);
 }
 
 void ReferenceSet::RemoveAllReferences() {
-  auto initial = by_key_;
-  for (const DocumentKeyReference& reference : initial) {
-    RemoveReference(reference);
-  }
+  by_key_.clear();
+  by_id_.clear();
+  size_ = 0;
+}
+
+DocumentKeySet ReferenceSet::ReferencedKeys(int id) {
+  auto found = by_id_.find(id);
+  if (found == by_id_.end()) return DocumentKeySet{};
+
+  return ToDocumentKeySet(found->second);
 }
 
-void ReferenceSet::RemoveReference(const DocumentKeyReference& reference) {
-  by_key_ = by_key_.erase(reference);
-  by_id_ = by_id_.erase(reference);
+bool ReferenceSet::ContainsKey(const DocumentKey& key) {
+  return by_key_.find(key) != by_key_.end();
 }
 
-DocumentKeySet ReferenceSet::ReferencedKeys(int id) {
-  DocumentKeyReference start{DocumentKey::Empty(), id};
-  DocumentKeyReference end{DocumentKey::Empty(), id + 1};
+bool ReferenceSet::AddId(const DocumentKey& key, int id) {
+  std::vector<int>& ids = by_key_[key];
+  if (std::find(ids.begin(), ids.end(), id) != ids.end()) {
+    return false;
+  }
+  ids.push_back(id);
+  size_++;
+  return true;
+}
 
-  DocumentKeySet keys;
-  for (const auto& reference : by_id_.values_in(start, end)) {
-    keys = keys.insert(reference.key());
+bool ReferenceSet::RemoveId(const DocumentKey& key, int id) {
+  auto found = by_key_.find(key);
+  if (found == by_key_.end()) return false;
+
+  std::vector<int>& ids = found->second;
+  auto id_it = std::find(ids.begin(), ids.end(), id);
+  if (id_it == ids.end()) return false;
+
+  // Order doesn't matter, so swap the last Id into the removed one's place.
+  *id_it = ids.back();
+  ids.pop_back();
+  if (ids.empty()) {
+    by_key_.erase(found);
   }
-  return keys;
+  size_--;
+  return true;
 }
 
-bool ReferenceSet::ContainsKey(const DocumentKey& key) {
-  // Create a reference with a zero ID as the start position to find any
-  // document reference with this key.
-  DocumentKeyReference start{key, 0};
+size_t ReferenceSet::EstimatedByteSize() const {
+  // Each node of a hash map holds its entry and a link to the next node, and
+  // each bucket a pointer to a node.
+  size_t size = sizeof(ReferenceSet);
+  size += by_key_.bucket_count() * sizeof(void*);
+  for (const auto& entry : by_key_) {
+    size +=
+        sizeof(entry) + sizeof(void*) + entry.second.capacity() * sizeof(int);
+  }
+  size += by_id_.bucket_count() * sizeof(void*);
+  for (const auto& entry : by_id_) {
+    size += sizeof(entry) + sizeof(void*);
+    size += entry.second.bucket_count() * sizeof(void*);
+    size += entry.second.size() * (sizeof(DocumentKey) + sizeof(void*));
+  }
+  return size;
+}
 
-  auto range = by_key_.values_from(start);
-  auto begin = range.begin();
-  return begin != range.end() && begin->key() == key;
+DocumentKeySet ReferenceSet::ToDocumentKeySet(const KeySet& keys) {
+  std::vector<DocumentKey> sorted{keys.begin(), keys.end()};
+  std::sort(sorted.begin(), sorted.end());
+  return DocumentKeySet{}.insert_all(sorted);
 }
 
 }  // namespace local
@@ -17,8 +17,11 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_REFERENCE_SET_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_REFERENCE_SET_H_
 
-#include "Firestore/core/src/firebase/firestore/immutable/sorted_set.h"
-#include "Firestore/core/src/firebase/firestore/local/document_key_reference.h"
+#include <cstddef>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 
@@ -31,25 +34,22 @@ namespace local {
  * (either a TargetId or BatchId). As references are added to or removed from
  * the set corresponding events are emitted to a registered garbage collector.
  *
- * Each reference is represented by a DocumentKeyReference object. Each of them
- * contains enough information to uniquely identify the reference. They are all
- * stored primarily in a set sorted by key. A document is considered garbage if
- * there's no references in that set (this can be efficiently checked thanks to
- * sorting by key).
- *
- * ReferenceSet also keeps a secondary set that contains references sorted by
- * Id. This one is used to efficiently implement removal of all references by
- * some TargetId.
+ * References are kept in a mutable, hash-based multimap from document key to
+ * Id, so that checking whether a document is garbage (has no references) is a
+ * single lookup. A second hash map from Id to document keys makes removal of
+ * all references by some TargetId proportional to the number of references
+ * removed. Neither map allocates on changes to keys or Ids that are already
+ * present, unlike the persistent sorted sets this class used to be built on.
  */
 class ReferenceSet {
  public:
   /** Returns true if the reference set contains no references. */
   bool empty() const {
-    return by_key_.empty();
+    return size_ == 0;
   }
 
   size_t size() const {
-    return by_key_.size();
+    return size_;
   }
 
   /** Adds a reference to the given document key for the given Id. */
@@ -80,12 +80,38 @@ class ReferenceSet {
    */
   bool ContainsKey(const model::DocumentKey& key);
 
+  /**
+   * Returns an estimate of the number of bytes of memory used by the set's
+   * hash maps. The paths of the keys are shared with the documents they refer
+   * to, so they aren't counted.
+   */
+  size_t EstimatedByteSize() const;
+
  private:
-  void RemoveReference(const DocumentKeyReference& reference);
+  using KeySet = std::unordered_set<model::DocumentKey, model::DocumentKeyHash>;
+
+  /** Adds `id` to the Ids referencing `key`, returning false if present. */
+  bool AddId(const model::DocumentKey& key, int id);
 
-  immutable::SortedSet<DocumentKeyReference, DocumentKeyReference::ByKey>
+  /** Removes `id` from the Ids referencing `key`, returning false if absent. */
+  bool RemoveId(const model::DocumentKey& key, int id);
+
+  /** Returns a sorted set of the given keys. */
+  static model::DocumentKeySet ToDocumentKeySet(const KeySet& keys);
+
+  /**
+   * The Ids referencing each document. A document is rarely referenced by more
+   * than a couple of Ids, so they're kept in a vector rather than a set.
+   */
+  std::unordered_map<model::DocumentKey,
+                     std::vector<int>,
+                     model::DocumentKeyHash>
       by_key_;
-  immutable::SortedSet<DocumentKeyReference, DocumentKeyReference::ById> by_id_;
+
+  /** The documents referenced by each Id. */
+  std::unordered_map<int, KeySet> by_id_;
+
+  size_t size_ = 0;
 };
 
 }  // namespace local
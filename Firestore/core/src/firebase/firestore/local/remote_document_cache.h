@@ -23,11 +23,19 @@
 
 #import <Foundation/Foundation.h>
 
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/local/field_index.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 
+@class FSTDocument;
 @class FSTMaybeDocument;
 @class FSTQuery;
 
@@ -37,6 +45,15 @@ namespace firebase {
 namespace firestore {
 namespace local {
 
+/**
+ * The position of a document in a field index: the encoded value of its
+ * entry, then its key.
+ */
+struct FieldIndexPosition {
+  std::string index_value;
+  model::DocumentKey document_key;
+};
+
 /**
  * Represents cached documents received from the remote backend.
  *
@@ -93,6 +110,98 @@ class RemoteDocumentCache {
    * @return The set of matching documents.
    */
   virtual model::DocumentMap GetMatching(FSTQuery* query) = 0;
+
+  /**
+   * Executes each of the given collection queries against the cached
+   * FSTDocument entries, as GetMatching does.
+   *
+   * Implementations may execute the queries concurrently, in which case they
+   * all see the same state of the cache.
+   *
+   * @param queries The collection queries to match documents against.
+   * @return The set of matching documents for each query, in the order of
+   *     `queries`.
+   */
+  virtual std::vector<model::DocumentMap> GetMatchingForQueries(
+      const std::vector<FSTQuery*>& queries) = 0;
+
+  /**
+   * Executes a query against the cached FSTDocument entries, using the given
+   * range of a field index to find candidate documents instead of scanning the
+   * whole collection.
+   *
+   * As with GetMatching, implementations may return extra documents, and
+   * implementations that don't maintain field indexes may ignore the range.
+   *
+   * @param query The query to match documents against. Must be a collection
+   *     query.
+   * @param range A range of a FieldIndex declared on the query's collection,
+   *     containing at least every document that matches the query.
+   * @return The set of matching documents.
+   */
+  virtual model::DocumentMap GetMatchingUsingIndex(
+      FSTQuery* query, const FieldIndexRange& range) = 0;
+
+  /**
+   * Calls `callback` with each of the FSTDocument entries that GetMatching
+   * would return, without collecting them. Implementations that decode
+   * documents read them one at a time, so consumers that look at each
+   * document only once don't keep the whole collection in memory.
+   */
+  virtual void ForEachMatching(
+      FSTQuery* query, const std::function<void(FSTDocument*)>& callback) = 0;
+
+  /**
+   * Calls `callback` with each of the FSTDocument entries that
+   * GetMatchingUsingIndex would return, without collecting them.
+   */
+  virtual void ForEachMatchingUsingIndex(
+      FSTQuery* query,
+      const FieldIndexRange& range,
+      const std::function<void(FSTDocument*)>& callback) = 0;
+
+  /**
+   * Calls `callback` with the FSTDocument entries in the collection queried by
+   * `query` in key order, starting after `start_after` if given, until
+   * `callback` returns false. Unlike ForEachMatching, the documents aren't
+   * matched against the query, and a scan that stops early doesn't read the
+   * rest of the collection.
+   *
+   * @param query A collection query.
+   */
+  virtual void ForEachInKeyOrder(
+      FSTQuery* query,
+      const absl::optional<model::DocumentKey>& start_after,
+      const std::function<bool(FSTDocument*)>& callback) = 0;
+
+  /**
+   * Calls `callback` with the encoded index value and contents of the
+   * FSTDocument entries in `range` in index order (by encoded value, then by
+   * key), starting after `start_after` if given, until `callback` returns
+   * false. As with ForEachInKeyOrder, the documents aren't matched against the
+   * query.
+   *
+   * @param query A collection query.
+   * @param range A range of a value index declared on the query's collection.
+   */
+  virtual void ForEachInIndexOrder(
+      FSTQuery* query,
+      const FieldIndexRange& range,
+      const absl::optional<FieldIndexPosition>& start_after,
+      const std::function<bool(absl::string_view, FSTDocument*)>& callback) = 0;
+
+  /**
+   * Writes entries for the given newly declared field index for all documents
+   * that are already cached. Implementations that don't maintain field
+   * indexes may ignore this.
+   */
+  virtual void BackfillFieldIndex(const FieldIndex& index) = 0;
+
+  /**
+   * Returns an estimate of the number of bytes of memory used by the cached
+   * documents, or 0 if they aren't held in memory.
+   */
+  virtual size_t EstimatedMemoryUsage() = 0;
 };
 
 }  // namespace local
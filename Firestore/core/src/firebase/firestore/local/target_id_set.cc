@@ -0,0 +1,426 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/target_id_set.h"
+
+#include <algorithm>
+#include <bitset>
+#include <iterator>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using model::TargetId;
+
+namespace {
+
+uint16_t High(TargetId target_id) {
+  return static_cast<uint16_t>(static_cast<uint32_t>(target_id) >> 16);
+}
+
+uint16_t Low(TargetId target_id) {
+  return static_cast<uint16_t>(static_cast<uint32_t>(target_id) & 0xffff);
+}
+
+TargetId Combine(uint16_t high, uint16_t low) {
+  return static_cast<TargetId>((static_cast<uint32_t>(high) << 16) | low);
+}
+
+bool TestBit(const std::vector<uint64_t>& bitmap, uint16_t low) {
+  return (bitmap[low / 64] >> (low % 64)) & 1;
+}
+
+/** Appends the values whose bits are set in `bitmap`, in increasing order. */
+void AppendSetBits(const std::vector<uint64_t>& bitmap,
+                   std::vector<uint16_t>* values) {
+  for (size_t word = 0; word < bitmap.size(); ++word) {
+    if (bitmap[word] == 0) continue;
+    for (size_t bit = 0; bit < 64; ++bit) {
+      if ((bitmap[word] >> bit) & 1) {
+        values->push_back(static_cast<uint16_t>(word * 64 + bit));
+      }
+    }
+  }
+}
+
+size_t CountBits(const std::vector<uint64_t>& bitmap) {
+  size_t count = 0;
+  for (uint64_t word : bitmap) {
+    count += std::bitset<64>(word).count();
+  }
+  return count;
+}
+
+void WriteVarint(std::string* dest, size_t value) {
+  while (value >= 0x80) {
+    dest->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  dest->push_back(static_cast<char>(value));
+}
+
+/** Returns the first of `containers` whose upper bits are at least `high`. */
+template <typename Iterator>
+Iterator LowerBound(Iterator begin, Iterator end, uint16_t high) {
+  return std::lower_bound(begin, end, high,
+                          [](decltype(*begin) container, uint16_t value) {
+                            return container.high < value;
+                          });
+}
+
+bool ReadVarint(absl::string_view* src, size_t* value) {
+  *value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (src->empty()) {
+      return false;
+    }
+    auto byte = static_cast<unsigned char>(src->front());
+    src->remove_prefix(1);
+    *value |= static_cast<size_t>(byte & 0x7f) << shift;
+    if (byte < 0x80) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+constexpr size_t TargetIdSet::kMaxArraySize;
+constexpr size_t TargetIdSet::kBitmapWords;
+
+// TargetIdSet::Container
+
+bool TargetIdSet::Container::contains(uint16_t low) const {
+  if (is_bitmap()) {
+    return TestBit(bitmap, low);
+  }
+  return std::binary_search(array.begin(), array.end(), low);
+}
+
+void TargetIdSet::Container::Normalize() {
+  if (is_bitmap() && cardinality <= kMaxArraySize) {
+    array.clear();
+    array.reserve(cardinality);
+    AppendSetBits(bitmap, &array);
+    bitmap.clear();
+    bitmap.shrink_to_fit();
+
+  } else if (!is_bitmap() && cardinality > kMaxArraySize) {
+    bitmap.assign(kBitmapWords, 0);
+    for (uint16_t low : array) {
+      bitmap[low / 64] |= uint64_t{1} << (low % 64);
+    }
+    array.clear();
+    array.shrink_to_fit();
+  }
+}
+
+// TargetIdSet
+
+size_t TargetIdSet::size() const {
+  size_t result = 0;
+  for (const Container& container : containers_) {
+    result += container.cardinality;
+  }
+  return result;
+}
+
+const TargetIdSet::Container* TargetIdSet::Find(uint16_t high) const {
+  auto found = LowerBound(containers_.begin(), containers_.end(), high);
+  if (found == containers_.end() || found->high != high) {
+    return nullptr;
+  }
+  return &*found;
+}
+
+bool TargetIdSet::contains(TargetId target_id) const {
+  const Container* container = Find(High(target_id));
+  return container && container->contains(Low(target_id));
+}
+
+bool TargetIdSet::insert(TargetId target_id) {
+  HARD_ASSERT(target_id >= 0, "Target ID %s can't be stored in a TargetIdSet",
+              target_id);
+  uint16_t high = High(target_id);
+  uint16_t low = Low(target_id);
+
+  auto container = LowerBound(containers_.begin(), containers_.end(), high);
+  if (container == containers_.end() || container->high != high) {
+    container = containers_.insert(container, Container{});
+    container->high = high;
+  }
+
+  if (container->is_bitmap()) {
+    uint64_t& word = container->bitmap[low / 64];
+    uint64_t bit = uint64_t{1} << (low % 64);
+    if (word & bit) {
+      return false;
+    }
+    word |= bit;
+  } else {
+    auto pos =
+        std::lower_bound(container->array.begin(), container->array.end(), low);
+    if (pos != container->array.end() && *pos == low) {
+      return false;
+    }
+    container->array.insert(pos, low);
+  }
+  container->cardinality++;
+  container->Normalize();
+  return true;
+}
+
+bool TargetIdSet::erase(TargetId target_id) {
+  uint16_t high = High(target_id);
+  uint16_t low = Low(target_id);
+
+  auto container = LowerBound(containers_.begin(), containers_.end(), high);
+  if (target_id < 0 || container == containers_.end() ||
+      container->high != high) {
+    return false;
+  }
+
+  if (container->is_bitmap()) {
+    uint64_t& word = container->bitmap[low / 64];
+    uint64_t bit = uint64_t{1} << (low % 64);
+    if (!(word & bit)) {
+      return false;
+    }
+    word &= ~bit;
+  } else {
+    auto pos =
+        std::lower_bound(container->array.begin(), container->array.end(), low);
+    if (pos == container->array.end() || *pos != low) {
+      return false;
+    }
+    container->array.erase(pos);
+  }
+  container->cardinality--;
+
+  if (container->cardinality == 0) {
+    containers_.erase(container);
+  } else {
+    container->Normalize();
+  }
+  return true;
+}
+
+std::vector<TargetId> TargetIdSet::ToVector() const {
+  std::vector<TargetId> result;
+  result.reserve(size());
+  for (const Container& container : containers_) {
+    std::vector<uint16_t> bitmap_values;
+    if (container.is_bitmap()) {
+      AppendSetBits(container.bitmap, &bitmap_values);
+    }
+    const std::vector<uint16_t>& values =
+        container.is_bitmap() ? bitmap_values : container.array;
+    for (uint16_t low : values) {
+      result.push_back(Combine(container.high, low));
+    }
+  }
+  return result;
+}
+
+TargetIdSet::Container TargetIdSet::UnionOf(const Container& lhs,
+                                            const Container& rhs) {
+  Container result;
+  result.high = lhs.high;
+  if (!lhs.is_bitmap() && !rhs.is_bitmap()) {
+    result.array.reserve(lhs.cardinality + rhs.cardinality);
+    std::set_union(lhs.array.begin(), lhs.array.end(), rhs.array.begin(),
+                   rhs.array.end(), std::back_inserter(result.array));
+    result.cardinality = result.array.size();
+    result.Normalize();
+    return result;
+  }
+
+  // At least one side has more than kMaxArraySize IDs, so the union does too.
+  const Container& bitmap_side = lhs.is_bitmap() ? lhs : rhs;
+  const Container& other_side = lhs.is_bitmap() ? rhs : lhs;
+  result.bitmap = bitmap_side.bitmap;
+  if (other_side.is_bitmap()) {
+    for (size_t i = 0; i < kBitmapWords; ++i) {
+      result.bitmap[i] |= other_side.bitmap[i];
+    }
+  } else {
+    for (uint16_t low : other_side.array) {
+      result.bitmap[low / 64] |= uint64_t{1} << (low % 64);
+    }
+  }
+  result.cardinality = CountBits(result.bitmap);
+  return result;
+}
+
+TargetIdSet::Container TargetIdSet::DifferenceOf(const Container& lhs,
+                                                 const Container& rhs) {
+  Container result;
+  result.high = lhs.high;
+  if (!lhs.is_bitmap()) {
+    for (uint16_t low : lhs.array) {
+      if (!rhs.contains(low)) {
+        result.array.push_back(low);
+      }
+    }
+    result.cardinality = result.array.size();
+    return result;
+  }
+
+  result.bitmap = lhs.bitmap;
+  if (rhs.is_bitmap()) {
+    for (size_t i = 0; i < kBitmapWords; ++i) {
+      result.bitmap[i] &= ~rhs.bitmap[i];
+    }
+  } else {
+    for (uint16_t low : rhs.array) {
+      result.bitmap[low / 64] &= ~(uint64_t{1} << (low % 64));
+    }
+  }
+  result.cardinality = CountBits(result.bitmap);
+  result.Normalize();
+  return result;
+}
+
+TargetIdSet TargetIdSet::Union(const TargetIdSet& lhs, const TargetIdSet& rhs) {
+  if (lhs.empty()) return rhs;
+  if (rhs.empty()) return lhs;
+
+  TargetIdSet result;
+  auto left = lhs.containers_.begin();
+  auto right = rhs.containers_.begin();
+  while (left != lhs.containers_.end() && right != rhs.containers_.end()) {
+    if (left->high < right->high) {
+      result.containers_.push_back(*left++);
+    } else if (right->high < left->high) {
+      result.containers_.push_back(*right++);
+    } else {
+      result.containers_.push_back(UnionOf(*left++, *right++));
+    }
+  }
+  result.containers_.insert(result.containers_.end(), left,
+                            lhs.containers_.end());
+  result.containers_.insert(result.containers_.end(), right,
+                            rhs.containers_.end());
+  return result;
+}
+
+TargetIdSet TargetIdSet::Difference(const TargetIdSet& lhs,
+                                    const TargetIdSet& rhs) {
+  if (lhs.empty() || rhs.empty()) return lhs;
+
+  TargetIdSet result;
+  for (const Container& container : lhs.containers_) {
+    const Container* other = rhs.Find(container.high);
+    if (!other) {
+      result.containers_.push_back(container);
+      continue;
+    }
+    Container difference = DifferenceOf(container, *other);
+    if (difference.cardinality != 0) {
+      result.containers_.push_back(std::move(difference));
+    }
+  }
+  return result;
+}
+
+std::string TargetIdSet::Encode() const {
+  std::string result;
+  WriteVarint(&result, containers_.size());
+  for (const Container& container : containers_) {
+    WriteVarint(&result, container.high);
+    WriteVarint(&result, container.cardinality);
+    if (container.is_bitmap()) {
+      for (uint64_t word : container.bitmap) {
+        for (int byte = 0; byte < 8; ++byte) {
+          result.push_back(static_cast<char>((word >> (byte * 8)) & 0xff));
+        }
+      }
+    } else {
+      uint16_t previous = 0;
+      for (uint16_t low : container.array) {
+        WriteVarint(&result, low - previous);
+        previous = low;
+      }
+    }
+  }
+  return result;
+}
+
+bool TargetIdSet::Decode(absl::string_view encoded) {
+  containers_.clear();
+
+  size_t count = 0;
+  if (!ReadVarint(&encoded, &count)) {
+    return false;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    size_t high = 0;
+    size_t cardinality = 0;
+    if (!ReadVarint(&encoded, &high) || !ReadVarint(&encoded, &cardinality) ||
+        high > 0x7fff || cardinality == 0 || cardinality > (1 << 16) ||
+        (!containers_.empty() && high <= containers_.back().high)) {
+      return false;
+    }
+
+    Container container;
+    container.high = static_cast<uint16_t>(high);
+    container.cardinality = cardinality;
+    if (cardinality > kMaxArraySize) {
+      if (encoded.size() < kBitmapWords * 8) {
+        return false;
+      }
+      container.bitmap.assign(kBitmapWords, 0);
+      for (size_t word = 0; word < kBitmapWords; ++word) {
+        for (int byte = 0; byte < 8; ++byte) {
+          auto value = static_cast<unsigned char>(encoded[word * 8 + byte]);
+          container.bitmap[word] |= static_cast<uint64_t>(value) << (byte * 8);
+        }
+      }
+      encoded.remove_prefix(kBitmapWords * 8);
+      if (CountBits(container.bitmap) != cardinality) {
+        return false;
+      }
+    } else {
+      container.array.reserve(cardinality);
+      size_t low = 0;
+      for (size_t j = 0; j < cardinality; ++j) {
+        size_t delta = 0;
+        // Only the first value may repeat the (zero) previous one.
+        if (!ReadVarint(&encoded, &delta) || (j > 0 && delta == 0) ||
+            delta > 0xffff - low) {
+          return false;
+        }
+        low += delta;
+        container.array.push_back(static_cast<uint16_t>(low));
+      }
+    }
+    containers_.push_back(std::move(container));
+  }
+  return encoded.empty();
+}
+
+bool operator==(const TargetIdSet& lhs, const TargetIdSet& rhs) {
+  return lhs.containers_ == rhs.containers_;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_TARGET_ID_SET_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_TARGET_ID_SET_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "absl/base/attributes.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * A set of target IDs, kept as a roaring bitmap: the IDs are split by their
+ * upper 16 bits into containers, each of which holds the lower 16 bits of its
+ * IDs either as a sorted array or, once it has more than `kMaxArraySize` of
+ * them, as a bitmap of all 65536 values.
+ *
+ * The targets that persist documents get dense IDs from TargetIdGenerator, so
+ * the IDs referencing one document fall into a handful of containers and the
+ * set stays small however many targets there are. `Encode()` writes the set
+ * into the compact form the document_target_set table stores for each
+ * document.
+ *
+ * Only non-negative IDs can be stored, which is all that the query cache
+ * assigns.
+ */
+class TargetIdSet {
+ public:
+  /** The most IDs a container keeps as an array rather than a bitmap. */
+  static constexpr size_t kMaxArraySize = 4096;
+
+  bool empty() const {
+    return containers_.empty();
+  }
+
+  size_t size() const;
+
+  bool contains(model::TargetId target_id) const;
+
+  /** Adds the given ID, returning false if it was already in the set. */
+  bool insert(model::TargetId target_id);
+
+  /** Removes the given ID, returning false if it wasn't in the set. */
+  bool erase(model::TargetId target_id);
+
+  /** Returns the IDs in the set, in increasing order. */
+  std::vector<model::TargetId> ToVector() const;
+
+  /** Returns the IDs that are in either of the given sets. */
+  static TargetIdSet Union(const TargetIdSet& lhs, const TargetIdSet& rhs);
+
+  /** Returns the IDs of `lhs` that aren't in `rhs`. */
+  static TargetIdSet Difference(const TargetIdSet& lhs,
+                                const TargetIdSet& rhs);
+
+  /**
+   * Encodes the set as the number of containers, followed by each container's
+   * upper 16 bits and number of IDs, as varints, and then its contents: the
+   * differences between successive lower 16 bits as varints for an array, or
+   * the 8 KiB of a bitmap. Equal sets are always encoded into the same bytes.
+   */
+  std::string Encode() const;
+
+  /**
+   * Replaces the contents of this set with the set encoded in `encoded`.
+   *
+   * @return true if the set successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view encoded);
+
+  friend bool operator==(const TargetIdSet& lhs, const TargetIdSet& rhs);
+
+ private:
+  static constexpr size_t kBitmapWords = (1 << 16) / 64;
+
+  /** The IDs sharing the same upper 16 bits. */
+  struct Container {
+    bool is_bitmap() const {
+      return !bitmap.empty();
+    }
+
+    bool contains(uint16_t low) const;
+
+    /** Switches between an array and a bitmap to suit `cardinality`. */
+    void Normalize();
+
+    friend bool operator==(const Container& lhs, const Container& rhs) {
+      return lhs.high == rhs.high && lhs.cardinality == rhs.cardinality &&
+             lhs.array == rhs.array && lhs.bitmap == rhs.bitmap;
+    }
+
+    uint16_t high = 0;
+    size_t cardinality = 0;
+
+    /** The sorted lower 16 bits, if `cardinality <= kMaxArraySize`. */
+    std::vector<uint16_t> array;
+
+    /** Otherwise, `kBitmapWords` words with a bit set for each ID. */
+    std::vector<uint64_t> bitmap;
+  };
+
+  /** Returns the container for `high`, or nullptr if there is none. */
+  const Container* Find(uint16_t high) const;
+
+  static Container UnionOf(const Container& lhs, const Container& rhs);
+  static Container DifferenceOf(const Container& lhs, const Container& rhs);
+
+  /** The containers, ordered by `high`. None of them is empty. */
+  std::vector<Container> containers_;
+};
+
+inline bool operator!=(const TargetIdSet& lhs, const TargetIdSet& rhs) {
+  return !(lhs == rhs);
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_TARGET_ID_SET_H_
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/value_compression.h"
+
+#include <zlib.h>
+
+#include <cstdint>
+
+#include "Firestore/core/src/firebase/firestore/nanopb/wire_reader.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/wire_writer.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+using nanopb::WireReader;
+using nanopb::WireWriter;
+
+/**
+ * The first byte of a compressed value. Like all bytes below 0x08, it would be
+ * a tag with field number 0, which is invalid, so no serialized proto starts
+ * with it. (The compact documents of FieldNameDictionary use 0x00.)
+ */
+const char kCompressedMarker = '\x01';
+
+/**
+ * The most that deflate can compress data by; any stored value that claims a
+ * larger ratio is corrupt.
+ */
+const uint64_t kMaxCompressionRatio = 1032;
+
+/** Negative window bits select a raw deflate stream, without a zlib header. */
+const int kWindowBits = -15;
+const int kMemoryLevel = 8;
+
+}  // namespace
+
+bool IsCompressedValue(absl::string_view stored) {
+  return !stored.empty() && stored.front() == kCompressedMarker;
+}
+
+absl::optional<std::string> CompressValue(absl::string_view value) {
+  z_stream stream{};
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, kWindowBits,
+                   kMemoryLevel, Z_DEFAULT_STRATEGY) != Z_OK) {
+    return absl::nullopt;
+  }
+
+  std::string result;
+  result.push_back(kCompressedMarker);
+  WireWriter{&result}.WriteVarint(value.size());
+  size_t header_size = result.size();
+
+  // Only results smaller than the original are worth it, so that's all the
+  // room deflate gets.
+  if (header_size + 1 >= value.size()) {
+    deflateEnd(&stream);
+    return absl::nullopt;
+  }
+  result.resize(value.size() - 1);
+
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(value.data()));
+  stream.avail_in = static_cast<uInt>(value.size());
+  stream.next_out = reinterpret_cast<Bytef*>(&result[header_size]);
+  stream.avail_out = static_cast<uInt>(result.size() - header_size);
+
+  int status = deflate(&stream, Z_FINISH);
+  size_t compressed_size = stream.total_out;
+  deflateEnd(&stream);
+
+  // Z_OK or Z_BUF_ERROR mean the output ran out of room.
+  if (status != Z_STREAM_END) {
+    return absl::nullopt;
+  }
+
+  result.resize(header_size + compressed_size);
+  return result;
+}
+
+absl::optional<std::string> UncompressValue(absl::string_view stored) {
+  if (!IsCompressedValue(stored)) {
+    return absl::nullopt;
+  }
+  stored.remove_prefix(1);
+
+  WireReader reader{stored};
+  uint64_t size = reader.ReadVarint();
+  absl::string_view compressed = reader.remaining();
+  if (!reader.ok() || size > compressed.size() * kMaxCompressionRatio) {
+    return absl::nullopt;
+  }
+
+  z_stream stream{};
+  if (inflateInit2(&stream, kWindowBits) != Z_OK) {
+    return absl::nullopt;
+  }
+
+  std::string result(static_cast<size_t>(size), '\0');
+  stream.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+  stream.avail_in = static_cast<uInt>(compressed.size());
+  stream.next_out = reinterpret_cast<Bytef*>(&result[0]);
+  stream.avail_out = static_cast<uInt>(result.size());
+
+  int status = inflate(&stream, Z_FINISH);
+  bool complete = status == Z_STREAM_END && stream.total_out == size &&
+                  stream.avail_in == 0;
+  inflateEnd(&stream);
+
+  if (!complete) {
+    return absl::nullopt;
+  }
+  return result;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
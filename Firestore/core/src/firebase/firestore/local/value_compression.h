@@ -0,0 +1,55 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_VALUE_COMPRESSION_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_VALUE_COMPRESSION_H_
+
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Whether the given stored value was produced by `CompressValue()`, rather
+ * than being a plain serialized proto.
+ *
+ * Compressed values start with a byte that no serialized proto can start with;
+ * the format is a marker, the varint size of the original value, and the
+ * original value as a raw deflate stream.
+ */
+bool IsCompressedValue(absl::string_view stored);
+
+/**
+ * Compresses a value for storage, or returns absl::nullopt if compression
+ * wouldn't make it any smaller, in which case it should be stored as is.
+ */
+absl::optional<std::string> CompressValue(absl::string_view value);
+
+/**
+ * Gives back the original value of a stored value that `IsCompressedValue()`,
+ * or absl::nullopt if the stored value is corrupt.
+ */
+absl::optional<std::string> UncompressValue(absl::string_view stored);
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_VALUE_COMPRESSION_H_
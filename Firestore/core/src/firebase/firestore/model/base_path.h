@@ -20,12 +20,14 @@
 #include <algorithm>
 #include <cctype>
 #include <initializer_list>
+#include <memory>
 #include <string>
 #include <utility>
-#include <vector>
 
+#include "Firestore/core/src/firebase/firestore/util/comparison.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/hashing.h"
+#include "absl/container/inlined_vector.h"
 
 namespace firebase {
 namespace firestore {
@@ -39,6 +41,22 @@ namespace impl {
  * BasePath is reassignable and movable. Apart from those, all other mutating
  * operations return new independent instances.
  *
+ * Segments are immutable once a path has been created, so copies of a path
+ * and paths derived from it by dropping segments (`PopFirst`, `PopLast`) share
+ * the same storage instead of copying every segment. Comparisons between paths
+ * that share storage don't need to look at the segments at all.
+ *
+ * A derived path keeps all of the storage alive, including the segments it
+ * dropped. To bound that, a derived path only shares the storage if it keeps at
+ * least half of its segments; a shorter one, like the first segment of a long
+ * path, copies its segments instead. A path therefore never holds on to more
+ * than twice the segments it uses.
+ *
+ * The storage keeps up to `kInlineSegments` segments inline, which covers
+ * nearly all document and field paths, so creating a path makes a single
+ * allocation for the storage plus one for each segment too long for the
+ * small string optimization.
+ *
  * ## Subclassing Notes
  *
  * BasePath is strictly meant as a base class for concrete implementations. It
@@ -49,41 +67,41 @@ namespace impl {
  */
 template <typename T>
 class BasePath {
- protected:
-  using SegmentsT = std::vector<std::string>;
-
  public:
-  using const_iterator = SegmentsT::const_iterator;
+  static constexpr size_t kInlineSegments = 6;
+
+  using SegmentsT = absl::InlinedVector<std::string, kInlineSegments>;
+  using const_iterator = typename SegmentsT::const_iterator;
 
   /** Returns i-th segment of the path. */
   const std::string& operator[](const size_t i) const {
-    HARD_ASSERT(i < segments_.size(), "index %s out of range", i);
-    return segments_[i];
+    HARD_ASSERT(i < size_, "index %s out of range", i);
+    return begin()[i];
   }
 
   /** Returns the first segment of the path. */
   const std::string& first_segment() const {
     HARD_ASSERT(!empty(), "Cannot call first_segment on empty path");
-    return segments_[0];
+    return begin()[0];
   }
   /** Returns the last segment of the path. */
   const std::string& last_segment() const {
     HARD_ASSERT(!empty(), "Cannot call last_segment on empty path");
-    return segments_[size() - 1];
+    return begin()[size_ - 1];
   }
 
   size_t size() const {
-    return segments_.size();
+    return size_;
   }
   bool empty() const {
-    return segments_.empty();
+    return size_ == 0;
   }
 
   const_iterator begin() const {
-    return segments_.begin();
+    return storage().begin() + offset_;
   }
   const_iterator end() const {
-    return segments_.end();
+    return begin() + size_;
   }
 
   /**
@@ -91,14 +109,14 @@ class BasePath {
    * additional segment.
    */
   T Append(const std::string& segment) const {
-    auto appended = segments_;
-    appended.push_back(segment);
-    return T{std::move(appended)};
+    std::shared_ptr<SegmentsT> appended = CopySegments(1);
+    appended->push_back(segment);
+    return WithStorage(std::move(appended));
   }
   T Append(std::string&& segment) const {
-    auto appended = segments_;
-    appended.push_back(std::move(segment));
-    return T{std::move(appended)};
+    std::shared_ptr<SegmentsT> appended = CopySegments(1);
+    appended->push_back(std::move(segment));
+    return WithStorage(std::move(appended));
   }
 
   /**
@@ -106,9 +124,9 @@ class BasePath {
    * another path.
    */
   T Append(const T& path) const {
-    auto appended = segments_;
-    appended.insert(appended.end(), path.begin(), path.end());
-    return T{std::move(appended)};
+    std::shared_ptr<SegmentsT> appended = CopySegments(path.size());
+    appended->insert(appended->end(), path.begin(), path.end());
+    return WithStorage(std::move(appended));
   }
 
   /**
@@ -118,7 +136,7 @@ class BasePath {
   T PopFirst(const size_t n = 1) const {
     HARD_ASSERT(n <= size(), "Cannot call PopFirst(%s) on path of length %s", n,
                 size());
-    return T{begin() + n, end()};
+    return Slice(offset_ + n, size_ - n);
   }
 
   /**
@@ -127,7 +145,7 @@ class BasePath {
    */
   T PopLast() const {
     HARD_ASSERT(!empty(), "Cannot call PopLast() on empty path");
-    return T{begin(), end() - 1};
+    return Slice(offset_, size_ - 1);
   }
 
   /**
@@ -136,7 +154,7 @@ class BasePath {
    * Empty path is a prefix of any path. Any path is a prefix of itself.
    */
   bool IsPrefixOf(const T& rhs) const {
-    return size() <= rhs.size() && std::equal(begin(), end(), rhs.begin());
+    return size() <= rhs.size() && SharesPrefixWith(rhs);
   }
 
   /**
@@ -146,40 +164,155 @@ class BasePath {
    */
   bool IsImmediateParentOf(const T& potential_child) const {
     return size() + 1 == potential_child.size() &&
-           std::equal(begin(), end(), potential_child.begin());
+           SharesPrefixWith(potential_child);
   }
 
   bool operator==(const BasePath& rhs) const {
-    return segments_ == rhs.segments_;
+    return size_ == rhs.size_ && SharesPrefixWith(rhs);
   }
   bool operator!=(const BasePath& rhs) const {
-    return segments_ != rhs.segments_;
+    return !(*this == rhs);
   }
+
+  /**
+   * Compares this path with `rhs` segment by segment. Unlike a lexicographical
+   * compare built on `operator<`, each pair of segments is compared once.
+   */
+  util::ComparisonResult CompareTo(const BasePath& rhs) const {
+    size_t common = std::min(size_, rhs.size_);
+    if (segments_ != rhs.segments_ || offset_ != rhs.offset_) {
+      const_iterator left = begin();
+      const_iterator right = rhs.begin();
+      for (size_t i = 0; i < common; ++i) {
+        int cmp = left[i].compare(right[i]);
+        if (cmp != 0) {
+          return util::ComparisonResultFromInt(cmp);
+        }
+      }
+    }
+    if (size_ != rhs.size_) {
+      return size_ < rhs.size_ ? util::ComparisonResult::Ascending
+                               : util::ComparisonResult::Descending;
+    }
+    return util::ComparisonResult::Same;
+  }
+
   bool operator<(const BasePath& rhs) const {
-    return segments_ < rhs.segments_;
+    return CompareTo(rhs) == util::ComparisonResult::Ascending;
   }
   bool operator>(const BasePath& rhs) const {
-    return segments_ > rhs.segments_;
+    return CompareTo(rhs) == util::ComparisonResult::Descending;
   }
   bool operator<=(const BasePath& rhs) const {
-    return segments_ <= rhs.segments_;
+    return CompareTo(rhs) != util::ComparisonResult::Descending;
   }
   bool operator>=(const BasePath& rhs) const {
-    return segments_ >= rhs.segments_;
+    return CompareTo(rhs) != util::ComparisonResult::Ascending;
   }
 
  protected:
   BasePath() = default;
+  BasePath(const BasePath& other) = default;
+  BasePath(BasePath&& other) noexcept
+      : segments_{std::move(other.segments_)},
+        offset_{other.offset_},
+        size_{other.size_} {
+    other.offset_ = 0;
+    other.size_ = 0;
+  }
+  BasePath& operator=(const BasePath& other) = default;
+  BasePath& operator=(BasePath&& other) noexcept {
+    segments_ = std::move(other.segments_);
+    offset_ = other.offset_;
+    size_ = other.size_;
+    other.offset_ = 0;
+    other.size_ = 0;
+    return *this;
+  }
+
   template <typename IterT>
-  BasePath(const IterT begin, const IterT end) : segments_{begin, end} {
+  BasePath(const IterT begin, const IterT end)
+      : BasePath{SegmentsT{begin, end}} {
   }
-  BasePath(std::initializer_list<std::string> list) : segments_{list} {
+  BasePath(std::initializer_list<std::string> list)
+      : BasePath{SegmentsT{list}} {
   }
-  explicit BasePath(SegmentsT&& segments) : segments_{std::move(segments)} {
+  explicit BasePath(SegmentsT&& segments) : size_{segments.size()} {
+    if (!segments.empty()) {
+      segments_ = std::make_shared<const SegmentsT>(std::move(segments));
+    }
   }
 
  private:
-  SegmentsT segments_;
+  static const SegmentsT& EmptySegments() {
+    static const SegmentsT* empty = new SegmentsT{};
+    return *empty;
+  }
+
+  const SegmentsT& storage() const {
+    return segments_ ? *segments_ : EmptySegments();
+  }
+
+  /**
+   * Returns true if the first `size()` segments of `rhs` equal this path,
+   * which must be no longer than `rhs`.
+   */
+  bool SharesPrefixWith(const BasePath& rhs) const {
+    if (segments_ == rhs.segments_ && offset_ == rhs.offset_) {
+      return true;
+    }
+    return std::equal(begin(), end(), rhs.begin());
+  }
+
+  /**
+   * Copies the segments of this path into new storage, reserving room for
+   * `extra` more.
+   */
+  std::shared_ptr<SegmentsT> CopySegments(size_t extra) const {
+    auto result = std::make_shared<SegmentsT>();
+    result->reserve(size_ + extra);
+    result->insert(result->end(), begin(), end());
+    return result;
+  }
+
+  /** Returns a path viewing all of the given storage. */
+  static T WithStorage(std::shared_ptr<const SegmentsT> storage) {
+    T result;
+    BasePath& base = result;
+    if (!storage->empty()) {
+      base.size_ = storage->size();
+      base.segments_ = std::move(storage);
+    }
+    return result;
+  }
+
+  /**
+   * Returns a path of the `size` segments of this path's storage starting at
+   * `offset`. It views the storage, unless that would keep less than half of
+   * it in use, in which case it gets a copy of its segments.
+   */
+  T Slice(size_t offset, size_t size) const {
+    T result;
+    if (size == 0) {
+      return result;
+    }
+
+    auto first = storage().begin() + offset;
+    if (size * 2 < storage().size()) {
+      return WithStorage(std::make_shared<SegmentsT>(first, first + size));
+    }
+
+    BasePath& base = result;
+    base.segments_ = segments_;
+    base.offset_ = offset;
+    base.size_ = size;
+    return result;
+  }
+
+  // Null for empty paths, which then don't need to allocate.
+  std::shared_ptr<const SegmentsT> segments_;
+  size_t offset_ = 0;
+  size_t size_ = 0;
 };
 
 }  // namespace impl
@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 
+#include <string>
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
@@ -34,12 +35,13 @@ void AssertValidPath(const ResourcePath& path) {
 }  // namespace
 
 DocumentKey::DocumentKey(const ResourcePath& path)
-    : path_{std::make_shared<ResourcePath>(path)} {
+    : path_{std::make_shared<ResourcePath>(path)}, hash_{HashPath(*path_)} {
   AssertValidPath(*path_);
 }
 
 DocumentKey::DocumentKey(ResourcePath&& path)
-    : path_{std::make_shared<ResourcePath>(std::move(path))} {
+    : path_{std::make_shared<ResourcePath>(std::move(path))},
+      hash_{HashPath(*path_)} {
   AssertValidPath(*path_);
 }
 
@@ -48,6 +50,22 @@ const DocumentKey& DocumentKey::Empty() {
   return empty;
 }
 
+size_t DocumentKey::EstimatedPathByteSize() const {
+  size_t size = sizeof(ResourcePath);
+  for (const std::string& segment : path()) {
+    size += sizeof(std::string) + segment.size();
+  }
+  return size;
+}
+
+size_t DocumentKey::HashPath(const ResourcePath& path) {
+  util::Hasher hasher;
+  for (const std::string& segment : path) {
+    hasher.AddBytes(segment);
+  }
+  return static_cast<size_t>(hasher.value());
+}
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
@@ -41,7 +41,8 @@ namespace model {
 class DocumentKey {
  public:
   /** Creates a "blank" document key not associated with any document. */
-  DocumentKey() : path_{std::make_shared<ResourcePath>()} {
+  DocumentKey()
+      : path_{std::make_shared<ResourcePath>()}, hash_{HashPath(*path_)} {
   }
 
   /** Creates a new document key containing a copy of the given path. */
@@ -50,11 +51,19 @@ class DocumentKey {
   /** Creates a new document key, taking ownership of the given path. */
   explicit DocumentKey(ResourcePath&& path);
 
-#if defined(__OBJC__)
-  NSUInteger Hash() const {
-    return util::Hash(ToString());
+  /**
+   * Returns a hash of the path, which is computed once when the key is created
+   * so that hash tables of keys don't rehash paths segment by segment.
+   */
+  size_t Hash() const {
+    return path_ ? hash_ : Empty().hash_;
   }
-#endif  // defined(__OBJC__)
+
+  /**
+   * Returns an estimate of the number of bytes of memory used by the key's
+   * path, which all copies of the key share.
+   */
+  size_t EstimatedPathByteSize() const;
 
   std::string ToString() const {
     return path().CanonicalString();
@@ -93,9 +102,12 @@ class DocumentKey {
   }
 
  private:
+  static size_t HashPath(const ResourcePath& path);
+
   // This is an optimization to make passing DocumentKey around cheaper (it's
   // copied often).
   std::shared_ptr<const ResourcePath> path_;
+  size_t hash_ = 0;
 };
 
 inline bool operator==(const DocumentKey& lhs, const DocumentKey& rhs) {
@@ -119,20 +131,14 @@ inline bool operator>=(const DocumentKey& lhs, const DocumentKey& rhs) {
 
 struct DocumentKeyHash {
   size_t operator()(const DocumentKey& key) const {
-    return util::Hash(key.path());
+    return key.Hash();
   }
 };
 
 #if defined(__OBJC__)
 inline NSComparisonResult CompareKeys(const DocumentKey& lhs,
                                       const DocumentKey& rhs) {
-  if (lhs < rhs) {
-    return NSOrderedAscending;
-  }
-  if (lhs > rhs) {
-    return NSOrderedDescending;
-  }
-  return NSOrderedSame;
+  return static_cast<NSComparisonResult>(lhs.path().CompareTo(rhs.path()));
 }
 
 #endif  // defined(__OBJC__)
@@ -142,7 +148,12 @@ inline NSComparisonResult CompareKeys(const DocumentKey& lhs,
 namespace util {
 
 template <>
-struct Comparator<model::DocumentKey> : public std::less<model::DocumentKey> {};
+struct Comparator<model::DocumentKey> : public std::less<model::DocumentKey> {
+  ComparisonResult Compare(const model::DocumentKey& left,
+                           const model::DocumentKey& right) const {
+    return left.path().CompareTo(right.path());
+  }
+};
 
 }  // namespace util
 }  // namespace firestore
@@ -55,6 +55,24 @@ using MaybeDocumentMap = immutable::SortedMap<DocumentKey, FSTMaybeDocument*>;
  */
 class DocumentMap {
  public:
+  /**
+   * Builds a DocumentMap from documents supplied in increasing key order. See
+   * SortedMap::Builder.
+   */
+  class Builder {
+   public:
+    void push_back(const DocumentKey& key, FSTDocument* value) {
+      builder_.push_back(key, value);
+    }
+
+    DocumentMap Build() {
+      return DocumentMap{builder_.Build()};
+    }
+
+   private:
+    MaybeDocumentMap::Builder builder_;
+  };
+
   DocumentMap() = default;
 
   ABSL_MUST_USE_RESULT DocumentMap insert(const DocumentKey& key,
@@ -66,6 +84,11 @@ class DocumentMap {
     return DocumentMap{map_.erase(key)};
   }
 
+  template <typename Range>
+  ABSL_MUST_USE_RESULT DocumentMap erase_all(const Range& keys) const {
+    return DocumentMap{map_.erase_all(keys)};
+  }
+
   bool empty() const {
     return map_.empty();
   }
@@ -23,6 +23,7 @@
 
 #import <Foundation/Foundation.h>
 
+#include <cstdint>
 #include <iosfwd>
 #include <string>
 #include <utility>
@@ -53,7 +54,9 @@ class DocumentSetComparator {
   }
 
   bool operator()(FSTDocument* lhs, FSTDocument* rhs) const {
-    return delegate_(lhs, rhs) == NSOrderedAscending;
+    // Finding a document in the set ends by comparing it with itself, which
+    // doesn't need to go through the delegate.
+    return lhs != rhs && delegate_(lhs, rhs) == NSOrderedAscending;
   }
 
  private:
@@ -65,6 +68,12 @@ class DocumentSetComparator {
  * in order specified by the provided comparator. We always add a document key
  * comparator on top of what is provided to guarantee document equality based on
  * the key.
+ *
+ * Each set keeps a digest of its documents, updated as documents are added and
+ * removed, so that hashing a set and telling most unequal sets apart take
+ * constant time. Sets that are copies of one another are known to be equal
+ * without looking at their documents either; only distinct sets with the same
+ * digest are compared document by document.
  */
 class DocumentSet : public immutable::SortedContainer,
                     public util::Equatable<DocumentSet> {
@@ -128,6 +137,15 @@ class DocumentSet : public immutable::SortedContainer,
    */
   size_t IndexOf(const DocumentKey& key) const;
 
+  /**
+   * Returns an iterator pointing to the document at the given index in the
+   * document set, or end() if the index is out of range. Like IndexOf, this
+   * takes O(log(n)) time.
+   */
+  const_iterator nth(size_t index) const {
+    return sorted_set_.nth(index);
+  }
+
   /** Returns a new DocumentSet that contains the given document. */
   DocumentSet insert(FSTDocument* _Nullable document) const;
 
@@ -137,17 +155,23 @@ class DocumentSet : public immutable::SortedContainer,
    */
   DocumentSet erase(const DocumentKey& key) const;
 
+  /**
+   * Returns a new DocumentSet that only contains the first `count` documents
+   * of this one. The documents past `count` are removed in bulk, so this is
+   * much cheaper than erasing them one at a time when there are many.
+   */
+  DocumentSet Truncate(size_t count) const;
+
   friend bool operator==(const DocumentSet& lhs, const DocumentSet& rhs);
 
   std::string ToString() const;
   friend std::ostream& operator<<(std::ostream& os, const DocumentSet& set);
 
+  /** Returns the digest of the documents in the set; takes constant time. */
   size_t Hash() const;
 
  private:
-  DocumentSet(DocumentMap&& index, SetType&& sorted_set)
-      : index_(std::move(index)), sorted_set_(std::move(sorted_set)) {
-  }
+  DocumentSet(DocumentMap&& index, SetType&& sorted_set, uint64_t digest);
 
   /**
    * An index of the documents in the DocumentSet, indexed by document key.
@@ -163,6 +187,19 @@ class DocumentSet : public immutable::SortedContainer,
    * DocumentSet.
    */
   SetType sorted_set_;
+
+  /**
+   * The sum of the scrambled hashes of the documents in the set, which doesn't
+   * depend on their order and so can be updated for each document added or
+   * removed.
+   */
+  uint64_t digest_ = 0;
+
+  /**
+   * Identifies the contents of the set: copies of a set share it, while every
+   * set built by adding or removing documents gets a new one.
+   */
+  uint64_t contents_id_ = 0;
 };
 
 }  // namespace model
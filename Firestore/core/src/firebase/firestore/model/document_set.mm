@@ -16,8 +16,10 @@
 
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
 
+#include <atomic>
 #include <ostream>
 #include <utility>
+#include <vector>
 
 #import "Firestore/Source/Model/FSTDocument.h"
 
@@ -35,14 +37,58 @@ namespace model {
 namespace objc = util::objc;
 using immutable::SortedSet;
 
+namespace {
+
+uint64_t NextContentsId() {
+  static std::atomic<uint64_t> next_id{1};
+  return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Returns the document's contribution to the digest of a set: its hash, which
+ * covers its key, version, state and (memoized) data, scrambled so that sums
+ * over different documents rarely collide.
+ */
+uint64_t DigestOf(FSTDocument* doc) {
+  uint64_t hash = static_cast<uint64_t>([doc hash]);
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+}  // namespace
+
 DocumentSet::DocumentSet(NSComparator comparator)
-    : index_{}, sorted_set_{DocumentSetComparator{comparator}} {
+    : index_{},
+      sorted_set_{DocumentSetComparator{comparator}},
+      contents_id_{NextContentsId()} {
+}
+
+DocumentSet::DocumentSet(DocumentMap&& index,
+                         SetType&& sorted_set,
+                         uint64_t digest)
+    : index_{std::move(index)},
+      sorted_set_{std::move(sorted_set)},
+      digest_{digest},
+      contents_id_{NextContentsId()} {
 }
 
 bool operator==(const DocumentSet& lhs, const DocumentSet& rhs) {
+  if (lhs.contents_id_ == rhs.contents_id_) {
+    return true;
+  }
+  if (lhs.digest_ != rhs.digest_ || lhs.size() != rhs.size()) {
+    return false;
+  }
+
+  // Sets with the same documents may still hold them in different orders.
   return absl::c_equal(lhs.sorted_set_, rhs.sorted_set_,
                        [](FSTDocument* left_doc, FSTDocument* right_doc) {
-                         return [left_doc isEqual:right_doc];
+                         return left_doc == right_doc ||
+                                [left_doc isEqual:right_doc];
                        });
 }
 
@@ -55,11 +101,7 @@ std::ostream& operator<<(std::ostream& os, const DocumentSet& set) {
 }
 
 size_t DocumentSet::Hash() const {
-  size_t hash = 0;
-  for (FSTDocument* doc : sorted_set_) {
-    hash = 31 * hash + [doc hash];
-  }
-  return hash;
+  return static_cast<size_t>(digest_);
 }
 
 bool DocumentSet::ContainsKey(const DocumentKey& key) const {
@@ -96,11 +138,13 @@ DocumentSet DocumentSet::insert(FSTDocument* _Nullable document) const {
 
   // Remove any prior mapping of the document's key before adding, preventing
   // sortedSet from accumulating values that aren't in the index.
-  DocumentSet removed = erase(document.key);
+  const DocumentKey& key = document.key;
+  DocumentSet removed = erase(key);
 
-  DocumentMap index = removed.index_.insert(document.key, document);
+  DocumentMap index = removed.index_.insert(key, document);
   SetType set = removed.sorted_set_.insert(document);
-  return {std::move(index), std::move(set)};
+  return {std::move(index), std::move(set),
+          removed.digest_ + DigestOf(document)};
 }
 
 DocumentSet DocumentSet::erase(const DocumentKey& key) const {
@@ -111,7 +155,28 @@ DocumentSet DocumentSet::erase(const DocumentKey& key) const {
 
   DocumentMap index = index_.erase(key);
   SetType set = sorted_set_.erase(doc);
-  return {std::move(index), std::move(set)};
+  return {std::move(index), std::move(set), digest_ - DigestOf(doc)};
+}
+
+DocumentSet DocumentSet::Truncate(size_t count) const {
+  if (count >= size()) {
+    return *this;
+  }
+
+  std::vector<DocumentKey> keys;
+  std::vector<FSTDocument*> docs;
+  keys.reserve(size() - count);
+  docs.reserve(size() - count);
+  uint64_t digest = digest_;
+  for (auto iter = nth(count); iter != end(); ++iter) {
+    keys.push_back((*iter).key);
+    docs.push_back(*iter);
+    digest -= DigestOf(*iter);
+  }
+
+  DocumentMap index = index_.erase_all(keys);
+  SetType set = sorted_set_.erase_all(docs);
+  return {std::move(index), std::move(set), digest};
 }
 
 }  // namespace model
@@ -17,6 +17,9 @@
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
 
 #include <algorithm>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <unordered_map>
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/api/input_validation.h"
@@ -79,9 +82,75 @@ struct JoinEscaped {
     out->append(escaped_segment(segment));
   }
 };
+
+/**
+ * The most paths a FieldPathCache holds. Field names are usually drawn from a
+ * small set, but maps keyed by IDs make for unbounded sets of paths, which
+ * would otherwise grow the cache forever.
+ */
+const size_t kMaxCachedFieldPaths = 1000;
+
+/**
+ * A thread-safe cache of parsed field paths, keyed by the string they were
+ * parsed from. Every path handed out for a string shares the storage of the
+ * first one parsed from it, so paths parsed from the same string (say, by a
+ * filter and an orderBy, or by every document mask naming the field) compare
+ * equal without looking at their segments.
+ */
+class FieldPathCache {
+ public:
+  /**
+   * Returns the cached path for `path`, or parses it with `parse` and caches
+   * the result. Paths that fail to parse (by throwing) aren't cached.
+   */
+  template <typename ParseFn>
+  FieldPath Get(absl::string_view path, const ParseFn& parse) {
+    std::string key{path};
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      auto found = paths_.find(key);
+      if (found != paths_.end()) {
+        return found->second;
+      }
+    }
+
+    FieldPath parsed = parse(path);
+
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (paths_.size() >= kMaxCachedFieldPaths) {
+      paths_.clear();
+    }
+    // Another thread may have parsed the same path meanwhile, in which case
+    // its copy wins so that all the paths handed out share storage.
+    return paths_.emplace(std::move(key), std::move(parsed)).first->second;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<std::string, FieldPath> paths_;
+};
+
+FieldPathCache& DotSeparatedCache() {
+  static auto* cache = new FieldPathCache();
+  return *cache;
+}
+
+FieldPathCache& ServerFormatCache() {
+  static auto* cache = new FieldPathCache();
+  return *cache;
+}
+
 }  // namespace
 
 FieldPath FieldPath::FromDotSeparatedString(absl::string_view path) {
+  return DotSeparatedCache().Get(path, ParseDotSeparatedString);
+}
+
+FieldPath FieldPath::FromServerFormat(absl::string_view path) {
+  return ServerFormatCache().Get(path, ParseServerFormat);
+}
+
+FieldPath FieldPath::ParseDotSeparatedString(absl::string_view path) {
   if (path.find_first_of("~*/[]") != absl::string_view::npos) {
     ThrowInvalidArgument(
         "Invalid field path (%s). Paths must not contain '~', '*', '/', '[', "
@@ -103,7 +172,7 @@ FieldPath FieldPath::FromDotSeparatedString(absl::string_view path) {
   return FieldPath(std::move(segments));
 }
 
-FieldPath FieldPath::FromServerFormat(const absl::string_view path) {
+FieldPath FieldPath::ParseServerFormat(const absl::string_view path) {
   SegmentsT segments;
   std::string segment;
   segment.reserve(path.size());
@@ -56,6 +56,9 @@ class FieldPath : public impl::BasePath<FieldPath> {
    * Creates and returns a new path from a dot-separated field-path string,
    * where path segments are separated by a dot ".".
    *
+   * Parsed paths are interned: paths created from the same string share their
+   * storage, which makes comparing them cheap.
+   *
    * PORTING NOTE: We define this on the model class to avoid having a tiny
    * api::FieldPath wrapper class.
    */
@@ -75,6 +78,8 @@ class FieldPath : public impl::BasePath<FieldPath> {
    * Creates and returns a new path from the server formatted field-path string,
    * where path segments are separated by a dot "." and optionally encoded using
    * backticks.
+   *
+   * Parsed paths are interned, like those of FromDotSeparatedString().
    */
   static FieldPath FromServerFormat(absl::string_view path);
   /** Returns a field path that represents an empty path. */
@@ -107,6 +112,12 @@ class FieldPath : public impl::BasePath<FieldPath> {
   }
 
  private:
+  /** Parses the path for FromDotSeparatedString(), bypassing the cache. */
+  static FieldPath ParseDotSeparatedString(absl::string_view path);
+
+  /** Parses the path for FromServerFormat(), bypassing the cache. */
+  static FieldPath ParseServerFormat(absl::string_view path);
+
   static void ValidateSegments(const SegmentsT& segments) {
     if (segments.empty()) {
       api::ThrowInvalidArgument(
@@ -18,8 +18,13 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
 #include <memory>
 #include <new>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -27,7 +32,9 @@
 #include "Firestore/core/src/firebase/firestore/util/comparison.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/hashing.h"
+#include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
 
 using firebase::firestore::util::Comparator;
 
@@ -71,14 +78,11 @@ FieldValue& FieldValue::operator=(const FieldValue& value) {
       *server_timestamp_value_ = *value.server_timestamp_value_;
       break;
     case Type::String:
-      *string_value_ = *value.string_value_;
+      string_value_ = value.string_value_;
       break;
-    case Type::Blob: {
-      // copy-and-swap
-      std::vector<uint8_t> tmp = *value.blob_value_;
-      std::swap(*blob_value_, tmp);
+    case Type::Blob:
+      blob_value_ = value.blob_value_;
       break;
-    }
     case Type::Reference:
       *reference_value_ = *value.reference_value_;
       break;
@@ -105,14 +109,6 @@ FieldValue& FieldValue::operator=(const FieldValue& value) {
 
 FieldValue& FieldValue::operator=(FieldValue&& value) {
   switch (value.tag_) {
-    case Type::String:
-      SwitchTo(Type::String);
-      string_value_->swap(*value.string_value_);
-      return *this;
-    case Type::Blob:
-      SwitchTo(Type::Blob);
-      std::swap(blob_value_, value.blob_value_);
-      return *this;
     case Type::Reference:
       SwitchTo(Type::Reference);
       std::swap(reference_value_, value.reference_value_);
@@ -126,7 +122,8 @@ FieldValue& FieldValue::operator=(FieldValue&& value) {
       std::swap(object_value_, value.object_value_);
       return *this;
     default:
-      // We just copy over POD union types.
+      // We just copy over POD union types, and strings and blobs, whose
+      // storage is shared (which also leaves the moved-from value intact).
       *this = value;
       return *this;
   }
@@ -190,7 +187,7 @@ ObjectValue ObjectValue::Delete(const FieldPath& field_path) const {
 }
 
 absl::optional<FieldValue> ObjectValue::Get(const FieldPath& field_path) const {
-  const FieldValue* current = &this->fv_;
+  const FieldValue* current = &fv_;
   for (const auto& path : field_path) {
     if (current->type() != Type::Object) {
       return absl::nullopt;
@@ -205,11 +202,170 @@ absl::optional<FieldValue> ObjectValue::Get(const FieldPath& field_path) const {
   return *current;
 }
 
+size_t ObjectValue::EstimatedByteSize() const {
+  return sizeof(ObjectValue) - sizeof(FieldValue) + fv_.EstimatedByteSize();
+}
+
 ObjectValue ObjectValue::SetChild(const std::string& child_name,
                                   const FieldValue& value) const {
   return ObjectValue::FromMap(fv_.object_value_->insert(child_name, value));
 }
 
+/**
+ * A pending edit at one position of the object being built. Set nodes replace
+ * the value there; Delete nodes remove it; Nested nodes edit the object there
+ * (or `value`, if `has_base` is set) according to their children.
+ */
+struct ObjectValue::Builder::Node {
+  enum class Op {
+    Nested,
+    Set,
+    Delete,
+  };
+
+  /**
+   * Makes this node replace its position with `new_value`. Objects become
+   * Nested nodes based on the value, so later edits beneath them can be
+   * merged in.
+   */
+  void Assign(FieldValue&& new_value) {
+    op = new_value.type() == Type::Object ? Op::Nested : Op::Set;
+    has_base = op == Op::Nested;
+    value = std::move(new_value);
+    children.clear();
+  }
+
+  /** Returns true if applying this node creates at least one field. */
+  bool ContainsSet() const {
+    if (has_base) {
+      return true;
+    }
+    for (const auto& entry : children) {
+      const Node& child = *entry.second;
+      if (child.op == Op::Set ||
+          (child.op == Op::Nested && child.ContainsSet())) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  Op op = Op::Nested;
+  bool has_base = false;
+  FieldValue value;
+
+  // Children are kept in key order so that they can be merged into the
+  // existing map in a single pass.
+  std::map<std::string, std::unique_ptr<Node>> children;
+};
+
+ObjectValue::Builder::Builder(ObjectValue base)
+    : base_(std::move(base)), root_(absl::make_unique<Node>()) {
+}
+
+ObjectValue::Builder::~Builder() = default;
+
+void ObjectValue::Builder::Set(const FieldPath& field_path, FieldValue value) {
+  HARD_ASSERT(!field_path.empty(),
+              "Cannot set field for empty path on FieldValue");
+  Node* node = root_.get();
+  for (const std::string& segment : field_path.PopLast()) {
+    std::unique_ptr<Node>& child = node->children[segment];
+    if (!child) {
+      child = absl::make_unique<Node>();
+    } else if (child->op != Node::Op::Nested) {
+      // Setting beneath a deleted field or a primitive replaces it with an
+      // object, just as ObjectValue::Set() does.
+      child->Assign(FieldValue::EmptyObject());
+    }
+    node = child.get();
+  }
+
+  std::unique_ptr<Node>& leaf = node->children[field_path.last_segment()];
+  if (!leaf) {
+    leaf = absl::make_unique<Node>();
+  }
+  leaf->Assign(std::move(value));
+}
+
+void ObjectValue::Builder::Delete(const FieldPath& field_path) {
+  HARD_ASSERT(!field_path.empty(),
+              "Cannot delete field for empty path on FieldValue");
+  Node* node = root_.get();
+  for (const std::string& segment : field_path.PopLast()) {
+    std::unique_ptr<Node>& child = node->children[segment];
+    if (!child) {
+      child = absl::make_unique<Node>();
+    } else if (child->op != Node::Op::Nested) {
+      // A deleted field or a primitive cannot contain the rest of the path.
+      return;
+    }
+    node = child.get();
+  }
+
+  std::unique_ptr<Node>& leaf = node->children[field_path.last_segment()];
+  if (!leaf) {
+    leaf = absl::make_unique<Node>();
+  }
+  leaf->op = Node::Op::Delete;
+  leaf->has_base = false;
+  leaf->children.clear();
+}
+
+ObjectValue ObjectValue::Builder::Build() const {
+  if (root_->children.empty()) {
+    return base_;
+  }
+  absl::optional<FieldValue> result = Apply(*root_, &base_.fv_);
+  return result ? ObjectValue(std::move(*result)) : base_;
+}
+
+absl::optional<FieldValue> ObjectValue::Builder::Apply(
+    const Node& node, const FieldValue* existing) {
+  const FieldValue* start = nullptr;
+  if (node.has_base) {
+    start = &node.value;
+  } else if (existing && existing->type() == Type::Object) {
+    start = existing;
+  } else if (!node.ContainsSet()) {
+    // Only deletes beneath a field that isn't an object, which don't change
+    // anything, just as with ObjectValue::Delete().
+    return absl::nullopt;
+  }
+  if (node.children.empty()) {
+    return start ? absl::make_optional(*start) : absl::nullopt;
+  }
+
+  const FieldValue::Map empty;
+  const FieldValue::Map& map = start ? *start->object_value_ : empty;
+
+  std::vector<std::pair<std::string, FieldValue>> upserts;
+  std::vector<std::string> erasures;
+  for (const auto& entry : node.children) {
+    const std::string& name = entry.first;
+    const Node& child = *entry.second;
+    switch (child.op) {
+      case Node::Op::Set:
+        upserts.emplace_back(name, child.value);
+        break;
+      case Node::Op::Delete:
+        erasures.push_back(name);
+        break;
+      case Node::Op::Nested: {
+        auto found = map.find(name);
+        absl::optional<FieldValue> result =
+            Apply(child, found != map.end() ? &found->second : nullptr);
+        if (result) {
+          upserts.emplace_back(name, std::move(*result));
+        }
+        break;
+      }
+    }
+  }
+
+  return FieldValue::FromMap(map.erase_all(erasures).insert_all(upserts));
+}
+
 FieldValue FieldValue::Null() {
   return FieldValue();
 }
@@ -285,15 +441,15 @@ FieldValue FieldValue::FromString(const std::string& value) {
 FieldValue FieldValue::FromString(std::string&& value) {
   FieldValue result;
   result.SwitchTo(Type::String);
-  result.string_value_->swap(value);
+  result.string_value_ = util::SharedValue<std::string>(std::move(value));
   return result;
 }
 
 FieldValue FieldValue::FromBlob(const uint8_t* source, size_t size) {
   FieldValue result;
   result.SwitchTo(Type::Blob);
-  std::vector<uint8_t> copy(source, source + size);
-  std::swap(*result.blob_value_, copy);
+  result.blob_value_ = util::SharedValue<std::vector<uint8_t>>(
+      std::vector<uint8_t>(source, source + size));
   return result;
 }
 
@@ -348,34 +504,332 @@ FieldValue FieldValue::FromMap(FieldValue::Map&& value) {
   return result;
 }
 
+namespace {
+
+/**
+ * Hashes a number consistently with FieldValue equality, under which an
+ * integral double equals the integer with the same value, -0.0 equals 0.0 and
+ * NaN equals itself.
+ */
+void HashNumber(double value, util::Hasher* hasher) {
+  if (value >= static_cast<double>(std::numeric_limits<int64_t>::min()) &&
+      value < static_cast<double>(std::numeric_limits<int64_t>::max()) &&
+      std::trunc(value) == value) {
+    hasher->AddInteger(static_cast<uint64_t>(static_cast<int64_t>(value)));
+  } else {
+    hasher->AddInteger(util::DoubleBits(value));
+  }
+}
+
+void HashTimestamp(const Timestamp& timestamp, util::Hasher* hasher) {
+  hasher->AddInteger(static_cast<uint64_t>(timestamp.seconds()))
+      .AddInteger(static_cast<uint64_t>(timestamp.nanoseconds()));
+}
+
+}  // namespace
+
 size_t FieldValue::Hash() const {
+  util::Hasher hasher;
+  HashInto(&hasher);
+  return static_cast<size_t>(hasher.value());
+}
+
+void FieldValue::HashInto(util::Hasher* hasher) const {
+  // Integers and doubles compare with each other, so they share a type here.
+  Type hash_type = type() == Type::Double ? Type::Integer : type();
+  hasher->AddInteger(static_cast<uint64_t>(hash_type));
+
   switch (type()) {
     case FieldValue::Type::Null:
-      HARD_FAIL("TODO(rsgowman): Implement");
+      return;
 
     case FieldValue::Type::Boolean:
-      return util::Hash(boolean_value());
+      hasher->AddInteger(boolean_value());
+      return;
 
     case FieldValue::Type::Integer:
+      hasher->AddInteger(static_cast<uint64_t>(integer_value_));
+      return;
+
     case FieldValue::Type::Double:
+      HashNumber(double_value_, hasher);
+      return;
+
     case FieldValue::Type::Timestamp:
+      HashTimestamp(*timestamp_value_, hasher);
+      return;
+
     case FieldValue::Type::ServerTimestamp:
-      HARD_FAIL("TODO(rsgowman): Implement");
+      // Server timestamps are only compared by their local write time.
+      HashTimestamp(server_timestamp_value_->local_write_time, hasher);
+      return;
 
     case FieldValue::Type::String:
-      return util::Hash(string_value());
+      hasher->AddBytes(string_value());
+      return;
+
+    case FieldValue::Type::Blob: {
+      const std::vector<uint8_t>& blob = blob_value();
+      hasher->AddBytes(absl::string_view{
+          reinterpret_cast<const char*>(blob.data()), blob.size()});
+      return;
+    }
+
+    case FieldValue::Type::Reference: {
+      const DatabaseId& database_id = *reference_value_->database_id;
+      hasher->AddBytes(database_id.project_id())
+          .AddBytes(database_id.database_id())
+          .AddInteger(reference_value_->reference.Hash());
+      return;
+    }
+
+    case FieldValue::Type::GeoPoint:
+      HashNumber(geo_point_value_->latitude(), hasher);
+      HashNumber(geo_point_value_->longitude(), hasher);
+      return;
+
+    case FieldValue::Type::Array:
+      for (const FieldValue& element : *array_value_) {
+        element.HashInto(hasher);
+      }
+      hasher->AddInteger(array_value_->size());
+      return;
+
+    case FieldValue::Type::Object:
+      for (const auto& entry : *object_value_) {
+        hasher->AddBytes(entry.first);
+        entry.second.HashInto(hasher);
+      }
+      hasher->AddInteger(object_value_->size());
+      return;
+  }
+
+  UNREACHABLE();
+}
+
+size_t FieldValue::EstimatedByteSize() const {
+  size_t size = sizeof(FieldValue);
+  switch (type()) {
+    case FieldValue::Type::Null:
+    case FieldValue::Type::Boolean:
+    case FieldValue::Type::Integer:
+    case FieldValue::Type::Double:
+      return size;
+
+    case FieldValue::Type::Timestamp:
+      return size + sizeof(Timestamp);
+
+    case FieldValue::Type::ServerTimestamp:
+      return size + sizeof(ServerTimestamp);
+
+    case FieldValue::Type::String:
+      return size + sizeof(std::string) + string_value().size();
 
     case FieldValue::Type::Blob:
+      return size + sizeof(std::vector<uint8_t>) + blob_value().size();
+
     case FieldValue::Type::Reference:
+      return size + sizeof(ReferenceValue) +
+             reference_value_->reference.EstimatedPathByteSize();
+
     case FieldValue::Type::GeoPoint:
+      return size + sizeof(GeoPoint);
+
     case FieldValue::Type::Array:
+      size += sizeof(std::vector<FieldValue>);
+      for (const FieldValue& element : *array_value_) {
+        size += element.EstimatedByteSize();
+      }
+      return size;
+
     case FieldValue::Type::Object:
-      HARD_FAIL("TODO(rsgowman): Implement");
+      size += sizeof(Map);
+      for (const auto& entry : *object_value_) {
+        size += sizeof(std::string) + entry.first.size() +
+                entry.second.EstimatedByteSize();
+      }
+      return size;
   }
 
   UNREACHABLE();
 }
 
+namespace {
+
+using util::OrderedCode;
+
+/**
+ * The first byte of a value's sort key, in the order of the values' types.
+ * Types that compare with each other (integers and doubles) share a byte.
+ */
+enum SortKeyTypeByte : char {
+  kSortKeyNull = 1,
+  kSortKeyBoolean,
+  kSortKeyNumber,
+  kSortKeyTimestamp,
+  kSortKeyServerTimestamp,
+  kSortKeyString,
+  kSortKeyBlob,
+  kSortKeyReference,
+  kSortKeyGeoPoint,
+  kSortKeyArray,
+  kSortKeyObject,
+};
+
+/**
+ * Marks the end of a sequence of elements (of an array, object or path) in a
+ * sort key. It sorts before the first byte of any element, so that a sequence
+ * sorts before every longer sequence it's a prefix of.
+ */
+const char kSortKeyEnd = 0;
+
+/** Precedes every entry of an object and every segment of a path. */
+const char kSortKeyContinue = 1;
+
+/**
+ * Writes a double such that the unsigned byte order of the output matches
+ * Comparator<double>: NaN sorts before all other numbers, and -0.0 is written
+ * as 0.0 since the two compare equal.
+ */
+void WriteSortKeyDouble(std::string* dest, double value) {
+  uint64_t bits = 0;
+  if (!std::isnan(value)) {
+    if (value == 0) {
+      value = 0;
+    }
+    std::memcpy(&bits, &value, sizeof(bits));
+    // Flipping the sign bit of positive numbers moves them above all negative
+    // numbers; flipping all bits of negative numbers reverses their order.
+    const uint64_t sign_bit = uint64_t{1} << 63;
+    bits = (bits & sign_bit) ? ~bits : bits | sign_bit;
+  }
+  OrderedCode::WriteNumIncreasing(dest, bits);
+}
+
+/**
+ * Writes a number as its nearest double, followed by the difference between
+ * the number and that double. Rounding to the nearest double preserves order,
+ * and the difference breaks ties between integers beyond 2^53 (and between
+ * them and their nearest doubles), so that integers and doubles are ordered
+ * exactly as CompareMixedNumber does. The difference is zero for doubles and
+ * for integers that doubles represent exactly, so equal numbers have equal
+ * keys.
+ */
+void WriteSortKeyNumber(std::string* dest, double nearest, int64_t difference) {
+  WriteSortKeyDouble(dest, nearest);
+  OrderedCode::WriteSignedNumIncreasing(dest, difference);
+}
+
+void WriteSortKeyInteger(std::string* dest, int64_t value) {
+  auto nearest = static_cast<double>(value);
+  int64_t difference = 0;
+  if (nearest >= static_cast<double>(std::numeric_limits<int64_t>::max())) {
+    // Integers close to INT64_MAX round up to 2^63, which doesn't fit into an
+    // int64_t; value - 2^63 does.
+    difference = value - std::numeric_limits<int64_t>::max() - 1;
+  } else {
+    difference = value - static_cast<int64_t>(nearest);
+  }
+  WriteSortKeyNumber(dest, nearest, difference);
+}
+
+void WriteSortKeyTimestamp(std::string* dest, const Timestamp& value) {
+  OrderedCode::WriteSignedNumIncreasing(dest, value.seconds());
+  OrderedCode::WriteSignedNumIncreasing(dest, value.nanoseconds());
+}
+
+}  // namespace
+
+std::string FieldValue::SortKey() const {
+  std::string result;
+  WriteSortKey(&result);
+  return result;
+}
+
+void FieldValue::WriteSortKey(std::string* dest) const {
+  switch (type()) {
+    case Type::Null:
+      dest->push_back(kSortKeyNull);
+      break;
+
+    case Type::Boolean:
+      dest->push_back(kSortKeyBoolean);
+      dest->push_back(boolean_value_ ? 1 : 0);
+      break;
+
+    case Type::Integer:
+      dest->push_back(kSortKeyNumber);
+      WriteSortKeyInteger(dest, integer_value_);
+      break;
+
+    case Type::Double:
+      dest->push_back(kSortKeyNumber);
+      WriteSortKeyNumber(dest, double_value_, 0);
+      break;
+
+    case Type::Timestamp:
+      dest->push_back(kSortKeyTimestamp);
+      WriteSortKeyTimestamp(dest, *timestamp_value_);
+      break;
+
+    case Type::ServerTimestamp:
+      dest->push_back(kSortKeyServerTimestamp);
+      WriteSortKeyTimestamp(dest, server_timestamp_value_->local_write_time);
+      break;
+
+    case Type::String:
+      dest->push_back(kSortKeyString);
+      OrderedCode::WriteString(dest, *string_value_);
+      break;
+
+    case Type::Blob: {
+      dest->push_back(kSortKeyBlob);
+      const std::vector<uint8_t>& blob = *blob_value_;
+      OrderedCode::WriteString(
+          dest, absl::string_view{reinterpret_cast<const char*>(blob.data()),
+                                  blob.size()});
+      break;
+    }
+
+    case Type::Reference: {
+      dest->push_back(kSortKeyReference);
+      const DatabaseId& database_id = *reference_value_->database_id;
+      OrderedCode::WriteString(dest, database_id.project_id());
+      OrderedCode::WriteString(dest, database_id.database_id());
+      for (const std::string& segment : reference_value_->reference.path()) {
+        dest->push_back(kSortKeyContinue);
+        OrderedCode::WriteString(dest, segment);
+      }
+      dest->push_back(kSortKeyEnd);
+      break;
+    }
+
+    case Type::GeoPoint:
+      dest->push_back(kSortKeyGeoPoint);
+      WriteSortKeyDouble(dest, geo_point_value_->latitude());
+      WriteSortKeyDouble(dest, geo_point_value_->longitude());
+      break;
+
+    case Type::Array:
+      dest->push_back(kSortKeyArray);
+      for (const FieldValue& element : *array_value_) {
+        element.WriteSortKey(dest);
+      }
+      dest->push_back(kSortKeyEnd);
+      break;
+
+    case Type::Object:
+      dest->push_back(kSortKeyObject);
+      for (const auto& kv : *object_value_) {
+        dest->push_back(kSortKeyContinue);
+        OrderedCode::WriteString(dest, kv.first);
+        kv.second.WriteSortKey(dest);
+      }
+      dest->push_back(kSortKeyEnd);
+      break;
+  }
+}
+
 bool operator<(const FieldValue::Map& lhs, const FieldValue::Map& rhs) {
   return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(),
                                       rhs.end());
@@ -459,10 +913,10 @@ void FieldValue::SwitchTo(const Type type) {
       server_timestamp_value_.~unique_ptr<ServerTimestamp>();
       break;
     case Type::String:
-      string_value_.~unique_ptr<std::string>();
+      string_value_.~SharedValue<std::string>();
       break;
     case Type::Blob:
-      blob_value_.~unique_ptr<std::vector<uint8_t>>();
+      blob_value_.~SharedValue<std::vector<uint8_t>>();
       break;
     case Type::Reference:
       reference_value_.~unique_ptr<ReferenceValue>();
@@ -490,13 +944,12 @@ void FieldValue::SwitchTo(const Type type) {
           absl::make_unique<ServerTimestamp>());
       break;
     case Type::String:
-      new (&string_value_)
-          std::unique_ptr<std::string>(absl::make_unique<std::string>());
+      // The storage is shared and immutable, so every caller that switches to
+      // a string or blob supplies its own.
+      new (&string_value_) util::SharedValue<std::string>();
       break;
     case Type::Blob:
-      // Do not even bother to allocate a new array of size 0.
-      new (&blob_value_) std::unique_ptr<std::vector<uint8_t>>(
-          absl::make_unique<std::vector<uint8_t>>());
+      new (&blob_value_) util::SharedValue<std::vector<uint8_t>>();
       break;
     case Type::Reference:
       new (&reference_value_)
@@ -30,6 +30,8 @@
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/hashing.h"
+#include "Firestore/core/src/firebase/firestore/util/shared_value.h"
 #include "absl/types/optional.h"
 
 #if __OBJC__
@@ -106,6 +108,10 @@ class FieldValue {
   FieldValue& operator=(FieldValue&& value);
 
 #if __OBJC__
+  /**
+   * Converts this value into the equivalent FSTFieldValue, choosing the same
+   * FSTFieldValue subclass for each type that the rest of the client uses.
+   */
   FSTFieldValue* Wrap() &&;
 #endif  // __OBJC__
 
@@ -153,6 +159,16 @@ class FieldValue {
     return *blob_value_;
   }
 
+  const ServerTimestamp& server_timestamp_value() const {
+    HARD_ASSERT(tag_ == Type::ServerTimestamp);
+    return *server_timestamp_value_;
+  }
+
+  const ReferenceValue& reference_value() const {
+    HARD_ASSERT(tag_ == Type::Reference);
+    return *reference_value_;
+  }
+
   const GeoPoint& geo_point_value() const {
     HARD_ASSERT(tag_ == Type::GeoPoint);
     return *geo_point_value_;
@@ -163,6 +179,11 @@ class FieldValue {
     return *array_value_;
   }
 
+  const Map& object_value() const {
+    HARD_ASSERT(tag_ == Type::Object);
+    return *object_value_;
+  }
+
   /** factory methods. */
   static FieldValue Null();
   static FieldValue True();
@@ -190,13 +211,42 @@ class FieldValue {
   static FieldValue FromMap(const Map& value);
   static FieldValue FromMap(Map&& value);
 
+  /**
+   * Returns a hash code that agrees with operator==: values that compare equal,
+   * such as the integer 1 and the double 1.0, have equal hashes.
+   */
   size_t Hash() const;
 
+  /**
+   * Returns a string whose byte order matches the Firestore ordering of
+   * values: `a < b` if and only if `a.SortKey() < b.SortKey()` when comparing
+   * the keys' bytes as unsigned (e.g. by memcmp). Values that compare equal,
+   * such as 1 and 1.0, have identical keys.
+   *
+   * Computing a key costs about as much as a single comparison, so keys pay
+   * off when each value is compared many times, as when sorting, or when the
+   * keys are stored.
+   */
+  std::string SortKey() const;
+
+  /**
+   * Returns an estimate of the number of bytes of memory used by the value,
+   * including the FieldValue itself and everything it owns. Strings and blobs
+   * are counted in full, even though copies of a value share them.
+   */
+  size_t EstimatedByteSize() const;
+
   friend bool operator<(const FieldValue& lhs, const FieldValue& rhs);
 
  private:
   friend class ObjectValue;
 
+  /** Appends SortKey() to `dest`. */
+  void WriteSortKey(std::string* dest) const;
+
+  /** Streams the value, including its type, into `hasher`. */
+  void HashInto(util::Hasher* hasher) const;
+
   explicit FieldValue(bool value) : tag_(Type::Boolean), boolean_value_(value) {
   }
 
@@ -213,9 +263,10 @@ class FieldValue {
     double double_value_;
     std::unique_ptr<Timestamp> timestamp_value_;
     std::unique_ptr<ServerTimestamp> server_timestamp_value_;
-    // TODO(rsgowman): Change unique_ptr<std::string> to nanopb::String?
-    std::unique_ptr<std::string> string_value_;
-    std::unique_ptr<std::vector<uint8_t>> blob_value_;
+    // Strings and blobs never change once created, so copies of a value share
+    // the same storage.
+    util::SharedValue<std::string> string_value_;
+    util::SharedValue<std::vector<uint8_t>> blob_value_;
     std::unique_ptr<ReferenceValue> reference_value_;
     std::unique_ptr<GeoPoint> geo_point_value_;
     std::unique_ptr<std::vector<FieldValue>> array_value_;
@@ -226,6 +277,8 @@ class FieldValue {
 /** A structured object value stored in Firestore. */
 class ObjectValue {
  public:
+  class Builder;
+
   explicit ObjectValue(FieldValue fv) : fv_(std::move(fv)) {
     HARD_ASSERT(fv_.type() == FieldValue::Type::Object);
   }
@@ -265,6 +318,12 @@ class ObjectValue {
    */
   ObjectValue Delete(const FieldPath& field_path) const;
 
+  /**
+   * Returns an estimate of the number of bytes of memory used by the object
+   * (see FieldValue::EstimatedByteSize()).
+   */
+  size_t EstimatedByteSize() const;
+
   // TODO(rsgowman): Add Value() method?
   //
   // Java has a value() method which returns a (non-immutable) java.util.Map,
@@ -284,6 +343,51 @@ class ObjectValue {
   FieldValue fv_;
 };
 
+/**
+ * Applies a batch of sets and deletes to an ObjectValue in a single pass.
+ *
+ * Each call to ObjectValue::Set() or Delete() copies every map along the path,
+ * so applying n changes copies the top-level map n times. A Builder instead
+ * records the changes as a tree of pending edits, and Build() then rebuilds
+ * each changed map once, merging all of its edits at the same time. Maps that
+ * aren't touched by any edit are shared with the original value.
+ *
+ * Changes are applied in the order they're made, exactly as the equivalent
+ * sequence of Set() and Delete() calls would be.
+ */
+class ObjectValue::Builder {
+ public:
+  explicit Builder(ObjectValue base);
+  ~Builder();
+
+  /**
+   * Sets the field at the given (non-empty) path to value, creating any absent
+   * parents and replacing any parents that aren't objects.
+   */
+  void Set(const FieldPath& field_path, FieldValue value);
+
+  /**
+   * Deletes the field at the given (non-empty) path, if there is one.
+   */
+  void Delete(const FieldPath& field_path);
+
+  /** Returns the base object with all the changes applied. */
+  ObjectValue Build() const;
+
+ private:
+  struct Node;
+
+  /**
+   * Returns the object at the position of `node`, given the current value
+   * there (or nullptr), or absl::nullopt if the node leaves it unchanged.
+   */
+  static absl::optional<FieldValue> Apply(const Node& node,
+                                          const FieldValue* existing);
+
+  ObjectValue base_;
+  std::unique_ptr<Node> root_;
+};
+
 bool operator<(const FieldValue::Map& lhs, const FieldValue::Map& rhs);
 
 /** Compares against another FieldValue. */
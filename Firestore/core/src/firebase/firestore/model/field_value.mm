@@ -16,14 +16,111 @@
 
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 
+#include <utility>
+#include <vector>
+
+#import "FIRGeoPoint.h"
+#import "FIRTimestamp.h"
+#import "Firestore/Source/Model/FSTDocumentKey.h"
 #import "Firestore/Source/Model/FSTFieldValue.h"
 
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+
 namespace firebase {
 namespace firestore {
 namespace model {
 
+namespace {
+
+FIRTimestamp* MakeFIRTimestamp(const Timestamp& timestamp) {
+  return [[FIRTimestamp alloc] initWithSeconds:timestamp.seconds()
+                                   nanoseconds:timestamp.nanoseconds()];
+}
+
+FSTFieldValue* WrapCopy(const FieldValue& value) {
+  return FieldValue(value).Wrap();
+}
+
+}  // namespace
+
 FSTFieldValue* FieldValue::Wrap() && {
-  return [FSTDelegateValue delegateWithValue:std::move(*this)];
+  switch (type()) {
+    case Type::Null:
+      return [FSTNullValue nullValue];
+
+    case Type::Boolean:
+    case Type::String:
+      return [FSTDelegateValue delegateWithValue:std::move(*this)];
+
+    case Type::Integer:
+      return [FSTIntegerValue integerValue:integer_value()];
+
+    case Type::Double:
+      return [FSTDoubleValue doubleValue:double_value()];
+
+    case Type::Timestamp:
+      return [FSTTimestampValue
+          timestampValue:MakeFIRTimestamp(timestamp_value())];
+
+    case Type::ServerTimestamp: {
+      const ServerTimestamp& server_timestamp = server_timestamp_value();
+      FSTFieldValue* previous_value = nil;
+      if (server_timestamp.previous_value) {
+        previous_value = [FSTTimestampValue
+            timestampValue:MakeFIRTimestamp(*server_timestamp.previous_value)];
+      }
+      return [FSTServerTimestampValue
+          serverTimestampValueWithLocalWriteTime:MakeFIRTimestamp(
+                                                     server_timestamp
+                                                         .local_write_time)
+                                   previousValue:previous_value];
+    }
+
+    case Type::Blob: {
+      const std::vector<uint8_t>& blob = blob_value();
+      return [FSTBlobValue blobValue:[NSData dataWithBytes:blob.data()
+                                                    length:blob.size()]];
+    }
+
+    case Type::Reference: {
+      const ReferenceValue& reference = reference_value();
+      return [FSTReferenceValue
+          referenceValue:[FSTDocumentKey
+                             keyWithDocumentKey:reference.reference]
+              databaseID:reference.database_id];
+    }
+
+    case Type::GeoPoint: {
+      const GeoPoint& geo_point = geo_point_value();
+      return [FSTGeoPointValue
+          geoPointValue:[[FIRGeoPoint alloc]
+                            initWithLatitude:geo_point.latitude()
+                                   longitude:geo_point.longitude()]];
+    }
+
+    case Type::Array: {
+      const std::vector<FieldValue>& array = array_value();
+      NSMutableArray<FSTFieldValue*>* result =
+          [NSMutableArray arrayWithCapacity:array.size()];
+      for (const FieldValue& element : array) {
+        [result addObject:WrapCopy(element)];
+      }
+      return [[FSTArrayValue alloc] initWithValueNoCopy:result];
+    }
+
+    case Type::Object: {
+      const Map& map = object_value();
+      NSMutableDictionary<NSString*, FSTFieldValue*>* result =
+          [NSMutableDictionary dictionaryWithCapacity:map.size()];
+      for (const auto& entry : map) {
+        result[util::WrapNSString(entry.first)] = WrapCopy(entry.second);
+      }
+      return [[FSTObjectValue alloc] initWithDictionary:result];
+    }
+  }
+
+  UNREACHABLE();
 }
 
 }  // namespace model
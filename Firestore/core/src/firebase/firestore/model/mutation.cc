@@ -158,17 +158,20 @@ ObjectValue PatchMutation::PatchDocument(const MaybeDocument* maybe_doc) const {
 }
 
 ObjectValue PatchMutation::PatchObject(ObjectValue obj) const {
+  // Masks often have many paths, so apply them all in a single pass rather
+  // than copying the object for each one.
+  ObjectValue::Builder builder{std::move(obj)};
   for (const FieldPath& path : mask_) {
     if (!path.empty()) {
       absl::optional<FieldValue> new_value = value_.Get(path);
       if (!new_value) {
-        obj = obj.Delete(path);
+        builder.Delete(path);
       } else {
-        obj = obj.Set(path, *new_value);
+        builder.Set(path, std::move(*new_value));
       }
     }
   }
-  return obj;
+  return builder.Build();
 }
 
 bool PatchMutation::equal_to(const Mutation& other) const {
@@ -18,7 +18,6 @@
 
 #include <algorithm>
 #include <utility>
-#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "absl/strings/str_join.h"
@@ -38,8 +37,7 @@ ResourcePath ResourcePath::FromString(const absl::string_view path) {
 
   // SkipEmpty because we may still have an empty segment at the beginning or
   // end if they had a leading or trailing slash (which we allow).
-  std::vector<std::string> segments =
-      absl::StrSplit(path, '/', absl::SkipEmpty());
+  SegmentsT segments = absl::StrSplit(path, '/', absl::SkipEmpty());
   return ResourcePath{std::move(segments)};
 }
 
@@ -28,6 +28,8 @@
 
 #include "Firestore/core/include/firebase/firestore/timestamp.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/objc_compatibility.h"
 
 namespace firebase {
 namespace firestore {
@@ -223,20 +225,39 @@ class ArrayTransform : public TransformOperation {
     }
   }
 
+  /**
+   * Applies the transform using hash sets of the values involved, so that it
+   * runs in time linear in the sizes of the previous array and the elements.
+   */
   FSTFieldValue* Apply(FSTFieldValue* previousValue) const {
     NSMutableArray<FSTFieldValue*>* result =
         ArrayTransform::CoercedFieldValuesArray(previousValue);
-    for (FSTFieldValue* element : elements_) {
-      if (type_ == Type::ArrayUnion) {
-        if (![result containsObject:element]) {
+    if (type_ == Type::ArrayUnion) {
+      // Existing duplicates are kept; only new elements are deduplicated.
+      objc::unordered_set<FSTFieldValue*> present(result.count);
+      for (FSTFieldValue* value in result) {
+        present.insert(value);
+      }
+      for (FSTFieldValue* element : elements_) {
+        if (present.insert(element).second) {
           [result addObject:element];
         }
-      } else {
-        HARD_ASSERT(type_ == Type::ArrayRemove);
-        [result removeObject:element];
+      }
+      return [[FSTArrayValue alloc] initWithValueNoCopy:result];
+    }
+
+    HARD_ASSERT(type_ == Type::ArrayRemove);
+    // Every occurrence of each element is removed.
+    objc::unordered_set<FSTFieldValue*> removed(elements_.begin(),
+                                                elements_.end());
+    NSMutableArray<FSTFieldValue*>* kept =
+        [NSMutableArray arrayWithCapacity:result.count];
+    for (FSTFieldValue* value in result) {
+      if (removed.find(value) == removed.end()) {
+        [kept addObject:value];
       }
     }
-    return [[FSTArrayValue alloc] initWithValueNoCopy:result];
+    return [[FSTArrayValue alloc] initWithValueNoCopy:kept];
   }
 };
 
@@ -0,0 +1,194 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/nanopb/arena.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/nanopb/pb_system.h"
+#include "absl/base/config.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+
+namespace {
+
+// Every allocation is aligned like malloc's, and preceded by a header of the
+// same size holding its capacity, which realloc needs to copy it.
+const size_t kAlignment = alignof(std::max_align_t);
+const size_t kHeaderSize = kAlignment;
+
+const size_t kMinBlockSize = 4096;
+
+size_t RoundUp(size_t size) {
+  return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+size_t GetCapacity(const char* allocation) {
+  size_t capacity;
+  std::memcpy(&capacity, allocation - kHeaderSize, sizeof(capacity));
+  return capacity;
+}
+
+void SetCapacity(char* allocation, size_t capacity) {
+  std::memcpy(allocation - kHeaderSize, &capacity, sizeof(capacity));
+}
+
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+thread_local Arena* current_arena = nullptr;
+#endif
+
+}  // namespace
+
+Arena::Scope::Scope(Arena* arena) {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  previous_ = current_arena;
+  current_arena = arena;
+#else
+  (void)arena;
+#endif
+}
+
+Arena::Scope::~Scope() {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  current_arena = previous_;
+#endif
+}
+
+bool Arena::IsSupported() {
+#if defined(PB_SYSTEM_HEADER) && defined(ABSL_HAVE_THREAD_LOCAL)
+  return true;
+#else
+  return false;
+#endif
+}
+
+Arena* Arena::Current() {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  return current_arena;
+#else
+  return nullptr;
+#endif
+}
+
+void* Arena::Allocate(size_t size) {
+  size_t capacity = RoundUp(std::max<size_t>(size, 1));
+  size_t needed = kHeaderSize + capacity;
+  if (blocks_.empty() || used_ + needed > blocks_.back().size) {
+    size_t block_size = kMinBlockSize;
+    if (!blocks_.empty()) {
+      block_size = std::max(block_size, blocks_.back().size * 2);
+    }
+    Block block;
+    block.size = std::max(block_size, needed);
+    block.data.reset(new char[block.size]);
+    blocks_.push_back(std::move(block));
+    used_ = 0;
+  }
+
+  char* result = blocks_.back().data.get() + used_ + kHeaderSize;
+  used_ += needed;
+  SetCapacity(result, capacity);
+  return result;
+}
+
+void* Arena::Reallocate(void* ptr, size_t size) {
+  if (ptr == nullptr) {
+    return Allocate(size);
+  }
+
+  char* allocation = static_cast<char*>(ptr);
+  size_t capacity = GetCapacity(allocation);
+  if (size <= capacity) {
+    return ptr;
+  }
+
+  // The last allocation can grow in place, as long as its block has room.
+  Block& last = blocks_.back();
+  char* end = last.data.get() + used_;
+  size_t growth = RoundUp(size) - capacity;
+  if (allocation + capacity == end && used_ + growth <= last.size) {
+    used_ += growth;
+    SetCapacity(allocation, capacity + growth);
+    return ptr;
+  }
+
+  // nanopb grows repeated fields one element at a time, so leave room to grow
+  // without copying every time.
+  void* result = Allocate(std::max(size, capacity * 2));
+  std::memcpy(result, ptr, capacity);
+  return result;
+}
+
+bool Arena::Owns(const void* ptr) const {
+  const char* p = static_cast<const char*>(ptr);
+  for (const Block& block : blocks_) {
+    const char* data = block.data.get();
+    if (p >= data && p < data + block.size) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Arena::Reset() {
+  if (blocks_.empty()) {
+    return;
+  }
+
+  auto largest = std::max_element(
+      blocks_.begin(), blocks_.end(),
+      [](const Block& lhs, const Block& rhs) { return lhs.size < rhs.size; });
+  Block kept = std::move(*largest);
+  blocks_.clear();
+  blocks_.push_back(std::move(kept));
+  used_ = 0;
+}
+
+size_t Arena::capacity() const {
+  size_t result = 0;
+  for (const Block& block : blocks_) {
+    result += block.size;
+  }
+  return result;
+}
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
+
+using firebase::firestore::nanopb::Arena;
+
+void* firebase_firestore_nanopb_realloc(void* ptr, size_t size) {
+  Arena* arena = Arena::Current();
+  if (arena && (ptr == nullptr || arena->Owns(ptr))) {
+    return arena->Reallocate(ptr, size);
+  }
+  return std::realloc(ptr, size);
+}
+
+void firebase_firestore_nanopb_free(void* ptr) {
+  // Memory from an arena is only freed all at once, when it's reset.
+  Arena* arena = Arena::Current();
+  if (arena && arena->Owns(ptr)) {
+    return;
+  }
+  std::free(ptr);
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_ARENA_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_ARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+
+/**
+ * A bump allocator for the memory nanopb allocates while decoding messages.
+ *
+ * Allocations come out of a few large blocks and are only freed all at once,
+ * by `Reset()`, which keeps the largest block. A loop that decodes a message
+ * per iteration and resets the arena in between therefore stops calling
+ * malloc once the arena has grown to fit the largest message.
+ *
+ * nanopb allocates through `pb_realloc` and `pb_free`, which builds that
+ * define PB_SYSTEM_HEADER as nanopb/pb_system.h route to the arena of the
+ * current `Scope`, if any (see DecodeContext).
+ */
+class Arena {
+ public:
+  /**
+   * Makes the given arena the target of nanopb's allocations on the current
+   * thread for the lifetime of the Scope.
+   */
+  class Scope {
+   public:
+    explicit Scope(Arena* arena);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    Arena* previous_ = nullptr;
+  };
+
+  Arena() = default;
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  /**
+   * Whether nanopb's allocations can be redirected to an arena in this build,
+   * which requires both the allocation hooks and thread_local.
+   */
+  static bool IsSupported();
+
+  /** The arena of the innermost Scope on the current thread, if any. */
+  static Arena* Current();
+
+  /**
+   * Behaves like realloc(). If `ptr` isn't null, it must have been allocated
+   * by this arena.
+   */
+  void* Reallocate(void* ptr, size_t size);
+
+  /** Whether `ptr` points into memory allocated by this arena. */
+  bool Owns(const void* ptr) const;
+
+  /**
+   * Frees everything allocated by this arena, keeping its largest block for
+   * reuse.
+   */
+  void Reset();
+
+  /** The total size of the blocks the arena currently holds. */
+  size_t capacity() const;
+
+ private:
+  struct Block {
+    std::unique_ptr<char[]> data;
+    size_t size = 0;
+  };
+
+  void* Allocate(size_t size);
+
+  std::vector<Block> blocks_;
+
+  /** The number of bytes used in the last block. */
+  size_t used_ = 0;
+};
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_ARENA_H_
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/nanopb/decode_context.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+
+void DecodeContext::ReadNanopbMessage(Reader* reader,
+                                      const pb_field_t fields[],
+                                      void* dest_struct) {
+  if (Arena::IsSupported()) {
+    Arena::Scope scope{&arena_};
+    reader->ReadNanopbMessage(fields, dest_struct);
+  } else {
+    reader->ReadNanopbMessage(fields, dest_struct);
+    messages_.emplace_back(fields, dest_struct);
+  }
+}
+
+void DecodeContext::Reset() {
+  for (const auto& message : messages_) {
+    pb_release(message.first, message.second);
+  }
+  messages_.clear();
+  arena_.Reset();
+}
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
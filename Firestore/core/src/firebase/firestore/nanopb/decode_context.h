@@ -0,0 +1,89 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_DECODE_CONTEXT_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_DECODE_CONTEXT_H_
+
+#include <pb.h>
+
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/nanopb/arena.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+
+/**
+ * Owns the memory of the nanopb messages decoded through it until it's reset,
+ * replacing the ReadNanopbMessage()/FreeNanopbMessage() pairs of a decode loop
+ * with a single Reset() per iteration:
+ *
+ *     DecodeContext context;
+ *     for (...) {
+ *       firestore_client_Target proto{};
+ *       context.ReadNanopbMessage(&reader, firestore_client_Target_fields,
+ *                                 &proto);
+ *       ...
+ *       context.Reset();
+ *     }
+ *
+ * Where supported (see Arena::IsSupported()) everything nanopb allocates while
+ * decoding comes from an arena, so that once the arena fits the largest
+ * message the loop no longer calls malloc or free. Elsewhere the context just
+ * releases the messages it decoded.
+ *
+ * Messages decoded through a context must not be passed to
+ * FreeNanopbMessage(), and must stay alive until the context is reset or
+ * destroyed.
+ */
+class DecodeContext {
+ public:
+  DecodeContext() = default;
+
+  DecodeContext(const DecodeContext&) = delete;
+  DecodeContext& operator=(const DecodeContext&) = delete;
+
+  ~DecodeContext() {
+    Reset();
+  }
+
+  /**
+   * Reads a nanopb message from the given reader, like
+   * Reader::ReadNanopbMessage(), storing any memory it allocates in this
+   * context.
+   */
+  void ReadNanopbMessage(Reader* reader,
+                         const pb_field_t fields[],
+                         void* dest_struct);
+
+  /** Frees the memory of all the messages decoded since the last reset. */
+  void Reset();
+
+ private:
+  Arena arena_;
+
+  /** The messages to release on reset, without an arena. */
+  std::vector<std::pair<const pb_field_t*, void*>> messages_;
+};
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_DECODE_CONTEXT_H_
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_PB_SYSTEM_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_PB_SYSTEM_H_
+
+/*
+ * The system header of nanopb (see PB_SYSTEM_HEADER in pb.h) in builds that
+ * route nanopb's allocations through Arena. This is also compiled as C, as
+ * part of nanopb itself.
+ */
+
+/* The headers nanopb includes by default. */
+#include <stdbool.h>  // NOLINT(build/include)
+#include <stddef.h>  // NOLINT(build/include)
+#include <stdint.h>  // NOLINT(build/include)
+#include <stdlib.h>  // NOLINT(build/include)
+#include <string.h>  // NOLINT(build/include)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Allocate from the current Arena if there is one, or else from the heap. See
+ * arena.cc.
+ */
+void* firebase_firestore_nanopb_realloc(void* ptr, size_t size);
+void firebase_firestore_nanopb_free(void* ptr);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#define pb_realloc(ptr, size) firebase_firestore_nanopb_realloc(ptr, size)
+#define pb_free(ptr) firebase_firestore_nanopb_free(ptr)
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_PB_SYSTEM_H_
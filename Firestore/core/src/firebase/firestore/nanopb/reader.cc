@@ -16,6 +16,11 @@
 
 #include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
 
+#include <algorithm>
+#include <cstring>
+
+#include "absl/memory/memory.h"
+
 namespace firebase {
 namespace firestore {
 namespace nanopb {
@@ -32,6 +37,58 @@ Reader Reader::Wrap(absl::string_view string_view) {
       string_view.size())};
 }
 
+Reader Reader::Wrap(std::vector<absl::string_view> segments) {
+  // A single segment is just a buffer, which nanopb reads more efficiently.
+  if (segments.size() == 1) {
+    return Wrap(segments.front());
+  }
+
+  auto state = absl::make_unique<Segments>();
+  state->segments = std::move(segments);
+  return Reader{std::move(state)};
+}
+
+Reader::Reader(std::unique_ptr<Segments> segments)
+    : segments_(std::move(segments)) {
+  size_t size = 0;
+  for (absl::string_view segment : segments_->segments) {
+    size += segment.size();
+  }
+
+  stream_.callback = ReadSegments;
+  stream_.state = segments_.get();
+  stream_.bytes_left = size;
+#ifndef PB_NO_ERRMSG
+  stream_.errmsg = nullptr;
+#endif
+}
+
+bool Reader::ReadSegments(pb_istream_t* stream,
+                          pb_byte_t* buf,
+                          size_t count) {
+  auto* state = static_cast<Segments*>(stream->state);
+  const std::vector<absl::string_view>& segments = state->segments;
+
+  while (count > 0) {
+    if (state->index == segments.size()) {
+      return false;
+    }
+
+    absl::string_view segment = segments[state->index];
+    size_t n = std::min(count, segment.size() - state->offset);
+    std::memcpy(buf, segment.data() + state->offset, n);
+    buf += n;
+    count -= n;
+    state->offset += n;
+
+    if (state->offset == segment.size()) {
+      state->index++;
+      state->offset = 0;
+    }
+  }
+  return true;
+}
+
 void Reader::ReadNanopbMessage(const pb_field_t fields[], void* dest_struct) {
   if (!status_.ok()) return;
 
@@ -20,6 +20,10 @@
 #include <pb.h>
 #include <pb_decode.h>
 
+#include <memory>
+#include <utility>
+#include <vector>
+
 #include "Firestore/core/include/firebase/firestore/firestore_errors.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "absl/strings/string_view.h"
@@ -58,6 +62,17 @@ class Reader {
    */
   static Reader Wrap(absl::string_view);
 
+  /**
+   * Creates an input stream that reads the given segments in order, as if they
+   * were a single contiguous buffer, without copying them. Note that the
+   * buffers backing the segments must remain valid for the lifetime of this
+   * Reader.
+   *
+   * This allows decoding messages that arrive in several pieces (like the
+   * slices of a grpc::ByteBuffer) without first flattening them.
+   */
+  static Reader Wrap(std::vector<absl::string_view> segments);
+
   /**
    * Reads a nanopb message from the input stream.
    *
@@ -82,12 +97,12 @@ class Reader {
    */
   void FreeNanopbMessage(const pb_field_t fields[], void* dest_struct);
 
-  util::Status status() const {
+  const util::Status& status() const {
     return status_;
   }
 
   void set_status(util::Status status) {
-    status_ = status;
+    status_ = std::move(status);
   }
 
   /**
@@ -111,9 +126,24 @@ class Reader {
   explicit Reader(pb_istream_t stream) : stream_(stream) {
   }
 
+  /** The read position within the segments of a segmented stream. */
+  struct Segments {
+    std::vector<absl::string_view> segments;
+    size_t index = 0;
+    size_t offset = 0;
+  };
+
+  explicit Reader(std::unique_ptr<Segments> segments);
+
+  static bool ReadSegments(pb_istream_t* stream, pb_byte_t* buf, size_t count);
+
   util::Status status_ = util::Status::OK();
 
   pb_istream_t stream_;
+
+  // Owned separately so that `stream_.state` stays valid when the Reader is
+  // moved.
+  std::unique_ptr<Segments> segments_;
 };
 
 }  // namespace nanopb
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/nanopb/wire_reader.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+
+bool WireReader::ReadTag(uint32_t* field_number, pb_wire_type_t* wire_type) {
+  if (!ok_ || rest_.empty()) return false;
+
+  uint64_t tag = ReadVarint();
+  *field_number = static_cast<uint32_t>(tag >> 3);
+  *wire_type = static_cast<pb_wire_type_t>(tag & 7);
+  if (*field_number == 0) {
+    ok_ = false;
+  }
+  return ok_;
+}
+
+absl::string_view WireReader::ReadLengthDelimited() {
+  return ReadBytes(ReadVarint());
+}
+
+void WireReader::SkipField(pb_wire_type_t wire_type) {
+  switch (wire_type) {
+    case PB_WT_VARINT:
+      ReadVarint();
+      return;
+    case PB_WT_64BIT:
+      ReadBytes(8);
+      return;
+    case PB_WT_STRING:
+      ReadLengthDelimited();
+      return;
+    case PB_WT_32BIT:
+      ReadBytes(4);
+      return;
+  }
+  // Groups are not supported by proto3 (or nanopb).
+  ok_ = false;
+}
+
+uint64_t WireReader::ReadVarint() {
+  uint64_t result = 0;
+  for (int shift = 0; ok_ && shift < 64; shift += 7) {
+    if (rest_.empty()) break;
+
+    uint8_t byte = static_cast<uint8_t>(rest_.front());
+    rest_.remove_prefix(1);
+    result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) return result;
+  }
+  ok_ = false;
+  return 0;
+}
+
+absl::string_view WireReader::ReadBytes(uint64_t size) {
+  if (!ok_ || size > rest_.size()) {
+    ok_ = false;
+    return {};
+  }
+  absl::string_view result = rest_.substr(0, static_cast<size_t>(size));
+  rest_.remove_prefix(static_cast<size_t>(size));
+  return result;
+}
+
+absl::optional<absl::string_view> FindLengthDelimitedField(
+    absl::string_view message, uint32_t field_number) {
+  absl::optional<absl::string_view> result;
+
+  WireReader reader{message};
+  uint32_t current_field = 0;
+  pb_wire_type_t wire_type = PB_WT_VARINT;
+  while (reader.ReadTag(&current_field, &wire_type)) {
+    if (current_field == field_number && wire_type == PB_WT_STRING) {
+      result = reader.ReadLengthDelimited();
+    } else {
+      reader.SkipField(wire_type);
+    }
+  }
+
+  if (!reader.ok()) return absl::nullopt;
+  return result;
+}
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
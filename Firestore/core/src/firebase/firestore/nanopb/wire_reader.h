@@ -0,0 +1,100 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_WIRE_READER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_WIRE_READER_H_
+
+#include <pb.h>
+
+#include <cstdint>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+
+/**
+ * Walks the top-level fields of an encoded protocol buffer message without
+ * decoding it, so that individual fields (typically submessages) can be located
+ * and then decoded on their own with a Reader.
+ *
+ * Returned string_views point into the bytes given to the constructor, which
+ * must outlive them.
+ */
+class WireReader {
+ public:
+  explicit WireReader(absl::string_view bytes) : rest_(bytes) {
+  }
+
+  /**
+   * Advances to the next field, returning false at the end of the message or
+   * if the message is malformed (in which case `ok()` becomes false).
+   *
+   * @param field_number Receives the field number of the tag.
+   * @param wire_type Receives the wire type of the tag, one of PB_WT_*.
+   */
+  bool ReadTag(uint32_t* field_number, pb_wire_type_t* wire_type);
+
+  /**
+   * Reads the value of the current field, which must have wire type
+   * PB_WT_STRING (i.e. a string, bytes or submessage field).
+   */
+  absl::string_view ReadLengthDelimited();
+
+  /**
+   * Reads a varint, such as the value of the current field if its wire type is
+   * PB_WT_VARINT. Values of signed fields are returned as their bit pattern.
+   */
+  uint64_t ReadVarint();
+
+  /** Skips the value of the current field, which has the given wire type. */
+  void SkipField(pb_wire_type_t wire_type);
+
+  bool ok() const {
+    return ok_;
+  }
+
+  /**
+   * The bytes that haven't been read yet. Comparing this before and after
+   * reading a field gives the field's encoding, so it can be copied verbatim.
+   */
+  absl::string_view remaining() const {
+    return rest_;
+  }
+
+ private:
+  absl::string_view ReadBytes(uint64_t size);
+
+  absl::string_view rest_;
+  bool ok_ = true;
+};
+
+/**
+ * Returns the value of the last occurrence of the given length-delimited field
+ * in the encoded message (protobuf parsers treat a repeated occurrence of a
+ * singular field as overriding the earlier ones), or absl::nullopt if there is
+ * none or the message is malformed.
+ */
+absl::optional<absl::string_view> FindLengthDelimitedField(
+    absl::string_view message, uint32_t field_number);
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_WIRE_READER_H_
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/nanopb/wire_writer.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+
+void WireWriter::WriteVarint(uint64_t value) {
+  char buffer[10];
+  size_t size = 0;
+  while (value >= 0x80) {
+    buffer[size++] = static_cast<char>((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  buffer[size++] = static_cast<char>(value);
+  out_->append(buffer, size);
+}
+
+void WireWriter::WriteFixed64(uint64_t value) {
+  // Fixed-width fields are always little endian, regardless of the host.
+  char buffer[8];
+  for (char& byte : buffer) {
+    byte = static_cast<char>(value & 0xff);
+    value >>= 8;
+  }
+  out_->append(buffer, sizeof(buffer));
+}
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_WIRE_WRITER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_WIRE_WRITER_H_
+
+#include <pb.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+
+/**
+ * Appends protocol buffer wire format to a string, one field at a time. This
+ * is the counterpart of WireReader, for encoders that write model objects
+ * directly instead of going through nanopb structs.
+ *
+ * The caller is responsible for knowing the size of each submessage before
+ * writing it, since the length prefix comes first. The `*Size` functions
+ * compute the sizes of individual fields for that purpose.
+ */
+class WireWriter {
+ public:
+  /**
+   * Creates a writer that appends to `out`, which must outlive the writer.
+   */
+  explicit WireWriter(std::string* out) : out_(out) {
+  }
+
+  void WriteTag(uint32_t field_number, pb_wire_type_t wire_type) {
+    WriteVarint((static_cast<uint64_t>(field_number) << 3) | wire_type);
+  }
+
+  void WriteVarint(uint64_t value);
+
+  void WriteFixed64(uint64_t value);
+
+  /** Writes the length prefix and contents of a string or bytes field. */
+  void WriteLengthDelimited(absl::string_view bytes) {
+    WriteVarint(bytes.size());
+    out_->append(bytes.data(), bytes.size());
+  }
+
+  /** Returns the number of bytes WriteVarint(value) writes. */
+  static size_t VarintSize(uint64_t value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+      value >>= 7;
+      size++;
+    }
+    return size;
+  }
+
+  /** Returns the number of bytes WriteTag(field_number, ...) writes. */
+  static size_t TagSize(uint32_t field_number) {
+    return VarintSize(static_cast<uint64_t>(field_number) << 3);
+  }
+
+  /**
+   * Returns the size of a whole length-delimited field (tag, length prefix
+   * and contents) whose contents are `size` bytes long.
+   */
+  static size_t LengthDelimitedFieldSize(uint32_t field_number, size_t size) {
+    return TagSize(field_number) + VarintSize(size) + size;
+  }
+
+ private:
+  std::string* out_ = nullptr;
+};
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_WIRE_WRITER_H_
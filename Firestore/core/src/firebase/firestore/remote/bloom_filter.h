@@ -0,0 +1,91 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_BLOOM_FILTER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_BLOOM_FILTER_H_
+
+#include <cstdint>
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * A read-only bloom filter over the resource names of the documents matching a
+ * target, as sent by Watch alongside an existence filter.
+ *
+ * Bit positions are derived by double hashing: the MD5 digest of a document
+ * name is split into two little-endian 64-bit integers `h1` and `h2`, and the
+ * `i`-th position is `(h1 + i * h2) % bit_count()`. Bit `n` lives in bit
+ * `n % 8` of byte `n / 8` of the bitmap.
+ */
+class BloomFilter {
+ public:
+  BloomFilter() = default;
+
+  /**
+   * Creates a bloom filter from its wire representation, or returns an
+   * `InvalidArgument` status if the parameters are inconsistent.
+   *
+   * @param bitmap The bits of the filter.
+   * @param padding The number of unused bits at the end of the last byte of
+   *     `bitmap`; must be zero if `bitmap` is empty.
+   * @param hash_count The number of bit positions set for each document name.
+   */
+  static util::StatusOr<BloomFilter> Create(std::string bitmap,
+                                            int32_t padding,
+                                            int32_t hash_count);
+
+  /** The number of usable bits in the filter. */
+  int64_t bit_count() const {
+    return bit_count_;
+  }
+
+  int32_t hash_count() const {
+    return hash_count_;
+  }
+
+  /**
+   * Returns false if `document_name` is definitely not in the filter, true if
+   * it may be. An empty filter contains nothing.
+   */
+  bool MightContain(absl::string_view document_name) const;
+
+  friend bool operator==(const BloomFilter& lhs, const BloomFilter& rhs);
+
+ private:
+  BloomFilter(std::string bitmap, int64_t bit_count, int32_t hash_count);
+
+  bool IsBitSet(uint64_t index) const;
+
+  std::string bitmap_;
+  int64_t bit_count_ = 0;
+  int32_t hash_count_ = 0;
+};
+
+inline bool operator!=(const BloomFilter& lhs, const BloomFilter& rhs) {
+  return !(lhs == rhs);
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_BLOOM_FILTER_H_
@@ -31,9 +31,12 @@
 #include "Firestore/core/src/firebase/firestore/auth/credentials_provider.h"
 #include "Firestore/core/src/firebase/firestore/auth/token.h"
 #include "Firestore/core/src/firebase/firestore/core/database_info.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/remote/connectivity_monitor.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_call.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_connection.h"
+#include "Firestore/core/src/firebase/firestore/remote/grpc_shared_resources.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_objc_bridge.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_stream.h"
 #include "Firestore/core/src/firebase/firestore/remote/write_stream.h"
@@ -72,6 +75,8 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
   // this function could take a single `StatusOr` parameter.
   using LookupCallback = std::function<void(
       const std::vector<FSTMaybeDocument*>&, const util::Status&)>;
+  using LookupDocumentCallback = std::function<void(FSTMaybeDocument*)>;
+  using LookupFinishedCallback = std::function<void(const util::Status&)>;
   using CommitCallback = std::function<void(const util::Status&)>;
 
   Datastore(const core::DatabaseInfo& database_info,
@@ -81,8 +86,36 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
   virtual ~Datastore() {
   }
 
+  /** The project/database this `Datastore` talks to. */
+  const model::DatabaseId& database_id() const {
+    return database_id_;
+  }
+
+  /**
+   * Whether streams and calls created from now on gzip the messages they
+   * send.
+   */
+  void set_compression_enabled(bool value) {
+    grpc_connection_.set_compression_enabled(value);
+  }
+
+  /** Returns the counts of the messages exchanged with the backend so far. */
+  const GrpcTrafficStats& traffic_stats() const {
+    return grpc_connection_.traffic_stats();
+  }
+
   /** Starts polling the gRPC completion queue. */
   void Start();
+  /**
+   * Starts connecting to the backend right away rather than when the first
+   * stream or call is created.
+   */
+  void Preconnect();
+  /**
+   * Invokes `callback` on the worker queue whenever the network connectivity
+   * changes, after the connection's calls have been failed with `Unavailable`.
+   */
+  void AddConnectivityCallback(ConnectivityMonitor::Callback&& callback);
   /** Cancels any pending gRPC calls and drains the gRPC completion queue. */
   void Shutdown();
 
@@ -101,8 +134,25 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
 
   void CommitMutations(const std::vector<FSTMutation*>& mutations,
                        CommitCallback&& callback);
+  /**
+   * Fetches the documents with the given keys and invokes `callback` with all
+   * of them, sorted by key, once the lookup has finished.
+   */
   void LookupDocuments(const std::vector<model::DocumentKey>& keys,
                        LookupCallback&& callback);
+  /**
+   * Fetches the documents with the given keys, handing each one to
+   * `on_document` as soon as it arrives (in no particular order);
+   * `on_finish` is invoked once all the documents have been delivered or, with
+   * an error, as soon as the lookup fails. No documents are delivered after a
+   * failure.
+   *
+   * Large key sets are split into several `BatchGetDocuments` calls that run
+   * concurrently.
+   */
+  void LookupDocumentsStreaming(const std::vector<model::DocumentKey>& keys,
+                                LookupDocumentCallback&& on_document,
+                                LookupFinishedCallback&& on_finish);
 
   /** Returns true if the given error is a gRPC ABORTED error. */
   static bool IsAbortedError(const util::Status& status);
@@ -147,7 +197,7 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
 
   /** Test-only method */
   grpc::CompletionQueue* grpc_queue() {
-    return &grpc_queue_;
+    return grpc_resources_->queue();
   }
   /** Test-only method */
   GrpcCall* LastCall() {
@@ -160,7 +210,11 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
   }
 
  private:
-  void PollGrpcQueue();
+  Datastore(const core::DatabaseInfo& database_info,
+            util::AsyncQueue* worker_queue,
+            auth::CredentialsProvider* credentials,
+            std::unique_ptr<ConnectivityMonitor> connectivity_monitor,
+            std::shared_ptr<GrpcSharedResources> grpc_resources);
 
   void CommitMutationsWithCredentials(
       const auth::Token& token,
@@ -170,10 +224,8 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
   void LookupDocumentsWithCredentials(
       const auth::Token& token,
       const std::vector<model::DocumentKey>& keys,
-      LookupCallback&& callback);
-  void OnLookupDocumentsResponse(
-      const util::StatusOr<std::vector<grpc::ByteBuffer>>& result,
-      const LookupCallback& callback);
+      LookupDocumentCallback&& on_document,
+      LookupFinishedCallback&& on_finish);
 
   using OnCredentials = std::function<void(const util::StatusOr<auth::Token>&)>;
   void ResumeRpcWithCredentials(const OnCredentials& on_token);
@@ -189,13 +241,14 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
   // down.
   bool is_shut_down_ = false;
 
+  model::DatabaseId database_id_;
   util::AsyncQueue* worker_queue_ = nullptr;
   auth::CredentialsProvider* credentials_ = nullptr;
 
-  // A separate executor dedicated to polling gRPC completion queue (which is
-  // shared for all spawned gRPC streams and calls).
-  std::unique_ptr<util::Executor> rpc_executor_;
-  grpc::CompletionQueue grpc_queue_;
+  // The gRPC completion queue (which is shared for all spawned gRPC streams
+  // and calls, and with other `Datastore`s talking to the same host), the
+  // executor dedicated to polling it, and the channel.
+  std::shared_ptr<GrpcSharedResources> grpc_resources_;
   // TODO(varconst): move `ConnectivityMonitor` to `FSTFirestoreClient`.
   std::unique_ptr<ConnectivityMonitor> connectivity_monitor_;
   GrpcConnection grpc_connection_;
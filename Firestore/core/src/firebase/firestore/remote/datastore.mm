@@ -16,9 +16,12 @@
 
 #include "Firestore/core/src/firebase/firestore/remote/datastore.h"
 
+#include <algorithm>
+#include <map>
 #include <unordered_set>
 #include <utility>
 
+#import "Firestore/Source/Model/FSTDocument.h"
 #import "Firestore/Source/Remote/FSTSerializerBeta.h"
 
 #include "Firestore/core/include/firebase/firestore/firestore_errors.h"
@@ -36,6 +39,7 @@
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/error_apple.h"
 #include "Firestore/core/src/firebase/firestore/util/executor_libdispatch.h"
+#include "Firestore/core/src/firebase/firestore/util/future.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
@@ -55,12 +59,16 @@ using util::Status;
 using util::StatusOr;
 using util::Executor;
 using util::ExecutorLibdispatch;
+using util::Promise;
 
 namespace {
 
 const auto kRpcNameCommit = "/google.firestore.v1.Firestore/Commit";
 const auto kRpcNameLookup = "/google.firestore.v1.Firestore/BatchGetDocuments";
 
+// Lookups of more keys than this are split into several concurrent calls.
+const size_t kMaxLookupKeysPerCall = 100;
+
 std::unique_ptr<Executor> CreateExecutor() {
   auto queue = dispatch_queue_create("com.google.firebase.firestore.rpc",
                                      DISPATCH_QUEUE_SERIAL);
@@ -93,19 +101,32 @@ Datastore::Datastore(const DatabaseInfo& database_info,
                      AsyncQueue* worker_queue,
                      CredentialsProvider* credentials)
     : Datastore{database_info, worker_queue, credentials,
-                ConnectivityMonitor::Create(worker_queue)} {
+                ConnectivityMonitor::Create(worker_queue),
+                GrpcSharedResources::Acquire(database_info.host(),
+                                             CreateExecutor)} {
 }
 
 Datastore::Datastore(const DatabaseInfo& database_info,
                      AsyncQueue* worker_queue,
                      CredentialsProvider* credentials,
                      std::unique_ptr<ConnectivityMonitor> connectivity_monitor)
-    : worker_queue_{NOT_NULL(worker_queue)},
+    : Datastore{database_info, worker_queue, credentials,
+                std::move(connectivity_monitor),
+                GrpcSharedResources::CreateUnshared(CreateExecutor())} {
+}
+
+Datastore::Datastore(const DatabaseInfo& database_info,
+                     AsyncQueue* worker_queue,
+                     CredentialsProvider* credentials,
+                     std::unique_ptr<ConnectivityMonitor> connectivity_monitor,
+                     std::shared_ptr<GrpcSharedResources> grpc_resources)
+    : database_id_{database_info.database_id()},
+      worker_queue_{NOT_NULL(worker_queue)},
       credentials_{credentials},
-      rpc_executor_{CreateExecutor()},
+      grpc_resources_{std::move(grpc_resources)},
       connectivity_monitor_{std::move(connectivity_monitor)},
-      grpc_connection_{database_info, worker_queue, &grpc_queue_,
-                       connectivity_monitor_.get()},
+      grpc_connection_{database_info, worker_queue, grpc_resources_->queue(),
+                       connectivity_monitor_.get(), grpc_resources_.get()},
       serializer_bridge_{database_info} {
   if (!database_info.ssl_enabled()) {
     GrpcConnection::UseInsecureChannel(database_info.host());
@@ -113,41 +134,29 @@ Datastore::Datastore(const DatabaseInfo& database_info,
 }
 
 void Datastore::Start() {
-  rpc_executor_->Execute([this] { PollGrpcQueue(); });
+  grpc_resources_->StartPolling();
+}
+
+void Datastore::Preconnect() {
+  grpc_connection_.Preconnect();
+}
+
+void Datastore::AddConnectivityCallback(
+    ConnectivityMonitor::Callback&& callback) {
+  // `grpc_connection_` registered its callback on construction, so it always
+  // runs first.
+  connectivity_monitor_->AddCallback(std::move(callback));
 }
 
 void Datastore::Shutdown() {
   is_shut_down_ = true;
 
   // Order matters here: shutting down `grpc_connection_`, which will quickly
-  // finish any pending gRPC calls, must happen before shutting down the gRPC
-  // queue.
+  // finish any pending gRPC calls, must happen before releasing the gRPC
+  // queue. Once the last `Datastore` sharing the queue releases it, the queue
+  // is shut down and drained.
   grpc_connection_.Shutdown();
-
-  // `grpc::CompletionQueue::Next` will only return `false` once `Shutdown` has
-  // been called and all submitted tags have been extracted. Without this call,
-  // `rpc_executor_` will never finish.
-  grpc_queue_.Shutdown();
-  // Drain the executor to make sure it extracted all the operations from gRPC
-  // completion queue.
-  rpc_executor_->ExecuteBlocking([] {});
-}
-
-void Datastore::PollGrpcQueue() {
-  HARD_ASSERT(rpc_executor_->IsCurrentExecutor(),
-              "PollGrpcQueue should only be called on the "
-              "dedicated Datastore executor");
-
-  void* tag = nullptr;
-  bool ok = false;
-  while (grpc_queue_.Next(&tag, &ok)) {
-    auto completion = static_cast<GrpcCompletion*>(tag);
-    // While it's valid in principle, we never deliberately pass a null pointer
-    // to gRPC completion queue and expect it back. This assertion might be
-    // relaxed if necessary.
-    HARD_ASSERT(tag, "gRPC queue returned a null tag");
-    completion->Complete(ok);
-  }
+  grpc_resources_.reset();
 }
 
 std::shared_ptr<WatchStream> Datastore::CreateWatchStream(
@@ -206,84 +215,156 @@ void Datastore::CommitMutationsWithCredentials(
 
 void Datastore::LookupDocuments(const std::vector<DocumentKey>& keys,
                                 LookupCallback&& callback) {
+  // Sort by key.
+  auto results = std::make_shared<std::map<DocumentKey, FSTMaybeDocument*>>();
+
+  // TODO(c++14): move into lambda.
+  LookupDocumentsStreaming(
+      keys, [results](FSTMaybeDocument* doc) { (*results)[doc.key] = doc; },
+      [results, callback](const Status& status) {
+        if (!status.ok()) {
+          callback({}, status);
+          return;
+        }
+
+        std::vector<FSTMaybeDocument*> docs;
+        docs.reserve(results->size());
+        for (const auto& kv : *results) {
+          docs.push_back(kv.second);
+        }
+        callback(docs, Status::OK());
+      });
+}
+
+void Datastore::LookupDocumentsStreaming(
+    const std::vector<DocumentKey>& keys,
+    LookupDocumentCallback&& on_document,
+    LookupFinishedCallback&& on_finish) {
   ResumeRpcWithCredentials(
       // TODO(c++14): move into lambda.
-      [this, keys, callback](const StatusOr<Token>& maybe_credentials) mutable {
+      [this, keys, on_document,
+       on_finish](const StatusOr<Token>& maybe_credentials) mutable {
         if (!maybe_credentials.ok()) {
-          callback({}, maybe_credentials.status());
+          on_finish(maybe_credentials.status());
           return;
         }
         LookupDocumentsWithCredentials(maybe_credentials.ValueOrDie(), keys,
-                                       std::move(callback));
+                                       std::move(on_document),
+                                       std::move(on_finish));
       });
 }
 
-void Datastore::LookupDocumentsWithCredentials(
-    const Token& token,
-    const std::vector<DocumentKey>& keys,
-    LookupCallback&& callback) {
-  grpc::ByteBuffer message = serializer_bridge_.ToByteBuffer(
-      serializer_bridge_.CreateLookupRequest(keys));
-
-  std::unique_ptr<GrpcStreamingReader> call_owning =
-      grpc_connection_.CreateStreamingReader(kRpcNameLookup, token,
-                                             std::move(message));
-  GrpcStreamingReader* call = call_owning.get();
-  active_calls_.push_back(std::move(call_owning));
+namespace {
 
-  // TODO(c++14): move into lambda.
-  call->Start([this, call, callback](
-                  const StatusOr<std::vector<grpc::ByteBuffer>>& result) {
-    LogGrpcCallFinished("BatchGetDocuments", call, result.status());
-    HandleCallStatus(result.status());
+/** The state shared by all the calls a single lookup is split into. */
+struct LookupProgress {
+  void Finish(const Status& status) {
+    if (finished) {
+      return;
+    }
+    finished = true;
+    on_finish(status);
+  }
 
-    OnLookupDocumentsResponse(result, callback);
+  Datastore::LookupDocumentCallback on_document;
+  Datastore::LookupFinishedCallback on_finish;
+  size_t pending_calls = 0;
+  bool finished = false;
+};
 
-    RemoveGrpcCall(call);
-  });
-}
+}  // namespace
 
-void Datastore::OnLookupDocumentsResponse(
-    const StatusOr<std::vector<grpc::ByteBuffer>>& result,
-    const LookupCallback& callback) {
-  if (!result.ok()) {
-    callback({}, result.status());
-    return;
+void Datastore::LookupDocumentsWithCredentials(
+    const Token& token,
+    const std::vector<DocumentKey>& keys,
+    LookupDocumentCallback&& on_document,
+    LookupFinishedCallback&& on_finish) {
+  std::vector<std::vector<DocumentKey>> chunks;
+  for (size_t begin = 0; begin < keys.size();
+       begin += kMaxLookupKeysPerCall) {
+    size_t end = std::min(keys.size(), begin + kMaxLookupKeysPerCall);
+    chunks.emplace_back(keys.begin() + begin, keys.begin() + end);
+  }
+  if (chunks.empty()) {
+    // An empty lookup still makes a (trivial) call to the backend.
+    chunks.emplace_back();
   }
 
-  Status parse_status;
-  std::vector<grpc::ByteBuffer> responses = std::move(result).ValueOrDie();
-  std::vector<FSTMaybeDocument*> docs =
-      serializer_bridge_.MergeLookupResponses(responses, &parse_status);
-  callback(docs, parse_status);
+  auto progress = std::make_shared<LookupProgress>();
+  progress->on_document = std::move(on_document);
+  progress->on_finish = std::move(on_finish);
+  progress->pending_calls = chunks.size();
+
+  for (const std::vector<DocumentKey>& chunk : chunks) {
+    grpc::ByteBuffer message = serializer_bridge_.ToByteBuffer(
+        serializer_bridge_.CreateLookupRequest(chunk));
+
+    std::unique_ptr<GrpcStreamingReader> call_owning =
+        grpc_connection_.CreateStreamingReader(kRpcNameLookup, token,
+                                               std::move(message));
+    GrpcStreamingReader* call = call_owning.get();
+    active_calls_.push_back(std::move(call_owning));
+
+    call->Start(
+        [this, progress](const grpc::ByteBuffer& response) {
+          // Once one of the calls fails, the responses to the others (which
+          // are left to run to completion) are ignored.
+          if (progress->finished) {
+            return;
+          }
+
+          Status parse_status;
+          FSTMaybeDocument* doc =
+              serializer_bridge_.ToMaybeDocument(response, &parse_status);
+          if (!parse_status.ok()) {
+            progress->Finish(parse_status);
+            return;
+          }
+          progress->on_document(doc);
+        },
+        [this, call,
+         progress](const StatusOr<std::vector<grpc::ByteBuffer>>& result) {
+          LogGrpcCallFinished("BatchGetDocuments", call, result.status());
+          HandleCallStatus(result.status());
+
+          --progress->pending_calls;
+          if (!result.ok() || progress->pending_calls == 0) {
+            progress->Finish(result.status());
+          }
+
+          RemoveGrpcCall(call);
+        });
+  }
 }
 
 void Datastore::ResumeRpcWithCredentials(const OnCredentials& on_credentials) {
   // Auth may outlive Firestore
   std::weak_ptr<Datastore> weak_this{shared_from_this()};
 
-  credentials_->GetToken(
-      [weak_this, on_credentials](const StatusOr<Token>& result) {
+  // Tokens that are available right away (and are requested on the worker
+  // queue) are handled without another hop onto the queue.
+  Promise<StatusOr<Token>> token;
+  token.GetFuture().Then(
+      worker_queue_, [weak_this, on_credentials](StatusOr<Token> result) {
         auto strong_this = weak_this.lock();
         if (!strong_this) {
           return;
         }
+        // In case Auth callback is invoked after Datastore has been shut down.
+        if (strong_this->is_shut_down_) {
+          return;
+        }
 
-        strong_this->worker_queue_->EnqueueRelaxed(
-            [weak_this, result, on_credentials] {
-              auto strong_this = weak_this.lock();
-              if (!strong_this) {
-                return;
-              }
-              // In case Auth callback is invoked after Datastore has been shut
-              // down.
-              if (strong_this->is_shut_down_) {
-                return;
-              }
-
-              on_credentials(result);
-            });
+        on_credentials(result);
       });
+
+  credentials_->GetToken([weak_this, token](const StatusOr<Token>& result) {
+    // The worker queue may be gone along with the Datastore.
+    if (!weak_this.lock()) {
+      return;
+    }
+    token.SetValue(result);
+  });
 }
 
 void Datastore::HandleCallStatus(const Status& status) {
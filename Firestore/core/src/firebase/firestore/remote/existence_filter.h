@@ -17,6 +17,11 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_EXISTENCE_FILTER_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_EXISTENCE_FILTER_H_
 
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/remote/bloom_filter.h"
+#include "absl/types/optional.h"
+
 namespace firebase {
 namespace firestore {
 namespace remote {
@@ -27,16 +32,29 @@ class ExistenceFilter {
   explicit ExistenceFilter(int count) : count_{count} {
   }
 
+  /**
+   * Creates an existence filter that also carries a bloom filter over the
+   * resource names of the documents matching the target.
+   */
+  ExistenceFilter(int count, BloomFilter bloom_filter)
+      : count_{count}, bloom_filter_{std::move(bloom_filter)} {
+  }
+
   int count() const {
     return count_;
   }
 
+  const absl::optional<BloomFilter>& bloom_filter() const {
+    return bloom_filter_;
+  }
+
  private:
   int count_ = 0;
+  absl::optional<BloomFilter> bloom_filter_;
 };
 
 inline bool operator==(const ExistenceFilter& lhs, const ExistenceFilter& rhs) {
-  return lhs.count() == rhs.count();
+  return lhs.count() == rhs.count() && lhs.bloom_filter() == rhs.bloom_filter();
 }
 
 }  // namespace remote
@@ -38,38 +38,86 @@ void GrpcCompletion::Cancel() {
 void GrpcCompletion::WaitUntilOffQueue() {
   worker_queue_->VerifyIsCurrentQueue();
 
-  EnsureValidFuture();
-  return off_queue_future_.wait();
+  std::unique_lock<std::mutex> lock{off_queue_mutex_};
+  off_queue_condition_.wait(lock, [this] { return off_queue_; });
 }
 
 std::future_status GrpcCompletion::WaitUntilOffQueue(
     std::chrono::milliseconds timeout) {
   worker_queue_->VerifyIsCurrentQueue();
 
-  EnsureValidFuture();
-  return off_queue_future_.wait_for(timeout);
-}
-
-void GrpcCompletion::EnsureValidFuture() {
-  if (!off_queue_future_.valid()) {
-    off_queue_future_ = off_queue_.get_future();
-  }
+  std::unique_lock<std::mutex> lock{off_queue_mutex_};
+  bool off_queue = off_queue_condition_.wait_for(
+      lock, timeout, [this] { return off_queue_; });
+  return off_queue ? std::future_status::ready : std::future_status::timeout;
 }
 
 void GrpcCompletion::Complete(bool ok) {
   // This mechanism allows `GrpcStream` to know when the completion is off the
   // gRPC completion queue (and thus no longer requires the underlying gRPC
   // objects to be valid).
-  off_queue_.set_value();
+  {
+    std::lock_guard<std::mutex> lock{off_queue_mutex_};
+    off_queue_ = true;
+  }
+  off_queue_condition_.notify_all();
 
   worker_queue_->Enqueue([this, ok] {
     if (callback_) {
       callback_(ok, this);
     }
-    delete this;
+    Release();
   });
 }
 
+void GrpcCompletion::Release() {
+  if (!pool_) {
+    delete this;
+    return;
+  }
+
+  // The pool doesn't keep itself alive through the completions it holds.
+  std::shared_ptr<GrpcCompletionPool> pool = std::move(pool_);
+  pool->Release(std::unique_ptr<GrpcCompletion>{this});
+}
+
+namespace {
+
+// A stream has a read and a write in flight at most, and each is replaced
+// while its callback runs, so few completions are ever done at once.
+const size_t kMaxPooledCompletions = 4;
+
+}  // namespace
+
+GrpcCompletion* GrpcCompletionPool::Acquire(
+    GrpcCompletion::Type type, GrpcCompletion::Callback&& callback) {
+  worker_queue_->VerifyIsCurrentQueue();
+
+  GrpcCompletion* completion = nullptr;
+  if (free_.empty()) {
+    completion = new GrpcCompletion{type, worker_queue_, std::move(callback)};
+  } else {
+    completion = free_.back().release();
+    free_.pop_back();
+    completion->type_ = type;
+    completion->callback_ = std::move(callback);
+  }
+  completion->pool_ = shared_from_this();
+  return completion;
+}
+
+void GrpcCompletionPool::Release(std::unique_ptr<GrpcCompletion> completion) {
+  if (free_.size() == kMaxPooledCompletions) {
+    return;
+  }
+
+  completion->callback_ = {};
+  completion->message_.Clear();
+  completion->status_ = grpc::Status{};
+  completion->off_queue_ = false;
+  free_.push_back(std::move(completion));
+}
+
 }  // namespace remote
 }  // namespace firestore
 }  // namespace firebase
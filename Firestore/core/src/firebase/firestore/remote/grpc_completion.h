@@ -18,9 +18,13 @@
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_COMPLETION_H_
 
 #include <chrono>  // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
 #include <functional>
 #include <future>  // NOLINT(build/c++11)
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
@@ -30,6 +34,8 @@ namespace firebase {
 namespace firestore {
 namespace remote {
 
+class GrpcCompletionPool;
+
 /**
  * A completion for a gRPC asynchronous operation that runs an arbitrary
  * callback.
@@ -48,7 +54,8 @@ namespace remote {
  * gRPC operation.
  *
  * `GrpcCompletion` is "self-owned"; `GrpcCompletion` deletes itself in its
- * `Complete` method.
+ * `Complete` method, or, if it came from a `GrpcCompletionPool`, returns itself
+ * to the pool.
  *
  * `GrpcCompletion` expects all gRPC objects pertaining to the current stream to
  * remain valid until the `GrpcCompletion` comes back from the gRPC completion
@@ -117,7 +124,9 @@ class GrpcCompletion {
   util::AsyncQueue* worker_queue_ = nullptr;
   Callback callback_;
 
-  void EnsureValidFuture();
+  friend class GrpcCompletionPool;
+
+  void Release();
 
   // Note that even though `grpc::GenericClientAsyncReaderWriter::Write` takes
   // the byte buffer by const reference, it expects the buffer's lifetime to
@@ -127,10 +136,43 @@ class GrpcCompletion {
   grpc::ByteBuffer message_;
   grpc::Status status_;
 
-  std::promise<void> off_queue_;
-  std::future<void> off_queue_future_;
+  // Unlike a promise, these don't allocate shared state for every operation.
+  std::mutex off_queue_mutex_;
+  std::condition_variable off_queue_condition_;
+  bool off_queue_ = false;
 
   Type type_{};
+
+  // The pool to return to once done, if the completion came from one.
+  std::shared_ptr<GrpcCompletionPool> pool_;
+};
+
+/**
+ * Recycles the `GrpcCompletion`s of a stream, so that the operations it keeps
+ * issuing, like the read that is always pending, don't allocate new ones.
+ *
+ * The pool is shared by the stream and the completions it issued, since those
+ * can finish running on the worker queue after the stream is gone. It must
+ * only be used on the worker queue.
+ */
+class GrpcCompletionPool
+    : public std::enable_shared_from_this<GrpcCompletionPool> {
+ public:
+  explicit GrpcCompletionPool(util::AsyncQueue* worker_queue)
+      : worker_queue_{worker_queue} {
+  }
+
+  /** Like `new GrpcCompletion`, but reuses a completion that's done if any. */
+  GrpcCompletion* Acquire(GrpcCompletion::Type type,
+                          GrpcCompletion::Callback&& callback);
+
+ private:
+  friend class GrpcCompletion;
+
+  void Release(std::unique_ptr<GrpcCompletion> completion);
+
+  util::AsyncQueue* worker_queue_ = nullptr;
+  std::vector<std::unique_ptr<GrpcCompletion>> free_;
 };
 
 }  // namespace remote
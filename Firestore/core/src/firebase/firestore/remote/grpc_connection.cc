@@ -82,11 +82,13 @@ bool HasSpecialConfig(const std::string& host) {
 GrpcConnection::GrpcConnection(const DatabaseInfo& database_info,
                                util::AsyncQueue* worker_queue,
                                grpc::CompletionQueue* grpc_queue,
-                               ConnectivityMonitor* connectivity_monitor)
+                               ConnectivityMonitor* connectivity_monitor,
+                               GrpcSharedResources* shared_resources)
     : database_info_{&database_info},
       worker_queue_{NOT_NULL(worker_queue)},
       grpc_queue_{NOT_NULL(grpc_queue)},
-      connectivity_monitor_{NOT_NULL(connectivity_monitor)} {
+      connectivity_monitor_{NOT_NULL(connectivity_monitor)},
+      shared_resources_{shared_resources} {
   RegisterConnectivityMonitor();
 }
 
@@ -127,10 +129,32 @@ std::unique_ptr<grpc::ClientContext> GrpcConnection::CreateContext(
   context->AddMetadata(kGoogleCloudResourcePrefix,
                        StringFormat("projects/%s/databases/%s",
                                     db_id.project_id(), db_id.database_id()));
+
+  if (compression_enabled_) {
+    context->set_compression_algorithm(GRPC_COMPRESS_GZIP);
+  }
   return context;
 }
 
+void GrpcConnection::Preconnect() {
+  EnsureActiveStub();
+  // Querying the state with `try_to_connect` makes an idle channel start
+  // connecting.
+  grpc_channel_->GetState(/*try_to_connect=*/true);
+}
+
 void GrpcConnection::EnsureActiveStub() {
+  if (shared_resources_) {
+    std::shared_ptr<grpc::Channel> channel =
+        shared_resources_->GetChannel([this] { return CreateChannel(); });
+    if (channel != grpc_channel_) {
+      LOG_DEBUG("Creating Firestore stub.");
+      grpc_channel_ = std::move(channel);
+      grpc_stub_ = absl::make_unique<grpc::GenericStub>(grpc_channel_);
+    }
+    return;
+  }
+
   // TODO(varconst): find out in which cases a gRPC channel might shut down.
   // This might be overkill.
   if (!grpc_channel_ || grpc_channel_->GetState(/*try_to_connect=*/false) ==
@@ -209,6 +233,21 @@ std::unique_ptr<GrpcStreamingReader> GrpcConnection::CreateStreamingReader(
       std::move(context), std::move(call), worker_queue_, this, message);
 }
 
+void GrpcConnection::RecordMessageSent(const grpc::ByteBuffer& message,
+                                       const grpc::ClientContext& context) {
+  auto size = static_cast<int64_t>(message.Length());
+  ++traffic_stats_.messages_sent;
+  traffic_stats_.bytes_sent += size;
+  if (context.compression_algorithm() != GRPC_COMPRESS_NONE) {
+    traffic_stats_.bytes_sent_with_compression += size;
+  }
+}
+
+void GrpcConnection::RecordMessageReceived(const grpc::ByteBuffer& message) {
+  ++traffic_stats_.messages_received;
+  traffic_stats_.bytes_received += static_cast<int64_t>(message.Length());
+}
+
 void GrpcConnection::RegisterConnectivityMonitor() {
   connectivity_monitor_->AddCallback(
       [this](ConnectivityMonitor::NetworkStatus /*ignored*/) {
@@ -223,6 +262,9 @@ void GrpcConnection::RegisterConnectivityMonitor() {
         // connection before eventually failing. Note that gRPC Objective-C
         // client does the same thing:
         // https://github.com/grpc/grpc/blob/fe11db09575f2dfbe1f88cd44bd417acc168e354/src/objective-c/GRPCClient/private/GRPCHost.m#L309-L314
+        if (shared_resources_ && grpc_channel_) {
+          shared_resources_->ResetChannel(grpc_channel_);
+        }
         grpc_channel_.reset();
       });
 }
@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_CONNECTION_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_CONNECTION_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -28,6 +29,7 @@
 #include "Firestore/core/src/firebase/firestore/core/database_info.h"
 #include "Firestore/core/src/firebase/firestore/remote/connectivity_monitor.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_call.h"
+#include "Firestore/core/src/firebase/firestore/remote/grpc_shared_resources.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_stream.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_stream_observer.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_streaming_reader.h"
@@ -45,6 +47,20 @@ namespace firebase {
 namespace firestore {
 namespace remote {
 
+/**
+ * Counts of the messages exchanged over a `GrpcConnection`, covering streams,
+ * unary calls, and streaming reads alike. Byte counts are message sizes
+ * before compression; gRPC doesn't report the compressed size.
+ */
+struct GrpcTrafficStats {
+  int64_t messages_sent = 0;
+  int64_t bytes_sent = 0;
+  /** The part of `bytes_sent` that was sent with compression requested. */
+  int64_t bytes_sent_with_compression = 0;
+  int64_t messages_received = 0;
+  int64_t bytes_received = 0;
+};
+
 // PORTING NOTE: this class has limited resemblance to `GrpcConnection` in Web
 // client. However, unlike Web client, it's not meant to hide different
 // implementations of a `Connection` under a single interface.
@@ -55,13 +71,25 @@ namespace remote {
  */
 class GrpcConnection {
  public:
+  /**
+   * @param shared_resources If given, the channel is shared with all the other
+   *     connections using these resources instead of being owned by this
+   *     connection. Must outlive the connection.
+   */
   GrpcConnection(const core::DatabaseInfo& database_info,
                  util::AsyncQueue* worker_queue,
                  grpc::CompletionQueue* grpc_queue,
-                 ConnectivityMonitor* connectivity_monitor);
+                 ConnectivityMonitor* connectivity_monitor,
+                 GrpcSharedResources* shared_resources = nullptr);
 
   void Shutdown();
 
+  /**
+   * Starts setting up the channel (connecting and the TLS handshake) ahead of
+   * the first stream or call, which then doesn't have to wait for it.
+   */
+  void Preconnect();
+
   /**
    * Creates a stream to the given stream RPC endpoint. The resulting stream
    * needs to be `Start`ed before it can be used.
@@ -85,6 +113,27 @@ class GrpcConnection {
   void Register(GrpcCall* call);
   void Unregister(GrpcCall* call);
 
+  /**
+   * Whether calls created from now on ask gRPC to gzip the messages they
+   * send.
+   */
+  void set_compression_enabled(bool value) {
+    compression_enabled_ = value;
+  }
+  bool compression_enabled() const {
+    return compression_enabled_;
+  }
+
+  /** Records a message sent by one of the calls of this connection. */
+  void RecordMessageSent(const grpc::ByteBuffer& message,
+                         const grpc::ClientContext& context);
+  /** Records a message received by one of the calls of this connection. */
+  void RecordMessageReceived(const grpc::ByteBuffer& message);
+
+  const GrpcTrafficStats& traffic_stats() const {
+    return traffic_stats_;
+  }
+
   /**
    * Don't use SSL, send all traffic unencrypted. Call before creating any
    * streams or calls.
@@ -115,7 +164,11 @@ class GrpcConnection {
   std::unique_ptr<grpc::GenericStub> grpc_stub_;
 
   ConnectivityMonitor* connectivity_monitor_ = nullptr;
+  GrpcSharedResources* shared_resources_ = nullptr;
   std::vector<GrpcCall*> active_calls_;
+
+  bool compression_enabled_ = false;
+  GrpcTrafficStats traffic_stats_;
 };
 
 }  // namespace remote
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/grpc_nanopb.h"
+
+#include <utility>
+
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+namespace {
+
+nanopb::Reader WrapSlices(const grpc::ByteBuffer& buffer,
+                          std::vector<grpc::Slice>* slices) {
+  grpc::Status status = buffer.Dump(slices);
+  if (!status.ok()) {
+    nanopb::Reader reader = nanopb::Reader::Wrap(absl::string_view{});
+    reader.set_status(util::Status{
+        FirestoreErrorCode::Internal,
+        "Trying to read an invalid grpc::ByteBuffer"});
+    return reader;
+  }
+
+  std::vector<absl::string_view> segments;
+  segments.reserve(slices->size());
+  for (const grpc::Slice& slice : *slices) {
+    segments.emplace_back(reinterpret_cast<const char*>(slice.begin()),
+                          slice.size());
+  }
+  return nanopb::Reader::Wrap(std::move(segments));
+}
+
+}  // namespace
+
+ByteBufferReader::ByteBufferReader(const grpc::ByteBuffer& buffer)
+    : reader_{WrapSlices(buffer, &slices_)} {
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_NANOPB_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_NANOPB_H_
+
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
+#include "grpcpp/support/byte_buffer.h"
+#include "grpcpp/support/slice.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * Reads nanopb messages directly from the slices of a `grpc::ByteBuffer`,
+ * without flattening the buffer into contiguous memory first. Large responses
+ * usually arrive in many slices, so this saves copying the whole message
+ * before decoding it.
+ *
+ * If the buffer can't be read, the reader is created with a failed status.
+ */
+class ByteBufferReader {
+ public:
+  explicit ByteBufferReader(const grpc::ByteBuffer& buffer);
+
+  ByteBufferReader(const ByteBufferReader&) = delete;
+  ByteBufferReader& operator=(const ByteBufferReader&) = delete;
+
+  nanopb::Reader* reader() {
+    return &reader_;
+  }
+
+ private:
+  // Each slice holds a reference to its part of the buffer, keeping it alive
+  // for `reader_`.
+  std::vector<grpc::Slice> slices_;
+  nanopb::Reader reader_;
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_NANOPB_H_
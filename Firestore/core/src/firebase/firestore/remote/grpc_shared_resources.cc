@@ -0,0 +1,128 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/grpc_shared_resources.h"
+
+#include <unordered_map>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/remote/grpc_completion.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+namespace {
+
+using ResourcesByHost =
+    std::unordered_map<std::string, std::weak_ptr<GrpcSharedResources>>;
+
+std::mutex& PoolMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+ResourcesByHost& Pool() {
+  static ResourcesByHost pool;
+  return pool;
+}
+
+}  // namespace
+
+std::shared_ptr<GrpcSharedResources> GrpcSharedResources::Acquire(
+    const std::string& host, const ExecutorFactory& create_executor) {
+  std::lock_guard<std::mutex> lock{PoolMutex()};
+
+  std::weak_ptr<GrpcSharedResources>& entry = Pool()[host];
+  std::shared_ptr<GrpcSharedResources> resources = entry.lock();
+  if (!resources) {
+    resources = CreateUnshared(create_executor());
+    entry = resources;
+  }
+  return resources;
+}
+
+std::shared_ptr<GrpcSharedResources> GrpcSharedResources::CreateUnshared(
+    std::unique_ptr<util::Executor> poll_executor) {
+  // The constructor is private, so `std::make_shared` can't be used.
+  return std::shared_ptr<GrpcSharedResources>(
+      new GrpcSharedResources(std::move(poll_executor)));
+}
+
+GrpcSharedResources::GrpcSharedResources(
+    std::unique_ptr<util::Executor> poll_executor)
+    : poll_executor_{std::move(poll_executor)} {
+}
+
+GrpcSharedResources::~GrpcSharedResources() {
+  // `grpc::CompletionQueue::Next` will only return `false` once `Shutdown` has
+  // been called and all submitted tags have been extracted. Without this call,
+  // `poll_executor_` will never finish.
+  queue_.Shutdown();
+  // Drain the executor to make sure it extracted all the operations from gRPC
+  // completion queue.
+  poll_executor_->ExecuteBlocking([] {});
+}
+
+void GrpcSharedResources::StartPolling() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (is_polling_) {
+      return;
+    }
+    is_polling_ = true;
+  }
+  poll_executor_->Execute([this] { PollQueue(); });
+}
+
+void GrpcSharedResources::PollQueue() {
+  HARD_ASSERT(poll_executor_->IsCurrentExecutor(),
+              "PollQueue should only be called on the dedicated executor");
+
+  void* tag = nullptr;
+  bool ok = false;
+  while (queue_.Next(&tag, &ok)) {
+    auto completion = static_cast<GrpcCompletion*>(tag);
+    // While it's valid in principle, we never deliberately pass a null pointer
+    // to gRPC completion queue and expect it back. This assertion might be
+    // relaxed if necessary.
+    HARD_ASSERT(tag, "gRPC queue returned a null tag");
+    completion->Complete(ok);
+  }
+}
+
+std::shared_ptr<grpc::Channel> GrpcSharedResources::GetChannel(
+    const ChannelFactory& create_channel) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (!channel_ || channel_->GetState(/*try_to_connect=*/false) ==
+                       GRPC_CHANNEL_SHUTDOWN) {
+    channel_ = create_channel();
+  }
+  return channel_;
+}
+
+void GrpcSharedResources::ResetChannel(
+    const std::shared_ptr<grpc::Channel>& channel) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (channel_ == channel) {
+    channel_.reset();
+  }
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_SHARED_RESOURCES_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_SHARED_RESOURCES_H_
+
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "grpcpp/channel.h"
+#include "grpcpp/completion_queue.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * The gRPC objects that all `Datastore`s talking to the same host share: a
+ * completion queue along with the executor polling it, and a channel.
+ *
+ * Sharing these means that several Firestore instances pointing at the same
+ * host (e.g. to different databases) only pay for a single polling thread and
+ * a single connection, including its TLS handshake.
+ *
+ * All methods are thread-safe; instances are used from the worker queues of
+ * all the `Datastore`s sharing them.
+ */
+class GrpcSharedResources {
+ public:
+  using ExecutorFactory = std::function<std::unique_ptr<util::Executor>()>;
+  using ChannelFactory = std::function<std::shared_ptr<grpc::Channel>()>;
+
+  /**
+   * Returns the resources for `host`, creating them if no one holds them at
+   * the moment. The resources are released once the last holder lets go of
+   * them.
+   *
+   * @param create_executor Creates the executor that polls the completion
+   *     queue, only invoked if new resources are created.
+   */
+  static std::shared_ptr<GrpcSharedResources> Acquire(
+      const std::string& host, const ExecutorFactory& create_executor);
+
+  /**
+   * Creates resources that aren't shared with anyone, for tests that drive the
+   * completion queue themselves.
+   */
+  static std::shared_ptr<GrpcSharedResources> CreateUnshared(
+      std::unique_ptr<util::Executor> poll_executor);
+
+  /**
+   * Shuts down the completion queue and waits until the executor has taken all
+   * the remaining operations off of it.
+   */
+  ~GrpcSharedResources();
+
+  GrpcSharedResources(const GrpcSharedResources&) = delete;
+  GrpcSharedResources& operator=(const GrpcSharedResources&) = delete;
+
+  grpc::CompletionQueue* queue() {
+    return &queue_;
+  }
+
+  /**
+   * Starts polling the completion queue, unless that's already happening.
+   * Every completion is handed to the worker queue of the call it belongs to.
+   */
+  void StartPolling();
+
+  /**
+   * Returns the shared channel, first creating it using `create_channel` if
+   * there is none yet or the existing one has shut down.
+   */
+  std::shared_ptr<grpc::Channel> GetChannel(
+      const ChannelFactory& create_channel);
+
+  /**
+   * Stops sharing `channel` if it's still the shared channel, so that the next
+   * call to `GetChannel` creates a fresh one. Does nothing if the channel has
+   * already been replaced.
+   */
+  void ResetChannel(const std::shared_ptr<grpc::Channel>& channel);
+
+ private:
+  explicit GrpcSharedResources(std::unique_ptr<util::Executor> poll_executor);
+
+  void PollQueue();
+
+  grpc::CompletionQueue queue_;
+  std::unique_ptr<util::Executor> poll_executor_;
+
+  std::mutex mutex_;
+  bool is_polling_ = false;
+  std::shared_ptr<grpc::Channel> channel_;
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_SHARED_RESOURCES_H_
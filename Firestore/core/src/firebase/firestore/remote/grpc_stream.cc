@@ -69,6 +69,9 @@ absl::optional<BufferedWrite> BufferedWriter::TryStartWrite() {
   has_active_write_ = true;
   BufferedWrite message = std::move(queue_.front());
   queue_.pop();
+  if (!queue_.empty()) {
+    message.options.set_buffer_hint();
+  }
   return std::move(message);
 }
 
@@ -92,7 +95,8 @@ GrpcStream::GrpcStream(
       call_{std::move(NOT_NULL(call))},
       worker_queue_{NOT_NULL(worker_queue)},
       grpc_connection_{NOT_NULL(grpc_connection)},
-      observer_{NOT_NULL(observer)} {
+      observer_{NOT_NULL(observer)},
+      completion_pool_{std::make_shared<GrpcCompletionPool>(worker_queue)} {
   grpc_connection_->Register(this);
 }
 
@@ -127,9 +131,14 @@ void GrpcStream::Read() {
     return;
   }
 
-  GrpcCompletion* completion =
-      NewCompletion(Type::Read, [this](const GrpcCompletion* completion) {
-        OnRead(*completion->message());
+  // Reads are issued for as long as the stream is open, so this callback,
+  // unlike the ones `NewCompletion` makes, is small enough for `std::function`
+  // to hold without allocating.
+  GrpcCompletion* completion = AddCompletion(
+      Type::Read, [this](bool ok, const GrpcCompletion* completion) {
+        if (RemoveCompletion(ok, completion)) {
+          OnRead(*completion->message());
+        }
       });
   call_->Read(completion->message(), completion);
 }
@@ -138,6 +147,11 @@ void GrpcStream::Write(grpc::ByteBuffer&& message) {
   MaybeWrite(buffered_writer_.EnqueueWrite(std::move(message)));
 }
 
+void GrpcStream::Write(grpc::ByteBuffer&& message,
+                       const grpc::WriteOptions& options) {
+  MaybeWrite(buffered_writer_.EnqueueWrite(std::move(message), options));
+}
+
 void GrpcStream::WriteLast(grpc::ByteBuffer&& message) {
   grpc::WriteOptions options;
   options.set_last_message();
@@ -150,9 +164,14 @@ void GrpcStream::MaybeWrite(absl::optional<BufferedWrite> maybe_write) {
   }
 
   BufferedWrite write = std::move(maybe_write).value();
-  GrpcCompletion* completion =
-      NewCompletion(Type::Write, [this](const GrpcCompletion*) { OnWrite(); });
+  GrpcCompletion* completion = AddCompletion(
+      Type::Write, [this](bool ok, const GrpcCompletion* completion) {
+        if (RemoveCompletion(ok, completion)) {
+          OnWrite();
+        }
+      });
   *completion->message() = write.message;
+  RecordMessageSent(*completion->message());
 
   call_->Write(*completion->message(), write.options, completion);
 }
@@ -266,6 +285,7 @@ bool GrpcStream::TryLastWrite(grpc::ByteBuffer&& message) {
   BufferedWrite last_write = std::move(maybe_write).value();
   GrpcCompletion* completion = NewCompletion(Type::Write, {});
   *completion->message() = last_write.message;
+  RecordMessageSent(*completion->message());
   call_->WriteLast(*completion->message(), grpc::WriteOptions{}, completion);
 
   // Empirically, the write normally takes less than a millisecond to finish
@@ -279,6 +299,12 @@ bool GrpcStream::TryLastWrite(grpc::ByteBuffer&& message) {
   return status == std::future_status::ready;
 }
 
+void GrpcStream::RecordMessageSent(const grpc::ByteBuffer& message) {
+  if (grpc_connection_) {
+    grpc_connection_->RecordMessageSent(message, *context_);
+  }
+}
+
 GrpcStream::Metadata GrpcStream::GetResponseHeaders() const {
   return context_->GetServerInitialMetadata();
 }
@@ -286,6 +312,9 @@ GrpcStream::Metadata GrpcStream::GetResponseHeaders() const {
 // Callbacks
 
 void GrpcStream::OnRead(const grpc::ByteBuffer& message) {
+  if (grpc_connection_) {
+    grpc_connection_->RecordMessageReceived(message);
+  }
   if (observer_) {
     // Continue waiting for new messages indefinitely as long as there is an
     // interested observer.
@@ -316,10 +345,19 @@ void GrpcStream::OnOperationFailed() {
   });
 }
 
-void GrpcStream::RemoveCompletion(const GrpcCompletion* to_remove) {
+bool GrpcStream::RemoveCompletion(bool ok, const GrpcCompletion* to_remove) {
   auto found = std::find(completions_.begin(), completions_.end(), to_remove);
   HARD_ASSERT(found != completions_.end(), "Missing GrpcCompletion");
   completions_.erase(found);
+
+  if (!ok) {
+    // Use the same error-handling for all operations; all errors are
+    // unrecoverable.
+    LOG_DEBUG("GrpcStream('%s'): operation of type %s failed", this,
+              to_remove->type());
+    OnOperationFailed();
+  }
+  return ok;
 }
 
 GrpcCompletion* GrpcStream::NewCompletion(Type tag,
@@ -327,24 +365,18 @@ GrpcCompletion* GrpcStream::NewCompletion(Type tag,
   // Can't move into lambda until C++14.
   GrpcCompletion::Callback decorated =
       [this, on_success](bool ok, const GrpcCompletion* completion) {
-        RemoveCompletion(completion);
-
-        if (ok) {
-          if (on_success) {
-            on_success(completion);
-          }
-        } else {
-          // Use the same error-handling for all operations; all errors are
-          // unrecoverable.
-          LOG_DEBUG("GrpcStream('%s'): operation of type %s failed", this,
-                    completion->type());
-          OnOperationFailed();
+        if (RemoveCompletion(ok, completion) && on_success) {
+          on_success(completion);
         }
       };
+  return AddCompletion(tag, std::move(decorated));
+}
 
+GrpcCompletion* GrpcStream::AddCompletion(Type tag,
+                                          GrpcCompletion::Callback&& callback) {
   // For lifetime details, see `GrpcCompletion` class comment.
-  auto* completion =
-      new GrpcCompletion{tag, worker_queue_, std::move(decorated)};
+  GrpcCompletion* completion =
+      completion_pool_->Acquire(tag, std::move(callback));
   completions_.push_back(completion);
   return completion;
 }
@@ -69,6 +69,11 @@ struct BufferedWrite {
  *
  * `BufferedWriter` does not store any of the operations it creates.
  *
+ * A write that becomes active while others are queued behind it is given
+ * a buffer hint ("corked"), so that gRPC completes it without flushing it to
+ * the network and sends it together with the ones that follow. The last write
+ * of a burst goes without one, which flushes them all.
+ *
  * This class exists to help Firestore streams adhere to the gRPC requirement
  * that only one write operation may be active at any given time.
  */
@@ -134,6 +139,13 @@ class GrpcStream : public GrpcCall {
   // Can only be called once the stream has opened.
   void Write(grpc::ByteBuffer&& message);
 
+  /**
+   * Like `Write`, with the given options. Messages written with a buffer hint
+   * may be held back by gRPC and sent together with the next message that
+   * doesn't have one.
+   */
+  void Write(grpc::ByteBuffer&& message, const grpc::WriteOptions& options);
+
   /**
    * Writes the given message and indicates to the server that no more write
    * operations will be sent using this stream. It is invalid to call `Write` or
@@ -185,6 +197,7 @@ class GrpcStream : public GrpcCall {
   void Read();
   void MaybeWrite(absl::optional<internal::BufferedWrite> maybe_write);
   bool TryLastWrite(grpc::ByteBuffer&& message);
+  void RecordMessageSent(const grpc::ByteBuffer& message);
 
   void Shutdown();
   void UnsetObserver() {
@@ -196,11 +209,17 @@ class GrpcStream : public GrpcCall {
   void OnRead(const grpc::ByteBuffer& message);
   void OnWrite();
   void OnOperationFailed();
-  void RemoveCompletion(const GrpcCompletion* to_remove);
+  // Forgets the completion that came back, handling the failure of its
+  // operation if `ok` is false. Returns `ok`.
+  bool RemoveCompletion(bool ok, const GrpcCompletion* to_remove);
 
   using OnSuccess = std::function<void(const GrpcCompletion*)>;
   GrpcCompletion* NewCompletion(GrpcCompletion::Type type,
                                 const OnSuccess& callback);
+  // Issues a completion from the pool with the given callback, which has to
+  // call `RemoveCompletion`.
+  GrpcCompletion* AddCompletion(GrpcCompletion::Type type,
+                                GrpcCompletion::Callback&& callback);
   // Finishes the underlying gRPC call. Must always be invoked on any call that
   // was started. Presumes that any pending completions will quickly come off
   // the queue and will block until they do, so this must only be invoked when
@@ -236,6 +255,7 @@ class GrpcStream : public GrpcCall {
   internal::BufferedWriter buffered_writer_;
 
   std::vector<GrpcCompletion*> completions_;
+  std::shared_ptr<GrpcCompletionPool> completion_pool_;
 
   // gRPC asserts that a call is finished exactly once.
   bool is_grpc_call_finished_ = false;
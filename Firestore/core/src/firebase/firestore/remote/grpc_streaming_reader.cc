@@ -48,6 +48,12 @@ void GrpcStreamingReader::Start(Callback&& callback) {
   stream_->Start();
 }
 
+void GrpcStreamingReader::Start(MessageCallback&& message_callback,
+                                Callback&& callback) {
+  message_callback_ = std::move(message_callback);
+  Start(std::move(callback));
+}
+
 void GrpcStreamingReader::FinishImmediately() {
   stream_->FinishImmediately();
 }
@@ -63,6 +69,11 @@ void GrpcStreamingReader::OnStreamStart() {
 }
 
 void GrpcStreamingReader::OnStreamRead(const grpc::ByteBuffer& message) {
+  if (message_callback_) {
+    message_callback_(message);
+    return;
+  }
+
   // Accumulate responses
   responses_.push_back(message);
 }
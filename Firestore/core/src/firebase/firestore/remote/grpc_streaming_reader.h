@@ -42,12 +42,15 @@ class GrpcConnection;
 
 /**
  * Sends a single request to the server, reads one or more streaming server
- * responses, and invokes the given callback with the accumulated responses.
+ * responses, and invokes the given callback with the accumulated responses
+ * (or, if started with a message callback, hands over each response as soon as
+ * it's read).
  */
 class GrpcStreamingReader : public GrpcCall, public GrpcStreamObserver {
  public:
   using ResponsesT = std::vector<grpc::ByteBuffer>;
   using Callback = std::function<void(const util::StatusOr<ResponsesT>&)>;
+  using MessageCallback = std::function<void(const grpc::ByteBuffer&)>;
 
   GrpcStreamingReader(
       std::unique_ptr<grpc::ClientContext> context,
@@ -63,6 +66,14 @@ class GrpcStreamingReader : public GrpcCall, public GrpcStreamObserver {
    */
   void Start(Callback&& callback);
 
+  /**
+   * Like `Start` above, but each response is passed to `message_callback` as
+   * soon as it's read instead of being accumulated; on success, `callback` is
+   * invoked with an empty vector. `message_callback` must not end this
+   * reader's lifetime.
+   */
+  void Start(MessageCallback&& message_callback, Callback&& callback);
+
   /**
    * If the call is in progress, attempts to cancel the call; otherwise, it's
    * a no-op. Cancellation is done on best-effort basis; however:
@@ -101,6 +112,7 @@ class GrpcStreamingReader : public GrpcCall, public GrpcStreamObserver {
   grpc::ByteBuffer request_;
 
   Callback callback_;
+  MessageCallback message_callback_;
   ResponsesT responses_;
 };
 
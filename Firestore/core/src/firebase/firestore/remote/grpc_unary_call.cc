@@ -52,6 +52,7 @@ GrpcUnaryCall::~GrpcUnaryCall() {
 void GrpcUnaryCall::Start(Callback&& callback) {
   callback_ = std::move(callback);
   call_->StartCall();
+  grpc_connection_->RecordMessageSent(request_, *context_);
 
   // For lifetime details, see `GrpcCompletion` class comment.
   finish_completion_ = new GrpcCompletion(
@@ -59,10 +60,14 @@ void GrpcUnaryCall::Start(Callback&& callback) {
       [this](bool /*ignored_ok*/, const GrpcCompletion* completion) {
         // Ignoring ok, status should contain all the relevant information.
         finish_completion_ = nullptr;
+        GrpcConnection* grpc_connection = grpc_connection_;
         Shutdown();
 
         auto callback = std::move(callback_);
         if (completion->status()->ok()) {
+          if (grpc_connection) {
+            grpc_connection->RecordMessageReceived(*completion->message());
+          }
           callback(*completion->message());
         } else {
           callback(ConvertStatus(*completion->status()));
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_MEMORY_PRESSURE_MONITOR_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_MEMORY_PRESSURE_MONITOR_H_
+
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * A base class for receiving the system's signals that the process is running
+ * low on memory; it is expected that each platform will have its own
+ * system-dependent implementation. The base class never signals.
+ *
+ * Callbacks are invoked on the worker queue, so they may release any state
+ * owned by the client that can be reconstructed later.
+ */
+class MemoryPressureMonitor {
+ public:
+  enum class Level {
+    /** Memory is getting low; caches should be trimmed. */
+    Warning,
+
+    /** Memory is critically low; the process is about to be terminated. */
+    Critical,
+  };
+
+  using Callback = std::function<void(Level)>;
+
+  /** Creates a platform-specific memory pressure monitor. */
+  static std::unique_ptr<MemoryPressureMonitor> Create(
+      util::AsyncQueue* worker_queue);
+
+  explicit MemoryPressureMonitor(util::AsyncQueue* worker_queue)
+      : worker_queue_{worker_queue} {
+  }
+
+  virtual ~MemoryPressureMonitor() {
+  }
+
+  void AddCallback(Callback&& callback) {
+    callbacks_.push_back(std::move(callback));
+  }
+
+ protected:
+  // Must be called on the worker queue.
+  void InvokeCallbacks(Level level);
+
+  util::AsyncQueue* queue() {
+    return worker_queue_;
+  }
+
+ private:
+  util::AsyncQueue* worker_queue_ = nullptr;
+  std::vector<Callback> callbacks_;
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_MEMORY_PRESSURE_MONITOR_H_
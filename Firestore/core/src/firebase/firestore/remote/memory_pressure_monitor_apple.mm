@@ -0,0 +1,96 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/memory_pressure_monitor.h"
+
+#if defined(__APPLE__)
+
+#include <dispatch/dispatch.h>
+
+#include <memory>
+
+#include "Firestore/core/src/firebase/firestore/util/executor_libdispatch.h"
+#include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "absl/memory/memory.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+namespace {
+
+using Level = MemoryPressureMonitor::Level;
+using util::AsyncQueue;
+using util::ExecutorLibdispatch;
+
+}  // namespace
+
+/**
+ * Implementation of `MemoryPressureMonitor` based on a libdispatch memory
+ * pressure source, which fires on the same warnings that are delivered to
+ * applications as `didReceiveMemoryWarning` (iOS/macOS).
+ */
+class MemoryPressureMonitorApple : public MemoryPressureMonitor {
+ public:
+  explicit MemoryPressureMonitorApple(AsyncQueue* worker_queue)
+      : MemoryPressureMonitor{worker_queue} {
+    // On Apple platforms, the executor implementation must be the
+    // libdispatch-based one (see ConnectivityMonitorApple).
+    auto executor = static_cast<ExecutorLibdispatch*>(queue()->executor());
+    source_ = dispatch_source_create(
+        DISPATCH_SOURCE_TYPE_MEMORYPRESSURE, 0,
+        DISPATCH_MEMORYPRESSURE_WARN | DISPATCH_MEMORYPRESSURE_CRITICAL,
+        executor->dispatch_queue());
+    if (!source_) {
+      LOG_DEBUG("Failed to create memory pressure source.");
+      return;
+    }
+
+    // The source delivers events on the worker queue and is cancelled there
+    // too, so the handler can't outlive this object.
+    dispatch_source_set_event_handler(source_, ^{
+      OnMemoryPressure();
+    });
+    dispatch_resume(source_);
+  }
+
+  ~MemoryPressureMonitorApple() {
+    if (source_) {
+      dispatch_source_cancel(source_);
+    }
+  }
+
+  void OnMemoryPressure() {
+    uintptr_t flags = dispatch_source_get_data(source_);
+    Level level = (flags & DISPATCH_MEMORYPRESSURE_CRITICAL) ? Level::Critical
+                                                             : Level::Warning;
+    queue()->ExecuteBlocking([this, level] { InvokeCallbacks(level); });
+  }
+
+ private:
+  dispatch_source_t source_ = nil;
+};
+
+std::unique_ptr<MemoryPressureMonitor> MemoryPressureMonitor::Create(
+    AsyncQueue* worker_queue) {
+  return absl::make_unique<MemoryPressureMonitorApple>(worker_queue);
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // defined(__APPLE__)
@@ -25,18 +25,23 @@
 
 #import <Foundation/Foundation.h>
 
-#include <set>
+#include <cstdint>
+#include <functional>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/types/optional.h"
 
 @class FSTMaybeDocument;
 @class FSTQueryData;
@@ -47,6 +52,32 @@ namespace firebase {
 namespace firestore {
 namespace remote {
 
+/**
+ * What watch has sent for a single target: how much its documents churned and
+ * how many bytes that took.
+ */
+struct TargetStatistics {
+  /** Documents that entered the target, including ones that re-entered it. */
+  int64_t documents_added = 0;
+  /** Changes to documents that were already part of the target. */
+  int64_t documents_modified = 0;
+  int64_t documents_removed = 0;
+
+  /**
+   * The encoded size of the responses addressed to the target. A response
+   * that applies to several targets counts towards each of them.
+   */
+  int64_t bytes_received = 0;
+
+  int64_t existence_filter_mismatches = 0;
+
+  /**
+   * The times watch reset the target or an existence filter mismatch forced a
+   * re-listen, both of which make watch resend the target's documents.
+   */
+  int64_t resets = 0;
+};
+
 /**
  * Interface implemented by `RemoteStore` to expose target metadata to the
  * `WatchChangeAggregator`.
@@ -69,6 +100,21 @@ class TargetMetadataProvider {
    */
   virtual FSTQueryData* GetQueryDataForTarget(
       model::TargetId target_id) const = 0;
+
+  /**
+   * Returns the database that the targets belong to, which determines the
+   * resource names that existence filter bloom filters are built from.
+   */
+  virtual const model::DatabaseId& GetDatabaseId() const = 0;
+
+  /**
+   * Returns the statistics to accumulate the given target's watch traffic
+   * into, or null if they aren't being recorded for it.
+   */
+  virtual TargetStatistics* GetStatisticsForTarget(model::TargetId target_id) {
+    (void)target_id;
+    return nullptr;
+  }
 };
 
 /**
@@ -152,7 +198,14 @@ bool operator==(const TargetChange& lhs, const TargetChange& rhs);
 /** Tracks the internal state of a Watch target. */
 class TargetState {
  public:
-  TargetState();
+  /** The keys of the documents that changed in a target, by kind of change. */
+  struct DocumentChanges {
+    std::vector<model::DocumentKey> added;
+    std::vector<model::DocumentKey> modified;
+    std::vector<model::DocumentKey> removed;
+  };
+
+  explicit TargetState(uint64_t generation);
 
   /**
    * Whether this target has been marked 'current'.
@@ -181,6 +234,23 @@ class TargetState {
     return has_pending_changes_;
   }
 
+  /**
+   * Identifies the document changes recorded for this target since they were
+   * last cleared. Changes recorded under an earlier generation no longer
+   * apply.
+   */
+  uint64_t generation() const {
+    return generation_;
+  }
+
+  /**
+   * The number of documents that the recorded document changes added to the
+   * target, less the number they removed.
+   */
+  int document_count_delta() const {
+    return document_count_delta_;
+  }
+
   /**
    * Applies the resume token to the `TargetChange`, but only when it has a new
    * value. Empty resume tokens are discarded.
@@ -188,19 +258,32 @@ class TargetState {
   void UpdateResumeToken(NSData* resume_token);
 
   /**
-   * Creates a target change from the current set of changes.
+   * Creates a target change from the given document changes, which are the
+   * ones recorded in the current generation.
    *
    * To reset the document changes after raising this snapshot, call
    * `ClearPendingChanges()`.
    */
-  TargetChange ToTargetChange() const;
+  TargetChange ToTargetChange(DocumentChanges document_changes) const;
+
+  /**
+   * Starts the given generation of document changes and sets
+   * `HasPendingChanges` to false.
+   */
+  void ClearPendingChanges(uint64_t generation);
 
-  /** Resets the document changes and sets `HasPendingChanges` to false. */
-  void ClearPendingChanges();
+  /**
+   * Starts the given generation of document changes without otherwise
+   * changing whether the target should be part of the next snapshot.
+   */
+  void DiscardDocumentChanges(uint64_t generation);
+
+  /**
+   * Accounts for a change to the document changes of the current generation
+   * that moves `document_count_delta()` by `count_delta`.
+   */
+  void RecordDocumentChange(int count_delta);
 
-  void AddDocumentChange(const model::DocumentKey& document_key,
-                         core::DocumentViewChange::Type type);
-  void RemoveDocumentChange(const model::DocumentKey& document_key);
   void RecordPendingTargetRequest();
   void RecordTargetResponse();
   void MarkCurrent();
@@ -213,15 +296,12 @@ class TargetState {
   int outstanding_responses_ = 0;
 
   /**
-   * Keeps track of the document changes since the last raised snapshot.
-   *
-   * These changes are continuously updated as we receive document updates and
-   * always reflect the current set of changes against the last issued snapshot.
+   * The document changes themselves are kept by the `WatchChangeAggregator`,
+   * once per document rather than once per target, tagged with the
+   * generation they were recorded in.
    */
-  std::unordered_map<model::DocumentKey,
-                     core::DocumentViewChange::Type,
-                     model::DocumentKeyHash>
-      document_changes_;
+  uint64_t generation_ = 0;
+  int document_count_delta_ = 0;
 
   NSData* resume_token_;
 
@@ -325,8 +405,9 @@ class WatchChangeAggregator {
 
   /**
    * Handles existence filters and synthesizes deletes for filter mismatches.
-   * Targets that are invalidated by filter mismatches are added to
-   * `pending_target_resets_`.
+   * If the filter carries a bloom filter, only the documents it rules out are
+   * removed from the target. Targets whose mismatch can't be resolved that way
+   * are invalidated and added to `pending_target_resets_`.
    */
   void HandleExistenceFilter(
       const ExistenceFilterWatchChange& existence_filter);
@@ -356,6 +437,34 @@ class WatchChangeAggregator {
   std::vector<model::TargetId> GetTargetIds(
       const WatchTargetChange& target_change) const;
 
+  /**
+   * A target that a pending document change was addressed to, and the change
+   * it made to the target's documents.
+   */
+  struct DocumentTarget {
+    model::TargetId target_id = 0;
+
+    /** The generation of the target's state the change was recorded in. */
+    uint64_t generation = 0;
+
+    /**
+     * The kind of change, or nothing if the document entered and left the
+     * target before a snapshot was raised.
+     */
+    absl::optional<core::DocumentViewChange::Type> change;
+  };
+
+  /**
+   * A document that changed since the last raised snapshot: its new state, if
+   * known, and the targets the changes were addressed to, without duplicates.
+   * Nearly every document belongs to one or two targets, so these are stored
+   * inline in the table's slots.
+   */
+  struct PendingDocument {
+    FSTMaybeDocument* _Nullable document = nil;
+    absl::InlinedVector<DocumentTarget, 2> targets;
+  };
+
   /**
    * Adds the provided document to the internal list of document updates and its
    * document key to the given target's mapping.
@@ -374,6 +483,22 @@ class WatchChangeAggregator {
                                 const model::DocumentKey& key,
                                 FSTMaybeDocument* _Nullable updated_document);
 
+  /**
+   * Records the given change (see `DocumentTarget::change`) of the document in
+   * the given active target, replacing any earlier one.
+   */
+  void RecordDocumentChange(
+      PendingDocument* pending_document,
+      model::TargetId target_id,
+      absl::optional<core::DocumentViewChange::Type> change);
+
+  /**
+   * Returns the document changes recorded for the target in its current
+   * generation.
+   */
+  TargetState::DocumentChanges GetDocumentChangesForTarget(
+      model::TargetId target_id);
+
   /**
    * Returns the current count of documents in the target. This includes both
    * the number of documents that the LocalStore considers to be part of the
@@ -381,8 +506,17 @@ class WatchChangeAggregator {
    */
   int GetCurrentDocumentCountForTarget(model::TargetId target_id);
 
+  /**
+   * Removes from the target every document that the existence filter's bloom
+   * filter says is no longer part of it. Returns the number of documents
+   * removed.
+   */
+  int RemoveDocumentsMissingFromFilter(model::TargetId target_id,
+                                       const ExistenceFilter& filter);
+
   // PORTING NOTE: this method exists only for consistency with other platforms;
-  // in C++, it's pretty much unnecessary.
+  // in C++, it's pretty much unnecessary. The returned reference is only valid
+  // until the state of another target is added.
   TargetState& EnsureTargetState(model::TargetId target_id);
 
   /**
@@ -410,25 +544,39 @@ class WatchChangeAggregator {
    */
   void ResetTarget(model::TargetId target_id);
 
+  /**
+   * Adds the encoded size of the given change to the target's statistics.
+   * Returns the statistics, or null if they aren't recorded for the target.
+   */
+  TargetStatistics* RecordBytesReceived(model::TargetId target_id,
+                                        const WatchChange& change);
+
   /** Returns whether the local store considers the document to be part of the
    * specified target. */
   bool TargetContainsDocument(model::TargetId target_id,
                               const model::DocumentKey& key);
 
+  /** Returns an identifier for a new generation of a target's changes. */
+  uint64_t NextGeneration() {
+    return ++last_generation_;
+  }
+
   /** The internal state of all tracked targets. */
-  std::unordered_map<model::TargetId, TargetState> target_states_;
+  absl::flat_hash_map<model::TargetId, TargetState> target_states_;
 
-  /** Keeps track of the documents to update since the last raised snapshot. */
-  std::unordered_map<model::DocumentKey,
-                     FSTMaybeDocument*,
-                     model::DocumentKeyHash>
-      pending_document_updates_;
+  /**
+   * The documents that changed since the last raised snapshot. This is an
+   * open-addressing table that is emptied, but not deallocated, by every
+   * `CreateRemoteEvent`, so a stream of similar snapshots reuses its memory.
+   * The `TargetChange`s of the snapshot are derived from it there.
+   */
+  absl::flat_hash_map<model::DocumentKey,
+                      PendingDocument,
+                      model::DocumentKeyHash>
+      pending_documents_;
 
-  /** A mapping of document keys to their set of target IDs. */
-  std::unordered_map<model::DocumentKey,
-                     std::set<model::TargetId>,
-                     model::DocumentKeyHash>
-      pending_document_target_mappings_;
+  /** The last generation handed out by `NextGeneration()`. */
+  uint64_t last_generation_ = 0;
 
   /**
    * A list of targets with existence filter mismatches. These targets are known
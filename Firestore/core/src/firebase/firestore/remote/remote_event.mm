@@ -16,22 +16,62 @@
 
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
 
+#include <algorithm>
 #include <utility>
+#include <vector>
 
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Local/FSTQueryData.h"
 #import "Firestore/Source/Model/FSTDocument.h"
 
+#include "Firestore/core/src/firebase/firestore/remote/bloom_filter.h"
+#include "Firestore/core/src/firebase/firestore/remote/serializer.h"
+#include "Firestore/core/src/firebase/firestore/util/metrics_registry.h"
+
 using firebase::firestore::core::DocumentViewChange;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::model::TargetId;
+using firebase::firestore::util::MetricsRegistry;
 
 namespace firebase {
 namespace firestore {
 namespace remote {
 
+namespace {
+
+/** The metrics that every `WatchChangeAggregator` records into. */
+struct WatchMetrics {
+  MetricsRegistry::Counter* document_changes =
+      MetricsRegistry::Default().GetCounter("watch.document_changes");
+  MetricsRegistry::Counter* target_changes =
+      MetricsRegistry::Default().GetCounter("watch.target_changes");
+  MetricsRegistry::Counter* existence_filters =
+      MetricsRegistry::Default().GetCounter("watch.existence_filters");
+  MetricsRegistry::Counter* existence_filter_mismatches =
+      MetricsRegistry::Default().GetCounter(
+          "watch.existence_filter_mismatches");
+  MetricsRegistry::Counter* target_resets =
+      MetricsRegistry::Default().GetCounter("watch.target_resets");
+};
+
+WatchMetrics& Metrics() {
+  static WatchMetrics metrics;
+  return metrics;
+}
+
+/**
+ * Removes every entry from the given table. Unlike `clear()`, which frees the
+ * slots of large tables, this keeps them allocated for the next remote event.
+ */
+template <typename Table>
+void EraseAllKeepingCapacity(Table* table) {
+  table->erase(table->begin(), table->end());
+}
+
+}  // namespace
+
 // TargetChange
 
 bool operator==(const TargetChange& lhs, const TargetChange& rhs) {
@@ -44,7 +84,8 @@ bool operator==(const TargetChange& lhs, const TargetChange& rhs) {
 
 // TargetState
 
-TargetState::TargetState() : resume_token_{[NSData data]} {
+TargetState::TargetState(uint64_t generation)
+    : generation_{generation}, resume_token_{[NSData data]} {
 }
 
 void TargetState::UpdateResumeToken(NSData* resume_token) {
@@ -54,38 +95,29 @@ void TargetState::UpdateResumeToken(NSData* resume_token) {
   }
 }
 
-TargetChange TargetState::ToTargetChange() const {
-  DocumentKeySet added_documents;
-  DocumentKeySet modified_documents;
-  DocumentKeySet removed_documents;
-
-  for (const auto& entry : document_changes_) {
-    const DocumentKey& document_key = entry.first;
-    DocumentViewChange::Type change_type = entry.second;
-
-    switch (change_type) {
-      case DocumentViewChange::Type::kAdded:
-        added_documents = added_documents.insert(document_key);
-        break;
-      case DocumentViewChange::Type::kModified:
-        modified_documents = modified_documents.insert(document_key);
-        break;
-      case DocumentViewChange::Type::kRemoved:
-        removed_documents = removed_documents.insert(document_key);
-        break;
-      default:
-        HARD_FAIL("Encountered invalid change type: %s", change_type);
-    }
-  }
-
-  return TargetChange{resume_token(), current(), std::move(added_documents),
-                      std::move(modified_documents),
-                      std::move(removed_documents)};
+TargetChange TargetState::ToTargetChange(
+    DocumentChanges document_changes) const {
+  // The changes are unordered, so sort the keys of each kind all at once
+  // rather than inserting them into the sets one by one.
+  return TargetChange{resume_token(), current(),
+                      DocumentKeySet{}.insert_all(document_changes.added),
+                      DocumentKeySet{}.insert_all(document_changes.modified),
+                      DocumentKeySet{}.insert_all(document_changes.removed)};
 }
 
-void TargetState::ClearPendingChanges() {
+void TargetState::ClearPendingChanges(uint64_t generation) {
   has_pending_changes_ = false;
-  document_changes_.clear();
+  DiscardDocumentChanges(generation);
+}
+
+void TargetState::DiscardDocumentChanges(uint64_t generation) {
+  generation_ = generation;
+  document_count_delta_ = 0;
+}
+
+void TargetState::RecordDocumentChange(int count_delta) {
+  has_pending_changes_ = true;
+  document_count_delta_ += count_delta;
 }
 
 void TargetState::RecordPendingTargetRequest() {
@@ -101,17 +133,6 @@ void TargetState::MarkCurrent() {
   current_ = true;
 }
 
-void TargetState::AddDocumentChange(const DocumentKey& document_key,
-                                    DocumentViewChange::Type type) {
-  has_pending_changes_ = true;
-  document_changes_[document_key] = type;
-}
-
-void TargetState::RemoveDocumentChange(const DocumentKey& document_key) {
-  has_pending_changes_ = true;
-  document_changes_.erase(document_key);
-}
-
 // WatchChangeAggregator
 
 WatchChangeAggregator::WatchChangeAggregator(
@@ -121,24 +142,95 @@ WatchChangeAggregator::WatchChangeAggregator(
 
 void WatchChangeAggregator::HandleDocumentChange(
     const DocumentWatchChange& document_change) {
+  Metrics().document_changes->Increment();
+  const DocumentKey& key = document_change.document_key();
+  FSTMaybeDocument* new_document = document_change.new_document();
+  bool is_document = [new_document isKindOfClass:[FSTDocument class]];
+  bool is_deleted_document =
+      !is_document && [new_document isKindOfClass:[FSTDeletedDocument class]];
+
+  // The document is looked up once for all of the targets the change is
+  // addressed to, and only recorded if one of them is active.
+  PendingDocument* pending_document = nullptr;
+  auto record_change = [&](TargetId target_id,
+                           absl::optional<DocumentViewChange::Type> change,
+                           FSTMaybeDocument* _Nullable updated_document) {
+    if (!pending_document) {
+      pending_document = &pending_documents_[key];
+    }
+    RecordDocumentChange(pending_document, target_id, change);
+    if (updated_document) {
+      pending_document->document = updated_document;
+    }
+  };
+  auto removal = [&](TargetId target_id) {
+    absl::optional<DocumentViewChange::Type> change;
+    if (TargetContainsDocument(target_id, key)) {
+      change = DocumentViewChange::Type::kRemoved;
+    }
+    return change;
+  };
+
   for (TargetId target_id : document_change.updated_target_ids()) {
-    if ([document_change.new_document() isKindOfClass:[FSTDocument class]]) {
-      AddDocumentToTarget(target_id, document_change.new_document());
-    } else if ([document_change.new_document()
-                   isKindOfClass:[FSTDeletedDocument class]]) {
-      RemoveDocumentFromTarget(target_id, document_change.document_key(),
-                               document_change.new_document());
+    TargetStatistics* statistics =
+        RecordBytesReceived(target_id, document_change);
+    bool is_active = IsActiveTarget(target_id);
+    if (is_document && (statistics || is_active)) {
+      bool contains_document = TargetContainsDocument(target_id, key);
+      if (statistics) {
+        if (contains_document) {
+          ++statistics->documents_modified;
+        } else {
+          ++statistics->documents_added;
+        }
+      }
+      if (is_active) {
+        record_change(target_id,
+                      contains_document ? DocumentViewChange::Type::kModified
+                                        : DocumentViewChange::Type::kAdded,
+                      new_document);
+      }
+    } else if (is_deleted_document) {
+      if (statistics) {
+        ++statistics->documents_removed;
+      }
+      if (is_active) {
+        record_change(target_id, removal(target_id), new_document);
+      }
     }
   }
 
   for (TargetId target_id : document_change.removed_target_ids()) {
-    RemoveDocumentFromTarget(target_id, document_change.document_key(),
-                             document_change.new_document());
+    TargetStatistics* statistics =
+        RecordBytesReceived(target_id, document_change);
+    if (statistics) {
+      ++statistics->documents_removed;
+    }
+    if (IsActiveTarget(target_id)) {
+      record_change(target_id, removal(target_id), new_document);
+    }
+  }
+}
+
+TargetStatistics* WatchChangeAggregator::RecordBytesReceived(
+    TargetId target_id, const WatchChange& change) {
+  TargetStatistics* statistics =
+      target_metadata_provider_->GetStatisticsForTarget(target_id);
+  if (statistics) {
+    statistics->bytes_received += static_cast<int64_t>(change.encoded_size());
   }
+  return statistics;
 }
 
 void WatchChangeAggregator::HandleTargetChange(
     const WatchTargetChange& target_change) {
+  Metrics().target_changes->Increment();
+  // Global changes (with no target IDs) carry the read time of a snapshot
+  // rather than anything about the targets, so they aren't attributed.
+  for (TargetId target_id : target_change.target_ids()) {
+    RecordBytesReceived(target_id, target_change);
+  }
+
   for (TargetId target_id : GetTargetIds(target_change)) {
     TargetState& target_state = EnsureTargetState(target_id);
 
@@ -156,7 +248,7 @@ void WatchChangeAggregator::HandleTargetChange(
           // We have a freshly added target, so we need to reset any state that
           // we had previously. This can happen e.g. when remove and add back a
           // target for existence filter mismatches.
-          target_state.ClearPendingChanges();
+          target_state.ClearPendingChanges(NextGeneration());
         }
         target_state.UpdateResumeToken(target_change.resume_token());
         continue;
@@ -183,6 +275,11 @@ void WatchChangeAggregator::HandleTargetChange(
           // Reset the target and synthesizes removes for all existing
           // documents. The backend will re-add any documents that still match
           // the target before it sends the next global snapshot.
+          TargetStatistics* statistics =
+              target_metadata_provider_->GetStatisticsForTarget(target_id);
+          if (statistics) {
+            ++statistics->resets;
+          }
           ResetTarget(target_id);
           target_state.UpdateResumeToken(target_change.resume_token());
         }
@@ -211,6 +308,9 @@ void WatchChangeAggregator::HandleExistenceFilter(
     const ExistenceFilterWatchChange& existence_filter) {
   TargetId target_id = existence_filter.target_id();
   int expected_count = existence_filter.filter().count();
+  Metrics().existence_filters->Increment();
+  TargetStatistics* statistics =
+      RecordBytesReceived(target_id, existence_filter);
 
   FSTQueryData* query_data = QueryDataForActiveTarget(target_id);
   if (query_data) {
@@ -237,10 +337,28 @@ void WatchChangeAggregator::HandleExistenceFilter(
     } else {
       int current_size = GetCurrentDocumentCountForTarget(target_id);
       if (current_size != expected_count) {
-        // Existence filter mismatch: We reset the mapping and raise a new
-        // snapshot with `isFromCache:true`.
-        ResetTarget(target_id);
-        pending_target_resets_.insert(target_id);
+        Metrics().existence_filter_mismatches->Increment();
+        if (statistics) {
+          ++statistics->existence_filter_mismatches;
+        }
+        // Existence filter mismatch: If Watch told us which documents still
+        // match, we only drop the ones that went away.
+        if (existence_filter.filter().bloom_filter()) {
+          current_size -= RemoveDocumentsMissingFromFilter(
+              target_id, existence_filter.filter());
+        }
+
+        // If that didn't account for the whole difference (e.g. because of a
+        // false positive), we reset the mapping and raise a new snapshot with
+        // `isFromCache:true`.
+        if (current_size != expected_count) {
+          Metrics().target_resets->Increment();
+          if (statistics) {
+            ++statistics->resets;
+          }
+          ResetTarget(target_id);
+          pending_target_resets_.insert(target_id);
+        }
       }
     }
   }
@@ -248,7 +366,9 @@ void WatchChangeAggregator::HandleExistenceFilter(
 
 RemoteEvent WatchChangeAggregator::CreateRemoteEvent(
     const SnapshotVersion& snapshot_version) {
-  std::unordered_map<TargetId, TargetChange> target_changes;
+  // The targets that are part of this event, and the document changes that
+  // are then distributed to them from the pending documents.
+  absl::flat_hash_map<TargetId, TargetState::DocumentChanges> changed_targets;
 
   for (auto& entry : target_states_) {
     TargetId target_id = entry.first;
@@ -262,8 +382,9 @@ RemoteEvent WatchChangeAggregator::CreateRemoteEvent(
         // delete if we have not previously received the document. This resolves
         // the limbo state of the document, removing it from limboDocumentRefs.
         DocumentKey key{query_data.query.path};
-        if (pending_document_updates_.find(key) ==
-                pending_document_updates_.end() &&
+        auto pending_document = pending_documents_.find(key);
+        if ((pending_document == pending_documents_.end() ||
+             !pending_document->second.document) &&
             !TargetContainsDocument(target_id, key)) {
           RemoveDocumentFromTarget(
               target_id, key,
@@ -274,44 +395,92 @@ RemoteEvent WatchChangeAggregator::CreateRemoteEvent(
       }
 
       if (target_state.HasPendingChanges()) {
-        target_changes[target_id] = target_state.ToTargetChange();
-        target_state.ClearPendingChanges();
+        changed_targets.try_emplace(target_id);
       }
     }
   }
 
+  std::unordered_map<DocumentKey, FSTMaybeDocument*, model::DocumentKeyHash>
+      document_updates;
+  document_updates.reserve(pending_documents_.size());
   DocumentKeySet resolved_limbo_documents;
 
-  // We extract the set of limbo-only document updates as the GC logic
-  // special-cases documents that do not appear in the query cache.
-  //
-  // TODO(gsoltis): Expand on this comment.
-  for (const auto& entry : pending_document_target_mappings_) {
+  for (const auto& entry : pending_documents_) {
+    const DocumentKey& key = entry.first;
+    const PendingDocument& pending_document = entry.second;
+    if (pending_document.document) {
+      document_updates.emplace(key, pending_document.document);
+    }
+
+    // We extract the set of limbo-only document updates as the GC logic
+    // special-cases documents that do not appear in the query cache.
+    //
+    // TODO(gsoltis): Expand on this comment.
     bool is_only_limbo_target = true;
 
-    for (TargetId target_id : entry.second) {
-      FSTQueryData* query_data = QueryDataForActiveTarget(target_id);
-      if (query_data && query_data.purpose != FSTQueryPurposeLimboResolution) {
-        is_only_limbo_target = false;
-        break;
+    for (const DocumentTarget& target : pending_document.targets) {
+      if (is_only_limbo_target) {
+        FSTQueryData* query_data = QueryDataForActiveTarget(target.target_id);
+        if (query_data &&
+            query_data.purpose != FSTQueryPurposeLimboResolution) {
+          is_only_limbo_target = false;
+        }
+      }
+
+      if (!target.change) continue;
+      auto changes = changed_targets.find(target.target_id);
+      if (changes == changed_targets.end() ||
+          target.generation !=
+              target_states_.at(target.target_id).generation()) {
+        continue;
+      }
+      switch (*target.change) {
+        case DocumentViewChange::Type::kAdded:
+          changes->second.added.push_back(key);
+          break;
+        case DocumentViewChange::Type::kModified:
+          changes->second.modified.push_back(key);
+          break;
+        case DocumentViewChange::Type::kRemoved:
+          changes->second.removed.push_back(key);
+          break;
+        default:
+          HARD_FAIL("Encountered invalid change type: %s", *target.change);
       }
     }
 
     if (is_only_limbo_target) {
-      resolved_limbo_documents = resolved_limbo_documents.insert(entry.first);
+      resolved_limbo_documents = resolved_limbo_documents.insert(key);
+    }
+  }
+
+  std::unordered_map<TargetId, TargetChange> target_changes;
+  for (auto& entry : target_states_) {
+    TargetId target_id = entry.first;
+    TargetState& target_state = entry.second;
+
+    auto changes = changed_targets.find(target_id);
+    if (changes != changed_targets.end()) {
+      target_changes[target_id] =
+          target_state.ToTargetChange(std::move(changes->second));
+      target_state.ClearPendingChanges(NextGeneration());
+    } else {
+      // The pending documents are dropped below along with the changes they
+      // record for inactive targets. Such a target only becomes active again
+      // through a fresh `Added` response, which would clear them anyway.
+      target_state.DiscardDocumentChanges(NextGeneration());
     }
   }
 
   RemoteEvent remote_event{snapshot_version, std::move(target_changes),
                            std::move(pending_target_resets_),
-                           std::move(pending_document_updates_),
+                           std::move(document_updates),
                            std::move(resolved_limbo_documents)};
 
   // Re-initialize the current state to ensure that we do not modify the
   // generated `RemoteEvent`.
-  pending_document_updates_.clear();
-  pending_document_target_mappings_.clear();
   pending_target_resets_.clear();
+  EraseAllKeepingCapacity(&pending_documents_);
 
   return remote_event;
 }
@@ -327,11 +496,9 @@ void WatchChangeAggregator::AddDocumentToTarget(TargetId target_id,
           ? DocumentViewChange::Type::kModified
           : DocumentViewChange::Type::kAdded;
 
-  TargetState& target_state = EnsureTargetState(target_id);
-  target_state.AddDocumentChange(document.key, change_type);
-
-  pending_document_updates_[document.key] = document;
-  pending_document_target_mappings_[document.key].insert(target_id);
+  PendingDocument& pending_document = pending_documents_[document.key];
+  RecordDocumentChange(&pending_document, target_id, change_type);
+  pending_document.document = document;
 }
 
 void WatchChangeAggregator::RemoveDocumentFromTarget(
@@ -342,19 +509,70 @@ void WatchChangeAggregator::RemoveDocumentFromTarget(
     return;
   }
 
-  TargetState& target_state = EnsureTargetState(target_id);
+  PendingDocument& pending_document = pending_documents_[key];
   if (TargetContainsDocument(target_id, key)) {
-    target_state.AddDocumentChange(key, DocumentViewChange::Type::kRemoved);
+    RecordDocumentChange(&pending_document, target_id,
+                         DocumentViewChange::Type::kRemoved);
   } else {
     // The document may have entered and left the target before we raised a
     // snapshot, so we can just ignore the change.
-    target_state.RemoveDocumentChange(key);
+    RecordDocumentChange(&pending_document, target_id, absl::nullopt);
   }
-  pending_document_target_mappings_[key].insert(target_id);
 
   if (updated_document) {
-    pending_document_updates_[key] = updated_document;
+    pending_document.document = updated_document;
+  }
+}
+
+void WatchChangeAggregator::RecordDocumentChange(
+    PendingDocument* pending_document,
+    TargetId target_id,
+    absl::optional<DocumentViewChange::Type> change) {
+  auto count_delta = [](const absl::optional<DocumentViewChange::Type>& type) {
+    if (type == DocumentViewChange::Type::kAdded) return 1;
+    if (type == DocumentViewChange::Type::kRemoved) return -1;
+    return 0;
+  };
+
+  TargetState& target_state = EnsureTargetState(target_id);
+  auto& targets = pending_document->targets;
+  auto target = std::find_if(
+      targets.begin(), targets.end(),
+      [&](const DocumentTarget& t) { return t.target_id == target_id; });
+  if (target == targets.end()) {
+    targets.push_back(DocumentTarget{target_id, target_state.generation(), {}});
+    target = targets.end() - 1;
+  }
+
+  int delta = count_delta(change);
+  if (target->generation == target_state.generation()) {
+    delta -= count_delta(target->change);
+  }
+  target->generation = target_state.generation();
+  target->change = change;
+  target_state.RecordDocumentChange(delta);
+}
+
+TargetState::DocumentChanges WatchChangeAggregator::GetDocumentChangesForTarget(
+    TargetId target_id) {
+  uint64_t generation = EnsureTargetState(target_id).generation();
+  TargetState::DocumentChanges result;
+  for (const auto& entry : pending_documents_) {
+    for (const DocumentTarget& target : entry.second.targets) {
+      if (target.target_id != target_id || target.generation != generation ||
+          !target.change) {
+        continue;
+      }
+      if (*target.change == DocumentViewChange::Type::kAdded) {
+        result.added.push_back(entry.first);
+      } else if (*target.change == DocumentViewChange::Type::kModified) {
+        result.modified.push_back(entry.first);
+      } else {
+        result.removed.push_back(entry.first);
+      }
+    }
   }
+  return result;
 }
 
 void WatchChangeAggregator::RemoveTarget(TargetId target_id) {
@@ -363,11 +581,38 @@ void WatchChangeAggregator::RemoveTarget(TargetId target_id) {
 
 int WatchChangeAggregator::GetCurrentDocumentCountForTarget(
     TargetId target_id) {
-  TargetState& target_state = EnsureTargetState(target_id);
-  TargetChange target_change = target_state.ToTargetChange();
   return target_metadata_provider_->GetRemoteKeysForTarget(target_id).size() +
-         target_change.added_documents().size() -
-         target_change.removed_documents().size();
+         EnsureTargetState(target_id).document_count_delta();
+}
+
+int WatchChangeAggregator::RemoveDocumentsMissingFromFilter(
+    TargetId target_id, const ExistenceFilter& filter) {
+  const BloomFilter& bloom_filter = *filter.bloom_filter();
+  Serializer serializer{target_metadata_provider_->GetDatabaseId()};
+
+  TargetState::DocumentChanges changes = GetDocumentChangesForTarget(target_id);
+  DocumentKeySet removed_documents =
+      DocumentKeySet{}.insert_all(changes.removed);
+  std::vector<DocumentKey> missing_keys;
+  auto check_key = [&](const DocumentKey& key) {
+    if (!bloom_filter.MightContain(serializer.EncodeKey(key))) {
+      missing_keys.push_back(key);
+    }
+  };
+  for (const DocumentKey& key :
+       target_metadata_provider_->GetRemoteKeysForTarget(target_id)) {
+    if (!removed_documents.contains(key)) {
+      check_key(key);
+    }
+  }
+  for (const DocumentKey& key : changes.added) {
+    check_key(key);
+  }
+
+  for (const DocumentKey& key : missing_keys) {
+    RemoveDocumentFromTarget(target_id, key, nil);
+  }
+  return static_cast<int>(missing_keys.size());
 }
 
 void WatchChangeAggregator::RecordPendingTargetRequest(TargetId target_id) {
@@ -377,7 +622,12 @@ void WatchChangeAggregator::RecordPendingTargetRequest(TargetId target_id) {
 }
 
 TargetState& WatchChangeAggregator::EnsureTargetState(TargetId target_id) {
-  return target_states_[target_id];
+  auto target_state = target_states_.find(target_id);
+  if (target_state == target_states_.end()) {
+    target_state =
+        target_states_.emplace(target_id, TargetState{NextGeneration()}).first;
+  }
+  return target_state->second;
 }
 
 bool WatchChangeAggregator::IsActiveTarget(TargetId target_id) const {
@@ -399,7 +649,7 @@ void WatchChangeAggregator::ResetTarget(TargetId target_id) {
                   !(current_target_state->second.IsPending()),
               "Should only reset active targets");
 
-  target_states_[target_id] = {};
+  current_target_state->second = TargetState{NextGeneration()};
 
   // Trigger removal for any documents currently mapped to this target. These
   // removals will be part of the initial snapshot if Watch does not resend
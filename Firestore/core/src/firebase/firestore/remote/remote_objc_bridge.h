@@ -30,6 +30,7 @@
 #include "Firestore/core/src/firebase/firestore/core/database_info.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/remote/serializer.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "grpcpp/support/byte_buffer.h"
@@ -40,6 +41,8 @@
 #import "Firestore/Source/Model/FSTMutation.h"
 #import "Firestore/Source/Remote/FSTSerializerBeta.h"
 
+@class FSTMutationBatch;
+
 namespace firebase {
 namespace firestore {
 namespace remote {
@@ -65,7 +68,7 @@ bool IsLoggingEnabled();
 class WatchStreamSerializer {
  public:
   explicit WatchStreamSerializer(FSTSerializerBeta* serializer)
-      : serializer_{serializer} {
+      : serializer_{serializer}, nanopb_serializer_{*serializer.databaseID} {
   }
 
   GCFSListenRequest* CreateWatchRequest(FSTQueryData* query) const;
@@ -82,12 +85,33 @@ class WatchStreamSerializer {
   std::unique_ptr<WatchChange> ToWatchChange(GCFSListenResponse* proto) const;
   model::SnapshotVersion ToSnapshotVersion(GCFSListenResponse* proto) const;
 
+  /**
+   * Decodes a response into the change it carries with the nanopb
+   * `Serializer`, which doesn't create a protobuf object for every message in
+   * the response as `ParseResponse` does.
+   *
+   * If decoding fails, returns null and writes information on the error to
+   * `out_status`. Otherwise, sets `out_snapshot_version` to the version of the
+   * consistent snapshot the response completes (or `SnapshotVersion::None()`)
+   * and `out_status` to ok.
+   */
+  std::unique_ptr<WatchChange> DecodeResponse(
+      const grpc::ByteBuffer& message,
+      model::SnapshotVersion* out_snapshot_version,
+      util::Status* out_status) const;
+
   /** Creates a pretty-printed description of the proto for debugging. */
   static NSString* Describe(GCFSListenRequest* request);
   static NSString* Describe(GCFSListenResponse* request);
 
  private:
+  std::unique_ptr<WatchChange> DecodeWatchChange(
+      nanopb::Reader* reader,
+      const google_firestore_v1_ListenResponse& proto,
+      absl::string_view encoded) const;
+
   FSTSerializerBeta* serializer_;
+  Serializer nanopb_serializer_;
 };
 
 /**
@@ -96,11 +120,12 @@ class WatchStreamSerializer {
  */
 class WriteStreamSerializer {
  public:
+  using BatchIterator = std::vector<FSTMutationBatch*>::const_iterator;
+
   explicit WriteStreamSerializer(FSTSerializerBeta* serializer)
-      : serializer_{serializer} {
+      : serializer_{serializer}, nanopb_serializer_{*serializer.databaseID} {
   }
 
-  void UpdateLastStreamToken(GCFSWriteResponse* proto);
   void SetLastStreamToken(NSData* token) {
     last_stream_token_ = token;
   }
@@ -111,6 +136,17 @@ class WriteStreamSerializer {
   GCFSWriteRequest* CreateHandshake() const;
   GCFSWriteRequest* CreateWriteMutationsRequest(
       const std::vector<FSTMutation*>& mutations) const;
+  /**
+   * Creates a request containing the mutations of consecutive batches
+   * starting at `begin`, adding batches for as long as the encoded writes fit
+   * in `max_bytes`. The first batch is always included, however large it is.
+   * Sets `out_batch_count` to the number of batches in the request.
+   */
+  GCFSWriteRequest* CreateCoalescedWriteMutationsRequest(
+      BatchIterator begin,
+      BatchIterator end,
+      size_t max_bytes,
+      size_t* out_batch_count) const;
   GCFSWriteRequest* CreateEmptyMutationsList() {
     return CreateWriteMutationsRequest({});
   }
@@ -127,12 +163,26 @@ class WriteStreamSerializer {
   std::vector<FSTMutationResult*> ToMutationResults(
       GCFSWriteResponse* proto) const;
 
+  /**
+   * Decodes a response with the nanopb `Serializer`, which doesn't create a
+   * protobuf object for every message in the response as `ParseResponse`
+   * does, and captures its stream token.
+   *
+   * Sets `out_commit_version` and `out_results` to the commit version and the
+   * mutation results of the response. If decoding fails, returns the error and
+   * leaves the stream token as it was.
+   */
+  util::Status DecodeResponse(const grpc::ByteBuffer& message,
+                              model::SnapshotVersion* out_commit_version,
+                              std::vector<FSTMutationResult*>* out_results);
+
   /** Creates a pretty-printed description of the proto for debugging. */
   static NSString* Describe(GCFSWriteRequest* request);
   static NSString* Describe(GCFSWriteResponse* request);
 
  private:
   FSTSerializerBeta* serializer_;
+  Serializer nanopb_serializer_;
   NSData* last_stream_token_;
 };
 
@@ -154,12 +204,11 @@ class DatastoreSerializer {
   static grpc::ByteBuffer ToByteBuffer(GCFSBatchGetDocumentsRequest* request);
 
   /**
-   * Merges results of the streaming read together. The array is sorted by the
-   * document key.
+   * Decodes a single response of the streaming read. Returns nil and sets
+   * `out_status` if the response cannot be parsed.
    */
-  std::vector<FSTMaybeDocument*> MergeLookupResponses(
-      const std::vector<grpc::ByteBuffer>& responses,
-      util::Status* out_status) const;
+  FSTMaybeDocument* ToMaybeDocument(const grpc::ByteBuffer& response,
+                                    util::Status* out_status) const;
   FSTMaybeDocument* ToMaybeDocument(
       GCFSBatchGetDocumentsResponse* response) const;
 
@@ -17,13 +17,22 @@
 #include "Firestore/core/src/firebase/firestore/remote/remote_objc_bridge.h"
 
 #include <iomanip>
-#include <map>
 #include <sstream>
+#include <string>
+#include <utility>
 #include <vector>
 
 #import "Firestore/Source/API/FIRFirestore+Internal.h"
+#import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Model/FSTDocumentKey.h"
+#import "Firestore/Source/Model/FSTFieldValue.h"
+#import "Firestore/Source/Model/FSTMutationBatch.h"
 
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/wire_reader.h"
+#include "Firestore/core/src/firebase/firestore/remote/grpc_nanopb.h"
 #include "Firestore/core/src/firebase/firestore/util/error_apple.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
@@ -35,9 +44,11 @@ namespace remote {
 namespace bridge {
 
 using core::DatabaseInfo;
+using model::DatabaseId;
 using model::DocumentKey;
 using model::TargetId;
 using model::SnapshotVersion;
+using nanopb::Reader;
 using util::MakeString;
 using util::MakeNSError;
 using util::Status;
@@ -72,8 +83,15 @@ NSData* ConvertToNsData(const grpc::ByteBuffer& buffer, NSError** out_error) {
   }
 
   if (slices.size() == 1) {
-    return [NSData dataWithBytes:slices.front().begin()
-                          length:slices.front().size()];
+    // The block keeps a reference to the slice for as long as the data is
+    // alive, so the bytes don't need to be copied.
+    grpc::Slice slice = slices.front();
+    return [[NSData alloc]
+        initWithBytesNoCopy:const_cast<uint8_t*>(slice.begin())
+                     length:slice.size()
+                deallocator:^(void*, NSUInteger) {
+                  (void)slice;
+                }];
   } else {
     NSMutableData* data = [NSMutableData dataWithCapacity:buffer.Length()];
     for (const auto& slice : slices) {
@@ -112,6 +130,192 @@ Proto* ToProto(const grpc::ByteBuffer& message, Status* out_status) {
   return nil;
 }
 
+/**
+ * The contents of a `grpc::ByteBuffer` as contiguous bytes. A buffer made of
+ * a single slice is used in place; only a buffer that arrived in several
+ * slices is copied.
+ *
+ * Only listen responses need this, to keep the bytes of the documents they
+ * carry. Other responses are read from the slices with `ByteBufferReader`.
+ */
+class FlatByteBuffer {
+ public:
+  explicit FlatByteBuffer(const grpc::ByteBuffer& buffer) {
+    ok_ = buffer.Dump(&slices_).ok();
+    if (slices_.size() == 1) {
+      const grpc::Slice& slice = slices_.front();
+      bytes_ = absl::string_view{reinterpret_cast<const char*>(slice.begin()),
+                                 slice.size()};
+    } else {
+      joined_.reserve(buffer.Length());
+      for (const auto& slice : slices_) {
+        joined_.append(reinterpret_cast<const char*>(slice.begin()),
+                       slice.size());
+      }
+      bytes_ = joined_;
+    }
+  }
+
+  FlatByteBuffer(const FlatByteBuffer&) = delete;
+  FlatByteBuffer& operator=(const FlatByteBuffer&) = delete;
+
+  bool ok() const {
+    return ok_;
+  }
+
+  absl::string_view bytes() const {
+    return bytes_;
+  }
+
+ private:
+  std::vector<grpc::Slice> slices_;
+  std::string joined_;
+  absl::string_view bytes_;
+  bool ok_ = false;
+};
+
+Status ResponseDecodingError(const Status& cause,
+                             const grpc::ByteBuffer& message) {
+  return Status{FirestoreErrorCode::Internal,
+                StringFormat("Unable to parse response from the server.\n"
+                             "Underlying error: %s\n"
+                             "Received value: %s\n",
+                             cause.error_message(), ToHexString(message))};
+}
+
+NSData* MakeNSData(const pb_bytes_array_t* bytes) {
+  if (!bytes) {
+    return [NSData data];
+  }
+  return [NSData dataWithBytes:bytes->bytes length:bytes->size];
+}
+
+std::vector<TargetId> MakeTargetIds(const int32_t* target_ids,
+                                    pb_size_t count) {
+  return std::vector<TargetId>(target_ids, target_ids + count);
+}
+
+/**
+ * Builds the Objective-C model values of a response directly from its nanopb
+ * messages, producing the same values as `FSTSerializerBeta` does from the
+ * equivalent protobuf objects.
+ */
+class ObjcValueDecoder {
+ public:
+  ObjcValueDecoder(const Serializer& serializer, const DatabaseId* database_id)
+      : serializer_{serializer}, database_id_{database_id} {
+  }
+
+  FSTFieldValue* DecodeFieldValue(
+      Reader* reader, const google_firestore_v1_Value& proto) const {
+    switch (proto.which_value_type) {
+      case google_firestore_v1_Value_reference_value_tag: {
+        DocumentKey key = DecodeKey(reader, proto.reference_value);
+        return [FSTReferenceValue
+            referenceValue:[FSTDocumentKey keyWithDocumentKey:key]
+                databaseID:database_id_];
+      }
+
+      case google_firestore_v1_Value_array_value_tag: {
+        const google_firestore_v1_ArrayValue& array = proto.array_value;
+        NSMutableArray<FSTFieldValue*>* contents =
+            [NSMutableArray arrayWithCapacity:array.values_count];
+        for (pb_size_t i = 0; i < array.values_count; ++i) {
+          [contents addObject:DecodeFieldValue(reader, array.values[i])];
+        }
+        return [[FSTArrayValue alloc] initWithValueNoCopy:contents];
+      }
+
+      case google_firestore_v1_Value_map_value_tag:
+        return DecodeFields(reader, proto.map_value.fields_count,
+                            proto.map_value.fields);
+
+      default:
+        // Scalars have a single representation in both models.
+        return Serializer::DecodeFieldValue(reader, proto).Wrap();
+    }
+  }
+
+  /** Decodes the entries of a `Document` or `MapValue`. */
+  template <typename Entry>
+  FSTObjectValue* DecodeFields(Reader* reader,
+                               pb_size_t count,
+                               const Entry* fields) const {
+    NSMutableDictionary<NSString*, FSTFieldValue*>* result =
+        [NSMutableDictionary dictionaryWithCapacity:count];
+    for (pb_size_t i = 0; i < count; ++i) {
+      NSString* key =
+          util::WrapNSString(Serializer::DecodeString(fields[i].key));
+      result[key] = DecodeFieldValue(reader, fields[i].value);
+    }
+    return [[FSTObjectValue alloc] initWithDictionary:result];
+  }
+
+  DocumentKey DecodeKey(Reader* reader, const pb_bytes_array_t* name) const {
+    return serializer_.DecodeKey(reader, Serializer::DecodeString(name));
+  }
+
+  FSTMutationResult* DecodeMutationResult(
+      Reader* reader,
+      const google_firestore_v1_WriteResult& proto,
+      const SnapshotVersion& commit_version) const {
+    // Deletes don't have an update time; use the commit version instead.
+    SnapshotVersion version =
+        Serializer::DecodeSnapshotVersion(reader, proto.update_time);
+    if (version == SnapshotVersion::None()) {
+      version = commit_version;
+    }
+
+    NSMutableArray<FSTFieldValue*>* transform_results = nil;
+    if (proto.transform_results_count > 0) {
+      transform_results =
+          [NSMutableArray arrayWithCapacity:proto.transform_results_count];
+      for (pb_size_t i = 0; i < proto.transform_results_count; ++i) {
+        [transform_results
+            addObject:DecodeFieldValue(reader, proto.transform_results[i])];
+      }
+    }
+    return [[FSTMutationResult alloc] initWithVersion:std::move(version)
+                                     transformResults:transform_results];
+  }
+
+ private:
+  const Serializer& serializer_;
+  const DatabaseId* database_id_;
+};
+
+WatchTargetChangeState DecodeTargetChangeState(
+    Reader* reader, google_firestore_v1_TargetChange_TargetChangeType state) {
+  switch (state) {
+    case google_firestore_v1_TargetChange_TargetChangeType_NO_CHANGE:
+      return WatchTargetChangeState::NoChange;
+    case google_firestore_v1_TargetChange_TargetChangeType_ADD:
+      return WatchTargetChangeState::Added;
+    case google_firestore_v1_TargetChange_TargetChangeType_REMOVE:
+      return WatchTargetChangeState::Removed;
+    case google_firestore_v1_TargetChange_TargetChangeType_CURRENT:
+      return WatchTargetChangeState::Current;
+    case google_firestore_v1_TargetChange_TargetChangeType_RESET:
+      return WatchTargetChangeState::Reset;
+  }
+  reader->Fail(StringFormat("Unexpected TargetChange.state: %s", state));
+  return WatchTargetChangeState::NoChange;
+}
+
+SnapshotVersion DecodeListenSnapshotVersion(
+    Reader* reader, const google_firestore_v1_ListenResponse& proto) {
+  // Only a target change that applies to all targets (i.e. has no target ids)
+  // and has a read time marks a consistent snapshot for the entire stream. The
+  // backend is guaranteed to send such responses.
+  if (proto.which_response_type !=
+          google_firestore_v1_ListenResponse_target_change_tag ||
+      proto.target_change.target_ids_count != 0) {
+    return SnapshotVersion::None();
+  }
+  return Serializer::DecodeSnapshotVersion(reader,
+                                           proto.target_change.read_time);
+}
+
 }  // namespace
 
 bool IsLoggingEnabled() {
@@ -157,6 +361,139 @@ SnapshotVersion WatchStreamSerializer::ToSnapshotVersion(
   return [serializer_ versionFromListenResponse:proto];
 }
 
+std::unique_ptr<WatchChange> WatchStreamSerializer::DecodeResponse(
+    const grpc::ByteBuffer& message,
+    SnapshotVersion* out_snapshot_version,
+    Status* out_status) const {
+  FlatByteBuffer buffer{message};
+  if (!buffer.ok()) {
+    *out_status = {FirestoreErrorCode::Internal,
+                   "Trying to decode an invalid grpc::ByteBuffer"};
+    return nullptr;
+  }
+
+  Reader reader = Reader::Wrap(buffer.bytes());
+  google_firestore_v1_ListenResponse proto{};
+  reader.ReadNanopbMessage(google_firestore_v1_ListenResponse_fields, &proto);
+
+  std::unique_ptr<WatchChange> change;
+  SnapshotVersion snapshot_version = SnapshotVersion::None();
+  if (reader.status().ok()) {
+    change = DecodeWatchChange(&reader, proto, buffer.bytes());
+    snapshot_version = DecodeListenSnapshotVersion(&reader, proto);
+  }
+  reader.FreeNanopbMessage(google_firestore_v1_ListenResponse_fields, &proto);
+
+  if (!reader.status().ok()) {
+    *out_status = ResponseDecodingError(reader.status(), message);
+    return nullptr;
+  }
+  *out_snapshot_version = snapshot_version;
+  *out_status = Status::OK();
+  return change;
+}
+
+std::unique_ptr<WatchChange> WatchStreamSerializer::DecodeWatchChange(
+    Reader* reader,
+    const google_firestore_v1_ListenResponse& proto,
+    absl::string_view encoded) const {
+  ObjcValueDecoder decoder{nanopb_serializer_, serializer_.databaseID};
+
+  switch (proto.which_response_type) {
+    case google_firestore_v1_ListenResponse_target_change_tag: {
+      const google_firestore_v1_TargetChange& change = proto.target_change;
+      Status cause;
+      if (change.cause.code != 0) {
+        cause = Status{static_cast<FirestoreErrorCode>(change.cause.code),
+                       Serializer::DecodeString(change.cause.message)};
+      }
+      return absl::make_unique<WatchTargetChange>(
+          DecodeTargetChangeState(reader, change.target_change_type),
+          MakeTargetIds(change.target_ids, change.target_ids_count),
+          MakeNSData(change.resume_token), std::move(cause));
+    }
+
+    case google_firestore_v1_ListenResponse_document_change_tag: {
+      const google_firestore_v1_DocumentChange& change = proto.document_change;
+      const google_firestore_v1_Document& document_proto = change.document;
+      DocumentKey key = decoder.DecodeKey(reader, document_proto.name);
+      SnapshotVersion version =
+          Serializer::DecodeSnapshotVersion(reader, document_proto.update_time);
+      if (version == SnapshotVersion::None()) {
+        reader->Fail("Got a document change with no snapshot version");
+      }
+      FSTObjectValue* data = decoder.DecodeFields(
+          reader, document_proto.fields_count, document_proto.fields);
+
+      // The document may soon be written to local persistence. Keep the bytes
+      // it arrived in so that it doesn't have to be encoded again.
+      NSData* encoded_document = nil;
+      absl::optional<absl::string_view> encoded_change =
+          nanopb::FindLengthDelimitedField(
+              encoded, google_firestore_v1_ListenResponse_document_change_tag);
+      absl::optional<absl::string_view> encoded_proto;
+      if (encoded_change) {
+        encoded_proto = nanopb::FindLengthDelimitedField(
+            *encoded_change, google_firestore_v1_DocumentChange_document_tag);
+      }
+      if (encoded_proto) {
+        encoded_document = [NSData dataWithBytes:encoded_proto->data()
+                                          length:encoded_proto->size()];
+      }
+
+      FSTMaybeDocument* document =
+          [FSTDocument documentWithData:data
+                                    key:key
+                                version:std::move(version)
+                                  state:FSTDocumentStateSynced
+                           encodedProto:encoded_document];
+      return absl::make_unique<DocumentWatchChange>(
+          MakeTargetIds(change.target_ids, change.target_ids_count),
+          MakeTargetIds(change.removed_target_ids,
+                        change.removed_target_ids_count),
+          std::move(key), document);
+    }
+
+    case google_firestore_v1_ListenResponse_document_delete_tag: {
+      const google_firestore_v1_DocumentDelete& change = proto.document_delete;
+      DocumentKey key = decoder.DecodeKey(reader, change.document);
+      // The read time might be unset, which decodes as SnapshotVersion::None().
+      SnapshotVersion version =
+          Serializer::DecodeSnapshotVersion(reader, change.read_time);
+      FSTMaybeDocument* document =
+          [FSTDeletedDocument documentWithKey:key
+                                      version:std::move(version)
+                        hasCommittedMutations:NO];
+      return absl::make_unique<DocumentWatchChange>(
+          std::vector<TargetId>{},
+          MakeTargetIds(change.removed_target_ids,
+                        change.removed_target_ids_count),
+          std::move(key), document);
+    }
+
+    case google_firestore_v1_ListenResponse_document_remove_tag: {
+      const google_firestore_v1_DocumentRemove& change = proto.document_remove;
+      DocumentKey key = decoder.DecodeKey(reader, change.document);
+      return absl::make_unique<DocumentWatchChange>(
+          std::vector<TargetId>{},
+          MakeTargetIds(change.removed_target_ids,
+                        change.removed_target_ids_count),
+          std::move(key), nil);
+    }
+
+    case google_firestore_v1_ListenResponse_filter_tag: {
+      const google_firestore_v1_ExistenceFilter& filter = proto.filter;
+      return absl::make_unique<ExistenceFilterWatchChange>(
+          ExistenceFilter{filter.count}, filter.target_id);
+    }
+
+    default:
+      reader->Fail(StringFormat("Unknown WatchChange.changeType %s",
+                                proto.which_response_type));
+      return nullptr;
+  }
+}
+
 NSString* WatchStreamSerializer::Describe(GCFSListenRequest* request) {
   return [request description];
 }
@@ -167,10 +504,6 @@ NSString* WatchStreamSerializer::Describe(GCFSListenResponse* response) {
 
 // WriteStreamSerializer
 
-void WriteStreamSerializer::UpdateLastStreamToken(GCFSWriteResponse* proto) {
-  last_stream_token_ = proto.streamToken;
-}
-
 GCFSWriteRequest* WriteStreamSerializer::CreateHandshake() const {
   // The initial request cannot contain mutations, but must contain a projectID.
   GCFSWriteRequest* request = [GCFSWriteRequest message];
@@ -193,6 +526,43 @@ GCFSWriteRequest* WriteStreamSerializer::CreateWriteMutationsRequest(
   return request;
 }
 
+GCFSWriteRequest* WriteStreamSerializer::CreateCoalescedWriteMutationsRequest(
+    BatchIterator begin,
+    BatchIterator end,
+    size_t max_bytes,
+    size_t* out_batch_count) const {
+  HARD_ASSERT(begin != end, "Coalescing an empty list of batches");
+
+  NSMutableArray<GCFSWrite*>* protos = [NSMutableArray array];
+  size_t total_bytes = 0;
+  size_t batch_count = 0;
+  for (auto iter = begin; iter != end; ++iter) {
+    const std::vector<FSTMutation*>& mutations = [*iter mutations];
+    NSMutableArray<GCFSWrite*>* batch_protos =
+        [NSMutableArray arrayWithCapacity:mutations.size()];
+    size_t batch_bytes = 0;
+    for (FSTMutation* mutation : mutations) {
+      GCFSWrite* proto = [serializer_ encodedMutation:mutation];
+      batch_bytes += static_cast<size_t>([proto serializedSize]);
+      [batch_protos addObject:proto];
+    }
+
+    if (batch_count > 0 && total_bytes + batch_bytes > max_bytes) {
+      break;
+    }
+    [protos addObjectsFromArray:batch_protos];
+    total_bytes += batch_bytes;
+    ++batch_count;
+  }
+
+  *out_batch_count = batch_count;
+
+  GCFSWriteRequest* request = [GCFSWriteRequest message];
+  request.writesArray = protos;
+  request.streamToken = last_stream_token_;
+  return request;
+}
+
 grpc::ByteBuffer WriteStreamSerializer::ToByteBuffer(
     GCFSWriteRequest* request) {
   return ConvertToByteBuffer([request data]);
@@ -222,6 +592,46 @@ std::vector<FSTMutationResult*> WriteStreamSerializer::ToMutationResults(
   return results;
 }
 
+Status WriteStreamSerializer::DecodeResponse(
+    const grpc::ByteBuffer& message,
+    SnapshotVersion* out_commit_version,
+    std::vector<FSTMutationResult*>* out_results) {
+  // Write responses keep none of their bytes, so they're decoded straight
+  // from the slices they arrived in.
+  ByteBufferReader buffer{message};
+  Reader* reader = buffer.reader();
+  if (!reader->status().ok()) {
+    return reader->status();
+  }
+
+  google_firestore_v1_WriteResponse proto{};
+  reader->ReadNanopbMessage(google_firestore_v1_WriteResponse_fields, &proto);
+
+  NSData* stream_token = nil;
+  SnapshotVersion commit_version;
+  std::vector<FSTMutationResult*> results;
+  if (reader->status().ok()) {
+    ObjcValueDecoder decoder{nanopb_serializer_, serializer_.databaseID};
+    stream_token = MakeNSData(proto.stream_token);
+    commit_version =
+        Serializer::DecodeSnapshotVersion(reader, proto.commit_time);
+    results.reserve(proto.write_results_count);
+    for (pb_size_t i = 0; i < proto.write_results_count; ++i) {
+      results.push_back(decoder.DecodeMutationResult(
+          reader, proto.write_results[i], commit_version));
+    }
+  }
+  reader->FreeNanopbMessage(google_firestore_v1_WriteResponse_fields, &proto);
+
+  if (!reader->status().ok()) {
+    return ResponseDecodingError(reader->status(), message);
+  }
+  last_stream_token_ = stream_token;
+  *out_commit_version = commit_version;
+  *out_results = std::move(results);
+  return Status::OK();
+}
+
 NSString* WriteStreamSerializer::Describe(GCFSWriteRequest* request) {
   return [request description];
 }
@@ -273,26 +683,13 @@ grpc::ByteBuffer DatastoreSerializer::ToByteBuffer(
   return ConvertToByteBuffer([request data]);
 }
 
-std::vector<FSTMaybeDocument*> DatastoreSerializer::MergeLookupResponses(
-    const std::vector<grpc::ByteBuffer>& responses, Status* out_status) const {
-  // Sort by key.
-  std::map<DocumentKey, FSTMaybeDocument*> results;
-
-  for (const auto& response : responses) {
-    auto* proto = ToProto<GCFSBatchGetDocumentsResponse>(response, out_status);
-    if (!out_status->ok()) {
-      return {};
-    }
-    FSTMaybeDocument* doc = [serializer_ decodedMaybeDocumentFromBatch:proto];
-    results[doc.key] = doc;
-  }
-
-  std::vector<FSTMaybeDocument*> docs;
-  docs.reserve(results.size());
-  for (const auto& kv : results) {
-    docs.push_back(kv.second);
+FSTMaybeDocument* DatastoreSerializer::ToMaybeDocument(
+    const grpc::ByteBuffer& response, Status* out_status) const {
+  auto* proto = ToProto<GCFSBatchGetDocumentsResponse>(response, out_status);
+  if (!out_status->ok()) {
+    return nil;
   }
-  return docs;
+  return ToMaybeDocument(proto);
 }
 
 FSTMaybeDocument* DatastoreSerializer::ToMaybeDocument(
@@ -23,26 +23,34 @@
 
 #import <Foundation/Foundation.h>
 
+#include <chrono>  // NOLINT(build/c++11)
+#include <deque>
 #include <memory>
 #include <unordered_map>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/core/bulk_writer.h"
 #include "Firestore/core/src/firebase/firestore/core/transaction.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/remote/connectivity_monitor.h"
 #include "Firestore/core/src/firebase/firestore/remote/datastore.h"
 #include "Firestore/core/src/firebase/firestore/remote/online_state_tracker.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
+#include "Firestore/core/src/firebase/firestore/remote/stream_metrics.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_stream.h"
 #include "Firestore/core/src/firebase/firestore/remote/write_stream.h"
+#include "Firestore/core/src/firebase/firestore/remote/write_window.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "absl/types/optional.h"
 
 @class FSTLocalStore;
 @class FSTMutationBatch;
 @class FSTMutationBatchResult;
+@class FSTQuery;
 @class FSTQueryData;
 @class FSTTransaction;
 
@@ -109,6 +117,17 @@ namespace firebase {
 namespace firestore {
 namespace remote {
 
+/** A snapshot of the network counters and latencies of a `RemoteStore`. */
+struct NetworkMetrics {
+  StreamMetrics watch_stream;
+  StreamMetrics write_stream;
+  /**
+   * Every message exchanged with the backend, including one-off calls such as
+   * transaction lookups and commits.
+   */
+  GrpcTrafficStats traffic;
+};
+
 class RemoteStore : public TargetMetadataProvider,
                     public WatchStreamCallback,
                     public WriteStreamCallback {
@@ -122,6 +141,35 @@ class RemoteStore : public TargetMetadataProvider,
     sync_engine_ = sync_engine;
   }
 
+  /**
+   * Sets the largest encoded size of the mutations packed into a single write
+   * request. Consecutive batches in the write pipeline are sent together for
+   * as long as they fit. 0, the default, sends every batch in its own
+   * request.
+   */
+  void set_max_coalesced_write_bytes(size_t value) {
+    max_coalesced_write_bytes_ = value;
+  }
+
+  /** Returns the network metrics accumulated since the store was created. */
+  NetworkMetrics GetNetworkMetrics() const;
+
+  /**
+   * Returns what watch has sent for the given query since it was last
+   * listened to, or nothing if it isn't being listened to.
+   */
+  absl::optional<TargetStatistics> GetTargetStatistics(FSTQuery* query) const;
+
+  /** The number of targets being listened to. */
+  size_t active_target_count() const {
+    return listen_targets_.size();
+  }
+
+  /** The number of writes waiting to be sent or acknowledged. */
+  size_t pending_write_count() const {
+    return write_pipeline_.size();
+  }
+
   /**
    * Starts up the remote store, creating streams, restoring state from
    * `FSTLocalStore`, etc.
@@ -177,14 +225,36 @@ class RemoteStore : public TargetMetadataProvider,
    */
   void AddToWritePipeline(FSTMutationBatch* batch);
 
+  /**
+   * Returns the current size of the write pipeline and how many writes it
+   * allows, along with counters describing how the pipeline has adapted.
+   */
+  WritePipelineStats GetWritePipelineStats() const;
+
   /** Returns a new transaction backed by this remote store. */
   // TODO(c++14): return a plain value when it becomes possible to move
   // `Transaction` into lambdas.
   std::shared_ptr<core::Transaction> CreateTransaction();
 
+  /**
+   * Returns a new bulk writer that commits its writes through this remote
+   * store's datastore, bypassing the write pipeline.
+   */
+  std::shared_ptr<core::BulkWriter> CreateBulkWriter();
+
+  /**
+   * Fetches the documents with the given keys from the backend in a single
+   * lookup, bypassing the local cache and the watch stream. Fails with
+   * `Unavailable` while the network is disabled.
+   */
+  void LookupDocuments(const std::vector<model::DocumentKey>& keys,
+                       Datastore::LookupCallback&& callback);
+
   model::DocumentKeySet GetRemoteKeysForTarget(
       model::TargetId target_id) const override;
   FSTQueryData* GetQueryDataForTarget(model::TargetId target_id) const override;
+  const model::DatabaseId& GetDatabaseId() const override;
+  TargetStatistics* GetStatisticsForTarget(model::TargetId target_id) override;
 
   void OnWatchStreamOpen() override;
   void OnWatchStreamChange(
@@ -202,6 +272,14 @@ class RemoteStore : public TargetMetadataProvider,
  private:
   void DisableNetworkInternal();
 
+  /**
+   * Restarts the streams that are waiting out a backoff as soon as the network
+   * becomes available again, rather than when the backoff delay expires. The
+   * streams have just failed because the connection was reset, not because
+   * the backend is overloaded.
+   */
+  void HandleNetworkStatusChange(ConnectivityMonitor::NetworkStatus status);
+
   void SendWatchRequest(FSTQueryData* query_data);
   void SendUnwatchRequest(model::TargetId target_id);
 
@@ -222,6 +300,16 @@ class RemoteStore : public TargetMetadataProvider,
 
   void StartWriteStream();
 
+  /**
+   * Sends the writes in the pipeline that haven't been sent on the current
+   * write stream yet, packing them into as few requests as
+   * `max_coalesced_write_bytes_` allows.
+   */
+  void SendPendingWrites();
+
+  /** Forgets which writes were sent on the current write stream. */
+  void ResetSentWrites();
+
   /**
    * Returns true if the network is enabled, the write stream has not yet been
    * started and there are pending writes.
@@ -254,6 +342,8 @@ class RemoteStore : public TargetMetadataProvider,
   /** The client-side proxy for interacting with the backend. */
   std::shared_ptr<Datastore> datastore_;
 
+  util::AsyncQueue* worker_queue_ = nullptr;
+
   /**
    * A mapping of watched targets that the client cares about tracking and the
    * user has explicitly called a 'listen' for this target.
@@ -265,6 +355,9 @@ class RemoteStore : public TargetMetadataProvider,
    */
   std::unordered_map<model::TargetId, FSTQueryData*> listen_targets_;
 
+  /** The watch traffic of each of the `listen_targets_`. */
+  std::unordered_map<model::TargetId, TargetStatistics> target_statistics_;
+
   OnlineStateTracker online_state_tracker_;
 
   /**
@@ -278,9 +371,24 @@ class RemoteStore : public TargetMetadataProvider,
   std::unique_ptr<WatchChangeAggregator> watch_change_aggregator_;
 
   /**
-   * A list of up to `kMaxPendingWrites` writes that we have fetched from the
-   * `LocalStore` via `FillWritePipeline` and have or will send to the write
-   * stream.
+   * When the first watch stream was started, kept until that stream opens to
+   * measure how long startup waits for the channel to connect.
+   */
+  absl::optional<std::chrono::steady_clock::time_point>
+      first_watch_stream_start_;
+  bool first_watch_stream_opened_ = false;
+
+  /**
+   * When the network last became available while there were active targets,
+   * kept until the next global snapshot to measure how long it takes to catch
+   * up with the backend.
+   */
+  absl::optional<std::chrono::steady_clock::time_point> network_restored_at_;
+
+  /**
+   * A list of up to `write_window_.size()` writes that we have fetched from
+   * the `LocalStore` via `FillWritePipeline` and have or will send to the
+   * write stream.
    *
    * Whenever `write_pipeline_` is not empty, the `RemoteStore` will attempt to
    * start or restart the write stream. When the stream is established, the
@@ -295,6 +403,35 @@ class RemoteStore : public TargetMetadataProvider,
    * the `write_pipeline_` as we receive responses.
    */
   std::vector<FSTMutationBatch*> write_pipeline_;
+
+  /**
+   * Decides how many writes `write_pipeline_` may hold, based on how quickly
+   * the backend acknowledges them and whether the write stream fails.
+   */
+  WriteWindow write_window_;
+
+  size_t max_coalesced_write_bytes_ = 0;
+
+  /**
+   * The number of writes at the front of `write_pipeline_` that have been sent
+   * on the current write stream.
+   */
+  size_t sent_writes_count_ = 0;
+
+  /**
+   * The number of batches in each request sent on the current write stream
+   * that hasn't been responded to yet, oldest first. Each response holds the
+   * results of all the batches in its request.
+   */
+  std::deque<size_t> sent_request_batch_counts_;
+
+  /**
+   * The number of writes to send in requests of their own, regardless of
+   * `max_coalesced_write_bytes_`. A permanent error on a request with several
+   * batches in it doesn't tell which of them is at fault, so they are retried
+   * one at a time.
+   */
+  size_t writes_to_send_individually_ = 0;
 };
 
 }  // namespace remote
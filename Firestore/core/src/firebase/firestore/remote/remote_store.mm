@@ -18,19 +18,26 @@
 
 #include <utility>
 
+#import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Local/FSTLocalStore.h"
 #import "Firestore/Source/Local/FSTQueryData.h"
 #import "Firestore/Source/Model/FSTMutationBatch.h"
 
+#include "Firestore/core/src/firebase/firestore/core/bulk_writer.h"
 #include "Firestore/core/src/firebase/firestore/core/transaction.h"
 #include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
 #include "Firestore/core/src/firebase/firestore/util/error_apple.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/metrics_registry.h"
+#include "Firestore/core/src/firebase/firestore/util/tracing.h"
 #include "absl/memory/memory.h"
 
+using firebase::firestore::core::BulkWriter;
 using firebase::firestore::core::Transaction;
 using firebase::firestore::model::BatchId;
+using firebase::firestore::model::DatabaseId;
+using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::OnlineState;
 using firebase::firestore::model::SnapshotVersion;
@@ -48,17 +55,57 @@ using firebase::firestore::remote::WatchChangeAggregator;
 using firebase::firestore::remote::WatchTargetChange;
 using firebase::firestore::remote::WatchTargetChangeState;
 using firebase::firestore::util::AsyncQueue;
+using firebase::firestore::util::MetricsRegistry;
 using firebase::firestore::util::Status;
 
 namespace firebase {
 namespace firestore {
 namespace remote {
 
-/**
- * The maximum number of pending writes to allow.
- * TODO(b/35853402): Negotiate this value with the backend.
- */
-constexpr int kMaxPendingWrites = 10;
+namespace {
+
+/** The metrics that every `RemoteStore` in the process records into. */
+struct RemoteStoreMetrics {
+  MetricsRegistry::Counter* listens =
+      MetricsRegistry::Default().GetCounter("remote_store.listens");
+  MetricsRegistry::Counter* unlistens =
+      MetricsRegistry::Default().GetCounter("remote_store.unlistens");
+  MetricsRegistry::Gauge* listen_targets =
+      MetricsRegistry::Default().GetGauge("remote_store.listen_targets");
+  MetricsRegistry::Counter* remote_events =
+      MetricsRegistry::Default().GetCounter("remote_store.remote_events");
+  MetricsRegistry::Counter* target_errors =
+      MetricsRegistry::Default().GetCounter("remote_store.target_errors");
+  MetricsRegistry::Counter* batches_sent =
+      MetricsRegistry::Default().GetCounter("remote_store.batches_sent");
+  MetricsRegistry::Counter* write_requests =
+      MetricsRegistry::Default().GetCounter("remote_store.write_requests");
+  MetricsRegistry::Counter* batches_acknowledged =
+      MetricsRegistry::Default().GetCounter(
+          "remote_store.batches_acknowledged");
+  MetricsRegistry::Counter* batches_rejected =
+      MetricsRegistry::Default().GetCounter("remote_store.batches_rejected");
+  /** From starting the first watch stream until it opened. */
+  MetricsRegistry::Histogram* startup_watch_stream_open =
+      MetricsRegistry::Default().GetHistogram(
+          "startup.watch_stream_open_latency");
+  MetricsRegistry::Counter* network_restarts =
+      MetricsRegistry::Default().GetCounter("remote_store.network_restarts");
+  /**
+   * From the network becoming available again until the next global snapshot
+   * of the active targets.
+   */
+  MetricsRegistry::Histogram* time_to_resync =
+      MetricsRegistry::Default().GetHistogram(
+          "remote_store.time_to_resync_latency");
+};
+
+RemoteStoreMetrics& Metrics() {
+  static RemoteStoreMetrics metrics;
+  return metrics;
+}
+
+}  // namespace
 
 RemoteStore::RemoteStore(
     FSTLocalStore* local_store,
@@ -67,12 +114,24 @@ RemoteStore::RemoteStore(
     std::function<void(model::OnlineState)> online_state_handler)
     : local_store_{local_store},
       datastore_{std::move(datastore)},
+      worker_queue_{worker_queue},
       online_state_tracker_{worker_queue, std::move(online_state_handler)} {
   datastore_->Start();
 
   // Create streams (but note they're not started yet)
   watch_stream_ = datastore_->CreateWatchStream(this);
   write_stream_ = datastore_->CreateWriteStream(this);
+
+  // `datastore_` is owned by this store, so the callback can't outlive it.
+  datastore_->AddConnectivityCallback(
+      [this](ConnectivityMonitor::NetworkStatus status) {
+        HandleNetworkStatusChange(status);
+      });
+}
+
+NetworkMetrics RemoteStore::GetNetworkMetrics() const {
+  return {watch_stream_->metrics(), write_stream_->metrics(),
+          datastore_->traffic_stats()};
 }
 
 void RemoteStore::Start() {
@@ -116,10 +175,49 @@ void RemoteStore::DisableNetworkInternal() {
               write_pipeline_.size());
     write_pipeline_.clear();
   }
+  write_window_.RecordStreamClose();
+  ResetSentWrites();
+  writes_to_send_individually_ = 0;
+  network_restored_at_.reset();
 
   CleanUpWatchStreamState();
 }
 
+void RemoteStore::HandleNetworkStatusChange(
+    ConnectivityMonitor::NetworkStatus status) {
+  if (status == ConnectivityMonitor::NetworkStatus::Unavailable ||
+      !CanUseNetwork()) {
+    return;
+  }
+
+  // By now, the connection has failed the streams that were open on the old
+  // network, and they have gone into backoff.
+  watch_stream_->CancelBackoff();
+  write_stream_->CancelBackoff();
+
+  bool should_start_watch_stream = ShouldStartWatchStream();
+  bool should_start_write_stream = ShouldStartWriteStream();
+  if (!should_start_watch_stream && !should_start_write_stream) {
+    return;
+  }
+
+  LOG_DEBUG("RemoteStore %s restarting streams after a network change", this);
+  Metrics().network_restarts->Increment();
+
+  // Set up the new channel while the streams are fetching credentials.
+  datastore_->Preconnect();
+
+  // The watch stream sends the resume tokens of `listen_targets_` as it opens,
+  // so only the changes made while the network was down are sent again.
+  if (should_start_watch_stream) {
+    network_restored_at_ = std::chrono::steady_clock::now();
+    StartWatchStream();
+  }
+  if (should_start_write_stream) {
+    StartWriteStream();
+  }
+}
+
 void RemoteStore::Shutdown() {
   LOG_DEBUG("RemoteStore %s shutting down", this);
   is_network_enabled_ = false;
@@ -141,6 +239,8 @@ void RemoteStore::Listen(FSTQueryData* query_data) {
 
   // Mark this as something the client is currently listening for.
   listen_targets_[targetKey] = query_data;
+  Metrics().listens->Increment();
+  Metrics().listen_targets->Add(1);
 
   if (ShouldStartWatchStream()) {
     // The listen will be sent in `OnWatchStreamOpen`
@@ -154,6 +254,9 @@ void RemoteStore::StopListening(TargetId target_id) {
   size_t num_erased = listen_targets_.erase(target_id);
   HARD_ASSERT(num_erased == 1,
               "StopListening: target not currently watched: %s", target_id);
+  target_statistics_.erase(target_id);
+  Metrics().unlistens->Increment();
+  Metrics().listen_targets->Add(-1);
 
   // The watch stream might not be started if we're in a disconnected state
   if (watch_stream_->IsOpen()) {
@@ -195,6 +298,9 @@ void RemoteStore::StartWatchStream() {
   HARD_ASSERT(ShouldStartWatchStream(),
               "StartWatchStream called when ShouldStartWatchStream is false.");
   watch_change_aggregator_ = absl::make_unique<WatchChangeAggregator>(this);
+  if (!first_watch_stream_start_) {
+    first_watch_stream_start_ = std::chrono::steady_clock::now();
+  }
   watch_stream_->Start();
 
   online_state_tracker_.HandleWatchStreamStart();
@@ -205,13 +311,25 @@ void RemoteStore::CleanUpWatchStreamState() {
 }
 
 void RemoteStore::OnWatchStreamOpen() {
-  // Restore any existing watches.
+  TRACE_SPAN("remote", "RemoteStore::OnWatchStreamOpen");
+  if (!first_watch_stream_opened_) {
+    first_watch_stream_opened_ = true;
+    Metrics().startup_watch_stream_open->RecordElapsedSince(
+        *first_watch_stream_start_);
+  }
+
+  // Restore any existing watches, writing them to the network together.
+  std::vector<FSTQueryData*> queries;
+  queries.reserve(listen_targets_.size());
   for (const auto& kv : listen_targets_) {
-    SendWatchRequest(kv.second);
+    watch_change_aggregator_->RecordPendingTargetRequest(kv.first);
+    queries.push_back(kv.second);
   }
+  watch_stream_->WatchQueries(queries);
 }
 
 void RemoteStore::OnWatchStreamClose(const Status& status) {
+  TRACE_SPAN("remote", "RemoteStore::OnWatchStreamClose");
   if (status.ok()) {
     // Graceful stop (due to Stop() or idle timeout). Make sure that's
     // desirable.
@@ -236,6 +354,7 @@ void RemoteStore::OnWatchStreamClose(const Status& status) {
 
 void RemoteStore::OnWatchStreamChange(const WatchChange& change,
                                       const SnapshotVersion& snapshot_version) {
+  TRACE_SPAN("remote", "RemoteStore::OnWatchStreamChange");
   // Mark the connection as Online because we got a message from the server.
   online_state_tracker_.UpdateState(OnlineState::Online);
 
@@ -270,12 +389,18 @@ void RemoteStore::OnWatchStreamChange(const WatchChange& change,
 }
 
 void RemoteStore::RaiseWatchSnapshot(const SnapshotVersion& snapshot_version) {
+  TRACE_SPAN("remote", "RemoteStore::RaiseWatchSnapshot");
   HARD_ASSERT(snapshot_version != SnapshotVersion::None(),
               "Can't raise event for unknown SnapshotVersion");
 
   RemoteEvent remote_event =
       watch_change_aggregator_->CreateRemoteEvent(snapshot_version);
 
+  if (network_restored_at_) {
+    Metrics().time_to_resync->RecordElapsedSince(*network_restored_at_);
+    network_restored_at_.reset();
+  }
+
   // Update in-memory resume tokens. `FSTLocalStore` will update the persistent
   // view of these when applying the completed `RemoteEvent`.
   for (const auto& entry : remote_event.target_changes()) {
@@ -333,6 +458,7 @@ void RemoteStore::RaiseWatchSnapshot(const SnapshotVersion& snapshot_version) {
   }
 
   // Finally handle remote event
+  Metrics().remote_events->Increment();
   [sync_engine_ applyRemoteEvent:remote_event];
 }
 
@@ -344,6 +470,9 @@ void RemoteStore::ProcessTargetError(const WatchTargetChange& change) {
     auto found = listen_targets_.find(target_id);
     if (found != listen_targets_.end()) {
       listen_targets_.erase(found);
+      target_statistics_.erase(target_id);
+      Metrics().target_errors->Increment();
+      Metrics().listen_targets->Add(-1);
       watch_change_aggregator_->RemoveTarget(target_id);
       [sync_engine_ rejectListenWithTargetID:target_id
                                        error:util::MakeNSError(change.cause())];
@@ -354,6 +483,7 @@ void RemoteStore::ProcessTargetError(const WatchTargetChange& change) {
 // Write Stream
 
 void RemoteStore::FillWritePipeline() {
+  TRACE_SPAN("remote", "RemoteStore::FillWritePipeline");
   BatchId last_batch_id_retrieved = write_pipeline_.empty()
                                         ? kBatchIdUnknown
                                         : write_pipeline_.back().batchID;
@@ -370,13 +500,19 @@ void RemoteStore::FillWritePipeline() {
     last_batch_id_retrieved = batch.batchID;
   }
 
+  // When coalescing, the batches added above have been waiting to be sent
+  // together.
+  if (write_stream_->IsOpen() && write_stream_->handshake_complete()) {
+    SendPendingWrites();
+  }
+
   if (ShouldStartWriteStream()) {
     StartWriteStream();
   }
 }
 
 bool RemoteStore::CanAddToWritePipeline() const {
-  return CanUseNetwork() && write_pipeline_.size() < kMaxPendingWrites;
+  return CanUseNetwork() && write_pipeline_.size() < write_window_.size();
 }
 
 void RemoteStore::AddToWritePipeline(FSTMutationBatch* batch) {
@@ -385,11 +521,44 @@ void RemoteStore::AddToWritePipeline(FSTMutationBatch* batch) {
 
   write_pipeline_.push_back(batch);
 
-  if (write_stream_->IsOpen() && write_stream_->handshake_complete()) {
-    write_stream_->WriteMutations(batch.mutations);
+  // When coalescing, wait for `FillWritePipeline` to add any batches that
+  // could share a request with this one.
+  if (max_coalesced_write_bytes_ == 0 && write_stream_->IsOpen() &&
+      write_stream_->handshake_complete()) {
+    SendPendingWrites();
+  }
+}
+
+void RemoteStore::SendPendingWrites() {
+  while (sent_writes_count_ < write_pipeline_.size()) {
+    auto unsent = write_pipeline_.begin() + sent_writes_count_;
+
+    size_t batch_count = 1;
+    if (max_coalesced_write_bytes_ > 0 && writes_to_send_individually_ == 0) {
+      batch_count = write_stream_->WriteCoalescedMutations(
+          unsent, write_pipeline_.end(), max_coalesced_write_bytes_);
+    } else {
+      write_stream_->WriteMutations((*unsent).mutations);
+      if (writes_to_send_individually_ > 0) {
+        --writes_to_send_individually_;
+      }
+    }
+
+    sent_writes_count_ += batch_count;
+    sent_request_batch_counts_.push_back(batch_count);
+    Metrics().write_requests->Increment();
+    Metrics().batches_sent->Increment(static_cast<int64_t>(batch_count));
+    for (size_t i = 0; i != batch_count; ++i) {
+      write_window_.RecordSend(WriteWindow::Clock::now());
+    }
   }
 }
 
+void RemoteStore::ResetSentWrites() {
+  sent_writes_count_ = 0;
+  sent_request_batch_counts_.clear();
+}
+
 bool RemoteStore::ShouldStartWriteStream() const {
   return CanUseNetwork() && !write_stream_->IsStarted() &&
          !write_pipeline_.empty();
@@ -402,35 +571,65 @@ void RemoteStore::StartWriteStream() {
 }
 
 void RemoteStore::OnWriteStreamOpen() {
+  TRACE_SPAN("remote", "RemoteStore::OnWriteStreamOpen");
   write_stream_->WriteHandshake();
 }
 
 void RemoteStore::OnWriteStreamHandshakeComplete() {
+  TRACE_SPAN("remote", "RemoteStore::OnWriteStreamHandshakeComplete");
   // Record the stream token.
   [local_store_ setLastStreamToken:write_stream_->GetLastStreamToken()];
 
   // Send the write pipeline now that the stream is established.
-  for (FSTMutationBatch* write : write_pipeline_) {
-    write_stream_->WriteMutations(write.mutations);
-  }
+  ResetSentWrites();
+  SendPendingWrites();
 }
 
 void RemoteStore::OnWriteStreamMutationResult(
     SnapshotVersion commit_version,
     std::vector<FSTMutationResult*> mutation_results) {
+  TRACE_SPAN("remote", "RemoteStore::OnWriteStreamMutationResult");
   // This is a response to a write containing mutations and should be correlated
-  // to the first write in our write pipeline.
-  HARD_ASSERT(!write_pipeline_.empty(), "Got result for empty write pipeline");
-
-  FSTMutationBatch* batch = write_pipeline_.front();
-  write_pipeline_.erase(write_pipeline_.begin());
+  // to the first request sent, which holds the first writes in our write
+  // pipeline.
+  HARD_ASSERT(!sent_request_batch_counts_.empty(),
+              "Got result for empty write pipeline");
+  size_t batch_count = sent_request_batch_counts_.front();
+  sent_request_batch_counts_.pop_front();
+  HARD_ASSERT(batch_count <= write_pipeline_.size(),
+              "Got result for more writes than are in the write pipeline");
+
+  std::vector<FSTMutationBatch*> batches{
+      write_pipeline_.begin(), write_pipeline_.begin() + batch_count};
+  write_pipeline_.erase(write_pipeline_.begin(),
+                        write_pipeline_.begin() + batch_count);
+  sent_writes_count_ -= batch_count;
+  Metrics().batches_acknowledged->Increment(static_cast<int64_t>(batch_count));
+
+  // Split the results of a coalesced request among its batches, in order.
+  size_t results_offset = 0;
+  for (FSTMutationBatch* batch : batches) {
+    write_window_.RecordAcknowledgement(WriteWindow::Clock::now());
+
+    std::vector<FSTMutationResult*> batch_results;
+    if (batch_count == 1) {
+      batch_results = std::move(mutation_results);
+    } else {
+      size_t mutation_count = batch.mutations.size();
+      HARD_ASSERT(results_offset + mutation_count <= mutation_results.size(),
+                  "Got fewer results than mutations in the write request");
+      auto results_begin = mutation_results.begin() + results_offset;
+      batch_results.assign(results_begin, results_begin + mutation_count);
+      results_offset += mutation_count;
+    }
 
-  FSTMutationBatchResult* batchResult = [FSTMutationBatchResult
-      resultWithBatch:batch
-        commitVersion:commit_version
-      mutationResults:std::move(mutation_results)
-          streamToken:write_stream_->GetLastStreamToken()];
-  [sync_engine_ applySuccessfulWriteWithResult:batchResult];
+    FSTMutationBatchResult* batchResult = [FSTMutationBatchResult
+        resultWithBatch:batch
+          commitVersion:commit_version
+        mutationResults:std::move(batch_results)
+            streamToken:write_stream_->GetLastStreamToken()];
+    [sync_engine_ applySuccessfulWriteWithResult:batchResult];
+  }
 
   // It's possible that with the completion of this mutation another slot has
   // freed up.
@@ -438,6 +637,7 @@ void RemoteStore::OnWriteStreamMutationResult(
 }
 
 void RemoteStore::OnWriteStreamClose(const Status& status) {
+  TRACE_SPAN("remote", "RemoteStore::OnWriteStreamClose");
   if (status.ok()) {
     // Graceful stop (due to Stop() or idle timeout). Make sure that's
     // desirable.
@@ -445,6 +645,9 @@ void RemoteStore::OnWriteStreamClose(const Status& status) {
                 "Write stream was stopped gracefully while still needed.");
   }
 
+  // Whatever was in flight will be sent again on the next stream.
+  write_window_.RecordStreamClose();
+
   // If the write stream closed due to an error, invoke the error callbacks if
   // there are pending writes.
   if (!status.ok() && !write_pipeline_.empty()) {
@@ -493,8 +696,21 @@ void RemoteStore::HandleWriteError(const Status& status) {
   HARD_ASSERT(!status.ok(), "Handling write error with status OK.");
 
   // Only handle permanent errors here. If it's transient, just let the retry
-  // logic kick in.
+  // logic kick in, but send fewer writes at once in case the backend or the
+  // connection couldn't keep up.
   if (!Datastore::IsPermanentWriteError(status)) {
+    write_window_.RecordFailure();
+    return;
+  }
+
+  // A request with several batches in it is rejected as a whole. Retry them one
+  // at a time to find out which one is the problem.
+  size_t batch_count = sent_request_batch_counts_.empty()
+                           ? 1
+                           : sent_request_batch_counts_.front();
+  if (batch_count > 1) {
+    writes_to_send_individually_ = batch_count;
+    write_stream_->InhibitBackoff();
     return;
   }
 
@@ -502,6 +718,7 @@ void RemoteStore::HandleWriteError(const Status& status) {
   // not going to succeed if we resend it.
   FSTMutationBatch* batch = write_pipeline_.front();
   write_pipeline_.erase(write_pipeline_.begin());
+  Metrics().batches_rejected->Increment();
 
   // In this case it's also unlikely that the server itself is melting
   // down--this was just a bad request so inhibit backoff on the next restart.
@@ -515,6 +732,13 @@ void RemoteStore::HandleWriteError(const Status& status) {
   FillWritePipeline();
 }
 
+WritePipelineStats RemoteStore::GetWritePipelineStats() const {
+  WritePipelineStats stats;
+  write_window_.FillStats(&stats);
+  stats.pending_writes = write_pipeline_.size();
+  return stats;
+}
+
 bool RemoteStore::CanUseNetwork() const {
   // PORTING NOTE: This method exists mostly because web also has to take into
   // account primary vs. secondary state.
@@ -522,7 +746,22 @@ bool RemoteStore::CanUseNetwork() const {
 }
 
 std::shared_ptr<Transaction> RemoteStore::CreateTransaction() {
-  return std::make_shared<Transaction>(datastore_.get());
+  return std::make_shared<Transaction>(datastore_.get(), worker_queue_);
+}
+
+std::shared_ptr<BulkWriter> RemoteStore::CreateBulkWriter() {
+  return BulkWriter::Create(datastore_.get(), worker_queue_);
+}
+
+void RemoteStore::LookupDocuments(const std::vector<DocumentKey>& keys,
+                                  Datastore::LookupCallback&& callback) {
+  if (!CanUseNetwork()) {
+    callback({}, Status{FirestoreErrorCode::Unavailable,
+                        "Failed to get documents because the client is "
+                        "offline."});
+    return;
+  }
+  datastore_->LookupDocuments(keys, std::move(callback));
 }
 
 DocumentKeySet RemoteStore::GetRemoteKeysForTarget(TargetId target_id) const {
@@ -534,6 +773,29 @@ FSTQueryData* RemoteStore::GetQueryDataForTarget(TargetId target_id) const {
   return found != listen_targets_.end() ? found->second : nil;
 }
 
+const DatabaseId& RemoteStore::GetDatabaseId() const {
+  return datastore_->database_id();
+}
+
+TargetStatistics* RemoteStore::GetStatisticsForTarget(TargetId target_id) {
+  if (listen_targets_.find(target_id) == listen_targets_.end()) {
+    return nullptr;
+  }
+  return &target_statistics_[target_id];
+}
+
+absl::optional<TargetStatistics> RemoteStore::GetTargetStatistics(
+    FSTQuery* query) const {
+  for (const auto& kv : listen_targets_) {
+    if ([kv.second.query isEqual:query]) {
+      auto found = target_statistics_.find(kv.first);
+      return found != target_statistics_.end() ? found->second
+                                               : TargetStatistics{};
+    }
+  }
+  return absl::nullopt;
+}
+
 void RemoteStore::HandleCredentialChange() {
   if (CanUseNetwork()) {
     // Tear down and re-create our network streams. This will ensure we get a
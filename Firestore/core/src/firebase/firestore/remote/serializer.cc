@@ -37,6 +37,7 @@
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/nanopb_util.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/wire_writer.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
 #include "Firestore/core/src/firebase/firestore/timestamp_internal.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
@@ -70,6 +71,7 @@ using firebase::firestore::model::SetMutation;
 using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::nanopb::CheckedSize;
 using firebase::firestore::nanopb::Reader;
+using firebase::firestore::nanopb::WireWriter;
 using firebase::firestore::nanopb::Writer;
 using firebase::firestore::util::Status;
 using firebase::firestore::util::StringFormat;
@@ -267,6 +269,350 @@ StructuredQuery DecodeStructuredQuery(
   return query;
 }
 
+/**
+ * Encodes model values straight to the wire format, without the intermediate
+ * nanopb structs (and their per-field allocations) that EncodeFieldValue()
+ * builds.
+ *
+ * Encoding takes two passes. The first computes the size of every nested
+ * message and records them in the order they're visited. The second visits
+ * them in the same order, so it can write each length prefix ahead of its
+ * message into an output buffer that was reserved to the exact size.
+ *
+ * The output matches what pb_encode() produces for the equivalent nanopb
+ * structs: proto3 scalar fields are omitted when zero, except within a oneof.
+ */
+class DirectEncoder {
+ public:
+  /** Returns the size of the encoded google_firestore_v1_Value. */
+  size_t ValueSize(const FieldValue& value);
+
+  /** Returns the size of the encoded google_firestore_v1_Document. */
+  size_t DocumentSize(absl::string_view name, const ObjectValue& value) {
+    return WireWriter::LengthDelimitedFieldSize(
+               google_firestore_v1_Document_name_tag, name.size()) +
+           FieldsSize(google_firestore_v1_Document_fields_tag,
+                      value.GetInternalValue());
+  }
+
+  void WriteValue(WireWriter* writer, const FieldValue& value) {
+    // The top-level value has no length prefix.
+    NextSize();
+    WriteValueContents(writer, value);
+  }
+
+  void WriteDocument(WireWriter* writer,
+                     absl::string_view name,
+                     const ObjectValue& value) {
+    writer->WriteTag(google_firestore_v1_Document_name_tag, PB_WT_STRING);
+    writer->WriteLengthDelimited(name);
+    WriteFields(writer, google_firestore_v1_Document_fields_tag,
+                value.GetInternalValue());
+  }
+
+ private:
+  size_t FieldsSize(uint32_t entry_field_number, const FieldValue::Map& map);
+
+  void WriteValueField(WireWriter* writer,
+                       uint32_t field_number,
+                       const FieldValue& value) {
+    writer->WriteTag(field_number, PB_WT_STRING);
+    writer->WriteVarint(NextSize());
+    WriteValueContents(writer, value);
+  }
+
+  void WriteValueContents(WireWriter* writer, const FieldValue& value);
+  void WriteFields(WireWriter* writer,
+                   uint32_t entry_field_number,
+                   const FieldValue::Map& map);
+
+  /** Reserves a slot for the size of a message visited in the first pass. */
+  size_t ReserveSize() {
+    sizes_.push_back(0);
+    return sizes_.size() - 1;
+  }
+
+  /** Returns the size recorded for the next message of the second pass. */
+  size_t NextSize() {
+    HARD_ASSERT(next_size_ < sizes_.size(),
+                "Wrote more messages than were sized");
+    return sizes_[next_size_++];
+  }
+
+  std::vector<size_t> sizes_;
+  size_t next_size_ = 0;
+};
+
+// The fields entries of Document and MapValue share a layout, which lets
+// DirectEncoder encode both with the same code.
+static_assert(google_firestore_v1_Document_FieldsEntry_key_tag ==
+                      google_firestore_v1_MapValue_FieldsEntry_key_tag &&
+                  google_firestore_v1_Document_FieldsEntry_value_tag ==
+                      google_firestore_v1_MapValue_FieldsEntry_value_tag,
+              "The FieldsEntry messages should have the same field numbers");
+
+uint64_t NanosVarint(const Timestamp& timestamp) {
+  // Negative int32s are sign-extended to 64 bits on the wire.
+  return static_cast<uint64_t>(int64_t{timestamp.nanoseconds()});
+}
+
+size_t TimestampSize(const Timestamp& timestamp) {
+  size_t size = 0;
+  if (timestamp.seconds() != 0) {
+    size += WireWriter::TagSize(google_protobuf_Timestamp_seconds_tag) +
+            WireWriter::VarintSize(static_cast<uint64_t>(timestamp.seconds()));
+  }
+  if (timestamp.nanoseconds() != 0) {
+    size += WireWriter::TagSize(google_protobuf_Timestamp_nanos_tag) +
+            WireWriter::VarintSize(NanosVarint(timestamp));
+  }
+  return size;
+}
+
+void WriteTimestamp(WireWriter* writer, const Timestamp& timestamp) {
+  writer->WriteVarint(TimestampSize(timestamp));
+  if (timestamp.seconds() != 0) {
+    writer->WriteTag(google_protobuf_Timestamp_seconds_tag, PB_WT_VARINT);
+    writer->WriteVarint(static_cast<uint64_t>(timestamp.seconds()));
+  }
+  if (timestamp.nanoseconds() != 0) {
+    writer->WriteTag(google_protobuf_Timestamp_nanos_tag, PB_WT_VARINT);
+    writer->WriteVarint(NanosVarint(timestamp));
+  }
+}
+
+/** Returns the bits of the double as they go on the wire, NaNs included. */
+uint64_t DoubleBits(double value) {
+  return absl::bit_cast<uint64_t>(value);
+}
+
+/**
+ * Returns true if nanopb would omit the double. It compares bytes, so -0.0 is
+ * still written.
+ */
+bool IsDefaultDouble(double value) {
+  return DoubleBits(value) == 0;
+}
+
+size_t GeoPointSize(const GeoPoint& geo_point) {
+  size_t size = 0;
+  if (!IsDefaultDouble(geo_point.latitude())) {
+    size += WireWriter::TagSize(google_type_LatLng_latitude_tag) + 8;
+  }
+  if (!IsDefaultDouble(geo_point.longitude())) {
+    size += WireWriter::TagSize(google_type_LatLng_longitude_tag) + 8;
+  }
+  return size;
+}
+
+void WriteGeoPoint(WireWriter* writer, const GeoPoint& geo_point) {
+  writer->WriteVarint(GeoPointSize(geo_point));
+  if (!IsDefaultDouble(geo_point.latitude())) {
+    writer->WriteTag(google_type_LatLng_latitude_tag, PB_WT_64BIT);
+    writer->WriteFixed64(DoubleBits(geo_point.latitude()));
+  }
+  if (!IsDefaultDouble(geo_point.longitude())) {
+    writer->WriteTag(google_type_LatLng_longitude_tag, PB_WT_64BIT);
+    writer->WriteFixed64(DoubleBits(geo_point.longitude()));
+  }
+}
+
+absl::string_view BlobView(const std::vector<uint8_t>& blob) {
+  return absl::string_view{reinterpret_cast<const char*>(blob.data()),
+                           blob.size()};
+}
+
+size_t DirectEncoder::ValueSize(const FieldValue& value) {
+  size_t slot = ReserveSize();
+  size_t size = 0;
+
+  switch (value.type()) {
+    case FieldValue::Type::Null:
+      size = WireWriter::TagSize(google_firestore_v1_Value_null_value_tag) +
+             WireWriter::VarintSize(google_protobuf_NullValue_NULL_VALUE);
+      break;
+
+    case FieldValue::Type::Boolean:
+      size = WireWriter::TagSize(google_firestore_v1_Value_boolean_value_tag) +
+             1;
+      break;
+
+    case FieldValue::Type::Integer:
+      size = WireWriter::TagSize(google_firestore_v1_Value_integer_value_tag) +
+             WireWriter::VarintSize(
+                 static_cast<uint64_t>(value.integer_value()));
+      break;
+
+    case FieldValue::Type::Double:
+      size =
+          WireWriter::TagSize(google_firestore_v1_Value_double_value_tag) + 8;
+      break;
+
+    case FieldValue::Type::Timestamp:
+      size = WireWriter::LengthDelimitedFieldSize(
+          google_firestore_v1_Value_timestamp_value_tag,
+          TimestampSize(value.timestamp_value()));
+      break;
+
+    case FieldValue::Type::String:
+      size = WireWriter::LengthDelimitedFieldSize(
+          google_firestore_v1_Value_string_value_tag,
+          value.string_value().size());
+      break;
+
+    case FieldValue::Type::Blob:
+      size = WireWriter::LengthDelimitedFieldSize(
+          google_firestore_v1_Value_bytes_value_tag, value.blob_value().size());
+      break;
+
+    case FieldValue::Type::GeoPoint:
+      size = WireWriter::LengthDelimitedFieldSize(
+          google_firestore_v1_Value_geo_point_value_tag,
+          GeoPointSize(value.geo_point_value()));
+      break;
+
+    case FieldValue::Type::Array: {
+      size_t array_slot = ReserveSize();
+      size_t array_size = 0;
+      for (const FieldValue& element : value.array_value()) {
+        array_size += WireWriter::LengthDelimitedFieldSize(
+            google_firestore_v1_ArrayValue_values_tag, ValueSize(element));
+      }
+      sizes_[array_slot] = array_size;
+      size = WireWriter::LengthDelimitedFieldSize(
+          google_firestore_v1_Value_array_value_tag, array_size);
+      break;
+    }
+
+    case FieldValue::Type::Object: {
+      size_t map_slot = ReserveSize();
+      size_t map_size = FieldsSize(google_firestore_v1_MapValue_fields_tag,
+                                   value.object_value());
+      sizes_[map_slot] = map_size;
+      size = WireWriter::LengthDelimitedFieldSize(
+          google_firestore_v1_Value_map_value_tag, map_size);
+      break;
+    }
+
+    case FieldValue::Type::ServerTimestamp:
+    case FieldValue::Type::Reference:
+      // TODO(rsgowman): Implement, along with EncodeFieldValue().
+      HARD_FAIL("Unhandled FieldValue type: %s",
+                static_cast<int>(value.type()));
+  }
+
+  sizes_[slot] = size;
+  return size;
+}
+
+size_t DirectEncoder::FieldsSize(uint32_t entry_field_number,
+                                 const FieldValue::Map& map) {
+  size_t size = 0;
+  for (const auto& kv : map) {
+    size_t entry_slot = ReserveSize();
+    size_t entry_size =
+        WireWriter::LengthDelimitedFieldSize(
+            google_firestore_v1_MapValue_FieldsEntry_key_tag,
+            kv.first.size()) +
+        WireWriter::LengthDelimitedFieldSize(
+            google_firestore_v1_MapValue_FieldsEntry_value_tag,
+            ValueSize(kv.second));
+    sizes_[entry_slot] = entry_size;
+    size +=
+        WireWriter::LengthDelimitedFieldSize(entry_field_number, entry_size);
+  }
+  return size;
+}
+
+void DirectEncoder::WriteValueContents(WireWriter* writer,
+                                       const FieldValue& value) {
+  switch (value.type()) {
+    case FieldValue::Type::Null:
+      writer->WriteTag(google_firestore_v1_Value_null_value_tag, PB_WT_VARINT);
+      writer->WriteVarint(google_protobuf_NullValue_NULL_VALUE);
+      return;
+
+    case FieldValue::Type::Boolean:
+      writer->WriteTag(google_firestore_v1_Value_boolean_value_tag,
+                       PB_WT_VARINT);
+      writer->WriteVarint(value.boolean_value() ? 1 : 0);
+      return;
+
+    case FieldValue::Type::Integer:
+      writer->WriteTag(google_firestore_v1_Value_integer_value_tag,
+                       PB_WT_VARINT);
+      writer->WriteVarint(static_cast<uint64_t>(value.integer_value()));
+      return;
+
+    case FieldValue::Type::Double:
+      writer->WriteTag(google_firestore_v1_Value_double_value_tag,
+                       PB_WT_64BIT);
+      writer->WriteFixed64(DoubleBits(value.double_value()));
+      return;
+
+    case FieldValue::Type::Timestamp:
+      writer->WriteTag(google_firestore_v1_Value_timestamp_value_tag,
+                       PB_WT_STRING);
+      WriteTimestamp(writer, value.timestamp_value());
+      return;
+
+    case FieldValue::Type::String:
+      writer->WriteTag(google_firestore_v1_Value_string_value_tag,
+                       PB_WT_STRING);
+      writer->WriteLengthDelimited(value.string_value());
+      return;
+
+    case FieldValue::Type::Blob:
+      writer->WriteTag(google_firestore_v1_Value_bytes_value_tag,
+                       PB_WT_STRING);
+      writer->WriteLengthDelimited(BlobView(value.blob_value()));
+      return;
+
+    case FieldValue::Type::GeoPoint:
+      writer->WriteTag(google_firestore_v1_Value_geo_point_value_tag,
+                       PB_WT_STRING);
+      WriteGeoPoint(writer, value.geo_point_value());
+      return;
+
+    case FieldValue::Type::Array:
+      writer->WriteTag(google_firestore_v1_Value_array_value_tag,
+                       PB_WT_STRING);
+      writer->WriteVarint(NextSize());
+      for (const FieldValue& element : value.array_value()) {
+        WriteValueField(writer, google_firestore_v1_ArrayValue_values_tag,
+                        element);
+      }
+      return;
+
+    case FieldValue::Type::Object:
+      writer->WriteTag(google_firestore_v1_Value_map_value_tag, PB_WT_STRING);
+      writer->WriteVarint(NextSize());
+      WriteFields(writer, google_firestore_v1_MapValue_fields_tag,
+                  value.object_value());
+      return;
+
+    case FieldValue::Type::ServerTimestamp:
+    case FieldValue::Type::Reference:
+      break;
+  }
+
+  UNREACHABLE();
+}
+
+void DirectEncoder::WriteFields(WireWriter* writer,
+                                uint32_t entry_field_number,
+                                const FieldValue::Map& map) {
+  for (const auto& kv : map) {
+    writer->WriteTag(entry_field_number, PB_WT_STRING);
+    writer->WriteVarint(NextSize());
+    writer->WriteTag(google_firestore_v1_MapValue_FieldsEntry_key_tag,
+                     PB_WT_STRING);
+    writer->WriteLengthDelimited(kv.first);
+    WriteValueField(writer, google_firestore_v1_MapValue_FieldsEntry_value_tag,
+                    kv.second);
+  }
+}
+
 }  // namespace
 
 Serializer::Serializer(
@@ -347,6 +693,19 @@ google_firestore_v1_Value Serializer::EncodeFieldValue(
   UNREACHABLE();
 }
 
+void Serializer::EncodeFieldValueBytes(const FieldValue& field_value,
+                                       std::string* out) {
+  DirectEncoder encoder;
+  size_t size = encoder.ValueSize(field_value);
+  out->clear();
+  out->reserve(size);
+
+  WireWriter writer{out};
+  encoder.WriteValue(&writer, field_value);
+  HARD_ASSERT(out->size() == size, "Encoded %s bytes instead of %s",
+              out->size(), size);
+}
+
 FieldValue Serializer::DecodeFieldValue(Reader* reader,
                                         const google_firestore_v1_Value& msg) {
   switch (msg.which_value_type) {
@@ -469,6 +828,22 @@ google_firestore_v1_Document Serializer::EncodeDocument(
   return result;
 }
 
+void Serializer::EncodeDocumentBytes(const DocumentKey& key,
+                                     const ObjectValue& value,
+                                     std::string* out) const {
+  std::string name = EncodeKey(key);
+
+  DirectEncoder encoder;
+  size_t size = encoder.DocumentSize(name, value);
+  out->clear();
+  out->reserve(size);
+
+  WireWriter writer{out};
+  encoder.WriteDocument(&writer, name, value);
+  HARD_ASSERT(out->size() == size, "Encoded %s bytes instead of %s",
+              out->size(), size);
+}
+
 std::unique_ptr<model::MaybeDocument> Serializer::DecodeMaybeDocument(
     Reader* reader,
     const google_firestore_v1_BatchGetDocumentsResponse& response) const {
@@ -133,6 +133,19 @@ class Serializer {
   static google_firestore_v1_Value EncodeFieldValue(
       const model::FieldValue& field_value);
 
+  /**
+   * Encodes the FieldValue as the bytes of a google_firestore_v1_Value, like
+   * writing the result of EncodeFieldValue() would, but without building the
+   * nanopb struct in between. The size is computed first so that the output
+   * is written in a single allocation.
+   *
+   * @param out Receives the bytes. Its previous contents are discarded, but its
+   *     capacity is kept, so callers encoding many values can reuse one
+   *     buffer and skip the allocation as well.
+   */
+  static void EncodeFieldValueBytes(const model::FieldValue& field_value,
+                                    std::string* out);
+
   /**
    * @brief Converts from nanopb proto to the model FieldValue format.
    */
@@ -162,6 +175,14 @@ class Serializer {
   google_firestore_v1_Document EncodeDocument(
       const model::DocumentKey& key, const model::ObjectValue& value) const;
 
+  /**
+   * Encodes the Document as the bytes of a google_firestore_v1_Document, like
+   * writing the result of EncodeDocument() would. See EncodeFieldValueBytes().
+   */
+  void EncodeDocumentBytes(const model::DocumentKey& key,
+                           const model::ObjectValue& value,
+                           std::string* out) const;
+
   /**
    * @brief Converts from nanopb proto to the model Document format.
    */
@@ -28,6 +28,7 @@
 #include "Firestore/core/src/firebase/firestore/remote/grpc_stream.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_objc_bridge.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/remote/stream_metrics.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
 #include "absl/strings/string_view.h"
@@ -168,6 +169,13 @@ class Stream : public GrpcStreamObserver,
    */
   void InhibitBackoff();
 
+  /**
+   * Cancels the wait of a stream that is backing off after an error and resets
+   * the backoff delay, so that the stream can be started again right away.
+   * Does nothing if the stream isn't waiting to restart.
+   */
+  void CancelBackoff();
+
   /**
    * Marks this stream as idle. If no further actions are performed on the
    * stream for one minute, the stream will automatically close itself and
@@ -187,6 +195,14 @@ class Stream : public GrpcStreamObserver,
    */
   void CancelIdleCheck();
 
+  /**
+   * Returns the network counters and latencies of this stream, accumulated
+   * across all its restarts.
+   */
+  const StreamMetrics& metrics() const {
+    return metrics_;
+  }
+
   // `GrpcStreamObserver` interface -- do not use.
   void OnStreamStart() override;
   void OnStreamRead(const grpc::ByteBuffer& message) override;
@@ -196,8 +212,24 @@ class Stream : public GrpcStreamObserver,
   // `Stream` expects all its methods to be called on the worker queue.
   void EnsureOnQueue() const;
   void Write(grpc::ByteBuffer&& message);
+  void Write(grpc::ByteBuffer&& message, const grpc::WriteOptions& options);
   std::string GetDebugDescription() const;
 
+  util::AsyncQueue* worker_queue() const {
+    return worker_queue_;
+  }
+
+  /**
+   * Closes the stream because a response could not be handled. Subclasses that
+   * handle responses asynchronously use this to report errors that
+   * `NotifyStreamResponse` would otherwise have returned.
+   */
+  void FinishWithReadError(const util::Status& status);
+
+  StreamMetrics* mutable_metrics() {
+    return &metrics_;
+  }
+
   ExponentialBackoff backoff_;
 
  private:
@@ -237,6 +269,10 @@ class Stream : public GrpcStreamObserver,
   // Used to prevent auth if the stream happens to be restarted before token is
   // received.
   int close_count_ = 0;
+
+  StreamMetrics metrics_;
+  LatencyHistogram::Clock::time_point grpc_stream_started_at_;
+  bool awaiting_first_response_ = false;
 };
 
 }  // namespace remote
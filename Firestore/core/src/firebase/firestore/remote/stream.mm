@@ -102,7 +102,9 @@ void Stream::RequestCredentials() {
   // deleted object.
   std::weak_ptr<Stream> weak_this{shared_from_this()};
   int initial_close_count = close_count_;
-  credentials_provider_->GetToken([weak_this, initial_close_count](
+  auto requested_at = LatencyHistogram::Clock::now();
+  credentials_provider_->GetToken([weak_this, initial_close_count,
+                                   requested_at](
                                       const StatusOr<Token>& maybe_token) {
     auto strong_this = weak_this.lock();
     if (!strong_this) {
@@ -110,13 +112,16 @@ void Stream::RequestCredentials() {
     }
 
     strong_this->worker_queue_->EnqueueRelaxed([maybe_token, weak_this,
-                                                initial_close_count] {
+                                                initial_close_count,
+                                                requested_at] {
       auto strong_this = weak_this.lock();
       // Streams can be stopped while waiting for authorization, so need
       // to check the close count.
       if (!strong_this || strong_this->close_count_ != initial_close_count) {
         return;
       }
+      strong_this->metrics_.token_fetch_latency.RecordElapsedSince(
+          requested_at);
       strong_this->ResumeStartWithCredentials(maybe_token);
     });
   });
@@ -134,6 +139,8 @@ void Stream::ResumeStartWithCredentials(const StatusOr<Token>& maybe_token) {
   }
 
   grpc_stream_ = CreateGrpcStream(grpc_connection_, maybe_token.ValueOrDie());
+  grpc_stream_started_at_ = LatencyHistogram::Clock::now();
+  awaiting_first_response_ = true;
   grpc_stream_->Start();
 }
 
@@ -155,9 +162,11 @@ void Stream::BackoffAndTryRestarting() {
               "Should only perform backoff in an error case");
 
   state_ = State::Backoff;
-  backoff_.BackoffAndRun([this] {
+  auto backoff_started_at = LatencyHistogram::Clock::now();
+  backoff_.BackoffAndRun([this, backoff_started_at] {
     HARD_ASSERT(state_ == State::Backoff,
                 "Backoff elapsed but state is now: %s", state_);
+    metrics_.backoff_delay.RecordElapsedSince(backoff_started_at);
 
     state_ = State::Initial;
     Start();
@@ -176,6 +185,19 @@ void Stream::InhibitBackoff() {
   backoff_.Reset();
 }
 
+void Stream::CancelBackoff() {
+  EnsureOnQueue();
+
+  if (state_ == State::Backoff) {
+    LOG_DEBUG("%s cancel backoff", GetDebugDescription());
+    backoff_.Cancel();
+    state_ = State::Error;
+  }
+  if (state_ == State::Error) {
+    InhibitBackoff();
+  }
+}
+
 // Idleness
 
 void Stream::MarkIdle() {
@@ -199,6 +221,14 @@ void Stream::OnStreamRead(const grpc::ByteBuffer& message) {
 
   HARD_ASSERT(IsStarted(), "OnStreamRead called for a stopped stream.");
 
+  ++metrics_.messages_received;
+  metrics_.bytes_received += static_cast<int64_t>(message.Length());
+  if (awaiting_first_response_) {
+    awaiting_first_response_ = false;
+    metrics_.time_to_first_response.RecordElapsedSince(
+        grpc_stream_started_at_);
+  }
+
   if (bridge::IsLoggingEnabled()) {
     LOG_DEBUG("%s headers (whitelisted): %s", GetDebugDescription(),
               Datastore::GetWhitelistedHeadersAsString(
@@ -207,14 +237,20 @@ void Stream::OnStreamRead(const grpc::ByteBuffer& message) {
 
   Status read_status = NotifyStreamResponse(message);
   if (!read_status.ok()) {
-    grpc_stream_->FinishImmediately();
-    // Don't expect gRPC to produce status -- since the error happened on the
-    // client, we have all the information we need.
-    OnStreamFinish(read_status);
-    return;
+    FinishWithReadError(read_status);
   }
 }
 
+void Stream::FinishWithReadError(const Status& status) {
+  EnsureOnQueue();
+  HARD_ASSERT(grpc_stream_, "FinishWithReadError called for a closed stream.");
+
+  grpc_stream_->FinishImmediately();
+  // Don't expect gRPC to produce status -- since the error happened on the
+  // client, we have all the information we need.
+  OnStreamFinish(status);
+}
+
 // Stopping
 
 void Stream::Stop() {
@@ -270,6 +306,7 @@ void Stream::Close(const Status& status) {
   }
   // Step 6 (both): destroy the underlying stream.
   grpc_stream_.reset();
+  awaiting_first_response_ = false;
 
   // Step 7 (both): update the state machine and notify the listener.
   // State must be updated before calling the delegate.
@@ -305,12 +342,19 @@ void Stream::EnsureOnQueue() const {
 }
 
 void Stream::Write(grpc::ByteBuffer&& message) {
+  Write(std::move(message), grpc::WriteOptions{});
+}
+
+void Stream::Write(grpc::ByteBuffer&& message,
+                   const grpc::WriteOptions& options) {
   EnsureOnQueue();
 
   HARD_ASSERT(IsOpen(), "Cannot write when the stream is not open.");
 
   CancelIdleCheck();
-  grpc_stream_->Write(std::move(message));
+  ++metrics_.messages_sent;
+  metrics_.bytes_sent += static_cast<int64_t>(message.Length());
+  grpc_stream_->Write(std::move(message), options);
 }
 
 std::string Stream::GetDebugDescription() const {
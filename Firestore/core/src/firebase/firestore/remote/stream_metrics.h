@@ -0,0 +1,57 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_STREAM_METRICS_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_STREAM_METRICS_H_
+
+#include <cstdint>
+
+#include "Firestore/core/src/firebase/firestore/util/latency_histogram.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using util::LatencyHistogram;
+
+/** Network counters and latencies of a single `Stream` over its lifetime. */
+struct StreamMetrics {
+  int64_t messages_sent = 0;
+  int64_t bytes_sent = 0;
+  int64_t messages_received = 0;
+  int64_t bytes_received = 0;
+
+  /** How long `CredentialsProvider::GetToken` takes on each start attempt. */
+  LatencyHistogram token_fetch_latency;
+  /**
+   * From starting the underlying gRPC call (after the token has been fetched)
+   * until the first response from the server.
+   */
+  LatencyHistogram time_to_first_response;
+  /** How long the stream waits in backoff before each restart. */
+  LatencyHistogram backoff_delay;
+  /**
+   * Write stream only: from sending a write request until the server
+   * acknowledges it.
+   */
+  LatencyHistogram write_ack_latency;
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_STREAM_METRICS_H_
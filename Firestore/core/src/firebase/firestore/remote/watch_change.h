@@ -25,6 +25,7 @@
 
 #import <Foundation/Foundation.h>
 
+#include <cstddef>
 #include <utility>
 #include <vector>
 
@@ -58,6 +59,21 @@ class WatchChange {
   }
 
   virtual Type type() const = 0;
+
+  /**
+   * The size of the encoded response this change was decoded from, in bytes,
+   * or zero if it wasn't decoded from a response.
+   */
+  size_t encoded_size() const {
+    return encoded_size_;
+  }
+
+  void set_encoded_size(size_t encoded_size) {
+    encoded_size_ = encoded_size;
+  }
+
+ private:
+  size_t encoded_size_ = 0;
 };
 
 /**
@@ -21,8 +21,11 @@
 #error "This header only supports Objective-C++"
 #endif  // !defined(__OBJC__)
 
+#include <dispatch/dispatch.h>
+
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
@@ -31,6 +34,7 @@
 #include "Firestore/core/src/firebase/firestore/remote/stream.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/reorder_buffer.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "absl/strings/string_view.h"
 #include "grpcpp/support/byte_buffer.h"
@@ -78,6 +82,11 @@ class WatchStreamCallback {
  * Once the `WatchStream` has called the `OnWatchStreamOpen` method on the
  * callback, any number of `WatchQuery` and `UnwatchTargetId` calls can be sent
  * to control what changes will be sent from the server for WatchChanges.
+ *
+ * Responses are decoded concurrently, off the worker queue, so that decoding a
+ * large snapshot doesn't hold up the local store and views. The decoded changes
+ * are still handed to the callback on the worker queue, in the order the
+ * responses were received.
  */
 class WatchStream : public Stream {
  public:
@@ -95,6 +104,15 @@ class WatchStream : public Stream {
    */
   virtual /*virtual for tests only*/ void WatchQuery(FSTQueryData* query);
 
+  /**
+   * Registers interest in the results of all the given queries, like calling
+   * `WatchQuery` for each. The requests are written to the network together
+   * rather than one by one, which makes restoring many targets on a new stream
+   * much cheaper.
+   */
+  virtual /*virtual for tests only*/ void WatchQueries(
+      const std::vector<FSTQueryData*>& queries);
+
   /**
    * Unregisters interest in the results of the query associated with the given
    * `target_id`.
@@ -115,8 +133,27 @@ class WatchStream : public Stream {
     return "WatchStream";
   }
 
+  /** A response message, decoded on `decode_queue_`. */
+  struct DecodedResponse {
+    util::Status status;
+    GCFSListenResponse* response = nil;
+    std::unique_ptr<WatchChange> change;
+    model::SnapshotVersion snapshot_version;
+  };
+
+  static DecodedResponse Decode(const bridge::WatchStreamSerializer& serializer,
+                                const grpc::ByteBuffer& message);
+  void OnResponseDecoded(DecodedResponse* decoded);
+
   bridge::WatchStreamSerializer serializer_bridge_;
   WatchStreamCallback* callback_;
+
+  dispatch_queue_t decode_queue_;
+
+  // Restores the order of responses whose decoding finishes out of order.
+  // Cleared whenever the stream closes, so responses from a stream that has
+  // since been closed are never delivered.
+  util::ReorderBuffer<DecodedResponse> decoded_responses_;
 };
 
 }  // namespace remote
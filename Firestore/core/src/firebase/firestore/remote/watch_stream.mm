@@ -16,6 +16,9 @@
 
 #include "Firestore/core/src/firebase/firestore/remote/watch_stream.h"
 
+#include <memory>
+#include <utility>
+
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
@@ -30,6 +33,7 @@ using auth::CredentialsProvider;
 using auth::Token;
 using model::TargetId;
 using util::AsyncQueue;
+using util::ReorderBuffer;
 using util::TimerId;
 using util::Status;
 
@@ -41,7 +45,10 @@ WatchStream::WatchStream(AsyncQueue* async_queue,
     : Stream{async_queue, credentials_provider, grpc_connection,
              TimerId::ListenStreamConnectionBackoff, TimerId::ListenStreamIdle},
       serializer_bridge_{serializer},
-      callback_{NOT_NULL(callback)} {
+      callback_{NOT_NULL(callback)},
+      decode_queue_{dispatch_queue_create(
+          "com.google.firebase.firestore.watch.decode",
+          DISPATCH_QUEUE_CONCURRENT)} {
 }
 
 void WatchStream::WatchQuery(FSTQueryData* query) {
@@ -53,6 +60,23 @@ void WatchStream::WatchQuery(FSTQueryData* query) {
   Write(serializer_bridge_.ToByteBuffer(request));
 }
 
+void WatchStream::WatchQueries(const std::vector<FSTQueryData*>& queries) {
+  EnsureOnQueue();
+
+  // gRPC holds back the messages written with a buffer hint until the last
+  // one, which goes without.
+  grpc::WriteOptions buffered;
+  buffered.set_buffer_hint();
+  for (size_t i = 0; i < queries.size(); ++i) {
+    GCFSListenRequest* request =
+        serializer_bridge_.CreateWatchRequest(queries[i]);
+    LOG_DEBUG("%s watch: %s", GetDebugDescription(),
+              serializer_bridge_.Describe(request));
+    Write(serializer_bridge_.ToByteBuffer(request),
+          i + 1 < queries.size() ? buffered : grpc::WriteOptions{});
+  }
+}
+
 void WatchStream::UnwatchTargetId(TargetId target_id) {
   EnsureOnQueue();
 
@@ -78,28 +102,87 @@ void WatchStream::NotifyStreamOpen() {
 }
 
 Status WatchStream::NotifyStreamResponse(const grpc::ByteBuffer& message) {
-  Status status;
-  GCFSListenResponse* response =
-      serializer_bridge_.ParseResponse(message, &status);
-  if (!status.ok()) {
-    return status;
+  ReorderBuffer<DecodedResponse>::Sequence sequence =
+      decoded_responses_.Reserve();
+
+  // The decoding block may outlive the stream, so make sure it doesn't try to
+  // access a deleted object. It works on its own copies of the serializer and
+  // message (copying a `ByteBuffer` only takes a reference to its slices).
+  std::weak_ptr<Stream> weak_this{shared_from_this()};
+  bridge::WatchStreamSerializer serializer = serializer_bridge_;
+  grpc::ByteBuffer buffer = message;
+
+  dispatch_async(decode_queue_, ^{
+    auto decoded =
+        std::make_shared<DecodedResponse>(Decode(serializer, buffer));
+
+    auto strong_this = weak_this.lock();
+    if (!strong_this) {
+      return;
+    }
+    auto watch_stream = static_cast<WatchStream*>(strong_this.get());
+    watch_stream->worker_queue()->EnqueueRelaxed([weak_this, sequence,
+                                                  decoded] {
+      auto strong_this = weak_this.lock();
+      if (!strong_this) {
+        return;
+      }
+      auto watch_stream = static_cast<WatchStream*>(strong_this.get());
+      watch_stream->decoded_responses_.Complete(
+          sequence, std::move(*decoded),
+          [watch_stream](DecodedResponse&& response) {
+            watch_stream->OnResponseDecoded(&response);
+          });
+    });
+  });
+
+  // Any error is reported once the response comes up for delivery.
+  return Status::OK();
+}
+
+WatchStream::DecodedResponse WatchStream::Decode(
+    const bridge::WatchStreamSerializer& serializer,
+    const grpc::ByteBuffer& message) {
+  DecodedResponse decoded;
+  decoded.change = serializer.DecodeResponse(
+      message, &decoded.snapshot_version, &decoded.status);
+  if (decoded.status.ok()) {
+    decoded.change->set_encoded_size(message.Length());
+    // Parsing into protobuf objects is only worth it to describe the response.
+    if (bridge::IsLoggingEnabled()) {
+      Status ignored;
+      decoded.response = serializer.ParseResponse(message, &ignored);
+    }
+  }
+  return decoded;
+}
+
+void WatchStream::OnResponseDecoded(DecodedResponse* decoded) {
+  EnsureOnQueue();
+
+  if (!decoded->status.ok()) {
+    FinishWithReadError(decoded->status);
+    return;
   }
 
   if (bridge::IsLoggingEnabled()) {
     LOG_DEBUG("%s response: %s", GetDebugDescription(),
-              serializer_bridge_.Describe(response));
+              serializer_bridge_.Describe(decoded->response));
   }
 
   // A successful response means the stream is healthy.
   backoff_.Reset();
 
-  callback_->OnWatchStreamChange(
-      *serializer_bridge_.ToWatchChange(response),
-      serializer_bridge_.ToSnapshotVersion(response));
-  return Status::OK();
+  callback_->OnWatchStreamChange(*decoded->change, decoded->snapshot_version);
 }
 
 void WatchStream::NotifyStreamClose(const Status& status) {
+  // Responses that haven't been delivered yet belong to the stream that is now
+  // closed. Watch only raises snapshots at consistent points and the next
+  // stream resumes from the last one, so dropping them is equivalent to the
+  // stream having closed a little earlier.
+  decoded_responses_.Clear();
+
   callback_->OnWatchStreamClose(status);
 }
 
@@ -22,6 +22,7 @@
 #endif  // !defined(__OBJC__)
 
 #import <Foundation/Foundation.h>
+#include <deque>
 #include <memory>
 #include <string>
 #include <vector>
@@ -39,6 +40,7 @@
 #import "Firestore/Source/Model/FSTMutation.h"
 #import "Firestore/Source/Remote/FSTSerializerBeta.h"
 
+@class FSTMutationBatch;
 @class FSTMutationResult;
 
 namespace firebase {
@@ -133,6 +135,21 @@ class WriteStream : public Stream {
   /** Sends a group of mutations to the Firestore backend to apply. */
   virtual void WriteMutations(const std::vector<FSTMutation*>& mutations);
 
+  /**
+   * Sends the mutations of consecutive batches starting at `begin` in a
+   * single request, adding batches for as long as their encoded size fits in
+   * `max_bytes`. The first batch is always sent.
+   *
+   * The backend applies the request atomically and responds with the results
+   * of all its mutations at once.
+   *
+   * Returns the number of batches sent.
+   */
+  virtual size_t WriteCoalescedMutations(
+      std::vector<FSTMutationBatch*>::const_iterator begin,
+      std::vector<FSTMutationBatch*>::const_iterator end,
+      size_t max_bytes);
+
  protected:
   // For tests only
   void SetHandshakeComplete(bool value = true) {
@@ -155,6 +172,9 @@ class WriteStream : public Stream {
   bridge::WriteStreamSerializer serializer_bridge_;
   WriteStreamCallback* callback_ = nullptr;
   bool handshake_complete_ = false;
+
+  // When each write request that hasn't been acknowledged yet was sent.
+  std::deque<LatencyHistogram::Clock::time_point> unacknowledged_writes_;
 };
 
 }  // namespace remote
@@ -16,6 +16,9 @@
 
 #include "Firestore/core/src/firebase/firestore/remote/write_stream.h"
 
+#include <utility>
+#include <vector>
+
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
@@ -28,6 +31,7 @@ namespace remote {
 
 using auth::CredentialsProvider;
 using auth::Token;
+using model::SnapshotVersion;
 using util::AsyncQueue;
 using util::TimerId;
 using util::Status;
@@ -76,6 +80,27 @@ void WriteStream::WriteMutations(const std::vector<FSTMutation*>& mutations) {
   LOG_DEBUG("%s write request: %s", GetDebugDescription(),
             serializer_bridge_.Describe(request));
   Write(serializer_bridge_.ToByteBuffer(request));
+  unacknowledged_writes_.push_back(LatencyHistogram::Clock::now());
+}
+
+size_t WriteStream::WriteCoalescedMutations(
+    std::vector<FSTMutationBatch*>::const_iterator begin,
+    std::vector<FSTMutationBatch*>::const_iterator end,
+    size_t max_bytes) {
+  EnsureOnQueue();
+  HARD_ASSERT(IsOpen(), "Writing mutations requires an opened stream");
+  HARD_ASSERT(handshake_complete(),
+              "Handshake must be complete before writing mutations");
+
+  size_t batch_count = 0;
+  GCFSWriteRequest* request =
+      serializer_bridge_.CreateCoalescedWriteMutationsRequest(
+          begin, end, max_bytes, &batch_count);
+  LOG_DEBUG("%s write request for %s batches: %s", GetDebugDescription(),
+            batch_count, serializer_bridge_.Describe(request));
+  Write(serializer_bridge_.ToByteBuffer(request));
+  unacknowledged_writes_.push_back(LatencyHistogram::Clock::now());
+  return batch_count;
 }
 
 std::unique_ptr<GrpcStream> WriteStream::CreateGrpcStream(
@@ -105,21 +130,24 @@ void WriteStream::NotifyStreamClose(const Status& status) {
   // Delegate's logic might depend on whether handshake was completed, so only
   // reset it after notifying.
   handshake_complete_ = false;
+  unacknowledged_writes_.clear();
 }
 
 Status WriteStream::NotifyStreamResponse(const grpc::ByteBuffer& message) {
-  Status status;
-  GCFSWriteResponse* response =
-      serializer_bridge_.ParseResponse(message, &status);
+  // Decoding always captures the last stream token.
+  SnapshotVersion commit_version;
+  std::vector<FSTMutationResult*> results;
+  Status status =
+      serializer_bridge_.DecodeResponse(message, &commit_version, &results);
   if (!status.ok()) {
     return status;
   }
 
+  // The arguments are only evaluated if debug logging is enabled.
+  Status ignored;
   LOG_DEBUG("%s response: %s", GetDebugDescription(),
-            serializer_bridge_.Describe(response));
-
-  // Always capture the last stream token.
-  serializer_bridge_.UpdateLastStreamToken(response);
+            serializer_bridge_.Describe(
+                serializer_bridge_.ParseResponse(message, &ignored)));
 
   if (!handshake_complete()) {
     // The first response is the handshake response
@@ -131,9 +159,14 @@ Status WriteStream::NotifyStreamResponse(const grpc::ByteBuffer& message) {
     // write itself might be causing an error we want to back off from.
     backoff_.Reset();
 
-    callback_->OnWriteStreamMutationResult(
-        serializer_bridge_.ToCommitVersion(response),
-        serializer_bridge_.ToMutationResults(response));
+    if (!unacknowledged_writes_.empty()) {
+      mutable_metrics()->write_ack_latency.RecordElapsedSince(
+          unacknowledged_writes_.front());
+      unacknowledged_writes_.pop_front();
+    }
+
+    callback_->OnWriteStreamMutationResult(std::move(commit_version),
+                                           std::move(results));
   }
 
   return Status::OK();
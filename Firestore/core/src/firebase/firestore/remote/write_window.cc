@@ -0,0 +1,121 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/write_window.h"
+
+#include <algorithm>
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+namespace {
+
+/**
+ * The estimated number of writes queued along the path below which the
+ * window keeps growing, and above which it shrinks. In between, the window is
+ * left alone.
+ */
+constexpr double kMinQueuedWrites = 2;
+constexpr double kMaxQueuedWrites = 4;
+
+}  // namespace
+
+constexpr size_t WriteWindow::kInitialSize;
+constexpr size_t WriteWindow::kMinSize;
+constexpr size_t WriteWindow::kMaxSize;
+
+void WriteWindow::RecordSend(Clock::time_point now) {
+  send_times_.push_back(now);
+  max_in_flight_ = std::max(max_in_flight_, send_times_.size());
+}
+
+void WriteWindow::RecordAcknowledgement(Clock::time_point now) {
+  HARD_ASSERT(!send_times_.empty(), "Acknowledgement with no write in flight");
+
+  // Only a full pipeline says anything about the capacity of the connection.
+  // During slow start, the window may be up to twice as large as what was
+  // last in flight, since it has just been doubling.
+  bool slow_start = window_ < slow_start_threshold_;
+  bool window_limited = slow_start ? size() < 2 * max_in_flight_
+                                   : size() <= max_in_flight_;
+
+  Clock::duration round_trip = now - send_times_.front();
+  send_times_.pop_front();
+  ++acknowledged_writes_;
+  if (send_times_.empty()) {
+    max_in_flight_ = 0;
+  }
+
+  min_round_trip_ = std::min(min_round_trip_, round_trip);
+  if (smoothed_round_trip_ == Clock::duration::zero()) {
+    smoothed_round_trip_ = round_trip;
+  } else {
+    smoothed_round_trip_ = (smoothed_round_trip_ * 7 + round_trip) / 8;
+  }
+
+  if (!window_limited) {
+    return;
+  }
+
+  // If nothing were queued, a window of writes would take the minimum round
+  // trip to complete. The extra time it takes is spent waiting behind other
+  // writes: estimate how many writes' worth of waiting that is.
+  double queued_writes = 0;
+  if (smoothed_round_trip_ > Clock::duration::zero()) {
+    double ratio = static_cast<double>(min_round_trip_.count()) /
+                   static_cast<double>(smoothed_round_trip_.count());
+    queued_writes = window_ * (1 - ratio);
+  }
+
+  if (queued_writes < kMinQueuedWrites) {
+    // Growing by a whole write per acknowledgement doubles the window every
+    // round trip; growing by 1/window adds one write per round trip.
+    window_ += slow_start ? 1 : 1 / window_;
+  } else if (queued_writes > kMaxQueuedWrites) {
+    window_ -= 1 / window_;
+    slow_start_threshold_ = std::min(slow_start_threshold_, window_);
+  }
+  window_ = std::max(static_cast<double>(kMinSize),
+                     std::min(window_, static_cast<double>(kMaxSize)));
+}
+
+void WriteWindow::RecordFailure() {
+  ++failures_;
+  window_ = std::max(static_cast<double>(kMinSize), window_ / 2);
+  slow_start_threshold_ = window_;
+}
+
+void WriteWindow::RecordStreamClose() {
+  send_times_.clear();
+  max_in_flight_ = 0;
+}
+
+void WriteWindow::FillStats(WritePipelineStats* stats) const {
+  stats->window_size = size();
+  stats->in_flight_writes = in_flight();
+  stats->acknowledged_writes = acknowledged_writes_;
+  stats->failures = failures_;
+  stats->smoothed_round_trip =
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          smoothed_round_trip_);
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_WRITE_WINDOW_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_WRITE_WINDOW_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * A snapshot of the state of the write pipeline, for diagnostics.
+ */
+struct WritePipelineStats {
+  /** The number of writes currently allowed in the pipeline. */
+  size_t window_size = 0;
+
+  /** The number of writes in the pipeline, whether sent or not. */
+  size_t pending_writes = 0;
+
+  /** The number of writes sent on the current stream but not acknowledged. */
+  size_t in_flight_writes = 0;
+
+  /** The total number of writes acknowledged by the backend. */
+  uint64_t acknowledged_writes = 0;
+
+  /** The total number of times the window shrank because of an error. */
+  uint64_t failures = 0;
+
+  /** The smoothed round-trip time of acknowledged writes. */
+  std::chrono::milliseconds smoothed_round_trip{0};
+};
+
+/**
+ * Decides how many writes `RemoteStore` may have in its write pipeline, much
+ * like a TCP congestion window.
+ *
+ * Writes are acknowledged in the order they were sent, so the window measures
+ * the round-trip time of each write. The window doubles every round trip
+ * while it is small ("slow start"), then grows by one write per round trip for
+ * as long as round-trip times stay close to the fastest seen. When they
+ * increase, writes are queueing up somewhere along the way rather than
+ * getting through any faster, so the window backs off: it settles around the
+ * bandwidth-delay product of the connection.
+ *
+ * Errors on the stream halve the window and end slow start.
+ *
+ * The window only grows while it actually limits the pipeline, so a long
+ * stretch of occasional writes doesn't inflate it.
+ */
+class WriteWindow {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * The initial window size. This was the fixed pipeline size before the
+   * window became adaptive.
+   */
+  static constexpr size_t kInitialSize = 10;
+
+  static constexpr size_t kMinSize = 1;
+
+  /**
+   * The largest window allowed, which bounds the number of batches held in
+   * memory at once.
+   * TODO(b/35853402): Negotiate this value with the backend.
+   */
+  static constexpr size_t kMaxSize = 100;
+
+  /** Returns the number of writes currently allowed in the pipeline. */
+  size_t size() const {
+    return static_cast<size_t>(window_);
+  }
+
+  /** Returns the number of writes sent but not yet acknowledged. */
+  size_t in_flight() const {
+    return send_times_.size();
+  }
+
+  /** Records that a write was sent on the stream at time `now`. */
+  void RecordSend(Clock::time_point now);
+
+  /**
+   * Records that the oldest write in flight was acknowledged at time `now`,
+   * and adjusts the window based on its round-trip time.
+   */
+  void RecordAcknowledgement(Clock::time_point now);
+
+  /**
+   * Records an error that suggests the backend or the connection is
+   * overloaded, and shrinks the window.
+   */
+  void RecordFailure();
+
+  /**
+   * Forgets the writes in flight, since they will have to be sent again on a
+   * new stream. The window size is kept.
+   */
+  void RecordStreamClose();
+
+  /** Fills in the window-related fields of `stats`. */
+  void FillStats(WritePipelineStats* stats) const;
+
+ private:
+  double window_ = kInitialSize;
+  double slow_start_threshold_ = kMaxSize;
+
+  // The times at which the writes in flight were sent, oldest first.
+  std::deque<Clock::time_point> send_times_;
+
+  // The most writes in flight at once since the pipeline was last empty.
+  size_t max_in_flight_ = 0;
+
+  Clock::duration min_round_trip_ = Clock::duration::max();
+  Clock::duration smoothed_round_trip_ = Clock::duration::zero();
+
+  uint64_t acknowledged_writes_ = 0;
+  uint64_t failures_ = 0;
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_WRITE_WINDOW_H_
@@ -16,15 +16,59 @@
 
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "absl/memory/memory.h"
 
 namespace firebase {
 namespace firestore {
 namespace util {
 
+namespace {
+
+namespace chr = std::chrono;
+
+const char* const kUnlabeled = "unlabeled";
+
+const char* TimerIdLabel(TimerId timer_id) {
+  switch (timer_id) {
+    case TimerId::All:
+      return "All";
+    case TimerId::ListenStreamIdle:
+      return "ListenStreamIdle";
+    case TimerId::ListenStreamConnectionBackoff:
+      return "ListenStreamConnectionBackoff";
+    case TimerId::WriteStreamIdle:
+      return "WriteStreamIdle";
+    case TimerId::WriteStreamConnectionBackoff:
+      return "WriteStreamConnectionBackoff";
+    case TimerId::OnlineStateTimeout:
+      return "OnlineStateTimeout";
+    case TimerId::GarbageCollectionDelay:
+      return "GarbageCollectionDelay";
+    case TimerId::PendingMigrationChunk:
+      return "PendingMigrationChunk";
+    case TimerId::SnapshotCoalescing:
+      return "SnapshotCoalescing";
+    case TimerId::BulkWriterRateLimit:
+      return "BulkWriterRateLimit";
+    case TimerId::BulkWriterRetry:
+      return "BulkWriterRetry";
+    case TimerId::TransactionRetry:
+      return "TransactionRetry";
+    case TimerId::MemoryLimitCheck:
+      return "MemoryLimitCheck";
+    case TimerId::CacheWarmingRateLimit:
+      return "CacheWarmingRateLimit";
+  }
+  UNREACHABLE();
+}
+
+}  // namespace
+
 AsyncQueue::AsyncQueue(std::unique_ptr<Executor> executor)
     : executor_{std::move(executor)} {
   is_operation_in_progress_ = false;
@@ -48,24 +92,78 @@ void AsyncQueue::VerifyIsCurrentQueue() const {
               executor_->Name(), executor_->CurrentExecutorName());
 }
 
+bool AsyncQueue::IsCurrentQueue() const {
+  return executor_->IsCurrentExecutor() && is_operation_in_progress_;
+}
+
 void AsyncQueue::ExecuteBlocking(const Operation& operation) {
+  Run(operation, Priority::Normal, nullptr, ReadyTime(Milliseconds::zero()));
+}
+
+void AsyncQueue::Run(const Operation& operation,
+                     const Priority priority,
+                     const char* label,
+                     const Clock::time_point ready_time) {
   VerifyIsCurrentExecutor();
   HARD_ASSERT(!is_operation_in_progress_,
               "ExecuteBlocking may not be called "
               "before the previous operation finishes executing");
 
   is_operation_in_progress_ = true;
-  operation();
+  current_priority_ = priority;
+  if (ready_time == Clock::time_point{}) {
+    operation();
+  } else {
+    Clock::time_point start = Clock::now();
+    operation();
+    RecordOperation(label, start - ready_time, Clock::now() - start);
+  }
   is_operation_in_progress_ = false;
 }
 
-void AsyncQueue::Enqueue(const Operation& operation) {
+void AsyncQueue::Enqueue(const Operation& operation,
+                         const Priority priority,
+                         const char* label) {
   VerifySequentialOrder();
-  EnqueueRelaxed(operation);
+  EnqueueRelaxed(operation, priority, label);
+}
+
+void AsyncQueue::EnqueueRelaxed(const Operation& operation,
+                                const Priority priority,
+                                const char* label) {
+  // Counted before the push so that the count never drops below zero.
+  ++pending_count_;
+  pending_[static_cast<int>(priority)].Push(Wrap(operation, priority, label));
+  executor_->Execute([this] { RunNextPendingOperation(); });
+}
+
+void AsyncQueue::RunNextPendingOperation() {
+  // Every enqueued operation posts exactly one call to this function, so there
+  // is always a pending operation here, though not necessarily the one whose
+  // enqueueing posted this call.
+  while (true) {
+    for (MpscQueue<Operation>& lane : pending_) {
+      absl::optional<Operation> next = lane.TryPop();
+      if (next) {
+        --pending_count_;
+        (*next)();
+        return;
+      }
+    }
+    // The operation is hidden behind another push to the same lane that is
+    // still in progress; that takes no more than a few instructions.
+    std::this_thread::yield();
+  }
 }
 
-void AsyncQueue::EnqueueRelaxed(const Operation& operation) {
-  executor_->Execute(Wrap(operation));
+bool AsyncQueue::ShouldYield() const {
+  VerifyIsCurrentQueue();
+  for (int i = 0; i < static_cast<int>(current_priority_); ++i) {
+    if (!pending_[i].empty()) {
+      return true;
+    }
+  }
+  return false;
 }
 
 DelayedOperation AsyncQueue::EnqueueAfterDelay(const Milliseconds delay,
@@ -79,16 +177,86 @@ DelayedOperation AsyncQueue::EnqueueAfterDelay(const Milliseconds delay,
   HARD_ASSERT(!IsScheduled(timer_id),
               "Attempted to schedule multiple operations with id %s", timer_id);
 
-  Executor::TaggedOperation tagged{static_cast<int>(timer_id), Wrap(operation)};
+  Executor::TaggedOperation tagged{
+      static_cast<int>(timer_id),
+      Wrap(operation, Priority::Background, TimerIdLabel(timer_id), delay)};
   return executor_->Schedule(delay, std::move(tagged));
 }
 
-AsyncQueue::Operation AsyncQueue::Wrap(const Operation& operation) {
-  // Decorator pattern: wrap `operation` into a call to `ExecuteBlocking` to
-  // ensure that it doesn't spawn any nested operations.
+AsyncQueue::Operation AsyncQueue::Wrap(const Operation& operation,
+                                       const Priority priority,
+                                       const char* label,
+                                       const Milliseconds delay) {
+  // Decorator pattern: wrap `operation` into a call to `Run` to ensure that it
+  // doesn't spawn any nested operations.
 
   // Note: can't move `operation` into lambda until C++14.
-  return [this, operation] { ExecuteBlocking(operation); };
+  Clock::time_point ready_time = ReadyTime(delay);
+  return [this, operation, priority, label, ready_time] {
+    Run(operation, priority, label, ready_time);
+  };
+}
+
+AsyncQueue::Clock::time_point AsyncQueue::ReadyTime(
+    const Milliseconds delay) const {
+  if (!is_instrumentation_enabled_) {
+    return Clock::time_point{};
+  }
+  return Clock::now() + delay;
+}
+
+void AsyncQueue::EnableInstrumentation(
+    const Milliseconds slow_operation_threshold) {
+  std::lock_guard<std::mutex> lock{metrics_mutex_};
+  slow_operation_threshold_ = slow_operation_threshold;
+  is_instrumentation_enabled_ = true;
+}
+
+std::map<std::string, AsyncQueue::OperationMetrics>
+AsyncQueue::GetOperationMetrics() const {
+  std::lock_guard<std::mutex> lock{metrics_mutex_};
+  return metrics_;
+}
+
+void AsyncQueue::SetSlowOperationHandler(SlowOperationHandler handler) {
+  std::lock_guard<std::mutex> lock{metrics_mutex_};
+  slow_operation_handler_ = std::move(handler);
+}
+
+void AsyncQueue::RecordOperation(const char* label,
+                                 const Clock::duration wait_time,
+                                 const Clock::duration run_time) {
+  if (!label) {
+    label = kUnlabeled;
+  }
+  auto run_time_ms = chr::duration_cast<Milliseconds>(run_time);
+
+  Milliseconds threshold;
+  SlowOperationHandler handler;
+  {
+    std::lock_guard<std::mutex> lock{metrics_mutex_};
+    OperationMetrics& metrics = metrics_[label];
+    metrics.wait_time.Record(chr::duration_cast<Milliseconds>(wait_time));
+    metrics.run_time.Record(run_time_ms);
+    threshold = slow_operation_threshold_;
+    if (run_time_ms > threshold) {
+      handler = slow_operation_handler_;
+    }
+  }
+
+  if (run_time_ms <= threshold) {
+    return;
+  }
+  if (handler) {
+    SlowOperation slow_operation;
+    slow_operation.label = label;
+    slow_operation.run_time = run_time_ms;
+    slow_operation.backlog = pending_count_;
+    handler(slow_operation);
+  } else {
+    LOG_WARN("Operation '%s' on queue '%s' ran for %s ms (threshold: %s ms)",
+             label, executor_->Name(), run_time_ms.count(), threshold.count());
+  }
 }
 
 void AsyncQueue::VerifySequentialOrder() const {
@@ -104,7 +272,7 @@ void AsyncQueue::VerifySequentialOrder() const {
 
 void AsyncQueue::EnqueueBlocking(const Operation& operation) {
   VerifySequentialOrder();
-  executor_->ExecuteBlocking(Wrap(operation));
+  executor_->ExecuteBlocking(Wrap(operation, Priority::Normal, nullptr));
 }
 
 bool AsyncQueue::IsScheduled(const TimerId timer_id) const {
@@ -17,12 +17,18 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_ASYNC_QUEUE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_ASYNC_QUEUE_H_
 
+#include <array>
 #include <atomic>
 #include <chrono>  // NOLINT(build/c++11)
 #include <functional>
+#include <map>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
 
 #include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "Firestore/core/src/firebase/firestore/util/latency_histogram.h"
+#include "Firestore/core/src/firebase/firestore/util/mpsc_queue.h"
 
 namespace firebase {
 namespace firestore {
@@ -57,13 +63,54 @@ enum class TimerId {
   /**
    * A timer used to periodically attempt LRU Garbage collection
    */
-  GarbageCollectionDelay
+  GarbageCollectionDelay,
+
+  /**
+   * A timer used to run the LevelDB migrations deferred at startup in chunks.
+   */
+  PendingMigrationChunk,
+
+  /**
+   * A timer used in `QueryListener` to raise the snapshots coalesced during
+   * its coalescing window.
+   */
+  SnapshotCoalescing,
+
+  /**
+   * Timers used in `BulkWriter` to wait for its rate limit to allow the next
+   * batch, and to back off before retrying a failed batch.
+   */
+  BulkWriterRateLimit,
+  BulkWriterRetry,
+
+  /**
+   * A timer used by the sync engine to back off before retrying a transaction
+   * that failed to commit.
+   */
+  TransactionRetry,
+
+  /**
+   * A timer used by the client to periodically compare its estimated memory
+   * use against the configured soft limit.
+   */
+  MemoryLimitCheck,
+
+  /**
+   * A timer used in `CacheWarmer` to wait for its rate limit to allow the next
+   * background listen.
+   */
+  CacheWarmingRateLimit
 };
 
 // A serial queue that executes given operations asynchronously, one at a time.
 // Operations may be scheduled to be executed as soon as possible or in the
 // future. Operations scheduled for the same time are FIFO-ordered.
 //
+// Operations scheduled as soon as possible are further divided into priority
+// classes: a pending operation of a higher priority always runs before pending
+// operations of lower priorities, while operations of the same priority run in
+// FIFO order.
+//
 // `AsyncQueue` wraps a platform-specific executor, adding checks that enforce
 // sequential ordering of operations: an enqueued operation, while being run,
 // normally cannot enqueue other operations for immediate execution (but see
@@ -80,25 +127,72 @@ class AsyncQueue {
   using Operation = Executor::Operation;
   using Milliseconds = Executor::Milliseconds;
 
+  // Priority classes of operations enqueued for immediate execution, from the
+  // highest to the lowest.
+  enum class Priority {
+    // Work that a user is waiting on, such as reading a document or
+    // registering a listener.
+    Interactive,
+    // The default for everything else, such as handling network responses.
+    Normal,
+    // Maintenance that nothing is waiting on.
+    Background,
+  };
+
+  // Timings of the operations that share a label, recorded while
+  // instrumentation is enabled (see `EnableInstrumentation`).
+  struct OperationMetrics {
+    // From the time an operation was enqueued (or, for delayed operations, the
+    // time it became due) until it started running.
+    LatencyHistogram wait_time;
+    // How long the operation ran.
+    LatencyHistogram run_time;
+  };
+
+  // An operation that ran longer than the slow operation threshold.
+  struct SlowOperation {
+    // The operation's label, or "unlabeled".
+    const char* label = nullptr;
+    Milliseconds run_time{0};
+    // The number of operations enqueued for immediate execution that were
+    // waiting when it finished. Delayed operations aren't counted until they
+    // are due.
+    int backlog = 0;
+  };
+
+  using SlowOperationHandler = std::function<void(const SlowOperation&)>;
+
   explicit AsyncQueue(std::unique_ptr<Executor> executor);
 
   // Asserts for the caller that it is being invoked as part of an operation on
   // the `AsyncQueue`.
   void VerifyIsCurrentQueue() const;
 
+  // Returns whether the caller is being invoked as part of an operation on the
+  // `AsyncQueue`.
+  bool IsCurrentQueue() const;
+
   // Enqueue methods
 
-  // Puts the `operation` on the queue to be executed as soon as possible, while
-  // maintaining FIFO order.
+  // Puts the `operation` on the queue to be executed as soon as possible, after
+  // all pending operations of the same or a higher `priority`.
+  //
+  // `label` identifies the operation in instrumentation; it must outlive the
+  // queue, which string literals do. Unlabeled operations are grouped
+  // together.
   //
   // Precondition: `Enqueue` calls cannot be nested; that is, `Enqueue` may not
   // be called by a previously enqueued operation when it is run (as a special
   // case, destructors invoked when an enqueued operation has run and is being
   // destroyed may invoke `Enqueue`).
-  void Enqueue(const Operation& operation);
+  void Enqueue(const Operation& operation,
+               Priority priority = Priority::Normal,
+               const char* label = nullptr);
 
   // Like `Enqueue`, but without applying any prerequisite checks.
-  void EnqueueRelaxed(const Operation& operation);
+  void EnqueueRelaxed(const Operation& operation,
+                      Priority priority = Priority::Normal,
+                      const char* label = nullptr);
 
   // Puts the `operation` on the queue to be executed `delay` milliseconds from
   // now, and returns a handle that allows to cancel the operation (provided it
@@ -108,7 +202,8 @@ class AsyncQueue {
   // Only one operation tagged with any given `timer_id` may be on the queue at
   // any time; an attempt to put another such operation will result in an
   // assertion failure. In tests, these tags also allow to check for presence of
-  // certain operations and to run certain operations in advance.
+  // certain operations and to run certain operations in advance. The
+  // `timer_id` also serves as the label of the operation in instrumentation.
   //
   // Precondition: `EnqueueAfterDelay` is being invoked asynchronously on the
   // queue.
@@ -116,6 +211,40 @@ class AsyncQueue {
                                      TimerId timer_id,
                                      const Operation& operation);
 
+  // Returns whether operations of a higher priority than the currently running
+  // one are pending. Long-running operations can check this at convenient
+  // points and enqueue the rest of their work to let those run first. Delayed
+  // operations count as `Background` work.
+  //
+  // Precondition: `ShouldYield` is being invoked as part of an operation on the
+  // queue.
+  bool ShouldYield() const;
+
+  // Instrumentation
+
+  // Starts recording the wait and run times of operations enqueued from now
+  // on, and logs a warning for each operation that runs longer than
+  // `slow_operation_threshold`. Instrumentation is off by default since it
+  // reads the clock twice per operation.
+  //
+  // May be called from any thread, and again to change the threshold.
+  void EnableInstrumentation(Milliseconds slow_operation_threshold);
+
+  // Returns the metrics recorded so far, keyed by operation label.
+  //
+  // May be called from any thread.
+  std::map<std::string, OperationMetrics> GetOperationMetrics() const;
+
+  // Makes the queue invoke `handler` for each operation that runs longer than
+  // the slow operation threshold, instead of logging a warning. The handler
+  // runs on the queue right after the slow operation, as part of it, so it may
+  // inspect state that only the queue's operations access, but it must not
+  // enqueue operations for immediate execution. Pass an empty handler to
+  // restore the warning.
+  //
+  // May be called from any thread.
+  void SetSlowOperationHandler(SlowOperationHandler handler);
+
   // Direct execution
 
   // Immediately executes the `operation` on the queue.
@@ -156,13 +285,52 @@ class AsyncQueue {
   void RunScheduledOperationsUntil(TimerId last_timer_id);
 
  private:
-  Operation Wrap(const Operation& operation);
+  static constexpr int kPriorityCount = 3;
+
+  using Clock = LatencyHistogram::Clock;
+
+  Operation Wrap(const Operation& operation,
+                 Priority priority,
+                 const char* label,
+                 Milliseconds delay = Milliseconds::zero());
+  void Run(const Operation& operation,
+           Priority priority,
+           const char* label,
+           Clock::time_point ready_time);
+  void RunNextPendingOperation();
+
+  // Returns the time an operation enqueued now with the given `delay` becomes
+  // ready to run, or a default-constructed time point if instrumentation is
+  // disabled.
+  Clock::time_point ReadyTime(Milliseconds delay) const;
+  void RecordOperation(const char* label,
+                       Clock::duration wait_time,
+                       Clock::duration run_time);
 
   // Asserts that the current invocation happens asynchronously on the queue.
   void VerifyIsCurrentExecutor() const;
   void VerifySequentialOrder() const;
 
   std::atomic<bool> is_operation_in_progress_;
+  // Only accessed on the queue.
+  Priority current_priority_ = Priority::Normal;
+
+  // Recorded by running operations, so, like `pending_`, these must outlive
+  // `executor_`.
+  std::atomic<bool> is_instrumentation_enabled_{false};
+  mutable std::mutex metrics_mutex_;
+  // Guarded by `metrics_mutex_`.
+  Milliseconds slow_operation_threshold_{0};
+  std::map<std::string, OperationMetrics> metrics_;
+  SlowOperationHandler slow_operation_handler_;
+
+  // The number of operations in `pending_`.
+  std::atomic<int> pending_count_{0};
+
+  // Operations enqueued for immediate execution, one queue per priority. Each
+  // of them also posts a call to `RunNextPendingOperation` on the executor.
+  // Declared before `executor_` so that it outlives any such calls.
+  std::array<MpscQueue<Operation>, kPriorityCount> pending_;
   std::unique_ptr<Executor> executor_;
 };
 
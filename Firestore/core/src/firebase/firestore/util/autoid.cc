@@ -16,10 +16,11 @@
 
 #include "Firestore/core/src/firebase/firestore/util/autoid.h"
 
-#include <random>
 #include <string>
+#include <utility>
+#include <vector>
 
-#include "Firestore/core/src/firebase/firestore/util/secure_random.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 
 namespace firebase {
 namespace firestore {
@@ -27,28 +28,74 @@ namespace util {
 
 namespace {
 
-const int kAutoIdLength = 20;
+const size_t kAutoIdLength = 20;
 const char kAutoIdAlphabet[] =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
 
-SecureRandom shared_random;
+// -1 here because sizeof(kAutoIdAlphabet) includes the trailing null
+// terminator.
+const size_t kAlphabetSize = sizeof(kAutoIdAlphabet) - 1;
+
+// The largest multiple of the alphabet size that fits in a byte. Bytes at or
+// above it are rejected so that `byte % kAlphabetSize` is uniform.
+const size_t kAcceptedByteLimit = 256 - 256 % kAlphabetSize;
+
+AutoIdGenerator& SharedGenerator() {
+  // Intentionally leaked to avoid destruction order issues at exit.
+  static auto* generator = new AutoIdGenerator();
+  return *generator;
+}
 
 }  // namespace
 
-std::string CreateAutoId() {
+constexpr size_t AutoIdGenerator::kDefaultPoolSize;
+
+AutoIdGenerator::AutoIdGenerator(size_t pool_size)
+    : pool_(pool_size), next_(pool_size) {
+  HARD_ASSERT(pool_size > 0, "Pool size must be positive");
+}
+
+std::string AutoIdGenerator::CreateAutoId() {
   std::string auto_id;
-  auto_id.reserve(kAutoIdLength);
+  std::lock_guard<std::mutex> lock(mutex_);
+  AppendAutoId(&auto_id);
+  return auto_id;
+}
+
+std::vector<std::string> AutoIdGenerator::CreateAutoIds(size_t count) {
+  std::vector<std::string> auto_ids(count);
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (std::string& auto_id : auto_ids) {
+    AppendAutoId(&auto_id);
+  }
+  return auto_ids;
+}
 
-  // -2 here because:
-  //   * sizeof(kAutoIdAlphabet) includes the trailing null terminator
-  //   * uniform_int_distribution is inclusive on both sizes
-  std::uniform_int_distribution<int> letters(0, sizeof(kAutoIdAlphabet) - 2);
+void AutoIdGenerator::AppendAutoId(std::string* result) {
+  result->reserve(result->size() + kAutoIdLength);
+  for (size_t i = 0; i < kAutoIdLength;) {
+    uint8_t byte = NextByte();
+    if (byte < kAcceptedByteLimit) {
+      result->push_back(kAutoIdAlphabet[byte % kAlphabetSize]);
+      ++i;
+    }
+  }
+}
 
-  for (int i = 0; i < kAutoIdLength; i++) {
-    int rand_index = letters(shared_random);
-    auto_id.append(1, kAutoIdAlphabet[rand_index]);
+uint8_t AutoIdGenerator::NextByte() {
+  if (next_ == pool_.size()) {
+    random_.Fill(pool_.data(), pool_.size());
+    next_ = 0;
   }
-  return auto_id;
+  return pool_[next_++];
+}
+
+std::string CreateAutoId() {
+  return SharedGenerator().CreateAutoId();
+}
+
+std::vector<std::string> CreateAutoIds(size_t count) {
+  return SharedGenerator().CreateAutoIds(count);
 }
 
 }  // namespace util
@@ -17,15 +17,60 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_AUTOID_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_AUTOID_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/secure_random.h"
 
 namespace firebase {
 namespace firestore {
 namespace util {
 
+// Generates random IDs suitable for use as document IDs from a pool of random
+// bytes that is refilled from SecureRandom in bulk, rather than asking
+// SecureRandom for a value per character.
+//
+// Each character is drawn from a single byte of the pool. Bytes that would
+// bias the choice of character are rejected and the next byte in the pool is
+// used instead, so no byte is ever used twice and every character of the
+// alphabet is equally likely.
+//
+// Thread-safe.
+class AutoIdGenerator {
+ public:
+  static constexpr size_t kDefaultPoolSize = 4096;
+
+  explicit AutoIdGenerator(size_t pool_size = kDefaultPoolSize);
+
+  std::string CreateAutoId();
+
+  // Generates `count` IDs at once, taking the lock only once.
+  std::vector<std::string> CreateAutoIds(size_t count);
+
+ private:
+  // Appends a new ID to `result`. Requires mutex_ to be held.
+  void AppendAutoId(std::string* result);
+
+  // Returns the next unused byte of the pool, refilling it if it's been used
+  // up. Requires mutex_ to be held.
+  uint8_t NextByte();
+
+  std::mutex mutex_;
+  SecureRandom random_;
+  std::vector<uint8_t> pool_;
+  size_t next_ = 0;
+};
+
 // Generates a random ID suitable for use as a document ID.
 std::string CreateAutoId();
 
+// Generates `count` random IDs suitable for use as document IDs. Cheaper than
+// calling CreateAutoId() `count` times.
+std::vector<std::string> CreateAutoIds(size_t count);
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
@@ -48,6 +48,24 @@ bool Comparator<double>::operator()(double left, double right) const {
   }
 }
 
+ComparisonResult Comparator<double>::Compare(double left, double right) const {
+  if (left < right) {
+    return ComparisonResult::Ascending;
+  } else if (left > right) {
+    return ComparisonResult::Descending;
+  } else if (left == right) {
+    return ComparisonResult::Same;
+  } else {
+    // One or both left and right is NaN. NaN sorts equal to itself and before
+    // any other number.
+    bool left_is_nan = isnan(left);
+    bool right_is_nan = isnan(right);
+    if (left_is_nan == right_is_nan) return ComparisonResult::Same;
+    return left_is_nan ? ComparisonResult::Ascending
+                       : ComparisonResult::Descending;
+  }
+}
+
 static constexpr double INT64_MIN_VALUE_AS_DOUBLE =
     static_cast<double>(std::numeric_limits<int64_t>::min());
 
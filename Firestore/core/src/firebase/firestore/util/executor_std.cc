@@ -41,8 +41,8 @@ ExecutorStd::ExecutorStd() {
   // before the worker thread is started.
   // See [this thread](https://stackoverflow.com/questions/25609858) for context
   // on the constructor.
-  current_id_ = 0;
   shutting_down_ = false;
+  worker_parked_ = false;
   worker_thread_ = std::thread{&ExecutorStd::PollingThread, this};
 }
 
@@ -55,7 +55,7 @@ ExecutorStd::~ExecutorStd() {
 }
 
 void ExecutorStd::Execute(Operation&& operation) {
-  PushOnSchedule(std::move(operation), Immediate());
+  PushImmediate(std::move(operation));
 }
 
 DelayedOperation ExecutorStd::Schedule(const Milliseconds delay,
@@ -73,43 +73,56 @@ DelayedOperation ExecutorStd::Schedule(const Milliseconds delay,
   return DelayedOperation{[this, id] { TryCancel(id); }};
 }
 
-void ExecutorStd::TryCancel(const Id operation_id) {
-  schedule_.RemoveIf(
-      [operation_id](const Entry& e) { return e.id == operation_id; });
+void ExecutorStd::TryCancel(const Id& operation_id) {
+  schedule_.Remove(operation_id);
 }
 
 ExecutorStd::Id ExecutorStd::PushOnSchedule(Operation&& operation,
                                             const TimePoint when,
                                             const Tag tag) {
-  // Note: operations scheduled for immediate execution don't actually need an
-  // id. This could be tweaked to reuse the same id for all such operations.
-  const auto id = NextId();
-  schedule_.Push(Entry{std::move(operation), id, tag}, when);
-  return id;
+  return schedule_.Push(Entry{std::move(operation), tag}, when);
+}
+
+void ExecutorStd::PushImmediate(Operation&& operation) {
+  immediate_.Push(Entry{std::move(operation)});
+  // The worker announces that it's about to block before checking whether
+  // `immediate_` is empty, and both that store and the push are sequentially
+  // consistent, so either the worker sees this entry or this thread sees that
+  // the worker has to be woken up.
+  if (worker_parked_) {
+    schedule_.Interrupt();
+  }
 }
 
 void ExecutorStd::PollingThread() {
   while (!shutting_down_) {
-    Entry entry = schedule_.PopBlocking();
-    if (entry.tagged.operation) {
-      entry.tagged.operation();
+    absl::optional<Entry> entry = immediate_.TryPop();
+    if (!entry) {
+      entry = schedule_.PopIfDue();
+    }
+    if (!entry) {
+      worker_parked_ = true;
+      entry = schedule_.PopBlockingUnless(
+          [this] { return !immediate_.empty(); });
+      worker_parked_ = false;
+      // If interrupted, the next iteration picks up the immediate operation.
+      // Should its push still be in progress, this spins for the few
+      // instructions it takes to complete.
+      if (!entry) {
+        continue;
+      }
+    }
+
+    if (entry->tagged.operation) {
+      entry->tagged.operation();
     }
   }
 }
 
 void ExecutorStd::UnblockQueue() {
-  // Put a no-op for immediate execution on the queue to ensure that
-  // `schedule_.PopBlocking` returns, and worker thread can notice that shutdown
-  // is in progress.
-  schedule_.Push(Entry{[] {}, /*id=*/0}, Immediate());
-}
-
-ExecutorStd::Id ExecutorStd::NextId() {
-  // The wrap around after ~4 billion operations is explicitly ignored. Even if
-  // an instance of `ExecutorStd` runs long enough to get `current_id_` to
-  // overflow, it's extremely unlikely that any object still holds a reference
-  // that is old enough to cause a conflict.
-  return current_id_++;
+  // Put a no-op for immediate execution on the queue to ensure that the worker
+  // thread wakes up and can notice that shutdown is in progress.
+  PushImmediate([] {});
 }
 
 bool ExecutorStd::IsCurrentExecutor() const {
@@ -139,8 +152,9 @@ bool ExecutorStd::IsScheduled(const Tag tag) const {
 }
 
 absl::optional<Executor::TaggedOperation> ExecutorStd::PopFromSchedule() {
-  auto removed =
-      schedule_.RemoveIf([](const Entry& e) { return !e.IsImmediate(); });
+  // Only delayed operations are ever put on `schedule_`, so this removes the
+  // one that is due the soonest.
+  auto removed = schedule_.RemoveIf([](const Entry&) { return true; });
   if (!removed.has_value()) {
     return {};
   }
@@ -20,7 +20,8 @@
 #include <algorithm>
 #include <atomic>
 #include <condition_variable>  // NOLINT(build/c++11)
-#include <deque>
+#include <cstdint>
+#include <map>
 #include <mutex>  // NOLINT(build/c++11)
 #include <string>
 #include <thread>  // NOLINT(build/c++11)
@@ -28,6 +29,7 @@
 
 #include "Firestore/core/src/firebase/firestore/util/executor.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/mpsc_queue.h"
 #include "absl/types/optional.h"
 
 namespace firebase {
@@ -47,6 +49,10 @@ namespace async {
 // The details of time management are completely concealed within the class.
 // Once an entry is scheduled, there is no way to reschedule or even retrieve
 // the time.
+//
+// Entries are kept in a balanced tree keyed by their due time and insertion
+// order, so pushing and removing an entry by its `Handle` take logarithmic
+// time, and finding the most due entry takes constant time.
 template <typename T>
 class Schedule {
   // Internal invariants:
@@ -59,12 +65,33 @@ class Schedule {
   // Entries are scheduled using absolute time.
   using TimePoint = std::chrono::time_point<Clock, Duration>;
 
+  // Identifies a scheduled entry for `Remove`. Handles are never reused, so
+  // removing an entry that has already been popped is a safe no-op.
+  class Handle {
+   public:
+    bool operator<(const Handle& rhs) const {
+      return due_ < rhs.due_ ||
+             (due_ == rhs.due_ && sequence_ < rhs.sequence_);
+    }
+
+   private:
+    friend class Schedule;
+
+    Handle(const TimePoint due, const uint64_t sequence)
+        : due_{due}, sequence_{sequence} {
+    }
+
+    TimePoint due_;
+    // Breaks ties between entries due at the same time in FIFO order.
+    uint64_t sequence_;
+  };
+
   // Schedules an entry for the specified time due. `due` may be in the past.
-  void Push(const T& value, const TimePoint due) {
-    InsertPreservingOrder(Entry{value, due});
+  Handle Push(const T& value, const TimePoint due) {
+    return Insert(T{value}, due);
   }
-  void Push(T&& value, const TimePoint due) {
-    InsertPreservingOrder(Entry{std::move(value), due});
+  Handle Push(T&& value, const TimePoint due) {
+    return Insert(std::move(value), due);
   }
 
   // If the queue contains at least one entry for which the scheduled time is
@@ -85,17 +112,35 @@ class Schedule {
   // most overdue from the queue and returns it. The function will
   // attempt to minimize both the waiting time and busy waiting.
   T PopBlocking() {
+    return PopBlockingUnless([] { return false; }).value();
+  }
+
+  // Like `PopBlocking`, but gives up and returns an empty `optional` as soon as
+  // `interrupt` returns true. `interrupt` is evaluated with the internal mutex
+  // held whenever the waiting thread wakes up, so whoever makes it true must
+  // call `Interrupt` afterwards to guarantee that the change is noticed.
+  template <typename Pred>
+  absl::optional<T> PopBlockingUnless(const Pred interrupt) {
     std::unique_lock<std::mutex> lock{mutex_};
 
     while (true) {
-      cv_.wait(lock, [this] { return !scheduled_.empty(); });
+      cv_.wait(lock, [this, &interrupt] {
+        return interrupt() || !scheduled_.empty();
+      });
+      if (interrupt()) {
+        return {};
+      }
 
       // To minimize busy waiting, sleep until either the nearest entry in the
       // future either changes, or else becomes due.
-      const auto until = scheduled_.front().due;
-      cv_.wait_until(lock, until, [this, until] {
-        return scheduled_.empty() || scheduled_.front().due != until;
+      const auto until = scheduled_.begin()->first.due_;
+      cv_.wait_until(lock, until, [this, until, &interrupt] {
+        return interrupt() || scheduled_.empty() ||
+               scheduled_.begin()->first.due_ != until;
       });
+      if (interrupt()) {
+        return {};
+      }
       // There are 3 possibilities why `wait_until` has returned:
       // - `wait_until` has timed out, in which case the current time is at
       //   least `until`, so there must be an overdue entry;
@@ -113,6 +158,13 @@ class Schedule {
     }
   }
 
+  // Wakes up the thread blocked in `PopBlockingUnless`, if any, so that it
+  // reevaluates its predicate.
+  void Interrupt() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    cv_.notify_one();
+  }
+
   bool empty() const {
     std::lock_guard<std::mutex> lock{mutex_};
     return scheduled_.empty();
@@ -123,6 +175,21 @@ class Schedule {
     return scheduled_.size();
   }
 
+  // Removes the entry identified by `handle` from the queue and returns it. If
+  // the entry is no longer in the queue, returns an empty `optional`.
+  //
+  // Note that this function doesn't take into account whether the removed entry
+  // is past its due time.
+  absl::optional<T> Remove(const Handle& handle) {
+    std::lock_guard<std::mutex> lock{mutex_};
+
+    const auto found = scheduled_.find(handle);
+    if (found == scheduled_.end()) {
+      return {};
+    }
+    return ExtractLocked(found);
+  }
+
   // Removes the first entry satisfying predicate from the queue and returns it.
   // If no such entry exists, returns an empty `optional`. Predicate is applied
   // to entries in order according to their scheduled time.
@@ -135,7 +202,7 @@ class Schedule {
 
     for (auto iter = scheduled_.begin(), end = scheduled_.end(); iter != end;
          ++iter) {
-      if (pred(iter->value)) {
+      if (pred(iter->second)) {
         return ExtractLocked(iter);
       }
     }
@@ -147,38 +214,31 @@ class Schedule {
   bool Contains(const Pred pred) const {
     std::lock_guard<std::mutex> lock{mutex_};
     return std::any_of(scheduled_.begin(), scheduled_.end(),
-                       [&pred](const Entry& s) { return pred(s.value); });
+                       [&pred](const typename Container::value_type& s) {
+                         return pred(s.second);
+                       });
   }
 
  private:
-  struct Entry {
-    bool operator<(const Entry& rhs) const {
-      return due < rhs.due;
-    }
-
-    T value;
-    TimePoint due;
-  };
-  // All removals are on the front, but most insertions are expected to be on
-  // the back.
-  using Container = std::deque<Entry>;
+  using Container = std::map<Handle, T>;
   using Iterator = typename Container::iterator;
 
-  void InsertPreservingOrder(Entry&& new_entry) {
+  Handle Insert(T&& value, const TimePoint due) {
     std::lock_guard<std::mutex> lock{mutex_};
 
-    const auto insertion_point =
-        std::upper_bound(scheduled_.begin(), scheduled_.end(), new_entry);
-    scheduled_.insert(insertion_point, std::move(new_entry));
+    const Handle handle{due, next_sequence_++};
+    // Most entries are due after all the existing ones, so hint the end.
+    scheduled_.emplace_hint(scheduled_.end(), handle, std::move(value));
 
     cv_.notify_one();
+    return handle;
   }
 
   // This function expects the mutex to be already locked.
   bool HasDueLocked() const {
     namespace chr = std::chrono;
     const auto now = chr::time_point_cast<Duration>(Clock::now());
-    return !scheduled_.empty() && now >= scheduled_.front().due;
+    return !scheduled_.empty() && now >= scheduled_.begin()->first.due_;
   }
 
   // This function expects the mutex to be already locked.
@@ -186,7 +246,7 @@ class Schedule {
     HARD_ASSERT(!scheduled_.empty(),
                 "Trying to pop an entry from an empty queue.");
 
-    T result = std::move(where->value);
+    T result = std::move(where->second);
     scheduled_.erase(where);
     cv_.notify_one();
 
@@ -196,6 +256,7 @@ class Schedule {
   mutable std::mutex mutex_;
   std::condition_variable cv_;
   Container scheduled_;
+  uint64_t next_sequence_ = 0;
 };
 
 }  // namespace async
@@ -220,56 +281,43 @@ class ExecutorStd : public Executor {
   bool IsScheduled(Tag tag) const override;
   absl::optional<TaggedOperation> PopFromSchedule() override;
 
-  using TimePoint = async::Schedule<Operation>::TimePoint;
-  // To allow canceling operations, each scheduled operation is assigned
-  // a monotonically increasing identifier.
-  using Id = unsigned int;
-
-  // If the operation hasn't yet been run, it will be removed from the queue.
-  // Otherwise, this function is a no-op.
-  void TryCancel(Id operation_id);
-
-  Id PushOnSchedule(Operation&& operation, TimePoint when, Tag tag = -1);
-
-  void PollingThread();
-  void UnblockQueue();
-  Id NextId();
-
-  // As a convention, assign the epoch time to all operations scheduled for
-  // immediate execution. Note that it means that an immediate operation is
-  // always scheduled before any delayed operation, even in the corner case when
-  // the immediate operation was scheduled after a delayed operation was due
-  // (but hasn't yet run).
-  static TimePoint Immediate() {
-    return TimePoint{};
-  }
-
   struct Entry {
     Entry() {
     }
-    Entry(Operation&& operation,
-          const ExecutorStd::Id id,
-          const ExecutorStd::Tag tag = kNoTag)
-        : tagged{tag, std::move(operation)}, id{id} {
-    }
-
-    bool IsImmediate() const {
-      return tagged.tag == kNoTag;
+    explicit Entry(Operation&& operation, const ExecutorStd::Tag tag = kNoTag)
+        : tagged{tag, std::move(operation)} {
     }
 
     static constexpr Tag kNoTag = -1;
     TaggedOperation tagged;
-    Id id = 0;
   };
-  // Operations scheduled for immediate execution are also put on the schedule
-  // (with due time set to `Immediate`).
+  using TimePoint = async::Schedule<Entry>::TimePoint;
+  // To allow canceling operations, each scheduled operation is identified by
+  // the handle the schedule assigned to it.
+  using Id = async::Schedule<Entry>::Handle;
+
+  // If the operation hasn't yet been run, it will be removed from the queue.
+  // Otherwise, this function is a no-op.
+  void TryCancel(const Id& operation_id);
+
+  Id PushOnSchedule(Operation&& operation, TimePoint when, Tag tag);
+  void PushImmediate(Operation&& operation);
+
+  void PollingThread();
+  void UnblockQueue();
+
+  // Operations submitted for immediate execution. These always run before any
+  // delayed operation, even one that became due before they were submitted.
+  MpscQueue<Entry> immediate_;
+  // Delayed operations, ordered by their due time.
   async::Schedule<Entry> schedule_;
+  // Set by the worker thread while it's blocked on `schedule_`, to let
+  // producers of immediate operations know that they have to wake it up.
+  std::atomic<bool> worker_parked_{false};
 
   std::thread worker_thread_;
   // Used to stop the worker thread.
   std::atomic<bool> shutting_down_{false};
-
-  std::atomic<Id> current_id_{0};
 };
 
 }  // namespace util
@@ -23,6 +23,7 @@
 #include "Firestore/core/src/firebase/firestore/util/path.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "absl/strings/string_view.h"
 
 namespace firebase {
 namespace firestore {
@@ -86,6 +87,34 @@ StatusOr<int64_t> FileSize(const Path& path);
  */
 StatusOr<std::string> ReadFile(const Path& path);
 
+/**
+ * The contents of a file, mapped read-only into memory so that large files can
+ * be read without first copying them. The contents stay valid for as long as
+ * the instance exists, and must not be changed by anyone while it does.
+ */
+class MappedFile {
+ public:
+  /**
+   * On success, maps the file at the given `path`.
+   */
+  static StatusOr<std::unique_ptr<MappedFile>> Open(const Path& path);
+
+  virtual ~MappedFile() {
+  }
+
+  absl::string_view contents() const {
+    return contents_;
+  }
+
+ protected:
+  MappedFile() = default;
+
+  MappedFile(const MappedFile& other) = delete;
+  MappedFile& operator=(const MappedFile& other) = delete;
+
+  absl::string_view contents_;
+};
+
 /**
  * Implements an iterator over the contents of a directory. Initializes to the
  * first entry in the directory.
@@ -17,6 +17,8 @@
 #include "Firestore/core/src/firebase/firestore/util/filesystem.h"
 
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -219,6 +221,63 @@ std::unique_ptr<DirectoryIterator> DirectoryIterator::Create(
   return absl::make_unique<DirectoryIteratorPosix>(path);
 }
 
+namespace {
+
+class MappedFilePosix : public MappedFile {
+ public:
+  MappedFilePosix(void* data, size_t size) : data_(data), size_(size) {
+    contents_ = absl::string_view{static_cast<const char*>(data), size};
+  }
+
+  ~MappedFilePosix() override {
+    if (data_) {
+      ::munmap(data_, size_);
+    }
+  }
+
+ private:
+  void* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+}  // namespace
+
+StatusOr<std::unique_ptr<MappedFile>> MappedFile::Open(const Path& path) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return Status::FromErrno(
+        errno, StringFormat("Could not open file %s", path.ToUtf8String()));
+  }
+
+  struct stat st {};
+  if (::fstat(fd, &st)) {
+    int error = errno;
+    ::close(fd);
+    return Status::FromErrno(
+        error, StringFormat("Failed to stat file: %s", path.ToUtf8String()));
+  }
+
+  // mmap rejects empty mappings, but there's nothing to map anyway.
+  size_t size = static_cast<size_t>(st.st_size);
+  void* data = nullptr;
+  if (size > 0) {
+    data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      int error = errno;
+      ::close(fd);
+      return Status::FromErrno(
+          error, StringFormat("Could not map file %s", path.ToUtf8String()));
+    }
+
+    // Mapped files are typically read front to back.
+    ::madvise(data, size, MADV_SEQUENTIAL);
+  }
+
+  // The mapping keeps the file open on its own.
+  ::close(fd);
+  return std::unique_ptr<MappedFile>{new MappedFilePosix(data, size)};
+}
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
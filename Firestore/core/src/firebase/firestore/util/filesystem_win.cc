@@ -22,6 +22,7 @@
 
 #include <cerrno>
 #include <string>
+#include <utility>
 
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/path.h"
@@ -240,6 +241,33 @@ std::unique_ptr<DirectoryIterator> DirectoryIterator::Create(
   return absl::make_unique<DirectoryIteratorWindows>(path);
 }
 
+namespace {
+
+/**
+ * Files aren't actually mapped on Windows: they're read into memory instead,
+ * which only differs in performance.
+ */
+class MappedFileWindows : public MappedFile {
+ public:
+  explicit MappedFileWindows(std::string data) : data_(std::move(data)) {
+    contents_ = data_;
+  }
+
+ private:
+  std::string data_;
+};
+
+}  // namespace
+
+StatusOr<std::unique_ptr<MappedFile>> MappedFile::Open(const Path& path) {
+  StatusOr<std::string> data = ReadFile(path);
+  if (!data.ok()) {
+    return data.status();
+  }
+  return std::unique_ptr<MappedFile>{
+      new MappedFileWindows(std::move(data.ValueOrDie()))};
+}
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_FUTURE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_FUTURE_H_
+
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace internal {
+
+// The state shared between a `Promise` and its `Future`.
+template <typename T>
+class FutureState {
+ public:
+  using Continuation = std::function<void(T)>;
+
+  void SetValue(T&& value) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    HARD_ASSERT(!has_value_, "A promise can only be fulfilled once");
+    has_value_ = true;
+    if (!continuation_) {
+      value_ = std::move(value);
+      return;
+    }
+
+    Continuation continuation = std::move(continuation_);
+    lock.unlock();
+    Dispatch(queue_, std::move(continuation), std::move(value));
+  }
+
+  void Then(AsyncQueue* queue, Continuation&& continuation) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    HARD_ASSERT(!has_continuation_,
+                "A future can only have a single continuation");
+    has_continuation_ = true;
+    if (!value_) {
+      queue_ = queue;
+      continuation_ = std::move(continuation);
+      return;
+    }
+
+    T value = std::move(*value_);
+    value_.reset();
+    lock.unlock();
+    Dispatch(queue, std::move(continuation), std::move(value));
+  }
+
+ private:
+  // Runs `continuation` on `queue`. If the caller is already running an
+  // operation on `queue`, `continuation` runs right away, as part of that
+  // operation, instead of in an operation of its own.
+  static void Dispatch(AsyncQueue* queue,
+                       Continuation&& continuation,
+                       T&& value) {
+    if (queue->IsCurrentQueue()) {
+      continuation(std::move(value));
+      return;
+    }
+
+    // TODO(c++14): move `continuation` and `value` into the lambda.
+    auto shared_value = std::make_shared<T>(std::move(value));
+    queue->EnqueueRelaxed([continuation, shared_value] {
+      continuation(std::move(*shared_value));
+    });
+  }
+
+  std::mutex mutex_;
+  bool has_value_ = false;
+  bool has_continuation_ = false;
+  absl::optional<T> value_;
+  AsyncQueue* queue_ = nullptr;
+  Continuation continuation_;
+};
+
+}  // namespace internal
+
+template <typename T>
+class Promise;
+
+// The result of an asynchronous computation that will become available on an
+// `AsyncQueue`.
+//
+// A `Future` is a lighter alternative to passing callbacks through several
+// layers that each re-enqueue onto the queue: it hops onto the queue exactly
+// once, and not at all if the value is produced (or the continuation attached)
+// while an operation is already running on the queue.
+//
+// Each `Future` takes a single continuation, and each `Promise` is fulfilled
+// exactly once. `T` must be copy-constructible.
+template <typename T>
+class Future {
+ public:
+  // Calls `continuation` with the value once it's available, on `queue`, which
+  // must outlive the promise.
+  //
+  // If the value is already available and `Then` is called as part of an
+  // operation on `queue`, `continuation` runs before `Then` returns. Likewise,
+  // if the promise is fulfilled as part of an operation on `queue`,
+  // `continuation` runs before `SetValue` returns. Otherwise, `continuation` is
+  // enqueued on `queue`.
+  void Then(AsyncQueue* queue, std::function<void(T)> continuation) {
+    state_->Then(queue, std::move(continuation));
+  }
+
+ private:
+  friend class Promise<T>;
+
+  explicit Future(std::shared_ptr<internal::FutureState<T>> state)
+      : state_{std::move(state)} {
+  }
+
+  std::shared_ptr<internal::FutureState<T>> state_;
+};
+
+// The producing side of a `Future`. Copies of a `Promise` share the same
+// state, so a `Promise` can be captured in callbacks that must be copyable.
+template <typename T>
+class Promise {
+ public:
+  Promise() : state_{std::make_shared<internal::FutureState<T>>()} {
+  }
+
+  Future<T> GetFuture() const {
+    return Future<T>{state_};
+  }
+
+  // Makes `value` available to the continuation of the future. May be called
+  // from any thread.
+  void SetValue(T value) const {
+    state_->SetValue(std::move(value));
+  }
+
+ private:
+  std::shared_ptr<internal::FutureState<T>> state_;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_FUTURE_H_
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/hashing.h"
+
+#include <cstring>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+using impl::kHashSecret0;
+using impl::kHashSecret1;
+using impl::kHashSecret2;
+using impl::kHashSecret3;
+using impl::MultiplyFold;
+
+// The reads are done with memcpy, which compilers turn into single unaligned
+// loads. The byte order of the loads differs between platforms, which is fine
+// since hashes are never persisted.
+
+uint64_t Read8(const uint8_t* p) {
+  uint64_t result;
+  std::memcpy(&result, p, sizeof(result));
+  return result;
+}
+
+uint64_t Read4(const uint8_t* p) {
+  uint32_t result;
+  std::memcpy(&result, p, sizeof(result));
+  return result;
+}
+
+/** Reads 1 to 3 bytes, reading some of them more than once. */
+uint64_t Read1To3(const uint8_t* p, size_t size) {
+  return (uint64_t{p[0]} << 16) | (uint64_t{p[size >> 1]} << 8) |
+         p[size - 1];
+}
+
+}  // namespace
+
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed) {
+  const auto* p = static_cast<const uint8_t*>(data);
+  seed ^= kHashSecret0;
+
+  uint64_t a = 0;
+  uint64_t b = 0;
+  if (size <= 16) {
+    if (size >= 4) {
+      // Two possibly overlapping pairs of 4-byte reads cover all the bytes.
+      size_t offset = (size >> 3) << 2;
+      a = (Read4(p) << 32) | Read4(p + offset);
+      b = (Read4(p + size - 4) << 32) | Read4(p + size - 4 - offset);
+    } else if (size > 0) {
+      a = Read1To3(p, size);
+    }
+  } else {
+    size_t remaining = size;
+    if (remaining > 48) {
+      // Three independent lanes let the multiplications overlap.
+      uint64_t seed1 = seed;
+      uint64_t seed2 = seed;
+      do {
+        seed = MultiplyFold(Read8(p) ^ kHashSecret1, Read8(p + 8) ^ seed);
+        seed1 =
+            MultiplyFold(Read8(p + 16) ^ kHashSecret2, Read8(p + 24) ^ seed1);
+        seed2 =
+            MultiplyFold(Read8(p + 32) ^ kHashSecret3, Read8(p + 40) ^ seed2);
+        p += 48;
+        remaining -= 48;
+      } while (remaining > 48);
+      seed ^= seed1 ^ seed2;
+    }
+    while (remaining > 16) {
+      seed = MultiplyFold(Read8(p) ^ kHashSecret1, Read8(p + 8) ^ seed);
+      p += 16;
+      remaining -= 16;
+    }
+    // The last 16 bytes, which may overlap with the ones already mixed in.
+    a = Read8(p + remaining - 16);
+    b = Read8(p + remaining - 8);
+  }
+
+  return MultiplyFold(kHashSecret1 ^ size,
+                      MultiplyFold(a ^ kHashSecret1, b ^ seed));
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -17,6 +17,8 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_HASHING_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_HASHING_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <iterator>
 #include <string>
@@ -24,6 +26,7 @@
 
 #include "Firestore/core/src/firebase/firestore/util/type_traits.h"
 #include "absl/meta/type_traits.h"
+#include "absl/strings/string_view.h"
 
 namespace firebase {
 namespace firestore {
@@ -203,6 +206,83 @@ size_t Hash(const Ts&... values) {
   return impl::HashInternal(0u, values...);
 }
 
+// Fast 64-bit hashing
+//
+// Unlike `Hash` above, whose results have to agree with hand-written
+// Objective-C `-hash` methods, these functions are free to use a high quality
+// hash function. They're based on wyhash, which mixes its input eight or
+// sixteen bytes at a time using 64x64 to 128-bit multiplications.
+//
+// The results are not stable across versions of the SDK and must not be
+// persisted.
+
+namespace impl {
+
+/** Multiplies `a` and `b` and folds the 128-bit product into 64 bits. */
+inline uint64_t MultiplyFold(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+  __uint128_t product = static_cast<__uint128_t>(a) * b;
+  return static_cast<uint64_t>(product) ^
+         static_cast<uint64_t>(product >> 64);
+#else
+  uint64_t a_hi = a >> 32;
+  uint64_t a_lo = static_cast<uint32_t>(a);
+  uint64_t b_hi = b >> 32;
+  uint64_t b_lo = static_cast<uint32_t>(b);
+  uint64_t hi_hi = a_hi * b_hi;
+  uint64_t hi_lo = a_hi * b_lo;
+  uint64_t lo_hi = a_lo * b_hi;
+  uint64_t lo_lo = a_lo * b_lo;
+
+  uint64_t middle = (lo_lo >> 32) + static_cast<uint32_t>(hi_lo) +
+                    static_cast<uint32_t>(lo_hi);
+  uint64_t lo = (middle << 32) | static_cast<uint32_t>(lo_lo);
+  uint64_t hi = hi_hi + (hi_lo >> 32) + (lo_hi >> 32) + (middle >> 32);
+  return lo ^ hi;
+#endif  // defined(__SIZEOF_INT128__)
+}
+
+constexpr uint64_t kHashSecret0 = 0xa0761d6478bd642fULL;
+constexpr uint64_t kHashSecret1 = 0xe7037ed1a0b428dbULL;
+constexpr uint64_t kHashSecret2 = 0x8ebc6af09c88c6e3ULL;
+constexpr uint64_t kHashSecret3 = 0x589965cc75374cc3ULL;
+
+}  // namespace impl
+
+/** Hashes `size` bytes at `data`, mixing the result with `seed`. */
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 0);
+
+/**
+ * Incrementally hashes a sequence of values, e.g. the segments of a path or
+ * the nodes of a value tree. The boundaries between values matter: hashing
+ * "ab" and then "c" gives a different result than "a" and then "bc".
+ */
+class Hasher {
+ public:
+  Hasher() = default;
+
+  explicit Hasher(uint64_t seed) : state_{seed} {
+  }
+
+  Hasher& AddBytes(absl::string_view bytes) {
+    state_ = HashBytes(bytes.data(), bytes.size(), state_);
+    return *this;
+  }
+
+  Hasher& AddInteger(uint64_t value) {
+    state_ = impl::MultiplyFold(state_ ^ impl::kHashSecret0,
+                                value ^ impl::kHashSecret1);
+    return *this;
+  }
+
+  uint64_t value() const {
+    return state_;
+  }
+
+ private:
+  uint64_t state_ = 0;
+};
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
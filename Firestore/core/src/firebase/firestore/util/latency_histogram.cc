@@ -0,0 +1,84 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace chr = std::chrono;
+
+constexpr size_t LatencyHistogram::kBucketCount;
+
+void LatencyHistogram::Record(Milliseconds latency) {
+  latency = std::max(latency, Milliseconds::zero());
+
+  size_t index = 0;
+  while (index + 1 < kBucketCount && latency >= BucketUpperBound(index)) {
+    ++index;
+  }
+
+  ++buckets_[index];
+  ++count_;
+  sum_ += latency;
+  max_ = std::max(max_, latency);
+}
+
+void LatencyHistogram::RecordElapsedSince(Clock::time_point start) {
+  Record(chr::duration_cast<Milliseconds>(Clock::now() - start));
+}
+
+LatencyHistogram::Milliseconds LatencyHistogram::BucketUpperBound(
+    size_t index) {
+  HARD_ASSERT(index < kBucketCount, "Bucket index out of range: %s", index);
+  if (index + 1 == kBucketCount) {
+    return Milliseconds::max();
+  }
+  return Milliseconds{int64_t{1} << index};
+}
+
+LatencyHistogram::Milliseconds LatencyHistogram::Percentile(
+    double percentile) const {
+  HARD_ASSERT(percentile >= 0 && percentile <= 100,
+              "Percentile must be between 0 and 100 (was %s)", percentile);
+  if (count_ == 0) {
+    return Milliseconds::zero();
+  }
+
+  // The number of recorded latencies that are at most the percentile.
+  auto rank = std::max(
+      int64_t{1},
+      static_cast<int64_t>(std::ceil(percentile / 100 * count_)));
+
+  int64_t seen = 0;
+  for (size_t i = 0; i != kBucketCount; ++i) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      return std::min(BucketUpperBound(i), max_);
+    }
+  }
+  return max_;
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_LATENCY_HISTOGRAM_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_LATENCY_HISTOGRAM_H_
+
+#include <array>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <cstdint>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/**
+ * A histogram of latencies with exponentially growing buckets: the first
+ * bucket holds latencies under 1 ms, bucket `i` holds latencies in
+ * `[2^(i-1), 2^i)` ms, and the last bucket holds everything from
+ * `2^(kBucketCount-2)` ms (about a minute) up.
+ */
+class LatencyHistogram {
+ public:
+  using Milliseconds = std::chrono::milliseconds;
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr size_t kBucketCount = 18;
+
+  void Record(Milliseconds latency);
+  /** Records the time elapsed since `start`. */
+  void RecordElapsedSince(Clock::time_point start);
+
+  /** The number of latencies recorded. */
+  int64_t count() const {
+    return count_;
+  }
+  Milliseconds sum() const {
+    return sum_;
+  }
+  Milliseconds max() const {
+    return max_;
+  }
+  const std::array<int64_t, kBucketCount>& buckets() const {
+    return buckets_;
+  }
+
+  /**
+   * The exclusive upper bound of the bucket with the given index; for the last
+   * bucket, which is unbounded, `Milliseconds::max()`.
+   */
+  static Milliseconds BucketUpperBound(size_t index);
+
+  /**
+   * Returns an upper bound for the given percentile (between 0 and 100) of the
+   * recorded latencies, accurate to the bucket the percentile falls into
+   * (which is never more than `max()`). Returns zero if nothing was recorded.
+   */
+  Milliseconds Percentile(double percentile) const;
+
+ private:
+  std::array<int64_t, kBucketCount> buckets_{};
+  int64_t count_ = 0;
+  Milliseconds sum_{0};
+  Milliseconds max_{0};
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_LATENCY_HISTOGRAM_H_
@@ -35,20 +35,37 @@ enum LogLevel {
   kLogLevelError,
 };
 
+// Logs a message at the given level if that level is enabled. The format
+// arguments are only evaluated, and the message only formatted, if it is, so
+// call sites may pass expensive expressions such as `ToString()` calls.
+#define FIRESTORE_LOG_AT_LEVEL_(level, ...)                              \
+  do {                                                                   \
+    namespace _util = firebase::firestore::util;                         \
+    if (_util::LogIsLoggable(_util::level)) {                            \
+      _util::LogMessage(_util::level, _util::StringFormat(__VA_ARGS__)); \
+    }                                                                    \
+  } while (0)
+
 // Log a message if kLogLevelDebug is enabled. Arguments are not evaluated if
 // logging is disabled.
 //
+// If FIRESTORE_STRIP_DEBUG_LOGGING is defined (see the option of the same name
+// in CMake), debug logging is compiled out entirely: the arguments are still
+// type-checked, but never evaluated, and debug logging can't be enabled.
+//
 // @param format A format string suitable for use with `util::StringFormat`
 // @param ... C++ variadic arguments that match the format string. Not C
 //     varargs.
-#define LOG_DEBUG(...)                                         \
-  do {                                                         \
-    namespace _util = firebase::firestore::util;               \
-    if (_util::LogIsLoggable(_util::kLogLevelDebug)) {         \
-      std::string _message = _util::StringFormat(__VA_ARGS__); \
-      _util::LogMessage(_util::kLogLevelDebug, _message);      \
-    }                                                          \
+#if defined(FIRESTORE_STRIP_DEBUG_LOGGING)
+#define LOG_DEBUG(...)                                      \
+  do {                                                      \
+    if (false) {                                            \
+      firebase::firestore::util::StringFormat(__VA_ARGS__); \
+    }                                                       \
   } while (0)
+#else
+#define LOG_DEBUG(...) FIRESTORE_LOG_AT_LEVEL_(kLogLevelDebug, __VA_ARGS__)
+#endif  // defined(FIRESTORE_STRIP_DEBUG_LOGGING)
 
 // Log a message if kLogLevelWarn is enabled (it is by default). Arguments are
 // not evaluated if logging is disabled.
@@ -56,14 +73,7 @@ enum LogLevel {
 // @param format A format string suitable for use with `util::StringFormat`
 // @param ... C++ variadic arguments that match the format string. Not C
 //     varargs.
-#define LOG_WARN(...)                                          \
-  do {                                                         \
-    namespace _util = firebase::firestore::util;               \
-    if (_util::LogIsLoggable(_util::kLogLevelWarning)) {       \
-      std::string _message = _util::StringFormat(__VA_ARGS__); \
-      _util::LogMessage(_util::kLogLevelWarning, _message);    \
-    }                                                          \
-  } while (0)
+#define LOG_WARN(...) FIRESTORE_LOG_AT_LEVEL_(kLogLevelWarning, __VA_ARGS__)
 
 // Log a message if kLogLevelError is enabled (it is by default). Arguments are
 // not evaluated if logging is disabled.
@@ -71,21 +81,18 @@ enum LogLevel {
 // @param format A format string suitable for use with `util::StringFormat`
 // @param ... C++ variadic arguments that match the format string. Not C
 //     varargs.
-#define LOG_ERROR(...)                                         \
-  do {                                                         \
-    namespace _util = firebase::firestore::util;               \
-    if (_util::LogIsLoggable(_util::kLogLevelError)) {         \
-      std::string _message = _util::StringFormat(__VA_ARGS__); \
-      _util::LogMessage(_util::kLogLevelError, _message);      \
-    }                                                          \
-  } while (0)
+#define LOG_ERROR(...) FIRESTORE_LOG_AT_LEVEL_(kLogLevelError, __VA_ARGS__)
 
 // Tests to see if the given log level is loggable.
 bool LogIsLoggable(LogLevel level);
 
 // Is debug logging enabled?
 inline bool LogIsDebugEnabled() {
+#if defined(FIRESTORE_STRIP_DEBUG_LOGGING)
+  return false;
+#else
   return LogIsLoggable(kLogLevelDebug);
+#endif  // defined(FIRESTORE_STRIP_DEBUG_LOGGING)
 }
 
 // All messages at or above the specified log level value are displayed.
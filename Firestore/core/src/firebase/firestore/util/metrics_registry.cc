@@ -0,0 +1,97 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/metrics_registry.h"
+
+#include "absl/memory/memory.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+template <typename Metric>
+Metric* FindOrCreate(std::map<std::string, std::unique_ptr<Metric>>* metrics,
+                     const std::string& name) {
+  std::unique_ptr<Metric>& metric = (*metrics)[name];
+  if (!metric) {
+    metric = absl::make_unique<Metric>();
+  }
+  return metric.get();
+}
+
+}  // namespace
+
+void MetricsRegistry::Histogram::Record(
+    LatencyHistogram::Milliseconds latency) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  histogram_.Record(latency);
+}
+
+void MetricsRegistry::Histogram::RecordElapsedSince(
+    LatencyHistogram::Clock::time_point start) {
+  Record(std::chrono::duration_cast<LatencyHistogram::Milliseconds>(
+      LatencyHistogram::Clock::now() - start));
+}
+
+LatencyHistogram MetricsRegistry::Histogram::value() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return histogram_;
+}
+
+MetricsRegistry& MetricsRegistry::Default() {
+  // Intentionally leaked: recording sites cache pointers into the registry and
+  // may still run during static destruction.
+  static auto* registry = new MetricsRegistry();
+  return *registry;
+}
+
+MetricsRegistry::Counter* MetricsRegistry::GetCounter(
+    const std::string& name) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return FindOrCreate(&counters_, name);
+}
+
+MetricsRegistry::Gauge* MetricsRegistry::GetGauge(const std::string& name) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return FindOrCreate(&gauges_, name);
+}
+
+MetricsRegistry::Histogram* MetricsRegistry::GetHistogram(
+    const std::string& name) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return FindOrCreate(&histograms_, name);
+}
+
+MetricsSnapshot MetricsRegistry::Snapshot() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  MetricsSnapshot result;
+  for (const auto& kv : counters_) {
+    result.counters[kv.first] = kv.second->value();
+  }
+  for (const auto& kv : gauges_) {
+    result.gauges[kv.first] = kv.second->value();
+  }
+  for (const auto& kv : histograms_) {
+    result.histograms[kv.first] = kv.second->value();
+  }
+  return result;
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
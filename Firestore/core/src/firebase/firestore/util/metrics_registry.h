@@ -0,0 +1,137 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_METRICS_REGISTRY_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_METRICS_REGISTRY_H_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/util/latency_histogram.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/** A point-in-time copy of every metric in a `MetricsRegistry`, by name. */
+struct MetricsSnapshot {
+  std::map<std::string, int64_t> counters;
+  std::map<std::string, int64_t> gauges;
+  std::map<std::string, LatencyHistogram> histograms;
+};
+
+/**
+ * A set of named counters, gauges and latency histograms that components
+ * record into as they go and that can be copied out at any time.
+ *
+ * Metrics are created on first lookup and live as long as the registry, so a
+ * recording site looks its metric up once and keeps the pointer:
+ *
+ *     static Counter* commits =
+ *         MetricsRegistry::Default().GetCounter("leveldb.commits");
+ *     commits->Increment();
+ *
+ * Counters and gauges are updated with relaxed atomics and never block, no
+ * matter which thread records into them. Histograms take an uncontended lock
+ * per recorded latency.
+ */
+class MetricsRegistry {
+ public:
+  /** A value that only goes up, such as the number of commits. */
+  class Counter {
+   public:
+    void Increment(int64_t amount = 1) {
+      value_.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    int64_t value() const {
+      return value_.load(std::memory_order_relaxed);
+    }
+
+   private:
+    std::atomic<int64_t> value_{0};
+  };
+
+  /** A value describing the current state, such as the number of targets. */
+  class Gauge {
+   public:
+    void Set(int64_t value) {
+      value_.store(value, std::memory_order_relaxed);
+    }
+
+    void Add(int64_t amount) {
+      value_.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    int64_t value() const {
+      return value_.load(std::memory_order_relaxed);
+    }
+
+   private:
+    std::atomic<int64_t> value_{0};
+  };
+
+  /** A distribution of latencies, in the buckets of `LatencyHistogram`. */
+  class Histogram {
+   public:
+    void Record(LatencyHistogram::Milliseconds latency);
+    void RecordElapsedSince(LatencyHistogram::Clock::time_point start);
+
+    LatencyHistogram value() const;
+
+   private:
+    mutable std::mutex mutex_;
+    LatencyHistogram histogram_;
+  };
+
+  MetricsRegistry() = default;
+
+  MetricsRegistry(const MetricsRegistry&) = delete;
+  MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+  /**
+   * The registry the Firestore core records into. It's shared by every
+   * Firestore instance in the process.
+   */
+  static MetricsRegistry& Default();
+
+  /**
+   * Returns the metric with the given name, creating it if it doesn't exist
+   * yet. The pointer stays valid for the lifetime of the registry.
+   */
+  Counter* GetCounter(const std::string& name);
+  Gauge* GetGauge(const std::string& name);
+  Histogram* GetHistogram(const std::string& name);
+
+  /** Copies out the current value of every metric. */
+  MetricsSnapshot Snapshot() const;
+
+ private:
+  mutable std::mutex mutex_;
+  std::map<std::string, std::unique_ptr<Counter>> counters_;
+  std::map<std::string, std::unique_ptr<Gauge>> gauges_;
+  std::map<std::string, std::unique_ptr<Histogram>> histograms_;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_METRICS_REGISTRY_H_
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_MPSC_QUEUE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_MPSC_QUEUE_H_
+
+#include <atomic>
+#include <utility>
+
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+// A FIFO queue that any number of threads may push onto without taking a lock,
+// while a single consumer thread pops from it. This is the intrusive queue
+// described by Dmitry Vyukov: producers atomically swap themselves in as the
+// new tail and only then link the previous tail to the new node, so a push
+// never waits for other producers or for the consumer.
+//
+// The queue never blocks; the consumer is responsible for sleeping (and being
+// woken up) when it runs out of entries.
+template <typename T>
+class MpscQueue {
+  // Internal invariants:
+  // - `head_` is always a node whose value has already been consumed (or the
+  //   initial stub); the oldest unconsumed entry is `head_->next`;
+  // - `tail_` is the most recently pushed node, or `head_` if the queue is
+  //   empty.
+ public:
+  MpscQueue() : head_{new Node{}}, tail_{head_} {
+  }
+
+  ~MpscQueue() {
+    while (TryPop().has_value()) {
+    }
+    delete head_;
+  }
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  // Adds an entry to the back of the queue. Safe to call from any thread.
+  void Push(T&& value) {
+    auto* node = new Node{std::move(value)};
+    // Sequentially consistent so that a consumer that announces it's going to
+    // sleep and then checks `empty` can't miss this entry (see `ExecutorStd`).
+    Node* previous = tail_.exchange(node);
+    previous->next.store(node, std::memory_order_release);
+  }
+
+  // Removes the entry at the front of the queue and returns it, or returns an
+  // empty `optional` if there is none. May only be called by the consumer.
+  //
+  // Note that an entry whose push is still in progress on another thread is
+  // not yet visible to `TryPop`, even though `empty` already returns false.
+  absl::optional<T> TryPop() {
+    Node* next = head_->next.load(std::memory_order_acquire);
+    if (!next) {
+      return {};
+    }
+
+    absl::optional<T> result{std::move(next->value)};
+    next->value.reset();
+    delete head_;
+    head_ = next;
+    return result;
+  }
+
+  // Returns whether no producer has pushed an entry that hasn't been popped
+  // yet, including pushes still in progress. May only be called by the
+  // consumer.
+  bool empty() const {
+    return tail_.load() == head_;
+  }
+
+ private:
+  struct Node {
+    Node() = default;
+    explicit Node(T&& value) : value{std::move(value)} {
+    }
+
+    absl::optional<T> value;
+    std::atomic<Node*> next{nullptr};
+  };
+
+  Node* head_;
+  std::atomic<Node*> tail_;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_MPSC_QUEUE_H_
@@ -27,6 +27,7 @@
 #include <string>
 #include <type_traits>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
 #include "Firestore/core/src/firebase/firestore/util/to_string.h"
@@ -111,6 +112,14 @@ template <typename K,
           typename = absl::enable_if_t<is_objective_c_pointer<K>::value>>
 using unordered_map = std::unordered_map<K, V, Hash<K>, EqualTo<K>>;
 
+/**
+ * The equivalent of std::unordered_set, where the Key type is an Objective-C
+ * class.
+ */
+template <typename K,
+          typename = absl::enable_if_t<is_objective_c_pointer<K>::value>>
+using unordered_set = std::unordered_set<K, Hash<K>, EqualTo<K>>;
+
 /**
  * Creates a debug description of the given `value` by calling `ToString` on it,
  * converting the result to an `NSString`. Exists mainly to simplify writing
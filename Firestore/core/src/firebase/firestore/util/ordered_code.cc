@@ -22,6 +22,15 @@
 #include "absl/base/internal/unaligned_access.h"
 #include "absl/base/port.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FIRESTORE_ORDERED_CODE_SSE2 1
+#elif defined(__ARM_NEON) && !defined(__ARM_BIG_ENDIAN)
+#include <arm_neon.h>
+#define FIRESTORE_ORDERED_CODE_NEON 1
+#endif
+
 #define UNALIGNED_LOAD32 ABSL_INTERNAL_UNALIGNED_LOAD32
 #define UNALIGNED_LOAD64 ABSL_INTERNAL_UNALIGNED_LOAD64
 #define UNALIGNED_STORE32 ABSL_INTERNAL_UNALIGNED_STORE32
@@ -117,6 +126,53 @@ inline static int AdvanceIfNoSpecialBytes(uint32_t v_32, const char* p) {
   }
 }
 
+#if defined(FIRESTORE_ORDERED_CODE_SSE2) || defined(FIRESTORE_ORDERED_CODE_NEON)
+
+/** Returns the index of the lowest set bit of the (non-zero) `n`. */
+inline static int LowestSetBit(uint64_t n) {
+  return Bits::Log2FloorNonZero64(n & (~n + 1));
+}
+
+/**
+ * Advances "p" over the 16 byte blocks of "[p..limit)" that contain no special
+ * bytes, testing each block with a few vector instructions. Returns a pointer
+ * to the first special byte, or to the remaining bytes (fewer than 16) if
+ * there is none.
+ */
+inline static const char* SkipBlocksWithoutSpecialBytes(const char* p,
+                                                        const char* limit) {
+#if defined(FIRESTORE_ORDERED_CODE_SSE2)
+  const __m128i zeros = _mm_setzero_si128();
+  const __m128i ones = _mm_set1_epi8(static_cast<char>(0xff));
+  for (; p + 16 <= limit; p += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i special =
+        _mm_or_si128(_mm_cmpeq_epi8(v, zeros), _mm_cmpeq_epi8(v, ones));
+    // One bit per byte, set if the byte is special.
+    int mask = _mm_movemask_epi8(special);
+    if (mask != 0) {
+      return p + LowestSetBit(static_cast<uint64_t>(mask));
+    }
+  }
+#else
+  for (; p + 16 <= limit; p += 16) {
+    uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+    uint8x16_t special = vorrq_u8(vceqq_u8(v, vdupq_n_u8(0)),
+                                  vceqq_u8(v, vdupq_n_u8(0xff)));
+    // Narrowing each 16 bit lane with a shift leaves four bits per byte, set
+    // if the byte is special.
+    uint64_t mask = vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(special), 4)), 0);
+    if (mask != 0) {
+      return p + LowestSetBit(mask) / 4;
+    }
+  }
+#endif
+  return p;
+}
+
+#endif
+
 /**
  * Return a pointer to the first byte in the range "[start..limit)"
  * whose value is 0 or 255 (kEscape1 or kEscape2).  If no such byte
@@ -128,6 +184,14 @@ inline static const char* SkipToNextSpecialByte(const char* start,
   HARD_ASSERT(kEscape1 == 0);
   HARD_ASSERT((kEscape2 & 0xff) == 255);
   const char* p = start;
+#if defined(FIRESTORE_ORDERED_CODE_SSE2) || defined(FIRESTORE_ORDERED_CODE_NEON)
+  // Document IDs and canonical IDs are often long enough to be worth scanning
+  // 16 bytes at a time, leaving the rest to the word at a time loop below.
+  p = SkipBlocksWithoutSpecialBytes(p, limit);
+  if (p < limit && IsSpecialByte(*p)) {
+    return p;
+  }
+#endif
   while (p + 8 <= limit) {
     // Find out if any of the next 8 bytes are either 0 or 255 (our
     // two characters that require special handling).  We do this using
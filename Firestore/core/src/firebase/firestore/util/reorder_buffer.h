@@ -0,0 +1,107 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_REORDER_BUFFER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_REORDER_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/**
+ * Restores the original order of results that are produced out of order, for
+ * example by work that is fanned out to several threads.
+ *
+ * Each unit of work reserves a sequence number before it starts. When a result
+ * is completed, every result that has now become next in line is handed to the
+ * delivery function, in sequence order.
+ *
+ * ReorderBuffer is not thread-safe: reservations and completions must all
+ * happen on the same queue, typically the one that consumes the results.
+ */
+template <typename T>
+class ReorderBuffer {
+ public:
+  using Sequence = uint64_t;
+
+  /**
+   * Returns the sequence number for the next unit of work, which must later be
+   * passed to Complete.
+   */
+  Sequence Reserve() {
+    return next_reserved_++;
+  }
+
+  /**
+   * Records the result for the given sequence number, then delivers, in order,
+   * every result that no longer waits on an earlier one.
+   *
+   * Results for sequence numbers reserved before the most recent call to
+   * Clear are discarded. `deliver` may itself call Clear, in which case no
+   * further results are delivered.
+   *
+   * @param sequence A sequence number returned by Reserve.
+   * @param result The result of the unit of work.
+   * @param deliver A function accepting a `T&&`.
+   */
+  template <typename Deliver>
+  void Complete(Sequence sequence, T&& result, Deliver&& deliver) {
+    if (sequence < next_to_deliver_) {
+      return;
+    }
+    pending_.emplace(sequence, std::move(result));
+
+    while (!pending_.empty() && pending_.begin()->first == next_to_deliver_) {
+      T next = std::move(pending_.begin()->second);
+      pending_.erase(pending_.begin());
+      ++next_to_deliver_;
+      deliver(std::move(next));
+    }
+  }
+
+  /**
+   * Discards all pending results, and arranges for results of all work
+   * reserved so far to be discarded when they're completed.
+   */
+  void Clear() {
+    pending_.clear();
+    next_to_deliver_ = next_reserved_;
+  }
+
+  /**
+   * Returns the number of results that have been completed but are still
+   * waiting on an earlier result.
+   */
+  size_t pending_size() const {
+    return pending_.size();
+  }
+
+ private:
+  Sequence next_reserved_ = 0;
+  Sequence next_to_deliver_ = 0;
+  std::map<Sequence, T> pending_;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_REORDER_BUFFER_H_
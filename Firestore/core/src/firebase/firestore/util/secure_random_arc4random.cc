@@ -30,6 +30,10 @@ SecureRandom::result_type SecureRandom::operator()() {
   return arc4random();
 }
 
+void SecureRandom::Fill(uint8_t* bytes, size_t count) {
+  arc4random_buf(bytes, count);
+}
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
@@ -29,14 +29,18 @@ namespace util {
 
 SecureRandom::result_type SecureRandom::operator()() {
   result_type result;
-  int rc = RAND_bytes(reinterpret_cast<uint8_t*>(&result), sizeof(result));
+  Fill(reinterpret_cast<uint8_t*>(&result), sizeof(result));
+  return result;
+}
+
+void SecureRandom::Fill(uint8_t* bytes, size_t count) {
+  int rc = RAND_bytes(bytes, static_cast<int>(count));
   if (rc <= 0) {
     // OpenSSL's RAND_bytes can fail if there's not enough entropy. BoringSSL
     // won't fail this way.
     ERR_print_errors_fp(stderr);
     abort();
   }
-  return result;
 }
 
 }  // namespace util
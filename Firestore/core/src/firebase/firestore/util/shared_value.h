@@ -0,0 +1,109 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_SHARED_VALUE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_SHARED_VALUE_H_
+
+#include <atomic>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+// SharedValue<T> is an immutable T whose copies share a single instance that
+// is destroyed along with the last copy. Unlike std::shared_ptr<const T>, it
+// is the size of a single pointer and keeps the reference count in the same
+// allocation as the value, which matters for types that are stored in large
+// numbers, like the strings in a FieldValue.
+//
+// Copies may be created and destroyed concurrently from multiple threads.
+//
+// A default-constructed SharedValue is empty: it may only be assigned to or
+// destroyed.
+template <typename T>
+class SharedValue {
+ public:
+  SharedValue() = default;
+
+  explicit SharedValue(T value) : rep_(new Rep(std::move(value))) {
+  }
+
+  SharedValue(const SharedValue& other) : rep_(other.rep_) {
+    Retain();
+  }
+
+  SharedValue& operator=(const SharedValue& other) {
+    // Retain first, so that self-assignment doesn't destroy the value.
+    other.Retain();
+    Release();
+    rep_ = other.rep_;
+    return *this;
+  }
+
+  ~SharedValue() {
+    Release();
+  }
+
+  const T& get() const {
+    HARD_ASSERT(rep_, "Accessing an empty SharedValue");
+    return rep_->value;
+  }
+
+  const T& operator*() const {
+    return get();
+  }
+
+  const T* operator->() const {
+    return &get();
+  }
+
+  /** Returns true if both values share the same instance of T. */
+  bool SharesWith(const SharedValue& other) const {
+    return rep_ == other.rep_;
+  }
+
+ private:
+  struct Rep {
+    explicit Rep(T initial_value) : value(std::move(initial_value)) {
+    }
+
+    std::atomic<int> ref_count{1};
+    const T value;
+  };
+
+  void Retain() const {
+    if (rep_) {
+      rep_->ref_count.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  void Release() {
+    if (rep_ && rep_->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete rep_;
+    }
+  }
+
+  Rep* rep_ = nullptr;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_SHARED_VALUE_H_
@@ -38,6 +38,10 @@ namespace util {
 class PlatformError;
 
 /// Denotes success or failure of a call.
+///
+/// A Status is a single pointer, which is null on success: creating, copying
+/// and checking an OK Status never allocates. Only errors allocate their code
+/// and message.
 class ABSL_MUST_USE_RESULT Status {
  public:
   /// Create a success status.
@@ -50,7 +54,11 @@ class ABSL_MUST_USE_RESULT Status {
 
   /// Copy the specified status.
   Status(const Status& s);
-  void operator=(const Status& s);
+  Status& operator=(const Status& s);
+
+  /// Move the specified status, which is left OK.
+  Status(Status&& s) noexcept = default;
+  Status& operator=(Status&& s) noexcept = default;
 
   static Status OK() {
     return Status();
@@ -161,16 +169,26 @@ inline Status::State::State(const State& s)
                                                    : s.platform_error->Copy()) {
 }
 
-inline void Status::operator=(const Status& s) {
+static_assert(sizeof(Status) == sizeof(void*),
+              "Status should be no larger than a pointer");
+
+inline Status& Status::operator=(const Status& s) {
   // The following condition catches both aliasing (when this == &s),
   // and the common case where both s and *this are ok.
   if (state_ != s.state_) {
     SlowCopyFrom(s.state_.get());
   }
+  return *this;
 }
 
 inline bool Status::operator==(const Status& x) const {
-  return (this->state_ == x.state_) || (ToString() == x.ToString());
+  if (state_ == x.state_) {
+    return true;
+  }
+  if (ok() || x.ok()) {
+    return false;
+  }
+  return state_->code == x.state_->code && state_->msg == x.state_->msg;
 }
 
 inline bool Status::operator!=(const Status& x) const {
@@ -273,7 +273,7 @@ inline StatusOr<T>& StatusOr<T>::operator=(StatusOr<U>&& other) {
   if (other.ok()) {
     this->Assign(std::move(other).ValueOrDie());
   } else {
-    this->Assign(std::move(other).status());
+    this->Assign(other.status());
   }
   return *this;
 }
@@ -284,7 +284,9 @@ const Status& StatusOr<T>::status() const& {
 }
 template <typename T>
 Status StatusOr<T>::status() && {
-  return ok() ? Status::OK() : std::move(this->status_);
+  // Can't move from `status_`: a moved-from Status is OK, which would leave
+  // this StatusOr OK without a value.
+  return this->status_;
 }
 
 template <typename T>
@@ -66,12 +66,14 @@ class StatusOrData {
     }
   }
 
+  // The status of a failed `other` is copied rather than moved: a moved-from
+  // Status is OK, and `other` must stay failed since it holds no value.
   StatusOrData(StatusOrData&& other) noexcept {
     if (other.ok()) {
       MakeValue(std::move(other.data_));
       MakeStatus();
     } else {
-      MakeStatus(std::move(other.status_));
+      MakeStatus(other.status_);
     }
   }
 
@@ -91,7 +93,7 @@ class StatusOrData {
       MakeValue(std::move(other.data_));
       MakeStatus();
     } else {
-      MakeStatus(std::move(other.status_));
+      MakeStatus(other.status_);
     }
   }
 
@@ -123,7 +125,7 @@ class StatusOrData {
     if (other.ok())
       Assign(std::move(other.data_));
     else
-      Assign(std::move(other.status_));
+      Assign(other.status_);
     return *this;
   }
 
@@ -0,0 +1,171 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/tracing.h"
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>   // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
+#include "absl/strings/str_cat.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace internal {
+std::atomic<bool> tracing_enabled{false};
+}  // namespace internal
+
+namespace {
+
+namespace chr = std::chrono;
+
+using Clock = chr::steady_clock;
+
+// Bounds the memory taken by a trace that is left running; spans past this
+// limit are counted but not recorded.
+constexpr size_t kMaxTraceEvents = 1 << 20;
+
+struct TraceEvent {
+  const char* category;
+  const char* name;
+  int64_t start_micros;
+  int64_t duration_micros;
+  int thread_id;
+};
+
+struct Trace {
+  std::mutex mutex;
+  Clock::time_point origin;
+  std::vector<TraceEvent> events;
+  // Trace viewers expect small integer thread ids.
+  std::map<std::thread::id, int> thread_ids;
+  int64_t dropped_event_count = 0;
+};
+
+Trace& GetTrace() {
+  // Never destroyed, so that spans ending during static destruction are safe.
+  static Trace* trace = new Trace();
+  return *trace;
+}
+
+int64_t ToMicros(Clock::duration duration) {
+  return chr::duration_cast<chr::microseconds>(duration).count();
+}
+
+void AppendJsonString(std::string* out, const char* value) {
+  out->push_back('"');
+  for (const char* c = value; *c; ++c) {
+    switch (*c) {
+      case '"':
+        out->append("\\\"");
+        break;
+      case '\\':
+        out->append("\\\\");
+        break;
+      default:
+        if (static_cast<unsigned char>(*c) < 0x20) {
+          out->append(StringFormat("\\u%04x", static_cast<int>(*c)));
+        } else {
+          out->push_back(*c);
+        }
+    }
+  }
+  out->push_back('"');
+}
+
+}  // namespace
+
+void TracingStart() {
+  Trace& trace = GetTrace();
+  std::lock_guard<std::mutex> lock{trace.mutex};
+  trace.origin = Clock::now();
+  trace.events.clear();
+  trace.thread_ids.clear();
+  trace.dropped_event_count = 0;
+  internal::tracing_enabled = true;
+}
+
+void TracingStop() {
+  internal::tracing_enabled = false;
+}
+
+void TraceSpan::Record() const {
+  Clock::time_point end = Clock::now();
+
+  Trace& trace = GetTrace();
+  std::lock_guard<std::mutex> lock{trace.mutex};
+  // Spans started before the last `TracingStart` belong to a previous trace.
+  if (start_ < trace.origin) {
+    return;
+  }
+  if (trace.events.size() == kMaxTraceEvents) {
+    ++trace.dropped_event_count;
+    return;
+  }
+
+  auto inserted = trace.thread_ids.emplace(
+      std::this_thread::get_id(), static_cast<int>(trace.thread_ids.size()));
+  trace.events.push_back(TraceEvent{category_, name_,
+                                    ToMicros(start_ - trace.origin),
+                                    ToMicros(end - start_),
+                                    inserted.first->second});
+}
+
+std::string TracingToJson() {
+  Trace& trace = GetTrace();
+  std::lock_guard<std::mutex> lock{trace.mutex};
+
+  std::string result = "{\"traceEvents\":[";
+  for (size_t i = 0; i != trace.events.size(); ++i) {
+    const TraceEvent& event = trace.events[i];
+    if (i != 0) {
+      result.push_back(',');
+    }
+    result.append("\n{\"name\":");
+    AppendJsonString(&result, event.name);
+    result.append(",\"cat\":");
+    AppendJsonString(&result, event.category);
+    absl::StrAppend(&result, ",\"ph\":\"X\",\"ts\":", event.start_micros,
+                    ",\"dur\":", event.duration_micros,
+                    ",\"pid\":1,\"tid\":", event.thread_id, "}");
+  }
+  absl::StrAppend(&result, "\n],\"displayTimeUnit\":\"ms\",",
+                  "\"otherData\":{\"dropped_events\":\"",
+                  trace.dropped_event_count, "\"}}\n");
+  return result;
+}
+
+Status TracingWriteJson(const Path& path) {
+  std::ofstream file{path.native_value()};
+  file << TracingToJson();
+  file.close();
+  if (!file) {
+    return Status{FirestoreErrorCode::Unknown,
+                  StringFormat("Could not write trace to file at path '%s'",
+                               path.ToUtf8String())};
+  }
+  return Status::OK();
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_TRACING_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_TRACING_H_
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/util/path.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+// Tracing records spans of Firestore's internal operations across all threads
+// and exports them in the Chrome trace event format, which trace viewers such
+// as chrome://tracing and Perfetto can open.
+//
+// Tracing is off by default; while it is, a span costs a single relaxed atomic
+// load.
+
+// Discards any previously recorded spans and starts recording.
+void TracingStart();
+
+// Stops recording. The spans recorded so far are kept until the next
+// `TracingStart`.
+void TracingStop();
+
+namespace internal {
+extern std::atomic<bool> tracing_enabled;
+}  // namespace internal
+
+inline bool TracingIsEnabled() {
+  return internal::tracing_enabled.load(std::memory_order_relaxed);
+}
+
+// Returns the recorded spans as a Chrome trace event JSON document.
+std::string TracingToJson();
+
+// Writes `TracingToJson()` to the file at `path`, replacing it if it exists.
+Status TracingWriteJson(const Path& path);
+
+// Records the time between its construction and its destruction as a span,
+// provided tracing was enabled at construction. Use `TRACE_SPAN` rather than
+// instantiating this directly.
+class TraceSpan {
+ public:
+  // `category` and `name` must outlive the recorded trace; in practice they
+  // are string literals.
+  TraceSpan(const char* category, const char* name)
+      : category_{category}, name_{name}, enabled_{TracingIsEnabled()} {
+    if (enabled_) {
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+
+  ~TraceSpan() {
+    if (enabled_) {
+      Record();
+    }
+  }
+
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+ private:
+  void Record() const;
+
+  const char* category_;
+  const char* name_;
+  bool enabled_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#define FIRESTORE_TRACE_CONCAT_(a, b) a##b
+#define FIRESTORE_TRACE_CONCAT(a, b) FIRESTORE_TRACE_CONCAT_(a, b)
+
+// Traces the rest of the enclosing scope as a span named `name` in the given
+// `category`. Both must be string literals.
+#define TRACE_SPAN(category, name)       \
+  ::firebase::firestore::util::TraceSpan \
+  FIRESTORE_TRACE_CONCAT(_trace_span_, __LINE__)(category, name)
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_TRACING_H_
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/worker_pool.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+// The state of a single `ParallelFor` call, shared with the helper operations
+// it puts on the pool. Helpers that only start after the call has returned
+// find no chunks left and exit without touching `body`.
+struct ParallelForState {
+  ParallelForState(size_t count,
+                   size_t chunk_size,
+                   const std::function<void(size_t, size_t)>* body)
+      : count{count},
+        chunk_size{chunk_size},
+        chunk_count{(count + chunk_size - 1) / chunk_size},
+        body{body} {
+  }
+
+  // Claims and processes chunks until none are left.
+  void ProcessChunks() {
+    for (size_t chunk = next_chunk++; chunk < chunk_count;
+         chunk = next_chunk++) {
+      size_t begin = chunk * chunk_size;
+      (*body)(begin, std::min(begin + chunk_size, count));
+
+      std::lock_guard<std::mutex> lock{mutex};
+      if (++finished_chunks == chunk_count) {
+        cv.notify_one();
+      }
+    }
+  }
+
+  const size_t count;
+  const size_t chunk_size;
+  const size_t chunk_count;
+  const std::function<void(size_t, size_t)>* body;
+
+  std::atomic<size_t> next_chunk{0};
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  size_t finished_chunks = 0;
+};
+
+}  // namespace
+
+WorkerPool::WorkerPool() : WorkerPool{DefaultThreadCount()} {
+}
+
+WorkerPool::WorkerPool(const size_t thread_count) {
+  HARD_ASSERT(thread_count > 0, "A worker pool needs at least one thread");
+  for (size_t i = 0; i != thread_count; ++i) {
+    threads_.emplace_back(&WorkerPool::PollingThread, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    shutting_down_ = true;
+  }
+  cv_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+size_t WorkerPool::DefaultThreadCount() {
+  // `hardware_concurrency` returns 0 if the number of cores is unknown.
+  unsigned int cores = std::thread::hardware_concurrency();
+  return cores > 2 ? cores - 1 : 1;
+}
+
+void WorkerPool::Execute(Operation&& operation) {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    HARD_ASSERT(!shutting_down_,
+                "Cannot execute operations on a pool that is being destroyed");
+    pending_.push_back(std::move(operation));
+  }
+  cv_.notify_one();
+}
+
+void WorkerPool::ParallelFor(const size_t count,
+                             const size_t min_chunk_size,
+                             const std::function<void(size_t, size_t)>& body) {
+  if (count == 0) {
+    return;
+  }
+
+  // Aim for a few chunks per thread so that uneven chunks balance out.
+  size_t target_chunks = (thread_count() + 1) * 4;
+  size_t chunk_size =
+      std::max(std::max<size_t>(min_chunk_size, 1),
+               (count + target_chunks - 1) / target_chunks);
+  auto state = std::make_shared<ParallelForState>(count, chunk_size, &body);
+
+  size_t helpers = std::min(thread_count(), state->chunk_count - 1);
+  for (size_t i = 0; i != helpers; ++i) {
+    Execute([state] { state->ProcessChunks(); });
+  }
+  state->ProcessChunks();
+
+  std::unique_lock<std::mutex> lock{state->mutex};
+  state->cv.wait(lock, [&state] {
+    return state->finished_chunks == state->chunk_count;
+  });
+}
+
+void WorkerPool::PollingThread() {
+  while (true) {
+    Operation operation;
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      cv_.wait(lock, [this] { return shutting_down_ || !pending_.empty(); });
+      // Finish everything that was submitted before shutting down.
+      if (pending_.empty()) {
+        return;
+      }
+      operation = std::move(pending_.front());
+      pending_.pop_front();
+    }
+    operation();
+  }
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_WORKER_POOL_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_WORKER_POOL_H_
+
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+// A fixed number of background threads that run side-effect-free computations,
+// like decoding documents or matching a chunk of documents against a query,
+// in parallel with each other and with the `AsyncQueue`.
+//
+// Unlike operations on an `AsyncQueue`, operations on a `WorkerPool` run
+// concurrently and in no particular order, so they must not touch any state
+// owned by the queue. Results are handed back to the queue instead, see
+// `ExecuteThen`.
+//
+// Destroying the pool waits for all operations that were submitted to it to
+// finish.
+class WorkerPool {
+ public:
+  using Operation = std::function<void()>;
+
+  // Creates a pool with `DefaultThreadCount()` threads.
+  WorkerPool();
+  explicit WorkerPool(size_t thread_count);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  // One thread per core besides the one the `AsyncQueue` is expected to keep
+  // busy, but at least one.
+  static size_t DefaultThreadCount();
+
+  size_t thread_count() const {
+    return threads_.size();
+  }
+
+  // Runs `operation` on one of the pool's threads.
+  void Execute(Operation&& operation);
+
+  // Runs `work` on one of the pool's threads and then enqueues `callback` with
+  // the result of `work` on `queue`, which must outlive the pool.
+  template <typename Work, typename Callback>
+  void ExecuteThen(AsyncQueue* queue, Work work, Callback callback) {
+    Execute([queue, work, callback] {
+      using Result = decltype(work());
+      // Note: can't move `result` into the lambda until C++14.
+      auto result = std::make_shared<Result>(work());
+      queue->EnqueueRelaxed(
+          [callback, result] { callback(std::move(*result)); });
+    });
+  }
+
+  // Calls `body(begin, end)` for consecutive ranges that together cover
+  // [0, count), spreading them over the pool's threads and the calling thread,
+  // and returns once all calls have returned. Ranges contain at least
+  // `min_chunk_size` indices (except possibly the last one), to keep the
+  // overhead per range low.
+  //
+  // The calling thread processes ranges rather than just waiting for the pool,
+  // so `ParallelFor` makes progress even if all of the pool's threads are busy,
+  // including when called from an operation running on the pool.
+  void ParallelFor(size_t count,
+                   size_t min_chunk_size,
+                   const std::function<void(size_t, size_t)>& body);
+
+ private:
+  void PollingThread();
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Operation> pending_;
+  bool shutting_down_ = false;
+
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_WORKER_POOL_H_
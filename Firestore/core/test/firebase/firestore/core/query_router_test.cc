@@ -0,0 +1,101 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/query_router.h"
+
+#include <set>
+
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+using model::TargetId;
+using testutil::Key;
+using testutil::Resource;
+
+namespace {
+
+std::set<TargetId> TargetsAffectedBy(const QueryRouter& router,
+                                     absl::string_view path) {
+  std::set<TargetId> targets;
+  router.AddTargetsAffectedBy(Key(path), &targets);
+  return targets;
+}
+
+}  // namespace
+
+TEST(QueryRouterTest, RoutesToCollectionQueries) {
+  QueryRouter router;
+  router.AddQuery(2, Resource("rooms"), "");
+  router.AddQuery(4, Resource("rooms"), "");
+  router.AddQuery(6, Resource("rooms/eros/messages"), "");
+
+  EXPECT_EQ(TargetsAffectedBy(router, "rooms/eros"),
+            (std::set<TargetId>{2, 4}));
+  EXPECT_EQ(TargetsAffectedBy(router, "rooms/eros/messages/1"),
+            std::set<TargetId>{6});
+  EXPECT_EQ(TargetsAffectedBy(router, "rooms/other/messages/1"),
+            std::set<TargetId>{});
+  EXPECT_EQ(TargetsAffectedBy(router, "roomsx/eros"), std::set<TargetId>{});
+}
+
+TEST(QueryRouterTest, RoutesToDocumentQueries) {
+  QueryRouter router;
+  router.AddQuery(2, Resource("rooms/eros"), "");
+  router.AddQuery(4, Resource("rooms"), "");
+
+  EXPECT_EQ(TargetsAffectedBy(router, "rooms/eros"),
+            (std::set<TargetId>{2, 4}));
+  EXPECT_EQ(TargetsAffectedBy(router, "rooms/other"), std::set<TargetId>{4});
+}
+
+TEST(QueryRouterTest, RoutesToCollectionGroupQueries) {
+  QueryRouter router;
+  router.AddQuery(2, Resource(""), "messages");
+  router.AddQuery(4, Resource("rooms/eros"), "messages");
+
+  EXPECT_EQ(TargetsAffectedBy(router, "messages/1"), std::set<TargetId>{2});
+  EXPECT_EQ(TargetsAffectedBy(router, "rooms/eros/messages/1"),
+            (std::set<TargetId>{2, 4}));
+  EXPECT_EQ(TargetsAffectedBy(router, "rooms/other/messages/1"),
+            std::set<TargetId>{2});
+  EXPECT_EQ(TargetsAffectedBy(router, "rooms/eros"), std::set<TargetId>{});
+}
+
+TEST(QueryRouterTest, StopsRoutingToRemovedQueries) {
+  QueryRouter router;
+  router.AddQuery(2, Resource("rooms"), "");
+  router.AddQuery(4, Resource("rooms"), "");
+  router.AddQuery(6, Resource(""), "rooms");
+
+  router.RemoveQuery(2, Resource("rooms"), "");
+  EXPECT_EQ(TargetsAffectedBy(router, "rooms/eros"),
+            (std::set<TargetId>{4, 6}));
+
+  router.RemoveQuery(4, Resource("rooms"), "");
+  router.RemoveQuery(6, Resource(""), "rooms");
+  EXPECT_EQ(TargetsAffectedBy(router, "rooms/eros"), std::set<TargetId>{});
+
+  // Removing a query that isn't routed to is a no-op.
+  router.RemoveQuery(6, Resource(""), "rooms");
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/rate_limiter.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+namespace chr = std::chrono;
+
+using Clock = RateLimiter::Clock;
+using Milliseconds = RateLimiter::Milliseconds;
+
+TEST(RateLimiterTest, AllowsInitialRateRightAway) {
+  Clock::time_point start = Clock::now();
+  RateLimiter limiter{500, 10000, chr::minutes(5), start};
+
+  EXPECT_TRUE(limiter.TryMakeRequest(300, start));
+  EXPECT_TRUE(limiter.TryMakeRequest(200, start));
+  EXPECT_FALSE(limiter.TryMakeRequest(1, start));
+}
+
+TEST(RateLimiterTest, RefillsOverTime) {
+  Clock::time_point start = Clock::now();
+  RateLimiter limiter{500, 10000, chr::minutes(5), start};
+
+  EXPECT_TRUE(limiter.TryMakeRequest(500, start));
+  EXPECT_FALSE(limiter.TryMakeRequest(100, start + Milliseconds(100)));
+  EXPECT_TRUE(limiter.TryMakeRequest(100, start + Milliseconds(200)));
+
+  // The bucket never holds more than a second's worth of operations.
+  EXPECT_TRUE(limiter.TryMakeRequest(500, start + chr::seconds(10)));
+  EXPECT_FALSE(limiter.TryMakeRequest(1, start + chr::seconds(10)));
+}
+
+TEST(RateLimiterTest, ComputesDelayUntilNextRequest) {
+  Clock::time_point start = Clock::now();
+  RateLimiter limiter{500, 10000, chr::minutes(5), start};
+
+  EXPECT_EQ(limiter.GetNextRequestDelay(20, start), Milliseconds::zero());
+  EXPECT_TRUE(limiter.TryMakeRequest(500, start));
+  EXPECT_EQ(limiter.GetNextRequestDelay(20, start), Milliseconds(40));
+  EXPECT_EQ(limiter.GetNextRequestDelay(20, start + Milliseconds(40)),
+            Milliseconds::zero());
+}
+
+TEST(RateLimiterTest, RampsUpToMaxRate) {
+  Clock::time_point start = Clock::now();
+  RateLimiter limiter{500, 1000, chr::minutes(5), start};
+
+  EXPECT_EQ(limiter.GetOpsPerSecond(start), 500);
+  EXPECT_EQ(limiter.GetOpsPerSecond(start + chr::minutes(4)), 500);
+  EXPECT_EQ(limiter.GetOpsPerSecond(start + chr::minutes(5)), 750);
+  EXPECT_EQ(limiter.GetOpsPerSecond(start + chr::minutes(10)), 1000);
+  EXPECT_EQ(limiter.GetOpsPerSecond(start + chr::hours(10)), 1000);
+
+  // A full bucket at the higher rate holds more operations.
+  Clock::time_point later = start + chr::minutes(6);
+  EXPECT_TRUE(limiter.TryMakeRequest(500, later));
+  EXPECT_TRUE(limiter.TryMakeRequest(250, later));
+  EXPECT_FALSE(limiter.TryMakeRequest(1, later));
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
@@ -19,6 +19,7 @@
 #include <algorithm>
 #include <numeric>
 #include <random>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/util/secure_random.h"
 
@@ -50,6 +51,24 @@ TEST(ArraySortedMap, InitializerIsSorted) {
   EXPECT_TRUE(std::is_sorted(map.begin(), map.end()));
 }
 
+TEST(ArraySortedMap, LowerBoundMatchesStandardLowerBoundAtEverySize) {
+  for (int size = 0; size <= static_cast<int>(kFixedSize); ++size) {
+    // Even keys only, so that odd probes fall between entries.
+    std::vector<int> keys;
+    for (int i = 0; i < size; ++i) {
+      keys.push_back(i * 2);
+    }
+    IntMap map = ToMap<IntMap>(keys);
+
+    for (int probe = -1; probe <= size * 2; ++probe) {
+      auto expected = std::lower_bound(keys.begin(), keys.end(), probe);
+      auto actual = map.lower_bound(probe);
+      ASSERT_EQ(actual - map.begin(), expected - keys.begin())
+          << "size " << size << ", probe " << probe;
+    }
+  }
+}
+
 }  // namespace impl
 }  // namespace immutable
 }  // namespace firestore
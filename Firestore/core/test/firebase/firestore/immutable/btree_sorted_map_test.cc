@@ -0,0 +1,223 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/immutable/btree_sorted_map.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "Firestore/core/test/firebase/firestore/immutable/testing.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+using IntMap = BTreeSortedMap<int, int>;
+using Node = IntMap::node_type;
+using SizeType = SortedMapBase::size_type;
+
+namespace {
+
+/**
+ * Checks the structural invariants of the subtree rooted at `node` and
+ * returns its depth.
+ */
+int CheckInvariants(const Node& node, bool is_root) {
+  if (!is_root) {
+    EXPECT_GE(node.width(), Node::kMinWidth);
+  }
+  EXPECT_LE(node.width(), Node::kMaxWidth);
+
+  if (node.is_leaf()) {
+    EXPECT_EQ(node.width(), node.size());
+    return 1;
+  }
+
+  EXPECT_GE(node.width(), 2u);
+  int depth = CheckInvariants(node.child(0), false);
+  SizeType size = node.child(0).size();
+  for (SizeType i = 1; i < node.width(); ++i) {
+    EXPECT_EQ(depth, CheckInvariants(node.child(i), false))
+        << "All leaves must be at the same depth";
+    size += node.child(i).size();
+  }
+  EXPECT_EQ(size, node.size());
+  return depth + 1;
+}
+
+int Depth(const IntMap& map) {
+  return CheckInvariants(map.root(), true);
+}
+
+}  // namespace
+
+TEST(BTreeSortedMap, EmptySize) {
+  IntMap map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(0u, map.size());
+  EXPECT_TRUE(map.root().is_leaf());
+  EXPECT_EQ(map.begin(), map.end());
+}
+
+TEST(BTreeSortedMap, SplitsFullRoot) {
+  int n = static_cast<int>(Node::kMaxWidth);
+  IntMap map = ToMap<IntMap>(Sequence(n));
+  EXPECT_TRUE(map.root().is_leaf());
+  EXPECT_EQ(1, Depth(map));
+
+  map = map.insert(n, n);
+  EXPECT_FALSE(map.root().is_leaf());
+  EXPECT_EQ(2u, map.root().width());
+  EXPECT_EQ(2, Depth(map));
+  EXPECT_EQ(Pairs(Sequence(n + 1)), Collect(map));
+}
+
+TEST(BTreeSortedMap, MergesUnderfullNodes) {
+  int n = static_cast<int>(Node::kMaxWidth) + 1;
+  IntMap map = ToMap<IntMap>(Sequence(n));
+  ASSERT_EQ(2, Depth(map));
+
+  // Erasing from the lower half leaves it underfull, so it gets merged with
+  // its sibling and the tree shrinks back to a single leaf.
+  map = map.erase(0);
+  EXPECT_TRUE(map.root().is_leaf());
+  EXPECT_EQ(1, Depth(map));
+  EXPECT_EQ(Pairs(Sequence(1, n)), Collect(map));
+}
+
+TEST(BTreeSortedMap, InsertIsImmutable) {
+  IntMap original = ToMap<IntMap>(Sequence(1000));
+
+  IntMap modified = original.insert(1000, 1000).insert(5, -5).erase(500);
+  EXPECT_EQ(Pairs(Sequence(1000)), Collect(original));
+  EXPECT_EQ(1000u, modified.size());
+  EXPECT_TRUE(Found(modified, 5, -5));
+  EXPECT_TRUE(NotFound(modified, 500));
+}
+
+TEST(BTreeSortedMap, SharesUnmodifiedLeaves) {
+  IntMap original = ToMap<IntMap>(Sequence(1000));
+  IntMap modified = original.insert(1000, 1000);
+
+  // The first leaf is untouched by appending, so both versions of the tree
+  // point to the same entries.
+  const Node* original_leaf = &original.root();
+  const Node* modified_leaf = &modified.root();
+  while (!original_leaf->is_leaf()) {
+    original_leaf = &original_leaf->child(0);
+    modified_leaf = &modified_leaf->child(0);
+  }
+  EXPECT_EQ(&original_leaf->entry(0), &modified_leaf->entry(0));
+}
+
+TEST(BTreeSortedMap, EraseOfMissingKeySharesTree) {
+  IntMap original = ToMap<IntMap>(Sequence(0, 1000, 2));
+  IntMap erased = original.erase(501);
+  EXPECT_EQ(&original.root().child(0), &erased.root().child(0));
+}
+
+TEST(BTreeSortedMap, MaintainsInvariantsUnderRandomChanges) {
+  std::mt19937 rand;
+  std::uniform_int_distribution<int> keys(0, 4999);
+  std::bernoulli_distribution should_insert(0.6);
+
+  IntMap map;
+  std::map<int, int> expected;
+  for (int i = 0; i < 20000; ++i) {
+    int key = keys(rand);
+    if (should_insert(rand)) {
+      map = map.insert(key, i);
+      expected[key] = i;
+    } else {
+      map = map.erase(key);
+      expected.erase(key);
+    }
+
+    if (i % 1000 == 0) {
+      Depth(map);
+    }
+  }
+
+  Depth(map);
+  ASSERT_EQ(expected.size(), map.size());
+  std::vector<std::pair<int, int>> expected_entries{expected.begin(),
+                                                    expected.end()};
+  ASSERT_EQ(expected_entries, Collect(map));
+
+  SizeType index = 0;
+  for (const auto& entry : expected) {
+    ASSERT_EQ(index, map.find_index(entry.first));
+    ++index;
+  }
+}
+
+TEST(BTreeSortedMap, LowerBoundCrossesLeaves) {
+  IntMap map = ToMap<IntMap>(Sequence(0, 1000, 2));
+  for (int i = 0; i < 998; ++i) {
+    auto found = map.lower_bound(i);
+    ASSERT_NE(map.end(), found);
+    ASSERT_EQ(i % 2 == 0 ? i : i + 1, found->first);
+  }
+  EXPECT_EQ(map.end(), map.lower_bound(999));
+  EXPECT_EQ(998, map.max()->first);
+}
+
+TEST(BTreeSortedMap, InitializerIsSorted) {
+  IntMap map = IntMap::Create(
+      std::vector<IntMap::value_type>{{3, 0}, {2, 0}, {1, 0}}, {});
+
+  EXPECT_TRUE(std::is_sorted(map.begin(), map.end()));
+}
+
+TEST(BTreeSortedMap, FromSortedBuildsMinimalDepthTree) {
+  int width = static_cast<int>(Node::kMaxWidth);
+  for (int n : {0, 1, width, width + 1, 2 * width + 1, width * width,
+                width * width + 1, 40000}) {
+    IntMap map = IntMap::FromSorted(Pairs(Sequence(n)), {});
+
+    int leaves = std::max(1, (n + width - 1) / width);
+    int expected_depth = 1;
+    for (int nodes = leaves; nodes > 1; nodes = (nodes + width - 1) / width) {
+      ++expected_depth;
+    }
+    EXPECT_EQ(expected_depth, Depth(map)) << "n = " << n;
+    ASSERT_EQ(Pairs(Sequence(n)), Collect(map)) << "n = " << n;
+  }
+}
+
+TEST(BTreeSortedMap, FromSortedTreeSupportsChanges) {
+  IntMap map = IntMap::FromSorted(Pairs(Sequence(0, 2000, 2)), {});
+  for (int i = 1; i < 2000; i += 2) {
+    map = map.insert(i, i);
+  }
+  Depth(map);
+  ASSERT_EQ(Pairs(Sequence(2000)), Collect(map));
+
+  for (int i = 0; i < 2000; i += 2) {
+    map = map.erase(i);
+  }
+  Depth(map);
+  ASSERT_EQ(Pairs(Sequence(1, 2000, 2)), Collect(map));
+}
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
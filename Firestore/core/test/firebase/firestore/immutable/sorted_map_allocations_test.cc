@@ -0,0 +1,122 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
+
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/immutable/array_sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/immutable/btree_sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/immutable/tree_sorted_map.h"
+#include "Firestore/core/test/firebase/firestore/immutable/testing.h"
+#include "Firestore/core/test/firebase/firestore/testutil/allocation_counter.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+
+using testutil::AllocationCounter;
+
+template <typename MapType>
+struct AllocationTestPolicy {
+  static const int kLargeSize = 100;
+};
+
+template <>
+struct AllocationTestPolicy<impl::ArraySortedMap<int, int>> {
+  // ArraySortedMap cannot insert more than this number
+  static const int kLargeSize = static_cast<int>(SortedMapBase::kFixedSize);
+};
+
+template <>
+struct AllocationTestPolicy<impl::BTreeSortedMap<int, int>> {
+  // Large enough to require several levels of inner nodes.
+  static const int kLargeSize = 5000;
+};
+
+template <typename IntMap>
+class SortedMapAllocationsTest : public ::testing::Test {
+ public:
+  int large_number() const {
+    return AllocationTestPolicy<IntMap>::kLargeSize;
+  }
+};
+
+// NOLINTNEXTLINE: must be a typedef for the gtest macros
+typedef ::testing::Types<SortedMap<int, int>,
+                         impl::ArraySortedMap<int, int>,
+                         impl::BTreeSortedMap<int, int>,
+                         impl::TreeSortedMap<int, int>>
+    TestedTypes;
+TYPED_TEST_CASE(SortedMapAllocationsTest, TestedTypes);
+
+template <typename MapType>
+int64_t CountIterationAllocations(const MapType& map) {
+  AllocationCounter allocations;
+  int sum = 0;
+  for (const auto& entry : map) {
+    sum += entry.second;
+  }
+  EXPECT_GE(sum, 0);
+  return allocations.count();
+}
+
+TYPED_TEST(SortedMapAllocationsTest, IterationAllocationsDoNotGrowWithSize) {
+  // Iterators into tree-backed maps keep a stack of the ancestors of the
+  // current node, which is stored inline, so iterating never allocates no
+  // matter how large the map is.
+  TypeParam small = ToMap<TypeParam>(Sequence(1));
+  TypeParam large = ToMap<TypeParam>(Sequence(this->large_number()));
+  EXPECT_EQ(CountIterationAllocations(small), 0);
+  EXPECT_EQ(CountIterationAllocations(large), 0);
+}
+
+TYPED_TEST(SortedMapAllocationsTest, ForEachDoesNotAllocate) {
+  TypeParam map = ToMap<TypeParam>(Shuffled(Sequence(this->large_number())));
+
+  std::vector<int> actual;
+  actual.reserve(map.size());
+  AllocationCounter allocations;
+  map.ForEach([&](const std::pair<int, int>& entry) {
+    actual.push_back(entry.first);
+  });
+  EXPECT_EQ(allocations.count(), 0);
+}
+
+TEST(SortedMapAllocations, IteratesAndFindsWithoutAllocating) {
+  // Neither the array nor the B-tree representation allocates to iterate or
+  // look up keys, so walking a map must stay allocation-free.
+  for (int size : {10, 5000}) {
+    SortedMap<int, int> map = ToMap<SortedMap<int, int>>(Sequence(size));
+
+    AllocationCounter allocations;
+    int sum = 0;
+    for (const auto& entry : map) {
+      sum += entry.second;
+    }
+    for (int i = 0; i < size; ++i) {
+      sum -= map.find(i)->second;
+    }
+    EXPECT_EQ(allocations.count(), 0) << "size " << size;
+    EXPECT_EQ(sum, 0);
+  }
+}
+
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
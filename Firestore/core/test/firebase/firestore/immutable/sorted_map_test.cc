@@ -28,8 +28,10 @@
 #include <type_traits>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/immutable/array_sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/immutable/btree_sorted_map.h"
 #include "Firestore/core/src/firebase/firestore/immutable/tree_sorted_map.h"
 #include "Firestore/core/src/firebase/firestore/util/secure_random.h"
 
@@ -53,6 +55,12 @@ struct TestPolicy<impl::ArraySortedMap<int, int>> {
   static const SizeType kLargeSize = SortedMapBase::kFixedSize;
 };
 
+template <>
+struct TestPolicy<impl::BTreeSortedMap<int, int>> {
+  // Large enough to require several levels of inner nodes.
+  static const SizeType kLargeSize = 5000;
+};
+
 template <typename IntMap>
 class SortedMapTest : public ::testing::Test {
  public:
@@ -68,6 +76,7 @@ class SortedMapTest : public ::testing::Test {
 // NOLINTNEXTLINE: must be a typedef for the gtest macros
 typedef ::testing::Types<SortedMap<int, int>,
                          impl::ArraySortedMap<int, int>,
+                         impl::BTreeSortedMap<int, int>,
                          impl::TreeSortedMap<int, int>>
     TestedTypes;
 TYPED_TEST_CASE(SortedMapTest, TestedTypes);
@@ -268,6 +277,30 @@ TYPED_TEST(SortedMapTest, FindIndex) {
   ASSERT_EQ(5u, map.find_index(50));
 }
 
+TYPED_TEST(SortedMapTest, Nth) {
+  TypeParam empty;
+  ASSERT_EQ(empty.end(), empty.nth(0));
+
+  std::vector<int> to_insert = Sequence(this->large_number());
+  TypeParam map = ToMap<TypeParam>(Shuffled(to_insert));
+  for (int i : to_insert) {
+    auto found = map.nth(static_cast<size_t>(i));
+    ASSERT_NE(map.end(), found);
+    ASSERT_EQ(i, found->first);
+    ASSERT_EQ(static_cast<size_t>(i), map.find_index(found->first));
+  }
+  ASSERT_EQ(map.end(), map.nth(map.size()));
+
+  // Iterating from nth visits the remaining entries in order.
+  size_t start = map.size() / 2;
+  std::vector<int> expected{to_insert.begin() + start, to_insert.end()};
+  std::vector<int> actual;
+  for (auto iter = map.nth(start); iter != map.end(); ++iter) {
+    actual.push_back(iter->first);
+  }
+  ASSERT_EQ(expected, actual);
+}
+
 TYPED_TEST(SortedMapTest, MinMax) {
   TypeParam empty;
   auto min = empty.min();
@@ -341,6 +374,21 @@ TYPED_TEST(SortedMapTest, Iterates) {
   ASSERT_EQ(to_insert, actual);
 }
 
+TYPED_TEST(SortedMapTest, ForEach) {
+  std::vector<int> to_insert = Sequence(this->large_number());
+  TypeParam map = ToMap<TypeParam>(Shuffled(to_insert));
+
+  std::vector<int> actual;
+  actual.reserve(to_insert.size());
+  map.ForEach([&](const std::pair<int, int>& entry) {
+    actual.push_back(entry.first);
+  });
+  ASSERT_EQ(to_insert, actual);
+
+  TypeParam empty;
+  empty.ForEach([](const std::pair<int, int>&) { FAIL(); });
+}
+
 TYPED_TEST(SortedMapTest, IteratorsUsingRangeBasedForLoop) {
   std::vector<int> to_insert = Sequence(this->large_number());
   TypeParam map = ToMap<TypeParam>(to_insert);
@@ -472,6 +520,102 @@ TYPED_TEST(SortedMapTest, KeysIn) {
   ASSERT_SEQ_EQ(Seq(8, 14), map.keys_in(7, 13));   // in between to in between
 }
 
+TEST(SortedMap, BuilderBuildsEitherRepresentation) {
+  using IntMap = SortedMap<int, int>;
+  int fixed_size = static_cast<int>(SortedMapBase::kFixedSize);
+  for (int n : {0, 1, fixed_size, fixed_size + 1, 5000}) {
+    IntMap::Builder builder;
+    for (int i : Sequence(n)) {
+      builder.push_back(i, i);
+    }
+    ASSERT_EQ(static_cast<SizeType>(n), builder.size());
+
+    IntMap map = builder.Build();
+    EXPECT_EQ(0u, builder.size());
+    ASSERT_EQ(Pairs(Sequence(n)), Collect(map)) << "n = " << n;
+    EXPECT_TRUE(Found(map, n / 2, n / 2) || n == 0);
+
+    // The result behaves like any other map.
+    map = map.insert(n, n).erase(0);
+    ASSERT_EQ(Pairs(Sequence(1, n + 1)), Collect(map)) << "n = " << n;
+  }
+}
+
+TEST(SortedMap, BuilderRequiresIncreasingKeys) {
+  SortedMap<int, int>::Builder builder;
+  builder.push_back(2, 2);
+  EXPECT_ANY_THROW(builder.push_back(2, 3));
+  EXPECT_ANY_THROW(builder.push_back(1, 1));
+}
+
+TEST(SortedMap, InsertAllMatchesRepeatedInsert) {
+  using IntMap = SortedMap<int, int>;
+  std::mt19937 rand;
+  std::uniform_int_distribution<int> keys(0, 999);
+
+  // Batches range from tiny (inserted one at a time) to many times the size of
+  // the map (merged and rebuilt).
+  for (int map_size : {0, 10, 100, 1000}) {
+    for (int batch_size : {1, 5, 50, 2000}) {
+      IntMap original;
+      for (int i = 0; i < map_size; ++i) {
+        original = original.insert(keys(rand), -i);
+      }
+
+      std::vector<std::pair<int, int>> batch;
+      for (int i = 0; i < batch_size; ++i) {
+        batch.emplace_back(keys(rand), i);
+      }
+
+      IntMap expected = original;
+      for (const auto& entry : batch) {
+        expected = expected.insert(entry.first, entry.second);
+      }
+
+      IntMap actual = original.insert_all(batch);
+      ASSERT_EQ(Collect(expected), Collect(actual))
+          << "map_size = " << map_size << ", batch_size = " << batch_size;
+    }
+  }
+}
+
+TEST(SortedMap, InsertAllOfSortedMap) {
+  using IntMap = SortedMap<int, int>;
+  IntMap evens = ToMap<IntMap>(Sequence(0, 1000, 2));
+  IntMap odds = ToMap<IntMap>(Sequence(1, 1000, 2));
+  ASSERT_EQ(Pairs(Sequence(1000)), Collect(evens.insert_all(odds)));
+  ASSERT_EQ(Collect(evens), Collect(evens.insert_all(IntMap{})));
+}
+
+TEST(SortedMap, EraseAllMatchesRepeatedErase) {
+  using IntMap = SortedMap<int, int>;
+  std::mt19937 rand;
+  std::uniform_int_distribution<int> keys(0, 999);
+
+  for (int map_size : {0, 10, 100, 1000}) {
+    for (int batch_size : {1, 5, 50, 2000}) {
+      IntMap original;
+      for (int i = 0; i < map_size; ++i) {
+        original = original.insert(keys(rand), i);
+      }
+
+      std::vector<int> batch;
+      for (int i = 0; i < batch_size; ++i) {
+        batch.push_back(keys(rand));
+      }
+
+      IntMap expected = original;
+      for (int key : batch) {
+        expected = expected.erase(key);
+      }
+
+      IntMap actual = original.erase_all(batch);
+      ASSERT_EQ(Collect(expected), Collect(actual))
+          << "map_size = " << map_size << ", batch_size = " << batch_size;
+    }
+  }
+}
+
 }  // namespace immutable
 }  // namespace firestore
 }  // namespace firebase
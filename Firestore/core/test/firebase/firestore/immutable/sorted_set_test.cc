@@ -16,8 +16,13 @@
 
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_set.h"
 
+#include <algorithm>
+#include <iterator>
 #include <random>
+#include <string>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "Firestore/core/test/firebase/firestore/immutable/testing.h"
 
@@ -122,6 +127,28 @@ TEST(SortedSetTest, Iterator) {
   ASSERT_SEQ_EQ(all, set);
 }
 
+TEST(SortedSetTest, ForEach) {
+  std::vector<int> all = Sequence(kLargeNumber);
+  SortedSet<int> set = ToSet(Shuffled(all));
+
+  std::vector<int> actual;
+  set.ForEach([&](int value) { actual.push_back(value); });
+  ASSERT_EQ(all, actual);
+}
+
+TEST(SortedSetTest, Nth) {
+  std::vector<int> all = Sequence(kLargeNumber);
+  SortedSet<int> set = ToSet(Shuffled(all));
+
+  ASSERT_EQ(0, *set.nth(0));
+  ASSERT_EQ(kLargeNumber - 1, *set.nth(all.size() - 1));
+  ASSERT_EQ(set.end(), set.nth(all.size()));
+
+  std::vector<int> tail{all.begin() + 10, all.end()};
+  ASSERT_SEQ_EQ(tail, (util::range<SortedSet<int>::const_iterator>{
+                          set.nth(10), set.end()}));
+}
+
 TEST(SortedSetTest, ValuesFrom) {
   std::vector<int> all = Sequence(2, 42, 2);
   SortedSet<int> set = ToSet(Shuffled(all));
@@ -169,6 +196,90 @@ TEST(SortedSetTest, ValuesIn) {
   ASSERT_SEQ_EQ(Seq(8, 14), set.values_in(7, 13));   // in between to in between
 }
 
+TEST(SortedSetTest, Builder) {
+  SortedSet<int>::Builder builder;
+  for (int i : Sequence(kLargeNumber)) {
+    builder.push_back(i);
+  }
+  EXPECT_EQ(static_cast<SizeType>(kLargeNumber), builder.size());
+
+  SortedSet<int> set = builder.Build();
+  EXPECT_EQ(0u, builder.size());
+  EXPECT_EQ(ToSet(Sequence(kLargeNumber)), set);
+}
+
+TEST(SortedSetTest, BuilderMovesKeys) {
+  SortedSet<std::string>::Builder builder;
+  builder.reserve(3);
+  for (std::string key : {"a", "b", "c"}) {
+    builder.push_back(std::move(key));
+  }
+
+  SortedSet<std::string> set = builder.Build();
+  EXPECT_EQ((SortedSet<std::string>{"a", "b", "c"}), set);
+}
+
+TEST(SortedSetTest, InsertAllAndEraseAll) {
+  SortedSet<int> set = ToSet(Sequence(0, kLargeNumber, 2));
+  SortedSet<int> all = set.insert_all(Sequence(1, kLargeNumber, 2));
+  EXPECT_EQ(ToSet(Sequence(kLargeNumber)), all);
+
+  // Duplicates and keys that are already present are harmless.
+  EXPECT_EQ(all, all.insert_all(std::vector<int>{3, 3, 5}));
+
+  SortedSet<int> odds = all.erase_all(set);
+  EXPECT_EQ(ToSet(Sequence(1, kLargeNumber, 2)), odds);
+  EXPECT_EQ(odds, odds.erase_all(std::vector<int>{0, 2, kLargeNumber}));
+}
+
+TEST(SortedSetTest, UnionIntersectAndDifference) {
+  // Pairs of sets of similar sizes are merged, while pairs where one set is
+  // much smaller (or empty) take the paths that work key by key.
+  std::vector<std::vector<int>> operands{
+      Empty(),
+      Sequence(0, 10, 3),
+      Sequence(0, 1000, 2),
+      Sequence(0, 1000, 3),
+      Sequence(500, 600),
+  };
+
+  for (const std::vector<int>& lhs_keys : operands) {
+    for (const std::vector<int>& rhs_keys : operands) {
+      SortedSet<int> lhs = ToSet(lhs_keys);
+      SortedSet<int> rhs = ToSet(rhs_keys);
+
+      std::vector<int> expected;
+      std::set_union(lhs_keys.begin(), lhs_keys.end(), rhs_keys.begin(),
+                     rhs_keys.end(), std::back_inserter(expected));
+      EXPECT_EQ(ToSet(expected), lhs.Union(rhs));
+
+      expected.clear();
+      std::set_intersection(lhs_keys.begin(), lhs_keys.end(),
+                            rhs_keys.begin(), rhs_keys.end(),
+                            std::back_inserter(expected));
+      EXPECT_EQ(ToSet(expected), lhs.Intersect(rhs));
+
+      expected.clear();
+      std::set_difference(lhs_keys.begin(), lhs_keys.end(), rhs_keys.begin(),
+                          rhs_keys.end(), std::back_inserter(expected));
+      EXPECT_EQ(ToSet(expected), lhs.Difference(rhs));
+    }
+  }
+}
+
+TEST(SortedSetTest, SetAlgebraReturnsOperandsWhenUnchanged) {
+  SortedSet<int> evens = ToSet(Sequence(0, 1000, 2));
+  SortedSet<int> some_evens = ToSet(Sequence(0, 1000, 4));
+  SortedSet<int> odds = ToSet(Sequence(1, 1000, 2));
+
+  auto same = [](const SortedSet<int>& lhs, const SortedSet<int>& rhs) {
+    return &*lhs.begin() == &*rhs.begin();
+  };
+  EXPECT_TRUE(same(evens, evens.Union(some_evens)));
+  EXPECT_TRUE(same(some_evens, evens.Intersect(some_evens)));
+  EXPECT_TRUE(same(evens, evens.Difference(odds)));
+}
+
 TEST(SortedSetTest, HashesStdHashable) {
   SortedSet<int> set;
 
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/bundle.h"
+
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/nanopb/wire_writer.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using model::DocumentKey;
+using nanopb::WireWriter;
+
+TEST(BundleTest, ReadsWhatWasWritten) {
+  BundleWriter writer;
+  writer.AddDocument("document 1");
+  writer.AddQuery("all rooms", "target",
+                  {testutil::Key("rooms/a"), testutil::Key("rooms/b")});
+  writer.AddDocument("document 2");
+
+  BundleReader reader{writer.bundle()};
+  ASSERT_TRUE(reader.Next());
+  ASSERT_EQ(BundleReader::ElementType::Document, reader.type());
+  EXPECT_EQ("document 1", reader.document());
+
+  ASSERT_TRUE(reader.Next());
+  ASSERT_EQ(BundleReader::ElementType::Query, reader.type());
+  EXPECT_EQ("all rooms", reader.query().name);
+  EXPECT_EQ("target", reader.query().target);
+  std::vector<DocumentKey> expected_keys{testutil::Key("rooms/a"),
+                                         testutil::Key("rooms/b")};
+  EXPECT_EQ(expected_keys, reader.query().matching_keys);
+
+  ASSERT_TRUE(reader.Next());
+  ASSERT_EQ(BundleReader::ElementType::Document, reader.type());
+  EXPECT_EQ("document 2", reader.document());
+
+  EXPECT_FALSE(reader.Next());
+  EXPECT_TRUE(reader.status().ok());
+}
+
+TEST(BundleTest, ReadsEmptyBundles) {
+  BundleReader reader{BundleWriter{}.bundle()};
+  EXPECT_FALSE(reader.Next());
+  EXPECT_TRUE(reader.status().ok());
+}
+
+TEST(BundleTest, SkipsUnknownElements) {
+  BundleWriter writer;
+  std::string bundle = writer.bundle();
+  WireWriter wire_writer{&bundle};
+  wire_writer.WriteTag(7, PB_WT_STRING);
+  wire_writer.WriteLengthDelimited("from the future");
+  wire_writer.WriteTag(1, PB_WT_STRING);
+  wire_writer.WriteLengthDelimited("document");
+
+  BundleReader reader{bundle};
+  ASSERT_TRUE(reader.Next());
+  EXPECT_EQ("document", reader.document());
+  EXPECT_FALSE(reader.Next());
+  EXPECT_TRUE(reader.status().ok());
+}
+
+TEST(BundleTest, RejectsOtherFiles) {
+  BundleReader reader{"not a bundle at all"};
+  EXPECT_FALSE(reader.Next());
+  EXPECT_EQ(FirestoreErrorCode::DataLoss, reader.status().code());
+}
+
+TEST(BundleTest, RejectsTruncatedBundles) {
+  BundleWriter writer;
+  writer.AddDocument("document 1");
+  writer.AddDocument("document 2");
+  std::string bundle = writer.bundle();
+  bundle.pop_back();
+
+  BundleReader reader{bundle};
+  ASSERT_TRUE(reader.Next());
+  EXPECT_FALSE(reader.Next());
+  EXPECT_EQ(FirestoreErrorCode::DataLoss, reader.status().code());
+}
+
+TEST(BundleTest, RejectsInvalidDocumentKeys) {
+  for (const char* path : {"rooms", "rooms//a", ""}) {
+    BundleWriter writer;
+    std::string query;
+    WireWriter query_writer{&query};
+    query_writer.WriteTag(2, PB_WT_STRING);
+    query_writer.WriteLengthDelimited("target");
+    query_writer.WriteTag(3, PB_WT_STRING);
+    query_writer.WriteLengthDelimited(path);
+
+    std::string bundle = writer.bundle();
+    WireWriter wire_writer{&bundle};
+    wire_writer.WriteTag(2, PB_WT_STRING);
+    wire_writer.WriteLengthDelimited(query);
+
+    BundleReader reader{bundle};
+    EXPECT_FALSE(reader.Next()) << path;
+    EXPECT_EQ(FirestoreErrorCode::DataLoss, reader.status().code()) << path;
+  }
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
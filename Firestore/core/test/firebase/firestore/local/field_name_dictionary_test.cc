@@ -0,0 +1,187 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/field_name_dictionary.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/nanopb/wire_writer.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+using nanopb::WireWriter;
+
+std::string Field(uint32_t field_number, const std::string& contents) {
+  std::string result;
+  WireWriter writer{&result};
+  writer.WriteTag(field_number, PB_WT_STRING);
+  writer.WriteLengthDelimited(contents);
+  return result;
+}
+
+std::string IntegerValue(int64_t value) {
+  std::string result;
+  WireWriter writer{&result};
+  writer.WriteTag(2, PB_WT_VARINT);
+  writer.WriteVarint(static_cast<uint64_t>(value));
+  return result;
+}
+
+std::string StringValue(const std::string& value) {
+  return Field(17, value);
+}
+
+/** A map<string, Value> entry, of a Document or a MapValue. */
+std::string Entry(const std::string& key, const std::string& value) {
+  return Field(1, key) + Field(2, value);
+}
+
+std::string MapValue(const std::vector<std::string>& entries) {
+  std::string map;
+  for (const std::string& entry : entries) {
+    map += Field(1, entry);
+  }
+  return Field(6, map);
+}
+
+std::string ArrayValue(const std::vector<std::string>& values) {
+  std::string array;
+  for (const std::string& value : values) {
+    array += Field(1, value);
+  }
+  return Field(9, array);
+}
+
+/** A MaybeDocument holding a Document with the given fields. */
+std::string EncodedDocument(const std::string& name,
+                            const std::vector<std::string>& entries) {
+  std::string document = Field(1, name);
+  for (const std::string& entry : entries) {
+    document += Field(2, entry);
+  }
+  // update_time { seconds: 42 }
+  document += Field(4, "\x08\x2a");
+  return Field(2, document);
+}
+
+std::string NestedDocument() {
+  std::string stats = MapValue({Entry("visits", IntegerValue(42)),
+                                Entry("name", StringValue("nested"))});
+  std::string tags = ArrayValue(
+      {StringValue("a"), MapValue({Entry("visits", IntegerValue(-1))})});
+  return EncodedDocument("projects/p/databases/d/documents/rooms/eros",
+                         {Entry("name", StringValue("Eros")),
+                          Entry("stats", stats), Entry("tags", tags)});
+}
+
+}  // namespace
+
+TEST(FieldNameDictionaryTest, RoundTripsDocuments) {
+  FieldNameDictionary dictionary;
+  std::string encoded = NestedDocument();
+
+  absl::optional<std::string> compact =
+      CompactMaybeDocument(encoded, &dictionary);
+  ASSERT_TRUE(compact.has_value());
+  EXPECT_TRUE(IsCompactMaybeDocument(*compact));
+  EXPECT_FALSE(IsCompactMaybeDocument(encoded));
+
+  // Each distinct name is only stored once, at any level of nesting.
+  EXPECT_EQ(4u, dictionary.size());
+
+  absl::optional<std::string> expanded =
+      ExpandMaybeDocument(*compact, dictionary);
+  ASSERT_TRUE(expanded.has_value());
+  EXPECT_EQ(encoded, *expanded);
+}
+
+TEST(FieldNameDictionaryTest, SharesNamesAcrossDocuments) {
+  FieldNameDictionary dictionary;
+  ASSERT_TRUE(CompactMaybeDocument(NestedDocument(), &dictionary).has_value());
+
+  std::vector<std::pair<uint32_t, std::string>> expected_names = {
+      {0, "name"}, {1, "stats"}, {2, "visits"}, {3, "tags"}};
+  EXPECT_EQ(expected_names, dictionary.TakeNewNames());
+
+  std::string second = EncodedDocument(
+      "projects/p/databases/d/documents/rooms/other",
+      {Entry("name", StringValue("Other")), Entry("stats", MapValue({}))});
+  absl::optional<std::string> compact =
+      CompactMaybeDocument(second, &dictionary);
+  ASSERT_TRUE(compact.has_value());
+  EXPECT_TRUE(dictionary.TakeNewNames().empty());
+  EXPECT_LT(compact->size(), second.size());
+  EXPECT_EQ(second, ExpandMaybeDocument(*compact, dictionary));
+}
+
+TEST(FieldNameDictionaryTest, ContinuesFromLoadedNames) {
+  FieldNameDictionary dictionary;
+  dictionary.Load(0, "name");
+  dictionary.Load(5, "stats");
+
+  EXPECT_EQ(0u, dictionary.Intern("name"));
+  EXPECT_EQ(6u, dictionary.Intern("visits"));
+  ASSERT_NE(nullptr, dictionary.Find(5));
+  EXPECT_EQ("stats", *dictionary.Find(5));
+  EXPECT_EQ(nullptr, dictionary.Find(1));
+
+  std::vector<std::pair<uint32_t, std::string>> expected_names = {
+      {6, "visits"}};
+  EXPECT_EQ(expected_names, dictionary.TakeNewNames());
+}
+
+TEST(FieldNameDictionaryTest, PassesThroughOtherDocuments) {
+  // NoDocument { name: "...", read_time { seconds: 42 } }
+  std::string no_document =
+      Field(1, Field(1, "projects/p/databases/d/documents/rooms/eros") +
+                   Field(2, "\x08\x2a"));
+
+  FieldNameDictionary dictionary;
+  absl::optional<std::string> compact =
+      CompactMaybeDocument(no_document, &dictionary);
+  ASSERT_TRUE(compact.has_value());
+  EXPECT_EQ(0u, dictionary.size());
+  EXPECT_EQ(no_document, ExpandMaybeDocument(*compact, dictionary));
+}
+
+TEST(FieldNameDictionaryTest, RejectsUnknownIds) {
+  FieldNameDictionary dictionary;
+  absl::optional<std::string> compact =
+      CompactMaybeDocument(NestedDocument(), &dictionary);
+  ASSERT_TRUE(compact.has_value());
+
+  FieldNameDictionary empty;
+  EXPECT_EQ(absl::nullopt, ExpandMaybeDocument(*compact, empty));
+  EXPECT_EQ(absl::nullopt, ExpandMaybeDocument(NestedDocument(), dictionary));
+}
+
+TEST(FieldNameDictionaryTest, RejectsMalformedInput) {
+  FieldNameDictionary dictionary;
+  std::string truncated = NestedDocument();
+  truncated.pop_back();
+  EXPECT_EQ(absl::nullopt, CompactMaybeDocument(truncated, &dictionary));
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
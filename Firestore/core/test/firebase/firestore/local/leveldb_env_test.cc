@@ -0,0 +1,115 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_env.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "leveldb/slice.h"
+#include "leveldb/status.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+/** Writes `contents` to a file in a test directory and returns its name. */
+std::string WriteFile(leveldb::Env* env, const std::string& contents) {
+  std::string directory;
+  EXPECT_TRUE(env->GetTestDirectory(&directory).ok());
+  std::string filename = directory + "/leveldb_env_test";
+
+  leveldb::WritableFile* file = nullptr;
+  EXPECT_TRUE(env->NewWritableFile(filename, &file).ok());
+  std::unique_ptr<leveldb::WritableFile> owned_file{file};
+  EXPECT_TRUE(file->Append(contents).ok());
+  EXPECT_TRUE(file->Close().ok());
+  return filename;
+}
+
+}  // namespace
+
+TEST(LevelDbEnvTest, ReadsFiles) {
+  leveldb::Env* env = MobileLevelDbEnv();
+  std::string filename = WriteFile(env, "0123456789");
+
+  leveldb::RandomAccessFile* file = nullptr;
+  ASSERT_TRUE(env->NewRandomAccessFile(filename, &file).ok());
+  std::unique_ptr<leveldb::RandomAccessFile> owned_file{file};
+
+  char scratch[10];
+  leveldb::Slice result;
+  ASSERT_TRUE(file->Read(2, 5, &result, scratch).ok());
+  EXPECT_EQ("23456", result.ToString());
+  ASSERT_TRUE(file->Read(0, 10, &result, scratch).ok());
+  EXPECT_EQ("0123456789", result.ToString());
+  EXPECT_FALSE(file->Read(8, 5, &result, scratch).ok());
+
+  EXPECT_TRUE(env->DeleteFile(filename).ok());
+}
+
+TEST(LevelDbEnvTest, ReadsEmptyFiles) {
+  leveldb::Env* env = MobileLevelDbEnv();
+  std::string filename = WriteFile(env, "");
+
+  leveldb::RandomAccessFile* file = nullptr;
+  ASSERT_TRUE(env->NewRandomAccessFile(filename, &file).ok());
+  std::unique_ptr<leveldb::RandomAccessFile> owned_file{file};
+
+  char scratch[1];
+  leveldb::Slice result;
+  file->Read(0, 1, &result, scratch);
+  EXPECT_TRUE(result.empty());
+
+  EXPECT_TRUE(env->DeleteFile(filename).ok());
+}
+
+TEST(LevelDbEnvTest, FailsToOpenMissingFiles) {
+  leveldb::RandomAccessFile* file = nullptr;
+  EXPECT_FALSE(MobileLevelDbEnv()
+                   ->NewRandomAccessFile("/nonexistent/leveldb_env_test", &file)
+                   .ok());
+}
+
+TEST(LevelDbEnvTest, SchedulesBackgroundWork) {
+  struct Work {
+    std::mutex mutex;
+    std::condition_variable done;
+    bool ran = false;
+  } work;
+
+  MobileLevelDbEnv()->Schedule(
+      [](void* arg) {
+        auto* work = static_cast<Work*>(arg);
+        std::lock_guard<std::mutex> lock{work->mutex};
+        work->ran = true;
+        work->done.notify_one();
+      },
+      &work);
+
+  std::unique_lock<std::mutex> lock{work.mutex};
+  work.done.wait(lock, [&] { return work.ran; });
+  EXPECT_TRUE(work.ran);
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
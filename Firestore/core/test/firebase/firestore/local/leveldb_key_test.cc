@@ -24,6 +24,7 @@
 
 using firebase::firestore::model::BatchId;
 using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::FieldPath;
 using firebase::firestore::model::TargetId;
 
 namespace firebase {
@@ -46,6 +47,13 @@ std::string DocMutationKey(absl::string_view user_id,
   return LevelDbDocumentMutationKey::Key(user_id, testutil::Key(key), batch_id);
 }
 
+std::string CollectionMutationKey(absl::string_view user_id,
+                                  absl::string_view collection_path,
+                                  model::BatchId batch_id) {
+  return LevelDbCollectionMutationKey::Key(
+      user_id, testutil::Resource(collection_path), batch_id);
+}
+
 std::string TargetDocKey(TargetId target_id, absl::string_view key) {
   return LevelDbTargetDocumentKey::Key(target_id, testutil::Key(key));
 }
@@ -54,6 +62,23 @@ std::string DocTargetKey(absl::string_view key, TargetId target_id) {
   return LevelDbDocumentTargetKey::Key(testutil::Key(key), target_id);
 }
 
+std::string DocTargetSetKey(absl::string_view key) {
+  return LevelDbDocumentTargetSetKey::Key(testutil::Key(key));
+}
+
+std::string FieldIndexEntryKey(absl::string_view field,
+                               absl::string_view index_value,
+                               absl::string_view key) {
+  return LevelDbFieldIndexEntryKey::Key(testutil::Field(field), index_value,
+                                        testutil::Key(key));
+}
+
+std::string FieldIndexEntryKeyPrefix(absl::string_view collection_path,
+                                     absl::string_view field) {
+  return LevelDbFieldIndexEntryKey::KeyPrefix(
+      testutil::Resource(collection_path), testutil::Field(field));
+}
+
 }  // namespace
 
 /**
@@ -208,6 +233,118 @@ TEST(LevelDbDocumentMutationKeyTest, Description) {
       "[document_mutation: user_id=user1 path=foo/bar batch_id=42]", key);
 }
 
+TEST(LevelDbCollectionMutationKeyTest, Prefixing) {
+  auto table_key = LevelDbCollectionMutationKey::KeyPrefix();
+  auto foo_user_key = LevelDbCollectionMutationKey::KeyPrefix("foo");
+  auto foo_bar_key = LevelDbCollectionMutationKey::KeyPrefix("foo", "bar");
+  auto top_level_key =
+      LevelDbCollectionMutationKey::KeyPrefix("foo", testutil::Resource("bar"));
+
+  auto top_level2_key = CollectionMutationKey("foo", "bar", 2);
+  auto nested2_key = CollectionMutationKey("foo", "a/b/bar", 2);
+
+  ASSERT_TRUE(absl::StartsWith(foo_user_key, table_key));
+  ASSERT_TRUE(absl::StartsWith(foo_bar_key, foo_user_key));
+  ASSERT_TRUE(absl::StartsWith(top_level_key, foo_bar_key));
+
+  ASSERT_TRUE(absl::StartsWith(top_level2_key, top_level_key));
+  ASSERT_TRUE(absl::StartsWith(nested2_key, foo_bar_key));
+
+  // The prefix for a collection also covers same-named collections below it,
+  // which readers must skip by comparing the decoded parent.
+  ASSERT_TRUE(absl::StartsWith(nested2_key, top_level_key));
+  ASSERT_FALSE(absl::StartsWith(
+      top_level2_key, LevelDbCollectionMutationKey::KeyPrefix(
+                          "foo", testutil::Resource("a/b/bar"))));
+
+  // Partial segments in common must not be prefixes.
+  ASSERT_FALSE(absl::StartsWith(CollectionMutationKey("foo", "barbaz", 2),
+                                foo_bar_key));
+}
+
+TEST(LevelDbCollectionMutationKeyTest, EncodeDecodeCycle) {
+  LevelDbCollectionMutationKey key;
+  std::string user("foo");
+
+  std::vector<model::ResourcePath> collection_paths{
+      testutil::Resource("a"), testutil::Resource("a/b/c"),
+      testutil::Resource("a/b/c/d/e")};
+
+  std::vector<BatchId> batch_ids{0, 1, 100, INT_MAX - 1, INT_MAX};
+
+  for (BatchId batch_id : batch_ids) {
+    for (auto&& collection_path : collection_paths) {
+      auto encoded =
+          LevelDbCollectionMutationKey::Key(user, collection_path, batch_id);
+
+      bool ok = key.Decode(encoded);
+      ASSERT_TRUE(ok);
+      ASSERT_EQ(user, key.user_id());
+      ASSERT_EQ(collection_path.last_segment(), key.collection_id());
+      ASSERT_EQ(collection_path.PopLast(), key.parent());
+      ASSERT_EQ(batch_id, key.batch_id());
+    }
+  }
+}
+
+TEST(LevelDbCollectionMutationKeyTest, Ordering) {
+  // Different user:
+  ASSERT_LT(CollectionMutationKey("1", "foo", 0),
+            CollectionMutationKey("2", "foo", 0));
+
+  // Different collection_id:
+  ASSERT_LT(CollectionMutationKey("1", "z/y/bar", 0),
+            CollectionMutationKey("1", "foo", 0));
+
+  // Different parents, where the top-level collection sorts first:
+  ASSERT_LT(CollectionMutationKey("1", "foo", 5),
+            CollectionMutationKey("1", "a/b/foo", 0));
+  ASSERT_LT(CollectionMutationKey("1", "a/b/foo", 0),
+            CollectionMutationKey("1", "a/c/foo", 0));
+
+  // Different batch_id:
+  ASSERT_LT(CollectionMutationKey("1", "a/b/foo", 0),
+            CollectionMutationKey("1", "a/b/foo", 1));
+}
+
+TEST(LevelDbCollectionMutationKeyTest, Description) {
+  AssertExpectedKeyDescription("[collection_mutation: incomplete key]",
+                               LevelDbCollectionMutationKey::KeyPrefix());
+
+  AssertExpectedKeyDescription(
+      "[collection_mutation: user_id=user1 collection_id=foo incomplete key]",
+      LevelDbCollectionMutationKey::KeyPrefix("user1", "foo"));
+
+  auto key = CollectionMutationKey("user1", "a/b/foo", 42);
+  AssertExpectedKeyDescription(
+      "[collection_mutation: user_id=user1 collection_id=foo path=a/b "
+      "batch_id=42]",
+      key);
+}
+
+TEST(LevelDbMigrationProgressKeyTest, EncodeDecodeCycle) {
+  LevelDbMigrationProgressKey key;
+
+  for (int32_t schema_version : {6, 8}) {
+    auto encoded = LevelDbMigrationProgressKey::Key(schema_version);
+    bool ok = key.Decode(encoded);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(schema_version, key.schema_version());
+  }
+}
+
+TEST(LevelDbMigrationProgressKeyTest, Prefixing) {
+  ASSERT_TRUE(absl::StartsWith(LevelDbMigrationProgressKey::Key(6),
+                               LevelDbMigrationProgressKey::KeyPrefix()));
+  ASSERT_LT(LevelDbMigrationProgressKey::Key(6),
+            LevelDbMigrationProgressKey::Key(8));
+}
+
+TEST(LevelDbMigrationProgressKeyTest, Description) {
+  AssertExpectedKeyDescription("[migration_progress: schema_version=8]",
+                               LevelDbMigrationProgressKey::Key(8));
+}
+
 TEST(LevelDbTargetGlobalKeyTest, EncodeDecodeCycle) {
   LevelDbTargetGlobalKey key;
 
@@ -311,6 +448,118 @@ TEST(DocumentTargetKeyTest, Ordering) {
   ASSERT_LT(DocTargetKey("foo/bar", 42), DocTargetKey("foo/bar", 100));
 }
 
+TEST(DocumentTargetSetKeyTest, EncodeDecodeCycle) {
+  LevelDbDocumentTargetSetKey key;
+
+  auto encoded = DocTargetSetKey("foo/bar");
+  ASSERT_TRUE(key.Decode(encoded));
+  ASSERT_EQ(testutil::Key("foo/bar"), key.document_key());
+  ASSERT_FALSE(key.Decode(DocTargetKey("foo/bar", 42)));
+}
+
+TEST(DocumentTargetSetKeyTest, Description) {
+  ASSERT_EQ("[document_target_set: path=foo/bar]",
+            DescribeKey(DocTargetSetKey("foo/bar")));
+}
+
+TEST(DocumentTargetSetKeyTest, Ordering) {
+  ASSERT_LT(DocTargetSetKey("foo/bar"), DocTargetSetKey("foo/baz"));
+  ASSERT_LT(DocTargetSetKey("foo/bar"), DocTargetSetKey("foo/bar2"));
+  ASSERT_LT(DocTargetSetKey("foo/bar"), DocTargetSetKey("foo/bar/suffix/key"));
+  ASSERT_LT(DocTargetSetKey("foo/bar/suffix/key"), DocTargetSetKey("foo/bar2"));
+
+  // The tables are disjoint even though one name is a prefix of the other.
+  ASSERT_FALSE(absl::StartsWith(LevelDbDocumentTargetSetKey::KeyPrefix(),
+                                LevelDbDocumentTargetKey::KeyPrefix()));
+}
+
+TEST(TargetSequenceKeyTest, EncodeDecodeCycle) {
+  LevelDbTargetSequenceKey key;
+
+  auto encoded = LevelDbTargetSequenceKey::Key(1234, 42);
+  ASSERT_TRUE(key.Decode(encoded));
+  ASSERT_EQ(1234, key.sequence_number());
+  ASSERT_EQ(42, key.target_id());
+}
+
+TEST(TargetSequenceKeyTest, Ordering) {
+  // Sequence numbers order the rows ahead of target IDs.
+  ASSERT_LT(LevelDbTargetSequenceKey::Key(1, 100),
+            LevelDbTargetSequenceKey::Key(2, 1));
+  ASSERT_LT(LevelDbTargetSequenceKey::Key(9, 1),
+            LevelDbTargetSequenceKey::Key(10, 1));
+  ASSERT_LT(LevelDbTargetSequenceKey::Key(10, 2),
+            LevelDbTargetSequenceKey::Key(10, 10));
+}
+
+TEST(TargetSequenceKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[target_sequence: sequence_number=1234 target_id=42]",
+      LevelDbTargetSequenceKey::Key(1234, 42));
+}
+
+TEST(DocumentSequenceKeyTest, EncodeDecodeCycle) {
+  LevelDbDocumentSequenceKey key;
+
+  auto encoded =
+      LevelDbDocumentSequenceKey::Key(1234, testutil::Key("foo/bar"));
+  ASSERT_TRUE(key.Decode(encoded));
+  ASSERT_EQ(1234, key.sequence_number());
+  ASSERT_EQ(testutil::Key("foo/bar"), key.document_key());
+  ASSERT_FALSE(key.Decode(LevelDbTargetSequenceKey::Key(1234, 42)));
+}
+
+TEST(DocumentSequenceKeyTest, Ordering) {
+  ASSERT_LT(LevelDbDocumentSequenceKey::Key(1, testutil::Key("foo/baz")),
+            LevelDbDocumentSequenceKey::Key(2, testutil::Key("foo/bar")));
+  ASSERT_LT(LevelDbDocumentSequenceKey::Key(2, testutil::Key("foo/bar")),
+            LevelDbDocumentSequenceKey::Key(2, testutil::Key("foo/baz")));
+}
+
+TEST(DocumentSequenceKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[document_sequence: sequence_number=1234 path=foo/bar]",
+      LevelDbDocumentSequenceKey::Key(1234, testutil::Key("foo/bar")));
+}
+
+TEST(QueryResultKeyTest, EncodeDecodeCycle) {
+  LevelDbQueryResultKey key;
+
+  std::vector<model::ResourcePath> collection_paths{
+      testutil::Resource("a"), testutil::Resource("a/b/c")};
+  std::vector<TargetId> target_ids{1, 2, 123, -1, INT_MAX};
+
+  for (auto&& collection_path : collection_paths) {
+    for (TargetId target_id : target_ids) {
+      auto encoded = LevelDbQueryResultKey::Key(collection_path, target_id);
+      bool ok = key.Decode(encoded);
+      ASSERT_TRUE(ok);
+      ASSERT_EQ(collection_path, key.collection_path());
+      ASSERT_EQ(target_id, key.target_id());
+    }
+  }
+}
+
+TEST(QueryResultKeyTest, Ordering) {
+  auto foo_prefix = LevelDbQueryResultKey::KeyPrefix(testutil::Resource("foo"));
+  auto foo_key = LevelDbQueryResultKey::Key(testutil::Resource("foo"), 5);
+  auto nested_key =
+      LevelDbQueryResultKey::Key(testutil::Resource("foo/bar/baz"), 1);
+
+  ASSERT_TRUE(absl::StartsWith(foo_key, foo_prefix));
+  ASSERT_TRUE(absl::StartsWith(nested_key, foo_prefix));
+
+  // The rows of a collection sort before those of nested collections.
+  ASSERT_LT(foo_key, nested_key);
+  ASSERT_LT(LevelDbQueryResultKey::Key(testutil::Resource("foo"), 1), foo_key);
+}
+
+TEST(QueryResultKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[query_result: path=foo/bar/baz target_id=42]",
+      LevelDbQueryResultKey::Key(testutil::Resource("foo/bar/baz"), 42));
+}
+
 TEST(RemoteDocumentKeyTest, Prefixing) {
   auto tableKey = LevelDbRemoteDocumentKey::KeyPrefix();
 
@@ -356,6 +605,259 @@ TEST(RemoteDocumentKeyTest, Description) {
       LevelDbRemoteDocumentKey::Key(testutil::Key("foo/bar/baz/quux")));
 }
 
+TEST(FieldIndexKeyTest, Prefixing) {
+  auto tableKey = LevelDbFieldIndexKey::KeyPrefix();
+  auto key = LevelDbFieldIndexKey::Key("foo", testutil::Field("a.b"));
+
+  ASSERT_TRUE(absl::StartsWith(key, tableKey));
+  ASSERT_TRUE(absl::StartsWith(key, LevelDbFieldIndexKey::KeyPrefix("foo")));
+  ASSERT_FALSE(absl::StartsWith(
+      LevelDbFieldIndexKey::Key("foo2", testutil::Field("a")),
+      LevelDbFieldIndexKey::KeyPrefix("foo")));
+}
+
+TEST(FieldIndexKeyTest, EncodeDecodeCycle) {
+  LevelDbFieldIndexKey key;
+
+  std::vector<std::string> fields{"a", "a.b", "foo.bar.baz"};
+  for (auto&& field : fields) {
+    auto encoded = LevelDbFieldIndexKey::Key("foo", testutil::Field(field));
+    bool ok = key.Decode(encoded);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ("foo", key.collection_id());
+    ASSERT_EQ(testutil::Field(field), key.field_path());
+  }
+}
+
+TEST(FieldIndexKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[field_index: collection_id=foo indexed_field=a.b]",
+      LevelDbFieldIndexKey::Key("foo", testutil::Field("a.b")));
+}
+
+TEST(FieldIndexEntryKeyTest, Prefixing) {
+  auto tableKey = LevelDbFieldIndexEntryKey::KeyPrefix();
+
+  ASSERT_TRUE(absl::StartsWith(FieldIndexEntryKey("a", "v", "foo/bar"),
+                               tableKey));
+  ASSERT_TRUE(absl::StartsWith(FieldIndexEntryKey("a", "v", "foo/bar"),
+                               FieldIndexEntryKeyPrefix("foo", "a")));
+
+  // Entries for documents in subcollections must not be included in a scan of
+  // the parent collection.
+  ASSERT_FALSE(absl::StartsWith(FieldIndexEntryKey("a", "v", "foo/bar/baz/qux"),
+                                FieldIndexEntryKeyPrefix("foo", "a")));
+
+  // Entries for another field must not be included either.
+  ASSERT_FALSE(absl::StartsWith(FieldIndexEntryKey("ab", "v", "foo/bar"),
+                                FieldIndexEntryKeyPrefix("foo", "a")));
+  ASSERT_FALSE(absl::StartsWith(FieldIndexEntryKey("a.b", "v", "foo/bar"),
+                                FieldIndexEntryKeyPrefix("foo", "a")));
+
+  ASSERT_TRUE(absl::StartsWith(
+      FieldIndexEntryKey("a", "v", "foo/bar"),
+      LevelDbFieldIndexEntryKey::KeyPrefix(testutil::Resource("foo"),
+                                           testutil::Field("a"), "v")));
+}
+
+TEST(FieldIndexEntryKeyTest, Ordering) {
+  // Entries are ordered by value first, then by document key.
+  ASSERT_LT(FieldIndexEntryKey("a", "v1", "foo/b"),
+            FieldIndexEntryKey("a", "v2", "foo/a"));
+  ASSERT_LT(FieldIndexEntryKey("a", "v", "foo/a"),
+            FieldIndexEntryKey("a", "v2", "foo/a"));
+  ASSERT_LT(FieldIndexEntryKey("a", std::string("v\0", 2), "foo/a"),
+            FieldIndexEntryKey("a", std::string("v\1", 2), "foo/a"));
+  ASSERT_LT(FieldIndexEntryKey("a", "v", "foo/a"),
+            FieldIndexEntryKey("a", "v", "foo/b"));
+}
+
+TEST(FieldIndexEntryKeyTest, EncodeDecodeCycle) {
+  LevelDbFieldIndexEntryKey key;
+
+  std::vector<std::string> values{"", "v", std::string("\0\1\xff", 3)};
+  for (auto&& value : values) {
+    auto encoded = FieldIndexEntryKey("a.b", value, "foo/bar/baz/quux");
+    bool ok = key.Decode(encoded);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(testutil::Resource("foo/bar/baz"), key.collection_path());
+    ASSERT_EQ(testutil::Field("a.b"), key.field_path());
+    ASSERT_EQ(value, key.index_value());
+    ASSERT_EQ(testutil::Key("foo/bar/baz/quux"), key.document_key());
+  }
+}
+
+TEST(FieldIndexEntryKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[field_index_entry: path=foo indexed_field=a index_value=\\x01 "
+      "path=foo/bar]",
+      FieldIndexEntryKey("a", std::string("\1", 1), "foo/bar"));
+}
+
+TEST(FieldNameKeyTest, Prefixing) {
+  auto key = LevelDbFieldNameKey::Key(testutil::Resource("foo/bar/baz"), 3);
+
+  ASSERT_TRUE(absl::StartsWith(key, LevelDbFieldNameKey::KeyPrefix()));
+  ASSERT_TRUE(absl::StartsWith(
+      key, LevelDbFieldNameKey::KeyPrefix(testutil::Resource("foo/bar/baz"))));
+  ASSERT_FALSE(absl::StartsWith(
+      key, LevelDbFieldNameKey::KeyPrefix(testutil::Resource("foo/bar/quux"))));
+}
+
+TEST(FieldNameKeyTest, Ordering) {
+  // A collection's own names sort before those of its subcollections.
+  ASSERT_LT(LevelDbFieldNameKey::Key(testutil::Resource("foo"), 2),
+            LevelDbFieldNameKey::Key(testutil::Resource("foo"), 10));
+  ASSERT_LT(LevelDbFieldNameKey::Key(testutil::Resource("foo"), 10),
+            LevelDbFieldNameKey::Key(testutil::Resource("foo/bar/baz"), 0));
+}
+
+TEST(FieldNameKeyTest, EncodeDecodeCycle) {
+  LevelDbFieldNameKey key;
+
+  for (int32_t field_name_id : {0, 1, 300}) {
+    auto encoded = LevelDbFieldNameKey::Key(testutil::Resource("foo/bar/baz"),
+                                            field_name_id);
+    bool ok = key.Decode(encoded);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(testutil::Resource("foo/bar/baz"), key.collection_path());
+    ASSERT_EQ(field_name_id, key.field_name_id());
+  }
+}
+
+TEST(FieldNameKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[field_name: path=foo/bar/baz field_name_id=3]",
+      LevelDbFieldNameKey::Key(testutil::Resource("foo/bar/baz"), 3));
+}
+
+TEST(ArrayIndexKeyTest, EncodeDecodeCycle) {
+  LevelDbArrayIndexKey key;
+
+  auto encoded = LevelDbArrayIndexKey::Key("foo", testutil::Field("a.b"));
+  ASSERT_TRUE(
+      absl::StartsWith(encoded, LevelDbArrayIndexKey::KeyPrefix("foo")));
+  ASSERT_TRUE(key.Decode(encoded));
+  ASSERT_EQ("foo", key.collection_id());
+  ASSERT_EQ(testutil::Field("a.b"), key.field_path());
+
+  // Array indexes are declared apart from field indexes on the same field.
+  ASSERT_FALSE(key.Decode(
+      LevelDbFieldIndexKey::Key("foo", testutil::Field("a.b"))));
+}
+
+TEST(ArrayIndexEntryKeyTest, EncodeDecodeCycle) {
+  LevelDbArrayIndexEntryKey key;
+
+  auto encoded = LevelDbArrayIndexEntryKey::Key(
+      testutil::Field("tags"), "v", testutil::Key("foo/bar"));
+  ASSERT_TRUE(absl::StartsWith(
+      encoded, LevelDbArrayIndexEntryKey::KeyPrefix(testutil::Resource("foo"),
+                                                    testutil::Field("tags"),
+                                                    "v")));
+  ASSERT_FALSE(absl::StartsWith(
+      encoded, LevelDbFieldIndexEntryKey::KeyPrefix(testutil::Resource("foo"),
+                                                    testutil::Field("tags"))));
+  ASSERT_TRUE(key.Decode(encoded));
+  ASSERT_EQ(testutil::Resource("foo"), key.collection_path());
+  ASSERT_EQ(testutil::Field("tags"), key.field_path());
+  ASSERT_EQ("v", key.index_value());
+  ASSERT_EQ(testutil::Key("foo/bar"), key.document_key());
+}
+
+TEST(ArrayIndexEntryKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[array_index_entry: path=foo indexed_field=tags index_value=v "
+      "path=foo/bar]",
+      LevelDbArrayIndexEntryKey::Key(testutil::Field("tags"), "v",
+                                     testutil::Key("foo/bar")));
+}
+
+TEST(PathViewTest, RemoteDocumentKeyView) {
+  LevelDbRemoteDocumentKeyView view;
+
+  auto encoded = RemoteDocKey("foo/bar/baz/quux");
+  ASSERT_TRUE(view.Decode(encoded));
+  ASSERT_EQ(4u, view.path().size());
+  ASSERT_FALSE(view.path().escaped());
+  ASSERT_EQ("baz", view.path().segment(2));
+  ASSERT_TRUE(view.path().SegmentEquals(3, "quux"));
+  ASSERT_FALSE(view.path().SegmentEquals(3, "quu"));
+  ASSERT_EQ(testutil::Key("foo/bar/baz/quux"), view.path().ToDocumentKey());
+
+  // The decoded segments point into the key.
+  ASSERT_GE(view.path().segment(0).data(), encoded.data());
+  ASSERT_LT(view.path().segment(0).data(), encoded.data() + encoded.size());
+}
+
+TEST(PathViewTest, RejectsInvalidKeys) {
+  LevelDbRemoteDocumentKeyView view;
+  ASSERT_FALSE(view.Decode(RemoteDocKeyPrefix("foo/bar")));
+  ASSERT_FALSE(view.Decode(RemoteDocKeyPrefix("foo")));
+  ASSERT_FALSE(view.Decode(DocTargetKey("foo/bar", 1)));
+
+  LevelDbTargetDocumentKeyView target_document_view;
+  ASSERT_FALSE(target_document_view.Decode(RemoteDocKey("foo/bar")));
+}
+
+TEST(PathViewTest, StartsWith) {
+  // Views point into the key, so it has to outlive them.
+  auto encoded = RemoteDocKey("foo/bar/baz/quux");
+  LevelDbRemoteDocumentKeyView view;
+  ASSERT_TRUE(view.Decode(encoded));
+
+  ASSERT_TRUE(view.path().StartsWith(testutil::Resource("")));
+  ASSERT_TRUE(view.path().StartsWith(testutil::Resource("foo/bar")));
+  ASSERT_TRUE(view.path().StartsWith(testutil::Resource("foo/bar/baz/quux")));
+  ASSERT_FALSE(view.path().StartsWith(testutil::Resource("foo/ba")));
+  ASSERT_FALSE(view.path().StartsWith(testutil::Resource("foo/bar/baz/q/r")));
+}
+
+TEST(PathViewTest, EscapedSegments) {
+  std::string segment("a\0b\xff", 4);
+  model::ResourcePath path({"foo", segment});
+
+  auto encoded = LevelDbRemoteDocumentKey::Key(DocumentKey{path});
+  LevelDbRemoteDocumentKeyView view;
+  ASSERT_TRUE(view.Decode(encoded));
+  ASSERT_TRUE(view.path().escaped());
+  ASSERT_TRUE(view.path().SegmentEquals(1, segment));
+  ASSERT_FALSE(view.path().SegmentEquals(1, "ab"));
+  ASSERT_TRUE(view.path().StartsWith(path));
+  ASSERT_EQ(path, view.path().ToResourcePath());
+}
+
+TEST(PathViewTest, TargetKeyViews) {
+  auto target_document_key = TargetDocKey(42, "foo/bar");
+  LevelDbTargetDocumentKeyView target_document_view;
+  ASSERT_TRUE(target_document_view.Decode(target_document_key));
+  ASSERT_EQ(42, target_document_view.target_id());
+  ASSERT_EQ(testutil::Key("foo/bar"),
+            target_document_view.path().ToDocumentKey());
+
+  auto document_target_key = DocTargetKey("foo/bar", 42);
+  LevelDbDocumentTargetKeyView document_target_view;
+  ASSERT_TRUE(document_target_view.Decode(document_target_key));
+  ASSERT_EQ(42, document_target_view.target_id());
+  ASSERT_FALSE(document_target_view.IsSentinel());
+  ASSERT_EQ(testutil::Key("foo/bar"),
+            document_target_view.path().ToDocumentKey());
+
+  // Paths compare equal across tables.
+  ASSERT_TRUE(target_document_view.path() == document_target_view.path());
+
+  auto sentinel_key =
+      LevelDbDocumentTargetKey::SentinelKey(testutil::Key("foo/baz"));
+  ASSERT_TRUE(document_target_view.Decode(sentinel_key));
+  ASSERT_TRUE(document_target_view.IsSentinel());
+  ASSERT_TRUE(target_document_view.path() != document_target_view.path());
+
+  LevelDbDocumentTargetSetKeyView document_target_set_view;
+  ASSERT_TRUE(document_target_set_view.Decode(DocTargetSetKey("foo/baz")));
+  ASSERT_TRUE(document_target_set_view.path() == document_target_view.path());
+  ASSERT_FALSE(document_target_set_view.Decode(sentinel_key));
+}
+
 #undef AssertExpectedKeyDescription
 
 }  // namespace local
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_options.h"
+
+#include <memory>
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_env.h"
+#include "leveldb/env.h"
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+TEST(LevelDbOptionsTest, LeavesLevelDbDefaults) {
+  LevelDbOptions options{LevelDbSettings{}};
+  leveldb::Options defaults;
+
+  EXPECT_TRUE(options.options().create_if_missing);
+  // A cache of LevelDB's default capacity, which can be released.
+  EXPECT_NE(nullptr, options.options().block_cache);
+  EXPECT_EQ(nullptr, options.options().filter_policy);
+  EXPECT_EQ(defaults.write_buffer_size, options.options().write_buffer_size);
+  EXPECT_EQ(leveldb::Env::Default(), options.options().env);
+  EXPECT_EQ(defaults.max_file_size, options.options().max_file_size);
+  EXPECT_EQ(defaults.max_open_files, options.options().max_open_files);
+  EXPECT_TRUE(options.read_options().verify_checksums);
+}
+
+TEST(LevelDbOptionsTest, AppliesSettings) {
+  LevelDbSettings settings;
+  settings.block_cache_size_bytes = 1024 * 1024;
+  settings.bloom_filter_enabled = true;
+  settings.write_buffer_size_bytes = 64 * 1024;
+  settings.verify_checksums = false;
+  settings.mobile_env = true;
+  settings.max_file_size_bytes = 8 * 1024 * 1024;
+  settings.max_open_files = 100;
+  LevelDbOptions options{settings};
+
+  EXPECT_NE(nullptr, options.options().block_cache);
+  ASSERT_NE(nullptr, options.options().filter_policy);
+  EXPECT_EQ(std::string("leveldb.BuiltinBloomFilter2"),
+            options.options().filter_policy->Name());
+  EXPECT_EQ(64u * 1024u, options.options().write_buffer_size);
+  EXPECT_FALSE(options.read_options().verify_checksums);
+  EXPECT_EQ(MobileLevelDbEnv(), options.options().env);
+  EXPECT_EQ(8u * 1024u * 1024u, options.options().max_file_size);
+  EXPECT_EQ(100, options.options().max_open_files);
+}
+
+TEST(LevelDbOptionsTest, UsesSharedBlockCache) {
+  std::shared_ptr<leveldb::Cache> cache{leveldb::NewLRUCache(1024 * 1024)};
+
+  LevelDbSettings settings;
+  settings.block_cache_size_bytes = 64 * 1024;
+  settings.shared_block_cache = cache;
+  LevelDbOptions options{settings};
+  LevelDbOptions other_options{settings};
+
+  EXPECT_EQ(cache.get(), options.options().block_cache);
+  EXPECT_EQ(cache.get(), other_options.options().block_cache);
+}
+
+TEST(LevelDbOptionsTest, ReleasesBlockCache) {
+  LevelDbOptions options{LevelDbSettings{}};
+  leveldb::Cache* cache = options.options().block_cache;
+
+  auto ignore = [](const leveldb::Slice&, void*) {};
+  leveldb::Cache::Handle* in_use =
+      cache->Insert("in_use", nullptr, 100, ignore);
+  cache->Release(cache->Insert("idle", nullptr, 200, ignore));
+  EXPECT_EQ(300u, cache->TotalCharge());
+
+  EXPECT_EQ(200u, options.ReleaseBlockCache());
+  EXPECT_EQ(100u, cache->TotalCharge());
+  EXPECT_EQ(0u, options.ReleaseBlockCache());
+
+  cache->Release(in_use);
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_shared_cache.h"
+
+#include <memory>
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/util/filesystem.h"
+#include "leveldb/db.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+using util::Path;
+
+std::unique_ptr<leveldb::DB> OpenDb(const Path& directory) {
+  leveldb::Options options;
+  options.create_if_missing = true;
+  leveldb::DB* db = nullptr;
+  leveldb::Status status =
+      leveldb::DB::Open(options, directory.ToUtf8String(), &db);
+  EXPECT_TRUE(status.ok()) << status.ToString();
+  return std::unique_ptr<leveldb::DB>(db);
+}
+
+class LevelDbSharedCacheTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    directory_ = util::TempDir().AppendUtf8("leveldb_shared_cache_test");
+    copy_ = util::TempDir().AppendUtf8("leveldb_shared_cache_test.reader");
+    ASSERT_TRUE(util::RecursivelyDelete(directory_).ok());
+    ASSERT_TRUE(util::RecursivelyDelete(copy_).ok());
+  }
+
+  void TearDown() override {
+    EXPECT_TRUE(util::RecursivelyDelete(directory_).ok());
+    EXPECT_TRUE(util::RecursivelyDelete(copy_).ok());
+  }
+
+  Path directory_;
+  Path copy_;
+};
+
+}  // namespace
+
+TEST_F(LevelDbSharedCacheTest, SequenceNumberStartsAtZero) {
+  ASSERT_TRUE(util::RecursivelyCreateDir(directory_).ok());
+  LevelDbSharedCache cache{directory_};
+  EXPECT_EQ(0u, cache.ReadSequenceNumber());
+}
+
+TEST_F(LevelDbSharedCacheTest, ReadsTheLastSequenceNumberWritten) {
+  ASSERT_TRUE(util::RecursivelyCreateDir(directory_).ok());
+  LevelDbSharedCache writer{directory_};
+  LevelDbSharedCache reader{directory_};
+
+  ASSERT_TRUE(writer.WriteSequenceNumber(1).ok());
+  EXPECT_EQ(1u, reader.ReadSequenceNumber());
+  ASSERT_TRUE(writer.WriteSequenceNumber(42).ok());
+  EXPECT_EQ(42u, reader.ReadSequenceNumber());
+}
+
+TEST_F(LevelDbSharedCacheTest, CopiesADatabaseThatIsOpen) {
+  std::unique_ptr<leveldb::DB> db = OpenDb(directory_);
+  ASSERT_TRUE(db->Put(leveldb::WriteOptions(), "a", "1").ok());
+  // Put some of the rows into a table file.
+  db->CompactRange(nullptr, nullptr);
+  ASSERT_TRUE(db->Put(leveldb::WriteOptions(), "b", "2").ok());
+
+  LevelDbSharedCache cache{directory_};
+  ASSERT_TRUE(cache.CopyTo(copy_).ok());
+
+  std::unique_ptr<leveldb::DB> copy = OpenDb(copy_);
+  std::string value;
+  ASSERT_TRUE(copy->Get(leveldb::ReadOptions(), "a", &value).ok());
+  EXPECT_EQ("1", value);
+  ASSERT_TRUE(copy->Get(leveldb::ReadOptions(), "b", &value).ok());
+  EXPECT_EQ("2", value);
+
+  // The copy is private to the reader.
+  ASSERT_TRUE(copy->Put(leveldb::WriteOptions(), "c", "3").ok());
+  EXPECT_TRUE(db->Get(leveldb::ReadOptions(), "c", &value).IsNotFound());
+}
+
+TEST_F(LevelDbSharedCacheTest, ReplacesAnEarlierCopy) {
+  std::unique_ptr<leveldb::DB> db = OpenDb(directory_);
+  LevelDbSharedCache cache{directory_};
+  ASSERT_TRUE(cache.CopyTo(copy_).ok());
+
+  ASSERT_TRUE(db->Put(leveldb::WriteOptions(), "a", "1").ok());
+  ASSERT_TRUE(cache.CopyTo(copy_).ok());
+
+  std::unique_ptr<leveldb::DB> copy = OpenDb(copy_);
+  std::string value;
+  ASSERT_TRUE(copy->Get(leveldb::ReadOptions(), "a", &value).ok());
+  EXPECT_EQ("1", value);
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
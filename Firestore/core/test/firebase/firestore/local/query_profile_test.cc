@@ -0,0 +1,110 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/query_profile.h"
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using Phase = QueryProfile::Phase;
+
+TEST(QueryProfileTest, RecordsNothingWithoutScope) {
+  EXPECT_EQ(nullptr, QueryProfile::Current());
+
+  // Must not crash.
+  QueryProfile::RecordKeysScanned();
+  QueryProfile::RecordDocumentDecoded();
+  QueryProfile::PhaseTimer timer(Phase::GetMatching);
+}
+
+TEST(QueryProfileTest, ScopeSetsCurrent) {
+  if (!QueryProfile::IsSupported()) {
+    return;
+  }
+
+  QueryProfile outer;
+  QueryProfile inner;
+  {
+    QueryProfile::Scope outer_scope{&outer};
+    EXPECT_EQ(&outer, QueryProfile::Current());
+    {
+      QueryProfile::Scope inner_scope{&inner};
+      EXPECT_EQ(&inner, QueryProfile::Current());
+    }
+    EXPECT_EQ(&outer, QueryProfile::Current());
+  }
+  EXPECT_EQ(nullptr, QueryProfile::Current());
+}
+
+TEST(QueryProfileTest, RecordsIntoCurrentProfile) {
+  if (!QueryProfile::IsSupported()) {
+    return;
+  }
+
+  QueryProfile outer;
+  QueryProfile inner;
+  {
+    QueryProfile::Scope outer_scope{&outer};
+    QueryProfile::RecordKeysScanned(3);
+    {
+      QueryProfile::Scope inner_scope{&inner};
+      QueryProfile::RecordKeysScanned();
+      QueryProfile::RecordDocumentDecoded();
+      QueryProfile::RecordDocumentsMatched(2);
+      QueryProfile::RecordMutationBatchesOverlaid(4);
+      QueryProfile::RecordCollectionParentsVisited(5);
+    }
+    QueryProfile::RecordDocumentDecoded();
+  }
+
+  EXPECT_EQ(3, outer.keys_scanned());
+  EXPECT_EQ(1, outer.documents_decoded());
+  EXPECT_EQ(0, outer.documents_matched());
+
+  EXPECT_EQ(1, inner.keys_scanned());
+  EXPECT_EQ(1, inner.documents_decoded());
+  EXPECT_EQ(2, inner.documents_matched());
+  EXPECT_EQ(4, inner.mutation_batches_overlaid());
+  EXPECT_EQ(5, inner.collection_parents_visited());
+}
+
+TEST(QueryProfileTest, AddsDurationsPerPhase) {
+  QueryProfile profile;
+  profile.AddDuration(Phase::GetMatching, QueryProfile::Microseconds{10});
+  profile.AddDuration(Phase::GetMatching, QueryProfile::Microseconds{5});
+  profile.AddDuration(Phase::ViewDiff, QueryProfile::Microseconds{7});
+
+  EXPECT_EQ(15, profile.duration(Phase::GetMatching).count());
+  EXPECT_EQ(0, profile.duration(Phase::Overlay).count());
+  EXPECT_EQ(7, profile.duration(Phase::ViewDiff).count());
+}
+
+TEST(QueryProfileTest, ToString) {
+  QueryProfile profile;
+  profile.AddDuration(Phase::Overlay, QueryProfile::Microseconds{42});
+  EXPECT_EQ(
+      "QueryProfile(keys_scanned=0, documents_decoded=0, documents_matched=0, "
+      "mutation_batches_overlaid=0, collection_parents_visited=0, "
+      "get_matching_us=0, overlay_us=42, view_diff_us=0)",
+      profile.ToString());
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
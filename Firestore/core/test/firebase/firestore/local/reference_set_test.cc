@@ -16,6 +16,8 @@
 
 #include "Firestore/core/src/firebase/firestore/local/reference_set.h"
 
+#include <string>
+
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 
@@ -26,6 +28,7 @@ namespace firestore {
 namespace local {
 
 using model::DocumentKey;
+using model::DocumentKeySet;
 
 TEST(ReferenceSetTest, AddOrRemoveReferences) {
   DocumentKey key = testutil::Key("foo/bar");
@@ -79,6 +82,71 @@ TEST(ReferenceSetTest, RemoteAllReferencesForTargetId) {
   EXPECT_FALSE(referenceSet.ContainsKey(key3));
 }
 
+TEST(ReferenceSetTest, AddsAndRemovesReferencesInBulk) {
+  DocumentKey key1 = testutil::Key("foo/bar");
+  DocumentKey key2 = testutil::Key("foo/baz");
+  DocumentKey key3 = testutil::Key("foo/blah");
+  ReferenceSet referenceSet{};
+
+  referenceSet.AddReferences(DocumentKeySet{key1, key2, key3}, 1);
+  referenceSet.AddReferences(DocumentKeySet{key2}, 2);
+  EXPECT_EQ(4u, referenceSet.size());
+  EXPECT_EQ((DocumentKeySet{key1, key2, key3}), referenceSet.ReferencedKeys(1));
+  EXPECT_EQ(DocumentKeySet{key2}, referenceSet.ReferencedKeys(2));
+  EXPECT_EQ(DocumentKeySet{}, referenceSet.ReferencedKeys(3));
+
+  referenceSet.RemoveReferences(DocumentKeySet{key1, key2}, 1);
+  EXPECT_EQ(2u, referenceSet.size());
+  EXPECT_FALSE(referenceSet.ContainsKey(key1));
+  EXPECT_TRUE(referenceSet.ContainsKey(key2));
+  EXPECT_EQ(DocumentKeySet{key3}, referenceSet.ReferencedKeys(1));
+
+  EXPECT_EQ(DocumentKeySet{key2}, referenceSet.RemoveReferences(2));
+  EXPECT_FALSE(referenceSet.ContainsKey(key2));
+  EXPECT_EQ(DocumentKeySet{}, referenceSet.RemoveReferences(2));
+  EXPECT_EQ(1u, referenceSet.size());
+}
+
+TEST(ReferenceSetTest, IgnoresDuplicateReferences) {
+  DocumentKey key = testutil::Key("foo/bar");
+  ReferenceSet referenceSet{};
+
+  referenceSet.AddReference(key, 1);
+  referenceSet.AddReference(key, 1);
+  referenceSet.AddReferences(DocumentKeySet{key}, 1);
+  EXPECT_EQ(1u, referenceSet.size());
+
+  referenceSet.RemoveReference(key, 1);
+  EXPECT_TRUE(referenceSet.empty());
+  EXPECT_FALSE(referenceSet.ContainsKey(key));
+  EXPECT_EQ(DocumentKeySet{}, referenceSet.ReferencedKeys(1));
+}
+
+TEST(ReferenceSetTest, RemovesAllReferences) {
+  ReferenceSet referenceSet{};
+  referenceSet.AddReference(testutil::Key("foo/bar"), 1);
+  referenceSet.AddReference(testutil::Key("foo/baz"), 2);
+
+  referenceSet.RemoveAllReferences();
+  EXPECT_TRUE(referenceSet.empty());
+  EXPECT_FALSE(referenceSet.ContainsKey(testutil::Key("foo/bar")));
+  EXPECT_EQ(DocumentKeySet{}, referenceSet.ReferencedKeys(2));
+}
+
+TEST(ReferenceSetTest, EstimatedByteSizeFollowsReferences) {
+  ReferenceSet referenceSet{};
+  size_t empty_size = referenceSet.EstimatedByteSize();
+
+  for (int i = 0; i < 100; ++i) {
+    referenceSet.AddReference(testutil::Key("foo/" + std::to_string(i)), 1);
+  }
+  size_t full_size = referenceSet.EstimatedByteSize();
+  EXPECT_GT(full_size, empty_size + 100 * sizeof(DocumentKey));
+
+  referenceSet.RemoveReferences(1);
+  EXPECT_LT(referenceSet.EstimatedByteSize(), full_size);
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,203 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/target_id_set.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using model::TargetId;
+
+namespace {
+
+/** Returns the IDs in [begin, end), counting by `step`. */
+std::vector<TargetId> Ids(TargetId begin, TargetId end, TargetId step = 1) {
+  std::vector<TargetId> result;
+  for (TargetId id = begin; id < end; id += step) {
+    result.push_back(id);
+  }
+  return result;
+}
+
+TargetIdSet MakeSet(const std::vector<TargetId>& ids) {
+  TargetIdSet result;
+  for (TargetId id : ids) {
+    result.insert(id);
+  }
+  return result;
+}
+
+/** Returns the given IDs that `keep` accepts. */
+template <typename Predicate>
+std::vector<TargetId> Filter(const std::vector<TargetId>& ids, Predicate keep) {
+  std::vector<TargetId> result;
+  for (TargetId id : ids) {
+    if (keep(id)) result.push_back(id);
+  }
+  return result;
+}
+
+TargetIdSet RoundTrip(const TargetIdSet& set) {
+  TargetIdSet decoded;
+  EXPECT_TRUE(decoded.Decode(set.Encode()));
+  return decoded;
+}
+
+}  // namespace
+
+TEST(TargetIdSet, Empty) {
+  TargetIdSet set;
+  EXPECT_TRUE(set.empty());
+  EXPECT_EQ(0u, set.size());
+  EXPECT_FALSE(set.contains(2));
+  EXPECT_TRUE(set.ToVector().empty());
+  EXPECT_EQ(set, RoundTrip(set));
+}
+
+TEST(TargetIdSet, InsertsAndErases) {
+  TargetIdSet set;
+  EXPECT_TRUE(set.insert(4));
+  EXPECT_TRUE(set.insert(2));
+  EXPECT_TRUE(set.insert(1 << 20));
+  EXPECT_FALSE(set.insert(2));
+  EXPECT_EQ(3u, set.size());
+  EXPECT_EQ((std::vector<TargetId>{2, 4, 1 << 20}), set.ToVector());
+
+  EXPECT_TRUE(set.contains(4));
+  EXPECT_FALSE(set.contains(6));
+  EXPECT_FALSE(set.contains((1 << 20) + 4));
+
+  EXPECT_TRUE(set.erase(4));
+  EXPECT_FALSE(set.erase(4));
+  EXPECT_FALSE(set.erase(-2));
+  EXPECT_TRUE(set.erase(1 << 20));
+  EXPECT_EQ((std::vector<TargetId>{2}), set.ToVector());
+
+  EXPECT_TRUE(set.erase(2));
+  EXPECT_TRUE(set.empty());
+  EXPECT_EQ(TargetIdSet{}, set);
+}
+
+TEST(TargetIdSet, SwitchesBetweenArraysAndBitmaps) {
+  // Even IDs, as TargetIdGenerator assigns them, spanning two containers. The
+  // first fills its container as a bitmap.
+  std::vector<TargetId> ids = Ids(0, 1 << 17, 2);
+  TargetIdSet set = MakeSet(ids);
+  EXPECT_EQ(ids.size(), set.size());
+  EXPECT_EQ(ids, set.ToVector());
+  EXPECT_EQ(set, RoundTrip(set));
+
+  // Erasing down to an array and adding back to a bitmap gives the same set.
+  std::vector<TargetId> removed = Ids(0, 1 << 16, 4);
+  for (TargetId id : removed) {
+    EXPECT_TRUE(set.erase(id));
+  }
+  for (TargetId id : removed) {
+    EXPECT_FALSE(set.contains(id));
+  }
+  EXPECT_EQ(set, RoundTrip(set));
+  for (TargetId id : removed) {
+    EXPECT_TRUE(set.insert(id));
+  }
+  EXPECT_EQ(MakeSet(ids), set);
+}
+
+TEST(TargetIdSet, Union) {
+  for (TargetId end : {100, 40000}) {
+    std::vector<TargetId> evens = Ids(0, end, 2);
+    std::vector<TargetId> threes = Ids(0, end, 3);
+    std::vector<TargetId> expected = Filter(
+        Ids(0, end), [](TargetId id) { return id % 2 == 0 || id % 3 == 0; });
+
+    TargetIdSet lhs = MakeSet(evens);
+    TargetIdSet rhs = MakeSet(threes);
+    EXPECT_EQ(MakeSet(expected), TargetIdSet::Union(lhs, rhs)) << end;
+    EXPECT_EQ(MakeSet(expected), TargetIdSet::Union(rhs, lhs)) << end;
+    EXPECT_EQ(lhs, TargetIdSet::Union(lhs, lhs));
+    EXPECT_EQ(lhs, TargetIdSet::Union(lhs, {}));
+    EXPECT_EQ(lhs, TargetIdSet::Union({}, lhs));
+  }
+
+  // Two arrays whose union no longer fits in an array.
+  TargetIdSet lhs = MakeSet(Ids(0, 8000, 4));
+  TargetIdSet rhs = MakeSet(Ids(2, 18000, 4));
+  TargetIdSet expected = MakeSet(Ids(0, 8000, 2));
+  for (TargetId id : Ids(8002, 18000, 4)) {
+    expected.insert(id);
+  }
+  EXPECT_EQ(expected, TargetIdSet::Union(lhs, rhs));
+}
+
+TEST(TargetIdSet, Difference) {
+  for (TargetId end : {100, 40000}) {
+    std::vector<TargetId> evens = Ids(0, end, 2);
+    std::vector<TargetId> threes = Ids(0, end, 3);
+    std::vector<TargetId> expected =
+        Filter(evens, [](TargetId id) { return id % 3 != 0; });
+
+    TargetIdSet lhs = MakeSet(evens);
+    TargetIdSet rhs = MakeSet(threes);
+    EXPECT_EQ(MakeSet(expected), TargetIdSet::Difference(lhs, rhs)) << end;
+    EXPECT_TRUE(TargetIdSet::Difference(lhs, lhs).empty());
+    EXPECT_EQ(lhs, TargetIdSet::Difference(lhs, {}));
+    EXPECT_TRUE(TargetIdSet::Difference({}, lhs).empty());
+  }
+
+  // A bitmap whose difference fits in an array.
+  TargetIdSet lhs = MakeSet(Ids(0, 20000, 2));
+  TargetIdSet rhs = MakeSet(Ids(0, 19000, 2));
+  EXPECT_EQ(MakeSet(Ids(19000, 20000, 2)), TargetIdSet::Difference(lhs, rhs));
+}
+
+TEST(TargetIdSet, EncodesCompactly) {
+  // A document in a handful of targets takes a few bytes per target.
+  TargetIdSet few = MakeSet({2, 4, 10, 1000});
+  EXPECT_LE(few.Encode().size(), 8u);
+
+  // A document in every one of a hundred thousand targets takes about a bit per
+  // possible ID.
+  TargetIdSet many = MakeSet(Ids(2, 200000, 2));
+  EXPECT_LT(many.Encode().size(), 30000u);
+  EXPECT_EQ(many, RoundTrip(many));
+}
+
+TEST(TargetIdSet, RejectsInvalidEncodings) {
+  TargetIdSet decoded;
+  std::string encoded = MakeSet({2, 4, 6}).Encode();
+  EXPECT_FALSE(decoded.Decode(encoded.substr(0, encoded.size() - 1)));
+  EXPECT_FALSE(decoded.Decode(encoded + "x"));
+  EXPECT_FALSE(decoded.Decode(""));
+
+  // Repeated IDs.
+  EXPECT_FALSE(decoded.Decode(std::string{"\x01\x00\x02\x02\x00", 5}));
+  // An empty container.
+  EXPECT_FALSE(decoded.Decode(std::string{"\x01\x00\x00", 3}));
+
+  std::string bitmap = MakeSet(Ids(0, 10000)).Encode();
+  EXPECT_FALSE(decoded.Decode(bitmap.substr(0, bitmap.size() - 100)));
+  bitmap.back() = '\xff';
+  EXPECT_FALSE(decoded.Decode(bitmap));
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/value_compression.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+std::string RepetitiveValue() {
+  std::string value;
+  for (int i = 0; i < 100; ++i) {
+    value += "\x0a\x04name\x12\x05value" + std::to_string(i % 10);
+  }
+  return value;
+}
+
+}  // namespace
+
+TEST(ValueCompressionTest, RoundTrips) {
+  std::string value = RepetitiveValue();
+  absl::optional<std::string> compressed = CompressValue(value);
+  ASSERT_TRUE(compressed.has_value());
+  EXPECT_TRUE(IsCompressedValue(*compressed));
+  EXPECT_FALSE(IsCompressedValue(value));
+  EXPECT_LT(compressed->size(), value.size() / 4);
+
+  EXPECT_EQ(value, UncompressValue(*compressed));
+}
+
+TEST(ValueCompressionTest, SkipsValuesThatDontShrink) {
+  EXPECT_EQ(absl::nullopt, CompressValue(""));
+  EXPECT_EQ(absl::nullopt, CompressValue("\x08\x01"));
+
+  std::string noise;
+  uint32_t state = 12345;
+  for (int i = 0; i < 256; ++i) {
+    state = state * 1103515245 + 12345;
+    noise.push_back(static_cast<char>(state >> 24));
+  }
+  EXPECT_EQ(absl::nullopt, CompressValue(noise));
+}
+
+TEST(ValueCompressionTest, RejectsCorruptValues) {
+  std::string value = RepetitiveValue();
+  std::string compressed = CompressValue(value).value();
+
+  EXPECT_EQ(absl::nullopt, UncompressValue(value));
+
+  std::string truncated = compressed.substr(0, compressed.size() - 1);
+  EXPECT_EQ(absl::nullopt, UncompressValue(truncated));
+
+  // A size that doesn't match the compressed data.
+  std::string wrong_size = compressed;
+  wrong_size[1] = static_cast<char>(wrong_size[1] ^ 1);
+  EXPECT_EQ(absl::nullopt, UncompressValue(wrong_size));
+
+  EXPECT_EQ(absl::nullopt, UncompressValue(std::string("\x01\xff\xff\xff", 4)));
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/test/firebase/firestore/testutil/allocation_counter.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+using testutil::AllocationCounter;
+using testutil::Key;
+
+TEST(DocumentKey, CopyAndMoveDoNotAllocate) {
+  // Keys are copied around constantly (into maps, sets, snapshots), so they
+  // share their path rather than copying it.
+  DocumentKey key = Key("rooms/firestore/messages/1");
+  DocumentKey assigned;
+
+  AllocationCounter allocations;
+  DocumentKey copied = key;
+  assigned = copied;
+  DocumentKey moved = std::move(copied);
+  EXPECT_EQ(allocations.count(), 0);
+
+  EXPECT_EQ(key, assigned);
+  EXPECT_EQ(key, moved);
+}
+
+TEST(ResourcePath, ShortPathsAllocateOnlyTheirStorage) {
+  // Segments this short fit the small string optimization, and paths this
+  // long fit their storage inline.
+  const ResourcePath parent = ResourcePath::FromString("rooms/Eros/messages");
+
+  AllocationCounter allocations;
+  const ResourcePath parsed = ResourcePath::FromString("rooms/Eros/messages/1");
+  EXPECT_LE(allocations.count(), 1);
+
+  AllocationCounter appending;
+  const ResourcePath appended = parent.Append("1");
+  EXPECT_LE(appending.count(), 1);
+
+  AllocationCounter popping;
+  EXPECT_EQ(parent, appended.PopLast());
+  EXPECT_EQ(parsed, appended);
+  EXPECT_EQ(popping.count(), 0);
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
@@ -155,6 +155,27 @@ TEST(DocumentKey, Comparator) {
   DocumentKey abcd = Key("a/b/c/d");
   DocumentKey xyzw = Key("x/y/z/w");
   EXPECT_TRUE(util::Comparator<DocumentKey>{}(abcd, xyzw));
+
+  EXPECT_EQ(util::ComparisonResult::Ascending, util::Compare(abcd, xyzw));
+  EXPECT_EQ(util::ComparisonResult::Descending, util::Compare(xyzw, abcd));
+  EXPECT_EQ(util::ComparisonResult::Same,
+            util::Compare(abcd, Key("a/b/c/d")));
+}
+
+TEST(DocumentKey, Hash) {
+  DocumentKey abcd = Key("a/b/c/d");
+  DocumentKey copy = abcd;
+  DocumentKey moved = Key("a/b/c/d");
+  DocumentKey moved_to = std::move(moved);
+
+  EXPECT_EQ(Key("a/b/c/d").Hash(), abcd.Hash());
+  EXPECT_EQ(abcd.Hash(), copy.Hash());
+  EXPECT_EQ(abcd.Hash(), moved_to.Hash());
+  EXPECT_EQ(DocumentKey{}.Hash(), DocumentKey::Empty().Hash());
+
+  EXPECT_NE(abcd.Hash(), Key("a/b/c/e").Hash());
+  EXPECT_NE(Key("a/bc").Hash(), Key("ab/c").Hash());
+  EXPECT_EQ(DocumentKeyHash{}(abcd), abcd.Hash());
 }
 
 }  // namespace model
@@ -272,6 +272,18 @@ TEST(FieldPath, KeyFieldPath) {
                                 key_field_path.CanonicalString().substr(1)));
 }
 
+TEST(FieldPath, ParsedPathsShareStorage) {
+  const auto path = FieldPath::FromServerFormat("foo.`bar.baz`");
+  const auto reparsed = FieldPath::FromServerFormat("foo.`bar.baz`");
+  EXPECT_EQ(path, reparsed);
+  EXPECT_EQ(&*path.begin(), &*reparsed.begin());
+
+  const auto dotted = FieldPath::FromDotSeparatedString("foo.bar");
+  const auto redotted = FieldPath::FromDotSeparatedString("foo.bar");
+  EXPECT_EQ(&*dotted.begin(), &*redotted.begin());
+  EXPECT_EQ(dotted, FieldPath::FromServerFormat("foo.bar"));
+}
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
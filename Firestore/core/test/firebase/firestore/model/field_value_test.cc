@@ -17,6 +17,12 @@
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 
 #include <climits>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
@@ -34,6 +40,87 @@ const uint8_t* Bytes(const char* value) {
   return reinterpret_cast<const uint8_t*>(value);
 }
 
+/**
+ * Returns values of every type in ascending order, including edge cases of
+ * mixed number comparisons and of strings and sequences that are prefixes of
+ * others. References point at the given databases, with database1 < database2.
+ */
+std::vector<FieldValue> ValuesInOrder(const DatabaseId* database1,
+                                      const DatabaseId* database2) {
+  const int64_t max = std::numeric_limits<int64_t>::max();
+  const int64_t min = std::numeric_limits<int64_t>::min();
+  const double infinity = std::numeric_limits<double>::infinity();
+  auto map = [](std::vector<std::pair<std::string, FieldValue>> entries) {
+    FieldValue::Map result;
+    for (auto& entry : entries) {
+      result = result.insert(entry.first, entry.second);
+    }
+    return FieldValue::FromMap(std::move(result));
+  };
+
+  return {
+      FieldValue::Null(),
+      FieldValue::False(),
+      FieldValue::True(),
+      FieldValue::Nan(),
+      FieldValue::FromDouble(-infinity),
+      FieldValue::FromInteger(min),
+      FieldValue::FromDouble(-1.5),
+      FieldValue::FromInteger(-1),
+      FieldValue::FromDouble(-1.0),
+      FieldValue::FromDouble(-0.0),
+      FieldValue::FromInteger(0),
+      FieldValue::FromDouble(0.5),
+      FieldValue::FromInteger(1),
+      FieldValue::FromDouble(9007199254740992.0),
+      FieldValue::FromInteger(9007199254740993LL),
+      FieldValue::FromDouble(9007199254740994.0),
+      FieldValue::FromInteger(9007199254740994LL),
+      FieldValue::FromInteger(9007199254740995LL),
+      FieldValue::FromInteger(max - 1),
+      FieldValue::FromInteger(max),
+      FieldValue::FromDouble(static_cast<double>(max)),
+      FieldValue::FromDouble(infinity),
+      FieldValue::FromTimestamp({-1, 999999999}),
+      FieldValue::FromTimestamp({0, 0}),
+      FieldValue::FromTimestamp({0, 1}),
+      FieldValue::FromServerTimestamp({0, 0}),
+      FieldValue::FromServerTimestamp({1, 0}),
+      FieldValue::FromString(""),
+      FieldValue::FromString(std::string(1, '\0')),
+      FieldValue::FromString("a"),
+      FieldValue::FromString(std::string("a\0", 2)),
+      FieldValue::FromString("ab"),
+      FieldValue::FromString("\xff"),
+      FieldValue::FromBlob(Bytes(""), 0),
+      FieldValue::FromBlob(Bytes("\0"), 1),
+      FieldValue::FromBlob(Bytes("\xff"), 1),
+      FieldValue::FromReference(DocumentKey::FromPathString("c/d"),
+                                database1),
+      FieldValue::FromReference(DocumentKey::FromPathString("c/d/e/f"),
+                                database1),
+      FieldValue::FromReference(DocumentKey::FromPathString("c/e"),
+                                database1),
+      FieldValue::FromReference(DocumentKey::FromPathString("a/b"),
+                                database2),
+      FieldValue::FromGeoPoint({-1, 5}),
+      FieldValue::FromGeoPoint({0, -1}),
+      FieldValue::FromGeoPoint({0, 1}),
+      FieldValue::FromArray({}),
+      FieldValue::FromArray({FieldValue::Null()}),
+      FieldValue::FromArray({FieldValue::FromInteger(1)}),
+      FieldValue::FromArray(
+          {FieldValue::FromInteger(1), FieldValue::FromString("a")}),
+      FieldValue::FromArray({FieldValue::FromInteger(2)}),
+      FieldValue::EmptyObject(),
+      map({{"", FieldValue::Null()}}),
+      map({{"a", FieldValue::FromInteger(1)}}),
+      map({{"a", FieldValue::FromInteger(1)}, {"b", FieldValue::Null()}}),
+      map({{"a", FieldValue::FromInteger(2)}}),
+      map({{"ab", FieldValue::Null()}}),
+  };
+}
+
 }  // namespace
 
 TEST(FieldValue, NullType) {
@@ -144,6 +231,19 @@ TEST(FieldValue, BlobType) {
   EXPECT_FALSE(a < a);
 }
 
+TEST(FieldValue, CopiesShareStringAndBlobStorage) {
+  FieldValue string = FieldValue::FromString("abc");
+  const FieldValue string_copy = string;
+  EXPECT_EQ(&string.string_value(), &string_copy.string_value());
+
+  const FieldValue blob = FieldValue::FromBlob(Bytes("abc"), 4);
+  const FieldValue blob_copy = blob;
+  EXPECT_EQ(&blob.blob_value(), &blob_copy.blob_value());
+
+  const FieldValue string_moved = std::move(string);
+  EXPECT_EQ(&string_copy.string_value(), &string_moved.string_value());
+}
+
 TEST(FieldValue, ReferenceType) {
   const DatabaseId id("project", "database");
   const FieldValue a =
@@ -484,6 +584,55 @@ TEST(FieldValue, CompareWithOperator) {
   EXPECT_FALSE(small == large);
 }
 
+TEST(FieldValue, SortKeysMatchComparisons) {
+  const DatabaseId database1("p", "a");
+  const DatabaseId database2("p", "b");
+  std::vector<FieldValue> values = ValuesInOrder(&database1, &database2);
+
+  for (size_t i = 0; i < values.size(); ++i) {
+    for (size_t j = 0; j < values.size(); ++j) {
+      const FieldValue& left = values[i];
+      const FieldValue& right = values[j];
+      std::string left_key = left.SortKey();
+      std::string right_key = right.SortKey();
+      EXPECT_EQ(left < right, left_key < right_key) << i << " vs " << j;
+      EXPECT_EQ(!(left < right) && !(right < left), left_key == right_key)
+          << i << " vs " << j;
+    }
+  }
+}
+
+TEST(FieldValue, HashesAgreeWithEquality) {
+  const DatabaseId database1("p", "a");
+  const DatabaseId database2("p", "b");
+  std::vector<FieldValue> values = ValuesInOrder(&database1, &database2);
+
+  std::unordered_set<size_t> hashes;
+  size_t distinct_values = 0;
+  for (size_t i = 0; i < values.size(); ++i) {
+    bool seen = false;
+    for (size_t j = 0; j < values.size(); ++j) {
+      if (values[i] == values[j]) {
+        EXPECT_EQ(values[i].Hash(), values[j].Hash()) << i << " vs " << j;
+        seen = seen || j < i;
+      }
+    }
+    distinct_values += seen ? 0 : 1;
+    hashes.insert(values[i].Hash());
+  }
+  // Collisions aren't wrong, but there shouldn't be any among these values.
+  EXPECT_EQ(distinct_values, hashes.size());
+}
+
+TEST(FieldValue, SortKeysOfEqualNumbersAreEqual) {
+  EXPECT_EQ(FieldValue::FromInteger(1).SortKey(),
+            FieldValue::FromDouble(1.0).SortKey());
+  EXPECT_EQ(FieldValue::FromDouble(0.0).SortKey(),
+            FieldValue::FromDouble(-0.0).SortKey());
+  EXPECT_EQ(FieldValue::FromInteger(9007199254740992LL).SortKey(),
+            FieldValue::FromDouble(9007199254740992.0).SortKey());
+}
+
 TEST(FieldValue, Set) {
   // Set a field in an object.
   const ObjectValue value = ObjectValue::FromMap({
@@ -546,6 +695,56 @@ TEST(FieldValue, DeleteNothing) {
   EXPECT_EQ(value, value.Delete(testutil::Field("aa")));
 }
 
+TEST(FieldValue, BuilderMatchesSequentialEdits) {
+  const ObjectValue value = ObjectValue::FromMap({
+      {"a", FieldValue::FromString("A")},
+      {"b", FieldValue::FromMap({
+                {"ba", FieldValue::FromString("BA")},
+                {"bb", FieldValue::FromString("BB")},
+            })},
+      {"c", FieldValue::FromInteger(1)},
+  });
+  const FieldValue object = FieldValue::FromMap({
+      {"x", FieldValue::FromString("X")},
+  });
+
+  // Each edit sets a path to a value, or deletes it if there's no value.
+  using Edit = std::pair<std::string, absl::optional<FieldValue>>;
+  const std::vector<std::vector<Edit>> edit_sequences = {
+      {},
+      {{"a", FieldValue::FromString("A2")}, {"b.bc", FieldValue::Null()}},
+      {{"b.ba", absl::nullopt}, {"b.bb", absl::nullopt}, {"d", absl::nullopt}},
+      {{"c.d", absl::nullopt}, {"e.f", absl::nullopt}},
+      {{"c.d", FieldValue::True()}, {"e.f.g", FieldValue::False()}},
+      {{"a", FieldValue::True()}, {"a.b", FieldValue::False()}},
+      {{"a", FieldValue::True()}, {"a.b", absl::nullopt}},
+      {{"b.bc", FieldValue::True()},
+       {"b", object},
+       {"b.y", FieldValue::True()}},
+      {{"b", object}, {"b.x", absl::nullopt}},
+      {{"b", absl::nullopt}, {"b.ba", FieldValue::True()}},
+      {{"b.bc", FieldValue::True()}, {"b", absl::nullopt}},
+      {{"b.ba", absl::nullopt}, {"b", FieldValue::Null()}},
+      {{"e.f", FieldValue::True()}, {"e.g", absl::nullopt}},
+  };
+
+  for (const std::vector<Edit>& edits : edit_sequences) {
+    ObjectValue expected = value;
+    ObjectValue::Builder builder{value};
+    for (const Edit& edit : edits) {
+      FieldPath path = testutil::Field(edit.first);
+      if (edit.second) {
+        expected = expected.Set(path, *edit.second);
+        builder.Set(path, *edit.second);
+      } else {
+        expected = expected.Delete(path);
+        builder.Delete(path);
+      }
+    }
+    EXPECT_EQ(expected, builder.Build());
+  }
+}
+
 TEST(FieldValue, Get) {
   const ObjectValue value = ObjectValue::FromMap({
       {"a", FieldValue::FromString("A")},
@@ -571,6 +770,27 @@ TEST(FieldValue, GetNothing) {
   EXPECT_EQ(absl::nullopt, value.Get(testutil::Field("a.a")));
 }
 
+TEST(FieldValue, EstimatedByteSizeGrowsWithContents) {
+  const size_t scalar = FieldValue::FromInteger(1).EstimatedByteSize();
+  EXPECT_EQ(sizeof(FieldValue), scalar);
+  EXPECT_EQ(scalar, FieldValue::Null().EstimatedByteSize());
+
+  FieldValue short_string = FieldValue::FromString("a");
+  FieldValue long_string = FieldValue::FromString(std::string(1000, 'a'));
+  EXPECT_EQ(short_string.EstimatedByteSize() + 999,
+            long_string.EstimatedByteSize());
+
+  FieldValue array = FieldValue::FromArray({long_string, long_string});
+  EXPECT_GT(array.EstimatedByteSize(), 2 * long_string.EstimatedByteSize());
+
+  ObjectValue object = ObjectValue::FromMap({
+      {"a", long_string},
+      {"b", FieldValue::FromMap({{"c", array}})},
+  });
+  EXPECT_GT(object.EstimatedByteSize(),
+            long_string.EstimatedByteSize() + array.EstimatedByteSize());
+}
+
 TEST(FieldValue, IsSmallish) {
   // We expect the FV to use 4 bytes to track the type of the union, plus 8
   // bytes for the union contents themselves. The other 4 is for padding. We
@@ -72,6 +72,67 @@ TEST(ResourcePath, Comparison) {
   EXPECT_TRUE(ab > a);
 }
 
+TEST(ResourcePath, CompareTo) {
+  const ResourcePath empty;
+  const ResourcePath a{"a"};
+  const ResourcePath ab{"a", "b"};
+  const ResourcePath ac{"a", "c"};
+  const ResourcePath longer{"a", "bb"};
+
+  EXPECT_EQ(util::ComparisonResult::Same, empty.CompareTo(ResourcePath{}));
+  EXPECT_EQ(util::ComparisonResult::Same, ab.CompareTo(ResourcePath{"a", "b"}));
+  EXPECT_EQ(util::ComparisonResult::Same, ab.CompareTo(ab));
+
+  EXPECT_EQ(util::ComparisonResult::Ascending, empty.CompareTo(a));
+  EXPECT_EQ(util::ComparisonResult::Ascending, a.CompareTo(ab));
+  EXPECT_EQ(util::ComparisonResult::Ascending, ab.CompareTo(ac));
+  EXPECT_EQ(util::ComparisonResult::Ascending, ab.CompareTo(longer));
+
+  EXPECT_EQ(util::ComparisonResult::Descending, ab.CompareTo(a));
+  EXPECT_EQ(util::ComparisonResult::Descending, ac.CompareTo(ab));
+
+  // Paths sharing storage compare by length alone.
+  EXPECT_EQ(util::ComparisonResult::Ascending, ab.PopLast().CompareTo(ab));
+  EXPECT_EQ(util::ComparisonResult::Same, ab.PopLast().CompareTo(a));
+}
+
+TEST(ResourcePath, DerivedPathsShareSegments) {
+  const ResourcePath path{"rooms", "Eros", "messages", "1"};
+
+  const ResourcePath parent = path.PopLast();
+  EXPECT_EQ(&path[0], &parent[0]);
+  EXPECT_EQ((ResourcePath{"rooms", "Eros", "messages"}), parent);
+  EXPECT_TRUE(parent.IsPrefixOf(path));
+  EXPECT_TRUE(parent.IsImmediateParentOf(path));
+  EXPECT_TRUE(parent < path);
+
+  const ResourcePath tail = path.PopFirst(2);
+  EXPECT_EQ(&path[2], &tail[0]);
+  EXPECT_EQ((ResourcePath{"messages", "1"}), tail);
+  EXPECT_FALSE(tail.IsPrefixOf(path));
+  EXPECT_EQ("messages/1", tail.CanonicalString());
+
+  // Slices that start at different segments of the same storage still compare
+  // by their contents.
+  const ResourcePath repeated{"a", "a", "a"};
+  EXPECT_EQ(repeated.PopFirst(), repeated.PopLast());
+  EXPECT_TRUE(repeated.PopFirst().PopLast().IsPrefixOf(repeated.PopFirst(2)));
+
+  // Slices that would leave most of the storage unused copy their segments
+  // instead of keeping it alive.
+  const ResourcePath root = parent.PopLast().PopLast();
+  EXPECT_NE(&path[0], &root[0]);
+  EXPECT_EQ(ResourcePath{"rooms"}, root);
+  const ResourcePath last = path.PopFirst(3);
+  EXPECT_NE(&path[3], &last[0]);
+  EXPECT_EQ(ResourcePath{"1"}, last);
+
+  EXPECT_EQ(ResourcePath::Empty(), path.PopFirst(4));
+  EXPECT_EQ((ResourcePath{"rooms", "Eros", "messages", "2"}),
+            parent.Append("2"));
+  EXPECT_EQ(path, parent.Append(tail.PopFirst()));
+}
+
 TEST(ResourcePath, Parsing) {
   const auto parse = [](const std::pair<std::string, size_t> expected) {
     const auto path = ResourcePath::FromString(expected.first);
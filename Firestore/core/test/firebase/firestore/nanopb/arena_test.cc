@@ -0,0 +1,124 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/nanopb/arena.h"
+
+#include <cstring>
+
+#include "Firestore/core/src/firebase/firestore/nanopb/pb_system.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+
+TEST(ArenaTest, ReallocateKeepsContents) {
+  Arena arena;
+  auto* first = static_cast<char*>(arena.Reallocate(nullptr, 4));
+  std::memcpy(first, "abc", 4);
+
+  // Allocate in between so that growing can't happen in place.
+  arena.Reallocate(nullptr, 16);
+
+  auto* grown = static_cast<char*>(arena.Reallocate(first, 1000));
+  EXPECT_NE(first, grown);
+  EXPECT_STREQ("abc", grown);
+}
+
+TEST(ArenaTest, GrowsLastAllocationInPlace) {
+  Arena arena;
+  void* ptr = arena.Reallocate(nullptr, 8);
+  EXPECT_EQ(ptr, arena.Reallocate(ptr, 100));
+  EXPECT_EQ(ptr, arena.Reallocate(ptr, 50));
+}
+
+TEST(ArenaTest, Owns) {
+  Arena arena;
+  int on_stack = 0;
+  EXPECT_FALSE(arena.Owns(&on_stack));
+
+  void* small = arena.Reallocate(nullptr, 8);
+  void* large = arena.Reallocate(nullptr, 100000);
+  EXPECT_TRUE(arena.Owns(small));
+  EXPECT_TRUE(arena.Owns(large));
+  EXPECT_FALSE(arena.Owns(&on_stack));
+}
+
+TEST(ArenaTest, ResetReusesLargestBlock) {
+  Arena arena;
+  EXPECT_EQ(0u, arena.capacity());
+
+  void* first = arena.Reallocate(nullptr, 8);
+  arena.Reallocate(nullptr, 100000);
+  size_t capacity = arena.capacity();
+
+  arena.Reset();
+  EXPECT_LT(arena.capacity(), capacity);
+  void* small = arena.Reallocate(nullptr, 8);
+  EXPECT_NE(first, small);
+  EXPECT_TRUE(arena.Owns(small));
+
+  arena.Reset();
+  EXPECT_EQ(small, arena.Reallocate(nullptr, 8));
+}
+
+TEST(ArenaTest, ScopeSetsCurrent) {
+  EXPECT_EQ(nullptr, Arena::Current());
+  if (!Arena::IsSupported()) {
+    return;
+  }
+
+  Arena outer;
+  Arena inner;
+  {
+    Arena::Scope outer_scope{&outer};
+    EXPECT_EQ(&outer, Arena::Current());
+    {
+      Arena::Scope inner_scope{&inner};
+      EXPECT_EQ(&inner, Arena::Current());
+    }
+    EXPECT_EQ(&outer, Arena::Current());
+  }
+  EXPECT_EQ(nullptr, Arena::Current());
+}
+
+TEST(ArenaTest, HooksAllocateFromCurrentArena) {
+  if (!Arena::IsSupported()) {
+    return;
+  }
+
+  void* heap = firebase_firestore_nanopb_realloc(nullptr, 8);
+
+  Arena arena;
+  {
+    Arena::Scope scope{&arena};
+    void* ptr = firebase_firestore_nanopb_realloc(nullptr, 8);
+    EXPECT_TRUE(arena.Owns(ptr));
+    ptr = firebase_firestore_nanopb_realloc(ptr, 64);
+    EXPECT_TRUE(arena.Owns(ptr));
+    firebase_firestore_nanopb_free(ptr);
+
+    // Memory allocated outside the arena is still freed normally.
+    heap = firebase_firestore_nanopb_realloc(heap, 16);
+    EXPECT_FALSE(arena.Owns(heap));
+  }
+
+  firebase_firestore_nanopb_free(heap);
+}
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/nanopb/wire_reader.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+
+namespace {
+
+// Field 1 (varint) = 150, field 2 (string) = "ab", field 3 (fixed64), field 4
+// (fixed32), field 2 (string) = "cd".
+const char kMessage[] =
+    "\x08\x96\x01"
+    "\x12\x02"
+    "ab"
+    "\x19\x01\x02\x03\x04\x05\x06\x07\x08"
+    "\x25\x01\x02\x03\x04"
+    "\x12\x02"
+    "cd";
+
+absl::string_view Message() {
+  return absl::string_view{kMessage, sizeof(kMessage) - 1};
+}
+
+}  // namespace
+
+TEST(WireReader, ReadsTags) {
+  WireReader reader{Message()};
+  uint32_t field_number = 0;
+  pb_wire_type_t wire_type = PB_WT_VARINT;
+
+  ASSERT_TRUE(reader.ReadTag(&field_number, &wire_type));
+  EXPECT_EQ(1u, field_number);
+  EXPECT_EQ(PB_WT_VARINT, wire_type);
+  reader.SkipField(wire_type);
+
+  ASSERT_TRUE(reader.ReadTag(&field_number, &wire_type));
+  EXPECT_EQ(2u, field_number);
+  EXPECT_EQ(PB_WT_STRING, wire_type);
+  EXPECT_EQ("ab", reader.ReadLengthDelimited());
+
+  ASSERT_TRUE(reader.ReadTag(&field_number, &wire_type));
+  EXPECT_EQ(3u, field_number);
+  EXPECT_EQ(PB_WT_64BIT, wire_type);
+  reader.SkipField(wire_type);
+
+  ASSERT_TRUE(reader.ReadTag(&field_number, &wire_type));
+  EXPECT_EQ(4u, field_number);
+  EXPECT_EQ(PB_WT_32BIT, wire_type);
+  reader.SkipField(wire_type);
+
+  ASSERT_TRUE(reader.ReadTag(&field_number, &wire_type));
+  EXPECT_EQ(2u, field_number);
+  EXPECT_EQ("cd", reader.ReadLengthDelimited());
+
+  EXPECT_FALSE(reader.ReadTag(&field_number, &wire_type));
+  EXPECT_TRUE(reader.ok());
+}
+
+TEST(WireReader, FailsOnTruncatedInput) {
+  absl::string_view message = Message();
+  // Cut the first string field short.
+  WireReader reader{message.substr(0, 5)};
+  uint32_t field_number = 0;
+  pb_wire_type_t wire_type = PB_WT_VARINT;
+
+  ASSERT_TRUE(reader.ReadTag(&field_number, &wire_type));
+  reader.SkipField(wire_type);
+  ASSERT_TRUE(reader.ReadTag(&field_number, &wire_type));
+  EXPECT_EQ("", reader.ReadLengthDelimited());
+  EXPECT_FALSE(reader.ok());
+  EXPECT_FALSE(reader.ReadTag(&field_number, &wire_type));
+}
+
+TEST(WireReader, FailsOnGroups) {
+  // Field 1, wire type 3 (start group).
+  WireReader reader{"\x0b"};
+  uint32_t field_number = 0;
+  pb_wire_type_t wire_type = PB_WT_VARINT;
+
+  ASSERT_TRUE(reader.ReadTag(&field_number, &wire_type));
+  reader.SkipField(wire_type);
+  EXPECT_FALSE(reader.ok());
+}
+
+TEST(FindLengthDelimitedField, ReturnsLastOccurrence) {
+  EXPECT_EQ("cd", FindLengthDelimitedField(Message(), 2));
+}
+
+TEST(FindLengthDelimitedField, IgnoresOtherWireTypes) {
+  EXPECT_EQ(absl::nullopt, FindLengthDelimitedField(Message(), 1));
+  EXPECT_EQ(absl::nullopt, FindLengthDelimitedField(Message(), 5));
+}
+
+TEST(FindLengthDelimitedField, FailsOnMalformedInput) {
+  EXPECT_EQ(absl::nullopt,
+            FindLengthDelimitedField(Message().substr(0, 5), 2));
+}
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
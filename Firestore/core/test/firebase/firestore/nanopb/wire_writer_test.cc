@@ -0,0 +1,98 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/nanopb/wire_writer.h"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/nanopb/wire_reader.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+
+TEST(WireWriter, WritesFields) {
+  std::string bytes;
+  WireWriter writer{&bytes};
+  writer.WriteTag(1, PB_WT_VARINT);
+  writer.WriteVarint(150);
+  writer.WriteTag(2, PB_WT_STRING);
+  writer.WriteLengthDelimited("ab");
+  writer.WriteTag(3, PB_WT_64BIT);
+  writer.WriteFixed64(0x0807060504030201ULL);
+
+  const char expected[] =
+      "\x08\x96\x01"
+      "\x12\x02"
+      "ab"
+      "\x19\x01\x02\x03\x04\x05\x06\x07\x08";
+  EXPECT_EQ(std::string(expected, sizeof(expected) - 1), bytes);
+}
+
+TEST(WireWriter, SizesMatchWrittenBytes) {
+  const uint64_t values[] = {0,
+                             1,
+                             127,
+                             128,
+                             16383,
+                             16384,
+                             static_cast<uint64_t>(-1),
+                             std::numeric_limits<uint64_t>::max() >> 1};
+  for (uint64_t value : values) {
+    std::string bytes;
+    WireWriter writer{&bytes};
+    writer.WriteVarint(value);
+    EXPECT_EQ(bytes.size(), WireWriter::VarintSize(value)) << value;
+  }
+
+  for (uint32_t field_number : {1u, 15u, 16u, 2047u, 2048u}) {
+    std::string bytes;
+    WireWriter writer{&bytes};
+    writer.WriteTag(field_number, PB_WT_STRING);
+    writer.WriteLengthDelimited(std::string(200, 'x'));
+    EXPECT_EQ(bytes.size(),
+              WireWriter::LengthDelimitedFieldSize(field_number, 200));
+  }
+}
+
+TEST(WireWriter, RoundTripsThroughWireReader) {
+  std::string bytes;
+  WireWriter writer{&bytes};
+  writer.WriteTag(17, PB_WT_STRING);
+  writer.WriteLengthDelimited("value");
+  writer.WriteTag(2, PB_WT_VARINT);
+  writer.WriteVarint(static_cast<uint64_t>(-5));
+
+  WireReader reader{bytes};
+  uint32_t field_number = 0;
+  pb_wire_type_t wire_type = PB_WT_VARINT;
+  ASSERT_TRUE(reader.ReadTag(&field_number, &wire_type));
+  EXPECT_EQ(17u, field_number);
+  EXPECT_EQ("value", reader.ReadLengthDelimited());
+  ASSERT_TRUE(reader.ReadTag(&field_number, &wire_type));
+  EXPECT_EQ(2u, field_number);
+  EXPECT_EQ(PB_WT_VARINT, wire_type);
+  reader.SkipField(wire_type);
+  EXPECT_FALSE(reader.ReadTag(&field_number, &wire_type));
+  EXPECT_TRUE(reader.ok());
+}
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/bloom_filter.h"
+
+#include <string>
+
+#include "Firestore/core/include/firebase/firestore/firestore_errors.h"
+#include "absl/strings/str_cat.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+namespace {
+
+const char* kPrefix = "projects/p/databases/d/documents/";
+
+std::string Name(const std::string& path) {
+  return absl::StrCat(kPrefix, path);
+}
+
+// Golden bitmaps, computed independently from the MD5 digests of the inserted
+// names.
+
+/** 100 bits (padding 4), 3 hashes, containing coll/a and coll/b. */
+const char kTwoDocuments[] =
+    "\x04\x04\x02\x00\x40\x00\x00\x00\x80\x00\x04\x00\x00";
+
+/** 64 bits, 7 hashes, containing a name that spans several MD5 blocks. */
+const char kLongName[] = "\x80\x80\x80\x00\x80\x80\x80\x80";
+
+std::string LongName() {
+  std::string path;
+  for (int i = 0; i < 5; ++i) {
+    absl::StrAppend(&path, i == 0 ? "" : "/", "collection", i, "/document", i);
+  }
+  return Name(path);
+}
+
+BloomFilter Create(const char* bitmap,
+                   size_t size,
+                   int32_t padding,
+                   int32_t hash_count) {
+  auto maybe_filter =
+      BloomFilter::Create(std::string(bitmap, size), padding, hash_count);
+  EXPECT_TRUE(maybe_filter.ok());
+  return maybe_filter.ValueOrDie();
+}
+
+}  // namespace
+
+TEST(BloomFilterTest, ContainsInsertedNames) {
+  BloomFilter filter = Create(kTwoDocuments, sizeof(kTwoDocuments) - 1, 4, 3);
+  EXPECT_EQ(filter.bit_count(), 100);
+  EXPECT_EQ(filter.hash_count(), 3);
+
+  EXPECT_TRUE(filter.MightContain(Name("coll/a")));
+  EXPECT_TRUE(filter.MightContain(Name("coll/b")));
+}
+
+TEST(BloomFilterTest, RejectsNamesThatWereNotInserted) {
+  BloomFilter filter = Create(kTwoDocuments, sizeof(kTwoDocuments) - 1, 4, 3);
+
+  for (char id = 'c'; id <= 'p'; ++id) {
+    EXPECT_FALSE(filter.MightContain(Name(std::string("coll/") + id))) << id;
+  }
+}
+
+TEST(BloomFilterTest, HashesNamesLongerThanOneBlock) {
+  BloomFilter filter = Create(kLongName, sizeof(kLongName) - 1, 0, 7);
+
+  EXPECT_TRUE(filter.MightContain(LongName()));
+  EXPECT_FALSE(filter.MightContain(Name("coll/a")));
+}
+
+TEST(BloomFilterTest, EmptyFilterContainsNothing) {
+  BloomFilter filter = Create("", 0, 0, 0);
+  EXPECT_EQ(filter.bit_count(), 0);
+  EXPECT_FALSE(filter.MightContain(Name("coll/a")));
+  EXPECT_FALSE(filter.MightContain(""));
+}
+
+TEST(BloomFilterTest, FullFilterContainsEverything) {
+  BloomFilter filter = Create("\xff\xff", 2, 1, 5);
+  EXPECT_EQ(filter.bit_count(), 15);
+  EXPECT_TRUE(filter.MightContain(Name("coll/a")));
+  EXPECT_TRUE(filter.MightContain(LongName()));
+}
+
+TEST(BloomFilterTest, RejectsInvalidParameters) {
+  EXPECT_EQ(BloomFilter::Create("\x01", -1, 1).status().code(),
+            FirestoreErrorCode::InvalidArgument);
+  EXPECT_EQ(BloomFilter::Create("\x01", 8, 1).status().code(),
+            FirestoreErrorCode::InvalidArgument);
+  EXPECT_EQ(BloomFilter::Create("\x01", 0, -1).status().code(),
+            FirestoreErrorCode::InvalidArgument);
+  EXPECT_EQ(BloomFilter::Create("\x01", 0, 0).status().code(),
+            FirestoreErrorCode::InvalidArgument);
+  EXPECT_EQ(BloomFilter::Create("", 1, 1).status().code(),
+            FirestoreErrorCode::InvalidArgument);
+}
+
+TEST(BloomFilterTest, Equality) {
+  BloomFilter filter = Create(kTwoDocuments, sizeof(kTwoDocuments) - 1, 4, 3);
+  EXPECT_EQ(filter, Create(kTwoDocuments, sizeof(kTwoDocuments) - 1, 4, 3));
+  EXPECT_NE(filter, Create(kTwoDocuments, sizeof(kTwoDocuments) - 1, 3, 3));
+  EXPECT_NE(filter, Create(kTwoDocuments, sizeof(kTwoDocuments) - 1, 4, 2));
+  EXPECT_NE(filter, BloomFilter{});
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
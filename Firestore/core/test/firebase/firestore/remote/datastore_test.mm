@@ -240,6 +240,37 @@ TEST_F(DatastoreTest, LookupDocumentsTwoSuccessfulReads) {
   EXPECT_TRUE(resulting_status.ok());
 }
 
+TEST_F(DatastoreTest, LookupDocumentsStreamingDeliversDocumentsEarly) {
+  std::vector<std::string> streamed_keys;
+  bool done = false;
+  Status resulting_status;
+  datastore->LookupDocumentsStreaming(
+      {},
+      [&](FSTMaybeDocument* doc) {
+        streamed_keys.push_back(doc.key.ToString());
+      },
+      [&](const Status& status) {
+        done = true;
+        resulting_status = status;
+      });
+  // Make sure Auth has a chance to run.
+  worker_queue.EnqueueBlocking([] {});
+
+  ForceFinishAnyTypeOrder({{Type::Write, Ok},
+                           {Type::Read, MakeFakeDocument("foo/2")},
+                           {Type::Read, MakeFakeDocument("foo/1")},
+                           /*Read after last*/ {Type::Read, Error}});
+  EXPECT_FALSE(done);
+  ASSERT_EQ(streamed_keys.size(), 2);
+  EXPECT_EQ(streamed_keys[0], "foo/2");
+  EXPECT_EQ(streamed_keys[1], "foo/1");
+
+  ForceFinish({{Type::Finish, grpc::Status::OK}});
+
+  EXPECT_TRUE(done);
+  EXPECT_TRUE(resulting_status.ok());
+}
+
 // gRPC errors
 
 TEST_F(DatastoreTest, CommitMutationsError) {
@@ -184,6 +184,24 @@ TEST_F(GrpcConnectionTest, ConnectivityChangeWithSeveralActiveCalls) {
   EXPECT_EQ(changes_count, 3);
 }
 
+TEST_F(GrpcConnectionTest, CompressionAppliesToNewCalls) {
+  ConnectivityObserver observer;
+
+  std::unique_ptr<GrpcStream> plain_stream = tester.CreateStream(&observer);
+  EXPECT_EQ(plain_stream->context()->compression_algorithm(),
+            GRPC_COMPRESS_NONE);
+
+  tester.grpc_connection()->set_compression_enabled(true);
+  std::unique_ptr<GrpcStream> stream = tester.CreateStream(&observer);
+  std::unique_ptr<GrpcUnaryCall> unary_call = tester.CreateUnaryCall();
+  EXPECT_EQ(stream->context()->compression_algorithm(), GRPC_COMPRESS_GZIP);
+  EXPECT_EQ(unary_call->context()->compression_algorithm(),
+            GRPC_COMPRESS_GZIP);
+  // Existing calls are unaffected.
+  EXPECT_EQ(plain_stream->context()->compression_algorithm(),
+            GRPC_COMPRESS_NONE);
+}
+
 TEST_F(GrpcConnectionTest, ShutdownFastFinishesActiveCalls) {
   class NoFinishObserver : public GrpcStreamObserver {
    public:
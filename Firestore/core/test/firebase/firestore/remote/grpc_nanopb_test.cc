@@ -0,0 +1,87 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/grpc_nanopb.h"
+
+#include <string>
+#include <vector>
+
+#include "Firestore/Protos/nanopb/google/protobuf/timestamp.nanopb.h"
+#include "grpcpp/support/byte_buffer.h"
+#include "grpcpp/support/slice.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+namespace {
+
+// A google.protobuf.Timestamp with seconds = 150 and nanos = 5.
+const char kTimestamp[] = "\x08\x96\x01\x10\x05";
+
+grpc::ByteBuffer MakeByteBuffer(const std::vector<std::string>& parts) {
+  std::vector<grpc::Slice> slices;
+  for (const std::string& part : parts) {
+    slices.emplace_back(part);
+  }
+  return grpc::ByteBuffer{slices.data(), slices.size()};
+}
+
+}  // namespace
+
+TEST(ByteBufferReaderTest, ReadsSingleSlice) {
+  ByteBufferReader reader{MakeByteBuffer({kTimestamp})};
+
+  google_protobuf_Timestamp timestamp{};
+  reader.reader()->ReadNanopbMessage(google_protobuf_Timestamp_fields,
+                                     &timestamp);
+  ASSERT_TRUE(reader.reader()->status().ok());
+  EXPECT_EQ(150, timestamp.seconds);
+  EXPECT_EQ(5, timestamp.nanos);
+}
+
+TEST(ByteBufferReaderTest, ReadsAcrossSlices) {
+  // The first varint is split between slices, and there's an empty slice.
+  ByteBufferReader reader{
+      MakeByteBuffer({"\x08", "\x96", "", "\x01\x10", "\x05"})};
+
+  google_protobuf_Timestamp timestamp{};
+  reader.reader()->ReadNanopbMessage(google_protobuf_Timestamp_fields,
+                                     &timestamp);
+  ASSERT_TRUE(reader.reader()->status().ok());
+  EXPECT_EQ(150, timestamp.seconds);
+  EXPECT_EQ(5, timestamp.nanos);
+}
+
+TEST(ByteBufferReaderTest, FailsOnTruncatedMessage) {
+  ByteBufferReader reader{MakeByteBuffer({"\x08", "\x96"})};
+
+  google_protobuf_Timestamp timestamp{};
+  reader.reader()->ReadNanopbMessage(google_protobuf_Timestamp_fields,
+                                     &timestamp);
+  EXPECT_FALSE(reader.reader()->status().ok());
+}
+
+TEST(ByteBufferReaderTest, FailsOnInvalidByteBuffer) {
+  grpc::ByteBuffer uninitialized;
+  ByteBufferReader reader{uninitialized};
+  EXPECT_FALSE(reader.reader()->status().ok());
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/grpc_shared_resources.h"
+
+#include <memory>
+
+#include "Firestore/core/src/firebase/firestore/util/executor_std.h"
+#include "absl/memory/memory.h"
+#include "grpcpp/create_channel.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using util::Executor;
+using util::ExecutorStd;
+
+namespace {
+
+std::unique_ptr<Executor> CreateExecutor() {
+  return absl::make_unique<ExecutorStd>();
+}
+
+std::shared_ptr<grpc::Channel> CreateChannel() {
+  return grpc::CreateChannel("localhost:1", grpc::InsecureChannelCredentials());
+}
+
+}  // namespace
+
+TEST(GrpcSharedResourcesTest, SharesResourcesForTheSameHost) {
+  auto foo1 = GrpcSharedResources::Acquire("foo.host", CreateExecutor);
+  auto foo2 = GrpcSharedResources::Acquire("foo.host", CreateExecutor);
+  auto bar = GrpcSharedResources::Acquire("bar.host", CreateExecutor);
+
+  EXPECT_EQ(foo1, foo2);
+  EXPECT_NE(foo1, bar);
+}
+
+TEST(GrpcSharedResourcesTest, ReleasesResourcesOnceUnused) {
+  auto resources = GrpcSharedResources::Acquire("foo.host", CreateExecutor);
+  std::weak_ptr<GrpcSharedResources> weak_resources = resources;
+  resources->StartPolling();
+  resources.reset();
+  EXPECT_TRUE(weak_resources.expired());
+
+  int executors_created = 0;
+  resources = GrpcSharedResources::Acquire("foo.host", [&] {
+    ++executors_created;
+    return CreateExecutor();
+  });
+  EXPECT_EQ(executors_created, 1);
+}
+
+TEST(GrpcSharedResourcesTest, UnsharedResourcesAreNotPooled) {
+  auto pooled = GrpcSharedResources::Acquire("foo.host", CreateExecutor);
+  auto unshared = GrpcSharedResources::CreateUnshared(CreateExecutor());
+  EXPECT_NE(pooled, unshared);
+  EXPECT_NE(pooled->queue(), unshared->queue());
+}
+
+TEST(GrpcSharedResourcesTest, StartPollingIsIdempotent) {
+  auto resources = GrpcSharedResources::CreateUnshared(CreateExecutor());
+  resources->StartPolling();
+  resources->StartPolling();
+  // Destroying the resources shuts down the queue and waits for polling to
+  // finish.
+  EXPECT_NO_THROW(resources.reset());
+}
+
+TEST(GrpcSharedResourcesTest, SharesChannel) {
+  auto resources = GrpcSharedResources::CreateUnshared(CreateExecutor());
+
+  int channels_created = 0;
+  auto create_channel = [&] {
+    ++channels_created;
+    return CreateChannel();
+  };
+
+  std::shared_ptr<grpc::Channel> channel1 =
+      resources->GetChannel(create_channel);
+  std::shared_ptr<grpc::Channel> channel2 =
+      resources->GetChannel(create_channel);
+  EXPECT_EQ(channel1, channel2);
+  EXPECT_EQ(channels_created, 1);
+}
+
+TEST(GrpcSharedResourcesTest, ResetChannelOnlyResetsTheCurrentChannel) {
+  auto resources = GrpcSharedResources::CreateUnshared(CreateExecutor());
+
+  std::shared_ptr<grpc::Channel> old_channel =
+      resources->GetChannel(CreateChannel);
+  resources->ResetChannel(old_channel);
+  std::shared_ptr<grpc::Channel> new_channel =
+      resources->GetChannel(CreateChannel);
+  EXPECT_NE(old_channel, new_channel);
+
+  // Resetting a stale channel doesn't affect the current one.
+  resources->ResetChannel(old_channel);
+  EXPECT_EQ(resources->GetChannel(CreateChannel), new_channel);
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -19,6 +19,7 @@
 #include <functional>
 #include <initializer_list>
 #include <memory>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -244,6 +245,48 @@ TEST_F(GrpcStreamTest, CanAddSeveralWrites) {
   EXPECT_EQ(observed_states().back(), "OnStreamRead");
 }
 
+TEST_F(GrpcStreamTest, ReusesCompletions) {
+  worker_queue.EnqueueBlocking([&] { stream->Start(); });
+
+  std::set<const GrpcCompletion*> completions;
+  int reads = 0;
+  ForceFinish([&](GrpcCompletion* completion) {
+    switch (completion->type()) {
+      case Type::Read:
+        completions.insert(completion);
+        *completion->message() = MakeByteBuffer("foo");
+        completion->Complete(true);
+        break;
+      default:
+        UnexpectedType(completion);
+        break;
+    }
+    return ++reads == 10;
+  });
+
+  // Each read is issued while the previous one's callback runs.
+  EXPECT_LE(completions.size(), 2u);
+  EXPECT_EQ(observed_states().size(), 11u);
+}
+
+TEST_F(GrpcStreamTest, RecordsTrafficStats) {
+  worker_queue.EnqueueBlocking([&] { stream->Start(); });
+  worker_queue.EnqueueBlocking([&] { stream->Write(MakeByteBuffer("foo")); });
+
+  tester.ForceFinishAnyTypeOrder(
+      stream->context(), {{Type::Write, CompletionResult::Ok},
+                          {Type::Read, MakeByteBuffer("foobar")}});
+
+  worker_queue.EnqueueBlocking([&] {
+    const GrpcTrafficStats& stats = tester.grpc_connection()->traffic_stats();
+    EXPECT_EQ(stats.messages_sent, 1);
+    EXPECT_EQ(stats.bytes_sent, 3);
+    EXPECT_EQ(stats.bytes_sent_with_compression, 0);
+    EXPECT_EQ(stats.messages_received, 1);
+    EXPECT_EQ(stats.bytes_received, 6);
+  });
+}
+
 // Observer
 
 TEST_F(GrpcStreamTest, ObserverReceivesOnStart) {
@@ -483,6 +526,33 @@ TEST_F(GrpcStreamTest, DoubleFinish_FailThenFailAgain) {
   ForceFinish({{Type::Finish, CompletionResult::Error}});
 }
 
+TEST(BufferedWriterTest, CorksWritesQueuedBehindOthers) {
+  internal::BufferedWriter writer;
+  absl::optional<internal::BufferedWrite> write =
+      writer.EnqueueWrite(MakeByteBuffer("foo"));
+  ASSERT_TRUE(write.has_value());
+  EXPECT_FALSE(write->options.get_buffer_hint());
+
+  EXPECT_FALSE(writer.EnqueueWrite(MakeByteBuffer("bar")).has_value());
+  grpc::WriteOptions last;
+  last.set_last_message();
+  EXPECT_FALSE(writer.EnqueueWrite(MakeByteBuffer("baz"), last).has_value());
+
+  // Only the last of the queued writes has to flush.
+  write = writer.DequeueNextWrite();
+  ASSERT_TRUE(write.has_value());
+  EXPECT_EQ(ByteBufferToString(write->message), "bar");
+  EXPECT_TRUE(write->options.get_buffer_hint());
+
+  write = writer.DequeueNextWrite();
+  ASSERT_TRUE(write.has_value());
+  EXPECT_EQ(ByteBufferToString(write->message), "baz");
+  EXPECT_FALSE(write->options.get_buffer_hint());
+  EXPECT_TRUE(write->options.is_last_message());
+
+  EXPECT_FALSE(writer.DequeueNextWrite().has_value());
+}
+
 }  // namespace remote
 }  // namespace firestore
 }  // namespace firebase
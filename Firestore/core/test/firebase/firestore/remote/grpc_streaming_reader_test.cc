@@ -16,6 +16,7 @@
 
 #include <initializer_list>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -183,6 +184,41 @@ TEST_F(GrpcStreamingReaderTest, TwoSuccessfulReads) {
   EXPECT_EQ(ByteBufferToString(responses[1]), std::string{"bar"});
 }
 
+TEST_F(GrpcStreamingReaderTest, MessageCallbackReceivesEachRead) {
+  std::vector<std::string> streamed;
+  worker_queue.EnqueueBlocking([&] {
+    reader->Start(
+        [&](const grpc::ByteBuffer& message) {
+          streamed.push_back(ByteBufferToString(message));
+        },
+        [this](const StatusOr<std::vector<grpc::ByteBuffer>>& result) {
+          status = result.status();
+          if (status->ok()) {
+            responses = result.ValueOrDie();
+          }
+        });
+  });
+
+  ForceFinishAnyTypeOrder({
+      {Type::Write, CompletionResult::Ok},
+      {Type::Read, MakeByteBuffer("foo")},
+      {Type::Read, MakeByteBuffer("bar")},
+      /*Read after last*/ {Type::Read, CompletionResult::Error},
+  });
+
+  // Responses are delivered before the call finishes.
+  EXPECT_FALSE(status.has_value());
+  ASSERT_EQ(streamed.size(), 2);
+  EXPECT_EQ(streamed[0], std::string{"foo"});
+  EXPECT_EQ(streamed[1], std::string{"bar"});
+
+  ForceFinish({{Type::Finish, grpc::Status::OK}});
+
+  ASSERT_TRUE(status.has_value());
+  EXPECT_EQ(status.value(), Status::OK());
+  EXPECT_TRUE(responses.empty());
+}
+
 TEST_F(GrpcStreamingReaderTest, FinishWhileReading) {
   StartReader();
 
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/memory_pressure_monitor.h"
+
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/executor_std.h"
+#include "absl/memory/memory.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using util::AsyncQueue;
+using util::ExecutorStd;
+using Level = MemoryPressureMonitor::Level;
+
+namespace {
+
+class FakeMemoryPressureMonitor : public MemoryPressureMonitor {
+ public:
+  using MemoryPressureMonitor::InvokeCallbacks;
+  using MemoryPressureMonitor::MemoryPressureMonitor;
+};
+
+}  // namespace
+
+class MemoryPressureMonitorTest : public testing::Test {
+ public:
+  MemoryPressureMonitorTest() : queue{absl::make_unique<ExecutorStd>()} {
+  }
+
+  AsyncQueue queue;
+};
+
+TEST_F(MemoryPressureMonitorTest, InvokesEveryCallbackWithTheLevel) {
+  FakeMemoryPressureMonitor monitor{&queue};
+  std::vector<Level> first;
+  std::vector<Level> second;
+  monitor.AddCallback([&](Level level) { first.push_back(level); });
+  monitor.AddCallback([&](Level level) { second.push_back(level); });
+
+  queue.EnqueueBlocking([&] {
+    monitor.InvokeCallbacks(Level::Warning);
+    monitor.InvokeCallbacks(Level::Critical);
+  });
+
+  EXPECT_EQ(first, (std::vector<Level>{Level::Warning, Level::Critical}));
+  EXPECT_EQ(second, first);
+}
+
+TEST_F(MemoryPressureMonitorTest, CanBeCreatedForThePlatform) {
+  auto monitor = MemoryPressureMonitor::Create(&queue);
+  ASSERT_NE(monitor, nullptr);
+  monitor->AddCallback([](Level) {});
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
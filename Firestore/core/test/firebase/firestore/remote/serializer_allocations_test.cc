@@ -0,0 +1,50 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/serializer.h"
+
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
+#include "Firestore/core/test/firebase/firestore/testutil/allocation_counter.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using model::SnapshotVersion;
+using nanopb::Reader;
+using testutil::AllocationCounter;
+
+TEST(SerializerAllocations, DecodesVersionsWithoutAllocating) {
+  // Every decoded document and watch change carries a version, so decoding
+  // one must stay allocation-free.
+  google_protobuf_Timestamp proto =
+      Serializer::EncodeVersion(testutil::Version(1234567));
+  Reader reader = Reader::Wrap(nullptr, 0);
+
+  AllocationCounter allocations;
+  SnapshotVersion version = Serializer::DecodeSnapshotVersion(&reader, proto);
+  EXPECT_EQ(allocations.count(), 0);
+
+  EXPECT_TRUE(reader.status().ok());
+  EXPECT_EQ(testutil::Version(1234567), version);
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
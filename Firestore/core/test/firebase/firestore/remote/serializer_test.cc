@@ -30,6 +30,8 @@
 #include <pb.h>
 #include <pb_encode.h>
 #include <limits>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "Firestore/Protos/cpp/google/firestore/v1/document.pb.h"
@@ -651,6 +653,50 @@ TEST_F(SerializerTest, EncodesNestedObjects) {
   ExpectRoundTrip(model, proto, FieldValue::Type::Object);
 }
 
+TEST_F(SerializerTest, EncodesFieldValueBytesLikeNanopb) {
+  std::vector<FieldValue> values{
+      FieldValue::Null(),
+      FieldValue::True(),
+      FieldValue::False(),
+      FieldValue::FromInteger(0),
+      FieldValue::FromInteger(-1),
+      FieldValue::FromInteger(std::numeric_limits<int64_t>::min()),
+      FieldValue::FromDouble(0.0),
+      FieldValue::FromDouble(-0.0),
+      FieldValue::FromDouble(1.5),
+      FieldValue::Nan(),
+      FieldValue::FromTimestamp({0, 0}),
+      FieldValue::FromTimestamp({-5, 7}),
+      FieldValue::FromString(""),
+      FieldValue::FromString(std::string(200, 'x')),
+      FieldValue::FromBlob(nullptr, 0),
+      FieldValue::FromBlob(reinterpret_cast<const uint8_t*>("\0\1"), 2),
+      FieldValue::FromGeoPoint({0, 0}),
+      FieldValue::FromGeoPoint({1.5, -2}),
+      FieldValue::FromArray({}),
+      FieldValue::EmptyObject(),
+      FieldValue::FromMap({
+          {"", FieldValue::Null()},
+          {"a", FieldValue::FromArray(
+                    {FieldValue::FromInteger(1),
+                     FieldValue::FromArray(
+                         {FieldValue::FromString(std::string(150, 'y'))})})},
+          {"o", FieldValue::FromMap({
+                    {"b", FieldValue::FromString(std::string(130, 'z'))},
+                })},
+      }),
+  };
+
+  std::string bytes;
+  for (size_t i = 0; i < values.size(); i++) {
+    // Reuses the buffer, like callers encoding many values would.
+    Serializer::EncodeFieldValueBytes(values[i], &bytes);
+    std::vector<uint8_t> expected = EncodeFieldValue(&serializer, values[i]);
+    EXPECT_EQ(std::string(expected.begin(), expected.end()), bytes)
+        << "values[" << i << "]";
+  }
+}
+
 TEST_F(SerializerTest, EncodesFieldValuesWithRepeatedEntries) {
   // Technically, serialized Value protos can contain multiple values. (The last
   // one "wins".) However, well-behaved proto emitters (such as libprotobuf)
@@ -983,6 +1029,24 @@ TEST_F(SerializerTest, EncodesNonEmptyDocument) {
   ExpectRoundTrip(key, fields, update_time, proto);
 }
 
+TEST_F(SerializerTest, EncodesDocumentBytesLikeNanopb) {
+  DocumentKey key = DocumentKey::FromPathString("path/to/the/doc");
+  for (const ObjectValue& fields :
+       {ObjectValue::Empty(), ObjectValue::FromMap({
+                                  {"foo", FieldValue::FromString("bar")},
+                                  {"two", FieldValue::FromInteger(2)},
+                                  {"nested", FieldValue::FromMap({
+                                                 {"fourty-two",
+                                                  FieldValue::FromInteger(42)},
+                                             })},
+                              })}) {
+    std::string bytes;
+    serializer.EncodeDocumentBytes(key, fields, &bytes);
+    std::vector<uint8_t> expected = EncodeDocument(&serializer, key, fields);
+    EXPECT_EQ(std::string(expected.begin(), expected.end()), bytes);
+  }
+}
+
 TEST_F(SerializerTest, DecodesNoDocument) {
   // We can't actually *encode* a NoDocument; the method exposed by the
   // serializer requires both the document key and contents (as an ObjectValue,
@@ -350,6 +350,35 @@ TEST_F(StreamTest, SeveralWrites) {
   // hang or crash indicates success.
 }
 
+// Metrics
+
+TEST_F(StreamTest, RecordsMetrics) {
+  StartStream();
+  worker_queue.EnqueueBlocking([&] {
+    const StreamMetrics& metrics = firestore_stream->metrics();
+    EXPECT_EQ(metrics.token_fetch_latency.count(), 1);
+    EXPECT_EQ(metrics.time_to_first_response.count(), 0);
+
+    firestore_stream->WriteEmptyBuffer();
+    EXPECT_EQ(metrics.messages_sent, 1);
+    EXPECT_EQ(metrics.bytes_sent, 0);
+  });
+
+  ForceFinish({
+      {Type::Read, MakeByteBuffer("foo")},
+      {Type::Read, MakeByteBuffer("quux")},
+  });
+
+  worker_queue.EnqueueBlocking([&] {
+    const StreamMetrics& metrics = firestore_stream->metrics();
+    EXPECT_EQ(metrics.messages_received, 2);
+    EXPECT_EQ(metrics.bytes_received, 7);
+    // Only the first response counts.
+    EXPECT_EQ(metrics.time_to_first_response.count(), 1);
+    EXPECT_EQ(metrics.backoff_delay.count(), 0);
+  });
+}
+
 // Auth edge cases
 
 TEST_F(StreamTest, AuthFailureOnStart) {
@@ -452,6 +481,31 @@ TEST_F(StreamTest, Backoff) {
   EXPECT_FALSE(worker_queue.IsScheduled(kBackoffTimerId));
 }
 
+TEST_F(StreamTest, CanCancelBackoff) {
+  StartStream();
+  ForceFinish({{Type::Read, Error},
+               {Type::Finish, grpc::Status{grpc::RESOURCE_EXHAUSTED, ""}}});
+
+  StartStream();
+  EXPECT_TRUE(worker_queue.IsScheduled(kBackoffTimerId));
+  worker_queue.EnqueueBlocking([&] {
+    firestore_stream->CancelBackoff();
+    EXPECT_FALSE(firestore_stream->IsStarted());
+  });
+  EXPECT_FALSE(worker_queue.IsScheduled(kBackoffTimerId));
+
+  StartStream();
+  EXPECT_FALSE(worker_queue.IsScheduled(kBackoffTimerId));
+  worker_queue.EnqueueBlocking(
+      [&] { EXPECT_TRUE(firestore_stream->IsOpen()); });
+
+  // Canceling the backoff of a stream that isn't backing off does nothing.
+  worker_queue.EnqueueBlocking([&] {
+    firestore_stream->CancelBackoff();
+    EXPECT_TRUE(firestore_stream->IsOpen());
+  });
+}
+
 // Errors
 
 // Error on read is tested in `ObserverReceivesStreamCloseOnError`.
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/write_window.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+
+#include "gtest/gtest.h"
+
+namespace chr = std::chrono;
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+class WriteWindowTest : public testing::Test {
+ public:
+  /**
+   * Sends and acknowledges a full window of writes, each taking `round_trip`.
+   */
+  void RunRoundTrip(chr::milliseconds round_trip) {
+    size_t count = window.size();
+    for (size_t i = 0; i != count; ++i) {
+      window.RecordSend(now);
+    }
+    now += round_trip;
+    for (size_t i = 0; i != count; ++i) {
+      window.RecordAcknowledgement(now);
+    }
+  }
+
+  WriteWindow window;
+  WriteWindow::Clock::time_point now;
+};
+
+TEST_F(WriteWindowTest, StartsAtInitialSize) {
+  EXPECT_EQ(window.size(), WriteWindow::kInitialSize);
+  EXPECT_EQ(window.in_flight(), 0);
+}
+
+TEST_F(WriteWindowTest, GrowsQuicklyWhileRoundTripsAreSteady) {
+  RunRoundTrip(chr::milliseconds{100});
+  EXPECT_EQ(window.size(), 2 * WriteWindow::kInitialSize);
+
+  RunRoundTrip(chr::milliseconds{100});
+  EXPECT_EQ(window.size(), 4 * WriteWindow::kInitialSize);
+}
+
+TEST_F(WriteWindowTest, NeverExceedsMaxSize) {
+  for (int i = 0; i != 20; ++i) {
+    RunRoundTrip(chr::milliseconds{100});
+  }
+  EXPECT_EQ(window.size(), WriteWindow::kMaxSize);
+}
+
+TEST_F(WriteWindowTest, DoesNotGrowUnlessFull) {
+  for (int i = 0; i != 100; ++i) {
+    window.RecordSend(now);
+    now += chr::milliseconds{100};
+    window.RecordAcknowledgement(now);
+  }
+  EXPECT_EQ(window.size(), WriteWindow::kInitialSize);
+}
+
+TEST_F(WriteWindowTest, StopsGrowingWhenRoundTripsIncrease) {
+  RunRoundTrip(chr::milliseconds{100});
+  size_t size = window.size();
+
+  // Each round trip now takes much longer than the fastest one, as if the
+  // writes were waiting in a queue.
+  for (int i = 0; i != 10; ++i) {
+    RunRoundTrip(chr::milliseconds{400});
+  }
+  EXPECT_LT(window.size(), size);
+  EXPECT_GE(window.size(), WriteWindow::kMinSize);
+}
+
+TEST_F(WriteWindowTest, ShrinksOnFailure) {
+  RunRoundTrip(chr::milliseconds{100});
+  EXPECT_EQ(window.size(), 20);
+
+  window.RecordFailure();
+  EXPECT_EQ(window.size(), 10);
+
+  // After a failure, the window only grows by about one write per round trip.
+  for (int i = 0; i != 5; ++i) {
+    RunRoundTrip(chr::milliseconds{100});
+  }
+  EXPECT_GE(window.size(), 13);
+  EXPECT_LE(window.size(), 15);
+}
+
+TEST_F(WriteWindowTest, NeverShrinksBelowMinSize) {
+  for (int i = 0; i != 20; ++i) {
+    window.RecordFailure();
+  }
+  EXPECT_EQ(window.size(), WriteWindow::kMinSize);
+}
+
+TEST_F(WriteWindowTest, ForgetsWritesInFlightWhenStreamCloses) {
+  window.RecordSend(now);
+  window.RecordSend(now);
+  EXPECT_EQ(window.in_flight(), 2);
+
+  window.RecordStreamClose();
+  EXPECT_EQ(window.in_flight(), 0);
+  EXPECT_EQ(window.size(), WriteWindow::kInitialSize);
+}
+
+TEST_F(WriteWindowTest, FillsStats) {
+  RunRoundTrip(chr::milliseconds{100});
+  window.RecordSend(now);
+  window.RecordFailure();
+
+  WritePipelineStats stats;
+  window.FillStats(&stats);
+  EXPECT_EQ(stats.window_size, WriteWindow::kInitialSize);
+  EXPECT_EQ(stats.in_flight_writes, 1);
+  EXPECT_EQ(stats.acknowledged_writes, WriteWindow::kInitialSize);
+  EXPECT_EQ(stats.failures, 1);
+  EXPECT_EQ(stats.smoothed_round_trip, chr::milliseconds{100});
+}
+
+TEST_F(WriteWindowTest, AcknowledgementWithoutSendFails) {
+  EXPECT_ANY_THROW(window.RecordAcknowledgement(now));
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,223 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/test/firebase/firestore/testutil/allocation_counter.h"
+
+#include <cstdlib>
+#include <new>
+
+#include "absl/base/config.h"
+
+namespace firebase {
+namespace firestore {
+namespace testutil {
+
+namespace {
+
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+thread_local int64_t allocations_on_thread = 0;
+#endif
+
+int64_t AllocationsOnThread() {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  return allocations_on_thread;
+#else
+  return 0;
+#endif
+}
+
+void CountAllocation() {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  ++allocations_on_thread;
+#endif
+}
+
+}  // namespace
+
+AllocationCounter::AllocationCounter() : start_(AllocationsOnThread()) {
+}
+
+int64_t AllocationCounter::count() const {
+  return AllocationsOnThread() - start_;
+}
+
+bool AllocationCounter::IsSupported() {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  return true;
+#else
+  return false;
+#endif
+}
+
+}  // namespace testutil
+}  // namespace firestore
+}  // namespace firebase
+
+// Replacements for the global allocation functions. Every form is replaced,
+// including those whose default forwards to another, so that memory is always
+// freed by the allocator that handed it out and compilers that check for
+// matching replacements (GCC's -Wsized-deallocation) find them all.
+
+namespace {
+
+void* Allocate(std::size_t size) {
+  firebase::firestore::testutil::CountAllocation();
+  // `malloc(0)` may return null, which `operator new` must not.
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+void* AllocateOrThrow(std::size_t size) {
+  void* result = Allocate(size);
+  if (!result) {
+#if ABSL_HAVE_EXCEPTIONS
+    throw std::bad_alloc();
+#else
+    std::abort();
+#endif
+  }
+  return result;
+}
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+  return AllocateOrThrow(size);
+}
+
+void* operator new[](std::size_t size) {
+  return AllocateOrThrow(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return Allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return Allocate(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
+
+#if defined(__cpp_sized_deallocation)
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+#endif  // defined(__cpp_sized_deallocation)
+
+#if defined(__cpp_aligned_new)
+namespace {
+
+void* AllocateAligned(std::size_t size, std::align_val_t alignment) {
+  firebase::firestore::testutil::CountAllocation();
+  std::size_t align = static_cast<std::size_t>(alignment);
+  if (size == 0) size = 1;
+#if defined(_WIN32)
+  return _aligned_malloc(size, align);
+#else
+  void* result = nullptr;
+  if (align < sizeof(void*)) align = sizeof(void*);
+  return posix_memalign(&result, align, size) == 0 ? result : nullptr;
+#endif
+}
+
+void* AllocateAlignedOrThrow(std::size_t size, std::align_val_t alignment) {
+  void* result = AllocateAligned(size, alignment);
+  if (!result) {
+#if ABSL_HAVE_EXCEPTIONS
+    throw std::bad_alloc();
+#else
+    std::abort();
+#endif
+  }
+  return result;
+}
+
+void FreeAligned(void* ptr) {
+#if defined(_WIN32)
+  _aligned_free(ptr);
+#else
+  std::free(ptr);
+#endif
+}
+
+}  // namespace
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  return AllocateAlignedOrThrow(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+  return AllocateAlignedOrThrow(size, alignment);
+}
+
+void* operator new(std::size_t size,
+                   std::align_val_t alignment,
+                   const std::nothrow_t&) noexcept {
+  return AllocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size,
+                     std::align_val_t alignment,
+                     const std::nothrow_t&) noexcept {
+  return AllocateAligned(size, alignment);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+  FreeAligned(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+  FreeAligned(ptr);
+}
+
+void operator delete(void* ptr,
+                     std::align_val_t,
+                     const std::nothrow_t&) noexcept {
+  FreeAligned(ptr);
+}
+
+void operator delete[](void* ptr,
+                       std::align_val_t,
+                       const std::nothrow_t&) noexcept {
+  FreeAligned(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+  FreeAligned(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+  FreeAligned(ptr);
+}
+#endif  // defined(__cpp_aligned_new)
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_TESTUTIL_ALLOCATION_COUNTER_H_
+#define FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_TESTUTIL_ALLOCATION_COUNTER_H_
+
+#include <cstdint>
+
+namespace firebase {
+namespace firestore {
+namespace testutil {
+
+/**
+ * Counts the heap allocations made on the current thread while it is alive,
+ * so that tests and benchmarks can hold hot paths to an allocation budget:
+ *
+ *     DocumentKey key = Key("rooms/eros");
+ *     AllocationCounter allocations;
+ *     DocumentKey copy = key;
+ *     EXPECT_EQ(allocations.count(), 0);
+ *
+ * Allocations are counted by replacing the global allocation functions, which
+ * happens for any binary that links this library, so allocation-budget tests
+ * live in test binaries of their own. Counters may be nested; each one sees
+ * every allocation made since it was created.
+ *
+ * Counting requires thread-local storage; where it isn't available, `count()`
+ * is always zero, so budgets trivially hold (see `IsSupported()`).
+ */
+class AllocationCounter {
+ public:
+  AllocationCounter();
+
+  /**
+   * The number of allocations made on this thread since this counter was
+   * created.
+   */
+  int64_t count() const;
+
+  /** Returns whether allocations are actually being counted. */
+  static bool IsSupported();
+
+ private:
+  int64_t start_ = 0;
+};
+
+}  // namespace testutil
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_TESTUTIL_ALLOCATION_COUNTER_H_
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/test/firebase/firestore/testutil/allocation_counter.h"
+
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace testutil {
+
+TEST(AllocationCounterTest, CountsAllocations) {
+  if (!AllocationCounter::IsSupported()) return;
+
+  AllocationCounter allocations;
+  EXPECT_EQ(allocations.count(), 0);
+
+  std::unique_ptr<int> value(new int(42));
+  EXPECT_EQ(allocations.count(), 1);
+
+  std::vector<int> values(10);
+  EXPECT_EQ(allocations.count(), 2);
+}
+
+TEST(AllocationCounterTest, DoesNotCountDeallocations) {
+  if (!AllocationCounter::IsSupported()) return;
+
+  std::unique_ptr<int> value(new int(42));
+  AllocationCounter allocations;
+  value.reset();
+  EXPECT_EQ(allocations.count(), 0);
+}
+
+TEST(AllocationCounterTest, Nests) {
+  if (!AllocationCounter::IsSupported()) return;
+
+  AllocationCounter outer;
+  std::unique_ptr<int> first(new int(1));
+
+  AllocationCounter inner;
+  std::unique_ptr<int> second(new int(2));
+
+  EXPECT_EQ(inner.count(), 1);
+  EXPECT_EQ(outer.count(), 2);
+}
+
+TEST(AllocationCounterTest, IgnoresOtherThreads) {
+  if (!AllocationCounter::IsSupported()) return;
+
+  const int kAllocations = 100;
+  int64_t other_count = 0;
+
+  AllocationCounter allocations;
+  // Starting the thread itself allocates on this thread, but far less than
+  // the thread does.
+  std::thread thread([&] {
+    AllocationCounter other_allocations;
+    std::vector<std::unique_ptr<int>> values;
+    values.reserve(kAllocations);
+    for (int i = 0; i < kAllocations; ++i) {
+      values.emplace_back(new int(i));
+    }
+    other_count = other_allocations.count();
+  });
+  thread.join();
+
+  EXPECT_EQ(other_count, kAllocations + 1);
+  EXPECT_LT(allocations.count(), kAllocations);
+}
+
+}  // namespace testutil
+}  // namespace firestore
+}  // namespace firebase
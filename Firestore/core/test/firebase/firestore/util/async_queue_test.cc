@@ -19,6 +19,8 @@
 #include <chrono>  // NOLINT(build/c++11)
 #include <future>  // NOLINT(build/c++11)
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/util/executor.h"
 #include "absl/memory/memory.h"
@@ -61,6 +63,117 @@ TEST_P(AsyncQueueTest, EnqueueRelaxedWorksFromWithinEnqueue) {
   EXPECT_TRUE(WaitForTestToFinish());
 }
 
+TEST_P(AsyncQueueTest, RunsHigherPrioritiesFirstAndEachPriorityInOrder) {
+  using Priority = AsyncQueue::Priority;
+  std::string steps;
+
+  queue.Enqueue([&] {
+    queue.EnqueueRelaxed(
+        [&] {
+          steps += '5';
+          signal_finished();
+        },
+        Priority::Background);
+    queue.EnqueueRelaxed([&steps] { steps += '3'; }, Priority::Normal);
+    queue.EnqueueRelaxed([&steps] { steps += '1'; }, Priority::Interactive);
+    queue.EnqueueRelaxed([&steps] { steps += '4'; }, Priority::Normal);
+    queue.EnqueueRelaxed([&steps] { steps += '2'; }, Priority::Interactive);
+  });
+
+  EXPECT_TRUE(WaitForTestToFinish());
+  EXPECT_EQ(steps, "12345");
+}
+
+TEST_P(AsyncQueueTest, ShouldYieldOnlyToHigherPriorities) {
+  using Priority = AsyncQueue::Priority;
+
+  queue.Enqueue([&] {
+    queue.EnqueueRelaxed([] {}, Priority::Background);
+    queue.EnqueueRelaxed([] {}, Priority::Normal);
+    EXPECT_FALSE(queue.ShouldYield());
+
+    queue.EnqueueRelaxed(
+        [&] {
+          EXPECT_FALSE(queue.ShouldYield());
+          signal_finished();
+        },
+        Priority::Interactive);
+    EXPECT_TRUE(queue.ShouldYield());
+  });
+
+  EXPECT_TRUE(WaitForTestToFinish());
+}
+
+TEST_P(AsyncQueueTest, RecordsOperationMetricsByLabelOnceInstrumented) {
+  using Priority = AsyncQueue::Priority;
+
+  queue.EnqueueBlocking([] {});
+  EXPECT_TRUE(queue.GetOperationMetrics().empty());
+
+  queue.EnableInstrumentation(AsyncQueue::Milliseconds(1000));
+  queue.Enqueue([] {}, Priority::Normal, "fast");
+  queue.Enqueue([] {}, Priority::Normal, "fast");
+  queue.Enqueue(
+      [] { std::this_thread::sleep_for(std::chrono::milliseconds(5)); },
+      Priority::Background, "slow");
+  // Operations run serially, so this one runs after the others are recorded.
+  queue.EnqueueBlocking([] {});
+
+  auto metrics = queue.GetOperationMetrics();
+  ASSERT_EQ(metrics.size(), 3u);
+  EXPECT_EQ(metrics["fast"].wait_time.count(), 2);
+  EXPECT_EQ(metrics["fast"].run_time.count(), 2);
+  EXPECT_EQ(metrics["slow"].run_time.count(), 1);
+  EXPECT_GE(metrics["slow"].run_time.max(), AsyncQueue::Milliseconds(5));
+  EXPECT_EQ(metrics["unlabeled"].run_time.count(), 1);
+}
+
+TEST_P(AsyncQueueTest, ReportsSlowOperationsToTheHandler) {
+  using Priority = AsyncQueue::Priority;
+
+  std::vector<AsyncQueue::SlowOperation> slow_operations;
+  queue.SetSlowOperationHandler(
+      [&](const AsyncQueue::SlowOperation& slow_operation) {
+        EXPECT_TRUE(queue.IsCurrentQueue());
+        slow_operations.push_back(slow_operation);
+      });
+  queue.EnableInstrumentation(AsyncQueue::Milliseconds(1));
+
+  // The slow operation waits for the fast one to be enqueued behind it.
+  std::promise<void> fast_enqueued;
+  std::shared_future<void> fast_enqueued_future = fast_enqueued.get_future();
+  queue.Enqueue(
+      [fast_enqueued_future] {
+        fast_enqueued_future.wait();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      },
+      Priority::Normal, "slow");
+  queue.Enqueue([] {}, Priority::Normal, "fast");
+  fast_enqueued.set_value();
+  queue.EnqueueBlocking([] {});
+
+  ASSERT_EQ(slow_operations.size(), 1u);
+  EXPECT_STREQ(slow_operations[0].label, "slow");
+  EXPECT_GE(slow_operations[0].run_time, AsyncQueue::Milliseconds(10));
+  EXPECT_EQ(slow_operations[0].backlog, 1);
+}
+
+TEST_P(AsyncQueueTest, LabelsDelayedOperationsByTimerId) {
+  queue.EnableInstrumentation(AsyncQueue::Milliseconds(1000));
+  queue.Enqueue([&] {
+    queue.EnqueueAfterDelay(AsyncQueue::Milliseconds(1),
+                            TimerId::GarbageCollectionDelay,
+                            [&] { signal_finished(); });
+  });
+
+  EXPECT_TRUE(WaitForTestToFinish());
+  queue.EnqueueBlocking([] {});
+
+  auto metrics = queue.GetOperationMetrics();
+  EXPECT_EQ(metrics["GarbageCollectionDelay"].wait_time.count(), 1);
+  EXPECT_EQ(metrics["GarbageCollectionDelay"].run_time.count(), 1);
+}
+
 TEST_P(AsyncQueueTest, EnqueueBlocking) {
   bool finished = false;
   queue.EnqueueBlocking([&] { finished = true; });
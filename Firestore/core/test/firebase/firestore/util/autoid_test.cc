@@ -17,10 +17,16 @@
 #include "Firestore/core/src/firebase/firestore/util/autoid.h"
 
 #include <cctype>
+#include <set>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
 
 #include "gtest/gtest.h"
 
+using firebase::firestore::util::AutoIdGenerator;
 using firebase::firestore::util::CreateAutoId;
+using firebase::firestore::util::CreateAutoIds;
 
 TEST(AutoId, IsSane) {
   for (int i = 0; i < 50; i++) {
@@ -34,3 +40,62 @@ TEST(AutoId, IsSane) {
     }
   }
 }
+
+TEST(AutoId, CreatesBatches) {
+  std::vector<std::string> auto_ids = CreateAutoIds(100);
+  ASSERT_EQ(100u, auto_ids.size());
+
+  std::set<std::string> distinct;
+  for (const std::string& auto_id : auto_ids) {
+    EXPECT_EQ(20u, auto_id.length());
+    distinct.insert(auto_id);
+  }
+  EXPECT_EQ(100u, distinct.size());
+
+  EXPECT_TRUE(CreateAutoIds(0).empty());
+}
+
+TEST(AutoId, RefillsSmallPools) {
+  // A pool smaller than an ID has to be refilled while generating each one.
+  AutoIdGenerator generator(7);
+
+  std::set<std::string> distinct;
+  for (const std::string& auto_id : generator.CreateAutoIds(50)) {
+    EXPECT_EQ(20u, auto_id.length());
+    distinct.insert(auto_id);
+  }
+  EXPECT_EQ(50u, distinct.size());
+}
+
+TEST(AutoId, UsesWholeAlphabet) {
+  AutoIdGenerator generator;
+  std::set<char> seen;
+  for (const std::string& auto_id : generator.CreateAutoIds(500)) {
+    seen.insert(auto_id.begin(), auto_id.end());
+  }
+  // 10000 characters drawn uniformly from 62 leave practically none unused.
+  EXPECT_EQ(62u, seen.size());
+}
+
+TEST(AutoId, IsThreadSafe) {
+  AutoIdGenerator generator(64);
+  std::vector<std::vector<std::string>> results(4);
+
+  std::vector<std::thread> threads;
+  for (auto& result : results) {
+    threads.emplace_back([&generator, &result] {
+      for (int i = 0; i < 100; i++) {
+        result.push_back(generator.CreateAutoId());
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  std::set<std::string> distinct;
+  for (const auto& result : results) {
+    distinct.insert(result.begin(), result.end());
+  }
+  EXPECT_EQ(400u, distinct.size());
+}
@@ -61,6 +61,60 @@ TEST(Comparison, StringCompare) {
   ASSERT_SAME(Compare<absl::string_view>("a", "a"));
 }
 
+TEST(Comparison, StdStringCompare) {
+  ASSERT_ASCENDING(Compare<std::string>("a", "b"));
+  ASSERT_ASCENDING(Compare<std::string>("a", "ab"));
+  ASSERT_DESCENDING(Compare<std::string>("b", "ab"));
+  ASSERT_SAME(Compare<std::string>("ab", "ab"));
+
+  // Bytes compare as unsigned, as they do with operator<.
+  ASSERT_ASCENDING(Compare<std::string>("a", "\xff"));
+}
+
+TEST(Comparison, IntegerCompare) {
+  ASSERT_SAME(Compare<int32_t>(3, 3));
+  ASSERT_ASCENDING(Compare<int32_t>(-1, 3));
+  ASSERT_DESCENDING(Compare<int32_t>(3, -1));
+
+  ASSERT_ASCENDING(Compare<int64_t>(INT64_MIN, INT64_MAX));
+  ASSERT_DESCENDING(Compare<int64_t>(INT64_MAX, INT64_MIN));
+  ASSERT_SAME(Compare<int64_t>(INT64_MIN, INT64_MIN));
+}
+
+namespace {
+
+/** A comparator that counts how often it's called. */
+struct CountingLess {
+  bool operator()(int left, int right) const {
+    ++*calls;
+    return left < right;
+  }
+  int* calls;
+};
+
+/** A comparator that only allows three-way comparisons. */
+struct ThreeWayOnly {
+  bool operator()(int, int) const {
+    ADD_FAILURE() << "Should have compared three ways";
+    return false;
+  }
+  ComparisonResult Compare(int left, int right) const {
+    return ComparisonResultFromInt(left - right);
+  }
+};
+
+}  // namespace
+
+TEST(Comparison, SelectsThreeWayCompare) {
+  int calls = 0;
+  ASSERT_SAME(Compare(1, 1, CountingLess{&calls}));
+  ASSERT_EQ(2, calls);
+
+  ASSERT_ASCENDING(Compare(1, 2, ThreeWayOnly{}));
+  ASSERT_DESCENDING(Compare(2, 1, ThreeWayOnly{}));
+  ASSERT_SAME(Compare(2, 2, ThreeWayOnly{}));
+}
+
 TEST(Comparison, BooleanCompare) {
   ASSERT_SAME(Compare<bool>(false, false));
   ASSERT_SAME(Compare<bool>(true, true));
@@ -78,6 +132,9 @@ TEST(Comparison, DoubleCompare) {
   ASSERT_ASCENDING(Compare<double>(-INFINITY, INFINITY));
   ASSERT_DESCENDING(Compare<double>(INFINITY, -INFINITY));
 
+  ASSERT_ASCENDING(Compare<double>(NAN, -INFINITY));
+  ASSERT_DESCENDING(Compare<double>(-INFINITY, NAN));
+
   ASSERT_SAME(Compare<double>(0, 0));
   ASSERT_SAME(Compare<double>(-0, -0));
   ASSERT_SAME(Compare<double>(-0, 0));
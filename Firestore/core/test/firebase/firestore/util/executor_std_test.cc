@@ -16,6 +16,7 @@
 
 #include "Firestore/core/test/firebase/firestore/util/executor_test.h"
 
+#include <atomic>
 #include <chrono>  // NOLINT(build/c++11)
 #include <cstdlib>
 #include <future>  // NOLINT(build/c++11)
@@ -105,6 +106,23 @@ TEST_F(ScheduleTest, RemoveIf) {
   EXPECT_TRUE(schedule.empty());
 }
 
+TEST_F(ScheduleTest, RemoveByHandle) {
+  const auto handle1 = schedule.Push(1, start_time);
+  const auto handle2 = schedule.Push(2, start_time);
+  const auto handle3 = schedule.Push(3, now() + chr::minutes(1));
+
+  EXPECT_EQ(schedule.Remove(handle2).value(), 2);
+  // Already removed.
+  EXPECT_FALSE(schedule.Remove(handle2).has_value());
+
+  EXPECT_EQ(schedule.PopIfDue().value(), 1);
+  // Already popped.
+  EXPECT_FALSE(schedule.Remove(handle1).has_value());
+
+  EXPECT_EQ(schedule.Remove(handle3).value(), 3);
+  EXPECT_TRUE(schedule.empty());
+}
+
 TEST_F(ScheduleTest, Ordering) {
   schedule.Push(11, start_time + chr::milliseconds(5));
   schedule.Push(1, start_time);
@@ -225,6 +243,23 @@ TEST_F(ScheduleTest, PopBlockingIsNotAffectedByIrrelevantRemovals) {
   ABORT_ON_TIMEOUT(future);
 }
 
+TEST_F(ScheduleTest, PopBlockingUnlessReturnsWhenInterrupted) {
+  schedule.Push(1, start_time + chr::seconds(10));
+  std::atomic<bool> interrupted{false};
+
+  const auto future = std::async(std::launch::async, [&] {
+    EXPECT_FALSE(
+        schedule.PopBlockingUnless([&] { return interrupted.load(); })
+            .has_value());
+  });
+
+  std::this_thread::sleep_for(chr::milliseconds(5));
+  interrupted = true;
+  schedule.Interrupt();
+  ABORT_ON_TIMEOUT(future);
+  EXPECT_EQ(schedule.size(), 1u);
+}
+
 // ExecutorStd tests
 
 namespace {
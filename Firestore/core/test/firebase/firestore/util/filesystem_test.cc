@@ -280,6 +280,23 @@ TEST(FilesystemTest, ReadFile) {
   ASSERT_EQ(result.ValueOrDie(), "foobar");
 }
 
+TEST(FilesystemTest, MappedFile) {
+  Path file = Path::JoinUtf8(TempDir(), TestFilename());
+  ASSERT_NOT_FOUND(MappedFile::Open(file).status());
+
+  Touch(file);
+  StatusOr<std::unique_ptr<MappedFile>> result = MappedFile::Open(file);
+  ASSERT_OK(result.status());
+  ASSERT_TRUE(result.ValueOrDie()->contents().empty());
+
+  WriteStringToFile(file, "foobar");
+  result = MappedFile::Open(file);
+  ASSERT_OK(result.status());
+  ASSERT_EQ(result.ValueOrDie()->contents(), "foobar");
+
+  EXPECT_OK(RecursivelyDelete(file));
+}
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
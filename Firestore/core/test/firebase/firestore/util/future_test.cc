@@ -0,0 +1,101 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/future.h"
+
+#include <future>  // NOLINT(build/c++11)
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/util/executor_std.h"
+#include "Firestore/core/test/firebase/firestore/util/async_tests_util.h"
+#include "absl/memory/memory.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+class FutureTest : public TestWithTimeoutMixin, public ::testing::Test {
+ public:
+  FutureTest() : queue{absl::make_unique<ExecutorStd>()} {
+  }
+
+  AsyncQueue queue;
+};
+
+TEST_F(FutureTest, DeliversValuesSetOffTheQueueOnTheQueue) {
+  Promise<std::string> promise;
+  promise.GetFuture().Then(&queue, [&](std::string value) {
+    queue.VerifyIsCurrentQueue();
+    EXPECT_EQ(value, "foo");
+    signal_finished();
+  });
+
+  promise.SetValue("foo");
+  EXPECT_TRUE(WaitForTestToFinish());
+}
+
+TEST_F(FutureTest, DeliversValuesSetBeforeThenOnTheQueue) {
+  Promise<std::string> promise;
+  promise.SetValue("foo");
+
+  promise.GetFuture().Then(&queue, [&](std::string value) {
+    queue.VerifyIsCurrentQueue();
+    EXPECT_EQ(value, "foo");
+    signal_finished();
+  });
+  EXPECT_TRUE(WaitForTestToFinish());
+}
+
+TEST_F(FutureTest, RunsContinuationInlineWhenSetOnTheQueue) {
+  queue.EnqueueBlocking([&] {
+    std::string steps;
+    Promise<int> promise;
+    promise.GetFuture().Then(&queue, [&](int value) {
+      EXPECT_EQ(value, 42);
+      steps += '1';
+    });
+
+    promise.SetValue(42);
+    steps += '2';
+    EXPECT_EQ(steps, "12");
+  });
+}
+
+TEST_F(FutureTest, RunsContinuationInlineWhenAttachedOnTheQueue) {
+  Promise<int> promise;
+  promise.SetValue(42);
+
+  queue.EnqueueBlocking([&] {
+    std::string steps;
+    promise.GetFuture().Then(&queue, [&](int value) {
+      EXPECT_EQ(value, 42);
+      steps += '1';
+    });
+    steps += '2';
+    EXPECT_EQ(steps, "12");
+  });
+}
+
+TEST_F(FutureTest, FulfillingTwiceFails) {
+  Promise<int> promise;
+  promise.SetValue(1);
+  EXPECT_ANY_THROW(promise.SetValue(2));
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
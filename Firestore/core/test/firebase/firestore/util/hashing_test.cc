@@ -17,6 +17,7 @@
 #include "Firestore/core/src/firebase/firestore/util/hashing.h"
 
 #include <map>
+#include <set>
 #include <string>
 
 #include "absl/strings/string_view.h"
@@ -134,6 +135,40 @@ TEST(HashingTest, Composite) {
   EXPECT_EQ(expected, Hash(1, 2, 3));
 }
 
+TEST(HashingTest, HashBytesDistinguishesLengths) {
+  std::string data(100, 'a');
+  std::set<uint64_t> hashes;
+  for (size_t size = 0; size <= data.size(); size++) {
+    hashes.insert(HashBytes(data.data(), size));
+  }
+  EXPECT_EQ(data.size() + 1, hashes.size());
+}
+
+TEST(HashingTest, HashBytesDependsOnSeed) {
+  std::string data = "projects/p/databases/d/documents/rooms/eros";
+  EXPECT_EQ(HashBytes(data.data(), data.size(), 1),
+            HashBytes(data.data(), data.size(), 1));
+  EXPECT_NE(HashBytes(data.data(), data.size(), 1),
+            HashBytes(data.data(), data.size(), 2));
+}
+
+TEST(HashingTest, HasherRespectsSegmentBoundaries) {
+  EXPECT_EQ(Hasher().AddBytes("ab").AddBytes("c").value(),
+            Hasher().AddBytes("ab").AddBytes("c").value());
+  EXPECT_NE(Hasher().AddBytes("ab").AddBytes("c").value(),
+            Hasher().AddBytes("a").AddBytes("bc").value());
+  EXPECT_NE(Hasher().AddBytes("abc").value(),
+            Hasher().AddBytes("ab").AddBytes("c").value());
+}
+
+TEST(HashingTest, HasherAddsIntegers) {
+  EXPECT_EQ(Hasher().AddInteger(1).value(), Hasher().AddInteger(1).value());
+  EXPECT_NE(Hasher().AddInteger(1).value(), Hasher().AddInteger(2).value());
+  EXPECT_NE(Hasher().AddInteger(1).AddInteger(2).value(),
+            Hasher().AddInteger(2).AddInteger(1).value());
+  EXPECT_NE(Hasher(1).AddInteger(1).value(), Hasher(2).AddInteger(1).value());
+}
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/latency_histogram.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+using Milliseconds = LatencyHistogram::Milliseconds;
+
+TEST(LatencyHistogramTest, StartsEmpty) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.count(), 0);
+  EXPECT_EQ(histogram.sum(), Milliseconds{0});
+  EXPECT_EQ(histogram.max(), Milliseconds{0});
+  EXPECT_EQ(histogram.Percentile(50), Milliseconds{0});
+}
+
+TEST(LatencyHistogramTest, BucketsGrowExponentially) {
+  EXPECT_EQ(LatencyHistogram::BucketUpperBound(0), Milliseconds{1});
+  EXPECT_EQ(LatencyHistogram::BucketUpperBound(1), Milliseconds{2});
+  EXPECT_EQ(LatencyHistogram::BucketUpperBound(10), Milliseconds{1024});
+  EXPECT_EQ(
+      LatencyHistogram::BucketUpperBound(LatencyHistogram::kBucketCount - 1),
+      Milliseconds::max());
+}
+
+TEST(LatencyHistogramTest, RecordsIntoBuckets) {
+  LatencyHistogram histogram;
+  histogram.Record(Milliseconds{0});
+  histogram.Record(Milliseconds{1});
+  histogram.Record(Milliseconds{3});
+  histogram.Record(Milliseconds{3});
+  histogram.Record(Milliseconds{1000});
+
+  EXPECT_EQ(histogram.count(), 5);
+  EXPECT_EQ(histogram.sum(), Milliseconds{1007});
+  EXPECT_EQ(histogram.max(), Milliseconds{1000});
+
+  const auto& buckets = histogram.buckets();
+  EXPECT_EQ(buckets[0], 1);   // [0, 1)
+  EXPECT_EQ(buckets[1], 1);   // [1, 2)
+  EXPECT_EQ(buckets[2], 2);   // [2, 4)
+  EXPECT_EQ(buckets[10], 1);  // [512, 1024)
+}
+
+TEST(LatencyHistogramTest, LongLatenciesGoIntoLastBucket) {
+  LatencyHistogram histogram;
+  histogram.Record(std::chrono::hours{1});
+  EXPECT_EQ(histogram.buckets()[LatencyHistogram::kBucketCount - 1], 1);
+}
+
+TEST(LatencyHistogramTest, NegativeLatenciesAreClampedToZero) {
+  LatencyHistogram histogram;
+  histogram.Record(Milliseconds{-5});
+  EXPECT_EQ(histogram.buckets()[0], 1);
+  EXPECT_EQ(histogram.sum(), Milliseconds{0});
+}
+
+TEST(LatencyHistogramTest, PercentilesUseBucketBounds) {
+  LatencyHistogram histogram;
+  for (int i = 0; i != 9; ++i) {
+    histogram.Record(Milliseconds{3});
+  }
+  histogram.Record(Milliseconds{100});
+
+  EXPECT_EQ(histogram.Percentile(0), Milliseconds{4});
+  EXPECT_EQ(histogram.Percentile(50), Milliseconds{4});
+  EXPECT_EQ(histogram.Percentile(90), Milliseconds{4});
+  // Bounded by the largest latency rather than the bucket bound (128).
+  EXPECT_EQ(histogram.Percentile(95), Milliseconds{100});
+  EXPECT_EQ(histogram.Percentile(100), Milliseconds{100});
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -36,7 +36,11 @@ TEST(Log, SetAndGet) {
   EXPECT_FALSE(LogIsDebugEnabled());
 
   LogSetLevel(kLogLevelDebug);
+#if defined(FIRESTORE_STRIP_DEBUG_LOGGING)
+  EXPECT_FALSE(LogIsDebugEnabled());
+#else
   EXPECT_TRUE(LogIsDebugEnabled());
+#endif  // defined(FIRESTORE_STRIP_DEBUG_LOGGING)
 
   LogSetLevel(kLogLevelWarning);
   EXPECT_FALSE(LogIsDebugEnabled());
@@ -48,6 +52,26 @@ TEST(Log, LogAllKinds) {
   LOG_DEBUG("test va-args %s %s %s", "abc", std::string{"def"}, 123);
 }
 
+TEST(Log, OnlyEvaluatesArgumentsOfLoggableMessages) {
+  int evaluations = 0;
+  auto evaluate = [&evaluations] { return ++evaluations; };
+
+  LOG_DEBUG("not logged %s", evaluate());
+  EXPECT_EQ(evaluations, 0);
+
+  LOG_WARN("logged %s", evaluate());
+  EXPECT_EQ(evaluations, 1);
+
+  LogSetLevel(kLogLevelDebug);
+  LOG_DEBUG("logged unless stripped %s", evaluate());
+  LogSetLevel(kLogLevelWarning);
+#if defined(FIRESTORE_STRIP_DEBUG_LOGGING)
+  EXPECT_EQ(evaluations, 1);
+#else
+  EXPECT_EQ(evaluations, 2);
+#endif  // defined(FIRESTORE_STRIP_DEBUG_LOGGING)
+}
+
 }  //  namespace util
 }  //  namespace firestore
 }  //  namespace firebase
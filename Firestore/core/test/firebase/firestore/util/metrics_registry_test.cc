@@ -0,0 +1,90 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/metrics_registry.h"
+
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+using Milliseconds = LatencyHistogram::Milliseconds;
+
+TEST(MetricsRegistryTest, ReturnsTheSameMetricForAName) {
+  MetricsRegistry registry;
+  EXPECT_EQ(registry.GetCounter("a"), registry.GetCounter("a"));
+  EXPECT_NE(registry.GetCounter("a"), registry.GetCounter("b"));
+  EXPECT_EQ(registry.GetGauge("a"), registry.GetGauge("a"));
+  EXPECT_EQ(registry.GetHistogram("a"), registry.GetHistogram("a"));
+}
+
+TEST(MetricsRegistryTest, SnapshotCopiesValues) {
+  MetricsRegistry registry;
+  registry.GetCounter("commits")->Increment();
+  registry.GetCounter("commits")->Increment(2);
+  registry.GetGauge("targets")->Set(5);
+  registry.GetGauge("targets")->Add(-1);
+  registry.GetHistogram("latency")->Record(Milliseconds{3});
+
+  MetricsSnapshot snapshot = registry.Snapshot();
+  EXPECT_EQ(3, snapshot.counters["commits"]);
+  EXPECT_EQ(4, snapshot.gauges["targets"]);
+  EXPECT_EQ(1, snapshot.histograms["latency"].count());
+  EXPECT_EQ(Milliseconds{3}, snapshot.histograms["latency"].max());
+
+  // Later updates don't affect the snapshot.
+  registry.GetCounter("commits")->Increment();
+  EXPECT_EQ(3, snapshot.counters["commits"]);
+  EXPECT_EQ(4, registry.Snapshot().counters["commits"]);
+}
+
+TEST(MetricsRegistryTest, SnapshotOfEmptyRegistry) {
+  MetricsRegistry registry;
+  MetricsSnapshot snapshot = registry.Snapshot();
+  EXPECT_TRUE(snapshot.counters.empty());
+  EXPECT_TRUE(snapshot.gauges.empty());
+  EXPECT_TRUE(snapshot.histograms.empty());
+}
+
+TEST(MetricsRegistryTest, CountsFromManyThreads) {
+  MetricsRegistry registry;
+  MetricsRegistry::Counter* counter = registry.GetCounter("count");
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&registry, counter] {
+      for (int j = 0; j < 1000; ++j) {
+        counter->Increment();
+        registry.GetHistogram("latency")->Record(Milliseconds{1});
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  MetricsSnapshot snapshot = registry.Snapshot();
+  EXPECT_EQ(4000, snapshot.counters["count"]);
+  EXPECT_EQ(4000, snapshot.histograms["latency"].count());
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
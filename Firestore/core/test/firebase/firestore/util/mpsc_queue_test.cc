@@ -0,0 +1,93 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/mpsc_queue.h"
+
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+TEST(MpscQueueTest, PopsInFifoOrder) {
+  MpscQueue<int> queue;
+  EXPECT_TRUE(queue.empty());
+  EXPECT_FALSE(queue.TryPop().has_value());
+
+  queue.Push(3);
+  queue.Push(1);
+  queue.Push(2);
+  EXPECT_FALSE(queue.empty());
+
+  EXPECT_EQ(queue.TryPop().value(), 3);
+  EXPECT_EQ(queue.TryPop().value(), 1);
+  EXPECT_EQ(queue.TryPop().value(), 2);
+  EXPECT_FALSE(queue.TryPop().has_value());
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(MpscQueueTest, DestroysEntriesThatWereNeverPopped) {
+  auto counter = std::make_shared<int>(0);
+  {
+    MpscQueue<std::shared_ptr<int>> queue;
+    queue.Push(std::shared_ptr<int>{counter});
+    queue.Push(std::shared_ptr<int>{counter});
+    EXPECT_EQ(counter.use_count(), 3);
+  }
+  EXPECT_EQ(counter.use_count(), 1);
+}
+
+TEST(MpscQueueTest, PreservesOrderOfEachProducer) {
+  constexpr int kProducers = 4;
+  constexpr int kValuesPerProducer = 10000;
+  MpscQueue<std::pair<int, int>> queue;
+
+  std::vector<std::thread> producers;
+  for (int producer = 0; producer != kProducers; ++producer) {
+    producers.emplace_back([&queue, producer] {
+      for (int i = 0; i != kValuesPerProducer; ++i) {
+        queue.Push(std::make_pair(producer, i));
+      }
+    });
+  }
+
+  std::vector<int> next_expected(kProducers, 0);
+  int popped = 0;
+  while (popped != kProducers * kValuesPerProducer) {
+    absl::optional<std::pair<int, int>> entry = queue.TryPop();
+    if (!entry) {
+      std::this_thread::yield();
+      continue;
+    }
+    ASSERT_EQ(entry->second, next_expected[entry->first]);
+    ++next_expected[entry->first];
+    ++popped;
+  }
+
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+  EXPECT_TRUE(queue.empty());
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
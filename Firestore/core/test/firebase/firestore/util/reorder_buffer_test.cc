@@ -0,0 +1,131 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/reorder_buffer.h"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+using Buffer = ReorderBuffer<int>;
+
+TEST(ReorderBufferTest, DeliversInOrderImmediately) {
+  Buffer buffer;
+  std::vector<int> delivered;
+  auto deliver = [&](int&& value) { delivered.push_back(value); };
+
+  for (int i = 0; i < 3; ++i) {
+    buffer.Complete(buffer.Reserve(), int{i}, deliver);
+  }
+  EXPECT_EQ((std::vector<int>{0, 1, 2}), delivered);
+  EXPECT_EQ(0u, buffer.pending_size());
+}
+
+TEST(ReorderBufferTest, HoldsResultsUntilEarlierOnesComplete) {
+  Buffer buffer;
+  std::vector<int> delivered;
+  auto deliver = [&](int&& value) { delivered.push_back(value); };
+
+  Buffer::Sequence first = buffer.Reserve();
+  Buffer::Sequence second = buffer.Reserve();
+  Buffer::Sequence third = buffer.Reserve();
+
+  buffer.Complete(third, 3, deliver);
+  buffer.Complete(second, 2, deliver);
+  EXPECT_TRUE(delivered.empty());
+  EXPECT_EQ(2u, buffer.pending_size());
+
+  buffer.Complete(first, 1, deliver);
+  EXPECT_EQ((std::vector<int>{1, 2, 3}), delivered);
+  EXPECT_EQ(0u, buffer.pending_size());
+}
+
+TEST(ReorderBufferTest, RestoresOrderOfShuffledCompletions) {
+  Buffer buffer;
+  std::vector<Buffer::Sequence> sequences;
+  for (int i = 0; i < 1000; ++i) {
+    sequences.push_back(buffer.Reserve());
+  }
+  std::shuffle(sequences.begin(), sequences.end(), std::mt19937{});
+
+  std::vector<int> delivered;
+  for (Buffer::Sequence sequence : sequences) {
+    buffer.Complete(sequence, static_cast<int>(sequence),
+                    [&](int&& value) { delivered.push_back(value); });
+  }
+  ASSERT_EQ(1000u, delivered.size());
+  EXPECT_TRUE(std::is_sorted(delivered.begin(), delivered.end()));
+}
+
+TEST(ReorderBufferTest, ClearDiscardsOutstandingWork) {
+  Buffer buffer;
+  std::vector<int> delivered;
+  auto deliver = [&](int&& value) { delivered.push_back(value); };
+
+  Buffer::Sequence stale_first = buffer.Reserve();
+  Buffer::Sequence stale_second = buffer.Reserve();
+  buffer.Complete(stale_second, -2, deliver);
+  buffer.Clear();
+  EXPECT_EQ(0u, buffer.pending_size());
+
+  Buffer::Sequence fresh = buffer.Reserve();
+  buffer.Complete(stale_first, -1, deliver);
+  buffer.Complete(fresh, 1, deliver);
+  EXPECT_EQ((std::vector<int>{1}), delivered);
+}
+
+TEST(ReorderBufferTest, DeliverCanClear) {
+  Buffer buffer;
+  std::vector<int> delivered;
+
+  Buffer::Sequence first = buffer.Reserve();
+  Buffer::Sequence second = buffer.Reserve();
+  buffer.Complete(second, 2, [&](int&& value) { delivered.push_back(value); });
+
+  // Delivering the first result clears the buffer, so the second is dropped.
+  buffer.Complete(first, 1, [&](int&& value) {
+    delivered.push_back(value);
+    buffer.Clear();
+  });
+  EXPECT_EQ((std::vector<int>{1}), delivered);
+  EXPECT_EQ(0u, buffer.pending_size());
+}
+
+TEST(ReorderBufferTest, SupportsMoveOnlyResults) {
+  ReorderBuffer<std::unique_ptr<int>> buffer;
+  std::vector<int> delivered;
+  auto deliver = [&](std::unique_ptr<int>&& value) {
+    delivered.push_back(*value);
+  };
+
+  auto first = buffer.Reserve();
+  auto second = buffer.Reserve();
+  buffer.Complete(second, absl::make_unique<int>(2), deliver);
+  buffer.Complete(first, absl::make_unique<int>(1), deliver);
+  EXPECT_EQ((std::vector<int>{1, 2}), delivered);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
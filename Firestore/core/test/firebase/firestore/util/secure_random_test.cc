@@ -31,6 +31,19 @@ TEST(SecureRandomTest, ResultsAreBounded) {
   }
 }
 
+TEST(SecureRandomTest, Fill) {
+  SecureRandom rng;
+  uint8_t bytes[1000] = {};
+  rng.Fill(bytes, sizeof(bytes));
+
+  int zeros = 0;
+  for (uint8_t byte : bytes) {
+    if (byte == 0) zeros++;
+  }
+  // Practically, zeros should be close to 4.
+  EXPECT_GT(50, zeros) << zeros;
+}
+
 TEST(SecureRandomTest, Uniform) {
   SecureRandom rng;
   int count[10] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
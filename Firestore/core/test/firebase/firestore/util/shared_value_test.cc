@@ -0,0 +1,100 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/shared_value.h"
+
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+struct Counted {
+  explicit Counted(int* live_count) : live(live_count) {
+    *live += 1;
+  }
+
+  Counted(Counted&& other) : live(other.live) {
+    *live += 1;
+  }
+
+  ~Counted() {
+    *live -= 1;
+  }
+
+  int* live;
+};
+
+}  // namespace
+
+TEST(SharedValueTest, IsTheSizeOfAPointer) {
+  EXPECT_EQ(sizeof(void*), sizeof(SharedValue<std::string>));
+}
+
+TEST(SharedValueTest, CopiesShareTheValue) {
+  SharedValue<std::string> a{std::string("abc")};
+  SharedValue<std::string> b = a;
+  EXPECT_EQ("abc", *b);
+  EXPECT_EQ(&a.get(), &b.get());
+  EXPECT_TRUE(a.SharesWith(b));
+
+  SharedValue<std::string> c{std::string("abc")};
+  EXPECT_FALSE(a.SharesWith(c));
+}
+
+TEST(SharedValueTest, DestroysTheValueWithTheLastCopy) {
+  int live = 0;
+  {
+    SharedValue<Counted> a{Counted(&live)};
+    EXPECT_EQ(1, live);
+    {
+      SharedValue<Counted> b = a;
+      SharedValue<Counted> c;
+      c = b;
+      EXPECT_EQ(1, live);
+    }
+    EXPECT_EQ(1, live);
+  }
+  EXPECT_EQ(0, live);
+}
+
+TEST(SharedValueTest, SelfAssignment) {
+  int live = 0;
+  SharedValue<Counted> a{Counted(&live)};
+  SharedValue<Counted>& alias = a;
+  a = alias;
+  EXPECT_EQ(1, live);
+  EXPECT_EQ(&live, a->live);
+}
+
+TEST(SharedValueTest, AssignmentReleasesThePreviousValue) {
+  int first = 0;
+  int second = 0;
+  SharedValue<Counted> a{Counted(&first)};
+  SharedValue<Counted> b{Counted(&second)};
+  a = b;
+  EXPECT_EQ(0, first);
+  EXPECT_EQ(1, second);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -17,6 +17,7 @@
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 
 #include <cerrno>
+#include <utility>
 
 #include "Firestore/core/test/firebase/firestore/util/status_test_util.h"
 #include "gmock/gmock.h"
@@ -62,6 +63,22 @@ TEST(Status, Assign) {
   ASSERT_EQ(a.ToString(), b.ToString());
 }
 
+TEST(Status, Move) {
+  Status a(FirestoreErrorCode::InvalidArgument, "Invalid");
+  Status b(std::move(a));
+  EXPECT_EQ(b.code(), FirestoreErrorCode::InvalidArgument);
+  EXPECT_EQ(b.error_message(), "Invalid");
+  EXPECT_TRUE(a.ok());
+}
+
+TEST(Status, MoveAssign) {
+  Status a(FirestoreErrorCode::InvalidArgument, "Invalid");
+  Status b(FirestoreErrorCode::Cancelled, "Cancelled");
+  b = std::move(a);
+  EXPECT_EQ(b.code(), FirestoreErrorCode::InvalidArgument);
+  EXPECT_EQ(b.error_message(), "Invalid");
+}
+
 TEST(Status, Update) {
   Status s;
   s.Update(Status::OK());
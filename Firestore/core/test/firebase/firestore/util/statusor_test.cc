@@ -173,6 +173,20 @@ TEST(StatusOr, TestMoveWithValuesAndErrors) {
   EXPECT_EQ(string(1000, '2'), status_or.ValueOrDie());
 }
 
+TEST(StatusOr, TestMovedFromErrorStaysFailed) {
+  StatusOr<std::unique_ptr<int>> error(
+      Status(FirestoreErrorCode::Unknown, "error"));
+
+  StatusOr<std::unique_ptr<int>> moved(std::move(error));
+  ASSERT_FALSE(moved.ok());
+  EXPECT_EQ("error", moved.status().error_message());
+  ASSERT_FALSE(error.ok());
+
+  Status status = std::move(moved).status();
+  EXPECT_EQ("error", status.error_message());
+  EXPECT_FALSE(moved.ok());
+}
+
 TEST(StatusOr, TestCopyWithValuesAndErrors) {
   StatusOr<string> status_or(string(1000, '0'));
   StatusOr<string> value1(string(1000, '1'));
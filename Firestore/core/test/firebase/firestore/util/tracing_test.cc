@@ -0,0 +1,110 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/tracing.h"
+
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+
+#include "Firestore/core/src/firebase/firestore/util/filesystem.h"
+#include "Firestore/core/src/firebase/firestore/util/path.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+bool Contains(const std::string& haystack, const std::string& needle) {
+  return haystack.find(needle) != std::string::npos;
+}
+
+}  // namespace
+
+TEST(TracingTest, RecordsNothingWhileStopped) {
+  TracingStart();
+  TracingStop();
+  EXPECT_FALSE(TracingIsEnabled());
+  { TRACE_SPAN("test", "Ignored"); }
+
+  EXPECT_FALSE(Contains(TracingToJson(), "Ignored"));
+}
+
+TEST(TracingTest, RecordsSpansAsCompleteEvents) {
+  TracingStart();
+  EXPECT_TRUE(TracingIsEnabled());
+  {
+    TRACE_SPAN("test", "Outer");
+    TRACE_SPAN("test", "Inner");
+  }
+  TracingStop();
+
+  std::string json = TracingToJson();
+  EXPECT_TRUE(Contains(json, R"("traceEvents":[)"));
+  EXPECT_TRUE(Contains(json, R"({"name":"Inner","cat":"test","ph":"X","ts":)"));
+  EXPECT_TRUE(Contains(json, R"({"name":"Outer","cat":"test","ph":"X","ts":)"));
+  // Spans are recorded as they end.
+  EXPECT_LT(json.find("Inner"), json.find("Outer"));
+}
+
+TEST(TracingTest, StartDiscardsThePreviousTrace) {
+  TracingStart();
+  { TRACE_SPAN("test", "First"); }
+  TracingStart();
+  { TRACE_SPAN("test", "Second"); }
+  TracingStop();
+
+  std::string json = TracingToJson();
+  EXPECT_FALSE(Contains(json, "First"));
+  EXPECT_TRUE(Contains(json, "Second"));
+}
+
+TEST(TracingTest, NumbersThreads) {
+  TracingStart();
+  { TRACE_SPAN("test", "Main"); }
+  std::thread([] { TRACE_SPAN("test", "Other"); }).join();
+  TracingStop();
+
+  std::string json = TracingToJson();
+  EXPECT_TRUE(Contains(json, R"("pid":1,"tid":0})"));
+  EXPECT_TRUE(Contains(json, R"("pid":1,"tid":1})"));
+}
+
+TEST(TracingTest, EscapesNames) {
+  TracingStart();
+  { TRACE_SPAN("test", "quoted \"name\""); }
+  TracingStop();
+
+  EXPECT_TRUE(Contains(TracingToJson(), R"("name":"quoted \"name\"")"));
+}
+
+TEST(TracingTest, WritesJsonToFile) {
+  TracingStart();
+  { TRACE_SPAN("test", "Written"); }
+  TracingStop();
+
+  Path file = Path::JoinUtf8(TempDir(), "firestore_tracing_test.json");
+  ASSERT_TRUE(TracingWriteJson(file).ok());
+  StatusOr<std::string> contents = ReadFile(file);
+  ASSERT_TRUE(contents.ok());
+  EXPECT_EQ(contents.ValueOrDie(), TracingToJson());
+  EXPECT_TRUE(RecursivelyDelete(file).ok());
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/worker_pool.h"
+
+#include <atomic>
+#include <future>  // NOLINT(build/c++11)
+#include <memory>
+#include <set>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/executor_std.h"
+#include "Firestore/core/test/firebase/firestore/util/async_tests_util.h"
+#include "absl/memory/memory.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+TEST(WorkerPoolTest, RunsOperationsConcurrently) {
+  WorkerPool pool{2};
+  std::promise<void> first_started;
+  std::promise<void> second_started;
+
+  // Each operation waits for the other one to start, which only finishes if
+  // they run at the same time.
+  pool.Execute([&] {
+    first_started.set_value();
+    ABORT_ON_TIMEOUT(second_started.get_future());
+  });
+  pool.Execute([&] {
+    second_started.set_value();
+    ABORT_ON_TIMEOUT(first_started.get_future());
+  });
+}
+
+TEST(WorkerPoolTest, FinishesSubmittedOperationsBeforeDestruction) {
+  std::atomic<int> finished{0};
+  {
+    WorkerPool pool{1};
+    for (int i = 0; i != 100; ++i) {
+      pool.Execute([&finished] { ++finished; });
+    }
+  }
+  EXPECT_EQ(finished, 100);
+}
+
+TEST(WorkerPoolTest, ParallelForCoversTheWholeRangeOnce) {
+  WorkerPool pool{3};
+  std::vector<std::atomic<int>> visits(1000);
+  for (std::atomic<int>& visit : visits) {
+    visit = 0;
+  }
+
+  pool.ParallelFor(visits.size(), 7, [&visits](size_t begin, size_t end) {
+    EXPECT_LT(begin, end);
+    for (size_t i = begin; i != end; ++i) {
+      ++visits[i];
+    }
+  });
+
+  for (const std::atomic<int>& visit : visits) {
+    EXPECT_EQ(visit, 1);
+  }
+}
+
+TEST(WorkerPoolTest, ParallelForWorksWhenThePoolIsBusy) {
+  WorkerPool pool{1};
+  std::promise<void> done;
+
+  // The only thread of the pool runs the outer operation, so the nested call
+  // has to be processed by the calling thread alone.
+  pool.Execute([&] {
+    std::atomic<size_t> total{0};
+    pool.ParallelFor(100, 1, [&total](size_t begin, size_t end) {
+      total += end - begin;
+    });
+    EXPECT_EQ(total, 100u);
+    done.set_value();
+  });
+  ABORT_ON_TIMEOUT(done.get_future());
+}
+
+TEST(WorkerPoolTest, ExecuteThenDeliversResultsOnTheQueue) {
+  AsyncQueue queue{absl::make_unique<ExecutorStd>()};
+  WorkerPool pool{2};
+  std::promise<void> done;
+
+  pool.ExecuteThen(
+      &queue, [] { return std::set<int>{3, 1, 2}; },
+      [&](std::set<int> result) {
+        queue.VerifyIsCurrentQueue();
+        EXPECT_EQ(result, (std::set<int>{1, 2, 3}));
+        done.set_value();
+      });
+  ABORT_ON_TIMEOUT(done.get_future());
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
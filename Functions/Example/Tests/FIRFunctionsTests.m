@@ -14,6 +14,8 @@
 
 #import <XCTest/XCTest.h>
 
+#import <GTMSessionFetcher/GTMSessionFetcherService.h>
+
 #import "FIRFunctions+Internal.h"
 #import "FIRFunctions.h"
 
@@ -38,4 +40,10 @@
   XCTAssertEqualObjects(@"https://my-region-my-project.cloudfunctions.net/my-endpoint", url);
 }
 
+- (void)testSharedFetcherServiceReusesSession {
+  GTMSessionFetcherService *fetcherService = [FIRFunctions sharedFetcherService];
+  XCTAssertEqual(fetcherService, [FIRFunctions sharedFetcherService]);
+  XCTAssertTrue(fetcherService.reuseSession);
+}
+
 @end
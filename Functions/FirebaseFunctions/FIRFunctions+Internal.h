@@ -18,6 +18,7 @@
 
 @protocol FIRAuthInterop;
 @class FIRHTTPSCallableResult;
+@class GTMSessionFetcherService;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -41,6 +42,13 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (NSString *)URLWithName:(NSString *)name;
 
+/**
+ * The fetcher service every Cloud Functions client sends its requests through. `functions` and the
+ * other class methods return a new client each time they are called, so sharing the service keeps
+ * one warm session, and its connections to the functions host, for all of them.
+ */
++ (GTMSessionFetcherService *)sharedFetcherService;
+
 /**
  * Sets the functions client to send requests to localhost instead of Firebase.
  * For testing only.
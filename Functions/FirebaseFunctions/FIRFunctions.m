@@ -95,6 +95,16 @@ NSString *const kFUNDefaultRegion = @"us-central1";
   return @[ internalProvider ];
 }
 
++ (GTMSessionFetcherService *)sharedFetcherService {
+  static GTMSessionFetcherService *fetcherService;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    fetcherService = [[GTMSessionFetcherService alloc] init];
+    fetcherService.reuseSession = YES;
+  });
+  return fetcherService;
+}
+
 + (instancetype)functions {
   return [[self alloc] initWithApp:[FIRApp defaultApp] region:kFUNDefaultRegion];
 }
@@ -125,7 +135,7 @@ NSString *const kFUNDefaultRegion = @"us-central1";
     if (!region) {
       FUNThrowInvalidArgument(@"FIRFunctions region cannot be nil.");
     }
-    _fetcherService = [[GTMSessionFetcherService alloc] init];
+    _fetcherService = [[self class] sharedFetcherService];
     _projectID = [projectID copy];
     _region = [region copy];
     _serializer = [[FUNSerializer alloc] init];
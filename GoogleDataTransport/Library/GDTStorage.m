@@ -42,7 +42,13 @@ static NSString *GDTStoragePath() {
   return storagePath;
 }
 
-@implementation GDTStorage
+/** Set on the storage queue, so that methods can tell when they're already running on it. */
+static const void *const kGDTStorageQueueKey = &kGDTStorageQueueKey;
+
+@implementation GDTStorage {
+  /** The background tasks of events stored in the background that are waiting on an archive. */
+  NSMutableArray<NSNumber *> *_backgroundTasksAwaitingArchive;
+}
 
 + (NSString *)archivePath {
   static NSString *archivePath;
@@ -66,6 +72,9 @@ static NSString *GDTStoragePath() {
   self = [super init];
   if (self) {
     _storageQueue = dispatch_queue_create("com.google.GDTStorage", DISPATCH_QUEUE_SERIAL);
+    dispatch_queue_set_specific(_storageQueue, kGDTStorageQueueKey, (void *)kGDTStorageQueueKey,
+                                NULL);
+    _backgroundTasksAwaitingArchive = [[NSMutableArray alloc] init];
     _targetToEventSet = [[NSMutableDictionary alloc] init];
     _storedEvents = [[NSMutableOrderedSet alloc] init];
     _uploader = [GDTUploadCoordinator sharedInstance];
@@ -74,6 +83,14 @@ static NSString *GDTStoragePath() {
 }
 
 - (void)storeEvent:(GDTEvent *)event {
+  [self storeEvents:@[ event ]];
+}
+
+- (void)storeEvents:(NSArray<GDTEvent *> *)events {
+  if (events.count == 0) {
+    return;
+  }
+  NSArray<GDTEvent *> *eventsToStore = [events copy];
   [self createEventDirectoryIfNotExists];
 
   __block UIBackgroundTaskIdentifier bgID = UIBackgroundTaskInvalid;
@@ -84,34 +101,41 @@ static NSString *GDTStoragePath() {
   }
 
   dispatch_async(_storageQueue, ^{
-    // Check that a backend implementation is available for this target.
-    NSInteger target = event.target;
-
-    // Check that a prioritizer is available for this target.
-    id<GDTPrioritizer> prioritizer = [GDTRegistrar sharedInstance].targetToPrioritizer[@(target)];
-    GDTAssert(prioritizer, @"There's no prioritizer registered for the given target.");
-
-    // Write the transport bytes to disk, get a filename.
-    GDTAssert(event.dataObjectTransportBytes, @"The event should have been serialized to bytes");
-    NSURL *eventFile = [self saveEventBytesToDisk:event.dataObjectTransportBytes
-                                        eventHash:event.hash];
-    GDTStoredEvent *storedEvent = [event storedEventWithFileURL:eventFile];
-
-    // Add event to tracking collections.
-    [self addEventToTrackingCollections:storedEvent];
-
-    // Have the prioritizer prioritize the event.
-    [prioritizer prioritizeEvent:storedEvent];
-
-    // Check the QoS, if it's high priority, notify the target that it has a high priority event.
-    if (event.qosTier == GDTEventQoSFast) {
-      [self.uploader forceUploadForTarget:target];
+    NSMutableIndexSet *targetsToUpload = [[NSMutableIndexSet alloc] init];
+    for (GDTEvent *event in eventsToStore) {
+      // Check that a backend implementation is available for this target.
+      NSInteger target = event.target;
+
+      // Check that a prioritizer is available for this target.
+      id<GDTPrioritizer> prioritizer =
+          [GDTRegistrar sharedInstance].targetToPrioritizer[@(target)];
+      GDTAssert(prioritizer, @"There's no prioritizer registered for the given target.");
+
+      // Write the transport bytes to disk, get a filename.
+      GDTAssert(event.dataObjectTransportBytes, @"The event should have been serialized to bytes");
+      NSURL *eventFile = [self saveEventBytesToDisk:event.dataObjectTransportBytes
+                                          eventHash:event.hash];
+      GDTStoredEvent *storedEvent = [event storedEventWithFileURL:eventFile];
+
+      // Add event to tracking collections.
+      [self addEventToTrackingCollections:storedEvent];
+
+      // Have the prioritizer prioritize the event.
+      [prioritizer prioritizeEvent:storedEvent];
+
+      // Check the QoS, if it's high priority, the target is told it has a high priority event
+      // once the whole batch is stored.
+      if (event.qosTier == GDTEventQoSFast) {
+        [targetsToUpload addIndex:(NSUInteger)target];
+      }
     }
+    [targetsToUpload enumerateIndexesUsingBlock:^(NSUInteger target, BOOL *stop) {
+      [self.uploader forceUploadForTarget:(GDTTarget)target];
+    }];
 
     // If running in the background, save state to disk and end the associated background task.
     if (bgID != UIBackgroundTaskInvalid) {
-      [NSKeyedArchiver archiveRootObject:self toFile:[GDTStorage archivePath]];
-      [[UIApplication sharedApplication] endBackgroundTask:bgID];
+      [self archiveEndingBackgroundTask:bgID];
     }
   });
 }
@@ -179,6 +203,29 @@ static NSString *GDTStoragePath() {
   return eventFilePath;
 }
 
+/** Archives the storage and then ends the given background task. The archive is made once every
+ * event already queued on _storageQueue has been stored, so a burst of events logged in the
+ * background is archived once rather than once per event.
+ *
+ * @note This method should only be called from a method within a block on _storageQueue to maintain
+ * thread safety.
+ *
+ * @param bgID The background task to end once the archive is written.
+ */
+- (void)archiveEndingBackgroundTask:(UIBackgroundTaskIdentifier)bgID {
+  [_backgroundTasksAwaitingArchive addObject:@(bgID)];
+  if (_backgroundTasksAwaitingArchive.count > 1) {
+    return;
+  }
+  dispatch_async(_storageQueue, ^{
+    [NSKeyedArchiver archiveRootObject:self toFile:[GDTStorage archivePath]];
+    for (NSNumber *taskID in self->_backgroundTasksAwaitingArchive) {
+      [[UIApplication sharedApplication] endBackgroundTask:taskID.unsignedIntegerValue];
+    }
+    [self->_backgroundTasksAwaitingArchive removeAllObjects];
+  });
+}
+
 /** Adds the event to internal tracking collections.
  *
  * @note This method should only be called from a method within a block on _storageQueue to maintain
@@ -244,10 +291,16 @@ static NSString *const kGDTStorageTargetToEventSetKey = @"GDTStorageTargetToEven
 
 - (void)encodeWithCoder:(NSCoder *)aCoder {
   GDTStorage *sharedInstance = [self.class sharedInstance];
-  dispatch_sync(sharedInstance.storageQueue, ^{
+  dispatch_block_t encode = ^{
     [aCoder encodeObject:sharedInstance->_storedEvents forKey:kGDTStorageStoredEventsKey];
     [aCoder encodeObject:sharedInstance->_targetToEventSet forKey:kGDTStorageTargetToEventSetKey];
-  });
+  };
+  // Archives made while storing events are already on the storage queue.
+  if (dispatch_get_specific(kGDTStorageQueueKey)) {
+    encode();
+  } else {
+    dispatch_sync(sharedInstance.storageQueue, encode);
+  }
 }
 
 @end
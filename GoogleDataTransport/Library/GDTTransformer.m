@@ -24,7 +24,13 @@
 #import "Library/Private/GDTConsoleLogger.h"
 #import "Library/Private/GDTStorage.h"
 
-@implementation GDTTransformer
+@implementation GDTTransformer {
+  /** The events waiting to be transformed and stored, guarded by @synchronized(self). */
+  NSMutableArray<GDTEvent *> *_pendingEvents;
+
+  /** The transformers for each of _pendingEvents, or NSNull for none. */
+  NSMutableArray *_pendingTransformers;
+}
 
 + (instancetype)sharedInstance {
   static GDTTransformer *eventTransformer;
@@ -40,6 +46,8 @@
   if (self) {
     _eventWritingQueue = dispatch_queue_create("com.google.GDTTransformer", DISPATCH_QUEUE_SERIAL);
     _storageInstance = [GDTStorage sharedInstance];
+    _pendingEvents = [[NSMutableArray alloc] init];
+    _pendingTransformers = [[NSMutableArray alloc] init];
   }
   return self;
 }
@@ -48,6 +56,18 @@
       withTransformers:(NSArray<id<GDTEventTransformer>> *)transformers {
   GDTAssert(event, @"You can't write a nil event");
 
+  // Events logged while earlier ones are still waiting for _eventWritingQueue join their batch
+  // rather than queueing a block of their own.
+  BOOL startsBatch;
+  @synchronized(self) {
+    startsBatch = _pendingEvents.count == 0;
+    [_pendingEvents addObject:event];
+    [_pendingTransformers addObject:transformers ? transformers : [NSNull null]];
+  }
+  if (!startsBatch) {
+    return;
+  }
+
   __block UIBackgroundTaskIdentifier bgID = UIBackgroundTaskInvalid;
   if (_runningInBackground) {
     bgID = [[UIApplication sharedApplication] beginBackgroundTaskWithExpirationHandler:^{
@@ -55,26 +75,66 @@
     }];
   }
   dispatch_async(_eventWritingQueue, ^{
-    GDTEvent *transformedEvent = event;
-    for (id<GDTEventTransformer> transformer in transformers) {
-      if ([transformer respondsToSelector:@selector(transform:)]) {
-        transformedEvent = [transformer transform:transformedEvent];
-        if (!transformedEvent) {
-          return;
-        }
-      } else {
-        GDTLogError(GDTMCETransformerDoesntImplementTransform,
-                    @"Transformer doesn't implement transform: %@", transformer);
-        return;
-      }
-    }
-    [self.storageInstance storeEvent:transformedEvent];
-    if (self->_runningInBackground) {
+    [self transformPendingEvents];
+    if (bgID != UIBackgroundTaskInvalid) {
       [[UIApplication sharedApplication] endBackgroundTask:bgID];
     }
   });
 }
 
+#pragma mark - Private helper methods
+
+/** Runs the transformers of every pending event and stores the events that remain in one batch.
+ *
+ * @note This method should only be called from a block on _eventWritingQueue.
+ */
+- (void)transformPendingEvents {
+  NSArray<GDTEvent *> *events;
+  NSArray *transformerLists;
+  @synchronized(self) {
+    events = [_pendingEvents copy];
+    transformerLists = [_pendingTransformers copy];
+    [_pendingEvents removeAllObjects];
+    [_pendingTransformers removeAllObjects];
+  }
+
+  NSMutableArray<GDTEvent *> *transformedEvents =
+      [[NSMutableArray alloc] initWithCapacity:events.count];
+  [events enumerateObjectsUsingBlock:^(GDTEvent *event, NSUInteger idx, BOOL *stop) {
+    GDTEvent *transformedEvent = [self applyTransformers:transformerLists[idx] toEvent:event];
+    if (transformedEvent) {
+      [transformedEvents addObject:transformedEvent];
+    }
+  }];
+  [self.storageInstance storeEvents:transformedEvents];
+}
+
+/** Runs the given transformers over an event.
+ *
+ * @param transformers The transformers to run, or NSNull for none.
+ * @param event The event to transform.
+ * @return The transformed event, or nil if the event shouldn't be stored.
+ */
+- (nullable GDTEvent *)applyTransformers:(id)transformers toEvent:(GDTEvent *)event {
+  if (transformers == [NSNull null]) {
+    return event;
+  }
+  GDTEvent *transformedEvent = event;
+  for (id<GDTEventTransformer> transformer in (NSArray<id<GDTEventTransformer>> *)transformers) {
+    if ([transformer respondsToSelector:@selector(transform:)]) {
+      transformedEvent = [transformer transform:transformedEvent];
+      if (!transformedEvent) {
+        return nil;
+      }
+    } else {
+      GDTLogError(GDTMCETransformerDoesntImplementTransform,
+                  @"Transformer doesn't implement transform: %@", transformer);
+      return nil;
+    }
+  }
+  return transformedEvent;
+}
+
 #pragma mark - GDTLifecycleProtocol
 
 - (void)appWillForeground:(UIApplication *)app {
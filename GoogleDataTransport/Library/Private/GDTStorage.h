@@ -39,6 +39,12 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)storeEvent:(GDTEvent *)event;
 
+/** Stores each of the given events as storeEvent: does, in one pass on the storage queue.
+ *
+ * @param events The events to store, in order.
+ */
+- (void)storeEvents:(NSArray<GDTEvent *> *)events;
+
 /** Removes a set of events from storage specified by their hash.
  *
  * @param events The set of stored events to remove.
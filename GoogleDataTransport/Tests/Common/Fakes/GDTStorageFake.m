@@ -21,6 +21,9 @@
 - (void)storeEvent:(GDTEvent *)event {
 }
 
+- (void)storeEvents:(NSArray<GDTEvent *> *)events {
+}
+
 - (void)removeEvents:(NSSet<GDTStoredEvent *> *)events {
 }
 
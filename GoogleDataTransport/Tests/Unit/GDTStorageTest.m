@@ -288,6 +288,26 @@ static NSInteger target = 1337;
   XCTAssertNotNil([unarchivedStorage.storedEvents lastObject]);
 }
 
+/** Tests encoding the storage singleton from the storage queue, as storing events in the background
+ * does. */
+- (void)testNSSecureCodingOnStorageQueue {
+  GDTEvent *event = [[GDTEvent alloc] initWithMappingID:@"404" target:target];
+  event.dataObjectTransportBytes = [@"testString" dataUsingEncoding:NSUTF8StringEncoding];
+  XCTAssertNoThrow([[GDTStorage sharedInstance] storeEvent:event]);
+  event = nil;
+  __block NSData *storageData;
+  dispatch_sync([GDTStorage sharedInstance].storageQueue, ^{
+    storageData = [NSKeyedArchiver archivedDataWithRootObject:[GDTStorage sharedInstance]];
+  });
+  [[GDTStorage sharedInstance] removeEvents:[GDTStorage sharedInstance].storedEvents.set];
+  dispatch_sync([GDTStorage sharedInstance].storageQueue, ^{
+    XCTAssertNil([[GDTStorage sharedInstance].storedEvents lastObject]);
+  });
+
+  GDTStorage *unarchivedStorage = [NSKeyedUnarchiver unarchiveObjectWithData:storageData];
+  XCTAssertNotNil([unarchivedStorage.storedEvents lastObject]);
+}
+
 /** Tests sending a fast priority event causes an upload attempt. */
 - (void)testQoSTierFast {
   // event is autoreleased, and the pool needs to drain.
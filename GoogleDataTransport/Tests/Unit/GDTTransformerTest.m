@@ -52,6 +52,29 @@
 
 @end
 
+@interface GDTTransformerTestBatchRecordingStorage : GDTStorageFake
+
+/** The batches of events that have been passed to -storeEvents:. */
+@property(nonatomic) NSMutableArray<NSArray<GDTEvent *> *> *batches;
+
+@end
+
+@implementation GDTTransformerTestBatchRecordingStorage
+
+- (instancetype)init {
+  self = [super init];
+  if (self) {
+    _batches = [[NSMutableArray alloc] init];
+  }
+  return self;
+}
+
+- (void)storeEvents:(NSArray<GDTEvent *> *)events {
+  [_batches addObject:events];
+}
+
+@end
+
 @interface GDTTransformerTest : GDTTestCase
 
 @end
@@ -125,4 +148,28 @@
   [self waitForExpectations:@[ errorExpectation ] timeout:5.0];
 }
 
+/** Tests that events written while the queue is busy are transformed and stored as one batch. */
+- (void)testEventsWrittenWhileQueueIsBusyAreStoredInOneBatch {
+  GDTTransformer *transformer = [GDTTransformer sharedInstance];
+  GDTTransformerTestBatchRecordingStorage *storage =
+      [[GDTTransformerTestBatchRecordingStorage alloc] init];
+  dispatch_semaphore_t queueBlocked = dispatch_semaphore_create(0);
+  dispatch_async(transformer.eventWritingQueue, ^{
+    transformer.storageInstance = storage;
+    dispatch_semaphore_wait(queueBlocked, DISPATCH_TIME_FOREVER);
+  });
+  NSArray<id<GDTEventTransformer>> *nilingTransformers =
+      @[ [[GDTTransformerTestNilingTransformer alloc] init] ];
+  for (int i = 0; i < 10; i++) {
+    GDTEvent *event = [[GDTEvent alloc] initWithMappingID:@"1" target:1];
+    event.dataObject = [[GDTDataObjectTesterSimple alloc] init];
+    [transformer transformEvent:event withTransformers:(i % 2 == 0 ? nil : nilingTransformers)];
+  }
+  dispatch_semaphore_signal(queueBlocked);
+  dispatch_sync(transformer.eventWritingQueue, ^{
+    XCTAssertEqual(storage.batches.count, 1);
+    XCTAssertEqual(storage.batches.firstObject.count, 5);
+  });
+}
+
 @end
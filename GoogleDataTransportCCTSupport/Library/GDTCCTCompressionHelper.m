@@ -0,0 +1,62 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "Library/Private/GDTCCTCompressionHelper.h"
+
+#import <zlib.h>
+
+/** The size of the chunks the compressed bytes are written out in. */
+static const NSUInteger kGDTCCTCompressionChunkSize = 16 * 1024;
+
+@implementation GDTCCTCompressionHelper
+
++ (nullable NSData *)gzippedData:(NSData *)data {
+  if (data.length > UINT_MAX) {
+    return nil;
+  }
+  z_stream stream;
+  memset(&stream, 0, sizeof(z_stream));
+  // A windowBits of 15 + 16 makes zlib write a gzip header and trailer.
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) !=
+      Z_OK) {
+    return nil;
+  }
+  NSMutableData *compressedData = [[NSMutableData alloc] initWithCapacity:data.length / 2 + 64];
+  stream.next_in = (Bytef *)data.bytes;
+  stream.avail_in = (uInt)data.length;
+  int status;
+  do {
+    if (compressedData.length - stream.total_out < kGDTCCTCompressionChunkSize) {
+      [compressedData increaseLengthBy:kGDTCCTCompressionChunkSize];
+    }
+    stream.next_out = (Bytef *)compressedData.mutableBytes + stream.total_out;
+    stream.avail_out = (uInt)(compressedData.length - stream.total_out);
+    status = deflate(&stream, Z_FINISH);
+  } while (status == Z_OK);
+  deflateEnd(&stream);
+  if (status != Z_STREAM_END) {
+    return nil;
+  }
+  compressedData.length = stream.total_out;
+  return compressedData;
+}
+
++ (BOOL)isGzipped:(NSData *)data {
+  const UInt8 *bytes = (const UInt8 *)data.bytes;
+  return data.length >= 2 && bytes[0] == 0x1f && bytes[1] == 0x8b;
+}
+
+@end
@@ -110,7 +110,11 @@ gdt_cct_LogEvent GDTCCTConstructLogEvent(GDTStoredEvent *event) {
   // TODO: Read network_connection_info from the custom params dict.
 
   NSError *error;
-  NSData *extensionBytes = [NSData dataWithContentsOfURL:event.eventFileURL options:0 error:&error];
+  // Mapping the file lets its bytes be copied straight into the proto instead of through a second
+  // heap buffer.
+  NSData *extensionBytes = [NSData dataWithContentsOfURL:event.eventFileURL
+                                                 options:NSDataReadingMappedIfSafe
+                                                   error:&error];
   NSCAssert(error == nil, @"There was an error reading extension bytes from disk: %@", error);
   logEvent.source_extension = GDTCCTEncodeData(extensionBytes);  // read bytes from the file.
   return logEvent;
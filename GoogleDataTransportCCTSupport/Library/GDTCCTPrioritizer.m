@@ -18,7 +18,16 @@
 
 const static NSUInteger kMillisPerDay = 8.64e+7;
 
-@implementation GDTCCTPrioritizer
+/** The default value of maxPackageBytes. */
+const static NSUInteger kGDTCCTDefaultMaxPackageBytes = 512 * 1024;
+
+@implementation GDTCCTPrioritizer {
+  /** The size in bytes of each event's file, read when the event is prioritized. */
+  NSMapTable<GDTStoredEvent *, NSNumber *> *_eventByteSizes;
+
+  /** The events in self.events, bucketed by their GDTCCTQoSTier. */
+  NSMutableDictionary<NSNumber *, NSMutableSet<GDTStoredEvent *> *> *_eventsByCCTQoSTier;
+}
 
 + (void)load {
   GDTCCTPrioritizer *prioritizer = [GDTCCTPrioritizer sharedInstance];
@@ -39,6 +48,9 @@ const static NSUInteger kMillisPerDay = 8.64e+7;
   if (self) {
     _queue = dispatch_queue_create("com.google.GDTCCTPrioritizer", DISPATCH_QUEUE_SERIAL);
     _events = [[NSMutableSet alloc] init];
+    _eventByteSizes = [NSMapTable strongToStrongObjectsMapTable];
+    _eventsByCCTQoSTier = [[NSMutableDictionary alloc] init];
+    _maxPackageBytes = kGDTCCTDefaultMaxPackageBytes;
   }
   return self;
 }
@@ -48,6 +60,10 @@ const static NSUInteger kMillisPerDay = 8.64e+7;
 - (void)prioritizeEvent:(GDTStoredEvent *)event {
   dispatch_async(_queue, ^{
     [self.events addObject:event];
+    [[self eventsInCCTQoSTierOfEvent:event] addObject:event];
+    NSNumber *byteSize;
+    [event.eventFileURL getResourceValue:&byteSize forKey:NSURLFileSizeKey error:nil];
+    [self->_eventByteSizes setObject:(byteSize ? byteSize : @0) forKey:event];
   });
 }
 
@@ -55,6 +71,8 @@ const static NSUInteger kMillisPerDay = 8.64e+7;
   dispatch_async(_queue, ^{
     for (GDTStoredEvent *event in events) {
       [self.events removeObject:event];
+      [[self eventsInCCTQoSTierOfEvent:event] removeObject:event];
+      [self->_eventByteSizes removeObjectForKey:event];
     }
   });
 }
@@ -65,7 +83,7 @@ const static NSUInteger kMillisPerDay = 8.64e+7;
     NSSet<GDTStoredEvent *> *logEventsThatWillBeSent;
     // A high priority event effectively flushes all events to be sent.
     if ((conditions & GDTUploadConditionHighPriority) == GDTUploadConditionHighPriority) {
-      package.events = self.events;
+      package.events = [self eventsCappedToMaxPackageBytes:[self.events copy]];
       return;
     }
 
@@ -86,7 +104,7 @@ const static NSUInteger kMillisPerDay = 8.64e+7;
       logEventsThatWillBeSent =
           [logEventsThatWillBeSent setByAddingObjectsFromSet:[self logEventsOkToSendDaily]];
     }
-    package.events = logEventsThatWillBeSent;
+    package.events = [self eventsCappedToMaxPackageBytes:logEventsThatWillBeSent];
   });
   return package;
 }
@@ -131,16 +149,65 @@ NSNumber *GDTCCTQosTierFromGDTEventQosTier(GDTEventQoS qosTier) {
   }
 }
 
+/** Returns the oldest of the given events whose files fit in maxPackageBytes.
+ *
+ * @note This should be called from a thread safe method.
+ * @param events The events that are ok to upload.
+ * @return The events to put in the package, which are all of them if they fit.
+ */
+- (NSSet<GDTStoredEvent *> *)eventsCappedToMaxPackageBytes:(NSSet<GDTStoredEvent *> *)events {
+  NSUInteger totalBytes = 0;
+  for (GDTStoredEvent *event in events) {
+    totalBytes += [_eventByteSizes objectForKey:event].unsignedIntegerValue;
+  }
+  if (totalBytes <= _maxPackageBytes) {
+    return events;
+  }
+  NSArray<GDTStoredEvent *> *sortedEvents = [events.allObjects
+      sortedArrayUsingComparator:^NSComparisonResult(GDTStoredEvent *event1,
+                                                     GDTStoredEvent *event2) {
+        int64_t time1 = event1.clockSnapshot.timeMillis;
+        int64_t time2 = event2.clockSnapshot.timeMillis;
+        return time1 < time2 ? NSOrderedAscending
+                             : (time1 > time2 ? NSOrderedDescending : NSOrderedSame);
+      }];
+  NSMutableSet<GDTStoredEvent *> *cappedEvents = [[NSMutableSet alloc] init];
+  totalBytes = 0;
+  for (GDTStoredEvent *event in sortedEvents) {
+    NSUInteger byteSize = [_eventByteSizes objectForKey:event].unsignedIntegerValue;
+    if (cappedEvents.count && totalBytes + byteSize > _maxPackageBytes) {
+      break;
+    }
+    [cappedEvents addObject:event];
+    totalBytes += byteSize;
+  }
+  return cappedEvents;
+}
+
+/** Returns the bucket of events in the same CCT QoS tier as the given event.
+ *
+ * @note This should be called from a thread safe method.
+ * @param event The event whose tier's bucket should be returned.
+ * @return The mutable set of prioritized events in that tier, created if there wasn't one yet.
+ */
+- (NSMutableSet<GDTStoredEvent *> *)eventsInCCTQoSTierOfEvent:(GDTStoredEvent *)event {
+  NSNumber *qosTier = GDTCCTQosTierFromGDTEventQosTier(event.qosTier);
+  NSMutableSet<GDTStoredEvent *> *events = _eventsByCCTQoSTier[qosTier];
+  if (!events) {
+    events = [[NSMutableSet alloc] init];
+    _eventsByCCTQoSTier[qosTier] = events;
+  }
+  return events;
+}
+
 /** Returns a set of logs that are ok to upload whilst on mobile data.
  *
  * @note This should be called from a thread safe method.
  * @return A set of logs that are ok to upload whilst on mobile data.
  */
 - (NSSet<GDTStoredEvent *> *)logEventsOkToSendOnMobileData {
-  return
-      [self.events objectsPassingTest:^BOOL(GDTStoredEvent *_Nonnull event, BOOL *_Nonnull stop) {
-        return [GDTCCTQosTierFromGDTEventQosTier(event.qosTier) isEqual:@(GDTCCTQoSDefault)];
-      }];
+  NSSet<GDTStoredEvent *> *events = _eventsByCCTQoSTier[@(GDTCCTQoSDefault)];
+  return events ? [events copy] : [NSSet set];
 }
 
 /** Returns a set of logs that are ok to upload whilst on wifi.
@@ -149,11 +216,12 @@ NSNumber *GDTCCTQosTierFromGDTEventQosTier(GDTEventQoS qosTier) {
  * @return A set of logs that are ok to upload whilst on wifi.
  */
 - (NSSet<GDTStoredEvent *> *)logEventsOkToSendOnWifi {
-  return
-      [self.events objectsPassingTest:^BOOL(GDTStoredEvent *_Nonnull event, BOOL *_Nonnull stop) {
-        NSNumber *qosTier = GDTCCTQosTierFromGDTEventQosTier(event.qosTier);
-        return [qosTier isEqual:@(GDTCCTQoSDefault)] || [qosTier isEqual:@(GDTCCTQoSWifiOnly)];
-      }];
+  NSMutableSet<GDTStoredEvent *> *events = [[self logEventsOkToSendOnMobileData] mutableCopy];
+  NSSet<GDTStoredEvent *> *wifiOnlyEvents = _eventsByCCTQoSTier[@(GDTCCTQoSWifiOnly)];
+  if (wifiOnlyEvents) {
+    [events unionSet:wifiOnlyEvents];
+  }
+  return events;
 }
 
 /** Returns a set of logs that only should have a single upload attempt per day.
@@ -162,10 +230,8 @@ NSNumber *GDTCCTQosTierFromGDTEventQosTier(GDTEventQoS qosTier) {
  * @return A set of logs that are ok to upload only once per day.
  */
 - (NSSet<GDTStoredEvent *> *)logEventsOkToSendDaily {
-  return
-      [self.events objectsPassingTest:^BOOL(GDTStoredEvent *_Nonnull event, BOOL *_Nonnull stop) {
-        return [GDTCCTQosTierFromGDTEventQosTier(event.qosTier) isEqual:@(GDTCCTQoSDaily)];
-      }];
+  NSSet<GDTStoredEvent *> *events = _eventsByCCTQoSTier[@(GDTCCTQoSDaily)];
+  return events ? [events copy] : [NSSet set];
 }
 
 #pragma mark - GDTLifecycleProtocol
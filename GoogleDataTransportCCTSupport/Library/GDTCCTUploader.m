@@ -22,6 +22,7 @@
 #import <nanopb/pb_decode.h>
 #import <nanopb/pb_encode.h>
 
+#import "Library/Private/GDTCCTCompressionHelper.h"
 #import "Library/Private/GDTCCTNanopbHelpers.h"
 #import "Library/Private/GDTCCTPrioritizer.h"
 
@@ -106,6 +107,11 @@
       self.currentTask = nil;
     };
     NSData *requestProtoData = [self constructRequestProtoFromPackage:(GDTUploadPackage *)package];
+    NSData *gzippedData = [GDTCCTCompressionHelper gzippedData:requestProtoData];
+    if (gzippedData && gzippedData.length < requestProtoData.length) {
+      [request setValue:@"gzip" forHTTPHeaderField:@"Content-Encoding"];
+      requestProtoData = gzippedData;
+    }
     self.currentTask = [self.uploaderSession uploadTaskWithRequest:request
                                                           fromData:requestProtoData
                                                  completionHandler:completionHandler];
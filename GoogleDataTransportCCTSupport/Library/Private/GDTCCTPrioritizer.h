@@ -32,6 +32,11 @@ NS_ASSUME_NONNULL_BEGIN
 /** The most recent attempted upload of daily uploaded logs. */
 @property(nonatomic) GDTClock *timeOfLastDailyUpload;
 
+/** The largest total size in bytes of the event files in an upload package. Events that don't fit
+ * are left for later packages, oldest events first. A package always has at least one event.
+ */
+@property(nonatomic) NSUInteger maxPackageBytes;
+
 /** Creates and/or returns the singleton instance of this class.
  *
  * @return The singleton instance of this class.
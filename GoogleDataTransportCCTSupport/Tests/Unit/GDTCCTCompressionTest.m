@@ -0,0 +1,76 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <zlib.h>
+
+#import "Library/Private/GDTCCTCompressionHelper.h"
+
+@interface GDTCCTCompressionTest : XCTestCase
+
+@end
+
+@implementation GDTCCTCompressionTest
+
+/** Decompresses gzipped data with zlib, returning nil if it isn't valid. */
+- (NSData *)gunzippedData:(NSData *)data {
+  z_stream stream;
+  memset(&stream, 0, sizeof(z_stream));
+  if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+    return nil;
+  }
+  NSMutableData *result = [[NSMutableData alloc] init];
+  stream.next_in = (Bytef *)data.bytes;
+  stream.avail_in = (uInt)data.length;
+  int status;
+  do {
+    [result increaseLengthBy:16 * 1024];
+    stream.next_out = (Bytef *)result.mutableBytes + stream.total_out;
+    stream.avail_out = (uInt)(result.length - stream.total_out);
+    status = inflate(&stream, Z_NO_FLUSH);
+  } while (status == Z_OK);
+  inflateEnd(&stream);
+  if (status != Z_STREAM_END) {
+    return nil;
+  }
+  result.length = stream.total_out;
+  return result;
+}
+
+/** Tests that compressed data decompresses back to the original bytes. */
+- (void)testCompressedDataRoundTrips {
+  NSMutableString *string = [[NSMutableString alloc] init];
+  for (int i = 0; i < 10000; i++) {
+    [string appendFormat:@"event %d ", i];
+  }
+  NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+  NSData *gzippedData = [GDTCCTCompressionHelper gzippedData:data];
+  XCTAssertNotNil(gzippedData);
+  XCTAssertTrue([GDTCCTCompressionHelper isGzipped:gzippedData]);
+  XCTAssertFalse([GDTCCTCompressionHelper isGzipped:data]);
+  XCTAssertLessThan(gzippedData.length, data.length);
+  XCTAssertEqualObjects([self gunzippedData:gzippedData], data);
+}
+
+/** Tests compressing empty data. */
+- (void)testCompressingEmptyData {
+  NSData *gzippedData = [GDTCCTCompressionHelper gzippedData:[NSData data]];
+  XCTAssertTrue([GDTCCTCompressionHelper isGzipped:gzippedData]);
+  XCTAssertEqualObjects([self gunzippedData:gzippedData], [NSData data]);
+}
+
+@end
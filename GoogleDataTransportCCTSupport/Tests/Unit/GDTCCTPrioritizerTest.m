@@ -135,4 +135,29 @@
   XCTAssertTrue([package.events containsObject:dailyEvent]);
 }
 
+/** Tests that a backlog larger than maxPackageBytes is split across several packages. */
+- (void)testPackagesAreCappedToMaxPackageBytes {
+  GDTCCTPrioritizer *prioritizer = [[GDTCCTPrioritizer alloc] init];
+  NSArray<GDTStoredEvent *> *storedEvents = [_generator generateTheFiveConsistentStoredEvents];
+  for (GDTStoredEvent *storedEvent in storedEvents) {
+    [prioritizer prioritizeEvent:storedEvent];
+  }
+  GDTUploadPackage *package =
+      [prioritizer uploadPackageWithConditions:GDTUploadConditionHighPriority];
+  XCTAssertEqual(package.events.count, 5);
+
+  // Every event file is larger than a byte, so each package holds just one event.
+  prioritizer.maxPackageBytes = 1;
+  NSMutableSet<GDTStoredEvent *> *uploadedEvents = [[NSMutableSet alloc] init];
+  for (int i = 0; i < 5; i++) {
+    package = [prioritizer uploadPackageWithConditions:GDTUploadConditionHighPriority];
+    XCTAssertEqual(package.events.count, 1);
+    [uploadedEvents unionSet:package.events];
+    [prioritizer unprioritizeEvents:package.events];
+  }
+  XCTAssertEqualObjects(uploadedEvents, [NSSet setWithArray:storedEvents]);
+  package = [prioritizer uploadPackageWithConditions:GDTUploadConditionHighPriority];
+  XCTAssertEqual(package.events.count, 0);
+}
+
 @end
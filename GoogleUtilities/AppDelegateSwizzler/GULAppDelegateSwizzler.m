@@ -137,6 +137,18 @@ static NSString *const kGULDidReceiveRemoteNotificationWithCompletionSEL =
 @implementation GULZeroingWeakContainer
 @end
 
+/** The containers of the interceptors that respond to each selector, keyed by the selector name.
+ *  They are looked up on the first notification for a selector and dropped whenever the set of
+ *  interceptors changes, so hot delegate callbacks don't check every interceptor each time.
+ */
+static NSMutableDictionary<NSString *, NSArray<GULZeroingWeakContainer *> *>
+    *gInterceptorsBySelector;
+
+/** Incremented whenever gInterceptorsBySelector is invalidated, so that a lookup that raced with
+ *  an interceptor change doesn't cache its outdated result.
+ */
+static NSUInteger gInterceptorsGeneration;
+
 @interface GULAppDelegateObserver : NSObject
 @end
 
@@ -253,6 +265,7 @@ static dispatch_once_t sProxyAppDelegateRemoteNotificationOnceToken;
   GULZeroingWeakContainer *weakObject = [[GULZeroingWeakContainer alloc] init];
   weakObject.object = interceptor;
   [GULAppDelegateSwizzler interceptors][interceptorID] = weakObject;
+  [GULAppDelegateSwizzler invalidateInterceptorsBySelector];
   return interceptorID;
 }
 
@@ -281,6 +294,7 @@ static dispatch_once_t sProxyAppDelegateRemoteNotificationOnceToken;
   }
 
   [[GULAppDelegateSwizzler interceptors] removeObjectForKey:interceptorID];
+  [GULAppDelegateSwizzler invalidateInterceptorsBySelector];
 }
 
 + (void)proxyOriginalDelegate {
@@ -664,6 +678,37 @@ static dispatch_once_t sProxyAppDelegateRemoteNotificationOnceToken;
     return;
   }
 
+  NSArray<GULZeroingWeakContainer *> *interceptorContainers =
+      [GULAppDelegateSwizzler interceptorsRespondingToSelector:methodSelector];
+  for (GULZeroingWeakContainer *interceptorContainer in interceptorContainers) {
+    id interceptor = interceptorContainer.object;
+    if (!interceptor) {
+      // The next lookup finds and removes the deallocated interceptor.
+      [GULAppDelegateSwizzler invalidateInterceptorsBySelector];
+      continue;
+    }
+    callback(interceptor);
+  }
+}
+
+/** Returns the containers of the interceptors that respond to a given selector, from
+ *  gInterceptorsBySelector if they were already looked up since the interceptors last changed.
+ *  Interceptors that were deallocated are removed.
+ *
+ *  @param methodSelector The SEL to check if an interceptor responds to.
+ */
++ (NSArray<GULZeroingWeakContainer *> *)interceptorsRespondingToSelector:(SEL)methodSelector {
+  NSString *selectorName = NSStringFromSelector(methodSelector);
+  NSUInteger generation;
+  @synchronized([GULAppDelegateSwizzler class]) {
+    NSArray<GULZeroingWeakContainer *> *cachedContainers = gInterceptorsBySelector[selectorName];
+    if (cachedContainers) {
+      return cachedContainers;
+    }
+    generation = gInterceptorsGeneration;
+  }
+
+  NSMutableArray<GULZeroingWeakContainer *> *respondingContainers = [[NSMutableArray alloc] init];
   NSDictionary *interceptors = [GULAppDelegateSwizzler interceptors].dictionary;
   [interceptors enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
     GULZeroingWeakContainer *interceptorContainer = obj;
@@ -678,9 +723,29 @@ static dispatch_once_t sProxyAppDelegateRemoteNotificationOnceToken;
       return;
     }
     if ([interceptor respondsToSelector:methodSelector]) {
-      callback(interceptor);
+      [respondingContainers addObject:interceptorContainer];
     }
   }];
+
+  @synchronized([GULAppDelegateSwizzler class]) {
+    if (generation == gInterceptorsGeneration) {
+      if (!gInterceptorsBySelector) {
+        gInterceptorsBySelector = [[NSMutableDictionary alloc] init];
+      }
+      gInterceptorsBySelector[selectorName] = [respondingContainers copy];
+    }
+  }
+  return respondingContainers;
+}
+
+/** Drops the interceptors looked up for each selector. Called whenever an interceptor is
+ *  registered or unregistered.
+ */
++ (void)invalidateInterceptorsBySelector {
+  @synchronized([GULAppDelegateSwizzler class]) {
+    [gInterceptorsBySelector removeAllObjects];
+    gInterceptorsGeneration++;
+  }
 }
 
 // The methods below are donor methods which are added to the dynamic subclass of the App Delegate.
@@ -1016,6 +1081,7 @@ static dispatch_once_t sProxyAppDelegateRemoteNotificationOnceToken;
 
 + (void)clearInterceptors {
   [[self interceptors] removeAllObjects];
+  [self invalidateInterceptorsBySelector];
 }
 
 + (void)resetProxyOriginalDelegateOnceToken {
@@ -32,6 +32,8 @@ extern dispatch_queue_t getGULClientQueue(void);
 
 extern BOOL getGULLoggerDebugMode(void);
 
+extern NSInteger getGULLoggerSuppressedLogCount(void);
+
 static NSString *const kMessageCode = @"I-COR000001";
 
 @interface GULLoggerTest : XCTestCase
@@ -102,6 +104,20 @@ static NSString *const kMessageCode = @"I-COR000001";
   XCTAssertNoThrow(GULLogDebug(@"my service", NO, kMessageCode, @"Configure %@.", @"blah"));
 }
 
+- (void)testRepeatedMessagesAreSuppressed {
+  self.randomLogString = [NSUUID UUID].UUIDString;
+  for (NSInteger i = 0; i < 5; i++) {
+    GULLogError(@"my service", NO, kMessageCode, @"%@", self.randomLogString);
+  }
+  [self drainGULClientQueue];
+  XCTAssertEqual(getGULLoggerSuppressedLogCount(), 4);
+
+  // A different message writes the count and is written itself.
+  GULLogError(@"my service", NO, kMessageCode, @"%@", [NSUUID UUID].UUIDString);
+  [self drainGULClientQueue];
+  XCTAssertEqual(getGULLoggerSuppressedLogCount(), 0);
+}
+
 // asl_set_filter does not perform as expected in unit test environment with simulator. The
 // following test only checks whether the logs have been sent to system with the default settings in
 // the unit test environment.
@@ -145,6 +145,33 @@
                                }];
 }
 
+- (void)testSessionNetwork_POST_foregroundRepeatedRequests {
+  NSData *uncompressedData = [@"Google" dataUsingEncoding:NSUTF8StringEncoding];
+  NSURL *url =
+      [NSURL URLWithString:[NSString stringWithFormat:@"http://localhost:%d/2", _httpServer.port]];
+  _statusCode = 200;
+
+  // The foreground requests share a session, which must stay usable after each of them.
+  for (NSInteger i = 0; i < 3; i++) {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Expect block is called"];
+    [_network postURL:url
+                       payload:uncompressedData
+                         queue:_backgroundQueue
+        usingBackgroundSession:NO
+             completionHandler:^(NSHTTPURLResponse *response, NSData *data, NSError *error) {
+               [self verifyResponse:response error:error];
+               [self verifyRequest];
+               [expectation fulfill];
+             }];
+    [self waitForExpectationsWithTimeout:10
+                                 handler:^(NSError *error) {
+                                   if (error) {
+                                     XCTFail(@"Timeout Error: %@", error);
+                                   }
+                                 }];
+  }
+}
+
 - (void)testSessionNetworkShouldReturnError_POST_foreground {
   XCTestExpectation *expectation = [self expectationWithDescription:@"Expect block is called"];
 
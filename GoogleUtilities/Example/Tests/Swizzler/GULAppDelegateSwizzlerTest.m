@@ -689,6 +689,42 @@ static BOOL gRespondsToHandleBackgroundSession;
   XCTAssertEqual(testAppDelegate.url, testURL);
 }
 
+/** Tests that interceptors registered or unregistered after a callback was already forwarded are
+ *  taken into account on the next callback.
+ */
+- (void)testApplicationOpenURLOptionsFollowsInterceptorChanges {
+  NSURL *testURL = [[NSURL alloc] initWithString:@"https://www.google.com"];
+  NSDictionary *testOpenURLOptions = @{UIApplicationOpenURLOptionUniversalLinksOnly : @"test"};
+
+  GULTestAppDelegate *testAppDelegate = [[GULTestAppDelegate alloc] init];
+  OCMStub([self.mockSharedApplication delegate]).andReturn(testAppDelegate);
+  [GULAppDelegateSwizzler proxyOriginalDelegate];
+
+  id interceptor = OCMProtocolMock(@protocol(UIApplicationDelegate));
+  OCMExpect([interceptor application:OCMOCK_ANY openURL:OCMOCK_ANY options:OCMOCK_ANY])
+      .andReturn(NO);
+  GULAppDelegateInterceptorID interceptorID =
+      [GULAppDelegateSwizzler registerAppDelegateInterceptor:interceptor];
+  [testAppDelegate application:[UIApplication sharedApplication]
+                       openURL:testURL
+                       options:testOpenURLOptions];
+  OCMVerifyAll(interceptor);
+
+  // A newly registered interceptor is called, an unregistered one isn't.
+  id interceptor2 = OCMProtocolMock(@protocol(UIApplicationDelegate));
+  OCMExpect([interceptor2 application:OCMOCK_ANY openURL:OCMOCK_ANY options:OCMOCK_ANY])
+      .andReturn(NO);
+  [GULAppDelegateSwizzler registerAppDelegateInterceptor:interceptor2];
+  [GULAppDelegateSwizzler unregisterAppDelegateInterceptorWithID:interceptorID];
+  OCMReject([interceptor application:OCMOCK_ANY openURL:OCMOCK_ANY options:OCMOCK_ANY]);
+
+  [testAppDelegate application:[UIApplication sharedApplication]
+                       openURL:testURL
+                       options:testOpenURLOptions];
+  OCMVerifyAll(interceptor2);
+  OCMVerifyAll(interceptor);
+}
+
 /** Tests that the result of application:openURL:options: from all interceptors is ORed. */
 - (void)testResultOfApplicationOpenURLOptionsIsORed {
   NSURL *testURL = [[NSURL alloc] initWithString:@"https://www.google.com"];
@@ -37,6 +37,17 @@ static const char *sVersion = "";
 
 static GULLoggerService kGULLoggerLogger = @"[GULLogger]";
 
+/// Identical messages logged within this many seconds of the last one that was written are
+/// counted instead of written again.
+static const CFTimeInterval kGULLoggerDuplicateSuppressionInterval = 1.0;
+
+// The last message written to the log, when it was written and how many identical messages were
+// suppressed since. They are only accessed on sGULClientQueue.
+static NSString *sGULLastLogMessage;
+static GULLoggerLevel sGULLastLogLevel;
+static CFAbsoluteTime sGULLastLogTime;
+static NSInteger sGULSuppressedLogCount;
+
 #ifdef DEBUG
 /// The regex pattern for the message code.
 static NSString *const kMessageCodePattern = @"^I-[A-Z]{3}[0-9]{6}$";
@@ -71,6 +82,8 @@ void GULLoggerInitializeASL(void) {
     sGULClientQueue = dispatch_queue_create("GULLoggingClientQueue", DISPATCH_QUEUE_SERIAL);
     dispatch_set_target_queue(sGULClientQueue,
                               dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0));
+    sGULLastLogMessage = nil;
+    sGULSuppressedLogCount = 0;
 #ifdef DEBUG
     sMessageCodeRegex = [NSRegularExpression regularExpressionWithPattern:kMessageCodePattern
                                                                   options:0
@@ -136,12 +149,50 @@ dispatch_queue_t getGULClientQueue() {
 BOOL getGULLoggerDebugMode() {
   return sGULLoggerDebugMode;
 }
+
+NSInteger getGULLoggerSuppressedLogCount() {
+  return sGULSuppressedLogCount;
+}
 #endif
 
 void GULLoggerRegisterVersion(const char *version) {
   sVersion = version;
 }
 
+/**
+ * Writes how many messages identical to the last written one were suppressed, if any. Must be
+ * called on sGULClientQueue.
+ */
+static void GULLogWriteSuppressedCount(void) {
+  if (sGULSuppressedLogCount > 0) {
+    asl_log(sGULLoggerClient, NULL, sGULLastLogLevel,
+            "%s - %s[I-COR000036] Previous message repeated %ld more times.", sVersion,
+            kGULLoggerLogger.UTF8String, (long)sGULSuppressedLogCount);
+    sGULSuppressedLogCount = 0;
+  }
+}
+
+/**
+ * Writes a message to the log, unless it's identical to the last written one and that was
+ * written less than kGULLoggerDuplicateSuppressionInterval ago. Suppressed messages are counted
+ * and the count is written before the next message that gets written. Must be called on
+ * sGULClientQueue.
+ */
+static void GULLogWrite(GULLoggerLevel level, NSString *logMsg) {
+  CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+  if (level == sGULLastLogLevel && [logMsg isEqualToString:sGULLastLogMessage] &&
+      now - sGULLastLogTime < kGULLoggerDuplicateSuppressionInterval) {
+    sGULSuppressedLogCount++;
+    return;
+  }
+
+  GULLogWriteSuppressedCount();
+  asl_log(sGULLoggerClient, NULL, level, "%s - %s", sVersion, logMsg.UTF8String);
+  sGULLastLogMessage = logMsg;
+  sGULLastLogLevel = level;
+  sGULLastLogTime = now;
+}
+
 void GULLogBasic(GULLoggerLevel level,
                  GULLoggerService service,
                  BOOL forceLog,
@@ -161,12 +212,14 @@ void GULLogBasic(GULLoggerLevel level,
                                                                     range:messageCodeRange];
   NSCAssert(numberOfMatches == 1, @"Incorrect message code format.");
 #endif
+  // The arguments can only be read on the calling thread, the rest of the work happens on the
+  // client queue.
   NSString *logMsg = [[NSString alloc] initWithFormat:message arguments:args_ptr];
-  logMsg = [NSString stringWithFormat:@"%s - %@[%@] %@", sVersion, service, messageCode, logMsg];
   dispatch_async(sGULClientQueue, ^{
-    asl_log(sGULLoggerClient, NULL, level, "%s", logMsg.UTF8String);
+    GULLogWrite(level, [NSString stringWithFormat:@"%@[%@] %@", service, messageCode, logMsg]);
   });
 }
+
 #pragma clang diagnostic pop
 
 /**
@@ -21,11 +21,104 @@
 #import "Private/GULNetworkConstants.h"
 #import "Private/GULNetworkMessageCode.h"
 
+/// Request bodies up to this size are uploaded from memory in the shared foreground session even
+/// when the background network is enabled, rather than written to a file for a background session.
+static const NSUInteger kGULNetworkInMemoryUploadMaxBodySize = 16 * 1024;
+
 @interface GULNetworkURLSession () <NSURLSessionDelegate,
                                     NSURLSessionTaskDelegate,
                                     NSURLSessionDownloadDelegate>
 @end
 
+/// The delegate of the foreground session shared by all fetchers. It forwards the delegate calls
+/// for each task to the fetcher that started it, and keeps the fetcher alive until the task
+/// completes.
+API_AVAILABLE(ios(7.0))
+@interface GULNetworkForegroundSessionDelegate : NSObject <NSURLSessionDelegate,
+                                                           NSURLSessionTaskDelegate,
+                                                           NSURLSessionDownloadDelegate>
+
+- (void)setFetcher:(GULNetworkURLSession *)fetcher forTask:(NSURLSessionTask *)task;
+
+@end
+
+@implementation GULNetworkForegroundSessionDelegate {
+  /// The fetchers of the running tasks, keyed by the task identifiers.
+  NSMutableDictionary<NSNumber *, GULNetworkURLSession *> *_fetchers;
+}
+
+- (instancetype)init {
+  self = [super init];
+  if (self) {
+    _fetchers = [[NSMutableDictionary alloc] init];
+  }
+  return self;
+}
+
+- (void)setFetcher:(GULNetworkURLSession *)fetcher forTask:(NSURLSessionTask *)task {
+  @synchronized(self) {
+    _fetchers[@(task.taskIdentifier)] = fetcher;
+  }
+}
+
+- (GULNetworkURLSession *)fetcherForTask:(NSURLSessionTask *)task {
+  @synchronized(self) {
+    return _fetchers[@(task.taskIdentifier)];
+  }
+}
+
+- (void)URLSession:(NSURLSession *)session
+                 downloadTask:(NSURLSessionDownloadTask *)task
+    didFinishDownloadingToURL:(NSURL *)url {
+  [[self fetcherForTask:task] URLSession:session downloadTask:task didFinishDownloadingToURL:url];
+}
+
+- (void)URLSession:(NSURLSession *)session
+                    task:(NSURLSessionTask *)task
+    didCompleteWithError:(NSError *)error {
+  GULNetworkURLSession *fetcher;
+  @synchronized(self) {
+    fetcher = _fetchers[@(task.taskIdentifier)];
+    [_fetchers removeObjectForKey:@(task.taskIdentifier)];
+  }
+  [fetcher URLSession:session task:task didCompleteWithError:error];
+}
+
+- (void)URLSession:(NSURLSession *)session
+                   task:(NSURLSessionTask *)task
+    didReceiveChallenge:(NSURLAuthenticationChallenge *)challenge
+      completionHandler:(void (^)(NSURLSessionAuthChallengeDisposition disposition,
+                                  NSURLCredential *credential))completionHandler {
+  GULNetworkURLSession *fetcher = [self fetcherForTask:task];
+  if (fetcher) {
+    [fetcher URLSession:session
+                   task:task
+        didReceiveChallenge:challenge
+          completionHandler:completionHandler];
+  } else {
+    completionHandler(NSURLSessionAuthChallengePerformDefaultHandling, nil);
+  }
+}
+
+- (void)URLSession:(NSURLSession *)session
+                          task:(NSURLSessionTask *)task
+    willPerformHTTPRedirection:(NSHTTPURLResponse *)response
+                    newRequest:(NSURLRequest *)request
+             completionHandler:(void (^)(NSURLRequest *))completionHandler {
+  GULNetworkURLSession *fetcher = [self fetcherForTask:task];
+  if (fetcher) {
+    [fetcher URLSession:session
+                              task:task
+        willPerformHTTPRedirection:response
+                        newRequest:request
+                 completionHandler:completionHandler];
+  } else {
+    completionHandler(nil);
+  }
+}
+
+@end
+
 @implementation GULNetworkURLSession {
   /// The handler to be called when the request completes or error has occurs.
   GULNetworkURLSessionCompletionHandler _completionHandler;
@@ -120,8 +213,11 @@
                      expiringTime:kGULNetworkTempFolderExpireTime];
 
   // If there is no background network enabled, no need to write to file. This will allow default
-  // network session which runs on the foreground.
-  if (_backgroundNetworkEnabled && [self ensureTemporaryDirectoryExists]) {
+  // network session which runs on the foreground. Small bodies are sent from memory in the
+  // foreground too, since they don't take long enough for a background transfer to be worth it.
+  BOOL needsBackgroundUpload =
+      _backgroundNetworkEnabled && request.HTTPBody.length > kGULNetworkInMemoryUploadMaxBodySize;
+  if (needsBackgroundUpload && [self ensureTemporaryDirectoryExists]) {
     didWriteFile = [request.HTTPBody writeToFile:_uploadingFileURL.path
                                          options:NSDataWritingAtomic
                                            error:&writeError];
@@ -147,12 +243,10 @@
     postRequestTask = [session uploadTaskWithRequest:request fromFile:_uploadingFileURL];
   } else {
     // If we cannot write to file, just send it in the foreground.
-    _sessionConfig = [NSURLSessionConfiguration defaultSessionConfiguration];
-    [self populateSessionConfig:_sessionConfig withRequest:request];
-    session = [NSURLSession sessionWithConfiguration:_sessionConfig
-                                            delegate:self
-                                       delegateQueue:[NSOperationQueue mainQueue]];
+    session = [[self class] foregroundSession];
+    _sessionConfig = session.configuration;
     postRequestTask = [session uploadTaskWithRequest:request fromData:request.HTTPBody];
+    [[[self class] foregroundSessionDelegate] setFetcher:self forTask:postRequestTask];
   }
 
   if (!session || !postRequestTask) {
@@ -183,21 +277,25 @@
 - (nullable NSString *)sessionIDFromAsyncGETRequest:(NSURLRequest *)request
                                   completionHandler:(GULNetworkURLSessionCompletionHandler)handler
     API_AVAILABLE(ios(7.0)) {
+  NSURLSession *session;
+  NSURLSessionDownloadTask *downloadTask;
   if (_backgroundNetworkEnabled) {
     _sessionConfig = [self backgroundSessionConfigWithSessionID:_sessionID];
-  } else {
-    _sessionConfig = [NSURLSessionConfiguration defaultSessionConfiguration];
-  }
-
-  [self populateSessionConfig:_sessionConfig withRequest:request];
+    [self populateSessionConfig:_sessionConfig withRequest:request];
 
-  // Do not cache the GET request.
-  _sessionConfig.URLCache = nil;
+    // Do not cache the GET request.
+    _sessionConfig.URLCache = nil;
 
-  NSURLSession *session = [NSURLSession sessionWithConfiguration:_sessionConfig
-                                                        delegate:self
-                                                   delegateQueue:[NSOperationQueue mainQueue]];
-  NSURLSessionDownloadTask *downloadTask = [session downloadTaskWithRequest:request];
+    session = [NSURLSession sessionWithConfiguration:_sessionConfig
+                                            delegate:self
+                                       delegateQueue:[NSOperationQueue mainQueue]];
+    downloadTask = [session downloadTaskWithRequest:request];
+  } else {
+    session = [[self class] foregroundSession];
+    _sessionConfig = session.configuration;
+    downloadTask = [session downloadTaskWithRequest:request];
+    [[[self class] foregroundSessionDelegate] setFetcher:self forTask:downloadTask];
+  }
 
   if (!session || !downloadTask) {
     NSError *error = [[NSError alloc]
@@ -295,8 +393,10 @@
                      expiringTime:kGULNetworkTempFolderExpireTime];
 
   // This is called without checking the sessionID here since non-background sessions
-  // won't have an ID.
-  [session finishTasksAndInvalidate];
+  // won't have an ID. The shared foreground session stays open for the next requests.
+  if (session != [[self class] foregroundSession]) {
+    [session finishTasksAndInvalidate];
+  }
 
   // Explicitly remove the session so it won't be reused. The weak map table should
   // remove the session on deallocation, but dealloc may not happen immediately after
@@ -563,6 +663,34 @@
 /// When reading and writing from/to the session map, don't use this method directly.
 /// To avoid thread safety issues, use one of the helper methods at the bottom of the
 /// file: setSessionInFetcherMap:forSessionID:, sessionFromFetcherMapForSessionID:
+/// The delegate of the shared foreground session.
++ (GULNetworkForegroundSessionDelegate *)foregroundSessionDelegate API_AVAILABLE(ios(7.0)) {
+  static GULNetworkForegroundSessionDelegate *foregroundSessionDelegate;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    foregroundSessionDelegate = [[GULNetworkForegroundSessionDelegate alloc] init];
+  });
+  return foregroundSessionDelegate;
+}
+
+/// The session that requests not needing a background transfer are sent through. Sharing it
+/// lets the requests reuse its connections instead of each one setting up a new session. The
+/// request headers, timeout and cache policy are taken from each request.
++ (NSURLSession *)foregroundSession API_AVAILABLE(ios(7.0)) {
+  static NSURLSession *foregroundSession;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    NSURLSessionConfiguration *sessionConfig =
+        [NSURLSessionConfiguration defaultSessionConfiguration];
+    // Do not cache the responses.
+    sessionConfig.URLCache = nil;
+    foregroundSession = [NSURLSession sessionWithConfiguration:sessionConfig
+                                                      delegate:[self foregroundSessionDelegate]
+                                                 delegateQueue:[NSOperationQueue mainQueue]];
+  });
+  return foregroundSession;
+}
+
 + (NSMapTable<NSString *, GULNetworkURLSession *> *)sessionIDToFetcherMap {
   static NSMapTable *sessionIDToFetcherMap;
 
@@ -693,7 +821,9 @@
                                                     messageCode:kGULNetworkMessageCodeURLSession019
                                                         message:message];
     }
-    [existingSession->_URLSession finishTasksAndInvalidate];
+    if (existingSession->_URLSession != [self foregroundSession]) {
+      [existingSession->_URLSession finishTasksAndInvalidate];
+    }
   }
   if (session) {
     [[[self class] sessionIDToFetcherMap] setObject:session forKey:sessionID];
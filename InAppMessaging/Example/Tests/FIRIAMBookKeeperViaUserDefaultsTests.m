@@ -184,4 +184,25 @@ extern NSString *FIRIAM_ImpressionDictKeyForTimestamp;
   XCTAssertEqualObjects(impressions[0].messageID, @"m2");
 }
 
+- (void)testMessageIDsFromImpressionsFollowRecordChanges {
+  FIRIAMBookKeeperViaUserDefaults *bookKeeper =
+      [[FIRIAMBookKeeperViaUserDefaults alloc] initWithUserDefaults:self.userDefaultsForTesting];
+  [bookKeeper cleanupImpressions];
+  XCTAssertEqual(0, [bookKeeper getMessageIDsFromImpressions].count);
+
+  [bookKeeper recordNewImpressionForMessage:@"m1" withStartTimestampInSeconds:1000];
+  [bookKeeper recordNewImpressionForMessage:@"m2" withStartTimestampInSeconds:2000];
+  NSArray<NSString *> *expectedIDs = @[ @"m1", @"m2" ];
+  XCTAssertEqualObjects(expectedIDs, [bookKeeper getMessageIDsFromImpressions]);
+
+  // Repeated reads are served from memory and give the same ids.
+  XCTAssertEqualObjects(expectedIDs, [bookKeeper getMessageIDsFromImpressions]);
+
+  [bookKeeper clearImpressionsWithMessageList:@[ @"m1" ]];
+  XCTAssertEqualObjects(@[ @"m2" ], [bookKeeper getMessageIDsFromImpressions]);
+
+  [bookKeeper cleanupImpressions];
+  XCTAssertEqual(0, [bookKeeper getMessageIDsFromImpressions].count);
+}
+
 @end
@@ -112,6 +112,48 @@
   XCTAssertEqualObjects(@"jackpot", third.renderTriggers[0].firebaseEventName);
 }
 
+- (void)testUnchangedMessagesAreReusedAcrossParses {
+  NSString *testJsonDataFilePath =
+      [[NSBundle bundleForClass:[self class]] pathForResource:@"TestJsonDataFromFetch"
+                                                       ofType:@"txt"];
+  NSData *data = [NSData dataWithContentsOfFile:testJsonDataFilePath];
+  NSDictionary *responseDict = [NSJSONSerialization JSONObjectWithData:data
+                                                               options:kNilOptions
+                                                                 error:nil];
+
+  NSInteger discardCount;
+  NSNumber *fetchWaitTime;
+  NSArray<FIRIAMMessageDefinition *> *firstResults =
+      [self.parser parseAPIResponseDictionary:responseDict
+                            discardedMsgCount:&discardCount
+                       fetchWaitTimeInSeconds:&fetchWaitTime];
+
+  // Change the title of the first message and parse the response again.
+  NSMutableDictionary *changedResponse = [responseDict mutableCopy];
+  NSMutableArray *messages = [responseDict[@"messages"] mutableCopy];
+  NSMutableDictionary *firstMessage = [messages[0] mutableCopy];
+  NSMutableDictionary *content = [firstMessage[@"content"] mutableCopy];
+  NSMutableDictionary *modal = [content[@"modal"] mutableCopy];
+  modal[@"title"] = @{@"text" : @"A new title", @"hexColor" : @"#000000"};
+  content[@"modal"] = modal;
+  firstMessage[@"content"] = content;
+  messages[0] = firstMessage;
+  changedResponse[@"messages"] = messages;
+
+  NSArray<FIRIAMMessageDefinition *> *secondResults =
+      [self.parser parseAPIResponseDictionary:changedResponse
+                            discardedMsgCount:&discardCount
+                       fetchWaitTimeInSeconds:&fetchWaitTime];
+
+  XCTAssertEqual(firstResults.count, secondResults.count);
+  XCTAssertEqual(0, discardCount);
+  XCTAssertNotEqual(firstResults[0], secondResults[0]);
+  XCTAssertEqualObjects(@"A new title", secondResults[0].renderData.contentData.titleText);
+  for (NSUInteger i = 1; i < firstResults.count; i++) {
+    XCTAssertEqual(firstResults[i], secondResults[i]);
+  }
+}
+
 - (void)testParsingTestMessage {
   NSString *testJsonDataFilePath = [[NSBundle bundleForClass:[self class]]
       pathForResource:@"TestJsonDataWithTestMessageFromFetch"
@@ -173,6 +173,43 @@
   XCTAssert([self.clientCache.firebaseAnalyticEventsToWatch containsObject:@"second_event"]);
 }
 
+- (void)testResetMessagesPrefetchesImagesOfEligibleMessages {
+  NSArray<NSString *> *impressionList = @[ @"m1" ];
+  OCMStub([self.mockBookkeeper getMessageIDsFromImpressions]).andReturn(impressionList);
+
+  id impressedContentData = OCMClassMock([FIRIAMMessageContentDataWithImageURL class]);
+  id eligibleContentData = OCMClassMock([FIRIAMMessageContentDataWithImageURL class]);
+  OCMReject([impressedContentData prefetchImageData]);
+
+  FIRIAMRenderingEffectSetting *renderSetting =
+      [FIRIAMRenderingEffectSetting getDefaultRenderingEffectSetting];
+  FIRIAMMessageRenderData *impressedRenderData =
+      [[FIRIAMMessageRenderData alloc] initWithMessageID:@"m1"
+                                             messageName:@"name"
+                                             contentData:impressedContentData
+                                         renderingEffect:renderSetting];
+  FIRIAMMessageRenderData *eligibleRenderData =
+      [[FIRIAMMessageRenderData alloc] initWithMessageID:@"m2"
+                                             messageName:@"name"
+                                             contentData:eligibleContentData
+                                         renderingEffect:renderSetting];
+  NSArray *triggers = @[ [[FIRIAMDisplayTriggerDefinition alloc] initForAppForegroundTrigger] ];
+  NSTimeInterval activeEndTime = [[NSDate date] timeIntervalSince1970] + 10000;
+
+  [self.clientCache setMessageData:@[
+    [[FIRIAMMessageDefinition alloc] initWithRenderData:impressedRenderData
+                                              startTime:0
+                                                endTime:activeEndTime
+                                      triggerDefinition:triggers],
+    [[FIRIAMMessageDefinition alloc] initWithRenderData:eligibleRenderData
+                                              startTime:0
+                                                endTime:activeEndTime
+                                      triggerDefinition:triggers]
+  ]];
+
+  OCMVerify([eligibleContentData prefetchImageData]);
+}
+
 - (void)testNextOnAppOpenDisplayMsg_ok {
   OCMStub([self.mockBookkeeper getImpressions]).andReturn(@[]);
   // m1 and m3 are messages rendered on app open
@@ -241,6 +278,23 @@
   XCTAssertNotNil(nextMsgOnFIREvent);
 }
 
+- (void)testNextOnFirebaseAnalyticsEventDisplayMsgOnlyChecksMatchingMessages {
+  OCMStub([self.mockBookkeeper getMessageIDsFromImpressions]).andReturn(@[]);
+  [self.clientCache setMessageData:@[ m1, m2, m3, m4 ]];
+
+  // m4 is the only message triggered by "second_event"
+  XCTAssertEqualObjects(@"m4",
+                        [self.clientCache nextOnFirebaseAnalyticEventDisplayMsg:@"second_event"]
+                            .renderData.messageID);
+
+  // removing it leaves no message for that event
+  [self.clientCache removeMessageWithId:@"m4"];
+  XCTAssertNil([self.clientCache nextOnFirebaseAnalyticEventDisplayMsg:@"second_event"]);
+  XCTAssertEqualObjects(@"m2",
+                        [self.clientCache nextOnFirebaseAnalyticEventDisplayMsg:@"test_event"]
+                            .renderData.messageID);
+}
+
 - (void)testMessageCanHaveMixedTypeOfTriggers_ok {
   OCMStub([self.mockBookkeeper getImpressions]).andReturn(@[]);
   [self.clientCache setMessageData:@[ m5 ]];
@@ -144,6 +144,32 @@ function(cc_test name)
   target_link_libraries(${name} ${cct_DEPENDS})
 endfunction()
 
+# cc_benchmark(
+#   target
+#   SOURCES sources...
+#   DEPENDS libraries...
+# )
+#
+# Defines a new Google Benchmark executable target with the given target name,
+# sources, and dependencies. Implicitly adds DEPENDS on benchmark and
+# benchmark_main. The benchmark is also registered as a test that runs each
+# benchmark only briefly, which catches benchmarks that fail without spending
+# the time a meaningful measurement needs.
+function(cc_benchmark name)
+  set(multi DEPENDS SOURCES)
+  cmake_parse_arguments(ccb "" "" "${multi}" ${ARGN})
+
+  list(APPEND ccb_DEPENDS benchmark benchmark_main)
+
+  maybe_remove_objc_sources(sources ${ccb_SOURCES})
+  add_executable(${name} ${sources})
+  add_objc_flags(${name} ${ccb_SOURCES})
+  add_test(${name} ${name} --benchmark_min_time=0.01)
+
+  target_include_directories(${name} PUBLIC ${FIREBASE_SOURCE_DIR})
+  target_link_libraries(${name} ${ccb_DEPENDS})
+endfunction()
+
 # cc_fuzz_test(
 #   target
 #   DICTIONARY dict_file